@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/c/c_api_experimental.h"
 
+#include <cstring>
+#include <vector>
+
 #include "absl/strings/substitute.h"
 #include "tensorflow/c/c_api.h"
 #include "tensorflow/c/c_api_internal.h"
@@ -306,6 +309,57 @@ void TF_EnqueueNamedTensor(TF_Session* session, int tensor_id,
   VLOG(1) << "Enqueuing is done.";
 }
 
+void TF_SessionRunWithOutputBuffers(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    TF_Tensor* const* input_values, int ninputs, const TF_Output* outputs,
+    TF_Tensor* const* output_values, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, TF_Status* status) {
+  for (int i = 0; i < noutputs; ++i) {
+    if (output_values[i] == nullptr) {
+      status->status =
+          tensorflow::errors::InvalidArgument("Output buffer ", i, " is null");
+      return;
+    }
+    const TF_DataType dtype = TF_TensorType(output_values[i]);
+    if (dtype == TF_STRING || dtype == TF_RESOURCE) {
+      status->status = tensorflow::errors::InvalidArgument(
+          "Output buffer ", i, " has unsupported type ",
+          tensorflow::DataTypeString(static_cast<tensorflow::DataType>(dtype)));
+      return;
+    }
+  }
+
+  // The fetched values share their buffers with the session's outputs, so
+  // the only copy made is the one into the caller's buffers.
+  std::vector<TF_Tensor*> fetched(noutputs);
+  TF_SessionRun(session, run_options, inputs, input_values, ninputs, outputs,
+                fetched.data(), noutputs, target_opers, ntargets, run_metadata,
+                status);
+  for (int i = 0; i < noutputs && status->status.ok(); ++i) {
+    TF_Tensor* src = fetched[i];
+    TF_Tensor* dst = output_values[i];
+    bool same_shape = TF_NumDims(src) == TF_NumDims(dst);
+    for (int d = 0; same_shape && d < TF_NumDims(src); ++d) {
+      same_shape = TF_Dim(src, d) == TF_Dim(dst, d);
+    }
+    if (TF_TensorType(src) != TF_TensorType(dst) || !same_shape ||
+        TF_TensorByteSize(src) != TF_TensorByteSize(dst)) {
+      status->status = tensorflow::errors::InvalidArgument(
+          "Output buffer ", i, " does not match the type and shape of fetch ",
+          TF_OperationName(outputs[i].oper), ":", outputs[i].index);
+      break;
+    }
+    if (TF_TensorByteSize(src) > 0) {
+      std::memcpy(TF_TensorData(dst), TF_TensorData(src),
+                  TF_TensorByteSize(src));
+    }
+  }
+  for (TF_Tensor* t : fetched) {
+    if (t != nullptr) TF_DeleteTensor(t);
+  }
+}
+
 TF_Buffer* TFE_GetServerDef(const char* text_proto, TF_Status* status) {
   tensorflow::ServerDef server_def;
   if (!tensorflow::protobuf::TextFormat::ParseFromString(text_proto,
@@ -143,6 +143,22 @@ TF_CAPI_EXPORT extern void TF_EnqueueNamedTensor(TF_Session* session,
                                                  int tensor_id,
                                                  TF_Tensor* tensor,
                                                  TF_Status* status);
+// Same as TF_SessionRun, except that `output_values` holds tensors allocated
+// by the caller, e.g. in preallocated response buffers, and the value of each
+// fetch is written into the corresponding tensor. Each tensor must have the
+// type and shape of its fetch, otherwise INVALID_ARGUMENT is returned and the
+// contents of all output tensors are unspecified. TF_STRING and TF_RESOURCE
+// fetches are not supported.
+//
+// The caller keeps ownership of `output_values`. Feeds are borrowed without a
+// copy, as in TF_SessionRun.
+TF_CAPI_EXPORT extern void TF_SessionRunWithOutputBuffers(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    TF_Tensor* const* input_values, int ninputs, const TF_Output* outputs,
+    TF_Tensor* const* output_values, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, TF_Status* status);
+
 // Create a serialized tensorflow.ServerDef proto.
 TF_Buffer* TFE_GetServerDef(const char* text_proto, TF_Status* status);
 
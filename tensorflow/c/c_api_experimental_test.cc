@@ -205,6 +205,46 @@ TEST(CAPI_EXPERIMENTAL, TFE_ExecuteOpInNewThreadTest_Blocking) {
   TF_DeleteStatus(status);
 }
 
+TEST(CAPI_EXPERIMENTAL, SessionRunWithOutputBuffers) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+  TF_Operation* feed = Placeholder(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* two = ScalarConst(2, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* add = Add(feed, two, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  CSession csession(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_Output input{feed, 0};
+  TF_Output output{add, 0};
+  TF_Tensor* input_value = Int32Tensor(3);
+  TF_Tensor* output_value = Int32Tensor(0);
+  void* output_data = TF_TensorData(output_value);
+  TF_SessionRunWithOutputBuffers(csession.mutable_session(), nullptr, &input,
+                                 &input_value, 1, &output, &output_value, 1,
+                                 nullptr, 0, nullptr, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  EXPECT_EQ(output_data, TF_TensorData(output_value));
+  EXPECT_EQ(3 + 2, *static_cast<int32_t*>(output_data));
+  TF_DeleteTensor(output_value);
+
+  // A buffer of the wrong type is rejected.
+  TF_Tensor* float_value = FloatTensor(0.0f);
+  TF_SessionRunWithOutputBuffers(csession.mutable_session(), nullptr, &input,
+                                 &input_value, 1, &output, &float_value, 1,
+                                 nullptr, 0, nullptr, s);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteTensor(float_value);
+
+  TF_DeleteTensor(input_value);
+  csession.CloseAndDelete(s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
 class ShapeInferenceTest : public ::testing::Test {
  protected:
   ShapeInferenceTest()
@@ -19,17 +19,21 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/protobuf_internal.h"
 #include "tensorflow/core/protobuf/graph_debug_info.pb.h"
 #include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 
 namespace tensorflow {
@@ -142,22 +146,84 @@ Status RunOnce(const RunOptions& run_options,
   return run_status;
 }
 
+// Returns the options of a callable that runs the initialization op, feeding
+// it the paths of the assets.
+CallableOptions InitOpCallableOptions(
+    const RunOptions& run_options, const string& export_dir,
+    const std::vector<AssetFileDef>& asset_file_defs,
+    const string& init_op_name) {
+  std::vector<std::pair<string, Tensor>> inputs;
+  AddAssetsTensorsToInputs(export_dir, asset_file_defs, &inputs);
+  CallableOptions callable_options;
+  *callable_options.mutable_run_options() = run_options;
+  for (const auto& input : inputs) {
+    callable_options.add_feed(input.first);
+  }
+  callable_options.add_target(init_op_name);
+  return callable_options;
+}
+
 // RunInitOp will return OK if the initialization op was run successfully.
-// An empty init_op_name indicates that there are no init ops to run.
-Status RunInitOp(const RunOptions& run_options, const string& export_dir,
-                 const MetaGraphDef& meta_graph_def,
+// `init_op_handle` is a callable made from InitOpCallableOptions(), which is
+// released regardless of the outcome.
+Status RunInitOp(const string& export_dir,
                  const std::vector<AssetFileDef>& asset_file_defs,
-                 Session* session, const string& init_op_name) {
-  if (!init_op_name.empty()) {
-    LOG(INFO) << "Running initialization op on SavedModel bundle at path: "
-              << export_dir;
-    std::vector<std::pair<string, Tensor>> inputs;
-    AddAssetsTensorsToInputs(export_dir, asset_file_defs, &inputs);
-    RunMetadata run_metadata;
-    return RunOnce(run_options, inputs, {}, {init_op_name},
-                   nullptr /* outputs */, &run_metadata, session);
+                 Session::CallableHandle init_op_handle, Session* session) {
+  LOG(INFO) << "Running initialization op on SavedModel bundle at path: "
+            << export_dir;
+  std::vector<std::pair<string, Tensor>> inputs;
+  AddAssetsTensorsToInputs(export_dir, asset_file_defs, &inputs);
+  std::vector<Tensor> feed_tensors;
+  for (const auto& input : inputs) {
+    feed_tensors.push_back(input.second);
   }
-  return Status::OK();
+  RunMetadata run_metadata;
+  const Status run_status = session->RunCallable(
+      init_op_handle, feed_tensors, nullptr /* outputs */, &run_metadata);
+  session->ReleaseCallable(init_op_handle).IgnoreError();
+  return run_status;
+}
+
+// Returns the options of callables that compute the outputs of each signature
+// of `meta_graph_def` from its inputs. Signatures with composite inputs or
+// outputs are skipped.
+std::vector<CallableOptions> SignatureCallableOptions(
+    const RunOptions& run_options, const MetaGraphDef& meta_graph_def) {
+  std::vector<CallableOptions> result;
+  for (const auto& signature : meta_graph_def.signature_def()) {
+    if (signature.first == kSavedModelInitOpSignatureKey) {
+      continue;
+    }
+    CallableOptions callable_options;
+    *callable_options.mutable_run_options() = run_options;
+    bool dense = true;
+    for (const auto& input : signature.second.inputs()) {
+      dense &= !input.second.name().empty();
+      callable_options.add_feed(input.second.name());
+    }
+    for (const auto& output : signature.second.outputs()) {
+      dense &= !output.second.name().empty();
+      callable_options.add_fetch(output.second.name());
+    }
+    if (dense && callable_options.fetch_size() > 0) {
+      result.push_back(std::move(callable_options));
+    }
+  }
+  return result;
+}
+
+// Whether to prepare the signatures of the SavedModel at load time, so that
+// their graphs are optimized and their functions instantiated while the
+// variables are restored.
+bool WarmupSignatures() {
+  bool warmup;
+  Status s = ReadBoolFromEnvVar("TF_SAVED_MODEL_WARMUP_SIGNATURES",
+                                /*default_val=*/false, &warmup);
+  if (!s.ok()) {
+    LOG(ERROR) << "Failed to read TF_SAVED_MODEL_WARMUP_SIGNATURES: " << s;
+    return false;
+  }
+  return warmup;
 }
 
 // A SavedModel may store the name of the initialization op to run in the
@@ -292,23 +358,78 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
   std::vector<AssetFileDef> asset_file_defs;
   TF_RETURN_IF_ERROR(
       GetAssetFileDefs(bundle->meta_graph_def, &asset_file_defs));
+  string init_op_name;
   TF_RETURN_IF_ERROR(
-      RunRestore(run_options, export_dir,
-                 bundle->meta_graph_def.saver_def().restore_op_name(),
-                 bundle->meta_graph_def.saver_def().filename_tensor_name(),
-                 asset_file_defs, bundle->session.get()));
+      GetInitOp(export_dir, bundle->meta_graph_def, &init_op_name));
+
+  // Make the callable of the init op, and those of the signatures when warming
+  // them up, concurrently with the restore. Making a callable prunes and
+  // optimizes its graph and creates its executors, which instantiates the
+  // functions that it calls.
+  std::vector<CallableOptions> callables;
+  if (!init_op_name.empty()) {
+    callables.push_back(InitOpCallableOptions(run_options, export_dir,
+                                              asset_file_defs, init_op_name));
+  }
+  const size_t first_signature_callable = callables.size();
+  if (WarmupSignatures()) {
+    for (CallableOptions& callable_options :
+         SignatureCallableOptions(run_options, bundle->meta_graph_def)) {
+      callables.push_back(std::move(callable_options));
+    }
+  }
+  Session* session = bundle->session.get();
+  std::vector<Session::CallableHandle> handles(callables.size());
+  std::vector<Status> make_statuses(callables.size());
+  Status restore_status;
+  {
+    BlockingCounter counter(callables.size());
+    std::unique_ptr<thread::ThreadPool> pool;
+    if (!callables.empty()) {
+      pool.reset(new thread::ThreadPool(
+          Env::Default(), "saved_model_load",
+          std::min<int>(callables.size(), port::MaxParallelism())));
+    }
+    for (size_t i = 0; i < callables.size(); ++i) {
+      pool->Schedule([session, &callables, &handles, &make_statuses, &counter,
+                      i]() {
+        make_statuses[i] = session->MakeCallable(callables[i], &handles[i]);
+        counter.DecrementCount();
+      });
+    }
+    restore_status =
+        RunRestore(run_options, export_dir,
+                   bundle->meta_graph_def.saver_def().restore_op_name(),
+                   bundle->meta_graph_def.saver_def().filename_tensor_name(),
+                   asset_file_defs, session);
+    counter.Wait();
+  }
+  // The signature callables were only made to warm them up.
+  for (size_t i = first_signature_callable; i < callables.size(); ++i) {
+    if (make_statuses[i].ok()) {
+      session->ReleaseCallable(handles[i]).IgnoreError();
+    } else {
+      LOG(WARNING) << "Could not warm up a signature of the SavedModel at "
+                   << export_dir << ": " << make_statuses[i];
+    }
+  }
+  if (!restore_status.ok()) {
+    if (!init_op_name.empty() && make_statuses[0].ok()) {
+      session->ReleaseCallable(handles[0]).IgnoreError();
+    }
+    return restore_status;
+  }
   // Record walltime spent in restoring graph from disk, but postpone metric
   // increments until graph init finishes.
   const uint64 restore_graph_walltime =
       GetLatencyMicroseconds(read_start_microseconds);
 
   const uint64 graph_init_start_microseconds = Env::Default()->NowMicros();
-  string init_op_name;
-  TF_RETURN_IF_ERROR(
-      GetInitOp(export_dir, bundle->meta_graph_def, &init_op_name));
-  TF_RETURN_IF_ERROR(RunInitOp(run_options, export_dir, bundle->meta_graph_def,
-                               asset_file_defs, bundle->session.get(),
-                               init_op_name));
+  if (!init_op_name.empty()) {
+    TF_RETURN_IF_ERROR(make_statuses[0]);
+    TF_RETURN_IF_ERROR(
+        RunInitOp(export_dir, asset_file_defs, handles[0], session));
+  }
   load_latency_by_stage->GetCell(export_dir, "restore_graph")
       ->Add(restore_graph_walltime);
   // Record wall time spent in init op.
@@ -101,6 +101,10 @@ class SavedModelBundleLite : public SavedModelBundleInterface {
 /// the set of tags used at SavedModel build time. Stores a SavedModel bundle in
 /// *bundle with a session and the requested MetaGraphDef, if found.
 ///
+/// The graph of the init op is prepared while the variables are restored. If
+/// the TF_SAVED_MODEL_WARMUP_SIGNATURES environment variable is true, the
+/// graphs of the signatures are prepared concurrently with the restore too.
+///
 /// NOTE: Prefer the overload that takes a SavedModelBundleLite* in new code.
 Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
@@ -132,5 +132,18 @@ Status CompileGraph(const GraphDef& graph_def, const tf2xla::Config& config,
   return CompileXla(client, computation, aot_opts, compile_result);
 }
 
+Status SetFeedBatchSize(int64 batch_size, tf2xla::Config* config) {
+  if (batch_size <= 0) {
+    return errors::InvalidArgument("Batch size must be positive, got ",
+                                   batch_size);
+  }
+  for (tf2xla::Feed& feed : *config->mutable_feed()) {
+    if (feed.shape().dim_size() > 0) {
+      feed.mutable_shape()->mutable_dim(0)->set_size(batch_size);
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace tfcompile
 }  // namespace tensorflow
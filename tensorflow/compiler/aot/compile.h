@@ -45,6 +45,10 @@ struct CompileResult {
 Status CompileGraph(const GraphDef& graph_def, const tf2xla::Config& config,
                     const MainFlags& flags, CompileResult* compile_result);
 
+// Sets the leading (batch) dimension of every non-scalar feed in `config` to
+// `batch_size`.
+Status SetFeedBatchSize(int64 batch_size, tf2xla::Config* config);
+
 }  // namespace tfcompile
 }  // namespace tensorflow
 
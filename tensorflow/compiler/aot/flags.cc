@@ -70,6 +70,10 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
        "Output session module proto."},
       {"mlir_components", &flags->mlir_components,
        "The MLIR components to enable. Currently only Bridge is supported."},
+      {"batch_size", &flags->batch_size,
+       "If positive, overrides the leading dimension of every non-scalar feed "
+       "in the config with this value, so that one config can be compiled "
+       "for several batch sizes."},
       {"gen_name_to_index", &flags->gen_name_to_index,
        "Generate name-to-index data for Lookup{Arg,Result}Index methods."},
       {"gen_program_shape", &flags->gen_program_shape,
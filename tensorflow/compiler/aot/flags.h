@@ -39,6 +39,7 @@ struct MainFlags {
   string out_header;
   string out_session_module;
   string mlir_components;
+  int32 batch_size = 0;
 
   // C++ codegen options
   bool gen_name_to_index = false;
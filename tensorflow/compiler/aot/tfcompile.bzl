@@ -38,6 +38,7 @@ def tf_library(
         include_standard_runtime_deps = True,
         enable_xla_hlo_profiling = False,
         mlir_components = None,
+        batch_sizes = None,
         deps = None,
         tags = []):
     """Runs tfcompile to compile a TensorFlow graph into executable code.
@@ -52,6 +53,10 @@ def tf_library(
                      useful for mobile devices or other platforms that can't
                      compile the full test libraries. Only created if
                      gen_benchmark=True.
+      foo_batch<N>:  For each N in batch_sizes, a library like foo compiled
+                     with the leading dimension of all feeds set to N, with
+                     its own _test and _benchmark targets.  Only created if
+                     batch_sizes is set.
     The output header is called <name>.h.
 
     Args:
@@ -90,6 +95,9 @@ def tf_library(
         profile counters.
       mlir_components: When the value is "Bridge", use MLIR to translate
         GraphDef to HLO.
+      batch_sizes: An optional list of batch sizes to also compile the graph
+        for.  The variant for batch size N is called <name>_batch<N>, its
+        class is <cpp_class>Batch<N> and its header <name>_batch<N>.h.
       deps: a list of deps to include on the build rules for the generated
         library, added to the standard deps if standard_runtime_deps is True.
       tags: tags to apply to subsidiary build rules.
@@ -97,6 +105,31 @@ def tf_library(
     if not cpp_class:
         fail("cpp_class must be specified")
 
+    for batch_size in batch_sizes or []:
+        if type(tfcompile_flags) == type(""):
+            batch_flags = tfcompile_flags + " --batch_size=%d" % batch_size
+        else:
+            batch_flags = (tfcompile_flags or []) + ["--batch_size=%d" % batch_size]
+        tf_library(
+            name = "%s_batch%d" % (name, batch_size),
+            graph = graph,
+            config = config,
+            freeze_checkpoint = freeze_checkpoint,
+            freeze_saver = freeze_saver,
+            cpp_class = "%sBatch%d" % (cpp_class, batch_size),
+            gen_test = gen_test,
+            gen_benchmark = gen_benchmark,
+            visibility = visibility,
+            testonly = testonly,
+            tfcompile_flags = batch_flags,
+            tfcompile_tool = tfcompile_tool,
+            include_standard_runtime_deps = include_standard_runtime_deps,
+            enable_xla_hlo_profiling = enable_xla_hlo_profiling,
+            mlir_components = mlir_components,
+            deps = deps,
+            tags = tags,
+        )
+
     tfcompile_graph = graph
     if freeze_checkpoint or freeze_saver:
         if not freeze_checkpoint:
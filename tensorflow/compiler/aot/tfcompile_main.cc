@@ -89,6 +89,9 @@ Status Main(const MainFlags& flags) {
     return errors::InvalidArgument("Must specify --config");
   }
   TF_RETURN_IF_ERROR(ReadProtoFile(flags.config, &config));
+  if (flags.batch_size != 0) {
+    TF_RETURN_IF_ERROR(SetFeedBatchSize(flags.batch_size, &config));
+  }
   TF_RETURN_IF_ERROR(ValidateConfig(config));
   if (flags.dump_fetch_nodes) {
     std::set<string> nodes;
@@ -112,6 +112,11 @@ void AppendMarkForCompilationPassFlagsInternal(std::vector<Flag>* flag_list) {
       Flag("tf_xla_cpu_global_jit",
            &mark_for_compilation_flags->tf_xla_cpu_global_jit,
            "Enables global JIT compilation for CPU via SessionOptions."),
+      Flag("tf_xla_cpu_elementwise_jit",
+           &mark_for_compilation_flags->tf_xla_cpu_elementwise_jit,
+           "If tf_xla_cpu_global_jit is not set, still auto-cluster chains of "
+           "element-wise, broadcast and reduction operations on CPU when "
+           "auto-clustering is enabled via SessionOptions."),
       Flag("tf_xla_clustering_fuel",
            &mark_for_compilation_flags->tf_xla_clustering_fuel,
            "Places an artificial limit on the number of ops marked as "
@@ -125,7 +130,15 @@ void AppendMarkForCompilationPassFlagsInternal(std::vector<Flag>* flag_list) {
            &mark_for_compilation_flags
                 ->tf_xla_disable_resource_variable_safety_checks_for_debugging,
            "Disable resource variables related safety checks when clustering "
-           "(this is unsound).")};
+           "(this is unsound)."),
+      Flag("tf_xla_shape_buckets",
+           &mark_for_compilation_flags->tf_xla_shape_buckets,
+           "(experimental) If non-empty, pad the leading dimension of the "
+           "inputs of auto-clustered XLA clusters made up of element-wise "
+           "operations up to a bucket boundary, and slice the outputs back, "
+           "so that inputs of varying size don't each trigger a "
+           "recompilation.  Either 'pow2' for powers of two or a comma "
+           "separated list of sizes, e.g. '32,64,128,256'.")};
   flag_list->insert(flag_list->end(), new_flags.begin(), new_flags.end());
 }
 
@@ -146,12 +159,14 @@ void AllocateAndParseFlags() {
       std::numeric_limits<int32>::max();
   mark_for_compilation_flags->tf_xla_clustering_debug = false;
   mark_for_compilation_flags->tf_xla_cpu_global_jit = false;
+  mark_for_compilation_flags->tf_xla_cpu_elementwise_jit = true;
   mark_for_compilation_flags->tf_xla_clustering_fuel =
       std::numeric_limits<int64>::max();
   mark_for_compilation_flags
       ->tf_xla_disable_deadness_safety_checks_for_debugging = false;
   mark_for_compilation_flags
       ->tf_xla_disable_resource_variable_safety_checks_for_debugging = false;
+  mark_for_compilation_flags->tf_xla_shape_buckets = "";
 
   device_flags = new XlaDeviceFlags;
   device_flags->tf_xla_compile_on_demand = false;
@@ -159,6 +174,7 @@ void AllocateAndParseFlags() {
 
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
+  ops_flags->tf_xla_async_compilation = false;
 
   jitter_flags = new IntroduceFloatingPointJitterPassFlags;
   jitter_flags->jitter_amount = 1e-5;
@@ -196,6 +212,14 @@ void AllocateAndParseFlags() {
 
        Flag("tf_xla_always_defer_compilation",
             &ops_flags->tf_xla_always_defer_compilation, ""),
+       Flag("tf_xla_async_compilation", &ops_flags->tf_xla_async_compilation,
+            "When lazy compilation is enabled, build XLA executables on a "
+            "background thread and run clusters in the TF executor until "
+            "they are ready."),
+       Flag("tf_xla_persistent_cache_dir",
+            &ops_flags->tf_xla_persistent_cache_dir,
+            "Directory in which to persist the object code of XLA clusters "
+            "compiled for CPU, so that it can be reused across processes."),
 
        Flag("tf_introduce_floating_point_jitter_to_tensors",
             setter_for_jitter_tensor_names, "",
@@ -64,6 +64,11 @@ struct MarkForCompilationPassFlags {
   // Enables global JIT compilation for CPU via SessionOptions.
   bool tf_xla_cpu_global_jit;
 
+  // If tf_xla_cpu_global_jit is not set but auto-clustering is enabled through
+  // SessionOptions, still auto-cluster chains of element-wise, broadcast and
+  // reduction ops on CPU.
+  bool tf_xla_cpu_elementwise_jit;
+
   // "Compiler fuel" for clustering.  Only this many ops will be marked as
   // eligible for clustering.
   int64 tf_xla_clustering_fuel;
@@ -78,6 +83,11 @@ struct MarkForCompilationPassFlags {
   // variable concurrency semantics.  This is unsound in general, but can be
   // used as a debugging aid.
   bool tf_xla_disable_resource_variable_safety_checks_for_debugging;
+
+  // If non-empty, pad the inputs of suitable auto-clustered XLA clusters to
+  // bucket boundaries so that varying input sizes only cause a bounded number
+  // of recompilations.  Either "pow2" or a comma separated list of sizes.
+  string tf_xla_shape_buckets;
 };
 
 // Flags associated with the XLA bridge's xla_device module.
@@ -97,6 +107,17 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile always refuses to compile the cluster, which means the
   // XLA clusters always run in the TF executor.  Defaults to false.
   bool tf_xla_always_defer_compilation;
+
+  // If true, _XlaCompile builds executables for lazily compiled clusters on a
+  // background thread, running the cluster in the TF executor until the
+  // executable is ready instead of blocking the step.  Defaults to false.
+  bool tf_xla_async_compilation;
+
+  // If non-empty, clusters compiled for the CPU backend keep their generated
+  // object code in this directory, so that later processes (restarts, other
+  // replicas) can reuse it instead of recompiling.  Overrides
+  // --xla_cpu_persistent_cache_dir.
+  string tf_xla_persistent_cache_dir;
 };
 
 // Flags for the build_xla_ops pass.
@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/compiler/jit/device_util.h"
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/graphcycles/graphcycles.h"
+#include "tensorflow/compiler/jit/xla_activity_listener.h"
 #include "tensorflow/compiler/jit/resource_operation_safety_analysis.h"
 #include "tensorflow/compiler/jit/union_find.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
@@ -200,6 +201,16 @@ class MarkForCompilationPassImpl {
       return resource_var_operation_node_ids_;
     }
 
+    // Records that this cluster could not be merged with a neighbor because
+    // of `reason`.  Only used to explain why small clusters stayed small.
+    void AddContractionFailure(XlaDeclusteringActivity::Reason reason) {
+      contraction_failures_ |= 1u << reason;
+    }
+
+    bool HasContractionFailure(XlaDeclusteringActivity::Reason reason) const {
+      return contraction_failures_ & (1u << reason);
+    }
+
     string DebugString(const Graph& graph) const {
       Node* node = graph.FindNodeId(cycles_graph_node_id());
       if (!node) {
@@ -228,6 +239,7 @@ class MarkForCompilationPassImpl {
     bool is_xla_compile_attr_true_;
     absl::optional<string> xla_scope_;
     std::vector<int> resource_var_operation_node_ids_;
+    uint32 contraction_failures_ = 0;
 
     TF_DISALLOW_COPY_AND_ASSIGN(Cluster);
   };
@@ -275,6 +287,16 @@ class MarkForCompilationPassImpl {
 
   Status DumpDebugInfo();
 
+  // Broadcasts and VLOGs why the nodes that did not end up in a cluster were
+  // left out.
+  Status ReportDeclusteringReasons();
+
+  void RecordDeclusteringReason(const Node* node,
+                                XlaDeclusteringActivity::Reason reason,
+                                string uncompilable_reason = "") {
+    declustering_reasons_[node] = {reason, std::move(uncompilable_reason)};
+  }
+
   bool IsCompilationCandidate(Node* n) const {
     return compilation_candidates_.find(n) != compilation_candidates_.end();
   }
@@ -288,6 +310,17 @@ class MarkForCompilationPassImpl {
 
   bool CompilationDisallowedByXlaCompileAttr(Node* node);
 
+  // Returns true if `node` or its callee has a _XlaCompile=true attribute.
+  bool IsXlaCompileAttrTrue(const Node& node) const;
+
+  // Returns true if only element-wise, broadcast and reduction ops should be
+  // auto-clustered on a device with `registration` and `device_type`: a CPU
+  // without --tf_xla_cpu_global_jit, with auto-clustering enabled and
+  // --tf_xla_cpu_elementwise_jit set.
+  bool IsElementwiseOnlyDevice(
+      const DeviceType& device_type,
+      const XlaOpRegistry::DeviceRegistration& registration) const;
+
   // Populates `clusters_`.
   Status BuildInitialClusterSet();
 
@@ -430,6 +463,7 @@ class MarkForCompilationPassImpl {
   std::unique_ptr<DeadnessAnalysis> deadness_analysis_;
   int64 iteration_count_ = 0;
   absl::flat_hash_set<std::pair<int, int>> unsafe_resource_deps_;
+  absl::flat_hash_map<const Node*, DeclusteringReason> declustering_reasons_;
 };
 
 std::vector<int> MarkForCompilationPassImpl::FindAlternatePathForDebugging(
@@ -553,6 +587,8 @@ void MarkForCompilationPassImpl::Cluster::Merge(Cluster* other) {
   absl::c_copy(other->resource_var_operation_node_ids_,
                std::back_inserter(resource_var_operation_node_ids_));
   other->resource_var_operation_node_ids_.clear();
+
+  contraction_failures_ |= other->contraction_failures_;
 }
 
 Status IgnoreResourceOpForSafetyAnalysis(
@@ -856,6 +892,8 @@ Status MarkForCompilationPassImpl::CreateClusters() {
     TF_ASSIGN_OR_RETURN(bool should_compile_cluster,
                         ShouldCompileCluster(*cluster));
     if (!should_compile_cluster) {
+      RecordDeclusteringReason(
+          n, XlaDeclusteringActivity::AUTO_CLUSTERING_DISABLED);
       continue;
     }
 
@@ -876,6 +914,19 @@ Status MarkForCompilationPassImpl::CreateClusters() {
       n->AddAttr(kXlaClusterAttr, name);
       n->AddAttr(kXlaAlreadyClustered, true);
       VLOG(3) << "Assigning node " << n->name() << " to cluster " << name;
+    } else {
+      XlaDeclusteringActivity::Reason reason =
+          XlaDeclusteringActivity::CLUSTER_TOO_SMALL;
+      for (XlaDeclusteringActivity::Reason failure :
+           {XlaDeclusteringActivity::RESOURCE_VARIABLE_SAFETY,
+            XlaDeclusteringActivity::MISMATCHING_DEADNESS,
+            XlaDeclusteringActivity::INCOMPATIBLE_DEVICES}) {
+        if (cluster->HasContractionFailure(failure)) {
+          reason = failure;
+          break;
+        }
+      }
+      RecordDeclusteringReason(n, reason);
     }
   }
 
@@ -1105,6 +1156,22 @@ absl::flat_hash_set<string> GetOrCreateWhitelist() {
   return whitelist;
 }
 
+// Returns the TF operations that are auto-clustered on devices for which
+// IsElementwiseOnlyDevice is true: point-wise ops, reductions and the
+// broadcasts feeding them.  These are cheap to compile and rarely vary in shape
+// from step to step.
+absl::flat_hash_set<string> GetElementwiseOps() {
+  absl::flat_hash_map<string, std::vector<string>>* whitelist_table =
+      tensorflow::GetWhitelistTable();
+  absl::flat_hash_set<string> result;
+  for (const char* category : {"PW", "RED"}) {
+    const std::vector<string>& ops = whitelist_table->at(category);
+    result.insert(ops.begin(), ops.end());
+  }
+  result.insert({"BiasAdd", "BroadcastTo"});
+  return result;
+}
+
 Status MarkForCompilationPassImpl::FindCompilationCandidates() {
   OptimizerOptions opts;
   std::unique_ptr<ProcessFunctionLibraryRuntime> pflr(
@@ -1137,6 +1204,7 @@ Status MarkForCompilationPassImpl::FindCompilationCandidates() {
   VLOG(2) << "sorted_nodes.size() = " << sorted_nodes.size();
 
   auto whitelist = GetOrCreateWhitelist();
+  const absl::flat_hash_set<string> elementwise_ops = GetElementwiseOps();
 
   std::vector<string> vall_ops = XlaOpRegistry::GetAllRegisteredOps();
   absl::flat_hash_set<string> all_ops(vall_ops.begin(), vall_ops.end());
@@ -1149,11 +1217,16 @@ Status MarkForCompilationPassImpl::FindCompilationCandidates() {
     }
   }
 
+  bool out_of_fuel = false;
   for (Node* node : sorted_nodes) {
-    if (*debug_options_.fuel <= 0) {
-      VLOG(1)
-          << "Hit fuel limit; not marking any remaining ops as clusterable.";
-      break;
+    if (out_of_fuel || *debug_options_.fuel <= 0) {
+      if (!out_of_fuel) {
+        VLOG(1)
+            << "Hit fuel limit; not marking any remaining ops as clusterable.";
+        out_of_fuel = true;
+      }
+      RecordDeclusteringReason(node, XlaDeclusteringActivity::FUEL_EXHAUSTED);
+      continue;
     }
 
     TF_ASSIGN_OR_RETURN(
@@ -1165,6 +1238,8 @@ Status MarkForCompilationPassImpl::FindCompilationCandidates() {
     if (CompilationDisallowedByXlaCompileAttr(node)) {
       VLOG(2) << "Not clustering " << node->name()
               << ": disallowed by _XlaCompile attribute";
+      RecordDeclusteringReason(node,
+                               XlaDeclusteringActivity::XLA_COMPILE_ATTR_FALSE);
       continue;
     }
 
@@ -1173,6 +1248,7 @@ Status MarkForCompilationPassImpl::FindCompilationCandidates() {
                                              &registration)) {
       VLOG(2) << "Rejecting " << node->name()
               << ": could not find JIT device for " << device_type.type();
+      RecordDeclusteringReason(node, XlaDeclusteringActivity::NO_JIT_DEVICE);
       continue;
     }
 
@@ -1181,14 +1257,38 @@ Status MarkForCompilationPassImpl::FindCompilationCandidates() {
     RecursiveCompilabilityChecker::OperationFilter op_filter =
         CreateOperationFilter(*registration);
 
-    if (!RecursiveCompilabilityChecker{&op_filter, &jit_device_type}
-             .IsCompilableNode(*node, lib_runtime)) {
+    RecursiveCompilabilityChecker checker{&op_filter, &jit_device_type};
+    if (!checker.IsCompilableNode(*node, lib_runtime)) {
+      // Only the first uncompilable node found is reported, which is enough to
+      // tell which kernel is missing in the common case of a single op.
+      string uncompilable_reason;
+      for (const auto& function_and_nodes :
+           checker.FindUncompilableNodes(*node, lib_runtime)) {
+        if (!function_and_nodes.second.second.empty()) {
+          uncompilable_reason =
+              function_and_nodes.second.second.front().uncompilable_reason;
+          break;
+        }
+      }
+      RecordDeclusteringReason(node, XlaDeclusteringActivity::UNSUPPORTED_OP,
+                               std::move(uncompilable_reason));
       continue;
     }
 
     if (!whitelist.empty() && !whitelist.contains(node->def().op())) {
       VLOG(1) << "Rejecting TF operation " << node->def().op()
               << " as it is not listed in --tf_xla_ops_to_cluster.";
+      RecordDeclusteringReason(node,
+                               XlaDeclusteringActivity::NOT_IN_OPS_TO_CLUSTER);
+      continue;
+    }
+
+    if (IsElementwiseOnlyDevice(device_type, *registration) &&
+        !elementwise_ops.contains(node->type_string()) &&
+        !IsXlaCompileAttrTrue(*node)) {
+      VLOG(2) << "Rejecting " << node->name() << ": " << node->type_string()
+              << " is not element-wise and --tf_xla_cpu_global_jit is not set.";
+      RecordDeclusteringReason(node, XlaDeclusteringActivity::NOT_ELEMENTWISE);
       continue;
     }
 
@@ -1239,6 +1339,8 @@ Status MarkForCompilationPassImpl::FindCompilationCandidates() {
         if (!is_tensor_array_or_stack_op) {
           VLOG(2) << "Isolating " << node->name()
                   << ": must-be-constant stateful op";
+          RecordDeclusteringReason(
+              node, XlaDeclusteringActivity::MUST_BE_CONSTANT_STATEFUL_OP);
           continue;
         }
       }
@@ -1270,6 +1372,8 @@ Status MarkForCompilationPassImpl::FindCompilationCandidates() {
       VLOG(2) << "Rejecting " << node->name()
               << ": including it can create dependencies between while loop "
                  "condition and body computations with runtime overhead.";
+      RecordDeclusteringReason(
+          node, XlaDeclusteringActivity::LOOP_CONDITION_IDENTITY);
       continue;
     }
 
@@ -1311,6 +1415,24 @@ bool MarkForCompilationPassImpl::CompilationDisallowedByXlaCompileAttr(
   return false;
 }
 
+bool MarkForCompilationPassImpl::IsXlaCompileAttrTrue(const Node& node) const {
+  bool compile = false;
+  if (TryGetNodeAttr(node.attrs(), kXlaCompileAttr, &compile) && compile) {
+    return true;
+  }
+  return flib_def_->GetAttr(node, kXlaCompileAttr, &compile).ok() && compile;
+}
+
+bool MarkForCompilationPassImpl::IsElementwiseOnlyDevice(
+    const DeviceType& device_type,
+    const XlaOpRegistry::DeviceRegistration& registration) const {
+  return GetMarkForCompilationPassFlags()->tf_xla_cpu_elementwise_jit &&
+         global_jit_level_ != OptimizerOptions::OFF &&
+         device_type.type_string() == DEVICE_CPU &&
+         registration.autoclustering_policy ==
+             XlaOpRegistry::AutoclusteringPolicy::kIfExplicitlyRequested;
+}
+
 bool MarkForCompilationPassImpl::LogNotContractableAndReturnFalse(
     Cluster* from, Cluster* to, absl::string_view reason) {
   VLOG(3) << EdgeContractionFailureMsg(from, to, reason);
@@ -1329,12 +1451,16 @@ StatusOr<bool> MarkForCompilationPassImpl::TryToContractEdge(Cluster* from,
             deadness_analysis_->DebugString(*from->deadness_predicate()),
             " and ",
             deadness_analysis_->DebugString(*to->deadness_predicate())));
+    from->AddContractionFailure(XlaDeclusteringActivity::MISMATCHING_DEADNESS);
+    to->AddContractionFailure(XlaDeclusteringActivity::MISMATCHING_DEADNESS);
     return false;
   }
 
   TF_ASSIGN_OR_RETURN(bool devices_compatible,
                       AreDevicesCompatible(*from, *to));
   if (!devices_compatible) {
+    from->AddContractionFailure(XlaDeclusteringActivity::INCOMPATIBLE_DEVICES);
+    to->AddContractionFailure(XlaDeclusteringActivity::INCOMPATIBLE_DEVICES);
     return LogNotContractableAndReturnFalse(
         from, to, "the two nodes have incompatible devices");
   }
@@ -1356,6 +1482,8 @@ StatusOr<bool> MarkForCompilationPassImpl::TryToContractEdge(Cluster* from,
                       ClusteringWillIntroduceInterDeviceDependency(*from, *to));
 
   if (will_introduce_cross_device_dependency) {
+    from->AddContractionFailure(XlaDeclusteringActivity::INCOMPATIBLE_DEVICES);
+    to->AddContractionFailure(XlaDeclusteringActivity::INCOMPATIBLE_DEVICES);
     return LogNotContractableAndReturnFalse(
         from, to, "the new cluster will introduce a cross device dependency");
   }
@@ -1377,6 +1505,10 @@ StatusOr<bool> MarkForCompilationPassImpl::TryToContractEdge(Cluster* from,
         // the n^2 pairs of resource variable operations are forbidden.
         if (unsafe_resource_deps_.contains(
                 {resource_var_from, resource_var_to})) {
+          from->AddContractionFailure(
+              XlaDeclusteringActivity::RESOURCE_VARIABLE_SAFETY);
+          to->AddContractionFailure(
+              XlaDeclusteringActivity::RESOURCE_VARIABLE_SAFETY);
           return LogNotContractableAndReturnFalse(
               from, to,
               "the new cluster would break resource variable semantics");
@@ -1400,12 +1532,16 @@ Status MarkForCompilationPassImpl::Run() {
   if (!initialized) {
     // Initialization exited early which means this instance of
     // MarkForCompilationPassImpl is not set up to run the subsequent phases.
-    return Status::OK();
+    for (Node* n : compilation_candidates_) {
+      RecordDeclusteringReason(n, XlaDeclusteringActivity::GRAPH_NOT_CLUSTERED);
+    }
+    return ReportDeclusteringReasons();
   }
 
   TF_RETURN_IF_ERROR(RunEdgeContractionLoop());
   TF_RETURN_IF_ERROR(CreateClusters());
   TF_RETURN_IF_ERROR(DumpDebugInfo());
+  TF_RETURN_IF_ERROR(ReportDeclusteringReasons());
 
   return Status::OK();
 }
@@ -1441,6 +1577,34 @@ string RatioToString(int numerator, int denominator) {
                          (100.0 * numerator) / denominator);
 }
 
+Status MarkForCompilationPassImpl::ReportDeclusteringReasons() {
+  XlaDeclusteringActivity activity =
+      GetXlaDeclusteringActivity(*graph_, declustering_reasons_);
+
+  if (VLOG_IS_ON(2)) {
+    VLOG(2) << "*** Declustering reasons for graph of size "
+            << graph_->num_nodes();
+    for (const XlaDeclusteringActivity::ReasonSummary& summary :
+         activity.reasons()) {
+      VLOG(2) << "  " << XlaDeclusteringActivity::Reason_Name(summary.reason())
+              << ": " << RatioToString(summary.node_count(),
+                                       graph_->num_nodes());
+      for (const XlaAutoClusteringSummary::OpAndCount& op_count :
+           summary.op_histogram()) {
+        VLOG(3) << "   " << op_count.op() << ": " << op_count.count()
+                << " instances";
+      }
+    }
+    for (const XlaDeclusteringActivity::UnsupportedOp& op :
+         activity.unsupported_ops()) {
+      VLOG(2) << "  Unsupported " << op.op() << " (" << op.node_names_size()
+              << " instances): " << op.uncompilable_reason();
+    }
+  }
+
+  return BroadcastXlaActivity(std::move(activity));
+}
+
 void MarkForCompilationPassImpl::VLogClusteringSummary() {
   if (!VLOG_IS_ON(2)) {
     return;
@@ -1612,7 +1776,10 @@ StatusOr<bool> MarkForCompilationPassImpl::ShouldCompileClusterImpl(
           XlaOpRegistry::AutoclusteringPolicy::kAlways ||
       (registration->autoclustering_policy ==
            XlaOpRegistry::AutoclusteringPolicy::kIfEnabledGlobally &&
-       global_jit_level_ != OptimizerOptions::OFF);
+       global_jit_level_ != OptimizerOptions::OFF) ||
+      // FindCompilationCandidates only let element-wise ops into clusters on
+      // such devices, unless they were explicitly marked for compilation.
+      IsElementwiseOnlyDevice(device_type, *registration);
 
   if (!should_compile && global_jit_level_ != OptimizerOptions::OFF &&
       device_type.type_string() == DEVICE_CPU) {
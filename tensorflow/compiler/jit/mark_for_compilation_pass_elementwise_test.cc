@@ -0,0 +1,203 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Tests of --tf_xla_cpu_elementwise_jit.  The CPU's XLA JIT device is
+// registered once per process with the value of --tf_xla_cpu_global_jit at the
+// time, so these run in their own binary without --tf_xla_cpu_global_jit,
+// unlike mark_for_compilation_pass_test.cc.
+
+#include <memory>
+#include <unordered_map>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/compiler/jit/defs.h"
+#include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/jit/mark_for_compilation_pass_test_helper.h"
+#include "tensorflow/compiler/jit/xla_activity.pb.h"
+#include "tensorflow/compiler/jit/xla_activity_listener.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+std::unordered_map<string, string> GetClusters(const Graph& graph) {
+  std::unordered_map<string, string> ids;
+  for (Node* node : graph.nodes()) {
+    string cluster;
+    if (TryGetNodeAttr(node->attrs(), kXlaClusterAttr, &cluster)) {
+      CHECK(!cluster.empty());
+      ids[node->name()] = cluster;
+    }
+  }
+  return ids;
+}
+
+class DeclusteringListener : public XlaActivityListener {
+ public:
+  Status Listen(
+      const XlaAutoClusteringActivity& auto_clustering_activity) override {
+    return Status::OK();
+  }
+
+  Status Listen(
+      const XlaJitCompilationActivity& jit_compilation_activity) override {
+    return Status::OK();
+  }
+
+  Status Listen(const XlaOptimizationRemark& optimization_remark) override {
+    return Status::OK();
+  }
+
+  Status Listen(
+      const XlaDeclusteringActivity& declustering_activity) override {
+    declustering_activity_ = declustering_activity;
+    return Status::OK();
+  }
+
+  // Returns true if `node_name` was left out of clusters for `reason` in the
+  // last graph clustered.
+  bool Declustered(const string& node_name,
+                   XlaDeclusteringActivity::Reason reason) const {
+    for (const auto& summary : declustering_activity_.reasons()) {
+      if (summary.reason() != reason) continue;
+      for (const string& name : summary.node_names()) {
+        if (name == node_name) return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  XlaDeclusteringActivity declustering_activity_;
+};
+
+class ElementwiseJitTest : public ::testing::Test {
+ protected:
+  ElementwiseJitTest() {
+    auto listener = absl::make_unique<DeclusteringListener>();
+    listener_ = listener.get();
+    RegisterXlaActivityListener(std::move(listener));
+  }
+
+  ~ElementwiseJitTest() override {
+    GetMarkForCompilationPassFlags()->tf_xla_cpu_elementwise_jit = true;
+  }
+
+  DeclusteringListener* listener_;
+};
+
+// x and y feed a chain of element-wise ops, a reduction and a MatMul.
+Status BuildGraph(bool xla_compile_matmul, std::unique_ptr<Graph>* graph) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  Output x = ops::Placeholder(root.WithOpName("x"), DT_FLOAT);
+  Output y = ops::Placeholder(root.WithOpName("y"), DT_FLOAT);
+  Output add = ops::Add(root.WithOpName("add"), x, y);
+  Output relu = ops::Relu(root.WithOpName("relu"), add);
+  Output tanh = ops::Tanh(root.WithOpName("tanh"), relu);
+  Output sum = ops::Sum(root.WithOpName("sum"), tanh,
+                        ops::Const(root.WithOpName("axis"), {0}));
+  Output matmul = ops::MatMul(root.WithOpName("matmul"), tanh, tanh);
+  Output neg = ops::Neg(root.WithOpName("neg"), matmul);
+  ops::Mul(root.WithOpName("mul"), neg, sum);
+
+  graph->reset(new Graph(OpRegistry::Global()));
+  TF_RETURN_IF_ERROR(root.ToGraph(graph->get()));
+  if (xla_compile_matmul) {
+    for (Node* n : (*graph)->op_nodes()) {
+      if (n->name() == "matmul") n->AddAttr(kXlaCompileAttr, true);
+    }
+  }
+  return Status::OK();
+}
+
+TEST_F(ElementwiseJitTest, ClustersElementwiseOps) {
+  std::unique_ptr<Graph> graph;
+  TF_ASSERT_OK(BuildGraph(/*xla_compile_matmul=*/false, &graph));
+  TF_ASSERT_OK(MarkForCompilationPassTestHelper::MarkForCompilation(&graph));
+
+  auto clusters = GetClusters(*graph);
+  ASSERT_FALSE(clusters["add"].empty());
+  EXPECT_EQ(clusters["add"], clusters["relu"]);
+  EXPECT_EQ(clusters["add"], clusters["tanh"]);
+  EXPECT_EQ(clusters["add"], clusters["sum"]);
+}
+
+TEST_F(ElementwiseJitTest, DoesNotClusterOtherOps) {
+  std::unique_ptr<Graph> graph;
+  TF_ASSERT_OK(BuildGraph(/*xla_compile_matmul=*/false, &graph));
+  TF_ASSERT_OK(MarkForCompilationPassTestHelper::MarkForCompilation(&graph));
+
+  auto clusters = GetClusters(*graph);
+  EXPECT_EQ(clusters.count("matmul"), 0);
+  // The MatMul separates neg and mul from the rest.
+  EXPECT_NE(clusters["neg"], clusters["add"]);
+
+  EXPECT_TRUE(listener_->Declustered("matmul",
+                                      XlaDeclusteringActivity::NOT_ELEMENTWISE));
+  EXPECT_FALSE(
+      listener_->Declustered("add", XlaDeclusteringActivity::NOT_ELEMENTWISE));
+}
+
+TEST_F(ElementwiseJitTest, ClustersOpsMarkedForCompilation) {
+  std::unique_ptr<Graph> graph;
+  TF_ASSERT_OK(BuildGraph(/*xla_compile_matmul=*/true, &graph));
+  TF_ASSERT_OK(MarkForCompilationPassTestHelper::MarkForCompilation(&graph));
+
+  auto clusters = GetClusters(*graph);
+  EXPECT_FALSE(clusters["matmul"].empty());
+  EXPECT_FALSE(listener_->Declustered(
+      "matmul", XlaDeclusteringActivity::NOT_ELEMENTWISE));
+}
+
+TEST_F(ElementwiseJitTest, NothingClusteredWithoutAutoClustering) {
+  std::unique_ptr<Graph> graph;
+  TF_ASSERT_OK(BuildGraph(/*xla_compile_matmul=*/false, &graph));
+  TF_ASSERT_OK(MarkForCompilationPassTestHelper::MarkForCompilation(
+      &graph, MarkForCompilationPassTestHelper::Options().WithNoGlobalJit()));
+
+  EXPECT_TRUE(GetClusters(*graph).empty());
+  EXPECT_FALSE(listener_->Declustered(
+      "matmul", XlaDeclusteringActivity::NOT_ELEMENTWISE));
+}
+
+TEST_F(ElementwiseJitTest, NothingClusteredWithoutFlag) {
+  GetMarkForCompilationPassFlags()->tf_xla_cpu_elementwise_jit = false;
+  std::unique_ptr<Graph> graph;
+  TF_ASSERT_OK(BuildGraph(/*xla_compile_matmul=*/false, &graph));
+  TF_ASSERT_OK(MarkForCompilationPassTestHelper::MarkForCompilation(&graph));
+
+  EXPECT_TRUE(GetClusters(*graph).empty());
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  tensorflow::MarkForCompilationPassFlags* flags =
+      tensorflow::GetMarkForCompilationPassFlags();
+  flags->tf_xla_cpu_global_jit = false;
+  flags->tf_xla_cpu_elementwise_jit = true;
+  flags->tf_xla_min_cluster_size = 2;
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,485 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing_for_auto_jit_pass.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/types/span.h"
+#include "tensorflow/cc/framework/scope_internal.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/jit/shape_inference.h"
+#include "tensorflow/compiler/jit/xla_activity_listener.h"
+#include "tensorflow/compiler/jit/xla_cluster_util.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/dump_graph.h"
+
+namespace tensorflow {
+namespace {
+
+// Operations that compute every output element from the input elements at the
+// same (broadcast) position only.
+bool IsElementwiseOp(const Node& n) {
+  static const auto* elementwise_ops = new absl::flat_hash_set<string>{
+      // Unary.
+      "Abs", "Cast", "Ceil", "Cos", "Elu", "Erf", "Exp", "Expm1", "Floor",
+      "Identity", "IsFinite", "Log", "Log1p", "LogicalNot", "Neg", "Reciprocal",
+      "Relu", "Relu6", "Round", "Rsqrt", "Selu", "Sigmoid", "Sign", "Sin",
+      "Softplus", "Softsign", "Sqrt", "Square", "Tanh",
+      // Binary, with numpy style broadcasting.
+      "Add", "AddV2", "Div", "DivNoNan", "Equal", "FloorDiv", "FloorMod",
+      "Greater", "GreaterEqual", "Less", "LessEqual", "LogicalAnd",
+      "LogicalOr", "Maximum", "Minimum", "Mul", "NotEqual", "Pow", "RealDiv",
+      "SquaredDifference", "Sub",
+      // Ternary.
+      "SelectV2"};
+  return elementwise_ops->contains(n.type_string());
+}
+
+// Types we pad cluster inputs of.
+bool IsPaddableType(DataType dtype) {
+  switch (dtype) {
+    case DT_BFLOAT16:
+    case DT_BOOL:
+    case DT_DOUBLE:
+    case DT_FLOAT:
+    case DT_HALF:
+    case DT_INT32:
+    case DT_INT64:
+      return true;
+    default:
+      return false;
+  }
+}
+
+xla::StatusOr<std::vector<int32>> ParseBucketBoundaries(
+    absl::string_view spec) {
+  std::vector<int32> boundaries;
+  if (spec == "pow2") {
+    for (int32 boundary = 2; boundary <= (1 << 30); boundary *= 2) {
+      boundaries.push_back(boundary);
+    }
+    return boundaries;
+  }
+
+  for (absl::string_view boundary_str :
+       absl::StrSplit(spec, ',', absl::SkipWhitespace())) {
+    int32 boundary;
+    if (!absl::SimpleAtoi(boundary_str, &boundary) || boundary < 2) {
+      return errors::InvalidArgument(
+          "Invalid entry \"", boundary_str,
+          "\" in --tf_xla_shape_buckets; expected \"pow2\" or a comma "
+          "separated list of sizes larger than one.");
+    }
+    boundaries.push_back(boundary);
+  }
+  if (boundaries.empty()) {
+    return errors::InvalidArgument("--tf_xla_shape_buckets=\"", spec,
+                                   "\" specifies no buckets.");
+  }
+  absl::c_sort(boundaries);
+  boundaries.erase(std::unique(boundaries.begin(), boundaries.end()),
+                   boundaries.end());
+  return boundaries;
+}
+
+// The largest padded to actual size ratio `boundaries` can produce.  This is
+// attained by the smallest size that is rounded up to a boundary, which is one
+// larger than the previous boundary (or 2, the smallest size we pad).
+double WorstCasePaddingRatio(absl::Span<const int32> boundaries) {
+  double ratio = 1.0;
+  int64 previous_boundary = 1;
+  for (int32 boundary : boundaries) {
+    ratio = std::max(ratio, static_cast<double>(boundary) /
+                                static_cast<double>(previous_boundary + 1));
+    previous_boundary = boundary;
+  }
+  return ratio;
+}
+
+// A cluster input or output tensor, identified by its producer.
+using TensorId = std::pair<Node*, int>;
+
+// Describes how a cluster is rewritten.
+struct BucketingPlan {
+  string cluster_name;
+
+  // The rank of the cluster's full-rank tensors, whose leading dimension is
+  // padded.
+  int rank;
+
+  // The cluster inputs to pad, in a deterministic order.
+  std::vector<TensorId> padded_inputs;
+
+  // The cluster outputs to slice, and for each one the indices into
+  // `padded_inputs` it depends on.
+  std::vector<std::pair<TensorId, std::set<int>>> sliced_outputs;
+};
+
+const PartialTensorShape* FindShape(const GraphShapeInfo& shape_info,
+                                    const Node* n, int output) {
+  auto it = shape_info.find(n->name());
+  if (it == shape_info.end() || output >= it->second.size()) {
+    return nullptr;
+  }
+  return &it->second[output].shape;
+}
+
+bool InCluster(const Node& n, absl::string_view cluster_name) {
+  absl::optional<absl::string_view> cluster = GetXlaClusterForNode(n);
+  return cluster.has_value() && *cluster == cluster_name;
+}
+
+// Returns a plan for bucketing the cluster made up of `nodes`, or nullopt if
+// the cluster can't be bucketed.
+absl::optional<BucketingPlan> PlanBucketing(const string& cluster_name,
+                                            const std::vector<Node*>& nodes,
+                                            const GraphShapeInfo& shape_info) {
+  int rank = 0;
+  for (Node* n : nodes) {
+    if (!n->IsConstant() && !IsElementwiseOp(*n)) {
+      VLOG(3) << "Not bucketing " << cluster_name << ": " << n->name()
+              << " is not element-wise";
+      return absl::nullopt;
+    }
+    for (int i = 0; i < n->num_outputs(); i++) {
+      const PartialTensorShape* shape = FindShape(shape_info, n, i);
+      if (shape == nullptr || shape->unknown_rank()) {
+        VLOG(3) << "Not bucketing " << cluster_name << ": " << n->name()
+                << " has an unknown rank";
+        return absl::nullopt;
+      }
+      rank = std::max(rank, shape->dims());
+    }
+  }
+  if (rank == 0) {
+    return absl::nullopt;
+  }
+
+  // Constants inside the cluster must broadcast against any padded size.
+  for (Node* n : nodes) {
+    if (!n->IsConstant()) {
+      continue;
+    }
+    const PartialTensorShape* shape = FindShape(shape_info, n, 0);
+    if (shape->dims() == rank && shape->dim_size(0) != 1) {
+      VLOG(3) << "Not bucketing " << cluster_name << ": constant " << n->name()
+              << " has a full-rank shape " << shape->DebugString();
+      return absl::nullopt;
+    }
+  }
+
+  BucketingPlan plan;
+  plan.cluster_name = cluster_name;
+  plan.rank = rank;
+
+  // Full-rank inputs are padded, except those that are statically known to
+  // broadcast along the leading dimension.  Lower rank inputs broadcast along
+  // it by construction.
+  std::map<TensorId, int> padded_input_index;
+  for (Node* n : nodes) {
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge() || InCluster(*e->src(), cluster_name)) {
+        continue;
+      }
+      TensorId input(e->src(), e->src_output());
+      if (padded_input_index.count(input)) {
+        continue;
+      }
+      const PartialTensorShape* shape =
+          FindShape(shape_info, e->src(), e->src_output());
+      if (shape == nullptr || shape->unknown_rank()) {
+        return absl::nullopt;
+      }
+      if (shape->dims() < rank || shape->dim_size(0) == 1) {
+        continue;
+      }
+      if (!IsPaddableType(e->src()->output_type(e->src_output()))) {
+        VLOG(3) << "Not bucketing " << cluster_name << ": can't pad input "
+                << e->src()->name() << ":" << e->src_output() << " of type "
+                << DataTypeString(e->src()->output_type(e->src_output()));
+        return absl::nullopt;
+      }
+      padded_input_index[input] = plan.padded_inputs.size();
+      plan.padded_inputs.push_back(input);
+    }
+  }
+  if (plan.padded_inputs.empty()) {
+    return absl::nullopt;
+  }
+
+  // Compute the padded inputs every node depends on, visiting the nodes in
+  // topological order.
+  absl::flat_hash_map<Node*, std::set<int>> depends_on;
+  std::vector<Node*> post_order;
+  GetPostOrder(*nodes.front()->graph(), &post_order);
+  for (auto it = post_order.rbegin(); it != post_order.rend(); ++it) {
+    Node* n = *it;
+    if (!InCluster(*n, cluster_name)) {
+      continue;
+    }
+    std::set<int>& deps = depends_on[n];
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) {
+        continue;
+      }
+      if (InCluster(*e->src(), cluster_name)) {
+        const std::set<int>& src_deps = depends_on[e->src()];
+        deps.insert(src_deps.begin(), src_deps.end());
+      } else {
+        auto index = padded_input_index.find({e->src(), e->src_output()});
+        if (index != padded_input_index.end()) {
+          deps.insert(index->second);
+        }
+      }
+    }
+  }
+
+  std::set<TensorId> seen_outputs;
+  for (Node* n : nodes) {
+    for (const Edge* e : n->out_edges()) {
+      if (e->IsControlEdge() || InCluster(*e->dst(), cluster_name) ||
+          depends_on[n].empty()) {
+        continue;
+      }
+      TensorId output(n, e->src_output());
+      if (seen_outputs.insert(output).second) {
+        plan.sliced_outputs.push_back({output, depends_on[n]});
+      }
+    }
+  }
+  return plan;
+}
+
+// Replaces all edges from `old_src` to nodes that `should_redirect` accepts
+// with edges from `new_src`.
+template <typename PredicateTy>
+void RedirectEdges(Graph* g, TensorId old_src, Output new_src,
+                   PredicateTy should_redirect) {
+  std::vector<const Edge*> edges;
+  for (const Edge* e : old_src.first->out_edges()) {
+    if (!e->IsControlEdge() && e->src_output() == old_src.second &&
+        e->dst() != new_src.node() && should_redirect(*e->dst())) {
+      edges.push_back(e);
+    }
+  }
+  for (const Edge* e : edges) {
+    Node* dst = e->dst();
+    int dst_input = e->dst_input();
+    g->RemoveEdge(e);
+    g->AddEdge(new_src.node(), new_src.index(), dst, dst_input);
+  }
+}
+
+Status RewriteCluster(Graph* g, const BucketingPlan& plan,
+                      absl::Span<const int32> boundaries) {
+  Status status;
+  Scope root = NewInternalScope(g, &status, /*refiner=*/nullptr)
+                   .NewSubScope(absl::StrCat(plan.cluster_name,
+                                             "/shape_bucketing"));
+
+  // Constants get a control edge from `frame_node` so that they end up in the
+  // same while loop frame as the tensors they are combined with.
+  auto host_const = [&](const Scope& s, Node* frame_node,
+                        const Input::Initializer& value) {
+    Output c = ops::Const(s, value);
+    g->AddControlEdge(frame_node, c.node());
+    return c;
+  };
+
+  Tensor bucket_table(DT_INT32, TensorShape({static_cast<int64>(
+                                    boundaries.size() + 1)}));
+  for (int i = 0; i < boundaries.size(); i++) {
+    bucket_table.flat<int32>()(i) = boundaries[i];
+  }
+  bucket_table.flat<int32>()(boundaries.size()) = 0;
+  std::vector<float> float_boundaries(boundaries.begin(), boundaries.end());
+
+  Tensor padding_mask(DT_INT32, TensorShape({plan.rank, 2}));
+  padding_mask.flat<int32>().setZero();
+  padding_mask.matrix<int32>()(0, 1) = 1;
+
+  std::vector<Output> input_sizes;
+  for (int i = 0; i < plan.padded_inputs.size(); i++) {
+    Node* src = plan.padded_inputs[i].first;
+    Output input(src, plan.padded_inputs[i].second);
+    const string& device = src->assigned_device_name();
+    string host_device;
+    TF_RETURN_IF_ERROR(
+        DeviceNameUtils::DeviceNameToCpuDeviceName(device, &host_device));
+    Scope host = root.WithAssignedDevice(host_device);
+
+    Output shape =
+        ops::Shape(root.WithOpName("shape_", i).WithAssignedDevice(device),
+                   input, ops::Shape::OutType(DT_INT32));
+    Output size = ops::StridedSlice(
+        host.WithOpName("size_", i), shape, host_const(host, src, {0}),
+        host_const(host, src, {1}), host_const(host, src, {1}),
+        ops::StridedSlice::ShrinkAxisMask(1));
+    input_sizes.push_back(size);
+
+    // bucket_table[i] is the smallest boundary >= size, or 0 if there is none.
+    Output bucket_index = ops::Bucketize(
+        host.WithOpName("bucket_index_", i),
+        ops::Sub(host.WithOpName("size_minus_one_", i), size,
+                 host_const(host, src, 1)),
+        float_boundaries);
+    Output bucket = ops::GatherV2(
+        host.WithOpName("bucket_", i), host_const(host, src, bucket_table),
+        bucket_index, host_const(host, src, 0));
+    Output padded_size = ops::Where3(
+        host.WithOpName("padded_size_", i),
+        ops::LessEqual(host.WithOpName("is_broadcast_", i), size,
+                       host_const(host, src, 1)),
+        size, ops::Maximum(host.WithOpName("bucketed_size_", i), bucket, size));
+    Output paddings = ops::Mul(
+        host.WithOpName("paddings_", i), host_const(host, src, padding_mask),
+        ops::Sub(host.WithOpName("padding_", i), padded_size, size));
+    Output padded = ops::Pad(
+        root.WithOpName("padded_", i).WithAssignedDevice(device), input,
+        paddings);
+    TF_RETURN_IF_ERROR(root.status());
+
+    RedirectEdges(g, plan.padded_inputs[i], padded, [&](const Node& dst) {
+      return InCluster(dst, plan.cluster_name);
+    });
+  }
+
+  for (int i = 0; i < plan.sliced_outputs.size(); i++) {
+    const TensorId& output = plan.sliced_outputs[i].first;
+    const std::set<int>& deps = plan.sliced_outputs[i].second;
+    Node* frame_node = plan.padded_inputs[*deps.begin()].first;
+    string host_device;
+    TF_RETURN_IF_ERROR(DeviceNameUtils::DeviceNameToCpuDeviceName(
+        frame_node->assigned_device_name(), &host_device));
+    Scope host = root.WithAssignedDevice(host_device);
+
+    // Without padding, the leading dimension of the output would have been
+    // the largest leading dimension of the inputs it depends on.
+    Output size;
+    for (int dep : deps) {
+      size = size.node() == nullptr
+                 ? input_sizes[dep]
+                 : ops::Maximum(host.WithOpName("output_size_", i), size,
+                                input_sizes[dep]);
+    }
+    Output end = ops::Reshape(host.WithOpName("output_end_", i), size,
+                              host_const(host, frame_node, {1}));
+    Output sliced = ops::StridedSlice(
+        root.WithOpName("sliced_", i)
+            .WithAssignedDevice(output.first->assigned_device_name()),
+        Output(output.first, output.second),
+        host_const(host, frame_node, {0}), end,
+        host_const(host, frame_node, {1}));
+    TF_RETURN_IF_ERROR(root.status());
+
+    RedirectEdges(g, output, sliced, [&](const Node& dst) {
+      return !InCluster(dst, plan.cluster_name);
+    });
+  }
+
+  return status;
+}
+
+Status FindAndBucketClusters(Graph* g,
+                             const FunctionLibraryDefinition* flib_def,
+                             absl::Span<const int32> boundaries,
+                             bool* changed) {
+  *changed = false;
+
+  std::map<string, std::vector<Node*>> clusters;
+  for (Node* n : g->op_nodes()) {
+    if (absl::optional<absl::string_view> cluster = GetXlaClusterForNode(*n)) {
+      clusters[string(*cluster)].push_back(n);
+    }
+  }
+  if (clusters.empty()) {
+    return Status::OK();
+  }
+
+  GraphShapeInfo shape_info;
+  TF_RETURN_IF_ERROR(
+      InferShapes(g, /*arg_shapes=*/{}, flib_def, &shape_info));
+
+  std::vector<BucketingPlan> plans;
+  for (const auto& cluster : clusters) {
+    if (absl::optional<BucketingPlan> plan =
+            PlanBucketing(cluster.first, cluster.second, shape_info)) {
+      plans.push_back(std::move(*plan));
+    }
+  }
+
+  for (const BucketingPlan& plan : plans) {
+    VLOG(2) << "Bucketing " << plan.padded_inputs.size() << " inputs of "
+            << plan.cluster_name;
+    TF_RETURN_IF_ERROR(RewriteCluster(g, plan, boundaries));
+
+    XlaShapeBucketingActivity activity;
+    activity.set_cluster_name(plan.cluster_name);
+    activity.set_padded_input_count(plan.padded_inputs.size());
+    for (int32 boundary : boundaries) {
+      activity.add_bucket_boundaries(boundary);
+    }
+    activity.set_worst_case_padding_ratio(WorstCasePaddingRatio(boundaries));
+    TF_RETURN_IF_ERROR(BroadcastXlaActivity(std::move(activity)));
+  }
+
+  if (!plans.empty()) {
+    FixupSourceAndSinkEdges(g);
+    *changed = true;
+  }
+  return Status::OK();
+}
+}  // namespace
+
+Status ShapeBucketingForAutoJitPass::Run(
+    const GraphOptimizationPassOptions& options) {
+  MarkForCompilationPassFlags* flags = GetMarkForCompilationPassFlags();
+  if (flags->tf_xla_shape_buckets.empty()) {
+    return Status::OK();
+  }
+  TF_ASSIGN_OR_RETURN(std::vector<int32> boundaries,
+                      ParseBucketBoundaries(flags->tf_xla_shape_buckets));
+
+  if (flags->tf_xla_clustering_debug) {
+    DumpGraphToFile("before_shape_bucketing_for_auto_jit_pass",
+                    **options.graph, options.flib_def);
+  }
+
+  bool changed;
+  TF_RETURN_IF_ERROR(FindAndBucketClusters(
+      options.graph->get(), options.flib_def, boundaries, &changed));
+  if (changed && flags->tf_xla_clustering_debug) {
+    DumpGraphToFile("shape_bucketing_for_auto_jit_pass", **options.graph,
+                    options.flib_def);
+  }
+
+  return Status::OK();
+}
+
+}  // namespace tensorflow
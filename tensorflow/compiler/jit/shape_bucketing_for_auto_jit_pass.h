@@ -0,0 +1,54 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_FOR_AUTO_JIT_PASS_H_
+#define TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_FOR_AUTO_JIT_PASS_H_
+
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+
+namespace tensorflow {
+
+// Bounds the number of times an auto-clustered XLA cluster is recompiled when
+// the size of its inputs varies from step to step (e.g. with variable sequence
+// lengths).  Enabled with --tf_xla_shape_buckets.
+//
+// For every cluster made up only of element-wise operations, this pass pads
+// the leading dimension of each full-rank cluster input up to the next bucket
+// boundary, and slices every cluster output that depends on a padded input
+// back to its original size:
+//
+//   x: f32[n, d] -> Pad(x, [[0, bucket(n) - n], [0, 0]]) -> cluster
+//   cluster -> StridedSlice(y, [0], [max n of the inputs y depends on], [1])
+//
+// where bucket(n) is the smallest boundary >= n, or n itself if n <= 1 or n is
+// larger than every boundary.  Sizes of 0 and 1 are left alone so that
+// broadcasting behaves as before.  The padding and slicing ops are placed
+// outside the cluster, so the cluster is only ever compiled for bucketed
+// shapes.
+//
+// Element-wise operations never mix elements at different positions, so the
+// padded elements can't affect the elements that are sliced out.  Clusters
+// containing any other operation are left untouched.
+//
+// Every bucketed cluster is reported to the XlaActivityListeners as an
+// XlaShapeBucketingActivity.
+class ShapeBucketingForAutoJitPass : public GraphOptimizationPass {
+ public:
+  Status Run(const GraphOptimizationPassOptions& options) override;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_FOR_AUTO_JIT_PASS_H_
@@ -0,0 +1,201 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing_for_auto_jit_pass.h"
+
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/jit/node_matchers.h"
+#include "tensorflow/compiler/jit/xla_cluster_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+using ::testing::_;
+using testing::matchers::AssignedDevice;
+using testing::matchers::Inputs;
+using testing::matchers::Name;
+using testing::matchers::NodeWith;
+using testing::matchers::Op;
+using testing::matchers::Out;
+
+const char* kDeviceName = "/job:worker/replica:0/task:0/device:CPU:0";
+
+class ShapeBucketingForAutoJitPassTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    GetMarkForCompilationPassFlags()->tf_xla_shape_buckets = "pow2";
+  }
+
+  void TearDown() override {
+    GetMarkForCompilationPassFlags()->tf_xla_shape_buckets = "";
+  }
+
+  Status RunPass(const Scope& s, std::unique_ptr<Graph>* result) {
+    auto graph = absl::make_unique<Graph>(OpRegistry::Global());
+    TF_RETURN_IF_ERROR(s.ToGraph(graph.get()));
+    for (Node* n : graph->nodes()) {
+      n->set_assigned_device_name(kDeviceName);
+    }
+
+    GraphOptimizationPassOptions options;
+    options.graph = &graph;
+    options.flib_def = &flib_def_;
+    ShapeBucketingForAutoJitPass pass;
+    TF_RETURN_IF_ERROR(pass.Run(options));
+    *result = std::move(graph);
+    return Status::OK();
+  }
+
+  int CountOps(const Graph& g, absl::string_view op) {
+    int count = 0;
+    for (Node* n : g.op_nodes()) {
+      count += n->type_string() == op;
+    }
+    return count;
+  }
+
+  FunctionLibraryDefinition flib_def_{OpRegistry::Global(),
+                                      FunctionDefLibrary()};
+};
+
+TEST_F(ShapeBucketingForAutoJitPassTest, Basic) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  Scope cluster = root.WithXlaCluster("cluster_0");
+
+  Output a = ops::Placeholder(root.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape({-1, 8}));
+  Output b = ops::Placeholder(root.WithOpName("b"), DT_FLOAT,
+                              ops::Placeholder::Shape({-1, 8}));
+  Output bias = ops::Placeholder(root.WithOpName("bias"), DT_FLOAT,
+                                 ops::Placeholder::Shape({8}));
+  Output add = ops::Add(cluster.WithOpName("add"), a, b);
+  Output relu = ops::Relu(
+      cluster.WithOpName("relu"),
+      ops::Add(cluster.WithOpName("add_bias"), add, bias));
+  Output out = ops::Identity(root.WithOpName("out"), relu);
+
+  std::unique_ptr<Graph> result;
+  TF_ASSERT_OK(RunPass(root, &result));
+
+  auto m_padded_a = Out(NodeWith(
+      Op("Pad"), AssignedDevice(kDeviceName),
+      Inputs(Out(NodeWith(Name("a"))),
+             Out(NodeWith(Op("Mul"), AssignedDevice(kDeviceName))))));
+  auto m_padded_b =
+      Out(NodeWith(Op("Pad"), Inputs(Out(NodeWith(Name("b"))), _)));
+  EXPECT_THAT(testing::FindNodeByName(result.get(), "add"),
+              NodeWith(Inputs(m_padded_a, m_padded_b)));
+
+  // The lower rank bias broadcasts along the padded dimension as is.
+  EXPECT_THAT(testing::FindNodeByName(result.get(), "add_bias"),
+              NodeWith(Inputs(_, Out(NodeWith(Name("bias"))))));
+
+  EXPECT_THAT(
+      testing::FindNodeByName(result.get(), "out"),
+      NodeWith(Inputs(Out(NodeWith(
+          Op("StridedSlice"),
+          Inputs(Out(NodeWith(Name("relu"))), _,
+                 Out(NodeWith(Op("Reshape"),
+                              Inputs(Out(NodeWith(Op("Maximum"))), _))),
+                 _))))));
+  EXPECT_EQ(CountOps(*result, "Pad"), 2);
+}
+
+TEST_F(ShapeBucketingForAutoJitPassTest, IndependentOutputsAreSlicedSeparately) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  Scope cluster = root.WithXlaCluster("cluster_0");
+
+  Output a = ops::Placeholder(root.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape({-1}));
+  Output b = ops::Placeholder(root.WithOpName("b"), DT_INT32,
+                              ops::Placeholder::Shape({-1}));
+  Output neg = ops::Neg(cluster.WithOpName("neg"), a);
+  Output cast = ops::Cast(cluster.WithOpName("cast"), b, DT_FLOAT);
+  Output out_a = ops::Identity(root.WithOpName("out_a"), neg);
+  Output out_b = ops::Identity(root.WithOpName("out_b"), cast);
+
+  std::unique_ptr<Graph> result;
+  TF_ASSERT_OK(RunPass(root, &result));
+
+  // Each output is sliced to the size of the one input it depends on.
+  auto m_size_of = [](const char* input) {
+    return Out(NodeWith(
+        Op("StridedSlice"),
+        Inputs(Out(NodeWith(Op("Shape"), Inputs(Out(NodeWith(Name(input)))))),
+               _, _, _)));
+  };
+  EXPECT_THAT(testing::FindNodeByName(result.get(), "out_a"),
+              NodeWith(Inputs(Out(NodeWith(
+                  Op("StridedSlice"),
+                  Inputs(_, _, Out(NodeWith(Inputs(m_size_of("a"), _))),
+                         _))))));
+  EXPECT_THAT(testing::FindNodeByName(result.get(), "out_b"),
+              NodeWith(Inputs(Out(NodeWith(
+                  Op("StridedSlice"),
+                  Inputs(_, _, Out(NodeWith(Inputs(m_size_of("b"), _))),
+                         _))))));
+}
+
+TEST_F(ShapeBucketingForAutoJitPassTest, NonElementwiseClusterIsUnchanged) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  Scope cluster = root.WithXlaCluster("cluster_0");
+
+  Output a = ops::Placeholder(root.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape({-1, 8}));
+  Output w = ops::Placeholder(root.WithOpName("w"), DT_FLOAT,
+                              ops::Placeholder::Shape({8, 8}));
+  Output matmul = ops::MatMul(cluster.WithOpName("matmul"), a, w);
+  Output out = ops::Identity(root.WithOpName("out"), matmul);
+
+  std::unique_ptr<Graph> result;
+  TF_ASSERT_OK(RunPass(root, &result));
+
+  EXPECT_EQ(CountOps(*result, "Pad"), 0);
+  EXPECT_THAT(testing::FindNodeByName(result.get(), "out"),
+              NodeWith(Inputs(Out(NodeWith(Name("matmul"))))));
+}
+
+TEST_F(ShapeBucketingForAutoJitPassTest, FullRankConstantPreventsBucketing) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  Scope cluster = root.WithXlaCluster("cluster_0");
+
+  Output a = ops::Placeholder(root.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape({-1, 2}));
+  Output c = ops::Const(cluster.WithOpName("c"), {{1.0f, 2.0f}, {3.0f, 4.0f}});
+  Output add = ops::Add(cluster.WithOpName("add"), a, c);
+  Output out = ops::Identity(root.WithOpName("out"), add);
+
+  std::unique_ptr<Graph> result;
+  TF_ASSERT_OK(RunPass(root, &result));
+
+  EXPECT_EQ(CountOps(*result, "Pad"), 0);
+}
+
+TEST_F(ShapeBucketingForAutoJitPassTest, InvalidBuckets) {
+  GetMarkForCompilationPassFlags()->tf_xla_shape_buckets = "16,foo";
+
+  Scope root = Scope::NewRootScope().ExitOnError();
+  std::unique_ptr<Graph> result;
+  EXPECT_FALSE(RunPass(root, &result).ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
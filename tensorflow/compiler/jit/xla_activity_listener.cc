@@ -72,6 +72,19 @@ Status BroadcastXlaActivity(
   });
 }
 
+Status BroadcastXlaActivity(
+    XlaShapeBucketingActivity shape_bucketing_activity) {
+  return ForEachListener([&](XlaActivityListener* listener) {
+    return listener->Listen(shape_bucketing_activity);
+  });
+}
+
+Status BroadcastXlaActivity(XlaDeclusteringActivity declustering_activity) {
+  return ForEachListener([&](XlaActivityListener* listener) {
+    return listener->Listen(declustering_activity);
+  });
+}
+
 Status BroadcastOptimizationRemark(XlaOptimizationRemark optimization_remark) {
   VLOG(2) << "OptimizationRemark: " << optimization_remark.DebugString();
   return ForEachListener([&](XlaActivityListener* listener) {
@@ -95,6 +108,16 @@ void RegisterXlaActivityListener(
   listener_list->listeners.push_back(std::move(listener));
 }
 
+Status XlaActivityListener::Listen(
+    const XlaShapeBucketingActivity& shape_bucketing_activity) {
+  return Status::OK();
+}
+
+Status XlaActivityListener::Listen(
+    const XlaDeclusteringActivity& declustering_activity) {
+  return Status::OK();
+}
+
 void XlaActivityListener::Flush() {}
 
 XlaActivityListener::~XlaActivityListener() {}
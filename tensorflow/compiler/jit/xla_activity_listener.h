@@ -27,6 +27,12 @@ Status BroadcastXlaActivity(XlaAutoClusteringActivity auto_clustering_activity);
 // Broadcast `jit_compilation_activity` to all the registered listeners.
 Status BroadcastXlaActivity(XlaJitCompilationActivity jit_compilation_activity);
 
+// Broadcast `shape_bucketing_activity` to all the registered listeners.
+Status BroadcastXlaActivity(XlaShapeBucketingActivity shape_bucketing_activity);
+
+// Broadcast `declustering_activity` to all the registered listeners.
+Status BroadcastXlaActivity(XlaDeclusteringActivity declustering_activity);
+
 // Broadcast `jit_compilation_activity` to all the registered listeners.
 Status BroadcastOptimizationRemark(XlaOptimizationRemark optimization_remark);
 
@@ -56,6 +62,19 @@ class XlaActivityListener {
   // Called after TensorFlow realizes possible lost performance.
   virtual Status Listen(const XlaOptimizationRemark& optimization_remark) = 0;
 
+  // Called after TensorFlow pads the inputs of an XLA cluster to bucket
+  // boundaries.
+  //
+  // Default implementation is a no-op.
+  virtual Status Listen(
+      const XlaShapeBucketingActivity& shape_bucketing_activity);
+
+  // Called after TensorFlow auto-clusters a graph, with the reasons nodes were
+  // left out of clusters.
+  //
+  // Default implementation is a no-op.
+  virtual Status Listen(const XlaDeclusteringActivity& declustering_activity);
+
   // Called at program exit in best-effort manner to give listeners a chance to
   // flush their state.
   //
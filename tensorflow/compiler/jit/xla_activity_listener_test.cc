@@ -47,6 +47,12 @@ class TestListener : public XlaActivityListener {
     return Status::OK();
   }
 
+  Status Listen(
+      const XlaDeclusteringActivity& declustering_activity) override {
+    declustering_activity_ = declustering_activity;
+    return Status::OK();
+  }
+
   ~TestListener() override {}
 
   const XlaAutoClusteringActivity& auto_clustering_activity() const {
@@ -55,10 +61,14 @@ class TestListener : public XlaActivityListener {
   const XlaJitCompilationActivity& jit_compilation_activity() const {
     return jit_compilation_activity_;
   }
+  const XlaDeclusteringActivity& declustering_activity() const {
+    return declustering_activity_;
+  }
 
  private:
   XlaAutoClusteringActivity auto_clustering_activity_;
   XlaJitCompilationActivity jit_compilation_activity_;
+  XlaDeclusteringActivity declustering_activity_;
 };
 
 class XlaActivityListenerTest : public ::testing::Test {
@@ -161,6 +171,15 @@ summary {
   EXPECT_EQ(listener()->auto_clustering_activity().DebugString(),
             expected_auto_clustering_activity);
 
+  // Every unclustered node has a reason.
+  int declustered_node_count = 0;
+  for (const XlaDeclusteringActivity::ReasonSummary& summary :
+       listener()->declustering_activity().reasons()) {
+    declustered_node_count += summary.node_count();
+    EXPECT_EQ(summary.node_names_size(), summary.node_count());
+  }
+  EXPECT_EQ(declustered_node_count, 4);
+
   EXPECT_EQ(listener()->jit_compilation_activity().cluster_name(), "cluster_0");
   EXPECT_EQ(listener()->jit_compilation_activity().compile_count(), 1);
 
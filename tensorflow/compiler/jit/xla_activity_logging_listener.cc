@@ -60,6 +60,42 @@ class XlaActivityLoggingListener final : public XlaActivityListener {
     return Status::OK();
   }
 
+  Status Listen(
+      const XlaShapeBucketingActivity& shape_bucketing_activity) override {
+    if (!IsEnabled()) {
+      VLOG(3) << "Logging XlaShapeBucketingActivity disabled";
+      return Status::OK();
+    }
+
+    if (Logger* logger = Logger::GetSingletonAsync()) {
+      VLOG(2) << "Logging XlaShapeBucketingActivity";
+      VLOG(3) << shape_bucketing_activity.DebugString();
+      logger->LogProto(shape_bucketing_activity);
+    } else {
+      VLOG(2) << "Not logging: logger not ready yet.";
+    }
+
+    return Status::OK();
+  }
+
+  Status Listen(
+      const XlaDeclusteringActivity& declustering_activity) override {
+    if (!IsEnabled()) {
+      VLOG(3) << "Logging XlaDeclusteringActivity disabled";
+      return Status::OK();
+    }
+
+    if (Logger* logger = Logger::GetSingletonAsync()) {
+      VLOG(2) << "Logging XlaDeclusteringActivity";
+      VLOG(3) << declustering_activity.DebugString();
+      logger->LogProto(declustering_activity);
+    } else {
+      VLOG(2) << "Not logging: logger not ready yet.";
+    }
+
+    return Status::OK();
+  }
+
   Status Listen(const XlaOptimizationRemark& optimization_remark) override {
     if (!IsEnabled()) {
       VLOG(3) << "Logging XlaJitCompilationActivity disabled";
@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
 
+#include <map>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/container/inlined_vector.h"
@@ -387,6 +390,118 @@ XlaAutoClusteringSummary GetXlaAutoClusteringSummary(const Graph& graph) {
   return result;
 }
 
+XlaDeclusteringActivity GetXlaDeclusteringActivity(
+    const Graph& graph,
+    const absl::flat_hash_map<const Node*, DeclusteringReason>& reasons) {
+  struct ReasonInfo {
+    absl::flat_hash_map<absl::string_view, int> op_histogram;
+    std::vector<string> node_names;
+  };
+  std::map<XlaDeclusteringActivity::Reason, ReasonInfo> reason_to_info;
+  // Keyed by (op, uncompilable reason).
+  std::map<std::pair<string, string>, std::vector<string>>
+      unsupported_op_to_nodes;
+
+  for (Node* n : graph.op_nodes()) {
+    if (GetXlaClusterForNode(*n)) {
+      continue;
+    }
+    auto it = reasons.find(n);
+    XlaDeclusteringActivity::Reason reason =
+        it == reasons.end() ? XlaDeclusteringActivity::OTHER
+                            : it->second.reason;
+    ReasonInfo* info = &reason_to_info[reason];
+    info->op_histogram[n->type_string()]++;
+    info->node_names.push_back(n->name());
+    if (reason == XlaDeclusteringActivity::UNSUPPORTED_OP) {
+      unsupported_op_to_nodes[{n->type_string(),
+                               it->second.uncompilable_reason}]
+          .push_back(n->name());
+    }
+  }
+
+  XlaDeclusteringActivity result;
+  for (auto& pair : reason_to_info) {
+    XlaDeclusteringActivity::ReasonSummary* summary = result.add_reasons();
+    summary->set_reason(pair.first);
+    summary->set_node_count(pair.second.node_names.size());
+    HistogramMapToRepeatedOpAndCount(summary->mutable_op_histogram(),
+                                     pair.second.op_histogram);
+    for (string& name : pair.second.node_names) {
+      summary->add_node_names(std::move(name));
+    }
+  }
+  absl::c_stable_sort(*result.mutable_reasons(),
+                      [](const XlaDeclusteringActivity::ReasonSummary& a,
+                         const XlaDeclusteringActivity::ReasonSummary& b) {
+                        return a.node_count() > b.node_count();
+                      });
+
+  for (auto& pair : unsupported_op_to_nodes) {
+    XlaDeclusteringActivity::UnsupportedOp* op = result.add_unsupported_ops();
+    op->set_op(pair.first.first);
+    op->set_uncompilable_reason(pair.first.second);
+    for (string& name : pair.second) {
+      op->add_node_names(std::move(name));
+    }
+  }
+  absl::c_stable_sort(*result.mutable_unsupported_ops(),
+                      [](const XlaDeclusteringActivity::UnsupportedOp& a,
+                         const XlaDeclusteringActivity::UnsupportedOp& b) {
+                        return a.node_names_size() > b.node_names_size();
+                      });
+
+  return result;
+}
+
+void AddStepStatsToDeclusteringActivity(const StepStats& step_stats,
+                                        XlaDeclusteringActivity* activity) {
+  absl::flat_hash_map<absl::string_view, int64> node_time_us;
+  int64 total_op_time_us = 0;
+  for (const DeviceStepStats& device_stats : step_stats.dev_stats()) {
+    for (const NodeExecStats& node_stats : device_stats.node_stats()) {
+      node_time_us[node_stats.node_name()] += node_stats.all_end_rel_micros();
+      total_op_time_us += node_stats.all_end_rel_micros();
+    }
+  }
+
+  auto time_for_nodes =
+      [&](const protobuf::RepeatedPtrField<string>& node_names) {
+        int64 time_us = 0;
+        for (const string& name : node_names) {
+          auto it = node_time_us.find(name);
+          if (it != node_time_us.end()) {
+            time_us += it->second;
+          }
+        }
+        return time_us;
+      };
+
+  int64 unclustered_op_time_us = 0;
+  for (XlaDeclusteringActivity::ReasonSummary& summary :
+       *activity->mutable_reasons()) {
+    summary.set_op_time_us(time_for_nodes(summary.node_names()));
+    unclustered_op_time_us += summary.op_time_us();
+  }
+  for (XlaDeclusteringActivity::UnsupportedOp& op :
+       *activity->mutable_unsupported_ops()) {
+    op.set_op_time_us(time_for_nodes(op.node_names()));
+  }
+  activity->set_total_op_time_us(total_op_time_us);
+  activity->set_unclustered_op_time_us(unclustered_op_time_us);
+
+  absl::c_stable_sort(*activity->mutable_reasons(),
+                      [](const XlaDeclusteringActivity::ReasonSummary& a,
+                         const XlaDeclusteringActivity::ReasonSummary& b) {
+                        return a.op_time_us() > b.op_time_us();
+                      });
+  absl::c_stable_sort(*activity->mutable_unsupported_ops(),
+                      [](const XlaDeclusteringActivity::UnsupportedOp& a,
+                         const XlaDeclusteringActivity::UnsupportedOp& b) {
+                        return a.op_time_us() > b.op_time_us();
+                      });
+}
+
 namespace {
 using CallTargetListTy = absl::InlinedVector<NameAttrList, 2>;
 
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/compiler/jit/xla_activity.pb.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/stream_executor/lib/statusor.h"
 
@@ -95,6 +96,28 @@ bool IsShapeConsumerOp(const Node& node);
 // `XlaAutoClusteringSummary` for details.
 XlaAutoClusteringSummary GetXlaAutoClusteringSummary(const Graph& graph);
 
+// Why a node was left out of XLA clusters, as determined by auto-clustering.
+struct DeclusteringReason {
+  XlaDeclusteringActivity::Reason reason;
+
+  // For UNSUPPORTED_OP, the reason given by the compilability checker.
+  string uncompilable_reason;
+};
+
+// Computes a declustering report for `graph`, after clustering, from the
+// reasons auto-clustering recorded for nodes it did not put in a cluster.
+// Unclustered nodes missing from `reasons` are reported as OTHER.  See
+// documentation on `XlaDeclusteringActivity` for details.
+XlaDeclusteringActivity GetXlaDeclusteringActivity(
+    const Graph& graph,
+    const absl::flat_hash_map<const Node*, DeclusteringReason>& reasons);
+
+// Fills in the op time fields of `activity` from `step_stats`, which should
+// come from a traced run of the graph `activity` was computed for, and orders
+// its entries by op time.
+void AddStepStatsToDeclusteringActivity(const StepStats& step_stats,
+                                        XlaDeclusteringActivity* activity);
+
 // Returns the set of nodes that have a path to or from nodes that may have ref
 // variables as input or output.
 //
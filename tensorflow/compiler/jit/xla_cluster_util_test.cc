@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/graph_to_functiondef.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
@@ -284,5 +285,50 @@ TEST(NodesRelatedToRefVariables, Cycles) {
 
   EXPECT_EQ(names, expected);
 }
+
+TEST(DeclusteringActivity, AttributesStepStats) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  Output a = ops::Placeholder(root.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Add(root.WithOpName("b"), a, a);
+  Output c = ops::Neg(root.WithOpName("c"), b);
+  Output d = ops::Neg(root.WithOpName("d"), c);
+  b.node()->AddAttr(kXlaClusterAttr, "cluster_0");
+
+  absl::flat_hash_map<const Node*, DeclusteringReason> reasons;
+  reasons[a.node()] = {XlaDeclusteringActivity::UNSUPPORTED_OP, "no kernel"};
+  reasons[c.node()] = {XlaDeclusteringActivity::CLUSTER_TOO_SMALL, ""};
+  reasons[d.node()] = {XlaDeclusteringActivity::CLUSTER_TOO_SMALL, ""};
+
+  XlaDeclusteringActivity activity =
+      GetXlaDeclusteringActivity(*root.graph(), reasons);
+  ASSERT_EQ(activity.reasons_size(), 2);
+  EXPECT_EQ(activity.reasons(0).reason(),
+            XlaDeclusteringActivity::CLUSTER_TOO_SMALL);
+  EXPECT_EQ(activity.reasons(0).node_count(), 2);
+  EXPECT_EQ(activity.reasons(1).reason(),
+            XlaDeclusteringActivity::UNSUPPORTED_OP);
+  ASSERT_EQ(activity.unsupported_ops_size(), 1);
+  EXPECT_EQ(activity.unsupported_ops(0).op(), "Placeholder");
+  EXPECT_EQ(activity.unsupported_ops(0).uncompilable_reason(), "no kernel");
+
+  StepStats step_stats;
+  DeviceStepStats* device_stats = step_stats.add_dev_stats();
+  for (const auto& name_and_time :
+       std::vector<std::pair<string, int64>>{{"a", 30}, {"b", 100}, {"c", 5}}) {
+    NodeExecStats* node_stats = device_stats->add_node_stats();
+    node_stats->set_node_name(name_and_time.first);
+    node_stats->set_all_end_rel_micros(name_and_time.second);
+  }
+
+  AddStepStatsToDeclusteringActivity(step_stats, &activity);
+  EXPECT_EQ(activity.total_op_time_us(), 135);
+  EXPECT_EQ(activity.unclustered_op_time_us(), 35);
+  ASSERT_EQ(activity.reasons_size(), 2);
+  EXPECT_EQ(activity.reasons(0).reason(),
+            XlaDeclusteringActivity::UNSUPPORTED_OP);
+  EXPECT_EQ(activity.reasons(0).op_time_us(), 30);
+  EXPECT_EQ(activity.reasons(1).op_time_us(), 5);
+  EXPECT_EQ(activity.unsupported_ops(0).op_time_us(), 30);
+}
 }  // namespace
 }  // namespace tensorflow
@@ -15,11 +15,14 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
+#include <memory>
 #include <numeric>
 
 #include "absl/base/call_once.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/xla_activity.pb.h"
 #include "tensorflow/compiler/jit/xla_activity_listener.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
@@ -50,6 +53,11 @@ XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
     : client_(client), device_type_(std::move(device_type)) {}
 
 XlaCompilationCache::~XlaCompilationCache() {
+  // Wait for background compilations, which write into the cache entries.
+  {
+    mutex_lock lock(async_compiler_mu_);
+    async_compiler_threads_.reset();
+  }
   // Ensure any use of our programs have completed by waiting for all stream
   // executors to complete.
   for (auto* executor : client_->backend().stream_executors()) {
@@ -162,6 +170,12 @@ Status XlaCompilationCache::BuildExecutable(
   build_options.set_result_layout(result.xla_output_shape);
   build_options.set_device_allocator(options.device_allocator);
   build_options.set_alias_passthrough_params(options.alias_passthrough_params);
+  const string& persistent_cache_dir =
+      GetXlaOpsCommonFlags().tf_xla_persistent_cache_dir;
+  if (!persistent_cache_dir.empty()) {
+    build_options.mutable_debug_options()->set_xla_cpu_persistent_cache_dir(
+        persistent_cache_dir);
+  }
 
   auto compile_result =
       client_->Compile(*result.computation, argument_layouts, build_options);
@@ -180,7 +194,8 @@ Status XlaCompilationCache::Compile(
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
   absl::optional<int64> compile_threshold;
-  if (compile_mode == CompileMode::kLazy) {
+  if (compile_mode == CompileMode::kLazy ||
+      compile_mode == CompileMode::kAsync) {
     compile_threshold = kDefaultCompilationThreshold;
   }
   auto compile_fn = [&](XlaCompiler* compiler,
@@ -189,6 +204,7 @@ Status XlaCompilationCache::Compile(
   };
   return CompileImpl(options, function, args, compile_fn,
                      /*compile_threshold=*/compile_threshold,
+                     /*compile_async=*/compile_mode == CompileMode::kAsync,
                      out_compilation_result, out_executable);
 }
 
@@ -228,7 +244,8 @@ Status XlaCompilationCache::CompileSingleOp(
   };
   return CompileImpl(options, name, args, compile_op,
                      /*compile_threshold=*/absl::nullopt,
-                     out_compilation_result, out_executable);
+                     /*compile_async=*/false, out_compilation_result,
+                     out_executable);
 }
 
 namespace {
@@ -250,7 +267,7 @@ Status XlaCompilationCache::CompileImpl(
     absl::Span<const XlaCompiler::Argument> args,
     const std::function<Status(XlaCompiler* compiler,
                                XlaCompiler::CompilationResult*)>& compile_fn,
-    absl::optional<int64> compile_threshold,
+    absl::optional<int64> compile_threshold, bool compile_async,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
   DCHECK_NE(out_executable, nullptr);
@@ -316,11 +333,19 @@ Status XlaCompilationCache::CompileImpl(
   // cache eviction.
   mutex_lock entry_lock(entry->mu);
   int64 current_request_count = ++entry->request_count;
-  VLOG(2) << "Compilation cache entry hit: " << entry->compiled
+  VLOG(2) << "Compilation cache entry hit: "
+          << static_cast<int>(entry->compile_state)
           << " signature: " << signature.HumanString() << " with request count "
           << current_request_count << " and compile threshold "
           << compile_threshold.value_or(0);
-  if (!entry->compiled) {
+  if (entry->compile_state == CompileState::kCompiling) {
+    VLOG(2) << "Compilation in progress for signature: "
+            << signature.HumanString();
+    *out_compilation_result = nullptr;
+    *out_executable = nullptr;
+    return Status::OK();
+  }
+  if (entry->compile_state == CompileState::kUncompiled) {
     XLA_SCOPED_LOGGING_TIMER("Compilation of XLA executable");
     const bool should_compile = [&] {
       if (!compile_threshold.has_value()) {
@@ -366,7 +391,26 @@ Status XlaCompilationCache::CompileImpl(
     // a long time.)
 
     XlaCompiler compiler(options);
-    entry->compiled = true;
+
+    if (compile_async) {
+      // Lowering to an XLA computation needs the function library and
+      // arguments of this request, so it happens here. Building the
+      // executable, which is usually the expensive part, does not.
+      auto result = std::make_shared<XlaCompiler::CompilationResult>();
+      entry->compilation_status = compile_fn(&compiler, result.get());
+      if (!entry->compilation_status.ok()) {
+        entry->compile_state = CompileState::kCompiled;
+        return entry->compilation_status;
+      }
+      entry->compile_state = CompileState::kCompiling;
+      BuildExecutableAsync(options, function.name(), compile_start_us,
+                           std::move(result), entry);
+      *out_compilation_result = nullptr;
+      *out_executable = nullptr;
+      return Status::OK();
+    }
+
+    entry->compile_state = CompileState::kCompiled;
 
     entry->compilation_status =
         compile_fn(&compiler, &entry->compilation_result);
@@ -376,36 +420,8 @@ Status XlaCompilationCache::CompileImpl(
         BuildExecutable(options, entry->compilation_result, &entry->executable);
 
     const uint64 compile_end_us = env->NowMicros();
-    const uint64 compile_time_us = compile_end_us - compile_start_us;
-    metrics::UpdateXlaCompilationTime(compile_time_us);
-    {
-      mutex_lock lock(cluster_compile_stats_mu_);
-      auto it = cluster_compile_stats_.find(function.name());
-      it->second.compile_count++;
-      it->second.cumulative_compile_time_us += compile_time_us;
-      LogOnceXlaCompiledFirstCluster();
-      VLOG(1) << "compiled " << function.name() << " "
-              << it->second.compile_count
-              << " times, compile time: " << compile_time_us
-              << " us, cumulative: " << it->second.cumulative_compile_time_us
-              << " us ("
-              << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
-                                                               1.0e6)
-              << " / "
-              << tensorflow::strings::HumanReadableElapsedTime(
-                     it->second.cumulative_compile_time_us / 1.0e6)
-              << ")";
-
-      XlaJitCompilationActivity jit_compilation_activity;
-      jit_compilation_activity.set_cluster_name(function.name());
-      jit_compilation_activity.set_compile_count(it->second.compile_count);
-      jit_compilation_activity.set_compile_time_us(compile_time_us);
-      jit_compilation_activity.set_cumulative_compile_time_us(
-          it->second.cumulative_compile_time_us);
-
-      TF_RETURN_IF_ERROR(
-          BroadcastXlaActivity(std::move(jit_compilation_activity)));
-    }
+    TF_RETURN_IF_ERROR(
+        RecordCompilation(function.name(), compile_end_us - compile_start_us));
   }
   TF_RETURN_IF_ERROR(entry->compilation_status);
   *out_compilation_result = &entry->compilation_result;
@@ -413,4 +429,72 @@ Status XlaCompilationCache::CompileImpl(
   return Status::OK();
 }
 
+void XlaCompilationCache::BuildExecutableAsync(
+    const XlaCompiler::Options& options, const string& cluster_name,
+    uint64 compile_start_us,
+    std::shared_ptr<XlaCompiler::CompilationResult> result, Entry* entry) {
+  XlaCompiler::Options build_options = options;
+  // The allocator is owned by the requesting op invocation; let XLA use the
+  // backend's default allocator instead.
+  build_options.device_allocator = nullptr;
+  // Entries are never evicted and the thread pool is destroyed first in our
+  // destructor, so `this` and `entry` outlive the closure.
+  auto build = [this, build_options, cluster_name, compile_start_us, result,
+                entry]() {
+    std::unique_ptr<xla::LocalExecutable> executable;
+    Status status = BuildExecutable(build_options, *result, &executable);
+
+    const uint64 compile_time_us =
+        tensorflow::Env::Default()->NowMicros() - compile_start_us;
+    Status record_status = RecordCompilation(cluster_name, compile_time_us);
+    if (!record_status.ok()) {
+      LOG(WARNING) << "Failed to record compilation of " << cluster_name
+                   << ": " << record_status;
+    }
+
+    mutex_lock lock(entry->mu);
+    entry->compilation_result = std::move(*result);
+    entry->executable = std::move(executable);
+    entry->compilation_status = status;
+    entry->compile_state = CompileState::kCompiled;
+  };
+
+  mutex_lock lock(async_compiler_mu_);
+  if (!async_compiler_threads_) {
+    async_compiler_threads_ = absl::make_unique<thread::ThreadPool>(
+        tensorflow::Env::Default(), "xla_async_compiler",
+        kNumAsyncCompilerThreads);
+  }
+  async_compiler_threads_->Schedule(std::move(build));
+}
+
+Status XlaCompilationCache::RecordCompilation(const string& cluster_name,
+                                              uint64 compile_time_us) {
+  metrics::UpdateXlaCompilationTime(compile_time_us);
+  mutex_lock lock(cluster_compile_stats_mu_);
+  auto it = cluster_compile_stats_.find(cluster_name);
+  it->second.compile_count++;
+  it->second.cumulative_compile_time_us += compile_time_us;
+  LogOnceXlaCompiledFirstCluster();
+  VLOG(1) << "compiled " << cluster_name << " " << it->second.compile_count
+          << " times, compile time: " << compile_time_us
+          << " us, cumulative: " << it->second.cumulative_compile_time_us
+          << " us ("
+          << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
+                                                           1.0e6)
+          << " / "
+          << tensorflow::strings::HumanReadableElapsedTime(
+                 it->second.cumulative_compile_time_us / 1.0e6)
+          << ")";
+
+  XlaJitCompilationActivity jit_compilation_activity;
+  jit_compilation_activity.set_cluster_name(cluster_name);
+  jit_compilation_activity.set_compile_count(it->second.compile_count);
+  jit_compilation_activity.set_compile_time_us(compile_time_us);
+  jit_compilation_activity.set_cumulative_compile_time_us(
+      it->second.cumulative_compile_time_us);
+
+  return BroadcastXlaActivity(std::move(jit_compilation_activity));
+}
+
 }  // namespace tensorflow
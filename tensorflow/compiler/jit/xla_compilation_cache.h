@@ -50,6 +50,7 @@ class XlaCompilationCache : public ResourceBase {
   enum class CompileMode {
     kLazy,
     kStrict,
+    kAsync,
   };
 
   // Compiles a function into a XlaCompiler::CompilationResult that can be used
@@ -62,7 +63,13 @@ class XlaCompilationCache : public ResourceBase {
   // heuristics, the compilation cache may decide not to compile the cluster at
   // this time.  In this case it returns null into both `out_compilation_result`
   // and `out_executable`.  If `compile_mode` is `kStrict` then the compilation
-  // cache always attempts the compilation on a cache miss.
+  // cache always attempts the compilation on a cache miss.  `kAsync` applies
+  // the same heuristics as `kLazy`, but when it decides to compile it only
+  // lowers the function to an XLA computation on the calling thread and builds
+  // the executable on a background thread; until that finishes, requests for
+  // the signature return null into both outputs, as in the lazy case.  The
+  // background build does not use `options.device_allocator`, since that may
+  // not outlive the request.
   //
   // The result of compilation is written to `*out_compilation_result`, which
   // must be non-null. If `out_executable` is non-null, also builds an
@@ -127,7 +134,7 @@ class XlaCompilationCache : public ResourceBase {
       absl::Span<const XlaCompiler::Argument> args,
       const std::function<Status(XlaCompiler* compiler,
                                  XlaCompiler::CompilationResult*)>& compile_fn,
-      absl::optional<int64> compile_threshold,
+      absl::optional<int64> compile_threshold, bool compile_async,
       const XlaCompiler::CompilationResult** out_compilation_result,
       xla::LocalExecutable** out_executable);
 
@@ -137,15 +144,36 @@ class XlaCompilationCache : public ResourceBase {
                          const XlaCompiler::CompilationResult& result,
                          std::unique_ptr<xla::LocalExecutable>* executable);
 
+  // Records a finished compilation of `cluster_name` that took
+  // `compile_time_us` in the cluster statistics and broadcasts it to the XLA
+  // activity listeners.
+  Status RecordCompilation(const string& cluster_name, uint64 compile_time_us);
+
+  struct Entry;
+
+  // Builds the executable for `result` on `async_compiler_threads_` and
+  // publishes both into `entry`, whose compilation must be in progress.
+  void BuildExecutableAsync(
+      const XlaCompiler::Options& options, const string& cluster_name,
+      uint64 compile_start_us,
+      std::shared_ptr<XlaCompiler::CompilationResult> result, Entry* entry);
+
   xla::LocalClient* const client_;
   const DeviceType device_type_;
 
+  enum class CompileState {
+    kUncompiled,
+    // Compilation has been handed to a background thread and has not finished.
+    kCompiling,
+    kCompiled,
+  };
+
   // The value associated with a cache entry.
   struct Entry {
     mutex mu;
 
     // Have we tried compiling this entry?
-    bool compiled = false;
+    CompileState compile_state = CompileState::kUncompiled;
 
     // The number of times a compilation with this signature has been requested.
     int64 request_count = 0;
@@ -191,6 +219,13 @@ class XlaCompilationCache : public ResourceBase {
   // signature before  we attempt to compile it.
   static constexpr int64 kDefaultCompilationThreshold = 2;
 
+  // Threads that build executables for kAsync compilations. Created on first
+  // use, and destroyed (waiting for outstanding builds) before anything else.
+  static constexpr int kNumAsyncCompilerThreads = 4;
+  mutex async_compiler_mu_;
+  std::unique_ptr<thread::ThreadPool> async_compiler_threads_
+      GUARDED_BY(async_compiler_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(XlaCompilationCache);
 };
 
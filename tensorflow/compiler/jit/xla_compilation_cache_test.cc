@@ -16,6 +16,11 @@ limitations under the License.
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
 #include "tensorflow/compiler/tf2xla/shape_util.h"
+#include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -52,6 +57,50 @@ TEST(XlaCompilationCacheTest, SignatureEquality) {
   }
 }
 
+TEST(XlaCompilationCacheTest, AsyncCompilation) {
+  xla::LocalClient* client = xla::ClientLibrary::LocalClientOrDie();
+  FunctionDefLibrary flib;
+  *flib.add_function() = test::function::XTimesTwo();
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(), flib);
+
+  XlaCompiler::Options options;
+  options.device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+  options.client = client;
+  options.flib_def = &flib_def;
+
+  NameAttrList fn;
+  fn.set_name("XTimesTwo");
+  (*fn.mutable_attr())["T"].set_type(DT_FLOAT);
+  std::vector<XlaCompiler::Argument> args(1);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_FLOAT;
+  args[0].shape = TensorShape({2});
+
+  auto* cache = new XlaCompilationCache(client, DeviceType(DEVICE_CPU_XLA_JIT));
+  core::ScopedUnref cache_ref(cache);
+  const XlaCompiler::CompilationResult* compilation_result;
+  xla::LocalExecutable* executable;
+  auto compile = [&]() {
+    return cache->Compile(options, fn, args, XlaCompiler::CompileOptions{},
+                          XlaCompilationCache::CompileMode::kAsync,
+                          &compilation_result, &executable);
+  };
+
+  // The first request only starts building the executable.
+  TF_ASSERT_OK(compile());
+  EXPECT_EQ(compilation_result, nullptr);
+  EXPECT_EQ(executable, nullptr);
+
+  // Later requests return it once it is ready.
+  for (int i = 0; i < 6000 && executable == nullptr; ++i) {
+    Env::Default()->SleepForMicroseconds(10 * 1000);
+    TF_ASSERT_OK(compile());
+  }
+  ASSERT_NE(executable, nullptr);
+  ASSERT_NE(compilation_result, nullptr);
+  EXPECT_EQ(compilation_result->xla_input_shapes.size(), 1);
+}
+
 static void BM_BuildSignature(int iters, int n_args) {
   NameAttrList fn;
   fn.set_name("afunction");
@@ -132,6 +132,17 @@ Status CreateXlaKernel(FunctionLibraryRuntime* flr, const NodeDef& node_def,
 
   // Make sure that kernels have been registered on the JIT device.
   XlaOpRegistry::RegisterCompilationKernels();
+
+  // Devices without an XLA backend, such as the VE, cannot run a function
+  // that must be compiled.
+  const XlaOpRegistry::DeviceRegistration* registration;
+  if (!XlaOpRegistry::GetCompilationDevice(flr->device()->device_type(),
+                                           &registration)) {
+    return errors::Unimplemented(
+        "XLA compilation is not supported on device type ",
+        flr->device()->device_type(), ": ", node_def.ShortDebugString());
+  }
+
   RecursiveCompilabilityChecker::UncompilableNodesMap uncompilable_nodes_map;
   if (!IsCompilable(flr, node_def, &uncompilable_nodes_map)) {
     std::vector<RecursiveCompilabilityChecker::UncompilableNodeInfo>
@@ -35,6 +35,8 @@ DebugOptions DefaultDebugOptionsIgnoringFlags() {
   opts.set_xla_llvm_disable_expensive_passes(false);
   opts.set_xla_backend_optimization_level(3);
   opts.set_xla_cpu_multi_thread_eigen(true);
+  opts.set_xla_cpu_parallel_codegen_threads(1);
+  opts.set_xla_cpu_enable_rematerialization(false);
   opts.set_xla_gpu_cuda_data_dir("./cuda_sdk_lib");
   opts.set_xla_eliminate_hlo_implicit_broadcast(true);
   opts.set_xla_dump_hlo_as_html(false);
@@ -519,6 +521,27 @@ static void AllocateFlags() {
           bool_setter_for(&DebugOptions::set_xla_gpu_deterministic_reductions),
           flag_values->xla_gpu_deterministic_reductions(),
           "Always run deterministic reductions on GPU"),
+      tensorflow::Flag(
+          "xla_cpu_persistent_cache_dir",
+          string_setter_for(&DebugOptions::set_xla_cpu_persistent_cache_dir),
+          flag_values->xla_cpu_persistent_cache_dir(),
+          "Directory in which XLA:CPU caches generated object code across "
+          "processes. Disabled if empty."),
+      tensorflow::Flag(
+          "xla_cpu_parallel_codegen_threads",
+          int32_setter_for(
+              &DebugOptions::set_xla_cpu_parallel_codegen_threads),
+          flag_values->xla_cpu_parallel_codegen_threads(),
+          "Number of threads XLA:CPU uses for LLVM optimization and code "
+          "generation in JIT mode. Values larger than one split the module "
+          "into that many parts that are compiled in parallel."),
+      tensorflow::Flag(
+          "xla_cpu_enable_rematerialization",
+          bool_setter_for(&DebugOptions::set_xla_cpu_enable_rematerialization),
+          flag_values->xla_cpu_enable_rematerialization(),
+          "Rematerialize values in XLA:CPU modules whose peak memory use "
+          "exceeds the memory size of the device, trading recomputation for "
+          "memory."),
   });
   ParseFlagsFromEnvAndDieIfUnknown("XLA_FLAGS", *flag_objects);
 }
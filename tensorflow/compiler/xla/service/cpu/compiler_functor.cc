@@ -82,6 +82,18 @@ class FilteredPassManager : public llvm::legacy::PassManager {
 
 std::unique_ptr<llvm::MemoryBuffer> CompilerFunctor::operator()(
     llvm::Module& module) const {
+  // Key the cache on the unoptimized module; computing it is cheap compared to
+  // the optimization and codegen it lets us skip.
+  string object_cache_key;
+  if (object_cache_) {
+    object_cache_key = ObjectCacheKey(module);
+    if (std::unique_ptr<llvm::MemoryBuffer> cached =
+            object_cache_->Lookup(object_cache_key)) {
+      RunPostCodegenHook(*cached);
+      return cached;
+    }
+  }
+
   FilteredPassManager module_passes(disable_expensive_passes_);
   llvm::legacy::FunctionPassManager function_passes(&module);
 
@@ -145,19 +157,47 @@ std::unique_ptr<llvm::MemoryBuffer> CompilerFunctor::operator()(
   std::unique_ptr<llvm::MemoryBuffer> memory_buffer(
       new llvm::SmallVectorMemoryBuffer(std::move(stream_buffer)));
 
-  if (post_codegen_hook_) {
-    llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> obj_file =
-        llvm::object::ObjectFile::createObjectFile(*memory_buffer);
-    if (obj_file) {
-      post_codegen_hook_(*obj_file.get());
-    } else {
-      LOG(WARNING) << "Could convert memory buffer to object file!";
-    }
+  RunPostCodegenHook(*memory_buffer);
+
+  if (object_cache_) {
+    object_cache_->Insert(object_cache_key, *memory_buffer);
   }
 
   return memory_buffer;
 }
 
+string CompilerFunctor::ObjectCacheKey(const llvm::Module& module) const {
+  string key;
+  llvm::raw_string_ostream stream(key);
+  const llvm::TargetOptions& target_options = target_machine_->Options;
+  stream << target_machine_->getTargetTriple().str() << ";"
+         << target_machine_->getTargetCPU() << ";"
+         << target_machine_->getTargetFeatureString() << ";"
+         << target_machine_->getOptLevel() << ";"
+         << target_options.UnsafeFPMath << target_options.NoInfsFPMath
+         << target_options.NoNaNsFPMath << target_options.NoSignedZerosFPMath
+         << ";" << opt_level_ << ";" << optimize_for_size_ << ";"
+         << disable_expensive_passes_ << ";";
+  fast_math_flags_.print(stream);
+  stream << ";";
+  module.print(stream, /*AAW=*/nullptr);
+  return stream.str();
+}
+
+void CompilerFunctor::RunPostCodegenHook(
+    const llvm::MemoryBuffer& buffer) const {
+  if (!post_codegen_hook_) {
+    return;
+  }
+  llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> obj_file =
+      llvm::object::ObjectFile::createObjectFile(buffer);
+  if (obj_file) {
+    post_codegen_hook_(*obj_file.get());
+  } else {
+    LOG(WARNING) << "Could convert memory buffer to object file!";
+  }
+}
+
 static std::vector<llvm::VecDesc> VectorFunctionsForTargetLibraryInfoImpl() {
   std::vector<llvm::VecDesc> result = {
       {"tanhf", runtime::kTanhV4F32SymbolName, 4},
@@ -16,11 +16,14 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_COMPILER_FUNCTOR_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_COMPILER_FUNCTOR_H_
 
+#include <memory>
+
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Target/TargetMachine.h"
+#include "tensorflow/compiler/xla/service/cpu/persistent_object_cache.h"
 #include "tensorflow/compiler/xla/service/llvm_compiler.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -29,6 +32,10 @@ namespace cpu {
 
 // Functor class for compiling an LLVM module down to an object file. For use by
 // Orc JIT compile layer.
+//
+// If `object_cache` is set, the object file for a module that was compiled
+// before with the same settings is read from it instead of being regenerated.
+// In that case the optimization hooks are not run, only `post_codegen_hook`.
 class CompilerFunctor {
  public:
   explicit CompilerFunctor(
@@ -38,7 +45,8 @@ class CompilerFunctor {
       LLVMCompiler::ModuleHook pre_optimization_hook = nullptr,
       LLVMCompiler::ModuleHook post_optimization_hook = nullptr,
       std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook =
-          nullptr)
+          nullptr,
+      std::shared_ptr<const PersistentObjectCache> object_cache = nullptr)
       : target_machine_(target_machine),
         opt_level_(opt_level),
         optimize_for_size_(optimize_for_size),
@@ -46,7 +54,8 @@ class CompilerFunctor {
         fast_math_flags_(fast_math_flags),
         pre_optimization_hook_(std::move(pre_optimization_hook)),
         post_optimization_hook_(std::move(post_optimization_hook)),
-        post_codegen_hook_(std::move(post_codegen_hook)) {}
+        post_codegen_hook_(std::move(post_codegen_hook)),
+        object_cache_(std::move(object_cache)) {}
 
   // Compile a Module to an ObjectFile.
   std::unique_ptr<llvm::MemoryBuffer> operator()(
@@ -62,6 +71,13 @@ class CompilerFunctor {
                              llvm::legacy::FunctionPassManager* function_passes,
                              unsigned opt_level, unsigned size_level) const;
 
+  // Returns a string that identifies the object file `module` compiles to
+  // under this functor's settings, for use as an `object_cache_` key.
+  string ObjectCacheKey(const llvm::Module& module) const;
+
+  // Invokes post_codegen_hook_, if any, on the object file in `buffer`.
+  void RunPostCodegenHook(const llvm::MemoryBuffer& buffer) const;
+
   llvm::TargetMachine* target_machine_;
   const unsigned opt_level_;
   const bool optimize_for_size_;
@@ -70,6 +86,7 @@ class CompilerFunctor {
   LLVMCompiler::ModuleHook pre_optimization_hook_;
   LLVMCompiler::ModuleHook post_optimization_hook_;
   std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook_;
+  std::shared_ptr<const PersistentObjectCache> object_cache_;
 };
 
 }  // namespace cpu
@@ -67,6 +67,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
+#include "tensorflow/compiler/xla/service/cpu/persistent_object_cache.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
 #include "tensorflow/compiler/xla/service/dot_decomposer.h"
@@ -87,6 +88,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_pass_fix.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 #include "tensorflow/compiler/xla/service/hlo_proto_util.h"
+#include "tensorflow/compiler/xla/service/hlo_rematerialization.h"
+#include "tensorflow/compiler/xla/service/hlo_schedule.h"
 #include "tensorflow/compiler/xla/service/hlo_subcomputation_unification.h"
 #include "tensorflow/compiler/xla/service/hlo_verifier.h"
 #include "tensorflow/compiler/xla/service/indexed_array_analysis.h"
@@ -555,6 +558,45 @@ struct OrcJITPostCompilationHook {
   const HloModule* module;
 };
 
+// Runs rematerialization on 'module' if it is enabled, to bring its peak memory
+// use under the memory size of 'stream_exec'. Updates 'schedule', which must
+// be a schedule of 'module', to the schedule of the rematerialized module.
+Status RematerializeIfEnabled(HloModule* module,
+                              se::StreamExecutor* stream_exec,
+                              const HloCostAnalysis::ShapeSizeFunction& size,
+                              HloSchedule* schedule) {
+  if (!module->config().debug_options().xla_cpu_enable_rematerialization()) {
+    return Status::OK();
+  }
+  XLA_SCOPED_LOGGING_TIMER("CpuCompiler - Rematerialization");
+  const int64 memory_limit_bytes =
+      stream_exec->GetDeviceDescription().device_memory_size();
+
+  // Compressing values only pays off with the tiled layouts of other backends,
+  // so only recompute them.
+  HloRematerialization::RematerializationSizes sizes;
+  HloRematerialization rematerialization(
+      size, memory_limit_bytes, &sizes,
+      /*compact_shape_function=*/nullptr,
+      HloRematerialization::RematerializationMode::kRecomputeOnly);
+  TF_RETURN_IF_ERROR(module->set_schedule(std::move(*schedule)));
+  TF_RETURN_IF_ERROR(rematerialization.Run(module).status());
+  *schedule = module->schedule();
+
+  const string summary = absl::StrFormat(
+      "Memory limit: %s (%d bytes)\n"
+      "Peak memory before rematerialization: %s (%d bytes)\n"
+      "Peak memory after rematerialization: %s (%d bytes)\n",
+      HumanReadableNumBytes(memory_limit_bytes), memory_limit_bytes,
+      HumanReadableNumBytes(sizes.before_bytes), sizes.before_bytes,
+      HumanReadableNumBytes(sizes.after_bytes), sizes.after_bytes);
+  VLOG(1) << module->name() << ": " << summary;
+  if (DumpingEnabledForHloModule(*module)) {
+    DumpToFileInDirOrStdout(*module, "rematerialization", summary);
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
@@ -587,7 +629,9 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
       module->config().debug_options().xla_llvm_disable_expensive_passes(),
       llvm_ir::GetCpuFastMathFlags(module->config()), pre_optimization_ir_hook,
       post_optimization_ir_hook,
-      OrcJITPostCompilationHook::Create(module.get()));
+      OrcJITPostCompilationHook::Create(module.get()),
+      PersistentObjectCache::Create(
+          module->config().debug_options().xla_cpu_persistent_cache_dir()));
   llvm_module->setDataLayout(jit->data_layout());
   llvm_module->setTargetTriple(jit->target_triple().getTriple());
 
@@ -609,6 +653,15 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
   const bool embed_ir_in_executable =
       module->config().debug_options().xla_embed_ir_in_executable();
 
+  // IR and object file dumps and user hooks expect to see the module in one
+  // piece, so only split it for parallel codegen when none of them is active.
+  int codegen_threads =
+      module->config().debug_options().xla_cpu_parallel_codegen_threads();
+  if (DumpingEnabledForHloModule(*module) || user_pre_optimization_hook_ ||
+      user_post_optimization_hook_) {
+    codegen_threads = 1;
+  }
+
   // Select an order for emitting the HLO instructions for each
   // computation. Using this sequence enables tighter buffer liveness analysis
   // and reduced memory usage (as compared to using DependencyHloOrdering).
@@ -616,6 +669,8 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
                       ScheduleModule(module.get(), BufferSizeBytesFunction(),
                                      ComputationSchedulerToModuleScheduler(
                                          DFSMemoryScheduler)));
+  TF_RETURN_IF_ERROR(RematerializeIfEnabled(
+      module.get(), stream_exec, ShapeSizeBytesFunction(), &schedule));
 
   // Run buffer allocation on the HLO graph.
   TF_ASSIGN_OR_RETURN(
@@ -682,7 +737,11 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
   TF_RETURN_IF_ERROR(VerifyLlvmModule(*llvm_module));
 
   // JIT compile the LLVM IR module to in-memory machine code.
-  jit->AddModule(std::move(llvm_module));
+  if (codegen_threads > 1) {
+    jit->AddModuleInParallel(std::move(llvm_module), codegen_threads);
+  } else {
+    jit->AddModule(std::move(llvm_module));
+  }
   cpu_executable.reset(new CpuExecutable(
       std::move(jit), std::move(assignment), std::move(module), function_name,
       std::move(hlo_profile_printer_data), std::move(hlo_profile_index_map)));
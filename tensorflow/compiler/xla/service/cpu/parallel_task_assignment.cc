@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
 
+#include <cmath>
+
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
@@ -49,59 +51,76 @@ class SimpleCostModel : public ParallelCostModel {
   const HloCostAnalysis::ShapeSizeFunction shape_size_;
 };
 
+// Machine parameters of the roofline model used by DefaultCostModel.  They
+// describe a typical server core; only their ratios affect the task counts.
+//
+// Peak arithmetic throughput of one core (2GHz, two 8-wide FMA units).
+constexpr double kFlopsPerSecondPerCore = 32e9;
+// Throughput of the vectorized transcendental functions on one core.
+constexpr double kTranscendentalsPerSecondPerCore = 1e9;
+// Memory bandwidth a single core can sustain.
+constexpr double kBytesPerSecondPerCore = 8e9;
+// Fixed cost of a fork/join: waking up workers and waiting on the barrier.
+constexpr double kForkJoinSeconds = 10e-6;
+// Cost of handing one more task to the intra-op thread pool.
+constexpr double kTaskDispatchSeconds = 1e-6;
+
+// Roofline cost model: estimates the run time of an instruction split into 'n'
+// tasks as the larger of its compute time and its memory time on 'n' cores,
+// plus the fork/join overhead of 'n' tasks, and picks the 'n' that minimizes
+// it.  Memory bandwidth stops scaling after a few cores, so memory bound
+// instructions get fewer tasks than compute bound ones, and instructions too
+// small to amortize the fork/join overhead are not partitioned at all.
 class DefaultCostModel : public ParallelCostModel {
  public:
   DefaultCostModel(const int64 max_parallelism,
                    const HloCostAnalysis::ShapeSizeFunction& shape_size,
                    std::unique_ptr<HloCostAnalysis> cost_analysis)
       : max_parallelism_(max_parallelism),
+        // Limit memory bandwidth scaling by assuming a sub-linear scaling
+        // function (fit based on empirical benchmark results).
+        // TODO(b/29630486) Develop system bandwidth model.
+        memory_bound_parallelism_(std::max<int64>(
+            1, std::ceil(std::sqrt(tensorflow::port::MaxParallelism())))),
         shape_size_(shape_size),
         cost_analysis_(std::move(cost_analysis)) {}
   ~DefaultCostModel() override {}
 
   int64 GetParallelTaskCount(HloInstruction* instruction) override {
-    // Parameters for parallel task count computation.
-    int64 instruction_cost;
-    int64 min_cost_per_thread;
-    int64 max_parallelism;
-    // Calculate flops-to-bytes-ratio for 'instruction'.
-    const int64 bytes_accessed =
-        std::max(int64{1}, cost_analysis_->bytes_accessed(*instruction));
-    const float flops_to_bytes_ratio =
-        cost_analysis_->flop_count(*instruction) /
-        static_cast<float>(bytes_accessed);
-    // Check for I/O bound instructions.
-    if (flops_to_bytes_ratio <= 1.0) {
-      // Limit max parallelism for I/O bound instructions by assuming a
-      // sub-linear scaling function (fit based on empirical benchmark results).
-      // TODO(b/29630486) Develop system bandwidth model.
-      max_parallelism = std::min<int64>(
-          max_parallelism_,
-          std::ceil(std::sqrt(tensorflow::port::MaxParallelism())));
-      // Use shape size instruction cost and L2 cache size min per-thread cost.
-      instruction_cost = shape_size_(instruction->shape());
-      min_cost_per_thread = 256LL << 10;  // 256KB L2 Cache size.
-    } else {
-      // Use max parallelism for compute bound instructions.
-      max_parallelism = max_parallelism_;
-      // Calculate the instruction cost in cycles.
-      // TODO(b/29630486) Improve on this linear cost model.
-      // Consider making 'min_cost_per_thread' be a function of the target
-      // bandwidth limit for instructions with low arithmetic complexity.
-      instruction_cost =
-          1 * cost_analysis_->flop_count(*instruction) +
-          2 * cost_analysis_->transcendental_count(*instruction) +
-          10 * cost_analysis_->bytes_accessed(*instruction);
-      // Minimum per-thread cost is 100us of work on a 2GHz core.
-      min_cost_per_thread = 100000;
+    const double compute_seconds =
+        cost_analysis_->flop_count(*instruction) / kFlopsPerSecondPerCore +
+        cost_analysis_->transcendental_count(*instruction) /
+            kTranscendentalsPerSecondPerCore;
+    // Instructions the analysis has no numbers for (e.g. in the body of a
+    // loop it could not analyze) are assumed to touch their output once.
+    const double bytes_accessed =
+        std::max<double>(cost_analysis_->bytes_accessed(*instruction),
+                         shape_size_(instruction->shape()));
+    const double memory_seconds = bytes_accessed / kBytesPerSecondPerCore;
+
+    int64 best_task_count = 1;
+    double best_seconds = std::max(compute_seconds, memory_seconds);
+    for (int64 task_count = 2; task_count <= max_parallelism_; ++task_count) {
+      const double seconds =
+          std::max(compute_seconds / task_count,
+                   memory_seconds /
+                       std::min(task_count, memory_bound_parallelism_)) +
+          kForkJoinSeconds + task_count * kTaskDispatchSeconds;
+      if (seconds < best_seconds) {
+        best_seconds = seconds;
+        best_task_count = task_count;
+      }
     }
-    // Return target parallel task count in [1, max_parallelism_].
-    return std::min(max_parallelism,
-                    std::max(int64{1}, instruction_cost / min_cost_per_thread));
+    VLOG(3) << "Estimated " << best_seconds * 1e6 << "us with "
+            << best_task_count << " tasks for " << instruction->name()
+            << " (compute " << compute_seconds * 1e6 << "us, memory "
+            << memory_seconds * 1e6 << "us on one core)";
+    return best_task_count;
   }
 
  private:
   const int64 max_parallelism_;
+  const int64 memory_bound_parallelism_;
   const HloCostAnalysis::ShapeSizeFunction shape_size_;
   const std::unique_ptr<HloCostAnalysis> cost_analysis_;
 };
@@ -112,10 +131,17 @@ ParallelTaskAssignment::ParallelTaskAssignment(
     const TargetMachineFeatures* target_machine_features)
     : target_machine_features_(*target_machine_features) {
   VLOG(1) << "ParallelTaskAssignment max_parallelism: " << max_parallelism;
-  // Run cost analysis on 'module'.
+  // Run cost analysis on all computations that can contain instructions we
+  // assign parallel tasks to, i.e. the entry computation and the bodies of
+  // (nested) while loops and calls.
   auto cost_analysis = absl::make_unique<HloCostAnalysis>(shape_size);
-  HloComputation* computation = module->entry_computation();
-  Status status = computation->root_instruction()->Accept(cost_analysis.get());
+  Status status;
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    status = computation->root_instruction()->Accept(cost_analysis.get());
+    if (!status.ok()) {
+      break;
+    }
+  }
   if (status.ok()) {
     // Set default cost model based on 'cost_analysis'.
     cost_model_.reset(new DefaultCostModel(max_parallelism, shape_size,
@@ -170,5 +170,36 @@ TEST_F(ParallelTaskAssignmentTest, InPlaceDynamicUpdateSliceNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(ParallelTaskAssignmentTest, LargeComputeBoundOperationParallelized) {
+  const string hlo_string = R"(
+    HloModule TestTaskParallel_Exp
+    ENTRY Exp {
+      p = f32[4096,1024]{1,0} parameter(0)
+      ROOT exp = f32[4096,1024]{1,0} exponential(p)
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+}
+
+TEST_F(ParallelTaskAssignmentTest, SmallOperationNotParallelized) {
+  // Too little work to amortize the cost of a fork/join.
+  const string hlo_string = R"(
+    HloModule TestTaskParallel_SmallExp
+    ENTRY SmallExp {
+      p = f32[64,64]{1,0} parameter(0)
+      ROOT exp = f32[64,64]{1,0} exponential(p)
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_FALSE(changed);
+}
+
 }  // namespace
 }  // namespace xla
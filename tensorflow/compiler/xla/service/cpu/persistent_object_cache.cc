@@ -0,0 +1,140 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/persistent_object_cache.h"
+
+#include <cstring>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/public/version.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// Bump this whenever the entry layout or the way keys are derived changes.
+constexpr int kCacheFormatVersion = 1;
+
+// Every entry starts with this magic, followed by the 64-bit fingerprint of the
+// object file bytes that come after it.
+constexpr char kEntryMagic[8] = {'X', 'L', 'A', 'C', 'P', 'U', 'O', 'B'};
+constexpr size_t kEntryHeaderSize = sizeof(kEntryMagic) + sizeof(uint64);
+
+}  // namespace
+
+/*static*/ std::unique_ptr<PersistentObjectCache> PersistentObjectCache::Create(
+    const string& directory, tensorflow::Env* env) {
+  if (directory.empty()) {
+    return nullptr;
+  }
+  tensorflow::Status status = env->RecursivelyCreateDir(directory);
+  if (!status.ok()) {
+    LOG(WARNING) << "Not using the persistent XLA:CPU object cache; could not "
+                    "create "
+                 << directory << ": " << status;
+    return nullptr;
+  }
+  VLOG(1) << "Using persistent XLA:CPU object cache in " << directory;
+  return absl::WrapUnique(new PersistentObjectCache(directory, env));
+}
+
+string PersistentObjectCache::EntryPath(absl::string_view key_material) const {
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(
+      absl::StrCat(kCacheFormatVersion, ";", TF_VERSION_STRING, ";",
+                   tf_git_version(), ";", key_material));
+  return tensorflow::io::JoinPath(
+      directory_,
+      absl::StrFormat("%016x%016x.o", fingerprint.high64, fingerprint.low64));
+}
+
+std::unique_ptr<llvm::MemoryBuffer> PersistentObjectCache::Lookup(
+    absl::string_view key_material) const {
+  const string path = EntryPath(key_material);
+  if (!env_->FileExists(path).ok()) {
+    VLOG(2) << "Persistent object cache miss: " << path;
+    return nullptr;
+  }
+  string contents;
+  tensorflow::Status status =
+      tensorflow::ReadFileToString(env_, path, &contents);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not read persistent object cache entry " << path
+                 << ": " << status;
+    return nullptr;
+  }
+
+  uint64 expected_fingerprint;
+  if (contents.size() < kEntryHeaderSize ||
+      std::memcmp(contents.data(), kEntryMagic, sizeof(kEntryMagic)) != 0) {
+    LOG(WARNING) << "Ignoring malformed persistent object cache entry " << path;
+    return nullptr;
+  }
+  std::memcpy(&expected_fingerprint, contents.data() + sizeof(kEntryMagic),
+              sizeof(expected_fingerprint));
+  const absl::string_view object =
+      absl::string_view(contents).substr(kEntryHeaderSize);
+  if (tensorflow::Fingerprint64(object) != expected_fingerprint) {
+    LOG(WARNING) << "Ignoring corrupt persistent object cache entry " << path;
+    return nullptr;
+  }
+
+  VLOG(2) << "Persistent object cache hit: " << path;
+  // Copy into a fresh buffer, which LLVM allocates suitably aligned for
+  // parsing as an object file.
+  return llvm::MemoryBuffer::getMemBufferCopy(
+      llvm::StringRef(object.data(), object.size()), path);
+}
+
+void PersistentObjectCache::Insert(absl::string_view key_material,
+                                   const llvm::MemoryBuffer& object) const {
+  const absl::string_view object_bytes(object.getBufferStart(),
+                                       object.getBufferSize());
+  const uint64 fingerprint = tensorflow::Fingerprint64(object_bytes);
+
+  string contents(kEntryMagic, sizeof(kEntryMagic));
+  contents.append(reinterpret_cast<const char*>(&fingerprint),
+                  sizeof(fingerprint));
+  contents.append(object_bytes.data(), object_bytes.size());
+
+  // Write to a uniquely named temporary and rename it into place, so that
+  // concurrent writers of the same entry cannot interleave and readers never
+  // observe a partially written file. Whichever rename lands last wins; all
+  // candidates are equivalent.
+  const string path = EntryPath(key_material);
+  const string tmp_path =
+      absl::StrCat(path, ".tmp.", absl::Hex(tensorflow::random::New64()));
+  tensorflow::Status status =
+      tensorflow::WriteStringToFile(env_, tmp_path, contents);
+  if (status.ok()) {
+    status = env_->RenameFile(tmp_path, path);
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not write persistent object cache entry " << path
+                 << ": " << status;
+    env_->DeleteFile(tmp_path).IgnoreError();
+    return;
+  }
+  VLOG(2) << "Wrote persistent object cache entry " << path << " ("
+          << object_bytes.size() << " bytes)";
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,72 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PERSISTENT_OBJECT_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PERSISTENT_OBJECT_CACHE_H_
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+namespace cpu {
+
+// An on-disk cache of the object files produced by CompilerFunctor, so that a
+// process that JITs the same LLVM module as an earlier one (e.g. after a
+// restart, or on another replica sharing the directory) can skip LLVM
+// optimization and code generation.
+//
+// Entries are keyed by a fingerprint of caller-provided key material, which
+// must cover everything that influences the generated code. The cache mixes in
+// its own format version and the TensorFlow and LLVM versions, so entries
+// written by a different build are never read back.
+//
+// Any number of processes may share a directory: entries are written to a
+// temporary file and renamed into place, so readers only ever see complete
+// files. Unreadable or corrupt entries are treated as misses.
+class PersistentObjectCache {
+ public:
+  // Returns nullptr if `directory` is empty or cannot be created.
+  static std::unique_ptr<PersistentObjectCache> Create(
+      const string& directory, tensorflow::Env* env = tensorflow::Env::Default());
+
+  // Returns the cached object file for `key_material`, or nullptr on a miss.
+  std::unique_ptr<llvm::MemoryBuffer> Lookup(
+      absl::string_view key_material) const;
+
+  // Stores `object` for `key_material`. Failures are logged and ignored.
+  void Insert(absl::string_view key_material,
+              const llvm::MemoryBuffer& object) const;
+
+  const string& directory() const { return directory_; }
+
+ private:
+  PersistentObjectCache(string directory, tensorflow::Env* env)
+      : directory_(std::move(directory)), env_(env) {}
+
+  // Returns the path of the entry for `key_material`.
+  string EntryPath(absl::string_view key_material) const;
+
+  const string directory_;
+  tensorflow::Env* const env_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PERSISTENT_OBJECT_CACHE_H_
@@ -0,0 +1,98 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/persistent_object_cache.h"
+
+#include <memory>
+#include <vector>
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+class PersistentObjectCacheTest : public ::testing::Test {
+ protected:
+  string CacheDir(const string& name) {
+    return tensorflow::io::JoinPath(tensorflow::testing::TmpDir(),
+                                    "persistent_object_cache_test", name);
+  }
+
+  std::vector<string> Entries(const string& dir) {
+    std::vector<string> children;
+    TF_CHECK_OK(tensorflow::Env::Default()->GetChildren(dir, &children));
+    return children;
+  }
+};
+
+TEST_F(PersistentObjectCacheTest, EmptyDirectoryDisablesCache) {
+  EXPECT_EQ(PersistentObjectCache::Create(""), nullptr);
+}
+
+TEST_F(PersistentObjectCacheTest, RoundTrip) {
+  auto cache = PersistentObjectCache::Create(CacheDir("round_trip"));
+  ASSERT_NE(cache, nullptr);
+
+  EXPECT_EQ(cache->Lookup("module-a"), nullptr);
+
+  const string object = string("\x7f" "ELF object bytes\0with a nul", 28);
+  cache->Insert("module-a",
+                *llvm::MemoryBuffer::getMemBuffer(object, "", false));
+
+  std::unique_ptr<llvm::MemoryBuffer> hit = cache->Lookup("module-a");
+  ASSERT_NE(hit, nullptr);
+  EXPECT_EQ(string(hit->getBufferStart(), hit->getBufferSize()), object);
+  EXPECT_EQ(cache->Lookup("module-b"), nullptr);
+
+  // A second cache over the same directory, as in a restarted process, sees the
+  // entry too. No temporaries are left behind.
+  auto reopened = PersistentObjectCache::Create(CacheDir("round_trip"));
+  ASSERT_NE(reopened, nullptr);
+  EXPECT_NE(reopened->Lookup("module-a"), nullptr);
+  EXPECT_EQ(Entries(CacheDir("round_trip")).size(), 1);
+}
+
+TEST_F(PersistentObjectCacheTest, CorruptEntryIsAMiss) {
+  const string dir = CacheDir("corrupt");
+  auto cache = PersistentObjectCache::Create(dir);
+  ASSERT_NE(cache, nullptr);
+  cache->Insert("module",
+                *llvm::MemoryBuffer::getMemBuffer("object", "", false));
+  ASSERT_NE(cache->Lookup("module"), nullptr);
+
+  std::vector<string> entries = Entries(dir);
+  ASSERT_EQ(entries.size(), 1);
+  const string path = tensorflow::io::JoinPath(dir, entries[0]);
+  string contents;
+  TF_ASSERT_OK(
+      tensorflow::ReadFileToString(tensorflow::Env::Default(), path, &contents));
+  contents.back() ^= 1;
+  TF_ASSERT_OK(
+      tensorflow::WriteStringToFile(tensorflow::Env::Default(), path, contents));
+  EXPECT_EQ(cache->Lookup("module"), nullptr);
+
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(), path,
+                                             "short"));
+  EXPECT_EQ(cache->Lookup("module"), nullptr);
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -22,6 +22,12 @@ using tensorflow::int64;
 
 #ifdef INTEL_MKL
 #include <omp.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
 #include "mkldnn.hpp"
 #include "tensorflow/compiler/xla/service/cpu/runtime_conv2d.h"
 
@@ -48,21 +54,34 @@ using mkldnn::prop_kind;
 using mkldnn::reorder;
 using mkldnn::stream;
 
-template <typename EigenDevice, typename ScalarType>
-void MKLConvImpl(const EigenDevice& device, ScalarType* out, ScalarType* lhs,
-                 ScalarType* rhs, int64 input_batch, int64 input_rows,
-                 int64 input_cols, int64 input_channels, int64 kernel_rows,
-                 int64 kernel_cols, int64 kernel_channels, int64 kernel_filters,
-                 int64 output_rows, int64 output_cols, int64 row_stride,
-                 int64 col_stride, int64 padding_top, int64 padding_bottom,
-                 int64 padding_left, int64 padding_right,
-                 int64 lhs_row_dilation, int64 lhs_col_dilation,
-                 int64 rhs_row_dilation, int64 rhs_col_dilation) {
-  auto cpu_engine = engine(engine::cpu, 0);
-
-  // Create a vector primitive to hold the network.
+// A convolution primitive together with the memory objects it reads and
+// writes. The user-facing memory objects are bound to XLA's buffers on every
+// call; the reorders into and out of the blocked formats MKL-DNN prefers, and
+// the intermediate buffers they use, are set up once per convolution shape.
+struct CachedConvolution {
+  memory user_src_memory;
+  memory user_weights_memory;
+  memory user_dst_memory;
+  // Memory objects the primitives in 'net' refer to, kept alive with them.
+  std::vector<memory> internal_memories;
   std::vector<primitive> net;
-
+};
+
+// Creating a convolution primitive JIT-compiles its kernel, which can take
+// longer than running it on small inputs, so primitives are cached per thread
+// (MKL-DNN primitives aren't safe to share between threads while their memory
+// objects are rebound). The cache is dropped wholesale when it grows past this
+// many entries.
+constexpr int kMaxCachedConvolutionsPerThread = 64;
+
+std::unique_ptr<CachedConvolution> CreateConvolution(
+    const engine& cpu_engine, float* out, float* lhs, float* rhs,
+    int64 input_batch, int64 input_rows,
+    int64 input_cols, int64 input_channels, int64 kernel_rows,
+    int64 kernel_cols, int64 kernel_channels, int64 kernel_filters,
+    int64 output_rows, int64 output_cols, int64 row_stride, int64 col_stride,
+    int64 padding_top, int64 padding_bottom, int64 padding_left,
+    int64 padding_right, int64 rhs_row_dilation, int64 rhs_col_dilation) {
   // Since memory::dims takes int for each dimension, we downcast the int64
   // values to int using the ToInt function defined above.
   memory::dims conv1_src_dim = {ToInt(input_batch), ToInt(input_channels),
@@ -80,21 +99,21 @@ void MKLConvImpl(const EigenDevice& device, ScalarType* out, ScalarType* lhs,
   memory::dims conv1_padding_r = {ToInt(padding_bottom), ToInt(padding_right)};
 
   // Create memory for user data. Input and output data have format of NHWC and
-  // kernel data has format of HWIO.
+  // kernel data has format of HWIO. The data handles are rebound on each call.
   // Note that as a convention in MKL-DNN, the dimensions of the data is always
   // described in NCHW/IOHW, regardless of the actual layout of the data.
-  auto user_src_memory =
-      memory({{{conv1_src_dim}, memory::data_type::f32, memory::format::nhwc},
-              cpu_engine},
-             lhs);
+  auto user_src_memory = memory(
+      {{{conv1_src_dim}, memory::data_type::f32, memory::format::nhwc},
+       cpu_engine},
+      lhs);
   auto user_weights_memory = memory(
       {{{conv1_weights_dim}, memory::data_type::f32, memory::format::hwio},
        cpu_engine},
       rhs);
-  auto user_dst_memory =
-      memory({{{conv1_dst_dim}, memory::data_type::f32, memory::format::nhwc},
-              cpu_engine},
-             out);
+  auto user_dst_memory = memory(
+      {{{conv1_dst_dim}, memory::data_type::f32, memory::format::nhwc},
+       cpu_engine},
+      out);
 
   // Create memory descriptors for convolution data with no specified format for
   // best performance.
@@ -113,20 +132,25 @@ void MKLConvImpl(const EigenDevice& device, ScalarType* out, ScalarType* lhs,
   auto conv1_prim_desc =
       convolution_forward::primitive_desc(conv1_desc, cpu_engine);
 
+  auto conv = absl::make_unique<CachedConvolution>(CachedConvolution{
+      user_src_memory, user_weights_memory, user_dst_memory, {}, {}});
+
   // Create reorders for data and weights if layout requested by convolution is
   // different from NCHW/OIHW.
   auto conv1_src_memory = user_src_memory;
   if (memory::primitive_desc(conv1_prim_desc.src_primitive_desc()) !=
       user_src_memory.get_primitive_desc()) {
     conv1_src_memory = memory(conv1_prim_desc.src_primitive_desc());
-    net.push_back(reorder(user_src_memory, conv1_src_memory));
+    conv->internal_memories.push_back(conv1_src_memory);
+    conv->net.push_back(reorder(user_src_memory, conv1_src_memory));
   }
 
   auto conv1_weights_memory = user_weights_memory;
   if (memory::primitive_desc(conv1_prim_desc.weights_primitive_desc()) !=
       user_weights_memory.get_primitive_desc()) {
     conv1_weights_memory = memory(conv1_prim_desc.weights_primitive_desc());
-    net.push_back(reorder(user_weights_memory, conv1_weights_memory));
+    conv->internal_memories.push_back(conv1_weights_memory);
+    conv->net.push_back(reorder(user_weights_memory, conv1_weights_memory));
   }
 
   // Check if output need layout conversion. If yes, create memory for
@@ -137,14 +161,59 @@ void MKLConvImpl(const EigenDevice& device, ScalarType* out, ScalarType* lhs,
   auto conv1_dst_memory = need_output_conversion
                               ? memory(conv1_prim_desc.dst_primitive_desc())
                               : user_dst_memory;
+  if (need_output_conversion) {
+    conv->internal_memories.push_back(conv1_dst_memory);
+  }
 
   // Create convolution primitive and add it to net.
-  net.push_back(convolution_forward(conv1_prim_desc, conv1_src_memory,
-                                    conv1_weights_memory, conv1_dst_memory));
+  conv->net.push_back(convolution_forward(conv1_prim_desc, conv1_src_memory,
+                                          conv1_weights_memory,
+                                          conv1_dst_memory));
   if (need_output_conversion) {
-    net.push_back(reorder(conv1_dst_memory, user_dst_memory));
+    conv->net.push_back(reorder(conv1_dst_memory, user_dst_memory));
+  }
+  return conv;
+}
+
+template <typename EigenDevice, typename ScalarType>
+void MKLConvImpl(const EigenDevice& device, ScalarType* out, ScalarType* lhs,
+                 ScalarType* rhs, int64 input_batch, int64 input_rows,
+                 int64 input_cols, int64 input_channels, int64 kernel_rows,
+                 int64 kernel_cols, int64 kernel_channels, int64 kernel_filters,
+                 int64 output_rows, int64 output_cols, int64 row_stride,
+                 int64 col_stride, int64 padding_top, int64 padding_bottom,
+                 int64 padding_left, int64 padding_right,
+                 int64 lhs_row_dilation, int64 lhs_col_dilation,
+                 int64 rhs_row_dilation, int64 rhs_col_dilation) {
+  static const engine* cpu_engine = new engine(engine::cpu, 0);
+  thread_local auto* cache =
+      new std::map<std::vector<int64>, std::unique_ptr<CachedConvolution>>();
+
+  std::vector<int64> key = {input_batch,      input_rows,      input_cols,
+                            input_channels,   kernel_rows,     kernel_cols,
+                            kernel_channels,  kernel_filters,  output_rows,
+                            output_cols,      row_stride,      col_stride,
+                            padding_top,      padding_bottom,  padding_left,
+                            padding_right,    rhs_row_dilation, rhs_col_dilation};
+  auto it = cache->find(key);
+  if (it == cache->end()) {
+    if (cache->size() >= kMaxCachedConvolutionsPerThread) {
+      cache->clear();
+    }
+    std::unique_ptr<CachedConvolution> conv = CreateConvolution(
+        *cpu_engine, out, lhs, rhs, input_batch, input_rows, input_cols,
+        input_channels, kernel_rows, kernel_cols, kernel_channels,
+        kernel_filters, output_rows, output_cols, row_stride, col_stride,
+        padding_top, padding_bottom, padding_left, padding_right,
+        rhs_row_dilation, rhs_col_dilation);
+    it = cache->emplace(std::move(key), std::move(conv)).first;
   }
-  stream(stream::kind::eager).submit(net).wait();
+
+  CachedConvolution& conv = *it->second;
+  conv.user_src_memory.set_data_handle(lhs);
+  conv.user_weights_memory.set_data_handle(rhs);
+  conv.user_dst_memory.set_data_handle(out);
+  stream(stream::kind::eager).submit(conv.net).wait();
 }
 }  // namespace
 #endif  // INTEL_MKL
@@ -17,6 +17,9 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <atomic>
+#include <memory>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/compiler/xla/executable_run_options.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
@@ -31,9 +34,29 @@ using tensorflow::uint64;
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      int64*, uint64*);
 
-// Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
-// Calls 'function_ptr' for first partition inline.
-// Uses blocking counter to synchronize threads after parallel calls complete.
+namespace {
+
+// State shared by the calling thread and the workers of one fork/join.  It is
+// reference counted because workers that find no partition left to run may
+// still be starting up after the calling thread has returned.
+struct ForkJoinState {
+  explicit ForkJoinState(int32 num_partitions)
+      : next_partition(0), done(num_partitions) {}
+
+  std::atomic<int32> next_partition;
+  tensorflow::BlockingCounter done;
+};
+
+}  // namespace
+
+// Calls 'function_ptr' for all 'num_partitions' partitions, in parallel on the
+// intra-op thread pool and the calling thread.
+//
+// Partitions are not bound to threads: the calling thread and
+// 'num_partitions - 1' workers claim them one at a time until none are left.
+// If the pool is busy, the calling thread runs the partitions the workers
+// haven't gotten to yet instead of waiting for them, and it returns as soon as
+// every partition has completed.
 //
 // The 'partitions' array has a total number of elements equal to
 // 'num_partitions * num_partitioned_dims * 2' (the '2' is necessary to specify
@@ -81,24 +104,24 @@ TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
   // Compute partition stride in 'partitions' array.
   const int64 stride = 2 * num_partitioned_dims;
 
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
-  tensorflow::BlockingCounter bc(num_partitions - 1);
+  auto state = std::make_shared<ForkJoinState>(num_partitions);
+  auto run_partitions = [state, num_partitions, function, result_ptr,
+                         run_options_ptr, buffer_table, prof_counters,
+                         partitions, stride]() {
+    for (int32 i = state->next_partition.fetch_add(1);
+         i < num_partitions; i = state->next_partition.fetch_add(1)) {
+      function(result_ptr, run_options_ptr, nullptr, buffer_table,
+               &partitions[i * stride], prof_counters);
+      VLOG(3) << "ParallelForkJoin partition " << i << " done.";
+      state->done.DecrementCount();
+    }
+  };
+
+  // Dispatch 'num_partitions - 1' workers and join in on the calling thread.
   for (int32 i = 1; i < num_partitions; ++i) {
-    const int64 offset = i * stride;
-    run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
-         partitions, offset, &bc]() {
-          function(result_ptr, run_options_ptr, nullptr, buffer_table,
-                   &partitions[offset], prof_counters);
-          bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
-        });
+    run_options->intra_op_thread_pool()->enqueueNoNotification(run_partitions);
   }
-
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, buffer_table, &partitions[0],
-           prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
-  bc.Wait();
+  run_partitions();
+  state->done.Wait();
   VLOG(2) << "ParallelForkJoin EXIT";
 }
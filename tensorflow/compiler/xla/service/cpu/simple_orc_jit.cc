@@ -22,13 +22,18 @@ limitations under the License.
 #include <utility>
 
 #include "absl/memory/memory.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Mangler.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/Support/CodeGen.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/orc_jit_memory_mapper.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_conv2d.h"
@@ -45,6 +50,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/windows_compatibility.h"
 #include "tensorflow/compiler/xla/service/custom_call_target_registry.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -88,24 +95,32 @@ SimpleOrcJIT::SimpleOrcJIT(
     bool disable_expensive_passes, llvm::FastMathFlags fast_math_flags,
     LLVMCompiler::ModuleHook pre_optimization_hook,
     LLVMCompiler::ModuleHook post_optimization_hook,
-    std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook)
+    std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook,
+    std::shared_ptr<const PersistentObjectCache> object_cache)
     : target_machine_(InferTargetMachineForJIT(target_options, opt_level)),
       data_layout_(target_machine_->createDataLayout()),
-      symbol_resolver_(llvm::orc::createLegacyLookupResolver(
-          execution_session_,
-          [this](const std::string& name) -> llvm::JITSymbol {
-            return this->ResolveRuntimeSymbol(name);
-          },
-          [](llvm::Error Err) {
-            cantFail(std::move(Err), "lookupFlags failed");
-          })),
+      compiler_functor_factory_(
+          [=](llvm::TargetMachine* target_machine) {
+            return CompilerFunctor(target_machine, opt_level,
+                                   optimize_for_size, disable_expensive_passes,
+                                   fast_math_flags, pre_optimization_hook,
+                                   post_optimization_hook, post_codegen_hook,
+                                   object_cache);
+          }),
       object_layer_(
           execution_session_,
-          [this](llvm::orc::VModuleKey) {
+          [this](llvm::orc::VModuleKey key) {
             llvm::orc::LegacyRTDyldObjectLinkingLayer::Resources result;
             result.MemMgr = std::make_shared<llvm::SectionMemoryManager>(
                 orc_jit_memory_mapper::GetInstance());
-            result.Resolver = symbol_resolver_;
+            result.Resolver = llvm::orc::createLegacyLookupResolver(
+                execution_session_,
+                [this, key](const std::string& name) -> llvm::JITSymbol {
+                  return this->ResolveSymbol(key, name);
+                },
+                [](llvm::Error Err) {
+                  cantFail(std::move(Err), "lookupFlags failed");
+                });
             return result;
           },
           /*NotifyLoaded=*/
@@ -119,19 +134,30 @@ SimpleOrcJIT::SimpleOrcJIT(
           [this](VModuleKeyT, const llvm::object::ObjectFile& object) {
             this->NotifyObjectFreed(object);
           }),
-      compile_layer_(
-          object_layer_,
-          CompilerFunctor(target_machine_.get(), opt_level, optimize_for_size,
-                          disable_expensive_passes, fast_math_flags,
-                          std::move(pre_optimization_hook),
-                          std::move(post_optimization_hook),
-                          std::move(post_codegen_hook))),
+      compile_layer_(object_layer_,
+                     compiler_functor_factory_(target_machine_.get())),
       gdb_jit_event_listener_(
           llvm::JITEventListener::createGDBRegistrationListener()) {
   VLOG(1) << "CPU target: " << target_machine_->getTargetCPU().str()
           << " features: " << target_machine_->getTargetFeatureString().str();
 }
 
+llvm::JITSymbol SimpleOrcJIT::ResolveSymbol(VModuleKeyT requester,
+                                            const std::string& name) {
+  // Modules split by AddModuleInParallel refer to each other's symbols, which
+  // may have hidden visibility.
+  for (VModuleKeyT key : module_keys_) {
+    if (key == requester) {
+      continue;
+    }
+    if (auto symbol = object_layer_.findSymbolIn(
+            key, name, /*ExportedSymbolsOnly=*/false)) {
+      return symbol;
+    }
+  }
+  return ResolveRuntimeSymbol(name);
+}
+
 llvm::JITSymbol SimpleOrcJIT::ResolveRuntimeSymbol(const std::string& name) {
   void* func_addr = nullptr;
   if (name.size() > 1 && name.front() == data_layout_.getGlobalPrefix()) {
@@ -179,6 +205,59 @@ SimpleOrcJIT::VModuleKeyT SimpleOrcJIT::AddModule(
   return key;
 }
 
+std::vector<SimpleOrcJIT::VModuleKeyT> SimpleOrcJIT::AddModuleInParallel(
+    std::unique_ptr<llvm::Module> module, int num_parts) {
+  if (num_parts <= 1) {
+    return {AddModule(std::move(module))};
+  }
+
+  // An LLVMContext must not be used from several threads, so every part is
+  // serialized to bitcode here and materialized in a context of its own on the
+  // thread that compiles it.
+  std::vector<std::string> part_bitcode;
+  llvm::SplitModule(
+      std::move(module), num_parts,
+      [&](std::unique_ptr<llvm::Module> part) {
+        part_bitcode.emplace_back();
+        llvm::raw_string_ostream stream(part_bitcode.back());
+        llvm::WriteBitcodeToFile(*part, stream);
+        stream.flush();
+      },
+      /*PreserveLocals=*/false);
+
+  // TargetMachines aren't thread safe either.
+  std::vector<std::unique_ptr<llvm::TargetMachine>> target_machines;
+  for (int i = 0; i < part_bitcode.size(); ++i) {
+    target_machines.push_back(InferTargetMachineForJIT(
+        target_machine_->Options, target_machine_->getOptLevel()));
+  }
+
+  std::vector<ObjLayerT::ObjectPtr> objects(part_bitcode.size());
+  {
+    tensorflow::thread::ThreadPool pool(tensorflow::Env::Default(),
+                                        "xla_cpu_codegen", part_bitcode.size());
+    for (int i = 0; i < part_bitcode.size(); ++i) {
+      pool.Schedule([&, i]() {
+        llvm::LLVMContext context;
+        std::unique_ptr<llvm::Module> part = cantFail(llvm::parseBitcodeFile(
+            llvm::MemoryBufferRef(part_bitcode[i], "part"), context));
+        objects[i] =
+            compiler_functor_factory_(target_machines[i].get())(*part);
+      });
+    }
+  }
+  VLOG(1) << "Compiled module in " << objects.size() << " parts";
+
+  std::vector<VModuleKeyT> keys;
+  for (ObjLayerT::ObjectPtr& object : objects) {
+    auto key = execution_session_.allocateVModule();
+    cantFail(object_layer_.addObject(key, std::move(object)));
+    module_keys_.push_back(key);
+    keys.push_back(key);
+  }
+  return keys;
+}
+
 void SimpleOrcJIT::RemoveModule(SimpleOrcJIT::VModuleKeyT key) {
   module_keys_.erase(std::remove(module_keys_.begin(), module_keys_.end(), key),
                      module_keys_.end());
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_SIMPLE_ORC_JIT_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_SIMPLE_ORC_JIT_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -29,6 +30,7 @@ limitations under the License.
 #include "llvm/IR/Module.h"
 #include "llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/cpu/compiler_functor.h"
+#include "tensorflow/compiler/xla/service/cpu/persistent_object_cache.h"
 #include "tensorflow/compiler/xla/types.h"
 
 namespace xla {
@@ -39,7 +41,9 @@ namespace cpu {
 // This class wraps Orc's functionality into a single interface that only
 // exposes what we need for XLA.
 //
-// Supports JIT-ing multiple modules but without cross-module linking.
+// Supports JIT-ing multiple modules.  Undefined symbols are resolved against
+// the other modules in the JIT before the XLA runtime, which is what links the
+// parts of a module added with AddModuleInParallel.
 // Implements eager compilation - the module is lowered to binary as soon as
 // it's added to the JIT.
 class SimpleOrcJIT {
@@ -53,14 +57,16 @@ class SimpleOrcJIT {
   //
   // {pre,post}_optimization_hook is invoked on the module before/after all
   // LLVM IR-level optimizations.  post_codegen_hook is invoked after
-  // compiling to machine code.
+  // compiling to machine code.  If object_cache is not null, object files are
+  // looked up in and added to it; see CompilerFunctor.
   SimpleOrcJIT(
       const llvm::TargetOptions& target_options,
       llvm::CodeGenOpt::Level opt_level, bool optimize_for_size,
       bool disable_expensive_passes, llvm::FastMathFlags fast_math_flags,
       LLVMCompiler::ModuleHook pre_optimization_hook,
       LLVMCompiler::ModuleHook post_optimization_hook,
-      std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook);
+      std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook,
+      std::shared_ptr<const PersistentObjectCache> object_cache = nullptr);
 
   const llvm::DataLayout& data_layout() const { return data_layout_; }
 
@@ -72,6 +78,14 @@ class SimpleOrcJIT {
   // remove this module.
   VModuleKeyT AddModule(std::unique_ptr<llvm::Module> module);
 
+  // Like AddModule, but splits `module` into `num_parts` modules that are
+  // optimized and lowered to object files on `num_parts` threads.  The split
+  // is deterministic, so the generated code only depends on `module` and
+  // `num_parts`.  The optimization and post codegen hooks are invoked
+  // concurrently, once per part.  Returns the keys of the parts.
+  std::vector<VModuleKeyT> AddModuleInParallel(
+      std::unique_ptr<llvm::Module> module, int num_parts);
+
   // Remove a module from the JIT and free the memory associated with it.
   void RemoveModule(VModuleKeyT key);
 
@@ -88,6 +102,9 @@ class SimpleOrcJIT {
       llvm::CodeGenOpt::Level opt_level);
 
  private:
+  // Resolves an undefined symbol of the object added under `requester`.
+  llvm::JITSymbol ResolveSymbol(VModuleKeyT requester, const std::string& name);
+
   llvm::JITSymbol ResolveRuntimeSymbol(const std::string& name);
 
   void NotifyObjectFinalized(
@@ -98,8 +115,12 @@ class SimpleOrcJIT {
   std::vector<VModuleKeyT> module_keys_;
   std::unique_ptr<llvm::TargetMachine> target_machine_;
   const llvm::DataLayout data_layout_;
+
+  // Creates the CompilerFunctor that lowers modules for `target_machine`.
+  std::function<CompilerFunctor(llvm::TargetMachine* target_machine)>
+      compiler_functor_factory_;
+
   llvm::orc::ExecutionSession execution_session_;
-  std::shared_ptr<llvm::orc::SymbolResolver> symbol_resolver_;
   ObjLayerT object_layer_;
   CompileLayerT compile_layer_;
 
@@ -0,0 +1,86 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// Runs a module made up of several computations, which end up in different
+// parts when the module is split for parallel codegen and have to be linked
+// back together by the JIT.
+class CpuParallelCodegenTest : public HloTestBase,
+                               public ::testing::WithParamInterface<int> {
+ private:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = HloTestBase::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_parallel_codegen_threads(GetParam());
+    return debug_options;
+  }
+};
+
+TEST_P(CpuParallelCodegenTest, CallsAcrossParts) {
+  const char* hlo_text = R"(
+HloModule CallsAcrossParts
+
+add {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT sum = f32[] add(a, b)
+}
+
+max {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT maximum = f32[] maximum(a, b)
+}
+
+ENTRY main {
+  x = f32[4,3] parameter(0)
+  c = f32[4,3] constant({{1, 2, 3}, {4, 5, 6}, {7, 8, 9}, {10, 11, 12}})
+  xc = f32[4,3] multiply(x, c)
+  zero = f32[] constant(0)
+  sums = f32[4] reduce(xc, zero), dimensions={1}, to_apply=add
+  lowest = f32[] constant(-inf)
+  maxes = f32[4] reduce(xc, lowest), dimensions={1}, to_apply=max
+  ROOT result = (f32[4], f32[4]) tuple(sums, maxes)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo_text));
+
+  Literal x = LiteralUtil::CreateR2<float>(
+      {{2, 2, 2}, {2, 2, 2}, {2, 2, 2}, {2, 2, 2}});
+  Literal result = ExecuteAndTransfer(std::move(module), {&x});
+
+  Literal expected = LiteralUtil::MakeTupleOwned(
+      LiteralUtil::CreateR1<float>({12, 30, 48, 66}),
+      LiteralUtil::CreateR1<float>({6, 12, 18, 24}));
+  EXPECT_TRUE(LiteralTestUtil::Equal(expected, result));
+}
+
+// More threads than functions leaves some parts empty.
+INSTANTIATE_TEST_CASE_P(CpuParallelCodegenTestInstantiation,
+                        CpuParallelCodegenTest, ::testing::Values(1, 4, 64));
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
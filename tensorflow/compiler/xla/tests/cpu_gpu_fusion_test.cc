@@ -824,8 +824,9 @@ XLA_TEST_F(FusionClientLibraryTest, ManyLayoutTransformations) {
   ComputeAndCompare(&b, {});
 }
 
-void BM_ParallelFusion(int num_iters) {
-  // Simple element-wise computation to benchmark parallel task partitioning.
+void BM_ParallelFusion(int num_iters, int dim) {
+  // Simple element-wise computation to benchmark parallel task partitioning,
+  // on [dim, dim] operands from cache resident to memory bound sizes.
   tensorflow::testing::StopTiming();
 
   se::Platform* platform = PlatformUtil::GetDefaultPlatform().ValueOrDie();
@@ -842,12 +843,12 @@ void BM_ParallelFusion(int num_iters) {
   int device_ordinal = client->default_device_ordinal();
 
   // Computation shape parameters.
-  const int64 param0_dim0 = 1024;
-  const int64 param0_dim1 = 1024;
-  const int64 param1_dim0 = 1024;
-  const int64 param1_dim1 = 1024;
-  const int64 param2_dim0 = 1024;
-  const int64 param2_dim1 = 1024;
+  const int64 param0_dim0 = dim;
+  const int64 param0_dim1 = dim;
+  const int64 param1_dim0 = dim;
+  const int64 param1_dim1 = dim;
+  const int64 param2_dim0 = dim;
+  const int64 param2_dim1 = dim;
 
   // Create computation.
   XlaBuilder builder("ParallelFusion");
@@ -911,9 +912,9 @@ void BM_ParallelFusion(int num_iters) {
   }
 
   // Run benchmark.
-  const int64 total_bytes = param0_dim0 * param0_dim0 +
-                            param1_dim0 * param1_dim0 +
-                            param2_dim0 * param2_dim0;
+  const int64 total_bytes = param0_dim0 * param0_dim1 +
+                            param1_dim0 * param1_dim1 +
+                            param2_dim0 * param2_dim1;
   tensorflow::testing::BytesProcessed(static_cast<int64>(num_iters) *
                                       total_bytes * sizeof(float));
   tensorflow::testing::UseRealTime();
@@ -924,7 +925,7 @@ void BM_ParallelFusion(int num_iters) {
   }
 }
 
-BENCHMARK(BM_ParallelFusion);
+BENCHMARK(BM_ParallelFusion)->Arg(64)->Arg(256)->Arg(1024)->Arg(4096);
 
 }  // namespace
 }  // namespace xla
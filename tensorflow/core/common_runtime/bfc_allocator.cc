@@ -16,13 +16,17 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 
 #include <atomic>
+#include <thread>
 
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -30,11 +34,50 @@ limitations under the License.
 #include "tensorflow/core/platform/stacktrace.h"
 #endif
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/scoped_memory_debug_annotation.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/bfc_memory_map.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+namespace {
+
+auto* bfc_free_bytes = monitoring::Gauge<int64, 1>::New(
+    "/tensorflow/core/bfc_allocator/free_bytes",
+    "Bytes in free chunks of a BFC allocator.", "allocator");
+
+auto* bfc_largest_free_chunk_bytes = monitoring::Gauge<int64, 1>::New(
+    "/tensorflow/core/bfc_allocator/largest_free_chunk_bytes",
+    "Size of the largest free chunk of a BFC allocator. With free_bytes it "
+    "measures fragmentation.",
+    "allocator");
+
+auto* bfc_bin_free_bytes = monitoring::Gauge<int64, 2>::New(
+    "/tensorflow/core/bfc_allocator/bin_free_bytes",
+    "Bytes in free chunks of a bin of a BFC allocator.", "allocator",
+    "bin_size");
+
+auto* bfc_bin_largest_free_chunk_bytes = monitoring::Gauge<int64, 2>::New(
+    "/tensorflow/core/bfc_allocator/bin_largest_free_chunk_bytes",
+    "Size of the largest free chunk in a bin of a BFC allocator.",
+    "allocator", "bin_size");
+
+auto* bfc_released_region_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/bfc_allocator/released_region_bytes",
+    "Bytes of free regions a BFC allocator released to its sub-allocator.",
+    "allocator");
+
+void AtomicMax(std::atomic<int64>* value, int64 candidate) {
+  int64 current = value->load(std::memory_order_relaxed);
+  while (candidate > current &&
+         !value->compare_exchange_weak(current, candidate,
+                                       std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name,
                            bool garbage_collection)
@@ -73,6 +116,28 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
       CHECK_NE(BinForSize(bin_size * 2), BinFromIndex(b));
     }
   }
+
+  bool use_chunk_cache = false;
+  Status s = ReadBoolFromEnvVar("TF_BFC_ALLOCATOR_SMALL_CHUNK_CACHE",
+                                /*default_val=*/false, &use_chunk_cache);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+  }
+  if (use_chunk_cache) {
+    VLOG(1) << "Enabling the small chunk cache of " << name_;
+    cache_shards_.reset(new CacheShard[kNumCacheShards]);
+  }
+
+  if (allow_growth) {
+    int64 release_secs = 0;
+    s = ReadInt64FromEnvVar("TF_BFC_ALLOCATOR_REGION_RELEASE_SECS",
+                            /*default_val=*/0, &release_secs);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+    }
+    region_release_interval_micros_ =
+        std::max<int64>(release_secs, 0) * 1000000;
+  }
 }
 
 BFCAllocator::~BFCAllocator() {
@@ -372,9 +437,19 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // so all memory addresses are nicely byte aligned.
   size_t rounded_bytes = RoundedBytes(num_bytes);
 
+  if (cache_shards_ != nullptr && rounded_bytes <= kMaxCachedChunkBytes &&
+      freed_before == 0 && timing_counter_ == nullptr) {
+    void* ptr = AllocateCachedChunk(rounded_bytes, num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
+  // Read outside of lock_ to keep the critical section short.
+  const uint64 now_micros = Env::Default()->NowMicros();
   mutex_lock l(lock_);
   if (!timestamped_chunks_.empty()) {
     // Merge timestamped chunks whose counts have become safe for general use.
@@ -382,7 +457,8 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   }
   void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
   if (ptr != nullptr) {
-    AddTraceMe("MemoryAllocation");
+    AddTraceMe("MemoryAllocation", ptr);
+    MaybeUpdateFragmentationStats(now_micros);
     return ptr;
   }
 
@@ -390,7 +466,17 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   if (Extend(unused_alignment, rounded_bytes)) {
     ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
     if (ptr != nullptr) {
-      AddTraceMe("MemoryAllocation");
+      AddTraceMe("MemoryAllocation", ptr);
+      return ptr;
+    }
+  }
+
+  // The free chunks held by the small chunk cache may coalesce with their
+  // neighbors into a chunk that fits.
+  if (cache_shards_ != nullptr && FlushChunkCache()) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      AddTraceMe("MemoryAllocation", ptr);
       return ptr;
     }
   }
@@ -403,7 +489,7 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     if (MergeTimestampedChunks(rounded_bytes)) {
       ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
       if (ptr != nullptr) {
-        AddTraceMe("MemoryAllocation");
+        AddTraceMe("MemoryAllocation", ptr);
         return ptr;
       }
     }
@@ -417,7 +503,7 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
       Extend(unused_alignment, rounded_bytes)) {
     ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
     if (ptr != nullptr) {
-      AddTraceMe("MemoryAllocation");
+      AddTraceMe("MemoryAllocation", ptr);
       return ptr;
     }
   }
@@ -441,26 +527,51 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   return nullptr;
 }
 
-void BFCAllocator::AddTraceMe(absl::string_view traceme_name) {
+void BFCAllocator::AddTraceMe(absl::string_view traceme_name,
+                              const void* chunk_ptr) {
+  if (!profiler::TraceMe::Active(kMemoryTraceMeLevel)) return;
+  const Chunk* chunk = ChunkFromHandle(region_manager_.get_handle(chunk_ptr));
+  AddTraceMe(traceme_name, chunk_ptr, chunk->requested_size, chunk->size);
+}
+
+void BFCAllocator::AddTraceMe(absl::string_view traceme_name,
+                              const void* chunk_ptr, int64 req_bytes,
+                              int64 alloc_bytes) {
   tensorflow::profiler::TraceMe trace_me(
       [&]() EXCLUSIVE_LOCKS_REQUIRED(lock_) {
         AllocatorStats stats = stats_;
+        // Chunks handed out by the small chunk cache are only counted in the
+        // cached_* counters.
+        stats.bytes_in_use +=
+            cached_bytes_in_use_.load(std::memory_order_relaxed);
+        stats.peak_bytes_in_use =
+            std::max(stats.peak_bytes_in_use,
+                     cached_peak_bytes_in_use_.load(std::memory_order_relaxed));
         double fragmentation = GetFragmentation();
         int64 bytes_available =
             memory_limit_ - stats.bytes_reserved - stats.bytes_in_use;
-        return absl::StrCat(traceme_name, "#allocator_name=", name_,
-                            ",bytes_reserved=", stats.bytes_reserved,
-                            ",bytes_allocated=", stats.bytes_in_use,
-                            ",bytes_available=", bytes_available,
-                            ",fragmentation=", fragmentation,
-                            ",peak_bytes_in_use=", stats.peak_bytes_in_use,
-                            "#");
+        const auto& annotation =
+            profiler::ScopedMemoryDebugAnnotation::CurrentAnnotation();
+        return absl::StrCat(
+            traceme_name, "#allocator_name=", name_,
+            ",bytes_reserved=", stats.bytes_reserved,
+            ",bytes_allocated=", stats.bytes_in_use,
+            ",bytes_available=", bytes_available,
+            ",fragmentation=", fragmentation,
+            ",peak_bytes_in_use=", stats.peak_bytes_in_use,
+            ",requested_bytes=", req_bytes,
+            ",allocation_bytes=", alloc_bytes,
+            ",addr=", reinterpret_cast<uint64>(chunk_ptr),
+            ",tf_op=",
+            annotation.pending_op_name ? annotation.pending_op_name : "",
+            ",id=", annotation.pending_step_id, "#");
       },
-      /*level=*/2);
+      kMemoryTraceMeLevel);
 }
 
-void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
-                                 size_t num_bytes, uint64 freed_before) {
+BFCAllocator::ChunkHandle BFCAllocator::FindFreeChunk(BinNum bin_num,
+                                                      size_t rounded_bytes,
+                                                      uint64 freed_before) {
   // First identify the first bin that could satisfy rounded_bytes.
   for (; bin_num < kNumBins; bin_num++) {
     // Start searching from the first bin for the smallest chunk that fits
@@ -487,52 +598,233 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
             static_cast<int64>(chunk->size) - rounded_bytes >=
                 kMaxInternalFragmentation) {
           SplitChunk(h, rounded_bytes);
-          chunk = ChunkFromHandle(h);  // Update chunk pointer in case it moved
         }
+        return h;
+      }
+    }
+  }
 
-        // The requested size of the returned chunk is what the user
-        // has allocated.
-        chunk->requested_size = num_bytes;
-        // Assign a unique id and increment the id counter, marking the
-        // chunk as being in use.
-        chunk->allocation_id = next_allocation_id_++;
-
-        // Update stats.
-        ++stats_.num_allocs;
-        stats_.bytes_in_use += chunk->size;
-        stats_.peak_bytes_in_use =
-            std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
-        stats_.largest_alloc_size =
-            std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
+  return kInvalidChunkHandle;
+}
+
+void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
+                                 size_t num_bytes, uint64 freed_before) {
+  const ChunkHandle h = FindFreeChunk(bin_num, rounded_bytes, freed_before);
+  if (h == kInvalidChunkHandle) {
+    return nullptr;
+  }
+  BFCAllocator::Chunk* chunk = ChunkFromHandle(h);
+
+  // The requested size of the returned chunk is what the user
+  // has allocated.
+  chunk->requested_size = num_bytes;
+  // Assign a unique id and increment the id counter, marking the
+  // chunk as being in use.
+  chunk->allocation_id = next_allocation_id_++;
+
+  // Update stats.
+  ++stats_.num_allocs;
+  stats_.bytes_in_use += chunk->size;
+  uncached_bytes_in_use_.store(stats_.bytes_in_use, std::memory_order_relaxed);
+  stats_.peak_bytes_in_use = std::max(
+      stats_.peak_bytes_in_use,
+      stats_.bytes_in_use +
+          cached_bytes_in_use_.load(std::memory_order_relaxed));
+  stats_.largest_alloc_size =
+      std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
 
 #ifdef TENSORFLOW_MEM_DEBUG
-        if (ShouldRecordOpName()) {
-          if (pending_op_name != nullptr) {
-            chunk->op_name = pending_op_name;
-          } else {
-            LOG(INFO) << "missing pending_op_name for " << Name()
-                      << " reading addr "
-                      << static_cast<const void*>(&pending_op_name) << "\n"
-                      << CurrentStackTrace();
-            chunk->op_name = nullptr;
-          }
-          chunk->action_count = ++action_counter_;
-          chunk->step_id = pending_step_id;
-          int slot = chunk->action_count % MEM_DEBUG_SIZE_HISTORY_SIZE;
-          size_history_[slot] = stats_.bytes_in_use;
-        }
+  if (ShouldRecordOpName()) {
+    if (pending_op_name != nullptr) {
+      chunk->op_name = pending_op_name;
+    } else {
+      LOG(INFO) << "missing pending_op_name for " << Name()
+                << " reading addr "
+                << static_cast<const void*>(&pending_op_name) << "\n"
+                << CurrentStackTrace();
+      chunk->op_name = nullptr;
+    }
+    chunk->action_count = ++action_counter_;
+    chunk->step_id = pending_step_id;
+    int slot = chunk->action_count % MEM_DEBUG_SIZE_HISTORY_SIZE;
+    size_history_[slot] = stats_.bytes_in_use;
+  }
 #endif
 
-        VLOG(4) << "Returning: " << chunk->ptr;
-        if (VLOG_IS_ON(4)) {
-          LOG(INFO) << "A: " << RenderOccupancy();
-        }
-        return chunk->ptr;
+  VLOG(4) << "Returning: " << chunk->ptr;
+  if (VLOG_IS_ON(4)) {
+    LOG(INFO) << "A: " << RenderOccupancy();
+  }
+  return chunk->ptr;
+}
+
+BFCAllocator::CacheShard* BFCAllocator::ThreadCacheShard() const {
+  const size_t hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+  return &cache_shards_[hash % kNumCacheShards];
+}
+
+BFCAllocator::CacheShard* BFCAllocator::PtrCacheShard(const void* ptr) const {
+  const std::uintptr_t p = reinterpret_cast<std::uintptr_t>(ptr);
+  return &cache_shards_[(p >> kMinAllocationBits) % kNumCacheShards];
+}
+
+void* BFCAllocator::AllocateCachedChunk(size_t rounded_bytes,
+                                        size_t num_bytes) {
+  const int size_index = rounded_bytes / kMinAllocationSize - 1;
+  CacheShard* shard = ThreadCacheShard();
+  CachedChunk chunk;
+  {
+    mutex_lock l(shard->mu);
+    std::vector<CachedChunk>& free_chunks = shard->free_chunks[size_index];
+    if (!free_chunks.empty()) {
+      chunk = free_chunks.back();
+      free_chunks.pop_back();
+    }
+  }
+
+  if (chunk.ptr == nullptr) {
+    // Take a few chunks from the bins at once. Chunks owned by the cache are
+    // marked in use with allocation id 0 but are not counted in stats_.
+    CachedChunk refill[kCacheRefillChunks];
+    int num_refill = 0;
+    {
+      mutex_lock l(lock_);
+      if (!timestamped_chunks_.empty()) {
+        MergeTimestampedChunks(0);
+      }
+      const BinNum bin_num = BinNumForSize(rounded_bytes);
+      for (; num_refill < kCacheRefillChunks; ++num_refill) {
+        const ChunkHandle h = FindFreeChunk(bin_num, rounded_bytes, 0);
+        if (h == kInvalidChunkHandle) break;
+        Chunk* c = ChunkFromHandle(h);
+        c->allocation_id = 0;
+        c->requested_size = 0;
+        refill[num_refill].ptr = c->ptr;
+        refill[num_refill].size = c->size;
+        refill[num_refill].rounded_bytes = rounded_bytes;
       }
     }
+    // Let the caller extend the allocator if needed.
+    if (num_refill == 0) {
+      return nullptr;
+    }
+    chunk = refill[0];
+    if (num_refill > 1) {
+      mutex_lock l(shard->mu);
+      std::vector<CachedChunk>& free_chunks = shard->free_chunks[size_index];
+      free_chunks.insert(free_chunks.end(), refill + 1, refill + num_refill);
+    }
   }
 
-  return nullptr;
+  chunk.requested_size = num_bytes;
+  chunk.allocation_id = next_allocation_id_++;
+  {
+    CacheShard* ptr_shard = PtrCacheShard(chunk.ptr);
+    mutex_lock l(ptr_shard->mu);
+    ptr_shard->in_use.emplace(chunk.ptr, chunk);
+  }
+
+  cached_num_allocs_.fetch_add(1, std::memory_order_relaxed);
+  const int64 bytes_in_use =
+      cached_bytes_in_use_.fetch_add(chunk.size, std::memory_order_relaxed) +
+      chunk.size;
+  AtomicMax(&cached_peak_bytes_in_use_,
+            bytes_in_use +
+                uncached_bytes_in_use_.load(std::memory_order_relaxed));
+  AtomicMax(&cached_largest_alloc_size_, chunk.size);
+  if (TF_PREDICT_FALSE(profiler::TraceMe::Active(kMemoryTraceMeLevel))) {
+    mutex_lock l(lock_);
+    AddTraceMe("MemoryAllocation", chunk.ptr, chunk.requested_size,
+               chunk.size);
+  }
+  return chunk.ptr;
+}
+
+bool BFCAllocator::DeallocateCachedChunk(void* ptr) {
+  CachedChunk chunk;
+  {
+    CacheShard* ptr_shard = PtrCacheShard(ptr);
+    mutex_lock l(ptr_shard->mu);
+    auto it = ptr_shard->in_use.find(ptr);
+    if (it == ptr_shard->in_use.end()) {
+      return false;
+    }
+    chunk = it->second;
+    ptr_shard->in_use.erase(it);
+  }
+  cached_bytes_in_use_.fetch_sub(chunk.size, std::memory_order_relaxed);
+  if (TF_PREDICT_FALSE(profiler::TraceMe::Active(kMemoryTraceMeLevel))) {
+    mutex_lock l(lock_);
+    AddTraceMe("MemoryDeallocation", chunk.ptr, chunk.requested_size,
+               chunk.size);
+  }
+  chunk.requested_size = 0;
+  chunk.allocation_id = -1;
+
+  // Chunks freed while a timing counter is set must not be reused before the
+  // safe frontier passes them, which only the bins keep track of.
+  if (timing_counter_ == nullptr) {
+    const int size_index = chunk.rounded_bytes / kMinAllocationSize - 1;
+    CacheShard* shard = ThreadCacheShard();
+    mutex_lock l(shard->mu);
+    std::vector<CachedChunk>& free_chunks = shard->free_chunks[size_index];
+    if (free_chunks.size() < kMaxCachedChunksPerSize) {
+      free_chunks.push_back(chunk);
+      return true;
+    }
+  }
+
+  mutex_lock l(lock_);
+  ReleaseCachedChunk(chunk.ptr);
+  return true;
+}
+
+bool BFCAllocator::FindCachedChunk(const void* ptr, CachedChunk* chunk) const {
+  if (cache_shards_ == nullptr) {
+    return false;
+  }
+  CacheShard* ptr_shard = PtrCacheShard(ptr);
+  mutex_lock l(ptr_shard->mu);
+  auto it = ptr_shard->in_use.find(ptr);
+  if (it == ptr_shard->in_use.end()) {
+    return false;
+  }
+  *chunk = it->second;
+  return true;
+}
+
+void BFCAllocator::ReleaseCachedChunk(void* ptr) {
+  const ChunkHandle h = region_manager_.get_handle(ptr);
+  CHECK(h != kInvalidChunkHandle);
+  Chunk* c = ChunkFromHandle(h);
+  CHECK(c->in_use() && (c->bin_num == kInvalidBinNum));
+  c->allocation_id = -1;
+  if (timing_counter_) {
+    c->freed_at_count = timing_counter_->next();
+    InsertFreeChunkIntoBin(h);
+    timestamped_chunks_.push_back(h);
+  } else {
+    InsertFreeChunkIntoBin(TryToCoalesce(h, false));
+  }
+}
+
+bool BFCAllocator::FlushChunkCache() {
+  std::vector<CachedChunk> to_release;
+  for (int i = 0; i < kNumCacheShards; ++i) {
+    CacheShard* shard = &cache_shards_[i];
+    mutex_lock l(shard->mu);
+    for (std::vector<CachedChunk>& free_chunks : shard->free_chunks) {
+      to_release.insert(to_release.end(), free_chunks.begin(),
+                        free_chunks.end());
+      free_chunks.clear();
+    }
+  }
+  VLOG(1) << "Flushing " << to_release.size() << " chunks from the small"
+          << " chunk cache of " << Name();
+  for (const CachedChunk& chunk : to_release) {
+    ReleaseCachedChunk(chunk.ptr);
+  }
+  return !to_release.empty();
 }
 
 void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
@@ -585,11 +877,18 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     VLOG(2) << "tried to deallocate nullptr";
     return;
   }
+  if (cache_shards_ != nullptr && DeallocateCachedChunk(ptr)) {
+    return;
+  }
+  const uint64 now_micros = Env::Default()->NowMicros();
   mutex_lock l(lock_);
 
   // Find the chunk from the ptr.
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
+  // Coalescing below may merge the chunk with its neighbors.
+  const int64 req_bytes = ChunkFromHandle(h)->requested_size;
+  const int64 alloc_bytes = ChunkFromHandle(h)->size;
 
   MarkFree(h);
 
@@ -605,7 +904,8 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     LOG(INFO) << "F: " << RenderOccupancy();
   }
 
-  AddTraceMe("MemoryDeallocation");
+  AddTraceMe("MemoryDeallocation", ptr, req_bytes, alloc_bytes);
+  MaybeUpdateFragmentationStats(now_micros);
 }
 
 // Merges h1 and h2 when Chunk(h1)->next is h2 and Chunk(h2)->prev is c1.
@@ -657,6 +957,7 @@ void BFCAllocator::InsertFreeChunkIntoBin(BFCAllocator::ChunkHandle h) {
   Bin* new_bin = BinFromIndex(bin_num);
   c->bin_num = bin_num;
   new_bin->free_chunks.insert(h);
+  new_bin->total_free_bytes += c->size;
 }
 
 void BFCAllocator::RemoveFreeChunkIterFromBin(
@@ -666,6 +967,7 @@ void BFCAllocator::RemoveFreeChunkIterFromBin(
   Chunk* c = ChunkFromHandle(h);
   CHECK(!c->in_use() && (c->bin_num != kInvalidBinNum));
   free_chunks->erase(citer);
+  BinFromIndex(c->bin_num)->total_free_bytes -= c->size;
   c->bin_num = kInvalidBinNum;
 }
 
@@ -674,6 +976,7 @@ void BFCAllocator::RemoveFreeChunkFromBin(BFCAllocator::ChunkHandle h) {
   CHECK(!c->in_use() && (c->bin_num != kInvalidBinNum));
   CHECK_GT(BinFromIndex(c->bin_num)->free_chunks.erase(h), 0)
       << "Could not find chunk in bin";
+  BinFromIndex(c->bin_num)->total_free_bytes -= c->size;
   c->bin_num = kInvalidBinNum;
 }
 
@@ -691,6 +994,7 @@ void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h) {
 
   // Updates the stats.
   stats_.bytes_in_use -= c->size;
+  uncached_bytes_in_use_.store(stats_.bytes_in_use, std::memory_order_relaxed);
 
 #ifdef TENSORFLOW_MEM_DEBUG
   if (ShouldRecordOpName()) {
@@ -822,6 +1126,10 @@ bool BFCAllocator::TracksAllocationSizes() const { return true; }
 
 size_t BFCAllocator::RequestedSize(const void* ptr) const {
   CHECK(ptr);
+  CachedChunk chunk;
+  if (FindCachedChunk(ptr, &chunk)) {
+    return chunk.requested_size;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -831,6 +1139,10 @@ size_t BFCAllocator::RequestedSize(const void* ptr) const {
 }
 
 size_t BFCAllocator::AllocatedSize(const void* ptr) const {
+  CachedChunk chunk;
+  if (FindCachedChunk(ptr, &chunk)) {
+    return chunk.size;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -840,6 +1152,10 @@ size_t BFCAllocator::AllocatedSize(const void* ptr) const {
 }
 
 int64 BFCAllocator::AllocationId(const void* ptr) const {
+  CachedChunk chunk;
+  if (FindCachedChunk(ptr, &chunk)) {
+    return chunk.allocation_id;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -1116,16 +1432,90 @@ double BFCAllocator::GetFragmentation() {
   return frag_metric;
 }
 
+void BFCAllocator::MaybeUpdateFragmentationStats(uint64 now_micros) {
+  if (region_release_interval_micros_ > 0 &&
+      now_micros >= next_region_release_micros_) {
+    next_region_release_micros_ = now_micros + region_release_interval_micros_;
+    ReleaseFreeRegions();
+  }
+  if (now_micros < next_fragmentation_stats_micros_) {
+    return;
+  }
+  next_fragmentation_stats_micros_ =
+      now_micros + kFragmentationStatsIntervalMicros;
+
+  int64 free_bytes = 0;
+  int64 largest_free_chunk = 0;
+  for (BinNum b = 0; b < kNumBins; b++) {
+    const Bin* bin = BinFromIndex(b);
+    int64 bin_largest_free_chunk = 0;
+    if (!bin->free_chunks.empty()) {
+      // free_chunks is sorted by size.
+      bin_largest_free_chunk =
+          ChunkFromHandle(*bin->free_chunks.rbegin())->size;
+    }
+    const string bin_size = strings::StrCat(bin->bin_size);
+    bfc_bin_free_bytes->GetCell(name_, bin_size)->Set(bin->total_free_bytes);
+    bfc_bin_largest_free_chunk_bytes->GetCell(name_, bin_size)
+        ->Set(bin_largest_free_chunk);
+    free_bytes += bin->total_free_bytes;
+    largest_free_chunk = std::max(largest_free_chunk, bin_largest_free_chunk);
+  }
+  bfc_free_bytes->GetCell(name_)->Set(free_bytes);
+  bfc_largest_free_chunk_bytes->GetCell(name_)->Set(largest_free_chunk);
+}
+
+void BFCAllocator::ReleaseFreeRegions() {
+  // Chunks waiting for the safe frontier are referenced by
+  // timestamped_chunks_ and must stay.
+  if (timing_counter_ != nullptr) {
+    return;
+  }
+  absl::flat_hash_set<void*> free_region_ptrs;
+  int64 free_region_bytes = 0;
+  for (const AllocationRegion& region : region_manager_.regions()) {
+    const Chunk* c = ChunkFromHandle(region_manager_.get_handle(region.ptr()));
+    if (!c->in_use() && c->size == region.memory_size()) {
+      free_region_ptrs.insert(region.ptr());
+      free_region_bytes += region.memory_size();
+    }
+  }
+  if (free_region_ptrs.empty()) {
+    return;
+  }
+  VLOG(1) << "Releasing " << free_region_ptrs.size() << " free regions of "
+          << Name() << " ("
+          << strings::HumanReadableNumBytes(free_region_bytes) << ")";
+  DeallocateRegions(free_region_ptrs);
+  bfc_released_region_bytes->GetCell(name_)->IncrementBy(free_region_bytes);
+}
+
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats = stats_;
+  if (cache_shards_ != nullptr) {
+    stats.num_allocs += cached_num_allocs_.load(std::memory_order_relaxed);
+    stats.bytes_in_use += cached_bytes_in_use_.load(std::memory_order_relaxed);
+    stats.peak_bytes_in_use =
+        std::max(stats.peak_bytes_in_use,
+                 cached_peak_bytes_in_use_.load(std::memory_order_relaxed));
+    stats.largest_alloc_size =
+        std::max(stats.largest_alloc_size,
+                 cached_largest_alloc_size_.load(std::memory_order_relaxed));
+  }
+  return stats;
 }
 
 void BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
   stats_.num_allocs = 0;
-  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  stats_.peak_bytes_in_use =
+      stats_.bytes_in_use +
+      cached_bytes_in_use_.load(std::memory_order_relaxed);
   stats_.largest_alloc_size = 0;
+  cached_num_allocs_.store(0, std::memory_order_relaxed);
+  cached_peak_bytes_in_use_.store(0, std::memory_order_relaxed);
+  cached_largest_alloc_size_.store(0, std::memory_order_relaxed);
 }
 
 std::array<BFCAllocator::BinDebugInfo, BFCAllocator::kNumBins>
@@ -17,12 +17,14 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
@@ -116,9 +118,17 @@ class BFCAllocator : public Allocator {
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Add TraceMe (in memory allocation and deallocation) for memory stats
-  // profiling.
-  void AddTraceMe(absl::string_view traceme_name)
+  // profiling. Each event carries the allocator state after the operation,
+  // the chunk and the op it is attributed to by ScopedMemoryDebugAnnotation.
+  // The first form looks up the sizes of the allocated chunk at `chunk_ptr`.
+  void AddTraceMe(absl::string_view traceme_name, const void* chunk_ptr)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void AddTraceMe(absl::string_view traceme_name, const void* chunk_ptr,
+                  int64 req_bytes, int64 alloc_bytes)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // TraceMe level of the memory profile events.
+  static const int kMemoryTraceMeLevel = 2;
 
   // A ChunkHandle is an index into the chunks_ vector in BFCAllocator
   // kInvalidChunkHandle means an invalid chunk
@@ -238,6 +248,8 @@ class BFCAllocator : public Allocator {
     // List of free chunks within the bin, sorted by chunk size.
     // Chunk * not owned.
     FreeChunkSet free_chunks;
+    // Sum of the sizes of free_chunks.
+    size_t total_free_bytes = 0;
     Bin(BFCAllocator* allocator, size_t bs)
         : bin_size(bs), free_chunks(ChunkComparator(allocator)) {}
   };
@@ -401,6 +413,68 @@ class BFCAllocator : public Allocator {
   void* FindChunkPtr(BinNum bin_num, size_t rounded_bytes, size_t num_bytes,
                      uint64 freed_before) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Removes a free chunk of at least 'rounded_bytes' from the bins, splitting
+  // it if it is much larger, and returns its handle, or kInvalidChunkHandle.
+  ChunkHandle FindFreeChunk(BinNum bin_num, size_t rounded_bytes,
+                            uint64 freed_before)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Small chunk cache.
+  //
+  // When enabled, allocations of up to kMaxCachedChunkBytes are served from
+  // shards of chunks that were freed recently, so that most small
+  // allocations and deallocations only take the lock of one shard instead of
+  // lock_. A thread takes free chunks from the shard its id hashes to, and
+  // the chunks it hands out are tracked by the shard their pointer hashes to.
+  //
+  // Chunks owned by the cache stay in use from the point of view of the bins
+  // until the cache is flushed, which happens when an allocation cannot be
+  // satisfied otherwise. The cache keeps its own stats, which GetStats adds
+  // to stats_.
+  static const size_t kMaxCachedChunkBytes = 4096;
+  static const int kNumCachedSizes = kMaxCachedChunkBytes / kMinAllocationSize;
+  static const int kNumCacheShards = 16;
+  // Bound on the free chunks of each size in a shard.
+  static const size_t kMaxCachedChunksPerSize = 16;
+  // Number of chunks taken from the bins when a shard has none of a size.
+  static const int kCacheRefillChunks = 4;
+
+  struct CachedChunk {
+    void* ptr = nullptr;
+    size_t size = 0;  // Full size of the underlying chunk.
+    size_t rounded_bytes = 0;
+    size_t requested_size = 0;
+    int64 allocation_id = -1;
+  };
+
+  struct CacheShard {
+    mutex mu;
+    // Free chunks owned by the cache, indexed by rounded size.
+    std::vector<CachedChunk> free_chunks[kNumCachedSizes] GUARDED_BY(mu);
+    // Chunks handed out by the cache, keyed by pointer.
+    absl::flat_hash_map<const void*, CachedChunk> in_use GUARDED_BY(mu);
+  };
+
+  CacheShard* ThreadCacheShard() const;
+  CacheShard* PtrCacheShard(const void* ptr) const;
+
+  // Returns nullptr if there is no free chunk left of 'rounded_bytes'.
+  void* AllocateCachedChunk(size_t rounded_bytes, size_t num_bytes)
+      LOCKS_EXCLUDED(lock_);
+
+  // Returns false if 'ptr' was not allocated by the cache.
+  bool DeallocateCachedChunk(void* ptr) LOCKS_EXCLUDED(lock_);
+
+  // Copies the entry of 'ptr' to 'chunk' if it was allocated by the cache.
+  bool FindCachedChunk(const void* ptr, CachedChunk* chunk) const;
+
+  // Returns the chunk at 'ptr', owned by the cache, to the bins.
+  void ReleaseCachedChunk(void* ptr) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns all free chunks owned by the cache to the bins. Returns true if
+  // there were any.
+  bool FlushChunkCache() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Splits the chunk specified by 'h' into two chunks, one at least
   // of size 'num_bytes'.
   void SplitChunk(ChunkHandle h, size_t num_bytes)
@@ -447,6 +521,17 @@ class BFCAllocator : public Allocator {
   // size over total free memory, and returns a value within [0, 1].
   double GetFragmentation() EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // At most once per kFragmentationStatsIntervalMicros, exports the free
+  // bytes of each bin and, if enabled, releases the regions that are
+  // entirely free back to the sub-allocator. `now_micros` is read by the
+  // caller before taking lock_.
+  static const int64 kFragmentationStatsIntervalMicros = 1000000;
+  void MaybeUpdateFragmentationStats(uint64 now_micros)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Releases the regions that consist of a single free chunk.
+  void ReleaseFreeRegions() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Information about a Bin that is useful for debugging.
   struct BinDebugInfo {
     size_t total_bytes_in_use = 0;
@@ -517,6 +602,12 @@ class BFCAllocator : public Allocator {
   // memory fragmentation.
   bool garbage_collection_;
 
+  // With allow_growth, free regions are released at most this often, set by
+  // TF_BFC_ALLOCATOR_REGION_RELEASE_SECS.  Zero disables the release.
+  int64 region_release_interval_micros_ = 0;
+  uint64 next_region_release_micros_ GUARDED_BY(lock_) = 0;
+  uint64 next_fragmentation_stats_micros_ GUARDED_BY(lock_) = 0;
+
   std::unique_ptr<SubAllocator> sub_allocator_;
   string name_;
   SharedCounter* timing_counter_ = nullptr;
@@ -534,11 +625,23 @@ class BFCAllocator : public Allocator {
   ChunkHandle free_chunks_list_ GUARDED_BY(lock_);
 
   // Counter containing the next unique identifier to assign to a
-  // newly-created chunk.
-  int64 next_allocation_id_ GUARDED_BY(lock_);
+  // newly-created chunk.  It is atomic because the small chunk cache assigns
+  // identifiers without holding lock_.
+  std::atomic<int64> next_allocation_id_;
 
   // Stats.
   AllocatorStats stats_ GUARDED_BY(lock_);
+
+  // nullptr unless the small chunk cache is enabled.
+  std::unique_ptr<CacheShard[]> cache_shards_;
+
+  // Stats of the allocations served by the small chunk cache, and a copy of
+  // stats_.bytes_in_use that can be read without holding lock_.
+  std::atomic<int64> cached_num_allocs_{0};
+  std::atomic<int64> cached_bytes_in_use_{0};
+  std::atomic<int64> cached_peak_bytes_in_use_{0};
+  std::atomic<int64> cached_largest_alloc_size_{0};
+  std::atomic<int64> uncached_bytes_in_use_{0};
 #ifdef TENSORFLOW_MEM_DEBUG
   int64 action_counter_ GUARDED_BY(lock_);
 #define MEM_DEBUG_SIZE_HISTORY_SIZE 4096
@@ -63,7 +63,10 @@ const char* GetCollectiveName(const CollectiveParams* cp, bool nccl) {
       return "HierarchicalTreeBroadcast";
 
     case REDUCTION_COLLECTIVE:
-      return nccl ? "NcclReduce" : "RingReduce";
+      if (nccl) return "NcclReduce";
+      return cp->instance.impl_details.communication_hint == "hierarchical_ring"
+                 ? "HierarchicalRingReduce"
+                 : "RingReduce";
 
     case GATHER_COLLECTIVE:
       return "RingGather";
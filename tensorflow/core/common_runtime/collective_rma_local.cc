@@ -128,16 +128,19 @@ void CollectiveRemoteAccessLocal::MemCpyAsync(
   const bool non_cpu_dst = dst_device_type != DeviceType(DEVICE_CPU);
   // For GPU devices when only one compute stream is used (the default)
   // the OpKernelContext does not supply a DeviceContext.  It's assumed
-  // that all nodes use the default context.
-  if (src_dev_ctx == nullptr && src_device_type == DEVICE_GPU) {
+  // that all nodes use the default context.  VE devices publish their
+  // default context the same way.
+  if (src_dev_ctx == nullptr &&
+      (src_device_type == DEVICE_GPU || src_device_type == DEVICE_VE)) {
     const DeviceBase::GpuDeviceInfo* dev_info =
         src_dev->tensorflow_gpu_device_info();
     CHECK(dev_info);
     src_dev_ctx = dev_info->default_context;
   }
-  if (dst_dev_ctx == nullptr && dst_device_type == DEVICE_GPU) {
+  if (dst_dev_ctx == nullptr &&
+      (dst_device_type == DEVICE_GPU || dst_device_type == DEVICE_VE)) {
     const DeviceBase::GpuDeviceInfo* dev_info =
-        src_dev->tensorflow_gpu_device_info();
+        dst_dev->tensorflow_gpu_device_info();
     CHECK(dev_info);
     dst_dev_ctx = dev_info->default_context;
   }
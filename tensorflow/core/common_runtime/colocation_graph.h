@@ -38,8 +38,7 @@ class Member {
   Member() = default;
 
   Status SetParentAndSupportedDevices(
-      const Node& node, const std::vector<DeviceType>& types,
-      const DeviceNameUtils::ParsedName* local_address_spec);
+      const Node& node, const PrioritizedDeviceTypeVector& supported_types);
 
   const DeviceNameUtils::ParsedName& requested_device_name() const {
     return requested_device_name_;
@@ -343,6 +342,13 @@ class ColocationGraph {
 
   Status InitializeMember(const Node& node, Member* member);
 
+  // Sets `*supported_types` to the device types having a kernel for `node`.
+  // Nodes agreeing on everything SupportedDeviceTypesForNode looks at share
+  // the result, which avoids one kernel registry lookup per device type and
+  // node on large graphs.
+  Status GetSupportedDeviceTypes(const Node& node,
+                                 PrioritizedDeviceTypeVector* supported_types);
+
   // Returns the root node of the disjoint tree to which the node with the
   // given id is connected.
   // FindRoot should be called only for debugging or after the members have
@@ -365,6 +371,8 @@ class ColocationGraph {
   const Device* default_local_device_;
   const bool allow_soft_placement_;
   const bool log_device_placement_;
+  std::unordered_map<string, PrioritizedDeviceTypeVector>
+      supported_device_types_cache_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ColocationGraph);
 };
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include <algorithm>
 #include <atomic>
+#include <list>
 #include <set>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -26,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/graph_runner.h"
 #include "tensorflow/core/common_runtime/memory_types.h"
+#include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -36,10 +39,15 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/setround.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -558,6 +566,129 @@ bool ReplaceTensorWithConstant(
   return true;
 }
 
+// Constant graphs with at least this many nodes are evaluated on a thread
+// pool, so that independent foldable subgraphs run in parallel.
+const int kMinNodesForParallelFolding = 1000;
+
+// Returns a fingerprint of the computation of `fetches` in `constant_graph`
+// that does not depend on node names, which may be generated, or 0 if the
+// graph calls functions, whose definition may change under the same name.
+uint64 ConstantGraphFingerprint(const Graph& constant_graph,
+                                const std::vector<NodeAndOutput>& fetches) {
+  uint64 fingerprint = 0;
+  string serialized;
+  for (const Node* n : constant_graph.nodes()) {
+    const OpRegistrationData* op_reg_data;
+    if (n->IsOp() &&
+        !OpRegistry::Global()->LookUp(n->type_string(), &op_reg_data).ok()) {
+      return 0;
+    }
+    fingerprint = FingerprintCat64(fingerprint, n->id());
+    fingerprint =
+        FingerprintCat64(fingerprint, Fingerprint64(n->type_string()));
+    std::vector<std::pair<string, const AttrValue*>> attrs;
+    for (const auto& attr : n->attrs()) {
+      attrs.emplace_back(attr.first, &attr.second);
+    }
+    std::sort(attrs.begin(), attrs.end());
+    for (const auto& attr : attrs) {
+      serialized.clear();
+      SerializeToStringDeterministic(*attr.second, &serialized);
+      fingerprint = FingerprintCat64(fingerprint, Fingerprint64(attr.first));
+      fingerprint = FingerprintCat64(fingerprint, Fingerprint64(serialized));
+    }
+    std::vector<std::tuple<int, int, int>> inputs;
+    for (const Edge* e : n->in_edges()) {
+      inputs.emplace_back(e->dst_input(), e->src()->id(), e->src_output());
+    }
+    std::sort(inputs.begin(), inputs.end());
+    for (const auto& input : inputs) {
+      fingerprint = FingerprintCat64(fingerprint, std::get<0>(input));
+      fingerprint = FingerprintCat64(fingerprint, std::get<1>(input));
+      fingerprint = FingerprintCat64(fingerprint, std::get<2>(input));
+    }
+  }
+  for (const NodeAndOutput& fetch : fetches) {
+    fingerprint = FingerprintCat64(fingerprint, fetch.first->id());
+    fingerprint = FingerprintCat64(fingerprint, fetch.second);
+  }
+  // Reserve 0 for "not cacheable".
+  return fingerprint == 0 ? 1 : fingerprint;
+}
+
+// Process-wide cache of evaluated constant graphs, so that rebuilding the
+// executors of a graph, e.g. when a session is extended or recreated, does
+// not evaluate the same constants again. Its size in bytes is bounded by
+// TF_CONSTANT_FOLDING_CACHE_BYTES, which is 0, disabling it, by default.
+class ConstantFoldingCache {
+ public:
+  static ConstantFoldingCache* Global() {
+    static ConstantFoldingCache* cache = new ConstantFoldingCache;
+    return cache;
+  }
+
+  bool enabled() const { return capacity_bytes_ > 0; }
+
+  bool Lookup(uint64 fingerprint, std::vector<Tensor>* outputs) {
+    mutex_lock l(mu_);
+    auto it = entries_.find(fingerprint);
+    if (it == entries_.end()) {
+      return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+    *outputs = it->second.outputs;
+    return true;
+  }
+
+  void Insert(uint64 fingerprint, const std::vector<Tensor>& outputs) {
+    int64 bytes = 0;
+    for (const Tensor& t : outputs) {
+      bytes += t.TotalBytes();
+    }
+    if (bytes > capacity_bytes_) {
+      return;
+    }
+    mutex_lock l(mu_);
+    if (entries_.count(fingerprint) > 0) {
+      return;
+    }
+    while (bytes_ + bytes > capacity_bytes_) {
+      auto it = entries_.find(lru_.back());
+      bytes_ -= it->second.bytes;
+      entries_.erase(it);
+      lru_.pop_back();
+    }
+    lru_.push_front(fingerprint);
+    Entry& entry = entries_[fingerprint];
+    entry.outputs = outputs;
+    entry.bytes = bytes;
+    entry.lru_position = lru_.begin();
+    bytes_ += bytes;
+  }
+
+ private:
+  ConstantFoldingCache() {
+    Status s = ReadInt64FromEnvVar("TF_CONSTANT_FOLDING_CACHE_BYTES",
+                                   /*default_val=*/0, &capacity_bytes_);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+    }
+  }
+
+  struct Entry {
+    std::vector<Tensor> outputs;
+    int64 bytes;
+    std::list<uint64>::iterator lru_position;
+  };
+
+  int64 capacity_bytes_ = 0;
+  mutex mu_;
+  std::unordered_map<uint64, Entry> entries_ GUARDED_BY(mu_);
+  // Most recently used first.
+  std::list<uint64> lru_ GUARDED_BY(mu_);
+  int64 bytes_ GUARDED_BY(mu_) = 0;
+};
+
 }  // namespace
 
 Status ConstantFold(const ConstantFoldingOptions& opts,
@@ -623,7 +754,20 @@ Status ConstantFold(const ConstantFoldingOptions& opts,
     tensors_to_replace.push_back(n.second);
   }
 
-  auto graph_runner = std::unique_ptr<GraphRunner>(new GraphRunner(env));
+  ConstantFoldingCache* cache = ConstantFoldingCache::Global();
+  uint64 fingerprint = 0;
+  if (cache->enabled()) {
+    std::vector<NodeAndOutput> fetches;
+    for (const auto& n : tensors_to_fetch_sorted) {
+      fetches.push_back(n.first);
+    }
+    fingerprint = ConstantGraphFingerprint(*constant_graph, fetches);
+  }
+
+  // The thread pool is only created for large graphs and outlives the
+  // GraphRunner that schedules on it.
+  std::unique_ptr<thread::ThreadPool> thread_pool;
+  std::unique_ptr<GraphRunner> graph_runner;
   // Evaluate the constant foldable nodes.
   std::vector<Tensor> outputs;
   auto delete_tensors = gtl::MakeCleanup([&graph_runner, &outputs] {
@@ -632,13 +776,38 @@ Status ConstantFold(const ConstantFoldingOptions& opts,
     graph_runner.reset(nullptr);
   });
 
-  Status s =
-      graph_runner->Run(constant_graph.get(), function_library, {} /* inputs*/,
-                        tensors_to_fetch_names, &outputs);
-  if (!s.ok()) {
-    VLOG(1) << "Could not fetch constants: " << s;
-    *was_mutated = false;
-    return s;
+  bool cached = false;
+  if (fingerprint != 0) {
+    cached = cache->Lookup(fingerprint, &outputs);
+    metrics::RecordConstantFoldingCacheLookup(cached);
+  }
+  if (cached) {
+    VLOG(1) << "Found " << outputs.size() << " folded constants in the cache";
+  } else {
+    if (constant_graph->num_node_ids() >= kMinNodesForParallelFolding &&
+        port::MaxParallelism() > 1) {
+      // A dedicated pool rather than the caller's: the caller may itself
+      // run on an inter-op thread, which would then block on its own pool.
+      thread_pool.reset(new thread::ThreadPool(env, "constant_folding",
+                                               port::MaxParallelism()));
+      graph_runner.reset(new GraphRunner(
+          env, [&thread_pool](std::function<void()> c) {
+            thread_pool->Schedule(std::move(c));
+          }));
+    } else {
+      graph_runner.reset(new GraphRunner(env));
+    }
+    Status s = graph_runner->Run(constant_graph.get(), function_library,
+                                 {} /* inputs*/, tensors_to_fetch_names,
+                                 &outputs);
+    if (!s.ok()) {
+      VLOG(1) << "Could not fetch constants: " << s;
+      *was_mutated = false;
+      return s;
+    }
+    if (fingerprint != 0) {
+      cache->Insert(fingerprint, outputs);
+    }
   }
 
   // Fetch the constant tensors and replace the corresponding tensors in the
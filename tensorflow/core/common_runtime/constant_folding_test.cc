@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/null_file_system.h"
 #include "tensorflow/core/platform/test.h"
@@ -91,6 +92,27 @@ class ConstantFoldingTest : public ::testing::Test {
     auto m2 = ops::MatMul(s.WithOpName("m2"), b, c);
     auto s2 = ops::_Send(s.WithOpName("s2"), m2, "m2", "sender", 0, "receiver");
   }
+
+  // Folds a graph that sends `c` + `c`, for a constant `c` of `size` floats
+  // equal to `value`, and checks the folded constant.
+  void FoldAddGraph(float value, int64 size) {
+    Scope s = Scope::NewRootScope();
+    auto c = ops::Const(
+        s, test::AsTensor<float>(std::vector<float>(size, value), {size}));
+    auto add = ops::Add(s, c, c);
+    ops::_Send(s.WithOpName("send"), add, "add", "sender", 0, "receiver");
+    Graph g(OpRegistry::Global());
+    TF_ASSERT_OK(s.ToGraph(&g));
+
+    bool was_mutated;
+    TF_ASSERT_OK(ConstantFold(ConstantFoldingOptions{}, nullptr,
+                              Env::Default(), nullptr, &g, &was_mutated));
+    EXPECT_TRUE(was_mutated);
+    Node* send = g.BuildNodeNameIndex().at("send");
+    ASSERT_EQ(1, send->num_inputs());
+    ExpectNodeClose<float>(*(send->in_nodes().begin()),
+                           std::vector<float>(size, 2 * value), {size});
+  }
 };
 
 class FakeDevice : public Device {
@@ -111,6 +133,31 @@ class FakeDevice : public Device {
   }
 };
 
+// The constant folding cache reads its capacity once per process, so it is
+// enabled before any test folds a graph.
+const bool kConstantFoldingCacheEnabled TF_ATTRIBUTE_UNUSED = [] {
+  setenv("TF_CONSTANT_FOLDING_CACHE_BYTES", "1048576", 1 /* replace */);
+  return true;
+}();
+
+// Returns the number of constant folding cache lookups with `result` "hit" or
+// "miss" so far.
+int64 ConstantFoldingCacheLookups(const string& result) {
+  const std::unique_ptr<monitoring::CollectedMetrics> metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics({});
+  auto it = metrics->point_set_map.find(
+      "/tensorflow/core/constant_folding_cache_lookups");
+  if (it == metrics->point_set_map.end()) {
+    return 0;
+  }
+  for (const auto& point : it->second->points) {
+    if (point->labels.size() == 1 && point->labels[0].value == result) {
+      return point->int64_value;
+    }
+  }
+  return 0;
+}
+
 TEST_F(ConstantFoldingTest, Basic) {
   Scope s = Scope::NewRootScope();
   BuildSimpleGraph(&s);
@@ -186,6 +233,69 @@ TEST_F(ConstantFoldingTest, DeterministicFolding) {
   }
 }
 
+TEST_F(ConstantFoldingTest, LargeGraph) {
+  // Enough independent chains for the constant graph to be evaluated on a
+  // thread pool.
+  const int kNumChains = 400;
+  Scope s = Scope::NewRootScope();
+  for (int i = 0; i < kNumChains; ++i) {
+    auto c = ops::Const<int>(s, {i}, {1});
+    auto add = ops::Add(s, c, c);
+    auto mul = ops::Mul(s, add, add);
+    ops::_Send(s.WithOpName(strings::StrCat("send_", i)), mul,
+               strings::StrCat("m", i), "sender", 0, "receiver");
+  }
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(s.ToGraph(&g));
+
+  bool was_mutated;
+  TF_ASSERT_OK(ConstantFold(ConstantFoldingOptions{}, nullptr, Env::Default(),
+                            nullptr, &g, &was_mutated));
+  EXPECT_TRUE(was_mutated);
+
+  std::unordered_map<string, Node*> index = g.BuildNodeNameIndex();
+  for (int i = 0; i < kNumChains; ++i) {
+    Node* send = index.at(strings::StrCat("send_", i));
+    ASSERT_EQ(1, send->num_inputs());
+    ExpectNodeEqual<int>(*(send->in_nodes().begin()), {4 * i * i}, {1});
+  }
+}
+
+TEST_F(ConstantFoldingTest, Cache) {
+  // Evaluated once, then found in the cache.
+  int64 hits = ConstantFoldingCacheLookups("hit");
+  int64 misses = ConstantFoldingCacheLookups("miss");
+  FoldAddGraph(1.0, 4);
+  EXPECT_EQ(misses + 1, ConstantFoldingCacheLookups("miss"));
+  FoldAddGraph(1.0, 4);
+  EXPECT_EQ(hits + 1, ConstantFoldingCacheLookups("hit"));
+  EXPECT_EQ(misses + 1, ConstantFoldingCacheLookups("miss"));
+
+  // A different constant is evaluated again.
+  FoldAddGraph(3.0, 4);
+  EXPECT_EQ(misses + 2, ConstantFoldingCacheLookups("miss"));
+}
+
+TEST_F(ConstantFoldingTest, CacheIsBoundedByCapacity) {
+  // 600KB of outputs each, so that only one of them fits in the cache.
+  const int64 kSize = 150000;
+  int64 hits = ConstantFoldingCacheLookups("hit");
+  int64 misses = ConstantFoldingCacheLookups("miss");
+  FoldAddGraph(5.0, kSize);
+  FoldAddGraph(7.0, kSize);
+  // The first graph was evicted by the second one.
+  FoldAddGraph(5.0, kSize);
+  EXPECT_EQ(misses + 3, ConstantFoldingCacheLookups("miss"));
+  FoldAddGraph(5.0, kSize);
+  EXPECT_EQ(hits + 1, ConstantFoldingCacheLookups("hit"));
+
+  // Outputs larger than the cache are never kept.
+  misses = ConstantFoldingCacheLookups("miss");
+  FoldAddGraph(9.0, 2 * kSize);
+  FoldAddGraph(9.0, 2 * kSize);
+  EXPECT_EQ(misses + 2, ConstantFoldingCacheLookups("miss"));
+}
+
 TEST_F(ConstantFoldingTest, ConsiderFunction) {
   Scope s = Scope::NewRootScope();
   BuildSimpleGraph(&s);
@@ -0,0 +1,125 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/cost_profile_store.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+/*static*/ CostProfileStore* CostProfileStore::Global() {
+  static CostProfileStore* store = []() -> CostProfileStore* {
+    string directory;
+    TF_CHECK_OK(ReadStringFromEnvVar("TF_COST_PROFILE_DIR", "", &directory));
+    if (directory.empty()) return nullptr;
+    Status s = Env::Default()->RecursivelyCreateDir(directory);
+    if (!s.ok()) {
+      LOG(WARNING) << "Not persisting cost profiles; could not create "
+                   << directory << ": " << s;
+      return nullptr;
+    }
+    VLOG(1) << "Persisting cost profiles in " << directory;
+    return new CostProfileStore(directory);
+  }();
+  return store;
+}
+
+CostProfileStore::CostProfileStore(const string& directory, Env* env)
+    : directory_(directory), env_(env) {}
+
+/*static*/ uint64 CostProfileStore::Fingerprint(const Graph& graph) {
+  std::vector<string> keys;
+  keys.reserve(graph.num_op_nodes());
+  for (const Node* n : graph.op_nodes()) {
+    keys.push_back(strings::StrCat(n->name(), ";", n->type_string()));
+  }
+  std::sort(keys.begin(), keys.end());
+  uint64 fingerprint = Fingerprint64("cost_profile");
+  for (const string& key : keys) {
+    fingerprint = FingerprintCat64(fingerprint, Fingerprint64(key));
+  }
+  return fingerprint;
+}
+
+string CostProfileStore::Path(uint64 fingerprint) const {
+  return io::JoinPath(directory_,
+                      strings::Printf("%016llx.cost_graph",
+                                      static_cast<unsigned long long>(
+                                          fingerprint)));
+}
+
+std::shared_ptr<const CostGraphDef> CostProfileStore::Lookup(
+    uint64 fingerprint) {
+  mutex_lock l(mu_);
+  auto it = profiles_.find(fingerprint);
+  if (it != profiles_.end()) return it->second;
+
+  std::shared_ptr<const CostGraphDef> profile;
+  const string path = Path(fingerprint);
+  if (env_->FileExists(path).ok()) {
+    auto loaded = std::make_shared<CostGraphDef>();
+    Status s = ReadBinaryProto(env_, path, loaded.get());
+    if (s.ok()) {
+      VLOG(1) << "Loaded cost profile " << path << " with "
+              << loaded->node_size() << " nodes";
+      profile = std::move(loaded);
+    } else {
+      LOG(WARNING) << "Ignoring unreadable cost profile " << path << ": " << s;
+    }
+  }
+  profiles_[fingerprint] = profile;
+  return profile;
+}
+
+Status CostProfileStore::Save(uint64 fingerprint, const CostGraphDef& profile) {
+  // Write to a uniquely named temporary and rename it into place, so that
+  // readers in other processes never see a partial profile.
+  const string path = Path(fingerprint);
+  const string tmp_path =
+      strings::StrCat(path, ".tmp.", strings::Hex(random::New64()));
+  Status s = WriteBinaryProto(env_, tmp_path, profile);
+  if (s.ok()) s = env_->RenameFile(tmp_path, path);
+  if (!s.ok()) {
+    env_->DeleteFile(tmp_path).IgnoreError();
+    return s;
+  }
+  VLOG(1) << "Saved cost profile " << path << " with " << profile.node_size()
+          << " nodes";
+
+  mutex_lock l(mu_);
+  profiles_[fingerprint] = std::make_shared<const CostGraphDef>(profile);
+  return Status::OK();
+}
+
+std::unordered_map<string, const CostGraphDef::Node*> CostProfileNodesByName(
+    const CostGraphDef& profile) {
+  std::unordered_map<string, const CostGraphDef::Node*> nodes;
+  nodes.reserve(profile.node_size());
+  for (const CostGraphDef::Node& node : profile.node()) {
+    nodes[node.name()] = &node;
+  }
+  return nodes;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,81 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COST_PROFILE_STORE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_COST_PROFILE_STORE_H_
+
+#include <memory>
+#include <unordered_map>
+
+#include "tensorflow/core/framework/cost_graph.pb.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Measured per-node costs of a graph, as collected by the session's cost
+// model, persisted across processes.
+//
+// Profiles are CostGraphDefs keyed by Fingerprint() of the graph they were
+// measured on, so that a later process building the same graph can use the
+// measured costs before its first step, e.g. to order ready nodes by their
+// critical path or to size edges whose shapes are not static.
+//
+// The store is enabled by setting TF_COST_PROFILE_DIR to a directory, which
+// may be shared by several processes. Sessions then measure a profile once
+// their executors are warm (see DirectSession) unless
+// GraphOptions.build_cost_model already asks for cost models.
+class CostProfileStore {
+ public:
+  // Returns the store in TF_COST_PROFILE_DIR, or nullptr if it is not set.
+  static CostProfileStore* Global();
+
+  explicit CostProfileStore(const string& directory,
+                            Env* env = Env::Default());
+
+  // Returns a fingerprint of the op nodes of `graph`, by name and type.
+  // Device assignments are ignored, so that a profile still applies when
+  // only placement changed.
+  static uint64 Fingerprint(const Graph& graph);
+
+  // Returns the profile saved for `fingerprint`, or nullptr.
+  std::shared_ptr<const CostGraphDef> Lookup(uint64 fingerprint);
+
+  // Saves `profile` for `fingerprint`, replacing any earlier one.
+  Status Save(uint64 fingerprint, const CostGraphDef& profile);
+
+  const string& directory() const { return directory_; }
+
+ private:
+  string Path(uint64 fingerprint) const;
+
+  const string directory_;
+  Env* const env_;
+
+  mutex mu_;
+  // Profiles read or saved so far, including misses as nullptr.
+  std::unordered_map<uint64, std::shared_ptr<const CostGraphDef>> profiles_
+      GUARDED_BY(mu_);
+};
+
+// Indexes the nodes of `profile` by name.
+std::unordered_map<string, const CostGraphDef::Node*> CostProfileNodesByName(
+    const CostGraphDef& profile);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_COST_PROFILE_STORE_H_
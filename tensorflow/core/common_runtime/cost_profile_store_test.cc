@@ -0,0 +1,73 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/cost_profile_store.h"
+
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+string StoreDir(const string& name) {
+  return io::JoinPath(testing::TmpDir(), "cost_profile_store_test", name);
+}
+
+TEST(CostProfileStoreTest, FingerprintIgnoresDevices) {
+  Graph a(OpRegistry::Global());
+  Node* x = test::graph::Constant(&a, Tensor(1.0f), "x");
+  test::graph::Identity(&a, x);
+  const uint64 fingerprint = CostProfileStore::Fingerprint(a);
+
+  x->set_assigned_device_name("/job:localhost/replica:0/task:0/device:CPU:0");
+  EXPECT_EQ(CostProfileStore::Fingerprint(a), fingerprint);
+
+  test::graph::Identity(&a, x);
+  EXPECT_NE(CostProfileStore::Fingerprint(a), fingerprint);
+}
+
+TEST(CostProfileStoreTest, RoundTrip) {
+  const string dir = StoreDir("round_trip");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(dir));
+  CostProfileStore store(dir);
+  EXPECT_EQ(store.Lookup(1), nullptr);
+
+  CostGraphDef profile;
+  CostGraphDef::Node* node = profile.add_node();
+  node->set_name("matmul");
+  node->set_compute_cost(42);
+  node->add_output_info()->set_size(4096);
+  TF_ASSERT_OK(store.Save(1, profile));
+
+  // A second store over the same directory, as in a restarted process, reads
+  // the profile back. Only the profile is left in the directory.
+  CostProfileStore reopened(dir);
+  std::shared_ptr<const CostGraphDef> loaded = reopened.Lookup(1);
+  ASSERT_NE(loaded, nullptr);
+  auto nodes = CostProfileNodesByName(*loaded);
+  ASSERT_EQ(nodes.count("matmul"), 1);
+  EXPECT_EQ(nodes["matmul"]->compute_cost(), 42);
+  EXPECT_EQ(nodes["matmul"]->output_info(0).size(), 4096);
+  EXPECT_EQ(reopened.Lookup(2), nullptr);
+
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(dir, &children));
+  EXPECT_EQ(children.size(), 1);
+}
+
+}  // namespace
+}  // namespace tensorflow
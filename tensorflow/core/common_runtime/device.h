@@ -159,6 +159,18 @@ class Device : public DeviceBase {
     return Status::OK();
   }
 
+  // Fills in the per-node DeviceContexts for executing `graph` on this device,
+  // e.g. to spread nodes over several streams.  Nodes without an entry use
+  // the context from TryGetDeviceContext().  Leaves `device_context_map`
+  // empty by default.
+  //
+  // The caller takes ownership of one reference on each non-null
+  // DeviceContext* in `device_context_map`, and should call Unref().
+  virtual Status FillContextMap(const Graph* graph,
+                                DeviceContextMap* device_context_map) {
+    return Status::OK();
+  }
+
   // Returns the op segment of this device.  The caller can reuse op
   // kernels registered for the same session running on this device.
   OpSegment* op_segment() { return &op_seg_; }
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/collective_executor_mgr.h"
 #include "tensorflow/core/common_runtime/collective_param_resolver_local.h"
 #include "tensorflow/core/common_runtime/constant_folding.h"
+#include "tensorflow/core/common_runtime/cost_profile_store.h"
 #include "tensorflow/core/common_runtime/debugger_state_interface.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/device_resolver_local.h"
@@ -81,6 +82,9 @@ namespace tensorflow {
 
 namespace {
 
+// The executor step whose costs are persisted when TF_COST_PROFILE_DIR is set.
+constexpr int64 kCostProfileStep = 10;
+
 auto* direct_session_runs = monitoring::Counter<0>::New(
     "/tensorflow/core/direct_session_runs",
     "The number of times DirectSession::Run() has been called.");
@@ -93,15 +97,17 @@ Status NewThreadPoolFromThreadPoolOptions(
   if (num_threads == 0) {
     num_threads = NumInterOpThreadsFromSessionOptions(options);
   }
+  const ThreadPoolPolicyProto& policy =
+      options.config.experimental().inter_op_thread_pool_policy();
   const string& name = thread_pool_options.global_name();
   if (name.empty()) {
     // Session-local threadpool.
     VLOG(1) << "Direct session inter op parallelism threads for pool "
             << pool_number << ": " << num_threads;
     *pool = new thread::ThreadPool(
-        options.env, ThreadOptions(), strings::StrCat("Compute", pool_number),
-        num_threads, !options.config.experimental().disable_thread_spinning(),
-        /*allocator=*/nullptr);
+        options.env, ThreadOptionsFromPolicy(policy),
+        strings::StrCat("Compute", pool_number), num_threads,
+        ThreadSpinningFromPolicy(options, policy), /*allocator=*/nullptr);
     *owned = true;
     return Status::OK();
   }
@@ -116,9 +122,9 @@ Status NewThreadPoolFromThreadPoolOptions(
   if (mvalue->second == nullptr) {
     mvalue->first = thread_pool_options.num_threads();
     mvalue->second = new thread::ThreadPool(
-        options.env, ThreadOptions(), strings::StrCat("Compute", pool_number),
-        num_threads, !options.config.experimental().disable_thread_spinning(),
-        /*allocator=*/nullptr);
+        options.env, ThreadOptionsFromPolicy(policy),
+        strings::StrCat("Compute", pool_number), num_threads,
+        ThreadSpinningFromPolicy(options, policy), /*allocator=*/nullptr);
   } else {
     if (mvalue->first != thread_pool_options.num_threads()) {
       return errors::InvalidArgument(
@@ -592,7 +598,9 @@ Status DirectSession::RunInternal(
   if (ShouldUseRunHandlerPool(run_options) &&
       run_options.experimental().use_run_handler_pool()) {
     VLOG(1) << "Using RunHandler to scheduler inter-op closures.";
-    handler = GetOrCreateRunHandlerPool(options_)->Get(step_id, call_timeout);
+    handler = GetOrCreateRunHandlerPool(options_)->Get(
+        step_id, call_timeout,
+        run_options.experimental().run_handler_pool_options());
     if (!handler) {
       return errors::DeadlineExceeded(
           "Could not obtain RunHandler for request after waiting for ",
@@ -634,7 +642,9 @@ Status DirectSession::RunInternal(
   const bool do_trace = (run_options.trace_level() > RunOptions::NO_TRACE);
 
   bool update_cost_model = false;
-  if (options_.config.graph_options().build_cost_model() > 0) {
+  const bool report_cost_model =
+      options_.config.graph_options().build_cost_model() > 0;
+  if (report_cost_model) {
     const int64 build_cost_model_every =
         options_.config.graph_options().build_cost_model();
     const int64 build_cost_model_after =
@@ -644,6 +654,10 @@ Status DirectSession::RunInternal(
       update_cost_model =
           ((measure_step_count + 1) % build_cost_model_every == 0);
     }
+  } else if (CostProfileStore::Global() != nullptr) {
+    // Measure a single step for the persisted cost profile, once the
+    // executors are warm so that one-time setup does not skew the costs.
+    update_cost_model = (executor_step_count == kCostProfileStep);
   }
   if (do_trace || update_cost_model ||
       run_options.report_tensor_allocations_upon_oom()) {
@@ -680,6 +694,12 @@ Status DirectSession::RunInternal(
         // specific thread pool(s).
         if (!device_thread_pool) {
           args->runner = default_runner;
+          if (handler != nullptr) {
+            RunHandler* handler_ptr = handler.get();
+            args->should_yield = [handler_ptr]() {
+              return handler_ptr->ShouldYield();
+            };
+          }
         } else {
           args->runner = [device_thread_pool](Executor::Args::Closure c) {
             device_thread_pool->Schedule(std::move(c));
@@ -765,10 +785,35 @@ Status DirectSession::RunInternal(
     run_state.collector->BuildCostModel(&cost_model_manager_, device_to_graph);
 
     // annotate stats onto cost graph.
-    CostGraphDef* cost_graph = run_metadata->mutable_cost_graph();
-    for (const auto& item : executors_and_keys->items) {
-      TF_RETURN_IF_ERROR(
-          cost_model_manager_.AddToCostGraphDef(item.graph.get(), cost_graph));
+    if (report_cost_model) {
+      CostGraphDef* cost_graph = run_metadata->mutable_cost_graph();
+      for (const auto& item : executors_and_keys->items) {
+        TF_RETURN_IF_ERROR(cost_model_manager_.AddToCostGraphDef(
+            item.graph.get(), cost_graph));
+      }
+    }
+
+    // Persist the costs per partition, for the executors, and for the whole
+    // graph, for placement. Failing to save only loses the optimization.
+    CostProfileStore* profile_store = CostProfileStore::Global();
+    if (profile_store != nullptr) {
+      CostGraphDef merged;
+      for (const auto& item : executors_and_keys->items) {
+        CostGraphDef profile;
+        TF_RETURN_IF_ERROR(
+            cost_model_manager_.AddToCostGraphDef(item.graph.get(), &profile));
+        Status s = profile_store->Save(
+            CostProfileStore::Fingerprint(*item.graph), profile);
+        if (!s.ok()) LOG(WARNING) << "Could not save cost profile: " << s;
+        // Merged separately so that node ids stay unique across partitions.
+        TF_RETURN_IF_ERROR(
+            cost_model_manager_.AddToCostGraphDef(item.graph.get(), &merged));
+      }
+      if (executors_and_keys->cost_profile_fingerprint != 0) {
+        Status s = profile_store->Save(
+            executors_and_keys->cost_profile_fingerprint, merged);
+        if (!s.ok()) LOG(WARNING) << "Could not save cost profile: " << s;
+      }
     }
   }
 
@@ -1290,7 +1335,8 @@ Status DirectSession::CreateExecutors(
   std::unordered_map<string, std::unique_ptr<Graph>> graphs;
   TF_RETURN_IF_ERROR(CreateGraphs(
       options, &graphs, &func_info->flib_def, run_state_args, &ek->input_types,
-      &ek->output_types, &ek->collective_graph_key));
+      &ek->output_types, &ek->collective_graph_key,
+      &ek->cost_profile_fingerprint));
 
   if (run_state_args->is_partial_run) {
     ek->graph = std::move(run_state_args->graph);
@@ -1396,7 +1442,8 @@ Status DirectSession::CreateExecutors(
     TF_RETURN_IF_ERROR(
         NewExecutor(executor_type, params, *partition_graph, &item->executor));
     if (!options_.config.experimental().disable_output_partition_graphs() ||
-        options_.config.graph_options().build_cost_model() > 0) {
+        options_.config.graph_options().build_cost_model() > 0 ||
+        CostProfileStore::Global() != nullptr) {
       item->graph = std::move(partition_graph);
     }
   }
@@ -1560,7 +1607,8 @@ Status DirectSession::CreateGraphs(
     std::unordered_map<string, std::unique_ptr<Graph>>* outputs,
     std::unique_ptr<FunctionLibraryDefinition>* flib_def,
     RunStateArgs* run_state_args, DataTypeVector* input_types,
-    DataTypeVector* output_types, int64* collective_graph_key) {
+    DataTypeVector* output_types, int64* collective_graph_key,
+    uint64* cost_profile_fingerprint) {
   mutex_lock l(graph_state_lock_);
   if (finalized_) {
     return errors::FailedPrecondition("Session has been finalized.");
@@ -1627,6 +1675,11 @@ Status DirectSession::CreateGraphs(
 
   stateful_placements_ = execution_state->GetStatefulPlacements();
 
+  if (CostProfileStore::Global() != nullptr) {
+    *cost_profile_fingerprint =
+        CostProfileStore::Fingerprint(*execution_state->full_graph());
+  }
+
   // Remember the graph in run state if this is a partial run.
   if (run_state_args->is_partial_run) {
     run_state_args->graph.reset(new Graph(flib_def_.get()));
@@ -176,6 +176,10 @@ class DirectSession : public Session {
     CallableOptions callable_options;
 
     int64 collective_graph_key = BuildGraphOptions::kNoCollectiveGraphKey;
+
+    // CostProfileStore fingerprint of the placed graph before partitioning,
+    // or 0 if cost profiles are not persisted.
+    uint64 cost_profile_fingerprint = 0;
   };
 
   // A FunctionInfo object is created for every unique set of feeds/fetches.
@@ -261,7 +265,8 @@ class DirectSession : public Session {
       std::unordered_map<string, std::unique_ptr<Graph>>* outputs,
       std::unique_ptr<FunctionLibraryDefinition>* flib_def,
       RunStateArgs* run_state_args, DataTypeVector* input_types,
-      DataTypeVector* output_types, int64* collective_graph_key);
+      DataTypeVector* output_types, int64* collective_graph_key,
+      uint64* cost_profile_fingerprint);
 
   ::tensorflow::Status RunInternal(
       int64 step_id, const RunOptions& run_options,
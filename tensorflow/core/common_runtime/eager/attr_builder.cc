@@ -203,9 +203,41 @@ void AttrBuilder::FillAttrValueMapWithoutDefaults(AttrValueMap* m) const {
   }
 }
 
+namespace {
+inline tensorflow::Fprint128 FingerprintCat128(const tensorflow::Fprint128& a,
+                                               const tensorflow::Fprint128& b) {
+  return {tensorflow::FingerprintCat64(a.low64, b.low64),
+          tensorflow::FingerprintCat64(a.high64, b.high64)};
+}
+
+void CombineUnordered(const tensorflow::Fprint128& a,
+                      tensorflow::Fprint128* b) {
+  b->low64 += a.low64;
+  b->high64 += a.high64;
+}
+
+inline tensorflow::Fprint128 CacheKeyHelper(StringPiece s,
+                                            const tensorflow::Fprint128& b) {
+  tensorflow::Fprint128 a = tensorflow::Fingerprint128(s);
+  return FingerprintCat128(a, b);
+}
+
+inline tensorflow::Fprint128 CacheKeyHelper(StringPiece s, uint64 b) {
+  return CacheKeyHelper(s, {b, b});
+}
+
+}  // namespace
+
 void AttrBuilder::AddAttrIfNotPresent(StringPiece attr_name,
                                       const AttrValue& value) {
-  encoded_attrs_.emplace(string(attr_name), value.SerializeAsString());
+  auto result =
+      encoded_attrs_.emplace(string(attr_name), value.SerializeAsString());
+  if (result.second) {
+    CombineUnordered(
+        CacheKeyHelper(attr_name, tensorflow::Fingerprint128(
+                                      result.first->second)),
+        &attrs_fingerprint_);
+  }
 }
 
 const NodeDef& AttrBuilder::BuildNodeDef() {
@@ -237,49 +269,26 @@ Status AttrTypeByName(const AttrTypeMap& m, const string& attr_name,
   return Status::OK();
 }
 
-namespace {
-inline tensorflow::Fprint128 FingerprintCat128(const tensorflow::Fprint128& a,
-                                               const tensorflow::Fprint128& b) {
-  return {tensorflow::FingerprintCat64(a.low64, b.low64),
-          tensorflow::FingerprintCat64(a.high64, b.high64)};
-}
-
-void CombineUnordered(const tensorflow::Fprint128& a,
-                      tensorflow::Fprint128* b) {
-  b->low64 += a.low64;
-  b->high64 += a.high64;
-}
-
-inline tensorflow::Fprint128 CacheKeyHelper(StringPiece s,
-                                            const tensorflow::Fprint128& b) {
-  tensorflow::Fprint128 a = tensorflow::Fingerprint128(s);
-  return FingerprintCat128(a, b);
-}
-
-inline tensorflow::Fprint128 CacheKeyHelper(StringPiece s, uint64 b) {
-  return CacheKeyHelper(s, {b, b});
-}
-
-}  // namespace
 
 tensorflow::Fprint128 AttrBuilder::CacheKey(const StringPiece device) {
   if (!cached_cache_key_ || device != device_for_cached_cache_key_) {
-    cached_cache_key_ = BuildCacheKeyForDevice(device);
-    device_for_cached_cache_key_ = string(device);
+    if (!op_and_device_fingerprint_ ||
+        device != device_for_cached_cache_key_) {
+      op_and_device_fingerprint_ = BuildOpAndDeviceFingerprint(device);
+      device_for_cached_cache_key_ = string(device);
+    }
+    tensorflow::Fprint128 f = *op_and_device_fingerprint_;
+    CombineUnordered(attrs_fingerprint_, &f);
+    cached_cache_key_ = f;
   }
 
   return *cached_cache_key_;
 }
 
-tensorflow::Fprint128 AttrBuilder::BuildCacheKeyForDevice(
+tensorflow::Fprint128 AttrBuilder::BuildOpAndDeviceFingerprint(
     const StringPiece device) const {
   tensorflow::Fprint128 f = tensorflow::Fingerprint128(op_name());
-  f = tensorflow::FingerprintCat128(f, tensorflow::Fingerprint128(device));
-  for (const auto& p : encoded_attrs_) {
-    CombineUnordered(
-        CacheKeyHelper(p.first, tensorflow::Fingerprint128(p.second)), &f);
-  }
-  return f;
+  return tensorflow::FingerprintCat128(f, tensorflow::Fingerprint128(device));
 }
 
 void AttrBuilder::InitializeNodeDef() {
@@ -88,13 +88,19 @@ class AttrBuilder {
   explicit AttrBuilder(const char* op) { Reset(op); }
 
   void Reset(const char* op) {
-    op_name_ = op;
+    // An operation reset to the same op can keep its op and device
+    // fingerprint.
+    if (op_name_ != op) {
+      op_name_ = op;
+      op_and_device_fingerprint_ = absl::nullopt;
+      device_for_cached_cache_key_.clear();
+    }
     num_inputs_ = 0;
     encoded_attrs_.clear();
+    attrs_fingerprint_ = {0, 0};
     node_def_initialized_ = false;
     node_def_finalized_ = false;
     cached_cache_key_ = absl::nullopt;
-    device_for_cached_cache_key_.clear();
   }
 
   const string& op_name() const { return op_name_; }
@@ -142,7 +148,8 @@ class AttrBuilder {
   const NodeDef& BuildNodeDef();
 
  private:
-  tensorflow::Fprint128 BuildCacheKeyForDevice(const StringPiece device) const;
+  tensorflow::Fprint128 BuildOpAndDeviceFingerprint(
+      const StringPiece device) const;
 
   // Initialize the node_def_ object.
   // REQUIRES: node_def_initialized_ = false
@@ -171,8 +178,12 @@ class AttrBuilder {
   bool node_def_initialized_;
   bool node_def_finalized_;
 
+  // The cache key combines the fingerprint of the op name and device with
+  // the fingerprints of the attrs, which are added up as attrs are set.
   absl::optional<tensorflow::Fprint128> cached_cache_key_;
+  absl::optional<tensorflow::Fprint128> op_and_device_fingerprint_;
   string device_for_cached_cache_key_;
+  tensorflow::Fprint128 attrs_fingerprint_ = {0, 0};
 };
 
 template <>
@@ -83,6 +83,28 @@ TEST(AttrTypeMap, CacheKey) {
   ASSERT_FALSE(cache_key == a.CacheKey("cpu:0"));
 }
 
+TEST(AttrTypeMap, CacheKeyAfterReset) {
+  AttrBuilder a("op_name");
+  a.Set("T", TF_FLOAT);
+  a.Set("x", 1.0);
+  tensorflow::Fprint128 cache_key = a.CacheKey("cpu:0");
+
+  // The key does not depend on the order the attrs are set in, or on the
+  // attrs set before a Reset.
+  a.Reset("op_name");
+  a.Set("y", 2);
+  a.CacheKey("cpu:0");
+  a.Reset("op_name");
+  a.Set("x", 1.0);
+  a.Set("T", TF_FLOAT);
+  ASSERT_TRUE(cache_key == a.CacheKey("cpu:0"));
+
+  a.Reset("other_op_name");
+  a.Set("T", TF_FLOAT);
+  a.Set("x", 1.0);
+  ASSERT_FALSE(cache_key == a.CacheKey("cpu:0"));
+}
+
 string ToString(const AttrValueMap& m) {
   std::vector<string> strs;
   for (const auto& e : m) {
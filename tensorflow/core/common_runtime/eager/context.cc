@@ -47,6 +47,7 @@ limitations under the License.
 #endif  // !IS_MOBILE_PLATFORM
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/platform/monitoring.h"
 #include "tensorflow/core/util/env_var.h"
@@ -62,10 +63,30 @@ bool ReadBoolFromEnvVar(StringPiece env_var_name, bool default_val) {
   return default_val;
 }
 
+int64 ReadInt64FromEnvVar(StringPiece env_var_name, int64 default_val) {
+  int64 val;
+  if (tensorflow::ReadInt64FromEnvVar(env_var_name, default_val, &val).ok()) {
+    return val;
+  }
+  return default_val;
+}
+
 auto* eager_context_created =
     monitoring::Gauge<bool, 0>::New("/tensorflow/core/eager_context_created",
                                     "True if an eager context was created.");
 
+auto* kernel_cache_hits = monitoring::Counter<0>::New(
+    "/tensorflow/core/eager_kernel_cache_hits",
+    "The number of eager kernels found in the kernel cache.");
+
+auto* kernel_cache_misses = monitoring::Counter<0>::New(
+    "/tensorflow/core/eager_kernel_cache_misses",
+    "The number of eager kernels not found in the kernel cache.");
+
+auto* kernel_cache_evictions = monitoring::Counter<0>::New(
+    "/tensorflow/core/eager_kernel_cache_evictions",
+    "The number of eager kernels evicted from a full kernel cache.");
+
 }  // namespace
 
 EagerContext::EagerContext(
@@ -102,6 +123,8 @@ EagerContext::EagerContext(
   // currently a no-op.
   eager_context_created->GetCell()->Set(true);
   monitoring::StartExporter();
+  kernel_cache_capacity_ = std::max<int64>(
+      ReadInt64FromEnvVar("TF_EAGER_KERNEL_CACHE_CAPACITY", 0), 0);
   InitPrioritizedDeviceTypeList();
   runner_ = [this](std::function<void()> closure) {
     this->thread_pool_->Schedule(std::move(closure));
@@ -193,6 +216,7 @@ void EagerContext::ClearCachesAndDefaultExecutor() {
   mutex_lock ml(cache_mu_);
   default_executor_.WaitForAllPendingNodes().IgnoreError();
   kernel_cache_.clear();
+  kernel_cache_lru_.clear();
   for (auto& entry : registered_functions_) {
     entry.second->cached_kernel_keys->clear();
   }
@@ -546,8 +570,11 @@ Status EagerContext::RemoveFunction(const string& func) {
     }
     is_last_ref = registered_function->RefCountIsOne();
     if (is_last_ref) {
-      for (auto& key : *registered_function->cached_kernel_keys) {
-        kernel_cache_.erase(key);
+      // EraseCachedKernel updates cached_kernel_keys.
+      std::vector<Fprint128> keys;
+      keys.swap(*registered_function->cached_kernel_keys);
+      for (auto& key : keys) {
+        EraseCachedKernel(key);
       }
       registered_functions_.erase(func);
     }
@@ -562,14 +589,31 @@ Status EagerContext::RemoveFunction(const string& func) {
 
 core::RefCountPtr<KernelAndDevice> EagerContext::GetCachedKernel(
     Fprint128 cache_key) {
-  tf_shared_lock l(cache_mu_);
-  auto iter = kernel_cache_.find(cache_key);
-  if (iter == kernel_cache_.end()) {
-    return nullptr;
+  KernelAndDevice* kernel = nullptr;
+  if (kernel_cache_capacity_ == 0) {
+    tf_shared_lock l(cache_mu_);
+    auto iter = kernel_cache_.find(cache_key);
+    if (iter != kernel_cache_.end()) {
+      kernel = iter->second.kernel.get();
+      kernel->Ref();
+    }
+  } else {
+    // Moving the entry to the front of the LRU list needs an exclusive lock.
+    mutex_lock l(cache_mu_);
+    auto iter = kernel_cache_.find(cache_key);
+    if (iter != kernel_cache_.end()) {
+      kernel_cache_lru_.splice(kernel_cache_lru_.begin(), kernel_cache_lru_,
+                               iter->second.lru_position);
+      kernel = iter->second.kernel.get();
+      kernel->Ref();
+    }
   }
-  core::RefCountPtr<KernelAndDevice> new_ref(iter->second.get());
-  new_ref->Ref();
-  return new_ref;
+  if (kernel == nullptr) {
+    kernel_cache_misses->GetCell()->IncrementBy(1);
+  } else {
+    kernel_cache_hits->GetCell()->IncrementBy(1);
+  }
+  return core::RefCountPtr<KernelAndDevice>(kernel);
 }
 
 void EagerContext::AddKernelToCache(Fprint128 cache_key,
@@ -577,13 +621,62 @@ void EagerContext::AddKernelToCache(Fprint128 cache_key,
   mutex_lock ml(cache_mu_);
   core::RefCountPtr<KernelAndDevice> new_ref(kernel);
   new_ref->Ref();
-  kernel_cache_[cache_key] = std::move(new_ref);
-  auto* registered_function =
-      gtl::FindPtrOrNull(registered_functions_, kernel->name());
-  // The kernel name can be either a primitive op or a function.
-  if (registered_function != nullptr) {
-    registered_function->cached_kernel_keys->emplace_back(cache_key);
+  auto iter = kernel_cache_.find(cache_key);
+  if (iter != kernel_cache_.end()) {
+    iter->second.kernel = std::move(new_ref);
+    if (kernel_cache_capacity_ > 0) {
+      kernel_cache_lru_.splice(kernel_cache_lru_.begin(), kernel_cache_lru_,
+                               iter->second.lru_position);
+    }
+  } else {
+    if (kernel_cache_capacity_ > 0) {
+      while (static_cast<int64>(kernel_cache_.size()) >=
+             kernel_cache_capacity_) {
+        EraseCachedKernel(kernel_cache_lru_.back());
+        kernel_cache_evictions->GetCell()->IncrementBy(1);
+      }
+      kernel_cache_lru_.push_front(cache_key);
+    }
+    KernelCacheEntry& entry = kernel_cache_[cache_key];
+    entry.kernel = std::move(new_ref);
+    entry.lru_position = kernel_cache_lru_.begin();
+    auto* registered_function =
+        gtl::FindPtrOrNull(registered_functions_, kernel->name());
+    // The kernel name can be either a primitive op or a function.
+    if (registered_function != nullptr) {
+      registered_function->cached_kernel_keys->emplace_back(cache_key);
+    }
+  }
+}
+
+int64 EagerContext::NumCachedKernelKeys(const string& func) {
+  tf_shared_lock l(cache_mu_);
+  auto* registered_function = gtl::FindPtrOrNull(registered_functions_, func);
+  if (registered_function == nullptr) {
+    return 0;
+  }
+  return registered_function->cached_kernel_keys->size();
+}
+
+void EagerContext::EraseCachedKernel(Fprint128 cache_key) {
+  auto iter = kernel_cache_.find(cache_key);
+  if (iter == kernel_cache_.end()) {
+    return;
+  }
+  if (kernel_cache_capacity_ > 0) {
+    kernel_cache_lru_.erase(iter->second.lru_position);
+    // Forget the key of an evicted function kernel so that the keys of a
+    // function do not accumulate while it stays registered.
+    auto* registered_function = gtl::FindPtrOrNull(
+        registered_functions_, iter->second.kernel->name());
+    if (registered_function != nullptr) {
+      std::vector<Fprint128>* keys =
+          registered_function->cached_kernel_keys.get();
+      keys->erase(std::remove(keys->begin(), keys->end(), cache_key),
+                  keys->end());
+    }
   }
+  kernel_cache_.erase(iter);
 }
 
 bool EagerContext::ShouldStoreGraphs() { return should_store_graphs_.load(); }
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstddef>
+#include <list>
 #include <map>
 #include <memory>
 #include <queue>
@@ -199,6 +200,10 @@ class EagerContext : public core::RefCounted {
 
   void AddKernelToCache(Fprint128 cache_key, KernelAndDevice* kernel);
 
+  // Returns the number of kernel cache keys kept for the registered function
+  // `func`, for testing.
+  int64 NumCachedKernelKeys(const string& func);
+
   bool LogDevicePlacement() const { return log_device_placement_; }
   bool AllowSoftPlacement() const { return allow_soft_placement_; }
   bool LogMemory() const { return log_memory_; }
@@ -476,9 +481,21 @@ class EagerContext : public core::RefCounted {
 
     std::unique_ptr<std::vector<Fprint128>> cached_kernel_keys;
   };
-  std::unordered_map<Fprint128, core::RefCountPtr<KernelAndDevice>,
-                     Fprint128Hasher>
+  struct KernelCacheEntry {
+    core::RefCountPtr<KernelAndDevice> kernel;
+    // Position in kernel_cache_lru_ if the cache is bounded.
+    std::list<Fprint128>::iterator lru_position;
+  };
+  std::unordered_map<Fprint128, KernelCacheEntry, Fprint128Hasher>
       kernel_cache_ GUARDED_BY(cache_mu_);
+  // Maximum number of kernels in kernel_cache_, from
+  // TF_EAGER_KERNEL_CACHE_CAPACITY. Zero means unbounded. When bounded, the
+  // least recently used kernel is evicted first.
+  int64 kernel_cache_capacity_ = 0;
+  // Keys of kernel_cache_, most recently used first.
+  std::list<Fprint128> kernel_cache_lru_ GUARDED_BY(cache_mu_);
+  void EraseCachedKernel(Fprint128 cache_key)
+      EXCLUSIVE_LOCKS_REQUIRED(cache_mu_);
   std::unordered_map<string, RegisteredFunction*> registered_functions_
       GUARDED_BY(cache_mu_);
 
@@ -0,0 +1,269 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/eager/context.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+// A kernel that is only cached, never run, and records its deletion.
+class TestKernel : public KernelAndDevice {
+ public:
+  TestKernel(const string& name, bool* deleted)
+      : KernelAndDevice(/*flr=*/nullptr, /*runner=*/nullptr,
+                        /*collective_executor=*/nullptr,
+                        /*host_cpu_device=*/nullptr),
+        name_(name),
+        deleted_(deleted) {
+    *deleted_ = false;
+  }
+  ~TestKernel() override { *deleted_ = true; }
+
+  Status Init(const NodeDef& ndef, GraphCollector* graph_collector) override {
+    return Status::OK();
+  }
+  Status Run(const EagerKernelArgs& inputs, std::vector<Tensor>* outputs,
+             CancellationManager* cancellation_manager,
+             const absl::optional<EagerRemoteFunctionParams>&
+                 remote_func_params) override {
+    return errors::Unimplemented("TestKernel cannot run.");
+  }
+  Status Run(ScopedStepContainer* step_container, const EagerKernelArgs& inputs,
+             std::vector<Tensor>* outputs,
+             CancellationManager* cancellation_manager,
+             const absl::optional<EagerRemoteFunctionParams>&
+                 remote_func_params) override {
+    return errors::Unimplemented("TestKernel cannot run.");
+  }
+
+  Device* InputDevice(int i) const override { return nullptr; }
+  Device* OutputDevice(int idx) const override { return nullptr; }
+  Device* OutputResourceDevice(int idx) const override { return nullptr; }
+  const OpKernel* kernel() const override { return nullptr; }
+  const DataTypeVector& output_dtypes() const override {
+    return output_dtypes_;
+  }
+  DataType input_type(int i) const override { return DT_INVALID; }
+  int num_inputs() const override { return 0; }
+  int num_outputs() const override { return 0; }
+  const string& name() const override { return name_; }
+
+ private:
+  const string name_;
+  const DataTypeVector output_dtypes_;
+  bool* const deleted_;
+};
+
+Fprint128 Key(uint64 i) { return Fprint128{i, 0}; }
+
+int64 CounterValue(const string& name) {
+  const std::unique_ptr<monitoring::CollectedMetrics> metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics({});
+  auto it = metrics->point_set_map.find(name);
+  if (it == metrics->point_set_map.end() || it->second->points.empty()) {
+    return 0;
+  }
+  return it->second->points[0]->int64_value;
+}
+
+class EagerContextKernelCacheTest : public ::testing::Test {
+ protected:
+  ~EagerContextKernelCacheTest() override {
+    if (context_ != nullptr) {
+      context_->Unref();
+    }
+    unsetenv("TF_EAGER_KERNEL_CACHE_CAPACITY");
+  }
+
+  // Creates the context with a kernel cache of `capacity` kernels, or an
+  // unbounded one if `capacity` is 0.
+  void CreateContext(int capacity) {
+    setenv("TF_EAGER_KERNEL_CACHE_CAPACITY", std::to_string(capacity).c_str(),
+           1 /* replace */);
+    std::vector<std::unique_ptr<Device>> devices;
+    devices.push_back(
+        DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+    context_ = new EagerContext(
+        SessionOptions(), ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT,
+        ContextMirroringPolicy::MIRRORING_NONE, /*async=*/false,
+        /*lazy_copy_function_remote_inputs=*/false,
+        new StaticDeviceMgr(std::move(devices)), /*device_mgr_owned=*/true,
+        /*rendezvous=*/nullptr, /*custom_kernel_creator=*/nullptr);
+  }
+
+  // Caches a new kernel named `name` under `Key(i)`, and returns a flag that
+  // is set once the kernel is deleted.
+  const bool* AddKernel(uint64 i, const string& name) {
+    deleted_.push_back(false);
+    core::RefCountPtr<KernelAndDevice> kernel(
+        new TestKernel(name, &deleted_.back()));
+    context_->AddKernelToCache(Key(i), kernel.get());
+    return &deleted_.back();
+  }
+
+  bool IsCached(uint64 i) {
+    return context_->GetCachedKernel(Key(i)) != nullptr;
+  }
+
+  EagerContext* context_ = nullptr;
+  // Outlives context_, which deletes the kernels left in its cache.
+  std::deque<bool> deleted_;
+};
+
+TEST_F(EagerContextKernelCacheTest, EvictsLeastRecentlyUsedKernel) {
+  CreateContext(3);
+  const bool* deleted1 = AddKernel(1, "Identity");
+  const bool* deleted2 = AddKernel(2, "Identity");
+  const bool* deleted3 = AddKernel(3, "Identity");
+  // Looking kernel 1 up makes kernel 2 the least recently used one.
+  EXPECT_TRUE(IsCached(1));
+  const bool* deleted4 = AddKernel(4, "Identity");
+  EXPECT_TRUE(*deleted2);
+  EXPECT_FALSE(IsCached(2));
+
+  // Caching a kernel under a cached key replaces the kernel without evicting
+  // another one, and makes it the most recently used.
+  const bool* deleted1_again = AddKernel(1, "Identity");
+  EXPECT_TRUE(*deleted1);
+  EXPECT_FALSE(*deleted3);
+  const bool* deleted5 = AddKernel(5, "Identity");
+  EXPECT_TRUE(*deleted3);
+  EXPECT_FALSE(IsCached(3));
+
+  EXPECT_FALSE(*deleted1_again);
+  EXPECT_FALSE(*deleted4);
+  EXPECT_FALSE(*deleted5);
+  EXPECT_TRUE(IsCached(1));
+  EXPECT_TRUE(IsCached(4));
+  EXPECT_TRUE(IsCached(5));
+}
+
+TEST_F(EagerContextKernelCacheTest, EvictedKernelOutlivesItsUsers) {
+  CreateContext(1);
+  const bool* deleted = AddKernel(1, "Identity");
+  core::RefCountPtr<KernelAndDevice> in_flight =
+      context_->GetCachedKernel(Key(1));
+  AddKernel(2, "Identity");
+  EXPECT_FALSE(IsCached(1));
+  EXPECT_FALSE(*deleted);
+  EXPECT_EQ(in_flight->name(), "Identity");
+  in_flight.reset();
+  EXPECT_TRUE(*deleted);
+}
+
+TEST_F(EagerContextKernelCacheTest, CountsHitsMissesAndEvictions) {
+  const int64 hits = CounterValue("/tensorflow/core/eager_kernel_cache_hits");
+  const int64 misses =
+      CounterValue("/tensorflow/core/eager_kernel_cache_misses");
+  const int64 evictions =
+      CounterValue("/tensorflow/core/eager_kernel_cache_evictions");
+
+  CreateContext(2);
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_FALSE(IsCached(i));
+    AddKernel(i, "Identity");
+  }
+  EXPECT_TRUE(IsCached(3));
+  EXPECT_TRUE(IsCached(4));
+  EXPECT_FALSE(IsCached(1));
+
+  EXPECT_EQ(CounterValue("/tensorflow/core/eager_kernel_cache_hits") - hits,
+            2);
+  EXPECT_EQ(
+      CounterValue("/tensorflow/core/eager_kernel_cache_misses") - misses, 5);
+  EXPECT_EQ(
+      CounterValue("/tensorflow/core/eager_kernel_cache_evictions") - evictions,
+      2);
+}
+
+TEST_F(EagerContextKernelCacheTest, ForgetsKeysOfEvictedFunctionKernels) {
+  CreateContext(2);
+  const FunctionDef fdef = test::function::XTimesTwo();
+  const string& func = fdef.signature().name();
+  TF_ASSERT_OK(context_->AddFunctionDef(fdef));
+
+  const bool* deleted1 = AddKernel(1, func);
+  AddKernel(2, func);
+  // Caching a kernel under a cached key does not repeat the key.
+  const bool* deleted2 = AddKernel(2, func);
+  EXPECT_EQ(context_->NumCachedKernelKeys(func), 2);
+
+  AddKernel(3, "Identity");
+  EXPECT_TRUE(*deleted1);
+  EXPECT_EQ(context_->NumCachedKernelKeys(func), 1);
+  AddKernel(4, "Identity");
+  EXPECT_TRUE(*deleted2);
+  EXPECT_EQ(context_->NumCachedKernelKeys(func), 0);
+
+  // Removing the function leaves the kernels of other ops cached.
+  TF_ASSERT_OK(context_->RemoveFunction(func));
+  EXPECT_TRUE(IsCached(3));
+  EXPECT_TRUE(IsCached(4));
+}
+
+TEST_F(EagerContextKernelCacheTest, RemoveFunctionErasesItsKernels) {
+  CreateContext(3);
+  const FunctionDef fdef = test::function::XTimesTwo();
+  const string& func = fdef.signature().name();
+  TF_ASSERT_OK(context_->AddFunctionDef(fdef));
+
+  const bool* deleted1 = AddKernel(1, func);
+  const bool* deleted2 = AddKernel(2, "Identity");
+  const bool* deleted3 = AddKernel(3, func);
+  TF_ASSERT_OK(context_->RemoveFunction(func));
+  EXPECT_TRUE(*deleted1);
+  EXPECT_TRUE(*deleted3);
+  EXPECT_FALSE(IsCached(1));
+  EXPECT_FALSE(IsCached(3));
+  EXPECT_TRUE(IsCached(2));
+
+  // The erased kernels left room in the cache.
+  AddKernel(1, "Identity");
+  AddKernel(3, "Identity");
+  EXPECT_FALSE(*deleted2);
+  EXPECT_TRUE(IsCached(1));
+  EXPECT_TRUE(IsCached(2));
+  EXPECT_TRUE(IsCached(3));
+}
+
+TEST_F(EagerContextKernelCacheTest, UnboundedByDefault) {
+  CreateContext(0);
+  constexpr int kNumKernels = 100;
+  std::vector<const bool*> deleted;
+  for (int i = 0; i < kNumKernels; ++i) {
+    deleted.push_back(AddKernel(i, "Identity"));
+  }
+  for (int i = 0; i < kNumKernels; ++i) {
+    EXPECT_FALSE(*deleted[i]) << i;
+    EXPECT_TRUE(IsCached(i)) << i;
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -634,7 +634,12 @@ Status TensorHandle::CopyToDevice(EagerContext* ctx, tensorflow::Device* dstd,
   // With that setup, Sync()ing across all 3 streams should be sufficient
   // but more than necessary (since it waits for operations that might have
   // nothing to do with this tensor to complete).
-  TF_RETURN_IF_ERROR(srcd->Sync());
+  // The VE device context already orders a copy after the kernels that write
+  // its source and leaves the rest of the pending batch running, so a full
+  // sync there would only stall the eager thread.
+  if (srcd->device_type() != DEVICE_VE) {
+    TF_RETURN_IF_ERROR(srcd->Sync());
+  }
   tensorflow::Notification n;
   tensorflow::Status status;
   tensorflow::CopyTensor::ViaDMA("copy", src_device_context, dst_device_context,
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <memory>
@@ -24,11 +25,13 @@ limitations under the License.
 
 #include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
+#include "tensorflow/core/common_runtime/cost_profile_store.h"
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -43,6 +46,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_node_util.h"
@@ -69,6 +73,7 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
 namespace tensorflow {
@@ -85,9 +90,14 @@ bool IsInitializationOp(const Node* node) {
 namespace nodestats {
 inline int64 NowInNsec() { return EnvTime::NowNanos(); }
 
-void SetScheduled(NodeExecStatsInterface* stats, int64 micros) {
+void SetReady(NodeExecStatsInterface* stats, int64 nanos) {
+  if (!stats || nanos == 0) return;
+  stats->SetReady(nanos);
+}
+
+void SetScheduled(NodeExecStatsInterface* stats, int64 nanos) {
   if (!stats) return;
-  stats->SetScheduled(micros * EnvTime::kMicrosToNanos);
+  stats->SetScheduled(nanos);
 }
 
 void SetAllStart(NodeExecStatsInterface* stats) {
@@ -176,6 +186,11 @@ struct NodeItem {
   bool is_next_iteration : 1;     // True iff IsNextIteration(node)
   bool is_noop : 1;  // True iff item->kernel->type_string_view() == "NoOp")
 
+  // Static scheduling priority: the estimated cost of the longest path from
+  // this node to the end of the graph. Only set when the ready queue is
+  // ordered by critical path.
+  int64 priority = 0;
+
   // The kernel for this node.
   OpKernel* kernel = nullptr;
 
@@ -333,6 +348,9 @@ class ExecutorImpl : public Executor {
     for (auto fiter : frame_info_) {
       delete fiter.second;
     }
+    for (DeviceContext* dc : device_context_map_) {
+      if (dc != nullptr) dc->Unref();
+    }
   }
 
   Status Initialize(const Graph& graph);
@@ -386,6 +404,9 @@ class ExecutorImpl : public Executor {
                                      ControlFlowInfo* cf_info);
   void InitializePending(const Graph* graph, const ControlFlowInfo& cf_info);
 
+  // Sets NodeItem::priority to the upward rank of every node.
+  void ComputeCriticalPathPriorities(const Graph& graph);
+
   FrameInfo* EnsureFrameInfo(const string& fname) {
     auto slot = &frame_info_[fname];
     if (*slot == nullptr) {
@@ -401,6 +422,18 @@ class ExecutorImpl : public Executor {
   // A cached value of params_
   bool device_record_tensor_accesses_ = false;
 
+  // The DeviceContext of each node, if the device picks them per node.
+  DeviceContextMap device_context_map_;
+
+  // True if ready nodes are run in order of NodeItem::priority instead of
+  // FIFO. Set by TF_EXECUTOR_CRITICAL_PATH_PRIORITY.
+  bool use_priority_ = false;
+
+  // Offsets of the outputs with statically known shapes in a per-step arena.
+  // Set by TF_EXECUTOR_STATIC_MEMORY_PLAN. Shared with the arenas, which may
+  // outlive the executor.
+  std::shared_ptr<const StaticMemoryPlan> memory_plan_;
+
   // Root nodes (with no in edges) that should form the initial ready queue
   std::vector<const NodeItem*> root_nodes_;
 
@@ -635,6 +668,8 @@ Status ExecutorImpl::Initialize(const Graph& graph) {
   // that O(# steps * # nodes per step) times.
   device_record_tensor_accesses_ =
       params_.device->RequiresRecordingAccessedTensors();
+  TF_RETURN_IF_ERROR(
+      params_.device->FillContextMap(&graph, &device_context_map_));
 
   for (auto& it : cf_info.unique_frame_names) {
     EnsureFrameInfo(it)->nodes = new std::vector<const NodeItem*>;
@@ -725,7 +760,65 @@ Status ExecutorImpl::Initialize(const Graph& graph) {
   // all nodes.
   InitializePending(&graph, cf_info);
 
-  return gview_.SetAllocAttrs(&graph, params_.device);
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_EXECUTOR_CRITICAL_PATH_PRIORITY",
+                                        false, &use_priority_));
+  if (use_priority_) {
+    ComputeCriticalPathPriorities(graph);
+  }
+
+  TF_RETURN_IF_ERROR(gview_.SetAllocAttrs(&graph, params_.device));
+
+  bool use_memory_plan;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_EXECUTOR_STATIC_MEMORY_PLAN",
+                                        false, &use_memory_plan));
+  if (use_memory_plan) {
+    // Only outputs allocated with default attributes, i.e. in device memory,
+    // come from the arena.
+    memory_plan_ = StaticMemoryPlan::Create(
+        graph, [this](const Node* n, int index) {
+          return gview_.node(n->id())->output_attrs()[index].value == 0;
+        });
+  }
+  return Status::OK();
+}
+
+void ExecutorImpl::ComputeCriticalPathPriorities(const Graph& graph) {
+  // Costs measured on this graph by an earlier session come from the
+  // CostProfileStore, in microseconds. Without a profile, expensive kernels
+  // are weighted against inexpensive ones instead.
+  const int64 kExpensiveCost = 10;
+  const int64 kInexpensiveCost = 1;
+  std::shared_ptr<const CostGraphDef> profile;
+  std::unordered_map<string, const CostGraphDef::Node*> measured;
+  if (CostProfileStore* store = CostProfileStore::Global()) {
+    profile = store->Lookup(CostProfileStore::Fingerprint(graph));
+    if (profile) measured = CostProfileNodesByName(*profile);
+  }
+  auto cost = [&](const Node* n, const NodeItem* item) -> int64 {
+    if (profile) {
+      auto it = measured.find(n->name());
+      return it == measured.end() ? kInexpensiveCost
+                                  : std::max<int64>(it->second->compute_cost(),
+                                                    kInexpensiveCost);
+    }
+    return item->kernel->IsExpensive() ? kExpensiveCost : kInexpensiveCost;
+  };
+
+  // In reverse post order every node comes before its consumers, except for
+  // the back edges out of NextIteration nodes, which are skipped.
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    const Node* n = *it;
+    NodeItem* item = gview_.node(n->id());
+    int64 rank = 0;
+    if (!n->IsNextIteration()) {
+      for (const Edge* e : n->out_edges()) {
+        rank = std::max(rank, gview_.node(e->dst()->id())->priority);
+      }
+    }
+    item->priority = rank + cost(n, item);
+  }
 }
 
 // If a Node has been marked to use a ScopedAllocator x for output i, then
@@ -994,6 +1087,16 @@ class ExecutorState {
           counts(*pending_counts) {  // Initialize with copy of *pending_counts
     }
 
+    // Prepares a finished iteration state for reuse by a new iteration.
+    void Reset(const PendingCounts* pending_counts, int total_input_tensors) {
+      for (int i = 0; i < total_input_tensors; ++i) {
+        input_tensors[i] = Entry();
+      }
+      outstanding_ops = 0;
+      outstanding_frame_count = 0;
+      counts.CopyFrom(*pending_counts);
+    }
+
     // The state of an iteration.
 
     // One copy per iteration. For iteration k, i-th node's j-th input is in
@@ -1135,6 +1238,10 @@ class ExecutorState {
     // will only "execute" the dead exits of the final iteration.
     std::vector<const NodeItem*> dead_exits GUARDED_BY(mu);
 
+    // Iteration states of finished iterations, reused by later iterations of
+    // this frame to avoid reallocating their inputs and pending counts.
+    std::vector<IterationState*> free_iterations GUARDED_BY(mu);
+
     // Static information specific to this frame.
     PendingCounts* pending_counts = nullptr;
     int total_input_tensors = 0;
@@ -1246,6 +1353,9 @@ class ExecutorState {
         delete iterations[i];
         iterations[i] = nullptr;
       }
+      for (IterationState* iter_state : free_iterations) {
+        delete iter_state;
+      }
     }
   };
 
@@ -1255,6 +1365,8 @@ class ExecutorState {
     FrameState* input_frame = nullptr;
     int64 input_iter = -1;
     bool is_dead = false;
+    // Time the node became ready, only set when collecting step stats.
+    int64 ready_nsec = 0;
 
     TaggedNode(const NodeItem* node_item, FrameState* in_frame, int64 in_iter,
                bool dead)
@@ -1270,8 +1382,21 @@ class ExecutorState {
   class TaggedNodeReadyQueue {
    public:
     TaggedNodeReadyQueue() : front_index_(0) {}
-
-    void push_back(TaggedNode node) { ready_.push_back(node); }
+    explicit TaggedNodeReadyQueue(bool by_priority)
+        : front_index_(0), by_priority_(by_priority) {}
+
+    // When ordered by priority, a node is queued ahead of the pending nodes
+    // with a lower NodeItem::priority. Nodes of equal priority stay FIFO.
+    void push_back(TaggedNode node) {
+      ready_.push_back(node);
+      if (!by_priority_) return;
+      for (int i = static_cast<int>(ready_.size()) - 1;
+           i > front_index_ &&
+           ready_[i - 1].node_item->priority < ready_[i].node_item->priority;
+           --i) {
+        std::swap(ready_[i - 1], ready_[i]);
+      }
+    }
     TaggedNode front() const {
       DCHECK_LT(front_index_, ready_.size());
       return ready_[front_index_];
@@ -1297,6 +1422,7 @@ class ExecutorState {
    private:
     gtl::InlinedVector<TaggedNode, 16> ready_;
     int front_index_;
+    bool by_priority_ = false;
   };
 
   struct AsyncState;
@@ -1324,12 +1450,18 @@ class ExecutorState {
   // QUESTION: Make it a checkpoint::TensorSliceReaderCacheWrapper
   // instead of a pointer?  (avoids having to delete).
   checkpoint::TensorSliceReaderCacheWrapper* slice_reader_cache_;
+  // Serves outputs from the executor's static memory plan, if any. Owns one
+  // reference.
+  StaticMemoryArena* memory_arena_ = nullptr;
+  // Supplied by the caller; takes precedence over `memory_arena_`.
+  StaticOutputProvider* const static_output_provider_;
   CallFrameInterface* call_frame_;
   const ExecutorImpl* impl_;
   CancellationManager* cancellation_manager_;
   // If not null, use this device to schedule intra-op operation
   std::unique_ptr<DeviceBase> user_device_;
   Executor::Args::Runner runner_;
+  std::function<bool()> should_yield_;
   bool sync_on_finish_;
 
   // Owned.
@@ -1458,10 +1590,12 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
           tracing::GetEventCollector(tracing::EventCategory::kCompute)),
       context_(ContextKind::kThread),
       slice_reader_cache_(new checkpoint::TensorSliceReaderCacheWrapper),
+      static_output_provider_(args.static_output_provider),
       call_frame_(args.call_frame),
       impl_(impl),
       cancellation_manager_(args.cancellation_manager),
       runner_(args.runner),
+      should_yield_(args.should_yield),
       sync_on_finish_(args.sync_on_finish),
       num_outstanding_ops_(0) {
   if (args.user_intra_op_threadpool != nullptr) {
@@ -1469,6 +1603,11 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  if (impl_->memory_plan_ != nullptr) {
+    memory_arena_ = new StaticMemoryArena(
+        impl_->memory_plan_,
+        impl_->params_.device->GetAllocator(AllocatorAttributes()));
+  }
 
   // We start the entire execution in iteration 0 of the root frame
   // so let us create the root frame and the state for iteration 0.
@@ -1493,6 +1632,9 @@ ExecutorState::~ExecutorState() {
     device_context_->Unref();
   }
   delete slice_reader_cache_;
+  if (memory_arena_) {
+    memory_arena_->Unref();
+  }
 }
 
 Status ExecutorImpl::BuildControlFlowInfo(const Graph* g,
@@ -1595,6 +1737,10 @@ void ExecutorState::RunAsync(Executor::DoneCallback done) {
     DCHECK_EQ(item->num_inputs, 0);
     ready.push_back(TaggedNode{item, root_frame_, 0, false});
   }
+  if (stats_collector_) {
+    const int64 ready_nsec = nodestats::NowInNsec();
+    for (TaggedNode& node : ready) node.ready_nsec = ready_nsec;
+  }
   if (ready.empty()) {
     delete this;
     done(Status::OK());
@@ -1652,6 +1798,37 @@ struct ExecutorState::AsyncState {
   }
 };
 
+// Scratch state of one ExecutorState::Process call. It is kept in a
+// per-thread free list, so that the parameters and input vectors keep their
+// heap storage across nodes and steps. Process may run nested on one thread,
+// e.g. when a kernel runs a function with an inline runner, so every active
+// call takes its own entry.
+struct ProcessScratch {
+  OpKernelContext::Params params;
+  TensorValueVec inputs;
+  AllocatorAttributeVec input_alloc_attrs;
+};
+
+std::vector<std::unique_ptr<ProcessScratch>>* ProcessScratchFreeList() {
+  thread_local std::vector<std::unique_ptr<ProcessScratch>> free_list;
+  return &free_list;
+}
+
+ProcessScratch* AcquireProcessScratch() {
+  std::vector<std::unique_ptr<ProcessScratch>>* free_list =
+      ProcessScratchFreeList();
+  if (free_list->empty()) {
+    return new ProcessScratch;
+  }
+  ProcessScratch* scratch = free_list->back().release();
+  free_list->pop_back();
+  return scratch;
+}
+
+void ReleaseProcessScratch(ProcessScratch* scratch) {
+  ProcessScratchFreeList()->emplace_back(scratch);
+}
+
 // Returns true if `item` might be traced by the given trace and event
 // collectors. Returns false only if `item` definitely will not be traced.
 bool MightTrace(const NodeItem& item,
@@ -1686,13 +1863,14 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
       2);
   WithContext wc(context_);
   TaggedNodeSeq ready;
-  TaggedNodeReadyQueue inline_ready;
-
-  // Parameters passed to OpKernel::Compute.
-  TensorValueVec inputs;
-  AllocatorAttributeVec input_alloc_attrs;
-
-  OpKernelContext::Params params;
+  TaggedNodeReadyQueue inline_ready(impl_->use_priority_);
+
+  // Parameters passed to OpKernel::Compute. They are reused across calls on
+  // the same thread.
+  ProcessScratch* scratch = AcquireProcessScratch();
+  TensorValueVec& inputs = scratch->inputs;
+  AllocatorAttributeVec& input_alloc_attrs = scratch->input_alloc_attrs;
+  OpKernelContext::Params& params = scratch->params;
   params.step_id = step_id_;
   // Override device's threadpool if user provides an intra_op_threadpool
   Device* device = impl_->params_.device;
@@ -1720,6 +1898,9 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
   params.input_alloc_attrs = &input_alloc_attrs;
   params.runner = &runner_;
   params.stats_collector = stats_collector_;
+  params.static_output_provider = static_output_provider_ != nullptr
+                                      ? static_output_provider_
+                                      : memory_arena_;
   params.inc_num_deferred_ops_function = [this]() {
     mutex_lock lock(num_deferred_ops_mu_);
     num_deferred_ops_++;
@@ -1747,8 +1928,20 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
 
   EntryVector outputs;
   bool completed = false;
+  bool first_node = true;
   inline_ready.push_back(tagged_node);
   while (!inline_ready.empty()) {
+    if (!first_node && should_yield_ && should_yield_()) {
+      // The nodes are already counted in num_outstanding_ops_, so they are
+      // simply run by other Process calls.
+      while (!inline_ready.empty()) {
+        TaggedNode n = inline_ready.front();
+        inline_ready.pop_front();
+        runner_([=]() { Process(n, scheduled_nsec); });
+      }
+      break;
+    }
+    first_node = false;
     tagged_node = inline_ready.front();
     inline_ready.pop_front();
     const NodeItem& item = *tagged_node.node_item;
@@ -1756,6 +1949,13 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
     const int64 input_iter = tagged_node.input_iter;
     const int id = item.node_id;
 
+    if (static_cast<size_t>(id) < impl_->device_context_map_.size() &&
+        impl_->device_context_map_[id] != nullptr) {
+      params.op_device_context = impl_->device_context_map_[id];
+    } else {
+      params.op_device_context = device_context_;
+    }
+
     // TODO(misard) Replace with a finer-grain enabling flag once we
     // add better optional debugging support.
     if (vlog_ && VLOG_IS_ON(1)) {
@@ -1770,6 +1970,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
       // Track allocations if and only if we are collecting statistics, and
       // `stats` object is expecting allocations to be tracked.
       params.track_allocations = stats ? stats->TrackAllocations() : false;
+      nodestats::SetReady(stats, tagged_node.ready_nsec);
       nodestats::SetScheduled(stats, scheduled_nsec);
       nodestats::SetAllStart(stats);
     }
@@ -1817,6 +2018,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
       params.is_input_dead = is_input_dead;
       params.output_attr_array = item.output_attrs();
       params.forward_from_array = item.forward_from();
+      params.static_output_node_id = id;
 
       if (item.kernel_is_async) {
         // Asynchronous computes.
@@ -1894,9 +2096,25 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
           tracing::ScopedRegion region(tracing::EventCategory::kCompute,
                                        op_name);
           absl::string_view kernel_label_view(kernel_label);
-          // 'TraceMe' will trace the OpKernel scheduling time.
+          // 'TraceMe' will trace the OpKernel scheduling time. When step
+          // stats are collected it also carries how long the node waited in
+          // the executor and for a thread.
           profiler::TraceMe activity(
-              kernel_label_view,
+              [&] {
+                if (tagged_node.ready_nsec == 0) {
+                  return string(kernel_label_view);
+                }
+                const int64 now_nsec = nodestats::NowInNsec();
+                return strings::StrCat(
+                    kernel_label_view, "#ready_wait_us=",
+                    std::max<int64>(scheduled_nsec - tagged_node.ready_nsec,
+                                    0) /
+                        EnvTime::kMicrosToNanos,
+                    ",dispatch_wait_us=",
+                    std::max<int64>(now_nsec - scheduled_nsec, 0) /
+                        EnvTime::kMicrosToNanos,
+                    "#");
+              },
               profiler::GetTFTraceMeLevel(op_kernel->IsExpensive()));
           // 'ScopedAnnotation' will trace the OpKernel execution time.
           profiler::ScopedAnnotation annotation(kernel_label_view);
@@ -1964,6 +2182,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
       completed = NodeDone(s, ready, stats, &inline_ready);
     }
   }  // while !inline_ready.empty()
+  ReleaseProcessScratch(scratch);
 
   // This thread of computation is done if completed = true.
   if (completed) ScheduleFinish();
@@ -1973,10 +2192,9 @@ Status ExecutorState::PrepareInputs(const NodeItem& item, Entry* first_input,
                                     TensorValueVec* inputs,
                                     AllocatorAttributeVec* input_alloc_attrs,
                                     bool* is_input_dead) {
-  inputs->clear();
-  inputs->resize(item.num_inputs);
-  input_alloc_attrs->clear();
-  input_alloc_attrs->resize(item.num_inputs);
+  // assign() keeps the heap storage of the vectors, unlike clear().
+  inputs->assign(item.num_inputs, TensorValue());
+  input_alloc_attrs->assign(item.num_inputs, AllocatorAttributes());
 
   *is_input_dead = false;
 
@@ -2261,6 +2479,11 @@ void ExecutorState::PropagateOutputs(const TaggedNode& tagged_node,
       CleanupFramesIterations(parent_frame, parent_iter, ready);
     }
   }
+
+  if (stats_collector_ && !ready->empty()) {
+    const int64 ready_nsec = nodestats::NowInNsec();
+    for (TaggedNode& node : *ready) node.ready_nsec = ready_nsec;
+  }
 }
 
 bool ExecutorState::NodeDone(const Status& s, const TaggedNodeSeq& ready,
@@ -2329,9 +2552,20 @@ bool ExecutorState::NodeDone(const Status& s, const TaggedNodeSeq& ready,
   return completed;
 }
 
-void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
+void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready_in,
                                   TaggedNodeReadyQueue* inline_ready) {
-  if (ready.empty()) return;
+  if (ready_in.empty()) return;
+
+  // Dispatch the nodes on the critical path first.
+  TaggedNodeSeq sorted;
+  if (impl_->use_priority_ && ready_in.size() > 1) {
+    sorted = ready_in;
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const TaggedNode& a, const TaggedNode& b) {
+                       return a.node_item->priority > b.node_item->priority;
+                     });
+  }
+  const TaggedNodeSeq& ready = sorted.empty() ? ready_in : sorted;
 
   int64 scheduled_nsec = 0;
   if (stats_collector_) {
@@ -2904,8 +3138,14 @@ void ExecutorState::FrameState::IncrementIteration(const GraphView* gview,
   const int64 next_iter = iteration_count;
 
   // Initialize the next iteration.
-  IterationState* iter_state =
-      new IterationState(pending_counts, total_input_tensors);
+  IterationState* iter_state;
+  if (!free_iterations.empty()) {
+    iter_state = free_iterations.back();
+    free_iterations.pop_back();
+    iter_state->Reset(pending_counts, total_input_tensors);
+  } else {
+    iter_state = new IterationState(pending_counts, total_input_tensors);
+  }
   SetIteration(next_iter, iter_state);
   num_outstanding_iterations++;
   dead_exits.clear();
@@ -2922,8 +3162,8 @@ bool ExecutorState::FrameState::CleanupIterations(const GraphView* gview,
                                                   TaggedNodeSeq* ready) {
   int64 curr_iter = iter;
   while (curr_iter <= iteration_count && IsIterationDone(curr_iter)) {
-    // Delete the iteration curr_iter.
-    delete GetIteration(curr_iter);
+    // Delete the iteration curr_iter. Its state is kept for reuse.
+    free_iterations.push_back(GetIteration(curr_iter));
     SetIteration(curr_iter, nullptr);
     --num_outstanding_iterations;
     ++curr_iter;
@@ -106,6 +106,16 @@ class Executor {
     typedef std::function<void()> Closure;
     typedef std::function<void(Closure)> Runner;
     Runner runner = nullptr;
+
+    // If set, called between the nodes that a thread runs inline. When it
+    // returns true, the remaining nodes are handed back to `runner`, e.g. so
+    // that the scheduler can run more urgent work first.
+    std::function<bool()> should_yield = nullptr;
+
+    // If set, consulted for the outputs of every node before they are
+    // allocated, instead of the static memory plan of the graph, if any.
+    // Not owned, and must outlive the run.
+    StaticOutputProvider* static_output_provider = nullptr;
   };
   typedef std::function<void(const Status&)> DoneCallback;
   virtual void RunAsync(const Args& args, DoneCallback done) = 0;
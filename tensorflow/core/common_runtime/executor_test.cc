@@ -250,6 +250,54 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeCriticalPathPriority) {
+  setenv("TF_EXECUTOR_CRITICAL_PATH_PRIORITY", "1", 1 /* replace */);
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  unsetenv("TF_EXECUTOR_CRITICAL_PATH_PRIORITY");
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+TEST_F(ExecutorTest, StaticMemoryPlan) {
+  setenv("TF_EXECUTOR_STATIC_MEMORY_PLAN", "1", 1 /* replace */);
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  // All shapes are known, so the outputs of the whole chain are planned and
+  // share a few slots of the arena.
+  auto one = test::graph::Constant(g.get(), V(1.0));
+  Node* x = one;
+  for (int i = 0; i < 64; ++i) {
+    x = test::graph::Add(g.get(), x, one);
+  }
+  test::graph::Send(g.get(), x, "b", BOB, kIncarnation, ALICE);
+  Create(std::move(g));
+  unsetenv("TF_EXECUTOR_STATIC_MEMORY_PLAN");
+  for (int iters = 0; iters < 4; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    // Without a stats collector, so that allocations are not tracked and
+    // outputs come from the arena.
+    Executor::Args exec_args;
+    exec_args.rendezvous = rendez;
+    exec_args.runner = runner_;
+    TF_ASSERT_OK(exec_->Run(exec_args));
+    Rendezvous::Args args;
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(65.0, V(out));
+    rendez->Unref();
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
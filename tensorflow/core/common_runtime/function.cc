@@ -16,6 +16,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/function.h"
 
 #include <deque>
+#include <list>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "absl/algorithm/container.h"
@@ -26,9 +29,11 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/graph_optimizer.h"
 #include "tensorflow/core/common_runtime/memory_types.h"
+#include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
@@ -42,9 +47,12 @@ limitations under the License.
 #include "tensorflow/core/graph/optimizer_cse.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 // See core/kernels/function_ops.cc for related kernels.
 
@@ -320,6 +328,30 @@ Status FunctionLibraryRuntimeOverlay::Clone(
   return base_flr_->Clone(out_lib_def, out_pflr, out_flr, skip_flib_def);
 }
 
+// Serves the outputs that a function returns from the caller's
+// RetvalBufferProvider. `sources[i]` is the node id and output index that
+// produce return value `i`.
+class RetvalOutputProvider : public StaticOutputProvider {
+ public:
+  RetvalOutputProvider(std::vector<std::pair<int, int>> sources,
+                       RetvalBufferProvider* provider)
+      : sources_(std::move(sources)), provider_(provider) {}
+
+  TensorBuffer* AllocateOutput(int node_id, int index, DataType type,
+                               const TensorShape& shape) override {
+    for (size_t i = 0; i < sources_.size(); ++i) {
+      if (sources_[i].first == node_id && sources_[i].second == index) {
+        return provider_->AllocateRetval(i, type, shape);
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+  const std::vector<std::pair<int, int>> sources_;
+  RetvalBufferProvider* const provider_;  // Not owned.
+};
+
 class FunctionLibraryRuntimeImpl : public FunctionLibraryRuntime {
  public:
   FunctionLibraryRuntimeImpl(const DeviceMgr* dmgr, Env* env,
@@ -410,6 +442,9 @@ class FunctionLibraryRuntimeImpl : public FunctionLibraryRuntime {
     FunctionLibraryRuntimeOverlay* overlay_flr = nullptr;
     string executor_type;
     Executor::RendezvousFactory rendezvous_factory = nullptr;
+    // The node id and output index that produce each return value, if the
+    // function runs on CPU; {-1, -1} for return values without a data input.
+    std::vector<std::pair<int, int>> retval_sources;
 
     ~Item() {
       delete this->func_graph;
@@ -446,6 +481,12 @@ class FunctionLibraryRuntimeImpl : public FunctionLibraryRuntime {
                                CallFrameInterface* frame,
                                Executor::Args* exec_args);
 
+  // Has the nodes of `item` that produce return values allocate their outputs
+  // from `run_opts.retval_buffer_provider`, if set, until `done` is called.
+  void MaybeProvideRetvalBuffers(const Options& run_opts, const Item* item,
+                                 Executor::Args* exec_args,
+                                 DoneCallback* done);
+
   TF_DISALLOW_COPY_AND_ASSIGN(FunctionLibraryRuntimeImpl);
 };
 
@@ -921,6 +962,103 @@ void PruneFunctionBody(const FunctionDef& fdef, Graph* g) {
     FixupSourceAndSinkEdges(g);
   }
 }
+
+// A process-wide cache of optimized function bodies, keyed by a fingerprint
+// of everything the optimization depends on, so that sessions instantiating
+// the same functions on the same devices, e.g. one session per tenant over
+// a shared SavedModel, optimize each of them once. Only graphs are shared,
+// executors are still created per session. Its size in bytes is bounded by
+// TF_FUNCTION_GRAPH_CACHE_BYTES, which is 0, disabling it, by default.
+class FunctionGraphCache {
+ public:
+  static FunctionGraphCache* Global() {
+    static FunctionGraphCache* cache = new FunctionGraphCache;
+    return cache;
+  }
+
+  bool enabled() const { return capacity_bytes_ > 0; }
+
+  std::shared_ptr<const GraphDef> Lookup(uint64 fingerprint) {
+    mutex_lock l(mu_);
+    auto it = entries_.find(fingerprint);
+    if (it == entries_.end()) {
+      return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+    return it->second.graph;
+  }
+
+  void Insert(uint64 fingerprint, std::shared_ptr<const GraphDef> graph) {
+    const int64 bytes = graph->ByteSizeLong();
+    if (bytes > capacity_bytes_) {
+      return;
+    }
+    mutex_lock l(mu_);
+    if (entries_.count(fingerprint) > 0) {
+      return;
+    }
+    while (bytes_ + bytes > capacity_bytes_) {
+      auto it = entries_.find(lru_.back());
+      bytes_ -= it->second.bytes;
+      entries_.erase(it);
+      lru_.pop_back();
+    }
+    lru_.push_front(fingerprint);
+    Entry& entry = entries_[fingerprint];
+    entry.graph = std::move(graph);
+    entry.bytes = bytes;
+    entry.lru_position = lru_.begin();
+    bytes_ += bytes;
+  }
+
+ private:
+  FunctionGraphCache() {
+    Status s = ReadInt64FromEnvVar("TF_FUNCTION_GRAPH_CACHE_BYTES",
+                                   /*default_val=*/0, &capacity_bytes_);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+    }
+  }
+
+  struct Entry {
+    std::shared_ptr<const GraphDef> graph;
+    int64 bytes;
+    std::list<uint64>::iterator lru_position;
+  };
+
+  int64 capacity_bytes_ = 0;
+  mutex mu_;
+  std::unordered_map<uint64, Entry> entries_ GUARDED_BY(mu_);
+  // Most recently used first.
+  std::list<uint64> lru_ GUARDED_BY(mu_);
+  int64 bytes_ GUARDED_BY(mu_) = 0;
+};
+
+// Returns the fingerprint of the optimized body of `fbody` on `device`: its
+// graph, the functions it may inline, the device and the optimizer options.
+// Returns 0 if the body cannot be fingerprinted.
+uint64 OptimizedFunctionGraphFingerprint(
+    const FunctionBody& fbody, const FunctionLibraryDefinition& lib_def,
+    const Device& device, const OptimizerOptions& optimizer_options,
+    int graph_def_version) {
+  GraphDef graph_def;
+  fbody.graph->ToGraphDef(&graph_def);
+  *graph_def.mutable_library() =
+      lib_def.ReachableDefinitions(graph_def).ToProto();
+  string serialized;
+  if (!SerializeToStringDeterministic(graph_def, &serialized)) {
+    return 0;
+  }
+  uint64 fingerprint = Fingerprint64(serialized);
+  fingerprint = FingerprintCat64(fingerprint, Fingerprint64(device.name()));
+  fingerprint =
+      FingerprintCat64(fingerprint, Fingerprint64(device.device_type()));
+  if (!SerializeToStringDeterministic(optimizer_options, &serialized)) {
+    return 0;
+  }
+  fingerprint = FingerprintCat64(fingerprint, Fingerprint64(serialized));
+  return FingerprintCat64(fingerprint, graph_def_version);
+}
 }  // namespace
 
 Status FunctionLibraryRuntimeImpl::CreateItem(Item** item) {
@@ -938,12 +1076,37 @@ Status FunctionLibraryRuntimeImpl::CreateItem(Item** item) {
   const FunctionLibraryDefinition* lib_def =
       flr->GetFunctionLibraryDefinition();
   std::unique_ptr<Graph> g(new Graph(lib_def));
-  CopyGraph(*fbody->graph, g.get());
 
-  PruneFunctionBody(fbody->fdef, g.get());
-  optimizer_.Optimize(this, env(), device(), &g, /*shape_map=*/nullptr);
-  TF_RETURN_IF_ERROR(EnsureMemoryTypes(DeviceType(device()->device_type()),
-                                       device()->name(), g.get()));
+  FunctionGraphCache* cache = FunctionGraphCache::Global();
+  uint64 fingerprint = 0;
+  if (cache->enabled() && device_ != nullptr) {
+    fingerprint = OptimizedFunctionGraphFingerprint(
+        *fbody, *lib_def, *device_, optimizer_.options(), graph_def_version_);
+  }
+  std::shared_ptr<const GraphDef> cached_graph;
+  if (fingerprint != 0) {
+    cached_graph = cache->Lookup(fingerprint);
+    metrics::RecordFunctionGraphCacheLookup(cached_graph != nullptr);
+  }
+  if (cached_graph != nullptr) {
+    VLOG(1) << "Found optimized function body for "
+            << fbody->fdef.signature().name() << " in the cache";
+    GraphConstructorOptions opts;
+    opts.allow_internal_ops = true;
+    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, *cached_graph, g.get()));
+  } else {
+    CopyGraph(*fbody->graph, g.get());
+
+    PruneFunctionBody(fbody->fdef, g.get());
+    optimizer_.Optimize(this, env(), device(), &g, /*shape_map=*/nullptr);
+    TF_RETURN_IF_ERROR(EnsureMemoryTypes(DeviceType(device()->device_type()),
+                                         device()->name(), g.get()));
+    if (fingerprint != 0) {
+      auto graph_def = std::make_shared<GraphDef>();
+      g->ToGraphDef(graph_def.get());
+      cache->Insert(fingerprint, std::move(graph_def));
+    }
+  }
 
   // Creates an executor based on the g. This must be done without
   // holding mu_ because create_kernel_ calls back into the library.
@@ -964,10 +1127,28 @@ Status FunctionLibraryRuntimeImpl::CreateItem(Item** item) {
   params.session_metadata = session_metadata_;
   std::unique_ptr<Executor> exec;
   TF_RETURN_IF_ERROR(NewExecutor(executor_type, params, *g, &exec));
+
+  // Only CPU outputs can be placed in buffers that the caller hands out.
+  std::vector<std::pair<int, int>> retval_sources;
+  if (device_ != nullptr && device_->device_type() == DEVICE_CPU) {
+    for (const Node* n : g->op_nodes()) {
+      if (!n->IsRetval()) continue;
+      int index;
+      TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "index", &index));
+      if (index >= static_cast<int>(retval_sources.size())) {
+        retval_sources.resize(index + 1, {-1, -1});
+      }
+      const Edge* edge;
+      if (n->input_edge(0, &edge).ok()) {
+        retval_sources[index] = {edge->src()->id(), edge->src_output()};
+      }
+    }
+  }
   {
     // Guard item since it is already inserted in items_.
     mutex_lock l(mu_);
     if ((*item)->exec == nullptr) {
+      (*item)->retval_sources = std::move(retval_sources);
       (*item)->graph = std::move(g);
       (*item)->exec = exec.release();
     }
@@ -1012,6 +1193,22 @@ void FunctionLibraryRuntimeImpl::ExecutorArgsFromOptions(
   exec_args->call_frame = frame;
 }
 
+void FunctionLibraryRuntimeImpl::MaybeProvideRetvalBuffers(
+    const Options& run_opts, const Item* item, Executor::Args* exec_args,
+    DoneCallback* done) {
+  if (run_opts.retval_buffer_provider == nullptr ||
+      item->retval_sources.empty()) {
+    return;
+  }
+  auto* provider = new RetvalOutputProvider(item->retval_sources,
+                                            run_opts.retval_buffer_provider);
+  exec_args->static_output_provider = provider;
+  *done = [done = std::move(*done), provider](const Status& status) {
+    delete provider;
+    done(status);
+  };
+}
+
 void FunctionLibraryRuntimeImpl::RunRemote(const Options& opts, Handle handle,
                                            gtl::ArraySlice<Tensor> args,
                                            std::vector<Tensor>* rets,
@@ -1162,6 +1359,7 @@ void FunctionLibraryRuntimeImpl::Run(const Options& opts, Handle handle,
 
   Executor::Args exec_args;
   ExecutorArgsFromOptions(run_opts, frame, &exec_args);
+  MaybeProvideRetvalBuffers(run_opts, item, &exec_args, &done);
 
   bool allow_dead_tensors = run_opts.allow_dead_tensors;
   item->exec->RunAsync(
@@ -1225,6 +1423,7 @@ void FunctionLibraryRuntimeImpl::Run(const Options& opts, Handle handle,
 
   Executor::Args exec_args;
   ExecutorArgsFromOptions(run_opts, frame, &exec_args);
+  MaybeProvideRetvalBuffers(run_opts, item, &exec_args, &done);
   item->exec->RunAsync(exec_args, std::move(done));
 }
 
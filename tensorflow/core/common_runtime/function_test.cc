@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/constant_folding.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/function_testlib.h"
@@ -45,6 +46,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session_options.h"
@@ -67,6 +69,31 @@ void HasError(const Status& s, StringPiece substr) {
       << s << ", expected substring " << substr;
 }
 
+// The function graph cache reads its capacity once per process, so it is
+// enabled before any test instantiates a function.
+const bool kFunctionGraphCacheEnabled TF_ATTRIBUTE_UNUSED = [] {
+  setenv("TF_FUNCTION_GRAPH_CACHE_BYTES", "1048576", 1 /* replace */);
+  return true;
+}();
+
+// Returns the number of function graph cache lookups with `result` "hit" or
+// "miss" so far.
+int64 FunctionGraphCacheLookups(const string& result) {
+  const std::unique_ptr<monitoring::CollectedMetrics> metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics({});
+  auto it = metrics->point_set_map.find(
+      "/tensorflow/core/function_graph_cache_lookups");
+  if (it == metrics->point_set_map.end()) {
+    return 0;
+  }
+  for (const auto& point : it->second->points) {
+    if (point->labels.size() == 1 && point->labels[0].value == result) {
+      return point->int64_value;
+    }
+  }
+  return 0;
+}
+
 class FunctionTest : public ::testing::Test {
  protected:
   FunctionTest()
@@ -391,6 +418,101 @@ TEST_F(FunctionLibraryRuntimeTest, XTimesTwo) {
   test::ExpectTensorEqual<float>(y, test::AsTensor<float>({2, 4, 6, 8}));
 }
 
+TEST_F(FunctionLibraryRuntimeTest, FunctionGraphCache) {
+  auto x = test::AsTensor<float>({1, 2, 3, 4});
+  Tensor y;
+
+  // The first runtime optimizes the function bodies, unless an earlier test
+  // already did.
+  Init({test::function::XTimesTwo(), test::function::XTimesFour()});
+  TF_CHECK_OK(
+      InstantiateAndRun(flr0_, "XTimesFour", {{"T", DT_FLOAT}}, {x}, {&y}));
+  test::ExpectTensorEqual<float>(y, test::AsTensor<float>({4, 8, 12, 16}));
+
+  // A runtime over the same library and devices reuses them.
+  Init({test::function::XTimesTwo(), test::function::XTimesFour()});
+  int64 hits = FunctionGraphCacheLookups("hit");
+  int64 misses = FunctionGraphCacheLookups("miss");
+  TF_CHECK_OK(
+      InstantiateAndRun(flr0_, "XTimesFour", {{"T", DT_FLOAT}}, {x}, {&y}));
+  test::ExpectTensorEqual<float>(y, test::AsTensor<float>({4, 8, 12, 16}));
+  EXPECT_GT(FunctionGraphCacheLookups("hit"), hits);
+  EXPECT_EQ(FunctionGraphCacheLookups("miss"), misses);
+
+  // Redefining a function that XTimesFour calls changes its body, which is
+  // optimized again instead of being taken from the cache.
+  const Tensor kThree = test::AsScalar<int64>(3);
+  FunctionDef x_times_three = FDH::Define(
+      // Name
+      "XTimesTwo",
+      // Args
+      {"x: T"},
+      // Return values
+      {"y: T"},
+      // Attr def
+      {"T: {float, double, int32, int64}"},
+      // Nodes
+      {
+          {{"three"}, "Const", {}, {{"value", kThree}, {"dtype", DT_INT64}}},
+          {{"scale"}, "Cast", {"three"}, {{"SrcT", DT_INT64}, {"DstT", "$T"}}},
+          {{"y"}, "Mul", {"x", "scale"}, {{"T", "$T"}}},
+      });
+  Init({x_times_three, test::function::XTimesFour()});
+  misses = FunctionGraphCacheLookups("miss");
+  TF_CHECK_OK(
+      InstantiateAndRun(flr0_, "XTimesFour", {{"T", DT_FLOAT}}, {x}, {&y}));
+  test::ExpectTensorEqual<float>(y, test::AsTensor<float>({9, 18, 27, 36}));
+  EXPECT_GT(FunctionGraphCacheLookups("miss"), misses);
+
+  // So is the body of a function instantiated on another device.
+  misses = FunctionGraphCacheLookups("miss");
+  TF_CHECK_OK(
+      InstantiateAndRun(flr1_, "XTimesFour", {{"T", DT_FLOAT}}, {x}, {&y}));
+  test::ExpectTensorEqual<float>(y, test::AsTensor<float>({9, 18, 27, 36}));
+  EXPECT_GT(FunctionGraphCacheLookups("miss"), misses);
+}
+
+// Hands out the buffer of `tensor` for return values of its shape.
+class TensorRetvalBufferProvider : public RetvalBufferProvider {
+ public:
+  explicit TensorRetvalBufferProvider(Tensor* tensor) : tensor_(tensor) {}
+
+  TensorBuffer* AllocateRetval(int index, DataType type,
+                               const TensorShape& shape) override {
+    if (index != 0 || type != tensor_->dtype() || shape != tensor_->shape()) {
+      return nullptr;
+    }
+    TensorBuffer* buf = DMAHelper::buffer(tensor_);
+    buf->Ref();
+    return buf;
+  }
+
+ private:
+  Tensor* const tensor_;
+};
+
+TEST_F(FunctionLibraryRuntimeTest, RetvalBufferProvider) {
+  Init({test::function::XTimesTwo()});
+  FunctionLibraryRuntime::Handle handle;
+  TF_CHECK_OK(Instantiate(flr0_, "XTimesTwo", {{"T", DT_FLOAT}}, &handle));
+  auto x = test::AsTensor<float>({1, 2, 3, 4});
+  Tensor buffer(DT_FLOAT, TensorShape({4}));
+  TensorRetvalBufferProvider provider(&buffer);
+  FunctionLibraryRuntime::Options opts;
+  opts.retval_buffer_provider = &provider;
+  Tensor y;
+  TF_CHECK_OK(Run(flr0_, handle, opts, {x}, {&y}));
+  test::ExpectTensorEqual<float>(y, test::AsTensor<float>({2, 4, 6, 8}));
+  EXPECT_EQ(y.tensor_data().data(), buffer.tensor_data().data());
+  test::ExpectTensorEqual<float>(buffer, test::AsTensor<float>({2, 4, 6, 8}));
+
+  // Return values of another shape are allocated as usual.
+  auto z = test::AsTensor<float>({1, 2});
+  TF_CHECK_OK(Run(flr0_, handle, opts, {z}, {&y}));
+  test::ExpectTensorEqual<float>(y, test::AsTensor<float>({2, 4}));
+  EXPECT_NE(y.tensor_data().data(), buffer.tensor_data().data());
+}
+
 TEST_F(FunctionLibraryRuntimeTest, XTimesN) {
   Init({test::function::XTimesTwo(), test::function::XTimesFour(),
         test::function::XTimes16()});
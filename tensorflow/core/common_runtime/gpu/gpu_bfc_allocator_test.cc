@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/framework/typed_allocator.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/stream_executor.h"
@@ -52,6 +53,23 @@ static void CheckStats(Allocator* a, int64 num_allocs, int64 bytes_in_use,
   EXPECT_EQ(stats->largest_alloc_size, largest_alloc_size);
 }
 
+// Returns the value of the BFC allocator metric `name` for `allocator`.
+static int64 AllocatorMetricValue(const string& name,
+                                  const string& allocator) {
+  const std::unique_ptr<monitoring::CollectedMetrics> metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics({});
+  auto it = metrics->point_set_map.find(name);
+  if (it == metrics->point_set_map.end()) {
+    return -1;
+  }
+  for (const auto& point : it->second->points) {
+    if (point->labels.size() == 1 && point->labels[0].value == allocator) {
+      return point->int64_value;
+    }
+  }
+  return -1;
+}
+
 TEST(GPUBFCAllocatorTest, NoDups) {
   PlatformGpuId platform_gpu_id(0);
   GPUMemAllocator* sub_allocator = new GPUMemAllocator(
@@ -196,6 +214,40 @@ TEST(GPUBFCAllocatorTest, AllocateZeroBufSize) {
   EXPECT_EQ(nullptr, ptr);
 }
 
+TEST(GPUBFCAllocatorTest, SmallChunkCache) {
+  setenv("TF_BFC_ALLOCATOR_SMALL_CHUNK_CACHE", "true", 1);
+  PlatformGpuId platform_gpu_id(0);
+  GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+      platform_gpu_id, false /*use_unified_memory*/, {}, {});
+  GPUBFCAllocator a(sub_allocator, 1 << 30, "GPU_0_bfc");
+  unsetenv("TF_BFC_ALLOCATOR_SMALL_CHUNK_CACHE");
+  CheckStats(&a, 0, 0, 0, 0);
+
+  void* p1 = a.AllocateRaw(1, 1000);
+  void* p2 = a.AllocateRaw(1, 1000);
+  EXPECT_EQ(1000, a.RequestedSize(p1));
+  EXPECT_EQ(1024, a.AllocatedSize(p1));
+  EXPECT_NE(a.AllocationId(p1), a.AllocationId(p2));
+  CheckStats(&a, 2, 2048, 2048, 1024);
+  a.DeallocateRaw(p1);
+  CheckStats(&a, 2, 1024, 2048, 1024);
+
+  // The freed chunk is reused without going back to the bins.
+  void* p3 = a.AllocateRaw(1, 900);
+  EXPECT_EQ(p1, p3);
+  EXPECT_EQ(900, a.RequestedSize(p3));
+  CheckStats(&a, 3, 2048, 2048, 1024);
+  a.DeallocateRaw(p2);
+  a.DeallocateRaw(p3);
+  CheckStats(&a, 3, 0, 2048, 1024);
+
+  // Allocating all the memory flushes the cached chunks back to the bins.
+  void* large = a.AllocateRaw(1, 1 << 30);
+  EXPECT_NE(nullptr, large);
+  a.DeallocateRaw(large);
+}
+
 TEST(GPUBFCAllocatorTest, TracksSizes) {
   PlatformGpuId platform_gpu_id(0);
   GPUMemAllocator* sub_allocator = new GPUMemAllocator(
@@ -633,6 +685,130 @@ class GPUBFCAllocatorPrivateMethodsTest : public ::testing::Test {
     }
     EXPECT_EQ(1, num_chunks_in_bins);
   }
+
+  void TestReleaseFreeRegions() {
+    GPUOptions options;
+    options.set_allow_growth(true);
+    setenv("TF_BFC_ALLOCATOR_REGION_RELEASE_SECS", "10", 1);
+    PlatformGpuId platform_gpu_id(0);
+    GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+        GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+        platform_gpu_id, /*use_unified_memory=*/false, {}, {});
+    GPUBFCAllocator a(sub_allocator, 1LL << 31, options, "GPU_0_bfc_release");
+    unsetenv("TF_BFC_ALLOCATOR_REGION_RELEASE_SECS");
+    EXPECT_EQ(10000000, a.region_release_interval_micros_);
+
+    // Allocate 128 raw pointers of 4 megs, and free all but the last one.
+    const size_t size = 1LL << 22;
+    std::vector<void*> initial_ptrs;
+    for (size_t s = 0; s < 128; s++) {
+      initial_ptrs.push_back(a.AllocateRaw(1, size));
+    }
+    for (size_t i = 0; i < initial_ptrs.size() - 1; i++) {
+      a.DeallocateRaw(initial_ptrs[i]);
+    }
+
+    {
+      mutex_lock l(a.lock_);
+      const size_t num_regions = a.region_manager_.regions().size();
+      EXPECT_LT(1, num_regions);
+
+      // Free regions are kept until the release is due.
+      a.next_region_release_micros_ = 1000;
+      a.MaybeUpdateFragmentationStats(999);
+      EXPECT_EQ(num_regions, a.region_manager_.regions().size());
+
+      // Then all but the region holding the last pointer are released.
+      a.MaybeUpdateFragmentationStats(1000);
+      EXPECT_EQ(1, a.region_manager_.regions().size());
+      EXPECT_EQ(static_cast<uint64>(1000 + a.region_release_interval_micros_),
+                a.next_region_release_micros_);
+    }
+    EXPECT_LT(0,
+              AllocatorMetricValue(
+                  "/tensorflow/core/bfc_allocator/released_region_bytes",
+                  "GPU_0_bfc_release"));
+
+    void* p = a.AllocateRaw(1, size);
+    EXPECT_NE(nullptr, p);
+    a.DeallocateRaw(p);
+    a.DeallocateRaw(initial_ptrs.back());
+  }
+
+  void TestNoRegionReleaseByDefault() {
+    GPUOptions options;
+    options.set_allow_growth(true);
+    unsetenv("TF_BFC_ALLOCATOR_REGION_RELEASE_SECS");
+    PlatformGpuId platform_gpu_id(0);
+    GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+        GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+        platform_gpu_id, /*use_unified_memory=*/false, {}, {});
+    GPUBFCAllocator a(sub_allocator, 1LL << 31, options, "GPU_0_bfc_keep");
+    EXPECT_EQ(0, a.region_release_interval_micros_);
+
+    void* p = a.AllocateRaw(1, 1LL << 22);
+    a.DeallocateRaw(p);
+    mutex_lock l(a.lock_);
+    a.MaybeUpdateFragmentationStats(Env::Default()->NowMicros());
+    EXPECT_EQ(1, a.region_manager_.regions().size());
+  }
+
+  void TestFragmentationStats() {
+    PlatformGpuId platform_gpu_id(0);
+    GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+        GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+        platform_gpu_id, false /*use_unified_memory*/, {}, {});
+    GPUBFCAllocator a(sub_allocator, 1 << 30, "GPU_0_bfc_fragmentation");
+
+    // Free every other chunk, so that the free chunks cannot be coalesced.
+    const size_t size = 1 << 20;
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 10; i++) {
+      ptrs.push_back(a.AllocateRaw(1, size));
+    }
+    for (int i = 0; i < 10; i += 2) {
+      a.DeallocateRaw(ptrs[i]);
+    }
+
+    int64 free_bytes = 0;
+    int64 largest_free_chunk = 0;
+    {
+      mutex_lock l(a.lock_);
+      ASSERT_EQ(1, a.region_manager_.regions().size());
+      for (int i = 0; i < BFCAllocator::kNumBins; i++) {
+        const BFCAllocator::Bin* bin = a.BinFromIndex(i);
+        size_t bin_free_bytes = 0;
+        for (BFCAllocator::ChunkHandle h : bin->free_chunks) {
+          const int64 chunk_size = a.ChunkFromHandle(h)->size;
+          bin_free_bytes += chunk_size;
+          largest_free_chunk = std::max(largest_free_chunk, chunk_size);
+        }
+        EXPECT_EQ(bin_free_bytes, bin->total_free_bytes) << "bin " << i;
+        free_bytes += bin->total_free_bytes;
+      }
+      EXPECT_EQ(
+          static_cast<int64>(a.region_manager_.regions()[0].memory_size() -
+                             5 * size),
+          free_bytes);
+
+      a.next_fragmentation_stats_micros_ = 0;
+      a.MaybeUpdateFragmentationStats(1);
+      const uint64 next_micros =
+          1 + BFCAllocator::kFragmentationStatsIntervalMicros;
+      EXPECT_EQ(next_micros, a.next_fragmentation_stats_micros_);
+    }
+    EXPECT_EQ(free_bytes,
+              AllocatorMetricValue("/tensorflow/core/bfc_allocator/free_bytes",
+                                   "GPU_0_bfc_fragmentation"));
+    EXPECT_EQ(largest_free_chunk,
+              AllocatorMetricValue(
+                  "/tensorflow/core/bfc_allocator/largest_free_chunk_bytes",
+                  "GPU_0_bfc_fragmentation"));
+
+    for (int i = 1; i < 10; i += 2) {
+      a.DeallocateRaw(ptrs[i]);
+    }
+  }
 };
 
 TEST_F(GPUBFCAllocatorPrivateMethodsTest, BinDebugInfo) { TestBinDebugInfo(); }
@@ -649,6 +825,18 @@ TEST_F(GPUBFCAllocatorPrivateMethodsTest, TestRegionDeallocation) {
   TestRegionDeallocation();
 }
 
+TEST_F(GPUBFCAllocatorPrivateMethodsTest, ReleaseFreeRegions) {
+  TestReleaseFreeRegions();
+}
+
+TEST_F(GPUBFCAllocatorPrivateMethodsTest, NoRegionReleaseByDefault) {
+  TestNoRegionReleaseByDefault();
+}
+
+TEST_F(GPUBFCAllocatorPrivateMethodsTest, FragmentationStats) {
+  TestFragmentationStats();
+}
+
 }  // namespace tensorflow
 
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -225,6 +225,10 @@ class EigenGpuStreamDevice : public ::Eigen::StreamInterface {
   TF_DISALLOW_COPY_AND_ASSIGN(EigenGpuStreamDevice);
 };
 
+// Upper bound of TF_GPU_NUM_COMPUTE_STREAMS. FillContextMap records the streams
+// a node waits for in a 32-bit mask.
+constexpr int kMaxComputeStreams = 8;
+
 // This factory helps to ensure that different GPU device objects that refer to
 // the same physical device and stream group id use the same stream group
 // object (and therefore the same CUDA streams). This is necessary since there
@@ -330,15 +334,19 @@ BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
 
 BaseGPUDevice::~BaseGPUDevice() {
   delete gpu_device_info_;
-  gpu_allocator_->DeallocateRaw(scratch_);
-  device_context_->Unref();
+  for (char* scratch : scratch_) gpu_allocator_->DeallocateRaw(scratch);
+  {
+    mutex_lock l(wait_contexts_mu_);
+    for (auto& entry : wait_contexts_) entry.second->Unref();
+  }
+  for (GPUDeviceContext* context : device_contexts_) context->Unref();
 }
 
 // This should be idempotent if already initialized.
 Status BaseGPUDevice::InitScratchBuffers() {
   mutex_lock l(scratch_init_mutex_);
-  if (!scratch_) {
-    DCHECK(stream_);
+  for (size_t i = scratch_.size(); i < streams_.size(); ++i) {
+    DCHECK(streams_[i]);
     size_t scratch_buffer_size = Eigen::kGpuScratchSize + sizeof(unsigned int);
     MEMDEBUG_CACHE_OP("ScratchBuffer");
     void* scratch_buffer = gpu_allocator_->AllocateRaw(
@@ -351,7 +359,7 @@ Status BaseGPUDevice::InitScratchBuffers() {
         se::DeviceMemoryBase(scratch_buffer, scratch_buffer_size));
     TF_RETURN_IF_ERROR(executor_->SynchronousMemZero(
         &mem, Eigen::kGpuScratchSize + sizeof(unsigned int)));
-    scratch_ = static_cast<char*>(scratch_buffer);
+    scratch_.push_back(static_cast<char*>(scratch_buffer));
   }
   return Status::OK();
 }
@@ -365,15 +373,30 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
 
   executor_ = executor_status.ValueOrDie();
 
-  stream_ = StreamGroupFactory::Global().GetOrCreate(
-      tf_gpu_id_, 0, executor_, options.config.gpu_options());
-  device_context_ =
-      new GPUDeviceContext(0, stream_->compute,
+  // Number of compute streams the executor spreads independent kernels over.
+  // With more than one, tensors accessed by a kernel are kept alive until the
+  // kernel has finished on its stream (see RequiresRecordingAccessedTensors).
+  int64 num_compute_streams = 1;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_GPU_NUM_COMPUTE_STREAMS", 1,
+                                         &num_compute_streams));
+  if (num_compute_streams < 1 || num_compute_streams > kMaxComputeStreams) {
+    LOG(ERROR) << "Illegal TF_GPU_NUM_COMPUTE_STREAMS=" << num_compute_streams
+               << " set to 1 instead.";
+    num_compute_streams = 1;
+  }
+  for (int i = 0; i < num_compute_streams; ++i) {
+    StreamGroup* group = StreamGroupFactory::Global().GetOrCreate(
+        tf_gpu_id_, i, executor_, options.config.gpu_options());
+    streams_.push_back(group);
+    device_contexts_.push_back(new GPUDeviceContext(
+        i, group->compute,
 #if TENSORFLOW_USE_ROCM
-                           stream_->nccl,
+        group->nccl,
 #endif
-                           stream_->host_to_device, stream_->device_to_host,
-                           stream_->device_to_device);
+        group->host_to_device, group->device_to_host, group->device_to_device));
+  }
+  stream_ = streams_[0];
+  device_context_ = device_contexts_[0];
 
   em_ = EventMgrFactory::Singleton()->GetEventMgr(executor_,
                                                   options.config.gpu_options());
@@ -388,6 +411,13 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
   if (timestamped_allocator_ ||
       (tracker_params.max_interval > 0 || tracker_params.max_bytes > 0 ||
        tracker_params.max_pending > 0)) {
+    if (streams_.size() > 1) {
+      // The kernel tracker and the timestamped allocator assume that all
+      // kernels run in order on a single stream.
+      return errors::InvalidArgument(
+          "TF_GPU_NUM_COMPUTE_STREAMS > 1 cannot be combined with the GPU "
+          "kernel tracker or the timestamped allocator");
+    }
     SharedCounter* timing_counter = nullptr;
     if (timestamped_allocator_) {
       // In this case the SharedCounter was already created and set in the
@@ -463,10 +493,71 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
 }
 
 bool BaseGPUDevice::RequiresRecordingAccessedTensors() const {
-  // Since there is only one stream, we release the tensor reference
-  // at the end of the kernel launch, instead of at the end of the kernel
-  // execution.
-  return false;
+  // With a single stream, we release the tensor reference at the end of the
+  // kernel launch, instead of at the end of the kernel execution: any later
+  // user of the freed memory is queued behind the kernel anyway. With several
+  // streams that no longer holds, so references are kept until the kernel's
+  // stream has reached the end of the kernel.
+  return streams_.size() > 1;
+}
+
+Status BaseGPUDevice::FillContextMap(const Graph* graph,
+                                     DeviceContextMap* device_context_map) {
+  if (streams_.size() <= 1) return Status::OK();
+
+  gpu_stream_util::AssignStreamsOpts opts;
+  opts.max_streams = streams_.size();
+  // Keep transfers on stream 0, so that they stay ordered with respect to the
+  // copies issued by the rendezvous and the GPU utilities.
+  opts.send_stream = 0;
+  opts.recv_stream = 0;
+  std::unordered_map<int, int> node_to_stream_id;
+  TF_RETURN_IF_ERROR(
+      gpu_stream_util::AssignStreams(graph, opts, &node_to_stream_id));
+
+  device_context_map->resize(graph->num_node_ids());
+  for (Node* n : graph->nodes()) {
+    const int stream_id = node_to_stream_id[n->id()];
+    // Only edges that cross streams need an explicit wait; everything else is
+    // already ordered by its stream.
+    uint32 wait_mask = 0;
+    for (const Edge* e : n->in_edges()) {
+      if (e->src()->IsSource()) continue;
+      auto it = node_to_stream_id.find(e->src()->id());
+      if (it != node_to_stream_id.end() && it->second != stream_id) {
+        wait_mask |= 1u << it->second;
+      }
+    }
+    GPUDeviceContext* context = wait_mask == 0
+                                    ? device_contexts_[stream_id]
+                                    : GetWaitingContext(stream_id, wait_mask);
+    context->Ref();
+    (*device_context_map)[n->id()] = context;
+    VLOG(3) << "Assigned " << n->name() << " to stream[" << stream_id
+            << "], waiting for streams 0x" << strings::Hex(wait_mask);
+  }
+  return Status::OK();
+}
+
+GPUDeviceContext* BaseGPUDevice::GetWaitingContext(int stream_id,
+                                                   uint32 wait_mask) {
+  mutex_lock l(wait_contexts_mu_);
+  GPUDeviceContext*& context = wait_contexts_[{stream_id, wait_mask}];
+  if (context == nullptr) {
+    StreamGroup* group = streams_[stream_id];
+    context = new GPUDeviceContext(
+        stream_id, group->compute,
+#if TENSORFLOW_USE_ROCM
+        group->nccl,
+#endif
+        group->host_to_device, group->device_to_host, group->device_to_device);
+    gtl::InlinedVector<se::Stream*, 4> wait_streams;
+    for (int i = 0, n = streams_.size(); i < n; ++i) {
+      if (wait_mask & (1u << i)) wait_streams.push_back(streams_[i]->compute);
+    }
+    context->set_wait_streams(std::move(wait_streams));
+  }
+  return context;
 }
 
 string BaseGPUDevice::ComputeOpKernelDebugString(const OpKernel& op_kernel,
@@ -505,6 +596,9 @@ void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
     }
   }
   ScopedActivateExecutorContext scoped_activation{stream->parent()};
+  for (se::Stream* wait_stream : gpu_device_context->wait_streams()) {
+    stream->ThenWaitFor(wait_stream);
+  }
   MEMDEBUG_CACHE_OP(op_kernel->name().c_str());
   MEMDEBUG_CACHE_STEPID(context->step_id());
   op_kernel->Compute(context);
@@ -571,6 +665,9 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
           << stream_id << "]";
 
   ScopedActivateExecutorContext scoped_activation{stream->parent()};
+  for (se::Stream* wait_stream : gpu_device_context->wait_streams()) {
+    stream->ThenWaitFor(wait_stream);
+  }
   op_kernel->ComputeAsync(context, std::move(done));
 }
 
@@ -891,11 +988,11 @@ void BaseGPUDevice::ReinitializeDevice(OpKernelContext* context,
   ConcretePerOpGpuDevice* concrete_device =
       static_cast<ConcretePerOpGpuDevice*>(device);
   DCHECK(concrete_device);
-  DCHECK_EQ(stream_id, 0);
+  DCHECK_LT(stream_id, streams_.size());
   const gpuStream_t* gpu_stream = reinterpret_cast<const gpuStream_t*>(
-      stream_->compute->implementation()->GpuStreamMemberHack());
+      streams_[stream_id]->compute->implementation()->GpuStreamMemberHack());
   concrete_device->Reinitialize(context, gpu_stream, tf_gpu_id_, allocator,
-                                scratch_);
+                                scratch_[stream_id]);
 }
 
 PerOpGpuDevice* BaseGPUDevice::MakeGpuDevice() {
@@ -912,7 +1009,6 @@ Status BaseGPUDevice::ReinitializeGpuDevice(OpKernelContext* context,
     const int stream_id = gpu_dc->stream_id();
     VLOG(1) << "  eigen_gpu_device(" << dc << ") => stream[" << stream_id
             << "]";
-    CHECK_EQ(stream_id, 0);
     ReinitializeDevice(context, device, stream_id, allocator);
   } else {
     ReinitializeDevice(context, device, 0, allocator);
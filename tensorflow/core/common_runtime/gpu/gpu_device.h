@@ -20,9 +20,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_DEVICE_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_DEVICE_H_
 
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -93,6 +95,11 @@ class BaseGPUDevice : public LocalDevice {
                                DeviceContext* dc,
                                Allocator* allocator) override;
 
+  // Assigns the nodes of `graph` to the compute streams of this device, if it
+  // has more than one.  See TF_GPU_NUM_COMPUTE_STREAMS.
+  Status FillContextMap(const Graph* graph,
+                        DeviceContextMap* device_context_map) override;
+
   // Returns the platform GPU id of this device within the native driver system;
   // e.g., for CUDA and ROCm this is the ordinal of the GPU within the system.
   int gpu_id() const {
@@ -143,10 +150,20 @@ class BaseGPUDevice : public LocalDevice {
   };
   class StreamGroupFactory;
 
+  // Stream group 0 holds the compute stream used unless FillContextMap picks
+  // another one for a node.
   StreamGroup* stream_;
+  gtl::InlinedVector<StreamGroup*, 4> streams_;
   mutex scratch_init_mutex_;
-  char* scratch_ = nullptr;
+  // Eigen scratch buffers, one per compute stream.
+  gtl::InlinedVector<char*, 4> scratch_;
   GPUDeviceContext* device_context_;
+  gtl::InlinedVector<GPUDeviceContext*, 4> device_contexts_;
+  // Contexts of nodes that wait for other compute streams, keyed by their
+  // stream and the bitmask of the streams they wait for.
+  mutex wait_contexts_mu_;
+  std::map<std::pair<int, uint32>, GPUDeviceContext*> wait_contexts_
+      GUARDED_BY(wait_contexts_mu_);
   GpuDeviceInfo* gpu_device_info_ = nullptr;
   mutex trace_mu_;
   TfGpuId tf_gpu_id_;
@@ -160,6 +177,10 @@ class BaseGPUDevice : public LocalDevice {
   // Initialize scractch buffers used by Eigen.
   Status InitScratchBuffers();
 
+  // Returns a context for kernels on compute stream `stream_id` that first
+  // wait for the compute streams in the bitmask `wait_mask`.
+  GPUDeviceContext* GetWaitingContext(int stream_id, uint32 wait_mask);
+
   void ReinitializeDevice(OpKernelContext* context, PerOpGpuDevice* device,
                           int stream_id, Allocator* allocator);
 
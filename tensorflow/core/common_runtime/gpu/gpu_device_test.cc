@@ -17,14 +17,26 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_device.h"
 
+#include <map>
+#include <set>
+
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id_utils.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
+#include "tensorflow/core/common_runtime/gpu_device_context.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
 
 namespace tensorflow {
 namespace {
@@ -345,6 +357,191 @@ TEST_F(GPUDeviceTest, CopyTensorInSameDevice) {
   }
 }
 
+// Tests of TF_GPU_NUM_COMPUTE_STREAMS.
+class GPUMultiStreamTest : public GPUDeviceTest {
+ protected:
+  void TearDown() override {
+    unsetenv("TF_GPU_NUM_COMPUTE_STREAMS");
+    GPUDeviceTest::TearDown();
+  }
+
+  std::unique_ptr<Device> CreateDevice(int num_compute_streams) {
+    setenv("TF_GPU_NUM_COMPUTE_STREAMS",
+           strings::StrCat(num_compute_streams).c_str(), /*overwrite=*/1);
+    std::vector<std::unique_ptr<Device>> devices;
+    TF_CHECK_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+        MakeSessionOptions("0"), kDeviceNamePrefix, &devices));
+    return std::move(devices[0]);
+  }
+
+  // Builds `num_branches` independent chains of element-wise ops on the GPU,
+  // summed up by a single AddN.
+  static Status BuildBranches(int num_branches, int num_elements, Graph* g) {
+    Scope root = Scope::NewRootScope().WithDevice("/device:GPU:0");
+    std::vector<Output> branches;
+    for (int i = 0; i < num_branches; ++i) {
+      Scope branch = root.NewSubScope(strings::StrCat("branch", i));
+      Output x = ops::Const(branch, static_cast<float>(i + 1),
+                            TensorShape({num_elements}));
+      branches.push_back(ops::Sqrt(branch, ops::Square(branch, x)));
+    }
+    ops::AddN(root.WithOpName("sum"), branches);
+    return root.ToGraph(g);
+  }
+
+  // Returns the contexts in `context_map` of the nodes of `g`, by name.
+  static std::map<string, GPUDeviceContext*> NodeContexts(
+      const Graph& g, const DeviceContextMap& context_map) {
+    std::map<string, GPUDeviceContext*> contexts;
+    for (Node* n : g.op_nodes()) {
+      contexts[n->name()] =
+          static_cast<GPUDeviceContext*>(context_map[n->id()]);
+    }
+    return contexts;
+  }
+
+  static void Unref(DeviceContextMap* context_map) {
+    for (DeviceContext* dc : *context_map) {
+      if (dc != nullptr) dc->Unref();
+    }
+    context_map->clear();
+  }
+
+  void RunBranches(int num_compute_streams);
+};
+
+TEST_F(GPUMultiStreamTest, SingleStreamKeepsDefaultContext) {
+  std::unique_ptr<Device> device = CreateDevice(1);
+  EXPECT_FALSE(device->RequiresRecordingAccessedTensors());
+
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(BuildBranches(4, 16, &g));
+  DeviceContextMap context_map;
+  TF_ASSERT_OK(device->FillContextMap(&g, &context_map));
+  EXPECT_TRUE(context_map.empty());
+}
+
+TEST_F(GPUMultiStreamTest, SpreadsNodesAcrossStreams) {
+  std::unique_ptr<Device> device = CreateDevice(4);
+  EXPECT_TRUE(device->RequiresRecordingAccessedTensors());
+
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(BuildBranches(4, 16, &g));
+  DeviceContextMap context_map;
+  TF_ASSERT_OK(device->FillContextMap(&g, &context_map));
+  auto contexts = NodeContexts(g, context_map);
+
+  std::set<int> branch_streams;
+  std::set<se::Stream*> branch_compute_streams;
+  for (int i = 0; i < 4; ++i) {
+    GPUDeviceContext* sqrt = contexts[strings::StrCat("branch", i, "/Sqrt")];
+    ASSERT_NE(sqrt, nullptr);
+    EXPECT_GE(sqrt->stream_id(), 0);
+    EXPECT_LT(sqrt->stream_id(), 4);
+    // Each chain stays on one stream, so it does not wait for any other.
+    EXPECT_EQ(contexts[strings::StrCat("branch", i, "/Square")]->stream_id(),
+              sqrt->stream_id());
+    EXPECT_TRUE(sqrt->wait_streams().empty());
+    branch_streams.insert(sqrt->stream_id());
+    branch_compute_streams.insert(sqrt->stream());
+  }
+  EXPECT_EQ(branch_streams.size(), 4);
+  EXPECT_EQ(branch_compute_streams.size(), 4);
+  Unref(&context_map);
+}
+
+TEST_F(GPUMultiStreamTest, CrossStreamConsumersWaitForProducers) {
+  std::unique_ptr<Device> device = CreateDevice(4);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(BuildBranches(4, 16, &g));
+  DeviceContextMap context_map;
+  TF_ASSERT_OK(device->FillContextMap(&g, &context_map));
+  auto contexts = NodeContexts(g, context_map);
+
+  // The sum runs on the stream of one branch, and waits for the three others.
+  GPUDeviceContext* sum = contexts["sum"];
+  ASSERT_NE(sum, nullptr);
+  std::set<se::Stream*> wait_streams(sum->wait_streams().begin(),
+                                     sum->wait_streams().end());
+  EXPECT_EQ(wait_streams.size(), 3);
+  for (int i = 0; i < 4; ++i) {
+    GPUDeviceContext* sqrt = contexts[strings::StrCat("branch", i, "/Sqrt")];
+    if (sqrt->stream_id() == sum->stream_id()) {
+      EXPECT_EQ(wait_streams.count(sqrt->stream()), 0);
+    } else {
+      EXPECT_EQ(wait_streams.count(sqrt->stream()), 1);
+    }
+  }
+  Unref(&context_map);
+}
+
+TEST_F(GPUMultiStreamTest, ScratchBufferPerStream) {
+  std::unique_ptr<Device> device = CreateDevice(4);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(BuildBranches(4, 16, &g));
+  DeviceContextMap context_map;
+  TF_ASSERT_OK(device->FillContextMap(&g, &context_map));
+  auto contexts = NodeContexts(g, context_map);
+
+  // Returns the Eigen scratch buffer of kernels run with `dc`.
+  Allocator* allocator = device->GetAllocator(AllocatorAttributes());
+  auto scratchpad = [&](DeviceContext* dc) {
+    std::unique_ptr<PerOpGpuDevice> eigen_device(device->MakeGpuDevice());
+    TF_CHECK_OK(device->ReinitializeGpuDevice(
+        /*context=*/nullptr, eigen_device.get(), dc, allocator));
+    return eigen_device->device().scratchpad();
+  };
+
+  // Kernels on one stream share a scratch buffer, kernels on different
+  // streams do not.
+  std::set<void*> scratchpads;
+  for (int i = 0; i < 4; ++i) {
+    void* square =
+        scratchpad(contexts[strings::StrCat("branch", i, "/Square")]);
+    void* sqrt = scratchpad(contexts[strings::StrCat("branch", i, "/Sqrt")]);
+    EXPECT_EQ(square, sqrt);
+    scratchpads.insert(sqrt);
+  }
+  EXPECT_EQ(scratchpads.size(), 4);
+  // The scratch buffer of stream 0 is still the one without a context.
+  EXPECT_EQ(scratchpads.count(scratchpad(nullptr)), 1);
+  Unref(&context_map);
+}
+
+// Runs the branches in a session with `num_compute_streams`, so that the sum
+// is wrong if it does not wait for the branches on other streams.
+void GPUMultiStreamTest::RunBranches(int num_compute_streams) {
+  constexpr int kNumBranches = 8;
+  constexpr int kNumElements = 1 << 16;
+  setenv("TF_GPU_NUM_COMPUTE_STREAMS",
+         strings::StrCat(num_compute_streams).c_str(), /*overwrite=*/1);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(BuildBranches(kNumBranches, kNumElements, &g));
+  GraphDef graph_def;
+  g.ToGraphDef(&graph_def);
+
+  std::unique_ptr<Session> session(NewSession(SessionOptions()));
+  TF_ASSERT_OK(session->Create(graph_def));
+  std::vector<Tensor> outputs;
+  // Several steps, so that kernels of one step can overlap the next one's.
+  for (int step = 0; step < 5; ++step) {
+    TF_ASSERT_OK(session->Run({}, {"sum"}, {}, &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    // 1 + 2 + ... + kNumBranches.
+    test::ExpectTensorEqual<float>(
+        outputs[0],
+        test::AsTensor<float>(std::vector<float>(
+                                  kNumElements,
+                                  kNumBranches * (kNumBranches + 1) / 2),
+                              {kNumElements}));
+  }
+  TF_ASSERT_OK(session->Close());
+}
+
+TEST_F(GPUMultiStreamTest, RunsGraphOnOneStream) { RunBranches(1); }
+
+TEST_F(GPUMultiStreamTest, RunsGraphOnSeveralStreams) { RunBranches(4); }
+
 class GPUKernelTrackerTest : public ::testing::Test {
  protected:
   void Init(const GPUKernelTracker::Params& params) {
@@ -18,12 +18,13 @@ limitations under the License.
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
-// The EventMgr has 1 thread for the polling loop and one to execute
-// event callback functions. Issues for reconsideration:
+// The EventMgr has 1 thread for the polling loop (or, with host callbacks, for
+// retiring completed records) and one to execute event callback functions. Issues for reconsideration:
 //  - Is this the right number of threads?
 //  - Should EventMgrs be shared between GPUDevices on a multi-GPU machine?
 static const int kNumThreads = 2;
@@ -97,16 +98,29 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
       polling_active_delay_usecs_(gpu_options.polling_active_delay_usecs()
                                       ? gpu_options.polling_active_delay_usecs()
                                       : 10),
+      use_host_callbacks_([] {
+        bool value = false;
+        TF_CHECK_OK(ReadBoolFromEnvVar("TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS",
+                                       false, &value));
+        return value;
+      }()),
       accumulated_stream_(nullptr),
       accumulated_tensors_(new TensorReferenceVector),
       accumulated_tensor_bytes_(0),
       threadpool_(Env::Default(), "GPU_Event_Manager", kNumThreads) {
   gpu_event_mgr::InitThreadpoolLabels(&threadpool_);
-  StartPollingLoop();
+  if (!use_host_callbacks_) StartPollingLoop();
 }
 
 EventMgr::~EventMgr() {
   StopPollingLoop();
+  {
+    // Pending host callbacks refer to this object.
+    mutex_lock l(mu_);
+    while (num_pending_callbacks_ > 0 || drain_scheduled_) {
+      callbacks_done_.wait(l);
+    }
+  }
 
   // Events are owned by this object.
   for (auto& e : free_events_) {
@@ -219,6 +233,10 @@ void EventMgr::PollLoop() {
 }
 
 void EventMgr::QueueInUse(se::Stream* stream, InUse iu) {
+  if (use_host_callbacks_) {
+    QueueHostCallback(stream, std::move(iu));
+    return;
+  }
   VLOG(2) << "QueueInUse  free_events_ " << free_events_.size()
           << " used_events_ " << used_events_.size();
   // Events are created on demand, and repeatedly reused.  There is no
@@ -237,6 +255,41 @@ void EventMgr::QueueInUse(se::Stream* stream, InUse iu) {
   if (was_empty) events_pending_.notify_all();
 }
 
+void EventMgr::QueueHostCallback(se::Stream* stream, InUse iu) {
+  VLOG(2) << "QueueHostCallback pending " << num_pending_callbacks_;
+  ++num_pending_callbacks_;
+  // The callback runs on a driver thread that blocks the stream until it
+  // returns, so it only moves the record over and wakes up a drainer.
+  InUse* pending = new InUse(std::move(iu));
+  stream->ThenDoHostCallback([this, pending]() {
+    mutex_lock l(mu_);
+    completed_callbacks_.push_back(std::move(*pending));
+    delete pending;
+    --num_pending_callbacks_;
+    if (!drain_scheduled_) {
+      drain_scheduled_ = true;
+      threadpool_.Schedule([this]() { DrainCompletedCallbacks(); });
+    }
+  });
+}
+
+void EventMgr::DrainCompletedCallbacks() {
+  ToFreeVector to_free;
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      if (completed_callbacks_.empty()) {
+        drain_scheduled_ = false;
+        if (num_pending_callbacks_ == 0) callbacks_done_.notify_all();
+        return;
+      }
+      to_free.swap(completed_callbacks_);
+    }
+    FreeMemory(to_free);
+    to_free.clear();
+  }
+}
+
 // This function must be called periodically to check whether pending
 // events have recorded, and then retire them.  Initial observations
 // suggest that typical behavior in a TensorFlow program is to have
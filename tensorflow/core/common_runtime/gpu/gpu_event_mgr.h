@@ -61,6 +61,15 @@ void WarnIfInCallback(std::function<void()> f);
 // An object to keep track of pending Events in the StreamExecutor streams
 // and associated Tensors that cannot safely be deleted until the associated
 // Events are recorded.
+//
+// By default completion is detected by polling recorded events, from the
+// calling threads and from a dedicated thread that sleeps
+// polling_active_delay_usecs between sweeps while events are outstanding.
+// With TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS=true, a host callback is enqueued
+// on the stream instead (cuStreamAddCallback / hipStreamAddCallback). The
+// callback only hands the record over; completed records are retired in
+// batches on the EventMgr threadpool, so a burst of completions costs a
+// single wakeup and no thread spins while the GPU is busy.
 class EventMgr {
  public:
   virtual ~EventMgr();
@@ -111,6 +120,7 @@ class EventMgr {
   se::StreamExecutor* const exec_;
   const int64 deferred_bytes_threshold_;
   const int32 polling_active_delay_usecs_;
+  const bool use_host_callbacks_;
   mutex mu_;
   condition_variable events_pending_ GUARDED_BY(mu_);
 
@@ -177,6 +187,14 @@ class EventMgr {
   void PollEvents(bool is_dedicated_poller, ToFreeVector* to_free)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Enqueues a host callback on "stream" that retires "in_use" once all
+  // work currently enqueued on "stream" has completed.
+  void QueueHostCallback(se::Stream* stream, InUse in_use)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Retires the records collected by host callbacks, until none are left.
+  void DrainCompletedCallbacks();
+
   // An internal polling loop that runs at a low frequency to clear
   // straggler Events.
   void PollLoop();
@@ -197,6 +215,14 @@ class EventMgr {
   // A FIFO queue of InUse events and associated tensors.
   std::deque<InUse> used_events_ GUARDED_BY(mu_);
 
+  // Records whose host callback has run, waiting to be retired by
+  // DrainCompletedCallbacks(), which is scheduled iff "drain_scheduled_".
+  ToFreeVector completed_callbacks_ GUARDED_BY(mu_);
+  bool drain_scheduled_ GUARDED_BY(mu_) = false;
+  // Number of host callbacks enqueued but not yet run.
+  int64 num_pending_callbacks_ GUARDED_BY(mu_) = 0;
+  condition_variable callbacks_done_;
+
   bool stop_polling_ GUARDED_BY(mu_);
   std::unique_ptr<Notification> polling_stopped_;
 
@@ -283,6 +283,45 @@ TEST(EventMgr, WarnIfInCallback) {
   note.WaitForNotification();
   EXPECT_TRUE(hit);
 }
+
+// With host callbacks, records are retired without a polling thread, in the
+// order they were queued on a stream.
+TEST(EventMgr, HostCallbacks) {
+  setenv("TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS", "true", 1);
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  {
+    TEST_EventMgr em(stream_exec, GPUOptions());
+    TEST_EventMgrHelper th(&em);
+    std::unique_ptr<se::Stream> stream(new se::Stream(stream_exec));
+    CHECK(stream);
+    stream->Init();
+    EXPECT_EQ(0, live_tensor_bytes);
+    for (int i = 0; i < 5; ++i) {
+      TensorReferenceVector v;
+      AddTensorReference(&v, 100 * 1048576);
+      em.ThenDeleteTensors(stream.get(), v);
+      // No events are recorded in this mode.
+      EXPECT_EQ(0, th.queue_size());
+      EXPECT_EQ(0, th.free_size());
+    }
+    Notification note;
+    bool in_callback = false;
+    em.ThenExecute(stream.get(), [&note, &in_callback]() {
+      gpu_event_mgr::WarnIfInCallback([&in_callback] { in_callback = true; });
+      note.Notify();
+    });
+    note.WaitForNotification();
+    EXPECT_TRUE(in_callback);
+    EXPECT_EQ(0, live_tensor_bytes);
+
+    // Shutting down with callbacks still pending waits for them.
+    TensorReferenceVector v;
+    AddTensorReference(&v, 100 * 1048576);
+    em.ThenDeleteTensors(stream.get(), v);
+  }
+  EXPECT_EQ(0, live_tensor_bytes);
+  unsetenv("TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS");
+}
 }  // namespace
 
 // Provides access to private resources of BaseGPUDevice.
@@ -16,22 +16,33 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_HOST_ALLOCATOR_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_HOST_ALLOCATOR_H_
 
+#include <unordered_set>
+
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/stream_executor.h"
 
 namespace tensorflow {
 // Allocator for pinned CPU RAM that is made known to GPU for the
 // purpose of efficient DMA with a GPU.
+//
+// With `numa_affinity`, memory is allocated on `numa_node` and then
+// registered with the GPU, since the driver's own pinned allocations are
+// placed wherever the calling thread happens to run.
 class GpuHostAllocator : public SubAllocator {
  public:
   // Note: stream_exec cannot be null.
   explicit GpuHostAllocator(se::StreamExecutor* stream_exec, int numa_node,
                             const std::vector<Visitor>& alloc_visitors,
-                            const std::vector<Visitor>& free_visitors)
+                            const std::vector<Visitor>& free_visitors,
+                            bool numa_affinity = false)
       : SubAllocator(alloc_visitors, free_visitors),
         stream_exec_(stream_exec),
-        numa_node_(numa_node) {
+        numa_node_(numa_node),
+        numa_affinity_(numa_affinity && numa_node >= 0 &&
+                       port::NUMAEnabled()) {
     CHECK(stream_exec_ != nullptr);
   }
   ~GpuHostAllocator() override {}
@@ -39,7 +50,12 @@ class GpuHostAllocator : public SubAllocator {
   void* Alloc(size_t alignment, size_t num_bytes) override {
     void* ptr = nullptr;
     if (num_bytes > 0) {
-      ptr = stream_exec_->HostMemoryAllocate(num_bytes);
+      if (numa_affinity_) {
+        ptr = AllocOnNode(alignment, num_bytes);
+      }
+      if (ptr == nullptr) {
+        ptr = stream_exec_->HostMemoryAllocate(num_bytes);
+      }
       if (ptr == nullptr) {
         LOG(WARNING) << "could not allocate pinned host memory of size: "
                      << num_bytes;
@@ -53,13 +69,48 @@ class GpuHostAllocator : public SubAllocator {
   void Free(void* ptr, size_t num_bytes) override {
     if (ptr != nullptr) {
       VisitFree(ptr, numa_node_, num_bytes);
+      if (numa_affinity_ && FreeOnNode(ptr, num_bytes)) {
+        return;
+      }
       stream_exec_->HostMemoryDeallocate(ptr);
     }
   }
 
  private:
+  // Returns memory from numa_node_ registered with the GPU, or nullptr.
+  void* AllocOnNode(size_t alignment, size_t num_bytes) {
+    void* ptr = port::NUMAMalloc(numa_node_, num_bytes, alignment);
+    if (ptr == nullptr) return nullptr;
+    if (!stream_exec_->HostMemoryRegister(ptr, num_bytes)) {
+      LOG_FIRST_N(WARNING, 1) << "could not register host memory on NUMA node "
+                              << numa_node_ << " with the GPU";
+      port::NUMAFree(ptr, num_bytes);
+      return nullptr;
+    }
+    mutex_lock l(mu_);
+    registered_.insert(ptr);
+    return ptr;
+  }
+
+  // Frees `ptr` if it came from AllocOnNode.
+  bool FreeOnNode(void* ptr, size_t num_bytes) {
+    {
+      mutex_lock l(mu_);
+      if (registered_.erase(ptr) == 0) return false;
+    }
+    if (!stream_exec_->HostMemoryUnregister(ptr)) {
+      LOG(ERROR) << "could not unregister pinned host memory at " << ptr;
+    }
+    port::NUMAFree(ptr, num_bytes);
+    return true;
+  }
+
   se::StreamExecutor* stream_exec_;  // not owned, non-null
   const int numa_node_;
+  const bool numa_affinity_;
+
+  mutex mu_;
+  std::unordered_set<void*> registered_ GUARDED_BY(mu_);
 
   TF_DISALLOW_COPY_AND_ASSIGN(GpuHostAllocator);
 };
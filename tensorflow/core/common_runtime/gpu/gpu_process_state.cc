@@ -193,54 +193,41 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
       !process_state_->ProcessState::FLAGS_brain_mem_reg_gpu_dma) {
     return process_state_->GetCPUAllocator(numa_node);
   }
-  if (numa_node == port::kNUMANoAffinity) {
-    numa_node = 0;
-  }
   {
-    // Here we optimize the most common use case where gpu_host_allocators_
-    // have already been populated and since we're only reading
-    // these vectors, we can get by with a shared lock. In the slower case,
-    // we take a unique lock and populate these vectors.
+    // Here we optimize the most common use case where gpu_host_pool_ has
+    // already been created and since we're only reading it, we can get by
+    // with a shared lock. In the slower case, we take a unique lock and
+    // create the pool.
     tf_shared_lock lock(mu_);
 
     if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types &&
-        !gpu_host_allocators_.empty() &&
-        gpu_host_allocators_[0].recording_allocator != nullptr) {
-      return gpu_host_allocators_[0].recording_allocator.get();
+        gpu_host_recording_allocator_ != nullptr) {
+      return gpu_host_recording_allocator_.get();
     }
-    if (static_cast<int>(gpu_host_allocators_.size()) > numa_node) {
-      return gpu_host_allocators_[0].allocator.get();
+    if (gpu_host_pool_ != nullptr) {
+      return gpu_host_pool_->GetAllocator(numa_node);
     }
   }
 
   mutex_lock lock(mu_);
-  // Find the first valid StreamExecutor to request CUDA or ROCm host memory
-  // through, since any will work.
-  //
-  // This search isn't super clean, and it would be nice to use a
-  // better source of information about which executor to use.  For
-  // example, process_state could maybe save the first stream executor
-  // it knows is valid.
-  se::StreamExecutor* se = nullptr;
-  for (int i = 0; i < static_cast<int>(gpu_allocators_.size()); ++i) {
-    if (gpu_allocators_[i].allocator != nullptr) {
-      se = GpuIdUtil::ExecutorForTfGpuId(TfGpuId(i)).ValueOrDie();
-      break;
+  if (gpu_host_pool_ == nullptr) {
+    // Find the first valid StreamExecutor to request CUDA or ROCm host memory
+    // through, since any will work.
+    //
+    // This search isn't super clean, and it would be nice to use a
+    // better source of information about which executor to use.  For
+    // example, process_state could maybe save the first stream executor
+    // it knows is valid.
+    se::StreamExecutor* se = nullptr;
+    for (int i = 0; i < static_cast<int>(gpu_allocators_.size()); ++i) {
+      if (gpu_allocators_[i].allocator != nullptr) {
+        se = GpuIdUtil::ExecutorForTfGpuId(TfGpuId(i)).ValueOrDie();
+        break;
+      }
     }
-  }
 
-  CHECK_NE(nullptr, se);
+    CHECK_NE(nullptr, se);
 
-  while (static_cast<int>(gpu_host_allocators_.size()) <= numa_node) {
-    while (gpu_host_alloc_visitors_.size() <= numa_node) {
-      gpu_host_alloc_visitors_.push_back({});
-    }
-    while (gpu_host_free_visitors_.size() <= numa_node) {
-      gpu_host_free_visitors_.push_back({});
-    }
-    SubAllocator* sub_allocator =
-        new GpuHostAllocator(se, numa_node, gpu_host_alloc_visitors_[numa_node],
-                             gpu_host_free_visitors_[numa_node]);
     // TODO(zheng-xq): evaluate whether 64GB by default is the best choice.
     int64 gpu_host_mem_limit_in_mb = -1;
     Status status = ReadInt64FromEnvVar("TF_GPU_HOST_MEM_LIMIT_IN_MB",
@@ -251,36 +238,39 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     }
     int64 gpu_host_mem_limit = gpu_host_mem_limit_in_mb * (1LL << 20);
 
-    Allocator* allocator =
-        new BFCAllocator(sub_allocator, gpu_host_mem_limit,
-                         true /*allow_growth*/, "gpu_host_bfc" /*name*/);
+    // Visitors are copied per node, so that the pool can create the
+    // allocators of further nodes without holding mu_.
+    auto alloc_visitors = gpu_host_alloc_visitors_;
+    auto free_visitors = gpu_host_free_visitors_;
+    gpu_host_pool_ = process_state_->GetPinnedHostMemoryPool(
+        "gpu_host_bfc", gpu_host_mem_limit,
+        [se, alloc_visitors, free_visitors](int node, bool numa_affinity) {
+          auto visitors = [node](
+              const std::vector<std::vector<SubAllocator::Visitor>>& v) {
+            return node < static_cast<int>(v.size())
+                       ? v[node]
+                       : std::vector<SubAllocator::Visitor>();
+          };
+          return new GpuHostAllocator(se, node, visitors(alloc_visitors),
+                                      visitors(free_visitors),
+                                      numa_affinity);
+        });
 
-    if (LogMemory::IsEnabled() && !allocator->TracksAllocationSizes()) {
-      // Wrap the allocator to track allocation ids for better logging
-      // at the cost of performance.
-      allocator = new TrackingAllocator(allocator, true);
-    }
-    gpu_host_allocators_.push_back({std::unique_ptr<Allocator>(allocator),
-                                    std::unique_ptr<SharedCounter>(nullptr),
-                                    nullptr, sub_allocator,
-                                    std::unique_ptr<Allocator>(nullptr)});
-    AllocatorParts& allocator_parts = gpu_host_allocators_.back();
     if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types) {
       ProcessState::MemDesc md;
       md.loc = ProcessState::MemDesc::CPU;
       md.dev_index = 0;
       md.gpu_registered = true;
       md.nic_registered = false;
-      allocator_parts.recording_allocator.reset(
-          new internal::RecordingAllocator(&process_state_->mem_desc_map_,
-                                           allocator_parts.allocator.get(), md,
-                                           &mu_));
+      gpu_host_recording_allocator_.reset(new internal::RecordingAllocator(
+          &process_state_->mem_desc_map_, gpu_host_pool_->GetAllocator(0), md,
+          &mu_));
     }
   }
   if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types) {
-    return gpu_host_allocators_[0].recording_allocator.get();
+    return gpu_host_recording_allocator_.get();
   } else {
-    return gpu_host_allocators_[0].allocator.get();
+    return gpu_host_pool_->GetAllocator(numa_node);
   }
 }
 
@@ -305,7 +295,7 @@ void GPUProcessState::AddGpuHostAllocVisitor(
 #if (defined(GOOGLE_CUDA) && GOOGLE_CUDA) || \
     (defined(TENSORFLOW_USE_ROCM) && TENSORFLOW_USE_ROCM)
   mutex_lock lock(mu_);
-  CHECK(gpu_host_allocators_.empty())  // Crash OK
+  CHECK(gpu_host_pool_ == nullptr)  // Crash OK
       << "AddGpuHostAllocVisitor must be called before "
          "first call to GetGpuHostAllocator.";
   while (numa_node >= static_cast<int64>(gpu_host_alloc_visitors_.size())) {
@@ -320,7 +310,7 @@ void GPUProcessState::AddGpuHostFreeVisitor(
 #if (defined(GOOGLE_CUDA) && GOOGLE_CUDA) || \
     (defined(TENSORFLOW_USE_ROCM) && TENSORFLOW_USE_ROCM)
   mutex_lock lock(mu_);
-  CHECK(gpu_host_allocators_.empty())  // Crash OK
+  CHECK(gpu_host_pool_ == nullptr)  // Crash OK
       << "AddGpuHostFreeVisitor must be called before "
          "first call to GetGpuHostAllocator.";
   while (numa_node >= static_cast<int64>(gpu_host_free_visitors_.size())) {
@@ -339,7 +329,9 @@ void GPUProcessState::TestOnlyReset() {
     gpu_device_enabled_ = false;
     gpu_allocators_.clear();
     gpu_visitors_.clear();
-    gpu_host_allocators_.clear();
+    // The pool itself is owned by ProcessState.
+    gpu_host_pool_ = nullptr;
+    gpu_host_recording_allocator_.reset();
     gpu_host_alloc_visitors_.clear();
     gpu_host_free_visitors_.clear();
   }
@@ -89,6 +89,9 @@ class GPUProcessState {
     return gpu_allocators_.size();
   }
 
+  // Returns the allocator of pinned host memory for `numa_node`, from the
+  // "gpu_host_bfc" pool of ProcessState. Each NUMA node has its own
+  // allocator when NUMA allocators are enabled in ProcessState.
   virtual Allocator* GetGpuHostAllocator(int numa_node);
 
   // Registers a Visitor to be invoked on new chunks of memory allocated by the
@@ -150,7 +153,8 @@ class GPUProcessState {
   std::vector<AllocatorParts> gpu_allocators_ GUARDED_BY(mu_);
   std::vector<std::vector<SubAllocator::Visitor>> gpu_visitors_ GUARDED_BY(mu_);
 
-  std::vector<AllocatorParts> gpu_host_allocators_ GUARDED_BY(mu_);
+  PinnedHostMemoryPool* gpu_host_pool_ GUARDED_BY(mu_) = nullptr;
+  std::unique_ptr<Allocator> gpu_host_recording_allocator_ GUARDED_BY(mu_);
   std::vector<std::vector<SubAllocator::Visitor>> gpu_host_alloc_visitors_
       GUARDED_BY(mu_);
   std::vector<std::vector<SubAllocator::Visitor>> gpu_host_free_visitors_
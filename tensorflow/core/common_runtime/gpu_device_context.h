@@ -59,6 +59,16 @@ class GPUDeviceContext : public DeviceContext {
   }
   int stream_id() const { return stream_id_; }
 
+  // Compute streams of other stream groups that must finish the work already
+  // enqueued on them before kernels run on stream(), because it produced
+  // their inputs.
+  const gtl::InlinedVector<se::Stream*, 4>& wait_streams() const {
+    return wait_streams_;
+  }
+  void set_wait_streams(gtl::InlinedVector<se::Stream*, 4> wait_streams) {
+    wait_streams_ = std::move(wait_streams);
+  }
+
   void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
                              Tensor* device_tensor, StatusCallback done,
                              bool sync_dst_compute) const override;
@@ -92,6 +102,7 @@ class GPUDeviceContext : public DeviceContext {
   se::Stream* device_to_host_stream_;
   // Streams to use for copying data between GPUs.
   gtl::InlinedVector<se::Stream*, 4> device_to_device_stream_;
+  gtl::InlinedVector<se::Stream*, 4> wait_streams_;
 };
 
 }  // namespace tensorflow
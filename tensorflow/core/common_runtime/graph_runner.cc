@@ -94,6 +94,11 @@ class SimpleRendezvous : public RendezvousInterface {
 GraphRunner::GraphRunner(Env* env)
     : device_deleter_(NewSingleThreadedCpuDevice(env)),
       device_(device_deleter_.get()) {}
+GraphRunner::GraphRunner(Env* env,
+                         std::function<void(std::function<void()>)> runner)
+    : device_deleter_(NewSingleThreadedCpuDevice(env)),
+      device_(device_deleter_.get()),
+      runner_(std::move(runner)) {}
 GraphRunner::GraphRunner(Device* device) : device_(device) {}
 
 GraphRunner::~GraphRunner() {}
@@ -148,9 +153,12 @@ Status GraphRunner::Run(Graph* graph, FunctionLibraryRuntime* function_library,
   // Create the local executor and the Rendezvous for fetching back the
   // constants.
 
-  // Run operators on the local thread. We should not need concurrency here; we
-  // should not be running expensive operators.
-  auto runner = [](Executor::Args::Closure c) { c(); };
+  // Run operators on the local thread unless a runner was given. We should
+  // not need concurrency here; we should not be running expensive operators.
+  Executor::Args::Runner runner = runner_;
+  if (runner == nullptr) {
+    runner = [](Executor::Args::Closure c) { c(); };
+  }
 
   LocalExecutorParams params;
   // The ownership of the output tensors are bound to this device's lifetime.
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GRAPH_RUNNER_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GRAPH_RUNNER_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -42,6 +43,10 @@ class GraphRunner {
  public:
   // REQUIRES: `env` is not nullptr.
   GraphRunner(Env* env);
+  // Runs the expensive nodes of a graph with `runner` instead of inline on
+  // the calling thread, so that independent nodes can run in parallel.
+  // REQUIRES: `env` is not nullptr.
+  GraphRunner(Env* env, std::function<void(std::function<void()>)> runner);
   // REQUIRES: 'device' is not nullptr. Not owned.
   GraphRunner(Device* device);
   ~GraphRunner();
@@ -63,6 +68,7 @@ class GraphRunner {
  private:
   std::unique_ptr<Device> device_deleter_;
   Device* const device_;
+  const std::function<void(std::function<void()>)> runner_;
 };
 
 }  // namespace tensorflow
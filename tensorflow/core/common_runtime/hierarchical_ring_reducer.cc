@@ -0,0 +1,419 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_ring_reducer.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/ring_reducer.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+// Set true for greater intelligibility of debug mode log messages.
+#define READABLE_KEYS false
+
+namespace tensorflow {
+
+namespace {
+// Key to be used for BufRendezvous by HierarchicalRingReducer.  The
+// inter-task ring uses RingReduce keys under its own exec_key.
+string HierarchicalRingBufKey(const string& exec_key, const string& phase,
+                              int subdiv, int src_rank, int dst_rank) {
+  if (READABLE_KEYS) {
+    return strings::StrCat("hierarchical_reduce(", exec_key, "):", phase,
+                           ":subdiv(", subdiv, "):src(", src_rank, "):dst(",
+                           dst_rank, ")");
+  } else {
+    return strings::StrCat(exec_key, ":", phase, ":", subdiv, ":", src_rank,
+                           ":", dst_rank);
+  }
+}
+}  // namespace
+
+HierarchicalRingReducer::HierarchicalRingReducer()
+    : col_ctx_(nullptr), col_params_(nullptr) {}
+
+Status HierarchicalRingReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  CHECK_EQ(col_params->instance.type, REDUCTION_COLLECTIVE);
+  CHECK_EQ(col_params->instance.impl_details.collective_name,
+           "HierarchicalRingReduce");
+  const string& device_name =
+      col_params->instance.device_names[col_params->default_rank];
+  // Start by counting the devices in each task.
+  // Precondition: device_names must be sorted so that all devices in
+  // the same task are adjacent.
+  std::vector<int> dev_per_task;
+  const string* prior_task_name = &col_params->instance.task_names[0];
+  int dev_count = 1;
+  for (int di = 1; di < col_params->group.group_size; ++di) {
+    if (col_params->instance.task_names[di] != *prior_task_name) {
+      dev_per_task.push_back(dev_count);
+      dev_count = 1;
+      prior_task_name = &col_params->instance.task_names[di];
+    } else {
+      ++dev_count;
+    }
+  }
+  dev_per_task.push_back(dev_count);
+  CHECK_EQ(col_params->group.num_tasks, dev_per_task.size());
+
+  // If there is just 1 task, then the reduction happens within one subdiv of
+  // all devices.  Otherwise, the first subdiv is the inter-task ring, and then
+  // there are N more subdivs, where N is #task.
+  const int num_tasks = col_params->group.num_tasks;
+  const int num_subdivs = num_tasks + (num_tasks > 1 ? 1 : 0);
+  col_params->instance.impl_details.subdiv_permutations.resize(num_subdivs);
+  col_params->subdiv_rank.reserve(num_subdivs);
+
+  // Inter-task subdiv.  Pick device 0 of each task.  If a device does not
+  // participate in the subdiv, set subdiv_rank to -1.
+  if (num_tasks > 1) {
+    std::vector<int>& perm =
+        col_params->instance.impl_details.subdiv_permutations[0];
+    CHECK_EQ(perm.size(), 0);
+    int device_count = 0;
+    int subdiv_rank = -1;
+    for (int ti = 0; ti < num_tasks; ti++) {
+      perm.push_back(device_count);
+      if (col_params->instance.device_names[device_count] == device_name) {
+        subdiv_rank = ti;
+      }
+      device_count += dev_per_task[ti];
+    }
+    col_params->subdiv_rank.push_back(subdiv_rank);
+  }
+
+  // Intra-task subdivs.  Pick all devices in task ti for subdiv sdi.  If a
+  // device does not participate in the subdiv, set subdiv_rank to -1.
+  int abs_di = 0;
+  for (int ti = 0; ti < num_tasks; ti++) {
+    const int sdi = ti + (num_tasks > 1 ? 1 : 0);
+    std::vector<int>& perm =
+        col_params->instance.impl_details.subdiv_permutations[sdi];
+    CHECK_EQ(perm.size(), 0);
+    int subdiv_rank = -1;
+    for (int di = 0; di < dev_per_task[ti]; di++) {
+      perm.push_back(abs_di);
+      if (col_params->instance.device_names[abs_di] == device_name) {
+        subdiv_rank = di;
+      }
+      abs_di++;
+    }
+    col_params->subdiv_rank.push_back(subdiv_rank);
+  }
+
+  VLOG(2) << collective_util::SubdivPermDebugString(*col_params);
+  return Status::OK();
+}
+
+Status HierarchicalRingReducer::InitializeCollectiveContext(
+    CollectiveContext* col_ctx) {
+  CHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = &col_ctx->col_params;
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void HierarchicalRingReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  const int num_subdivs =
+      static_cast<int>(col_params_->instance.impl_details.subdiv_permutations
+                           .size());
+  const bool multi_task = col_params_->group.num_tasks > 1;
+  int task_subdiv = -1;
+  for (int sdi = multi_task ? 1 : 0; sdi < num_subdivs; ++sdi) {
+    if (col_params_->subdiv_rank[sdi] >= 0) {
+      task_subdiv = sdi;
+      break;
+    }
+  }
+  CHECK_GE(task_subdiv, 0);
+  const bool is_task_leader = col_params_->subdiv_rank[task_subdiv] == 0;
+  // The inter-task RingReducer unblocks the collectives that depend on this
+  // one on behalf of the first device of each task, so that they are not
+  // unblocked twice for that device.
+  const bool runs_ring = multi_task && is_task_leader &&
+                         col_params_->instance.shape.num_elements() > 0;
+  if (!runs_ring) {
+    col_ctx_->col_exec->UnblockDependencies(*col_params_);
+  }
+
+  // Start by copying input to output if they're not already the same, i.e. if
+  // we're not computing in-place on the input tensor.
+  Status status;
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    Notification note;
+    profiler::TraceMe activity("MemCpyAsync", profiler::TraceMeLevel::kInfo);
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+  }
+  if (col_params_->instance.shape.num_elements() == 0) {
+    // Nothing to reduce.
+    done(status);
+    return;
+  }
+
+  if (status.ok()) status = ReduceInTask(task_subdiv);
+  if (is_task_leader) {
+    if (runs_ring) {
+      if (status.ok()) {
+        status = ReduceAcrossTasks();
+      } else {
+        col_ctx_->col_exec->UnblockDependencies(*col_params_);
+      }
+    }
+    if (status.ok()) status = Finalize();
+  }
+  if (status.ok()) status = BroadcastInTask(task_subdiv);
+  if (!status.ok()) {
+    // Abort the sends and receives of the other devices, which would
+    // otherwise wait for this one forever.
+    LOG(ERROR) << "Aborting HierarchicalRingReduce with " << status;
+    col_ctx_->col_exec->StartAbort(status);
+  }
+  done(status);
+}
+
+Status HierarchicalRingReducer::ReduceInTask(int subdiv) {
+  const int num_devices = static_cast<int>(
+      col_params_->instance.impl_details.subdiv_permutations[subdiv].size());
+  const int rank = col_params_->subdiv_rank[subdiv];
+  if (num_devices == 1) return Status::OK();
+  if (rank != 0) {
+    Notification note;
+    Status status;
+    DispatchSend("reduce", subdiv, rank, 0, col_ctx_->output,
+                 [&note, &status](const Status& s) {
+                   status = s;
+                   note.Notify();
+                 });
+    note.WaitForNotification();
+    return status;
+  }
+
+  // Receive the values of all other devices of this task in parallel, then
+  // merge them into the output in rank order.
+  Allocator* allocator =
+      col_ctx_->device->GetAllocator(col_ctx_->op_ctx->output_alloc_attr(0));
+  std::vector<Tensor> values;
+  values.reserve(num_devices - 1);
+  std::vector<Status> statuses(num_devices - 1);
+  BlockingCounter pending(num_devices - 1);
+  for (int src_rank = 1; src_rank < num_devices; ++src_rank) {
+    values.emplace_back(allocator, col_ctx_->output->dtype(),
+                        col_ctx_->output->shape());
+    Status* status = &statuses[src_rank - 1];
+    DispatchRecv("reduce", subdiv, src_rank, 0, &values.back(),
+                 [status, &pending](const Status& s) {
+                   *status = s;
+                   pending.DecrementCount();
+                 });
+  }
+  pending.Wait();
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  for (Tensor& value : values) {
+    TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+        col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+        col_params_->merge_op.get(), col_ctx_->output, &value));
+  }
+  return Status::OK();
+}
+
+Status HierarchicalRingReducer::ReduceAcrossTasks() {
+  const CollectiveParams& cp = *col_params_;
+  const std::vector<int>& perm = cp.instance.impl_details.subdiv_permutations[0];
+  CollectiveParams ring_params;
+  ring_params.name = cp.name;
+  ring_params.group = cp.group;
+  ring_params.group.group_size = cp.group.num_tasks;
+  ring_params.instance.instance_key = cp.instance.instance_key;
+  ring_params.instance.type = REDUCTION_COLLECTIVE;
+  ring_params.instance.data_type = cp.instance.data_type;
+  ring_params.instance.shape = cp.instance.shape;
+  ring_params.instance.num_devices_per_task = cp.instance.num_devices_per_task;
+  ring_params.instance.impl_details.collective_name = "RingReduce";
+  for (int di : perm) {
+    ring_params.instance.device_names.push_back(cp.instance.device_names[di]);
+    ring_params.instance.task_names.push_back(cp.instance.task_names[di]);
+    ring_params.task.is_local.push_back(cp.task.is_local[di]);
+  }
+  ring_params.default_rank = cp.subdiv_rank[0];
+  // The ring borrows the merge op.  The final op is left to Finalize(), since
+  // it must see the size of the whole group rather than the number of tasks.
+  ring_params.merge_op.reset(cp.merge_op.get());
+  auto release_merge_op =
+      gtl::MakeCleanup([&ring_params] { ring_params.merge_op.release(); });
+
+  RingReducer ring;
+  // Neither can fail, since the tensor is not empty and this device was
+  // already found by InitializeCollectiveContext().  Failing would also leave
+  // `ring` waiting in its destructor for a Run() that never happened.
+  TF_CHECK_OK(ring.InitializeCollectiveParams(&ring_params));
+  CollectiveContext ring_ctx(
+      col_ctx_->col_exec, col_ctx_->dev_mgr, col_ctx_->op_ctx,
+      col_ctx_->op_params, ring_params,
+      strings::StrCat(col_ctx_->exec_key, ":ring"), col_ctx_->step_id,
+      col_ctx_->output, col_ctx_->output);
+  TF_CHECK_OK(ring.InitializeCollectiveContext(&ring_ctx));
+  Status status;
+  // RingReducer::Run() runs to completion in this thread.
+  ring.Run([&status](const Status& s) { status = s; });
+  return status;
+}
+
+Status HierarchicalRingReducer::Finalize() {
+  if (!col_params_->final_op) return Status::OK();
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  std::unique_ptr<CollectiveAdapter> ca(
+      MakeCollectiveAdapter(col_ctx_->output, 1,
+                            col_ctx_->device->GetAllocator(attr),
+                            /*align_chunks=*/false));
+  Tensor group_size_val = ca->Scalar(col_params_->group.group_size);
+  Tensor group_size_tensor;
+  Status status;
+  if (col_params_->group.device_type != "CPU") {
+    group_size_tensor = ca->Scalar(
+        col_ctx_->device->GetAllocator(col_ctx_->op_ctx->input_alloc_attr(0)),
+        AllocationAttributes());
+    Notification note;
+    col_ctx_->op_ctx->op_device_context()->CopyCPUTensorToDevice(
+        &group_size_val, col_ctx_->device, &group_size_tensor,
+        [&note, &status](const Status& s) {
+          status = s;
+          note.Notify();
+        });
+    note.WaitForNotification();
+  } else {
+    group_size_tensor = group_size_val;
+  }
+  if (status.ok()) {
+    Tensor value = ca->ChunkAlias(0);
+    status = collective_util::ComputeBinOp(
+        col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+        col_params_->final_op.get(), &value, &group_size_tensor);
+  }
+  ca->ConsumeFinalValue(col_ctx_->output);
+  return status;
+}
+
+Status HierarchicalRingReducer::BroadcastInTask(int subdiv) {
+  const int num_devices = static_cast<int>(
+      col_params_->instance.impl_details.subdiv_permutations[subdiv].size());
+  const int rank = col_params_->subdiv_rank[subdiv];
+  if (num_devices == 1) return Status::OK();
+  if (rank != 0) {
+    Notification note;
+    Status status;
+    DispatchRecv("broadcast", subdiv, 0, rank, col_ctx_->output,
+                 [&note, &status](const Status& s) {
+                   status = s;
+                   note.Notify();
+                 });
+    note.WaitForNotification();
+    return status;
+  }
+  std::vector<Status> statuses(num_devices - 1);
+  BlockingCounter pending(num_devices - 1);
+  for (int dst_rank = 1; dst_rank < num_devices; ++dst_rank) {
+    Status* status = &statuses[dst_rank - 1];
+    DispatchSend("broadcast", subdiv, 0, dst_rank, col_ctx_->output,
+                 [status, &pending](const Status& s) {
+                   *status = s;
+                   pending.DecrementCount();
+                 });
+  }
+  pending.Wait();
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  return Status::OK();
+}
+
+void HierarchicalRingReducer::DispatchSend(const string& phase, int subdiv,
+                                           int src_rank, int dst_rank,
+                                           const Tensor* src_tensor,
+                                           const StatusCallback& done) {
+  string send_buf_key = HierarchicalRingBufKey(col_ctx_->exec_key, phase,
+                                               subdiv, src_rank, dst_rank);
+  int dst_idx =
+      col_params_->instance.impl_details.subdiv_permutations[subdiv][dst_rank];
+  VLOG(3) << "DispatchSend " << send_buf_key << " from_device "
+          << col_ctx_->device_name << " to_device "
+          << col_params_->instance.device_names[dst_idx];
+  col_ctx_->col_exec->PostToPeer(col_params_->instance.device_names[dst_idx],
+                                 col_params_->instance.task_names[dst_idx],
+                                 send_buf_key, col_ctx_->device,
+                                 col_ctx_->op_ctx->op_device_context(),
+                                 col_ctx_->op_ctx->output_alloc_attr(0),
+                                 src_tensor, col_ctx_->device_locality, done);
+}
+
+void HierarchicalRingReducer::DispatchRecv(const string& phase, int subdiv,
+                                           int src_rank, int dst_rank,
+                                           Tensor* dst_tensor,
+                                           const StatusCallback& done) {
+  string recv_buf_key = HierarchicalRingBufKey(col_ctx_->exec_key, phase,
+                                               subdiv, src_rank, dst_rank);
+  int src_idx =
+      col_params_->instance.impl_details.subdiv_permutations[subdiv][src_rank];
+  VLOG(3) << "DispatchRecv " << recv_buf_key << " from_device "
+          << col_params_->instance.device_names[src_idx] << " to_device "
+          << col_ctx_->device_name;
+  col_ctx_->col_exec->RecvFromPeer(
+      col_params_->instance.device_names[src_idx],
+      col_params_->instance.task_names[src_idx],
+      col_params_->task.is_local[src_idx], recv_buf_key, col_ctx_->device,
+      col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), dst_tensor,
+      col_ctx_->device_locality, 0 /*stream_index*/, done);
+}
+
+REGISTER_COLLECTIVE(HierarchicalRingReduce, HierarchicalRingReducer);
+
+}  // namespace tensorflow
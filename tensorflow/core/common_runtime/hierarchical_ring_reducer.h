@@ -0,0 +1,89 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+
+namespace tensorflow {
+
+// Hierarchical implementation of collective all-reduce.  The devices of each
+// task first reduce into the first device of the task over local copies, the
+// first devices of all tasks then all-reduce with a ring, and finally each of
+// them broadcasts the result to the other devices of its task.  Compared to
+// RingReduce over all devices, each task sends and receives each chunk of the
+// tensor over the network 2(n-1) times for n tasks instead of n devices.
+class HierarchicalRingReducer : public CollectiveImplementationInterface {
+ public:
+  HierarchicalRingReducer();
+  ~HierarchicalRingReducer() override = default;
+
+  // Establishes the subdiv permutations needed for a hierarchical reduction.
+  // If all devices are local, establishes a single subdiv comprising all
+  // devices.  If any devices are on a different task, establishes n+1 subdivs
+  // for n tasks.
+  // The first subdiv comprises the first device of each task, which runs the
+  // inter-task ring.  Subdiv i+1 comprises the devices of task i, whose first
+  // device reduces and broadcasts the values of that task.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  Status InitializeCollectiveContext(CollectiveContext* col_ctx) override;
+
+  // No-op for hierarchical ring reducer.
+  Status InitializeCollectiveGroupRuntimeDetails(
+      CollGroupRuntimeDetails*) override {
+    return Status::OK();
+  }
+
+  // Begins async execution of the hierarchical ring reduction.
+  // Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+ private:
+  // Reduces the values of all devices of this task into the output of its
+  // first device, whose rank in `subdiv` is 0.
+  Status ReduceInTask(int subdiv);
+
+  // Runs a RingReduce of the outputs of the first devices of all tasks.
+  Status ReduceAcrossTasks();
+
+  // Applies the final op of the reduction to the output.
+  Status Finalize();
+
+  // Broadcasts the output of the first device of this task to the other
+  // devices of `subdiv`.
+  Status BroadcastInTask(int subdiv);
+
+  // Sends `src_tensor` from this device to the device at `dst_rank` in
+  // `subdiv`, in the given phase of the algorithm.
+  void DispatchSend(const string& phase, int subdiv, int src_rank,
+                    int dst_rank, const Tensor* src_tensor,
+                    const StatusCallback& done);
+
+  // Receives into `dst_tensor` at this device the value sent by the device at
+  // `src_rank` in `subdiv`, in the given phase of the algorithm.
+  void DispatchRecv(const string& phase, int subdiv, int src_rank,
+                    int dst_rank, Tensor* dst_tensor,
+                    const StatusCallback& done);
+
+  CollectiveContext* col_ctx_;          // Not owned
+  const CollectiveParams* col_params_;  // Not owned
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
@@ -0,0 +1,246 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_ring_reducer.h"
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/device_resolver_local.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/test_collective_executor_mgr.h"
+#include "tensorflow/core/common_runtime/threadpool_device.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/unbounded_work_queue.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+static int64 kStepId = 123;
+
+std::unique_ptr<OpKernel> GetKernel(const NodeDef& node, DeviceBase* device) {
+  Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      DEVICE_CPU, device, device->GetAllocator(AllocatorAttributes()), node,
+      TF_GRAPH_DEF_VERSION, &status);
+  if (!status.ok()) {
+    LOG(FATAL) << status;
+  }
+  return k;
+}
+
+std::unique_ptr<OpKernel> GetBinOp(const string& op, DataType dtype,
+                                   DeviceBase* device) {
+  NodeDef node_def;
+  NodeDefBuilder builder(strings::StrCat(op, "_node"), op);
+  TF_CHECK_OK(builder.Attr("T", dtype)
+                  .Input(FakeInput(dtype))
+                  .Input(FakeInput(dtype))
+                  .Finalize(&node_def));
+  return GetKernel(node_def, device);
+}
+
+CollectiveParams SetUpCollectiveParams(int num_tasks, int num_devs_per_task) {
+  CollectiveParams cp;
+  const int kNumDevs = num_tasks * num_devs_per_task;
+  cp.name = "test_collective";
+  cp.group.group_key = 5;
+  cp.group.group_size = kNumDevs;
+  cp.group.device_type = DEVICE_CPU;
+  cp.group.num_tasks = num_tasks;
+  cp.instance.instance_key = 17;
+  cp.instance.type = REDUCTION_COLLECTIVE;
+  cp.instance.data_type = DT_FLOAT;
+  cp.instance.impl_details.collective_name = "HierarchicalRingReduce";
+  for (int ti = 0; ti < num_tasks; ++ti) {
+    string task_name = strings::StrCat("/job:worker/replica:0/task:", ti);
+    cp.instance.num_devices_per_task[task_name] = num_devs_per_task;
+    for (int di = 0; di < num_devs_per_task; ++di) {
+      cp.instance.task_names.push_back(task_name);
+      cp.instance.device_names.push_back(
+          strings::StrCat(task_name, "/device:CPU:", di));
+      // This test runs in a single process so is_local is always true.
+      cp.task.is_local.push_back(true);
+    }
+  }
+  return cp;
+}
+
+class HierarchicalRingReducerTest : public ::testing::Test {
+ protected:
+  ~HierarchicalRingReducerTest() override {
+    if (col_exec_) col_exec_->Unref();
+  }
+
+  void Init(int num_tasks, int num_devs_per_task, int tensor_len) {
+    std::vector<std::unique_ptr<Device>> devices;
+    SessionOptions sess_opts;
+    sess_opts.env = Env::Default();
+    for (int ti = 0; ti < num_tasks; ++ti) {
+      for (int di = 0; di < num_devs_per_task; ++di) {
+        devices.push_back(absl::make_unique<ThreadPoolDevice>(
+            sess_opts,
+            strings::StrCat("/job:worker/replica:0/task:", ti, "/cpu:", di),
+            Bytes(4 << 20), DeviceLocality(), cpu_allocator()));
+      }
+    }
+    dev_mgr_ = absl::make_unique<StaticDeviceMgr>(std::move(devices));
+    dev_resolver_ = absl::make_unique<DeviceResolverLocal>(dev_mgr_.get());
+    work_queue_ = std::make_shared<UnboundedWorkQueue>(Env::Default(), "test");
+    rma_ = new CollectiveRemoteAccessLocal(dev_mgr_.get(), dev_resolver_.get(),
+                                           work_queue_, kStepId);
+    col_exec_ = new BaseCollectiveExecutor(&col_exec_mgr_, rma_, kStepId,
+                                           dev_mgr_.get(), &gpu_ring_order_);
+    col_params_ = SetUpCollectiveParams(num_tasks, num_devs_per_task);
+    col_params_.instance.shape = TensorShape({tensor_len});
+    instances_.resize(col_params_.group.group_size);
+  }
+
+  // Runs the reduction on every device, where device d contributes
+  // d * 10 + i at index i, and checks that all of them get the mean.
+  void RunTest(int num_tasks, int num_devs_per_task, int tensor_len) {
+    Init(num_tasks, num_devs_per_task, tensor_len);
+    const int group_size = col_params_.group.group_size;
+    std::atomic<int> done(0);
+    for (int rank = 0; rank < group_size; ++rank) {
+      SchedClosure([this, rank, tensor_len, &done] {
+        DoReduce(rank, tensor_len);
+        ++done;
+      });
+    }
+    while (done < group_size) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    for (int rank = 0; rank < group_size; ++rank) {
+      TF_EXPECT_OK(instances_[rank].status);
+      auto values = instances_[rank].tensor.flat<float>();
+      for (int i = 0; i < tensor_len; ++i) {
+        const float expected = (group_size - 1) * 5.0f + i;
+        EXPECT_FLOAT_EQ(expected, values(i))
+            << "Mismatch at rank " << rank << " index " << i;
+      }
+    }
+  }
+
+  void DoReduce(int rank, int tensor_len) {
+    Instance* instance = &instances_[rank];
+    Device* device = nullptr;
+    TF_CHECK_OK(dev_mgr_->LookupDevice(
+        col_params_.instance.device_names[rank], &device));
+    instance->tensor = Tensor(device->GetAllocator(AllocatorAttributes()),
+                              DT_FLOAT, TensorShape({tensor_len}));
+    for (int i = 0; i < tensor_len; ++i) {
+      instance->tensor.flat<float>()(i) = rank * 10 + i;
+    }
+
+    CollectiveParams cp;
+    cp.name = col_params_.name;
+    cp.group = col_params_.group;
+    cp.instance = col_params_.instance;
+    cp.task = col_params_.task;
+    cp.default_rank = rank;
+    HierarchicalRingReducer reducer;
+    TF_CHECK_OK(reducer.InitializeCollectiveParams(&cp));
+    cp.merge_op = GetBinOp("Add", DT_FLOAT, device);
+    cp.final_op = GetBinOp("Div", DT_FLOAT, device);
+
+    OpKernelContext::Params op_params;
+    op_params.step_id = kStepId;
+    op_params.device = device;
+    gtl::InlinedVector<TensorValue, 4> inputs;
+    inputs.push_back(TensorValue(&instance->tensor));
+    op_params.inputs = &inputs;
+    gtl::InlinedVector<AllocatorAttributes, 4> input_aa(
+        {AllocatorAttributes()});
+    op_params.input_alloc_attrs = &input_aa;
+    DeviceContext* dev_ctx = new DeviceContext;
+    op_params.op_device_context = dev_ctx;
+    int forward_from = 0;
+    op_params.forward_from_array = &forward_from;
+    AllocatorAttributes generic_alloc_attr;
+    op_params.output_attr_array = &generic_alloc_attr;
+    op_params.op_kernel = cp.merge_op.get();
+    OpKernelContext ctx(&op_params, 1);
+
+    string exec_key = strings::StrCat(cp.instance.instance_key, ":0:0");
+    CollectiveContext col_ctx(col_exec_, dev_mgr_.get(), &ctx, &op_params, cp,
+                              exec_key, kStepId, &instance->tensor,
+                              &instance->tensor);
+    TF_CHECK_OK(reducer.InitializeCollectiveContext(&col_ctx));
+    reducer.Run([instance](const Status& s) { instance->status = s; });
+    dev_ctx->Unref();
+  }
+
+  struct Instance {
+    Tensor tensor;
+    Status status;
+  };
+
+  TestCollectiveExecutorMgr col_exec_mgr_;
+  CollectiveExecutor* col_exec_ = nullptr;
+  CollectiveRemoteAccessLocal* rma_;
+  std::unique_ptr<DeviceMgr> dev_mgr_;
+  std::unique_ptr<DeviceResolverLocal> dev_resolver_;
+  std::shared_ptr<UnboundedWorkQueue> work_queue_;
+  string gpu_ring_order_;
+  CollectiveParams col_params_;
+  std::vector<Instance> instances_;
+};
+
+TEST_F(HierarchicalRingReducerTest, InitializeParams) {
+  CollectiveParams cp = SetUpCollectiveParams(3, 2);
+  cp.default_rank = 3;
+  HierarchicalRingReducer reducer;
+  TF_ASSERT_OK(reducer.InitializeCollectiveParams(&cp));
+  const std::vector<std::vector<int>> expected_perms = {
+      {0, 2, 4}, {0, 1}, {2, 3}, {4, 5}};
+  EXPECT_EQ(expected_perms, cp.instance.impl_details.subdiv_permutations);
+  const std::vector<int> expected_ranks = {-1, -1, 1, -1};
+  EXPECT_EQ(expected_ranks, cp.subdiv_rank);
+}
+
+TEST_F(HierarchicalRingReducerTest, InitializeParamsSingleTask) {
+  CollectiveParams cp = SetUpCollectiveParams(1, 4);
+  cp.default_rank = 0;
+  HierarchicalRingReducer reducer;
+  TF_ASSERT_OK(reducer.InitializeCollectiveParams(&cp));
+  const std::vector<std::vector<int>> expected_perms = {{0, 1, 2, 3}};
+  EXPECT_EQ(expected_perms, cp.instance.impl_details.subdiv_permutations);
+  const std::vector<int> expected_ranks = {0};
+  EXPECT_EQ(expected_ranks, cp.subdiv_rank);
+}
+
+TEST_F(HierarchicalRingReducerTest, Tasks1Devices4) { RunTest(1, 4, 1001); }
+
+TEST_F(HierarchicalRingReducerTest, Tasks2Devices1) { RunTest(2, 1, 1001); }
+
+TEST_F(HierarchicalRingReducerTest, Tasks2Devices4) { RunTest(2, 4, 4096); }
+
+TEST_F(HierarchicalRingReducerTest, Tasks4Devices3) { RunTest(4, 3, 9408); }
+
+TEST_F(HierarchicalRingReducerTest, Tasks3Devices2Len1) { RunTest(3, 2, 1); }
+
+}  // namespace
+}  // namespace tensorflow
@@ -84,13 +84,16 @@ struct LocalDevice::EigenThreadPoolInfo {
         intra_op_parallelism_threads = port::MaxParallelism(numa_node);
       }
     }
-    ThreadOptions thread_opts;
-    thread_opts.numa_node = numa_node;
+    const ThreadPoolPolicyProto& policy =
+        options.config.experimental().intra_op_thread_pool_policy();
+    ThreadOptions thread_opts = ThreadOptionsFromPolicy(policy);
+    if (numa_node != port::kNUMANoAffinity) {
+      thread_opts.numa_node = numa_node;
+    }
     eigen_worker_threads_.num_threads = intra_op_parallelism_threads;
     eigen_worker_threads_.workers = new thread::ThreadPool(
         options.env, thread_opts, strings::StrCat("numa_", numa_node, "_Eigen"),
-        intra_op_parallelism_threads,
-        !options.config.experimental().disable_thread_spinning(),
+        intra_op_parallelism_threads, ThreadSpinningFromPolicy(options, policy),
         /*allocator=*/nullptr);
     Eigen::ThreadPoolInterface* threadpool =
         eigen_worker_threads_.workers->AsEigenThreadPool();
@@ -24,6 +24,10 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_node_util.h"
 #include "tensorflow/core/public/session_options.h"
+#ifdef TENSORFLOW_USE_VE
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
+#endif
 
 namespace tensorflow {
 
@@ -56,6 +60,23 @@ bool CheckStringAttr(const Node* n, absl::string_view attr_name) {
   return found && !match.empty();
 }
 
+#ifdef TENSORFLOW_USE_VE
+// With TF_VE_SPECULATIVE_WHILE the VE WhileOp overlaps the predicate copy
+// with the next iteration, which needs StatelessWhile to stay functional
+// unless it is requested on another device.
+bool KeepFunctionalWhileForVE(const Node* n) {
+  static const bool speculate = [] {
+    bool v;
+    ReadBoolFromEnvVar("TF_VE_SPECULATIVE_WHILE", false, &v).IgnoreError();
+    return v;
+  }();
+  if (!speculate || n->type_string() != "StatelessWhile") return false;
+  DeviceNameUtils::ParsedName parsed;
+  return !DeviceNameUtils::ParseFullName(n->requested_device(), &parsed) ||
+         !parsed.has_type || parsed.type == DEVICE_VE;
+}
+#endif  // TENSORFLOW_USE_VE
+
 bool LowerUsingSwitchMergeIsOn(const Node* n) {
   return CheckBoolAttr(n, kLowerUsingSwitchMergeAttr);
 }
@@ -167,6 +188,9 @@ Status LowerFunctionalOpsPass::Run(
       TF_RETURN_IF_ERROR(RewriteCaseNode(n, g, keep_lowered_nodes_fetchable));
 
     } else if (n->IsWhileNode() && lower_control_flow(n)) {
+#ifdef TENSORFLOW_USE_VE
+      if (KeepFunctionalWhileForVE(n)) continue;
+#endif
       TF_RETURN_IF_ERROR(RewriteWhileNode(n, g, keep_lowered_nodes_fetchable));
 
     } else {
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
 
 namespace tensorflow {
@@ -61,6 +62,22 @@ auto* graph_unused_outputs = monitoring::Counter<1>::New(
 auto* tf_data_autotune_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/autotune", "tf.data autotuning", "name");
 
+auto* tf_data_autotune_parameter_gauge = monitoring::Gauge<int64, 2>::New(
+    "/tensorflow/data/autotune/parameter",
+    "The latest value chosen by tf.data autotuning for a tunable parameter.",
+    "name", "parameter");
+
+auto* tf_data_autotune_node_gauge = monitoring::Gauge<int64, 2>::New(
+    "/tensorflow/data/autotune/node",
+    "The per-element processing time (in nanoseconds) and buffer occupancy of "
+    "tf.data input pipeline nodes observed by autotuning.",
+    "name", "statistic");
+
+auto* tf_data_autotune_bottleneck_gauge = monitoring::Gauge<string, 0>::New(
+    "/tensorflow/data/autotune/bottleneck",
+    "The tf.data input pipeline node that spends the most processing time per "
+    "element.");
+
 auto* tf_data_bytes_read_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/bytes_read",
     "The number of bytes read by tf.data Dataset sources.", "name");
@@ -120,12 +137,50 @@ auto* mlir_import_failure_count = monitoring::Counter<0>::New(
     "/tensorflow/mlir/import_failure_count",
     "The number of jobs that failed during mlir import or verification.");
 
+auto* mkl_primitive_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/mkl_primitive_cache_lookups",
+    "The number of lookups of MKL-DNN primitives in the primitive cache, "
+    "by whether the primitive was found (hit) or had to be created (miss).",
+    "result");
+
+auto* function_graph_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/function_graph_cache_lookups",
+    "The number of lookups of optimized function bodies in the function graph "
+    "cache, by whether the body was found (hit) or had to be optimized (miss).",
+    "result");
+
+auto* constant_folding_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/constant_folding_cache_lookups",
+    "The number of lookups of evaluated constant graphs in the constant "
+    "folding cache, by whether the outputs were found (hit) or had to be "
+    "computed (miss).",
+    "result");
+
 }  // namespace
 
 void RecordTFDataAutotune(const string& name) {
   tf_data_autotune_counter->GetCell(name)->IncrementBy(1);
 }
 
+void RecordTFDataAutotuneParameter(const string& name,
+                                   const string& parameter, int64 value) {
+  tf_data_autotune_parameter_gauge->GetCell(name, parameter)->Set(value);
+}
+
+void RecordTFDataNodeStats(const string& name, int64 processing_time_ns,
+                           int64 buffered_elements, int64 buffered_bytes) {
+  tf_data_autotune_node_gauge->GetCell(name, "processing_time_ns")
+      ->Set(processing_time_ns);
+  tf_data_autotune_node_gauge->GetCell(name, "buffered_elements")
+      ->Set(buffered_elements);
+  tf_data_autotune_node_gauge->GetCell(name, "buffered_bytes")
+      ->Set(buffered_bytes);
+}
+
+void RecordTFDataBottleneck(const string& name) {
+  tf_data_autotune_bottleneck_gauge->GetCell()->Set(name);
+}
+
 void RecordTFDataBytesRead(const string& name, int64 num_bytes) {
   tf_data_bytes_read_counter->GetCell(name)->IncrementBy(num_bytes);
 }
@@ -234,5 +289,23 @@ void RecordUnusedOutput(const string& op_name) {
   graph_unused_outputs->GetCell(op_name)->IncrementBy(1);
 }
 
+void RecordMklPrimitiveCacheLookup(bool hit) {
+  static auto* hit_cell = mkl_primitive_cache_lookups->GetCell("hit");
+  static auto* miss_cell = mkl_primitive_cache_lookups->GetCell("miss");
+  (hit ? hit_cell : miss_cell)->IncrementBy(1);
+}
+
+void RecordFunctionGraphCacheLookup(bool hit) {
+  static auto* hit_cell = function_graph_cache_lookups->GetCell("hit");
+  static auto* miss_cell = function_graph_cache_lookups->GetCell("miss");
+  (hit ? hit_cell : miss_cell)->IncrementBy(1);
+}
+
+void RecordConstantFoldingCacheLookup(bool hit) {
+  static auto* hit_cell = constant_folding_cache_lookups->GetCell("hit");
+  static auto* miss_cell = constant_folding_cache_lookups->GetCell("miss");
+  (hit ? hit_cell : miss_cell)->IncrementBy(1);
+}
+
 }  // namespace metrics
 }  // namespace tensorflow
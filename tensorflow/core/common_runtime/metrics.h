@@ -26,6 +26,24 @@ namespace metrics {
 // The `name` argument identifies the Dataset type (e.g. "ParallelMap").
 void RecordTFDataAutotune(const string& name);
 
+// Records the value that autotuning chose for a tunable parameter.
+//
+// The `name` argument identifies the input pipeline node (e.g.
+// "ParallelMap(id:3)") and `parameter` the parameter (e.g. "parallelism").
+void RecordTFDataAutotuneParameter(const string& name,
+                                   const string& parameter, int64 value);
+
+// Records the per-element processing time (in nanoseconds) and the buffer
+// occupancy of an input pipeline node observed by autotuning.
+//
+// The `name` argument identifies the input pipeline node (e.g. "Map(id:2)").
+void RecordTFDataNodeStats(const string& name, int64 processing_time_ns,
+                           int64 buffered_elements, int64 buffered_bytes);
+
+// Records the input pipeline node that autotuning last found to spend the most
+// processing time per element.
+void RecordTFDataBottleneck(const string& name);
+
 // Records the number of bytes read from the filesystem by a tf.data.Dataset
 // source.
 //
@@ -98,6 +116,18 @@ void UpdateXlaCompilationTime(const uint64 compilation_time_usecs);
 // Increment the number of jobs that failed during import to mlir.
 void IncrementMLIRImportFailureCount();
 
+// Records a lookup of an MKL-DNN primitive in the primitive cache of the MKL
+// kernels, and whether the cached primitive was found.
+void RecordMklPrimitiveCacheLookup(bool hit);
+
+// Records a lookup of an optimized function body in the process-wide function
+// graph cache, and whether the body was found.
+void RecordFunctionGraphCacheLookup(bool hit);
+
+// Records a lookup of an evaluated constant graph in the process-wide constant
+// folding cache, and whether its outputs were found.
+void RecordConstantFoldingCacheLookup(bool hit);
+
 }  // namespace metrics
 }  // namespace tensorflow
 
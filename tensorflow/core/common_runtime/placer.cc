@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/graph_node_util.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/port.h"
 
@@ -171,12 +172,15 @@ Status Placer::Run() {
     }
   }
 
+  Env* env = Env::Default();
+  const uint64 start_micros = env->NowMicros();
   FunctionStack stack(function_name_);
   ColocationGraph colocation_graph(graph_, stack, flib_def_, devices_,
                                    default_local_device_, allow_soft_placement_,
                                    log_device_placement_);
 
   TF_RETURN_IF_ERROR(colocation_graph.Initialize());
+  const uint64 colocation_micros = env->NowMicros();
 
   // For each node, assign a device based on the constraints in the disjoint
   // node set.
@@ -247,6 +251,8 @@ Status Placer::Run() {
                                     log_device_placement_));
   }
 
+  const uint64 first_pass_micros = env->NowMicros();
+
   // Perform a second pass assignment for those nodes explicitly
   // skipped during the first pass.
   for (Node* node : second_pass) {
@@ -287,6 +293,14 @@ Status Placer::Run() {
                                     log_device_placement_));
   }
 
+  const uint64 end_micros = env->NowMicros();
+  VLOG(1) << "Placed " << graph_->num_op_nodes() << " nodes in "
+          << end_micros - start_micros << "us: colocation graph "
+          << colocation_micros - start_micros << "us, first pass "
+          << first_pass_micros - colocation_micros << "us, second pass ("
+          << second_pass.size() << " nodes) "
+          << end_micros - first_pass_micros << "us";
+
   if (VLOG_IS_ON(3)) {
     DumpGraphToFile("placer_output", *graph_, nullptr);
     DumpColocationGraph("colocation_graph", colocation_graph);
@@ -201,6 +201,12 @@ REGISTER_KERNEL_BUILDER(Name("TestXlaOp").Device("XLA_CPU").Priority(2),
 REGISTER_KERNEL_BUILDER(Name("TestXlaOp").Device("FakeCPU").Priority(1),
                         DummyOp);
 
+REGISTER_OP("TestTypedOutput").Output("a: T").Attr("T: type");
+REGISTER_KERNEL_BUILDER(Name("TestTypedOutput").Device("FakeCPU"), DummyOp);
+REGISTER_KERNEL_BUILDER(
+    Name("TestTypedOutput").Device("FakeGPU").TypeConstraint<float>("T"),
+    DummyOp);
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // A PlacerTest method has three phases:
@@ -415,6 +421,30 @@ TEST_F(PlacerTest, TestNoConstraints) {
   EXPECT_DEVICE_TYPE(g, "n2", "FakeGPU");
 }
 
+// Test that nodes of the same op whose attrs select different kernels do not
+// share supported device types.
+TEST_F(PlacerTest, TestSupportedDeviceTypesDependOnAttrs) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    ops::SourceOp("TestTypedOutput",
+                  b.opts().WithName("f1").WithAttr("T", DT_FLOAT));
+    ops::SourceOp("TestTypedOutput",
+                  b.opts().WithName("i1").WithAttr("T", DT_INT32));
+    ops::SourceOp("TestTypedOutput",
+                  b.opts().WithName("f2").WithAttr("T", DT_FLOAT));
+    ops::SourceOp("TestTypedOutput",
+                  b.opts().WithName("i2").WithAttr("T", DT_INT32));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  TF_EXPECT_OK(Place(&g));
+  EXPECT_DEVICE_TYPE(g, "f1", "FakeGPU");
+  EXPECT_DEVICE_TYPE(g, "i1", "FakeCPU");
+  EXPECT_DEVICE_TYPE(g, "f2", "FakeGPU");
+  EXPECT_DEVICE_TYPE(g, "i2", "FakeCPU");
+}
+
 // Test that a graph with no constraints but using kernels that have a specified
 // device priority will successfully assign nodes to the device with higher
 // priority
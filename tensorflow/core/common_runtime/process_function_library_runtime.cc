@@ -998,6 +998,8 @@ void ProcessFunctionLibraryRuntime::RunMultiDevice(
   }
 
   FunctionLibraryRuntime::Options opts_copy = opts;
+  // The return values of the components are not those of the function.
+  opts_copy.retval_buffer_provider = nullptr;
   for (const auto& pair : data->glue_) {
     const string& target = pair.first;
     const ComponentFunctionData& comp_data = pair.second;
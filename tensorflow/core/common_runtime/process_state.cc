@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/env_var.h"
 
@@ -43,6 +44,58 @@ namespace tensorflow {
 
 ProcessState::ProcessState() : numa_enabled_(false) {}
 
+PinnedHostMemoryPool::PinnedHostMemoryPool(const string& name,
+                                           int64 limit_per_node,
+                                           bool numa_enabled,
+                                           SubAllocatorFactory factory)
+    : name_(name),
+      limit_per_node_(limit_per_node),
+      numa_enabled_(numa_enabled),
+      factory_(std::move(factory)) {}
+
+PinnedHostMemoryPool::~PinnedHostMemoryPool() {}
+
+Allocator* PinnedHostMemoryPool::GetAllocator(int numa_node) {
+  if (!numa_enabled_ || numa_node < 0) numa_node = 0;
+  {
+    tf_shared_lock lock(mu_);
+    if (static_cast<size_t>(numa_node) < allocators_.size() &&
+        allocators_[numa_node] != nullptr) {
+      return allocators_[numa_node].get();
+    }
+  }
+
+  mutex_lock lock(mu_);
+  if (allocators_.size() <= static_cast<size_t>(numa_node)) {
+    allocators_.resize(numa_node + 1);
+  }
+  std::unique_ptr<Allocator>& allocator = allocators_[numa_node];
+  if (allocator == nullptr) {
+    VLOG(1) << "Creating pinned host memory pool " << name_ << " for NUMA node "
+            << numa_node << " with a limit of " << limit_per_node_ << " bytes";
+    allocator.reset(new BFCAllocator(factory_(numa_node, numa_enabled_),
+                                     limit_per_node_, true /*allow_growth*/,
+                                     name_));
+    if (LogMemory::IsEnabled() && !allocator->TracksAllocationSizes()) {
+      // Wrap the allocator to track allocation ids for better logging
+      // at the cost of performance.
+      allocator.reset(new TrackingAllocator(allocator.release(), true));
+    }
+  }
+  return allocator.get();
+}
+
+std::vector<std::pair<int, AllocatorStats>> PinnedHostMemoryPool::GetStats() {
+  std::vector<std::pair<int, AllocatorStats>> stats;
+  tf_shared_lock lock(mu_);
+  for (size_t node = 0; node < allocators_.size(); ++node) {
+    if (allocators_[node] == nullptr) continue;
+    absl::optional<AllocatorStats> s = allocators_[node]->GetStats();
+    if (s) stats.emplace_back(node, *s);
+  }
+  return stats;
+}
+
 string ProcessState::MemDesc::DebugString() {
   return strings::StrCat((loc == CPU ? "CPU " : "GPU "), dev_index,
                          ", dma: ", gpu_registered, ", nic: ", nic_registered);
@@ -138,8 +191,48 @@ void ProcessState::AddCPUFreeVisitor(SubAllocator::Visitor visitor) {
   cpu_free_visitors_.push_back(std::move(visitor));
 }
 
+bool ProcessState::HasCPUAllocators() {
+  mutex_lock lock(mu_);
+  return !cpu_allocators_.empty();
+}
+
+PinnedHostMemoryPool* ProcessState::GetPinnedHostMemoryPool(
+    const string& name, int64 limit_per_node,
+    PinnedHostMemoryPool::SubAllocatorFactory factory) {
+  mutex_lock lock(mu_);
+  std::unique_ptr<PinnedHostMemoryPool>& pool = pinned_host_pools_[name];
+  if (pool == nullptr) {
+    // Devices DMA from the pool on every transfer, so it can be split by
+    // NUMA node even when the CPU allocators are not. That is opt-in, as
+    // each node gets the whole limit.
+    bool numa = false;
+    Status status =
+        ReadBoolFromEnvVar("TF_PINNED_HOST_MEM_NUMA", false, &numa);
+    if (!status.ok()) {
+      LOG(ERROR) << "GetPinnedHostMemoryPool: " << status.error_message();
+    }
+    pool.reset(new PinnedHostMemoryPool(name, limit_per_node,
+                                        numa_enabled_ || numa,
+                                        std::move(factory)));
+  }
+  return pool.get();
+}
+
+std::vector<ProcessState::PinnedHostMemoryStats>
+ProcessState::GetPinnedHostMemoryStats() {
+  std::vector<PinnedHostMemoryStats> result;
+  mutex_lock lock(mu_);
+  for (const auto& p : pinned_host_pools_) {
+    for (const auto& node_stats : p.second->GetStats()) {
+      result.push_back({p.first, node_stats.first, node_stats.second});
+    }
+  }
+  return result;
+}
+
 void ProcessState::TestOnlyReset() {
   mutex_lock lock(mu_);
+  pinned_host_pools_.clear();
   // Don't delete this value because it's static.
   Allocator* default_cpu_allocator = cpu_allocator_base();
   mem_desc_map_.clear();
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <functional>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -33,6 +34,47 @@ namespace tensorflow {
 class Allocator;
 class PoolAllocator;
 
+// Host memory that devices can DMA to and from directly, with one
+// BFCAllocator per NUMA node. Freed chunks are reused by size class, and the
+// pages for each node come from that node, so that a device's transfers stay
+// local to the socket it is attached to. How the memory is pinned or
+// registered with the device is up to the SubAllocators made by `factory`.
+//
+// Pools are owned by ProcessState and shared by all devices of a kind; see
+// ProcessState::GetPinnedHostMemoryPool.
+class PinnedHostMemoryPool {
+ public:
+  // Returns a SubAllocator for `numa_node`. It places its memory on that node
+  // when `numa_affinity` is true.
+  typedef std::function<SubAllocator*(int numa_node, bool numa_affinity)>
+      SubAllocatorFactory;
+
+  PinnedHostMemoryPool(const string& name, int64 limit_per_node,
+                       bool numa_enabled, SubAllocatorFactory factory);
+  ~PinnedHostMemoryPool();
+
+  // Returns the allocator for `numa_node`, creating it on first use.
+  // kNUMANoAffinity, and every node when NUMA is not enabled, map to node 0.
+  Allocator* GetAllocator(int numa_node);
+
+  // Returns the stats of the allocator of every node used so far, by node.
+  std::vector<std::pair<int, AllocatorStats>> GetStats();
+
+  const string& name() const { return name_; }
+
+ private:
+  const string name_;
+  const int64 limit_per_node_;
+  const bool numa_enabled_;
+  const SubAllocatorFactory factory_;
+
+  mutex mu_;
+  // Indexed by NUMA node; null for nodes not used yet.
+  std::vector<std::unique_ptr<Allocator>> allocators_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PinnedHostMemoryPool);
+};
+
 // Singleton that manages per-process state, e.g. allocation of
 // shared resources.
 class ProcessState : public ProcessStateInterface {
@@ -75,6 +117,29 @@ class ProcessState : public ProcessStateInterface {
   // REQUIRES: must be called before GetCPUAllocator.
   void AddCPUFreeVisitor(SubAllocator::Visitor v);
 
+  // Returns true once GetCPUAllocator has been called, after which visitors
+  // can no longer be registered.
+  bool HasCPUAllocators();
+
+  // Returns the pinned host memory pool called `name`, creating it with
+  // `limit_per_node` and `factory` on the first call for that name. Pools
+  // are split by NUMA node if EnableNUMA was called or
+  // TF_PINNED_HOST_MEM_NUMA=true, in which case each node used may take up
+  // to `limit_per_node` bytes.
+  PinnedHostMemoryPool* GetPinnedHostMemoryPool(
+      const string& name, int64 limit_per_node,
+      PinnedHostMemoryPool::SubAllocatorFactory factory);
+
+  // Stats of one node of a pinned host memory pool.
+  struct PinnedHostMemoryStats {
+    string pool;
+    int numa_node;
+    AllocatorStats stats;
+  };
+
+  // Returns the stats of every pinned host memory pool, per NUMA node.
+  std::vector<PinnedHostMemoryStats> GetPinnedHostMemoryStats();
+
   typedef std::unordered_map<const void*, MemDesc> MDMap;
 
  protected:
@@ -102,6 +167,9 @@ class ProcessState : public ProcessStateInterface {
   std::vector<SubAllocator::Visitor> cpu_alloc_visitors_ GUARDED_BY(mu_);
   std::vector<SubAllocator::Visitor> cpu_free_visitors_ GUARDED_BY(mu_);
 
+  std::map<string, std::unique_ptr<PinnedHostMemoryPool>> pinned_host_pools_
+      GUARDED_BY(mu_);
+
   // Optional RecordingAllocators that wrap the corresponding
   // Allocators for runtime attribute use analysis.
   MDMap mem_desc_map_;
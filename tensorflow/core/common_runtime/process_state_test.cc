@@ -0,0 +1,153 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/process_state.h"
+
+#include <stdlib.h>
+
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Records the arguments of every SubAllocator the pool asks for.
+struct FactoryCalls {
+  std::vector<std::pair<int, bool>> calls;
+
+  PinnedHostMemoryPool::SubAllocatorFactory Factory() {
+    return [this](int numa_node, bool numa_affinity) {
+      calls.emplace_back(numa_node, numa_affinity);
+      return new BasicCPUAllocator(port::kNUMANoAffinity, {}, {});
+    };
+  }
+};
+
+TEST(PinnedHostMemoryPoolTest, OneAllocatorWithoutNUMA) {
+  FactoryCalls factory;
+  PinnedHostMemoryPool pool("test_pool", 1 << 20, /*numa_enabled=*/false,
+                            factory.Factory());
+  Allocator* a = pool.GetAllocator(0);
+  EXPECT_EQ(a, pool.GetAllocator(1));
+  EXPECT_EQ(a, pool.GetAllocator(port::kNUMANoAffinity));
+  ASSERT_EQ(factory.calls.size(), 1);
+  EXPECT_EQ(factory.calls[0], std::make_pair(0, false));
+}
+
+TEST(PinnedHostMemoryPoolTest, OneAllocatorPerNode) {
+  FactoryCalls factory;
+  PinnedHostMemoryPool pool("test_pool", 1 << 20, /*numa_enabled=*/true,
+                            factory.Factory());
+  Allocator* a1 = pool.GetAllocator(1);
+  Allocator* a0 = pool.GetAllocator(0);
+  EXPECT_NE(a0, a1);
+  EXPECT_EQ(a0, pool.GetAllocator(port::kNUMANoAffinity));
+  EXPECT_EQ(a1, pool.GetAllocator(1));
+  ASSERT_EQ(factory.calls.size(), 2);
+  EXPECT_EQ(factory.calls[0], std::make_pair(1, true));
+  EXPECT_EQ(factory.calls[1], std::make_pair(0, true));
+}
+
+TEST(PinnedHostMemoryPoolTest, LimitAppliesPerNode) {
+  FactoryCalls factory;
+  PinnedHostMemoryPool pool("test_pool", 1 << 20, /*numa_enabled=*/true,
+                            factory.Factory());
+  void* p0 = pool.GetAllocator(0)->AllocateRaw(64, 1 << 20);
+  void* p1 = pool.GetAllocator(1)->AllocateRaw(64, 1 << 20);
+  EXPECT_NE(p0, nullptr);
+  EXPECT_NE(p1, nullptr);
+  EXPECT_EQ(pool.GetAllocator(0)->AllocateRaw(64, 1 << 20), nullptr);
+
+  std::vector<std::pair<int, AllocatorStats>> stats = pool.GetStats();
+  ASSERT_EQ(stats.size(), 2);
+  EXPECT_EQ(stats[0].first, 0);
+  EXPECT_EQ(stats[1].first, 1);
+  EXPECT_EQ(stats[0].second.bytes_in_use, 1 << 20);
+  EXPECT_EQ(stats[1].second.bytes_in_use, 1 << 20);
+  EXPECT_EQ(*stats[0].second.bytes_limit, 1 << 20);
+
+  pool.GetAllocator(0)->DeallocateRaw(p0);
+  pool.GetAllocator(1)->DeallocateRaw(p1);
+}
+
+TEST(ProcessStateTest, PinnedHostMemoryPoolIsSharedByName) {
+  // Outlives the test, as the pool is kept by the ProcessState singleton.
+  static FactoryCalls factory;
+  ProcessState* ps = ProcessState::singleton();
+  PinnedHostMemoryPool* pool =
+      ps->GetPinnedHostMemoryPool("shared_pool", 1 << 20, factory.Factory());
+  EXPECT_EQ(pool->name(), "shared_pool");
+  EXPECT_EQ(pool, ps->GetPinnedHostMemoryPool("shared_pool", 1 << 20,
+                                              factory.Factory()));
+  EXPECT_NE(pool, ps->GetPinnedHostMemoryPool("other_pool", 1 << 20,
+                                              factory.Factory()));
+}
+
+TEST(ProcessStateTest, PinnedHostMemoryPoolIsNotSplitByDefault) {
+  static FactoryCalls factory;
+  PinnedHostMemoryPool* pool =
+      ProcessState::singleton()->GetPinnedHostMemoryPool(
+          "default_pool", 1 << 20, factory.Factory());
+  EXPECT_EQ(pool->GetAllocator(0), pool->GetAllocator(1));
+  ASSERT_EQ(factory.calls.size(), 1);
+  EXPECT_EQ(factory.calls[0], std::make_pair(0, false));
+}
+
+TEST(ProcessStateTest, PinnedHostMemoryPoolSplitOptIn) {
+  setenv("TF_PINNED_HOST_MEM_NUMA", "true", 1 /* replace */);
+  static FactoryCalls factory;
+  PinnedHostMemoryPool* pool =
+      ProcessState::singleton()->GetPinnedHostMemoryPool(
+          "numa_pool", 1 << 20, factory.Factory());
+  unsetenv("TF_PINNED_HOST_MEM_NUMA");
+  EXPECT_NE(pool->GetAllocator(0), pool->GetAllocator(1));
+  ASSERT_EQ(factory.calls.size(), 2);
+  EXPECT_EQ(factory.calls[0], std::make_pair(0, true));
+  EXPECT_EQ(factory.calls[1], std::make_pair(1, true));
+
+  // Pools created since are not split any more.
+  static FactoryCalls other_factory;
+  pool = ProcessState::singleton()->GetPinnedHostMemoryPool(
+      "non_numa_pool", 1 << 20, other_factory.Factory());
+  EXPECT_EQ(pool->GetAllocator(0), pool->GetAllocator(1));
+}
+
+TEST(ProcessStateTest, PinnedHostMemoryStats) {
+  static FactoryCalls factory;
+  ProcessState* ps = ProcessState::singleton();
+  Allocator* a =
+      ps->GetPinnedHostMemoryPool("stats_pool", 1 << 20, factory.Factory())
+          ->GetAllocator(0);
+  void* p = a->AllocateRaw(64, 1024);
+  bool found = false;
+  for (const ProcessState::PinnedHostMemoryStats& s :
+       ps->GetPinnedHostMemoryStats()) {
+    if (s.pool != "stats_pool") continue;
+    EXPECT_FALSE(found);
+    found = true;
+    EXPECT_EQ(s.numa_node, 0);
+    EXPECT_EQ(s.stats.bytes_in_use, 1024);
+    EXPECT_EQ(s.stats.num_allocs, 1);
+  }
+  EXPECT_TRUE(found);
+  a->DeallocateRaw(p);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -77,9 +77,11 @@ static thread::ThreadPool* InitComputePool(const SessionOptions& options) {
   if (inter_op_parallelism_threads == 0) {
     inter_op_parallelism_threads = DefaultNumInterOpThreads();
   }
+  const ThreadPoolPolicyProto& policy =
+      options.config.experimental().inter_op_thread_pool_policy();
   return new thread::ThreadPool(
-      Env::Default(), ThreadOptions(), "Compute", inter_op_parallelism_threads,
-      !options.config.experimental().disable_thread_spinning(),
+      Env::Default(), ThreadOptionsFromPolicy(policy), "Compute",
+      inter_op_parallelism_threads, ThreadSpinningFromPolicy(options, policy),
       /*allocator=*/nullptr);
 }
 
@@ -154,13 +156,36 @@ int32 NumInterOpThreadsFromSessionOptions(const SessionOptions& options) {
   return DefaultNumInterOpThreads();
 }
 
+ThreadOptions ThreadOptionsFromPolicy(const ThreadPoolPolicyProto& policy) {
+  ThreadOptions thread_options;
+  if (policy.numa_affinity_case() == ThreadPoolPolicyProto::kNumaNode) {
+    thread_options.numa_node = policy.numa_node();
+  }
+  thread_options.cpus.assign(policy.cpus().begin(), policy.cpus().end());
+  return thread_options;
+}
+
+bool ThreadSpinningFromPolicy(const SessionOptions& options,
+                              const ThreadPoolPolicyProto& policy) {
+  switch (policy.spinning()) {
+    case ThreadPoolPolicyProto::SPINNING_ON:
+      return true;
+    case ThreadPoolPolicyProto::SPINNING_OFF:
+      return false;
+    default:
+      return !options.config.experimental().disable_thread_spinning();
+  }
+}
+
 thread::ThreadPool* NewThreadPoolFromSessionOptions(
     const SessionOptions& options) {
   const int32 num_threads = NumInterOpThreadsFromSessionOptions(options);
   VLOG(1) << "Direct session inter op parallelism threads: " << num_threads;
+  const ThreadPoolPolicyProto& policy =
+      options.config.experimental().inter_op_thread_pool_policy();
   return new thread::ThreadPool(
-      options.env, ThreadOptions(), "Compute", num_threads,
-      !options.config.experimental().disable_thread_spinning(),
+      options.env, ThreadOptionsFromPolicy(policy), "Compute", num_threads,
+      ThreadSpinningFromPolicy(options, policy),
       /*allocator=*/nullptr);
 }
 
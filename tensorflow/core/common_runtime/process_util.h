@@ -44,6 +44,15 @@ int32 NumIntraOpThreadsFromEnvironment();
 // on the number of schedulable CPUs, and any MKL and OpenMP configurations.
 int32 NumInterOpThreadsFromSessionOptions(const SessionOptions& options);
 
+// Returns the options of the threads of a pool configured by `policy`, i.e.
+// the CPUs and the NUMA node they are pinned to.
+ThreadOptions ThreadOptionsFromPolicy(const ThreadPoolPolicyProto& policy);
+
+// Returns whether the idle threads of a pool configured by `policy` spin
+// before parking, i.e. the low_latency_hint of the thread::ThreadPool.
+bool ThreadSpinningFromPolicy(const SessionOptions& options,
+                              const ThreadPoolPolicyProto& policy);
+
 // Creates a thread pool with number of inter op threads.
 thread::ThreadPool* NewThreadPoolFromSessionOptions(
     const SessionOptions& options);
@@ -34,5 +34,32 @@ TEST(ProcessUtilTest, ThreadPool) {
   delete pool;
 }
 
+TEST(ProcessUtilTest, ThreadOptionsFromPolicy) {
+  ThreadPoolPolicyProto policy;
+  ThreadOptions thread_options = ThreadOptionsFromPolicy(policy);
+  EXPECT_EQ(port::kNUMANoAffinity, thread_options.numa_node);
+  EXPECT_TRUE(thread_options.cpus.empty());
+
+  policy.set_numa_node(0);
+  policy.add_cpus(2);
+  policy.add_cpus(3);
+  thread_options = ThreadOptionsFromPolicy(policy);
+  EXPECT_EQ(0, thread_options.numa_node);
+  EXPECT_EQ(std::vector<int>({2, 3}), thread_options.cpus);
+}
+
+TEST(ProcessUtilTest, ThreadSpinningFromPolicy) {
+  SessionOptions opts;
+  ThreadPoolPolicyProto policy;
+  EXPECT_TRUE(ThreadSpinningFromPolicy(opts, policy));
+  opts.config.mutable_experimental()->set_disable_thread_spinning(true);
+  EXPECT_FALSE(ThreadSpinningFromPolicy(opts, policy));
+  policy.set_spinning(ThreadPoolPolicyProto::SPINNING_ON);
+  EXPECT_TRUE(ThreadSpinningFromPolicy(opts, policy));
+  policy.set_spinning(ThreadPoolPolicyProto::SPINNING_OFF);
+  opts.config.mutable_experimental()->set_disable_thread_spinning(false);
+  EXPECT_FALSE(ThreadSpinningFromPolicy(opts, policy));
+}
+
 }  // anonymous namespace
 }  // namespace tensorflow
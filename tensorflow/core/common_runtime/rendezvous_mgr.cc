@@ -89,7 +89,8 @@ void SameWorkerRecvDone(const DeviceMgr* device_mgr,
       safe_alloc_frontier = dst_device->SafeAllocFrontier(safe_alloc_frontier);
       return safe_alloc_frontier;
     };
-    if (parsed.dst.type == "GPU" && safe_alloc_frontier > 0) {
+    if ((parsed.dst.type == "GPU" || parsed.dst.type == "VE") &&
+        safe_alloc_frontier > 0) {
       // There's a timestamped allocator at work, so use it instead
       // of sync_dst_compute.
       aa.freed_by_func = &freed_by_func;
@@ -14,8 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 
+#include <algorithm>
 #include <deque>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -30,6 +32,8 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/public/session.h"
 
 namespace tensorflow {
@@ -240,8 +244,21 @@ Status ShapeRefiner::AddNode(const Node* node) {
   std::unique_ptr<ExtendedInferenceContext> ec(
       new ExtendedInferenceContext(std::move(ic), node));
 
-  // Run the shape inference function, and return if there was an error.
-  TF_RETURN_IF_ERROR(RunShapeFn(node, op_reg_data, ec.get()));
+  // Reuse the result of the shape function for an earlier node with the same
+  // op, attrs and input shapes if there is one.
+  const string cache_key =
+      op_reg_data->shape_inference_fn != nullptr
+          ? ShapeFnCacheKey(node, ec->get_context())
+          : string();
+  auto cached = cache_key.empty() ? shape_fn_cache_.end()
+                                  : shape_fn_cache_.find(cache_key);
+  if (cached != shape_fn_cache_.end()) {
+    ReplayShapeFnResult(cached->second, ec->get_context());
+  } else {
+    // Run the shape inference function, and return if there was an error.
+    TF_RETURN_IF_ERROR(RunShapeFn(node, op_reg_data, ec.get()));
+    if (!cache_key.empty()) CacheShapeFnResult(cache_key, ec->get_context());
+  }
 
   // Store the resulting context object in the map.
   node_to_context_[node].swap(ec);
@@ -755,6 +772,170 @@ Status ShapeRefiner::RunShapeFn(const Node* node,
   return Status::OK();
 }
 
+namespace {
+
+// Attrs larger than this, e.g. the values of Consts, make the node's shape
+// function result not worth caching.
+constexpr int64 kMaxCachedAttrBytes = 1024;
+
+}  // namespace
+
+string ShapeRefiner::ShapeFnCacheKey(const Node* node,
+                                     InferenceContext* c) const {
+  // Nodes without inputs only depend on their attrs, which are cheap to read
+  // again, and function calls depend on the function body.
+  if (c->num_inputs() == 0 ||
+      (function_library_ && IsFunctionCall(*function_library_, *node))) {
+    return "";
+  }
+  string key = strings::StrCat(node->type_string(), ";", graph_def_version_);
+
+  // The attrs in name order, as the order of the map is unspecified.
+  std::vector<std::pair<StringPiece, const AttrValue*>> attrs;
+  attrs.reserve(node->def().attr_size());
+  for (const auto& attr : node->def().attr()) {
+    attrs.emplace_back(attr.first, &attr.second);
+  }
+  std::sort(attrs.begin(), attrs.end(),
+            [](const std::pair<StringPiece, const AttrValue*>& a,
+               const std::pair<StringPiece, const AttrValue*>& b) {
+              return a.first < b.first;
+            });
+  string value;
+  for (const auto& attr : attrs) {
+    if (attr.second->ByteSizeLong() > kMaxCachedAttrBytes ||
+        !SerializeToStringDeterministic(*attr.second, &value)) {
+      return "";
+    }
+    strings::StrAppend(&key, ";", attr.first, "=", value.size(), ":", value);
+  }
+
+  // The input shapes, with ids for the shapes and unknown dims that are the
+  // same handle, as shape functions may return either.
+  std::unordered_map<std::size_t, int> input_shapes;
+  std::unordered_map<std::size_t, int> unknown_dims;
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    ShapeHandle s = c->input(i);
+    if (s.Handle() == 0 || c->input_handle_shapes_and_types(i) != nullptr) {
+      return "";
+    }
+    auto shape_id = input_shapes.emplace(s.Handle(), i);
+    if (!shape_id.second) {
+      strings::StrAppend(&key, "|=", shape_id.first->second);
+      continue;
+    }
+    if (!c->RankKnown(s)) {
+      strings::StrAppend(&key, "|?");
+      continue;
+    }
+    strings::StrAppend(&key, "|");
+    for (int d = 0; d < c->Rank(s); ++d) {
+      DimensionHandle dim = c->Dim(s, d);
+      if (c->ValueKnown(dim)) {
+        strings::StrAppend(&key, c->Value(dim), ",");
+      } else {
+        const int id = unknown_dims.emplace(dim.Handle(), unknown_dims.size())
+                           .first->second;
+        strings::StrAppend(&key, "u", id, ",");
+      }
+    }
+  }
+  return key;
+}
+
+void ShapeRefiner::CacheShapeFnResult(const string& key, InferenceContext* c) {
+  if (shape_fn_cache_.size() >= kMaxShapeFnCacheEntries) return;
+  std::unordered_map<std::size_t, int> shapes;
+  std::unordered_map<std::size_t, std::pair<int, int>> unknown_dims;
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    if (c->requested_input_tensor(i) ||
+        c->requested_input_tensor_as_partial_shape(i)) {
+      return;
+    }
+    ShapeHandle s = c->input(i);
+    shapes.emplace(s.Handle(), i);
+    for (int d = 0; d < c->Rank(s); ++d) {
+      DimensionHandle dim = c->Dim(s, d);
+      if (!c->ValueKnown(dim)) {
+        unknown_dims.emplace(dim.Handle(), std::make_pair(i, d));
+      }
+    }
+  }
+
+  CachedShapeFnResult result;
+  result.outputs.resize(c->num_outputs());
+  std::unordered_map<std::size_t, int> output_shapes;
+  std::unordered_map<std::size_t, int> new_dims;
+  for (int o = 0; o < c->num_outputs(); ++o) {
+    if (c->output_handle_shapes_and_types(o) != nullptr) return;
+    CachedShapeFnResult::Output& output = result.outputs[o];
+    ShapeHandle s = c->output(o);
+    auto it = shapes.find(s.Handle());
+    if (it != shapes.end()) {
+      output.input = it->second;
+      continue;
+    }
+    auto shape_id = output_shapes.emplace(s.Handle(), o);
+    if (!shape_id.second) {
+      output.output = shape_id.first->second;
+      continue;
+    }
+    if (!c->RankKnown(s)) continue;
+    output.rank = c->Rank(s);
+    output.dims.reserve(output.rank);
+    for (int d = 0; d < output.rank; ++d) {
+      DimensionHandle dim = c->Dim(s, d);
+      if (c->ValueKnown(dim)) {
+        output.dims.push_back({c->Value(dim), -1, -1});
+        continue;
+      }
+      auto input_dim = unknown_dims.find(dim.Handle());
+      if (input_dim != unknown_dims.end()) {
+        output.dims.push_back(
+            {-1, input_dim->second.first, input_dim->second.second});
+      } else {
+        const int id =
+            new_dims.emplace(dim.Handle(), new_dims.size()).first->second;
+        output.dims.push_back({-1, -1, id});
+      }
+    }
+  }
+  shape_fn_cache_.emplace(key, std::move(result));
+}
+
+void ShapeRefiner::ReplayShapeFnResult(const CachedShapeFnResult& result,
+                                       InferenceContext* c) {
+  DCHECK_EQ(result.outputs.size(), c->num_outputs());
+  std::vector<DimensionHandle> new_dims;
+  std::vector<DimensionHandle> dims;
+  for (int o = 0; o < c->num_outputs(); ++o) {
+    const CachedShapeFnResult::Output& output = result.outputs[o];
+    if (output.input >= 0) {
+      c->set_output(o, c->input(output.input));
+    } else if (output.output >= 0) {
+      c->set_output(o, c->output(output.output));
+    } else if (output.rank < 0) {
+      c->set_output(o, c->UnknownShape());
+    } else {
+      dims.clear();
+      for (const CachedShapeFnResult::Dim& dim : output.dims) {
+        if (dim.value >= 0) {
+          dims.push_back(c->MakeDim(dim.value));
+        } else if (dim.input >= 0) {
+          dims.push_back(c->Dim(c->input(dim.input), dim.input_dim));
+        } else {
+          // New dims are numbered in the order they were first seen.
+          if (dim.input_dim == static_cast<int>(new_dims.size())) {
+            new_dims.push_back(c->UnknownDim());
+          }
+          dims.push_back(new_dims[dim.input_dim]);
+        }
+      }
+      c->set_output(o, c->MakeShape(dims));
+    }
+  }
+}
+
 bool ShapeRefiner::SameDefinedShape(InferenceContext* c, ShapeHandle s0,
                                     ShapeHandle s1) {
   if (s0.SameHandle(s1)) {
@@ -228,6 +228,40 @@ class ShapeRefiner {
   Status RunShapeFn(const Node* node, const OpRegistrationData* op_reg_data,
                     ExtendedInferenceContext* ec);
 
+  // The output shapes of a shape function, relative to its input shapes, for
+  // replaying it on another node with the same op, attrs and input shapes.
+  struct CachedShapeFnResult {
+    // A dim of an output. It is known if value >= 0. Otherwise it is dim
+    // `input_dim` of input `input` if input >= 0, or else a new unknown dim
+    // shared by the dims with the same `input_dim`.
+    struct Dim {
+      int64 value;
+      int input;
+      int input_dim;
+    };
+    struct Output {
+      // If >= 0, the output is the shape of this input or earlier output.
+      int input = -1;
+      int output = -1;
+      // Unknown if < 0.
+      int rank = -1;
+      std::vector<Dim> dims;
+    };
+    std::vector<Output> outputs;
+  };
+
+  // Returns the key of `node` in shape_fn_cache_, given the input shapes in
+  // `c`, or "" if the result of its shape function can't be shared.
+  string ShapeFnCacheKey(const Node* node,
+                         shape_inference::InferenceContext* c) const;
+  // Adds the outputs of `c` to shape_fn_cache_ under `key`, unless the shape
+  // function depended on more than the op, attrs and input shapes.
+  void CacheShapeFnResult(const string& key,
+                          shape_inference::InferenceContext* c);
+  // Sets the outputs of `c` from `result`.
+  static void ReplayShapeFnResult(const CachedShapeFnResult& result,
+                                  shape_inference::InferenceContext* c);
+
   int32 graph_def_version_;
   const OpRegistryInterface* const ops_registry_;
 
@@ -250,6 +284,12 @@ class ShapeRefiner {
   static constexpr int64 kMaxTensorSize = 1024;
   std::unordered_map<string, Tensor> const_tensor_map_;
 
+  // Results of shape functions by ShapeFnCacheKey. Repeated layers give many
+  // nodes with the same op, attrs and input shapes, whose shape functions
+  // need to run only once.
+  static constexpr int64 kMaxShapeFnCacheEntries = 1 << 16;
+  std::unordered_map<string, CachedShapeFnResult> shape_fn_cache_;
+
   bool require_shape_inference_fns_ = true;
   bool disable_constant_propagation_ = false;
 
@@ -1512,5 +1512,72 @@ TEST_F(ShapeRefinerTest, FunctionShapeInferenceWorksForResourceHandles) {
   EXPECT_RESOURCE_SINGLE_TYPE(DataType::DT_FLOAT, m, swap, 1);
 }
 
+
+int num_cached_shape_fn_calls = 0;
+
+// Returns [input dim 0, new unknown dim] and [that new dim].
+REGISTER_OP("TestCachedShapeFn")
+    .Input("a: float")
+    .Output("o: float")
+    .Output("p: float")
+    .Attr("k: int = 1")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      ++num_cached_shape_fn_calls;
+      shape_inference::DimensionHandle dim = c->UnknownDim();
+      c->set_output(0, c->Matrix(c->Dim(c->input(0), 0), dim));
+      c->set_output(1, c->Vector(dim));
+      return Status::OK();
+    });
+
+TEST_F(ShapeRefinerTest, CachesShapeFnResults) {
+  Scope root = Scope::NewRootScope();
+  auto x = ops::Placeholder(
+      root, DT_FLOAT, ops::Placeholder::Shape(PartialTensorShape({-1, 3})));
+  auto y = ops::Placeholder(
+      root, DT_FLOAT, ops::Placeholder::Shape(PartialTensorShape({-1, 4})));
+  Node* a;
+  Node* b;
+  Node* c;
+  Node* d;
+  TF_ASSERT_OK(NodeBuilder("a", "TestCachedShapeFn")
+                   .Input(x.node())
+                   .Finalize(root.graph(), &a));
+  TF_ASSERT_OK(NodeBuilder("b", "TestCachedShapeFn")
+                   .Input(x.node())
+                   .Finalize(root.graph(), &b));
+  TF_ASSERT_OK(NodeBuilder("c", "TestCachedShapeFn")
+                   .Input(x.node())
+                   .Attr("k", 2)
+                   .Finalize(root.graph(), &c));
+  TF_ASSERT_OK(NodeBuilder("d", "TestCachedShapeFn")
+                   .Input(y.node())
+                   .Finalize(root.graph(), &d));
+
+  ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
+  TF_ASSERT_OK(m.AddNode(x.node()));
+  TF_ASSERT_OK(m.AddNode(y.node()));
+  num_cached_shape_fn_calls = 0;
+  TF_ASSERT_OK(m.AddNode(a));
+  TF_ASSERT_OK(m.AddNode(b));
+  EXPECT_EQ(1, num_cached_shape_fn_calls);
+  // Different attrs or input shapes run the shape function again.
+  TF_ASSERT_OK(m.AddNode(c));
+  TF_ASSERT_OK(m.AddNode(d));
+  EXPECT_EQ(3, num_cached_shape_fn_calls);
+
+  // The replayed outputs of b keep the dim of x, and get their own new dim.
+  shape_inference::InferenceContext* x_ctx = m.GetContext(x.node());
+  shape_inference::InferenceContext* a_ctx = m.GetContext(a);
+  shape_inference::InferenceContext* b_ctx = m.GetContext(b);
+  EXPECT_EQ("[?,?]", b_ctx->DebugString(b_ctx->output(0)));
+  EXPECT_EQ("[?]", b_ctx->DebugString(b_ctx->output(1)));
+  EXPECT_TRUE(SameHandle(x_ctx->Dim(x_ctx->output(0), 0),
+                         b_ctx->Dim(b_ctx->output(0), 0)));
+  EXPECT_TRUE(SameHandle(b_ctx->Dim(b_ctx->output(0), 1),
+                         b_ctx->Dim(b_ctx->output(1), 0)));
+  EXPECT_FALSE(SameHandle(a_ctx->Dim(a_ctx->output(0), 1),
+                          b_ctx->Dim(b_ctx->output(0), 1)));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,250 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "tensorflow/core/common_runtime/shape_refiner.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+// Planning is quadratic in the number of outputs; larger graphs keep using
+// the device allocator.
+const int kMaxPlannedOutputs = 10000;
+
+int64 AlignedBytes(int64 bytes) {
+  const int64 alignment = Allocator::kAllocatorAlignment;
+  return (bytes + alignment - 1) / alignment * alignment;
+}
+
+// Nodes whose outputs never come from allocate_output.
+bool ProducesAllocatedOutputs(const Node* n) {
+  return n->IsOp() && !n->IsConstant() && !n->IsVariable() && !n->IsSend() &&
+         !n->IsRecv() && !n->IsArg() && !n->IsRetval() &&
+         !n->IsControlFlow() && !n->IsIdentity();
+}
+
+struct Candidate {
+  int node_id;
+  int index;
+  int64 bytes;
+  // Positions in topological order of the producer and the last consumer.
+  int first;
+  int last;
+};
+
+}  // namespace
+
+/* static */
+std::unique_ptr<StaticMemoryPlan> StaticMemoryPlan::Create(
+    const Graph& graph, const OutputFilter& filter) {
+  for (const Node* n : graph.op_nodes()) {
+    // A node in a loop runs several times per step.
+    if (n->IsEnter()) return nullptr;
+  }
+
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  std::vector<int> position(graph.num_node_ids(), -1);
+  ShapeRefiner refiner(graph.versions(), graph.op_registry());
+  refiner.set_require_shape_inference_fns(false);
+  for (int i = 0; i < static_cast<int>(order.size()); ++i) {
+    const Node* n = order[i];
+    position[n->id()] = i;
+    if (!n->IsOp()) continue;
+    Status s = refiner.AddNode(n);
+    if (!s.ok()) {
+      VLOG(1) << "No static memory plan, shape inference failed: " << s;
+      return nullptr;
+    }
+  }
+
+  std::vector<Candidate> candidates;
+  for (const Node* n : order) {
+    if (!ProducesAllocatedOutputs(n)) continue;
+    shape_inference::InferenceContext* c = refiner.GetContext(n);
+    if (c == nullptr) continue;
+    for (int i = 0; i < n->num_outputs(); ++i) {
+      DataType dtype = n->output_type(i);
+      if (IsRefType(dtype) || !DataTypeCanUseMemcpy(dtype)) continue;
+      if (!filter(n, i)) continue;
+      shape_inference::ShapeHandle shape = c->output(i);
+      if (!c->FullyDefined(shape)) continue;
+      int64 num_elements = 1;
+      for (int d = 0; d < c->Rank(shape); ++d) {
+        num_elements *= c->Value(c->Dim(shape, d));
+      }
+      int64 bytes = num_elements * DataTypeSize(dtype);
+      if (bytes == 0) continue;
+
+      Candidate candidate = {n->id(), i, bytes, position[n->id()],
+                             position[n->id()]};
+      for (const Edge* e : n->out_edges()) {
+        if (e->IsControlEdge() || e->src_output() != i) continue;
+        candidate.last = std::max(candidate.last, position[e->dst()->id()]);
+      }
+      candidates.push_back(candidate);
+    }
+  }
+  if (candidates.empty()) return nullptr;
+  if (static_cast<int>(candidates.size()) > kMaxPlannedOutputs) {
+    VLOG(1) << "No static memory plan, " << candidates.size()
+            << " outputs to plan";
+    return nullptr;
+  }
+
+  std::unique_ptr<StaticMemoryPlan> plan(new StaticMemoryPlan);
+  const int num_slots = static_cast<int>(candidates.size());
+  plan->slots_.resize(num_slots);
+
+  // Greedy by size: place the largest outputs first, each at the lowest
+  // offset not used by an output whose lifetime intersects its own.
+  std::vector<int> by_size(num_slots);
+  std::iota(by_size.begin(), by_size.end(), 0);
+  std::stable_sort(by_size.begin(), by_size.end(), [&candidates](int a, int b) {
+    return candidates[a].bytes > candidates[b].bytes;
+  });
+  std::vector<int> by_offset;
+  for (int s : by_size) {
+    const Candidate& candidate = candidates[s];
+    const int64 bytes = AlignedBytes(candidate.bytes);
+    int64 offset = 0;
+    for (int other : by_offset) {
+      const Candidate& o = candidates[other];
+      if (o.last < candidate.first || candidate.last < o.first) continue;
+      const Slot& placed = plan->slots_[other];
+      if (offset + bytes <= placed.offset) break;
+      offset = std::max(offset, placed.offset + AlignedBytes(placed.bytes));
+    }
+    plan->slots_[s].offset = offset;
+    plan->slots_[s].bytes = candidate.bytes;
+    plan->arena_bytes_ = std::max(plan->arena_bytes_, offset + bytes);
+    by_offset.insert(std::upper_bound(by_offset.begin(), by_offset.end(), s,
+                                      [&plan](int a, int b) {
+                                        return plan->slots_[a].offset <
+                                               plan->slots_[b].offset;
+                                      }),
+                     s);
+  }
+
+  for (int a = 0; a < num_slots; ++a) {
+    Slot& slot_a = plan->slots_[a];
+    for (int b = a + 1; b < num_slots; ++b) {
+      Slot& slot_b = plan->slots_[b];
+      if (slot_a.offset < slot_b.offset + slot_b.bytes &&
+          slot_b.offset < slot_a.offset + slot_a.bytes) {
+        slot_a.overlaps.push_back(b);
+        slot_b.overlaps.push_back(a);
+      }
+    }
+  }
+
+  plan->first_slot_.assign(graph.num_node_ids(), -1);
+  for (int s = 0; s < num_slots; ++s) {
+    const Candidate& candidate = candidates[s];
+    int& first = plan->first_slot_[candidate.node_id];
+    if (first < 0) {
+      first = static_cast<int>(plan->slot_of_output_.size());
+      plan->slot_of_output_.resize(
+          first + graph.FindNodeId(candidate.node_id)->num_outputs(), -1);
+    }
+    plan->slot_of_output_[first + candidate.index] = s;
+  }
+
+  VLOG(1) << "Static memory plan: " << num_slots << " outputs in "
+          << plan->arena_bytes_ << " bytes";
+  return plan;
+}
+
+class StaticMemoryArena::SlotBuffer : public TensorBuffer {
+ public:
+  SlotBuffer(StaticMemoryArena* arena, int slot, void* data, size_t size)
+      : TensorBuffer(data), arena_(arena), slot_(slot), size_(size) {
+    arena_->Ref();
+  }
+
+  ~SlotBuffer() override {
+    arena_->Release(slot_);
+    arena_->Unref();
+  }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocated_bytes(size_);
+    proto->set_allocator_name("static_memory_plan");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+ private:
+  StaticMemoryArena* const arena_;
+  const int slot_;
+  const size_t size_;
+};
+
+StaticMemoryArena::StaticMemoryArena(
+    std::shared_ptr<const StaticMemoryPlan> plan, Allocator* allocator)
+    : plan_(std::move(plan)),
+      live_(new std::atomic<bool>[plan_->num_slots()]) {
+  for (int i = 0; i < plan_->num_slots(); ++i) {
+    live_[i].store(false, std::memory_order_relaxed);
+  }
+  AllocationAttributes attr;
+  attr.no_retry_on_failure = true;
+  backing_tensor_ = Tensor(allocator, DT_INT8,
+                           TensorShape({plan_->arena_bytes()}), attr);
+  if (backing_tensor_.IsInitialized()) {
+    base_ = const_cast<char*>(backing_tensor_.tensor_data().data());
+  } else {
+    VLOG(1) << "Could not allocate " << plan_->arena_bytes()
+            << " bytes for the static memory plan";
+  }
+}
+
+TensorBuffer* StaticMemoryArena::AllocateOutput(int node_id, int index,
+                                                DataType type,
+                                                const TensorShape& shape) {
+  if (base_ == nullptr || !DataTypeCanUseMemcpy(type)) return nullptr;
+  const int slot = plan_->slot(node_id, index);
+  if (slot < 0) return nullptr;
+  const StaticMemoryPlan::Slot& info = plan_->slot_info(slot);
+  const int64 bytes = shape.num_elements() * DataTypeSize(type);
+  if (bytes == 0 || bytes > info.bytes) return nullptr;
+
+  // Claim the slot first and then look for a live output sharing its memory,
+  // so that of two outputs claiming overlapping slots at once at least one
+  // sees the other and backs off.
+  if (live_[slot].exchange(true)) return nullptr;
+  for (int other : info.overlaps) {
+    if (live_[other].load()) {
+      live_[slot].store(false);
+      return nullptr;
+    }
+  }
+  return new SlotBuffer(this, slot, base_ + info.offset, bytes);
+}
+
+void StaticMemoryArena::Release(int slot) { live_[slot].store(false); }
+
+}  // namespace tensorflow
@@ -0,0 +1,112 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLAN_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLAN_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/refcount.h"
+
+namespace tensorflow {
+
+// Assigns an offset in a single arena to every node output whose shape is
+// fully known after shape inference, in the spirit of TFLite's ArenaPlanner.
+// Outputs whose lifetimes, measured in topological order, do not intersect
+// may share memory.
+//
+// The plan only guides placement. Nodes may run in any order allowed by the
+// dataflow and tensors may outlive their last consumer, so StaticMemoryArena
+// checks at run time that no other output using the same memory is live, and
+// otherwise lets the kernel allocate from the device allocator.
+class StaticMemoryPlan {
+ public:
+  struct Slot {
+    int64 offset;
+    int64 bytes;
+    // Slots whose memory range overlaps this one.
+    std::vector<int> overlaps;
+  };
+
+  // Returns true if output `index` of `node` may be placed in the arena,
+  // e.g. because it lives in device memory.
+  typedef std::function<bool(const Node* node, int index)> OutputFilter;
+
+  // Returns nullptr if `graph` has no output that can be planned, contains
+  // loops, or is too large to plan.
+  static std::unique_ptr<StaticMemoryPlan> Create(const Graph& graph,
+                                                  const OutputFilter& filter);
+
+  // Returns the slot of output `index` of node `node_id`, or -1.
+  int slot(int node_id, int index) const {
+    if (node_id < 0 || node_id >= static_cast<int>(first_slot_.size()) ||
+        first_slot_[node_id] < 0) {
+      return -1;
+    }
+    return slot_of_output_[first_slot_[node_id] + index];
+  }
+
+  const Slot& slot_info(int slot) const { return slots_[slot]; }
+  int num_slots() const { return static_cast<int>(slots_.size()); }
+  int64 arena_bytes() const { return arena_bytes_; }
+
+ private:
+  StaticMemoryPlan() {}
+
+  std::vector<Slot> slots_;
+  // For node id n, index into slot_of_output_ of its output 0, or -1.
+  std::vector<int> first_slot_;
+  std::vector<int> slot_of_output_;
+  int64 arena_bytes_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticMemoryPlan);
+};
+
+// The memory of one StaticMemoryPlan for one step. Created by the executor at
+// the start of a step. Outputs served from the arena hold a reference to it,
+// so the arena is released once the step is done and the last such output
+// has been freed.
+class StaticMemoryArena : public StaticOutputProvider, public core::RefCounted {
+ public:
+  StaticMemoryArena(std::shared_ptr<const StaticMemoryPlan> plan,
+                    Allocator* allocator);
+
+  TensorBuffer* AllocateOutput(int node_id, int index, DataType type,
+                               const TensorShape& shape) override;
+
+ private:
+  class SlotBuffer;
+
+  ~StaticMemoryArena() override {}
+
+  void Release(int slot);
+
+  const std::shared_ptr<const StaticMemoryPlan> plan_;
+  Tensor backing_tensor_;
+  char* base_ = nullptr;
+  std::unique_ptr<std::atomic<bool>[]> live_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticMemoryArena);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLAN_H_
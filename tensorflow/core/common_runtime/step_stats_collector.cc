@@ -141,6 +141,10 @@ void NodeExecStatsWrapper::RecordExecutorEnded() {
   stats_->set_all_end_rel_nanos(now_nanos - stats_->all_start_nanos());
 }
 
+void NodeExecStatsWrapper::SetReady(int64 nanos) {
+  stats_->set_ready_nanos(nanos);
+}
+
 void NodeExecStatsWrapper::SetScheduled(int64 nanos) {
   stats_->set_scheduled_micros(nanos / EnvTime::kMicrosToNanos);
   stats_->set_scheduled_nanos(nanos);
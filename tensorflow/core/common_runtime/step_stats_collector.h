@@ -85,6 +85,10 @@ class NodeExecStatsInterface {
   // execution of this node.
   virtual void SetReferencedTensors(const TensorReferenceVector& tensors) = 0;
 
+  // Records the absolute time in nanoseconds at which all inputs of this node
+  // became available.
+  virtual void SetReady(int64 nanos) = 0;
+
   // Records the absolute time in nanoseconds at which this node became
   // runnable (i.e. was scheduled for execution).
   virtual void SetScheduled(int64 nanos) = 0;
@@ -114,6 +118,7 @@ class NodeExecStatsWrapper : public NodeExecStatsInterface {
   void SetMemory(OpKernelContext* ctx) override;
   void SetOutput(int slot, const Tensor* tensor) override;
   void SetReferencedTensors(const TensorReferenceVector& tensors) override;
+  void SetReady(int64 nanos) override;
   void SetScheduled(int64 nanos) override;
 
  private:
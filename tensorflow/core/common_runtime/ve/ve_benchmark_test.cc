@@ -0,0 +1,75 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of the copy paths and request latencies of /device:VE:0.
+// Comparing BM_VEOWrite and BM_DMAWrite over sizes gives the crossover to
+// set TF_DMA_THRESHOLD to; BM_Write shows the path the device takes with
+// the current settings. Run with --benchmarks=all.
+
+#include "tensorflow/core/common_runtime/ve/ve_device.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+void RunVEBenchmark(int iters, VEBenchmarkPath path, size_t size,
+                    bool is_copy) {
+  testing::StopTiming();
+  testing::UseRealTime();
+  testing::StartTiming();
+  uint64 elapsed_ns = 0;
+  Status s = VEBenchmark(0, path, size, iters, &elapsed_ns);
+  testing::StopTiming();
+  if (!s.ok()) {
+    testing::SetLabel(s.error_message());
+    return;
+  }
+  if (is_copy) {
+    testing::BytesProcessed(static_cast<int64>(iters) * size);
+  } else {
+    testing::ItemsProcessed(static_cast<int64>(iters) * size);
+  }
+}
+
+#define BM_VE_COPY(name, path)                          \
+  static void BM_##name(int iters, int size) {          \
+    RunVEBenchmark(iters, path, size, /*is_copy=*/true); \
+  }                                                     \
+  BENCHMARK(BM_##name)->Range(4 << 10, 256 << 20)
+
+BM_VE_COPY(Write, VEBenchmarkPath::kWrite);
+BM_VE_COPY(Read, VEBenchmarkPath::kRead);
+BM_VE_COPY(VEOWrite, VEBenchmarkPath::kVEOWrite);
+BM_VE_COPY(VEORead, VEBenchmarkPath::kVEORead);
+BM_VE_COPY(DMAWrite, VEBenchmarkPath::kDMAWrite);
+BM_VE_COPY(DMARead, VEBenchmarkPath::kDMARead);
+
+#undef BM_VE_COPY
+
+static void BM_Call(int iters) {
+  RunVEBenchmark(iters, VEBenchmarkPath::kCall, 1, /*is_copy=*/false);
+}
+BENCHMARK(BM_Call);
+
+// Latency of syncing a batch of `kernels` trivial kernels.
+static void BM_BatchFlush(int iters, int kernels) {
+  RunVEBenchmark(iters, VEBenchmarkPath::kBatchFlush, kernels,
+                 /*is_copy=*/false);
+}
+BENCHMARK(BM_BatchFlush)->Arg(1)->Arg(16)->Arg(256)->Arg(4096);
+
+}  // namespace
+}  // namespace tensorflow
@@ -3,22 +3,37 @@
 //#include "tensorflow/core/common_runtime/visitable_allocator.h"
 #include "tensorflow/core/common_runtime/process_state.h"
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
+#include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/scoped_allocator.h"
+#include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
+#include "tensorflow/core/common_runtime/shared_counter.h"
 
 #include "tensorflow/core/common_runtime/ve/ve_device.h"
+#include "tensorflow/core/common_runtime/ve/ve_tracer.h"
 
 #include "tensorflow/core/framework/variant_op_registry.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/profiler/internal/annotation_stack.h"
+#include "tensorflow/core/util/env_var.h"
 
 #include "ve_offload.h"
+#include <deque>
+#include <set>
+#include <unordered_map>
 #include <sys/types.h>
 #include <sys/syscall.h>
 
 #define VEO_ASYNC
 
 #define TF_VE_EXECUTOR
-#ifdef TF_VE_EXECUTOR
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
-#endif
 
 #define USE_DMA
 #ifdef USE_DMA
@@ -30,6 +45,126 @@ namespace tensorflow {
 
 namespace {
 
+#ifdef USE_DMA
+// Hugepage shm segments allocated by VEHostMemAllocator for host tensors.
+// A segment is registered to a VE process on its first use, and then DMA
+// reads and writes tensors in the segment directly instead of through the
+// staging buffer.
+class VEHostMemRegistry {
+  public:
+    struct Segment {
+      const char* ptr;
+      size_t size;
+      int shmid;
+    };
+
+    typedef std::function<void(const Segment&)> Listener;
+
+    static VEHostMemRegistry* Global() {
+      static VEHostMemRegistry* instance = new VEHostMemRegistry;
+      return instance;
+    }
+
+    void Add(const Segment& seg) {
+      mutex_lock l(mu_);
+      segments_[seg.ptr] = seg;
+    }
+
+    // Returns false when ptr is not a segment. Listeners are called before
+    // returning.
+    bool Remove(const void* ptr) {
+      Segment seg;
+      std::vector<Listener> listeners;
+      {
+        mutex_lock l(mu_);
+        auto it = segments_.find(reinterpret_cast<const char*>(ptr));
+        if (it == segments_.end())
+          return false;
+        seg = it->second;
+        segments_.erase(it);
+        listeners = listeners_;
+      }
+      for (auto& fn : listeners)
+        fn(seg);
+      return true;
+    }
+
+    // Finds the segment including [p, p + len).
+    bool Find(const void* p, size_t len, Segment* seg) {
+      const char* ptr = reinterpret_cast<const char*>(p);
+      mutex_lock l(mu_);
+      auto it = segments_.upper_bound(ptr);
+      if (it == segments_.begin())
+        return false;
+      --it;
+      if (ptr + len > it->second.ptr + it->second.size)
+        return false;
+      *seg = it->second;
+      return true;
+    }
+
+    // Registers a function called when a segment is removed.
+    void AddRemoveListener(Listener fn) {
+      mutex_lock l(mu_);
+      listeners_.push_back(std::move(fn));
+    }
+
+  private:
+    mutex mu_;
+    std::map<const char*, Segment> segments_;
+    std::vector<Listener> listeners_;
+};
+#endif // USE_DMA
+
+// Kernel times of batches sampled by TF_VE_KERNEL_SAMPLING_INTERVAL, labeled
+// by kernel name.
+auto* ve_kernel_count = monitoring::Counter<1>::New(
+    "/tensorflow/core/ve/kernel_count",
+    "The number of sampled VE kernels.", "kernel");
+
+auto* ve_kernel_time_usecs = monitoring::Counter<1>::New(
+    "/tensorflow/core/ve/kernel_time_usecs",
+    "The total time spent in sampled VE kernels in microseconds.", "kernel");
+
+auto* ve_kernel_time_usecs_histogram = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/ve/kernel_time_usecs_histogram",
+     "The time spent in sampled VE kernels in microseconds.", "kernel"},
+    // Power of 2 with bucket count 24 (> 16 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
+auto* ve_const_cache_hit_bytes = monitoring::Counter<0>::New(
+    "/tensorflow/core/ve/const_cache_hit_bytes",
+    "The total size of constants found in VEConstCache instead of being "
+    "uploaded.");
+
+auto* ve_sampled_batches = monitoring::Counter<0>::New(
+    "/tensorflow/core/ve/sampled_batches",
+    "The number of kernel batches profiled by sampling.");
+
+// Hardware performance counters of sampled or traced VE kernels, labeled by
+// kernel name and by counter name (see VEPmcs).
+auto* ve_kernel_pmc = monitoring::Counter<2>::New(
+    "/tensorflow/core/ve/kernel_pmc",
+    "The total increment of a VE performance counter in sampled or traced "
+    "kernels.", "kernel", "counter");
+
+// Sizes of tensors copied between the host and VEs, labeled by direction
+// ("host_to_device" or "device_to_host"), and the kernel batches issued to
+// VEs. Benchmarks report their increments per step.
+auto* ve_transfer_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/ve/transfer_bytes",
+    "The total size of tensors copied between the host and VEs.",
+    "direction");
+
+auto* ve_issued_batches = monitoring::Counter<0>::New(
+    "/tensorflow/core/ve/issued_batches",
+    "The number of kernel batches issued to VEs.");
+
+// Name of the edge of the copy being issued on this thread. Set by
+// VEDeviceContextImpl while it issues a copy, and read by VEO to label the
+// trace record of the copy.
+thread_local StringPiece tls_copy_edge_name;
+
 class VEO {
   public:
     struct Args {
@@ -56,9 +191,11 @@ class VEO {
       }
     };
 
-    VEO() : cb_(nullptr) {}
+    VEO(int device_id) : device_id_(device_id), cb_(nullptr) {}
     virtual ~VEO();
 
+    int device_id() const { return device_id_; }
+
     typedef void (*cb_t)(int nodeid, int kind, const void* buf, void* data);
 
     bool isTracerEnabled() const { return cb_ != nullptr; }
@@ -103,6 +240,8 @@ class VEO {
       }
 
       VLOG(2) << "VEO::alloc_mem: ret=" << ret << " addr=" << std::hex << addr;
+      if (ret != 0)
+        return 0;
       return addr;
     }
 
@@ -117,24 +256,20 @@ class VEO {
 
       //bool useDMA = false;
 #ifdef USE_DMA
-      if (dma_.available && len <= dma_.bufsize && len >= dma_.threshold) {
-        mutex_lock guard(dma_.lock);
-        //VLOG(2) << "VEO::write_mem: after dma lock";
+      if (use_dma(len)) {
         if (isTracerEnabled())
           start = Env::Default()->NowMicros();
         //start0 = Env::Default()->NowMicros(); useDMA = true;
 
-        assert(len < 256 * 1024 * 1024);
-        struct {
-          uint64_t size;
-          uint64_t vevma;
-        } tmp;
-        tmp.size = len;
-        tmp.vevma = ve_addr;
-        Args a(&tmp, sizeof(tmp));
-
-        memcpy(dma_.shmptr, vh_buff, len);
-        Status s = call_and_wait(dma_.sym_dma_read, a);
+        uint64_t shmid, offset;
+        Status s;
+        if (find_host_shm(true, vh_buff, len, &shmid, &offset)) {
+          DMAShmArgs a(ve_addr, len, shmid, offset);
+          s = call_and_wait(dma_.sym_dma_read_shm, a.args);
+        } else {
+          // vh_buff is not written when htod is true
+          s = dma_transfer(true, ve_addr, const_cast<void*>(vh_buff), len);
+        }
         if (!s.ok())
           return s;
         rc = 0;
@@ -146,14 +281,14 @@ class VEO {
 
       if (isTracerEnabled()) {
         end = Env::Default()->NowMicros();
-        callbackTracer(start, end, 0); // 0: HtoD
+        callbackTracer(makeCopyTrace(start, len), end, 0); // 0: HtoD
       }
 #else
       if (isTracerEnabled()) {
         uint64_t start = Env::Default()->NowMicros();
         rc = veo_write_mem(proc_, ve_addr, vh_buff, len);
         uint64_t end = Env::Default()->NowMicros();
-        callbackTracer(start, end, 0); // 0: HtoD
+        callbackTracer(makeCopyTrace(start, len), end, 0); // 0: HtoD
       } else
         rc = veo_write_mem(proc_, ve_addr, vh_buff, len);
 #endif
@@ -169,25 +304,84 @@ class VEO {
 
     virtual Status read_mem(void* vh_buff, uint64_t ve_addr, size_t len) {
       int rc;
+#ifdef USE_DMA
+      uint64_t shmid, offset;
+      bool use_shm = use_dma(len)
+          && find_host_shm(false, vh_buff, len, &shmid, &offset);
+      if (use_shm || use_dma_write(len)) {
+        uint64_t start = 0;
+        if (isTracerEnabled())
+          start = Env::Default()->NowMicros();
+
+        Status s;
+        if (use_shm) {
+          DMAShmArgs a(ve_addr, len, shmid, offset);
+          s = call_and_wait(dma_.sym_dma_write_shm, a.args);
+        } else {
+          s = dma_transfer(false, ve_addr, vh_buff, len);
+        }
+        if (!s.ok())
+          return s;
+
+        if (isTracerEnabled()) {
+          uint64_t end = Env::Default()->NowMicros();
+          callbackTracer(makeCopyTrace(start, len), end, 1); // 1: DtoH
+        }
+        return Status::OK();
+      }
+#endif
+
       if (isTracerEnabled()) {
         uint64_t start = Env::Default()->NowMicros();
         rc = veo_read_mem(proc_, vh_buff, ve_addr, len);
         uint64_t end = Env::Default()->NowMicros();
-        callbackTracer(start, end, 1); // 1: DtoH
+        callbackTracer(makeCopyTrace(start, len), end, 1); // 1: DtoH
       } else
         rc = veo_read_mem(proc_, vh_buff, ve_addr, len);
 
       if (rc == 0)
         return Status::OK();
       else
-        return errors::Internal("write_mem failed. rc=", rc);
+        return errors::Internal("read_mem failed. rc=", rc);
     }
 
-    virtual Status compute(const std::string& name, const void* arg, size_t len,
-                           const OpKernel* op) {
+    // Asynchronous versions of write_mem and read_mem. `done` is called
+    // after the copy and all kernels issued before the copy are
+    // completed. Buffers have to be alive until `done` is called.
+    //
+    // When sync_dst_compute is false, the caller guarantees that no pending
+    // kernel uses ve_addr, and the copy may run on a copy stream without
+    // waiting for preceding kernels.
+    virtual void write_mem_async(uint64_t ve_addr, const void* vh_buff,
+                                 size_t len, StatusCallback done,
+                                 bool sync_dst_compute = true) {
+      done(write_mem(ve_addr, vh_buff, len));
+    }
+
+    virtual void read_mem_async(void* vh_buff, uint64_t ve_addr, size_t len,
+                                StatusCallback done) {
+      done(read_mem(vh_buff, ve_addr, len));
+    }
+
+    Status compute(const std::string& name, const void* arg, size_t len,
+                   const OpKernel* op) {
       VLOG(2) << "VEO::compute: name=" << name << " arg=" << arg << " len=" << len;
       uint64_t sym = find_kernel_sym(name);
+      if (sym == 0)
+        return errors::Internal("VEO: VE kernel not found for ", name);
+      return compute(sym, arg, len, op);
+    }
 
+    // Returns a symbol of the VE kernel `name` to call it by compute without
+    // looking up the name, or 0 when it is not found.
+    uint64_t lookup_kernel(const std::string& name) {
+      return find_kernel_sym(name);
+    }
+
+    virtual Status compute(uint64_t sym, const void* arg, size_t len,
+                           const OpKernel* op) {
+      VLOG(2) << "VEO::compute: sym=" << reinterpret_cast<void*>(sym)
+        << " arg=" << arg << " len=" << len;
       Args a;
       veo_args_set_stack(a.args, VEO_INTENT_IN, 0, (char*)arg, len);
       veo_args_set_i64(a.args, 1, len);
@@ -197,20 +391,56 @@ class VEO {
     virtual Status init(int nodeid);
     virtual Status sync() { return Status::OK(); }
 
+    // A timing counter for allocators of this VE when it has copy streams.
+    // Memory freed at or before the count returned by safe_alloc_frontier
+    // is not used by any pending kernel, and a copy stream can write it.
+    virtual SharedCounter* timing_counter() { return nullptr; }
+    virtual uint64 safe_alloc_frontier() { return 0; }
+
+    // Records that the buffer at `ve_addr` is written by kernels pushed so
+    // far. A read of the buffer then waits only for those kernels.
+    virtual void record_writer(uint64_t ve_addr) {}
+
+    // See VEBenchmark.
+    Status benchmark(VEBenchmarkPath path, size_t size, int iters,
+                     uint64* elapsed_ns);
+
   protected:
+    // Symbols of kernels are resolved on first use because resolving all
+    // kernels in the library takes a long time at startup.
     uint64_t find_kernel_sym(std::string const& name) {
+      {
+        tf_shared_lock l(lock_syms_);
+        auto it = kernel_map_.find(name);
+        if (it != kernel_map_.end())
+          return it->second;
+      }
+
+      mutex_lock l(lock_syms_);
       auto it = kernel_map_.find(name);
-      if (it == kernel_map_.end())
+      if (it != kernel_map_.end())
+        return it->second;
+      auto func = kernel_funcs_.find(name);
+      if (func == kernel_funcs_.end())
         return 0;
-      return it->second;
+      uint64_t sym = veo_get_sym(proc_, lib_id_, func->second.c_str());
+      VLOG(2) << "VEO::find_kernel_sym: name=" << name
+        << " func=" << func->second << " sym=" << reinterpret_cast<void*>(sym);
+      if (!sym) {
+        LOG(ERROR) << "VE: failed to get symbol for " << func->second;
+        return 0;
+      }
+      kernel_map_[name] = sym;
+      kernel_names_[sym] = name;
+      return sym;
     }
 
     std::string find_kernel_name(uint64_t sym) {
-      for (auto p : kernel_map_) {
-        if (p.second == sym)
-          return p.first;
-      }
-      return "(unknown)";
+      tf_shared_lock l(lock_syms_);
+      auto it = kernel_names_.find(sym);
+      if (it == kernel_names_.end())
+        return "(unknown)";
+      return it->second;
     }
 
     virtual uint64_t get_sym(uint64_t lib_id, const char* name) {
@@ -218,15 +448,39 @@ class VEO {
     }
 
     virtual uint64_t call(uint64_t sym, const Args& a) {
-      uint64_t req_id = veo_call_async(ctx_, sym, a.args);
+      return call_on(ctx_, sym, a);
+    }
+
+    virtual Status wait(uint64_t req_id, uint64_t *pRetval = NULL) {
+      return wait_on(ctx_, req_id, pRetval);
+    }
+
+    // Opens an additional context on the VE process. Requests on different
+    // contexts are executed concurrently by different VE threads.
+    struct veo_thr_ctxt* open_context() { return veo_context_open(proc_); }
+    struct veo_thr_ctxt* context() const { return ctx_; }
+
+    uint64_t call_on(struct veo_thr_ctxt* ctx, uint64_t sym, const Args& a) {
+      uint64_t req_id = veo_call_async(ctx, sym, a.args);
       VLOG(2) << "VEO::call: return from veo_call_async. req_id=" << req_id;
       return req_id;
     }
 
-    virtual Status wait(uint64_t req_id, uint64_t *pRetval = NULL) {
+    uint64_t async_write_mem(struct veo_thr_ctxt* ctx, uint64_t ve_addr,
+                             const void* vh_buff, size_t len) {
+      return veo_async_write_mem(ctx, ve_addr, vh_buff, len);
+    }
+
+    uint64_t async_read_mem(struct veo_thr_ctxt* ctx, void* vh_buff,
+                            uint64_t ve_addr, size_t len) {
+      return veo_async_read_mem(ctx, vh_buff, ve_addr, len);
+    }
+
+    Status wait_on(struct veo_thr_ctxt* ctx, uint64_t req_id,
+                   uint64_t *pRetval = NULL) {
       VLOG(2) << "VEO::wait: call veo_wait_result for req_id=" << req_id;
       uint64_t retval;
-      int ret = veo_call_wait_result(ctx_, req_id, &retval);
+      int ret = veo_call_wait_result(ctx, req_id, &retval);
       VLOG(2) << "VEO::wait: return from veo_wait_result."
         << " req_id=" << req_id << " ret=" << ret << " retval=" << retval;
       if (pRetval)
@@ -247,72 +501,341 @@ class VEO {
       return wait(req_id, pRetval);
     }
 
+    // `buf` has, for each kernel, its start and end cycles followed by
+    // `num_pmcs` performance counters. `push_ns` has the host time each
+    // kernel was pushed to its stack, `submit_ns` and `complete_ns` the host
+    // times the stack was issued to the VE and seen completed.
     void callbackTracer(const std::vector<std::string>& kernel_names,
-                        const void* buf)
+                        const std::vector<uint64_t>& push_ns,
+                        uint64_t submit_ns, uint64_t complete_ns,
+                        const void* buf, int num_pmcs)
     {
       VLOG(2) << "VEO::callbackTracer: cb_=" << reinterpret_cast<void*>(cb_);
       if (cb_) {
         struct {
           const std::vector<std::string>* kernel_names;
           const void* buf;
+          int num_pmcs;
+          const std::vector<uint64_t>* push_ns;
+          uint64_t submit_ns;
+          uint64_t complete_ns;
         } tmp;
         tmp.kernel_names = &kernel_names;
         tmp.buf = buf;
-        cb_(0, 0, &tmp, cb_data_);
+        tmp.num_pmcs = num_pmcs;
+        tmp.push_ns = &push_ns;
+        tmp.submit_ns = submit_ns;
+        tmp.complete_ns = complete_ns;
+        cb_(device_id_, 0, &tmp, cb_data_);
       }
     }
 
-    void callbackTracer(uint64_t start, uint64_t end, int type) {
+    // Trace of a copy. It is captured on the thread issuing the copy since
+    // the copy may complete on another thread.
+    struct CopyTrace {
+      uint64_t start = 0;
+      size_t bytes = 0;
+      std::string name;
+    };
+
+    // Labels a copy by the current annotation of this thread and the edge
+    // being copied, if any.
+    CopyTrace makeCopyTrace(uint64_t start, size_t len) const {
+      CopyTrace trace;
+      trace.start = start;
+      trace.bytes = len;
+      const std::string& annotation = profiler::AnnotationStack::Get();
+      if (!annotation.empty())
+        trace.name = annotation;
+      if (!tls_copy_edge_name.empty()) {
+        if (!trace.name.empty())
+          trace.name += ":";
+        trace.name += std::string(tls_copy_edge_name);
+      }
+      if (trace.name.empty())
+        trace.name = "unknown";
+      return trace;
+    }
+
+    CopyTrace beginCopyTrace(size_t len) const {
+      if (!isTracerEnabled())
+        return CopyTrace();
+      return makeCopyTrace(Env::Default()->NowMicros(), len);
+    }
+
+    void callbackTracer(const CopyTrace& trace, uint64_t end, int type) {
       if (cb_) {
         struct {
           uint64_t start;
           uint64_t end;
           uint64_t type;
+          uint64_t bytes;
+          const char* name;
         } tmp;
-        tmp.start = start;
+        tmp.start = trace.start;
         tmp.end = end;
         tmp.type = type;
-        cb_(0, 1, &tmp, cb_data_);
+        tmp.bytes = trace.bytes;
+        tmp.name = trace.name.c_str();
+        cb_(device_id_, 1, &tmp, cb_data_);
+      }
+    }
+
+#ifdef USE_DMA
+    // The shm segment registered to VE is divided into num_bufs staging
+    // buffers of chunk_size bytes. A transfer larger than chunk_size is
+    // split into chunks, and a chunk is copied on VH while VE transfers
+    // previous ones.
+    struct {
+      bool available = false;
+      size_t bufsize;
+      size_t chunk_size;
+      int num_bufs;
+      uint64_t threshold;
+      // vetfkl_dma_{read,write}_at take an offset in the shm segment. Only
+      // one staging buffer at offset 0 is used with vetfkl_dma_{read,write}.
+      bool has_offset = false;
+      uint64_t sym_dma_read = 0;  // VE reads shmptr, that is HtoD
+      uint64_t sym_dma_write = 0; // VE writes shmptr, that is DtoH
+      void* shmptr = nullptr;
+      mutex lock;
+      condition_variable cond;
+      std::vector<int> free_bufs; // guarded by lock
+
+      // DMA between VE and segments of VEHostMemRegistry.
+      uint64_t sym_dma_register_shm = 0;
+      uint64_t sym_dma_unregister_shm = 0;
+      uint64_t sym_dma_read_shm = 0;
+      uint64_t sym_dma_write_shm = 0;
+      mutex shm_lock;
+      std::set<int> registered_shmids; // guarded by shm_lock
+    } dma_;
+
+    struct DMAShmArgs {
+      struct {
+        uint64_t size;
+        uint64_t vevma;
+        uint64_t shmid;
+        uint64_t offset;
+      } tmp;
+      Args args;
+
+      DMAShmArgs(uint64_t ve_addr, size_t len, uint64_t shmid,
+                 uint64_t offset) {
+        tmp.size = len;
+        tmp.vevma = ve_addr;
+        tmp.shmid = shmid;
+        tmp.offset = offset;
+        args.set(&tmp, sizeof(tmp));
+      }
+    };
+
+    // Returns true when [vh_buff, vh_buff + len) is in a segment of
+    // VEHostMemRegistry. The segment is registered to VE if not yet.
+    bool find_host_shm(bool htod, const void* vh_buff, size_t len,
+                       uint64_t* shmid, uint64_t* offset) {
+      if ((htod ? dma_.sym_dma_read_shm : dma_.sym_dma_write_shm) == 0)
+        return false;
+
+      VEHostMemRegistry::Segment seg;
+      if (!VEHostMemRegistry::Global()->Find(vh_buff, len, &seg))
+        return false;
+
+      mutex_lock guard(dma_.shm_lock);
+      if (dma_.registered_shmids.count(seg.shmid) == 0) {
+        struct {
+          int32_t shmid;
+          uint64_t size;
+        } tmp;
+        tmp.shmid = seg.shmid;
+        tmp.size = seg.size;
+        Args a(&tmp, sizeof(tmp));
+        Status s = call_and_wait(dma_.sym_dma_register_shm, a);
+        if (!s.ok()) {
+          LOG(WARNING) << "VE: failed to register host memory to VE: " << s;
+          return false;
+        }
+        dma_.registered_shmids.insert(seg.shmid);
+      }
+
+      *shmid = seg.shmid;
+      *offset = reinterpret_cast<const char*>(vh_buff) - seg.ptr;
+      return true;
+    }
+
+    void unregister_host_shm(int shmid) {
+      mutex_lock guard(dma_.shm_lock);
+      if (dma_.registered_shmids.erase(shmid) == 0)
+        return;
+      int32_t tmp = shmid;
+      Args a(&tmp, sizeof(tmp));
+      Status s = call_and_wait(dma_.sym_dma_unregister_shm, a);
+      if (!s.ok())
+        LOG(WARNING) << "VE: failed to unregister host memory from VE: " << s;
+    }
+
+    struct DMAArgs {
+      struct {
+        uint64_t size;
+        uint64_t vevma;
+        uint64_t offset; // only used by vetfkl_dma_{read,write}_at
+      } tmp;
+      Args args;
+
+      DMAArgs(uint64_t ve_addr, size_t len, size_t offset, bool has_offset) {
+        tmp.size = len;
+        tmp.vevma = ve_addr;
+        tmp.offset = offset;
+        args.set(&tmp, has_offset ? sizeof(tmp) : sizeof(uint64_t) * 2);
+      }
+    };
+
+    bool use_dma(size_t len) const {
+      return dma_.available && len >= dma_.threshold;
+    }
+
+    // vetfkl_dma_write is not provided by old VE kernel libraries.
+    bool use_dma_write(size_t len) const {
+      return use_dma(len) && dma_.sym_dma_write != 0;
+    }
+
+    void* dma_buf(int buf) const {
+      return reinterpret_cast<char*>(dma_.shmptr) + dma_offset(buf);
+    }
+
+    size_t dma_offset(int buf) const { return dma_.chunk_size * buf; }
+
+    bool try_acquire_dma_buf(int* buf) {
+      mutex_lock guard(dma_.lock);
+      if (dma_.free_bufs.empty())
+        return false;
+      *buf = dma_.free_bufs.back();
+      dma_.free_bufs.pop_back();
+      return true;
+    }
+
+    int acquire_dma_buf() {
+      mutex_lock guard(dma_.lock);
+      while (dma_.free_bufs.empty())
+        dma_.cond.wait(guard);
+      int buf = dma_.free_bufs.back();
+      dma_.free_bufs.pop_back();
+      return buf;
+    }
+
+    void release_dma_buf(int buf) {
+      mutex_lock guard(dma_.lock);
+      dma_.free_bufs.push_back(buf);
+      dma_.cond.notify_one();
+    }
+
+    // Transfers len bytes by chunks using free staging buffers. htod is true
+    // for VH to VE.
+    Status dma_transfer(bool htod, uint64_t ve_addr, void* vh_buff, size_t len) {
+      struct Chunk {
+        uint64_t req_id;
+        int buf;
+        size_t offset;
+        size_t size;
+        std::unique_ptr<DMAArgs> args;
+      };
+      std::deque<Chunk> inflight;
+      char* p = reinterpret_cast<char*>(vh_buff);
+      uint64_t sym = htod ? dma_.sym_dma_read : dma_.sym_dma_write;
+      Status status;
+
+      auto finish = [this, htod, p, &status](const Chunk& c) {
+        Status s = wait(c.req_id);
+        if (s.ok() && !htod)
+          memcpy(p + c.offset, dma_buf(c.buf), c.size);
+        status.Update(s);
+      };
+
+      for (size_t off = 0; off < len; off += dma_.chunk_size) {
+        Chunk c;
+        c.offset = off;
+        c.size = std::min(dma_.chunk_size, len - off);
+
+        // Do not wait for a free buffer while holding in-flight buffers
+        // to avoid deadlock with other threads.
+        if (!try_acquire_dma_buf(&c.buf)) {
+          if (inflight.empty()) {
+            c.buf = acquire_dma_buf();
+          } else {
+            finish(inflight.front());
+            c.buf = inflight.front().buf;
+            inflight.pop_front();
+          }
+        }
+
+        if (!status.ok()) {
+          release_dma_buf(c.buf);
+          break;
+        }
+
+        if (htod)
+          memcpy(dma_buf(c.buf), p + off, c.size);
+        c.args.reset(new DMAArgs(ve_addr + off, c.size, dma_offset(c.buf),
+                                 dma_.has_offset));
+        c.req_id = call(sym, c.args->args);
+        if (c.req_id == VEO_REQUEST_ID_INVALID) {
+          release_dma_buf(c.buf);
+          status.Update(errors::Internal("Failed to call DMA"));
+          break;
+        }
+        inflight.push_back(std::move(c));
       }
+
+      while (!inflight.empty()) {
+        finish(inflight.front());
+        release_dma_buf(inflight.front().buf);
+        inflight.pop_front();
+      }
+
+      return status;
     }
 
+    Status init_dma(veo_proc_handle* proc, uint64_t lib_id);
+#endif
+
   private:
 #if 0
     pid_t proc_pid_;
 #endif
+    int device_id_; // index of /device:VE:N, not the VE node number
     struct veo_proc_handle* proc_;
     struct veo_thr_ctxt *ctx_;
 
-    std::map<std::string, uint64_t> kernel_map_;
+    uint64_t lib_id_ = 0;
+    mutex lock_syms_;
+    // kernel name to function name in the library
+    std::unordered_map<std::string, std::string> kernel_funcs_;
+    // resolved kernels
+    std::unordered_map<std::string, uint64_t> kernel_map_; // guarded by lock_syms_
+    std::unordered_map<uint64_t, std::string> kernel_names_; // guarded by lock_syms_
     uint64_t sym_get_timestamp_;
     cb_t cb_;
     void* cb_data_;
-
-#ifdef USE_DMA
-    struct {
-      bool available;
-      size_t bufsize;
-      uint64_t threshold;
-      mutex lock;
-      uint64_t sym_dma_read;
-      void* shmptr;
-    } dma_;
-
-    Status init_dma(veo_proc_handle* proc, uint64_t lib_id);
-#endif
 };
 
+// Serialized arguments of kernels issued to VE as one request. The buffer
+// starts with `size` bytes and grows on demand up to `max_size` bytes.
 class KernelStack
 {
   public:
-    KernelStack(size_t size) : buf_size_(size), num_kernels_(0) {
-      buf_ = reinterpret_cast<void*>(new char[buf_size_]);
-      curr_ = reinterpret_cast<uintptr_t>(buf_)
-        + sizeof(int32_t); // reserve int32_t to store num_kernels
-      top_ = curr_ + buf_size_;
+    KernelStack(size_t size, size_t max_size)
+      : capacity_(std::max(size, sizeof(int32_t))), max_size_(max_size),
+        num_kernels_(0) {
+      buf_ = new char[capacity_];
+      size_ = sizeof(int32_t); // reserve int32_t to store num_kernels
     }
 
-    int push(uint64_t sym, const void* arg, size_t len, 
+    ~KernelStack() { delete[] buf_; }
+
+    // Returns 1 when the kernel does not fit in max_size bytes. Then the
+    // stack should be issued before pushing the kernel again. A kernel is
+    // always pushed to an empty stack even if it is larger than max_size.
+    int push(uint64_t sym, const void* arg, size_t len,
              const std::string* annotation) {
 #if 0
       VLOG(2) << "KernelStack::push: num_kernels=" << num_kernels_
@@ -320,80 +843,113 @@ class KernelStack
 #endif
 
       size_t sz = sizeof(uint64_t) + sizeof(size_t) + len;
-      if (curr_ + sz >= top_) {
-        VLOG(2) << "KernelStack::push: overflow";
-        return 1;
+      if (size_ + sz > capacity_) {
+        if (num_kernels_ > 0 && size_ + sz > max_size_) {
+          VLOG(2) << "KernelStack::push: overflow";
+          return 1;
+        }
+        grow(size_ + sz);
       }
 
       ++num_kernels_;
+      offsets_.push_back(size_);
 
       // copy to buf
-      *reinterpret_cast<uint64_t*>(curr_) = sym;
-      curr_ += sizeof(uint64_t);
-      *reinterpret_cast<size_t*>(curr_) = len;
-      curr_ += sizeof(size_t);
-      memcpy(reinterpret_cast<void*>(curr_), arg, len);
-      curr_ += len;
-
-      if (annotation)
+      char* curr = buf_ + size_;
+      *reinterpret_cast<uint64_t*>(curr) = sym;
+      curr += sizeof(uint64_t);
+      *reinterpret_cast<size_t*>(curr) = len;
+      curr += sizeof(size_t);
+      memcpy(curr, arg, len);
+      size_ += sz;
+
+      if (annotation) {
         annotations_.push_back(*annotation);
+        push_ns_.push_back(Env::Default()->NowNanos());
+      }
 
       return 0;
     }
 
     uint64_t find_sym(int idx) const {
       //VLOG(2) << "KernelStack::find_sym: idx=" << idx << " num_kernels_=" << num_kernels_;
-      if (num_kernels_ <= idx)
+      if (idx < 0 || num_kernels_ <= idx)
         return 0;
-      uintptr_t curr = reinterpret_cast<uintptr_t>(buf_);
-      curr += sizeof(int32_t); // skip num_kernels
-      uint64_t sym = 0;
-      for (int i = 0; i < idx + 1; ++i) {
-        sym = *reinterpret_cast<const uint64_t*>(curr);
-        size_t len = *reinterpret_cast<const size_t*>(curr + sizeof(uint64_t));
-        curr += len + sizeof(uint64_t) + sizeof(size_t);
-        //VLOG(2) << "KernelStack::find_sym: i=" << i << " sym=" << sym;
-      }
-      return sym;
+      return *reinterpret_cast<const uint64_t*>(buf_ + offsets_[idx]);
     }
 
     int32_t num_kernels() const { return num_kernels_; }
     void* buf() { return buf_; }
-    size_t size() const { return curr_ - reinterpret_cast<uintptr_t>(buf_); }
+    size_t size() const { return size_; }
     void clear() {
-      curr_ = reinterpret_cast<uintptr_t>(buf_) + sizeof(int32_t);
+      size_ = sizeof(int32_t);
       num_kernels_ = 0;
+      offsets_.clear();
       annotations_.clear();
+      push_ns_.clear();
     }
     const std::vector<std::string>& annotations() const { return annotations_; }
+    // Host times in nanoseconds the annotated kernels were pushed.
+    const std::vector<uint64_t>& push_ns() const { return push_ns_; }
 
   private:
-    size_t buf_size_;
+    size_t capacity_;
+    size_t max_size_;
     int32_t num_kernels_;
-    void* buf_;
-    uintptr_t top_;
-    uintptr_t curr_;
+    char* buf_;
+    size_t size_;
+    std::vector<size_t> offsets_; // offset of each kernel in buf_
     std::vector<std::string> annotations_;
+    std::vector<uint64_t> push_ns_;
+
+    void grow(size_t required) {
+      size_t capacity = std::max(std::min(capacity_ * 2, max_size_), required);
+      VLOG(2) << "KernelStack::grow: capacity=" << capacity;
+      char* buf = new char[capacity];
+      memcpy(buf, buf_, size_);
+      delete[] buf_;
+      buf_ = buf;
+      capacity_ = capacity;
+    }
+
+    TF_DISALLOW_COPY_AND_ASSIGN(KernelStack);
 };
 
 #ifdef VEO_ASYNC
 class VEOAsync : public VEO
 {
   public:
-    VEOAsync()  {
-      stack_size_ = 10 * 1024 * 1024;
-      int stack_pool_size = 10;
-        for (int i = 0; i < stack_pool_size - 1; ++i) {
-          stack_pool_.push_back(new KernelStack(stack_size_));
+    using VEO::compute;
+
+    VEOAsync(int device_id) : VEO(device_id) {}
+
+    ~VEOAsync() {
+#ifdef TF_VE_EXECUTOR
+      {
+        mutex_lock guard(lock_stack_);
+        dispatcher_done_ = true;
+        dispatcher_cond_.notify_all();
+      }
+      // join the dispatcher before the completion threads
+      dispatcher_thread_.reset();
+#endif
+      for (auto& stream : streams_) {
+        {
+          mutex_lock l(stream->mu);
+          stream->done = true;
+          stream->cond_requests.notify_all();
         }
-        currStack_ = new KernelStack(stack_size_);
+        // join the completion thread before callback_pool_
+        stream->thread.reset();
       }
+      // the context of the compute stream is closed by VEO
+      for (size_t i = 1; i < streams_.size(); ++i)
+        veo_context_close(streams_[i]->ctx);
 
-#ifdef TF_VE_EXECUTOR
-    ~VEOAsync() {
-      thread_done_ = true;
+      delete currStack_;
+      for (KernelStack* stack : stack_pool_)
+        delete stack;
     }
-#endif
 
     Status init(int nodeid) override {
       Status s = VEO::init(nodeid);
@@ -407,20 +963,128 @@ class VEOAsync : public VEO
       if (sym_prof_ == 0 || sym_noprof_ == 0)
         return errors::Internal("Failed to get symbol for vetfkl_entry");
 
+      // vetfkl_entry_pmc also reads performance counters around each kernel.
+      // Older kernel libraries do not have it, and TF_VE_ENABLE_PMC=false
+      // disables it.
+      bool enable_pmc;
+      TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_VE_ENABLE_PMC", true,
+                                            &enable_pmc));
+      sym_pmc_ = enable_pmc ? get_sym(0, "vetfkl_entry_pmc") : 0;
+      VLOG(2) << "VEOAsync: sym_pmc=" << std::hex << sym_pmc_;
+
+      // Every TF_VE_KERNEL_SAMPLING_INTERVAL-th batch is profiled, and its
+      // kernel times are exported as monitoring counters. 0 disables
+      // sampling. The resolution is read here because no completion thread
+      // is running yet.
+      TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_VE_KERNEL_SAMPLING_INTERVAL",
+                                             0, &sampling_interval_));
+      if (sampling_interval_ > 0) {
+        uint64_t ts;
+        TF_RETURN_IF_ERROR(get_timestamp(&ts, &sampling_resolution_));
+        VLOG(2) << "VEOAsync: sampling_interval=" << sampling_interval_
+          << " resolution=" << sampling_resolution_;
+      }
+
+      // A stack grows from TF_VE_STACK_SIZE up to TF_VE_STACK_MAX_SIZE
+      // bytes. Then it is issued even if sync is not called.
+      int64 stack_size, stack_max_size, stack_pool_size;
+      TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_VE_STACK_SIZE",
+                                             1024 * 1024, &stack_size));
+      TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_VE_STACK_MAX_SIZE",
+                                             10 * 1024 * 1024,
+                                             &stack_max_size));
+      TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_VE_STACK_POOL_SIZE", 10,
+                                             &stack_pool_size));
+      stack_size = std::max(stack_size, int64{0});
+      stack_size_ = stack_size;
+      stack_max_size_ = std::max(stack_max_size, stack_size);
+      stack_pool_size_ = std::max(stack_pool_size, int64{1});
+      VLOG(2) << "VEOAsync: stack_size=" << stack_size_
+        << " stack_max_size=" << stack_max_size_
+        << " stack_pool_size=" << stack_pool_size_;
+
+      {
+        mutex_lock guard(lock_stack_);
+        for (int i = 0; i < stack_pool_size_ - 1; ++i)
+          stack_pool_.push_back(new KernelStack(stack_size_, stack_max_size_));
+        currStack_ = new KernelStack(stack_size_, stack_max_size_);
+      }
+
+      // Stream 0 is the compute stream that executes kernels and copies in
+      // order. Other streams are copy streams for host-to-device copies
+      // that do not have to wait for kernels.
+      int64 num_streams;
+      TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_VE_NUM_STREAMS", 1,
+                                             &num_streams));
+      num_streams = std::max(num_streams, int64{1});
+      VLOG(2) << "VEOAsync: num_streams=" << num_streams
+        << ". Can be changed by TF_VE_NUM_STREAMS";
+
+      // `done` of asynchronous copies is called on this pool not to block
+      // the completion threads by the executor.
+      int64 num_callback_threads;
+      TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_VE_COPY_THREAD_COUNT", 2,
+                                             &num_callback_threads));
+      num_callback_threads = std::max(num_callback_threads, int64{1});
+      callback_pool_.reset(new thread::ThreadPool(
+              Env::Default(), "ve_copy_done", num_callback_threads));
+
+      for (int64 i = 0; i < num_streams; ++i) {
+        std::unique_ptr<Stream> stream(new Stream);
+        stream->ctx = i == 0 ? context() : open_context();
+        if (!stream->ctx)
+          return errors::Internal("Failed to open VEO context for stream ", i);
+        Stream* p = stream.get();
+        streams_.push_back(std::move(stream));
+        p->thread.reset(tensorflow::Env::Default()->StartThread(
+          tensorflow::ThreadOptions(), "ve_completion_thread",
+          std::bind(&VEOAsync::CompletionLoop, this, p)));
+      }
+
+      // Copy streams are used only when allocators are timestamped. See
+      // safe_alloc_frontier.
+      if (num_streams > 1) {
+        timing_counter_.reset(new SharedCounter);
+        // No memory is freed at the initial frontier.
+        safe_frontier_ = timing_counter_->next();
+      }
+
 #ifdef TF_VE_EXECUTOR
       if (char const* tmp = getenv("TF_VE_EXECUTOR")) {
           ve_executor_enabled_ = true;
-          ve_executor_threshold_ = std::atoi(tmp);
+          ve_executor_threshold_ = std::max(std::atoi(tmp), 1);
+          TF_CHECK_OK(ReadInt64FromEnvVar("TF_VE_EXECUTOR_MAX_BYTES",
+                                          1024 * 1024,
+                                          &ve_executor_max_bytes_));
+          TF_CHECK_OK(ReadInt64FromEnvVar("TF_VE_EXECUTOR_DEADLINE_US", 500,
+                                          &ve_executor_deadline_us_));
           VLOG(2) << "VEOAsync: StartThread: "
-            << " threshold=" << ve_executor_threshold_;
-          thread_.reset(tensorflow::Env::Default()->StartThread(
-            tensorflow::ThreadOptions(), "ve_sync_thread",
-            std::bind(&VEOAsync::Run, this)));
+            << " threshold=" << ve_executor_threshold_
+            << " max_bytes=" << ve_executor_max_bytes_
+            << " deadline_us=" << ve_executor_deadline_us_;
+          dispatcher_thread_.reset(tensorflow::Env::Default()->StartThread(
+            tensorflow::ThreadOptions(), "ve_dispatcher_thread",
+            std::bind(&VEOAsync::DispatchLoop, this)));
       }
 #endif
       return Status::OK();
     }
 
+    SharedCounter* timing_counter() override { return timing_counter_.get(); }
+
+    // Memory freed before a kernel stack is issued is safe after the stack
+    // is completed because kernels using the memory were pushed before it
+    // was freed.
+    uint64 safe_alloc_frontier() override {
+      mutex_lock guard(lock_stack_);
+      if (!timing_counter_)
+        return 0;
+      if (currStack_->num_kernels() == 0 && stacks_in_flight_ == 0)
+        safe_frontier_ = std::max(safe_frontier_,
+                                  static_cast<uint64>(timing_counter_->get()));
+      return safe_frontier_;
+    }
+
     virtual Status write_mem(uint64_t ve_addr, const void* vh_buff, size_t len) override {
       //VLOG(2) << "VEOAsync::write_mem";
       Status s = sync();
@@ -430,148 +1094,664 @@ class VEOAsync : public VEO
     }
 
     virtual Status read_mem(void* vh_buff, uint64_t ve_addr, size_t len) override {
-      Status s = sync();
+      // Waits only for the kernels which the read depends on.
+      Notification n;
+      Status status;
+      read_mem_async(vh_buff, ve_addr, len, [&n, &status](const Status& s) {
+        status = s;
+        n.Notify();
+      });
+      n.WaitForNotification();
+      return status;
+    }
+
+    void write_mem_async(uint64_t ve_addr, const void* vh_buff, size_t len,
+                         StatusCallback done,
+                         bool sync_dst_compute) override {
+      VLOG(2) << "VEOAsync::write_mem_async: len=" << len;
+      CopyTrace trace = beginCopyTrace(len);
+      // A later read has to be ordered with this copy.
+      forget_writer(ve_addr);
+      Stream* stream = compute_stream();
+      if (!sync_dst_compute && timing_counter_)
+        stream = copy_stream();
+#ifdef USE_DMA
+      if (use_dma(len)) {
+        uint64_t shmid, offset;
+        if (find_host_shm(true, vh_buff, len, &shmid, &offset)) {
+          issue_dma_shm(stream, true, ve_addr, shmid, offset, len,
+                        std::move(trace), std::move(done));
+        } else {
+          // vh_buff is not written when htod is true
+          issue_dma(stream, true, ve_addr, const_cast<void*>(vh_buff), len,
+                    std::move(trace), std::move(done));
+        }
+        return;
+      }
+#endif
+
+      Status s = issue_request(
+          stream,
+          [this, ve_addr, vh_buff, len](struct veo_thr_ctxt* ctx) {
+            return async_write_mem(ctx, ve_addr, vh_buff, len);
+          },
+          [this, trace, done](const Status& s, uint64_t retval) {
+            complete_copy(s, trace, 0, done); // 0: HtoD
+          });
       if (!s.ok())
-        return s;
-      return VEO::read_mem(vh_buff, ve_addr, len);
+        done(s);
     }
 
-    virtual Status compute(const std::string& name, const void* arg, size_t len,
-                           const OpKernel* op) override {
-      mutex_lock guard(lock_stack_);
+    void read_mem_async(void* vh_buff, uint64_t ve_addr, size_t len,
+                        StatusCallback done) override {
+      VLOG(2) << "VEOAsync::read_mem_async: len=" << len;
+      CopyTrace trace = beginCopyTrace(len);
+      // The source is written by preceding kernels. When the stack which
+      // wrote it is known, the kernels pushed after it are not issued for
+      // the read, and the read runs on a copy stream once the stack is
+      // completed.
+      Stream* stream = compute_stream();
+      bool flush_stack = true;
+      uint64_t writer = find_writer(ve_addr);
+      if (writer > 0) {
+        if (writer <= num_completed_stacks_.load() && streams_.size() > 1)
+          stream = copy_stream();
+        else if (writer <= num_issued_stacks_.load())
+          flush_stack = false;
+      }
+#ifdef USE_DMA
+      uint64_t shmid, offset;
+      if (use_dma(len) && find_host_shm(false, vh_buff, len, &shmid, &offset)) {
+        issue_dma_shm(stream, false, ve_addr, shmid, offset, len,
+                      std::move(trace), std::move(done), flush_stack);
+        return;
+      }
+      if (use_dma_write(len)) {
+        issue_dma(stream, false, ve_addr, vh_buff, len, std::move(trace),
+                  std::move(done), flush_stack);
+        return;
+      }
+#endif
 
-      VLOG(2) << "VEOAsync::compute:"
-        << " name=" << name
-        << " num_kernels_in_stack=" << currStack_->num_kernels();
-      uint64_t sym = find_kernel_sym(name);
-      if (sym == 0)
-        return errors::Internal("VEOAsync: VE kernel not found for ", name);
+      Status s = issue_request(
+          stream,
+          [this, vh_buff, ve_addr, len](struct veo_thr_ctxt* ctx) {
+            return async_read_mem(ctx, vh_buff, ve_addr, len);
+          },
+          [this, trace, done](const Status& s, uint64_t retval) {
+            complete_copy(s, trace, 1, done); // 1: DtoH
+          },
+          flush_stack);
+      if (!s.ok())
+        done(s);
+    }
 
-      int ret;
+    virtual Status compute(uint64_t sym, const void* arg, size_t len,
+                           const OpKernel* op) override {
+      VLOG(2) << "VEOAsync::compute: sym=" << reinterpret_cast<void*>(sym);
+
+      std::string annotation;
       if (isTracerEnabled()) {
-        std::string annotation;
         if (op)
           annotation = strings::StrCat(op->name(), ":", op->type_string());
         else
-          annotation = name;
-        ret = currStack_->push(sym, arg, len, &annotation); 
-      } else {
-        ret = currStack_->push(sym, arg, len, nullptr); 
+          annotation = find_kernel_name(sym);
       }
 
-      if (ret != 0)
-        return errors::Internal("VEOAsync: Failed to push kernel");
+      for (;;) {
+        {
+          mutex_lock guard(lock_stack_);
+          if (push_locked(sym, arg, len,
+                          isTracerEnabled() ? &annotation : nullptr))
+            return Status::OK();
+        }
+
+        // The stack is full. Issue it, and then push the kernel again.
+        VLOG(2) << "VEOAsync::compute: issue the full stack";
+        mutex_lock guard_sync(lock_sync_);
+        TF_RETURN_IF_ERROR(issue_stack());
+      }
+    }
+
+    virtual Status sync() override {
+      std::vector<uint64_t> targets(streams_.size());
+      Status s;
+      {
+        // Only one thread can issue at once.
+        mutex_lock guard_sync(lock_sync_);
+        s = issue_stack();
+        for (size_t i = 0; i < streams_.size(); ++i) {
+          mutex_lock l(streams_[i]->mu);
+          targets[i] = streams_[i]->num_issued;
+        }
+      }
+
+      // wait for all requests issued before on all streams
+      for (size_t i = 0; i < streams_.size(); ++i) {
+        Stream* stream = streams_[i].get();
+        mutex_lock l(stream->mu);
+        while (stream->num_completed < targets[i])
+          stream->cond_completed.wait(l);
+      }
+
+      if (!s.ok())
+        return s;
+
+      // report an error of kernels completed asynchronously.
+      return take_error();
+    }
+
+  private:
+    typedef std::function<void(const Status&, uint64_t)> CompletionFn;
+
+    // A request issued to the VEO context. Requests are completed in the
+    // issued order because a context executes them in order.
+    struct Request {
+      uint64_t req_id;
+      CompletionFn fn;
+    };
+
+    // A VEO context and requests issued to it. Each stream has its own
+    // completion thread.
+    struct Stream {
+      struct veo_thr_ctxt* ctx;
+      mutex issue_mu; // serializes issues on copy streams
+      mutex mu;
+      condition_variable cond_requests;
+      condition_variable cond_completed;
+      std::deque<Request> requests; // guarded by mu
+      uint64_t num_issued = 0;      // guarded by mu
+      uint64_t num_completed = 0;   // guarded by mu
+      bool done = false;            // guarded by mu
+      std::unique_ptr<Thread> thread;
+    };
+
+    mutex lock_stack_;
+    mutex lock_sync_; // serializes issues on the compute stream
+
+    std::vector<KernelStack*> stack_pool_; // guarded by lock_stack_
+    KernelStack* currStack_ = nullptr;     // guarded by lock_stack_
+    size_t stack_size_;
+    size_t stack_max_size_;
+    int64 stack_pool_size_;
+
+    uint64_t sym_prof_;
+    uint64_t sym_noprof_;
+    uint64_t sym_pmc_ = 0; // 0 if performance counters are not read
+
+    int64 sampling_interval_ = 0;
+    double sampling_resolution_ = 0; // VE cycles per second
+    // Stacks are numbered from 1 in the issued order. The issued count is
+    // updated under lock_stack_ when the current stack is replaced, and the
+    // completed count by the completion thread of the compute stream.
+    std::atomic<uint64_t> num_issued_stacks_{0};
+    std::atomic<uint64_t> num_completed_stacks_{0};
+
+    // The stack which last wrote a buffer, keyed by its address. An entry
+    // can be stale once the buffer is freed; reads of buffers not written
+    // by a kernel since are then ordered with more kernels than needed,
+    // and writes by copies remove entries.
+    mutex lock_writers_;
+    std::unordered_map<uint64_t, uint64_t> writers_; // guarded by lock_writers_
+    static constexpr size_t kMaxWriters = 4096;
+
+    void record_writer(uint64_t ve_addr) override {
+      // The kernels are in the current stack or in an issued one.
+      uint64_t seq = num_issued_stacks_.load() + 1;
+      mutex_lock l(lock_writers_);
+      if (writers_.size() >= kMaxWriters) {
+        // Entries of completed stacks are only used to pick a copy stream.
+        uint64_t completed = num_completed_stacks_.load();
+        for (auto it = writers_.begin(); it != writers_.end();) {
+          if (it->second <= completed)
+            it = writers_.erase(it);
+          else
+            ++it;
+        }
+      }
+      writers_[ve_addr] = seq;
+    }
+
+    void forget_writer(uint64_t ve_addr) {
+      mutex_lock l(lock_writers_);
+      writers_.erase(ve_addr);
+    }
+
+    // Returns the stack which wrote ve_addr, or 0 if unknown.
+    uint64_t find_writer(uint64_t ve_addr) {
+      mutex_lock l(lock_writers_);
+      auto it = writers_.find(ve_addr);
+      return it == writers_.end() ? 0 : it->second;
+    }
+
+    // Exports kernel times of a sampled batch. `buf` is the output of
+    // vetfkl_entry_prof, a pair of cycles for each kernel, or of
+    // vetfkl_entry_pmc if `num_pmcs` is not 0.
+    void record_samples(const KernelStack* stack, const void* buf,
+                        int num_pmcs) {
+      const uint64_t* pcyc = reinterpret_cast<const uint64_t*>(buf);
+      const int stride = 2 + num_pmcs;
+      double us_per_cycle = 1e6 / sampling_resolution_;
+      ve_sampled_batches->GetCell()->IncrementBy(1);
+      for (int32_t i = 0; i < stack->num_kernels(); ++i) {
+        double us = (pcyc[i * stride + 1] - pcyc[i * stride]) * us_per_cycle;
+        const std::string name = find_kernel_name(stack->find_sym(i));
+        ve_kernel_count->GetCell(name)->IncrementBy(1);
+        ve_kernel_time_usecs->GetCell(name)->IncrementBy(
+            static_cast<int64>(us));
+        ve_kernel_time_usecs_histogram->GetCell(name)->Add(us);
+      }
+      record_pmcs(stack, buf, num_pmcs);
+    }
+
+    // Adds the performance counters in `buf` to ve_kernel_pmc.
+    void record_pmcs(const KernelStack* stack, const void* buf,
+                     int num_pmcs) {
+      if (num_pmcs == 0)
+        return;
+      const uint64_t* p = reinterpret_cast<const uint64_t*>(buf);
+      const int stride = 2 + num_pmcs;
+      for (int32_t i = 0; i < stack->num_kernels(); ++i) {
+        const std::string name = find_kernel_name(stack->find_sym(i));
+        for (int j = 0; j < num_pmcs; ++j) {
+          ve_kernel_pmc->GetCell(name, VEPmcs::Name(j))
+              ->IncrementBy(static_cast<int64>(p[i * stride + 2 + j]));
+        }
+      }
+    }
+
+    std::vector<std::unique_ptr<Stream>> streams_; // [0] is compute stream
+    std::atomic<uint64_t> next_copy_stream_{0};
+
+    std::unique_ptr<SharedCounter> timing_counter_;
+    uint64 safe_frontier_ = 0;  // guarded by lock_stack_
+    int stacks_in_flight_ = 0;  // guarded by lock_stack_
+
+    mutex lock_error_;
+    Status error_; // first error in kernels not reported yet
+    std::unique_ptr<thread::ThreadPool> callback_pool_;
+
+    Stream* compute_stream() { return streams_[0].get(); }
+
+    // Pushes a kernel to the current stack. Returns false when the stack
+    // is full. lock_stack_ has to be held.
+    bool push_locked(uint64_t sym, const void* arg, size_t len,
+                     const std::string* annotation) {
+      VLOG(2) << "VEOAsync::push_locked:"
+        << " num_kernels_in_stack=" << currStack_->num_kernels();
+      if (currStack_->push(sym, arg, len, annotation) != 0)
+        return false;
 
 #ifdef TF_VE_EXECUTOR
-      if (ve_executor_enabled_
-          && currStack_->num_kernels() >= ve_executor_threshold_) {
-        VLOG(2) << "VEOAsync::compute: notify executor";
-        executor_cond_.notify_all();
+      if (ve_executor_enabled_) {
+        // Notify the first kernel to start the deadline, and then when the
+        // stack is full enough.
+        if (currStack_->num_kernels() == 1) {
+          first_push_us_ = Env::Default()->NowMicros();
+          dispatcher_cond_.notify_one();
+        } else if (should_dispatch_locked()) {
+          VLOG(2) << "VEOAsync::compute: notify dispatcher";
+          dispatcher_cond_.notify_one();
+        }
       }
 #endif
+      return true;
+    }
+
+    // Returns the compute stream when there is no copy stream.
+    Stream* copy_stream() {
+      if (streams_.size() == 1)
+        return compute_stream();
+      uint64_t i = next_copy_stream_.fetch_add(1, std::memory_order_relaxed);
+      return streams_[1 + i % (streams_.size() - 1)].get();
+    }
+
+    void enqueue(Stream* stream, uint64_t req_id, CompletionFn fn) {
+      mutex_lock l(stream->mu);
+      stream->requests.push_back(Request{req_id, std::move(fn)});
+      ++stream->num_issued;
+      stream->cond_requests.notify_one();
+    }
+
+    // Issues a request by `issue` on `stream`. Kernels in the current stack
+    // are issued before the request on the compute stream to keep the
+    // order unless flush_stack is false, that is, the request does not
+    // depend on them.
+    Status issue_request(
+        Stream* stream,
+        const std::function<uint64_t(struct veo_thr_ctxt*)>& issue,
+        CompletionFn fn, bool flush_stack = true) {
+      bool is_compute = stream == compute_stream();
+      mutex_lock guard(is_compute ? lock_sync_ : stream->issue_mu);
+      if (is_compute && flush_stack)
+        TF_RETURN_IF_ERROR(issue_stack());
+
+      uint64_t req_id = issue(stream->ctx);
+      if (req_id == VEO_REQUEST_ID_INVALID)
+        return errors::Internal("VEOAsync: Failed to issue request");
 
+      enqueue(stream, req_id, std::move(fn));
       return Status::OK();
     }
 
-    virtual Status sync() override {
-      // Only one thread can sync at once.
-      mutex_lock guard_sync(lock_sync_);
+    void CompletionLoop(Stream* stream) {
+      VLOG(2) << "VEOAsync::CompletionLoop: begin";
+      for (;;) {
+        Request req;
+        {
+          mutex_lock l(stream->mu);
+          while (stream->requests.empty() && !stream->done)
+            stream->cond_requests.wait(l);
+          if (stream->requests.empty())
+            break;
+          req = std::move(stream->requests.front());
+          stream->requests.pop_front();
+        }
 
-      if (currStack_->num_kernels() == 0)
-        return Status::OK();
+        uint64_t retval = 0;
+        Status s = wait_on(stream->ctx, req.req_id, &retval);
+        req.fn(s, retval);
 
-      KernelStack* stack = currStack_;
-      KernelStack* nextStack;
-      if (stack_pool_.size() > 0) {
-          nextStack = stack_pool_.back();
-          stack_pool_.pop_back();
-      } else {
-        nextStack = new KernelStack(stack_size_);
+        mutex_lock l(stream->mu);
+        ++stream->num_completed;
+        stream->cond_completed.notify_all();
+      }
+      VLOG(2) << "VEOAsync::CompletionLoop: end";
+    }
+
+    void set_error(const Status& s) {
+      mutex_lock l(lock_error_);
+      if (error_.ok())
+        error_ = s;
+    }
+
+    Status take_error() {
+      mutex_lock l(lock_error_);
+      Status s = error_;
+      error_ = Status::OK();
+      return s;
+    }
+
+    // Called from a completion thread.
+    void complete_copy(const Status& s, const CopyTrace& trace, int type,
+                       StatusCallback done) {
+      if (s.ok() && isTracerEnabled())
+        callbackTracer(trace, Env::Default()->NowMicros(), type);
+
+      Status status = s;
+      if (status.ok()) {
+        // Data is not valid when preceding kernels were failed.
+        status = take_error();
       }
+      callback_pool_->Schedule([done, status]() { done(status); });
+    }
+
+#ifdef USE_DMA
+    // State of a copy issued as DMA requests of chunks.
+    struct DMACopy {
+      mutex mu;
+      Status status;
+      int pending = 1; // number of chunks in flight + 1 for the issuer
+      CopyTrace trace;
+      int type;
+      StatusCallback done;
+    };
 
+    void finish_dma_chunk(const std::shared_ptr<DMACopy>& copy,
+                          const Status& s) {
+      bool last;
+      {
+        mutex_lock l(copy->mu);
+        copy->status.Update(s);
+        last = --copy->pending == 0;
+      }
+      if (last)
+        complete_copy(copy->status, copy->trace, copy->type, copy->done);
+    }
+
+    // Issues DMA requests by chunks. A chunk is copied to a staging buffer
+    // while VE transfers previous chunks. For DtoH, the chunk is copied from
+    // the staging buffer to vh_buff on completion. `done` is called after
+    // all chunks are completed.
+    void issue_dma(Stream* stream, bool htod, uint64_t ve_addr, void* vh_buff,
+                   size_t len, CopyTrace trace, StatusCallback done,
+                   bool flush_stack = true) {
+      std::shared_ptr<DMACopy> copy = std::make_shared<DMACopy>();
+      copy->trace = std::move(trace);
+      copy->type = htod ? 0 : 1; // 0: HtoD, 1: DtoH
+      copy->done = std::move(done);
+
+      char* p = reinterpret_cast<char*>(vh_buff);
+      uint64_t sym = htod ? dma_.sym_dma_read : dma_.sym_dma_write;
+      Status status;
+
+      for (size_t off = 0; off < len; off += dma_.chunk_size) {
+        size_t size = std::min(dma_.chunk_size, len - off);
+
+        // Staging buffers are released by the completion thread.
+        int buf = acquire_dma_buf();
+        if (htod)
+          memcpy(dma_buf(buf), p + off, size);
+
+        // arguments are read by the VEO context when the request is executed.
+        std::shared_ptr<DMAArgs> a = std::make_shared<DMAArgs>(
+            ve_addr + off, size, dma_offset(buf), dma_.has_offset);
+
+        {
+          mutex_lock l(copy->mu);
+          ++copy->pending;
+        }
+        status = issue_request(
+            stream,
+            [this, sym, a](struct veo_thr_ctxt* ctx) {
+              return call_on(ctx, sym, a->args);
+            },
+            [this, copy, a, htod, p, off, size, buf](const Status& s,
+                                                     uint64_t retval) {
+              if (s.ok() && !htod)
+                memcpy(p + off, dma_buf(buf), size);
+              release_dma_buf(buf);
+              finish_dma_chunk(copy, s);
+            },
+            flush_stack);
+        if (!status.ok()) {
+          release_dma_buf(buf);
+          {
+            mutex_lock l(copy->mu);
+            --copy->pending;
+          }
+          break;
+        }
+      }
+
+      // release the issuer's count
+      finish_dma_chunk(copy, status);
+    }
+
+    // Issues DMA between VE and a host tensor in a segment of
+    // VEHostMemRegistry. No staging buffer is used.
+    void issue_dma_shm(Stream* stream, bool htod, uint64_t ve_addr,
+                       uint64_t shmid, uint64_t offset, size_t len,
+                       CopyTrace trace, StatusCallback done,
+                       bool flush_stack = true) {
+      std::shared_ptr<DMAShmArgs> a = std::make_shared<DMAShmArgs>(
+          ve_addr, len, shmid, offset);
+      uint64_t sym = htod ? dma_.sym_dma_read_shm : dma_.sym_dma_write_shm;
+      int type = htod ? 0 : 1; // 0: HtoD, 1: DtoH
+
+      Status s = issue_request(
+          stream,
+          [this, sym, a](struct veo_thr_ctxt* ctx) {
+            return call_on(ctx, sym, a->args);
+          },
+          [this, a, trace, type, done](const Status& s, uint64_t retval) {
+            complete_copy(s, trace, type, done);
+          },
+          flush_stack);
+      if (!s.ok())
+        done(s);
+    }
+#endif
+
+    // Issues kernels in the current stack as one request on the compute
+    // stream. lock_sync_ has to be held.
+    Status issue_stack() {
+      KernelStack* stack;
+      uint64 frontier;
+      uint64_t seq;
       {
         mutex_lock guard_stack(lock_stack_);
+        if (currStack_->num_kernels() == 0)
+          return Status::OK();
+
+        KernelStack* nextStack;
+        if (stack_pool_.size() > 0) {
+          nextStack = stack_pool_.back();
+          stack_pool_.pop_back();
+        } else {
+          nextStack = new KernelStack(stack_size_, stack_max_size_);
+        }
+        stack = currStack_;
         currStack_ = nextStack;
+
+        frontier = timing_counter_ ? timing_counter_->get() : 0;
+        ++stacks_in_flight_;
+        seq = ++num_issued_stacks_;
       }
 
       // here, curren thread is only one holder of the stack
 
-      // Set n again because new kernel might be pushed to the stack.
       int32_t n = stack->num_kernels();
-      VLOG(2) << "VEOAsync::sync: num_kernels=" << n;
+      VLOG(2) << "VEOAsync::issue_stack: num_kernels=" << n;
 
       size_t len = stack->size();
       void* buf = stack->buf();
       *reinterpret_cast<int32_t*>(buf) = n;
-      Status s;
-
-      uint64_t retval = 0;
-      if (isTracerEnabled()) {
-        size_t len_out = sizeof(double) + sizeof(uint64_t) * n * 2;
-        std::vector<char> buf_out(len_out);
-        Args args(buf, len, buf_out.data(), len_out);
-        s = call_and_wait(sym_prof_, args, &retval);
 
-        if (s.ok())
-          callbackTracer(stack->annotations(), buf_out.data());
+      std::shared_ptr<std::vector<char>> buf_out;
+      std::shared_ptr<Args> args;
+      uint64_t sym;
+      bool tracing = isTracerEnabled();
+      bool sampled = !tracing && sampling_interval_ > 0
+          && seq % sampling_interval_ == 0;
+      int num_pmcs = 0;
+      if (tracing || sampled) {
+        if (sym_pmc_ != 0)
+          num_pmcs = VEPmcs::kNumPmcs;
+        size_t len_out =
+            sizeof(double) + sizeof(uint64_t) * n * (2 + num_pmcs);
+        buf_out = std::make_shared<std::vector<char>>(len_out);
+        args = std::make_shared<Args>(buf, len, buf_out->data(), len_out);
+        sym = num_pmcs > 0 ? sym_pmc_ : sym_prof_;
       } else {
-        Args args(buf, len);
-        s = call_and_wait(sym_noprof_, args, &retval);
+        args = std::make_shared<Args>(buf, len);
+        sym = sym_noprof_;
       }
 
-      if (!s.ok()) {
-        int i = retval >> 32;
-        int rc = retval & 0xffffffff;
-        uint64_t sym = stack->find_sym(i);
-        std::string name = find_kernel_name(sym);
-        VLOG(2) << "VEOAsync::sync: retval=" << retval
-          << " i=" << i
-          << " rc=" << rc
-          << " sym=" << reinterpret_cast<void*>(sym)
-          << " name=" << name;
-        return errors::Internal("Failed in ", name, " Kernel on VE. rc=", rc);
+      const uint64_t submit_ns = tracing ? Env::Default()->NowNanos() : 0;
+      Stream* stream = compute_stream();
+      uint64_t req_id = call_on(stream->ctx, sym, *args);
+      if (req_id == VEO_REQUEST_ID_INVALID) {
+        release_stack(stack, frontier);
+        return errors::Internal("Failed to call kernel");
       }
+      ve_issued_batches->GetCell()->IncrementBy(1);
+
+      enqueue(stream, req_id,
+              [this, stack, args, buf_out, frontier, sampled, seq, num_pmcs,
+               submit_ns](const Status& s, uint64_t retval) {
+        if (s.ok()) {
+          if (sampled) {
+            record_samples(stack, buf_out->data(), num_pmcs);
+          } else if (buf_out) {
+            record_pmcs(stack, buf_out->data(), num_pmcs);
+            callbackTracer(stack->annotations(), stack->push_ns(), submit_ns,
+                           Env::Default()->NowNanos(), buf_out->data(),
+                           num_pmcs);
+          }
+        } else {
+          int i = retval >> 32;
+          int rc = retval & 0xffffffff;
+          uint64_t sym = stack->find_sym(i);
+          std::string name = find_kernel_name(sym);
+          VLOG(2) << "VEOAsync::issue_stack: retval=" << retval
+            << " i=" << i
+            << " rc=" << rc
+            << " sym=" << reinterpret_cast<void*>(sym)
+            << " name=" << name;
+          set_error(errors::Internal("Failed in ", name, " Kernel on VE. rc=", rc));
+        }
+        release_stack(stack, frontier);
+        num_completed_stacks_.store(seq);
+      });
 
-      stack->clear();
-      stack_pool_.push_back(stack);
-
-      VLOG(2) << "VEOAsync::sync: done num_kernels=" << n;
-      return s;
+      return Status::OK();
     }
 
-  private:
-    mutex lock_stack_;
-    mutex lock_sync_;
-
-    std::vector<KernelStack*> stack_pool_;
-    KernelStack* currStack_;
-    size_t stack_size_;
-
-    uint64_t sym_prof_;
-    uint64_t sym_noprof_;
+    // Stacks are completed in the issued order, so memory freed before
+    // `frontier` is not used by any pending kernel.
+    void release_stack(KernelStack* stack, uint64 frontier) {
+      stack->clear();
+      mutex_lock guard_stack(lock_stack_);
+      // stacks allocated while the pool was empty are not kept.
+      if (stack_pool_.size() + 1 < static_cast<size_t>(stack_pool_size_))
+        stack_pool_.push_back(stack);
+      else
+        delete stack;
+      --stacks_in_flight_;
+      safe_frontier_ = std::max(safe_frontier_, frontier);
+    }
 
 #ifdef TF_VE_EXECUTOR
+    // The dispatcher issues the current stack without waiting for sync()
+    // when it has ve_executor_threshold_ kernels or ve_executor_max_bytes_
+    // bytes, or when its first kernel has waited ve_executor_deadline_us_.
     bool ve_executor_enabled_ = false;
-    std::unique_ptr<Thread> thread_;
     int ve_executor_threshold_ = 1;
-    bool thread_done_ = false;
-    condition_variable executor_cond_;
-    mutex executor_mutex_;
-
-    Status Run() {
-      VLOG(2) << "VEExecturo: begin";
-      while (!thread_done_) {
-        if (currStack_->num_kernels() >= ve_executor_threshold_) {
-          VLOG(2) << "VEExecutor: sync";
-          sync();
-        } else {
-          VLOG(2) << "VEExecutor: sleep";
-          mutex_lock l(executor_mutex_);
-          executor_cond_.wait(l);
-          VLOG(2) << "VEExecutor: woke";
+    int64 ve_executor_max_bytes_;
+    int64 ve_executor_deadline_us_;
+    std::unique_ptr<Thread> dispatcher_thread_;
+    condition_variable dispatcher_cond_; // used with lock_stack_
+    bool dispatcher_done_ = false;       // guarded by lock_stack_
+    uint64 first_push_us_ = 0;           // guarded by lock_stack_
+
+    // lock_stack_ has to be held.
+    bool should_dispatch_locked() const {
+      return currStack_->num_kernels() >= ve_executor_threshold_
+          || static_cast<int64>(currStack_->size()) >= ve_executor_max_bytes_;
+    }
+
+    void DispatchLoop() {
+      VLOG(2) << "VEOAsync::DispatchLoop: begin";
+      for (;;) {
+        {
+          mutex_lock guard(lock_stack_);
+          for (;;) {
+            if (dispatcher_done_) {
+              VLOG(2) << "VEOAsync::DispatchLoop: end";
+              return;
+            }
+            if (currStack_->num_kernels() == 0) {
+              dispatcher_cond_.wait(guard);
+              continue;
+            }
+            if (should_dispatch_locked())
+              break;
+            uint64 now = Env::Default()->NowMicros();
+            uint64 deadline = first_push_us_ + ve_executor_deadline_us_;
+            if (now >= deadline)
+              break;
+            dispatcher_cond_.wait_for(
+                guard, std::chrono::microseconds(deadline - now));
+          }
         }
+
+        VLOG(2) << "VEOAsync::DispatchLoop: issue";
+        mutex_lock guard_sync(lock_sync_);
+        Status s = issue_stack();
+        if (!s.ok())
+          set_error(s);
       }
-      return Status::OK();
     }
 #endif
 };
@@ -593,7 +1773,7 @@ Status veo_sym_call(struct veo_proc_handle* proc,
     return errors::Internal("Failed to allocate arguments");
 
   uint64_t req_id = veo_call_async(ctx, sym, args.args);
-  //VLOG(2) << "VEO::load_kernel_syms: VEO request ID = " << req_id;
+  //VLOG(2) << "veo_sym_call: VEO request ID = " << req_id;
   if (req_id == VEO_REQUEST_ID_INVALID) {
     return errors::Internal("Failed to call VE");
   }
@@ -606,10 +1786,11 @@ Status veo_sym_call(struct veo_proc_handle* proc,
   return Status::OK();
 }
 
-Status load_kernel_syms(struct veo_proc_handle* proc,
-                        struct veo_thr_ctxt* ctx,
-                        uint64_t lib_id,
-                        std::map<std::string, uint64_t>& map)
+// Reads the kernel table of the library. Symbols are not resolved here.
+Status load_kernel_table(struct veo_proc_handle* proc,
+                         struct veo_thr_ctxt* ctx,
+                         uint64_t lib_id,
+                         std::unordered_map<std::string, std::string>& map)
 {
   Status s;
 
@@ -617,7 +1798,7 @@ Status load_kernel_syms(struct veo_proc_handle* proc,
   s = veo_sym_call(proc, ctx, lib_id, "get_num_kernels", &num_kernels);
   if (!s.ok())
     return s;
-  VLOG(2) << "VEO::load_kernel_syms: num_kernels=" << num_kernels;
+  VLOG(2) << "VEO::load_kernel_table: num_kernels=" << num_kernels;
 
   uint64_t addr;
   s = veo_sym_call(proc, ctx, lib_id, "get_kernel_table_addr", &addr);
@@ -627,21 +1808,18 @@ Status load_kernel_syms(struct veo_proc_handle* proc,
   struct kernel {
     char name[256];
     char func[256];
-  } table[num_kernels];
+  };
+  std::vector<kernel> table(num_kernels);
 
-  int ret = veo_read_mem(proc, table, addr, num_kernels * sizeof(kernel));
+  int ret = veo_read_mem(proc, table.data(), addr,
+                         num_kernels * sizeof(kernel));
   if (ret != 0)
     return errors::Internal("Failed to read mem");
 
-  for (uint64_t i = 0; i < num_kernels; ++i) {
-    uint64_t sym = veo_get_sym(proc, lib_id, table[i].func);
-    VLOG(2) << "VEO::load_kernel_syms:"
-      << " name=" << table[i].name
-      << " func=" << table[i].func
-      << " sym=" << (void*)sym;
-    if (!sym)
-      return errors::Internal("Failed to get symbol for ", table[i].func);
-    map[table[i].name] = sym;
+  for (const kernel& k : table) {
+    VLOG(2) << "VEO::load_kernel_table:"
+      << " name=" << k.name << " func=" << k.func;
+    map[k.name] = k.func;
   }
 
   return Status::OK();
@@ -652,7 +1830,7 @@ Status VEO::init_dma(veo_proc_handle* proc, uint64_t lib_id)
 {
   size_t size = 256 * 1024 * 1024;
   if (const char* tmp = getenv("TF_DMA_BUF_SIZE")) {
-    size = atoi(tmp);
+    size = strtoull(tmp, NULL, 0);
   }
   dma_.bufsize = size;
 
@@ -675,10 +1853,10 @@ Status VEO::init_dma(veo_proc_handle* proc, uint64_t lib_id)
     dma_.available = false;
     return Status::OK();
   }
-  dma_.available = true;
 
   dma_.shmptr = shmat(shmid, NULL, 0);
   if (dma_.shmptr == (void*)-1) {
+    dma_.shmptr = nullptr;
     return errors::Internal("shmat failed");
   }
 
@@ -694,12 +1872,42 @@ Status VEO::init_dma(veo_proc_handle* proc, uint64_t lib_id)
   VLOG(2) << "VEO::init: dma_threshold is " << dma_.threshold 
     << " bytes. Can be changed by TF_DMA_THRESHOLD"; 
 
-  dma_.sym_dma_read = veo_get_sym(proc, lib_id, "vetfkl_dma_read");
+  uint64_t sym_dma_read_at = veo_get_sym(proc, lib_id, "vetfkl_dma_read_at");
+  uint64_t sym_dma_write_at = veo_get_sym(proc, lib_id, "vetfkl_dma_write_at");
+  dma_.has_offset = sym_dma_read_at != 0 && sym_dma_write_at != 0;
+  if (dma_.has_offset) {
+    dma_.sym_dma_read = sym_dma_read_at;
+    dma_.sym_dma_write = sym_dma_write_at;
+  } else {
+    dma_.sym_dma_read = veo_get_sym(proc, lib_id, "vetfkl_dma_read");
+    dma_.sym_dma_write = veo_get_sym(proc, lib_id, "vetfkl_dma_write");
+  }
+
+  // Two or more buffers are required to overlap VH and VE copies.
+  dma_.num_bufs = 1;
+  if (dma_.has_offset) {
+    dma_.num_bufs = 4;
+    if (const char* tmp = getenv("TF_DMA_NUM_BUFS"))
+      dma_.num_bufs = std::max(atoi(tmp), 1);
+  }
+  const size_t kAlign = 4096;
+  dma_.chunk_size = size / dma_.num_bufs / kAlign * kAlign;
+  if (dma_.chunk_size == 0) {
+    dma_.num_bufs = 1;
+    dma_.chunk_size = size;
+  }
+  for (int i = 0; i < dma_.num_bufs; ++i)
+    dma_.free_bufs.push_back(i);
+
+  VLOG(2) << "VEO::init: DMA uses " << dma_.num_bufs << " buffers of "
+    << dma_.chunk_size << " bytes. Number of buffers can be changed by"
+    << " TF_DMA_NUM_BUFS";
 
   // call init_dma on VE
   uint64_t sym_dma_init = veo_get_sym(proc, lib_id, "vetfkl_dma_init");
 
   VLOG(2) << "VEO:init:: sym_dma_read=" << dma_.sym_dma_read;
+  VLOG(2) << "VEO:init:: sym_dma_write=" << dma_.sym_dma_write;
   VLOG(2) << "VEO:init:: sym_dma_init=" << sym_dma_init;
 
   struct {
@@ -711,7 +1919,27 @@ Status VEO::init_dma(veo_proc_handle* proc, uint64_t lib_id)
   tmp.size = size;
 
   Args a(&tmp, sizeof(tmp));
-  return call_and_wait(sym_dma_init, a);
+  Status s = call_and_wait(sym_dma_init, a);
+  if (!s.ok())
+    return s;
+
+  // DMA with host tensors allocated by VEHostMemAllocator. It is not
+  // provided by old VE kernel libraries.
+  dma_.sym_dma_register_shm = veo_get_sym(proc, lib_id, "vetfkl_dma_register_shm");
+  dma_.sym_dma_unregister_shm = veo_get_sym(proc, lib_id, "vetfkl_dma_unregister_shm");
+  if (dma_.sym_dma_register_shm != 0 && dma_.sym_dma_unregister_shm != 0) {
+    dma_.sym_dma_read_shm = veo_get_sym(proc, lib_id, "vetfkl_dma_read_shm");
+    dma_.sym_dma_write_shm = veo_get_sym(proc, lib_id, "vetfkl_dma_write_shm");
+    VEHostMemRegistry::Global()->AddRemoveListener(
+        [this](const VEHostMemRegistry::Segment& seg) {
+          unregister_host_shm(seg.shmid);
+        });
+  }
+  VLOG(2) << "VEO:init:: sym_dma_read_shm=" << dma_.sym_dma_read_shm
+    << " sym_dma_write_shm=" << dma_.sym_dma_write_shm;
+
+  dma_.available = true;
+  return Status::OK();
 }
 #endif // USE_DMA
 
@@ -737,7 +1965,7 @@ Status VEO::init(int nodeid) {
   VLOG(2) << "VEO::init: pid=" << proc_pid_ << " tid=" << syscall(SYS_gettid);
 #endif
 
-  uint64_t lib_id = 0UL;
+  uint64_t& lib_id = lib_id_;
   if( filename != NULL ) {
     lib_id = veo_load_library(proc_, filename);
     VLOG(2) << "VEO::init: lib_id=" << lib_id;
@@ -762,7 +1990,7 @@ Status VEO::init(int nodeid) {
   }
 #endif
 
-  return load_kernel_syms(proc_, ctx_, lib_id, kernel_map_);
+  return load_kernel_table(proc_, ctx_, lib_id, kernel_funcs_);
 }
 
 VEO::~VEO() {
@@ -770,10 +1998,93 @@ VEO::~VEO() {
   veo_context_close(ctx_);
   veo_proc_destroy(proc_);
 #ifdef USE_DMA
-  shmdt(dma_.shmptr);
+  if (dma_.shmptr)
+    shmdt(dma_.shmptr);
+#endif
+}
+
+Status VEO::benchmark(VEBenchmarkPath path, size_t size, int iters,
+                      uint64* elapsed_ns) {
+  // vetfkl_get_timestamp takes an output buffer and its length like
+  // kernels take their arguments, so it serves as a trivial kernel.
+  struct {
+    uint64_t ts;
+    double resolution;
+  } arg;
+
+  if (path == VEBenchmarkPath::kCall || path == VEBenchmarkPath::kBatchFlush) {
+    TF_RETURN_IF_ERROR(sync());
+    uint64 start = Env::Default()->NowNanos();
+    for (int i = 0; i < iters; ++i) {
+      if (path == VEBenchmarkPath::kCall) {
+        TF_RETURN_IF_ERROR(get_timestamp(&arg.ts, &arg.resolution));
+      } else {
+        for (size_t k = 0; k < size; ++k)
+          TF_RETURN_IF_ERROR(compute(sym_get_timestamp_, &arg, sizeof(arg),
+                                     nullptr));
+        TF_RETURN_IF_ERROR(sync());
+      }
+    }
+    *elapsed_ns = Env::Default()->NowNanos() - start;
+    return Status::OK();
+  }
+
+#ifdef USE_DMA
+  const bool has_dma = dma_.available
+      && (path != VEBenchmarkPath::kDMARead || dma_.sym_dma_write != 0);
+#else
+  const bool has_dma = false;
+#endif
+  if (!has_dma && (path == VEBenchmarkPath::kDMAWrite
+                   || path == VEBenchmarkPath::kDMARead))
+    return errors::Unimplemented("VE: DMA is not available");
+
+  uint64_t ve_addr = alloc_mem(std::max(size, size_t{1}));
+  if (ve_addr == 0)
+    return errors::ResourceExhausted("VE: failed to allocate ", size,
+                                     " bytes");
+  std::vector<char> buf(size);
+
+  Status s = sync();
+  uint64 start = Env::Default()->NowNanos();
+  for (int i = 0; s.ok() && i < iters; ++i) {
+    int rc = 0;
+    switch (path) {
+      case VEBenchmarkPath::kWrite:
+        s = write_mem(ve_addr, buf.data(), size);
+        break;
+      case VEBenchmarkPath::kRead:
+        s = read_mem(buf.data(), ve_addr, size);
+        break;
+      case VEBenchmarkPath::kVEOWrite:
+        rc = veo_write_mem(proc_, ve_addr, buf.data(), size);
+        break;
+      case VEBenchmarkPath::kVEORead:
+        rc = veo_read_mem(proc_, buf.data(), ve_addr, size);
+        break;
+#ifdef USE_DMA
+      case VEBenchmarkPath::kDMAWrite:
+        s = dma_transfer(true, ve_addr, buf.data(), size);
+        break;
+      case VEBenchmarkPath::kDMARead:
+        s = dma_transfer(false, ve_addr, buf.data(), size);
+        break;
 #endif
+      default:
+        s = errors::InvalidArgument("VE: unknown benchmark path");
+    }
+    if (rc != 0)
+      s = errors::Internal("VE: copy failed. rc=", rc);
+  }
+  *elapsed_ns = Env::Default()->NowNanos() - start;
+
+  free_mem(ve_addr);
+  return s;
 }
 
+// Allocates regions of BFCAllocator on VE. Since veo_alloc_mem does not take
+// an alignment, a region is over-allocated and aligned. The address from
+// veo_alloc_mem is kept on host to free the region.
 class VEMemAllocator : public SubAllocator {
   public:
     VEMemAllocator(VEO* veo) : SubAllocator({}, {}), veo_(veo) {}
@@ -783,43 +2094,320 @@ class VEMemAllocator : public SubAllocator {
 
   private:
     VEO* veo_;
+    mutex mu_;
+    // aligned address -> address returned by veo_alloc_mem
+    std::unordered_map<uint64_t, uint64_t> regions_ GUARDED_BY(mu_);
 };
 
 VEMemAllocator::~VEMemAllocator() {}
 
 void* VEMemAllocator::Alloc(size_t alignments, size_t num_bytes) {
   VLOG(2) << "VEMemAllocator::Alloc: alignments=" << alignments << " num_bytes=" << num_bytes;
-#if 0
-  return veo_->alloc_mem(num_bytes);
-#else
-#if 0
-  void* p = veo_->alloc_mem(num_bytes);
-  if (reinterpret_cast<uintptr_t>(p) % alignments != 0) {
-    VLOG(2) << "VEMemAllocator::Alloc: alignment error. addr=" << p;
-    return NULL;
-  }
-#endif
+  if (num_bytes == 0)
+    return nullptr;
 
-  size_t n = num_bytes + alignments + sizeof(uintptr_t);
-  uint64_t addr = veo_->alloc_mem(n);
-  uint64_t addr0 = (addr + sizeof(uint64_t) + alignments) & ~(alignments - 1);
+  uint64_t addr = veo_->alloc_mem(num_bytes + alignments - 1);
+  if (addr == 0)
+    return nullptr;
+  uint64_t addr0 = (addr + alignments - 1) & ~(alignments - 1);
   VLOG(2) << "VEMemAllocator::Alloc addr=" << std::hex << addr
     << " addr0=" << std::hex << addr0;
-  *reinterpret_cast<uint64_t*>(addr0 - sizeof(uint64_t)) = addr;
+
+  mutex_lock l(mu_);
+  regions_[addr0] = addr;
   return reinterpret_cast<void*>(addr0);
-#endif
 }
 
 void VEMemAllocator::Free(void* ptr, size_t num_bytes) {
   VLOG(2) << "VEMemAllocator::Free: ptr=" << ptr;
+  if (ptr == nullptr)
+    return;
 
-  uint64_t addr = reinterpret_cast<uintptr_t>(ptr) - sizeof(uint64_t);
+  uint64_t addr;
+  {
+    mutex_lock l(mu_);
+    auto it = regions_.find(reinterpret_cast<uint64_t>(ptr));
+    if (it == regions_.end()) {
+      LOG(ERROR) << "VEMemAllocator::Free: unknown address " << ptr;
+      return;
+    }
+    addr = it->second;
+    regions_.erase(it);
+  }
 
   VLOG(2) << "VEMemAllocator::Free: addr=" << std::hex << addr;
 
   veo_->free_mem(addr);
 }
 
+#ifdef USE_DMA
+// Allocates host memory from hugepage shm segments, which VE can DMA
+// directly. See VEHostMemRegistry. With numa_affinity, the pages come from
+// numa_node.
+class VEHostMemAllocator : public SubAllocator {
+  public:
+    VEHostMemAllocator(int numa_node, bool numa_affinity,
+                       const std::vector<Visitor>& alloc_visitors,
+                       const std::vector<Visitor>& free_visitors)
+      : SubAllocator(alloc_visitors, free_visitors), numa_node_(numa_node),
+        numa_affinity_(numa_affinity && port::NUMAEnabled()) {}
+    ~VEHostMemAllocator() override {}
+
+    void* Alloc(size_t alignment, size_t num_bytes) override;
+    void Free(void* ptr, size_t num_bytes) override;
+
+  private:
+    // Faults in the pages of a new segment from numa_node_.
+    void TouchOnNode(void* ptr, size_t size, size_t page_size);
+
+    const int numa_node_;
+    const bool numa_affinity_;
+};
+
+void VEHostMemAllocator::TouchOnNode(void* ptr, size_t size,
+                                     size_t page_size) {
+  // Pages of a shm segment are allocated when first touched, on the node of
+  // the touching thread, so touch them from a thread bound to numa_node_.
+  // That is a thread of its own, as the affinity of the calling thread can't
+  // be restored when it was not bound to a node.
+  const int numa_node = numa_node_;
+  // Deleting the thread joins it.
+  std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+      ThreadOptions(), "ve_host_mem_touch",
+      [numa_node, ptr, size, page_size]() {
+        port::NUMASetThreadNodeAffinity(numa_node);
+        for (size_t off = 0; off < size; off += page_size)
+          static_cast<volatile char*>(ptr)[off] = 0;
+      }));
+}
+
+void* VEHostMemAllocator::Alloc(size_t alignment, size_t num_bytes) {
+  if (num_bytes == 0)
+    return nullptr;
+
+  // Segments are aligned to hugepage, that is enough for alignment.
+  const size_t kHugePageSize = 2 * 1024 * 1024;
+  size_t size = (num_bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+  int shmid = shmget(IPC_PRIVATE, size, SHM_HUGETLB | IPC_CREAT | IPC_EXCL | 0600);
+  if (shmid != -1) {
+    void* ptr = shmat(shmid, NULL, 0);
+    shmctl(shmid, IPC_RMID, NULL);
+    if (ptr != (void*)-1) {
+      VLOG(2) << "VEHostMemAllocator::Alloc: shmid=" << shmid
+        << " size=" << size << " ptr=" << ptr;
+      if (numa_affinity_)
+        TouchOnNode(ptr, size, kHugePageSize);
+      VEHostMemRegistry::Global()->Add(
+          VEHostMemRegistry::Segment{reinterpret_cast<const char*>(ptr), size,
+                                     shmid});
+      VisitAlloc(ptr, numa_node_, size);
+      return ptr;
+    }
+  }
+
+  LOG_FIRST_N(WARNING, 1) << "VE: failed to allocate host memory from hugepage."
+    " Such memory is copied through the DMA staging buffer.";
+  void* ptr = numa_affinity_
+      ? port::NUMAMalloc(numa_node_, num_bytes, alignment)
+      : port::AlignedMalloc(num_bytes, alignment);
+  if (ptr != nullptr)
+    VisitAlloc(ptr, numa_node_, num_bytes);
+  return ptr;
+}
+
+void VEHostMemAllocator::Free(void* ptr, size_t num_bytes) {
+  if (ptr == nullptr)
+    return;
+  VEHostMemRegistry::Segment seg;
+  if (VEHostMemRegistry::Global()->Find(ptr, 1, &seg) && seg.ptr == ptr) {
+    VisitFree(ptr, numa_node_, seg.size);
+    VEHostMemRegistry::Global()->Remove(ptr);
+    shmdt(ptr);
+  } else {
+    VisitFree(ptr, numa_node_, num_bytes);
+    if (numa_affinity_)
+      port::NUMAFree(ptr, num_bytes);
+    else
+      port::AlignedFree(ptr);
+  }
+}
+#endif // USE_DMA
+
+// Per-process state for VE like GPUProcessState.
+class VEProcessState {
+  public:
+    static VEProcessState* singleton() {
+      static VEProcessState* instance = new VEProcessState;
+      return instance;
+    }
+
+    // Returns the allocator for host memory which VE can DMA directly. This
+    // is used for host tensors copied to and from VE, like
+    // GPUProcessState::GetGpuHostAllocator. The memory comes from the
+    // "ve_host_bfc" pool of ProcessState, which has an allocator per NUMA
+    // node when NUMA allocators are enabled.
+    Allocator* GetVEHostAllocator(int numa_node) {
+#ifdef USE_DMA
+      mutex_lock lock(mu_);
+      if (!ve_host_pool_) {
+        int64 ve_host_mem_limit_in_mb = -1;
+        Status status = ReadInt64FromEnvVar("TF_VE_HOST_MEM_LIMIT_IN_MB",
+                                            1LL << 16 /*64GB max by default*/,
+                                            &ve_host_mem_limit_in_mb);
+        if (!status.ok()) {
+          LOG(ERROR) << "GetVEHostAllocator: " << status.error_message();
+        }
+        int64 ve_host_mem_limit = ve_host_mem_limit_in_mb * (1LL << 20);
+
+        auto alloc_visitors = ve_host_alloc_visitors_;
+        auto free_visitors = ve_host_free_visitors_;
+        ve_host_pool_ = ProcessState::singleton()->GetPinnedHostMemoryPool(
+            "ve_host_bfc", ve_host_mem_limit,
+            [alloc_visitors, free_visitors](int node, bool numa_affinity) {
+              return new VEHostMemAllocator(node, numa_affinity,
+                                            alloc_visitors, free_visitors);
+            });
+      }
+      return ve_host_pool_->GetAllocator(numa_node);
+#else
+      return ProcessState::singleton()->GetCPUAllocator(numa_node);
+#endif
+    }
+
+    // See AddVEHostMemVisitors.
+    bool AddVEHostMemVisitors(const SubAllocator::Visitor& alloc_visitor,
+                              const SubAllocator::Visitor& free_visitor) {
+#ifdef USE_DMA
+      mutex_lock lock(mu_);
+      if (ve_host_pool_)
+        return false;
+      ve_host_alloc_visitors_.push_back(alloc_visitor);
+      ve_host_free_visitors_.push_back(free_visitor);
+      return true;
+#else
+      // Host tensors come from the CPU allocators.
+      return true;
+#endif
+    }
+
+  private:
+    VEProcessState() {}
+
+    mutex mu_;
+    PinnedHostMemoryPool* ve_host_pool_ = nullptr;  // Owned by ProcessState.
+    std::vector<SubAllocator::Visitor> ve_host_alloc_visitors_;
+    std::vector<SubAllocator::Visitor> ve_host_free_visitors_;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(VEProcessState);
+};
+
+// Constants of Const kernels uploaded to each VE, shared by the VE devices of
+// all sessions in the process. Sessions which load the same frozen model,
+// e.g. other versions of the model or other tenants, then share one copy of
+// its weights on VE instead of each uploading its own. A constant is found by
+// a fingerprint of its type, shape and content. Sharing is safe because a
+// buffer with more than one reference is never forwarded to an output.
+//
+// Only constants too large to pack are cached, which are the ones that take
+// memory and upload time. Entries no longer used by any session are kept for
+// later sessions up to TF_VE_CONST_CACHE_IDLE_BYTES, least recently used
+// first. TF_VE_CONST_CACHE=false disables the cache.
+class VEConstCache {
+  public:
+    // Returns nullptr when the cache is disabled.
+    static VEConstCache* Global() {
+      static VEConstCache* instance = []() -> VEConstCache* {
+        bool enabled;
+        TF_CHECK_OK(ReadBoolFromEnvVar("TF_VE_CONST_CACHE", true, &enabled));
+        if (!enabled)
+          return nullptr;
+        int64 max_idle_bytes;
+        TF_CHECK_OK(ReadInt64FromEnvVar("TF_VE_CONST_CACHE_IDLE_BYTES",
+                                        1LL << 30, &max_idle_bytes));
+        VLOG(2) << "VEConstCache: max_idle_bytes=" << max_idle_bytes;
+        return new VEConstCache(max_idle_bytes);
+      }();
+      return instance;
+    }
+
+    // Returns the key of `host` uploaded to /device:VE:`device_id`.
+    static string Key(int device_id, const Tensor& host) {
+      Fprint128 fp = Fingerprint128(host.tensor_data());
+      return strings::StrCat(device_id, ";", host.dtype(), ";",
+                             host.shape().DebugString(), ";",
+                             strings::Hex(fp.high64), ";",
+                             strings::Hex(fp.low64));
+    }
+
+    bool Lookup(const string& key, Tensor* tensor) {
+      mutex_lock l(mu_);
+      auto it = entries_.find(key);
+      if (it == entries_.end())
+        return false;
+      it->second.last_use = ++clock_;
+      *tensor = it->second.tensor;
+      ve_const_cache_hit_bytes->GetCell()->IncrementBy(tensor->TotalBytes());
+      return true;
+    }
+
+    void Insert(const string& key, const Tensor& tensor) {
+      mutex_lock l(mu_);
+      Entry& entry = entries_[key];
+      entry.tensor = tensor;
+      entry.last_use = ++clock_;
+      EvictLocked();
+    }
+
+    // Drops idle entries over the limit, e.g. after a session is closed.
+    void Trim() {
+      mutex_lock l(mu_);
+      EvictLocked();
+    }
+
+  private:
+    struct Entry {
+      Tensor tensor;
+      uint64 last_use = 0;
+    };
+    typedef std::unordered_map<string, Entry> EntryMap;
+
+    explicit VEConstCache(int64 max_idle_bytes)
+        : max_idle_bytes_(max_idle_bytes) {}
+
+    void EvictLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      // An entry is idle when only the cache references it. Sessions only
+      // get references through Lookup, so an idle entry stays idle here.
+      std::vector<EntryMap::iterator> idle;
+      int64 idle_bytes = 0;
+      for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->second.tensor.RefCountIsOne()) {
+          idle.push_back(it);
+          idle_bytes += it->second.tensor.TotalBytes();
+        }
+      }
+      if (idle_bytes <= max_idle_bytes_)
+        return;
+      std::sort(idle.begin(), idle.end(),
+                [](EntryMap::iterator a, EntryMap::iterator b) {
+                  return a->second.last_use < b->second.last_use;
+                });
+      for (EntryMap::iterator it : idle) {
+        if (idle_bytes <= max_idle_bytes_)
+          break;
+        idle_bytes -= it->second.tensor.TotalBytes();
+        VLOG(2) << "VEConstCache: evict " << it->first;
+        entries_.erase(it);
+      }
+    }
+
+    const int64 max_idle_bytes_;
+    mutex mu_;
+    EntryMap entries_ GUARDED_BY(mu_);
+    uint64 clock_ GUARDED_BY(mu_) = 0;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(VEConstCache);
+};
+
 
 class VEBFCAllocator : public BFCAllocator {
   public:
@@ -853,6 +2441,17 @@ class VEDeviceContextImpl : public VEDeviceContext {
     virtual Status Compute(const std::string& name, const void* arg, size_t len,
                            const OpKernel* op);
 
+    uint64_t LookupKernel(const std::string& name) override {
+      return veo_->lookup_kernel(name);
+    }
+
+    Status Compute(uint64_t kernel, const void* arg, size_t len,
+                   const OpKernel* op) override {
+      return veo_->compute(kernel, arg, len, op);
+    }
+
+    VEO* veo() const { return veo_; }
+
   private:
     VEO* veo_;
 };
@@ -860,25 +2459,57 @@ class VEDeviceContextImpl : public VEDeviceContext {
 class VEDevice : public LocalDevice {
   public:
     VEDevice(const SessionOptions& options, const string name,
+             Bytes memory_limit,
              Allocator* ve_allocator,
-             Allocator* cpu_allocator) :
+             Allocator* cpu_allocator,
+             const DeviceLocality& locality,
+             const string& physical_device_desc) :
       LocalDevice(options,
                   Device::BuildDeviceAttributes(name, "VE",
-                                                Bytes(256 << 20),
-                                                DeviceLocality())),
+                                                memory_limit,
+                                                locality,
+                                                physical_device_desc)),
       ve_allocator_(ve_allocator),
-      cpu_allocator_(cpu_allocator) {}
+      cpu_allocator_(cpu_allocator),
+      scoped_allocator_mgr_(new ScopedAllocatorMgr(name)) {}
 
     ~VEDevice() override;
 
     Status Init(const SessionOptions& options, VEO* veo);
     Status Sync() override;
 
+    void Compute(OpKernel* op_kernel, OpKernelContext* context) override;
+    void ComputeAsync(AsyncOpKernel* op_kernel, OpKernelContext* context,
+                      AsyncOpKernel::DoneCallback done) override;
+
+    uint64 SafeAllocFrontier(uint64 old_value) override;
+
     Allocator* GetAllocator(AllocatorAttributes attr) override {
-      if (attr.on_host())
+      if (attr.on_host()) {
+        if (attr.gpu_compatible())
+          return VEProcessState::singleton()->GetVEHostAllocator(
+              attributes().locality().numa_node());
         return cpu_allocator_;
-      else
+      } else {
         return ve_allocator_;
+      }
+    }
+
+    // Scoped allocators let many small outputs, such as gradients, share one
+    // VE buffer so that they can be moved with a single copy.
+    Allocator* GetScopedAllocator(AllocatorAttributes attr,
+                                  int64 step_id) override {
+      if (attr.scope_id > 0) {
+        return scoped_allocator_mgr_->GetContainer(step_id)->GetInstance(
+            attr.scope_id);
+      }
+      LOG(FATAL) << "Unexpected call to VEDevice::GetScopedAllocator "
+                 << "attr.scope_id = " << attr.scope_id;
+      return ve_allocator_;
+    }
+
+    ScopedAllocatorMgr* GetScopedAllocatorMgr() const override {
+      return scoped_allocator_mgr_.get();
     }
 
     Status MakeTensorFromProto(const TensorProto& tensor_proto,
@@ -888,11 +2519,41 @@ class VEDevice : public LocalDevice {
   protected:
     Allocator* ve_allocator_;
     Allocator* cpu_allocator_;
+    std::unique_ptr<ScopedAllocatorMgr> scoped_allocator_mgr_;
 
   private:
+    // Records outputs of a kernel as written by the kernels pushed so far,
+    // so that a copy of an output to the host does not wait for kernels
+    // pushed later.
+    void RecordWriters(OpKernelContext* context);
+
+    VEO* veo_ = nullptr;
+    bool timestamped_allocator_ = false;
+    std::unique_ptr<thread::ThreadPool> thread_pool_;
     GpuDeviceInfo* gpu_device_info_;
     std::vector<VEDeviceContextImpl*> device_contexts_;
 
+    // Small constants are packed into one host buffer while kernels are
+    // created, and uploaded with one copy when the first kernel runs. The
+    // copy goes to a temporary buffer on VE, and Snapshot kernels scatter
+    // it to the constants.
+    struct PendingConst {
+      uint64_t dst;
+      size_t offset;
+      size_t size;
+    };
+    int64 const_pack_max_bytes_ = 0;  // 0 disables packing
+    int64 const_pack_size_ = 0;
+    mutex const_mu_;
+    std::string const_pack_;                    // guarded by const_mu_
+    std::vector<PendingConst> pending_consts_;  // guarded by const_mu_
+    std::atomic<bool> has_pending_consts_{false};
+
+    Status PackConst(const AllocatorAttributes& alloc_attrs,
+                     const Tensor& from, Tensor* to);
+    Status FlushConsts();
+    Status FlushConstsLocked() EXCLUSIVE_LOCKS_REQUIRED(const_mu_);
+
     // This method returns an initialization status, in addition to
     // calling the "done" StatusCallback, if there is a failure to
     // allocate memory or if the tensor "from" is not DMA-copyable.
@@ -906,14 +2567,67 @@ class VEDevice : public LocalDevice {
 VEDevice::~VEDevice() {
   delete gpu_device_info_;
   for (auto ctx : device_contexts_) ctx->Unref();
+  // Kernels of the session are gone, so its constants may be idle now.
+  if (VEConstCache* const_cache = VEConstCache::Global())
+    const_cache->Trim();
 }
 
 Status VEDevice::Init(const SessionOptions& options, VEO* veo) {
   VLOG(2) << "VEDevice::Init";
+  veo_ = veo;
   device_contexts_.push_back(new VEDeviceContextImpl(veo));
 
+  // Copies to memory allocated with freed_by_func can run on copy streams.
+  if (SharedCounter* timing_counter = veo->timing_counter()) {
+    static_cast<BFCAllocator*>(ve_allocator_)->SetTimingCounter(
+        timing_counter);
+    timestamped_allocator_ = true;
+  }
+
   VLOG(2) << "VEDevice::Init DeviceContext=" << device_contexts_.back();
 
+  // Issuing a kernel only pushes it to the current stack, so VE kernels are
+  // inlined on the executor thread. The rest (async kernels and nodes that
+  // the executor does not inline) runs on:
+  //   * global: the inter-op thread pool shared with CPU ops. (default)
+  //   * ve_private: threads dedicated to this device.
+  //   * ve_shared: threads shared by all VE devices.
+  string ve_thread_mode;
+  TF_RETURN_IF_ERROR(
+      ReadStringFromEnvVar("TF_VE_THREAD_MODE", "global", &ve_thread_mode));
+  ve_thread_mode = str_util::Lowercase(ve_thread_mode);
+  if (ve_thread_mode != "global") {
+    int64 ve_thread_count;
+    TF_RETURN_IF_ERROR(
+        ReadInt64FromEnvVar("TF_VE_THREAD_COUNT", 2, &ve_thread_count));
+    if (ve_thread_mode == "ve_private") {
+      thread_pool_.reset(new thread::ThreadPool(
+          options.env, ThreadOptions(),
+          strings::StrCat("ve_private_", parsed_name().id),
+          static_cast<int32>(ve_thread_count),
+          !options.config.experimental().disable_thread_spinning(),
+          /*allocator=*/nullptr));
+      set_tensorflow_device_thread_pool(thread_pool_.get());
+    } else if (ve_thread_mode == "ve_shared") {
+      static thread::ThreadPool* thread_pool = new thread::ThreadPool(
+          options.env, ThreadOptions(), "ve_shared",
+          static_cast<int32>(ve_thread_count),
+          !options.config.experimental().disable_thread_spinning(),
+          /*allocator=*/nullptr);
+      set_tensorflow_device_thread_pool(thread_pool);
+    } else {
+      return errors::InvalidArgument("Invalid TF_VE_THREAD_MODE: ",
+                                     ve_thread_mode);
+    }
+  }
+
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_VE_CONST_PACK_MAX_BYTES",
+                                         64 * 1024, &const_pack_max_bytes_));
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_VE_CONST_PACK_SIZE",
+                                         4 * 1024 * 1024, &const_pack_size_));
+  VLOG(2) << "VEDevice::Init: const_pack_max_bytes=" << const_pack_max_bytes_
+    << " const_pack_size=" << const_pack_size_;
+
   gpu_device_info_ = new GpuDeviceInfo;
   gpu_device_info_->default_context = device_contexts_[0];
   set_tensorflow_gpu_device_info(gpu_device_info_);
@@ -941,11 +2655,9 @@ Status VEDevice::MaybeCopyTensorToVE(
       safe_alloc_frontier = SafeAllocFrontier(safe_alloc_frontier);
       return safe_alloc_frontier;
     };
-#if 0
     if (timestamped_allocator_) {
       allocation_attr.freed_by_func = &freed_by_func;
     }
-#endif
     auto* copy = new Tensor(GetAllocator(alloc_attrs), from.dtype(),
                             from.shape(), allocation_attr);
 
@@ -969,9 +2681,94 @@ Status VEDevice::MaybeCopyTensorToVE(
 
 //    tracing::ScopedAnnotation annotation("MakeTensorFromProto");
     device_contexts_[0]->CopyCPUTensorToDevice(
-        &from, this, copy, std::move(wrapped_done) );
+        &from, this, copy, std::move(wrapped_done),
+        !timestamped_allocator_ /*sync_dst_compute*/);
+    return Status::OK();
+  }
+}
+
+Status VEDevice::PackConst(const AllocatorAttributes& alloc_attrs,
+                           const Tensor& from, Tensor* to) {
+  // The scatter runs on the compute stream, so the buffer is allocated
+  // without freed_by_func.
+  Tensor copy(GetAllocator(alloc_attrs), from.dtype(), from.shape());
+  if (!copy.IsInitialized()) {
+    return errors::ResourceExhausted(
+        "OOM when allocating tensor of shape ", from.shape().DebugString(),
+        " and type ", DataTypeString(from.dtype()));
+  }
+
+  size_t size = from.TotalBytes();
+  mutex_lock l(const_mu_);
+  if (const_pack_.size() + size > static_cast<size_t>(const_pack_size_))
+    TF_RETURN_IF_ERROR(FlushConstsLocked());
+  // Keep each constant 8-byte aligned in the pack.
+  size_t offset = (const_pack_.size() + 7) & ~size_t{7};
+  const_pack_.resize(offset + size);
+  memcpy(&const_pack_[offset], DMAHelper::base(&from), size);
+  pending_consts_.push_back(PendingConst{
+      reinterpret_cast<uint64_t>(DMAHelper::base(&copy)), offset, size});
+  has_pending_consts_ = true;
+  *to = std::move(copy);
+  return Status::OK();
+}
+
+Status VEDevice::FlushConsts() {
+  if (!has_pending_consts_)
+    return Status::OK();
+  mutex_lock l(const_mu_);
+  return FlushConstsLocked();
+}
+
+Status VEDevice::FlushConstsLocked() {
+  if (pending_consts_.empty())
     return Status::OK();
+  VLOG(2) << "VEDevice::FlushConsts: num_consts=" << pending_consts_.size()
+    << " bytes=" << const_pack_.size();
+
+  std::vector<PendingConst> consts;
+  consts.swap(pending_consts_);
+  has_pending_consts_ = false;
+  int64 size = const_pack_.size();
+
+  AllocatorAttributes host_attr;
+  host_attr.set_on_host(true);
+  host_attr.set_gpu_compatible(true);
+  Tensor* host = new Tensor(GetAllocator(host_attr), DT_INT8,
+                            TensorShape({size}));
+  Tensor staging(GetAllocator(AllocatorAttributes()), DT_INT8,
+                 TensorShape({size}));
+  if (!host->IsInitialized() || !staging.IsInitialized()) {
+    delete host;
+    const_pack_.clear();
+    return errors::ResourceExhausted(
+        "OOM when allocating ", size, " bytes to upload constants");
+  }
+  memcpy(DMAHelper::base(host), const_pack_.data(), size);
+  const_pack_.clear();
+
+  // The copy and the kernels are ordered on the compute stream, and the
+  // staging buffer can be freed once they are issued.
+  device_contexts_[0]->CopyCPUTensorToDevice(
+      host, this, &staging,
+      [host](const Status& s) {
+        if (!s.ok())
+          LOG(ERROR) << "VE: failed to upload constants: " << s;
+        delete host;
+      },
+      true /*sync_dst_compute*/);
+
+  uint64_t base = reinterpret_cast<uint64_t>(DMAHelper::base(&staging));
+  for (const PendingConst& c : consts) {
+    struct {
+      uint64_t dst, src;
+      size_t size;
+    } args = {c.dst, base + c.offset, c.size};
+    Status s = veo_->compute("Snapshot", &args, sizeof(args), nullptr);
+    if (!s.ok())
+      return s;
   }
+  return Status::OK();
 }
 
 Status VEDevice::MakeTensorFromProto(const TensorProto& tensor_proto,
@@ -981,7 +2778,8 @@ Status VEDevice::MakeTensorFromProto(const TensorProto& tensor_proto,
       (pending_op_name != nullptr ? pending_op_name : "MakeTensorFromProto"));
   AllocatorAttributes attr;
   attr.set_on_host(true);
-//  attr.set_gpu_compatible(true);
+  // parse into host memory which VE can DMA directly
+  attr.set_gpu_compatible(true);
   Allocator* host_alloc = GetAllocator(attr);
   Tensor parsed(tensor_proto.dtype());
   if (!parsed.FromProto(host_alloc, tensor_proto)) {
@@ -1028,6 +2826,24 @@ Status VEDevice::MakeTensorFromProto(const TensorProto& tensor_proto,
     *tensor = std::move(copy);
     return copy_status;
   } else {
+    if (!alloc_attrs.on_host() && DMAHelper::CanUseDMA(&parsed) &&
+        parsed.TotalBytes() > 0 &&
+        static_cast<int64>(parsed.TotalBytes()) <= const_pack_max_bytes_)
+      return PackConst(alloc_attrs, parsed, tensor);
+
+    VEConstCache* const_cache = nullptr;
+    string key;
+    if ((alloc_attrs.value & kVESharedConstAttribute) &&
+        !alloc_attrs.on_host() && DMAHelper::CanUseDMA(&parsed) &&
+        parsed.TotalBytes() > 0) {
+      const_cache = VEConstCache::Global();
+    }
+    if (const_cache) {
+      key = VEConstCache::Key(parsed_name().id, parsed);
+      if (const_cache->Lookup(key, tensor))
+        return Status::OK();
+    }
+
     Notification n;
     Status status;
     TF_RETURN_IF_ERROR(MaybeCopyTensorToVE(alloc_attrs, parsed, tensor,
@@ -1036,107 +2852,309 @@ Status VEDevice::MakeTensorFromProto(const TensorProto& tensor_proto,
                                               n.Notify();
                                             }));
     n.WaitForNotification();
+    if (status.ok() && const_cache)
+      const_cache->Insert(key, *tensor);
     return status;
   }
 }
 
+// Returns VE node numbers visible to this process. /device:VE:N is mapped
+// to the N-th entry. VE_NODE_NUMBER can be a comma separated list of node
+// numbers, and a negative number disables VE. When VE_NODE_NUMBER is not set,
+// all nodes found as /dev/veslotN are used.
+std::vector<int> GetVisibleVENodeIds() {
+  std::vector<int> nodeids;
+
+  if (const char* tmp = getenv("VE_NODE_NUMBER")) {
+    for (const string& str : str_util::Split(tmp, ',')) {
+      int32 nodeid;
+      if (!strings::safe_strto32(str, &nodeid)) {
+        LOG(WARNING) << "VE: ignore invalid node number in VE_NODE_NUMBER: "
+          << str;
+        continue;
+      }
+      if (nodeid < 0) // user disables VE
+        return {};
+      nodeids.push_back(nodeid);
+    }
+    return nodeids;
+  }
+
+  const int kMaxVENodes = 64;
+  for (int i = 0; i < kMaxVENodes; ++i) {
+    if (Env::Default()->FileExists(strings::StrCat("/dev/veslot", i)).ok())
+      nodeids.push_back(i);
+  }
+
+  // Use node 0 as before when device files are not visible, ex. in a
+  // container. veo_proc_create reports an error if it does not exist.
+  if (nodeids.empty())
+    nodeids.push_back(0);
+
+  return nodeids;
+}
+
+// Returns the size of HBM on VE node `nodeid` reported by the VE driver in
+// bytes, or 0 when it is not available.
+int64 GetVEMemorySize(int nodeid) {
+  string str;
+  Status s = ReadFileToString(
+      Env::Default(), strings::StrCat("/sys/class/ve/ve", nodeid, "/memory_size"),
+      &str);
+  int64 size_in_gb;
+  if (!s.ok() || !strings::safe_strto64(str, &size_in_gb) || size_in_gb <= 0)
+    return 0;
+  return size_in_gb << 30;
+}
+
+// Returns the NUMA node of the host that VE node `nodeid` is attached to, or 0
+// when it is not available.
+int GetVENumaNode(int nodeid) {
+  string str;
+  Status s = ReadFileToString(
+      Env::Default(),
+      strings::StrCat("/sys/class/ve/ve", nodeid, "/device/numa_node"), &str);
+  int32 numa_node;
+  if (!s.ok() || !strings::safe_strto32(str, &numa_node) || numa_node < 0)
+    return 0;
+  return numa_node;
+}
+
+// Returns the number of cores of VE node `nodeid`, or 0 when it is not
+// available.
+int GetVENumCores(int nodeid) {
+  string str;
+  Status s = ReadFileToString(
+      Env::Default(),
+      strings::StrCat("/sys/class/ve/ve", nodeid, "/num_of_core"), &str);
+  int32 num_cores;
+  if (!s.ok() || !strings::safe_strto32(str, &num_cores) || num_cores < 0)
+    return 0;
+  return num_cores;
+}
+
+// Returns the memory limit of the BFC allocator of VE node `nodeid`.
+// TF_VE_MEMORY_LIMIT_IN_MB has priority over TF_VE_MEMORY_FRACTION that is
+// a fraction of HBM on the node.
+Status GetVEMemoryLimit(int nodeid, int64* memory_limit) {
+  int64 limit_in_mb;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_VE_MEMORY_LIMIT_IN_MB", 0,
+                                         &limit_in_mb));
+  if (limit_in_mb > 0) {
+    *memory_limit = limit_in_mb * (1LL << 20);
+    return Status::OK();
+  }
+
+  float fraction;
+  TF_RETURN_IF_ERROR(ReadFloatFromEnvVar("TF_VE_MEMORY_FRACTION", 0.9,
+                                         &fraction));
+  if (fraction <= 0 || fraction > 1)
+    return errors::InvalidArgument("TF_VE_MEMORY_FRACTION must be in (0, 1]",
+                                   " but ", fraction);
+
+  int64 total_memory = GetVEMemorySize(nodeid);
+  if (total_memory == 0) {
+    total_memory = 20LL << 30;
+    LOG(WARNING) << "VE: failed to get the memory size of VE node " << nodeid
+      << ". Assume " << (total_memory >> 30) << "GB";
+  }
+  *memory_limit = static_cast<int64>(total_memory * fraction);
+  return Status::OK();
+}
+
+// Holds one VEO, that is one VE process, per visible VE node.
 class VEOFactory {
   public:
-    Status GetOrCreate(VEO** pveo, int nodeid) {
-      mutex_lock guard(lock_);
-
-      if (!veo_) {
+    Status GetOrCreate(VEO** pveo, int device_id) {
+      if (device_id < 0 || device_id >= NumDevices())
+        return errors::InvalidArgument("VE:", device_id, " does not exist."
+                                       " Number of visible VEs is ",
+                                       nodeids_.size());
+
+      // Only the same device is serialized, so nodes can be initialized in
+      // parallel.
+      Entry& entry = *entries_[device_id];
+      mutex_lock guard(entry.mu);
+      VEO* veo = entry.veo;
+      if (!veo) {
 #if defined(VEO_ASYNC)
         if (getenv("TF_VE_SYNC")) {
           VLOG(2) << "use VEO (not VEOAsync) because TF_VEO_SYNC is set";
-          veo_ = new VEO;
+          veo = new VEO(device_id);
         } else {
-          veo_ = new VEOAsync;
+          veo = new VEOAsync(device_id);
         }
 #else
-        veo_ = new VEO;
+        veo = new VEO(device_id);
 #endif
-        Status s = veo_->init(nodeid);
-        if (!s.ok())
-          return s;
+        entry.veo = veo;
+        entry.status = veo->init(nodeids_[device_id]);
       }
+      TF_RETURN_IF_ERROR(entry.status);
+
+      *pveo = veo;
+      return Status::OK();
+    }
 
-      *pveo = veo_;
+    // Creates VEOs of the first `n` devices. Each VE process is created and
+    // initialized on its own thread since that takes a while per node.
+    Status CreateAll(int n) {
+      std::vector<Status> status(n);
+      {
+        std::vector<std::unique_ptr<Thread>> threads;
+        for (int i = 0; i < n; ++i) {
+          threads.emplace_back(Env::Default()->StartThread(
+                  ThreadOptions(), strings::StrCat("ve_init_", i),
+                  [this, i, &status]() {
+                    VEO* veo;
+                    status[i] = GetOrCreate(&veo, i);
+                  }));
+        }
+      }
+      for (const Status& s : status)
+        TF_RETURN_IF_ERROR(s);
       return Status::OK();
     }
 
+    int NumDevices() const { return nodeids_.size(); }
+    int NodeId(int device_id) const { return nodeids_[device_id]; }
+
     static VEOFactory* Global() {
       static VEOFactory* instance = new VEOFactory;
       return instance;
     }
 
   private:
-    mutex lock_;
-    VEO* veo_ = NULL;
+    struct Entry {
+      mutex mu;
+      VEO* veo = nullptr;  // guarded by mu
+      Status status;       // guarded by mu
+    };
 
-    VEOFactory() = default;
+    const std::vector<int> nodeids_;
+    std::vector<std::unique_ptr<Entry>> entries_;
+
+    VEOFactory() : nodeids_(GetVisibleVENodeIds()) {
+      for (size_t i = 0; i < nodeids_.size(); ++i)
+        entries_.emplace_back(new Entry);
+    }
     TF_DISALLOW_COPY_AND_ASSIGN(VEOFactory);
 };
 
 Status VEDevice::Sync() {
   VLOG(2) << "VEDevice::Sync";
-  VEO* veo = NULL;
-  int nodeid = 0; // FIXME
-  Status s = VEOFactory::Global()->GetOrCreate(&veo, nodeid);
-  if (!s.ok())
-    return s;
-
-  return veo->sync();
+  TF_RETURN_IF_ERROR(FlushConsts());
+  return veo_->sync();
 }
 
-class VEDeviceFactory : public DeviceFactory {
-  Status CreateDevices(const SessionOptions& options, const string& name_prefix,
-                       std::vector<std::unique_ptr<Device>>* devices) override {
-    const string device_name = strings::StrCat(name_prefix, "/device:VE:0");
-    VLOG(2) << "VEDeviceFactory::CreateDevices: " << device_name;
+void VEDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
+  Status s = FlushConsts();
+  if (!s.ok()) {
+    context->SetStatus(s);
+    return;
+  }
+  op_kernel->Compute(context);
+  if (context->status().ok())
+    RecordWriters(context);
+}
 
-    int nodeid = 0;
-    if (const char* tmp = getenv("VE_NODE_NUMBER")) {
-      nodeid = atoi(tmp);
-    }
+void VEDevice::ComputeAsync(AsyncOpKernel* op_kernel,
+                            OpKernelContext* context,
+                            AsyncOpKernel::DoneCallback done) {
+  Status s = FlushConsts();
+  if (!s.ok()) {
+    context->SetStatus(s);
+    done();
+    return;
+  }
+  op_kernel->ComputeAsync(context, [this, context, done]() {
+    if (context->status().ok())
+      RecordWriters(context);
+    done();
+  });
+}
 
-    if (nodeid < 0) // user disables VE
-      return Status::OK();
+void VEDevice::RecordWriters(OpKernelContext* context) {
+  for (int i = 0; i < context->num_outputs(); ++i) {
+    if (context->output_memory_type(i) == HOST_MEMORY)
+      continue;
+    const Tensor* t = context->mutable_output(i);
+    if (t == nullptr || !t->IsInitialized() || t->TotalBytes() == 0)
+      continue;
+    veo_->record_writer(
+        reinterpret_cast<uint64_t>(DMAHelper::base(t)));
+  }
+}
 
-    VEO* veo = NULL;
-    Status s = VEOFactory::Global()->GetOrCreate(&veo, nodeid);
-    if (!s.ok())
-      return s;
+uint64 VEDevice::SafeAllocFrontier(uint64 old_value) {
+  if (!timestamped_allocator_)
+    return 0;
+  uint64 frontier = veo_->safe_alloc_frontier();
+  // let the allocator coalesce chunks freed before the frontier
+  if (frontier > old_value)
+    ve_allocator_->SetSafeFrontier(frontier);
+  return frontier;
+}
 
+class VEDeviceFactory : public DeviceFactory {
+  Status CreateDevices(const SessionOptions& options, const string& name_prefix,
+                       std::vector<std::unique_ptr<Device>>* devices) override {
+    VEOFactory* factory = VEOFactory::Global();
 
-    size_t n = 1;
+    int n = factory->NumDevices();
     auto iter = options.config.device_count().find("VE");
     if (iter != options.config.device_count().end()) {
-      n = iter->second;
+      n = std::min(n, std::max(iter->second, 0));
+    }
+    if (n > 1)
+      TF_RETURN_IF_ERROR(factory->CreateAll(n));
+
+    for (int i = 0; i < n; ++i) {
+      const string device_name = strings::StrCat(name_prefix, "/device:VE:", i);
+      VLOG(2) << "VEDeviceFactory::CreateDevices: " << device_name
+        << " nodeid=" << factory->NodeId(i);
+
+      VEO* veo = NULL;
+      TF_RETURN_IF_ERROR(factory->GetOrCreate(&veo, i));
+
+      int64 memory_limit;
+      TF_RETURN_IF_ERROR(GetVEMemoryLimit(factory->NodeId(i), &memory_limit));
+      bool allow_growth;
+      TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_VE_ALLOW_GROWTH", true,
+                                            &allow_growth));
+      VLOG(2) << "VEDeviceFactory::CreateDevices: memory_limit="
+        << memory_limit << " allow_growth=" << allow_growth;
+
+      Allocator* ve_allocator = new VEBFCAllocator(
+          memory_limit, allow_growth, strings::StrCat("VE_", i, "_bfc"), veo);
+
+      int numa_node = GetVENumaNode(factory->NodeId(i));
+      VLOG(2) << "VEDeviceFactory::CreateDevices: numa_node=" << numa_node;
+      DeviceLocality locality;
+      locality.set_numa_node(numa_node);
+      locality.set_bus_id(numa_node + 1);
+
+      // Describes the node as reported by the VE driver.
+      const string desc = strings::StrCat(
+          "device: ", i, ", ve node: ", factory->NodeId(i), ", num cores: ",
+          GetVENumCores(factory->NodeId(i)));
+
+      std::unique_ptr<VEDevice> device
+        = absl::make_unique<VEDevice>(options, device_name,
+                                      Bytes(memory_limit), ve_allocator,
+                                      ProcessState::singleton()->GetCPUAllocator(numa_node),
+                                      locality, desc);
+      TF_RETURN_IF_ERROR(device->Init(options, veo));
+      devices->push_back(std::move(device));
     }
-    if( n <= 0 ) return Status::OK();
-
-    size_t total_memory = 20UL*1024*1024*1024;
-    Allocator* ve_allocator = new VEBFCAllocator(total_memory, true, "VE_0_bfc", veo);
-
-    int numa_node = 0;
 
-    std::unique_ptr<VEDevice> device 
-      = absl::make_unique<VEDevice>(options, device_name, ve_allocator,
-                                    ProcessState::singleton()->GetCPUAllocator(numa_node));
-    TF_RETURN_IF_ERROR(device->Init(options, veo));
-    devices->push_back(std::move(device));
     return Status::OK();
   }
 
-  Status ListPhysicalDevices(std::vector<string>* devices) {
-    int nodeid = 0;
-    if (const char* tmp = getenv("VE_NODE_NUMBER")) {
-      nodeid = atoi(tmp);
-    }
-    if (nodeid > 0) {
-      const string device_name = strings::StrCat("/physical_device:VE:", nodeid);
-      devices->push_back(device_name);
+  Status ListPhysicalDevices(std::vector<string>* devices) override {
+    int n = VEOFactory::Global()->NumDevices();
+    for (int i = 0; i < n; ++i) {
+      devices->push_back(strings::StrCat("/physical_device:VE:", i));
     }
     return Status::OK();
   }
@@ -1161,9 +3179,16 @@ void VEDeviceContextImpl::CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device
   VLOG(2) << "VEDeviceContextImpl::CopyCPUTensorToDevice: proc_pid_=" << getpid() << " tid=" << syscall(SYS_gettid);
 #endif
 
-  Status s = veo_->write_mem((uint64_t)out, in, cpu_tensor->TotalBytes());
-  done(s);
-  VLOG(2) << "VEDeviceContextImpl::CopyCPUTensorToDevice: done";
+  size_t len = cpu_tensor->TotalBytes();
+  if (len == 0) {
+    done(Status::OK());
+    return;
+  }
+
+  ve_transfer_bytes->GetCell("host_to_device")->IncrementBy(len);
+  veo_->write_mem_async((uint64_t)out, in, len, std::move(done),
+                        sync_dst_compute);
+  VLOG(2) << "VEDeviceContextImpl::CopyCPUTensorToDevice: issued";
 }
 
 void VEDeviceContextImpl::CopyDeviceTensorToCPU(const Tensor* device_tensor, StringPiece edge_name,
@@ -1177,8 +3202,18 @@ void VEDeviceContextImpl::CopyDeviceTensorToCPU(const Tensor* device_tensor, Str
   VLOG(2) << "VEDeviceContextImpl::CopyDeviceTensorToCPU: in=" << in
     << " out=" << out << " size=" << device_tensor->TotalBytes();
 
-  Status s = veo_->read_mem(out, (uint64_t)in, device_tensor->TotalBytes());
-  done(s);
+  size_t len = device_tensor->TotalBytes();
+  if (len == 0) {
+    done(Status::OK());
+    return;
+  }
+
+  ve_transfer_bytes->GetCell("device_to_host")->IncrementBy(len);
+
+  // read_mem_async captures the edge name for the tracer on this thread.
+  tls_copy_edge_name = edge_name;
+  veo_->read_mem_async(out, (uint64_t)in, len, std::move(done));
+  tls_copy_edge_name = StringPiece();
 }
 
 void VEDeviceContextImpl::CopyTensorInSameDevice(const Tensor* input_tensor,
@@ -1201,6 +3236,171 @@ void VEDeviceContextImpl::CopyTensorInSameDevice(const Tensor* input_tensor,
   done(s) ;
 }
 
+namespace {
+
+// VE to VE copy through a host staging buffer. There is no peer DMA between
+// VEs, so a tensor is copied by chunks and a chunk is written to the
+// destination while the next one is read from the source. The staging buffer
+// is allocated from the VE host allocator so that both VEs can DMA it
+// directly.
+class VEPeerCopy {
+  public:
+    static void Start(VEO* src, VEO* dst, uint64_t src_addr, uint64_t dst_addr,
+                      size_t len, StatusCallback done) {
+      int64 chunk_size;
+      Status s = ReadInt64FromEnvVar("TF_VE_PEER_COPY_CHUNK_SIZE",
+                                     8 * 1024 * 1024, &chunk_size);
+      if (!s.ok()) {
+        done(s);
+        return;
+      }
+      chunk_size = std::max(chunk_size, int64{4096});
+
+      VEPeerCopy* copy = new VEPeerCopy(src, dst, src_addr, dst_addr, len,
+                                        chunk_size, std::move(done));
+      if (copy->staging_ == nullptr) {
+        copy->done_(errors::ResourceExhausted(
+                "VEPeerCopy: failed to allocate a staging buffer of ",
+                copy->num_slots_ * copy->chunk_size_, " bytes"));
+        delete copy;
+        return;
+      }
+      for (size_t slot = 0; slot < copy->num_slots_; ++slot)
+        copy->ReadChunk(slot, slot * copy->chunk_size_);
+    }
+
+  private:
+    VEPeerCopy(VEO* src, VEO* dst, uint64_t src_addr, uint64_t dst_addr,
+               size_t len, size_t chunk_size, StatusCallback done)
+      : src_(src), dst_(dst), src_addr_(src_addr), dst_addr_(dst_addr),
+        len_(len), chunk_size_(std::min(chunk_size, len)),
+        num_chunks_((len + chunk_size_ - 1) / chunk_size_),
+        num_slots_(std::min<size_t>(num_chunks_, 2)),
+        pending_(num_chunks_), done_(std::move(done)) {
+      allocator_ = VEProcessState::singleton()->GetVEHostAllocator(0);
+      staging_ = reinterpret_cast<char*>(allocator_->AllocateRaw(
+              Allocator::kAllocatorAlignment, num_slots_ * chunk_size_));
+    }
+
+    ~VEPeerCopy() {
+      if (staging_)
+        allocator_->DeallocateRaw(staging_);
+    }
+
+    char* slot_buf(size_t slot) { return staging_ + slot * chunk_size_; }
+
+    // Returns the number of chunks copied through the slot of the chunk at
+    // `off`, from that chunk on.
+    size_t ChunksFrom(size_t off) const {
+      return (num_chunks_ - off / chunk_size_ + num_slots_ - 1) / num_slots_;
+    }
+
+    // Reads the chunk at `off` into `slot`, and then writes it to the
+    // destination. The slot is reused for the chunk num_slots_ later.
+    void ReadChunk(size_t slot, size_t off) {
+      size_t size = std::min(chunk_size_, len_ - off);
+      src_->read_mem_async(slot_buf(slot), src_addr_ + off, size,
+                           [this, slot, off, size](const Status& s) {
+        if (!s.ok()) {
+          // The chunks that would use this slot are abandoned too.
+          FinishChunk(s, ChunksFrom(off));
+          return;
+        }
+        dst_->write_mem_async(dst_addr_ + off, slot_buf(slot), size,
+                              [this, slot, off](const Status& s) {
+          if (!s.ok()) {
+            FinishChunk(s, ChunksFrom(off));
+            return;
+          }
+          size_t next = off + num_slots_ * chunk_size_;
+          if (next < len_)
+            ReadChunk(slot, next);
+          FinishChunk(s, 1);
+        });
+      });
+    }
+
+    void FinishChunk(const Status& s, size_t n) {
+      bool last;
+      {
+        mutex_lock l(mu_);
+        status_.Update(s);
+        pending_ -= n;
+        last = pending_ == 0;
+      }
+      if (last) {
+        done_(status_);
+        delete this;
+      }
+    }
+
+    VEO* src_;
+    VEO* dst_;
+    uint64_t src_addr_;
+    uint64_t dst_addr_;
+    size_t len_;
+    size_t chunk_size_;
+    size_t num_chunks_;
+    size_t num_slots_;
+    Allocator* allocator_;
+    char* staging_;
+
+    mutex mu_;
+    Status status_;
+    size_t pending_; // chunks not written yet
+    StatusCallback done_;
+};
+
+// Returns `ctx`, or the default context of `device` when it is null.
+VEDeviceContextImpl* GetVEContext(DeviceContext* ctx, Device* device) {
+  if (ctx == nullptr) {
+    const DeviceBase::GpuDeviceInfo* dev_info =
+        device->tensorflow_gpu_device_info();
+    if (dev_info == nullptr)
+      return nullptr;
+    ctx = dev_info->default_context;
+  }
+  return static_cast<VEDeviceContextImpl*>(ctx);
+}
+
+void CopyVEToVE(DeviceContext* send_dev_context,
+                DeviceContext* recv_dev_context, Device* src, Device* dst,
+                const AllocatorAttributes src_alloc_attr,
+                const AllocatorAttributes dst_alloc_attr, const Tensor* input,
+                Tensor* output, int dev_to_dev_stream_index,
+                StatusCallback done) {
+  size_t len = input->TotalBytes();
+  VLOG(2) << "CopyVEToVE: " << src->name() << " -> " << dst->name()
+    << " size=" << len;
+  if (len == 0) {
+    done(Status::OK());
+    return;
+  }
+
+  VEDeviceContextImpl* src_ctx = GetVEContext(send_dev_context, src);
+  VEDeviceContextImpl* dst_ctx = GetVEContext(recv_dev_context, dst);
+  if (src_ctx == nullptr || dst_ctx == nullptr) {
+    done(errors::Internal("CopyVEToVE: no device context"));
+    return;
+  }
+
+  if (src_ctx->veo() == dst_ctx->veo()) {
+    // Same VE. The copy is a kernel ordered with other kernels.
+    dst_ctx->CopyTensorInSameDevice(input, dst, output, std::move(done));
+    return;
+  }
+
+  VEPeerCopy::Start(src_ctx->veo(), dst_ctx->veo(),
+                    reinterpret_cast<uint64_t>(DMAHelper::base(input)),
+                    reinterpret_cast<uint64_t>(DMAHelper::base(output)),
+                    len, std::move(done));
+}
+
+static CopyTensor::Registration register_ve_to_ve_copy(DEVICE_VE, DEVICE_VE,
+                                                       CopyVEToVE);
+
+} // namespace
+
 Status VEDeviceContextImpl::Compute(const std::string& name, const void* arg, size_t len,
                                     const OpKernel* op)
 {
@@ -1208,6 +3408,11 @@ Status VEDeviceContextImpl::Compute(const std::string& name, const void* arg, si
   return veo_->compute(name, arg, len, op);
 }
 
+int ve_get_num_devices()
+{
+  return VEOFactory::Global()->NumDevices();
+}
+
 Status ve_get_timestamp(int nodeid, uint64_t* ts, double* resolution)
 {
   VEO* veo = NULL;
@@ -1230,5 +3435,20 @@ Status ve_set_trace_callback(int nodeid, VEO::cb_t cb, void* data)
   return s;
 }
 
+Status VEBenchmark(int device_id, VEBenchmarkPath path, size_t size,
+                   int iters, uint64* elapsed_ns)
+{
+  VEO* veo = NULL;
+  TF_RETURN_IF_ERROR(VEOFactory::Global()->GetOrCreate(&veo, device_id));
+  return veo->benchmark(path, size, iters, elapsed_ns);
+}
+
+bool AddVEHostMemVisitors(const SubAllocator::Visitor& alloc_visitor,
+                          const SubAllocator::Visitor& free_visitor)
+{
+  return VEProcessState::singleton()->AddVEHostMemVisitors(alloc_visitor,
+                                                           free_visitor);
+}
+
 } // namespace tensorflow
 
@@ -1,6 +1,7 @@
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_VE_VE_DEVICE_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_VE_VE_DEVICE_H_
 
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -12,8 +13,58 @@ class VEDeviceContext : public DeviceContext {
 
     virtual Status Compute(const std::string& name, const void* arg, size_t len,
                            const OpKernel* op = nullptr) = 0;
+
+    // Returns a handle of the VE kernel `name`, or 0 when it is not found.
+    // Compute with the handle does not look up the kernel by name.
+    virtual uint64_t LookupKernel(const std::string& name) = 0;
+
+    virtual Status Compute(uint64_t kernel, const void* arg, size_t len,
+                           const OpKernel* op = nullptr) = 0;
+};
+
+// Returns a handle of the VE kernel `name` on `device`, or 0 when it is not
+// found. OpKernels call this in their constructors.
+inline uint64_t LookupVEKernel(DeviceBase* device, const std::string& name) {
+  const DeviceBase::GpuDeviceInfo* info = device->tensorflow_gpu_device_info();
+  if (!info || !info->default_context)
+    return 0;
+  return static_cast<VEDeviceContext*>(info->default_context)
+      ->LookupKernel(name);
+}
+
+// A device-specific bit of AllocatorAttributes::value which Const kernels
+// set when they call MakeTensorFromProto. It marks the tensor as a constant
+// that VEDevice may share read-only with the sessions which load the same
+// constant.
+constexpr uint32 kVESharedConstAttribute = 1u << 24;
+
+// Registers visitors called on each region of hugepage host memory which
+// VE DMAs directly, when it is allocated and before it is freed, e.g. for a
+// network transport to register the regions with its NIC too. Returns false
+// when host tensors for VE have already been allocated.
+bool AddVEHostMemVisitors(const SubAllocator::Visitor& alloc_visitor,
+                          const SubAllocator::Visitor& free_visitor);
+
+// Transfers and requests timed by VEBenchmark, e.g. to check a host after a
+// driver upgrade or to tune TF_DMA_THRESHOLD and TF_DMA_NUM_BUFS.
+enum class VEBenchmarkPath {
+  kWrite,       // VH to VE as the device copies, i.e. by TF_DMA_THRESHOLD
+  kRead,        // VE to VH as the device copies
+  kVEOWrite,    // VH to VE by veo_write_mem
+  kVEORead,     // VE to VH by veo_read_mem
+  kDMAWrite,    // VH to VE by DMA through the staging buffers
+  kDMARead,     // VE to VH by DMA through the staging buffers
+  kCall,        // a synchronous call of a trivial VE function
+  kBatchFlush,  // a batch of trivial kernels pushed and then synced
 };
 
+// Runs `path` on /device:VE:`device_id` `iters` times and returns the total
+// time in `elapsed_ns`. `size` is the bytes per copy, or the kernels per
+// batch for kBatchFlush, and is ignored by kCall. The host buffer is
+// pageable memory. Returns Unimplemented when DMA is not available.
+Status VEBenchmark(int device_id, VEBenchmarkPath path, size_t size,
+                   int iters, uint64* elapsed_ns);
+
 }
 
 #endif
@@ -0,0 +1,308 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Post-placement pass that reports edges crossing between a VE and a non-VE
+// device. Every such edge costs a sync and a PCIe copy at run time, and they
+// mostly come from ops without a VE kernel that the placer silently put on
+// CPU.
+//
+//   TF_VE_PLACEMENT_REPORT=1  logs a ranked report of the nodes responsible
+//                             for the most crossings.
+//   TF_VE_PLACEMENT_FIXUP=1   moves cheap nodes whose data neighbors all live
+//                             on one other device onto that device.
+//   TF_VE_PLACEMENT_FIXUP_MAX_BYTES  upper bound on the output size of a node
+//                             moved from VE to the host (default 64KB).
+//
+// Output sizes that are not known statically are taken from the cost profile
+// measured on this graph by an earlier session, if TF_COST_PROFILE_DIR holds
+// one.
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/cost_profile_store.h"
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace {
+
+bool IsVEDevice(const string& device_name) {
+  DeviceNameUtils::ParsedName parsed;
+  return DeviceNameUtils::ParseFullName(device_name, &parsed) &&
+         parsed.has_type && parsed.type == DEVICE_VE;
+}
+
+// Measured nodes of the graph's cost profile, by name.
+using MeasuredNodes = std::unordered_map<string, const CostGraphDef::Node*>;
+
+// Returns the measured size in bytes of output `index` of `node`, or -1.
+int64 MeasuredOutputBytes(const MeasuredNodes& measured, const Node* node,
+                          int index) {
+  auto it = measured.find(node->name());
+  if (it == measured.end() || index >= it->second->output_info_size()) {
+    return -1;
+  }
+  return it->second->output_info(index).size();
+}
+
+// Returns the size in bytes of output `index` of `node`, or -1 if unknown.
+int64 OutputBytes(const MeasuredNodes& measured, const Node* node, int index) {
+  DataType dtype = node->output_type(index);
+  if (DataTypeSize(dtype) == 0) {
+    return MeasuredOutputBytes(measured, node, index);
+  }
+
+  TensorShape shape;
+  std::vector<PartialTensorShape> shapes;
+  const TensorProto* value = nullptr;
+  if (GetNodeAttr(node->attrs(), "_output_shapes", &shapes).ok() &&
+      index < static_cast<int>(shapes.size())) {
+    if (!shapes[index].AsTensorShape(&shape)) {
+      return MeasuredOutputBytes(measured, node, index);
+    }
+  } else if (node->IsConstant() &&
+             GetNodeAttr(node->attrs(), "value", &value).ok()) {
+    if (!TensorShape::IsValid(value->tensor_shape())) return -1;
+    shape = TensorShape(value->tensor_shape());
+  } else {
+    return MeasuredOutputBytes(measured, node, index);
+  }
+  return shape.num_elements() * DataTypeSize(dtype);
+}
+
+struct CrossingStats {
+  int64 edges = 0;
+  int64 bytes = 0;
+  int64 unknown = 0;  // Edges whose size is not known statically.
+
+  void Add(int64 b) {
+    ++edges;
+    if (b < 0)
+      ++unknown;
+    else
+      bytes += b;
+  }
+};
+
+// Returns true when a node is allowed to change device. Anything that
+// carries state, references or colocation constraints stays where the placer
+// put it.
+bool IsMovable(const Node* node) {
+  if (!node->IsOp() || node->IsControlFlow() || node->IsSend() ||
+      node->IsRecv() || node->IsFunctionCall() || node->op_def().is_stateful())
+    return false;
+  if (node->attrs().Find(kColocationAttrName) != nullptr) return false;
+  for (DataType dt : node->input_types())
+    if (IsRefType(dt) || dt == DT_RESOURCE || dt == DT_VARIANT) return false;
+  for (DataType dt : node->output_types())
+    if (IsRefType(dt) || dt == DT_RESOURCE || dt == DT_VARIANT) return false;
+  return true;
+}
+
+// Returns the device shared by every data neighbor of `node`, or an empty
+// string if the neighbors live on several devices or the node has none.
+string CommonNeighborDevice(const Node* node) {
+  string device;
+  auto visit = [&device](const Node* n) {
+    if (!n->IsOp()) return true;
+    if (device.empty()) device = n->assigned_device_name();
+    return n->assigned_device_name() == device;
+  };
+  for (const Edge* e : node->in_edges())
+    if (!e->IsControlEdge() && !visit(e->src())) return "";
+  for (const Edge* e : node->out_edges())
+    if (!e->IsControlEdge() && !visit(e->dst())) return "";
+  return device;
+}
+
+// Moves nodes whose data neighbors all sit on a single other device onto
+// that device if one side is a VE. A host node is moved onto the VE only when
+// a VE kernel exists for it; a VE node is moved onto the host only when its
+// outputs are known to be small, so that compute heavy ops stay on the VE.
+int FixupPlacement(Graph* graph, const MeasuredNodes& measured,
+                   int64 max_bytes) {
+  int moved = 0;
+  for (Node* node : graph->op_nodes()) {
+    if (!IsMovable(node)) continue;
+    const string& current = node->assigned_device_name();
+    string target = CommonNeighborDevice(node);
+    if (target.empty() || target == current) continue;
+
+    bool current_is_ve = IsVEDevice(current);
+    bool target_is_ve = IsVEDevice(target);
+    if (current_is_ve == target_is_ve) continue;
+
+    if (target_is_ve) {
+      if (!FindKernelDef(DeviceType(DEVICE_VE), node->def(), nullptr, nullptr)
+               .ok())
+        continue;
+    } else {
+      bool small = node->num_outputs() > 0;
+      for (int i = 0; i < node->num_outputs() && small; ++i) {
+        int64 bytes = OutputBytes(measured, node, i);
+        small = bytes >= 0 && bytes <= max_bytes;
+      }
+      if (!small) continue;
+      DeviceNameUtils::ParsedName parsed;
+      if (!DeviceNameUtils::ParseFullName(target, &parsed) ||
+          !FindKernelDef(DeviceType(parsed.type), node->def(), nullptr,
+                         nullptr)
+               .ok())
+        continue;
+    }
+
+    VLOG(2) << "VEPlacementAdvisor: move " << node->name() << " ("
+            << node->type_string() << ") from " << current << " to "
+            << target;
+    node->set_assigned_device_name(target);
+    ++moved;
+  }
+  return moved;
+}
+
+void ReportCrossings(const Graph* graph, const MeasuredNodes& measured) {
+  // Statistics keyed by the non-VE endpoint of each crossing edge, which is
+  // where a missing VE kernel usually shows up.
+  std::unordered_map<const Node*, CrossingStats> per_node;
+  std::unordered_map<string, CrossingStats> per_op;
+  CrossingStats total;
+
+  for (const Edge* e : graph->edges()) {
+    if (e->IsControlEdge()) continue;
+    const Node* src = e->src();
+    const Node* dst = e->dst();
+    if (!src->IsOp() || !dst->IsOp()) continue;
+    bool src_ve = IsVEDevice(src->assigned_device_name());
+    bool dst_ve = IsVEDevice(dst->assigned_device_name());
+    if (src_ve == dst_ve) continue;
+
+    int64 bytes = OutputBytes(measured, src, e->src_output());
+    const Node* host = src_ve ? dst : src;
+    per_node[host].Add(bytes);
+    per_op[host->type_string()].Add(bytes);
+    total.Add(bytes);
+  }
+
+  if (total.edges == 0) {
+    LOG(INFO) << "VEPlacementAdvisor: no edges between VE and other devices";
+    return;
+  }
+
+  auto rank = [](const CrossingStats& a, const CrossingStats& b) {
+    return a.edges != b.edges ? a.edges > b.edges : a.bytes > b.bytes;
+  };
+
+  std::vector<std::pair<string, CrossingStats>> ops(per_op.begin(),
+                                                    per_op.end());
+  std::sort(ops.begin(), ops.end(),
+            [&rank](const std::pair<string, CrossingStats>& a,
+                    const std::pair<string, CrossingStats>& b) {
+              return rank(a.second, b.second);
+            });
+
+  std::vector<std::pair<const Node*, CrossingStats>> nodes(per_node.begin(),
+                                                           per_node.end());
+  std::sort(nodes.begin(), nodes.end(),
+            [&rank](const std::pair<const Node*, CrossingStats>& a,
+                    const std::pair<const Node*, CrossingStats>& b) {
+              return rank(a.second, b.second);
+            });
+
+  string report = strings::StrCat(
+      "VEPlacementAdvisor: ", total.edges, " edges between VE and other ",
+      "devices, ", total.bytes, " bytes known, ", total.unknown,
+      " edges of unknown size\n  by op type:\n");
+  for (const auto& p : ops) {
+    strings::StrAppend(&report, "    ", p.first, ": edges=", p.second.edges,
+                       " bytes=", p.second.bytes, "\n");
+  }
+  const size_t kMaxNodes = 20;
+  strings::StrAppend(&report, "  top nodes:\n");
+  for (size_t i = 0; i < nodes.size() && i < kMaxNodes; ++i) {
+    const Node* n = nodes[i].first;
+    bool has_ve_kernel =
+        FindKernelDef(DeviceType(DEVICE_VE), n->def(), nullptr, nullptr).ok();
+    strings::StrAppend(&report, "    ", n->name(), " (", n->type_string(),
+                       ") on ", n->assigned_device_name(),
+                       ": edges=", nodes[i].second.edges,
+                       " bytes=", nodes[i].second.bytes,
+                       has_ve_kernel ? "" : " [no VE kernel]", "\n");
+  }
+  LOG(INFO) << report;
+}
+
+class VEPlacementAdvisorPass : public GraphOptimizationPass {
+ public:
+  Status Run(const GraphOptimizationPassOptions& options) override {
+    if (options.graph == nullptr) return Status::OK();
+    Graph* graph = options.graph->get();
+
+    bool has_ve = false;
+    for (const Node* node : graph->op_nodes()) {
+      if (IsVEDevice(node->assigned_device_name())) {
+        has_ve = true;
+        break;
+      }
+    }
+    if (!has_ve) return Status::OK();
+
+    bool report, fixup;
+    int64 max_bytes;
+    TF_RETURN_IF_ERROR(
+        ReadBoolFromEnvVar("TF_VE_PLACEMENT_REPORT", false, &report));
+    TF_RETURN_IF_ERROR(
+        ReadBoolFromEnvVar("TF_VE_PLACEMENT_FIXUP", false, &fixup));
+    TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_VE_PLACEMENT_FIXUP_MAX_BYTES",
+                                           64 * 1024, &max_bytes));
+
+    std::shared_ptr<const CostGraphDef> profile;
+    MeasuredNodes measured;
+    if (CostProfileStore* store = CostProfileStore::Global()) {
+      profile = store->Lookup(CostProfileStore::Fingerprint(*graph));
+      if (profile) measured = CostProfileNodesByName(*profile);
+    }
+
+    if (fixup) {
+      // A move can make a neighbor movable, so iterate a few times.
+      const int kMaxIterations = 4;
+      int total = 0;
+      for (int i = 0; i < kMaxIterations; ++i) {
+        int moved = FixupPlacement(graph, measured, max_bytes);
+        total += moved;
+        if (moved == 0) break;
+      }
+      VLOG(1) << "VEPlacementAdvisor: moved " << total << " nodes";
+    }
+
+    if (report || VLOG_IS_ON(2)) ReportCrossings(graph, measured);
+    return Status::OK();
+  }
+};
+
+REGISTER_OPTIMIZATION(OptimizationPassRegistry::POST_PLACEMENT, 0,
+                      VEPlacementAdvisorPass);
+
+}  // namespace
+}  // namespace tensorflow
@@ -1,10 +1,13 @@
 #include <stdlib.h>
+#include <algorithm>
+#include <chrono>
 #include <memory>
 
 //#include "tensorflow/core/platform/device_tracer.h"
 #include "tensorflow/core/profiler/internal/profiler_interface.h"
 #include "tensorflow/core/profiler/internal/profiler_factory.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/ve/ve_tracer.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #if 0
 #include "tensorflow/core/lib/core/errors.h"
@@ -12,17 +15,23 @@
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/env_var.h"
 #if 0
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
 #endif
 #include "tensorflow/core/platform/tracing.h"
+#include "tensorflow/core/profiler/internal/annotation_stack.h"
+#include "tensorflow/core/profiler/utils/xplane_builder.h"
+#include "tensorflow/core/profiler/utils/xplane_schema.h"
+#include "tensorflow/core/profiler/utils/xplane_utils.h"
 
 namespace tensorflow {
 
 typedef void (*cb_t)(int nodeid, int kind, const void* data, void* self);
 
+extern int ve_get_num_devices();
 extern Status ve_get_timestamp(int nodeid, uint64_t* ts, double* resolution);
 extern Status ve_set_trace_callback(int nodeid, cb_t cb, void* data);
 
@@ -116,7 +125,10 @@ class VEDeviceTracer : public profiler::ProfilerInterface {
   public:
     VEDeviceTracer();
 
-    ~VEDeviceTracer() override { VLOG(2) << "~VEDeviceTracer"; }
+    ~VEDeviceTracer() override {
+      VLOG(2) << "~VEDeviceTracer";
+      StopResyncThread();
+    }
 
     Status Start() override;
     Status Stop() override;
@@ -134,6 +146,15 @@ class VEDeviceTracer : public profiler::ProfilerInterface {
       std::string name;
       uint64_t t0;
       uint64_t t1;
+      // Kernels issued in one call to the VE share the same batch.
+      uint64_t batch;
+      bool has_pmcs;
+      VEPmcs pmcs;
+      // Host times the kernel was pushed to its stack, the stack was issued
+      // to the VE and seen completed. 0 if unknown.
+      uint64_t push_ns;
+      uint64_t submit_ns;
+      uint64_t complete_ns;
     };
 
     struct MemcpyRecords {
@@ -141,15 +162,103 @@ class VEDeviceTracer : public profiler::ProfilerInterface {
       std::string name;
       uint64_t start_timestamp;
       uint64_t end_timestamp;
+      uint64_t bytes;
+    };
+
+    // A pair of host and VE timestamps taken at the same time.
+    struct SyncPoint {
+      uint64_t host_ns;
+      uint64_t ve_cycles;
     };
 
-    int64 start_;
-    uint64_t ve_start_timestamp_;
-    double ve_resolution_;
+    // indexed by nodeid, that is the index of /device:VE:N
+    std::vector<std::vector<SyncPoint>> sync_points_;
+    std::vector<double> ve_resolution_;
     std::vector<KernelRecords> kernel_records_;
     std::vector<MemcpyRecords> memcpy_records_;
+    uint64_t num_batches_ = 0;
     mutex lock_;
 
+    // The VE clock drifts from the host clock, so sync points are taken
+    // periodically while tracing.
+    std::unique_ptr<Thread> resync_thread_;
+    mutex resync_mu_;
+    condition_variable resync_cond_;
+    bool resync_stop_ = false;
+
+    Status Resync();
+    void StopResyncThread();
+
+    static std::string KernelDetails(const KernelRecords& r, double usecs) {
+      const VEPmcs& p = r.pmcs;
+      return strings::Printf(
+          "vector_length:%.1f vector_op_ratio:%.1f%% mops:%.0f mflops:%.0f "
+          "l1_hit_rate:%.3f llc_hit_rate:%.3f bandwidth:%.2fGB/s",
+          p.AverageVectorLength(), p.VectorOpRatio(), p.Mops(usecs),
+          p.Mflops(usecs), p.L1HitRate(), p.LLCHitRate(),
+          p.MemoryBandwidthGBps(usecs));
+    }
+
+    static std::string MemcpyDetails(const MemcpyRecords& r) {
+      uint64_t us = r.end_timestamp - r.start_timestamp;
+      double gbps = us > 0 ? r.bytes / (us * 1e3) : 0.0;
+      return strings::Printf("size:%lu bandwidth:%.2fGB/s",
+                             static_cast<unsigned long>(r.bytes), gbps);
+    }
+
+    // Converts VE cycles into host wall time in nanoseconds using the latest
+    // sync point taken before `cycles`.
+    uint64_t ToWalltimeNs(int nodeid, uint64_t cycles) const {
+      const std::vector<SyncPoint>& points = sync_points_[nodeid];
+      if (points.empty())
+        return 0;
+      auto it = std::upper_bound(points.begin(), points.end(), cycles,
+                                 [](uint64_t c, const SyncPoint& p) {
+                                   return c < p.ve_cycles;
+                                 });
+      const SyncPoint& p = it == points.begin() ? *it : *(it - 1);
+      double ns_per_cycle = 1e9 / ve_resolution_[nodeid];
+      int64 delta = static_cast<int64>(cycles - p.ve_cycles);
+      return p.host_ns + static_cast<int64>(delta * ns_per_cycle);
+    }
+
+    // Adds the raw performance counters of `r` and the metrics derived from
+    // them to its kernel event.
+    void AddPmcStats(XPlaneBuilder* plane, XEventBuilder* event,
+                     const KernelRecords& r) const {
+      const VEPmcs& p = r.pmcs;
+      for (int i = 0; i < VEPmcs::kNumPmcs; ++i)
+        event->AddStatValue(*plane->GetOrCreateStatMetadata(
+                strings::StrCat("pmc_", VEPmcs::Name(i))),
+            static_cast<uint64>(p.values[i]));
+      double usecs = (ToWalltimeNs(r.nodeid, r.t1) -
+                      ToWalltimeNs(r.nodeid, r.t0)) / 1e3;
+      auto add = [&](const char* name, double value) {
+        event->AddStatValue(*plane->GetOrCreateStatMetadata(name), value);
+      };
+      add("avg_vector_length", p.AverageVectorLength());
+      add("vector_op_ratio", p.VectorOpRatio());
+      add("mops", p.Mops(usecs));
+      add("mflops", p.Mflops(usecs));
+      add("l1_hit_rate", p.L1HitRate());
+      add("llc_hit_rate", p.LLCHitRate());
+      add("memory_bandwidth_gbps", p.MemoryBandwidthGBps(usecs));
+    }
+
+    // Adds how long the kernel waited in its stack before being issued, and
+    // how long after its end the host saw the stack complete.
+    void AddQueueingStats(XPlaneBuilder* plane, XEventBuilder* event,
+                          const KernelRecords& r) const {
+      if (r.push_ns > 0 && r.submit_ns >= r.push_ns)
+        event->AddStatValue(*plane->GetOrCreateStatMetadata("stack_wait_us"),
+                            (r.submit_ns - r.push_ns) / 1e3);
+      uint64_t end_ns = ToWalltimeNs(r.nodeid, r.t1);
+      if (r.complete_ns > 0 && end_ns > 0 && r.complete_ns >= end_ns)
+        event->AddStatValue(
+            *plane->GetOrCreateStatMetadata("completion_latency_us"),
+            (r.complete_ns - end_ns) / 1e3);
+    }
+
     void callback(int nodeid, int kind, const void* data);
 
     static void cb(int nodeid, int kind, const void* data, void* self) {
@@ -166,25 +275,41 @@ void VEDeviceTracer::callback(int nodeid, int kind, const void* data)
     struct Tmp {
       const std::vector<std::string>* kernel_names;
       const void* buf;
+      int num_pmcs;
+      const std::vector<uint64_t>* push_ns;
+      uint64_t submit_ns;
+      uint64_t complete_ns;
     };
     const Tmp* tmp = reinterpret_cast<const Tmp*>(data);
     const std::vector<std::string>& kernel_names = *tmp->kernel_names;
+    const std::vector<uint64_t>& push_ns = *tmp->push_ns;
     const void* buf = tmp->buf;
+    // The buffer may come from a kernel library reading other counters than
+    // VEPmcs, then they are ignored.
+    const int stride = 2 + tmp->num_pmcs;
+    const bool has_pmcs = tmp->num_pmcs == VEPmcs::kNumPmcs;
 
     VLOG(2) << "VEDeviceTracer::callback: kernel_records_.size=" << kernel_records_.size()
       << " kernel_names.size=" << kernel_names.size();
 
     const uint64_t* pcyc = reinterpret_cast<const uint64_t*>(buf);
+    const uint64_t batch = num_batches_++;
     int n = kernel_names.size();
     for (int i = 0; i < n; ++i) {
-      uint64_t t0 = pcyc[i*2];
-      uint64_t t1 = pcyc[i*2+1];
+      uint64_t t0 = pcyc[i*stride];
+      uint64_t t1 = pcyc[i*stride+1];
 #if 0
       VLOG(2) << "VEDeviceTracer::callback: kernel=" 
         << kernel_names[i] << " t0=" << t0 << " t1=" << t1;
 #endif
 
-      kernel_records_.push_back(KernelRecords{nodeid, kernel_names[i], t0, t1});
+      VEPmcs pmcs;
+      if (has_pmcs)
+        std::copy(pcyc + i*stride + 2, pcyc + (i+1)*stride, pmcs.values);
+      kernel_records_.push_back(
+          KernelRecords{nodeid, kernel_names[i], t0, t1, batch, has_pmcs,
+                        pmcs, i < push_ns.size() ? push_ns[i] : 0,
+                        tmp->submit_ns, tmp->complete_ns});
     }
   }
   else if (kind == 1) { // mempcy
@@ -192,18 +317,18 @@ void VEDeviceTracer::callback(int nodeid, int kind, const void* data)
       uint64_t start;
       uint64_t end;
       uint64_t type;
+      uint64_t bytes;
+      const char* name;
     };
     const Tmp* tmp = reinterpret_cast<const Tmp*>(data);
     std::string str_type[] = {"MEMCPYHtoD", "MEMCPYDtoH"};
-#if 0
-    const char* tls_annotation = tls_current_annotation.get();
-    const char* annotation = tls_annotation ? tls_annotation : "unknown";
-#else
-    const char* annotation = "unknown";
-#endif
+    // The name is the annotation and the edge name of the copy, captured by
+    // VEO on the thread that issued it.
+    const char* annotation = tmp->name ? tmp->name : "unknown";
     std::string name = strings::StrCat(annotation, ":", str_type[tmp->type]);
 
-    memcpy_records_.push_back(MemcpyRecords{nodeid, name, tmp->start, tmp->end});
+    memcpy_records_.push_back(
+        MemcpyRecords{nodeid, name, tmp->start, tmp->end, tmp->bytes});
   }
 }
 
@@ -212,28 +337,84 @@ VEDeviceTracer::VEDeviceTracer() {
   VLOG(2) << "VEDeviceTracer::VEDeviceTracer:"
     " cb=" << reinterpret_cast<void*>(cb) << " this=" << this;
 #endif
-  int nodeid = 0; // FIXME
-  ve_set_trace_callback(nodeid, cb, (void*)this);
+  int n = ve_get_num_devices();
+  sync_points_.resize(n);
+  ve_resolution_.resize(n);
+  for (int nodeid = 0; nodeid < n; ++nodeid)
+    ve_set_trace_callback(nodeid, cb, (void*)this);
   //VLOG(2) << "VEDeviceTracer::VEDeviceTracer done";
 }
 
+// Takes a sync point on every VE. The host time is the middle of the call to
+// the VE.
+Status VEDeviceTracer::Resync() {
+  for (int nodeid = 0; nodeid < sync_points_.size(); ++nodeid) {
+    uint64_t t0 = Env::Default()->NowNanos();
+    uint64_t ts;
+    double resolution;
+    Status s = ve_get_timestamp(nodeid, &ts, &resolution);
+    uint64_t t1 = Env::Default()->NowNanos();
+    if (!s.ok())
+      return s;
+    VLOG(2) << "VEDeviceTracer::Resync: nodeid=" << nodeid
+      << " ve_timestamp=" << ts << " ve_resolution=" << resolution;
+
+    mutex_lock guard(lock_);
+    ve_resolution_[nodeid] = resolution;
+    sync_points_[nodeid].push_back(SyncPoint{t0 + (t1 - t0) / 2, ts});
+  }
+  return Status::OK();
+}
+
+void VEDeviceTracer::StopResyncThread() {
+  {
+    mutex_lock l(resync_mu_);
+    resync_stop_ = true;
+    resync_cond_.notify_all();
+  }
+  resync_thread_.reset(); // joins
+}
+
 Status VEDeviceTracer::Start() { 
   //VLOG(2) << "VEDeviceTracer::Start";
-  start_ = Env::Default()->NowMicros();
-  int nodeid = 0; // FIXME
-  Status s = ve_get_timestamp(nodeid, &ve_start_timestamp_, &ve_resolution_);
-  VLOG(2) << "VEDeviceTracer::Start:"
-    << " ve_start_timestamp_=" << ve_start_timestamp_
-    << " ve_resolution_=" << ve_resolution_;
-  if (!s.ok())
-    return s;
+  {
+    mutex_lock guard(lock_);
+    for (auto& points : sync_points_)
+      points.clear();
+  }
+  TF_RETURN_IF_ERROR(Resync());
+
+  int64 interval_ms;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_VE_TRACER_RESYNC_INTERVAL_MS",
+                                         1000, &interval_ms));
+  if (interval_ms > 0) {
+    resync_stop_ = false;
+    resync_thread_.reset(Env::Default()->StartThread(
+            ThreadOptions(), "ve_tracer_resync", [this, interval_ms]() {
+          mutex_lock l(resync_mu_);
+          while (!resync_stop_) {
+            resync_cond_.wait_for(l,
+                                  std::chrono::milliseconds(interval_ms));
+            if (resync_stop_)
+              break;
+            Status s = Resync();
+            if (!s.ok())
+              VLOG(1) << "VEDeviceTracer: failed to resync clock: " << s;
+          }
+        }));
+  }
 
+  // Annotations label memcpy records.
+  AnnotationStack::Enable(true);
   return Status::OK(); 
 }
 
 Status VEDeviceTracer::Stop() {
   VLOG(2) << "VEDeviceTracer::Stop";
-  ve_set_trace_callback(0, nullptr, nullptr);
+  AnnotationStack::Enable(false);
+  StopResyncThread();
+  for (int nodeid = 0; nodeid < sync_points_.size(); ++nodeid)
+    ve_set_trace_callback(nodeid, nullptr, nullptr);
   return Status::OK(); 
 }
 
@@ -244,8 +425,84 @@ Status VEDeviceTracer::CollectData(RunMetadata* run_metadata) {
   return Status::OK();
 }
 
+// Exports one plane per VE node. The plane has a line with one event per
+// kernel, named by the annotation recorded when the kernel was pushed, a line
+// with one event per batch of kernels issued together, and a line for memcpy.
+// Kernel events have performance counter stats when vetfkl_entry_pmc was used.
 Status VEDeviceTracer::CollectData(XSpace* space) {
-    return errors::Unimplemented("Collect data into XSpace not yet implemented");
+  mutex_lock guard(lock_);
+
+  VLOG(2) << "VEDeviceTracer::CollectData(XSpace):"
+    << " kernel_records_.size=" << kernel_records_.size()
+    << " memcpy_records_.size=" << memcpy_records_.size();
+
+  enum { kKernelLine = 0, kBatchLine = 1, kMemcpyLine = 2 };
+
+  std::vector<std::unique_ptr<XPlaneBuilder>> planes(ve_resolution_.size());
+  auto get_plane = [&](int nodeid) -> XPlaneBuilder* {
+    if (!planes[nodeid]) {
+      planes[nodeid].reset(new XPlaneBuilder(GetOrCreatePlane(
+                  space, strings::StrCat(kVePlanePrefix, nodeid))));
+      XPlaneBuilder* plane = planes[nodeid].get();
+      plane->SetId(nodeid);
+      plane->GetOrCreateLine(kKernelLine).SetName("Kernels");
+      plane->GetOrCreateLine(kBatchLine).SetName("Kernel Batches");
+      plane->GetOrCreateLine(kMemcpyLine).SetName("Memcpy");
+      plane->AddStatValue(*plane->GetOrCreateStatMetadata(
+              GetStatTypeStr(StatType::kDevCapClockRateKHz)),
+          static_cast<uint64>(ve_resolution_[nodeid] / 1000));
+    }
+    return planes[nodeid].get();
+  };
+
+  // Kernel records of a batch are contiguous, so a batch event spans from
+  // the first kernel of the batch to the last one.
+  for (size_t i = 0; i < kernel_records_.size(); ) {
+    const KernelRecords& first = kernel_records_[i];
+    XPlaneBuilder* plane = get_plane(first.nodeid);
+    XLineBuilder kernels = plane->GetOrCreateLine(kKernelLine);
+
+    size_t j = i;
+    uint64_t t1 = first.t1;
+    for (; j < kernel_records_.size()
+         && kernel_records_[j].batch == first.batch; ++j) {
+      const KernelRecords& r = kernel_records_[j];
+      XEventBuilder event =
+        kernels.AddEvent(*plane->GetOrCreateEventMetadata(r.name));
+      event.SetTimestampNs(ToWalltimeNs(r.nodeid, r.t0));
+      event.SetEndTimestampNs(ToWalltimeNs(r.nodeid, r.t1));
+      event.AddStatValue(*plane->GetOrCreateStatMetadata(
+              GetStatTypeStr(StatType::kLevel0)), r.name);
+      if (r.has_pmcs)
+        AddPmcStats(plane, &event, r);
+      AddQueueingStats(plane, &event, r);
+      t1 = std::max(t1, r.t1);
+    }
+
+    XLineBuilder batches = plane->GetOrCreateLine(kBatchLine);
+    XEventBuilder event = batches.AddEvent(*plane->GetOrCreateEventMetadata(
+            strings::StrCat("batch of ", j - i, " kernels")));
+    event.SetTimestampNs(ToWalltimeNs(first.nodeid, first.t0));
+    event.SetEndTimestampNs(ToWalltimeNs(first.nodeid, t1));
+    event.AddStatValue(*plane->GetOrCreateStatMetadata("num_kernels"),
+                       static_cast<uint64>(j - i));
+    i = j;
+  }
+
+  for (const auto& r : memcpy_records_) {
+    XPlaneBuilder* plane = get_plane(r.nodeid);
+    XLineBuilder line = plane->GetOrCreateLine(kMemcpyLine);
+    XEventBuilder event =
+      line.AddEvent(*plane->GetOrCreateEventMetadata(r.name));
+    event.SetTimestampNs(r.start_timestamp * 1000);
+    event.SetEndTimestampNs(r.end_timestamp * 1000);
+    event.AddStatValue(*plane->GetOrCreateStatMetadata(
+            GetStatTypeStr(StatType::kMemcpyDetails)), MemcpyDetails(r));
+  }
+
+  kernel_records_.clear();
+  memcpy_records_.clear();
+  return Status::OK();
 }
 
 Status VEDeviceTracer::Collect(StepStatsCollector *collector) {
@@ -254,34 +511,24 @@ Status VEDeviceTracer::Collect(StepStatsCollector *collector) {
   mutex_lock guard(lock_);
 
   const string prefix = "";
-  double mhz = ve_resolution_ / 1e6;
-
-#if 0
-  VLOG(2) << "VEDeviceTracer::Collect:"
-    << " start_=" << start_
-    << " ve_start_timestamp_=" << ve_start_timestamp_
-    << " ve_resolution_=" << ve_resolution_;
-#endif
 
   for (auto s : kernel_records_) {
-#if 0
-    VLOG(2) << "VEDeviceTracer::Collect:"
-      << " name=" << s.name
-      << " t0=" << s.t0 << " t1=" << s.t1
-      << " dur=" << (s.t1 - s.t0) / mhz;
-#endif
+    uint64_t start_ns = ToWalltimeNs(s.nodeid, s.t0);
+    uint64_t end_ns = ToWalltimeNs(s.nodeid, s.t1);
     NodeExecStats *ns = new NodeExecStats;
-    ns->set_all_start_micros(start_ + (s.t0 - ve_start_timestamp_) / mhz);
+    ns->set_all_start_micros(start_ns / 1000);
+    ns->set_all_start_nanos(start_ns);
+    ns->set_scheduled_nanos(s.push_ns);
+    ns->set_scheduled_micros(s.push_ns / 1000);
+    ns->set_device_submit_nanos(s.submit_ns);
+    ns->set_device_complete_nanos(s.complete_ns);
     ns->set_op_start_rel_micros(0);
-    auto elapsed_us = (s.t1 - s.t0) / mhz;
+    auto elapsed_us = (end_ns - start_ns) / 1000;
     ns->set_op_end_rel_micros(elapsed_us);
     ns->set_all_end_rel_micros(elapsed_us);
     ns->set_node_name(strings::StrCat(s.name, ":", s.name));
-#if 0
-    VLOG(2) << "VEDeviceTracer::Collect:"
-      << " start=" << ns->all_start_micros()
-      << " end=" << ns->all_start_micros() + ns->all_end_rel_micros();
-#endif
+    if (s.has_pmcs)
+      ns->set_timeline_label(KernelDetails(s, (end_ns - start_ns) / 1e3));
     const string stream_device =
       strings::StrCat(prefix, "/device:VE:", s.nodeid, "/stream:");
     collector->Save(strings::StrCat(stream_device, "0"), ns);
@@ -297,11 +544,13 @@ Status VEDeviceTracer::Collect(StepStatsCollector *collector) {
     ns->set_op_end_rel_micros(elapsed_us);
     ns->set_all_end_rel_micros(elapsed_us);
     ns->set_node_name(s.name);
+    ns->set_timeline_label(MemcpyDetails(s));
     const string stream_device =
       strings::StrCat(prefix, "/device:VE:", s.nodeid, "/memcpy:");
     collector->Save(strings::StrCat(stream_device, "all"), ns);
   }
 
+  memcpy_records_.clear();
   return Status::OK();
 }
 
@@ -309,12 +558,10 @@ Status VEDeviceTracer::Collect(StepStatsCollector *collector) {
 
 std::unique_ptr<profiler::ProfilerInterface>
 CreateDeviceTracer(const profiler::ProfilerOptions&) {
-  if (const char* tmp = getenv("VE_NODE_NUMBER")) {
-    if (atoi(tmp) < 0) {
-      return nullptr;
-    }
+  if (ve_get_num_devices() == 0) {
+    return nullptr;
   }
-  
+
   VLOG(2) << "CreateDeviceTracer(VE)";
   std::unique_ptr<profiler::ProfilerInterface> tracer(new profiler::VEDeviceTracer());
   return tracer;
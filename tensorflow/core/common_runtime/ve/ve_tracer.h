@@ -1,4 +1,77 @@
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_VE_VE_TRACER_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_VE_VE_TRACER_H_
 
+#include <stdint.h>
+
+namespace tensorflow {
+
+// Hardware performance counters of a VE kernel. vetfkl_entry_pmc writes, for
+// each kernel, its start and end cycles followed by the increments of these
+// counters while the kernel ran, in this order.
+struct VEPmcs {
+  enum {
+    kEX,    // instructions executed
+    kVX,    // vector instructions executed
+    kVE,    // vector elements processed
+    kFPEC,  // floating point elements processed
+    kVECC,  // cycles the vector unit was busy
+    kL1OAC, // L1 operand cache accesses
+    kL1OMC, // L1 operand cache misses
+    kVLEC,  // vector load elements
+    kVLCME, // vector load elements missing the LLC
+    kNumPmcs
+  };
+
+  static const char* Name(int i) {
+    static const char* const names[kNumPmcs] = {
+      "EX", "VX", "VE", "FPEC", "VECC", "L1OAC", "L1OMC", "VLEC", "VLCME"};
+    return names[i];
+  }
+
+  uint64_t values[kNumPmcs] = {};
+
+  void Add(const VEPmcs& other) {
+    for (int i = 0; i < kNumPmcs; ++i)
+      values[i] += other.values[i];
+  }
+
+  // Elements per vector instruction. Close to 256 for well vectorized code.
+  double AverageVectorLength() const {
+    return Ratio(values[kVE], values[kVX]);
+  }
+
+  // Percentage of operations, counting each vector element as one, that are
+  // done by vector instructions.
+  double VectorOpRatio() const {
+    return 100.0 * Ratio(values[kVE], NumOps());
+  }
+
+  // Millions of operations per second.
+  double Mops(double usecs) const { return Ratio(NumOps(), usecs); }
+
+  double Mflops(double usecs) const { return Ratio(values[kFPEC], usecs); }
+
+  double L1HitRate() const {
+    return 1.0 - Ratio(values[kL1OMC], values[kL1OAC]);
+  }
+
+  double LLCHitRate() const {
+    return 1.0 - Ratio(values[kVLCME], values[kVLEC]);
+  }
+
+  // Bandwidth from memory of vector loads, which are 8 bytes per element.
+  double MemoryBandwidthGBps(double usecs) const {
+    return Ratio(values[kVLCME] * 8.0, usecs * 1e3);
+  }
+
+ private:
+  double NumOps() const {
+    return static_cast<double>(values[kEX]) - values[kVX] + values[kVE];
+  }
+
+  static double Ratio(double a, double b) { return b > 0 ? a / b : 0.0; }
+};
+
+}  // namespace tensorflow
+
 #endif
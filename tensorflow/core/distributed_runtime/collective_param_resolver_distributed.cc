@@ -14,15 +14,83 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/distributed_runtime/collective_param_resolver_distributed.h"
 
+#include <unordered_map>
+
 #include "absl/strings/escaping.h"
 #include "tensorflow/core/distributed_runtime/cancellable_call.h"
 #include "tensorflow/core/distributed_runtime/device_resolver_distributed.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace {
 
+// Whether groups resolved by the group leader are remembered for the life of
+// the process, so that resolvers created later in this process, e.g. for the
+// servers of an elastic job that re-forms its cluster, do not ask the leader
+// again.  This is only correct as long as a group key keeps its size and
+// members, and the leader that handed out its communicator_key keeps running.
+bool ProcessGroupCacheEnabled() {
+  static const bool enabled = [] {
+    bool enabled;
+    Status s = ReadBoolFromEnvVar("TF_COLLECTIVE_PROCESS_GROUP_CACHE",
+                                  /*default_val=*/false, &enabled);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to read TF_COLLECTIVE_PROCESS_GROUP_CACHE: " << s;
+      enabled = false;
+    }
+    return enabled;
+  }();
+  return enabled;
+}
+
+// Groups resolved by a group leader, shared by all the resolvers of this
+// process.  Keyed by leader, group key, size and device type, and only used
+// for the devices that are members of the resolved group.
+class ProcessGroupCache {
+ public:
+  static ProcessGroupCache* Global() {
+    static ProcessGroupCache* cache = new ProcessGroupCache;
+    return cache;
+  }
+
+  bool Lookup(const string& leader, const CollGroupParams& group,
+              const string& device, CompleteGroupResponse* resp) {
+    mutex_lock l(mu_);
+    auto it = groups_.find(Key(leader, group));
+    if (it == groups_.end()) return false;
+    for (const string& dn : it->second.device_name()) {
+      if (dn == device) {
+        *resp = it->second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Insert(const string& leader, const CompleteGroupResponse& resp) {
+    CollGroupParams group;
+    group.group_key = resp.group_key();
+    group.group_size = resp.group_size();
+    group.device_type = DeviceType(resp.device_type());
+    mutex_lock l(mu_);
+    groups_[Key(leader, group)] = resp;
+  }
+
+ private:
+  static string Key(const string& leader, const CollGroupParams& group) {
+    return strings::StrCat(leader, "|", group.group_key, "|",
+                           group.group_size, "|",
+                           group.device_type.type_string());
+  }
+
+  mutex mu_;
+  std::unordered_map<string, CompleteGroupResponse> groups_ GUARDED_BY(mu_);
+};
+
 class CompleteGroupCall : public CancellableCall {
  public:
   CompleteGroupCall(const CollGroupParams& group, const string& device_name,
@@ -97,6 +165,10 @@ CollectiveParamResolverDistributed::CollectiveParamResolverDistributed(
           << config.experimental().collective_nccl() << "}";
 }
 
+CollectiveParamResolverDistributed::~CollectiveParamResolverDistributed() {
+  prefetch_cancel_mgr_.StartCancel();
+}
+
 void CollectiveParamResolverDistributed::CompleteParamsAsync(
     const string& device, CollectiveParams* cp, CancellationManager* cancel_mgr,
     const StatusCallback& done) {
@@ -149,6 +221,26 @@ void CollectiveParamResolverDistributed::CompleteGroupAsync(
       });
 }
 
+void CollectiveParamResolverDistributed::PrefetchGroupAsync(
+    const string& device, const CollectiveParams& cp) {
+  if (GroupIsCached(cp.group.group_key)) return;
+  // Only the group part of the params is resolved, since instance resolution
+  // depends on the shape and source of each execution of the op.
+  CollectiveParams* prefetch_cp = new CollectiveParams;
+  prefetch_cp->name = cp.name;
+  prefetch_cp->group = cp.group;
+  prefetch_cp->instance.type = cp.instance.type;
+  CompleteGroupDistributed(
+      device, prefetch_cp, &prefetch_cancel_mgr_,
+      [device, prefetch_cp](const Status& s, const GroupRec* gr) {
+        if (!s.ok()) {
+          VLOG(1) << "Prefetching group " << prefetch_cp->group.group_key
+                  << " for device " << device << " failed: " << s;
+        }
+        delete prefetch_cp;
+      });
+}
+
 void CollectiveParamResolverDistributed::CompleteInstanceAsync(
     const CompleteInstanceRequest* request, CompleteInstanceResponse* response,
     CancellationManager* cancel_mgr, const StatusCallback& done) {
@@ -279,6 +371,18 @@ void CollectiveParamResolverDistributed::CompleteGroupDistributed(
     // This is the group leader, so resolution is local.
     return CompleteGroupLocal(device, cp, done);
   } else if (!GroupIsCached(cp->group.group_key)) {
+    CompleteGroupResponse cached_resp;
+    if (ProcessGroupCacheEnabled() &&
+        ProcessGroupCache::Global()->Lookup(group_leader_, cp->group, device,
+                                            &cached_resp)) {
+      // Resolved by another resolver of this process.
+      Status status = UpdateGroupCache(cached_resp);
+      if (!status.ok()) {
+        done(status, nullptr);
+        return;
+      }
+      return CompleteGroupLocal(device, cp, done);
+    }
     // Need to update Group cache from the leader.
     CompleteGroupCall* call =
         new CompleteGroupCall(cp->group, device, cp->instance.type, cancel_mgr,
@@ -287,6 +391,9 @@ void CollectiveParamResolverDistributed::CompleteGroupDistributed(
       if (s.ok()) {
         Status status = UpdateGroupCache(call->resp_);
         if (status.ok()) {
+          if (ProcessGroupCacheEnabled()) {
+            ProcessGroupCache::Global()->Insert(group_leader_, call->resp_);
+          }
           CompleteGroupLocal(device, cp, done);
         } else {
           done(status, nullptr);
@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COLLECTIVE_PARAM_RESOLVER_DISTRIBUTED_H_
 
 #include "tensorflow/core/common_runtime/collective_param_resolver_local.h"
+#include "tensorflow/core/framework/cancellation.h"
 
 namespace tensorflow {
 class ConfigProto;
@@ -31,6 +32,8 @@ class CollectiveParamResolverDistributed : public CollectiveParamResolverLocal {
                                      WorkerCacheInterface* worker_cache,
                                      const string& task_name);
 
+  ~CollectiveParamResolverDistributed() override;
+
   void CompleteParamsAsync(const string& device, CollectiveParams* cp,
                            CancellationManager* cancel_mgr,
                            const StatusCallback& done) override;
@@ -45,6 +48,9 @@ class CollectiveParamResolverDistributed : public CollectiveParamResolverLocal {
                              CancellationManager* cancel_mgr,
                              const StatusCallback& done) override;
 
+  void PrefetchGroupAsync(const string& device,
+                          const CollectiveParams& cp) override;
+
  protected:
   // Returns true iff there's an entry for this group_key in the
   // local group_table_.
@@ -84,6 +90,8 @@ class CollectiveParamResolverDistributed : public CollectiveParamResolverLocal {
 
   WorkerCacheInterface* worker_cache_;  // Not owned
   const string group_leader_;
+  // Cancels the prefetches still waiting for the group leader on deletion.
+  CancellationManager prefetch_cancel_mgr_;
 };
 
 }  // namespace tensorflow
@@ -315,6 +315,23 @@ TEST_F(DeviceResDistTest, Workers2Devices2) {
   ValidateCollectiveParams(num_workers, num_devices);
 }
 
+TEST_F(DeviceResDistTest, Workers2Devices2Prefetched) {
+  const int num_workers = 2;
+  const int num_devices = 2;
+  DefineWorkers(num_workers, num_devices, "CPU", false);
+  DefineCollectiveParams(num_workers, num_devices);
+  for (int wi = 0; wi < num_workers; ++wi) {
+    string task_name = strings::StrCat("/job:worker/replica:0/task:", wi);
+    for (int di = 0; di < num_devices; ++di) {
+      string device_name = strings::StrCat(task_name, "/device:CPU:", di);
+      cp_resolvers_[task_name]->PrefetchGroupAsync(
+          device_name, cp_[wi * num_devices + di]);
+    }
+  }
+  IssueRequests(num_workers, num_devices);
+  ValidateCollectiveParams(num_workers, num_devices);
+}
+
 #ifndef GOOGLE_CUDA
 namespace {
 // A mock NcclReducer for testing group runtime details initialization with CPU
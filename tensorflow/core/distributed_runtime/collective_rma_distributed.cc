@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/cancellable_call.h"
 #include "tensorflow/core/distributed_runtime/request_id.h"
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/platform/protobuf_internal.h"
 #include "tensorflow/core/protobuf/transport_options.pb.h"
@@ -87,6 +88,19 @@ void CollectiveRemoteAccessDistributed::RecvFromPeer(
     return;
   }
 
+  if (tensor_transport_ != nullptr && tensor_transport_->CanReach(peer_task)) {
+    tensor_transport_->RecvBufAsync(
+        peer_task, peer_device, step_id_, key, to_device, to_device_ctx,
+        to_alloc_attr, to_tensor, &cancel_mgr_,
+        [this, peer_task, done](const Status& s) {
+          if (!s.ok() && errors::IsFailedPrecondition(s)) {
+            dev_resolver_->ClearTask(peer_task);
+          }
+          done(s);
+        });
+    return;
+  }
+
   // State that needs to be threaded through a couple of async calls
   // in order to make this function completely non-blocking.
   struct State {
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/platform/unbounded_work_queue.h"
 
 namespace tensorflow {
+class TensorTransport;
 class WorkerCacheInterface;
 
 // Extend CollectiveRemoteAccessLocal with access to remote peers.
@@ -28,9 +29,11 @@ class CollectiveRemoteAccessDistributed : public CollectiveRemoteAccessLocal {
   CollectiveRemoteAccessDistributed(
       const DeviceMgr* dev_mgr, DeviceResolverInterface* dev_resolver,
       std::shared_ptr<UnboundedWorkQueue> work_queue,
-      WorkerCacheInterface* worker_cache, int64 step_id)
+      WorkerCacheInterface* worker_cache, int64 step_id,
+      TensorTransport* tensor_transport = nullptr)
       : CollectiveRemoteAccessLocal(dev_mgr, dev_resolver, work_queue, step_id),
-        worker_cache_(worker_cache) {}
+        worker_cache_(worker_cache),
+        tensor_transport_(tensor_transport) {}
 
   ~CollectiveRemoteAccessDistributed() override {}
 
@@ -46,6 +49,8 @@ class CollectiveRemoteAccessDistributed : public CollectiveRemoteAccessLocal {
 
  protected:
   WorkerCacheInterface* worker_cache_;  // Not owned
+  // If set, used instead of RecvBuf for the peers it reaches.
+  TensorTransport* tensor_transport_;  // Not owned
   CancellationManager cancel_mgr_;
 };
 
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/graph_mgr.h"
 
 #include <chrono>  // NOLINT(build/c++11)
+#include <set>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/build_graph_options.h"
@@ -100,6 +101,36 @@ static Status ValidateGraphDefForDevices(const GraphDef& gdef) {
   return Status::OK();
 }
 
+// Starts resolving the groups of the collective ops of "graph" on "device",
+// so that their first execution does not wait for the group leader.
+static void PrefetchCollectiveGroups(ParamResolverInterface* resolver,
+                                     const Device* device, const Graph& graph) {
+  std::set<int32> group_keys;
+  for (const Node* node : graph.op_nodes()) {
+    CollectiveType type;
+    if (node->type_string() == "CollectiveReduce") {
+      type = REDUCTION_COLLECTIVE;
+    } else if (node->type_string() == "CollectiveBcastSend" ||
+               node->type_string() == "CollectiveBcastRecv") {
+      type = BROADCAST_COLLECTIVE;
+    } else if (node->type_string() == "CollectiveGather") {
+      type = GATHER_COLLECTIVE;
+    } else {
+      continue;
+    }
+    CollectiveParams cp;
+    if (!GetNodeAttr(node->attrs(), "group_key", &cp.group.group_key).ok() ||
+        !GetNodeAttr(node->attrs(), "group_size", &cp.group.group_size).ok() ||
+        !group_keys.insert(cp.group.group_key).second) {
+      continue;
+    }
+    cp.name = node->name();
+    cp.group.device_type = DeviceType(device->device_type());
+    cp.instance.type = type;
+    resolver->PrefetchGroupAsync(device->name(), cp);
+  }
+}
+
 Status GraphMgr::DecorateAndPublishGraphForDebug(
     const DebugOptions& debug_options, Graph* graph, Device* device) {
   std::unique_ptr<DebugGraphDecoratorInterface> decorator;
@@ -148,6 +179,7 @@ Status GraphMgr::InitItem(
   opts.allow_internal_ops = true;
   opts.expect_device_spec = true;
   opts.validate_nodes = true;
+  opts.validation_thread_pool = worker_env_->compute_pool;
   TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, gdef, &graph));
 
   // Splits "graph" into multiple subgraphs by device names.
@@ -282,6 +314,12 @@ Status GraphMgr::InitItem(
       skip_cost_models_ = false;
     }
     TF_RETURN_IF_ERROR(NewLocalExecutor(params, *unit->graph, &unit->root));
+    if (collective_graph_key != BuildGraphOptions::kNoCollectiveGraphKey &&
+        worker_env_->collective_executor_mgr) {
+      PrefetchCollectiveGroups(
+          worker_env_->collective_executor_mgr->GetParamResolver(),
+          unit->device, *unit->graph);
+    }
   }
   return Status::OK();
 }
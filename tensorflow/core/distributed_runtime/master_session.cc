@@ -47,10 +47,12 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -98,13 +100,16 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   }
 
   ~ReffedClientGraph() override {
-    if (should_deregister_) {
+    if (should_deregister_ && registered_by_ == nullptr) {
       DeregisterPartitions();
     } else {
       for (Part& part : partitions_) {
         worker_cache_->ReleaseWorker(part.name, part.worker);
       }
     }
+    if (registered_by_ != nullptr) {
+      registered_by_->Unref();
+    }
   }
 
   const CallableOptions& callable_options() { return callable_opts_; }
@@ -195,8 +200,10 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   // Local execution methods.
 
   // Partitions the graph into subgraphs and registers them on
-  // workers.
-  Status RegisterPartitions(PartitionOptions popts);
+  // workers. If "session" already registered the same subgraphs for
+  // another ReffedClientGraph, e.g. for a callable or run signature that
+  // prunes to the same graph, they are used instead.
+  Status RegisterPartitions(PartitionOptions popts, MasterSession* session);
 
   // Runs one step of all partitions.
   Status RunPartitions(const MasterEnv* env, int64 step_id,
@@ -283,6 +290,10 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   // init_result_ remembers the initialization error if any.
   Status init_result_ GUARDED_BY(mu_);
 
+  // If not null, the graph that registered partitions_ on the workers, which
+  // this graph holds a reference to so that they stay registered.
+  ReffedClientGraph* registered_by_ = nullptr;
+
   std::unique_ptr<StatsPublisherInterface> stats_publisher_;
 
   string DetailText(const NodeDetails& details, const NodeExecStats& stats) {
@@ -304,6 +315,13 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   static void TrackFeedsAndFetches(Part* part, const GraphDef& graph_def,
                                    const PartitionOptions& popts);
 
+  // Returns the fingerprint of everything that determines the registered
+  // partitions of "client_graph", or 0 if they should not be shared.
+  uint64 PartitionsFingerprint(const ClientGraph& client_graph);
+
+  // Uses the partitions registered by "other" as partitions_.
+  Status SharePartitions(ReffedClientGraph* other);
+
   // The actual graph partitioning and registration implementation.
   Status DoBuildPartitions(
       PartitionOptions popts, ClientGraph* client_graph,
@@ -331,7 +349,7 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
 };
 
 Status MasterSession::ReffedClientGraph::RegisterPartitions(
-    PartitionOptions popts) {
+    PartitionOptions popts, MasterSession* session) {
   {  // Ensure register once.
     mu_.lock();
     if (client_graph_before_register_) {
@@ -342,6 +360,20 @@ Status MasterSession::ReffedClientGraph::RegisterPartitions(
       std::unique_ptr<ClientGraph> client_graph;
       std::swap(client_graph_before_register_, client_graph);
       mu_.unlock();
+      const uint64 fingerprint = PartitionsFingerprint(*client_graph);
+      ReffedClientGraph* registered =
+          fingerprint == 0 ? nullptr
+                           : session->FindRegisteredPartitions(fingerprint);
+      if (registered != nullptr) {
+        VLOG(1) << "Reusing the partitions registered for graph fingerprint "
+                << fingerprint;
+        Status s = SharePartitions(registered);
+        mu_.lock();
+        init_result_ = s;
+        init_done_.Notify();
+        mu_.unlock();
+        return s;
+      }
       std::unordered_map<string, GraphDef> graph_defs;
       popts.flib_def = client_graph->flib_def.get();
       Status s = DoBuildPartitions(popts, client_graph.get(), &graph_defs);
@@ -358,6 +390,9 @@ Status MasterSession::ReffedClientGraph::RegisterPartitions(
         stats_publisher_->PublishGraphProto(graph_defs_for_publishing);
         s = DoRegisterPartitions(popts, std::move(graph_defs));
       }
+      if (s.ok() && fingerprint != 0) {
+        session->AddRegisteredPartitions(fingerprint, this);
+      }
       mu_.lock();
       init_result_ = s;
       init_done_.Notify();
@@ -372,6 +407,53 @@ Status MasterSession::ReffedClientGraph::RegisterPartitions(
   }
 }
 
+uint64 MasterSession::ReffedClientGraph::PartitionsFingerprint(
+    const ClientGraph& client_graph) {
+  // Partial runs keep per-handle state on the workers, so their graphs are
+  // always registered separately.
+  if (is_partial_) return 0;
+  GraphDef graph_def;
+  client_graph.graph.ToGraphDef(&graph_def);
+  string serialized;
+  if (!SerializeToStringDeterministic(graph_def, &serialized)) return 0;
+  uint64 fingerprint = Fingerprint64(serialized);
+  if (!SerializeToStringDeterministic(
+          callable_opts_.run_options().debug_options(), &serialized)) {
+    return 0;
+  }
+  fingerprint = FingerprintCat64(fingerprint, Fingerprint64(serialized));
+  fingerprint = FingerprintCat64(fingerprint, collective_graph_key_);
+  // 0 means "do not share".
+  return fingerprint == 0 ? 1 : fingerprint;
+}
+
+Status MasterSession::ReffedClientGraph::SharePartitions(
+    ReffedClientGraph* other) {
+  partitions_.reserve(other->partitions_.size());
+  for (const Part& other_part : other->partitions_) {
+    partitions_.emplace_back();
+    Part* part = &partitions_.back();
+    part->name = other_part.name;
+    part->feed_key = other_part.feed_key;
+    part->key_fetch = other_part.key_fetch;
+    part->graph_handle = other_part.graph_handle;
+    part->worker = worker_cache_->GetOrCreateWorker(part->name);
+    if (part->worker == nullptr) {
+      // The graph handles belong to "other", so they must not be
+      // deregistered on destruction.
+      for (Part& p : partitions_) {
+        worker_cache_->ReleaseWorker(p.name, p.worker);
+      }
+      partitions_.clear();
+      other->Unref();
+      return errors::NotFound("worker ", other_part.name);
+    }
+  }
+  // Takes over the reference returned by FindRegisteredPartitions().
+  registered_by_ = other;
+  return Status::OK();
+}
+
 static string SplitByWorker(const Node* node) {
   string task;
   string device;
@@ -1252,6 +1334,7 @@ MasterSession::MasterSession(
 MasterSession::~MasterSession() {
   for (const auto& iter : run_graphs_) iter.second->Unref();
   for (const auto& iter : partial_run_graphs_) iter.second->Unref();
+  for (const auto& iter : registered_partitions_) iter.second->Unref();
 }
 
 void MasterSession::UpdateLastAccessTime() {
@@ -1545,6 +1628,24 @@ void MasterSession::ClearRunsTable(std::vector<ReffedClientGraph*>* to_unref,
   rcg_map->clear();
 }
 
+MasterSession::ReffedClientGraph* MasterSession::FindRegisteredPartitions(
+    uint64 fingerprint) {
+  mutex_lock l(mu_);
+  auto iter = registered_partitions_.find(fingerprint);
+  if (iter == registered_partitions_.end()) return nullptr;
+  iter->second->Ref();
+  return iter->second;
+}
+
+void MasterSession::AddRegisteredPartitions(uint64 fingerprint,
+                                            ReffedClientGraph* rcg) {
+  mutex_lock l(mu_);
+  if (closed_) return;
+  if (registered_partitions_.insert({fingerprint, rcg}).second) {
+    rcg->Ref();
+  }
+}
+
 uint64 MasterSession::NewStepId(int64 graph_key) {
   if (graph_key == BuildGraphOptions::kNoCollectiveGraphKey) {
     // StepId must leave the most-significant 7 bits empty for future use.
@@ -1682,7 +1783,7 @@ Status MasterSession::BuildAndRegisterPartitions(ReffedClientGraph* rcg) {
     popts.need_to_record_start_times = true;
   }
 
-  TF_RETURN_IF_ERROR(rcg->RegisterPartitions(std::move(popts)));
+  TF_RETURN_IF_ERROR(rcg->RegisterPartitions(std::move(popts), this));
 
   return Status::OK();
 }
@@ -2098,6 +2199,7 @@ Status MasterSession::Close() {
     ClearRunsTable(&to_unref, &run_graphs_);
     ClearRunsTable(&to_unref, &partial_run_graphs_);
     ClearRunsTable(&to_unref, &callables_);
+    ClearRunsTable(&to_unref, &registered_partitions_);
   }
   for (ReffedClientGraph* rcg : to_unref) rcg->Unref();
   if (should_delete_worker_sessions_) {
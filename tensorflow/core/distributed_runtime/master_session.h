@@ -157,6 +157,11 @@ class MasterSession : public core::RefCounted {
   int64 next_callable_handle_ GUARDED_BY(mu_) = 0;
   RCGMap callables_ GUARDED_BY(mu_);
 
+  // Maps the fingerprint of a partitioned graph to the ReffedClientGraph
+  // that registered its partitions, so that graphs for other signatures
+  // that prune to the same subgraph skip partitioning and registration.
+  RCGMap registered_partitions_ GUARDED_BY(mu_);
+
   struct PerStepState {
     bool collect_costs = false;
     bool collect_timeline = false;
@@ -225,6 +230,12 @@ class MasterSession : public core::RefCounted {
                    ReffedClientGraph** out_rcg, int64* out_count);
   void ClearRunsTable(std::vector<ReffedClientGraph*>* to_unref,
                       RCGMap* rcg_map) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns a new reference to the graph that registered the partitions
+  // with "fingerprint", or nullptr if there is none.
+  ReffedClientGraph* FindRegisteredPartitions(uint64 fingerprint)
+      LOCKS_EXCLUDED(mu_);
+  void AddRegisteredPartitions(uint64 fingerprint, ReffedClientGraph* rcg)
+      LOCKS_EXCLUDED(mu_);
   void FillPerStepState(MasterSession::ReffedClientGraph* rcg,
                         const RunOptions& run_options, uint64 step_id,
                         int64 count, PerStepState* out_pss,
@@ -15,11 +15,16 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_client.h"
 
+#include <memory>
+#include <vector>
+
 #include "grpcpp/generic/generic_stub.h"
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_service.h"
+#include "tensorflow/core/distributed_runtime/rpc/eager/streaming_enqueue_batcher.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_state.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/env.h"
@@ -62,6 +67,25 @@ bool EnableStreaming() {
   return result;
 }
 
+// Setting environment variable "TF_EAGER_CLIENT_STREAMING_ENQUEUE_BATCH" to
+// true coalesces the requests fed into a StreamingEnqueue call while an
+// earlier one waits for its response, see StreamingEnqueueBatcher. An error
+// in any item of a coalesced request is then reported for all of them.
+bool EnableStreamingEnqueueBatching() {
+  static const bool enabled = [] {
+    bool enabled;
+    Status s = ReadBoolFromEnvVar("TF_EAGER_CLIENT_STREAMING_ENQUEUE_BATCH",
+                                  /*default_val=*/false, &enabled);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to read TF_EAGER_CLIENT_STREAMING_ENQUEUE_BATCH: "
+                 << s;
+      enabled = false;
+    }
+    return enabled;
+  }();
+  return enabled;
+}
+
 // Ref-counted thread to handle callbacks for completed requests a GRPC
 // completion queue. The thread might be shared by multiple eager clients, and
 // each one of them should hold a reference count to ensure that the thread
@@ -148,9 +172,13 @@ class GrpcEagerClient : public EagerClient {
 
     mutex_lock l(mu_);
     const auto& it = enqueue_dispatchers_.find(request->context_id());
+    const auto& batcher_it = enqueue_batchers_.find(request->context_id());
     if (it != enqueue_dispatchers_.end()) {
       it->second.CancelCall();
       enqueue_dispatchers_.erase(it);
+    } else if (batcher_it != enqueue_batchers_.end()) {
+      batcher_it->second->CancelCall();
+      enqueue_batchers_.erase(batcher_it);
     } else if (EnableStreaming()) {
       LOG(ERROR) << "Remote EagerContext with id " << request->context_id()
                  << " does not seem to exist.";
@@ -161,7 +189,34 @@ class GrpcEagerClient : public EagerClient {
                              EnqueueResponse* response,
                              StatusCallback done) override {
     StatusCallback done_wrapped = callback_wrapper(std::move(done));
-    if (EnableStreaming()) {
+    if (EnableStreaming() && EnableStreamingEnqueueBatching()) {
+      std::shared_ptr<StreamingEnqueueBatcher> batcher;
+      {
+        tf_shared_lock l(mu_);
+        auto it = enqueue_batchers_.find(request->context_id());
+        if (it != enqueue_batchers_.end()) batcher = it->second;
+      }
+      if (batcher == nullptr) {
+        mutex_lock l(mu_);
+        std::shared_ptr<StreamingEnqueueBatcher>& entry =
+            enqueue_batchers_[request->context_id()];
+        if (entry == nullptr) {
+          auto dispatcher =
+              std::make_shared<StreamingRPCDispatcher<EnqueueResponse>>(
+                  &stub_, cq_,
+                  "/tensorflow.eager.EagerService/StreamingEnqueue");
+          entry = std::make_shared<StreamingEnqueueBatcher>(
+              [dispatcher](const EnqueueRequest& request,
+                           EnqueueResponse* response, StatusCallback done) {
+                dispatcher->SendNextRequest(request, response,
+                                            std::move(done));
+              },
+              [dispatcher]() { dispatcher->CancelCall(); });
+        }
+        batcher = entry;
+      }
+      batcher->Enqueue(*request, response, std::move(done_wrapped));
+    } else if (EnableStreaming()) {
       tf_shared_lock l(mu_);
       auto it = enqueue_dispatchers_.find(request->context_id());
       if (it == enqueue_dispatchers_.end()) {
@@ -196,6 +251,10 @@ class GrpcEagerClient : public EagerClient {
 
   std::unordered_map<uint64, StreamingRPCDispatcher<EnqueueResponse>>
       enqueue_dispatchers_ GUARDED_BY(mu_);
+  // Used instead of enqueue_dispatchers_ with
+  // TF_EAGER_CLIENT_STREAMING_ENQUEUE_BATCH.
+  std::unordered_map<uint64, std::shared_ptr<StreamingEnqueueBatcher>>
+      enqueue_batchers_ GUARDED_BY(mu_);
 
   StatusCallback callback_wrapper(StatusCallback done) {
     Ref();
@@ -0,0 +1,118 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/eager/streaming_enqueue_batcher.h"
+
+#include <utility>
+
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace eager {
+
+StreamingEnqueueBatcher::StreamingEnqueueBatcher(
+    SendFn send, std::function<void()> cancel_call)
+    : send_(std::move(send)), cancel_call_(std::move(cancel_call)) {}
+
+void StreamingEnqueueBatcher::Enqueue(const EnqueueRequest& request,
+                                      EnqueueResponse* response,
+                                      StatusCallback done) {
+  Batch* batch = nullptr;
+  {
+    mutex_lock l(mu_);
+    if (!cancelled_) {
+      next_.request.set_context_id(request.context_id());
+      next_.request.mutable_queue()->MergeFrom(request.queue());
+      next_.callers.push_back(
+          {request.queue_size(), response, std::move(done)});
+      if (in_flight_) return;
+      in_flight_ = true;
+      batch = TakeNextBatchLocked();
+    }
+  }
+  if (batch == nullptr) {
+    done(errors::Cancelled("The remote eager context was closed"));
+    return;
+  }
+  Send(batch);
+}
+
+void StreamingEnqueueBatcher::CancelCall() {
+  std::vector<Caller> callers;
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    next_.request.Clear();
+    callers.swap(next_.callers);
+  }
+  cancel_call_();
+  for (Caller& caller : callers) {
+    caller.done(errors::Cancelled("The remote eager context was closed"));
+  }
+}
+
+StreamingEnqueueBatcher::Batch* StreamingEnqueueBatcher::TakeNextBatchLocked() {
+  Batch* batch = new Batch;
+  batch->request.Swap(&next_.request);
+  batch->callers.swap(next_.callers);
+  return batch;
+}
+
+void StreamingEnqueueBatcher::Send(Batch* batch) {
+  VLOG(3) << "Sending " << batch->request.queue_size() << " queue items of "
+          << batch->callers.size() << " StreamingEnqueue requests";
+  std::shared_ptr<StreamingEnqueueBatcher> self = shared_from_this();
+  send_(batch->request, &batch->response,
+        [self, batch](const Status& s) { self->BatchDone(batch, s); });
+}
+
+void StreamingEnqueueBatcher::BatchDone(Batch* batch, Status s) {
+  Batch* next = nullptr;
+  {
+    mutex_lock l(mu_);
+    if (next_.callers.empty()) {
+      in_flight_ = false;
+    } else {
+      next = TakeNextBatchLocked();
+    }
+  }
+  if (next != nullptr) {
+    Send(next);
+  }
+
+  if (s.ok() &&
+      batch->response.queue_response_size() != batch->request.queue_size()) {
+    s = errors::Internal("StreamingEnqueue returned ",
+                         batch->response.queue_response_size(),
+                         " queue responses for ", batch->request.queue_size(),
+                         " queue items");
+  }
+  int offset = 0;
+  for (Caller& caller : batch->callers) {
+    if (s.ok()) {
+      for (int i = 0; i < caller.num_items; ++i) {
+        caller.response->add_queue_response()->Swap(
+            batch->response.mutable_queue_response(offset + i));
+      }
+    }
+    offset += caller.num_items;
+    caller.done(s);
+  }
+  delete batch;
+}
+
+}  // namespace eager
+}  // namespace tensorflow
@@ -0,0 +1,88 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_EAGER_STREAMING_ENQUEUE_BATCHER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_EAGER_STREAMING_ENQUEUE_BATCHER_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/eager_service.pb.h"
+
+namespace tensorflow {
+namespace eager {
+
+// Feeds the EnqueueRequests of one remote context into its StreamingEnqueue
+// call, one request in flight at a time. Requests fed while one waits for its
+// response are merged, and sent as a single request once it arrives. The
+// service handles the requests of a stream one at a time anyway, so this
+// saves the per-request overhead of tf.functions and loops that enqueue many
+// remote ops without delaying a lone op.
+//
+// An error in any item of a merged request is reported to all of its callers.
+class StreamingEnqueueBatcher
+    : public std::enable_shared_from_this<StreamingEnqueueBatcher> {
+ public:
+  // Sends `request` on the streaming call, and calls `done` once `response`
+  // is filled in.
+  typedef std::function<void(const EnqueueRequest& request,
+                             EnqueueResponse* response, StatusCallback done)>
+      SendFn;
+
+  // `cancel_call` cancels the streaming call that `send` feeds.
+  StreamingEnqueueBatcher(SendFn send, std::function<void()> cancel_call);
+
+  void Enqueue(const EnqueueRequest& request, EnqueueResponse* response,
+               StatusCallback done);
+
+  // Cancels the streaming call, and the requests waiting to be sent.
+  void CancelCall();
+
+ private:
+  // A caller of Enqueue, whose items are the next "num_items" of a batch.
+  struct Caller {
+    int num_items;
+    EnqueueResponse* response;
+    StatusCallback done;
+  };
+
+  struct Batch {
+    EnqueueRequest request;
+    EnqueueResponse response;
+    std::vector<Caller> callers;
+  };
+
+  Batch* TakeNextBatchLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void Send(Batch* batch);
+  void BatchDone(Batch* batch, Status s);
+
+  const SendFn send_;
+  const std::function<void()> cancel_call_;
+
+  mutex mu_;
+  bool in_flight_ GUARDED_BY(mu_) = false;
+  bool cancelled_ GUARDED_BY(mu_) = false;
+  // The requests fed since the batch in flight was sent.
+  Batch next_ GUARDED_BY(mu_);
+};
+
+}  // namespace eager
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_EAGER_STREAMING_ENQUEUE_BATCHER_H_
@@ -0,0 +1,206 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/eager/streaming_enqueue_batcher.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace eager {
+namespace {
+
+// A request with one operation per id.
+EnqueueRequest MakeRequest(const std::vector<int64>& op_ids) {
+  EnqueueRequest request;
+  request.set_context_id(42);
+  for (int64 id : op_ids) {
+    request.add_queue()->mutable_operation()->set_id(id);
+  }
+  return request;
+}
+
+std::vector<int64> OpIds(const EnqueueRequest& request) {
+  std::vector<int64> ids;
+  for (const QueueItem& item : request.queue()) {
+    ids.push_back(item.operation().id());
+  }
+  return ids;
+}
+
+// Returns the op ids that Respond() stored in the queue responses, as the size
+// of their first dimension.
+std::vector<int64> ResponseIds(const EnqueueResponse& response) {
+  std::vector<int64> ids;
+  for (const QueueResponse& queue_response : response.queue_response()) {
+    ids.push_back(queue_response.shape(0).dim(0).size());
+  }
+  return ids;
+}
+
+// One Enqueue call and the status it was done with, if any.
+struct Call {
+  EnqueueResponse response;
+  bool done = false;
+  Status status;
+};
+
+class StreamingEnqueueBatcherTest : public ::testing::Test {
+ protected:
+  StreamingEnqueueBatcherTest()
+      : batcher_(std::make_shared<StreamingEnqueueBatcher>(
+            [this](const EnqueueRequest& request, EnqueueResponse* response,
+                   StatusCallback done) {
+              sent_.push_back({request, response, std::move(done)});
+            },
+            [this]() { ++num_cancel_calls_; })) {}
+
+  void Enqueue(const std::vector<int64>& op_ids, Call* call) {
+    batcher_->Enqueue(MakeRequest(op_ids), &call->response,
+                      [call](const Status& s) {
+                        call->done = true;
+                        call->status = s;
+                      });
+  }
+
+  // Answers the `i`-th sent request with one queue response per item, tagged
+  // with its op id, or fails it with `status`.
+  void Respond(int i, const Status& status = Status::OK()) {
+    if (status.ok()) {
+      EnqueueResponse* response = sent_[i].response;
+      for (int64 id : OpIds(sent_[i].request)) {
+        response->add_queue_response()->add_shape()->add_dim()->set_size(id);
+      }
+    }
+    Done(i, status);
+  }
+
+  // Calls the callback of the `i`-th sent request, which may send the next.
+  void Done(int i, const Status& status) {
+    StatusCallback done = std::move(sent_[i].done);
+    done(status);
+  }
+
+  struct SentRequest {
+    EnqueueRequest request;
+    EnqueueResponse* response;
+    StatusCallback done;
+  };
+
+  std::shared_ptr<StreamingEnqueueBatcher> batcher_;
+  std::vector<SentRequest> sent_;
+  int num_cancel_calls_ = 0;
+};
+
+TEST_F(StreamingEnqueueBatcherTest, LoneRequestIsSentRightAway) {
+  Call call;
+  Enqueue({1, 2}, &call);
+  ASSERT_EQ(sent_.size(), 1);
+  EXPECT_EQ(sent_[0].request.context_id(), 42);
+  EXPECT_EQ(OpIds(sent_[0].request), std::vector<int64>({1, 2}));
+  EXPECT_FALSE(call.done);
+
+  Respond(0);
+  EXPECT_TRUE(call.done);
+  TF_EXPECT_OK(call.status);
+  EXPECT_EQ(ResponseIds(call.response), std::vector<int64>({1, 2}));
+}
+
+TEST_F(StreamingEnqueueBatcherTest, MergesRequestsWhileOneIsInFlight) {
+  Call first, second, third;
+  Enqueue({1}, &first);
+  Enqueue({2, 3}, &second);
+  Enqueue({4}, &third);
+  ASSERT_EQ(sent_.size(), 1);
+
+  // The response to the first request flushes the others as one request.
+  Respond(0);
+  TF_EXPECT_OK(first.status);
+  EXPECT_FALSE(second.done);
+  ASSERT_EQ(sent_.size(), 2);
+  EXPECT_EQ(OpIds(sent_[1].request), std::vector<int64>({2, 3, 4}));
+
+  Respond(1);
+  ASSERT_TRUE(second.done);
+  ASSERT_TRUE(third.done);
+  TF_EXPECT_OK(second.status);
+  TF_EXPECT_OK(third.status);
+  EXPECT_EQ(ResponseIds(second.response), std::vector<int64>({2, 3}));
+  EXPECT_EQ(ResponseIds(third.response), std::vector<int64>({4}));
+
+  // Nothing was waiting, so the next request is sent right away again.
+  Call fourth;
+  Enqueue({5}, &fourth);
+  ASSERT_EQ(sent_.size(), 3);
+  EXPECT_EQ(OpIds(sent_[2].request), std::vector<int64>({5}));
+}
+
+TEST_F(StreamingEnqueueBatcherTest, ErrorIsReportedToAllMergedCallers) {
+  Call first, second, third;
+  Enqueue({1}, &first);
+  Enqueue({2}, &second);
+  Enqueue({3}, &third);
+  Respond(0);
+  Respond(1, errors::Unavailable("worker went away"));
+
+  TF_EXPECT_OK(first.status);
+  EXPECT_TRUE(errors::IsUnavailable(second.status));
+  EXPECT_TRUE(errors::IsUnavailable(third.status));
+  EXPECT_EQ(second.response.queue_response_size(), 0);
+  EXPECT_EQ(third.response.queue_response_size(), 0);
+}
+
+TEST_F(StreamingEnqueueBatcherTest, MissingQueueResponsesAreAnError) {
+  Call first, second;
+  Enqueue({1}, &first);
+  Enqueue({2}, &second);
+  Done(0, Status::OK());
+  EXPECT_TRUE(errors::IsInternal(first.status));
+
+  // The next batch is sent regardless.
+  ASSERT_EQ(sent_.size(), 2);
+  Respond(1);
+  TF_EXPECT_OK(second.status);
+}
+
+TEST_F(StreamingEnqueueBatcherTest, CancelFailsWaitingRequests) {
+  Call first, second;
+  Enqueue({1}, &first);
+  Enqueue({2}, &second);
+  batcher_->CancelCall();
+  EXPECT_EQ(num_cancel_calls_, 1);
+  ASSERT_TRUE(second.done);
+  EXPECT_TRUE(errors::IsCancelled(second.status));
+
+  // The request in flight is done by the cancelled call.
+  EXPECT_FALSE(first.done);
+  Respond(0, errors::Cancelled("call cancelled"));
+  EXPECT_TRUE(errors::IsCancelled(first.status));
+  EXPECT_EQ(sent_.size(), 1);
+
+  Call third;
+  Enqueue({3}, &third);
+  ASSERT_TRUE(third.done);
+  EXPECT_TRUE(errors::IsCancelled(third.status));
+  EXPECT_EQ(sent_.size(), 1);
+}
+
+}  // namespace
+}  // namespace eager
+}  // namespace tensorflow
@@ -148,6 +148,36 @@ Status NewHostPortGrpcChannel(const string& target,
   return Status::OK();
 }
 
+Status NewHostPortGrpcStripeChannel(const string& target, int stripe,
+                                    const RPCOptions* rpc_options,
+                                    SharedGrpcChannelPtr* channel_pointer) {
+  TF_RETURN_IF_ERROR(ValidateHostPortPair(target));
+
+  ::grpc::ChannelArguments args = GetChannelArguments(rpc_options);
+  // gRPC shares connections between channels whose arguments are the same,
+  // so an argument that differs per stripe gives each its own connection.
+  args.SetInt("tensorflow.grpc_channel_stripe", stripe);
+  *channel_pointer = ::grpc::CreateCustomChannel(
+      "dns:///" + target, ::grpc::InsecureChannelCredentials(), args);
+  return Status::OK();
+}
+
+StripeChannelCreationFunction ConvertToStripeChannelCreationFunction(
+    const std::function<Status(string, int, const RPCOptions*,
+                               SharedGrpcChannelPtr*)>& new_channel_func_ptr) {
+  return [new_channel_func_ptr](const string& target,
+                                int stripe) -> SharedGrpcChannelPtr {
+    SharedGrpcChannelPtr channel_ptr;
+    if (new_channel_func_ptr(target, stripe, /*rpc_options=*/nullptr,
+                             &channel_ptr)
+            .ok()) {
+      return channel_ptr;
+    } else {
+      return nullptr;
+    }
+  };
+}
+
 ChannelCreationFunction ConvertToChannelCreationFunction(
     const std::function<Status(string, const RPCOptions*,
                                SharedGrpcChannelPtr*)>& new_channel_func_ptr) {
@@ -266,6 +296,19 @@ class MultiGrpcChannelCache : public CachingGrpcChannelCache {
     return cache->TranslateTask(target);
   }
 
+  std::vector<SharedGrpcChannelPtr> FindWorkerChannels(
+      const string& target) override {
+    if (!FindWorkerChannel(target)) {
+      return {};
+    }
+    GrpcChannelCache* cache;
+    {
+      mutex_lock l(mu_);  // could use reader lock
+      cache = gtl::FindPtrOrNull(target_caches_, target);
+    }
+    return cache->FindWorkerChannels(target);
+  }
+
  protected:
   SharedGrpcChannelPtr FindChannelOnce(const string& target) override {
     for (GrpcChannelCache* cache : caches_) {
@@ -293,10 +336,14 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
  public:
   SparseGrpcChannelCache(const string& job_id,
                          const std::map<int, string>& host_ports,
-                         ChannelCreationFunction channel_func)
+                         ChannelCreationFunction channel_func,
+                         int num_channels_per_target,
+                         StripeChannelCreationFunction stripe_channel_func)
       : job_id_(job_id),
         host_ports_(host_ports),
-        channel_func_(std::move(channel_func)) {
+        channel_func_(std::move(channel_func)),
+        num_channels_per_target_(num_channels_per_target),
+        stripe_channel_func_(std::move(stripe_channel_func)) {
     LOG(INFO) << "Initialize GrpcChannelCache for job " << ToString();
   }
   ~SparseGrpcChannelCache() override {}
@@ -339,6 +386,34 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
     return iter->second;
   }
 
+  std::vector<SharedGrpcChannelPtr> FindWorkerChannels(
+      const string& target) override {
+    std::vector<SharedGrpcChannelPtr> channels =
+        GrpcChannelCache::FindWorkerChannels(target);
+    if (channels.empty() || num_channels_per_target_ <= 1 ||
+        !stripe_channel_func_) {
+      return channels;
+    }
+    mutex_lock l(stripe_mu_);
+    std::vector<SharedGrpcChannelPtr>& stripe_channels =
+        stripe_channels_[target];
+    if (stripe_channels.empty()) {
+      const string host_port = TranslateTask(target);
+      for (int stripe = 1; stripe < num_channels_per_target_; ++stripe) {
+        SharedGrpcChannelPtr ch = stripe_channel_func_(host_port, stripe);
+        if (!ch) {
+          // Fall back to the single channel, and retry next time.
+          stripe_channels.clear();
+          return channels;
+        }
+        stripe_channels.push_back(std::move(ch));
+      }
+    }
+    channels.insert(channels.end(), stripe_channels.begin(),
+                    stripe_channels.end());
+    return channels;
+  }
+
  protected:
   SharedGrpcChannelPtr FindChannelOnce(const string& target) override {
     const string host_port = TranslateTask(target);
@@ -363,13 +438,22 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
   const string job_id_;
   const std::map<int, string> host_ports_;
   const ChannelCreationFunction channel_func_;
+  const int num_channels_per_target_;
+  const StripeChannelCreationFunction stripe_channel_func_;
+
+  mutex stripe_mu_;
+  // The channels of FindWorkerChannels() after the first, by target.
+  std::unordered_map<string, std::vector<SharedGrpcChannelPtr>>
+      stripe_channels_ GUARDED_BY(stripe_mu_);
   TF_DISALLOW_COPY_AND_ASSIGN(SparseGrpcChannelCache);
 };
 
 }  // namespace
 
-GrpcChannelCache* NewGrpcChannelCache(const GrpcChannelSpec& spec,
-                                      ChannelCreationFunction channel_func) {
+GrpcChannelCache* NewGrpcChannelCache(
+    const GrpcChannelSpec& spec, ChannelCreationFunction channel_func,
+    int num_channels_per_target,
+    StripeChannelCreationFunction stripe_channel_func) {
   const int num_jobs = spec.host_ports_jobs().size();
   if (!num_jobs) {
     LOG(ERROR) << "Empty channel spec.";
@@ -378,8 +462,9 @@ GrpcChannelCache* NewGrpcChannelCache(const GrpcChannelSpec& spec,
   std::vector<GrpcChannelCache*> caches;
   caches.reserve(num_jobs);
   for (auto& job : spec.host_ports_jobs()) {
-    caches.push_back(
-        new SparseGrpcChannelCache(job.job_id, job.host_ports, channel_func));
+    caches.push_back(new SparseGrpcChannelCache(
+        job.job_id, job.host_ports, channel_func, num_channels_per_target,
+        stripe_channel_func));
   }
   return caches.size() == 1 ? caches[0] : new MultiGrpcChannelCache(caches);
 }
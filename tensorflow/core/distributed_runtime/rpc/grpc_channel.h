@@ -76,14 +76,37 @@ class GrpcChannelCache {
   // E.g., /job:mnist/task:2
   virtual SharedGrpcChannelPtr FindWorkerChannel(const string& target) = 0;
 
+  // Returns the channels to 'target' across which large transfers are
+  // striped: FindWorkerChannel(target), followed by channels that each have
+  // their own connection if the cache was created to open several channels
+  // per target.  Returns an empty vector if 'target' is not found.
+  virtual std::vector<SharedGrpcChannelPtr> FindWorkerChannels(
+      const string& target) {
+    SharedGrpcChannelPtr channel = FindWorkerChannel(target);
+    if (!channel) {
+      return {};
+    }
+    return {channel};
+  }
+
   // Translates a string in the form `/job:X/task:Z` into a host_port.
   virtual string TranslateTask(const string& task) = 0;
 };
 
 typedef std::function<SharedGrpcChannelPtr(string)> ChannelCreationFunction;
 
-GrpcChannelCache* NewGrpcChannelCache(const GrpcChannelSpec& channel_spec,
-                                      ChannelCreationFunction channel_func);
+// Creates a channel to a host:port that does not share its connection with
+// the channels created for other stripes, or by a ChannelCreationFunction.
+typedef std::function<SharedGrpcChannelPtr(string, int)>
+    StripeChannelCreationFunction;
+
+// If 'num_channels_per_target' is greater than 1, FindWorkerChannels()
+// returns that many channels per target, the extra ones created by
+// 'stripe_channel_func' for stripes 1, 2, ...
+GrpcChannelCache* NewGrpcChannelCache(
+    const GrpcChannelSpec& channel_spec, ChannelCreationFunction channel_func,
+    int num_channels_per_target = 1,
+    StripeChannelCreationFunction stripe_channel_func = nullptr);
 
 // Below here are internal-only functions.
 
@@ -97,6 +120,16 @@ Status NewHostPortGrpcChannel(const string& target,
                               const RPCOptions* rpc_options,
                               SharedGrpcChannelPtr* channel_pointer);
 
+// As NewHostPortGrpcChannel, but the channel has its own connection, which
+// is not shared with channels created for other values of 'stripe'.
+Status NewHostPortGrpcStripeChannel(const string& target, int stripe,
+                                    const RPCOptions* rpc_options,
+                                    SharedGrpcChannelPtr* channel_pointer);
+
+StripeChannelCreationFunction ConvertToStripeChannelCreationFunction(
+    const std::function<Status(string, int, const RPCOptions*,
+                               SharedGrpcChannelPtr*)>& new_channel_func_ptr);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_CHANNEL_H_
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
 
 #include <utility>
+#include <vector>
 
 #include "grpcpp/generic/generic_stub.h"
 #include "grpcpp/grpcpp.h"
@@ -23,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_state.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
@@ -33,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/transport_options.pb.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
@@ -44,11 +47,13 @@ const int kMaxWorkerRpcRetries = 10;
 class GrpcRemoteWorker : public WorkerInterface {
  public:
   explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
+                            std::vector<SharedGrpcChannelPtr> stripe_channels,
                             ::grpc::CompletionQueue* completion_queue,
                             thread::ThreadPool* callback_threadpool,
                             WorkerCacheLogger* logger)
       : channel_(std::move(channel)),
         stub_(channel_),
+        stripe_channels_(std::move(stripe_channels)),
         cq_(completion_queue),
         callback_threadpool_(callback_threadpool),
         getstatus_(Method(GrpcWorkerMethod::kGetStatus)),
@@ -67,7 +72,13 @@ class GrpcRemoteWorker : public WorkerInterface {
         instancesource_(Method(GrpcWorkerMethod::kCompleteInstance)),
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
         markrecvfinished_(Method(GrpcWorkerMethod::kMarkRecvFinished)),
-        logger_(logger) {}
+        batchrecvtensor_(Method(GrpcWorkerMethod::kBatchRecvTensor)),
+        recvtensorstripe_(Method(GrpcWorkerMethod::kRecvTensorStripe)),
+        logger_(logger) {
+    for (const SharedGrpcChannelPtr& stripe_channel : stripe_channels_) {
+      stripe_stubs_.emplace_back(new ::grpc::GenericStub(stripe_channel));
+    }
+  }
 
   ~GrpcRemoteWorker() override {}
 
@@ -169,7 +180,42 @@ class GrpcRemoteWorker : public WorkerInterface {
       done(s);
     };
 
-    IssueRequest(request, response, recvbuf_, callback, call_opts);
+    if (stripe_stubs_.empty()) {
+      IssueRequest(request, response, recvbuf_, callback, call_opts);
+      return;
+    }
+    auto fetch_stripes = [this, call_opts, request, response,
+                          callback](Status s) {
+      const int num_stripes = response->num_stripes();
+      if (!s.ok() || num_stripes <= 1) {
+        callback(s);
+        return;
+      }
+      // Gather the stripes as the chunks of an unstriped response.
+      auto* extra = new RecvBufRespExtra;
+      std::vector<char*> stripe_data(num_stripes);
+      for (int i = 0; i < num_stripes; ++i) {
+        int64 offset;
+        int64 size;
+        grpc::GetTensorStripeBounds(request->num_bytes(), num_stripes, i,
+                                    &offset, &size);
+        string* chunk = extra->add_tensor_content();
+        chunk->resize(size);
+        stripe_data[i] = &(*chunk)[0];
+      }
+      FetchStripes(call_opts, request->request_id(), request->num_bytes(),
+                   stripe_data, [response, callback, extra](Status s) {
+                     if (s.ok()) {
+                       response->mutable_transport_options()->PackFrom(*extra);
+                     }
+                     delete extra;
+                     callback(s);
+                   });
+    };
+    RecvBufRequest striped_request(*request);
+    striped_request.set_max_stripes(stripe_stubs_.size() + 1);
+    IssueRequest(&striped_request, response, recvbuf_, fetch_stripes,
+                 call_opts);
   }
 
   void CompleteGroupAsync(CallOptions* call_opts,
@@ -251,7 +297,56 @@ class GrpcRemoteWorker : public WorkerInterface {
       done(s);
     };
 
-    IssueRequest(request, response, recvtensor_, callback, call_opts);
+    // Stripes are copied into the parsed tensor, so they need it on the host.
+    if (stripe_stubs_.empty() || !response->on_host()) {
+      IssueRequest(request, response, recvtensor_, callback, call_opts);
+      return;
+    }
+    auto fetch_stripes = [this, call_opts, request, response,
+                          callback](Status s) {
+      const int num_stripes = response->metadata().num_stripes();
+      if (!s.ok() || num_stripes <= 1) {
+        callback(s);
+        return;
+      }
+      const StringPiece content = response->tensor().tensor_data();
+      std::vector<char*> stripe_data(num_stripes);
+      for (int i = 0; i < num_stripes; ++i) {
+        int64 offset;
+        int64 size;
+        grpc::GetTensorStripeBounds(content.size(), num_stripes, i, &offset,
+                                    &size);
+        stripe_data[i] = const_cast<char*>(content.data()) + offset;
+      }
+      FetchStripes(call_opts, request->request_id(), content.size(),
+                   stripe_data, callback);
+    };
+    RecvTensorRequest striped_request(*request);
+    striped_request.set_max_stripes(stripe_stubs_.size() + 1);
+    IssueRequest(&striped_request, response, recvtensor_, fetch_stripes,
+                 call_opts);
+  }
+
+  void BatchRecvTensorAsync(CallOptions* call_opts,
+                            const BatchRecvTensorRequest* request,
+                            BatchRecvTensorResponse* response,
+                            StatusCallback done) override {
+    VLOG(1) << "BatchRecvTensorAsync for " << request->request_size()
+            << " tensors";
+    auto callback = [this, request, response, done](Status s) {
+      // Note done() can delete this worker object, so we need to call done()
+      // last.
+      if (s.ok()) {
+        for (int i = 0; i < response->response_size(); ++i) {
+          if (response->response(i).require_ack()) {
+            IssueMarkRecvFinishedRequest(request->request(i).request_id());
+          }
+        }
+      }
+      done(s);
+    };
+
+    IssueRequest(request, response, batchrecvtensor_, callback, call_opts);
   }
 
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
@@ -284,6 +379,74 @@ class GrpcRemoteWorker : public WorkerInterface {
                                  callback_threadpool_);
   }
 
+  // Fetches the stripes of the content of the tensor received by request
+  // "request_id", "total_bytes" in all, into "stripe_data", using the
+  // channels in turn.  Calls "done" once all of them have arrived.  If
+  // "call_opts" is not null, cancelling it cancels the stripes in flight.
+  void FetchStripes(CallOptions* call_opts, int64 request_id,
+                    int64 total_bytes, const std::vector<char*>& stripe_data,
+                    StatusCallback done) {
+    struct FetchState {
+      FetchState(CallOptions* call_opts, int num_stripes, StatusCallback done)
+          : call_opts(call_opts),
+            stripe_opts(num_stripes),
+            pending(num_stripes),
+            done(std::move(done)) {}
+      CallOptions* const call_opts;
+      // One per stripe, since each RPC sets its own cancel callback.
+      std::vector<CallOptions> stripe_opts;
+      mutex mu;
+      int pending GUARDED_BY(mu);
+      Status status GUARDED_BY(mu);
+      const StatusCallback done;
+    };
+    const int num_stripes = stripe_data.size();
+    auto* state = new FetchState(call_opts, num_stripes, std::move(done));
+    if (call_opts != nullptr) {
+      // The parent call has completed, so its cancel callback is free.
+      call_opts->SetCancelCallback([state]() {
+        for (CallOptions& opts : state->stripe_opts) {
+          opts.StartCancel();
+        }
+      });
+    }
+    for (int i = 0; i < num_stripes; ++i) {
+      int64 offset;
+      int64 size;
+      grpc::GetTensorStripeBounds(total_bytes, num_stripes, i, &offset, &size);
+      RecvTensorStripeRequest request;
+      request.set_request_id(request_id);
+      request.set_stripe(i);
+      const int channel = i % (stripe_stubs_.size() + 1);
+      ::grpc::GenericStub* stub =
+          channel == 0 ? &stub_ : stripe_stubs_[channel - 1].get();
+      auto* buffer = new ::grpc::ByteBuffer;
+      char* data = stripe_data[i];
+      new RPCState<::grpc::ByteBuffer>(
+          stub, cq_, recvtensorstripe_, request, buffer,
+          [state, buffer, data, size](Status s) {
+            if (s.ok()) {
+              s = grpc::DecodeTensorStripeFromByteBuffer(buffer, data, size);
+            }
+            delete buffer;
+            Status status;
+            {
+              mutex_lock l(state->mu);
+              state->status.Update(s);
+              if (--state->pending > 0) return;
+              status = state->status;
+            }
+            // Waits for a concurrent cancel callback, which uses "state".
+            if (state->call_opts != nullptr) {
+              state->call_opts->ClearCancelCallback();
+            }
+            state->done(status);
+            delete state;
+          },
+          &state->stripe_opts[i], callback_threadpool_);
+    }
+  }
+
   void IssueMarkRecvFinishedRequest(int64 request_id) {
     VLOG(2) << "Send MarkRecvFinishedRequest for request " << request_id;
     MarkRecvFinishedRequest request;
@@ -299,6 +462,10 @@ class GrpcRemoteWorker : public WorkerInterface {
 
   SharedGrpcChannelPtr channel_;
   ::grpc::GenericStub stub_;
+  // Channels with their own connections, across which large tensors are
+  // striped together with channel_.
+  const std::vector<SharedGrpcChannelPtr> stripe_channels_;
+  std::vector<std::unique_ptr<::grpc::GenericStub>> stripe_stubs_;
   ::grpc::CompletionQueue* cq_;
   thread::ThreadPool* callback_threadpool_;
 
@@ -318,6 +485,8 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string instancesource_;
   const ::grpc::string getstepsequence_;
   const ::grpc::string markrecvfinished_;
+  const ::grpc::string batchrecvtensor_;
+  const ::grpc::string recvtensorstripe_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
@@ -329,8 +498,17 @@ WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      ::grpc::CompletionQueue* completion_queue,
                                      thread::ThreadPool* callback_threadpool,
                                      WorkerCacheLogger* logger) {
-  return new GrpcRemoteWorker(std::move(channel), completion_queue,
+  return new GrpcRemoteWorker(std::move(channel), {}, completion_queue,
                               callback_threadpool, logger);
 }
 
+WorkerInterface* NewGrpcRemoteWorker(
+    SharedGrpcChannelPtr channel,
+    std::vector<SharedGrpcChannelPtr> stripe_channels,
+    ::grpc::CompletionQueue* completion_queue,
+    thread::ThreadPool* callback_threadpool, WorkerCacheLogger* logger) {
+  return new GrpcRemoteWorker(std::move(channel), std::move(stripe_channels),
+                              completion_queue, callback_threadpool, logger);
+}
+
 }  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_REMOTE_WORKER_H_
 
 #include <memory>
+#include <vector>
 
 #include "grpcpp/completion_queue.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
@@ -31,6 +32,15 @@ WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      thread::ThreadPool* callback_threadpool,
                                      WorkerCacheLogger* logger);
 
+// As above, but the content of large tensors received by RecvTensorAsync and
+// RecvBufAsync is striped across "channel" and "stripe_channels", which
+// should each have their own connection.
+WorkerInterface* NewGrpcRemoteWorker(
+    SharedGrpcChannelPtr channel,
+    std::vector<SharedGrpcChannelPtr> stripe_channels,
+    ::grpc::CompletionQueue* completion_queue,
+    thread::ThreadPool* callback_threadpool, WorkerCacheLogger* logger);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_REMOTE_WORKER_H_
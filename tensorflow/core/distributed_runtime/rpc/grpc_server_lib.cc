@@ -42,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 #include "tensorflow/core/distributed_runtime/rpc_collective_executor_mgr.h"
 #include "tensorflow/core/distributed_runtime/server_lib.h"
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/worker_cache_wrapper.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/framework/op.h"
@@ -92,6 +93,31 @@ std::unique_ptr<GrpcWorkerEnv> CreateGrpcWorkerEnv() {
   return absl::make_unique<GrpcWorkerEnv>(num_completion_queues, num_threads);
 }
 
+// Applies the TF_GRPC_WORKER_SERVICE_* environment variables to `options`.
+GrpcWorkerServiceOptions WorkerServiceOptionsFromEnv(
+    GrpcWorkerServiceOptions options) {
+  int64 num_threads;
+  Status status = ReadInt64FromEnvVar("TF_GRPC_WORKER_SERVICE_THREADS",
+                                      options.num_serving_threads,
+                                      &num_threads);
+  if (!status.ok()) {
+    LOG(ERROR) << "Error parsing TF_GRPC_WORKER_SERVICE_THREADS: " << status;
+  } else if (num_threads > 0) {
+    options.num_serving_threads = num_threads;
+  }
+  int64 num_bulk_data_threads;
+  status = ReadInt64FromEnvVar("TF_GRPC_WORKER_SERVICE_BULK_DATA_THREADS",
+                               options.num_bulk_data_threads,
+                               &num_bulk_data_threads);
+  if (!status.ok()) {
+    LOG(ERROR) << "Error parsing TF_GRPC_WORKER_SERVICE_BULK_DATA_THREADS: "
+               << status;
+  } else {
+    options.num_bulk_data_threads = num_bulk_data_threads;
+  }
+  return options;
+}
+
 }  // namespace
 
 GrpcServer::GrpcServer(const ServerDef& server_def, Env* env)
@@ -181,6 +207,15 @@ Status GrpcServer::Init(const GrpcServerOptions& opts) {
   ConfigProto config = server_def_.default_session_config();
   sess_opts.config = config;
 
+  // The transport registers the memory of allocators as they grow, so it
+  // must exist before the devices do.
+  const string& tensor_transport = config.rpc_options().tensor_transport();
+  if (!tensor_transport.empty()) {
+    TF_RETURN_IF_ERROR(NewTensorTransport(tensor_transport, server_def_,
+                                          &tensor_transport_));
+    worker_env_.tensor_transport = tensor_transport_.get();
+  }
+
   // Configure shared devices between master and worker.
   string name_prefix =
       strings::StrCat("/job:", server_def_.job_name(), "/replica:0",
@@ -228,9 +263,11 @@ Status GrpcServer::Init(const GrpcServerOptions& opts) {
   master_service_ = NewGrpcMasterService(master_impl_.get(), config, &builder);
   worker_impl_ = opts.worker_func ? opts.worker_func(&worker_env_, config)
                                   : NewGrpcWorker(&worker_env_, config);
-  worker_service_ = NewGrpcWorkerService(worker_impl_.get(), &builder,
-                                         opts.worker_service_options)
-                        .release();
+  worker_service_ =
+      NewGrpcWorkerService(
+          worker_impl_.get(), &builder,
+          WorkerServiceOptionsFromEnv(opts.worker_service_options))
+          .release();
   eager_service_ = new eager::GrpcEagerServiceImpl(&worker_env_, &builder);
 
   // extra service:
@@ -268,7 +305,8 @@ Status GrpcServer::Init(const GrpcServerOptions& opts) {
                                                default_worker_name));
     worker_env_.collective_executor_mgr = new RpcCollectiveExecutorMgr(
         config, worker_env_.device_mgr, std::move(dev_resolver),
-        std::move(param_resolver), worker_cache, default_worker_name);
+        std::move(param_resolver), worker_cache, default_worker_name,
+        worker_env_.tensor_transport);
   }
 
   // Set up worker environment.
@@ -305,6 +343,10 @@ Status GrpcServer::Init(const GrpcServerOptions& opts) {
         return WorkerCacheFactory(options, worker_cache);
       };
 
+  if (tensor_transport_) {
+    TF_RETURN_IF_ERROR(tensor_transport_->Start(&worker_env_));
+  }
+
   // Provide direct access to the master from in-process clients.
   LocalMaster::Register(target(), master_impl_.get(),
                         config.operation_timeout_in_ms());
@@ -349,8 +391,12 @@ Status GrpcServer::WorkerCacheFactory(const WorkerCacheFactoryOptions& options,
   GrpcChannelSpec channel_spec;
   TF_RETURN_IF_ERROR(ParseChannelSpec(options, &channel_spec));
 
-  std::shared_ptr<GrpcChannelCache> channel_cache(
-      NewGrpcChannelCache(channel_spec, GetChannelCreationFunction()));
+  std::shared_ptr<GrpcChannelCache> channel_cache(NewGrpcChannelCache(
+      channel_spec, GetChannelCreationFunction(),
+      server_def_.default_session_config()
+          .rpc_options()
+          .num_channels_per_target(),
+      GetStripeChannelCreationFunction()));
 
   string name_prefix = strings::StrCat("/job:", *options.job_name, "/replica:0",
                                        "/task:", options.task_index);
@@ -492,6 +538,11 @@ ChannelCreationFunction GrpcServer::GetChannelCreationFunction() const {
   return ConvertToChannelCreationFunction(NewHostPortGrpcChannel);
 }
 
+StripeChannelCreationFunction GrpcServer::GetStripeChannelCreationFunction()
+    const {
+  return ConvertToStripeChannelCreationFunction(NewHostPortGrpcStripeChannel);
+}
+
 std::unique_ptr<Master> GrpcServer::CreateMaster(MasterEnv* master_env) {
   return std::unique_ptr<Master>(new Master(master_env, 0.0));
 }
@@ -41,6 +41,7 @@ namespace tensorflow {
 
 class GrpcWorker;
 class Master;
+class TensorTransport;
 
 // function that creates a RendezvousMgr.
 typedef std::function<RendezvousMgrInterface*(const WorkerEnv*)>
@@ -113,6 +114,11 @@ class GrpcServer : public ServerInterface {
 
   virtual ChannelCreationFunction GetChannelCreationFunction() const;
 
+  // Creates the extra channels of the worker cache when
+  // RPCOptions.num_channels_per_target is greater than 1.
+  virtual StripeChannelCreationFunction GetStripeChannelCreationFunction()
+      const;
+
   virtual std::unique_ptr<Master> CreateMaster(MasterEnv* master_env);
 
   // Creates a WorkerCacheInterface for a session.
@@ -163,6 +169,8 @@ class GrpcServer : public ServerInterface {
   AsyncServiceInterface* worker_service_ = nullptr;
   std::unique_ptr<Thread> worker_thread_ GUARDED_BY(mu_);
   std::unique_ptr<GrpcWorkerEnv> grpc_worker_env_;
+  // Set if RPCOptions.tensor_transport names one.
+  std::shared_ptr<TensorTransport> tensor_transport_;
 
   // TensorFlow Eager implementation, and RPC polling thread.
   AsyncServiceInterface* eager_service_ = nullptr;
@@ -452,9 +452,9 @@ Status GrpcSession::RunCallable(CallableHandle handle,
   CallOptions call_options;
   call_options.SetTimeout(options_.config.operation_timeout_in_ms());
   TF_RETURN_IF_ERROR(master_->RunCallable(&call_options, &req, &resp));
-  for (const TensorProto& fetch : resp.fetch()) {
+  for (TensorProto& fetch : *resp.mutable_fetch()) {
     Tensor fetch_tensor;
-    if (!fetch_tensor.FromProto(cpu_allocator(), fetch)) {
+    if (!fetch_tensor.FromProto(cpu_allocator(), std::move(fetch))) {
       return errors::Internal(
           "Could not parse fetched tensor data in response from master.");
     }
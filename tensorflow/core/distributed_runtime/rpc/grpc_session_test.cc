@@ -163,6 +163,50 @@ TEST(GrpcSessionTest, BasicCallable) {
   }
 }
 
+TEST(GrpcSessionTest, CallablesSharingPartitions) {
+  GraphDef graph;
+  string node_names[3];
+  // c = a * b
+  CreateGraphDef(&graph, node_names);
+
+  std::unique_ptr<test::TestCluster> cluster;
+  TF_CHECK_OK(test::TestCluster::MakeTestCluster(Devices(1, 0), 2, &cluster));
+
+  std::unique_ptr<Session> session(
+      NewRemote(Options(cluster->targets()[0], 1)));
+  ASSERT_TRUE(session != nullptr);
+  TF_CHECK_OK(session->Create(graph));
+
+  CallableOptions opts;
+  opts.add_fetch(node_names[2] + ":0");
+  Session::CallableHandle first_handle;
+  TF_CHECK_OK(session->MakeCallable(opts, &first_handle));
+  std::vector<Tensor> outputs;
+  TF_CHECK_OK(session->RunCallable(first_handle, {}, &outputs, nullptr));
+  ASSERT_EQ(1, outputs.size());
+  IsSingleFloatValue(outputs[0], 4.0);
+
+  // The second callable prunes to the same graph as the first, and must keep
+  // working once the first is released.
+  Session::CallableHandle second_handle;
+  TF_CHECK_OK(session->MakeCallable(opts, &second_handle));
+  TF_CHECK_OK(session->ReleaseCallable(first_handle));
+  for (int iters = 0; iters < 3; ++iters) {
+    outputs.clear();
+    TF_CHECK_OK(session->RunCallable(second_handle, {}, &outputs, nullptr));
+    ASSERT_EQ(1, outputs.size());
+    IsSingleFloatValue(outputs[0], 4.0);
+  }
+  TF_CHECK_OK(session->ReleaseCallable(second_handle));
+
+  outputs.clear();
+  TF_CHECK_OK(session->Run({}, {node_names[2] + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  IsSingleFloatValue(outputs[0], 4.0);
+
+  TF_CHECK_OK(session->Close());
+}
+
 TEST(GrpcSessionTest, CallableWithOnDeviceFeedsAndFetches) {
   // Specifying feeds/fetch devices for remote sessions is not yet defined.
   // Ensure that the error is graceful.
@@ -525,6 +569,49 @@ TEST(GrpcSessionTest, LargeTensorSend) {
   TF_CHECK_OK(session->Close());
 }
 
+TEST(GrpcSessionTest, BatchedRecvsWithCrossWorkerDependency) {
+  // The worker processes inherit the environment.
+  setenv("TF_RPC_BATCH_RECV_TENSOR", "1", 1 /* replace */);
+  std::unique_ptr<test::TestCluster> cluster;
+  TF_CHECK_OK(test::TestCluster::MakeTestCluster(Devices(1, 0), 2, &cluster));
+  unsetenv("TF_RPC_BATCH_RECV_TENSOR");
+  const DeviceAttributes& a = cluster->devices()[0];
+  const DeviceAttributes& b = cluster->devices()[1];
+
+  // 'a' receives p and y from 'b' in one batch, but 'b' only produces y from
+  // q, which 'a' computes from p.
+  Graph graph(OpRegistry::Global());
+  Tensor p_tensor(DT_FLOAT, TensorShape({1, 1}));
+  p_tensor.flat<float>()(0) = 3;
+  Node* p = test::graph::Constant(&graph, p_tensor);
+  Node* q = test::graph::Identity(&graph, p);
+  Node* y = test::graph::Unary(&graph, "Square", q);
+  Node* sum = test::graph::Add(&graph, p, y);
+
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+  SetDevice(&def, p->name(), b.name());
+  SetDevice(&def, q->name(), a.name());
+  SetDevice(&def, y->name(), b.name());
+  SetDevice(&def, sum->name(), a.name());
+
+  SessionOptions options = Options(cluster->targets()[0], 1);
+  // Keeps the graph from being folded into a constant.
+  options.config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_disable_meta_optimizer(true);
+  std::unique_ptr<Session> session(NewRemote(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_CHECK_OK(session->Create(def));
+  for (int i = 0; i < 3; ++i) {
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session->Run({}, {sum->name()}, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    IsSingleFloatValue(outputs[0], 12);
+  }
+  TF_CHECK_OK(session->Close());
+}
+
 TEST(GrpcSessionTest, MultiDevices_String) {
   std::unique_ptr<test::TestCluster> cluster;
   TF_CHECK_OK(test::TestCluster::MakeTestCluster(Devices(1, 1), 2, &cluster));
@@ -15,17 +15,22 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 
+#include "grpcpp/impl/codegen/proto_utils.h"
 #include "grpcpp/support/byte_buffer.h"
 #include "grpcpp/support/slice.h"
 #include "absl/flags/flag.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/io/proto_encode_helper.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
 // (Omitted internal-only flag)
@@ -33,6 +38,20 @@ limitations under the License.
 namespace tensorflow {
 namespace grpc {
 
+namespace {
+
+// Contents of the tensors sent for RecvTensorRequests, labeled by the wire
+// encoding they were sent with.
+auto* tensor_wire_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/rpc/tensor_wire_bytes",
+    "The number of tensor bytes sent, by wire encoding.", "encoding");
+
+auto* tensor_wire_saved_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/rpc/tensor_wire_saved_bytes",
+    "The number of tensor bytes saved by wire encodings.", "encoding");
+
+}  // namespace
+
 void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
                                           ::grpc::ByteBuffer* result) {
   ::grpc::Slice slice(proto.ByteSizeLong());
@@ -137,15 +156,12 @@ static void EncodeSkeleton(const Tensor& val, io::ProtoEncodeHelper* e) {
 #endif
 }
 
-void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
-                              ::grpc::ByteBuffer* result) {
+// Encodes "val" into a RecvTensorResponse whose other fields are those of
+// "response".
+static void EncodeTensorWithResponse(const Tensor& val,
+                                     RecvTensorResponse response,
+                                     ::grpc::ByteBuffer* result) {
   const int kLargeTensorBytes = 1024;
-  RecvTensorResponse response;
-  if (is_dead) {
-    response.set_is_dead(is_dead);
-  }
-  response.set_require_ack(require_ack);
-  response.set_send_start_micros(Env::Default()->NowMicros());
   if (!DataTypeCanUseMemcpy(val.dtype())) {
     // Straightforward but slow path for complicated kinds of tensor data
     // TODO(jeff,sanjay): If this becomes an issue, we could
@@ -245,5 +261,128 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
   }
 }
 
+static RecvTensorResponse MakeResponseHeader(bool is_dead, bool require_ack) {
+  RecvTensorResponse response;
+  if (is_dead) {
+    response.set_is_dead(is_dead);
+  }
+  response.set_require_ack(require_ack);
+  response.set_send_start_micros(Env::Default()->NowMicros());
+  return response;
+}
+
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
+                              ::grpc::ByteBuffer* result) {
+  EncodeTensorWithResponse(val, MakeResponseHeader(is_dead, require_ack),
+                           result);
+}
+
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
+                              const RecvTensorRequest& request,
+                              ::grpc::ByteBuffer* result) {
+  RecvTensorResponse response = MakeResponseHeader(is_dead, require_ack);
+  Tensor encoded;
+  if (!is_dead && request.accepted_wire_encodings_size() > 0 &&
+      EncodeTensorForWire(request, val, &encoded, &response)) {
+    const string encoding = TensorWireEncoding_Name(response.wire_encoding());
+    tensor_wire_bytes->GetCell(encoding)->IncrementBy(encoded.TotalBytes());
+    tensor_wire_saved_bytes->GetCell(encoding)->IncrementBy(
+        val.TotalBytes() - encoded.TotalBytes());
+    EncodeTensorWithResponse(encoded, std::move(response), result);
+    return;
+  }
+  if (DataTypeCanUseMemcpy(val.dtype())) {
+    tensor_wire_bytes->GetCell(TensorWireEncoding_Name(WIRE_ENCODING_RAW))
+        ->IncrementBy(val.TotalBytes());
+  }
+  EncodeTensorWithResponse(val, std::move(response), result);
+}
+
+void EncodeBatchRecvTensorResponseToByteBuffer(
+    std::vector<::grpc::ByteBuffer>* responses,
+    const std::vector<int32>& deferred, ::grpc::ByteBuffer* result) {
+  // Each response is encoded as the tag and varint32 length of a
+  // BatchRecvTensorResponse::response entry, followed by its bytes.
+  static const int kMaxHeaderBytes = 1 + core::kMaxVarint32Bytes;
+  std::vector<::grpc::Slice> slices;
+  for (::grpc::ByteBuffer& response : *responses) {
+    std::vector<::grpc::Slice> response_slices;
+    if (response.Length() > 0) {
+      CHECK(response.Dump(&response_slices).ok());
+    }
+    char header[kMaxHeaderBytes];
+    io::ProtoEncodeHelper e(header, kMaxHeaderBytes);
+    e.WriteVarlengthBeginning(BatchRecvTensorResponse::kResponseFieldNumber,
+                              response.Length());
+    slices.emplace_back(e.data(), e.size());
+    for (::grpc::Slice& slice : response_slices) {
+      slices.push_back(std::move(slice));
+    }
+  }
+  if (!deferred.empty()) {
+    // Each deferred index is encoded as an unpacked varint entry.
+    const int max_bytes = deferred.size() * (1 + core::kMaxVarint64Bytes);
+    gtl::InlinedVector<char, 128> buf(max_bytes);
+    io::ProtoEncodeHelper e(buf.data(), max_bytes);
+    for (int32 index : deferred) {
+      e.WriteUint64(BatchRecvTensorResponse::kDeferredFieldNumber, index);
+    }
+    slices.emplace_back(e.data(), e.size());
+  }
+  ::grpc::ByteBuffer tmp(slices.data(), slices.size());
+  result->Swap(&tmp);
+}
+
+void GetTensorStripeBounds(int64 total_bytes, int num_stripes, int stripe,
+                           int64* offset, int64* size) {
+  *offset = total_bytes * stripe / num_stripes;
+  *size = total_bytes * (stripe + 1) / num_stripes - *offset;
+}
+
+void EncodeTensorStripeToByteBuffer(const Tensor& val, int64 offset,
+                                    int64 size, ::grpc::ByteBuffer* result) {
+  static const int kMaxHeaderBytes = 1 + core::kMaxVarint32Bytes;
+  char header[kMaxHeaderBytes];
+  io::ProtoEncodeHelper e(header, kMaxHeaderBytes);
+  e.WriteVarlengthBeginning(RecvTensorStripeResponse::kContentFieldNumber,
+                            size);
+  ::grpc::Slice slices[2];
+  slices[0] = ::grpc::Slice(e.data(), e.size());
+  // Share the backing store of the tensor, as for large tensors in
+  // EncodeTensorWithResponse.
+  const TensorBuffer* buf = DMAHelper::buffer(&val);
+  buf->Ref();
+  slices[1] = ::grpc::Slice(
+      const_cast<char*>(val.tensor_data().data()) + offset, size,
+      [](void* backing) { static_cast<TensorBuffer*>(backing)->Unref(); },
+      const_cast<TensorBuffer*>(buf));
+  ::grpc::ByteBuffer tmp(&slices[0], 2);
+  result->Swap(&tmp);
+}
+
+Status DecodeTensorStripeFromByteBuffer(::grpc::ByteBuffer* buffer, char* dst,
+                                        int64 size) {
+  ::grpc::ProtoBufferReader reader(buffer);
+  protobuf::io::CodedInputStream input(&reader);
+  input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
+  uint32 length = 0;
+  const uint32 tag = input.ReadTag();
+  if (tag != 0) {
+    // The content is the only field, so its tag must come first.
+    if (tag != ((RecvTensorStripeResponse::kContentFieldNumber << 3) | 2) ||
+        !input.ReadVarint32(&length)) {
+      return errors::Internal("Malformed RecvTensorStripe response");
+    }
+  }
+  if (length != size) {
+    return errors::Internal("RecvTensorStripe returned ", length,
+                            " bytes, expected ", size);
+  }
+  if (!input.ReadRaw(dst, length) || input.ReadTag() != 0) {
+    return errors::Internal("Malformed RecvTensorStripe response");
+  }
+  return Status::OK();
+}
+
 }  // namespace grpc
 }  // namespace tensorflow
@@ -16,7 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 
+#include <vector>
+
 #include "grpcpp/impl/codegen/byte_buffer.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 class Tensor;
@@ -49,6 +53,44 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result);
 
+// As above, but encodes "val" with one of the wire encodings accepted by
+// "request" if that makes it smaller (see EncodeTensorForWire).
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
+                              const RecvTensorRequest& request,
+                              ::grpc::ByteBuffer* result);
+
+// Encode byte buffers that each hold an encoded RecvTensorResponse, such as
+// the ones produced by EncodeTensorToByteBuffer, into a byte buffer in a
+// format that is parseable as a BatchRecvTensorResponse protocol buffer
+// holding them in order, and listing "deferred" as its deferred requests,
+// whose byte buffers are empty. The slices of "responses" are shared rather
+// than copied.
+//
+// Discards original contents of *result.
+void EncodeBatchRecvTensorResponseToByteBuffer(
+    std::vector<::grpc::ByteBuffer>* responses,
+    const std::vector<int32>& deferred, ::grpc::ByteBuffer* result);
+
+// Sets "*offset" and "*size" to the bounds in bytes of stripe "stripe" of
+// "num_stripes" of tensor content of "total_bytes" bytes, as defined by
+// RecvTensorStripeRequest.
+void GetTensorStripeBounds(int64 total_bytes, int num_stripes, int stripe,
+                           int64* offset, int64* size);
+
+// Encode the "size" bytes at "offset" of the content of "val" into a byte
+// buffer in a format that is parseable as a RecvTensorStripeResponse,
+// sharing the underlying Tensor buffer for "val".
+//
+// Discards original contents of *result.
+void EncodeTensorStripeToByteBuffer(const Tensor& val, int64 offset,
+                                    int64 size, ::grpc::ByteBuffer* result);
+
+// Copy the content of the RecvTensorStripeResponse encoded in "buffer" to
+// "dst", which holds "size" bytes.  Fails unless the content has exactly
+// that size.
+Status DecodeTensorStripeFromByteBuffer(::grpc::ByteBuffer* buffer, char* dst,
+                                        int64 size);
+
 }  // namespace grpc
 }  // namespace tensorflow
 
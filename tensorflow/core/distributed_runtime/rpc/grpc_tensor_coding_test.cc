@@ -100,4 +100,69 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(GrpcTensorCodingTest, BatchRecvTensorResponse) {
+  // Both a tensor that is copied into the encoding and one whose backing
+  // store is shared, plus a dead tensor.
+  std::vector<Tensor> tensors = {test::AsTensor<float>({1, 2, 3}),
+                                 Tensor(DT_INT32, TensorShape({1000})),
+                                 Tensor(DT_FLOAT, TensorShape({0}))};
+  test::FillIota<int32>(&tensors[1], 0);
+  std::vector<::grpc::ByteBuffer> buffers(tensors.size());
+  for (int i = 0; i < tensors.size(); ++i) {
+    grpc::EncodeTensorToByteBuffer(/*is_dead=*/i == 2, tensors[i],
+                                   /*require_ack=*/i == 1, &buffers[i]);
+  }
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeBatchRecvTensorResponseToByteBuffer(&buffers, {}, &buf);
+
+  std::vector<::grpc::Slice> slices;
+  (void)buf.Dump(&slices);
+  string tmp;
+  for (const auto& s : slices) {
+    tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+  }
+
+  BatchRecvTensorResponse batch;
+  ASSERT_TRUE(batch.ParseFromString(tmp));
+  ASSERT_EQ(tensors.size(), batch.response_size());
+  for (int i = 0; i < tensors.size(); ++i) {
+    const RecvTensorResponse& response = batch.response(i);
+    EXPECT_EQ(i == 2, response.is_dead());
+    EXPECT_EQ(i == 1, response.require_ack());
+    Tensor result_tensor;
+    EXPECT_TRUE(result_tensor.FromProto(response.tensor()));
+    EXPECT_EQ(tensors[i].DebugString(), result_tensor.DebugString());
+  }
+  EXPECT_EQ(0, batch.deferred_size());
+}
+
+TEST_F(GrpcTensorCodingTest, BatchRecvTensorResponseWithDeferred) {
+  std::vector<::grpc::ByteBuffer> buffers(4);
+  grpc::EncodeTensorToByteBuffer(/*is_dead=*/false,
+                                 test::AsTensor<float>({1, 2, 3}),
+                                 /*require_ack=*/false, &buffers[2]);
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeBatchRecvTensorResponseToByteBuffer(&buffers, {0, 1, 3}, &buf);
+
+  std::vector<::grpc::Slice> slices;
+  (void)buf.Dump(&slices);
+  string tmp;
+  for (const auto& s : slices) {
+    tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+  }
+
+  BatchRecvTensorResponse batch;
+  ASSERT_TRUE(batch.ParseFromString(tmp));
+  ASSERT_EQ(4, batch.response_size());
+  EXPECT_FALSE(batch.response(0).has_tensor());
+  Tensor result_tensor;
+  EXPECT_TRUE(result_tensor.FromProto(batch.response(2).tensor()));
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 2, 3}),
+                                 result_tensor);
+  ASSERT_EQ(3, batch.deferred_size());
+  EXPECT_EQ(0, batch.deferred(0));
+  EXPECT_EQ(1, batch.deferred(1));
+  EXPECT_EQ(3, batch.deferred(2));
+}
+
 }  // namespace tensorflow
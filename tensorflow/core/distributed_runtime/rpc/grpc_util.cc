@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/lib/random/random.h"
 
 namespace tensorflow {
@@ -31,8 +32,47 @@ double GenerateUniformRandomNumberBetween(double a, double b) {
   return a + GenerateUniformRandomNumber() * (b - a);
 }
 
+// A buffer that aliases part of a received gRPC slice. The buffer does not
+// own its memory, so that kernels never forward it and write to it.
+class GrpcSliceTensorBuffer : public TensorBuffer {
+ public:
+  GrpcSliceTensorBuffer(::grpc::Slice slice, const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)),
+        slice_(std::move(slice)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("grpc_slice");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const ::grpc::Slice slice_;
+  const size_t size_;
+};
+
 }  // namespace
 
+TensorBuffer* GrpcByteSource::ShareBytes(const char* data, size_t size) {
+  // The reader hands out the memory of the buffer's own slices, unless it had
+  // to decompress the buffer, in which case no slice contains the bytes.
+  std::vector<::grpc::Slice> slices;
+  if (!buffer_->Dump(&slices).ok()) {
+    return nullptr;
+  }
+  for (::grpc::Slice& slice : slices) {
+    const char* begin = reinterpret_cast<const char*>(slice.begin());
+    if (data >= begin && data + size <= begin + slice.size()) {
+      return new GrpcSliceTensorBuffer(std::move(slice), data, size);
+    }
+  }
+  return nullptr;
+}
+
 int64 ComputeBackoffMicroseconds(int current_retry_attempt, int64 min_delay,
                                  int64 max_delay) {
   DCHECK_GE(current_retry_attempt, 0);
@@ -114,6 +154,12 @@ bool GrpcMaybeParseProto(grpc::ByteBuffer* src, string* dst) {
   return true;
 }
 
+// GrpcMaybeParseProto simply takes over the buffer.
+bool GrpcMaybeParseProto(::grpc::ByteBuffer* src, ::grpc::ByteBuffer* dst) {
+  dst->Swap(src);
+  return true;
+}
+
 #ifdef USE_TSTRING
 // GrpcMaybeParseProto simply copies bytes into the tstring.
 bool GrpcMaybeParseProto(grpc::ByteBuffer* src, tstring* dst) {
@@ -53,6 +53,10 @@ class GrpcByteSource : public TensorResponse::Source {
     return stream_;
   }
 
+  // Shares the bytes when they lie in one of the buffer's slices, by taking a
+  // reference to that slice.
+  TensorBuffer* ShareBytes(const char* data, size_t size) override;
+
  private:
   void DeleteStream() {
     if (stream_) {
@@ -134,6 +138,9 @@ bool GrpcMaybeParseProto(::grpc::ByteBuffer* src, string* dst);
 // Copy grpc buffer src to tstring *dst.
 bool GrpcMaybeParseProto(::grpc::ByteBuffer* src, tstring* dst);
 
+// Move grpc buffer src to *dst, for responses that are parsed by the caller.
+bool GrpcMaybeParseProto(::grpc::ByteBuffer* src, ::grpc::ByteBuffer* dst);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_UTIL_H_
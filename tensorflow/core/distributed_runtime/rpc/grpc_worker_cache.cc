@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_cache.h"
 
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_client.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
@@ -64,12 +65,15 @@ class GrpcWorkerCache : public WorkerCachePartial {
     if (target == local_target_) {
       return local_worker_;
     } else {
-      SharedGrpcChannelPtr channel = channel_cache_->FindWorkerChannel(target);
-      if (!channel) {
+      std::vector<SharedGrpcChannelPtr> channels =
+          channel_cache_->FindWorkerChannels(target);
+      if (channels.empty()) {
         return nullptr;
       }
+      SharedGrpcChannelPtr channel = std::move(channels[0]);
+      channels.erase(channels.begin());
       size_t index = AssignWorkerToThread(target);
-      return NewGrpcRemoteWorker(channel,
+      return NewGrpcRemoteWorker(channel, std::move(channels),
                                  worker_env_->GetCompletionQueue(index),
                                  worker_env_->GetThreadPool(), &logger_);
     }
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
 
+#include <algorithm>
 #include <deque>
+#include <limits>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -45,6 +47,7 @@ limitations under the License.
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
@@ -93,6 +96,16 @@ namespace {
     ENQUEUE_REQUEST(method, supports_cancel);                                  \
   }
 
+// The methods a GrpcWorkerServiceThread requests on its completion queue.
+enum class ServedMethods {
+  kAll,
+  // All methods except RecvTensor, BatchRecvTensor, RecvBuf and
+  // RecvTensorStripe.
+  kControl,
+  // Only RecvTensor, BatchRecvTensor, RecvBuf and RecvTensorStripe.
+  kBulkData,
+};
+
 // GrpcWorkerService spawns one or more GrpcWorkerServiceThreads to service
 // requests.  Each thread operates on an independent completion queue.
 class GrpcWorkerServiceThread {
@@ -100,8 +113,10 @@ class GrpcWorkerServiceThread {
   explicit GrpcWorkerServiceThread(
       GrpcWorker* worker, ::grpc::ServerBuilder* builder,
       std::unordered_map<int, int> queue_depth, GrpcResponseCache* cache,
-      grpc::WorkerService::AsyncService* worker_service)
+      grpc::WorkerService::AsyncService* worker_service,
+      ServedMethods served_methods)
       : worker_(worker),
+        served_methods_(served_methods),
         queue_depth_(queue_depth),
         cache_(cache),
         worker_service_(worker_service),
@@ -129,33 +144,51 @@ class GrpcWorkerServiceThread {
   // Add one or more completion queue entries for each worker method, then
   // begin servicing requests from the completion queue.
   void HandleRPCsLoop() {
-    // TODO(ncteisen): This may require performance engineering. We can
-    // change the number of threads, the number of handlers per thread,
-    // or even decide to specialize certain threads to certain methods.
-    SETUP_FOR_REQUEST(GetStatus, 1, false);
-    SETUP_FOR_REQUEST(CreateWorkerSession, 1, false);
-    SETUP_FOR_REQUEST(DeleteWorkerSession, 1, false);
-    SETUP_FOR_REQUEST(CleanupAll, 1, false);
-    SETUP_FOR_REQUEST(RegisterGraph, 1, false);
-    SETUP_FOR_REQUEST(DeregisterGraph, 1, false);
-    SETUP_FOR_REQUEST(Logging, 1, false);
-    SETUP_FOR_REQUEST(Tracing, 1, false);
-    SETUP_FOR_REQUEST(CompleteGroup, 10, true);
-    SETUP_FOR_REQUEST(CompleteInstance, 10, true);
-    SETUP_FOR_REQUEST(GetStepSequence, 10, true);
-    SETUP_FOR_REQUEST(RecvBuf, 500, true);
-    SETUP_FOR_REQUEST(RunGraph, 100, true);
-    SETUP_FOR_REQUEST(CleanupGraph, 100, false);
-    SETUP_FOR_REQUEST(MarkRecvFinished, 10, false);
-
-    // TODO(ncteisen): Determine a better policy for enqueuing the
-    // appropriate number of each request type.
-    for (int i = 0;
-         i < gtl::FindWithDefault(
-                 queue_depth_, static_cast<int>(GrpcWorkerMethod::kRecvTensor),
-                 1000);
-         ++i) {
-      EnqueueRecvTensorRequestRaw();
+    // gRPC only delivers a call to a completion queue on which its method has
+    // been requested, so threads restricted to some methods never see the
+    // others.
+    if (served_methods_ != ServedMethods::kBulkData) {
+      SETUP_FOR_REQUEST(GetStatus, 1, false);
+      SETUP_FOR_REQUEST(CreateWorkerSession, 1, false);
+      SETUP_FOR_REQUEST(DeleteWorkerSession, 1, false);
+      SETUP_FOR_REQUEST(CleanupAll, 1, false);
+      SETUP_FOR_REQUEST(RegisterGraph, 1, false);
+      SETUP_FOR_REQUEST(DeregisterGraph, 1, false);
+      SETUP_FOR_REQUEST(Logging, 1, false);
+      SETUP_FOR_REQUEST(Tracing, 1, false);
+      SETUP_FOR_REQUEST(CompleteGroup, 10, true);
+      SETUP_FOR_REQUEST(CompleteInstance, 10, true);
+      SETUP_FOR_REQUEST(GetStepSequence, 10, true);
+      SETUP_FOR_REQUEST(RunGraph, 100, true);
+      SETUP_FOR_REQUEST(CleanupGraph, 100, false);
+      SETUP_FOR_REQUEST(MarkRecvFinished, 10, false);
+    }
+
+    if (served_methods_ != ServedMethods::kControl) {
+      SETUP_FOR_REQUEST(RecvBuf, 500, true);
+      // TODO(ncteisen): Determine a better policy for enqueuing the
+      // appropriate number of each request type.
+      for (int i = 0; i < gtl::FindWithDefault(
+                              queue_depth_,
+                              static_cast<int>(GrpcWorkerMethod::kRecvTensor),
+                              1000);
+           ++i) {
+        EnqueueRecvTensorRequestRaw();
+      }
+      for (int i = 0;
+           i < gtl::FindWithDefault(
+                   queue_depth_,
+                   static_cast<int>(GrpcWorkerMethod::kBatchRecvTensor), 100);
+           ++i) {
+        EnqueueBatchRecvTensorRequestRaw();
+      }
+      for (int i = 0;
+           i < gtl::FindWithDefault(
+                   queue_depth_,
+                   static_cast<int>(GrpcWorkerMethod::kRecvTensorStripe), 100);
+           ++i) {
+        EnqueueRecvTensorStripeRequestRaw();
+      }
     }
 
     void* tag;
@@ -283,6 +316,40 @@ class GrpcWorkerServiceThread {
     EnqueueRecvTensorRequestRaw();
   }
 
+  void BatchRecvTensorHandlerRaw(
+      WorkerCall<BatchRecvTensorRequest, ::grpc::ByteBuffer>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+
+      worker_->GrpcBatchRecvTensorAsync(
+          call_opts, &call->request, &call->response,
+          [call, call_opts](const Status& s) {
+            call->ClearCancelCallback();
+            delete call_opts;
+            if (!s.ok()) {
+              VLOG(1) << "Bad response from BatchRecvTensor:" << s;
+            }
+            call->SendResponse(ToGrpcStatus(s));
+          });
+    });
+    EnqueueBatchRecvTensorRequestRaw();
+  }
+
+  void RecvTensorStripeHandlerRaw(
+      WorkerCall<RecvTensorStripeRequest, ::grpc::ByteBuffer>* call) {
+    // Stripes are encoded without copying their content and never wait, so
+    // they are served on this thread.
+    worker_->GrpcRecvTensorStripeAsync(
+        nullptr, &call->request, &call->response, [call](const Status& s) {
+          if (!s.ok()) {
+            VLOG(1) << "Bad response from RecvTensorStripe:" << s;
+          }
+          call->SendResponse(ToGrpcStatus(s));
+        });
+    EnqueueRecvTensorStripeRequestRaw();
+  }
+
   void RecvBufHandler(WorkerCall<RecvBufRequest, RecvBufResponse>* call) {
     Schedule([this, call]() {
       CallOptions* call_opts = new CallOptions;
@@ -352,7 +419,34 @@ class GrpcWorkerServiceThread {
     }
   }
 
+  void EnqueueBatchRecvTensorRequestRaw() {
+    mutex_lock l(shutdown_mu_);
+    if (!is_shutdown_) {
+      Call<GrpcWorkerServiceThread, grpc::WorkerService::AsyncService,
+           BatchRecvTensorRequest, ::grpc::ByteBuffer>::
+          EnqueueRequestForMethod(
+              worker_service_, cq_.get(),
+              static_cast<int>(GrpcWorkerMethod::kBatchRecvTensor),
+              &GrpcWorkerServiceThread::BatchRecvTensorHandlerRaw,
+              true /* supports cancel*/);
+    }
+  }
+
+  void EnqueueRecvTensorStripeRequestRaw() {
+    mutex_lock l(shutdown_mu_);
+    if (!is_shutdown_) {
+      Call<GrpcWorkerServiceThread, grpc::WorkerService::AsyncService,
+           RecvTensorStripeRequest, ::grpc::ByteBuffer>::
+          EnqueueRequestForMethod(
+              worker_service_, cq_.get(),
+              static_cast<int>(GrpcWorkerMethod::kRecvTensorStripe),
+              &GrpcWorkerServiceThread::RecvTensorStripeHandlerRaw,
+              false /* supports cancel*/);
+    }
+  }
+
   GrpcWorker* const worker_ = nullptr;  // Not owned.
+  const ServedMethods served_methods_;
   std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
   std::unique_ptr<Thread> thread_;
   std::unordered_map<int, int> queue_depth_;
@@ -371,10 +465,24 @@ class GrpcWorkerService : public AsyncServiceInterface {
       : is_shutdown_(false) {
     builder->RegisterService(&worker_service_);
 
+    int num_bulk_data_threads = std::max(options.num_bulk_data_threads, 0);
+    if (num_bulk_data_threads >= options.num_serving_threads) {
+      LOG(WARNING) << "Ignoring num_bulk_data_threads="
+                   << options.num_bulk_data_threads
+                   << " as it leaves no thread out of "
+                   << options.num_serving_threads
+                   << " to serve the other worker methods.";
+      num_bulk_data_threads = 0;
+    }
     for (int i = 0; i < options.num_serving_threads; i++) {
-      threads_.emplace_back(
-          new GrpcWorkerServiceThread(worker, builder, options.queue_depth,
-                                      cache_.get(), &worker_service_));
+      ServedMethods served_methods = ServedMethods::kAll;
+      if (num_bulk_data_threads > 0) {
+        served_methods = i < num_bulk_data_threads ? ServedMethods::kBulkData
+                                                   : ServedMethods::kControl;
+      }
+      threads_.emplace_back(new GrpcWorkerServiceThread(
+          worker, builder, options.queue_depth, cache_.get(), &worker_service_,
+          served_methods));
     }
   }
 
@@ -442,16 +550,47 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
                                      ::grpc::ByteBuffer* response,
                                      StatusCallback done) {
   VLOG(1) << "GrpcRecvTensorAsync req: " << request->DebugString();
+  const bool cache_enabled =
+      (response_cache_ != nullptr && request->request_id() != 0);
+  RecvTensorToByteBuffer(opts, request,
+                         cache_enabled ? response_cache_.get() : nullptr,
+                         /*require_ack=*/cache_enabled, response,
+                         std::move(done));
+}
+
+void GrpcWorker::RecvTensorToByteBuffer(CallOptions* opts,
+                                        const RecvTensorRequest* request,
+                                        GrpcResponseCache* cache,
+                                        bool require_ack,
+                                        ::grpc::ByteBuffer* response,
+                                        StatusCallback done) {
   const int64 request_id = request->request_id();
   const int64 step_id = request->step_id();
 
-  bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
-
-  auto do_response = [response, done, cache_enabled](const Tensor& tensor,
-                                                     bool is_dead,
-                                                     const Status& status) {
+  auto do_response = [this, request, response, done, require_ack](
+                         const Tensor& tensor, bool is_dead,
+                         const Status& status) {
     if (status.ok()) {
-      grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
+      const int num_stripes =
+          is_dead ? 1
+                  : MaybeStripeTensor(request->request_id(),
+                                      request->step_id(),
+                                      request->max_stripes(), tensor,
+                                      /*copy_tensor=*/false);
+      if (num_stripes > 1) {
+        // Only send the metadata, the client fetches the content.
+        // The client acks once it has all the stripes, releasing the tensor.
+        RecvTensorResponse proto;
+        proto.set_require_ack(true);
+        proto.set_send_start_micros(Env::Default()->NowMicros());
+        proto.mutable_tensor()->set_dtype(tensor.dtype());
+        tensor.shape().AsProto(proto.mutable_tensor()->mutable_tensor_shape());
+        proto.set_num_stripes(num_stripes);
+        grpc::EncodeRecvTensorResponseToByteBuffer(proto, response);
+      } else {
+        grpc::EncodeTensorToByteBuffer(is_dead, tensor, require_ack, *request,
+                                       response);
+      }
     }
     done(status);
   };
@@ -460,17 +599,17 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
   // request, we delegate this retry request to the response cache. Otherwise,
   // we add the request to the response cache and start the computation to
   // retrieve the requested data.
-  if (cache_enabled &&
-      response_cache_->QueueRequest(request_id, step_id, do_response)) {
+  if (cache != nullptr &&
+      cache->QueueRequest(request_id, step_id, do_response)) {
     return;
   }
 
-  auto rendezvous_done = [this, request_id, do_response, cache_enabled](
+  auto rendezvous_done = [cache, request_id, do_response](
                              const Tensor& tensor, bool is_dead,
                              const Status& status) {
-    if (cache_enabled) {
+    if (cache != nullptr) {
       // Data is ready. Process all pending requests in the response cache.
-      response_cache_->OnRequestFinished(request_id, tensor, is_dead, status);
+      cache->OnRequestFinished(request_id, tensor, is_dead, status);
     } else {
       do_response(tensor, is_dead, status);
     }
@@ -555,6 +694,166 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
       });
 }
 
+void GrpcWorker::GrpcBatchRecvTensorAsync(
+    CallOptions* opts, const BatchRecvTensorRequest* request,
+    ::grpc::ByteBuffer* response, StatusCallback done) {
+  const int num_requests = request->request_size();
+  VLOG(1) << "GrpcBatchRecvTensorAsync for " << num_requests << " tensors";
+  if (num_requests == 0) {
+    std::vector<::grpc::ByteBuffer> no_responses;
+    grpc::EncodeBatchRecvTensorResponseToByteBuffer(&no_responses, {},
+                                                    response);
+    done(Status::OK());
+    return;
+  }
+
+  // Each tensor is received independently, so that a pending tensor does not
+  // hold back the cancellation of the others.  The response is sent as soon
+  // as one of them is available, since one of the others may only be produced
+  // once the client has received it.  The tensors that are not available by
+  // then stay in batch_recv_cache_ until the client requests them again.
+  struct BatchState {
+    explicit BatchState(int n)
+        : responses(n), call_opts(n), available(n, false), pending(n + 1) {}
+    std::vector<::grpc::ByteBuffer> responses;
+    std::vector<CallOptions> call_opts;
+    mutex mu;
+    std::vector<bool> available GUARDED_BY(mu);
+    int num_available GUARDED_BY(mu) = 0;
+    Status status GUARDED_BY(mu);
+    // Whether every tensor has been requested, which holds back the response
+    // so that it includes all the tensors that are available at once.
+    bool issued GUARDED_BY(mu) = false;
+    bool responded GUARDED_BY(mu) = false;
+    // The tensors still to be received, plus one until `issued`.
+    int pending GUARDED_BY(mu);
+  };
+  auto* state = new BatchState(num_requests);
+  opts->SetCancelCallback([state]() {
+    for (CallOptions& call_opts : state->call_opts) {
+      call_opts.StartCancel();
+    }
+  });
+
+  // Records the completion of tensor `i`, or the end of the requests if `i` is
+  // negative, and sends the response if it is the time to.
+  auto finish = [this, opts, request, state, response, done](
+                    int i, const Status& s) {
+    std::vector<::grpc::ByteBuffer> responses;
+    std::vector<int32> deferred;
+    std::vector<int64> sent_request_ids;
+    Status status;
+    bool respond = false;
+    bool last;
+    {
+      mutex_lock l(state->mu);
+      if (i < 0) {
+        state->issued = true;
+      } else {
+        state->available[i] = true;
+        ++state->num_available;
+        state->status.Update(s);
+      }
+      last = --state->pending == 0;
+      if (state->issued && !state->responded && state->num_available > 0) {
+        state->responded = respond = true;
+        status = state->status;
+        if (status.ok()) {
+          responses.resize(state->responses.size());
+          for (int j = 0; j < responses.size(); ++j) {
+            if (state->available[j]) {
+              responses[j] = state->responses[j];
+              sent_request_ids.push_back(request->request(j).request_id());
+            } else {
+              deferred.push_back(j);
+            }
+          }
+        }
+      }
+    }
+    if (respond) {
+      opts->ClearCancelCallback();
+      if (status.ok()) {
+        // The tensors that are sent need no ack.
+        for (int64 request_id : sent_request_ids) {
+          batch_recv_cache_.EraseRequestId(request_id);
+        }
+        grpc::EncodeBatchRecvTensorResponseToByteBuffer(&responses, deferred,
+                                                        response);
+      }
+      done(status);
+    }
+    if (last) {
+      delete state;
+    }
+  };
+  for (int i = 0; i < num_requests; ++i) {
+    RecvTensorToByteBuffer(&state->call_opts[i], &request->request(i),
+                           &batch_recv_cache_, /*require_ack=*/false,
+                           &state->responses[i],
+                           [finish, i](const Status& s) { finish(i, s); });
+  }
+  finish(-1, Status::OK());
+}
+
+int GrpcWorker::MaybeStripeTensor(int64 request_id, int64 step_id,
+                                  int32 max_stripes, const Tensor& tensor,
+                                  bool copy_tensor) {
+  // Smaller stripes are not worth the extra round trip.
+  static constexpr int64 kMinStripeBytes = 1 << 20;
+  if (max_stripes <= 1 || request_id == 0 ||
+      !DataTypeCanUseMemcpy(tensor.dtype())) {
+    return 1;
+  }
+  const int64 total_bytes = tensor.TotalBytes();
+  const int num_stripes =
+      std::min<int64>(max_stripes, total_bytes / kMinStripeBytes);
+  // RecvTensorStripeResponses encode the stripe size as a varint32.
+  if (num_stripes <= 1 ||
+      total_bytes / num_stripes >= std::numeric_limits<int32>::max()) {
+    return 1;
+  }
+  mutex_lock l(striped_tensors_mu_);
+  // A retried request or a response cache replay reuses the held tensor.
+  auto it = striped_tensors_.find(request_id);
+  if (it != striped_tensors_.end()) {
+    return it->second.num_stripes;
+  }
+  striped_tensors_.emplace(
+      request_id,
+      StripedTensor{step_id, copy_tensor ? tensor::DeepCopy(tensor) : tensor,
+                    num_stripes});
+  return num_stripes;
+}
+
+void GrpcWorker::GrpcRecvTensorStripeAsync(
+    CallOptions* opts, const RecvTensorStripeRequest* request,
+    ::grpc::ByteBuffer* response, StatusCallback done) {
+  Tensor tensor;
+  int num_stripes = 0;
+  {
+    mutex_lock l(striped_tensors_mu_);
+    auto it = striped_tensors_.find(request->request_id());
+    if (it != striped_tensors_.end() && request->stripe() >= 0 &&
+        request->stripe() < it->second.num_stripes) {
+      tensor = it->second.tensor;
+      num_stripes = it->second.num_stripes;
+    }
+  }
+  if (num_stripes == 0) {
+    done(errors::NotFound("No stripe ", request->stripe(),
+                          " of a tensor for request ",
+                          request->request_id()));
+    return;
+  }
+  int64 offset;
+  int64 size;
+  grpc::GetTensorStripeBounds(tensor.TotalBytes(), num_stripes,
+                              request->stripe(), &offset, &size);
+  grpc::EncodeTensorStripeToByteBuffer(tensor, offset, size, response);
+  done(Status::OK());
+}
+
 namespace {
 // If RecvBufRespExtra.tensor_content is a single large string, then gRPC
 // can stall on the recv side when the string buffer needs to be enlarged,
@@ -589,14 +888,22 @@ void GrpcWorker::RecvBufAsync(CallOptions* opts, const RecvBufRequest* request,
   const int64 step_id = request->step_id();
   bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
 
-  auto do_response = [this, response, done, cache_enabled](
+  auto do_response = [this, request, response, done, cache_enabled](
                          const Tensor& tensor, bool is_dead,
                          const Status& status) {
     if (status.ok()) {
-      SetTensorInRecvBufResp(recv_buf_max_chunk_, &tensor, response);
+      // The producer may reuse the buffer once the response is generated.
+      const int num_stripes = MaybeStripeTensor(
+          request->request_id(), request->step_id(), request->max_stripes(),
+          tensor, /*copy_tensor=*/true);
+      if (num_stripes > 1) {
+        response->set_num_stripes(num_stripes);
+      } else {
+        SetTensorInRecvBufResp(recv_buf_max_chunk_, &tensor, response);
+      }
     }
     response->set_send_start_micros(env_->env->NowMicros());
-    response->set_require_ack(cache_enabled);
+    response->set_require_ack(cache_enabled || response->num_stripes() > 1);
     done(status);
   };
 
@@ -731,6 +1038,19 @@ void GrpcWorker::CleanupGraphAsync(const CleanupGraphRequest* request,
     // a worker crashes before acking a request.
     response_cache_->CleanEntriesForStep(request->step_id());
   }
+  // Likewise for deferred BatchRecvTensor responses.
+  batch_recv_cache_.CleanEntriesForStep(request->step_id());
+  {
+    // Likewise for striped tensors that were never acked.
+    mutex_lock l(striped_tensors_mu_);
+    for (auto it = striped_tensors_.begin(); it != striped_tensors_.end();) {
+      if (it->second.step_id == request->step_id()) {
+        it = striped_tensors_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
   Worker::CleanupGraphAsync(request, response, done);
 }
 
@@ -740,6 +1060,9 @@ void GrpcWorker::RemoveCacheEntryForId(int64 request_id) {
   if (response_cache_) {
     response_cache_->EraseRequestId(request_id);
   }
+  batch_recv_cache_.EraseRequestId(request_id);
+  mutex_lock l(striped_tensors_mu_);
+  striped_tensors_.erase(request_id);
 }
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* env,
@@ -22,6 +22,8 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_response_cache.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
 namespace grpc {
@@ -46,6 +48,22 @@ class GrpcWorker : public Worker {
                                    ::grpc::ByteBuffer* response,
                                    StatusCallback done);
 
+  // Receives every tensor of `request` as with GrpcRecvTensorAsync, and
+  // generates a BatchRecvTensorResponse into `response` once one of them is
+  // available, with every tensor available by then.  The others are deferred.
+  virtual void GrpcBatchRecvTensorAsync(CallOptions* opts,
+                                        const BatchRecvTensorRequest* request,
+                                        ::grpc::ByteBuffer* response,
+                                        StatusCallback done);
+
+  // Generates the requested stripe of a tensor whose RecvTensor or RecvBuf
+  // response was striped into `response`, in the format of a
+  // RecvTensorStripeResponse.
+  virtual void GrpcRecvTensorStripeAsync(CallOptions* opts,
+                                         const RecvTensorStripeRequest* request,
+                                         ::grpc::ByteBuffer* response,
+                                         StatusCallback done);
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override;
 
@@ -60,11 +78,44 @@ class GrpcWorker : public Worker {
 
   void EnableResponseCache();
 
+  // Releases the response cache entry and the striped tensor of
+  // `request_id`, once the client has received all of it.
   void RemoveCacheEntryForId(int64 request_id);
 
  private:
+  friend class GrpcWorkerTest;
+
+  // Receives the tensor of `request` into `response` as GrpcRecvTensorAsync
+  // does, through `cache` if it is not null, and asks the client to ack the
+  // response if `require_ack`.
+  void RecvTensorToByteBuffer(CallOptions* opts,
+                              const RecvTensorRequest* request,
+                              GrpcResponseCache* cache, bool require_ack,
+                              ::grpc::ByteBuffer* response,
+                              StatusCallback done);
+
+  // Returns the number of stripes to split `tensor` into for a request that
+  // allows up to `max_stripes`, and if that is more than one, holds on to
+  // `tensor`, or a copy of it if `copy_tensor`, until the client acks the
+  // request or the step is cleaned up.  Stripes may be requested any number
+  // of times until then, and a repeated request keeps the first tensor.
+  int MaybeStripeTensor(int64 request_id, int64 step_id, int32 max_stripes,
+                        const Tensor& tensor, bool copy_tensor);
+
   std::unique_ptr<GrpcResponseCache> response_cache_;
+  // The tensors of BatchRecvTensor requests, until they are sent, so that
+  // deferred ones can be requested again.
+  GrpcResponseCache batch_recv_cache_;
   const int32 recv_buf_max_chunk_;
+
+  struct StripedTensor {
+    int64 step_id;
+    Tensor tensor;
+    int num_stripes;
+  };
+  mutex striped_tensors_mu_;
+  std::unordered_map<int64, StripedTensor> striped_tensors_
+      GUARDED_BY(striped_tensors_mu_);
 };
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* worker_env,
@@ -74,7 +125,14 @@ struct GrpcWorkerServiceOptions {
   // Map from GrpcWorkerMethod id to queue depth.  If set this overrides the
   // default queue depth for a method.
   std::unordered_map<int, int> queue_depth;
+  // Number of threads polling an independent completion queue each.
   int num_serving_threads = 8;
+  // If positive, this many of the serving threads only handle the bulk data
+  // methods RecvTensor, BatchRecvTensor, RecvBuf and RecvTensorStripe, and
+  // the others handle all other methods, so that tensor traffic can't delay
+  // control RPCs such as RunGraph.
+  // Otherwise every thread handles every method.
+  int num_bulk_data_threads = 0;
 };
 
 // Returns an implementation of WorkerService rpc service.
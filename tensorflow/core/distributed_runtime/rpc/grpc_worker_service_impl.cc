@@ -60,6 +60,10 @@ const char* GrpcWorkerMethodName(GrpcWorkerMethod id) {
       return "/tensorflow.WorkerService/GetStepSequence";
     case GrpcWorkerMethod::kMarkRecvFinished:
       return "/tensorflow.WorkerService/MarkRecvFinished";
+    case GrpcWorkerMethod::kBatchRecvTensor:
+      return "/tensorflow.WorkerService/BatchRecvTensor";
+    case GrpcWorkerMethod::kRecvTensorStripe:
+      return "/tensorflow.WorkerService/RecvTensorStripe";
   }
   // Shouldn't be reached.
   LOG(FATAL) << "Invalid id: this line shouldn't be reached.";
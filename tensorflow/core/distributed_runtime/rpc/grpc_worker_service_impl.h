@@ -86,10 +86,12 @@ enum class GrpcWorkerMethod {
   kCompleteInstance,
   kGetStepSequence,
   kMarkRecvFinished,
+  kBatchRecvTensor,
+  kRecvTensorStripe,
 };
 
 static const int kGrpcNumWorkerMethods =
-    static_cast<int>(GrpcWorkerMethod::kMarkRecvFinished) + 1;
+    static_cast<int>(GrpcWorkerMethod::kRecvTensorStripe) + 1;
 
 const char* GrpcWorkerMethodName(GrpcWorkerMethod id);
 
@@ -0,0 +1,343 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
+
+#include <memory>
+#include <vector>
+
+#include "grpcpp/support/byte_buffer.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
+#include "tensorflow/core/distributed_runtime/worker_cache.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/distributed_runtime/worker_session.h"
+#include "tensorflow/core/framework/control_flow.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+
+class GrpcWorkerTest : public ::testing::Test {
+ protected:
+  GrpcWorkerTest() : rmgr_(&env_) {
+    env_.env = Env::Default();
+    env_.rendezvous_mgr = &rmgr_;
+    worker_.reset(new GrpcWorker(&env_, ConfigProto()));
+  }
+
+  // A 4MB tensor, which is large enough to be split into 4 stripes.
+  static Tensor MakeTensor(float start) {
+    Tensor tensor(DT_FLOAT, TensorShape({1 << 20}));
+    auto flat = tensor.flat<float>();
+    for (int i = 0; i < flat.size(); ++i) {
+      flat(i) = start + i;
+    }
+    return tensor;
+  }
+
+  int StripeTensor(int64 request_id, int64 step_id, int32 max_stripes,
+                   const Tensor& tensor, bool copy_tensor) {
+    return worker_->MaybeStripeTensor(request_id, step_id, max_stripes, tensor,
+                                      copy_tensor);
+  }
+
+  // Fetches stripe `stripe` of `num_stripes` of the tensor held for
+  // `request_id` into the matching bytes of `content`.
+  Status FetchStripe(int64 request_id, int num_stripes, int stripe,
+                     Tensor* content) {
+    RecvTensorStripeRequest request;
+    request.set_request_id(request_id);
+    request.set_stripe(stripe);
+    ::grpc::ByteBuffer buffer;
+    Status status;
+    worker_->GrpcRecvTensorStripeAsync(/*opts=*/nullptr, &request, &buffer,
+                                       [&status](const Status& s) {
+                                         status = s;
+                                       });
+    TF_RETURN_IF_ERROR(status);
+    int64 offset;
+    int64 size;
+    grpc::GetTensorStripeBounds(content->TotalBytes(), num_stripes, stripe,
+                                &offset, &size);
+    char* data = const_cast<char*>(content->tensor_data().data());
+    return grpc::DecodeTensorStripeFromByteBuffer(&buffer, data + offset,
+                                                  size);
+  }
+
+  WorkerEnv env_;
+  RpcRendezvousMgr rmgr_;
+  std::unique_ptr<GrpcWorker> worker_;
+};
+
+TEST_F(GrpcWorkerTest, SmallTensorsAreNotStriped) {
+  Tensor small(DT_FLOAT, TensorShape({1024}));
+  EXPECT_EQ(StripeTensor(1, 1, 4, small, false), 1);
+  EXPECT_EQ(StripeTensor(2, 1, 1, MakeTensor(0), false), 1);
+  // Request 0 can't be acked.
+  EXPECT_EQ(StripeTensor(0, 1, 4, MakeTensor(0), false), 1);
+  Tensor content(DT_FLOAT, TensorShape({1024}));
+  EXPECT_TRUE(errors::IsNotFound(FetchStripe(1, 1, 0, &content)));
+}
+
+TEST_F(GrpcWorkerTest, StripesCanBeFetchedRepeatedly) {
+  const Tensor expected = MakeTensor(0);
+  ASSERT_EQ(StripeTensor(1, 1, 4, expected, false), 4);
+
+  // A duplicate or retried stripe request is served again.
+  Tensor content(DT_FLOAT, expected.shape());
+  TF_ASSERT_OK(FetchStripe(1, 4, 2, &content));
+  TF_ASSERT_OK(FetchStripe(1, 4, 2, &content));
+  for (int stripe = 0; stripe < 4; ++stripe) {
+    TF_ASSERT_OK(FetchStripe(1, 4, stripe, &content));
+  }
+  test::ExpectTensorEqual<float>(content, expected);
+
+  // Until the client acks, all the stripes stay available.
+  Tensor again(DT_FLOAT, expected.shape());
+  for (int stripe = 0; stripe < 4; ++stripe) {
+    TF_ASSERT_OK(FetchStripe(1, 4, stripe, &again));
+  }
+  test::ExpectTensorEqual<float>(again, expected);
+
+  EXPECT_TRUE(errors::IsNotFound(FetchStripe(1, 4, 4, &content)));
+  EXPECT_TRUE(errors::IsNotFound(FetchStripe(1, 4, -1, &content)));
+}
+
+TEST_F(GrpcWorkerTest, RepeatedRequestKeepsStripedTensor) {
+  Tensor source = MakeTensor(0);
+  ASSERT_EQ(StripeTensor(1, 1, 4, source, true), 4);
+  // A copy is held, so the producer may reuse its buffer.
+  const Tensor original = MakeTensor(0);
+  source.flat<float>()(0) = -1;
+
+  // A retried request or a response cache replay, possibly with a
+  // different maximum, keeps the tensor and stripes of the first one.
+  EXPECT_EQ(StripeTensor(1, 1, 2, MakeTensor(7), true), 4);
+  Tensor content(DT_FLOAT, original.shape());
+  for (int stripe = 0; stripe < 4; ++stripe) {
+    TF_ASSERT_OK(FetchStripe(1, 4, stripe, &content));
+  }
+  test::ExpectTensorEqual<float>(content, original);
+}
+
+TEST_F(GrpcWorkerTest, AckReleasesStripedTensor) {
+  ASSERT_EQ(StripeTensor(1, 1, 4, MakeTensor(0), false), 4);
+  ASSERT_EQ(StripeTensor(2, 1, 4, MakeTensor(0), false), 4);
+  worker_->RemoveCacheEntryForId(1);
+
+  Tensor content(DT_FLOAT, TensorShape({1 << 20}));
+  EXPECT_TRUE(errors::IsNotFound(FetchStripe(1, 4, 0, &content)));
+  TF_EXPECT_OK(FetchStripe(2, 4, 0, &content));
+}
+
+TEST_F(GrpcWorkerTest, CleanupGraphReleasesStripedTensorsOfStep) {
+  ASSERT_EQ(StripeTensor(1, 1, 4, MakeTensor(0), false), 4);
+  ASSERT_EQ(StripeTensor(2, 2, 4, MakeTensor(0), false), 4);
+  CleanupGraphRequest request;
+  request.set_step_id(1);
+  CleanupGraphResponse response;
+  Status status = errors::Unknown("Not done");
+  worker_->CleanupGraphAsync(&request, &response,
+                             [&status](const Status& s) { status = s; });
+  TF_ASSERT_OK(status);
+
+  Tensor content(DT_FLOAT, TensorShape({1 << 20}));
+  EXPECT_TRUE(errors::IsNotFound(FetchStripe(1, 4, 0, &content)));
+  TF_EXPECT_OK(FetchStripe(2, 4, 0, &content));
+}
+
+namespace {
+
+// Fake cache implementation for WorkerSession.
+class DummyWorkerCache : public WorkerCacheInterface {
+  void ListWorkers(std::vector<string>* workers) const override {}
+  void ListWorkersInJob(const string& job_name,
+                        std::vector<string>* workers) const override {}
+  WorkerInterface* GetOrCreateWorker(const string& target) override {
+    return nullptr;
+  }
+  Status GetEagerClientCache(
+      std::unique_ptr<eager::EagerClientCache>* eager_client_cache) override {
+    return errors::Unimplemented("Unimplemented.");
+  }
+  bool GetDeviceLocalityNonBlocking(const string& device,
+                                    DeviceLocality* locality) override {
+    return false;
+  }
+  void GetDeviceLocalityAsync(const string& device, DeviceLocality* locality,
+                              StatusCallback done) override {}
+};
+
+constexpr char kWorkerName[] = "/job:worker/replica:0/task:0";
+
+class GrpcWorkerBatchRecvTest : public GrpcWorkerTest {
+ protected:
+  GrpcWorkerBatchRecvTest() {
+    std::vector<std::unique_ptr<Device>> devices;
+    devices.push_back(
+        DeviceFactory::NewDevice("CPU", SessionOptions(), kWorkerName));
+    device_ = devices[0].get();
+    device_mgr_.reset(new StaticDeviceMgr(std::move(devices)));
+    env_.device_mgr = device_mgr_.get();
+    worker_session_.reset(new WorkerSession(
+        "session", kWorkerName,
+        std::unique_ptr<WorkerCacheInterface>(new DummyWorkerCache),
+        std::unique_ptr<DeviceMgr>(), std::unique_ptr<GraphMgr>(), nullptr));
+  }
+
+  string Key(const string& name) {
+    return Rendezvous::CreateKey(device_->name(),
+                                 device_->attributes().incarnation(),
+                                 device_->name(), name, FrameAndIter(0, 0));
+  }
+
+  Status Send(RemoteRendezvous* rendez, const string& name, float value) {
+    Rendezvous::ParsedKey parsed;
+    TF_RETURN_IF_ERROR(Rendezvous::ParseKey(Key(name), &parsed));
+    return rendez->Send(parsed, Rendezvous::Args(),
+                        test::AsScalar<float>(value), /*is_dead=*/false);
+  }
+
+  static void AddRequest(BatchRecvTensorRequest* request, int64 step_id,
+                         int64 request_id, const string& key) {
+    RecvTensorRequest* req = request->add_request();
+    req->set_step_id(step_id);
+    req->set_rendezvous_key(key);
+    req->set_request_id(request_id);
+  }
+
+  // Starts a BatchRecvTensor RPC for `request`, which notifies `done` once it
+  // has parsed the response into `response`.
+  void StartBatchRecv(const BatchRecvTensorRequest* request,
+                      BatchRecvTensorResponse* response, Status* status,
+                      Notification* done) {
+    auto* buffer = new ::grpc::ByteBuffer;
+    worker_->GrpcBatchRecvTensorAsync(
+        &call_opts_, request, buffer,
+        [buffer, response, status, done](const Status& s) {
+          *status = s;
+          if (s.ok() && !GrpcMaybeParseProto(buffer, response)) {
+            *status = errors::Internal("Unparseable response");
+          }
+          delete buffer;
+          done->Notify();
+        });
+  }
+
+  static void ExpectTensor(const RecvTensorResponse& response, float value) {
+    Tensor tensor;
+    ASSERT_TRUE(tensor.FromProto(response.tensor()));
+    test::ExpectTensorEqual<float>(tensor, test::AsScalar<float>(value));
+    EXPECT_FALSE(response.require_ack());
+  }
+
+  Device* device_;  // Owned by device_mgr_.
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  std::unique_ptr<WorkerSession> worker_session_;
+  CallOptions call_opts_;
+};
+
+TEST_F(GrpcWorkerBatchRecvTest, DefersUnavailableTensors) {
+  const int64 step_id = 7;
+  RemoteRendezvous* rendez = rmgr_.Find(step_id);
+  core::ScopedUnref unref(rendez);
+  TF_ASSERT_OK(rendez->Initialize(worker_session_.get()));
+  TF_ASSERT_OK(Send(rendez, "x", 1));
+
+  // The response does not wait for y, which the receiver could be producing
+  // from x.
+  BatchRecvTensorRequest request;
+  AddRequest(&request, step_id, 1, Key("x"));
+  AddRequest(&request, step_id, 2, Key("y"));
+  BatchRecvTensorResponse response;
+  Status status;
+  Notification done;
+  StartBatchRecv(&request, &response, &status, &done);
+  done.WaitForNotification();
+  TF_ASSERT_OK(status);
+  ASSERT_EQ(response.response_size(), 2);
+  ExpectTensor(response.response(0), 1);
+  ASSERT_EQ(response.deferred_size(), 1);
+  EXPECT_EQ(response.deferred(0), 1);
+
+  // Requesting y again waits for it.
+  BatchRecvTensorRequest retry;
+  *retry.add_request() = request.request(1);
+  BatchRecvTensorResponse retry_response;
+  Notification retry_done;
+  StartBatchRecv(&retry, &retry_response, &status, &retry_done);
+  EXPECT_FALSE(retry_done.HasBeenNotified());
+  TF_ASSERT_OK(Send(rendez, "y", 2));
+  retry_done.WaitForNotification();
+  TF_ASSERT_OK(status);
+  ASSERT_EQ(retry_response.response_size(), 1);
+  ExpectTensor(retry_response.response(0), 2);
+  EXPECT_EQ(retry_response.deferred_size(), 0);
+  rmgr_.Cleanup(step_id);
+}
+
+TEST_F(GrpcWorkerBatchRecvTest, SendsAllAvailableTensors) {
+  const int64 step_id = 7;
+  RemoteRendezvous* rendez = rmgr_.Find(step_id);
+  core::ScopedUnref unref(rendez);
+  TF_ASSERT_OK(rendez->Initialize(worker_session_.get()));
+
+  BatchRecvTensorRequest request;
+  AddRequest(&request, step_id, 1, Key("x"));
+  AddRequest(&request, step_id, 2, Key("y"));
+  AddRequest(&request, step_id, 3, Key("z"));
+  BatchRecvTensorResponse response;
+  Status status;
+  Notification done;
+  StartBatchRecv(&request, &response, &status, &done);
+  EXPECT_FALSE(done.HasBeenNotified());
+  TF_ASSERT_OK(Send(rendez, "z", 3));
+  done.WaitForNotification();
+  TF_ASSERT_OK(status);
+  ASSERT_EQ(response.deferred_size(), 2);
+
+  // A deferred tensor that is available by the time it is requested again is
+  // sent with the others.
+  TF_ASSERT_OK(Send(rendez, "x", 1));
+  TF_ASSERT_OK(Send(rendez, "y", 2));
+  BatchRecvTensorRequest retry;
+  *retry.add_request() = request.request(0);
+  *retry.add_request() = request.request(1);
+  BatchRecvTensorResponse retry_response;
+  Notification retry_done;
+  StartBatchRecv(&retry, &retry_response, &status, &retry_done);
+  retry_done.WaitForNotification();
+  TF_ASSERT_OK(status);
+  ASSERT_EQ(retry_response.response_size(), 2);
+  EXPECT_EQ(retry_response.deferred_size(), 0);
+  ExpectTensor(retry_response.response(0), 1);
+  ExpectTensor(retry_response.response(1), 2);
+  rmgr_.Cleanup(step_id);
+}
+
+}  // namespace
+}  // namespace tensorflow
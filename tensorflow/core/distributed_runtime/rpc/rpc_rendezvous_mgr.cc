@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -23,8 +25,10 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/request_id.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -32,11 +36,47 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
 
+// Upper bound on the tensors fetched by one BatchRecvTensor RPC.
+constexpr int kMaxBatchRecvs = 64;
+
+// Returns true if receives from the same worker should be coalesced into
+// BatchRecvTensor RPCs. A batch completes once one of its tensors has been
+// produced, with all those produced by then, and the others are requested
+// again, so this trades the latency of some tensors for fewer round trips,
+// and is off by default.
+bool BatchRecvTensorEnabled() {
+  static const bool enabled = [] {
+    bool enabled;
+    Status s = ReadBoolFromEnvVar("TF_RPC_BATCH_RECV_TENSOR",
+                                  /*default_val=*/false, &enabled);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to read TF_RPC_BATCH_RECV_TENSOR: " << s;
+      enabled = false;
+    }
+    return enabled;
+  }();
+  return enabled;
+}
+
+// Workers that answered a BatchRecvTensor RPC with Unimplemented.
+mutex unbatched_workers_mu(LINKER_INITIALIZED);
+std::unordered_set<string>* UnbatchedWorkers()
+    EXCLUSIVE_LOCKS_REQUIRED(unbatched_workers_mu) {
+  static auto* workers = new std::unordered_set<string>;
+  return workers;
+}
+
+bool SupportsBatchRecvTensor(const string& worker) {
+  mutex_lock l(unbatched_workers_mu);
+  return UnbatchedWorkers()->count(worker) == 0;
+}
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
   RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id)
@@ -48,8 +88,39 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
                            DoneCallback done) override;
 
  private:
+  struct PendingRecv {
+    Rendezvous::ParsedKey parsed;
+    Rendezvous::Args args;
+    DoneCallback done;
+  };
+
   ~RpcRemoteRendezvous() override {}
 
+  // Fetches a single tensor with a RecvTensor RPC.
+  void RecvTensorFromRemote(const Rendezvous::ParsedKey& parsed,
+                            const Rendezvous::Args& args, DoneCallback done);
+
+  // Issues the receives queued for `src_worker` since the last flush.
+  void FlushPendingRecvs(const string& src_worker);
+
+  // Fetches the tensors of `recvs`, which share a cancellation manager, with
+  // BatchRecvTensor RPCs to `src_worker`.
+  void BatchRecvFromRemote(const string& src_worker,
+                           std::vector<PendingRecv> recvs);
+
+  // Issues a BatchRecvTensor RPC to `src_worker` for `keys`, under
+  // `request_ids`, and issues another one for the tensors it defers.
+  void StartBatchRecvCall(const string& src_worker,
+                          std::vector<Rendezvous::ParsedKey> keys,
+                          std::vector<Rendezvous::Args> recv_args,
+                          std::vector<DoneCallback> dones,
+                          std::vector<Device*> dst_devices,
+                          std::vector<int64> request_ids);
+
+  mutex pending_mu_;
+  std::unordered_map<string, std::vector<PendingRecv>> pending_recvs_
+      GUARDED_BY(pending_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
 
@@ -69,6 +140,9 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     req_.set_step_id(step_id);
     req_.set_rendezvous_key(key.data(), key.size());
     req_.set_request_id(GetUniqueRequestId());
+    for (TensorWireEncoding encoding : AcceptedTensorWireEncodings()) {
+      req_.add_accepted_wire_encodings(encoding);
+    }
   }
 
   void Reset() {
@@ -79,6 +153,8 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
 
     alloc_attrs_ = AllocatorAttributes();
     dst_device_ = nullptr;
+    stage_on_host_ = false;
+    device_tensor_ = Tensor();
     // We don't clear opts_ and assume that Init will set up the state for
     // opts_ appropriately.
     req_.Clear();
@@ -122,7 +198,9 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     wi_ = nullptr;
   }
 
-  const Tensor& tensor() const { return resp_.tensor(); }
+  const Tensor& tensor() const {
+    return stage_on_host_ ? device_tensor_ : resp_.tensor();
+  }
 
   bool is_dead() const { return resp_.metadata().is_dead(); }
 
@@ -135,22 +213,88 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
 
   // Start the main RecvTensor call, checking for an async abort.
   void StartRTCall(std::function<void()> recv_done) {
-    resp_.InitAlloc(dst_device_, alloc_attrs_);
+    // A tensor for VE memory is parsed straight from the wire into a host
+    // buffer and then DMAed, instead of being parsed into a TensorProto and
+    // copied twice more by MakeTensorFromProto. gpu_compatible makes the VE
+    // device hand out its hugepage host pool, which the VE DMAs from without
+    // going through its staging buffer. The send side stages VE tensors in
+    // the same pool, so neither side needs a pinned slab of its own.
+    stage_on_host_ =
+        dst_device_->device_type() == DEVICE_VE && !alloc_attrs_.on_host();
+    AllocatorAttributes attrs = alloc_attrs_;
+    if (stage_on_host_) {
+      attrs.set_on_host(true);
+      attrs.set_gpu_compatible(true);
+    }
+    resp_.InitAlloc(dst_device_, attrs);
     auto cb = [this, recv_done = std::move(recv_done)](const Status& s) {
       if (!s.ok()) {
         mutex_lock l(mu_);
         status_.Update(s);
+      } else if (stage_on_host_) {
+        CopyToDevice(recv_done);
+        return;
       }
       recv_done();
     };
     wi_->RecvTensorAsync(&opts_, &req_, &resp_, std::move(cb));
   }
 
+  // Copies the tensor parsed into host memory to `dst_device_`. The host
+  // tensor is owned by `resp_` and lives until the call is reset.
+  void CopyToDevice(std::function<void()> recv_done) {
+    const Tensor& host = resp_.tensor();
+    Status s;
+    if (is_dead()) {
+      device_tensor_ = host;
+    } else if (!DMAHelper::CanUseDMA(&host)) {
+      TensorProto proto;
+      host.AsProtoTensorContent(&proto);
+      s = dst_device_->MakeTensorFromProto(proto, alloc_attrs_,
+                                           &device_tensor_);
+    } else {
+      Tensor* copy = new Tensor(dst_device_->GetAllocator(alloc_attrs_),
+                                host.dtype(), host.shape());
+      if (!copy->IsInitialized()) {
+        s = errors::ResourceExhausted("OOM when allocating tensor of shape ",
+                                      host.shape().DebugString(), " and type ",
+                                      DataTypeString(host.dtype()));
+        delete copy;
+      } else if (host.TotalBytes() == 0) {
+        device_tensor_ = std::move(*copy);
+        delete copy;
+      } else {
+        DeviceContext* dev_ctx =
+            dst_device_->tensorflow_gpu_device_info()->default_context;
+        dev_ctx->CopyCPUTensorToDevice(
+            &host, dst_device_, copy,
+            [this, copy, recv_done](const Status& s) {
+              if (s.ok()) {
+                device_tensor_ = std::move(*copy);
+              } else {
+                mutex_lock l(mu_);
+                status_.Update(s);
+              }
+              delete copy;
+              recv_done();
+            });
+        return;
+      }
+    }
+    if (!s.ok()) {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    recv_done();
+  }
+
   string src_worker_;
   string src_rel_device_;
   WorkerInterface* wi_;  // Not owned.
   AllocatorAttributes alloc_attrs_;
   Device* dst_device_;
+  bool stage_on_host_ = false;
+  Tensor device_tensor_;  // Set when stage_on_host_ is true.
   CallOptions opts_;
   RecvTensorRequest req_;
   TensorResponse resp_;
@@ -203,6 +347,142 @@ class RpcRecvTensorFreeList {
   std::vector<RpcRecvTensorCall*> objects_ GUARDED_BY(mu_);
 };
 
+// Used to retrieve several tensors from one remote process in one round trip.
+class RpcBatchRecvTensorCall : public BaseRecvTensorCall {
+ public:
+  RpcBatchRecvTensorCall(WorkerInterface* wi, const string& src_worker,
+                         int64 step_id,
+                         std::vector<Rendezvous::ParsedKey> keys,
+                         std::vector<Rendezvous::Args> recv_args,
+                         std::vector<Rendezvous::DoneCallback> dones,
+                         std::vector<Device*> dst_devices,
+                         std::vector<int64> request_ids)
+      : wi_(wi),
+        src_worker_(src_worker),
+        keys_(std::move(keys)),
+        recv_args_(std::move(recv_args)),
+        dones_(std::move(dones)),
+        dst_devices_(std::move(dst_devices)),
+        request_ids_(std::move(request_ids)) {
+    for (int i = 0; i < keys_.size(); ++i) {
+      const Rendezvous::ParsedKey& key = keys_[i];
+      RecvTensorRequest* req = req_.add_request();
+      req->set_step_id(step_id);
+      req->set_rendezvous_key(key.FullKey().data(), key.FullKey().size());
+      req->set_request_id(request_ids_[i]);
+      for (TensorWireEncoding encoding : AcceptedTensorWireEncodings()) {
+        req->add_accepted_wire_encodings(encoding);
+      }
+    }
+  }
+
+  ~RpcBatchRecvTensorCall() override {
+    CHECK_EQ(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "Leaking WorkerInterface in RpcBatchRecvTensorCall destructor.";
+  }
+
+  void Start(std::function<void()> recv_done) override {
+    wi_->BatchRecvTensorAsync(&opts_, &req_, &resp_,
+                              [this, recv_done](const Status& s) {
+                                if (!s.ok()) {
+                                  mutex_lock l(mu_);
+                                  status_.Update(s);
+                                }
+                                recv_done();
+                              });
+  }
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  void ReleaseWorker(WorkerCacheInterface* worker_cache) {
+    DCHECK_NE(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "RpcBatchRecvTensorCall::ReleaseWorker() called twice.";
+    worker_cache->ReleaseWorker(src_worker_, wi_);
+    wi_ = nullptr;
+  }
+
+  const std::vector<Rendezvous::ParsedKey>& keys() const { return keys_; }
+  const std::vector<Rendezvous::Args>& recv_args() const { return recv_args_; }
+  std::vector<Rendezvous::DoneCallback>* dones() { return &dones_; }
+  const std::vector<Device*>& dst_devices() const { return dst_devices_; }
+  const std::vector<int64>& request_ids() const { return request_ids_; }
+
+  // Returns the indices of the tensors that the response deferred, or fails
+  // if the response is malformed.
+  Status GetDeferred(std::vector<bool>* deferred) const {
+    const int n = dones_.size();
+    if (resp_.response_size() != n) {
+      return errors::Internal("BatchRecvTensor returned ",
+                              resp_.response_size(), " tensors, expected ", n);
+    }
+    deferred->assign(n, false);
+    for (int32 i : resp_.deferred()) {
+      if (i < 0 || i >= n) {
+        return errors::Internal("BatchRecvTensor deferred tensor ", i,
+                                " of ", n);
+      }
+      (*deferred)[i] = true;
+    }
+    return Status::OK();
+  }
+
+  // Converts the received tensors and calls the done callbacks with them, or
+  // with `s` if it is not OK, except for the `deferred` ones, whose callbacks
+  // have been moved out.
+  void RunCallbacks(Status s, const std::vector<bool>& deferred) {
+    const int n = dones_.size();
+    std::vector<Tensor> tensors(n);
+    std::vector<bool> is_dead(n);
+    // Convert every tensor before calling any callback, since a callback may
+    // release the session that owns the devices.
+    for (int i = 0; s.ok() && i < n; ++i) {
+      if (deferred[i]) continue;
+      is_dead[i] = resp_.response(i).is_dead();
+      if (is_dead[i]) continue;
+      TensorResponse response;
+      response.InitAlloc(dst_devices_[i], recv_args_[i].alloc_attrs);
+      s = response.InitFrom(resp_.mutable_response(i));
+      tensors[i] = response.tensor();
+    }
+    for (int i = 0; i < n; ++i) {
+      if (deferred[i]) continue;
+      if (s.ok()) {
+        dones_[i](s, Rendezvous::Args(), recv_args_[i], tensors[i], is_dead[i]);
+      } else {
+        dones_[i](s, Rendezvous::Args(), recv_args_[i], Tensor(), false);
+      }
+    }
+  }
+
+ private:
+  WorkerInterface* wi_;  // Not owned.
+  const string src_worker_;
+  const std::vector<Rendezvous::ParsedKey> keys_;
+  const std::vector<Rendezvous::Args> recv_args_;
+  std::vector<Rendezvous::DoneCallback> dones_;
+  const std::vector<Device*> dst_devices_;
+  const std::vector<int64> request_ids_;
+  CallOptions opts_;
+  BatchRecvTensorRequest req_;
+  BatchRecvTensorResponse resp_;
+
+  mutable mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RpcBatchRecvTensorCall);
+};
+
 static RpcRecvTensorFreeList* get_call_freelist() {
   static RpcRecvTensorFreeList* call_freelist = new RpcRecvTensorFreeList();
   return call_freelist;
@@ -212,6 +492,213 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
     const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
     DoneCallback done) {
   CHECK(is_initialized());
+  string src_worker;
+  string src_rel_device;
+  if (!DeviceNameUtils::SplitDeviceName(parsed.src_device, &src_worker,
+                                        &src_rel_device)) {
+    // Reports the invalid device.
+    RecvTensorFromRemote(parsed, recv_args, std::move(done));
+    return;
+  }
+  TensorTransport* transport = env_->tensor_transport;
+  if (transport != nullptr && transport->CanReach(src_worker)) {
+    Device* dst_device;
+    Status s = session()->device_mgr()->LookupDevice(parsed.dst_device,
+                                                     &dst_device);
+    if (!s.ok()) {
+      done(s, Args(), recv_args, Tensor{}, false);
+      return;
+    }
+    transport->RecvTensorAsync(src_worker, step_id_, parsed, recv_args,
+                               dst_device, std::move(done));
+    return;
+  }
+  if (!BatchRecvTensorEnabled() || !SupportsBatchRecvTensor(src_worker)) {
+    RecvTensorFromRemote(parsed, recv_args, std::move(done));
+    return;
+  }
+
+  // The first receive from `src_worker` schedules a flush, and all receives
+  // from it that arrive before the flush runs share its RPCs. Receives are
+  // requested in bursts when an executor activates the recv nodes of a step,
+  // so this coalesces them without delaying isolated receives.
+  bool schedule_flush;
+  {
+    mutex_lock l(pending_mu_);
+    std::vector<PendingRecv>& pending = pending_recvs_[src_worker];
+    schedule_flush = pending.empty();
+    pending.push_back({parsed, recv_args, std::move(done)});
+  }
+  if (schedule_flush) {
+    Ref();
+    env_->compute_pool->Schedule([this, src_worker]() {
+      FlushPendingRecvs(src_worker);
+      Unref();
+    });
+  }
+}
+
+void RpcRemoteRendezvous::FlushPendingRecvs(const string& src_worker) {
+  std::vector<PendingRecv> pending;
+  {
+    mutex_lock l(pending_mu_);
+    auto it = pending_recvs_.find(src_worker);
+    pending.swap(it->second);
+    pending_recvs_.erase(it);
+  }
+
+  // Receives of a batch are aborted together, so only receives with the same
+  // cancellation manager can share an RPC.
+  std::vector<std::vector<PendingRecv>> batches;
+  std::unordered_map<CancellationManager*, int> open_batch;
+  for (PendingRecv& recv : pending) {
+    auto it = open_batch.find(recv.args.cancellation_manager);
+    if (it == open_batch.end() ||
+        batches[it->second].size() >= kMaxBatchRecvs) {
+      open_batch[recv.args.cancellation_manager] = batches.size();
+      batches.emplace_back();
+      it = open_batch.find(recv.args.cancellation_manager);
+    }
+    batches[it->second].push_back(std::move(recv));
+  }
+  for (std::vector<PendingRecv>& batch : batches) {
+    if (batch.size() == 1) {
+      RecvTensorFromRemote(batch[0].parsed, batch[0].args,
+                           std::move(batch[0].done));
+    } else {
+      BatchRecvFromRemote(src_worker, std::move(batch));
+    }
+  }
+}
+
+void RpcRemoteRendezvous::BatchRecvFromRemote(const string& src_worker,
+                                              std::vector<PendingRecv> recvs) {
+  WorkerSession* sess = session();
+  std::vector<Rendezvous::ParsedKey> keys;
+  std::vector<Rendezvous::Args> recv_args;
+  std::vector<DoneCallback> dones;
+  std::vector<Device*> dst_devices;
+  for (PendingRecv& recv : recvs) {
+    Device* dst_device;
+    if (!sess->device_mgr()
+             ->LookupDevice(recv.parsed.dst_device, &dst_device)
+             .ok()) {
+      // Reports the error through the unbatched path.
+      RecvTensorFromRemote(recv.parsed, recv.args, std::move(recv.done));
+      continue;
+    }
+    keys.push_back(recv.parsed);
+    recv_args.push_back(recv.args);
+    dones.push_back(std::move(recv.done));
+    dst_devices.push_back(dst_device);
+  }
+  if (keys.empty()) {
+    return;
+  }
+  std::vector<int64> request_ids;
+  for (int i = 0; i < keys.size(); ++i) {
+    request_ids.push_back(GetUniqueRequestId());
+  }
+  StartBatchRecvCall(src_worker, std::move(keys), std::move(recv_args),
+                     std::move(dones), std::move(dst_devices),
+                     std::move(request_ids));
+}
+
+void RpcRemoteRendezvous::StartBatchRecvCall(
+    const string& src_worker, std::vector<Rendezvous::ParsedKey> keys,
+    std::vector<Rendezvous::Args> recv_args, std::vector<DoneCallback> dones,
+    std::vector<Device*> dst_devices, std::vector<int64> request_ids) {
+  WorkerSession* sess = session();
+  WorkerInterface* rwi = sess->worker_cache()->GetOrCreateWorker(src_worker);
+  if (rwi == nullptr) {
+    Status s = errors::Internal("No worker known as ", src_worker);
+    for (int i = 0; i < dones.size(); ++i) {
+      dones[i](s, Args(), recv_args[i], Tensor{}, false);
+    }
+    return;
+  }
+
+  const Rendezvous::Args first_recv_args = recv_args[0];
+  auto* call = new RpcBatchRecvTensorCall(
+      rwi, src_worker, step_id_, std::move(keys), std::move(recv_args),
+      std::move(dones), std::move(dst_devices), std::move(request_ids));
+
+  // Record "call" in active_ so that it can be aborted cleanly.
+  RegisterCall(call, first_recv_args);
+
+  // RendezvousMgr already aborted, shouldn't send RPC call any more
+  if (!call->status().ok()) {
+    call->ReleaseWorker(sess->worker_cache());
+    call->RunCallbacks(call->status(),
+                       std::vector<bool>(call->keys().size(), false));
+    delete call;
+    return;
+  }
+
+  Ref();
+  call->Start([this, call, src_worker]() {
+    // Removes "call" from active_. Prevent StartAbort().
+    DeregisterCall(call);
+    Status s = call->status();
+    // NOTE: `*session()` can potentially be deleted before we return from
+    // the done callbacks, so we must release the worker before calling them.
+    call->ReleaseWorker(session()->worker_cache());
+    if (errors::IsUnimplemented(s)) {
+      // The remote worker predates BatchRecvTensor: stop batching receives
+      // from it, and fetch these tensors one by one.
+      VLOG(1) << "BatchRecvTensor is not supported by " << src_worker;
+      {
+        mutex_lock l(unbatched_workers_mu);
+        UnbatchedWorkers()->insert(src_worker);
+      }
+      for (int i = 0; i < call->keys().size(); ++i) {
+        RecvTensorFromRemote(call->keys()[i], call->recv_args()[i],
+                             std::move((*call->dones())[i]));
+      }
+      delete call;
+      Unref();
+      return;
+    }
+    std::vector<bool> deferred(call->keys().size(), false);
+    if (s.ok()) {
+      s = call->GetDeferred(&deferred);
+    }
+    if (s.ok()) {
+      // The sender holds on to the tensors it deferred until they are
+      // requested again under the same request ids.  This is done before
+      // the callbacks of the received tensors, which may end the step.
+      std::vector<Rendezvous::ParsedKey> keys;
+      std::vector<Rendezvous::Args> recv_args;
+      std::vector<DoneCallback> dones;
+      std::vector<Device*> dst_devices;
+      std::vector<int64> request_ids;
+      for (int i = 0; i < deferred.size(); ++i) {
+        if (!deferred[i]) continue;
+        keys.push_back(call->keys()[i]);
+        recv_args.push_back(call->recv_args()[i]);
+        dones.push_back(std::move((*call->dones())[i]));
+        dst_devices.push_back(call->dst_devices()[i]);
+        request_ids.push_back(call->request_ids()[i]);
+      }
+      if (!keys.empty()) {
+        VLOG(2) << "BatchRecvTensor deferred " << keys.size() << " of "
+                << deferred.size() << " tensors from " << src_worker;
+        StartBatchRecvCall(src_worker, std::move(keys), std::move(recv_args),
+                           std::move(dones), std::move(dst_devices),
+                           std::move(request_ids));
+      }
+    } else {
+      deferred.assign(deferred.size(), false);
+    }
+    call->RunCallbacks(s, deferred);
+    delete call;
+    Unref();
+  });
+}
+
+void RpcRemoteRendezvous::RecvTensorFromRemote(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
+    DoneCallback done) {
   Status s;
 
   // Prepare a RecvTensor call that can handle being aborted.
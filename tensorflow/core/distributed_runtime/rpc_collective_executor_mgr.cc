@@ -29,11 +29,13 @@ RpcCollectiveExecutorMgr::RpcCollectiveExecutorMgr(
     const ConfigProto& config, const DeviceMgr* dev_mgr,
     std::unique_ptr<DeviceResolverDistributed> dev_resolver,
     std::unique_ptr<CollectiveParamResolverDistributed> param_resolver,
-    WorkerCacheInterface* worker_cache, const string& task_name)
+    WorkerCacheInterface* worker_cache, const string& task_name,
+    TensorTransport* tensor_transport)
     : CollectiveExecutorMgr(config, dev_mgr, std::move(dev_resolver),
                             std::move(param_resolver)),
       worker_cache_(worker_cache),
-      task_name_(task_name) {
+      task_name_(task_name),
+      tensor_transport_(tensor_transport) {
   group_leader_ = (task_name == config.experimental().collective_group_leader())
                       ? ""
                       : config.experimental().collective_group_leader();
@@ -48,7 +50,8 @@ RpcCollectiveExecutorMgr::~RpcCollectiveExecutorMgr() {
 CollectiveExecutor* RpcCollectiveExecutorMgr::Create(int64 step_id) {
   CollectiveRemoteAccessDistributed* rma =
       new CollectiveRemoteAccessDistributed(
-          dev_mgr_, dev_resolver_.get(), work_queue_, worker_cache_, step_id);
+          dev_mgr_, dev_resolver_.get(), work_queue_, worker_cache_, step_id,
+          tensor_transport_);
   return new BaseCollectiveExecutor(this, rma, step_id, dev_mgr_,
                                     &gpu_ring_order_);
 }
@@ -23,6 +23,7 @@ class CollectiveParamResolverDistributed;
 class ConfigProto;
 class DeviceMgr;
 class DeviceResolverDistributed;
+class TensorTransport;
 class WorkerCacheInterface;
 class StepSequenceRequest;
 class StepSequenceResponse;
@@ -38,7 +39,8 @@ class RpcCollectiveExecutorMgr : public CollectiveExecutorMgr {
       const ConfigProto& config, const DeviceMgr* dev_mgr,
       std::unique_ptr<DeviceResolverDistributed> dev_resolver,
       std::unique_ptr<CollectiveParamResolverDistributed> param_resolver,
-      WorkerCacheInterface* worker_cache, const string& task_name);
+      WorkerCacheInterface* worker_cache, const string& task_name,
+      TensorTransport* tensor_transport = nullptr);
 
   virtual ~RpcCollectiveExecutorMgr();
 
@@ -60,6 +62,7 @@ class RpcCollectiveExecutorMgr : public CollectiveExecutorMgr {
 
   WorkerCacheInterface* const worker_cache_;  // Not owned.
   const string task_name_;
+  TensorTransport* const tensor_transport_;  // Not owned.
   string group_leader_;
   friend class RpcCollectiveExecutorMgrTest;
 
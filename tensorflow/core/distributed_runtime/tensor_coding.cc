@@ -17,9 +17,14 @@ limitations under the License.
 
 #include "google/protobuf/any.pb.h"
 
+#include "absl/strings/str_split.h"
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/bfloat16.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/snappy.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -51,15 +56,36 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
 }
 
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
-  Status s;
   meta_.Swap(response);
-  if (on_host_) {
-    if (!tensor_.FromProto(allocator_, meta_.tensor())) {
+  return MakeTensorFromMeta();
+}
+
+Status TensorResponse::MakeTensorFromMeta() {
+  Status s;
+  if (meta_.wire_encoding() != WIRE_ENCODING_RAW) {
+    // Decode on the host, then hand the result to the device.
+    Tensor wire;
+    Tensor decoded;
+    if (!wire.FromProto(cpu_allocator(), meta_.tensor())) {
+      s = errors::InvalidArgument("Cannot parse tensor from response");
+    } else if (on_host_) {
+      s = DecodeTensorFromWire(meta_, wire, allocator_, &tensor_);
+    } else {
+      s = DecodeTensorFromWire(meta_, wire, cpu_allocator(), &decoded);
+      if (s.ok()) {
+        TensorProto proto;
+        decoded.AsProtoTensorContent(&proto);
+        s = device_->MakeTensorFromProto(proto, alloc_attrs_, &tensor_);
+      }
+    }
+  } else if (on_host_) {
+    if (!tensor_.FromProto(allocator_, std::move(*meta_.mutable_tensor()))) {
       s = errors::InvalidArgument("Cannot parse tensor from response");
     }
   } else {
     s = device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
   }
+  // Reduce memory usage for big tensors.
   {
     TensorProto empty;
     meta_.mutable_tensor()->Swap(&empty);
@@ -81,6 +107,14 @@ void TensorResponse::InitPartial(const RecvTensorResponse& response,
 
 Status TensorResponse::ParseFrom(Source* source) {
   if (!on_host_) {
+    const DeviceBase::GpuDeviceInfo* gpu_info =
+        device_->tensorflow_gpu_device_info();
+    Status s;
+    if (gpu_info != nullptr && gpu_info->default_context != nullptr &&
+        ParseToDevice(source, gpu_info->default_context, &s)) {
+      return s;
+    }
+
     protobuf::io::CodedInputStream input(source->contents());
     input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
 
@@ -88,24 +122,65 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
-    Status s =
-        device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
-    // Reduce memory usage for big tensors.
-    {
-      TensorProto empty;
-      meta_.mutable_tensor()->Swap(&empty);
-    }
-    meta_.clear_tensor();
-    return s;
+    return MakeTensorFromMeta();
   }
   if (already_used_) {
     ClearTensor();
   }
   already_used_ = true;
-  if (ParseFast(source)) return Status::OK();
-  meta_.Clear();
-  if (ParseSlow(source)) return Status::OK();
-  return errors::InvalidArgument("Cannot parse tensor from response");
+  if (!ParseFast(source)) {
+    meta_.Clear();
+    if (!ParseSlow(source)) {
+      return errors::InvalidArgument("Cannot parse tensor from response");
+    }
+  }
+  if (meta_.wire_encoding() != WIRE_ENCODING_RAW) {
+    Tensor wire = std::move(tensor_);
+    return DecodeTensorFromWire(meta_, wire, allocator_, &tensor_);
+  }
+  return Status::OK();
+}
+
+bool TensorResponse::ParseToDevice(Source* source,
+                                   DeviceContext* device_context,
+                                   Status* status) {
+  ClearTensor();
+  Allocator* device_allocator = allocator_;
+  allocator_ = cpu_allocator();
+  const bool parsed = ParseFast(source);
+  allocator_ = device_allocator;
+  if (!parsed || !tensor_.IsInitialized() || tensor_.NumElements() == 0) {
+    ClearTensor();
+    return false;
+  }
+  Tensor host = std::move(tensor_);
+  if (meta_.wire_encoding() != WIRE_ENCODING_RAW) {
+    Tensor wire = std::move(host);
+    *status = DecodeTensorFromWire(meta_, wire, cpu_allocator(), &host);
+    if (!status->ok()) return true;
+  }
+  // Non-host destinations are always Devices (see rpc_rendezvous_mgr.cc).
+  Tensor copy(allocator_, host.dtype(), host.shape());
+  Notification n;
+  device_context->CopyCPUTensorToDevice(
+      &host, static_cast<Device*>(device_), &copy,
+      [&n, status](const Status& s) {
+        *status = s;
+        n.Notify();
+      });
+  n.WaitForNotification();
+  if (status->ok()) {
+    tensor_ = std::move(copy);
+  }
+  return true;
+}
+
+bool TensorResponse::CanShareSourceBytes() const {
+  // Host tensors that devices or NICs read directly must live in memory
+  // registered with them, which the source's bytes are not.  Tensors parsed
+  // for a device are only read by the copy to that device.
+  return !on_host_ ||
+         (!alloc_attrs_.gpu_compatible() && !alloc_attrs_.nic_compatible());
 }
 
 // Define some helper routines for decoding protocol buffer wire format data
@@ -115,6 +190,10 @@ enum WireType {
   WIRETYPE_VARINT = 0,
   WIRETYPE_LENGTH_DELIMITED = 2,
 };
+
+// Tensor content at least this big is shared with the source when possible.
+constexpr int kMinSharedContentBytes = 32 << 10;
+
 inline int GetTagFieldNumber(uint32 tag) { return tag >> 3; }
 inline WireType GetTagWireType(uint32 tag) {
   return static_cast<WireType>(tag & 0x7);
@@ -145,7 +224,8 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 }  // namespace
 
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    Source* source, protobuf::io::CodedInputStream* input,
+    TensorProto* tensor_meta) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -196,12 +276,29 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
+        if (num_bytes >= kMinSharedContentBytes && CanShareSourceBytes() &&
+            shape.num_elements() * DataTypeSize(tensor_meta->dtype()) ==
+                num_bytes) {
+          // Avoid copying big tensors whose content is contiguous and
+          // aligned in the source.
+          const void* data;
+          int size;
+          if (input->GetDirectBufferPointer(&data, &size) &&
+              size >= num_bytes &&
+              reinterpret_cast<uintptr_t>(data) % EIGEN_MAX_ALIGN_BYTES == 0) {
+            TensorBuffer* buf =
+                source->ShareBytes(static_cast<const char*>(data), num_bytes);
+            if (buf != nullptr) {
+              tensor_ = Tensor(tensor_meta->dtype(), shape, buf);
+              buf->Unref();
+              if (!input->Skip(num_bytes)) return false;
+              break;
+            }
+          }
+        }
         Tensor t(allocator_, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -235,7 +332,7 @@ bool TensorResponse::ParseFast(Source* source) {
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(source, &input, meta_.mutable_tensor())) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
@@ -267,6 +364,30 @@ bool TensorResponse::ParseFast(Source* source) {
         meta_.set_require_ack(v != 0);
         break;
       }
+      case RecvTensorResponse::kWireEncodingFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        meta_.set_wire_encoding(static_cast<TensorWireEncoding>(v));
+        break;
+      }
+      case RecvTensorResponse::kDecodedDtypeFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        meta_.set_decoded_dtype(static_cast<DataType>(v));
+        break;
+      }
+      case RecvTensorResponse::kNumStripesFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        meta_.set_num_stripes(static_cast<int32>(v));
+        break;
+      }
+      case RecvTensorResponse::kDecodedShapeFieldNumber: {
+        if ((wt != WIRETYPE_LENGTH_DELIMITED) ||
+            !ReadNestedMessage(&input, meta_.mutable_decoded_shape()))
+          return false;
+        break;
+      }
       default: {
         // Unknown tag, so don't handle we can't handle on the fast path
         return false;
@@ -283,7 +404,7 @@ bool TensorResponse::ParseSlow(Source* source) {
   }
 
   Tensor parsed(meta_.tensor().dtype());
-  if (!parsed.FromProto(allocator_, meta_.tensor())) {
+  if (!parsed.FromProto(allocator_, std::move(*meta_.mutable_tensor()))) {
     return false;
   }
   tensor_ = std::move(parsed);
@@ -298,4 +419,140 @@ bool TensorResponse::ParseSlow(Source* source) {
   return true;
 }
 
+namespace {
+
+// Tensors smaller than this are not worth compressing.
+constexpr int64 kMinSnappyBytes = 1024;
+
+bool IsSnappyEncodable(DataType dtype) {
+  switch (dtype) {
+    case DT_BOOL:
+    case DT_INT8:
+    case DT_INT16:
+    case DT_INT32:
+    case DT_INT64:
+    case DT_UINT8:
+    case DT_UINT16:
+    case DT_UINT32:
+    case DT_UINT64:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::vector<TensorWireEncoding> ReadAcceptedTensorWireEncodings() {
+  std::vector<TensorWireEncoding> encodings;
+  string names;
+  Status s = ReadStringFromEnvVar("TF_RPC_TENSOR_WIRE_ENCODINGS", "", &names);
+  if (!s.ok()) {
+    LOG(ERROR) << "Failed to read TF_RPC_TENSOR_WIRE_ENCODINGS: " << s;
+    return encodings;
+  }
+  for (absl::string_view name :
+       absl::StrSplit(names, ',', absl::SkipWhitespace())) {
+    if (name == "bfloat16") {
+      encodings.push_back(WIRE_ENCODING_BFLOAT16);
+    } else if (name == "snappy") {
+      encodings.push_back(WIRE_ENCODING_SNAPPY);
+    } else {
+      LOG(ERROR) << "Ignoring unknown tensor wire encoding " << name
+                 << " in TF_RPC_TENSOR_WIRE_ENCODINGS.";
+    }
+  }
+  return encodings;
+}
+
+}  // namespace
+
+const std::vector<TensorWireEncoding>& AcceptedTensorWireEncodings() {
+  static const auto* encodings =
+      new std::vector<TensorWireEncoding>(ReadAcceptedTensorWireEncodings());
+  return *encodings;
+}
+
+bool EncodeTensorForWire(const RecvTensorRequest& request, const Tensor& val,
+                         Tensor* encoded, RecvTensorResponse* response) {
+  for (int encoding : request.accepted_wire_encodings()) {
+    if (encoding == WIRE_ENCODING_BFLOAT16 && val.dtype() == DT_FLOAT &&
+        val.NumElements() > 0) {
+      Tensor t(DT_BFLOAT16, val.shape());
+      auto src = val.flat<float>();
+      auto dst = t.flat<bfloat16>();
+      for (int64 i = 0; i < src.size(); ++i) {
+        dst(i) = bfloat16::round_to_bfloat16(src(i));
+      }
+      *encoded = std::move(t);
+    } else if (encoding == WIRE_ENCODING_SNAPPY &&
+               IsSnappyEncodable(val.dtype()) &&
+               val.TotalBytes() >= kMinSnappyBytes) {
+      const StringPiece data = val.tensor_data();
+      string compressed;
+      // Only keep the compressed form if it saves at least an eighth.
+      if (!port::Snappy_Compress(data.data(), data.size(), &compressed) ||
+          compressed.size() > data.size() - data.size() / 8) {
+        continue;
+      }
+      Tensor t(DT_UINT8, TensorShape({static_cast<int64>(compressed.size())}));
+      memcpy(const_cast<char*>(t.tensor_data().data()), compressed.data(),
+             compressed.size());
+      *encoded = std::move(t);
+    } else {
+      continue;
+    }
+    response->set_wire_encoding(static_cast<TensorWireEncoding>(encoding));
+    response->set_decoded_dtype(val.dtype());
+    val.shape().AsProto(response->mutable_decoded_shape());
+    return true;
+  }
+  return false;
+}
+
+Status DecodeTensorFromWire(const RecvTensorResponse& response,
+                            const Tensor& wire, Allocator* allocator,
+                            Tensor* decoded) {
+  if (!TensorShape::IsValid(response.decoded_shape())) {
+    return errors::InvalidArgument("Invalid decoded shape in response");
+  }
+  const TensorShape shape(response.decoded_shape());
+  switch (response.wire_encoding()) {
+    case WIRE_ENCODING_BFLOAT16: {
+      if (response.decoded_dtype() != DT_FLOAT ||
+          wire.dtype() != DT_BFLOAT16 ||
+          wire.NumElements() != shape.num_elements()) {
+        return errors::InvalidArgument("Malformed bfloat16 encoded tensor");
+      }
+      Tensor t(allocator, DT_FLOAT, shape);
+      if (shape.num_elements() > 0) {
+        BFloat16ToFloat(wire.flat<bfloat16>().data(), t.flat<float>().data(),
+                        shape.num_elements());
+      }
+      *decoded = std::move(t);
+      return Status::OK();
+    }
+    case WIRE_ENCODING_SNAPPY: {
+      if (!IsSnappyEncodable(response.decoded_dtype()) ||
+          wire.dtype() != DT_UINT8) {
+        return errors::InvalidArgument("Malformed snappy encoded tensor");
+      }
+      Tensor t(allocator, response.decoded_dtype(), shape);
+      const StringPiece compressed = wire.tensor_data();
+      const StringPiece buf = t.tensor_data();
+      size_t length;
+      if (!port::Snappy_GetUncompressedLength(compressed.data(),
+                                              compressed.size(), &length) ||
+          length != buf.size() ||
+          !port::Snappy_Uncompress(compressed.data(), compressed.size(),
+                                   const_cast<char*>(buf.data()))) {
+        return errors::DataLoss("Failed to uncompress snappy encoded tensor");
+      }
+      *decoded = std::move(t);
+      return Status::OK();
+    }
+    default:
+      return errors::Unimplemented("Unsupported tensor wire encoding ",
+                                   response.wire_encoding());
+  }
+}
+
 }  // namespace tensorflow
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
 
+#include <vector>
+
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -27,6 +29,7 @@ namespace tensorflow {
 
 class Allocator;
 class DeviceBase;
+class DeviceContext;
 class TensorProto;
 
 // TensorResponse can be used as the destination of an RPC that returns
@@ -64,6 +67,15 @@ class TensorResponse {
     // Ownership of the returned stream is retained by the Source and
     // should not be deleted by the caller.
     virtual ::tensorflow::protobuf::io::ZeroCopyInputStream* contents() = 0;
+
+    // Return a buffer that aliases the "size" bytes at "data", which lie in
+    // the data yielded by the most recent contents() stream, and keeps them
+    // alive for as long as the buffer is referenced.  The caller owns one
+    // reference to the result.  Returns nullptr if the bytes cannot be
+    // shared, in which case ParseFrom copies them instead.
+    virtual TensorBuffer* ShareBytes(const char* data, size_t size) {
+      return nullptr;
+    }
   };
 
   // Parse the RecvTensorResponse encoded in the data yielded by
@@ -91,8 +103,26 @@ class TensorResponse {
   // Return pointer to the device hosting the tensor.
   DeviceBase* device() const { return device_; }
 
+  // Whether the tensor is parsed into host memory.
+  bool on_host() const { return on_host_; }
+
  private:
-  bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
+  // Sets tensor_ from meta_.tensor(), decoding it if needed.
+  Status MakeTensorFromMeta();
+
+  // Parses "source" into a host tensor and copies it to the device with
+  // "device_context", which lets the copy read straight out of the received
+  // bytes.  Returns false, with *this cleared, if "source" can't be parsed
+  // that way.
+  bool ParseToDevice(Source* source, DeviceContext* device_context,
+                     Status* status);
+
+  // Whether tensor content may alias the bytes of the source it is parsed
+  // from, rather than being copied into memory from allocator_.
+  bool CanShareSourceBytes() const;
+
+  bool ParseTensorSubmessage(Source* source,
+                             protobuf::io::CodedInputStream* input,
                              TensorProto* tensor_meta);
   bool ParseFast(Source* source);
   bool ParseSlow(Source* source);
@@ -106,6 +136,24 @@ class TensorResponse {
   RecvTensorResponse meta_;
 };
 
+// Returns the wire encodings that receivers of this process accept, set by
+// TF_RPC_TENSOR_WIRE_ENCODINGS as a comma separated list of "bfloat16" and
+// "snappy". "bfloat16" is lossy: it should only be enabled for jobs whose
+// float32 transfers, such as gradients, tolerate bfloat16 precision.
+const std::vector<TensorWireEncoding>& AcceptedTensorWireEncodings();
+
+// Encodes `val` into `*encoded` with an encoding that `request` accepts, and
+// records how to decode it in `*response`. Returns false, leaving both
+// untouched, if `val` should be sent raw.
+bool EncodeTensorForWire(const RecvTensorRequest& request, const Tensor& val,
+                         Tensor* encoded, RecvTensorResponse* response);
+
+// Decodes `wire`, the tensor sent with `response`, into a tensor allocated
+// by `allocator`.
+Status DecodeTensorFromWire(const RecvTensorResponse& response,
+                            const Tensor& wire, Allocator* allocator,
+                            Tensor* decoded);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
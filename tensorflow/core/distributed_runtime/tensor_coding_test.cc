@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -72,6 +73,43 @@ class StringSource : public TensorResponse::Source {
   int block_size_;
 };
 
+// A buffer that aliases memory owned by the test.
+class BorrowedTensorBuffer : public TensorBuffer {
+ public:
+  BorrowedTensorBuffer(const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)), size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const size_t size_;
+};
+
+// A source over one block of memory, which shares its bytes.
+class SharingArraySource : public TensorResponse::Source {
+ public:
+  SharingArraySource(const char* data, int size) : data_(data), size_(size) {}
+
+  protobuf::io::ZeroCopyInputStream* contents() override {
+    stream_.reset(new protobuf::io::ArrayInputStream(data_, size_));
+    return stream_.get();
+  }
+
+  TensorBuffer* ShareBytes(const char* data, size_t size) override {
+    return new BorrowedTensorBuffer(data, size);
+  }
+
+ private:
+  const char* data_;
+  int size_;
+  std::unique_ptr<protobuf::io::ArrayInputStream> stream_;
+};
+
 class TensorResponseTest : public ::testing::Test {
  public:
   void Validate(const Tensor& src, bool is_dead, bool use_tensor_content) {
@@ -156,6 +194,90 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(TensorResponseTest, WireEncodings) {
+  RecvTensorRequest request;
+  request.add_accepted_wire_encodings(WIRE_ENCODING_BFLOAT16);
+  request.add_accepted_wire_encodings(WIRE_ENCODING_SNAPPY);
+
+  // Small integers are exact in bfloat16, and repeated values compress well.
+  Tensor floats(DT_FLOAT, TensorShape({4, 500}));
+  floats.flat<float>().setConstant(3.0f);
+  Tensor ints(DT_INT32, TensorShape({2, 1000}));
+  ints.flat<int32>().setZero();
+  Tensor doubles(DT_DOUBLE, TensorShape({100}));
+  doubles.flat<double>().setZero();
+
+  for (const Tensor& src : {floats, ints, doubles}) {
+    RecvTensorResponse proto;
+    proto.set_send_start_micros(123456);
+    Tensor encoded;
+    const bool is_encoded =
+        EncodeTensorForWire(request, src, &encoded, &proto);
+    EXPECT_EQ(is_encoded, src.dtype() != DT_DOUBLE);
+    if (is_encoded) {
+      EXPECT_LT(encoded.TotalBytes(), src.TotalBytes());
+      encoded.AsProtoTensorContent(proto.mutable_tensor());
+    } else {
+      src.AsProtoTensorContent(proto.mutable_tensor());
+    }
+    string serialized;
+    proto.AppendToString(&serialized);
+
+    StringSource source(&serialized, 1024);
+    TensorResponse response;
+    DummyDevice cpu_device(Env::Default());
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    TF_EXPECT_OK(response.ParseFrom(&source));
+    EXPECT_EQ(response.metadata().send_start_micros(), 123456);
+    const Tensor& result = response.tensor();
+    switch (src.dtype()) {
+      case DT_FLOAT:
+        test::ExpectTensorEqual<float>(result, src);
+        break;
+      case DT_INT32:
+        test::ExpectTensorEqual<int32>(result, src);
+        break;
+      default:
+        test::ExpectTensorEqual<double>(result, src);
+    }
+  }
+}
+
+TEST_F(TensorResponseTest, SharesAlignedContent) {
+  Tensor src(DT_FLOAT, TensorShape({128, 128}));
+  test::FillIota<float>(&src, 0.0f);
+  RecvTensorResponse proto;
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string serialized;
+  proto.AppendToString(&serialized);
+  // The tensor content is the last field, so place the serialized response
+  // such that the content is aligned.
+  const size_t content_offset = serialized.size() - src.TotalBytes();
+  std::vector<char> storage(serialized.size() + EIGEN_MAX_ALIGN_BYTES);
+  const uintptr_t content_addr =
+      reinterpret_cast<uintptr_t>(storage.data()) + content_offset;
+  char* start = storage.data() + (EIGEN_MAX_ALIGN_BYTES -
+                                  content_addr % EIGEN_MAX_ALIGN_BYTES) %
+                                     EIGEN_MAX_ALIGN_BYTES;
+  memcpy(start, serialized.data(), serialized.size());
+
+  for (bool aligned : {true, false}) {
+    SharingArraySource source(start + (aligned ? 0 : 1), serialized.size());
+    if (!aligned) {
+      memmove(start + 1, start, serialized.size());
+    }
+    TensorResponse response;
+    DummyDevice cpu_device(Env::Default());
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    TF_EXPECT_OK(response.ParseFrom(&source));
+    const Tensor& result = response.tensor();
+    test::ExpectTensorEqual<float>(result, src);
+    EXPECT_EQ(result.tensor_data().data() ==
+                  start + (aligned ? 0 : 1) + content_offset,
+              aligned);
+  }
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
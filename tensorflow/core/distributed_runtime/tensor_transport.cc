@@ -0,0 +1,113 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/common_runtime/process_state.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#ifdef TENSORFLOW_USE_VE
+#include "tensorflow/core/common_runtime/ve/ve_device.h"
+#endif  // TENSORFLOW_USE_VE
+
+namespace tensorflow {
+
+namespace {
+mutex* get_transport_factory_lock() {
+  static mutex transport_factory_lock(LINKER_INITIALIZED);
+  return &transport_factory_lock;
+}
+
+typedef std::unordered_map<string, TensorTransportFactory*>
+    TensorTransportFactories;
+TensorTransportFactories* transport_factories() {
+  static TensorTransportFactories* factories = new TensorTransportFactories;
+  return factories;
+}
+}  // namespace
+
+/* static */
+void TensorTransportFactory::Register(const string& name,
+                                      TensorTransportFactory* factory) {
+  mutex_lock l(*get_transport_factory_lock());
+  if (!transport_factories()->insert({name, factory}).second) {
+    LOG(ERROR) << "Two tensor transport factories are being registered under "
+               << name;
+  }
+}
+
+/* static */
+Status TensorTransportFactory::GetFactory(
+    const string& name, TensorTransportFactory** out_factory) {
+  mutex_lock l(*get_transport_factory_lock());
+  auto it = transport_factories()->find(name);
+  if (it != transport_factories()->end()) {
+    *out_factory = it->second;
+    return Status::OK();
+  }
+
+  std::vector<string> transport_names;
+  for (const auto& transport_factory : *transport_factories()) {
+    transport_names.push_back(transport_factory.first);
+  }
+
+  return errors::NotFound("No tensor transport factory registered under \"",
+                          name, "\". The available tensor transports are: [ ",
+                          absl::StrJoin(transport_names, ", "), " ]");
+}
+
+Status NewTensorTransport(const string& name, const ServerDef& server_def,
+                          std::shared_ptr<TensorTransport>* out_transport) {
+  TensorTransportFactory* factory;
+  TF_RETURN_IF_ERROR(TensorTransportFactory::GetFactory(name, &factory));
+  std::unique_ptr<TensorTransport> transport;
+  TF_RETURN_IF_ERROR(factory->NewTensorTransport(server_def, &transport));
+  std::shared_ptr<TensorTransport> shared(std::move(transport));
+
+  SubAllocator::Visitor alloc_visitor = [shared](void* ptr, int index,
+                                                 size_t num_bytes) {
+    shared->RegisterMemoryRegion(ptr, index, num_bytes);
+  };
+  SubAllocator::Visitor free_visitor = [shared](void* ptr, int index,
+                                                size_t num_bytes) {
+    shared->DeregisterMemoryRegion(ptr, index, num_bytes);
+  };
+  ProcessState* process_state = ProcessState::singleton();
+  if (process_state->HasCPUAllocators()) {
+    LOG(WARNING) << "CPU tensors were allocated before the " << name
+                 << " tensor transport was created, so they will be copied "
+                    "through its own buffers.";
+  } else {
+    process_state->AddCPUAllocVisitor(alloc_visitor);
+    process_state->AddCPUFreeVisitor(free_visitor);
+  }
+#ifdef TENSORFLOW_USE_VE
+  if (!AddVEHostMemVisitors(alloc_visitor, free_visitor)) {
+    LOG(WARNING) << "Host tensors for VE were allocated before the " << name
+                 << " tensor transport was created, so they will be copied "
+                    "through its own buffers.";
+  }
+#endif  // TENSORFLOW_USE_VE
+
+  *out_transport = std::move(shared);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
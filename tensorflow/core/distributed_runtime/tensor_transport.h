@@ -0,0 +1,118 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_TRANSPORT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_TRANSPORT_H_
+
+#include <memory>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/tensorflow_server.pb.h"
+
+namespace tensorflow {
+
+class CancellationManager;
+class Device;
+class DeviceContext;
+class Tensor;
+struct WorkerEnv;
+
+// A TensorTransport moves tensor contents between workers over something
+// other than the worker service RPCs, e.g. one-sided RDMA writes into
+// registered memory.
+//
+// Which tensors move and when they are ready is still decided by the
+// producer's rendezvous and BufRendezvous: the receiving side asks the
+// transport instead of issuing RecvTensor or RecvBuf, and the transport
+// serves the sending side through the same WorkerEnv those RPCs use.
+// Peers the transport cannot reach keep using the RPCs.
+class TensorTransport {
+ public:
+  virtual ~TensorTransport() {}
+
+  // Called once "env" is fully set up and before the server starts
+  // serving, e.g. to connect to the peers of the cluster.
+  virtual Status Start(WorkerEnv* env) = 0;
+
+  // Returns true if and only if tensors can be received from the task
+  // named "task" (e.g. "/job:worker/replica:0/task:1") over this transport.
+  virtual bool CanReach(const string& task) = 0;
+
+  // Receives the tensor of "parsed" sent in step "step_id" by "src_task",
+  // allocated per "recv_args" on "dst_device". Like the RecvTensor RPC, the
+  // tensor may be on the host when "dst_device" is not. Aborted with
+  // "recv_args.cancellation_manager".
+  virtual void RecvTensorAsync(const string& src_task, int64 step_id,
+                               const Rendezvous::ParsedKey& parsed,
+                               const Rendezvous::Args& recv_args,
+                               Device* dst_device,
+                               Rendezvous::DoneCallback done) = 0;
+
+  // Receives the collective buffer "key" of "peer_device" on "peer_task"
+  // directly into "to_tensor", which was allocated with "to_alloc_attr" on
+  // "to_device". Aborted with "cancel_mgr".
+  virtual void RecvBufAsync(const string& peer_task, const string& peer_device,
+                            int64 step_id, const string& key,
+                            Device* to_device, DeviceContext* to_device_ctx,
+                            const AllocatorAttributes& to_alloc_attr,
+                            Tensor* to_tensor, CancellationManager* cancel_mgr,
+                            const StatusCallback& done) = 0;
+
+  // Called with each region of memory a registered allocator gets from (or
+  // returns to) the system, so that tensors allocated there can be written
+  // remotely without an intermediate copy. "index" is the numa node.
+  // Tensors outside registered regions must still be accepted, e.g. by
+  // going through a bounce buffer.
+  virtual void RegisterMemoryRegion(void* ptr, int index, size_t num_bytes) = 0;
+  virtual void DeregisterMemoryRegion(void* ptr, int index,
+                                      size_t num_bytes) = 0;
+};
+
+class TensorTransportFactory {
+ public:
+  virtual ~TensorTransportFactory() {}
+
+  // Creates a transport for the task of "server_def" and stores it in
+  // "*out_transport". Called before the devices of the task are created.
+  virtual Status NewTensorTransport(
+      const ServerDef& server_def,
+      std::unique_ptr<TensorTransport>* out_transport) = 0;
+
+  // For each `TensorTransportFactory` subclass, an instance of that class
+  // must be registered by calling this method.
+  //
+  // The `name` must be unique to the transport factory, and is what
+  // RPCOptions.tensor_transport refers to.
+  static void Register(const string& name, TensorTransportFactory* factory);
+
+  // Looks up the factory registered under `name`.
+  static Status GetFactory(const string& name,
+                           TensorTransportFactory** out_factory);
+};
+
+// Creates the transport registered under "name" for "server_def", and
+// registers the memory of the host allocators with it: the CPU allocators
+// and, in builds with VE support, the hugepage allocator of host tensors
+// VE DMAs. Regions allocated before this call are not registered. The
+// allocators share ownership of the transport, since they outlive servers.
+Status NewTensorTransport(const string& name, const ServerDef& server_def,
+                          std::shared_ptr<TensorTransport>* out_transport);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_TRANSPORT_H_
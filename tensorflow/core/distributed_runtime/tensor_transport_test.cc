@@ -0,0 +1,95 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
+
+#include "tensorflow/core/common_runtime/process_state.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class TestTensorTransport : public TensorTransport {
+ public:
+  Status Start(WorkerEnv* env) override { return Status::OK(); }
+
+  bool CanReach(const string& task) override { return false; }
+
+  void RecvTensorAsync(const string& src_task, int64 step_id,
+                       const Rendezvous::ParsedKey& parsed,
+                       const Rendezvous::Args& recv_args, Device* dst_device,
+                       Rendezvous::DoneCallback done) override {
+    done(errors::Unimplemented("RecvTensorAsync"), Rendezvous::Args(),
+         recv_args, Tensor(), false);
+  }
+
+  void RecvBufAsync(const string& peer_task, const string& peer_device,
+                    int64 step_id, const string& key, Device* to_device,
+                    DeviceContext* to_device_ctx,
+                    const AllocatorAttributes& to_alloc_attr,
+                    Tensor* to_tensor, CancellationManager* cancel_mgr,
+                    const StatusCallback& done) override {
+    done(errors::Unimplemented("RecvBufAsync"));
+  }
+
+  void RegisterMemoryRegion(void* ptr, int index, size_t num_bytes) override {
+    registered_bytes += num_bytes;
+  }
+
+  void DeregisterMemoryRegion(void* ptr, int index,
+                              size_t num_bytes) override {
+    registered_bytes -= num_bytes;
+  }
+
+  size_t registered_bytes = 0;
+};
+
+class TestTensorTransportFactory : public TensorTransportFactory {
+ public:
+  Status NewTensorTransport(
+      const ServerDef& server_def,
+      std::unique_ptr<TensorTransport>* out_transport) override {
+    out_transport->reset(new TestTensorTransport);
+    return Status::OK();
+  }
+};
+
+TEST(TensorTransportTest, RegistersCPUMemory) {
+  TensorTransportFactory::Register("test_transport",
+                                   new TestTensorTransportFactory());
+  ASSERT_FALSE(ProcessState::singleton()->HasCPUAllocators());
+  std::shared_ptr<TensorTransport> transport;
+  TF_ASSERT_OK(NewTensorTransport("test_transport", ServerDef(), &transport));
+  auto* test_transport = static_cast<TestTensorTransport*>(transport.get());
+
+  Allocator* allocator = ProcessState::singleton()->GetCPUAllocator(0);
+  void* ptr = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 1 << 20);
+  EXPECT_GE(test_transport->registered_bytes, 1 << 20);
+  allocator->DeallocateRaw(ptr);
+}
+
+TEST(TensorTransportTest, UnknownTransport) {
+  ServerDef server_def;
+  std::shared_ptr<TensorTransport> transport;
+  Status s = NewTensorTransport("fake_transport", server_def, &transport);
+  ASSERT_TRUE(errors::IsNotFound(s));
+  EXPECT_TRUE(absl::StrContains(s.error_message(),
+                                "The available tensor transports are: ["));
+}
+
+}  // namespace tensorflow
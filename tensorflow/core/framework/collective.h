@@ -186,6 +186,13 @@ class ParamResolverInterface {
                                      CompleteInstanceResponse* response,
                                      CancellationManager* cancel_mgr,
                                      const StatusCallback& done) = 0;
+
+  // Starts resolving the group of "cp" for "device" in the background, e.g.
+  // when a graph with collective ops is set up, so that the first
+  // CompleteParamsAsync of the ops need not wait for it. Only cp.name,
+  // cp.group and cp.instance.type are read.
+  virtual void PrefetchGroupAsync(const string& device,
+                                  const CollectiveParams& cp) {}
 };
 
 // Graphs which utilize Collective Ops in a common instance must
@@ -521,6 +521,20 @@ class Device;
 // Forward declare. Defined in common_runtime/device_mgr.h
 class DeviceMgr;
 
+// Hands out the buffers that the return values of a function call should be
+// computed into, e.g. the slices of a batch that the caller would otherwise
+// copy them to.
+class RetvalBufferProvider {
+ public:
+  virtual ~RetvalBufferProvider() {}
+
+  // Returns a buffer, with one reference owned by the caller, for return value
+  // `index`, or nullptr if it must be allocated as usual. May be called
+  // concurrently for different return values.
+  virtual TensorBuffer* AllocateRetval(int index, DataType type,
+                                       const TensorShape& shape) = 0;
+};
+
 class FunctionLibraryRuntime {
  public:
   virtual ~FunctionLibraryRuntime() {}
@@ -712,6 +726,11 @@ class FunctionLibraryRuntime {
     // If True, allow returning dead tensors.
     bool allow_dead_tensors = false;
 
+    // If set, the nodes that produce the return values allocate their outputs
+    // from it where possible. Only honored for functions that run on a single
+    // CPU device. Not owned, and must outlive the call.
+    RetvalBufferProvider* retval_buffer_provider = nullptr;
+
     // Returns a human readable representation of this.
     string DebugString() const;
   };
@@ -62,10 +62,21 @@ class LocalRendezvous {
 
   typedef gtl::FlatMap<uint64, ItemQueue> Table;
 
-  // TODO(zhifengc): shard table_.
-  mutex mu_;
-  Table table_ GUARDED_BY(mu_);
-  Status status_ GUARDED_BY(mu_);
+  // The table is sharded by key hash so that Send and Recv on different keys
+  // rarely contend for the same lock. Each shard records the abort status
+  // too, so that checking it takes no other lock.
+  static const int kNumShards = 16;
+  struct TableShard {
+    mutex mu;
+    Table table GUARDED_BY(mu);
+    Status status GUARDED_BY(mu);
+  };
+
+  TableShard* ShardFor(uint64 key_hash) {
+    return &shards_[key_hash % kNumShards];
+  }
+
+  TableShard shards_[kNumShards];
 
   TF_DISALLOW_COPY_AND_ASSIGN(LocalRendezvous);
 };
@@ -634,6 +634,19 @@ std::shared_ptr<Parameter> MakeParameter(const string& name,
   return std::make_shared<Parameter>(name, state, min, max);
 }
 
+string SlowestNode(const std::map<string, NodeStats>& stats) {
+  string slowest;
+  double slowest_processing_time = -1;
+  for (const auto& pair : stats) {
+    if (pair.second.num_elements > 0 &&
+        pair.second.processing_time > slowest_processing_time) {
+      slowest = pair.first;
+      slowest_processing_time = pair.second.processing_time;
+    }
+  }
+  return slowest;
+}
+
 std::shared_ptr<Node> MakeInterleaveManyNode(Node::Args args) {
   return std::make_shared<InterleaveMany>(std::move(args));
 }
@@ -777,6 +790,33 @@ void Model::RemoveNode(const string& name) {
   lookup_table_.erase(name);
 }
 
+std::map<std::pair<string, string>, double> Model::TunableParameterValues() {
+  std::map<std::pair<string, string>, std::shared_ptr<Parameter>> parameters;
+  {
+    tf_shared_lock l(mu_);
+    if (output_) {
+      output_->CollectTunableParametersByNode(&parameters);
+    }
+  }
+  // The parameter state is read without holding any node lock because input
+  // pipeline threads acquire node locks while holding the state mutex.
+  std::map<std::pair<string, string>, double> values;
+  for (auto& pair : parameters) {
+    tf_shared_lock l(*pair.second->state->mu);
+    values[pair.first] = pair.second->state->value;
+  }
+  return values;
+}
+
+std::map<string, NodeStats> Model::CollectNodeStats() {
+  std::map<string, NodeStats> stats;
+  tf_shared_lock l(mu_);
+  if (output_) {
+    output_->CollectStats(&stats);
+  }
+  return stats;
+}
+
 std::map<string, std::shared_ptr<Parameter>> Model::CollectTunableParameters(
     std::shared_ptr<Node> node) {
   std::map<string, std::shared_ptr<Parameter>> parameters;
@@ -93,6 +93,24 @@ std::shared_ptr<Parameter> MakeParameter(const string& name,
                                          std::shared_ptr<SharedState> state,
                                          double min, double max);
 
+// Summarizes the work done by an input pipeline node.
+struct NodeStats {
+  // Processing time spent in the node per element it produced, in nanoseconds.
+  double processing_time = 0;
+
+  // Number of elements the node has produced.
+  int64 num_elements = 0;
+
+  // Number of elements and bytes currently stored in the node's buffer.
+  int64 buffered_elements = 0;
+  int64 buffered_bytes = 0;
+};
+
+// Returns the long name of the node that spends the most processing time per
+// element among the nodes that produced elements, or an empty string if there
+// is no such node.
+string SlowestNode(const std::map<string, NodeStats>& stats);
+
 // Abstract representation of a TensorFlow input pipeline node. It collects
 // information about inputs to this node, processing time spent executing the
 // node logic, number of elements produced by the node, various other
@@ -261,6 +279,41 @@ class Node {
     }
   }
 
+  // Collects the tunable parameters of the subtree rooted in this node, keyed
+  // by the long name of the node and the name of the parameter.
+  void CollectTunableParametersByNode(
+      std::map<std::pair<string, string>, std::shared_ptr<Parameter>>*
+          parameters) const LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    if (!autotune_) {
+      return;
+    }
+    for (auto& pair : parameters_) {
+      if (pair.second->state->tunable) {
+        parameters->insert(std::make_pair(
+            std::make_pair(long_name(), pair.first), pair.second));
+      }
+    }
+    for (auto& input : inputs_) {
+      input->CollectTunableParametersByNode(parameters);
+    }
+  }
+
+  // Collects a summary of the work done by each node of the subtree rooted in
+  // this node, keyed by the long name of the node.
+  void CollectStats(std::map<string, NodeStats>* stats) const
+      LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    NodeStats& node_stats = (*stats)[long_name()];
+    node_stats.processing_time = SelfProcessingTimeLocked();
+    node_stats.num_elements = num_elements_;
+    node_stats.buffered_elements = buffered_elements_;
+    node_stats.buffered_bytes = buffered_bytes_;
+    for (auto& input : inputs_) {
+      input->CollectStats(stats);
+    }
+  }
+
   // Returns a human-readable representation of this node.
   string DebugString() const LOCKS_EXCLUDED(mu_) {
     tf_shared_lock l(mu_);
@@ -605,6 +658,15 @@ class Model {
   // Removes the given node.
   void RemoveNode(const string& name) LOCKS_EXCLUDED(mu_);
 
+  // Returns the value currently in use for each tunable parameter of the
+  // model, keyed by the long name of its node and the name of the parameter.
+  std::map<std::pair<string, string>, double> TunableParameterValues()
+      LOCKS_EXCLUDED(mu_);
+
+  // Returns a summary of the work done by each node of the model, keyed by the
+  // long name of the node.
+  std::map<string, NodeStats> CollectNodeStats() LOCKS_EXCLUDED(mu_);
+
  private:
   // Collects tunable parameters in the tree rooted in the given node, returning
   // a mapping from a (unique) node name to a tunable parameter.
@@ -727,6 +727,72 @@ TEST(UnknownGradientTest, Model) {
               (new_output_time - output_time) / kParameterStep,
               kComparisonPrecision);
 }
+
+TEST(TunableParameterValuesTest, Model) {
+  Model model(/*remove_node_hook=*/[](std::shared_ptr<Node>) {});
+  auto mu = std::make_shared<mutex>();
+  auto cond_var = std::make_shared<condition_variable>();
+  auto buffer_size = std::make_shared<SharedState>(kAutotune, mu, cond_var);
+  auto parallelism = std::make_shared<SharedState>(kAutotune, mu, cond_var);
+  auto fixed = std::make_shared<SharedState>(2, mu, cond_var);
+  model.AddNode(
+      [&buffer_size](Node::Args args) {
+        return MakeAsyncKnownRatioNode(
+            std::move(args), /*ratio=*/1,
+            {MakeParameter(kBufferSize, buffer_size, 0, 8)});
+      },
+      "Prefetch", "");
+  model.AddNode(
+      [&parallelism, &fixed](Node::Args args) {
+        return MakeAsyncInterleaveManyNode(
+            std::move(args), {MakeParameter(kParallelism, parallelism, 1, 4),
+                              MakeParameter("fixed", fixed, 1, 4)});
+      },
+      "Prefetch::ParallelInterleave", "Prefetch");
+  buffer_size->value = 5;
+  parallelism->value = 3;
+
+  auto values = model.TunableParameterValues();
+  EXPECT_EQ(values.size(), 2);
+  EXPECT_EQ(values[std::make_pair("Prefetch(id:1)", kBufferSize)], 5);
+  EXPECT_EQ(values[std::make_pair("ParallelInterleave(id:2)", kParallelism)],
+            3);
+}
+
+TEST(NodeStatsTest, Model) {
+  Model model(/*remove_node_hook=*/[](std::shared_ptr<Node>) {});
+  std::shared_ptr<Node> prefetch = model.AddNode(
+      [](Node::Args args) {
+        return MakeAsyncKnownRatioNode(std::move(args), /*ratio=*/1, {});
+      },
+      "Prefetch", "");
+  std::shared_ptr<Node> map = model.AddNode(
+      [](Node::Args args) {
+        return MakeKnownRatioNode(std::move(args), /*ratio=*/1);
+      },
+      "Prefetch::Map", "Prefetch");
+  model.AddNode(
+      [](Node::Args args) { return MakeSourceNode(std::move(args)); },
+      "Prefetch::Map::Range", "Prefetch::Map");
+  prefetch->record_element();
+  prefetch->record_element();
+  prefetch->add_processing_time(20);
+  prefetch->record_buffer_event(/*bytes_delta=*/16, /*elements_delta=*/2);
+  map->record_element();
+  map->add_processing_time(50);
+
+  auto stats = model.CollectNodeStats();
+  EXPECT_EQ(stats.size(), 3);
+  EXPECT_EQ(stats["Prefetch(id:1)"].processing_time, 10);
+  EXPECT_EQ(stats["Prefetch(id:1)"].num_elements, 2);
+  EXPECT_EQ(stats["Prefetch(id:1)"].buffered_elements, 2);
+  EXPECT_EQ(stats["Prefetch(id:1)"].buffered_bytes, 16);
+  EXPECT_EQ(stats["Map(id:2)"].processing_time, 50);
+  EXPECT_EQ(stats["Range(id:3)"].num_elements, 0);
+  EXPECT_EQ(SlowestNode(stats), "Map(id:2)");
+  EXPECT_EQ(SlowestNode({}), "");
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace data
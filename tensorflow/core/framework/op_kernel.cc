@@ -49,6 +49,7 @@ limitations under the License.
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/platform_strings.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/scoped_memory_debug_annotation.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
@@ -120,10 +121,11 @@ OpKernel::OpKernel(OpKernelConstruction* context,
   OP_REQUIRES_OK(context, CheckOpDeprecation(*context->op_def_,
                                              context->graph_def_version()));
 
-  // Kernels executing on GPU/SYCL tie very few resources on the CPU where the
-  // scheduler runs: we consider them as inexpensive.
+  // Kernels executing on GPU/SYCL/VE tie very few resources on the CPU where
+  // the scheduler runs: we consider them as inexpensive.
   expensive_ = context->device_type() != DeviceType(DEVICE_GPU) &&
-               context->device_type() != DeviceType(DEVICE_SYCL);
+               context->device_type() != DeviceType(DEVICE_SYCL) &&
+               context->device_type() != DeviceType(DEVICE_VE);
 }
 
 OpKernel::~OpKernel() {}
@@ -747,6 +749,8 @@ Status OpKernelContext::allocate_tensor(
   Allocator* a = get_allocator(attr);
   MEMDEBUG_CACHE_OP(op_kernel().name().c_str());
   MEMDEBUG_CACHE_STEPID(step_id());
+  profiler::ScopedMemoryDebugAnnotation op_annotation(
+      op_kernel().name().c_str(), step_id());
   Tensor new_tensor(a, type, shape,
                     AllocationAttributes(allocation_attr.no_retry_on_failure,
                                          /* allocation_will_be_logged= */ true,
@@ -801,6 +805,18 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
           " more than once.  Try turning off the ScopedAllocator optimizer.");
     }
   }
+  if (params_->static_output_provider != nullptr && attr.value == 0 &&
+      attr.scope_id == 0 && !track_allocations() && !params_->log_memory) {
+    TensorBuffer* buf = params_->static_output_provider->AllocateOutput(
+        params_->static_output_node_id, index, type, shape);
+    if (buf != nullptr) {
+      outputs_[index] = TensorValue(new Tensor(type, shape, buf));
+      buf->Unref();
+      record_tensor_reference(*outputs_[index].tensor);
+      *output = outputs_[index].tensor;
+      return Status::OK();
+    }
+  }
   auto output_tensor = MakeUnique<Tensor>();
   Status s = allocate_tensor(type, shape, output_tensor.get(), attr);
   if (s.ok()) {
@@ -630,6 +630,19 @@ struct GraphCollector {
   }
 };
 
+// Hands out output buffers that an executor assigned ahead of time, e.g. from
+// a static memory plan of a graph with known shapes.
+class StaticOutputProvider {
+ public:
+  virtual ~StaticOutputProvider() {}
+
+  // Returns a buffer, with one reference owned by the caller, for output
+  // `index` of node `node_id`, or nullptr if the output must be allocated by
+  // the device allocator.
+  virtual TensorBuffer* AllocateOutput(int node_id, int index, DataType type,
+                                       const TensorShape& shape) = 0;
+};
+
 class OpKernelContext {
  public:
   // The first element of a WrappedAllocator is a "base" Allocator and
@@ -750,6 +763,11 @@ class OpKernelContext {
     // Values in [0,...) represent reservations for the indexed output.
     const int* forward_from_array = nullptr;
 
+    // Preassigned output buffers, and the id of this node as known to the
+    // provider. Outputs not served by the provider use the device allocator.
+    StaticOutputProvider* static_output_provider = nullptr;
+    int static_output_node_id = -1;
+
     // For tracking actively running deferred ops.
     std::function<void()> inc_num_deferred_ops_function;
     std::function<void()> dec_num_deferred_ops_function;
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -512,5 +513,39 @@ void BM_PingPong(int iters) {
 }
 BENCHMARK(BM_PingPong);
 
+// Each of `num_threads` threads sends and receives on its own keys, as the
+// partitions of a step do on their cross-device edges.
+void BM_SendRecvManyKeys(int iters, int num_threads) {
+  const int kNumKeysPerThread = 64;
+  Rendezvous* rendez = NewLocalRendezvous();
+  std::vector<std::vector<Rendezvous::ParsedKey>> keys(num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    for (int k = 0; k < kNumKeysPerThread; ++k) {
+      keys[t].push_back(MakeKey(strings::StrCat("edge_", t, "_", k)));
+    }
+  }
+  thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "test", num_threads);
+  BlockingCounter counter(num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    pool->Schedule([rendez, iters, &keys, &counter, t]() {
+      Tensor orig = V("val");
+      Tensor val(DT_STRING, TensorShape({}));
+      bool is_dead = false;
+      Rendezvous::Args args;
+      for (int i = 0; i < iters; ++i) {
+        const Rendezvous::ParsedKey& key = keys[t][i % kNumKeysPerThread];
+        TF_CHECK_OK(rendez->Send(key, args, orig, is_dead));
+        TF_CHECK_OK(rendez->Recv(key, args, &val, &is_dead));
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  delete pool;
+  rendez->Unref();
+}
+BENCHMARK(BM_SendRecvManyKeys)->Arg(1)->Arg(4)->Arg(16);
+
 }  // namespace
 }  // namespace tensorflow
@@ -24,6 +24,7 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/run_handler_util.h"
 #include "tensorflow/core/lib/core/threadpool_interface.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/denormal.h"
@@ -38,6 +39,12 @@ namespace tensorflow {
 namespace {
 static constexpr int32 kMaxConcurrentHandlers = 128;
 
+auto* inter_op_queue_time_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/run_handler/inter_op_queue_time_usecs",
+     "Time an inter-op closure waits in a RunHandler queue, in microseconds.",
+     "priority"},
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
 // TODO(azaks): Refactor with thread:ThreadPool
 class RunHandlerEnvironment {
   typedef Thread EnvThread;
@@ -154,13 +161,21 @@ class ThreadWorkSource {
             static_cast<int32>(ParamFromEnvWithDefault(
                 "TF_RUN_HANDLER_NUM_OF_NON_BLOCKING_QUEUES", 1))),
         non_blocking_work_queues_(non_blocking_work_sharding_factor_),
+        blocking_work_sharding_factor_(
+            static_cast<int32>(ParamFromEnvWithDefault(
+                "TF_RUN_HANDLER_NUM_OF_BLOCKING_QUEUES", 1))),
+        blocking_work_queues_(blocking_work_sharding_factor_),
         blocking_inflight_(0),
         non_blocking_inflight_(0),
-        traceme_id_(0) {
+        traceme_id_(0),
+        priority_(0) {
     queue_waiters_.next = &queue_waiters_;
     queue_waiters_.prev = &queue_waiters_;
     for (int i = 0; i < NonBlockingWorkShardingFactor(); ++i) {
-      non_blocking_work_queues_.emplace_back(new NonBlockingQueue());
+      non_blocking_work_queues_.emplace_back(new QueueShard());
+    }
+    for (int i = 0; i < blocking_work_sharding_factor_; ++i) {
+      blocking_work_queues_.emplace_back(new QueueShard());
     }
   }
 
@@ -168,9 +183,16 @@ class ThreadWorkSource {
     for (int i = 0; i < non_blocking_work_queues_.size(); ++i) {
       delete non_blocking_work_queues_[i];
     }
+    for (int i = 0; i < blocking_work_queues_.size(); ++i) {
+      delete blocking_work_queues_[i];
+    }
   }
 
-  Task EnqueueTask(Task t, bool is_blocking) {
+  // `thread_id` is the index of the calling worker in the RunHandler thread
+  // pool, or -1 if the caller is not a worker. When there are several blocking
+  // queues, inter-op work enqueued by a worker goes to the queue owned by that
+  // worker, so that it is likely to run on the core that produced its inputs.
+  Task EnqueueTask(Task t, bool is_blocking, int thread_id = -1) {
     mutex* mu = nullptr;
     Queue* task_queue = nullptr;
     thread_local int64 closure_counter = 0;
@@ -180,8 +202,10 @@ class ThreadWorkSource {
       task_queue = &(non_blocking_work_queues_[queue_index]->queue);
       mu = &non_blocking_work_queues_[queue_index]->queue_op_mu;
     } else {
-      task_queue = &blocking_work_queue_;
-      mu = &blocking_queue_op_mu_;
+      int queue_index = thread_id >= 0 ? thread_id : ++closure_counter;
+      queue_index %= blocking_work_sharding_factor_;
+      task_queue = &(blocking_work_queues_[queue_index]->queue);
+      mu = &blocking_work_queues_[queue_index]->queue_op_mu;
     }
 
     {
@@ -255,7 +279,38 @@ class ThreadWorkSource {
     return t;
   }
 
-  Task PopBlockingTask() { return blocking_work_queue_.PopBack(); }
+  // With a single blocking queue tasks are taken in FIFO order. With several
+  // queues, a worker first takes the most recently pushed task from its own
+  // queue (LIFO) and then steals the oldest task from the others (FIFO).
+  Task PopBlockingTask(int thread_id) {
+    if (blocking_work_sharding_factor_ == 1) {
+      return blocking_work_queues_[0]->queue.PopBack();
+    }
+    Task t;
+    int own_index = -1;
+    if (thread_id >= 0) {
+      own_index = thread_id % blocking_work_sharding_factor_;
+      QueueShard* own = blocking_work_queues_[own_index];
+      {
+        // PushFront and PopFront may only be used by one thread at a time.
+        mutex_lock l(own->queue_op_mu);
+        t = own->queue.PopFront();
+      }
+      if (t.f) {
+        return t;
+      }
+    }
+    int start_index = thread_id >= 0 ? own_index + 1 : 0;
+    for (int j = 0; j < blocking_work_sharding_factor_; ++j) {
+      int index = (start_index + j) % blocking_work_sharding_factor_;
+      if (index == own_index) continue;
+      t = blocking_work_queues_[index]->queue.PopBack();
+      if (t.f) {
+        return t;
+      }
+    }
+    return t;
+  }
 
   Task PopNonBlockingTask(int start_index, bool search_from_all_queue) {
     Task t;
@@ -280,7 +335,11 @@ class ThreadWorkSource {
 
   int TaskQueueSize(bool is_blocking) {
     if (is_blocking) {
-      return blocking_work_queue_.Size();
+      unsigned total_size = 0;
+      for (int i = 0; i < blocking_work_sharding_factor_; ++i) {
+        total_size += blocking_work_queues_[i]->queue.Size();
+      }
+      return total_size;
     } else {
       unsigned total_size = 0;
       for (int i = 0; i < non_blocking_work_sharding_factor_; ++i) {
@@ -295,6 +354,9 @@ class ThreadWorkSource {
   void SetTracemeId(int64 value) { traceme_id_ = value; }
   void SetRank(int64 value) { rank_ = value; }
 
+  int64 GetPriority() { return priority_.load(std::memory_order_relaxed); }
+  void SetPriority(int64 value) { priority_ = value; }
+
   void SetWaiter(Waiter* waiter, mutex* mutex) {
     mutex_lock l(run_handler_waiter_mu_);
     sub_thread_pool_waiter_ = waiter;
@@ -332,25 +394,27 @@ class ThreadWorkSource {
   }
 
  private:
-  struct NonBlockingQueue {
+  struct QueueShard {
     mutex queue_op_mu;
     char pad[128];
     Queue queue;
   };
 
   int32 non_blocking_work_sharding_factor_;
-  Eigen::MaxSizeVector<NonBlockingQueue*> non_blocking_work_queues_;
+  Eigen::MaxSizeVector<QueueShard*> non_blocking_work_queues_;
+
+  int32 blocking_work_sharding_factor_;
+  Eigen::MaxSizeVector<QueueShard*> blocking_work_queues_;
 
   std::atomic<int64> blocking_inflight_;
   std::atomic<int64> non_blocking_inflight_;
 
-  Queue blocking_work_queue_;
-  mutex blocking_queue_op_mu_;
   char pad_[128];
   mutex waiters_mu_;
   Waiter queue_waiters_ GUARDED_BY(waiters_mu_);
   std::atomic<int64> traceme_id_;
   std::atomic<int64> rank_;
+  std::atomic<int64> priority_;
 
   mutex run_handler_waiter_mu_;
   mutex* sub_thread_pool_waiter_mu_ GUARDED_BY(run_handler_waiter_mu_);
@@ -432,7 +496,7 @@ class RunHandlerThreadPool {
   void AddWorkToQueue(ThreadWorkSource* tws, bool is_blocking,
                       std::function<void()> fn) {
     Task t = env_.CreateTask(std::move(fn));
-    t = tws->EnqueueTask(std::move(t), is_blocking);
+    t = tws->EnqueueTask(std::move(t), is_blocking, CurrentThreadId());
     if (t.f) {
       VLOG(3) << "Running " << (is_blocking ? "inter" : "intra") << " work for "
               << tws->GetTracemeId();
@@ -499,6 +563,28 @@ class RunHandlerThreadPool {
     return pt;
   }
 
+  // Returns true if the calling thread is a worker and one of the requests it
+  // takes work from has a higher priority than `tws` and queued inter-op
+  // work.
+  bool HasHigherPriorityWork(ThreadWorkSource* tws) {
+    const int tid = CurrentThreadId();
+    if (tid < 0) {
+      return false;
+    }
+    const int64 priority = tws->GetPriority();
+    mutex_lock l(thread_data_[tid].mu);
+    const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources =
+        thread_data_[tid].thread_work_sources;
+    for (int i = 0; i < thread_work_sources.size(); ++i) {
+      ThreadWorkSource* other = thread_work_sources[i];
+      if (other != tws && other->GetPriority() > priority &&
+          other->TaskQueueSize(true) > 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   int CurrentThreadId() const {
     const PerThread* pt =
         const_cast<RunHandlerThreadPool*>(this)->GetPerThread();
@@ -591,7 +677,7 @@ Task RunHandlerThreadPool::FindTask(
     // For blocking thread, search for blocking tasks first.
     if (may_steal_blocking_work &&
         (*tws)->GetInflightTaskCount(true) < max_blocking_inflight) {
-      t = (*tws)->PopBlockingTask();
+      t = (*tws)->PopBlockingTask(thread_id);
       if (t.f) {
         *task_from_blocking_queue = true;
         break;
@@ -670,7 +756,7 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
         // This is best effort policy.
         if (may_steal_blocking_work &&
             tws->GetInflightTaskCount(true) < kMaxBlockingInflight) {
-          t = tws->PopBlockingTask();
+          t = tws->PopBlockingTask(thread_id);
           if (t.f) {
             break;
           }
@@ -796,10 +882,13 @@ class RunHandler::Impl {
   // requested via RunHandlerPool::Get().
   uint64 start_time_us() const { return start_time_us_; }
   int64 step_id() const { return step_id_; }
+  int64 priority() const { return priority_; }
   void ScheduleInterOpClosure(std::function<void()> fn);
   void ScheduleIntraOpClosure(std::function<void()> fn);
+  bool ShouldYield();
 
-  void Reset(int64 step_id);
+  void Reset(int64 step_id,
+             const RunOptions::Experimental::RunHandlerPoolOptions& options);
 
   RunHandlerPool::Impl* pool_impl() { return pool_impl_; }
 
@@ -822,6 +911,9 @@ class RunHandler::Impl {
   RunHandlerPool::Impl* pool_impl_;  // NOT OWNED.
   uint64 start_time_us_;
   int64 step_id_;
+  int64 priority_;
+  // Queue time of inter-op closures for the priority of the current request.
+  monitoring::SamplerCell* queue_time_cell_ = nullptr;
   std::unique_ptr<thread::ThreadPoolInterface> thread_pool_interface_;
   ThreadWorkSource tws_;
 };
@@ -883,7 +975,9 @@ class RunHandlerPool::Impl {
     return !free_handlers_.empty();
   }
 
-  std::unique_ptr<RunHandler> Get(int64 step_id, int64 timeout_in_ms)
+  std::unique_ptr<RunHandler> Get(
+      int64 step_id, int64 timeout_in_ms,
+      const RunOptions::Experimental::RunHandlerPoolOptions& options)
       LOCKS_EXCLUDED(mu_) {
     std::unique_ptr<Eigen::MaxSizeVector<ThreadWorkSource*>>
         thread_work_sources;
@@ -905,13 +999,20 @@ class RunHandlerPool::Impl {
           return nullptr;
         }
       }
-      // Remove the last entry from free_handlers_ and add to the end of
-      // sorted_active_handlers_.
+      // Remove the last entry from free_handlers_ and add it after the
+      // active handlers of the same or higher priority. Handlers are obtained
+      // in increasing order of time, so this keeps the list sorted by
+      // priority and then by start time.
       handler_impl = free_handlers_.back();
-      handler_impl->Reset(step_id);
-      // Sortedness isn't violated if we simply add at the end of the list,
-      // since handlers are expected to be obtained in increasing order of time.
-      sorted_active_handlers_.push_back(handler_impl);
+      handler_impl->Reset(step_id, options);
+      sorted_active_handlers_.insert(
+          std::upper_bound(sorted_active_handlers_.begin(),
+                           sorted_active_handlers_.end(), handler_impl,
+                           [](const RunHandler::Impl* a,
+                              const RunHandler::Impl* b) {
+                             return a->priority() > b->priority();
+                           }),
+          handler_impl);
       DCHECK_LE(sorted_active_handlers_.size(), max_handlers_);
       free_handlers_.pop_back();
 
@@ -1019,7 +1120,7 @@ class RunHandlerPool::Impl {
 
   std::unique_ptr<RunHandlerThreadPool> run_handler_thread_pool_;
   // Thread compatible part used only by lock under RunHandlerPool.
-  // Handlers are sorted by start time.
+  // Handlers are sorted by priority and then by start time.
   // TODO(azaks): sort by the remaining latency budget.
   std::vector<RunHandler::Impl*> sorted_active_handlers_ GUARDED_BY(mu_);
   std::vector<RunHandler::Impl*> free_handlers_ GUARDED_BY(mu_);
@@ -1105,13 +1206,18 @@ void RunHandler::Impl::ThreadPoolInterfaceWrapper::Schedule(
 RunHandler::Impl::Impl(RunHandlerPool::Impl* pool_impl)
     : pool_impl_(pool_impl) {
   thread_pool_interface_.reset(new ThreadPoolInterfaceWrapper(this));
-  Reset(0);
+  Reset(0, RunOptions::Experimental::RunHandlerPoolOptions());
 }
 
 void RunHandler::Impl::ScheduleInterOpClosure(std::function<void()> fn) {
   VLOG(3) << "Scheduling inter work for  " << tws()->GetTracemeId();
-  pool_impl_->run_handler_thread_pool()->AddWorkToQueue(tws(), true,
-                                                        std::move(fn));
+  monitoring::SamplerCell* cell = queue_time_cell_;
+  const uint64 enqueue_time_us = Env::Default()->NowMicros();
+  pool_impl_->run_handler_thread_pool()->AddWorkToQueue(
+      tws(), true, [cell, enqueue_time_us, fn = std::move(fn)]() {
+        cell->Add(Env::Default()->NowMicros() - enqueue_time_us);
+        fn();
+      });
 }
 
 void RunHandler::Impl::ScheduleIntraOpClosure(std::function<void()> fn) {
@@ -1120,10 +1226,20 @@ void RunHandler::Impl::ScheduleIntraOpClosure(std::function<void()> fn) {
                                                         std::move(fn));
 }
 
-void RunHandler::Impl::Reset(int64 step_id) {
+bool RunHandler::Impl::ShouldYield() {
+  return pool_impl_->run_handler_thread_pool()->HasHigherPriorityWork(tws());
+}
+
+void RunHandler::Impl::Reset(
+    int64 step_id,
+    const RunOptions::Experimental::RunHandlerPoolOptions& options) {
   start_time_us_ = tensorflow::Env::Default()->NowMicros();
   step_id_ = step_id;
+  priority_ = options.priority();
+  queue_time_cell_ =
+      inter_op_queue_time_usecs->GetCell(strings::StrCat(priority_));
   tws_.SetTracemeId(step_id);
+  tws_.SetPriority(priority_);
 }
 
 RunHandlerPool::RunHandlerPool(int num_inter_op_threads)
@@ -1135,9 +1251,10 @@ RunHandlerPool::RunHandlerPool(int num_inter_op_threads,
 
 RunHandlerPool::~RunHandlerPool() {}
 
-std::unique_ptr<RunHandler> RunHandlerPool::Get(int64 step_id,
-                                                int64 timeout_in_ms) {
-  return impl_->Get(step_id, timeout_in_ms);
+std::unique_ptr<RunHandler> RunHandlerPool::Get(
+    int64 step_id, int64 timeout_in_ms,
+    const RunOptions::Experimental::RunHandlerPoolOptions& options) {
+  return impl_->Get(step_id, timeout_in_ms, options);
 }
 
 RunHandler::RunHandler(Impl* impl) : impl_(impl) {}
@@ -1150,6 +1267,8 @@ thread::ThreadPoolInterface* RunHandler::AsIntraThreadPoolInterface() {
   return impl_->thread_pool_interface();
 }
 
+bool RunHandler::ShouldYield() { return impl_->ShouldYield(); }
+
 RunHandler::~RunHandler() { impl_->pool_impl()->ReleaseHandler(impl_); }
 
 }  // namespace tensorflow
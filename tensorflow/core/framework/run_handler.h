@@ -62,7 +62,13 @@ class RunHandlerPool {
   // unique_ptr is destroyed.
   //
   // Will block unless there is an inactive handler.
-  std::unique_ptr<RunHandler> Get(int64 step_id = 0, int64 timeout_in_ms = 0);
+  //
+  // Active handlers are ordered by `options.priority()`, highest first, and
+  // then by the time of the Get() call.
+  std::unique_ptr<RunHandler> Get(
+      int64 step_id = 0, int64 timeout_in_ms = 0,
+      const RunOptions::Experimental::RunHandlerPoolOptions& options =
+          RunOptions::Experimental::RunHandlerPoolOptions());
 
  private:
   class Impl;
@@ -88,6 +94,13 @@ class RunHandler {
   void ScheduleInterOpClosure(std::function<void()> fn);
   thread::ThreadPoolInterface* AsIntraThreadPoolInterface();
 
+  // Returns true if the calling thread is a worker of the pool and a request
+  // of higher priority than this one has inter-op work waiting. A caller that
+  // runs several pieces of work inline can then reschedule the remaining ones
+  // with ScheduleInterOpClosure, so that a long step of low priority does not
+  // keep workers from more urgent requests.
+  bool ShouldYield();
+
   ~RunHandler();
 
  private:
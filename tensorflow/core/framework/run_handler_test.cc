@@ -78,6 +78,72 @@ TEST(RunHandlerUtilTest, TestBasicScheduling) {
   counter.Wait();
 }
 
+TEST(RunHandlerUtilTest, TestPriorityYield) {
+  // A single inter-op worker, so that work queued while it runs stays queued.
+  std::unique_ptr<RunHandlerPool> pool(new RunHandlerPool(1, 0));
+  RunOptions::Experimental::RunHandlerPoolOptions low_options;
+  RunOptions::Experimental::RunHandlerPoolOptions high_options;
+  high_options.set_priority(1);
+  auto low = pool->Get(0, 0, low_options);
+  auto high = pool->Get(1, 0, high_options);
+
+  // Not called from a worker of the pool.
+  EXPECT_FALSE(low->ShouldYield());
+
+  BlockingCounter counter(2);
+  bool low_should_yield = false;
+  bool high_should_yield = true;
+  RunHandler* low_ptr = low.get();
+  RunHandler* high_ptr = high.get();
+  low->ScheduleInterOpClosure([&]() {
+    high_ptr->ScheduleInterOpClosure(
+        [&counter]() { counter.DecrementCount(); });
+    low_should_yield = low_ptr->ShouldYield();
+    high_should_yield = high_ptr->ShouldYield();
+    counter.DecrementCount();
+  });
+  counter.Wait();
+  EXPECT_TRUE(low_should_yield);
+  EXPECT_FALSE(high_should_yield);
+}
+
+TEST(RunHandlerUtilTest, TestShardedBlockingQueues) {
+  ASSERT_EQ(setenv("TF_RUN_HANDLER_NUM_OF_BLOCKING_QUEUES", "4", true), 0);
+  int num_threads = 4;
+  int num_handlers = 4;
+  int fanout = 16;
+
+  std::unique_ptr<RunHandlerPool> pool(
+      new RunHandlerPool(num_threads, num_threads));
+  ASSERT_EQ(unsetenv("TF_RUN_HANDLER_NUM_OF_BLOCKING_QUEUES"), 0);
+
+  // Inter closures scheduled from worker threads land in the worker's own
+  // queue; every one of them must still run.
+  BlockingCounter counter(num_handlers * fanout * (fanout + 1));
+  thread::ThreadPool test_pool(Env::Default(), "test", num_handlers);
+  for (int i = 0; i < num_handlers; ++i) {
+    test_pool.Schedule([&counter, &pool, fanout, i]() {
+      auto handler = pool->Get(i);
+      BlockingCounter local_counter(fanout * (fanout + 1));
+      RunHandler* h = handler.get();
+      for (int j = 0; j < fanout; ++j) {
+        h->ScheduleInterOpClosure([h, &local_counter, &counter, fanout]() {
+          for (int k = 0; k < fanout; ++k) {
+            h->ScheduleInterOpClosure([&local_counter, &counter]() {
+              counter.DecrementCount();
+              local_counter.DecrementCount();
+            });
+          }
+          counter.DecrementCount();
+          local_counter.DecrementCount();
+        });
+      }
+      local_counter.Wait();
+    });
+  }
+  counter.Wait();
+}
+
 SessionOptions DefaultSessionOptions() {
   SessionOptions options;
   (*options.config.mutable_device_count())["CPU"] = 2;
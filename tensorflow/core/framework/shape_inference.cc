@@ -1243,20 +1243,34 @@ bool InferenceContext::RelaxInputHandleShapesAndMergeTypes(
 // -----------------------------------------------------------------------------
 // ShapeManager
 // -----------------------------------------------------------------------------
-InferenceContext::ShapeManager::ShapeManager() {}
+namespace {
+
+// Enough for the shapes and dims of most nodes. Arena blocks are aligned to
+// pointers, and Arena::Alloc keeps later objects aligned as long as every size
+// is a multiple of the alignment.
+constexpr size_t kShapeArenaBlockSize = 512;
+static_assert(sizeof(Dimension) % alignof(Dimension) == 0 &&
+                  sizeof(Shape) % alignof(Dimension) == 0 &&
+                  alignof(Shape) <= alignof(Dimension) &&
+                  alignof(Dimension) <= sizeof(void*),
+              "Shapes and dims must stay aligned in the arena");
+
+}  // namespace
+
+InferenceContext::ShapeManager::ShapeManager()
+    : arena_(kShapeArenaBlockSize) {}
 InferenceContext::ShapeManager::~ShapeManager() {
-  for (auto* s : all_shapes_) delete s;
-  for (auto* d : all_dims_) delete d;
+  for (auto* s : all_shapes_) s->~Shape();
 }
 
 ShapeHandle InferenceContext::ShapeManager::MakeShape(
     const std::vector<DimensionHandle>& dims) {
-  all_shapes_.push_back(new Shape(dims));
+  all_shapes_.push_back(new (arena_.Alloc(sizeof(Shape))) Shape(dims));
   return all_shapes_.back();
 }
 
 ShapeHandle InferenceContext::ShapeManager::UnknownShape() {
-  all_shapes_.push_back(new Shape());
+  all_shapes_.push_back(new (arena_.Alloc(sizeof(Shape))) Shape());
   return all_shapes_.back();
 }
 
@@ -15,11 +15,13 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_SHAPE_INFERENCE_H_
 #define TENSORFLOW_CORE_FRAMEWORK_SHAPE_INFERENCE_H_
 
+#include <new>
 #include <vector>
 
 #include "absl/memory/memory.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/arena.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
@@ -615,6 +617,9 @@ class InferenceContext {
 
  private:
   // Creates and stores shapes for use in InferenceContext.
+  //
+  // Shapes and dims are placed in an arena, so that a context makes a few
+  // allocations for all of them rather than one per shape and dim.
   class ShapeManager {
    public:
     ShapeManager();
@@ -633,14 +638,15 @@ class InferenceContext {
       if (d.dim.IsSet()) {
         return d.dim;
       } else {
-        all_dims_.push_back(new Dimension(d.val));
-        return all_dims_.back();
+        return new (arena_.Alloc(sizeof(Dimension))) Dimension(d.val);
       }
     }
 
    private:
-    std::vector<Shape*> all_shapes_;    // values are owned.
-    std::vector<Dimension*> all_dims_;  // values are owned.
+    core::Arena arena_;
+    // Shapes in arena_, which are destroyed with the manager. Dimensions are
+    // trivially destructible, so they are only freed with the arena.
+    std::vector<Shape*> all_shapes_;
   };
 
   friend class ::tensorflow::grappler::GraphProperties;
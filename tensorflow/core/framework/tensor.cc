@@ -810,8 +810,117 @@ static Allocator* get_default_cpu_allocator() {
   return default_cpu_allocator;
 }
 
+namespace {
+
+// Host tensors of at most this many bytes allocated by the default CPU
+// allocator are backed by an InlineBuffer.
+constexpr size_t kMaxInlineBufferBytes = 32;
+
+// A buffer for small host tensors of simple types that keeps the elements in
+// the same allocation as the TensorBuffer itself, halving the number of
+// allocations for scalars and shape vectors.
+class InlineBuffer : public TensorBuffer {
+ public:
+  static InlineBuffer* New(size_t num_bytes) {
+    const size_t offset = DataOffset();
+    void* ptr =
+        port::AlignedMalloc(offset + num_bytes, EIGEN_MAX_ALIGN_BYTES);
+    if (ptr == nullptr) return nullptr;
+    return new (ptr) InlineBuffer(static_cast<char*>(ptr) + offset, num_bytes);
+  }
+
+  size_t size() const override { return num_bytes_; }
+  TensorBuffer* root_buffer() override { return this; }
+  bool GetAllocatedBytes(size_t* out_bytes) const override { return false; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size());
+    proto->set_allocator_name("InlineTensorBuffer");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+  // `delete this` in `core::RefCounted::Unref()` frees the allocation made in
+  // New(), which starts at the object.
+  static void operator delete(void* ptr) { port::AlignedFree(ptr); }
+  static void operator delete(void*, void*) {}
+
+ private:
+  InlineBuffer(void* data_ptr, size_t num_bytes)
+      : TensorBuffer(data_ptr), num_bytes_(num_bytes) {}
+  ~InlineBuffer() override {}
+
+  // Offset of the elements from the start of the allocation, keeping them
+  // aligned as if they came from an allocator.
+  static size_t DataOffset() {
+    return (sizeof(InlineBuffer) + EIGEN_MAX_ALIGN_BYTES - 1) /
+           EIGEN_MAX_ALIGN_BYTES * EIGEN_MAX_ALIGN_BYTES;
+  }
+
+  const size_t num_bytes_;
+};
+
+// Returns an InlineBuffer for a tensor of `type` and `shape`, or nullptr if
+// the tensor must come from the allocator. Allocator statistics and memory
+// logging only see the allocator, so inline buffers are not used while
+// either is enabled.
+TensorBuffer* MaybeNewInlineBuffer(DataType type, const TensorShape& shape) {
+  if (!DataTypeCanUseMemcpy(type) || CPUAllocatorStatsEnabled() ||
+      MemoryLoggingEnabled()) {
+    return nullptr;
+  }
+  const size_t num_bytes = shape.num_elements() * DataTypeSize(type);
+  if (num_bytes == 0 || num_bytes > kMaxInlineBufferBytes) return nullptr;
+  return InlineBuffer::New(num_bytes);
+}
+
+// A buffer that takes over the tensor_content string of a TensorProto consumed
+// by Tensor::FromProto, so that the parsed bytes are used in place instead of
+// being copied into a second allocation.
+class ProtoContentBuffer : public TensorBuffer {
+ public:
+  // Takes `*content`, leaving it empty, if its bytes are aligned for a tensor.
+  // Returns nullptr otherwise. Strings of at most kMaxInlineBufferBytes may
+  // keep their bytes inside the string object, so they are never taken.
+  static ProtoContentBuffer* New(string* content) {
+    if (content->size() <= kMaxInlineBufferBytes) return nullptr;
+#if EIGEN_MAX_ALIGN_BYTES > 0
+    if (reinterpret_cast<intptr_t>(content->data()) % EIGEN_MAX_ALIGN_BYTES !=
+        0) {
+      return nullptr;
+    }
+#endif
+    return new ProtoContentBuffer(content);
+  }
+
+  size_t size() const override { return content_.size(); }
+  TensorBuffer* root_buffer() override { return this; }
+  bool GetAllocatedBytes(size_t* out_bytes) const override { return false; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size());
+    proto->set_allocator_name("TensorProtoContent");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+ private:
+  // Swapping a heap-allocated string keeps its bytes where they are.
+  explicit ProtoContentBuffer(string* content)
+      : TensorBuffer(&(*content)[0]) {
+    content_.swap(*content);
+    DCHECK_EQ(data(), content_.data());
+  }
+  ~ProtoContentBuffer() override {}
+
+  string content_;
+};
+
+}  // namespace
+
 Tensor::Tensor(DataType type, const TensorShape& shape)
-    : Tensor(get_default_cpu_allocator(), type, shape) {}
+    : shape_(shape), buf_(MaybeNewInlineBuffer(type, shape)) {
+  set_dtype(type);
+  if (buf_ == nullptr) {
+    *this = Tensor(get_default_cpu_allocator(), type, shape);
+  }
+}
 
 bool Tensor::HostScalarTensorBufferBase::GetAllocatedBytes(
     size_t* out_bytes) const {
@@ -948,6 +1057,36 @@ bool Tensor::FromProto(Allocator* a, const TensorProto& proto) {
   return true;
 }
 
+bool Tensor::FromProto(TensorProto&& proto) {
+  return FromProto(get_default_cpu_allocator(), std::move(proto));
+}
+
+bool Tensor::FromProto(Allocator* a, TensorProto&& proto) {
+  // The bytes can only be adopted in place of an allocation from the default
+  // CPU allocator, and only when nothing accounts for that allocator's memory.
+  if (a == get_default_cpu_allocator() && !proto.tensor_content().empty() &&
+      DataTypeCanUseMemcpy(proto.dtype()) && !CPUAllocatorStatsEnabled() &&
+      !MemoryLoggingEnabled() && TensorShape::IsValid(proto.tensor_shape())) {
+    TensorShape shape(proto.tensor_shape());
+    if (shape.num_elements() * DataTypeSize(proto.dtype()) ==
+        proto.tensor_content().size()) {
+      TensorBuffer* p = ProtoContentBuffer::New(proto.mutable_tensor_content());
+      if (p != nullptr) {
+        shape_ = shape;
+        set_dtype(proto.dtype());
+        UnrefIfNonNull(buf_);
+        buf_ = p;
+        return true;
+      }
+    }
+  }
+  if (!FromProto(a, static_cast<const TensorProto&>(proto))) return false;
+  // Releases the bytes that were copied now rather than with the proto, so
+  // that a caller parsing many tensors only holds both copies of one.
+  string().swap(*proto.mutable_tensor_content());
+  return true;
+}
+
 void Tensor::AsProtoField(TensorProto* proto) const {
   proto->Clear();
   shape_.AsProto(proto->mutable_tensor_shape());
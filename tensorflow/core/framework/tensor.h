@@ -350,6 +350,16 @@ class Tensor {
   bool FromProto(const TensorProto& other) TF_MUST_USE_RESULT;
   bool FromProto(Allocator* a, const TensorProto& other) TF_MUST_USE_RESULT;
 
+  /// \brief Parse `other`, which is consumed, and construct the tensor.
+  ///
+  /// If `a` is the default CPU allocator and the `tensor_content` of `other`
+  /// is suitably aligned, the tensor takes over its bytes instead of copying
+  /// them. Otherwise the bytes are released as soon as they are copied. Either
+  /// way a large tensor is not held twice while it is parsed. If the parsing
+  /// succeeds, `other` is left in a valid but unspecified state.
+  bool FromProto(TensorProto&& other) TF_MUST_USE_RESULT;
+  bool FromProto(Allocator* a, TensorProto&& other) TF_MUST_USE_RESULT;
+
   /// \brief Fills in `proto` with `*this` tensor's content.
   ///
   /// `AsProtoField()` fills in the repeated field for `proto.dtype()`, while
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
@@ -156,6 +157,14 @@ void TestCopies(const Tensor& t) {
     EXPECT_TRUE(t3.FromProto(proto));
     test::ExpectTensorEqual<T>(t, t2);
   }
+  {
+    LOG(INFO) << "FromProto(TensorProto&&)";
+    TensorProto proto;
+    t.AsProtoTensorContent(&proto);
+    Tensor t2(t.dtype());
+    EXPECT_TRUE(t2.FromProto(std::move(proto)));
+    test::ExpectTensorEqual<T>(t, t2);
+  }
   {
     LOG(INFO) << "AsTensor";
     gtl::ArraySlice<T> values(t.flat<T>().data(), t.NumElements());
@@ -276,6 +285,33 @@ TEST(Tensor_Variant, Simple) {
   }
 }
 
+TEST(Tensor_Float, FromProtoTakesContent) {
+  Tensor t(DT_FLOAT, TensorShape({64, 64}));
+  test::FillIota<float>(&t, 0.0f);
+  TensorProto proto;
+  t.AsProtoTensorContent(&proto);
+  const char* content = proto.tensor_content().data();
+  const bool aligned =
+      reinterpret_cast<intptr_t>(content) % EIGEN_MAX_ALIGN_BYTES == 0;
+
+  Tensor t2;
+  ASSERT_TRUE(t2.FromProto(std::move(proto)));
+  test::ExpectTensorEqual<float>(t, t2);
+  EXPECT_TRUE(t2.IsAligned());
+  // Aligned bytes are taken over, others are copied and released.
+  EXPECT_EQ(t2.tensor_data().data() == content, aligned);
+  EXPECT_TRUE(proto.tensor_content().empty());
+
+  // A proto that does not parse is left as it was.
+  TensorProto bad;
+  t.AsProtoTensorContent(&bad);
+  bad.mutable_tensor_content()->resize(bad.tensor_content().size() - 4);
+  const size_t bad_size = bad.tensor_content().size();
+  Tensor t3;
+  EXPECT_FALSE(t3.FromProto(std::move(bad)));
+  EXPECT_EQ(bad.tensor_content().size(), bad_size);
+}
+
 TEST(Tensor_Variant, Marshal) {
   Tensor t(DT_VARIANT, TensorShape({}));
 
@@ -871,6 +907,39 @@ TEST(Tensor_HostScalar, Basics) {
   }
 }
 
+TEST(Tensor_SmallHost, Inline) {
+  {
+    Tensor t(DT_INT32, TensorShape({4}));
+    EXPECT_TRUE(t.IsAligned());
+    auto Tt = t.vec<int32>();
+    for (int i = 0; i < 4; ++i) Tt(i) = i;
+    Tensor copy = t;
+    EXPECT_TRUE(copy.SharesBufferWith(t));
+    test::ExpectTensorEqual<int32>(copy, test::AsTensor<int32>({0, 1, 2, 3}));
+    TensorDescription description;
+    t.FillDescription(&description);
+    EXPECT_EQ("InlineTensorBuffer",
+              description.allocation_description().allocator_name());
+  }
+  {
+    // Too large to be inlined.
+    Tensor t(DT_FLOAT, TensorShape({9}));
+    TensorDescription description;
+    t.FillDescription(&description);
+    EXPECT_NE("InlineTensorBuffer",
+              description.allocation_description().allocator_name());
+  }
+  {
+    // Strings need their constructors and destructors run.
+    Tensor t(DT_STRING, TensorShape({}));
+    t.scalar<tstring>()() = "fooooooooooooooooooooooooooooooooooooo";
+    TensorDescription description;
+    t.FillDescription(&description);
+    EXPECT_NE("InlineTensorBuffer",
+              description.allocation_description().allocator_name());
+  }
+}
+
 TEST(Tensor_Float, Reshape_And_Slice_Assignment) {
   // A test to experiment with a way to assign to a subset of a tensor
   Tensor t(DT_FLOAT, TensorShape({10, 4, 3, 2}));
@@ -1519,6 +1588,17 @@ void BM_CreateAndDestroyHostScalarOptimized(int iters) {
 }
 BENCHMARK(BM_CreateAndDestroyHostScalarOptimized);
 
+// Benchmark creating and destroying a small host vector, using the default
+// allocator constructor.
+void BM_CreateAndDestroySmallHostVector(int iters) {
+  TensorShape shape({4});
+  while (--iters) {
+    Tensor a(DT_INT32, shape);
+    a.vec<int32>()(0) = 37;
+  }
+}
+BENCHMARK(BM_CreateAndDestroySmallHostVector);
+
 static void BM_FromProto(int iters, int size) {
   testing::StopTiming();
   TensorShape shape({size});
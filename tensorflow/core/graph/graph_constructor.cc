@@ -38,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
@@ -95,7 +96,8 @@ class GraphConstructor {
           importing(false),
           validate_nodes(in.validate_nodes),
           validate_colocation_constraints(false),
-          add_default_attributes(in.add_default_attributes) {}
+          add_default_attributes(in.add_default_attributes),
+          validation_thread_pool(in.validation_thread_pool) {}
     Options(const ImportGraphDefOptions& in)  // NOLINT(runtime/explicit)
         : allow_internal_ops(false),
           expect_device_spec(false),
@@ -148,6 +150,10 @@ class GraphConstructor {
     bool add_default_attributes = true;
 
     string default_device;
+
+    // If set, `validate_nodes` checks the nodes on this pool once they are
+    // all added, rather than one at a time. Not used when `importing`.
+    thread::ThreadPool* validation_thread_pool = nullptr;
   };
 
   typedef gtl::ArraySlice<const NodeDef*> NodeDefSlice;
@@ -191,6 +197,7 @@ class GraphConstructor {
     // NOTE: Convert() invokes `consume_node_def()` on each node in the input
     // graph, so `get_node_def()` is no longer usable once it is called.
     TF_RETURN_IF_ERROR(Convert());
+    TF_RETURN_IF_ERROR(ValidateNodesInParallel());
 
     TF_RETURN_IF_ERROR(AddBackEdges());
     TF_RETURN_IF_ERROR(UpdateVersionDef());
@@ -208,6 +215,7 @@ class GraphConstructor {
   Status BuildNodeIndex();
   Status InitFromEdges();
   Status Convert();
+  Status ValidateNodesInParallel();
   Status AddBackEdges();
   Status UpdateVersionDef();
   Status PopulateReturnTensors();
@@ -228,6 +236,9 @@ class GraphConstructor {
   Status MakeEdge(Node* src, int output_index, Node* dst, int input_index);
   Status ValidateShape(Node* node);
   Status ModifyNodeDefForImport(NodeDef* node_def);
+  // Looks up the OpDef of `op`, memoizing it so that the registry, and its
+  // lock, is only consulted once per op type.
+  Status LookUpOpDef(const string& op, const OpDef** op_def);
   // Modifies node_def's inputs according to opts_.input_map.
   // input_already_exists is a pre-initialized vector of length
   // node_def->input_size(). This function will mark inputs that are remapped to
@@ -332,6 +343,12 @@ class GraphConstructor {
   // Prefixes already used in the GraphDef being imported.
   gtl::FlatSet<StringPiece, StringPieceHasher> gdef_prefixes_;
 
+  // OpDefs looked up so far, by op type.
+  gtl::FlatMap<string, const OpDef*> op_defs_;
+
+  // Nodes and their OpDefs left to validate on opts_.validation_thread_pool.
+  std::vector<std::pair<const Node*, const OpDef*>> nodes_to_validate_;
+
   // Mapping from node name to the existing node in g_.
   gtl::FlatMap<StringPiece, Node*, StringPieceHasher> existing_nodes_;
 
@@ -607,6 +624,8 @@ Status GraphConstructor::ValidateInputMapAndControlDependencies() {
 }
 
 Status GraphConstructor::BuildNodeIndex() {
+  gdef_nodes_.reserve(node_def_count());
+  if (opts_.importing) string_intern_table_.reserve(node_def_count());
   // Validate the node names and add them to gdef_nodes_ and gdef_prefixes_.
   for (int n = 0; n < node_def_count(); ++n) {
     const NodeDef& node_def = get_node_def(n);
@@ -655,7 +674,9 @@ Status GraphConstructor::InitFromEdges() {
   const int num_nodes = node_def_count();
   pending_count_.reserve(num_nodes);
   outputs_.resize(num_nodes);
-  gtl::FlatSet<string> next_iteration_nodes;
+  // Names of NextIteration nodes, pointing into the NodeDefs, which are not
+  // consumed before Convert().
+  gtl::FlatSet<StringPiece, StringPieceHasher> next_iteration_nodes;
   for (int n = 0; n < node_def_count(); ++n) {
     const NodeDef& node_def = get_node_def(n);
     if (IsNextIteration(node_def)) {
@@ -680,7 +701,7 @@ Status GraphConstructor::InitFromEdges() {
           num_control_edges++;
         } else {
           TensorId id(ParseTensorName(input_name));
-          if (next_iteration_nodes.find(string(id.first)) !=
+          if (next_iteration_nodes.find(id.first) !=
               next_iteration_nodes.end()) {
             has_loop_back_edge = true;
           }
@@ -745,8 +766,14 @@ Status GraphConstructor::MakeNode(NodeDef&& node_def, Node** node) {
     (*node)->set_assigned_device_name((*node)->def().device());
   }
 #ifdef TENSORFLOW_USE_VE
-  if (const char* tmp = getenv("TF_FORCE_CPU")) {
-    std::vector<string> v = str_util::Split(tmp, ",");
+  // Op types listed in TF_FORCE_CPU, parsed once rather than for every node.
+  static const std::vector<string>* const force_cpu_ops = [] {
+    const char* tmp = getenv("TF_FORCE_CPU");
+    return new std::vector<string>(
+        tmp ? str_util::Split(tmp, ",") : std::vector<string>());
+  }();
+  {
+    const std::vector<string>& v = *force_cpu_ops;
     if (std::find(v.begin(), v.end(), (*node)->type_string()) != v.end()) {
       const char* dev = "/job:localhost/replica:0/task:0/device:CPU:0";
       LOG(INFO) << "assigne node " << (*node)->name()
@@ -855,9 +882,20 @@ Status GraphConstructor::ValidateShape(Node* node) {
   return Status::OK();
 }
 
+Status GraphConstructor::LookUpOpDef(const string& op, const OpDef** op_def) {
+  auto it = op_defs_.find(op);
+  if (it != op_defs_.end()) {
+    *op_def = it->second;
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(g_->op_registry()->LookUpOpDef(op, op_def));
+  op_defs_.emplace(op, *op_def);
+  return Status::OK();
+}
+
 Status GraphConstructor::ModifyNodeDefForImport(NodeDef* node_def) {
   const OpDef* op_def;
-  TF_RETURN_IF_ERROR(g_->op_registry()->LookUpOpDef(node_def->op(), &op_def));
+  TF_RETURN_IF_ERROR(LookUpOpDef(node_def->op(), &op_def));
   AddDefaultsToNodeDef(*op_def, node_def);
   TF_RETURN_IF_ERROR(ValidateNodeDef(*node_def, *op_def));
   if (versions()) {
@@ -1241,6 +1279,7 @@ Status GraphConstructor::Convert() {
     }
 
     Node* node;
+    const OpDef* op_def = nullptr;
     if (opts_.importing) {
       if (!prefix_.empty()) {
         AddPrefixToNodeDef(input_already_exists, &node_def);
@@ -1255,18 +1294,20 @@ Status GraphConstructor::Convert() {
     if (opts_.importing) {
       TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&node_def));
     } else {
-      const OpDef* op_def;
-      TF_RETURN_IF_ERROR(
-          g_->op_registry()->LookUpOpDef(node_def.op(), &op_def));
+      TF_RETURN_IF_ERROR(LookUpOpDef(node_def.op(), &op_def));
       if (opts_.add_default_attributes) {
         AddDefaultsToNodeDef(*op_def, &node_def);
       }
-      if (opts_.validate_nodes) {
+      if (opts_.validate_nodes && opts_.validation_thread_pool == nullptr) {
         TF_RETURN_IF_ERROR(ValidateNodeDef(node_def, *op_def));
       }
     }
 
     TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
+    if (!opts_.importing && opts_.validate_nodes &&
+        opts_.validation_thread_pool != nullptr) {
+      nodes_to_validate_.emplace_back(node, op_def);
+    }
 
     if (opts_.importing) {
       // Use interned original node name so StringPiece remains valid.
@@ -1322,6 +1363,26 @@ Status GraphConstructor::Convert() {
   return Status::OK();
 }
 
+Status GraphConstructor::ValidateNodesInParallel() {
+  if (nodes_to_validate_.empty()) return Status::OK();
+  std::vector<Status> statuses(nodes_to_validate_.size());
+  // Rough cost in cycles of validating the attrs of one node.
+  const int64 kCostPerNode = 10000;
+  opts_.validation_thread_pool->ParallelFor(
+      nodes_to_validate_.size(), kCostPerNode,
+      [this, &statuses](int64 begin, int64 end) {
+        for (int64 i = begin; i < end; ++i) {
+          const auto& node_and_op_def = nodes_to_validate_[i];
+          statuses[i] = ValidateNodeDef(node_and_op_def.first->def(),
+                                        *node_and_op_def.second);
+        }
+      });
+  nodes_to_validate_.clear();
+  // Reports the error of the first node added, as serial validation would.
+  for (const Status& s : statuses) TF_RETURN_IF_ERROR(s);
+  return Status::OK();
+}
+
 Status GraphConstructor::AddBackEdges() {
   // Add the back edges after all nodes are created.
   for (auto e : back_edges_) {
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
@@ -893,6 +894,39 @@ TEST_F(GraphConstructorTest, Error_ControlEdgeBeforeRealInput) {
       {"Node 't2': Control dependencies must come after regular dependencies"});
 }
 
+TEST_F(GraphConstructorTest, ValidateNodesOnThreadPool) {
+  thread::ThreadPool pool(Env::Default(), "validate", 4);
+  GraphConstructorOptions opts;
+  opts.validate_nodes = true;
+  opts.validation_thread_pool = &pool;
+  Convert(
+      "node { name: 'W1' op: 'TestParams' }"
+      "node { name: 'input' op: 'TestInput' }"
+      "node { name: 't1' op: 'TestMul' input: [ 'W1', 'input:1' ] }"
+      "node { name: 'd' op: 'TestDefaultAttr' }");
+  TF_EXPECT_OK(ConvertGraphDefToGraph(opts, gdef_, &graph_));
+  EXPECT_TRUE(HasEdge("input", 1, "t1", 1));
+  EXPECT_EQ(31415, FindNode("d")->def().attr().at("default_int").i());
+}
+
+TEST_F(GraphConstructorTest, Error_ValidateNodesOnThreadPool) {
+  thread::ThreadPool pool(Env::Default(), "validate", 4);
+  GraphConstructorOptions opts;
+  opts.validate_nodes = true;
+  opts.validation_thread_pool = &pool;
+  const string original_graph_description = GraphDebugString();
+  Convert(
+      "node { name: 'W1' op: 'TestParams' }"
+      "node { name: 'input' op: 'TestInput' attr { key: 'bad' value { i: 1 } }"
+      "}"
+      "node { name: 't1' op: 'TestMul' input: [ 'W1', 'input:1' ] }");
+  Status s = ConvertGraphDefToGraph(opts, gdef_, &graph_);
+  EXPECT_FALSE(s.ok());
+  EXPECT_TRUE(str_util::StrContains(s.error_message(), "bad")) << s;
+  // The nodes added before validation are removed again.
+  EXPECT_EQ(original_graph_description, GraphDebugString());
+}
+
 TEST_F(GraphConstructorTest, ImportGraphDef) {
   GraphDef def;
   ImportGraphDefOptions opts;
@@ -38,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mem.h"
 
 namespace tensorflow {
@@ -148,6 +149,37 @@ DeviceProperties GetLocalGPUInfo(PlatformGpuId platform_gpu_id) {
   return device;
 }
 
+DeviceProperties GetLocalVEInfo(int ve_id) {
+  DeviceProperties device;
+  device.set_type("VE");
+
+  // SX-Aurora TSUBASA Vector Engine Type 10B, refined by what the VE driver
+  // reports when the card is present.
+  device.set_vendor("NEC");
+  device.set_model("VE10B");
+  device.set_frequency(1400);
+  device.set_num_cores(8);
+  const string sysfs = strings::StrCat("/sys/class/ve/ve", ve_id, "/");
+  string str;
+  int32 value;
+  if (ReadFileToString(Env::Default(), sysfs + "num_of_core", &str).ok() &&
+      strings::safe_strto32(str, &value) && value > 0) {
+    device.set_num_cores(value);
+  }
+  // In MHz.
+  if (ReadFileToString(Env::Default(), sysfs + "clock_chip", &str).ok() &&
+      strings::safe_strto32(str, &value) && value > 0) {
+    device.set_frequency(value);
+  }
+  device.set_l1_cache_size(32 * 1024);
+  device.set_l2_cache_size(256 * 1024);
+  device.set_l3_cache_size(16 * 1024 * 1024);
+  // 1.2TB/s of HBM2, in KB/s.
+  device.set_bandwidth(1200 * 1024 * 1024);
+
+  return device;
+}
+
 DeviceProperties GetDeviceInfo(const DeviceNameUtils::ParsedName& device) {
   DeviceProperties unknown;
   unknown.set_type("UNKNOWN");
@@ -167,6 +199,8 @@ DeviceProperties GetDeviceInfo(const DeviceNameUtils::ParsedName& device) {
     } else {
       return GetLocalGPUInfo(PlatformGpuId(0));
     }
+  } else if (device.type == "VE") {
+    return GetLocalVEInfo(device.has_id ? device.id : 0);
   }
   return unknown;
 }
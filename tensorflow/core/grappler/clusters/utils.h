@@ -30,6 +30,11 @@ DeviceProperties GetLocalCPUInfo();
 // which grappler is running.
 DeviceProperties GetLocalGPUInfo(PlatformGpuId platform_gpu_id);
 
+// Returns the DeviceProperties of the specified VE attached to the server on
+// which grappler is running. The memory size is not filled in since it depends
+// on the memory limit the VE device was created with.
+DeviceProperties GetLocalVEInfo(int ve_id);
+
 // Returns the DeviceProperties of the specified device
 DeviceProperties GetDeviceInfo(const DeviceNameUtils::ParsedName& device);
 
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/grappler/clusters/utils.h"
 #include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/util/device_name_utils.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -53,6 +54,8 @@ constexpr char kReshape[] = "Reshape";
 constexpr char kSqueeze[] = "Squeeze";
 constexpr char kRecv[] = "_Recv";
 constexpr char kSend[] = "_Send";
+constexpr char kAttrSendDevice[] = "send_device";
+constexpr char kAttrRecvDevice[] = "recv_device";
 constexpr char kBatchMatMul[] = "BatchMatMul";
 constexpr char kRank[] = "Rank";
 constexpr char kShape[] = "Shape";
@@ -96,8 +99,23 @@ constexpr char kReadVariablesOp[] = "_ReadVariablesOp";
 
 static const Costs::Duration kMinComputeTime(1);
 
+// Tensors move between the host and a VE by DMA over PCIe Gen3 x16, which
+// sustains about 11GB/s once a transfer has been set up. Setting one up through
+// VEO takes a few microseconds.
+constexpr double kVEPCIeGBPerSec = 11;
+static const Costs::Duration kVEDmaLatency(5000);
+// Kernels are launched on a VE in batches of VEOAsync calls, so each kernel
+// only pays its share of the round trip of a batch.
+static const Costs::Duration kVEKernelLaunchOverhead(1000);
+
 namespace {
 
+bool IsVEDevice(const string& device_name) {
+  DeviceNameUtils::ParsedName parsed;
+  return DeviceNameUtils::ParseFullName(device_name, &parsed) &&
+         parsed.type == "VE";
+}
+
 string GetDataFormat(const OpInfo& op_info) {
   string data_format = "NHWC";  // Default format.
   if (op_info.attr().find("data_format") != op_info.attr().end()) {
@@ -342,7 +360,7 @@ OpLevelCostEstimator::OpLevelCostEstimator() {
   device_cost_impl_.emplace(kRecv,
                             wrap(&OpLevelCostEstimator::PredictIdentity));
   device_cost_impl_.emplace(kSend,
-                            wrap(&OpLevelCostEstimator::PredictIdentity));
+                            wrap(&OpLevelCostEstimator::PredictSend));
   device_cost_impl_.emplace(kSwitch,
                             wrap(&OpLevelCostEstimator::PredictIdentity));
   device_cost_impl_.emplace(kMerge,
@@ -537,6 +555,17 @@ DeviceInfo OpLevelCostEstimator::GetDeviceInfo(
     } else {
       gb_per_sec = 100;
     }
+  } else if (device.type() == "VE") {
+    // Each VE core has three FMA pipes of 32 lanes working on packed pairs of
+    // floats.
+    const int kVEMacsPerCycle = 192;
+    gflops = device.num_cores() * device.frequency() * 1e-3 * kVEMacsPerCycle *
+             kOpsPerMac;
+    if (device.bandwidth() > 0) {
+      gb_per_sec = device.bandwidth() / 1e6;
+    } else {
+      gb_per_sec = 1200;
+    }
   }
   VLOG(1) << "Device: " << device.type() << " gflops: " << gflops
           << " gb_per_sec: " << gb_per_sec;
@@ -623,6 +652,9 @@ Costs OpLevelCostEstimator::PredictOpCountBasedCost(
   }
 
   Costs::NanoSeconds compute_cost(std::ceil(operations / device_info.gigaops));
+  if (op_info.device().type() == "VE") {
+    compute_cost += kVEKernelLaunchOverhead;
+  }
   VLOG(1) << "Op:" << op_info.op() << " GOps:" << operations / 1e9
           << " Compute Time (ns):" << compute_cost.count();
 
@@ -1571,6 +1603,36 @@ Costs OpLevelCostEstimator::PredictIdentity(const OpContext& op_context) const {
   return result;
 }
 
+Costs OpLevelCostEstimator::PredictSend(const OpContext& op_context) const {
+  const auto& op_info = op_context.op_info;
+  const auto& attr = op_info.attr();
+  const auto send_device = attr.find(kAttrSendDevice);
+  const auto recv_device = attr.find(kAttrRecvDevice);
+  if (send_device == attr.end() || recv_device == attr.end()) {
+    return PredictIdentity(op_context);
+  }
+  const bool from_ve = IsVEDevice(send_device->second.s());
+  const bool to_ve = IsVEDevice(recv_device->second.s());
+  if (!from_ve && !to_ve) {
+    return PredictIdentity(op_context);
+  }
+
+  // The transfer is charged to the _Send; the matching _Recv stays free. A
+  // tensor going from one VE to another is staged through host memory.
+  const int num_copies = from_ve && to_ve ? 2 : 1;
+  Costs result = Costs::ZeroCosts();
+  const double bytes = CalculateOutputSize(op_info, &result.inaccurate);
+  result.max_memory = bytes;
+  result.num_ops_with_unknown_shapes = result.inaccurate;
+  result.compute_time =
+      num_copies * (kVEDmaLatency +
+                    Costs::NanoSeconds(std::ceil(bytes / kVEPCIeGBPerSec)));
+  result.execution_time = result.compute_time;
+  VLOG(1) << "Op:" << op_info.op() << " Size (KB):" << bytes / 1e3
+          << " VE Transfer Time (ns):" << result.execution_time.count();
+  return result;
+}
+
 Costs OpLevelCostEstimator::PredictVariable(const OpContext& op_context) const {
   const auto& op_info = op_context.op_info;
   VLOG(1) << "Op:" << op_info.op() << " Execution Time 0 (ns)";
@@ -73,6 +73,7 @@ class OpLevelCostEstimator {
   Costs PredictSparseTensorDenseMatMul(const OpContext& op_context) const;
   Costs PredictNoOp(const OpContext& op_context) const;
   Costs PredictIdentity(const OpContext& op_context) const;
+  Costs PredictSend(const OpContext& op_context) const;
   Costs PredictVariable(const OpContext& op_context) const;
   Costs PredictBatchMatMul(const OpContext& op_context) const;
   Costs PredictMetadata(const OpContext& op_context) const;
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/utils.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/device_properties.pb.h"
 
@@ -584,6 +585,45 @@ TEST_F(OpLevelCostEstimatorTest, TestPersistentOpCosts) {
   }
 }
 
+TEST_F(OpLevelCostEstimatorTest, TestVETransferCosts) {
+  OpContext op_context;
+  op_context.op_info.mutable_device()->set_type("Channel");
+  op_context.op_info.set_op("_Send");
+  DescribeArbitraryRankOutput({1000, 1000}, DT_FLOAT, &op_context.op_info);
+  auto& attr = *op_context.op_info.mutable_attr();
+
+  // Transfers between host devices are free.
+  attr["send_device"].set_s("/job:localhost/replica:0/task:0/device:CPU:0");
+  attr["recv_device"].set_s("/job:localhost/replica:0/task:0/device:CPU:1");
+  auto cost = estimator_.PredictCosts(op_context);
+  EXPECT_EQ(Costs::Duration(1), cost.execution_time);
+
+  // 4MB over PCIe at 11GB/s, plus the DMA setup.
+  attr["recv_device"].set_s("/job:localhost/replica:0/task:0/device:VE:0");
+  cost = estimator_.PredictCosts(op_context);
+  EXPECT_EQ(Costs::Duration(368637), cost.execution_time);
+  EXPECT_EQ(4000000, cost.max_memory);
+  EXPECT_FALSE(cost.inaccurate);
+
+  // VE to VE goes through the host.
+  attr["send_device"].set_s("/job:localhost/replica:0/task:0/device:VE:1");
+  cost = estimator_.PredictCosts(op_context);
+  EXPECT_EQ(Costs::Duration(2 * 368637), cost.execution_time);
+}
+
+TEST_F(OpLevelCostEstimatorTest, TestVEKernelLaunchOverhead) {
+  OpContext op_context;
+  DescribeArbitraryRankInput({16}, DT_FLOAT, &op_context.op_info);
+  DescribeArbitraryRankOutput({16}, DT_FLOAT, &op_context.op_info);
+  op_context.op_info.set_op("Relu");
+  *op_context.op_info.mutable_device() = GetLocalVEInfo(0);
+
+  // A tiny kernel on a VE is bound by its launch overhead.
+  auto cost = estimator_.PredictCosts(op_context);
+  EXPECT_LE(Costs::Duration(1000), cost.compute_time);
+  EXPECT_LE(Costs::Duration(1000), cost.execution_time);
+}
+
 TEST_F(OpLevelCostEstimatorTest, TestGatherCosts) {
   OpContext op_context;
   SetCpuDevice(&op_context.op_info);
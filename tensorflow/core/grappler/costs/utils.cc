@@ -250,6 +250,8 @@ DeviceProperties GetDeviceInfo(const string& device_str) {
       return GetLocalGPUInfo(platform_gpu_id);
     } else if (parsed.type == "CPU") {
       return GetLocalCPUInfo();
+    } else if (parsed.type == "VE") {
+      return GetLocalVEInfo(parsed.id);
     }
   }
   return unknown;
@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/env_var.h"
 
@@ -834,7 +835,7 @@ DataTypeSet AllowedDataTypes(const OpDef& op_def, const TypeAttrId& t_attr_id) {
 }
 
 NodeDef BuildCastNode(const MutableGraphView::OutputPort& src, bool to_fp16,
-                      const string& device) {
+                      DataType target_dtype, const string& device) {
   const char* cast_string = to_fp16 ? kCastToFp16 : kCastToFp32;
   string name = strings::StrCat(src.node->name(), "-", src.port_id, "-",
                                 cast_string, "-", kSuffix);
@@ -843,8 +844,8 @@ NodeDef BuildCastNode(const MutableGraphView::OutputPort& src, bool to_fp16,
   node.set_op("Cast");
   node.set_device(device);
   node.add_input(strings::StrCat(src.node->name(), ":", src.port_id));
-  (*node.mutable_attr())["SrcT"].set_type(to_fp16 ? DT_FLOAT : DT_HALF);
-  (*node.mutable_attr())["DstT"].set_type(to_fp16 ? DT_HALF : DT_FLOAT);
+  (*node.mutable_attr())["SrcT"].set_type(to_fp16 ? DT_FLOAT : target_dtype);
+  (*node.mutable_attr())["DstT"].set_type(to_fp16 ? target_dtype : DT_FLOAT);
   (*node.mutable_attr())["Truncate"].set_b(false);
   return node;
 }
@@ -934,8 +935,12 @@ class AutoMixedPrecisionImpl {
  public:
   AutoMixedPrecisionImpl(Cluster* cluster,
                          const std::unordered_set<string>& nodes_to_preserve,
-                         GraphDef* graph, string id)
-      : virtual_placer_(cluster->GetDevices()),
+                         GraphDef* graph, string id,
+                         AutoMixedPrecisionMode mode)
+      : mode_(mode),
+        target_dtype_(mode == AutoMixedPrecisionMode::CUDA ? DT_HALF
+                                                           : DT_BFLOAT16),
+        virtual_placer_(cluster->GetDevices()),
         nodes_to_preserve_(nodes_to_preserve),
         graph_(graph),
         id_(id),
@@ -956,13 +961,14 @@ class AutoMixedPrecisionImpl {
   Status PrintDebugLogs(bool preop, size_t timestamp);
   void LogSkippedNode(const NodeDef& node) const;
   bool MustPreserve(const NodeDef& node) const;
-  bool IsOnGPU(const NodeDef& node) const;
+  bool IsOnDevice(const NodeDef& node, const string& device_type) const;
   bool IsOnSuitableGPUArch(const NodeDef& node) const;
+  bool IsOnSuitableDevice(const NodeDef& node) const;
   bool ShouldProcess(const NodeDef& node) const;
-  bool NodeHasFP16KernelForTypeAttr(const NodeDef& node, TypeAttrId taid) const;
+  bool NodeHasF16KernelForTypeAttr(const NodeDef& node, TypeAttrId taid) const;
   bool NodeImplicitlyReadsNonResourceVariable(const NodeDef& node) const;
   void ConvertBatchNormOpsToV2();
-  bool SupportsFloat16(const NodeTypeId& node_type) const;
+  bool SupportsF16(const NodeTypeId& node_type) const;
   const NodeDef* GetTailOfChain(
       const NodeDef& node, const absl::flat_hash_set<string>& match_ops) const;
   Status AddDataStructureOpsToMap(
@@ -989,6 +995,9 @@ class AutoMixedPrecisionImpl {
       absl::flat_hash_set<int>* white_set) const;
   Status ChangeTypeAttrsAndAddCasts(const absl::flat_hash_set<int>& white_set);
 
+  const AutoMixedPrecisionMode mode_;
+  // DT_HALF or DT_BFLOAT16, depending on the mode.
+  const DataType target_dtype_;
   VirtualPlacer virtual_placer_;
   std::unordered_set<string> nodes_to_preserve_;
   GraphDef* graph_;
@@ -1006,14 +1015,14 @@ class AutoMixedPrecisionImpl {
   absl::flat_hash_set<const NodeDef*> should_process_nodes_;
 };
 
-bool AutoMixedPrecisionImpl::NodeHasFP16KernelForTypeAttr(
+bool AutoMixedPrecisionImpl::NodeHasF16KernelForTypeAttr(
     const NodeDef& node, TypeAttrId taid) const {
   NodeDef node_copy(node);
   if (node.device().empty()) {
     string device_name = virtual_placer_.get_canonical_device_name(node);
     node_copy.set_device(device_name);
   }
-  if (!SetDataType(&node_copy, taid, DataType::DT_HALF)) {
+  if (!SetDataType(&node_copy, taid, target_dtype_)) {
     return false;
   }
   return IsKernelRegisteredForNode(node_copy).ok();
@@ -1050,8 +1059,7 @@ Status AutoMixedPrecisionImpl::PrintDebugLogs(bool preop, size_t timestamp) {
                          strings::StrCat("paintbuckets", suffix, ".txt"));
     f.open(fname.c_str(), std::fstream::out);
     f << "WhiteList:\n";
-    for (auto x :
-         AutoMixedPrecisionLists::WhiteList(cuda_version_, cudnn_version_)) {
+    for (auto x : fp16_whitelist_) {
       f << x << "\n";
     }
     f << "\nBlackList:\n";
@@ -1075,16 +1083,16 @@ Status AutoMixedPrecisionImpl::PrintDebugLogs(bool preop, size_t timestamp) {
 void AutoMixedPrecisionImpl::LogSkippedNode(const NodeDef& node) const {
   VLOG(2) << "Skipping " << node.op() << " node " << node.name()
           << " because it "
-          << (MustPreserve(node)
-                  ? "must be preserved"
-                  : "is not on the GPU, or the GPU arch is not suitable");
+          << (MustPreserve(node) ? "must be preserved"
+                                 : "is not on a suitable device");
 }
 
 bool AutoMixedPrecisionImpl::MustPreserve(const NodeDef& node) const {
   return nodes_to_preserve_.count(node.name());
 }
 
-bool AutoMixedPrecisionImpl::IsOnGPU(const NodeDef& node) const {
+bool AutoMixedPrecisionImpl::IsOnDevice(const NodeDef& node,
+                                        const string& device_type) const {
   string device_name;
   if (node.device().empty()) {
     device_name = virtual_placer_.get_canonical_device_name(node);
@@ -1095,7 +1103,7 @@ bool AutoMixedPrecisionImpl::IsOnGPU(const NodeDef& node) const {
   string not_used;
   if (DeviceNameUtils::SplitDeviceName(device_name, &not_used, &device) &&
       absl::StrContains(absl::AsciiStrToLower(device),
-                        absl::AsciiStrToLower(DEVICE_GPU))) {
+                        absl::AsciiStrToLower(device_type))) {
     return true;
   }
   return false;
@@ -1140,15 +1148,14 @@ bool IsFloat32(const NodeTypeId& node_type) {
          DataType::DT_FLOAT;
 }
 
-bool AutoMixedPrecisionImpl::SupportsFloat16(
-    const NodeTypeId& node_type) const {
+bool AutoMixedPrecisionImpl::SupportsF16(const NodeTypeId& node_type) const {
   const OpDef* op_def;
   Status status =
       OpRegistry::Global()->LookUpOpDef(node_type.node->op(), &op_def);
   if (!status.ok()) return false;
   return AllowedDataTypes(*op_def, node_type.type_attr)
-             .Contains(DataType::DT_HALF) &&
-         NodeHasFP16KernelForTypeAttr(*node_type.node, node_type.type_attr);
+             .Contains(target_dtype_) &&
+         NodeHasF16KernelForTypeAttr(*node_type.node, node_type.type_attr);
 }
 
 // TODO(mconley): Make this change the node's name (to aid debugging). Need to
@@ -1189,6 +1196,21 @@ bool ShouldIgnorePerformance() {
   return is_enabled;
 }
 
+bool AutoMixedPrecisionImpl::IsOnSuitableDevice(const NodeDef& node) const {
+  if (mode_ == AutoMixedPrecisionMode::CUDA) {
+    return IsOnDevice(node, DEVICE_GPU) &&
+           (ShouldIgnorePerformance() || IsOnSuitableGPUArch(node));
+  }
+  if (IsOnDevice(node, DEVICE_CPU)) {
+    // Without AVX512-BF16, bfloat16 kernels convert to float internally and
+    // are slower than the float ones.
+    return ShouldIgnorePerformance() ||
+           port::TestCPUFeature(port::CPUFeature::AVX512_BF16);
+  }
+  // Only the ops with bfloat16 VE kernels are converted.
+  return IsOnDevice(node, "VE");
+}
+
 Status AutoMixedPrecisionImpl::Optimize() {
   string optimization_level;
   TF_RETURN_IF_ERROR(ReadStringFromEnvVar(
@@ -1197,7 +1219,9 @@ Status AutoMixedPrecisionImpl::Optimize() {
   force_all_fp16_ = optimization_level == "UNSAFE_FORCE_ALL";
 
   fp16_whitelist_ =
-      AutoMixedPrecisionLists::WhiteList(cuda_version_, cudnn_version_);
+      mode_ == AutoMixedPrecisionMode::CUDA
+          ? AutoMixedPrecisionLists::WhiteList(cuda_version_, cudnn_version_)
+          : AutoMixedPrecisionLists::BF16WhiteList();
   fp16_blacklist_ = AutoMixedPrecisionLists::BlackList();
   fp16_graylist_ = AutoMixedPrecisionLists::GrayList();
   fp16_clearlist_ = AutoMixedPrecisionLists::ClearList();
@@ -1209,8 +1233,7 @@ Status AutoMixedPrecisionImpl::Optimize() {
 
   VLOG(2) << "Identifying nodes that should be processed";
   for (const NodeDef& node : graph_->node()) {
-    if (!MustPreserve(node) && IsOnGPU(node) &&
-        (ShouldIgnorePerformance() || IsOnSuitableGPUArch(node))) {
+    if (!MustPreserve(node) && IsOnSuitableDevice(node)) {
       should_process_nodes_.insert(&node);
     } else {
       LogSkippedNode(node);
@@ -1516,7 +1539,7 @@ void AutoMixedPrecisionImpl::AddClearAndGrayToWhiteIfBetweenWhite(
                   // TODO(benbarsdell): Consider allowing propagation through
                   // ops that are already float16 in order to reduce the number
                   // of casts.
-                  IsFloat32(item) && SupportsFloat16(item) &&
+                  IsFloat32(item) && SupportsF16(item) &&
                   (fp16_clearlist_.count(item.node->op()) ||
                    fp16_graylist_.count(item.node->op())));
         }),
@@ -1570,7 +1593,7 @@ void AutoMixedPrecisionImpl::PropagateWhiteThroughClear(
           return idx == root_idx ||
                  (!white_set->count(idx) && !black_set.count(idx) &&
                   ShouldProcess(*item.node) && IsFloat32(item) &&
-                  SupportsFloat16(item) &&
+                  SupportsF16(item) &&
                   (fp16_clearlist_.count(item.node->op())) &&
                   // We don't propagate (backwards) through nodes that read
                   // Variables because it can break the behavior of TensorBoard
@@ -1786,9 +1809,9 @@ void AutoMixedPrecisionImpl::MakeCastsWhiteIfAllOutputsWhite(
   }
 }
 
-// Changes all white-painted type attributes to DT_HALF, and inserts Cast nodes
-// at node outputs for all edges that connect white-painted <->
-// non-white-painted type attributes.
+// Changes all white-painted type attributes to the target type (DT_HALF or
+// DT_BFLOAT16), and inserts Cast nodes at node outputs for all edges that
+// connect white-painted <-> non-white-painted type attributes.
 Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
     const absl::flat_hash_set<int>& white_set) {
   int num_nodes_changed = 0;
@@ -1809,8 +1832,9 @@ Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
       bool src_is_white = white_set.count(node_type_idx);
       if (src_is_white) {
         VLOG(1) << "Changing type " << type_attr.DebugString() << " of "
-                << node->op() << " node " << node->name() << " to DT_HALF";
-        if (!SetDataType(node, type_attr, DT_HALF)) {
+                << node->op() << " node " << node->name() << " to "
+                << DataTypeString(target_dtype_);
+        if (!SetDataType(node, type_attr, target_dtype_)) {
           return errors::Internal("Failed to set type attribute");
         }
         ++num_nodes_changed;
@@ -1837,11 +1861,13 @@ Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
             if (!added_cast_node) {
               bool to_fp16 = dst_is_white;
               VLOG(1) << "Inserting cast to "
-                      << (to_fp16 ? "DT_HALF" : "DT_FLOAT") << " at "
+                      << DataTypeString(to_fp16 ? target_dtype_ : DT_FLOAT)
+                      << " at "
                       << src.node->op() << " " << src.node->name() << ":"
                       << src.port_id;
               added_cast_node = graph_view_.AddNode(
-                  BuildCastNode(src, to_fp16, src.node->device()));
+                  BuildCastNode(src, to_fp16, target_dtype_,
+                                src.node->device()));
               if (to_fp16 && !IsConstant(*node) && !IsVariable(*node) &&
                   !NodeImplicitlyReadsNonResourceVariable(*node)) {
                 ++num_nonvar_casts_to_fp16;
@@ -1855,8 +1881,10 @@ Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
     }
   }
   LOG(INFO) << "Converted " << num_nodes_changed << "/" << num_nodes_preop
-            << " nodes to float16 precision using " << num_nonvar_casts_to_fp16
-            << " cast(s) to float16 (excluding Const and Variable casts)";
+            << " nodes to " << DataTypeString(target_dtype_)
+            << " precision using " << num_nonvar_casts_to_fp16 << " cast(s) to "
+            << DataTypeString(target_dtype_)
+            << " (excluding Const and Variable casts)";
   return Status::OK();
 }
 
@@ -1874,6 +1902,21 @@ int GetNumGPUs(const Cluster& cluster,
   return num_gpus;
 }
 
+// Returns the number of devices the bfloat16 mode would convert nodes on.
+int GetNumBF16Devices(const Cluster& cluster) {
+  int num_devices = 0;
+  for (const auto& device : cluster.GetDevices()) {
+    const string& type = device.second.type();
+    if (type == "VE" ||
+        (type == "CPU" &&
+         (ShouldIgnorePerformance() ||
+          port::TestCPUFeature(port::CPUFeature::AVX512_BF16)))) {
+      num_devices++;
+    }
+  }
+  return num_devices;
+}
+
 }  // end namespace
 
 Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
@@ -1885,18 +1928,24 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
   // Start by copying input graph to output.
   *output = item.graph;
 
-  int num_gpus = ShouldIgnorePerformance() ? GetNumGPUs(*cluster)
-                                           : GetNumGPUs(*cluster, kMinGPUArch);
-  if (num_gpus < 1) {
-    // AutoMixedPrecision is currently only tuned for GPU.
-    LOG(WARNING) << "No (suitable) GPUs detected, skipping " << name()
-                 << " graph optimizer";
+  if (mode_ == AutoMixedPrecisionMode::CUDA) {
+    int num_gpus = ShouldIgnorePerformance()
+                       ? GetNumGPUs(*cluster)
+                       : GetNumGPUs(*cluster, kMinGPUArch);
+    if (num_gpus < 1) {
+      LOG(WARNING) << "No (suitable) GPUs detected, skipping " << name()
+                   << " graph optimizer";
+      return Status::OK();
+    }
+  } else if (GetNumBF16Devices(*cluster) < 1) {
+    VLOG(1) << "No CPUs with AVX512-BF16 or VEs detected, skipping " << name()
+            << " graph optimizer";
     return Status::OK();
   }
 
   // Optimize the output graph in-place.
   AutoMixedPrecisionImpl optimizer(cluster, item.NodesToPreserve(), output,
-                                   item.id);
+                                   item.id, mode_);
   if (item.id == "tf_graph") {
     LOG(INFO) << "Running " << name() << " graph optimizer";
   } else {
@@ -22,16 +22,30 @@ limitations under the License.
 namespace tensorflow {
 namespace grappler {
 
-// Convert data types to float16 where appropriate to improve performance on
-// GPUs.
+// Which devices to target and which reduced precision type to use.
+enum class AutoMixedPrecisionMode {
+  // float16 on NVIDIA GPUs.
+  CUDA,
+  // bfloat16 on CPUs with AVX512-BF16 and on VEs, wherever the device
+  // registers bfloat16 kernels.
+  BF16,
+};
+
+// Convert data types to float16 or bfloat16 where appropriate to improve
+// performance on the target devices.
 class AutoMixedPrecision : public GraphOptimizer {
  public:
   explicit AutoMixedPrecision(
-      RewriterConfig::Toggle opt_level = RewriterConfig::ON) {}
+      RewriterConfig::Toggle opt_level = RewriterConfig::ON,
+      AutoMixedPrecisionMode mode = AutoMixedPrecisionMode::CUDA)
+      : mode_(mode) {}
 
   ~AutoMixedPrecision() override {}
 
-  string name() const override { return "auto_mixed_precision"; };
+  string name() const override {
+    return mode_ == AutoMixedPrecisionMode::CUDA ? "auto_mixed_precision"
+                                                 : "auto_mixed_precision_bf16";
+  };
 
   bool UsesFunctionLibrary() const override { return false; }
 
@@ -40,6 +54,9 @@ class AutoMixedPrecision : public GraphOptimizer {
 
   void Feedback(Cluster* cluster, const GrapplerItem& item,
                 const GraphDef& optimize_output, double result) override;
+
+ private:
+  const AutoMixedPrecisionMode mode_;
 };
 
 }  // end namespace grappler
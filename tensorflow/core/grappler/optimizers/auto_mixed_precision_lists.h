@@ -97,6 +97,37 @@ class AutoMixedPrecisionLists {
     return list;
   }
 
+  // Returns the whitelist used when converting to bfloat16 on CPUs and VEs.
+  // Without tensor cores, only the ops dominated by multiply-accumulates gain
+  // enough to pay for the casts. The gray, black and clear lists are shared
+  // with float16, which has a narrower range than bfloat16.
+  static gtl::FlatSet<string> BF16WhiteList() {
+    string to_add, to_remove;
+    TF_CHECK_OK(ReadStringFromEnvVar(
+        "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_BF16_WHITELIST_ADD", "",
+        &to_add));
+    TF_CHECK_OK(ReadStringFromEnvVar(
+        "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_BF16_WHITELIST_REMOVE", "",
+        &to_remove));
+
+    auto list = gtl::FlatSet<string>{
+        "BatchMatMul",
+        "BatchMatMulV2",
+        "Conv2D",
+        "Conv2DBackpropFilter",
+        "Conv2DBackpropInput",
+        "Conv3D",
+        "Conv3DBackpropFilterV2",
+        "Conv3DBackpropInputV2",
+        "DepthwiseConv2dNative",
+        "DepthwiseConv2dNativeBackpropFilter",
+        "DepthwiseConv2dNativeBackpropInput",
+        "MatMul",
+    };
+    UpdateList(&list, to_add, to_remove);
+    return list;
+  }
+
   // Returns the set of ops that are considered numerically-safe (for execution
   // in fp16), but which may be made unsafe by an upstream blacklist op.
   static gtl::FlatSet<string> GrayList() {
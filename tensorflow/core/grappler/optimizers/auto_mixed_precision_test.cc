@@ -13,12 +13,6 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-// Currently, this test only passes when TensorFlow passes with CUDA, because
-// otherwise the optimizer will not turn clearlist nodes to float16. When
-// looking at clearlist nodes, this optimizer checks if the nodes have a float16
-// GPU OpKernel, but without CUDA there are no GPU OpKernels at all.
-#if GOOGLE_CUDA
-
 #include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 
 #include <utility>
@@ -37,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/cpu_info.h"
 
 // TODO(benbarsdell): Improve the numerical checks in these tests. The tests
 // were originally written only to check the graph coloring, so the graphs do
@@ -46,6 +41,12 @@ namespace tensorflow {
 namespace grappler {
 namespace {
 
+// Currently, the float16 tests only pass when TensorFlow passes with CUDA,
+// because otherwise the optimizer will not turn clearlist nodes to float16.
+// When looking at clearlist nodes, this optimizer checks if the nodes have a
+// float16 GPU OpKernel, but without CUDA there are no GPU OpKernels at all.
+#if GOOGLE_CUDA
+
 template <DataType DTYPE>
 Tensor GenerateIdentityMatrix(int64 height, int64 width) {
   typedef typename EnumToDataType<DTYPE>::Type T;
@@ -1074,8 +1075,59 @@ TEST_F(AutoMixedPrecisionTest, TanhOp) {
       });
 }
 
+#endif  // GOOGLE_CUDA
+
+class AutoMixedPrecisionBF16Test : public GrapplerTest {
+ protected:
+  void SetUp() override {
+    DeviceProperties device_properties;
+    device_properties.set_type("CPU");
+    virtual_cluster_.reset(
+        new VirtualCluster({{"/CPU:0", device_properties}}));
+    TF_CHECK_OK(virtual_cluster_->Provision());
+  }
+
+  void TearDown() override { TF_CHECK_OK(virtual_cluster_->Shutdown()); }
+
+  std::unique_ptr<Cluster> virtual_cluster_;
+};
+
+TEST_F(AutoMixedPrecisionBF16Test, MatMulOnCpu) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/CPU:0");
+  Output input = ops::Const(s.WithOpName("input"), 1.f / 32, {32, 32});
+  Output mm = ops::MatMul(s.WithOpName("mm"), input, input);
+  Output relu = ops::Relu(s.WithOpName("relu"), mm);
+  Output fetch = ops::Identity(s.WithOpName("fetch"), relu);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  AutoMixedPrecision optimizer(RewriterConfig::ON,
+                               AutoMixedPrecisionMode::BF16);
+  EXPECT_EQ("auto_mixed_precision_bf16", optimizer.name());
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(virtual_cluster_.get(), item, &output));
+
+  VLOG(1) << output.DebugString();
+
+  GraphView output_view(&output);
+  if (!port::TestCPUFeature(port::CPUFeature::AVX512_BF16)) {
+    // bfloat16 would be slower than float on this CPU.
+    EXPECT_EQ(item.graph.node_size(), output.node_size());
+    EXPECT_EQ(DT_FLOAT, output_view.GetNode("mm")->attr().at("T").type());
+    return;
+  }
+  EXPECT_EQ(item.graph.node_size() + 2, output.node_size());
+  EXPECT_EQ(DT_BFLOAT16, output_view.GetNode("mm")->attr().at("T").type());
+  EXPECT_EQ(DT_BFLOAT16, output_view.GetNode("relu")->attr().at("T").type());
+  EXPECT_EQ(DT_FLOAT, output_view.GetNode("fetch")->attr().at("T").type());
+  const NodeDef* cast =
+      output_view.GetNode("relu-0-CastToFp32-AutoMixedPrecision");
+  ASSERT_NE(nullptr, cast);
+  EXPECT_EQ(DT_BFLOAT16, cast->attr().at("SrcT").type());
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
-
-#endif  // GOOGLE_CUDA
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/function_optimizer.h"
 
+#include <algorithm>
+#include <map>
+#include <numeric>
 #include <vector>
 
 #include "absl/algorithm/container.h"
@@ -450,6 +453,131 @@ FunctionDefLibrary PruneFunctionLibrary(const FunctionLibraryDefinition& flib,
   return pruned_flib.ToProto();
 }
 
+// FunctionDefsEqual ignores argument attributes and resource argument ids, but
+// two functions that differ in them can't be used interchangeably.
+bool ArgAttrsEqual(const FunctionDef& f1, const FunctionDef& f2) {
+  if (f1.arg_attr_size() != f2.arg_attr_size()) return false;
+  for (const auto& arg : f1.arg_attr()) {
+    auto it = f2.arg_attr().find(arg.first);
+    if (it == f2.arg_attr().end()) return false;
+    const auto& attrs1 = arg.second.attr();
+    const auto& attrs2 = it->second.attr();
+    if (attrs1.size() != attrs2.size()) return false;
+    for (const auto& attr : attrs1) {
+      auto attr_it = attrs2.find(attr.first);
+      if (attr_it == attrs2.end() ||
+          !AreAttrValuesEqual(attr.second, attr_it->second)) {
+        return false;
+      }
+    }
+  }
+  const std::map<uint32, uint32> ids1(f1.resource_arg_unique_id().begin(),
+                                      f1.resource_arg_unique_id().end());
+  const std::map<uint32, uint32> ids2(f2.resource_arg_unique_id().begin(),
+                                      f2.resource_arg_unique_id().end());
+  return ids1 == ids2;
+}
+
+void RenameFunctions(const absl::flat_hash_map<string, string>& renames,
+                     AttrValue* attr) {
+  const auto rename = [&renames](NameAttrList* func) {
+    auto it = renames.find(func->name());
+    if (it != renames.end()) func->set_name(it->second);
+    for (auto& func_attr : *func->mutable_attr()) {
+      RenameFunctions(renames, &func_attr.second);
+    }
+  };
+  if (attr->has_func()) {
+    rename(attr->mutable_func());
+  } else if (attr->has_list()) {
+    for (NameAttrList& func : *attr->mutable_list()->mutable_func()) {
+      rename(&func);
+    }
+  }
+}
+
+// Rewrites direct and indirect calls from `node` to the functions in `renames`.
+void RenameFunctions(const absl::flat_hash_map<string, string>& renames,
+                     NodeDef* node) {
+  auto it = renames.find(node->op());
+  if (it != renames.end()) node->set_op(it->second);
+  for (auto& attr : *node->mutable_attr()) {
+    RenameFunctions(renames, &attr.second);
+  }
+}
+
+// Merges functions in the `graph` library that have identical signatures and
+// bodies, and differ only in their names, into the one with the smallest name.
+// Merging callees can make their callers identical, so this repeats
+// until no duplicates are left. Functions with a registered gradient, or used
+// as one, are kept as they are. Returns the number of functions removed.
+int DedupFunctionLibrary(GraphDef* graph) {
+  FunctionDefLibrary* library = graph->mutable_library();
+
+  absl::flat_hash_set<string> has_gradient;
+  for (const GradientDef& grad : library->gradient()) {
+    has_gradient.insert(grad.function_name());
+    has_gradient.insert(grad.gradient_func());
+  }
+
+  int num_removed = 0;
+  absl::flat_hash_map<string, string> renames;
+  do {
+    renames.clear();
+
+    // Function definitions with the signature name cleared, bucketed by hash.
+    std::vector<FunctionDef> anonymous(library->function_size());
+    absl::flat_hash_map<uint64, std::vector<int>> buckets;
+    // The library order is arbitrary, visit functions by name instead to pick
+    // the same representative every time.
+    std::vector<int> order(library->function_size());
+    std::iota(order.begin(), order.end(), 0);
+    absl::c_sort(order, [library](int a, int b) {
+      return library->function(a).signature().name() <
+             library->function(b).signature().name();
+    });
+    for (int i : order) {
+      const FunctionDef& func = library->function(i);
+      if (has_gradient.contains(func.signature().name())) continue;
+
+      anonymous[i] = func;
+      anonymous[i].mutable_signature()->clear_name();
+      std::vector<int>& bucket = buckets[FunctionDefHash(anonymous[i])];
+      const auto is_duplicate = [&](int j) {
+        return FunctionDefsEqual(anonymous[i], anonymous[j]) &&
+               ArgAttrsEqual(anonymous[i], anonymous[j]);
+      };
+      auto it = absl::c_find_if(bucket, is_duplicate);
+      if (it == bucket.end()) {
+        bucket.push_back(i);
+      } else {
+        renames[func.signature().name()] =
+            library->function(*it).signature().name();
+      }
+    }
+    if (renames.empty()) break;
+
+    auto* functions = library->mutable_function();
+    functions->erase(
+        std::remove_if(functions->begin(), functions->end(),
+                       [&renames](const FunctionDef& func) {
+                         return renames.contains(func.signature().name());
+                       }),
+        functions->end());
+    for (NodeDef& node : *graph->mutable_node()) {
+      RenameFunctions(renames, &node);
+    }
+    for (FunctionDef& func : *functions) {
+      for (NodeDef& node : *func.mutable_node_def()) {
+        RenameFunctions(renames, &node);
+      }
+    }
+    num_removed += renames.size();
+  } while (true);
+
+  return num_removed;
+}
+
 // Push all constant inputs of an instantiating node into the function body.
 Status PushDownConstInputs(const NodeDef& func_node,
                            const FunctionOptimizerContext& ctx,
@@ -1463,6 +1591,11 @@ Status FunctionOptimizer::RunFunctionOptimizerPass(
   // Prune unreachable function from the library.
   *optimized_graph->mutable_library() =
       PruneFunctionLibrary(ctx.function_library(), *optimized_graph);
+  // Share one copy of structurally identical functions. This also merges
+  // specializations that pushed down the same constants.
+  const int num_deduped = DedupFunctionLibrary(optimized_graph);
+  VLOG(3) << "Deduplicated function library: " << num_deduped
+          << " functions removed";
 
   return Status::OK();
 }
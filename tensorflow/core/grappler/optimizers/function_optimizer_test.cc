@@ -2097,5 +2097,66 @@ TEST_F(FunctionOptimizerTest, PruningUselessLibraryFunctions) {
             "XTimesTwo_specialized_for_y_at_test_graph");
 }
 
+TEST_F(FunctionOptimizerTest, DedupIdenticalLibraryFunctions) {
+  using test::function::NDef;
+  FunctionOptimizer optimizer(RewriterConfig::DEFAULT, true);
+
+  // Two copies of the same function that differ only in their names, and two
+  // callers that become identical once their callees are merged.
+  const auto make_inner = [](const string& name) {
+    FunctionDef func = FunctionDefHelper::Create(
+        name, {"x:float", "y:float"}, {"z:float"}, {},
+        {{{"output"}, "Mul", {"x", "y"}, {{"T", DT_FLOAT}}}},
+        {{"z", "output:z:0"}});
+    (*func.mutable_attr())["_noinline"].set_b(true);
+    return func;
+  };
+  const auto make_outer = [](const string& name, const string& inner) {
+    FunctionDef func = FunctionDefHelper::Create(
+        name, {"x:float", "y:float"}, {"z:float"}, {},
+        {{{"inner"}, inner, {"x", "y"}, {}}}, {{"z", "inner:z:0"}});
+    (*func.mutable_attr())["_noinline"].set_b(true);
+    return func;
+  };
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("y", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("a", "OuterA", {"x", "y"}, {}, kDevice),
+       NDef("b", "OuterB", {"x", "y"}, {}, kDevice)},
+      {make_inner("InnerA"), make_inner("InnerB"),
+       make_outer("OuterA", "InnerA"), make_outer("OuterB", "InnerB")});
+  item.fetch = {"a", "b"};
+
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  ASSERT_EQ(2, output.library().function_size());
+  FunctionLibraryDefinition flib(OpRegistry::Global(), output.library());
+  ASSERT_NE(nullptr, flib.Find("InnerA"));
+  const FunctionDef* outer = flib.Find("OuterA");
+  ASSERT_NE(nullptr, outer);
+  EXPECT_EQ("InnerA", outer->node_def(0).op());
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if ((node.name() == "a" || node.name() == "b") && ++found) {
+      EXPECT_EQ("OuterA", node.op());
+    }
+  }
+  EXPECT_EQ(2, found);
+
+  Tensor pi = test::AsScalar<float>(3.14f);
+  item.feed = {{"x", pi}, {"y", pi}};
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized = item.WithGraph(std::move(output));
+  auto tensors = EvaluateFetchNodes(optimized);
+  ASSERT_EQ(tensors_expected.size(), tensors.size());
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+  test::ExpectTensorEqual<float>(tensors_expected[1], tensors[1]);
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
@@ -69,6 +69,17 @@ inline std::pair<int, int> GetNumGPUs(const Cluster& cluster) {
   return {num_gpus, num_volta};
 }
 
+inline int GetNumVEs(const Cluster& cluster) {
+  auto devices = cluster.GetDevices();
+  int num_ves = 0;
+  for (const auto& device : devices) {
+    if (device.second.type() == kVE) {
+      num_ves++;
+    }
+  }
+  return num_ves;
+}
+
 inline bool NumConv2DOnDeviceWithDataTypeOverThreshold(
     const TransposeContext& context, absl::string_view device,
     const DataType& data_type) {
@@ -402,10 +413,13 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
   }
   const auto num_gpus_and_num_volta = GetNumGPUs(*cluster);
   const int num_gpus = num_gpus_and_num_volta.first;
-  if (num_gpus < 1) {
+  // VE kernels only implement NCHW convolutions and pooling, so graphs placed
+  // on VE are converted to NCHW when there is no GPU to tune for.
+  const int num_ves = num_gpus < 1 ? GetNumVEs(*cluster) : 0;
+  if (num_gpus < 1 && num_ves < 1) {
     return errors::Aborted(
-        "No GPUs found: GenericLayoutOptimizer is currently only tuned for "
-        "GPU.");
+        "No GPUs or VEs found: GenericLayoutOptimizer is currently only tuned "
+        "for GPU and VE.");
   }
 
   const bool is_aggressive = opt_level_ == RewriterConfig::AGGRESSIVE;
@@ -414,10 +428,14 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
   TF_RETURN_IF_ERROR(
       TransposeContext::InitializeTransposeContext(item, cluster, &context));
 
-  const auto src_dst_formats =
-      GetSrcAndDstDataFormats(context, num_gpus, num_gpus_and_num_volta.second);
-  context.AssignDeviceAndDataFormats(kGPU, src_dst_formats.first,
-                                     src_dst_formats.second);
+  if (num_gpus > 0) {
+    const auto src_dst_formats = GetSrcAndDstDataFormats(
+        context, num_gpus, num_gpus_and_num_volta.second);
+    context.AssignDeviceAndDataFormats(kGPU, src_dst_formats.first,
+                                       src_dst_formats.second);
+  } else {
+    context.AssignDeviceAndDataFormats(kVE, kNHWC, kNCHW);
+  }
 
   TransposerFactory transposer_factory;
   TF_RETURN_IF_ERROR(ExpandLayoutSensitiveOp(&context, &transposer_factory));
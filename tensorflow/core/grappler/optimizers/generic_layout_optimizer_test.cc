@@ -311,6 +311,34 @@ TEST_F(GenericLayoutOptimizerTest, CPUDevice) {
   VerifyDataFormatAttributeMatch(conv_node, "NHWC");
 }
 
+TEST_F(GenericLayoutOptimizerTest, VEDevice) {
+  DeviceProperties cpu_device;
+  cpu_device.set_type("CPU");
+  DeviceProperties ve_device;
+  ve_device.set_type("VE");
+  VirtualCluster cluster({{"/CPU:0", cpu_device}, {"/VE:0", ve_device}});
+  TF_ASSERT_OK(cluster.Provision());
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto conv =
+      SimpleConv2D(&s, 4, 2, "VALID", "/job:w/replica:0/task:0/device:VE:0");
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {conv});
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GenericLayoutOptimizer optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(&cluster, item, &output));
+
+  Status status;
+  utils::GraphView graph_view(&output, &status);
+  TF_ASSERT_OK(status);
+  auto* conv_node = graph_view.GetNode("Conv2D");
+  ASSERT_NE(conv_node, nullptr);
+  VerifyDataFormatAttributeMatch(conv_node, "NCHW");
+  TF_ASSERT_OK(cluster.Shutdown());
+}
+
 TEST_F(GenericLayoutOptimizerTest, Connectivity) {
 #if !GOOGLE_CUDA
   GTEST_SKIP() << "CUDA is not enabled";
@@ -0,0 +1,228 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/grouped_apply_optimizer.h"
+
+#include <map>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/frame.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// An optimizer op that can be grouped, and the grouped op replacing it. Inputs
+// marked as shared (learning rate, momentum, ...) must be the same tensor in
+// all grouped ops and are passed once. The others are passed once per
+// variable, in the order of the original inputs.
+struct GroupableOp {
+  const char* op;
+  const char* grouped_op;
+  std::vector<bool> shared_inputs;
+};
+
+const std::vector<GroupableOp>& GroupableOps() {
+  static const std::vector<GroupableOp>* ops = new std::vector<GroupableOp>{
+      // var, alpha, delta
+      {"ResourceApplyGradientDescent", "_ResourceGroupedApplyGradientDescent",
+       {false, true, false}},
+      // var, accum, lr, grad, momentum
+      {"ResourceApplyMomentum", "_ResourceGroupedApplyMomentum",
+       {false, false, true, false, true}},
+  };
+  return *ops;
+}
+
+const GroupableOp* FindGroupableOp(const NodeDef& node) {
+  for (const GroupableOp& op : GroupableOps()) {
+    if (node.op() == op.op) return &op;
+  }
+  return nullptr;
+}
+
+bool IsCandidate(const NodeDef& node, const FrameView& frame_view,
+                 const std::unordered_set<string>& nodes_to_preserve) {
+  const GroupableOp* op = FindGroupableOp(node);
+  if (op == nullptr) return false;
+  if (!NodeIsOnVe(&node)) return false;
+  if (nodes_to_preserve.count(node.name()) > 0) return false;
+  if (frame_view.IsInFrame(node)) return false;
+  return NumNonControlInputs(node) == op->shared_inputs.size();
+}
+
+// Ops in the same group may be merged: same op, device and attributes, and
+// the same shared inputs.
+string GroupKey(const NodeDef& node) {
+  const GroupableOp* op = FindGroupableOp(node);
+  std::vector<string> parts = {node.op(), node.device()};
+  for (const char* attr : {"T", "use_locking", "use_nesterov"}) {
+    auto it = node.attr().find(attr);
+    if (it != node.attr().end()) {
+      parts.push_back(strings::StrCat(attr, "=", it->second.DebugString()));
+    }
+  }
+  for (int i = 0; i < op->shared_inputs.size(); ++i) {
+    if (op->shared_inputs[i]) parts.push_back(node.input(i));
+  }
+  return absl::StrJoin(parts, ";");
+}
+
+}  // namespace
+
+Status GroupedApplyOptimizer::Optimize(Cluster* cluster,
+                                       const GrapplerItem& item,
+                                       GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+
+  FrameView frame_view;
+  TF_RETURN_IF_ERROR(frame_view.InferFromGraph(*optimized_graph));
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+
+  std::vector<int> candidates;
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    if (IsCandidate(optimized_graph->node(i), frame_view, nodes_to_preserve)) {
+      candidates.push_back(i);
+    }
+  }
+  if (candidates.size() < 2) return Status::OK();
+
+  NodeMap node_map(optimized_graph);
+
+  // Collect everything that runs after some candidate. A candidate that is
+  // one of these nodes, or reads one of them, cannot be merged with the
+  // others without creating a cycle.
+  absl::flat_hash_set<const NodeDef*> descendants;
+  std::vector<const NodeDef*> queue;
+  for (int i : candidates) {
+    for (const NodeDef* fanout :
+         node_map.GetOutputs(optimized_graph->node(i).name())) {
+      queue.push_back(fanout);
+    }
+  }
+  while (!queue.empty()) {
+    const NodeDef* node = queue.back();
+    queue.pop_back();
+    if (!descendants.insert(node).second) continue;
+    for (const NodeDef* fanout : node_map.GetOutputs(node->name())) {
+      queue.push_back(fanout);
+    }
+  }
+
+  // Use an ordered map so that the rewritten graph is deterministic.
+  std::map<string, std::vector<int>> groups;
+  for (int i : candidates) {
+    const NodeDef& node = optimized_graph->node(i);
+    if (descendants.contains(&node)) continue;
+    bool reads_descendant = false;
+    for (const string& input : node.input()) {
+      const NodeDef* input_node = node_map.GetNode(NodeName(input));
+      if (input_node != nullptr && descendants.contains(input_node)) {
+        reads_descendant = true;
+        break;
+      }
+    }
+    if (reads_descendant) continue;
+    groups[GroupKey(node)].push_back(i);
+  }
+
+  std::set<int> nodes_to_delete;
+  for (const auto& group : groups) {
+    const std::vector<int>& members = group.second;
+    if (members.size() < 2) continue;
+
+    const NodeDef& first = optimized_graph->node(members[0]);
+    const GroupableOp* op = FindGroupableOp(first);
+
+    NodeDef grouped;
+    grouped.set_name(AddPrefixToNodeName(first.name(), "GroupedApply"));
+    grouped.set_op(op->grouped_op);
+    grouped.set_device(first.device());
+    for (const char* attr : {"T", "use_locking", "use_nesterov"}) {
+      auto it = first.attr().find(attr);
+      if (it != first.attr().end()) {
+        (*grouped.mutable_attr())[attr] = it->second;
+      }
+    }
+    (*grouped.mutable_attr())["N"].set_i(members.size());
+
+    for (int k = 0; k < op->shared_inputs.size(); ++k) {
+      if (op->shared_inputs[k]) {
+        grouped.add_input(first.input(k));
+        continue;
+      }
+      for (int i : members) {
+        grouped.add_input(optimized_graph->node(i).input(k));
+      }
+    }
+
+    std::set<string> control_inputs;
+    for (int i : members) {
+      const NodeDef& node = optimized_graph->node(i);
+      for (int k = op->shared_inputs.size(); k < node.input_size(); ++k) {
+        control_inputs.insert(node.input(k));
+      }
+    }
+    for (const string& control_input : control_inputs) {
+      grouped.add_input(control_input);
+    }
+
+    // Consumers of the original updates now depend on the grouped update.
+    const string grouped_control = AsControlDependency(grouped.name());
+    for (int i : members) {
+      const string control =
+          AsControlDependency(optimized_graph->node(i).name());
+      for (NodeDef* fanout :
+           node_map.GetOutputs(optimized_graph->node(i).name())) {
+        bool has_grouped_control = false;
+        for (const string& input : fanout->input()) {
+          if (input == grouped_control) has_grouped_control = true;
+        }
+        auto* inputs = fanout->mutable_input();
+        for (int k = inputs->size() - 1; k >= 0; --k) {
+          if (inputs->Get(k) != control) continue;
+          if (has_grouped_control) {
+            inputs->SwapElements(k, inputs->size() - 1);
+            inputs->RemoveLast();
+          } else {
+            *inputs->Mutable(k) = grouped_control;
+            has_grouped_control = true;
+          }
+        }
+      }
+      nodes_to_delete.insert(i);
+    }
+
+    VLOG(2) << "Grouped " << members.size() << " " << op->op << " ops into "
+            << grouped.name();
+    *optimized_graph->add_node() = std::move(grouped);
+  }
+
+  EraseNodesFromGraph(nodes_to_delete, optimized_graph);
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
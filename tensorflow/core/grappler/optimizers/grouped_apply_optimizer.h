@@ -0,0 +1,51 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_GROUPED_APPLY_OPTIMIZER_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_GROUPED_APPLY_OPTIMIZER_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Replaces the per-variable optimizer updates placed on a VE with one grouped
+// update per device, e.g. N ResourceApplyGradientDescent ops sharing the same
+// learning rate become a single _ResourceGroupedApplyGradientDescent. This
+// saves one kernel dispatch and one round of variable locking per variable
+// and step.
+class GroupedApplyOptimizer : public GraphOptimizer {
+ public:
+  GroupedApplyOptimizer() {}
+  explicit GroupedApplyOptimizer(RewriterConfig::Toggle opt_level) {}
+
+  ~GroupedApplyOptimizer() override {}
+
+  string name() const override { return "grouped_apply_optimizer"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_GROUPED_APPLY_OPTIMIZER_H_
@@ -0,0 +1,118 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/grouped_apply_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class GroupedApplyOptimizerTest : public GrapplerTest {
+ protected:
+  // Builds `num_vars` ResourceApplyGradientDescent updates on `device`,
+  // followed by a "train" NoOp depending on all of them. Every update uses
+  // "alpha" unless `distinct_alpha` is set.
+  GrapplerItem MakeItem(const string& device, int num_vars,
+                        bool distinct_alpha) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(device);
+    Output alpha = ops::Const(s.WithOpName("alpha"), 0.1f, {});
+    std::vector<Operation> updates;
+    for (int i = 0; i < num_vars; ++i) {
+      Output var = ops::VarHandleOp(s.WithOpName(strings::StrCat("var_", i)),
+                                    DT_FLOAT, {2, 2});
+      Output grad = ops::Const(s.WithOpName(strings::StrCat("grad_", i)),
+                               1.0f, {2, 2});
+      Output lr = alpha;
+      if (distinct_alpha) {
+        lr = ops::Const(s.WithOpName(strings::StrCat("alpha_", i)), 0.1f, {});
+      }
+      updates.push_back(ops::ResourceApplyGradientDescent(
+          s.WithOpName(strings::StrCat("apply_", i)), var, lr, grad));
+    }
+    ops::NoOp(s.WithOpName("train").WithControlDependencies(updates));
+
+    GrapplerItem item;
+    item.fetch = {"train"};
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  }
+};
+
+TEST_F(GroupedApplyOptimizerTest, GroupsUpdatesOnVE) {
+  GrapplerItem item = MakeItem("/device:VE:0", 3, false);
+
+  GroupedApplyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  string grouped_name;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.op(), "ResourceApplyGradientDescent");
+    if (node.op() == "_ResourceGroupedApplyGradientDescent") {
+      grouped_name = node.name();
+      EXPECT_EQ(node.attr().at("N").i(), 3);
+      ASSERT_EQ(node.input_size(), 7);
+      EXPECT_EQ(node.input(0), "var_0");
+      EXPECT_EQ(node.input(1), "var_1");
+      EXPECT_EQ(node.input(2), "var_2");
+      EXPECT_EQ(node.input(3), "alpha");
+      EXPECT_EQ(node.input(4), "grad_0");
+      EXPECT_EQ(node.input(5), "grad_1");
+      EXPECT_EQ(node.input(6), "grad_2");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  const NodeDef* train = nullptr;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "train") train = &node;
+  }
+  ASSERT_NE(train, nullptr);
+  ASSERT_EQ(train->input_size(), 1);
+  EXPECT_EQ(train->input(0), AsControlDependency(grouped_name));
+}
+
+TEST_F(GroupedApplyOptimizerTest, KeepsUpdatesWithDistinctAlpha) {
+  GrapplerItem item = MakeItem("/device:VE:0", 3, true);
+
+  GroupedApplyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  CompareGraphs(item.graph, output);
+}
+
+TEST_F(GroupedApplyOptimizerTest, KeepsUpdatesOnCPU) {
+  GrapplerItem item = MakeItem("/device:CPU:0", 3, false);
+
+  GroupedApplyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  CompareGraphs(item.graph, output);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
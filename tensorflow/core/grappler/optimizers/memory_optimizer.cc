@@ -440,9 +440,112 @@ void RecomputeSubgraph(
   }
 }
 
+// Selects nodes whose outputs to recompute on every device where the
+// estimated peak memory usage exceeds the memory size. Like checkpointing
+// algorithms, the activations live at the peak are taken in increasing order of
+// compute time per byte until the savings cover the excess.
+std::unordered_set<string> SelectNodesToRecomputeForMemory(
+    Cluster* cluster, const GrapplerItem& item, const NodeMap& node_map,
+    const std::function<bool(const NodeDef&)>& is_candidate,
+    const std::function<bool(const NodeDef&)>& is_target) {
+  std::unordered_set<string> selected;
+  const std::unordered_map<string, DeviceProperties>& devices =
+      cluster->GetDevices();
+  GraphMemory memory(item);
+  Status s = memory.InferStatically(devices);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer memory usage: " << s.error_message();
+    return selected;
+  }
+
+  std::unordered_map<string, int64> compute_times;
+  {
+    VirtualCluster vcluster(devices);
+    if (!vcluster.Provision().ok() || !vcluster.Initialize(item).ok()) {
+      return selected;
+    }
+    RunMetadata metadata;
+    s = vcluster.Run(item.graph, item.feed, item.fetch, &metadata);
+    if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
+      return selected;
+    }
+    for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
+      for (const auto& node_stats : dev_stats.node_stats()) {
+        compute_times.emplace(node_stats.node_name(),
+                              node_stats.op_end_rel_nanos() -
+                                  node_stats.op_start_rel_nanos());
+      }
+    }
+  }
+
+  for (const auto& device : devices) {
+    const string& name = device.first;
+    const DeviceProperties& prop = device.second;
+    if (prop.type() != "GPU" && prop.type() != "VE") {
+      continue;
+    }
+    if (prop.memory_size() <= 0) {
+      VLOG(1) << "Peak memory usage unknown for device " << name;
+      continue;
+    }
+    const GraphMemory::MemoryUsage& mem_usage = memory.GetPeakMemoryUsage(name);
+    if (mem_usage.used_memory <= prop.memory_size()) {
+      continue;
+    }
+    const int64 required_savings = mem_usage.used_memory - prop.memory_size();
+
+    // Only activations which are read again by a target node are shortened by
+    // recomputing them.
+    std::unordered_map<string, int64> live_bytes;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      const NodeDef* node = node_map.GetNode(live_tensor.node);
+      if (node == nullptr || selected.count(node->name()) > 0 ||
+          !is_candidate(*node) || !IsFreeOfSideEffect(*node)) {
+        continue;
+      }
+      live_bytes[node->name()] += live_tensor.memory_used;
+    }
+    std::vector<std::pair<double, string>> candidates;
+    for (const auto& live : live_bytes) {
+      const NodeDef* node = node_map.GetNode(live.first);
+      bool has_target_output = false;
+      for (const NodeDef* output : node_map.GetOutputs(node->name())) {
+        has_target_output |= is_target(*output);
+      }
+      bool has_target_input = false;
+      for (const string& input_name : node->input()) {
+        const NodeDef* input_node = node_map.GetNode(input_name);
+        has_target_input |= input_node != nullptr && is_target(*input_node);
+      }
+      if (!has_target_output || has_target_input || live.second <= 0) {
+        continue;
+      }
+      auto it = compute_times.find(live.first);
+      const int64 compute_time = it == compute_times.end() ? 0 : it->second;
+      candidates.emplace_back(static_cast<double>(compute_time) / live.second,
+                              live.first);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    int64 savings = 0;
+    for (const auto& candidate : candidates) {
+      if (savings >= required_savings) {
+        break;
+      }
+      selected.insert(candidate.second);
+      savings += live_bytes[candidate.second];
+    }
+    VLOG(1) << "Recomputing " << selected.size() << " nodes to save " << savings
+            << " of the " << required_savings << " bytes over the memory of "
+            << name;
+  }
+  return selected;
+}
+
 void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                                 const string& recomputation_targets_name_scope,
-                                GraphDef* graph, const GrapplerItem& item) {
+                                Cluster* cluster, GraphDef* graph,
+                                const GrapplerItem& item) {
   // The topological numberings and NodeMap will be stale as soon as we start
   // modifying the graph in RecomputeSubgraph. However, RecomputeSubgraph only
   // looks up nodes which were in the original graph, and preserves the graph
@@ -494,6 +597,23 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                  node.attr().count(kRecomputeHint) > 0;
         },
         is_target);
+  } else if (optimization_level ==
+                 RewriterConfig::MEMORY_DRIVEN_RECOMPUTATION &&
+             cluster != nullptr && !item.fetch.empty()) {
+    const std::unordered_set<string> nodes_to_recompute =
+        SelectNodesToRecomputeForMemory(
+            cluster, item, node_map,
+            [&feeds, &is_target](const NodeDef& node) {
+              return !is_target(node) && feeds.count(node.name()) == 0 &&
+                     !IsPersistent(node) && !IsControlFlow(node);
+            },
+            is_target);
+    recomputed_subgraphs = GetOpGroupsToRecompute(
+        graph, node_map,
+        [&nodes_to_recompute](const NodeDef& node) {
+          return nodes_to_recompute.count(node.name()) > 0;
+        },
+        is_target);
   }
   if (!recomputed_subgraphs.empty()) {
     std::unordered_map<const NodeDef*, int> topological_numbering;
@@ -739,12 +859,16 @@ Status BuildSwapPair(NodeDef* node, int input_to_swap,
                      const std::unordered_map<string, const NodeDef*>& name_map,
                      GraphDef* graph,
                      std::pair<NodeDef*, NodeDef*>* swap_pair) {
+  // VE memory is swapped through the DMA path of the VE device context.
+  DeviceNameUtils::ParsedName parsed;
+  const bool on_ve = DeviceNameUtils::ParseFullName(node->device(), &parsed) &&
+                     parsed.has_type && parsed.type == DEVICE_VE;
   string task, device;
   if (!DeviceNameUtils::SplitDeviceName(node->device(), &task, &device) ||
-      !absl::StrContains(device, DEVICE_GPU)) {
+      (!on_ve && !absl::StrContains(device, DEVICE_GPU))) {
     return errors::InvalidArgument("Can't swap input ", input_to_swap,
                                    " of node ", node->name(),
-                                   " since it is not on GPU");
+                                   " since it is not on GPU or VE");
   }
   const OpDef* op_def;
   TF_RETURN_IF_ERROR(OpRegistry::Global()->LookUpOpDef(node->op(), &op_def));
@@ -769,12 +893,12 @@ Status BuildSwapPair(NodeDef* node, int input_to_swap,
   // Force the tensor to be copied to cpu.
   NodeDef* swap_out_node = graph->add_node();
   swap_out_node->set_name(swap_out_name);
-  swap_out_node->set_op("_CopyFromGpuToHost");
+  swap_out_node->set_op(on_ve ? "_CopyFromVEToHost" : "_CopyFromGpuToHost");
 
   // Force the tensor to be restored to the device.
   NodeDef* swap_in_node = graph->add_node();
   swap_in_node->set_name(swap_in_name);
-  swap_in_node->set_op("_CopyFromHostToGpu");
+  swap_in_node->set_op(on_ve ? "_CopyFromHostToVE" : "_CopyFromHostToGpu");
   *swap_in_node->add_input() = swap_out_node->name();
 
   // Colocate the swap_out_ and swap_in_ nodes with the node itself.
@@ -988,7 +1112,7 @@ static bool IdentifySwappingCandidates(
   for (const auto& device : devices) {
     const string& name = device.first;
     const DeviceProperties& prop = device.second;
-    if (prop.type() != "GPU") {
+    if (prop.type() != "GPU" && prop.type() != "VE") {
       continue;
     }
     if (prop.memory_size() <= 0) {
@@ -1376,7 +1500,8 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   bool run_recomputation_pass =
       (optimization_level_ == RewriterConfig::RECOMPUTATION_HEURISTICS ||
        optimization_level_ == RewriterConfig::HEURISTICS ||
-       optimization_level_ == RewriterConfig::MANUAL);
+       optimization_level_ == RewriterConfig::MANUAL ||
+       optimization_level_ == RewriterConfig::MEMORY_DRIVEN_RECOMPUTATION);
   if (!run_recomputation_pass && nodes_to_relax.empty() && item.fetch.empty()) {
     return errors::Aborted("Nothing to do.");
   }
@@ -1386,7 +1511,7 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
 
   if (run_recomputation_pass) {
     RecomputationRewritingPass(optimization_level_,
-                               recomputation_targets_name_scope_,
+                               recomputation_targets_name_scope_, cluster,
                                &optimized_item.graph, item);
   }
 
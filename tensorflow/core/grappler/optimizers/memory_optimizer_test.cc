@@ -448,6 +448,51 @@ TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   }
 }
 
+TEST_F(MemoryOptimizerTest, MemoryDrivenRecomputation) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v = ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  Output a = ops::Square(s.WithOpName("a").WithDevice("/gpu:0"), v);
+  Output b = ops::Sqrt(s.WithOpName("b").WithDevice("/gpu:0"), a);
+  Output c = ops::Exp(s.WithOpName("c").WithDevice("/gpu:0"), b);
+  Output d = ops::AddN(s.WithOpName("gradients/d").WithDevice("/gpu:0"), {c});
+  Output e =
+      ops::AddN(s.WithOpName("gradients/e").WithDevice("/gpu:0"), {d, b});
+  Output f =
+      ops::AddN(s.WithOpName("gradients/f").WithDevice("/gpu:0"), {e, a});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/f"};
+
+  // The activations don't fit in the 1MB of the GPU.
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  MemoryOptimizer optimizer(RewriterConfig::MEMORY_DRIVEN_RECOMPUTATION);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  int num_recomputed = 0;
+  for (const auto& node : output.node()) {
+    if (node.name().find("Recomputed/") == 0) {
+      ++num_recomputed;
+      EXPECT_NE("Recomputed/v", node.name());
+      // Recomputations wait for the gradients to need them.
+      EXPECT_EQ('^', node.input(node.input_size() - 1)[0]);
+    }
+  }
+  EXPECT_LT(0, num_recomputed);
+
+  // Nothing is recomputed when the activations fit.
+  DeviceProperties gpu_device = cluster->GetDevices().at(
+      "/job:localhost/replica:0/task:0/gpu:0");
+  gpu_device.set_memory_size(1024 * 1024 * 1024);
+  std::unordered_map<string, DeviceProperties> devices = cluster->GetDevices();
+  devices["/job:localhost/replica:0/task:0/gpu:0"] = gpu_device;
+  VirtualCluster roomy_cluster(devices);
+  TF_EXPECT_OK(optimizer.Optimize(&roomy_cluster, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
 class RelaxAllocatorConstraintsTest : public GrapplerTest {};
 
 TEST_F(RelaxAllocatorConstraintsTest, SameDevice) {
@@ -15,11 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include <deque>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/versions.pb.h"
@@ -34,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/function_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/grouped_apply_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/implementation_selector.h"
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
@@ -48,9 +53,15 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/grappler/utils/tpu.h"
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
 
@@ -86,7 +97,8 @@ int NumIterations(const RewriterConfig& cfg) {
 // Check if optimizer is allowed to run only once.
 bool IsRunOnceOptimizer(const string& name) {
   return name == "layout" || name == "memory_optimizer" ||
-         name == "loop_optimizer" || name == "auto_mixed_precision";
+         name == "loop_optimizer" || name == "auto_mixed_precision" ||
+         name == "auto_mixed_precision_bf16";
 }
 
 // Creates a function library stub from a real function library: copy only
@@ -161,6 +173,168 @@ bool MemoryOptimizerEnabled(
   return mem_opt_type != RewriterConfig::NO_MEM_OPT;
 }
 
+// Returns the number of threads used to optimize the bodies of the functions
+// in a function library, as set by TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS.
+int NumFunctionOptimizationThreads() {
+  int64 num_threads = 1;
+  Status s = ReadInt64FromEnvVar("TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS",
+                                 /*default_val=*/1, &num_threads);
+  if (!s.ok()) {
+    LOG(WARNING) << s;
+    return 1;
+  }
+  return std::max<int64>(num_threads, 1);
+}
+
+// Maximum number of optimized graphs kept by the in-memory result cache.
+constexpr size_t kMaxCachedResults = 64;
+
+// Returns whether RunMetaOptimizer may reuse the result of an earlier run on
+// identical inputs, as set by TF_GRAPPLER_RESULT_CACHE.
+bool ResultCacheEnabled() {
+  bool enabled = false;
+  Status s = ReadBoolFromEnvVar("TF_GRAPPLER_RESULT_CACHE",
+                                /*default_val=*/false, &enabled);
+  if (!s.ok()) {
+    LOG(WARNING) << s;
+    return false;
+  }
+  return enabled;
+}
+
+// Returns the directory in which the result cache also persists optimized
+// graphs, as set by TF_GRAPPLER_RESULT_CACHE_DIR, or an empty string.
+string ResultCacheDir() {
+  string dir;
+  Status s = ReadStringFromEnvVar("TF_GRAPPLER_RESULT_CACHE_DIR",
+                                  /*default_val=*/"", &dir);
+  if (!s.ok()) {
+    LOG(WARNING) << s;
+    return "";
+  }
+  return dir;
+}
+
+// Returns a key that identifies everything that the result of
+// RunMetaOptimizer depends on: the item, the configuration and whether a CPU
+// device for constant folding was provided.
+string ResultCacheKey(const GrapplerItem& item, const ConfigProto& cfg,
+                      const DeviceBase* cpu_device) {
+  string serialized;
+  SerializeToStringDeterministic(item.graph, &serialized);
+  string config;
+  SerializeToStringDeterministic(cfg, &config);
+  strings::StrAppend(&serialized, config);
+  for (const auto& feed : item.feed) {
+    TensorProto proto;
+    feed.second.AsProtoTensorContent(&proto);
+    string value;
+    SerializeToStringDeterministic(proto, &value);
+    strings::StrAppend(&serialized, "\nfeed:", feed.first, ":", value);
+  }
+  for (const string& fetch : item.fetch) {
+    strings::StrAppend(&serialized, "\nfetch:", fetch);
+  }
+  for (const string& init_op : item.init_ops) {
+    strings::StrAppend(&serialized, "\ninit:", init_op);
+  }
+  for (const string& keep_op : item.keep_ops) {
+    strings::StrAppend(&serialized, "\nkeep:", keep_op);
+  }
+  std::vector<string> devices(item.devices().begin(), item.devices().end());
+  std::sort(devices.begin(), devices.end());
+  for (const string& device : devices) {
+    strings::StrAppend(&serialized, "\ndevice:", device);
+  }
+  const auto& options = item.optimization_options();
+  strings::StrAppend(&serialized, "\noptions:",
+                     options.allow_non_differentiable_rewrites,
+                     options.allow_pruning_stateful_and_dataset_ops,
+                     options.optimize_function_library, options.is_eager_mode,
+                     cpu_device != nullptr);
+  const Fprint128 fingerprint = Fingerprint128(serialized);
+  return strings::StrCat(strings::Hex(fingerprint.high64, strings::kZeroPad16),
+                         strings::Hex(fingerprint.low64, strings::kZeroPad16));
+}
+
+// Caches optimized graphs in memory, and optionally in a directory, so that
+// processes that repeatedly load the same model skip re-optimizing it.
+class ResultCache {
+ public:
+  static ResultCache* Global() {
+    static ResultCache* cache = new ResultCache();
+    return cache;
+  }
+
+  bool Lookup(const string& key, GraphDef* optimized_graph) {
+    {
+      mutex_lock l(mu_);
+      auto it = results_.find(key);
+      if (it != results_.end()) {
+        *optimized_graph = it->second;
+        return true;
+      }
+    }
+    const string dir = ResultCacheDir();
+    if (dir.empty()) {
+      return false;
+    }
+    GraphDef graph;
+    if (!ReadBinaryProto(Env::Default(), Filename(dir, key), &graph).ok()) {
+      return false;
+    }
+    *optimized_graph = graph;
+    Insert(key, std::move(graph));
+    return true;
+  }
+
+  void Add(const string& key, const GraphDef& optimized_graph) {
+    Insert(key, optimized_graph);
+    const string dir = ResultCacheDir();
+    if (dir.empty()) {
+      return;
+    }
+    // Write to a temporary file first so that concurrent readers never see
+    // a partially written graph.
+    const string filename = Filename(dir, key);
+    const string tmp_filename = strings::StrCat(
+        filename, "-tmp-", Env::Default()->NowMicros());
+    Status s = Env::Default()->RecursivelyCreateDir(dir);
+    if (s.ok()) {
+      s = WriteBinaryProto(Env::Default(), tmp_filename, optimized_graph);
+    }
+    if (s.ok()) {
+      s = Env::Default()->RenameFile(tmp_filename, filename);
+    }
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to persist optimized graph in " << dir << ": "
+                   << s;
+    }
+  }
+
+ private:
+  static string Filename(const string& dir, const string& key) {
+    return io::JoinPath(dir, strings::StrCat(key, ".grappler.pb"));
+  }
+
+  void Insert(const string& key, GraphDef graph) {
+    mutex_lock l(mu_);
+    if (results_.count(key) != 0) {
+      return;
+    }
+    if (results_.size() >= kMaxCachedResults) {
+      results_.erase(insertion_order_.front());
+      insertion_order_.pop_front();
+    }
+    results_.emplace(key, std::move(graph));
+    insertion_order_.push_back(key);
+  }
+
+  mutex mu_;
+  absl::flat_hash_map<string, GraphDef> results_ GUARDED_BY(mu_);
+  std::deque<string> insertion_order_ GUARDED_BY(mu_);
+};
+
 }  // namespace
 
 #define MK_OPT(NAME, VALUE) \
@@ -183,6 +357,9 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
   MK_OPT("layout", new GenericLayoutOptimizer());
   MK_OPT("auto_mixed_precision",
          new AutoMixedPrecision(cfg_.auto_mixed_precision()));
+  MK_OPT("auto_mixed_precision_bf16",
+         new AutoMixedPrecision(cfg_.auto_mixed_precision_bf16(),
+                                AutoMixedPrecisionMode::BF16));
   MK_OPT("memory", new MemoryOptimizer(RewriterConfig::MANUAL));
   MK_OPT("arithmetic", new ArithmeticOptimizer(cfg_.arithmetic_optimization()));
   MK_OPT("autoparallel", new AutoParallel(cfg_.auto_parallel().num_replicas()));
@@ -194,6 +371,8 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
                                       cfg_.scoped_allocator_opts()));
   MK_OPT("pin_to_host",
          new PinToHostOptimizer(cfg_.pin_to_host_optimization()));
+  MK_OPT("grouped_apply",
+         new GroupedApplyOptimizer(cfg_.grouped_apply_optimization()));
 
   return std::unique_ptr<GraphOptimizer>();
 }
@@ -238,6 +417,10 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(
         MakeUnique<AutoMixedPrecision>(cfg_.auto_mixed_precision()));
   }
+  if (AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_bf16())) {
+    optimizers->push_back(MakeUnique<AutoMixedPrecision>(
+        cfg_.auto_mixed_precision_bf16(), AutoMixedPrecisionMode::BF16));
+  }
   if (cfg_.pin_to_host_optimization() == RewriterConfig::ON) {
     optimizers->push_back(MakeUnique<PinToHostOptimizer>());
   }
@@ -280,6 +463,10 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(MakeUnique<ScopedAllocatorOptimizer>(
         cfg_.scoped_allocator_optimization(), cfg_.scoped_allocator_opts()));
   }
+  if (cfg_.grouped_apply_optimization() != RewriterConfig::OFF) {
+    optimizers->push_back(MakeUnique<GroupedApplyOptimizer>(
+        cfg_.grouped_apply_optimization()));
+  }
   return InitializeCustomGraphOptimizers(std::set<string>(), optimizers);
 }
 
@@ -501,7 +688,10 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
                                    }) != optimization_result.results.end();
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.push_back(optimization_result);
+  }
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -581,10 +771,47 @@ Status MetaOptimizer::RunOptimizer(
   return Status::OK();
 }
 
+Status MetaOptimizer::OptimizeFunctionBody(Cluster* cluster, bool is_tpu_graph,
+                                           GrapplerFunctionItem* func_item,
+                                           GraphDef* optimized_func_graph) {
+  GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+  if (is_tpu_graph) {
+    // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+    // passes do not handle TPU functions correctly in a variety of ways
+    // (Note that due to the pre-placement TPU graph rewriting passes, the
+    // TPU-related ops are encapsulated away into functions). For example,
+    // TPU graphs contain TPUReplicateMetadata node that carries relevant
+    // TPU metadata and Grappler passes could prune that away. Grappler
+    // passes could also cause issues around shape inference. Since the
+    // desired and existing behavior is to not optimize TPU functions with
+    // Grappler, this check preserves that. The only execption is
+    // implementation selector what is required to swap in some TPU specific
+    // lowering code and is verified the work correctly on TPUs.
+    ImplementationSelector implementation_selector;
+
+    // Implementation selector needs to have access to valid function
+    // signature and attributes, and it doesn't need actual function body.
+    FunctionDefLibrary func_item_function_library;
+    func_item_function_library.Swap(func_item->graph.mutable_library());
+    *func_item->graph.mutable_library() =
+        GetFunctionDefLibraryStub(func_item_function_library);
+
+    TF_RETURN_IF_ERROR(implementation_selector.Optimize(
+        cluster, *func_item, optimized_func_graph));
+  } else {
+    TF_RETURN_IF_ERROR(
+        OptimizeGraph(cluster, *func_item, optimized_func_graph));
+  }
+  return Status::OK();
+}
+
 Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                GraphDef* optimized_graph) {
   VLOG(1) << "Starting optimization for grappler item: " << item.id;
-  optimization_results_.clear();
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.clear();
+  }
 
   // Constructs a FunctionLibraryDefinition with functions that are reachable
   // from the nodes of the graph.
@@ -669,9 +896,97 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   bool optimize_function_library =
       item.optimization_options().optimize_function_library;
 
+  // Makes a GrapplerItem from a FunctionDef.
+  const auto make_func_item = [&](const FunctionDef& func,
+                                  GrapplerFunctionItem* func_item) -> Status {
+    const string& func_name = func.signature().name();
+    TF_RETURN_IF_ERROR(MakeGrapplerFunctionItem(
+        func, flib, trimmed_item.graph.versions().producer(), func_item));
+
+    // If we need to compute the gradient of optimized function at runtime, we
+    // can't perform non-differentiable rewrites.
+    func_item->optimization_options().allow_non_differentiable_rewrites =
+        !differentiable_functions.contains(func_name);
+
+    // Device set available to the function is defined only by the runtime,
+    // when we instantiate and execute the function. We can't use all devices
+    // available to the main graph, because after partitioning the function
+    // call node might execute on a remote worker.
+    if (!func_item->devices().empty()) {
+      return errors::Internal("GrapplerFunctionItem devices must be empty.");
+    }
+
+    // We are not allowed to prune certain types of ops from the graph
+    // instantiated by the function definition, because we must guarantee
+    // function execution semantics wrt side effects (see
+    // function_optimizer.cc).
+    func_item->optimization_options().allow_pruning_stateful_and_dataset_ops =
+        false;
+
+    // TODO(b/129545186): Shape inference in GraphProperties doesn't work well
+    // with _Arg nodes. Replace them with Placeholders with unknown shape.
+    absl::flat_hash_set<absl::string_view> input_nodes;
+    for (auto& input_arg : func_item->inputs()) {
+      input_nodes.insert(input_arg.node_name);
+    }
+    for (NodeDef& func_node : *func_item->graph.mutable_node()) {
+      if (input_nodes.contains(func_node.name())) {
+        func_node.set_op("Placeholder");
+        auto& attrs = *func_node.mutable_attr();
+        attrs["dtype"] = attrs["T"];
+        attrs.erase("index");
+        attrs.erase("T");
+        TensorShapeProto unknown_shape;
+        unknown_shape.set_unknown_rank(true);
+        *(attrs["shape"].mutable_shape()) = unknown_shape;
+      }
+    }
+    return Status::OK();
+  };
+
+  // Optimizes the body of a function item and records the time it took.
+  const auto optimize_func_body = [&](bool is_tpu_graph,
+                                      GrapplerFunctionItem* func_item,
+                                      GraphDef* optimized_func_graph) {
+    const uint64 start_us = Env::Default()->NowMicros();
+    Status s = OptimizeFunctionBody(cluster, is_tpu_graph, func_item,
+                                    optimized_func_graph);
+    const uint64 end_us = Env::Default()->NowMicros();
+    metrics::UpdateGrapplerPassTime("function_optimization", end_us - start_us);
+    VLOG(1) << "Optimized function " << func_item->id << " in "
+            << (end_us - start_us) / 1000.0f << "ms.";
+    return s;
+  };
+
+  // Replaces a function in the library by its optimized body.
+  const auto merge_func_body = [&](const string& func_name,
+                                   GrapplerFunctionItem* func_item,
+                                   GraphDef* optimized_func_graph) -> Status {
+    // Function body optimization might have created new specialized
+    // functions for each instantiation context. Add them to the library.
+    for (const FunctionDef& func_def :
+         optimized_func_graph->library().function()) {
+      if (flib.Find(func_def.signature().name()) == nullptr) {
+        TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+      }
+    }
+
+    // Convert optimized graph back to FunctionDef.
+    FunctionDef optimized_func;
+    func_item->SwapFunctionBody(std::move(*optimized_func_graph));
+    TF_RETURN_IF_ERROR(MakeFunctionDef(*func_item, flib, &optimized_func));
+
+    // Replace optimized function with a new FunctionDef.
+    return flib.ReplaceFunction(func_name, optimized_func);
+  };
+
   while (optimize_function_library) {
     optimize_function_library = false;
 
+    // Functions to optimize in this pass, in library order. They point into
+    // the library of optimized_graph, which is only replaced after the pass.
+    std::vector<const FunctionDef*> funcs;
+
     int function_idx = 0;
     for (const FunctionDef& func : optimized_graph->library().function()) {
       GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
@@ -699,97 +1014,55 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       // have to reset the flag and do at least one more pass over the library.
       optimize_function_library = true;
       optimized_funcs.insert(func_name);
+      funcs.push_back(&func);
+    }
 
-      // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
-      TF_RETURN_IF_ERROR(MakeGrapplerFunctionItem(
-          func, flib, trimmed_item.graph.versions().producer(), &func_item));
-
-      // If we need to compute the gradient of optimized function at runtime, we
-      // can't perform non-differentiable rewrites.
-      func_item.optimization_options().allow_non_differentiable_rewrites =
-          !differentiable_functions.contains(func_name);
-
-      // Device set available to the function is defined only by the runtime,
-      // when we instantiate and execute the function. We can't use all devices
-      // available to the main graph, because after partitioning the function
-      // call node might execute on a remote worker.
-      if (!func_item.devices().empty()) {
-        return errors::Internal("GrapplerFunctionItem devices must be empty.");
-      }
-
-      // We are not allowed to prune certain types of ops from the graph
-      // instantiated by the function definition, because we must guarantee
-      // function execution semantics wrt side effects (see
-      // function_optimizer.cc).
-      func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
-          false;
-
-      // TODO(b/129545186): Shape inference in GraphProperties doesn't work well
-      // with _Arg nodes. Replace them with Placeholders with unknown shape.
-      absl::flat_hash_set<absl::string_view> input_nodes;
-      for (auto& input_arg : func_item.inputs()) {
-        input_nodes.insert(input_arg.node_name);
+    const bool is_tpu_graph = IsTPUGraphDef(*optimized_graph);
+    const int num_threads =
+        std::min<int>(NumFunctionOptimizationThreads(), funcs.size());
+    if (num_threads > 1) {
+      // All the items are built up front, from the library as it was at the
+      // start of the pass, and their bodies optimized concurrently.
+      std::vector<GrapplerFunctionItem> func_items(funcs.size());
+      for (size_t i = 0; i < funcs.size(); ++i) {
+        TF_RETURN_IF_ERROR(make_func_item(*funcs[i], &func_items[i]));
       }
-      for (NodeDef& func_node : *func_item.graph.mutable_node()) {
-        if (input_nodes.contains(func_node.name())) {
-          func_node.set_op("Placeholder");
-          auto& attrs = *func_node.mutable_attr();
-          attrs["dtype"] = attrs["T"];
-          attrs.erase("index");
-          attrs.erase("T");
-          TensorShapeProto unknown_shape;
-          unknown_shape.set_unknown_rank(true);
-          *(attrs["shape"].mutable_shape()) = unknown_shape;
+      std::vector<GraphDef> optimized_func_graphs(funcs.size());
+      std::vector<Status> func_statuses(funcs.size());
+      {
+        thread::ThreadPool pool(Env::Default(),
+                                "grappler_function_optimization", num_threads);
+        BlockingCounter counter(funcs.size());
+        for (size_t i = 0; i < funcs.size(); ++i) {
+          pool.Schedule([&, i]() {
+            func_statuses[i] = optimize_func_body(
+                is_tpu_graph, &func_items[i], &optimized_func_graphs[i]);
+            counter.DecrementCount();
+          });
         }
+        counter.Wait();
       }
 
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (IsTPUGraphDef(*optimized_graph)) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only execption is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        FunctionDefLibrary func_item_function_library;
-        func_item_function_library.Swap(func_item.graph.mutable_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        TF_RETURN_IF_ERROR(
-            OptimizeGraph(cluster, func_item, &optimized_func_graph));
+      // Merge the results in library order, so that they do not depend on
+      // the order in which the functions finished.
+      for (size_t i = 0; i < funcs.size(); ++i) {
+        TF_RETURN_IF_ERROR(func_statuses[i]);
+        TF_RETURN_IF_ERROR(merge_func_body(funcs[i]->signature().name(),
+                                           &func_items[i],
+                                           &optimized_func_graphs[i]));
       }
-
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
-      for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
-        }
+    } else {
+      // One function at a time, so that only one item is alive at once and
+      // each item sees the functions optimized before it.
+      for (const FunctionDef* func : funcs) {
+        GrapplerFunctionItem func_item;
+        TF_RETURN_IF_ERROR(make_func_item(*func, &func_item));
+        GraphDef optimized_func_graph;
+        TF_RETURN_IF_ERROR(optimize_func_body(is_tpu_graph, &func_item,
+                                              &optimized_func_graph));
+        TF_RETURN_IF_ERROR(merge_func_body(func->signature().name(),
+                                           &func_item, &optimized_func_graph));
       }
-
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
-
-      // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
     }
 
     // If optimized at least one function, update the graph library.
@@ -811,6 +1084,7 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
 }
 
 void MetaOptimizer::PrintResult() {
+  mutex_lock l(optimization_results_mu_);
   for (const GraphOptimizationResult& graph_result : optimization_results_) {
     LOG(INFO) << "Optimization results for grappler item: " << graph_result.id;
     for (const OptimizerResult& result : graph_result.results) {
@@ -843,7 +1117,9 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
          rewrite_cfg.debug_stripper() == RewriterConfig::ON ||
          rewrite_cfg.scoped_allocator_optimization() == RewriterConfig::ON ||
          rewrite_cfg.pin_to_host_optimization() == RewriterConfig::ON ||
+         rewrite_cfg.grouped_apply_optimization() != RewriterConfig::OFF ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision()) ||
+         AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_bf16()) ||
          !rewrite_cfg.optimizers().empty() ||
          !rewrite_cfg.custom_optimizers().empty();
 }
@@ -851,10 +1127,23 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
 Status RunMetaOptimizer(const GrapplerItem& item, const ConfigProto& cfg,
                         DeviceBase* cpu_device, Cluster* cluster,
                         GraphDef* optimized_graph) {
+  string cache_key;
+  if (ResultCacheEnabled()) {
+    cache_key = ResultCacheKey(item, cfg, cpu_device);
+    if (ResultCache::Global()->Lookup(cache_key, optimized_graph)) {
+      VLOG(1) << "Reusing the cached optimization result for grappler item: "
+              << item.id;
+      return Status::OK();
+    }
+  }
   MetaOptimizer optimizer(cpu_device, cfg);
   optimizer.set_deadline_usec(
       DeadlineMicroSeconds(cfg.graph_options().rewrite_options()));
-  return optimizer.Optimize(cluster, item, optimized_graph);
+  TF_RETURN_IF_ERROR(optimizer.Optimize(cluster, item, optimized_graph));
+  if (!cache_key.empty()) {
+    ResultCache::Global()->Add(cache_key, *optimized_graph);
+  }
+  return Status::OK();
 }
 
 Status OptimizeGraph(
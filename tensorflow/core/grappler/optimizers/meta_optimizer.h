@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/verifiers/graph_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/protobuf/verifier_config.pb.h"
@@ -31,6 +32,8 @@ limitations under the License.
 namespace tensorflow {
 namespace grappler {
 
+class GrapplerFunctionItem;
+
 // Run the other grappler optimizers based on the specified rewriter config.
 class MetaOptimizer : public GraphOptimizer {
  public:
@@ -80,6 +83,13 @@ class MetaOptimizer : public GraphOptimizer {
   Status OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
                        GraphDef* optimized_graph);
 
+  // Optimizes the body of a function of the library of a graph (that is a TPU
+  // graph if `is_tpu_graph` is set). Bodies of different functions can be
+  // optimized concurrently.
+  Status OptimizeFunctionBody(Cluster* cluster, bool is_tpu_graph,
+                              GrapplerFunctionItem* func_item,
+                              GraphDef* optimized_func_graph);
+
   DeviceBase* const cpu_device_;  // may be NULL
   ConfigProto config_proto_;
   RewriterConfig& cfg_;
@@ -100,7 +110,9 @@ class MetaOptimizer : public GraphOptimizer {
                       GrapplerItem* optimized_item, GraphDef* optimized_graph,
                       GraphOptimizationResult* optimization_result);
 
-  std::vector<GraphOptimizationResult> optimization_results_;
+  mutex optimization_results_mu_;
+  std::vector<GraphOptimizationResult> optimization_results_
+      GUARDED_BY(optimization_results_mu_);
 };
 
 bool MetaOptimizerEnabled(const ConfigProto& cfg);
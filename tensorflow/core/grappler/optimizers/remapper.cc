@@ -47,17 +47,33 @@ namespace grappler {
 // MatMul + ... -> _FusedMatMul:
 //   (1) MatMul + BiasAdd + <Activation>
 //
+// MatMul with a constant right hand side -> _PrepackedMatMul (on CPU).
+//
+// GatherV2 + Mul + SegmentSum -> _SparseSegmentWeightedSum (on CPU).
+//
 // FusedBatchNorm[$is_training] + ... -> _FusedBatchNormEx[$is_training]
 //   (1) FusedBatchNorm + <Activation>
 //   (2) FusedBatchNorm + SideInput + <Activation>
 //
+// Pad + Conv2D -> Conv2D with explicit paddings (on VE).
+//
+// Mean + SquaredDifference + Mean + Rsqrt + Mul + Sub + Add of a layer
+// normalization -> _FusedLayerNorm (on VE, with TF_VE_FUSE_TRANSFORMER_OPS).
+//
+// [Mul +] Add + Softmax of masked attention scores -> _FusedMaskedSoftmax
+// (on VE, with TF_VE_FUSE_TRANSFORMER_OPS).
+//
 // Both Conv2D and MatMul implemented as Tensor contraction (on CPU), so all the
 // patterns are "ContractionWith...".
 namespace {
 
 constexpr char kFusedConv2D[] = "_FusedConv2D";
 constexpr char kFusedMatMul[] = "_FusedMatMul";
+constexpr char kPrepackedMatMul[] = "_PrepackedMatMul";
+constexpr char kSparseSegmentWeightedSum[] = "_SparseSegmentWeightedSum";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
+constexpr char kFusedLayerNorm[] = "_FusedLayerNorm";
+constexpr char kFusedMaskedSoftmax[] = "_FusedMaskedSoftmax";
 
 constexpr char kDataFormat[] = "data_format";
 constexpr char kIsTraining[] = "is_training";
@@ -160,6 +176,80 @@ struct ContractionWithBatchNormAndActivation {
   float epsilon = 0.0;
 };
 
+// Pad with constant paddings followed by a Conv2D.
+struct PadWithConv2D {
+  PadWithConv2D() = default;
+  PadWithConv2D(int pad, int conv2d) : pad(pad), conv2d(conv2d) {}
+
+  int pad = kMissingIndex;
+  int conv2d = kMissingIndex;
+  std::vector<int64> explicit_paddings;
+};
+
+// MatMul with a constant right hand side (weights of an inference graph).
+struct MatMulWithConstRhs {
+  MatMulWithConstRhs() = default;
+  explicit MatMulWithConstRhs(int matmul) : matmul(matmul) {}
+
+  int matmul = kMissingIndex;
+};
+
+// Weighted sum of gathered rows along segments (weighted embedding lookup).
+struct GatherWithMulAndSegmentSum {
+  GatherWithMulAndSegmentSum() = default;
+  GatherWithMulAndSegmentSum(int gather, int mul, int segment_sum,
+                             int weights_port)
+      : gather(gather),
+        mul(mul),
+        segment_sum(segment_sum),
+        weights_port(weights_port) {}
+
+  int gather = kMissingIndex;
+  int mul = kMissingIndex;
+  int segment_sum = kMissingIndex;
+  int weights_port = 1;
+};
+
+// Layer normalization over the innermost dimension, as built by nn.moments
+// and nn.batch_normalization (tf.contrib.layers.layer_norm, BERT, and Keras
+// LayerNormalization when it is not fused):
+//   mean = Mean(x), variance = Mean(SquaredDifference(x, mean))
+//   inv = Mul(Rsqrt(Add(variance, epsilon)), gamma)
+//   y = Add(Mul(x, inv), Sub(beta, Mul(mean, inv)))
+struct LayerNorm {
+  LayerNorm() = default;
+
+  int mean = kMissingIndex;
+  // StopGradient or Identity between the mean and the SquaredDifference,
+  // unless it was pruned.
+  int stop_gradient = kMissingIndex;
+  int squared_difference = kMissingIndex;
+  int variance = kMissingIndex;
+  int add_epsilon = kMissingIndex;
+  int rsqrt = kMissingIndex;
+  int inv = kMissingIndex;
+  int mul_x = kMissingIndex;
+  int mul_mean = kMissingIndex;
+  int sub = kMissingIndex;
+  int add = kMissingIndex;
+  float epsilon = 0.0;
+};
+
+// Softmax of attention scores plus a broadcast mask, with the scores
+// optionally scaled by a constant.
+struct MaskedSoftmax {
+  MaskedSoftmax() = default;
+  MaskedSoftmax(int add, int softmax, int logits_port)
+      : add(add), softmax(softmax), logits_port(logits_port) {}
+
+  int mul = kMissingIndex;
+  int add = kMissingIndex;
+  int softmax = kMissingIndex;
+  int logits_port = 0;
+  int scale_port = 1;
+  float scale = 1.0;
+};
+
 #ifdef INTEL_MKL
 // Contraction node followed by a BiasAdd and Add.
 struct ContractionWithBiasAddAndAdd {
@@ -316,10 +406,31 @@ bool IsGpuCompatible(const RemapperContext& ctx,
   return false;
 }
 
+// Checks if we can rewrite a pattern to the `_Fused{Conv2D,MatMul}` on VE.
+// VE kernels apply BiasAdd and the activation in place after the contraction,
+// so any supported activation can be fused.
+template <typename Pattern>
+bool IsVeCompatible(const RemapperContext& ctx, const Pattern& matched) {
+  const NodeDef& node = ctx.graph_view.graph()->node(matched.contraction);
+  if (!NodeIsOnVe(&node) || !HasDataType(&node, DT_FLOAT)) return false;
+  if (IsConv2D(node)) {
+    return IsGpuCompatibleDataFormat(&node);
+  } else if (IsMatMul(node)) {
+    return true;
+  } else {
+    return false;
+  }
+}
+bool IsVeCompatible(const RemapperContext& ctx,
+                    const ContractionWithSqueezeAndBiasAdd& matched) {
+  return false;
+}
+
 // Returns true if the given pattern is supported on the assigned device.
 template <typename Pattern>
 bool IsDeviceCompatible(const RemapperContext& ctx, Pattern& matched) {
-  return IsCpuCompatible(ctx, matched) || IsGpuCompatible(ctx, matched);
+  return IsCpuCompatible(ctx, matched) || IsGpuCompatible(ctx, matched) ||
+         IsVeCompatible(ctx, matched);
 }
 
 bool IsSupportedActivation(const NodeDef& node) {
@@ -738,9 +849,10 @@ bool FindFusedBatchNormEx(const RemapperContext& ctx, int node_index,
     const auto* fused_batch_norm_node_def = fused_batch_norm.node();
     if (!IsFusedBatchNorm(*fused_batch_norm_node_def)) return false;
 
-    // We fuse FusedBatchNorm only on GPU, because on CPU we fuse it with
-    // contraction (MatMul or Conv2D node).
-    if (!NodeIsOnGpu(fused_batch_norm_node_def)) return false;
+    // We fuse FusedBatchNorm only on GPU and VE, because on CPU we fuse it
+    // with contraction (MatMul or Conv2D node).
+    const bool is_on_ve = NodeIsOnVe(fused_batch_norm_node_def);
+    if (!NodeIsOnGpu(fused_batch_norm_node_def) && !is_on_ve) return false;
 
     DataType t_dtype = GetDataTypeFromAttr(*fused_batch_norm_node_def, "T");
     if (t_dtype != DT_FLOAT && t_dtype != DT_HALF) return false;
@@ -751,6 +863,10 @@ bool FindFusedBatchNormEx(const RemapperContext& ctx, int node_index,
              .ok())
       return false;
 
+    // VE applies Relu after the batch norm kernel, which is only supported for
+    // float inference.
+    if (is_on_ve && (is_training || t_dtype != DT_FLOAT)) return false;
+
     // In training mode we rely on cuDNN for computing FusedBatchNorm with side
     // inputs and activation, and it has its own limitations. In inference mode
     // we have a custom CUDA kernel that doesn't not have these constraints.
@@ -805,7 +921,8 @@ bool FindFusedBatchNormEx(const RemapperContext& ctx, int node_index,
   }
 
   // Input to a Relu can be an Add node with FusedBatchNorm as one of the inputs
-  if (IsAdd(*relu_fanin_0_node_def)) {
+  // (side inputs are not supported on VE).
+  if (IsAdd(*relu_fanin_0_node_def) && !NodeIsOnVe(relu_fanin_0_node_def)) {
     // Check that only Relu node consumes the output of an Add node.
     if (HasControlFaninOrFanout(*relu_fanin_0_node_view) ||
         !HasAtMostOneFanoutAtPort0(*relu_fanin_0_node_view) ||
@@ -845,6 +962,439 @@ bool FindFusedBatchNormEx(const RemapperContext& ctx, int node_index,
   return false;
 }
 
+// Layer norm and masked softmax fusions need the LayerNorm and MaskedSoftmax
+// kernels of the VE kernel library, and VE has no CPU fallback for the fused
+// ops. veorun_tf does not provide these kernels yet, so the fusions are only
+// done with TF_VE_FUSE_TRANSFORMER_OPS=true, for a library that has them.
+bool VeTransformerFusionsEnabled() {
+  static bool is_enabled = [] {
+    bool is_enabled = false;
+    TF_CHECK_OK(tensorflow::ReadBoolFromEnvVar("TF_VE_FUSE_TRANSFORMER_OPS",
+                                               /*default_val=*/false,
+                                               &is_enabled));
+    return is_enabled;
+  }();
+  return is_enabled;
+}
+
+// Returns the node feeding `port` of `node_view` if it is an `is_op` node that
+// can be fused into `node_view`: on the same device, of the same type, and
+// read only by `num_fanouts` nodes, which all belong to the pattern.
+const utils::MutableNodeView* GetFusableFanin(
+    const RemapperContext& ctx, const utils::MutableNodeView& node_view,
+    int port, bool (*is_op)(const NodeDef&), int num_fanouts) {
+  if (port >= node_view.NumRegularFanins()) return nullptr;
+  const auto& fanin = node_view.GetRegularFanin(port);
+  const auto* fanin_node_view = fanin.node_view();
+  const auto* fanin_node_def = fanin_node_view->node();
+  if (fanin.index() != 0 || !is_op(*fanin_node_def) ||
+      fanin_node_def->device() != node_view.node()->device() ||
+      !HaveSameDataType(node_view.node(), fanin_node_def) ||
+      HasControlFaninOrFanout(*fanin_node_view) ||
+      fanin_node_view->GetRegularFanout(0).size() !=
+          static_cast<size_t>(num_fanouts) ||
+      IsInPreserveSet(ctx, fanin_node_def))
+    return nullptr;
+  return fanin_node_view;
+}
+
+// Returns true if `node` is a float constant with a single element.
+bool GetScalarConstValue(const NodeDef& node, float* value) {
+  Tensor tensor;
+  if (!IsConstant(node) || !node.attr().count("value") ||
+      !tensor.FromProto(node.attr().at("value").tensor()) ||
+      tensor.dtype() != DT_FLOAT || tensor.NumElements() != 1)
+    return false;
+  *value = tensor.flat<float>()(0);
+  return true;
+}
+
+// Returns true if `axes` is a constant holding only the innermost axis of a
+// tensor of rank `rank`.
+bool IsInnermostAxis(const NodeDef& axes_node, int rank) {
+  Tensor axes;
+  if (!IsConstant(axes_node) || !axes_node.attr().count("value") ||
+      !axes.FromProto(axes_node.attr().at("value").tensor()) ||
+      axes.NumElements() != 1)
+    return false;
+  const int64 axis = axes.dtype() == DT_INT32 ? axes.flat<int32>()(0)
+                                              : axes.flat<int64>()(0);
+  return axis == -1 || axis == rank - 1;
+}
+
+bool FindLayerNorm(const RemapperContext& ctx, int node_index,
+                   LayerNorm* matched) {
+  const auto* add_node_view = ctx.graph_view.GetNode(node_index);
+  const auto* add_node_def = add_node_view->node();
+  // Root of the pattern must be the final Add on VE.
+  if (!IsAdd(*add_node_def) || !NodeIsOnVe(add_node_def) ||
+      !HasDataType(add_node_def, DT_FLOAT) ||
+      HasControlFaninOrFanout(*add_node_view) ||
+      add_node_view->NumRegularFanins() != 2 || !VeTransformerFusionsEnabled())
+    return false;
+
+  // y = Add(Mul(x, inv), Sub(beta, Mul(mean, inv)))
+  const auto* mul_x_node_view =
+      GetFusableFanin(ctx, *add_node_view, 0, IsMul, 1);
+  const auto* sub_node_view = GetFusableFanin(ctx, *add_node_view, 1, IsSub, 1);
+  if (mul_x_node_view == nullptr || sub_node_view == nullptr) return false;
+  const auto* mul_mean_node_view =
+      GetFusableFanin(ctx, *sub_node_view, 1, IsMul, 1);
+  if (mul_mean_node_view == nullptr) return false;
+
+  // inv = Mul(Rsqrt(Add(variance, epsilon)), gamma), read by both Muls.
+  const auto* inv_node_view =
+      GetFusableFanin(ctx, *mul_x_node_view, 1, IsMul, 2);
+  if (inv_node_view == nullptr ||
+      mul_mean_node_view->NumRegularFanins() != 2 ||
+      mul_mean_node_view->GetRegularFanin(1).node_view() != inv_node_view)
+    return false;
+  const auto* rsqrt_node_view =
+      GetFusableFanin(ctx, *inv_node_view, 0, IsRsqrt, 1);
+  if (rsqrt_node_view == nullptr) return false;
+  const auto* add_epsilon_node_view =
+      GetFusableFanin(ctx, *rsqrt_node_view, 0, IsAdd, 1);
+  if (add_epsilon_node_view == nullptr ||
+      add_epsilon_node_view->NumRegularFanins() != 2 ||
+      !GetScalarConstValue(
+          *add_epsilon_node_view->GetRegularFanin(1).node_view()->node(),
+          &matched->epsilon))
+    return false;
+
+  // variance = Mean(SquaredDifference(x, StopGradient(mean)))
+  const auto* variance_node_view =
+      GetFusableFanin(ctx, *add_epsilon_node_view, 0, IsMean, 1);
+  if (variance_node_view == nullptr) return false;
+  const auto* squared_difference_node_view =
+      GetFusableFanin(ctx, *variance_node_view, 0, IsSquaredDifference, 1);
+  // mean = Mean(x), read by the Mul and the SquaredDifference.
+  const auto* mean_node_view =
+      GetFusableFanin(ctx, *mul_mean_node_view, 0, IsMean, 2);
+  if (squared_difference_node_view == nullptr || mean_node_view == nullptr ||
+      squared_difference_node_view->NumRegularFanins() != 2)
+    return false;
+  const utils::MutableNodeView* stop_gradient_node_view = nullptr;
+  if (squared_difference_node_view->GetRegularFanin(1).node_view() !=
+      mean_node_view) {
+    stop_gradient_node_view = GetFusableFanin(
+        ctx, *squared_difference_node_view, 1,
+        [](const NodeDef& node) {
+          return IsStopGradient(node) || IsIdentity(node);
+        },
+        1);
+    if (stop_gradient_node_view == nullptr ||
+        stop_gradient_node_view->NumRegularFanins() < 1 ||
+        stop_gradient_node_view->GetRegularFanin(0).node_view() !=
+            mean_node_view)
+      return false;
+  }
+
+  // The Mul, the SquaredDifference and the Mean all read the same x.
+  const auto& x = mul_x_node_view->GetRegularFanin(0);
+  for (const auto* node_view : {squared_difference_node_view, mean_node_view}) {
+    const auto& fanin = node_view->GetRegularFanin(0);
+    if (fanin.node_index() != x.node_index() || fanin.index() != x.index())
+      return false;
+  }
+
+  // Both Means reduce the innermost dimension of x, which gamma and beta
+  // scale and shift.
+  const auto& mean_props =
+      ctx.graph_properties.GetInputProperties(mean_node_view->GetName());
+  const auto& inv_props =
+      ctx.graph_properties.GetInputProperties(inv_node_view->GetName());
+  const auto& sub_props =
+      ctx.graph_properties.GetInputProperties(sub_node_view->GetName());
+  if (mean_props.empty() || inv_props.size() != 2 || sub_props.size() != 2)
+    return false;
+  const auto& x_shape = mean_props[0].shape();
+  if (x_shape.unknown_rank() || x_shape.dim_size() < 1) return false;
+  for (const auto* node_view : {mean_node_view, variance_node_view}) {
+    bool keep_dims = false;
+    if (node_view->NumRegularFanins() != 2 ||
+        !TryGetNodeAttr(*node_view->node(), "keep_dims", &keep_dims) ||
+        !keep_dims ||
+        !IsInnermostAxis(*node_view->GetRegularFanin(1).node_view()->node(),
+                         x_shape.dim_size()))
+      return false;
+  }
+  for (const auto* shape : {&inv_props[1].shape(), &sub_props[0].shape()}) {
+    if (shape->unknown_rank() || shape->dim_size() != 1) return false;
+  }
+
+  // We successfully found a layer normalization pattern.
+  matched->mean = mean_node_view->node_index();
+  if (stop_gradient_node_view != nullptr) {
+    matched->stop_gradient = stop_gradient_node_view->node_index();
+  }
+  matched->squared_difference = squared_difference_node_view->node_index();
+  matched->variance = variance_node_view->node_index();
+  matched->add_epsilon = add_epsilon_node_view->node_index();
+  matched->rsqrt = rsqrt_node_view->node_index();
+  matched->inv = inv_node_view->node_index();
+  matched->mul_x = mul_x_node_view->node_index();
+  matched->mul_mean = mul_mean_node_view->node_index();
+  matched->sub = sub_node_view->node_index();
+  matched->add = node_index;
+
+  return true;
+}
+
+// Returns true if `mask` has the rank of `logits` and each of its dimensions
+// is 1 or the dimension of `logits`.
+bool IsBroadcastableMask(const TensorShapeProto& logits,
+                         const TensorShapeProto& mask) {
+  if (logits.unknown_rank() || mask.unknown_rank() ||
+      logits.dim_size() < 1 || mask.dim_size() != logits.dim_size())
+    return false;
+  for (int d = 0; d < logits.dim_size(); ++d) {
+    const int64 size = mask.dim(d).size();
+    if (size != 1 && (size == -1 || size != logits.dim(d).size()))
+      return false;
+  }
+  return true;
+}
+
+bool FindMaskedSoftmax(const RemapperContext& ctx, int node_index,
+                       MaskedSoftmax* matched) {
+  const auto* softmax_node_view = ctx.graph_view.GetNode(node_index);
+  const auto* softmax_node_def = softmax_node_view->node();
+  // Root of the pattern must be a Softmax on VE.
+  if (!IsSoftmax(*softmax_node_def) || !NodeIsOnVe(softmax_node_def) ||
+      !HasDataType(softmax_node_def, DT_FLOAT) ||
+      HasControlFaninOrFanout(*softmax_node_view) ||
+      !VeTransformerFusionsEnabled())
+    return false;
+
+  // Input to the Softmax must be an Add of the logits and the mask.
+  const auto* add_node_view =
+      GetFusableFanin(ctx, *softmax_node_view, 0, IsAdd, 1);
+  if (add_node_view == nullptr || add_node_view->NumRegularFanins() != 2)
+    return false;
+  const auto& add_props =
+      ctx.graph_properties.GetInputProperties(add_node_view->GetName());
+  if (add_props.size() != 2) return false;
+
+  // The logits can be either input of the Add, the mask is broadcast to them.
+  for (int port : {0, 1}) {
+    if (!IsBroadcastableMask(add_props[port].shape(),
+                             add_props[1 - port].shape()))
+      continue;
+    *matched = MaskedSoftmax(add_node_view->node_index(), node_index, port);
+
+    // Logits scaled by a constant, e.g. 1 / sqrt(head size), are scaled in
+    // the kernel.
+    const auto* mul_node_view =
+        GetFusableFanin(ctx, *add_node_view, port, IsMul, 1);
+    if (mul_node_view != nullptr && mul_node_view->NumRegularFanins() == 2) {
+      for (int scale_port : {1, 0}) {
+        if (GetScalarConstValue(
+                *mul_node_view->GetRegularFanin(scale_port).node_view()->node(),
+                &matched->scale)) {
+          matched->mul = mul_node_view->node_index();
+          matched->scale_port = scale_port;
+          break;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+bool FindPadWithConv2D(const RemapperContext& ctx, int node_index,
+                       PadWithConv2D* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  // Root of the pattern must be a Conv2D on VE. VE conv kernels take explicit
+  // paddings, so padding the input in a separate kernel is not needed.
+  if (!IsConv2D(*node_def) || !NodeIsOnVe(node_def)) return false;
+
+  const auto* padding_attr = node_view->GetAttr("padding");
+  if (padding_attr == nullptr ||
+      (padding_attr->s() != "VALID" && padding_attr->s() != "EXPLICIT"))
+    return false;
+
+  // Input to the Conv2D must be a Pad with zero constant values.
+  if (node_view->NumRegularFanins() < 1) return false;
+  const auto& regular_fanin_0 = node_view->GetRegularFanin(0);
+  const auto* pad_node_view = regular_fanin_0.node_view();
+  const auto* pad_node_def = pad_node_view->node();
+
+  if (pad_node_def->op() != "Pad" || regular_fanin_0.index() != 0 ||
+      !HaveSameDataType(node_def, pad_node_def) ||
+      HasControlFaninOrFanout(*pad_node_view) ||
+      !HasAtMostOneFanoutAtPort0(*pad_node_view) ||
+      IsInPreserveSet(ctx, pad_node_def))
+    return false;
+
+  // Paddings must be a constant [4, 2] tensor.
+  if (pad_node_view->NumRegularFanins() < 2) return false;
+  const auto* paddings_node_def =
+      pad_node_view->GetRegularFanin(1).node_view()->node();
+  Tensor paddings;
+  if (!IsConstant(*paddings_node_def) ||
+      !paddings_node_def->attr().count("value") ||
+      !paddings.FromProto(paddings_node_def->attr().at("value").tensor()) ||
+      paddings.dims() != 2 || paddings.dim_size(0) != 4 ||
+      paddings.dim_size(1) != 2)
+    return false;
+
+  std::vector<int64> explicit_paddings(8, 0);
+  const auto* explicit_paddings_attr = node_view->GetAttr("explicit_paddings");
+  if (padding_attr->s() == "EXPLICIT") {
+    if (explicit_paddings_attr == nullptr ||
+        explicit_paddings_attr->list().i_size() != 8)
+      return false;
+    for (int i = 0; i < 8; ++i) {
+      explicit_paddings[i] = explicit_paddings_attr->list().i(i);
+    }
+  }
+  for (int d = 0; d < 4; ++d) {
+    for (int j = 0; j < 2; ++j) {
+      const int64 pad = paddings.dtype() == DT_INT32
+                            ? paddings.matrix<int32>()(d, j)
+                            : paddings.matrix<int64>()(d, j);
+      if (pad < 0) return false;
+      explicit_paddings[2 * d + j] += pad;
+    }
+  }
+
+  // Only spatial dimensions can be padded by Conv2D.
+  const string& data_format = node_view->GetAttr(kDataFormat)->s();
+  const int batch_dim = 0;
+  const int depth_dim = data_format == "NCHW" ? 1 : 3;
+  for (int d : {batch_dim, depth_dim}) {
+    if (explicit_paddings[2 * d] != 0 || explicit_paddings[2 * d + 1] != 0)
+      return false;
+  }
+
+  // We successfully found a Pad+Conv2D pattern.
+  *matched = PadWithConv2D(pad_node_view->node_index(), node_index);
+  matched->explicit_paddings = std::move(explicit_paddings);
+
+  return true;
+}
+
+bool FindMatMulWithConstRhs(const RemapperContext& ctx, int node_index,
+                            MatMulWithConstRhs* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  // Root of the pattern must be a MatMul on CPU.
+  if (!IsMatMul(*node_def) || !IsCpuCompatibleMatMul(node_def)) return false;
+  if (node_view->NumRegularFanins() < 2) return false;
+
+  // MatMul with a constant left hand side is left to constant folding.
+  const auto* lhs_node_def = node_view->GetRegularFanin(0).node_view()->node();
+  if (IsConstant(*lhs_node_def)) return false;
+
+  // Right hand side must be a constant that is never fed, so that the kernel
+  // can pack it once and reuse the packed panels for all invocations.
+  const auto* rhs_node_def = node_view->GetRegularFanin(1).node_view()->node();
+  if (!IsConstant(*rhs_node_def) || !NodeIsOnCpu(rhs_node_def) ||
+      IsInPreserveSet(ctx, rhs_node_def))
+    return false;
+
+  *matched = MatMulWithConstRhs(node_index);
+
+  return true;
+}
+
+bool FindGatherWithMulAndSegmentSum(const RemapperContext& ctx, int node_index,
+                                    GatherWithMulAndSegmentSum* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  // Root of the pattern must be a SegmentSum on CPU.
+  if (node_def->op() != "SegmentSum" || !NodeIsOnCpu(node_def)) return false;
+  const DataType dtype = GetDataTypeFromAttr(*node_def, "T");
+  if (dtype != DT_FLOAT && dtype != DT_DOUBLE) return false;
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  // Input to the SegmentSum must be a Mul of the gathered rows and weights.
+  if (node_view->NumRegularFanins() < 2) return false;
+  const auto& regular_fanin_0 = node_view->GetRegularFanin(0);
+  const auto* mul_node_view = regular_fanin_0.node_view();
+  const auto* mul_node_def = mul_node_view->node();
+  if (!IsMul(*mul_node_def) || regular_fanin_0.index() != 0 ||
+      !HaveSameDataType(node_def, mul_node_def) ||
+      HasControlFaninOrFanout(*mul_node_view) ||
+      !HasAtMostOneFanoutAtPort0(*mul_node_view) ||
+      IsInPreserveSet(ctx, mul_node_def))
+    return false;
+
+  // Gathered rows can be either input of the Mul.
+  if (mul_node_view->NumRegularFanins() < 2) return false;
+  int weights_port = kMissingIndex;
+  for (int port : {0, 1}) {
+    const auto& mul_fanin = mul_node_view->GetRegularFanin(port);
+    if (mul_fanin.node_view()->node()->op() == "GatherV2" &&
+        mul_fanin.index() == 0) {
+      weights_port = 1 - port;
+      break;
+    }
+  }
+  if (weights_port == kMissingIndex) return false;
+
+  const auto* gather_node_view =
+      mul_node_view->GetRegularFanin(1 - weights_port).node_view();
+  const auto* gather_node_def = gather_node_view->node();
+  if (GetDataTypeFromAttr(*gather_node_def, "Tparams") != dtype ||
+      HasControlFaninOrFanout(*gather_node_view) ||
+      !HasAtMostOneFanoutAtPort0(*gather_node_view) ||
+      IsInPreserveSet(ctx, gather_node_def))
+    return false;
+
+  // Rows must be gathered along the first dimension.
+  int batch_dims = 0;
+  if (TryGetNodeAttr(*gather_node_def, "batch_dims", &batch_dims) &&
+      batch_dims != 0)
+    return false;
+  if (gather_node_view->NumRegularFanins() < 3) return false;
+  const auto* axis_node_def =
+      gather_node_view->GetRegularFanin(2).node_view()->node();
+  Tensor axis;
+  if (!IsConstant(*axis_node_def) || !axis_node_def->attr().count("value") ||
+      !axis.FromProto(axis_node_def->attr().at("value").tensor()) ||
+      axis.NumElements() != 1)
+    return false;
+  const int64 axis_value = axis.dtype() == DT_INT32 ? axis.flat<int32>()(0)
+                                                     : axis.flat<int64>()(0);
+  if (axis_value != 0) return false;
+
+  // Indices must be a vector, and weights must be broadcast along the rows of
+  // the gathered tensor, i.e. have shape [num_indices, 1, ..., 1].
+  const auto& gather_props =
+      ctx.graph_properties.GetInputProperties(gather_node_def->name());
+  const auto& mul_props =
+      ctx.graph_properties.GetInputProperties(mul_node_def->name());
+  if (gather_props.size() < 2 || mul_props.size() != 2) return false;
+  const auto& indices_shape = gather_props[1].shape();
+  const auto& rows_shape = mul_props[1 - weights_port].shape();
+  const auto& weights_shape = mul_props[weights_port].shape();
+  if (indices_shape.unknown_rank() || indices_shape.dim_size() != 1 ||
+      rows_shape.unknown_rank() || weights_shape.unknown_rank() ||
+      weights_shape.dim_size() != rows_shape.dim_size())
+    return false;
+  for (int d = 1; d < weights_shape.dim_size(); ++d) {
+    if (weights_shape.dim(d).size() != 1) return false;
+  }
+  // The fused kernel reads one weight per index, so weights broadcast along
+  // the first dimension too, or of unknown length, can't be fused. The
+  // lengths must be known and equal, or the same symbolic dimension (< -1).
+  const int64 num_indices = indices_shape.dim(0).size();
+  const int64 num_weights = weights_shape.dim(0).size();
+  if (num_weights != num_indices || num_weights == -1) return false;
+
+  // We successfully found a GatherV2+Mul+SegmentSum pattern.
+  *matched = GatherWithMulAndSegmentSum(gather_node_view->node_index(),
+                                        mul_node_view->node_index(),
+                                        node_index, weights_port);
+
+  return true;
+}
+
 void CopyConv2DAttributes(const NodeDef& conv2d, NodeDef* fused_conv2d) {
   DCHECK(IsConv2D(conv2d)) << "Input node must be a Conv2D";
 
@@ -1453,10 +2003,173 @@ Status AddBatchNormNodes(RemapperContext* ctx, const FusedBatchNorm& matched) {
   return mutation->Apply();
 }
 
+Status FoldPadIntoConv2D(RemapperContext* ctx, const PadWithConv2D& matched,
+                         std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& pad = graph->node(matched.pad);
+  const NodeDef& conv2d = graph->node(matched.conv2d);
+  VLOG(2) << "Fold Pad into Conv2D: pad=" << pad.name()
+          << " conv2d=" << conv2d.name();
+
+  auto* conv2d_node_view = ctx->graph_view.GetNode(matched.conv2d);
+  AttrValue padding;
+  padding.set_s("EXPLICIT");
+  AttrValue explicit_paddings;
+  SetAttrValue(matched.explicit_paddings, &explicit_paddings);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  mutation->AddOrUpdateRegularFanin(conv2d_node_view, 0,
+                                    ParseTensorName(pad.input(0)));
+  mutation->AddOrUpdateNodeAttr(conv2d_node_view, "padding", padding);
+  mutation->AddOrUpdateNodeAttr(conv2d_node_view, "explicit_paddings",
+                                explicit_paddings);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*nodes_to_delete)[matched.pad] = true;
+
+  return Status::OK();
+}
+
+Status AddPrepackedMatMulNode(RemapperContext* ctx,
+                              const MatMulWithConstRhs& matched) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& matmul = graph->node(matched.matmul);
+  VLOG(2) << "Prepack constant right hand side of MatMul: matmul="
+          << matmul.name();
+
+  auto* matmul_node_view = ctx->graph_view.GetNode(matched.matmul);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  mutation->UpdateNodeOp(matmul_node_view, kPrepackedMatMul);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  return Status::OK();
+}
+
+Status AddSparseSegmentWeightedSumNode(
+    RemapperContext* ctx, const GatherWithMulAndSegmentSum& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& gather = graph->node(matched.gather);
+  const NodeDef& mul = graph->node(matched.mul);
+  const NodeDef& segment_sum = graph->node(matched.segment_sum);
+  VLOG(2) << "Fuse " << gather.op() << " with Mul and SegmentSum: "
+          << " gather=" << gather.name() << " mul=" << mul.name()
+          << " segment_sum=" << segment_sum.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(segment_sum.name());
+  fused_op.set_op(kSparseSegmentWeightedSum);
+  fused_op.set_device(segment_sum.device());
+  fused_op.add_input(gather.input(0));                  // 0: data
+  fused_op.add_input(gather.input(1));                  // 1: indices
+  fused_op.add_input(mul.input(matched.weights_port));  // 2: weights
+  fused_op.add_input(segment_sum.input(1));             // 3: segment_ids
+
+  auto* attr = fused_op.mutable_attr();
+  (*attr)["T"] = segment_sum.attr().at("T");
+  (*attr)["Tidx"] = gather.attr().at("Tindices");
+  (*attr)["Tsegmentids"] = segment_sum.attr().at("Tindices");
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.segment_sum] = true;
+  (*nodes_to_delete)[matched.mul] = true;
+  (*nodes_to_delete)[matched.gather] = true;
+
+  return Status::OK();
+}
+
+Status AddLayerNormNode(RemapperContext* ctx, const LayerNorm& matched,
+                        std::vector<bool>* invalidated_nodes,
+                        std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& mul_x = graph->node(matched.mul_x);
+  const NodeDef& inv = graph->node(matched.inv);
+  const NodeDef& sub = graph->node(matched.sub);
+  const NodeDef& add = graph->node(matched.add);
+  VLOG(2) << "Fuse layer normalization into " << kFusedLayerNorm
+          << ": add=" << add.name() << " mean="
+          << graph->node(matched.mean).name();
+
+  NodeDef fused_op;
+  fused_op.set_name(add.name());
+  fused_op.set_op(kFusedLayerNorm);
+  fused_op.set_device(add.device());
+  fused_op.add_input(mul_x.input(0));  // 0: x
+  fused_op.add_input(inv.input(1));    // 1: gamma
+  fused_op.add_input(sub.input(0));    // 2: beta
+
+  auto* attr = fused_op.mutable_attr();
+  (*attr)["T"] = add.attr().at("T");
+  SetAttrValue(matched.epsilon, &(*attr)["epsilon"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.add] = true;
+  for (int node :
+       {matched.mean, matched.stop_gradient, matched.squared_difference,
+        matched.variance, matched.add_epsilon, matched.rsqrt, matched.inv,
+        matched.mul_x, matched.mul_mean, matched.sub}) {
+    if (node != kMissingIndex) (*nodes_to_delete)[node] = true;
+  }
+
+  return Status::OK();
+}
+
+Status AddMaskedSoftmaxNode(RemapperContext* ctx, const MaskedSoftmax& matched,
+                            std::vector<bool>* invalidated_nodes,
+                            std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& add = graph->node(matched.add);
+  const NodeDef& softmax = graph->node(matched.softmax);
+  VLOG(2) << "Fuse " << add.op() << " with Softmax: add=" << add.name()
+          << " softmax=" << softmax.name() << " scale=" << matched.scale;
+
+  NodeDef fused_op;
+  fused_op.set_name(softmax.name());
+  fused_op.set_op(kFusedMaskedSoftmax);
+  fused_op.set_device(softmax.device());
+  if (matched.mul != kMissingIndex) {
+    const NodeDef& mul = graph->node(matched.mul);
+    fused_op.add_input(mul.input(1 - matched.scale_port));  // 0: logits
+  } else {
+    fused_op.add_input(add.input(matched.logits_port));     // 0: logits
+  }
+  fused_op.add_input(add.input(1 - matched.logits_port));   // 1: mask
+
+  auto* attr = fused_op.mutable_attr();
+  (*attr)["T"] = softmax.attr().at("T");
+  SetAttrValue(matched.scale, &(*attr)["scale"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.softmax] = true;
+  (*nodes_to_delete)[matched.add] = true;
+  if (matched.mul != kMissingIndex) (*nodes_to_delete)[matched.mul] = true;
+
+  return Status::OK();
+}
+
 // Check if a node is a candidate to one of the patterns that require inferred
 // shapes:
 //   (1) Splitting FusedBatchNorm into primitives.
 //   (2) Fusing side input and/or activation into FusedBatchNorm.
+//   (3) Fusing GatherV2 and Mul into SegmentSum.
+//   (4) Fusing a layer normalization on VE.
+//   (5) Fusing Add and Softmax on VE.
 bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
   // Candidate for a FusedBatchNorm splitting.
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -1502,7 +2215,38 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
     return false;
   };
 
-  return is_batch_norm_candidate() || is_batch_norm_fusion_candidate();
+  // Candidate for a GatherV2+Mul+SegmentSum fusion.
+  const auto is_segment_sum_fusion_candidate = [&]() -> bool {
+    if (node_def->op() != "SegmentSum") return false;
+
+    if (node_view->NumRegularFanins() < 1) return false;
+    const auto* mul_node_view = node_view->GetRegularFanin(0).node_view();
+    if (!IsMul(*mul_node_view->node())) return false;
+
+    for (int port = 0; port < mul_node_view->NumRegularFanins(); ++port) {
+      const auto& mul_fanin = mul_node_view->GetRegularFanin(port);
+      if (mul_fanin.node_view()->node()->op() == "GatherV2") return true;
+    }
+
+    return false;
+  };
+
+  // Candidate for a layer norm or masked softmax fusion on VE.
+  const auto is_ve_transformer_fusion_candidate = [&]() -> bool {
+    if (!NodeIsOnVe(node_def) || node_view->NumRegularFanins() < 1)
+      return false;
+
+    if (IsAdd(*node_def)) {
+      return node_view->NumRegularFanins() == 2 &&
+             IsSub(*node_view->GetRegularFanin(1).node_view()->node());
+    }
+    return IsSoftmax(*node_def) &&
+           IsAdd(*node_view->GetRegularFanin(0).node_view()->node());
+  };
+
+  return is_batch_norm_candidate() || is_batch_norm_fusion_candidate() ||
+         is_segment_sum_fusion_candidate() ||
+         is_ve_transformer_fusion_candidate();
 }
 
 }  // namespace
@@ -1529,6 +2273,16 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
   bool allow_non_differentiable_rewrites =
       item.optimization_options().allow_non_differentiable_rewrites;
 
+  // Fold Pad into Conv2D before the fusions below, so that _FusedConv2D
+  // inherits the explicit paddings.
+  for (int i = 0; i < num_nodes; ++i) {
+    PadWithConv2D pad_with_conv2d;
+    if (!nodes_to_delete[i] && FindPadWithConv2D(ctx, i, &pad_with_conv2d)) {
+      TF_RETURN_IF_ERROR(
+          FoldPadIntoConv2D(&ctx, pad_with_conv2d, &nodes_to_delete));
+    }
+  }
+
   for (int i = num_nodes - 1; i >= 0; --i) {
     // Check if node was invalidated by one of the previous remaps.
     if (invalidated_nodes[i] || nodes_to_delete[i]) {
@@ -1618,6 +2372,16 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
                              &invalidated_nodes, &nodes_to_delete));
       continue;
     }
+
+    // Remap MatMul with a constant right hand side into the _PrepackedMatMul.
+    // MatMul+BiasAdd was already fused above, because BiasAdd is visited
+    // before the MatMul in reverse-topological order.
+    MatMulWithConstRhs matmul_with_const_rhs;
+    if (allow_non_differentiable_rewrites &&
+        FindMatMulWithConstRhs(ctx, i, &matmul_with_const_rhs)) {
+      TF_RETURN_IF_ERROR(AddPrepackedMatMulNode(&ctx, matmul_with_const_rhs));
+      continue;
+    }
 #endif  // !INTEL_MKL
 
     // Infer properties lazily in case they are not needed.
@@ -1640,6 +2404,37 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+#ifndef INTEL_MKL
+    // Remap GatherV2+Mul+SegmentSum into the _SparseSegmentWeightedSum.
+    GatherWithMulAndSegmentSum gather_with_mul_and_segment_sum;
+    if (allow_non_differentiable_rewrites &&
+        FindGatherWithMulAndSegmentSum(ctx, i,
+                                       &gather_with_mul_and_segment_sum)) {
+      TF_RETURN_IF_ERROR(AddSparseSegmentWeightedSumNode(
+          &ctx, gather_with_mul_and_segment_sum, &invalidated_nodes,
+          &nodes_to_delete));
+      continue;
+    }
+#endif  // !INTEL_MKL
+
+    // Remap the primitives of a layer normalization into the _FusedLayerNorm.
+    LayerNorm layer_norm;
+    if (allow_non_differentiable_rewrites &&
+        FindLayerNorm(ctx, i, &layer_norm)) {
+      TF_RETURN_IF_ERROR(AddLayerNormNode(&ctx, layer_norm, &invalidated_nodes,
+                                          &nodes_to_delete));
+      continue;
+    }
+
+    // Remap [Mul+]Add+Softmax into the _FusedMaskedSoftmax.
+    MaskedSoftmax masked_softmax;
+    if (allow_non_differentiable_rewrites &&
+        FindMaskedSoftmax(ctx, i, &masked_softmax)) {
+      TF_RETURN_IF_ERROR(AddMaskedSoftmaxNode(
+          &ctx, masked_softmax, &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
     // During inference, most of the inputs to FusedBatchNorm are constant, and
     // we can therefore replace the op with a much cheaper set of primitives.
     FusedBatchNorm fused_batch_norm;
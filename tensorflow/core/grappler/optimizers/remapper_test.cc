@@ -36,6 +36,8 @@ class RemapperTest : public GrapplerTest {
   void SetUp() override {
     // This is a requirement for fusing FusedBatchNorm + SideInput + Activation.
     setenv("TF_USE_CUDNN_BATCHNORM_SPATIAL_PERSISTENT", "1", 1 /* replace */);
+    // The VE layer norm and masked softmax fusions are opt-in.
+    setenv("TF_VE_FUSE_TRANSFORMER_OPS", "1", 1 /* replace */);
   }
 };
 
@@ -388,6 +390,60 @@ TEST_F(RemapperTest, FuseConv2DWithBias) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(RemapperTest, FoldPadIntoConv2DOnVE) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto input_shape = ops::Placeholder::Shape({8, 32, 32, 3});
+  auto filter_shape = ops::Placeholder::Shape({3, 3, 3, 16});
+
+  auto input = Placeholder(s.WithOpName("input"), DT_FLOAT, input_shape);
+  auto filter = Placeholder(s.WithOpName("filter"), DT_FLOAT, filter_shape);
+  auto paddings = ops::Const(s.WithOpName("paddings"),
+                             {{0, 0}, {1, 2}, {0, 1}, {0, 0}}, {4, 2});
+  auto pad = ops::Pad(s.WithOpName("pad"), input, paddings);
+
+  std::vector<int> strides = {1, 1, 1, 1};
+  auto conv = ops::Conv2D(s.WithOpName("conv"), pad, filter, strides, "VALID");
+  auto fetch = ops::Identity(s.WithOpName("fetch"), conv);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on VE.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:VE:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "pad");
+    if (node.name() == "conv") {
+      EXPECT_EQ(node.op(), "Conv2D");
+      ASSERT_GE(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "input");
+      EXPECT_EQ(node.input(1), "filter");
+      EXPECT_EQ(node.attr().at("padding").s(), "EXPLICIT");
+
+      const auto explicit_paddings =
+          node.attr().at("explicit_paddings").list().i();
+      const std::vector<int64> expected = {0, 0, 1, 2, 0, 1, 0, 0};
+      ASSERT_EQ(explicit_paddings.size(), expected.size());
+      for (int i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(explicit_paddings[i], expected[i]);
+      }
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+}
+
 TEST_F(RemapperTest, FuseMatMulWithBias) {
   using ::tensorflow::ops::Placeholder;
 
@@ -449,6 +505,426 @@ TEST_F(RemapperTest, FuseMatMulWithBias) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(RemapperTest, PrepackMatMulWithConstRhs) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs_shape = ops::Placeholder::Shape({4, 32});
+  auto rhs_t = GenerateRandomTensor<DT_FLOAT>({64, 32});
+
+  auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+  auto rhs = ops::Const(s.WithOpName("rhs"), Input::Initializer(rhs_t));
+
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs,
+                            ops::MatMul::Attrs().TransposeB(true));
+  auto fetch = ops::Identity(s.WithOpName("fetch"), matmul);
+
+  auto lhs_t = GenerateRandomTensor<DT_FLOAT>({4, 32});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"lhs", lhs_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "matmul") {
+      EXPECT_EQ(node.op(), "_PrepackedMatMul");
+      ASSERT_GE(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "lhs");
+      EXPECT_EQ(node.input(1), "rhs");
+      EXPECT_TRUE(node.attr().at("transpose_b").b());
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-5);
+}
+
+TEST_F(RemapperTest, DoNotPrepackMatMulWithFedRhs) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs = ops::Placeholder(s.WithOpName("lhs"), DT_FLOAT,
+                              ops::Placeholder::Shape({4, 32}));
+  auto rhs = ops::Const(s.WithOpName("rhs"), 1.0f, {32, 64});
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), matmul);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"lhs", GenerateRandomTensor<DT_FLOAT>({4, 32})},
+               {"rhs", GenerateRandomTensor<DT_FLOAT>({32, 64})}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // Fed constant may change between runs, so it can't be packed once.
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "matmul") {
+      EXPECT_EQ(node.op(), "MatMul");
+    }
+  }
+}
+
+TEST_F(RemapperTest, FuseGatherWithMulAndSegmentSum) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto params = Placeholder(s.WithOpName("params"), DT_FLOAT,
+                            ops::Placeholder::Shape({10, 16}));
+  auto indices = Placeholder(s.WithOpName("indices"), DT_INT32,
+                             ops::Placeholder::Shape({6}));
+  auto weights = Placeholder(s.WithOpName("weights"), DT_FLOAT,
+                             ops::Placeholder::Shape({6, 1}));
+  auto segment_ids = Placeholder(s.WithOpName("segment_ids"), DT_INT32,
+                                 ops::Placeholder::Shape({6}));
+
+  auto axis = ops::Const(s.WithOpName("axis"), 0);
+  auto gather = ops::GatherV2(s.WithOpName("gather"), params, indices, axis);
+  auto mul = ops::Mul(s.WithOpName("mul"), weights, gather);
+  auto segment_sum =
+      ops::SegmentSum(s.WithOpName("segment_sum"), mul, segment_ids);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), segment_sum);
+
+  Tensor indices_t(DT_INT32, TensorShape({6}));
+  test::FillValues<int32>(&indices_t, {3, 0, 9, 3, 5, 1});
+  Tensor segment_ids_t(DT_INT32, TensorShape({6}));
+  test::FillValues<int32>(&segment_ids_t, {0, 0, 1, 3, 3, 3});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"params", GenerateRandomTensor<DT_FLOAT>({10, 16})},
+               {"indices", indices_t},
+               {"weights", GenerateRandomTensor<DT_FLOAT>({6, 1})},
+               {"segment_ids", segment_ids_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "gather");
+    EXPECT_NE(node.name(), "mul");
+    if (node.name() == "segment_sum") {
+      EXPECT_EQ(node.op(), "_SparseSegmentWeightedSum");
+      ASSERT_EQ(node.input_size(), 4);
+      EXPECT_EQ(node.input(0), "params");
+      EXPECT_EQ(node.input(1), "indices");
+      EXPECT_EQ(node.input(2), "weights");
+      EXPECT_EQ(node.input(3), "segment_ids");
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, DoNotFuseGatherWithElementwiseMul) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto params = ops::Placeholder(s.WithOpName("params"), DT_FLOAT,
+                                 ops::Placeholder::Shape({10, 16}));
+  auto indices = ops::Placeholder(s.WithOpName("indices"), DT_INT32,
+                                  ops::Placeholder::Shape({6}));
+  auto weights = ops::Placeholder(s.WithOpName("weights"), DT_FLOAT,
+                                  ops::Placeholder::Shape({6, 16}));
+  auto segment_ids = ops::Placeholder(s.WithOpName("segment_ids"), DT_INT32,
+                                      ops::Placeholder::Shape({6}));
+
+  auto axis = ops::Const(s.WithOpName("axis"), 0);
+  auto gather = ops::GatherV2(s.WithOpName("gather"), params, indices, axis);
+  auto mul = ops::Mul(s.WithOpName("mul"), gather, weights);
+  auto segment_sum =
+      ops::SegmentSum(s.WithOpName("segment_sum"), mul, segment_ids);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), segment_sum);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // Weights that are not broadcast along the rows can't be fused.
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "segment_sum") {
+      EXPECT_EQ(node.op(), "SegmentSum");
+    }
+  }
+}
+
+TEST_F(RemapperTest, DoNotFuseGatherWithBroadcastWeights) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto params = ops::Placeholder(s.WithOpName("params"), DT_FLOAT,
+                                 ops::Placeholder::Shape({10, 16}));
+  auto indices = ops::Placeholder(s.WithOpName("indices"), DT_INT32,
+                                  ops::Placeholder::Shape({6}));
+  auto weights = ops::Placeholder(s.WithOpName("weights"), DT_FLOAT,
+                                  ops::Placeholder::Shape({1, 1}));
+  auto unknown_weights =
+      ops::Placeholder(s.WithOpName("unknown_weights"), DT_FLOAT,
+                       ops::Placeholder::Shape({-1, 1}));
+  auto segment_ids = ops::Placeholder(s.WithOpName("segment_ids"), DT_INT32,
+                                      ops::Placeholder::Shape({6}));
+
+  auto axis = ops::Const(s.WithOpName("axis"), 0);
+  auto gather = ops::GatherV2(s.WithOpName("gather"), params, indices, axis);
+  auto mul = ops::Mul(s.WithOpName("mul"), weights, gather);
+  auto segment_sum =
+      ops::SegmentSum(s.WithOpName("segment_sum"), mul, segment_ids);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), segment_sum);
+
+  auto gather_2 =
+      ops::GatherV2(s.WithOpName("gather_2"), params, indices, axis);
+  auto mul_2 = ops::Mul(s.WithOpName("mul_2"), unknown_weights, gather_2);
+  auto segment_sum_2 =
+      ops::SegmentSum(s.WithOpName("segment_sum_2"), mul_2, segment_ids);
+  auto fetch_2 = ops::Identity(s.WithOpName("fetch_2"), segment_sum_2);
+
+  Tensor indices_t(DT_INT32, TensorShape({6}));
+  test::FillValues<int32>(&indices_t, {3, 0, 9, 3, 5, 1});
+  Tensor segment_ids_t(DT_INT32, TensorShape({6}));
+  test::FillValues<int32>(&segment_ids_t, {0, 0, 1, 3, 3, 3});
+
+  GrapplerItem item;
+  item.fetch = {"fetch", "fetch_2"};
+  item.feed = {{"params", GenerateRandomTensor<DT_FLOAT>({10, 16})},
+               {"indices", indices_t},
+               {"weights", GenerateRandomTensor<DT_FLOAT>({1, 1})},
+               {"unknown_weights", GenerateRandomTensor<DT_FLOAT>({6, 1})},
+               {"segment_ids", segment_ids_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // A single weight broadcast to all the rows, or weights of unknown length,
+  // can't be fused as one weight per index.
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "segment_sum" || node.name() == "segment_sum_2") {
+      EXPECT_EQ(node.op(), "SegmentSum");
+      found++;
+    }
+  }
+  EXPECT_EQ(2, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 2);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 2);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+  test::ExpectTensorNear<float>(tensors[1], tensors_expected[1], 1e-6);
+}
+
+TEST_F(RemapperTest, FuseMatMulWithBiasAndActivationOnVE) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs_shape = ops::Placeholder::Shape({8, 32});
+  auto rhs_shape = ops::Placeholder::Shape({32, 64});
+  auto bias_shape = ops::Placeholder::Shape({64});
+
+  auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+  auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT, rhs_shape);
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  auto relu6 = ops::Relu6(s.WithOpName("activation"), bias_add);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), relu6);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on VE. The rewritten graph is only inspected, because VE
+  // kernels are not available in tests.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:VE:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "activation") {
+      EXPECT_EQ(node.op(), "_FusedMatMul");
+      ASSERT_GE(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "lhs");
+      EXPECT_EQ(node.input(1), "rhs");
+      EXPECT_EQ(node.input(2), "bias");
+
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 2);
+      EXPECT_EQ(fused_ops[0], "BiasAdd");
+      EXPECT_EQ(fused_ops[1], "Relu6");
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+}
+
+TEST_F(RemapperTest, FuseLayerNormOnVE) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                       ops::Placeholder::Shape({8, 16, 64}));
+  auto gamma = Placeholder(s.WithOpName("gamma"), DT_FLOAT,
+                           ops::Placeholder::Shape({64}));
+  auto beta = Placeholder(s.WithOpName("beta"), DT_FLOAT,
+                          ops::Placeholder::Shape({64}));
+
+  // The graph of nn.moments and nn.batch_normalization over the last axis.
+  auto axes = ops::Const(s.WithOpName("axes"), {-1}, {1});
+  auto keep_dims = ops::Mean::KeepDims(true);
+  auto mean = ops::Mean(s.WithOpName("mean"), x, axes, keep_dims);
+  auto stop_gradient = ops::StopGradient(s.WithOpName("stop_gradient"), mean);
+  auto squared_difference = ops::SquaredDifference(
+      s.WithOpName("squared_difference"), x, stop_gradient);
+  auto variance =
+      ops::Mean(s.WithOpName("variance"), squared_difference, axes, keep_dims);
+  auto epsilon = ops::Const(s.WithOpName("epsilon"), 1e-12f);
+  auto add_epsilon = ops::AddV2(s.WithOpName("add_epsilon"), variance, epsilon);
+  auto rsqrt = ops::Rsqrt(s.WithOpName("rsqrt"), add_epsilon);
+  auto inv = ops::Mul(s.WithOpName("inv"), rsqrt, gamma);
+  auto mul_x = ops::Mul(s.WithOpName("mul_x"), x, inv);
+  auto mul_mean = ops::Mul(s.WithOpName("mul_mean"), mean, inv);
+  auto sub = ops::Sub(s.WithOpName("sub"), beta, mul_mean);
+  auto layer_norm = ops::AddV2(s.WithOpName("layer_norm"), mul_x, sub);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), layer_norm);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on VE. The rewritten graph is only inspected, because VE
+  // kernels are not available in tests.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:VE:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  const std::vector<string> fused = {
+      "mean", "stop_gradient", "squared_difference", "variance", "add_epsilon",
+      "rsqrt", "inv", "mul_x", "mul_mean", "sub"};
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    for (const string& name : fused) EXPECT_NE(node.name(), name);
+    if (node.name() == "layer_norm") {
+      EXPECT_EQ(node.op(), "_FusedLayerNorm");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "gamma");
+      EXPECT_EQ(node.input(2), "beta");
+      EXPECT_FLOAT_EQ(node.attr().at("epsilon").f(), 1e-12f);
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+}
+
+TEST_F(RemapperTest, FuseMaskedSoftmaxOnVE) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // Attention scores of [batch, heads, from, to] and a mask over `to`.
+  auto scores = Placeholder(s.WithOpName("scores"), DT_FLOAT,
+                            ops::Placeholder::Shape({2, 4, 8, 8}));
+  auto mask = Placeholder(s.WithOpName("mask"), DT_FLOAT,
+                          ops::Placeholder::Shape({2, 1, 1, 8}));
+
+  auto scale = ops::Const(s.WithOpName("scale"), 0.125f);
+  auto scaled = ops::Mul(s.WithOpName("scaled"), scores, scale);
+  auto masked = ops::Add(s.WithOpName("masked"), scaled, mask);
+  auto softmax = ops::Softmax(s.WithOpName("softmax"), masked);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), softmax);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:VE:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "scaled");
+    EXPECT_NE(node.name(), "masked");
+    if (node.name() == "softmax") {
+      EXPECT_EQ(node.op(), "_FusedMaskedSoftmax");
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "scores");
+      EXPECT_EQ(node.input(1), "mask");
+      EXPECT_FLOAT_EQ(node.attr().at("scale").f(), 0.125f);
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+}
+
 TEST_F(RemapperTest, FuseConv2DWithBiasAndActivation) {
   using ::tensorflow::ops::Placeholder;
 
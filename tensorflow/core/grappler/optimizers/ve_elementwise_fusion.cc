@@ -0,0 +1,286 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/ve_elementwise_fusion.h"
+
+#include <algorithm>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kFusedOp[] = "_VEFusedElementwise";
+
+// Upper bound on the ops of one cluster, so that the intermediates of the
+// program fit in the vector registers of a VE core.
+constexpr int kMaxFusedOps = 32;
+
+// The ops the VE FusedElementwise kernel can interpret.
+const absl::flat_hash_set<string>& UnaryOps() {
+  static const auto* ops = new absl::flat_hash_set<string>{
+      "Abs", "Exp", "Log", "Neg", "Relu", "Rsqrt", "Sigmoid", "Sqrt",
+      "Square", "Tanh"};
+  return *ops;
+}
+
+const absl::flat_hash_set<string>& BinaryOps() {
+  static const auto* ops = new absl::flat_hash_set<string>{
+      "Add", "AddV2", "Maximum", "Minimum", "Mul", "RealDiv",
+      "SquaredDifference", "Sub"};
+  return *ops;
+}
+
+bool IsOnVE(const NodeDef& node) {
+  DeviceNameUtils::ParsedName parsed;
+  return DeviceNameUtils::ParseFullName(node.device(), &parsed) &&
+         parsed.has_type && parsed.type == DEVICE_VE;
+}
+
+bool IsScalarOrHasShape(const OpInfo::TensorProperties& prop,
+                        const TensorShape& shape) {
+  TensorShape prop_shape;
+  if (!PartialTensorShape(prop.shape()).AsTensorShape(&prop_shape)) {
+    return false;
+  }
+  return prop_shape.num_elements() == 1 || prop_shape == shape;
+}
+
+class ElementwiseFuser {
+ public:
+  ElementwiseFuser(const GrapplerItem& item, const GraphProperties& properties,
+                   GraphDef* graph)
+      : properties_(properties),
+        graph_(graph),
+        node_map_(graph),
+        nodes_to_preserve_(item.NodesToPreserve()) {}
+
+  Status Run() {
+    std::vector<const NodeDef*> topo_order;
+    TF_RETURN_IF_ERROR(ComputeTopologicalOrder(*graph_, &topo_order));
+    for (int i = 0; i < topo_order.size(); ++i) {
+      topo_index_[topo_order[i]] = i;
+    }
+
+    // Grow clusters from their consumers towards their producers, so that a
+    // cluster root is never absorbed by a later cluster.
+    std::vector<NodeDef> fused_nodes;
+    std::set<string> nodes_to_delete;
+    for (auto it = topo_order.rbegin(); it != topo_order.rend(); ++it) {
+      const NodeDef* root = *it;
+      TensorShape shape;
+      if (clustered_.contains(root) || !IsCandidate(*root, &shape)) continue;
+
+      std::vector<const NodeDef*> members = GrowCluster(*root, shape);
+      if (members.size() < 2) continue;
+
+      fused_nodes.push_back(MakeFusedNode(*root, &members));
+      for (const NodeDef* member : members) {
+        clustered_.insert(member);
+        if (member != root) nodes_to_delete.insert(member->name());
+      }
+    }
+    if (fused_nodes.empty()) return Status::OK();
+
+    // Fused nodes keep the name of their root, so consumers and fetches of
+    // the cluster output stay valid.
+    for (NodeDef& fused : fused_nodes) {
+      *node_map_.GetNode(fused.name()) = std::move(fused);
+    }
+    VLOG(1) << "Fused " << nodes_to_delete.size() + fused_nodes.size()
+            << " VE elementwise ops into " << fused_nodes.size() << " nodes";
+    EraseNodesFromGraph(nodes_to_delete, graph_);
+    return Status::OK();
+  }
+
+ private:
+  // Returns true if `node` can be part of a cluster, and sets `shape` to the
+  // shape of its output.
+  bool IsCandidate(const NodeDef& node, TensorShape* shape) const {
+    const bool is_unary = UnaryOps().contains(node.op());
+    if (!is_unary && !BinaryOps().contains(node.op())) return false;
+    if (!IsOnVE(node) || nodes_to_preserve_.count(node.name()) > 0 ||
+        HasControlInputs(node)) {
+      return false;
+    }
+    const AttrValue* type = AttrSlice(node).Find("T");
+    if (type == nullptr || type->type() != DT_FLOAT) return false;
+
+    if (!properties_.HasOutputProperties(node.name())) return false;
+    const auto& outputs = properties_.GetOutputProperties(node.name());
+    if (outputs.size() != 1) return false;
+    const PartialTensorShape output_shape(outputs[0].shape());
+    if (!output_shape.AsTensorShape(shape) || shape->num_elements() == 0) {
+      return false;
+    }
+    const auto& inputs = properties_.GetInputProperties(node.name());
+    if (inputs.size() != (is_unary ? 1 : 2)) return false;
+    for (const auto& input : inputs) {
+      if (!IsScalarOrHasShape(input, *shape)) return false;
+    }
+    return true;
+  }
+
+  // Returns the nodes of the cluster rooted at `root`.
+  std::vector<const NodeDef*> GrowCluster(const NodeDef& root,
+                                          const TensorShape& shape) const {
+    std::vector<const NodeDef*> members = {&root};
+    absl::flat_hash_set<const NodeDef*> member_set = {&root};
+
+    // A producer joins once all of its consumers are members, which may only
+    // happen after another branch has been absorbed, so iterate to a fixed
+    // point.
+    bool changed = true;
+    while (changed && members.size() < kMaxFusedOps) {
+      changed = false;
+      for (int i = 0; i < members.size() && members.size() < kMaxFusedOps;
+           ++i) {
+        for (const string& input : members[i]->input()) {
+          const TensorId tensor = ParseTensorName(input);
+          const NodeDef* producer = node_map_.GetNode(tensor.node());
+          if (producer == nullptr || tensor.index() != 0 ||
+              member_set.contains(producer) || clustered_.contains(producer) ||
+              producer->device() != root.device()) {
+            continue;
+          }
+          TensorShape producer_shape;
+          if (!IsCandidate(*producer, &producer_shape) ||
+              producer_shape != shape) {
+            continue;
+          }
+          bool consumed_in_cluster = true;
+          for (const NodeDef* consumer :
+               node_map_.GetOutputs(producer->name())) {
+            if (!member_set.contains(consumer)) {
+              consumed_in_cluster = false;
+              break;
+            }
+          }
+          if (!consumed_in_cluster) continue;
+
+          members.push_back(producer);
+          member_set.insert(producer);
+          changed = true;
+          if (members.size() >= kMaxFusedOps) break;
+        }
+      }
+    }
+    return members;
+  }
+
+  // Builds the node that replaces `members`, sorting them topologically.
+  //
+  // The program is a list of ops with two operands each, -1 if unused. An
+  // operand below `N` refers to the input with that index, and operand
+  // `N + k` to the result of the k-th op. The last op produces the output.
+  NodeDef MakeFusedNode(const NodeDef& root,
+                        std::vector<const NodeDef*>* members) const {
+    std::sort(members->begin(), members->end(),
+              [this](const NodeDef* a, const NodeDef* b) {
+                return topo_index_.at(a) < topo_index_.at(b);
+              });
+    absl::flat_hash_map<const NodeDef*, int> op_index;
+    for (int i = 0; i < members->size(); ++i) {
+      op_index[(*members)[i]] = i;
+    }
+
+    // External inputs, in order of first use.
+    std::vector<string> inputs;
+    absl::flat_hash_map<string, int> input_index;
+    for (const NodeDef* member : *members) {
+      for (const string& input : member->input()) {
+        if (op_index.contains(node_map_.GetNode(NodeName(input)))) continue;
+        if (input_index.emplace(input, inputs.size()).second) {
+          inputs.push_back(input);
+        }
+      }
+    }
+
+    NodeDef fused;
+    fused.set_name(root.name());
+    fused.set_op(kFusedOp);
+    fused.set_device(root.device());
+    for (const string& input : inputs) {
+      fused.add_input(input);
+    }
+    auto* attr = fused.mutable_attr();
+    (*attr)["T"].set_type(DT_FLOAT);
+    (*attr)["N"].set_i(inputs.size());
+    auto* ops = (*attr)["ops"].mutable_list();
+    auto* operands = (*attr)["operands"].mutable_list();
+    for (const NodeDef* member : *members) {
+      ops->add_s(member->op());
+      for (int i = 0; i < 2; ++i) {
+        if (i >= member->input_size()) {
+          operands->add_i(-1);
+          continue;
+        }
+        const string& input = member->input(i);
+        auto it = op_index.find(node_map_.GetNode(NodeName(input)));
+        operands->add_i(it != op_index.end() ? inputs.size() + it->second
+                                              : input_index.at(input));
+      }
+    }
+    return fused;
+  }
+
+  const GraphProperties& properties_;
+  GraphDef* graph_;
+  NodeMap node_map_;
+  const std::unordered_set<string> nodes_to_preserve_;
+  absl::flat_hash_map<const NodeDef*, int> topo_index_;
+  absl::flat_hash_set<const NodeDef*> clustered_;
+};
+
+}  // namespace
+
+Status VEElementwiseFusion::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                     GraphDef* output) {
+  *output = item.graph;
+  const bool has_ve_nodes = std::any_of(
+      output->node().begin(), output->node().end(), [](const NodeDef& node) {
+        return IsOnVE(node) && (UnaryOps().contains(node.op()) ||
+                                BinaryOps().contains(node.op()));
+      });
+  if (!has_ve_nodes) {
+    return errors::Aborted("Nothing to do.");
+  }
+
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(/*assume_valid_feeds=*/false));
+
+  ElementwiseFuser fuser(item, properties, output);
+  return fuser.Run();
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(VEElementwiseFusion, "ve_elementwise_fusion");
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,60 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_VE_ELEMENTWISE_FUSION_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_VE_ELEMENTWISE_FUSION_H_
+
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Replaces clusters of float elementwise ops placed on the same VE by a single
+// _VEFusedElementwise node. The node carries the cluster as a small program
+// that the VE kernel interprets per vector of elements, so intermediate
+// results stay in vector registers instead of round-tripping through HBM.
+//
+// A cluster has a single output: every member except its root is consumed
+// only by other members. All members produce the shape of the root, and each
+// input of the cluster has that shape or is a scalar.
+//
+// The optimizer is registered as "ve_elementwise_fusion" and must be enabled
+// through RewriterConfig.custom_optimizers. It requires a VE kernel library
+// that provides the "FusedElementwise" kernel.
+class VEElementwiseFusion : public CustomGraphOptimizer {
+ public:
+  VEElementwiseFusion() = default;
+  ~VEElementwiseFusion() override = default;
+
+  string name() const override { return "ve_elementwise_fusion"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Init(
+      const tensorflow::RewriterConfig_CustomGraphOptimizer* config) override {
+    return Status::OK();
+  }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* output) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimize_output, double result) override {}
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_VE_ELEMENTWISE_FUSION_H_
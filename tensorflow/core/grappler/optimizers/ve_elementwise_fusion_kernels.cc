@@ -0,0 +1,187 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Op kernel for _VEFusedElementwise. The program is passed to the
+// FusedElementwise VE kernel, which interprets it over vectors of elements.
+
+#include <cstring>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/ve/ve_device.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace {
+
+// Opcodes understood by the FusedElementwise VE kernel. Must be kept in sync
+// with the VE kernel library.
+enum FusedOpcode : int32_t {
+  kAbs = 0,
+  kExp = 1,
+  kLog = 2,
+  kNeg = 3,
+  kRelu = 4,
+  kRsqrt = 5,
+  kSigmoid = 6,
+  kSqrt = 7,
+  kSquare = 8,
+  kTanh = 9,
+  kAdd = 10,
+  kMaximum = 11,
+  kMinimum = 12,
+  kMul = 13,
+  kRealDiv = 14,
+  kSquaredDifference = 15,
+  kSub = 16,
+};
+
+const absl::flat_hash_map<string, FusedOpcode>& Opcodes() {
+  static const auto* opcodes = new absl::flat_hash_map<string, FusedOpcode>{
+      {"Abs", kAbs},
+      {"Exp", kExp},
+      {"Log", kLog},
+      {"Neg", kNeg},
+      {"Relu", kRelu},
+      {"Rsqrt", kRsqrt},
+      {"Sigmoid", kSigmoid},
+      {"Sqrt", kSqrt},
+      {"Square", kSquare},
+      {"Tanh", kTanh},
+      {"Add", kAdd},
+      {"AddV2", kAdd},
+      {"Maximum", kMaximum},
+      {"Minimum", kMinimum},
+      {"Mul", kMul},
+      {"RealDiv", kRealDiv},
+      {"SquaredDifference", kSquaredDifference},
+      {"Sub", kSub},
+  };
+  return *opcodes;
+}
+
+class VEFusedElementwiseOp : public OpKernel {
+ public:
+  explicit VEFusedElementwiseOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    std::vector<string> ops;
+    std::vector<int32> operands;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("ops", &ops));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("operands", &operands));
+    OP_REQUIRES(ctx, !ops.empty() && operands.size() == 2 * ops.size(),
+                errors::InvalidArgument(
+                    "Expected two operands per op, got ", operands.size(),
+                    " operands for ", ops.size(), " ops"));
+
+    const int num_inputs = ctx->num_inputs();
+    for (int i = 0; i < ops.size(); ++i) {
+      auto it = Opcodes().find(ops[i]);
+      OP_REQUIRES(ctx, it != Opcodes().end(),
+                  errors::Unimplemented("Op ", ops[i],
+                                        " can't be fused on the VE"));
+      // An op may only use the inputs and the results of earlier ops.
+      for (int j = 0; j < 2; ++j) {
+        const int32 operand = operands[2 * i + j];
+        OP_REQUIRES(ctx, operand >= -1 && operand < num_inputs + i,
+                    errors::InvalidArgument("Invalid operand ", operand,
+                                            " of op ", i));
+      }
+      program_.push_back({it->second, operands[2 * i], operands[2 * i + 1]});
+    }
+
+    kernel_ = LookupVEKernel(ctx->device(), "FusedElementwise");
+    OP_REQUIRES(ctx, kernel_ != 0,
+                errors::Internal("VE kernel not found for FusedElementwise"));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const int num_inputs = ctx->num_inputs();
+
+    // Inputs have the shape of the output or are scalars.
+    int largest = 0;
+    for (int i = 1; i < num_inputs; ++i) {
+      if (ctx->input(i).NumElements() > ctx->input(largest).NumElements()) {
+        largest = i;
+      }
+    }
+    const TensorShape& shape = ctx->input(largest).shape();
+    for (int i = 0; i < num_inputs; ++i) {
+      const Tensor& input = ctx->input(i);
+      OP_REQUIRES(ctx, input.NumElements() == 1 || input.shape() == shape,
+                  errors::InvalidArgument(
+                      "Input ", i, " of shape ", input.shape().DebugString(),
+                      " is neither a scalar nor of shape ",
+                      shape.DebugString()));
+    }
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, shape, &output));
+    if (output->NumElements() == 0) return;
+
+    struct Input {
+      uint64_t addr;
+      int64_t nelems;
+    } __attribute__((__packed__));
+
+    struct Args {
+      int32_t dtype;
+      int32_t num_inputs;
+      int32_t num_ops;
+      int64_t nelems;
+      uint64_t out;
+      // Followed by `num_inputs` Input and `num_ops` Instruction.
+    } __attribute__((__packed__));
+
+    const size_t len = sizeof(Args) + sizeof(Input) * num_inputs +
+                       sizeof(Instruction) * program_.size();
+    std::vector<char> buf(len);
+    Args* args = reinterpret_cast<Args*>(buf.data());
+    args->dtype = output->dtype();
+    args->num_inputs = num_inputs;
+    args->num_ops = program_.size();
+    args->nelems = output->NumElements();
+    args->out = (uint64_t)DMAHelper::base(output);
+    Input* inputs = reinterpret_cast<Input*>(buf.data() + sizeof(Args));
+    for (int i = 0; i < num_inputs; ++i) {
+      inputs[i].addr = (uint64_t)DMAHelper::base(&ctx->input(i));
+      inputs[i].nelems = ctx->input(i).NumElements();
+    }
+    memcpy(inputs + num_inputs, program_.data(),
+           sizeof(Instruction) * program_.size());
+
+    VEDeviceContext* vectx = ctx->op_device_context<VEDeviceContext>();
+    Status s = vectx->Compute(kernel_, buf.data(), len, this);
+    if (!s.ok()) ctx->SetStatus(s);
+  }
+
+ private:
+  struct Instruction {
+    int32_t opcode;
+    int32_t operand0;
+    int32_t operand1;
+  } __attribute__((__packed__));
+
+  std::vector<Instruction> program_;
+  uint64_t kernel_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("_VEFusedElementwise")
+                            .Device(DEVICE_VE)
+                            .TypeConstraint<float>("T"),
+                        VEFusedElementwiseOp);
+
+}  // namespace
+}  // namespace tensorflow
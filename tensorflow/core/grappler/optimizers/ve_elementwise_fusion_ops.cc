@@ -0,0 +1,52 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Definition for the op that runs a cluster of elementwise ops fused by the
+// ve_elementwise_fusion optimizer.
+
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace {
+
+Status FusedElementwiseShapeFn(shape_inference::InferenceContext* c) {
+  shape_inference::ShapeHandle out = c->input(0);
+  for (int i = 1; i < c->num_inputs(); ++i) {
+    TF_RETURN_IF_ERROR(BroadcastBinaryOpOutputShapeFnHelper(
+        c, out, c->input(i), /*incompatible_shape_error=*/true, &out));
+  }
+  c->set_output(0, out);
+  return Status::OK();
+}
+
+// The _VEFusedElementwise op evaluates `ops` elementwise over its inputs, which
+// have the shape of the output or are scalars. Each op takes two entries of
+// `operands`, -1 if unused. An operand below N refers to that input, and
+// operand N + k to the result of the k-th op. The last op yields the output.
+REGISTER_OP("_VEFusedElementwise")
+    .Input("inputs: N * T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("N: int >= 1")
+    .Attr("ops: list(string)")
+    .Attr("operands: list(int)")
+    .SetShapeFn(FusedElementwiseShapeFn)
+    .Doc("Evaluates a fused cluster of elementwise ops on the VE.");
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,144 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/ve_elementwise_fusion.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kVEDevice[] = "/device:VE:0";
+
+class VEElementwiseFusionTest : public GrapplerTest {};
+
+TEST_F(VEElementwiseFusionTest, FuseChain) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kVEDevice);
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({4, 8}));
+  auto y = ops::Placeholder(s.WithOpName("y"), DT_FLOAT,
+                            ops::Placeholder::Shape({4, 8}));
+  auto c = ops::Const(s.WithOpName("c"), 2.0f, {});
+  auto a = ops::Mul(s.WithOpName("a"), x, c);
+  auto b = ops::Add(s.WithOpName("b"), a, y);
+  auto r = ops::Relu(s.WithOpName("r"), b);
+  auto out = ops::Identity(s.WithOpName("out"), r);
+
+  GrapplerItem item;
+  item.fetch = {"out"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  VEElementwiseFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size() - 2, output.node_size());
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE("a", node.name());
+    EXPECT_NE("b", node.name());
+    if (node.name() == "r") {
+      ++found;
+      EXPECT_EQ("_VEFusedElementwise", node.op());
+      EXPECT_EQ(kVEDevice, node.device());
+      ASSERT_EQ(3, node.input_size());
+      EXPECT_EQ("x", node.input(0));
+      EXPECT_EQ("c", node.input(1));
+      EXPECT_EQ("y", node.input(2));
+      EXPECT_EQ(3, node.attr().at("N").i());
+
+      const auto& ops = node.attr().at("ops").list();
+      ASSERT_EQ(3, ops.s_size());
+      EXPECT_EQ("Mul", ops.s(0));
+      EXPECT_EQ("Add", ops.s(1));
+      EXPECT_EQ("Relu", ops.s(2));
+
+      // Mul(x, c), Add(op 0, y), Relu(op 1).
+      const std::vector<int64> expected = {0, 1, 3, 2, 4, -1};
+      const auto& operands = node.attr().at("operands").list().i();
+      EXPECT_EQ(expected, std::vector<int64>(operands.begin(), operands.end()));
+    } else if (node.name() == "out") {
+      ++found;
+      ASSERT_EQ(1, node.input_size());
+      EXPECT_EQ("r", node.input(0));
+    }
+  }
+  EXPECT_EQ(2, found);
+}
+
+TEST_F(VEElementwiseFusionTest, KeepTensorsConsumedOutsideCluster) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kVEDevice);
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({16}));
+  auto a = ops::Exp(s.WithOpName("a"), x);
+  auto b = ops::Square(s.WithOpName("b"), a);
+  auto r = ops::Tanh(s.WithOpName("r"), b);
+  auto out_a = ops::Identity(s.WithOpName("out_a"), a);
+  auto out_r = ops::Identity(s.WithOpName("out_r"), r);
+
+  GrapplerItem item;
+  item.fetch = {"out_a", "out_r"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  VEElementwiseFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // `a` is also fetched, so only `b` and `r` are fused.
+  EXPECT_EQ(item.graph.node_size() - 1, output.node_size());
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE("b", node.name());
+    if (node.name() == "a") {
+      ++found;
+      EXPECT_EQ("Exp", node.op());
+    } else if (node.name() == "r") {
+      ++found;
+      EXPECT_EQ("_VEFusedElementwise", node.op());
+      ASSERT_EQ(1, node.input_size());
+      EXPECT_EQ("a", node.input(0));
+      EXPECT_EQ(2, node.attr().at("ops").list().s_size());
+    }
+  }
+  EXPECT_EQ(2, found);
+}
+
+TEST_F(VEElementwiseFusionTest, IgnoreOpsOnOtherDevices) {
+  tensorflow::Scope s =
+      tensorflow::Scope::NewRootScope().WithDevice("/device:CPU:0");
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({16}));
+  auto a = ops::Exp(s.WithOpName("a"), x);
+  auto r = ops::Tanh(s.WithOpName("r"), a);
+
+  GrapplerItem item;
+  item.fetch = {"r"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  VEElementwiseFusion optimizer;
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  EXPECT_TRUE(errors::IsAborted(status));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
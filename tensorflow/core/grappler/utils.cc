@@ -235,6 +235,12 @@ bool NodeIsOnGpu(const NodeDef* node) {
          absl::StartsWith(device, DEVICE_GPU);
 }
 
+bool NodeIsOnVe(const NodeDef* node) {
+  string task, device;
+  return DeviceNameUtils::SplitDeviceName(node->device(), &task, &device) &&
+         absl::StartsWith(device, DEVICE_VE);
+}
+
 int NumOutputs(const NodeDef& node, GraphDef* graph) {
   int num_outputs = 0;
   const OpDef* op_def = nullptr;
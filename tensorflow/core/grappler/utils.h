@@ -205,6 +205,9 @@ bool NodeIsOnCpu(const NodeDef* node);
 // Returns true if the node is assigned to run on GPU device.
 bool NodeIsOnGpu(const NodeDef* node);
 
+// Returns true if the node is assigned to run on VE device.
+bool NodeIsOnVe(const NodeDef* node);
+
 // Returns the number of outputs of a node according to its OpDef. Note that
 // some of the outputs may be unconnected.
 int NumOutputs(const NodeDef& node, GraphDef* graph);
@@ -271,43 +271,55 @@ class AddNOp<VEDevice, T> : public OpKernel {
     if (num == 1) {
       ctx->set_output(0, input0);
       return;
-    } else {
-      Tensor* output = nullptr;
-      OP_REQUIRES_OK(ctx, ctx->allocate_output(0, input0.shape(), &output));
-
-      struct Args {
-        int output_type;
-        uint64_t out;
-        size_t num_elems;
-        size_t num_inputs;
-        uint64_t in[1];	// variable length
-      } ;
-
-      size_t argSize = sizeof(struct Args) + sizeof(uint64_t)*(num-1) ;
-      struct Args *args = (struct Args *) malloc(argSize) ;
-
-      args->output_type = DataTypeToEnum<T>::v();
-      args->out = (uint64_t)DMAHelper::base(output);
-      args->num_elems = input0.NumElements();
-      args->num_inputs = num;
-      for (int i = 0; i < num; ++i) {
-        OP_REQUIRES(ctx, ctx->input(i).dtype() == args->output_type,
-                    errors::InvalidArgument("type mismatch"));
-        args->in[i] = (uint64_t)DMAHelper::base(&ctx->input(i));
-      }
+    }
 
-      VEDeviceContext* vectx = ctx->op_device_context<VEDeviceContext>();
-      Status s = vectx->Compute("AddN", (void*)args, argSize);
-      if (!s.ok())
-        ctx->SetStatus(s);
+    for (int i = 0; i < num; ++i) {
+      OP_REQUIRES(ctx, ctx->input(i).dtype() == DataTypeToEnum<T>::v(),
+                  errors::InvalidArgument("type mismatch"));
+    }
 
-      free(args) ;
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, input0.shape(), &output));
+    if (output->NumElements() == 0) return;
+
+    struct Args {
+      int output_type;
+      uint64_t out;
+      size_t num_elems;
+      size_t num_inputs;
+      uint64_t in[1];	// variable length
+    } ;
+
+    size_t argSize = sizeof(struct Args) + sizeof(uint64_t)*(num-1) ;
+    std::vector<char> buf(argSize);
+    struct Args *args = reinterpret_cast<struct Args*>(buf.data());
+
+    args->output_type = DataTypeToEnum<T>::v();
+    args->out = (uint64_t)DMAHelper::base(output);
+    args->num_elems = input0.NumElements();
+    args->num_inputs = num;
+    for (int i = 0; i < num; ++i) {
+      args->in[i] = (uint64_t)DMAHelper::base(&ctx->input(i));
     }
+
+    VEDeviceContext* vectx = ctx->op_device_context<VEDeviceContext>();
+    Status s = vectx->Compute("AddN", (void*)args, argSize);
+    if (!s.ok())
+      ctx->SetStatus(s);
   }
 };
 
 REGISTER_ADDN(float, VE);
 // REGISTER_ADDN(double, VE);
+
+// A special VE kernel for int32. As for GPU, all int32 inputs and outputs
+// are in host memory.
+REGISTER_KERNEL_BUILDER(Name("AddN")
+                            .Device(DEVICE_VE)
+                            .TypeConstraint<int32>("T")
+                            .HostMemory("inputs")
+                            .HostMemory("sum"),
+                        AddNOp<CPUDevice, int32>);
 #endif // TENSORFLOW_USE_VE
 
 #undef REGISTER_ADDN
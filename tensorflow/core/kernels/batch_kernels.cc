@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/split_lib.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/macros.h"
@@ -38,6 +39,12 @@ typedef Eigen::GpuDevice GPUDevice;
 typedef Eigen::SyclDevice SYCLDevice;
 #endif  // TENSORFLOW_USE_SYCL
 
+auto* batch_padding_ratio = monitoring::Sampler<0>::New(
+    {"/tensorflow/serving/batching/padding_ratio",
+     "The fraction of each processed batch that is padding."},
+    monitoring::Buckets::Explicit(
+        {0.0, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9}));
+
 // Concatenates 'inputs' into a single tensor along the zeroth dimension.
 // Requires that all elements of 'inputs' have element type T. Writes to the
 // op's output at position 'output_index', using 'context' for the allocation to
@@ -228,6 +235,16 @@ class BatchResource : public ResourceBase {
         max_enqueued_batches;
     new_resource->batcher_queue_options_.batch_timeout_micros =
         batch_timeout_micros;
+    new_resource->batcher_queue_options_.get_task_deadline_micros =
+        [](const BatchTask& task) { return task.deadline_micros; };
+    if (fhandle != kInvalidHandle) {
+      // The outputs of a function can be split and reassembled, so requests
+      // larger than a batch are accepted, and batches are cut to pad less.
+      new_resource->batcher_queue_options_.split_input_task_func =
+          SplitInputTask;
+      new_resource->batcher_queue_options_.allowed_batch_sizes.assign(
+          allowed_batch_sizes.begin(), allowed_batch_sizes.end());
+    }
 
     new_resource->allowed_batch_sizes_ = allowed_batch_sizes;
 
@@ -240,12 +257,19 @@ class BatchResource : public ResourceBase {
   string DebugString() const final { return "BatchResource"; }
 
   // Ingests data from one invocation of the batch op. The data is enqueued to
-  // be combined with others into a batch, asynchronously.
+  // be combined with others into a batch, asynchronously. If
+  // 'latency_budget_micros' is positive, the batch is processed early enough
+  // to be done within that time if possible.
   Status RegisterInput(int64 guid, OpKernelContext* context,
                        const string& batcher_queue_name,
+                       int64 latency_budget_micros,
                        AsyncOpKernel::DoneCallback done_callback) {
     std::unique_ptr<BatchTask> batch_components(new BatchTask);
     batch_components->guid = guid;
+    if (latency_budget_micros > 0) {
+      batch_components->deadline_micros =
+          Env::Default()->NowMicros() + latency_budget_micros;
+    }
     batch_components->propagated_context = Context(ContextKind::kThread);
     OpInputList tensors;
     TF_RETURN_IF_ERROR(context->input_list("in_tensors", &tensors));
@@ -283,6 +307,20 @@ class BatchResource : public ResourceBase {
  private:
   BatchResource() = default;
 
+  // The state shared by the pieces of an invocation split across batches, to
+  // reassemble its outputs once all of them are done.
+  struct SplitState {
+    OpKernelContext* context;
+    AsyncOpKernel::DoneCallback done_callback;
+
+    mutex mu;
+    // The total size of the pieces that are not done yet.
+    int64 pending_size GUARDED_BY(mu);
+    Status status GUARDED_BY(mu);
+    // The offset of each done piece in the invocation -> its outputs.
+    std::map<int64, std::vector<Tensor>> outputs GUARDED_BY(mu);
+  };
+
   // One input to be batched. Corresponds to one invocation of the batch op.
   struct BatchTask : public serving::BatchTask {
     // A unique ID to identify this invocation of Batch.
@@ -295,6 +333,16 @@ class BatchResource : public ResourceBase {
     OpKernelContext* context;
     AsyncOpKernel::DoneCallback done_callback;
 
+    // The time by which the batch of this invocation should be done, or 0.
+    uint64 deadline_micros = 0;
+
+    // Set for a piece of an invocation split across batches, which reports to
+    // 'split' rather than to 'context'. The piece starts at 'split_offset' in
+    // the 0th dimension of the invocation's tensors.
+    std::shared_ptr<SplitState> split;
+    int64 split_offset = 0;
+    std::vector<Tensor> split_outputs;
+
     size_t size() const override { return inputs[0].shape().dim_size(0); }
   };
 
@@ -302,6 +350,105 @@ class BatchResource : public ResourceBase {
   using BatcherQueue = serving::BatchScheduler<BatchTask>;
   using Batch = serving::Batch<BatchTask>;
 
+  // Splits an invocation, or a piece of one, into pieces along the 0th
+  // dimension of its inputs. See QueueOptions::split_input_task_func.
+  static Status SplitInputTask(
+      std::unique_ptr<BatchTask>* input_task,
+      const std::vector<size_t>& output_task_sizes,
+      std::vector<std::unique_ptr<BatchTask>>* output_tasks) {
+    BatchTask& input = **input_task;
+    std::shared_ptr<SplitState> split = input.split;
+    if (split == nullptr) {
+      split = std::make_shared<SplitState>();
+      split->context = input.context;
+      split->done_callback = input.done_callback;
+      split->pending_size = input.size();
+    }
+    int64 start = 0;
+    for (const size_t size : output_task_sizes) {
+      std::unique_ptr<BatchTask> piece(new BatchTask);
+      piece->guid = input.guid;
+      piece->propagated_context = input.propagated_context;
+      for (const Tensor& tensor : input.inputs) {
+        Tensor slice = tensor.Slice(start, start + size);
+        // Kernels expect aligned tensors.
+        piece->inputs.push_back(slice.IsAligned() ? slice
+                                                  : tensor::DeepCopy(slice));
+      }
+      piece->captured_inputs = input.captured_inputs;
+      piece->context = input.context;
+      piece->deadline_micros = input.deadline_micros;
+      piece->split = split;
+      piece->split_offset = input.split_offset + start;
+      output_tasks->push_back(std::move(piece));
+      start += size;
+    }
+    DCHECK_EQ(start, input.size());
+    input_task->reset();
+    return Status::OK();
+  }
+
+  // Reports that 'piece' is done with 'status'. Once all pieces of its
+  // invocation are, sets the invocation's outputs to the concatenation of
+  // theirs, and calls its done callback.
+  static void FinishPiece(BatchTask* piece, const Status& status) {
+    SplitState* split = piece->split.get();
+    Status final_status;
+    {
+      mutex_lock l(split->mu);
+      split->status.Update(status);
+      split->outputs[piece->split_offset] = std::move(piece->split_outputs);
+      split->pending_size -= piece->size();
+      if (split->pending_size > 0) {
+        return;
+      }
+      final_status = split->status;
+      if (final_status.ok()) {
+        final_status = ConcatSplitOutputs(split);
+      }
+    }
+    split->context->SetStatus(final_status);
+    split->done_callback();
+  }
+
+  static Status ConcatSplitOutputs(SplitState* split)
+      EXCLUSIVE_LOCKS_REQUIRED(split->mu) {
+    const size_t num_outputs = split->outputs.begin()->second.size();
+    for (size_t i = 0; i < num_outputs; ++i) {
+      std::vector<Tensor> to_concatenate;
+      to_concatenate.reserve(split->outputs.size());
+      for (const auto& piece_outputs : split->outputs) {
+        if (piece_outputs.second.size() != num_outputs) {
+          return errors::Internal("Pieces of a split invocation have ",
+                                  piece_outputs.second.size(), " and ",
+                                  num_outputs, " outputs");
+        }
+        to_concatenate.push_back(piece_outputs.second[i]);
+      }
+      Tensor output;
+      TF_RETURN_IF_ERROR(
+          ConcatTensors(split->context, to_concatenate, &output));
+      split->context->set_output(i, output);
+    }
+    return Status::OK();
+  }
+
+  // Concatenates 'inputs' along the 0th dimension, whatever their type.
+  static Status ConcatTensors(OpKernelContext* context,
+                              const std::vector<Tensor>& inputs,
+                              Tensor* output) {
+    const DataType type = inputs[0].dtype();
+    switch (type) {
+#define CASE(type)                  \
+  case DataTypeToEnum<type>::value: \
+    return Concat<type>(context, inputs, output);
+      TF_CALL_ALL_TYPES(CASE);
+#undef CASE
+      default:
+        return errors::InvalidArgument("Unsupported data type: ", type);
+    }
+  }
+
   // Validates that it's legal to combine the tasks in 'batch' into a batch.
   // Assumes the batch is non-empty.
   static Status ValidateBatch(const Batch& batch) {
@@ -342,6 +489,10 @@ class BatchResource : public ResourceBase {
 
     const int padded_batch_size = RoundToLowestAllowedBatchSize(batch.size());
     const int padding_amount = padded_batch_size - batch.size();
+    if (padded_batch_size > 0) {
+      batch_padding_ratio->GetCell()->Add(static_cast<double>(padding_amount) /
+                                          padded_batch_size);
+    }
 
     // All tasks should have the same number of input edges.
     const int num_inputs = batch.task(0).inputs.size();
@@ -389,23 +540,9 @@ class BatchResource : public ResourceBase {
         }
       }
 
-      const DataType type = to_concatenate[0].dtype();
-      Status concat_status;
       Tensor concatenated_tensor;
-      switch (type) {
-#define CASE(type)                                                   \
-  case DataTypeToEnum<type>::value:                                  \
-    concat_status =                                                  \
-        Concat<type>(context, to_concatenate, &concatenated_tensor); \
-    break;
-        TF_CALL_ALL_TYPES(CASE);
-#undef CASE
-        default:
-          concat_status =
-              errors::InvalidArgument("Unsupported data type: ", type);
-          break;
-      }
-      TF_RETURN_IF_ERROR(concat_status);
+      TF_RETURN_IF_ERROR(
+          ConcatTensors(context, to_concatenate, &concatenated_tensor));
       concatenated_tensors->push_back(concatenated_tensor);
     }
     return Status::OK();
@@ -469,7 +606,11 @@ class BatchResource : public ResourceBase {
 
       for (int j = 0; j < batch->num_tasks(); ++j) {
         BatchTask& task = *(batch->mutable_task(j));
-        task.context->set_output(i, split_tensor.at(j));
+        if (task.split != nullptr) {
+          task.split_outputs.push_back(split_tensor.at(j));
+        } else {
+          task.context->set_output(i, split_tensor.at(j));
+        }
       }  // (Ignore a possible final split_tensors entry containing the
          // padding.)
     }
@@ -500,8 +641,13 @@ class BatchResource : public ResourceBase {
         return;
       }
       for (int i = 0; i < batch->num_tasks(); ++i) {
-        batch->mutable_task(i)->context->SetStatus(status);
-        batch->mutable_task(i)->done_callback();
+        BatchTask* task = batch->mutable_task(i);
+        if (task->split != nullptr) {
+          FinishPiece(task, status);
+          continue;
+        }
+        task->context->SetStatus(status);
+        task->done_callback();
       }
       cleanup_done = true;
     };
@@ -720,6 +866,12 @@ class BatchFunctionKernel : public AsyncOpKernel {
                    c->GetAttr("max_enqueued_batches", &max_enqueued_batches_));
     OP_REQUIRES_OK(c, c->GetAttr("allowed_batch_sizes", &allowed_batch_sizes_));
     OP_REQUIRES_OK(c, ValidateAllowedBatchSizes());
+    OP_REQUIRES_OK(
+        c, c->GetAttr("latency_budget_micros", &latency_budget_micros_));
+    OP_REQUIRES(c, latency_budget_micros_ >= 0,
+                errors::InvalidArgument(
+                    "latency_budget_micros must be non-negative; was ",
+                    latency_budget_micros_));
 
     auto lib = c->function_library();
     OP_REQUIRES(c, lib != nullptr, errors::Internal("No function library"));
@@ -747,7 +899,8 @@ class BatchFunctionKernel : public AsyncOpKernel {
                              container_, shared_name_, &br, creator),
                          done);
     const Status status =
-        br->RegisterInput(random::New64(), c, batcher_queue_, done);
+        br->RegisterInput(random::New64(), c, batcher_queue_,
+                          latency_budget_micros_, done);
     br->Unref();
     OP_REQUIRES_OK_ASYNC(c, status, done);
     // Assume br calls done, so nothing to do here.
@@ -784,6 +937,7 @@ class BatchFunctionKernel : public AsyncOpKernel {
   int32 batch_timeout_micros_;
   int32 max_enqueued_batches_;
   std::vector<int32> allowed_batch_sizes_;
+  int64 latency_budget_micros_;
   FunctionLibraryRuntime::Handle fhandle_;
 };
 
@@ -827,7 +981,8 @@ class BatchKernel : public AsyncOpKernel {
                              container_, shared_name_, &br, creator),
                          done);
     const Status status =
-        br->RegisterInput(random::New64(), c, batcher_queue_, done);
+        br->RegisterInput(random::New64(), c, batcher_queue_,
+                          /*latency_budget_micros=*/0, done);
     br->Unref();
     OP_REQUIRES_OK_ASYNC(c, status, done);
     // Assume br calls done, so nothing to do here.
@@ -745,13 +745,12 @@ class BaseBatchMatMulOp<VEDevice, Scalar> : public OpKernel {
     if (out->NumElements() == 0) {
       return;
     }
-
-#if 0
     if (in0.NumElements() == 0 || in1.NumElements() == 0) {
-      functor::SetZeroFunctor<Device, Scalar> f;
-      f(ctx->eigen_device<Device>(), out->flat<Scalar>());
+      functor::VESetZeroFunctor<Scalar>(ctx, out);
       return;
     }
+
+#if 0
     Tensor out_reshaped;
     OP_REQUIRES(ctx,
                 out_reshaped.CopyFrom(*out, TensorShape({batch_size, d0, d3})),
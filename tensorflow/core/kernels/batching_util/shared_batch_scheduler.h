@@ -18,9 +18,11 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <deque>
 #include <functional>
 #include <list>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -93,6 +95,13 @@ namespace serving {
 // For bulk processing jobs and throughput-oriented benchmarks, you may want to
 // set the maximum queue size to a large value.
 //
+// Tasks may also carry deadlines (see QueueOptions::get_task_deadline_micros),
+// in which case a queue closes its open batch as late as it can while still
+// meeting the earliest deadline of its tasks, given how long batches of that
+// size have taken to process so far. This serves requests with different
+// latency budgets from one queue, without a timeout that is either too short
+// for throughput or too long for the tightest budget.
+//
 // TODO(b/26539183): Support queue servicing policies other than round-robin.
 // E.g. let each queue specify a "share" (an int >= 1), so e.g. with queues A
 // and B having shares 1 and 2 respectively, the servicing pattern is ABBABB...
@@ -160,6 +169,33 @@ class SharedBatchScheduler
     // See the class documentation above for guidelines on how to tune this
     // parameter.
     size_t max_enqueued_batches = 10;
+
+    // If set, returns the time (per Env::NowMicros()) by which 'task' should
+    // have been processed, or 0 if it has no deadline. The open batch is then
+    // also closed once waiting any longer would miss the earliest deadline of
+    // its tasks, given a moving average of the time taken to process the
+    // batches of each size so far. 'batch_timeout_micros' still bounds the
+    // wait, e.g. of tasks without deadlines.
+    std::function<uint64(const TaskType&)> get_task_deadline_micros;
+
+    // If set, splits '*input_task' into tasks of 'output_task_sizes', which
+    // add up to its size, appending them to 'output_tasks' in order. On error,
+    // '*input_task' is left as-is. Tasks larger than 'max_batch_size' are then
+    // accepted, and each task is split to fill the open batch up to
+    // 'max_batch_size' before starting a new one.
+    std::function<Status(std::unique_ptr<TaskType>* input_task,
+                         const std::vector<size_t>& output_task_sizes,
+                         std::vector<std::unique_ptr<TaskType>>* output_tasks)>
+        split_input_task_func;
+
+    // If non-empty, the increasing batch sizes to which the process-batch
+    // callback pads batches, the last one being 'max_batch_size'. With
+    // 'split_input_task_func', an open batch closed before it is full is cut
+    // at the largest allowed size below its size if that pads less overall,
+    // e.g. a batch of 33 with allowed sizes {8, 16, 32, 64} is processed as a
+    // batch of 32 and then one of 1, padded to 8, rather than one padded to
+    // 64.
+    std::vector<size_t> allowed_batch_sizes;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -283,10 +319,25 @@ class Queue {
   // fresh open batch behind it.
   void StartNewBatch() EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Like StartNewBatch(), but first cuts the open batch at the size returned
+  // by PaddingMinimizingCutSize(), moving the tasks past it, or the part of a
+  // task across it, to the fresh open batch.
+  void CloseOpenBatch() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the size at which to cut an open batch of 'batch_size' before
+  // closing it to minimize padding, or 'batch_size' not to cut it.
+  size_t PaddingMinimizingCutSize(size_t batch_size) const;
+
   // Determines whether the open batch residing at the back of 'batches_' is
   // currently schedulable.
   bool IsOpenBatchSchedulable() const EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Returns the predicted time to process a batch of 'batch_size': that of the
+  // smallest batch size at least as large with observations, or else of the
+  // largest one, or 0 without observations.
+  uint64 PredictProcessingTimeMicros(size_t batch_size) const
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   const typename SharedBatchScheduler<TaskType>::QueueOptions options_;
 
   // The environment to use.
@@ -314,6 +365,14 @@ class Queue {
   // in 'batches_'. Valid iff that batch contains at least one task.
   uint64 open_batch_start_time_micros_ GUARDED_BY(mu_);
 
+  // The earliest deadline of the tasks in the open batch, or 0 if none of them
+  // has one. Only used with 'options_.get_task_deadline_micros'.
+  uint64 open_batch_deadline_micros_ GUARDED_BY(mu_) = 0;
+
+  // Batch size -> moving average of the time taken to process batches of that
+  // size. Only used with 'options_.get_task_deadline_micros'.
+  std::map<size_t, double> processing_time_micros_ GUARDED_BY(mu_);
+
   // Whether this queue contains a batch that is eligible to be scheduled. Used
   // to keep track of when to call 'schedulable_batch_callback_'.
   bool schedulable_batch_ GUARDED_BY(mu_) = false;
@@ -410,6 +469,18 @@ Status SharedBatchScheduler<TaskType>::AddQueue(
         "max_enqueued_batches must be non-negative; was ",
         options.max_enqueued_batches);
   }
+  for (size_t i = 0; i < options.allowed_batch_sizes.size(); ++i) {
+    if (i > 0 &&
+        options.allowed_batch_sizes[i] <= options.allowed_batch_sizes[i - 1]) {
+      return errors::InvalidArgument(
+          "allowed_batch_sizes entries must be monotonically increasing");
+    }
+  }
+  if (!options.allowed_batch_sizes.empty() &&
+      options.allowed_batch_sizes.back() != options.max_batch_size) {
+    return errors::InvalidArgument(
+        "final entry in allowed_batch_sizes must equal max_batch_size");
+  }
 
   auto schedulable_batch_callback = [this] {
     mutex_lock l(mu_);
@@ -530,30 +601,72 @@ template <typename TaskType>
 Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
   profiler::TraceMe trace_me(
       [task] { return strings::StrCat("Schedule:", (*task)->size()); });
-  if ((*task)->size() > options_.max_batch_size) {
+  if ((*task)->size() > options_.max_batch_size &&
+      !options_.split_input_task_func) {
     return errors::InvalidArgument("Task size ", (*task)->size(),
                                    " is larger than maximum batch size ",
                                    options_.max_batch_size);
   }
 
+  const uint64 deadline_micros = options_.get_task_deadline_micros
+                                     ? options_.get_task_deadline_micros(**task)
+                                     : 0;
+
   bool notify_of_schedulable_batch = false;
   {
     mutex_lock l(mu_);
 
     DCHECK(!closed_);
 
-    if (batches_.back()->size() + (*task)->size() > options_.max_batch_size) {
-      if (batches_.size() >= options_.max_enqueued_batches) {
-        return errors::Unavailable(
-            "The batch scheduling queue to which this task was submitted is "
-            "full");
+    // The task goes into the open batch if it fits. Otherwise, it goes into a
+    // new batch, or is split to fill the open batch and then new ones.
+    const size_t task_size = (*task)->size();
+    const size_t open_batch_room =
+        options_.max_batch_size - batches_.back()->size();
+    std::vector<size_t> piece_sizes;
+    size_t num_new_batches = 0;
+    if (task_size <= open_batch_room) {
+      piece_sizes.push_back(task_size);
+    } else if (options_.split_input_task_func) {
+      if (open_batch_room > 0) {
+        piece_sizes.push_back(open_batch_room);
+      }
+      for (size_t rest = task_size - open_batch_room; rest > 0;) {
+        piece_sizes.push_back(std::min(rest, options_.max_batch_size));
+        rest -= piece_sizes.back();
+        ++num_new_batches;
+      }
+    } else {
+      piece_sizes.push_back(task_size);
+      num_new_batches = 1;
+    }
+    if (batches_.size() + num_new_batches > options_.max_enqueued_batches) {
+      return errors::Unavailable(
+          "The batch scheduling queue to which this task was submitted is "
+          "full");
+    }
+    std::vector<std::unique_ptr<TaskType>> pieces;
+    if (piece_sizes.size() > 1) {
+      TF_RETURN_IF_ERROR(
+          options_.split_input_task_func(task, piece_sizes, &pieces));
+    } else {
+      pieces.push_back(std::move(*task));
+    }
+
+    for (auto& piece : pieces) {
+      if (batches_.back()->size() + piece->size() > options_.max_batch_size) {
+        StartNewBatch();
       }
-      StartNewBatch();
+      if (batches_.back()->empty()) {
+        open_batch_start_time_micros_ = env_->NowMicros();
+      }
+      batches_.back()->AddTask(std::move(piece));
     }
-    if (batches_.back()->empty()) {
-      open_batch_start_time_micros_ = env_->NowMicros();
+    if (deadline_micros > 0 &&
+        (open_batch_deadline_micros_ == 0 ||
+         deadline_micros < open_batch_deadline_micros_)) {
+      open_batch_deadline_micros_ = deadline_micros;
     }
-    batches_.back()->AddTask(std::move(*task));
 
     if (!schedulable_batch_) {
       if (batches_.size() > 1 || IsOpenBatchSchedulable()) {
@@ -602,7 +715,7 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
 
     // Consider closing the open batch at this time, to schedule it.
     if (batches_.size() == 1 && IsOpenBatchSchedulable()) {
-      StartNewBatch();
+      CloseOpenBatch();
     }
 
     if (batches_.size() >= 2) {
@@ -622,10 +735,23 @@ template <typename TaskType>
 void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
   profiler::TraceMe trace_me(
       [&batch] { return strings::StrCat("ProcessBatch:", batch->size()); });
+  const size_t batch_size = batch->size();
+  const uint64 start_time_micros = env_->NowMicros();
   process_batch_callback_(std::move(batch));
+  const uint64 processing_time_micros = env_->NowMicros() - start_time_micros;
 
   {
     mutex_lock l(mu_);
+    if (options_.get_task_deadline_micros) {
+      // An exponential moving average, which follows changes in the load.
+      const double kDecay = 0.9;
+      auto result = processing_time_micros_.emplace(batch_size,
+                                                    processing_time_micros);
+      if (!result.second) {
+        result.first->second = kDecay * result.first->second +
+                               (1 - kDecay) * processing_time_micros;
+      }
+    }
     --num_batches_being_processed_;
     if (empty_notification_ != nullptr && IsEmptyInternal()) {
       empty_notification_->Notify();
@@ -665,6 +791,86 @@ template <typename TaskType>
 void Queue<TaskType>::StartNewBatch() {
   batches_.back()->Close();
   batches_.emplace_back(new Batch<TaskType>);
+  open_batch_deadline_micros_ = 0;
+}
+
+template <typename TaskType>
+void Queue<TaskType>::CloseOpenBatch() {
+  Batch<TaskType>* open_batch = batches_.back().get();
+  const size_t cut_size = PaddingMinimizingCutSize(open_batch->size());
+  if (cut_size == open_batch->size()) {
+    StartNewBatch();
+    return;
+  }
+
+  // The tasks to move, in reverse order.
+  std::vector<std::unique_ptr<TaskType>> moved_tasks;
+  while (open_batch->size() > cut_size) {
+    moved_tasks.push_back(open_batch->RemoveTask());
+  }
+  if (open_batch->size() < cut_size) {
+    // Splits the task across the cut.
+    std::unique_ptr<TaskType> task = std::move(moved_tasks.back());
+    moved_tasks.pop_back();
+    const size_t first_size = cut_size - open_batch->size();
+    std::vector<std::unique_ptr<TaskType>> pieces;
+    const Status status = options_.split_input_task_func(
+        &task, {first_size, task->size() - first_size}, &pieces);
+    if (status.ok()) {
+      open_batch->AddTask(std::move(pieces[0]));
+      moved_tasks.push_back(std::move(pieces[1]));
+    } else {
+      VLOG(1) << "Not cutting batch to minimize padding: " << status;
+      moved_tasks.push_back(std::move(task));
+      while (!moved_tasks.empty()) {
+        open_batch->AddTask(std::move(moved_tasks.back()));
+        moved_tasks.pop_back();
+      }
+    }
+  }
+
+  // The moved tasks have waited as long as the batch they were cut from.
+  const uint64 start_time_micros = open_batch_start_time_micros_;
+  StartNewBatch();
+  open_batch_start_time_micros_ = start_time_micros;
+  while (!moved_tasks.empty()) {
+    std::unique_ptr<TaskType>& task = moved_tasks.back();
+    if (options_.get_task_deadline_micros) {
+      const uint64 deadline_micros = options_.get_task_deadline_micros(*task);
+      if (deadline_micros > 0 &&
+          (open_batch_deadline_micros_ == 0 ||
+           deadline_micros < open_batch_deadline_micros_)) {
+        open_batch_deadline_micros_ = deadline_micros;
+      }
+    }
+    batches_.back()->AddTask(std::move(task));
+    moved_tasks.pop_back();
+  }
+}
+
+template <typename TaskType>
+size_t Queue<TaskType>::PaddingMinimizingCutSize(size_t batch_size) const {
+  const std::vector<size_t>& allowed_sizes = options_.allowed_batch_sizes;
+  if (!options_.split_input_task_func || allowed_sizes.empty()) {
+    return batch_size;
+  }
+  // The padded size of a batch, as in the process-batch callback.
+  auto padded_size = [&allowed_sizes](size_t size) {
+    auto it = std::lower_bound(allowed_sizes.begin(), allowed_sizes.end(),
+                               size);
+    return it == allowed_sizes.end() ? size : *it;
+  };
+  auto it =
+      std::lower_bound(allowed_sizes.begin(), allowed_sizes.end(), batch_size);
+  if (it == allowed_sizes.begin() ||
+      (it != allowed_sizes.end() && *it == batch_size)) {
+    return batch_size;
+  }
+  const size_t cut_size = *(it - 1);
+  const size_t rest_size = batch_size - cut_size;
+  const size_t padding = padded_size(batch_size) - batch_size;
+  const size_t cut_padding = padded_size(rest_size) - rest_size;
+  return cut_padding < padding ? cut_size : batch_size;
 }
 
 template <typename TaskType>
@@ -673,9 +879,30 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= options_.max_batch_size ||
-         env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+  if (closed_ || open_batch->size() >= options_.max_batch_size) {
+    return true;
+  }
+  const uint64 now_micros = env_->NowMicros();
+  if (now_micros >=
+      open_batch_start_time_micros_ + options_.batch_timeout_micros) {
+    return true;
+  }
+  // Waiting any longer would miss the earliest deadline.
+  return open_batch_deadline_micros_ > 0 &&
+         now_micros + PredictProcessingTimeMicros(open_batch->size()) >=
+             open_batch_deadline_micros_;
+}
+
+template <typename TaskType>
+uint64 Queue<TaskType>::PredictProcessingTimeMicros(size_t batch_size) const {
+  if (processing_time_micros_.empty()) {
+    return 0;
+  }
+  auto it = processing_time_micros_.lower_bound(batch_size);
+  if (it == processing_time_micros_.end()) {
+    --it;
+  }
+  return static_cast<uint64>(it->second);
 }
 
 template <typename TaskType>
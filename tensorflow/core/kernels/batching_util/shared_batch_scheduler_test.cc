@@ -254,6 +254,158 @@ TEST(SharedBatchSchedulerTest, ObeysTimeout) {
   stop_teardown.Notify();
 }
 
+TEST(SharedBatchSchedulerTest, ObeysDeadlines) {
+  // Set up a fake clock, which only advances when we explicitly tell it to.
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    mutex mu;
+    int num_batches_processed = 0;
+    // Each batch takes 30 microseconds to process.
+    auto callback = [&env, &mu, &num_batches_processed](
+                        std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      env.AdvanceByMicroseconds(30);
+      mutex_lock l(mu);
+      ++num_batches_processed;
+    };
+    auto num_processed = [&mu, &num_batches_processed] {
+      mutex_lock l(mu);
+      return num_batches_processed;
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 4;
+    queue_options.batch_timeout_micros = 1000 * 1000;
+    queue_options.max_enqueued_batches = 2;
+    // Tasks of size 1 must be done 100 microseconds after they are scheduled;
+    // the others have no deadline.
+    queue_options.get_task_deadline_micros = [&env](const FakeTask& task) {
+      return task.size() == 1 ? env.NowMicros() + 100 : 0;
+    };
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // Without observed processing times, the batch waits until the deadline.
+    TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    env.AdvanceByMicroseconds(99);
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_EQ(0, num_processed());
+    env.AdvanceByMicroseconds(1);
+    while (num_processed() < 1) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+
+    // Batches of size 3 take 30 microseconds, so the next one closes 30
+    // microseconds before the deadline.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+    env.AdvanceByMicroseconds(69);
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_EQ(1, num_processed());
+    env.AdvanceByMicroseconds(1);
+    while (num_processed() < 2) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+// Splits a FakeTask into FakeTasks of the given sizes.
+Status SplitFakeTask(std::unique_ptr<FakeTask>* input_task,
+                     const std::vector<size_t>& output_task_sizes,
+                     std::vector<std::unique_ptr<FakeTask>>* output_tasks) {
+  for (const size_t size : output_task_sizes) {
+    output_tasks->emplace_back(new FakeTask(size));
+  }
+  input_task->reset();
+  return Status::OK();
+}
+
+TEST(SharedBatchSchedulerTest, SplitsLargeTasks) {
+  mutex mu;
+  std::vector<std::vector<size_t>> callback_data;
+  auto callback = [&mu,
+                   &callback_data](std::unique_ptr<Batch<FakeTask>> batch) {
+    ASSERT_TRUE(batch->IsClosed());
+    std::vector<size_t> batch_data;
+    for (int i = 0; i < batch->num_tasks(); ++i) {
+      batch_data.push_back(batch->mutable_task(i)->size());
+    }
+    mutex_lock l(mu);
+    callback_data.push_back(batch_data);
+  };
+  {
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 4;
+    queue_options.batch_timeout_micros = 10 * 1000 * 1000;  // 10 seconds
+    queue_options.max_enqueued_batches = 3;
+    queue_options.split_input_task_func = SplitFakeTask;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // The task of size 6 fills the first batch, then a second one, and starts
+    // a third one.
+    TF_ASSERT_OK(ScheduleTask(3, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(6, queue.get()));
+    // A task of size 16 would need more batches than are allowed.
+    EXPECT_EQ(error::UNAVAILABLE, ScheduleTask(16, queue.get()).code());
+  }
+  mutex_lock l(mu);
+  EXPECT_EQ((std::vector<std::vector<size_t>>{{3, 1}, {4}, {1}}),
+            callback_data);
+}
+
+TEST(SharedBatchSchedulerTest, CutsBatchesToMinimizePadding) {
+  mutex mu;
+  std::vector<std::vector<size_t>> callback_data;
+  auto callback = [&mu,
+                   &callback_data](std::unique_ptr<Batch<FakeTask>> batch) {
+    ASSERT_TRUE(batch->IsClosed());
+    std::vector<size_t> batch_data;
+    for (int i = 0; i < batch->num_tasks(); ++i) {
+      batch_data.push_back(batch->mutable_task(i)->size());
+    }
+    mutex_lock l(mu);
+    callback_data.push_back(batch_data);
+  };
+  {
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 8;
+    queue_options.batch_timeout_micros = 10 * 1000 * 1000;  // 10 seconds
+    queue_options.split_input_task_func = SplitFakeTask;
+    queue_options.allowed_batch_sizes = {1, 2, 4, 8};
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // A batch of 5 would be padded to 8, while batches of 4 and 1 need no
+    // padding.
+    TF_ASSERT_OK(ScheduleTask(3, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+  }
+  mutex_lock l(mu);
+  EXPECT_EQ((std::vector<std::vector<size_t>>{{3, 1}, {1}}), callback_data);
+}
+
 TEST(SharedBatchSchedulerTest, ObeysTimeoutWithRealClock) {
   Notification first_batch_processed, second_batch_processed;
   auto callback = [&first_batch_processed, &second_batch_processed](
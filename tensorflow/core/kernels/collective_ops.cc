@@ -138,6 +138,16 @@ REGISTER_KERNEL_BUILDER(Name("CollectiveGather").Device(DEVICE_CPU),
                         CollectiveGatherOpKernel);
 REGISTER_KERNEL_BUILDER(Name("CollectiveGather").Device(DEVICE_GPU),
                         CollectiveGatherOpKernel);
+#ifdef TENSORFLOW_USE_VE
+#define REGISTER_VE(T)                                      \
+  REGISTER_KERNEL_BUILDER(Name("CollectiveGather")          \
+                              .Device(DEVICE_VE)            \
+                              .TypeConstraint<T>("T"),      \
+                          CollectiveGatherOpKernel);
+TF_CALL_float(REGISTER_VE);
+TF_CALL_int64(REGISTER_VE);
+#undef REGISTER_VE
+#endif  // TENSORFLOW_USE_VE
 
 class CollectiveReduceOpKernel : public CollectiveOpKernel {
  public:
@@ -259,6 +269,14 @@ REGISTER_KERNEL_BUILDER(Name("CollectiveReduce").Device(DEVICE_CPU),
                         CollectiveReduceOpKernel);
 REGISTER_KERNEL_BUILDER(Name("CollectiveReduce").Device(DEVICE_GPU),
                         CollectiveReduceOpKernel);
+#ifdef TENSORFLOW_USE_VE
+// merge_op and final_op run as VE kernels on the VE, which has float Add, Mul,
+// Maximum, Minimum and Div kernels.
+REGISTER_KERNEL_BUILDER(Name("CollectiveReduce")
+                            .Device(DEVICE_VE)
+                            .TypeConstraint<float>("T"),
+                        CollectiveReduceOpKernel);
+#endif  // TENSORFLOW_USE_VE
 
 class CollectiveBcastSendOpKernel : public CollectiveOpKernel {
  public:
@@ -335,6 +353,16 @@ REGISTER_KERNEL_BUILDER(Name("CollectiveBcastSend").Device(DEVICE_CPU),
                         CollectiveBcastSendOpKernel);
 REGISTER_KERNEL_BUILDER(Name("CollectiveBcastSend").Device(DEVICE_GPU),
                         CollectiveBcastSendOpKernel);
+#ifdef TENSORFLOW_USE_VE
+#define REGISTER_VE(T)                                      \
+  REGISTER_KERNEL_BUILDER(Name("CollectiveBcastSend")       \
+                              .Device(DEVICE_VE)            \
+                              .TypeConstraint<T>("T"),      \
+                          CollectiveBcastSendOpKernel);
+TF_CALL_float(REGISTER_VE);
+TF_CALL_int64(REGISTER_VE);
+#undef REGISTER_VE
+#endif  // TENSORFLOW_USE_VE
 
 class CollectiveBcastRecvOpKernel : public CollectiveOpKernel {
  public:
@@ -404,6 +432,16 @@ REGISTER_KERNEL_BUILDER(Name("CollectiveBcastRecv").Device(DEVICE_CPU),
                         CollectiveBcastRecvOpKernel);
 REGISTER_KERNEL_BUILDER(Name("CollectiveBcastRecv").Device(DEVICE_GPU),
                         CollectiveBcastRecvOpKernel);
+#ifdef TENSORFLOW_USE_VE
+#define REGISTER_VE(T)                                      \
+  REGISTER_KERNEL_BUILDER(Name("CollectiveBcastRecv")       \
+                              .Device(DEVICE_VE)            \
+                              .TypeConstraint<T>("T"),      \
+                          CollectiveBcastRecvOpKernel);
+TF_CALL_float(REGISTER_VE);
+TF_CALL_int64(REGISTER_VE);
+#undef REGISTER_VE
+#endif  // TENSORFLOW_USE_VE
 
 }  // namespace
 }  // namespace tensorflow
@@ -81,8 +81,14 @@ ConstantOp::ConstantOp(OpKernelConstruction* ctx)
   const TensorProto* proto = nullptr;
   MEMDEBUG_CACHE_OP(ctx->def().name().c_str());
   OP_REQUIRES_OK(ctx, ctx->GetAttr("value", &proto));
-  OP_REQUIRES_OK(ctx, ctx->device()->MakeTensorFromProto(
-                          *proto, AllocatorAttributes(), &tensor_));
+  AllocatorAttributes alloc_attrs;
+#ifdef TENSORFLOW_USE_VE
+  if (ctx->device_type() == DeviceType(DEVICE_VE)) {
+    alloc_attrs.value |= kVESharedConstAttribute;
+  }
+#endif  // TENSORFLOW_USE_VE
+  OP_REQUIRES_OK(ctx, ctx->device()->MakeTensorFromProto(*proto, alloc_attrs,
+                                                         &tensor_));
   OP_REQUIRES(
       ctx, ctx->output_type(0) == tensor_.dtype(),
       errors::InvalidArgument("Type mismatch between value (",
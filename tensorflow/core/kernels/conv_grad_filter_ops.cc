@@ -61,6 +61,7 @@ limitations under the License.
 #endif  // GOOGLE_CUDA
 
 #ifdef TENSORFLOW_USE_VE
+#include "tensorflow/core/kernels/conv_ops.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
 #include "tensorflow/core/framework/ve_ops_common.h"
 //#include "tensorflow/core/common_runtime/ve/ve_device.h"
@@ -205,15 +206,27 @@ struct LaunchConv2DBackpropFilterOp<VEDevice, T> {
                   const Tensor& out_backprop, const Tensor& input,
                   int row_dilation, int col_dilation, int row_stride,
                   int col_stride, const Padding& padding,
+                  const std::vector<int64>& explicit_paddings,
                   Tensor* filter_backprop, TensorFormat data_format) {
     VLOG(2) << "LaunchConv2DBackpropFilterOp<VEDevice, T>";
     VLOG(2) << "LaunchConv2DBackpropFilterOp<VEDevice, T>: DeviceContext=" << ctx->op_device_context();
 
+    int64 pad_top = 0, pad_bottom = 0, pad_left = 0, pad_right = 0;
     if (padding == EXPLICIT) {
-      ctx->SetStatus(errors::Unimplemented(
-          "VE conv implementation only supports SAME/VALID padding."
-	  "Explicit padding is specified."));
-      return;
+      GetExplicitPaddingForDim(explicit_paddings, data_format, 'H', &pad_top,
+                               &pad_bottom);
+      GetExplicitPaddingForDim(explicit_paddings, data_format, 'W', &pad_left,
+                               &pad_right);
+      if (pad_top != pad_bottom || pad_left != pad_right) {
+        Tensor padded;
+        OP_REQUIRES_OK(ctx, VEPadSpatialDims(ctx, input, data_format, pad_top,
+                                             pad_bottom, pad_left, pad_right,
+                                             &padded));
+        (*this)(ctx, use_cudnn, cudnn_use_autotune, out_backprop, padded,
+                row_dilation, col_dilation, row_stride, col_stride, VALID, {},
+                filter_backprop, data_format);
+        return;
+      }
     }
 
     const int64 batch = GetTensorDim(input, data_format, 'N');
@@ -245,6 +258,9 @@ struct LaunchConv2DBackpropFilterOp<VEDevice, T> {
 
       row_padding = row_pad_all - row_pad_all/2 ;
       col_padding = col_pad_all - col_pad_all/2 ;
+    } else if (padding == EXPLICIT) {
+      row_padding = pad_top;
+      col_padding = pad_left;
     }
 
     VEOpKernelHelper::ArgsImpl<> args;
@@ -1339,6 +1355,10 @@ class Conv2DVEBackpropFilterOp : public OpKernel {
                 errors::InvalidArgument(
                     "Current implementation does not yet support "
                     "dilations in the batch and depth dimensions."));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("explicit_paddings", &explicit_paddings_));
+    OP_REQUIRES_OK(context, CheckValidPadding(padding_, explicit_paddings_,
+                                              /*num_dims=*/4, data_format_));
   }
 
   void Compute(OpKernelContext* context) override {
@@ -1357,9 +1377,10 @@ class Conv2DVEBackpropFilterOp : public OpKernel {
     ConvBackpropDimensions dims;
     OP_REQUIRES_OK(
         context,
-        ConvBackpropComputeDimensions(
+        ConvBackpropComputeDimensionsV2(
             type_string(), /*num_spatial_dims=*/2, input.shape(), filter_shape,
-            out_backprop.shape(), strides_, padding_, data_format_, &dims));
+            out_backprop.shape(), dilations_, strides_, padding_,
+            explicit_paddings_, data_format_, &dims));
 
     Tensor* filter_backprop = nullptr;
     OP_REQUIRES_OK(context,
@@ -1367,14 +1388,16 @@ class Conv2DVEBackpropFilterOp : public OpKernel {
 
     LaunchConv2DBackpropFilterOp<Device, T>()(
         context, false, false, out_backprop, input,
-        /*row_dilation=*/1, /*col_dilation=*/1, dims.spatial_dims[0].stride,
-        dims.spatial_dims[1].stride, padding_, filter_backprop, data_format_);
+        dims.spatial_dims[0].dilation, dims.spatial_dims[1].dilation,
+        dims.spatial_dims[0].stride, dims.spatial_dims[1].stride, padding_,
+        explicit_paddings_, filter_backprop, data_format_);
   }
 
  private:
   std::vector<int32> dilations_;
   std::vector<int32> strides_;
   Padding padding_;
+  std::vector<int64> explicit_paddings_;
   TensorFormat data_format_;
 };
 
@@ -63,6 +63,7 @@ limitations under the License.
 #endif  // GOOGLE_CUDA
 
 #ifdef TENSORFLOW_USE_VE
+#include "tensorflow/core/kernels/conv_ops.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
 #include "tensorflow/core/framework/ve_ops_common.h"
 #endif
@@ -222,11 +223,34 @@ struct LaunchConv2DBackpropInputOp<VEDevice, T> {
     VLOG(2) << "LaunchConv2DBackpropInputOp<VEDevice, T>";
     VLOG(2) << "LaunchConv2DBackpropInputOp<VEDevice, T>: DeviceContext=" << ctx->op_device_context();
 
+    int64 pad_top = 0, pad_bottom = 0, pad_left = 0, pad_right = 0;
     if (padding == EXPLICIT) {
-      ctx->SetStatus(errors::Unimplemented(
-          "VE conv implementation only supports SAME/VALID padding."
-	  "Explicit padding is specified."));
-      return;
+      GetExplicitPaddingForDim(explicit_paddings, data_format, 'H', &pad_top,
+                               &pad_bottom);
+      GetExplicitPaddingForDim(explicit_paddings, data_format, 'W', &pad_left,
+                               &pad_right);
+      if (pad_top != pad_bottom || pad_left != pad_right) {
+        // Compute the gradient of the padded input and drop the padding.
+        TensorShape padded_shape = in_backprop->shape();
+        const int row_dim = GetTensorDimIndex(data_format, 'H');
+        const int col_dim = GetTensorDimIndex(data_format, 'W');
+        padded_shape.set_dim(row_dim, padded_shape.dim_size(row_dim) +
+                                          pad_top + pad_bottom);
+        padded_shape.set_dim(col_dim, padded_shape.dim_size(col_dim) +
+                                          pad_left + pad_right);
+        Tensor padded_in_backprop;
+        OP_REQUIRES_OK(ctx, ctx->allocate_temp(in_backprop->dtype(),
+                                               padded_shape,
+                                               &padded_in_backprop));
+        (*this)(ctx, use_cudnn, cudnn_use_autotune, out_backprop, filter,
+                row_dilation, col_dilation, row_stride, col_stride, VALID, {},
+                &padded_in_backprop, data_format);
+        if (!ctx->status().ok()) return;
+        OP_REQUIRES_OK(ctx, VESliceSpatialDims(ctx, padded_in_backprop,
+                                               data_format, pad_top, pad_left,
+                                               in_backprop));
+        return;
+      }
     }
 
     const int64 batch = GetTensorDim(*in_backprop, data_format, 'N');
@@ -258,6 +282,9 @@ struct LaunchConv2DBackpropInputOp<VEDevice, T> {
 
       row_padding = row_pad_all - row_pad_all/2 ;
       col_padding = col_pad_all - col_pad_all/2 ;
+    } else if (padding == EXPLICIT) {
+      row_padding = pad_top;
+      col_padding = pad_left;
     }
 
     VEOpKernelHelper::ArgsImpl<> args;
@@ -1587,10 +1614,11 @@ class Conv2DVEBackpropInputOp : public OpKernel {
 
     ConvBackpropDimensions dims;
     OP_REQUIRES_OK(context,
-                   ConvBackpropComputeDimensions(
+                   ConvBackpropComputeDimensionsV2(
                        "Conv2DFastBackpropInput", /*num_spatial_dims=*/2,
                        input_shape, filter.shape(), out_backprop.shape(),
-                       strides_, padding_, data_format_, &dims));
+                       dilations_, strides_, padding_, explicit_paddings_,
+                       data_format_, &dims));
 
     Tensor* in_backprop = nullptr;
     OP_REQUIRES_OK(context,
@@ -1599,8 +1627,8 @@ class Conv2DVEBackpropInputOp : public OpKernel {
 
     LaunchConv2DBackpropInputOp<Device, T>()(
         context, false, false, out_backprop, filter,
-        /*row_dilation=*/1, /*col_dilation=*/1, dims.spatial_dims[0].stride,
-        dims.spatial_dims[1].stride, padding_, 
+        dims.spatial_dims[0].dilation, dims.spatial_dims[1].dilation,
+        dims.spatial_dims[0].stride, dims.spatial_dims[1].stride, padding_,
         explicit_paddings_, in_backprop, data_format_);
   }
 
@@ -47,6 +47,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/util/padding.h"
@@ -70,6 +71,9 @@ limitations under the License.
 #endif  // GOOGLE_CUDA
 
 #ifdef TENSORFLOW_USE_VE
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/ve/ve_device.h"
+#include "tensorflow/core/kernels/fused_eigen_output_kernels.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
 #include "tensorflow/core/framework/ve_ops_common.h"
 #endif
@@ -224,6 +228,71 @@ struct LaunchConv2DOp<GPUDevice, int32> {
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
 #ifdef TENSORFLOW_USE_VE
+Status VEPadSpatialDims(OpKernelContext* ctx, const Tensor& in,
+                        TensorFormat data_format, int64 pad_top,
+                        int64 pad_bottom, int64 pad_left, int64 pad_right,
+                        Tensor* out) {
+  if (in.dtype() != DT_FLOAT)
+    return errors::Unimplemented("VE padding supports only float tensors");
+
+  int32 paddings[4][2] = {{0, 0}, {0, 0}, {0, 0}, {0, 0}};
+  const int row_dim = GetTensorDimIndex(data_format, 'H');
+  const int col_dim = GetTensorDimIndex(data_format, 'W');
+  paddings[row_dim][0] = pad_top;
+  paddings[row_dim][1] = pad_bottom;
+  paddings[col_dim][0] = pad_left;
+  paddings[col_dim][1] = pad_right;
+
+  TensorShape shape = in.shape();
+  shape.set_dim(row_dim, shape.dim_size(row_dim) + pad_top + pad_bottom);
+  shape.set_dim(col_dim, shape.dim_size(col_dim) + pad_left + pad_right);
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(in.dtype(), shape, out));
+
+  // Same argument layout as VEPadOp<float, int32>.
+  VEOpKernelHelper::ArgsImpl<> args;
+  TF_RETURN_IF_ERROR(args.addArg<int32_t>(4));
+  TF_RETURN_IF_ERROR(args.addArg<int64>(DT_FLOAT));
+  TF_RETURN_IF_ERROR(args.addArg<Tensor>(in));
+  TF_RETURN_IF_ERROR(args.addArg<int64>(DT_INT32));
+  TF_RETURN_IF_ERROR(args.addArg<float>(0.0f));
+  TF_RETURN_IF_ERROR(args.addArg<Tensor>(*out));
+  for (int i = 0; i < 4; ++i) {
+    TF_RETURN_IF_ERROR(args.addArg<int32_t>(paddings[i][0]));
+    TF_RETURN_IF_ERROR(args.addArg<int32_t>(paddings[i][1]));
+  }
+
+  VEDeviceContext* vectx = ctx->op_device_context<VEDeviceContext>();
+  return vectx->Compute("Pad", args.buf(), args.size());
+}
+
+Status VESliceSpatialDims(OpKernelContext* ctx, const Tensor& in,
+                          TensorFormat data_format, int64 pad_top,
+                          int64 pad_left, Tensor* out) {
+  // Same argument layout as VESliceOp.
+  struct {
+    int dtype;
+    uint64_t input_dims;
+    uint64_t input_ptr;
+    uint64_t output_ptr;
+    uint64_t array[4 * 3];
+  } args;
+
+  args.dtype = in.dtype();
+  args.input_dims = 4;
+  args.input_ptr = (uint64_t)DMAHelper::base(&in);
+  args.output_ptr = (uint64_t)DMAHelper::base(out);
+  for (int i = 0; i < 4; ++i) {
+    args.array[i] = in.dim_size(i);
+    args.array[4 + i] = out->dim_size(i);
+    args.array[8 + i] = 0;
+  }
+  args.array[8 + GetTensorDimIndex(data_format, 'H')] = pad_top;
+  args.array[8 + GetTensorDimIndex(data_format, 'W')] = pad_left;
+
+  VEDeviceContext* vectx = ctx->op_device_context<VEDeviceContext>();
+  return vectx->Compute("Slice", (void*)&args, sizeof(args));
+}
+
 template <typename T>
 struct LaunchConv2DOp<VEDevice, T> {
   void operator()(OpKernelContext* ctx, bool use_cudnn, bool cudnn_use_autotune,
@@ -241,11 +310,22 @@ struct LaunchConv2DOp<VEDevice, T> {
     VLOG(2) << "LaunchConv2DOp<VEDevice, T>: sizeof(T)=" << sizeof(T);
 #endif
 
+    int64 pad_top = 0, pad_bottom = 0, pad_left = 0, pad_right = 0;
     if (padding == EXPLICIT) {
-      ctx->SetStatus(errors::Unimplemented(
-          "VE conv implementation only supports SAME/VALID padding."
-	  "Explicit padding is specified."));
-      return;
+      GetExplicitPaddingForDim(explicit_paddings, data_format, 'H', &pad_top,
+                               &pad_bottom);
+      GetExplicitPaddingForDim(explicit_paddings, data_format, 'W', &pad_left,
+                               &pad_right);
+      if (pad_top != pad_bottom || pad_left != pad_right) {
+        Tensor padded;
+        OP_REQUIRES_OK(ctx, VEPadSpatialDims(ctx, input, data_format, pad_top,
+                                             pad_bottom, pad_left, pad_right,
+                                             &padded));
+        (*this)(ctx, use_cudnn, cudnn_use_autotune, padded, filter,
+                row_dilation, col_dilation, row_stride, col_stride, VALID, {},
+                output, data_format);
+        return;
+      }
     }
     
     const int64 batch = GetTensorDim(input, data_format, 'N');
@@ -277,30 +357,48 @@ struct LaunchConv2DOp<VEDevice, T> {
 
       row_padding = row_pad_all - row_pad_all/2 ;
       col_padding = col_pad_all - col_pad_all/2 ;
+    } else if (padding == EXPLICIT) {
+      row_padding = pad_top;
+      col_padding = pad_left;
     }
 
     VEOpKernelHelper::ArgsImpl<> args;
 
     /* Input , Output */
 
+    // NHWC and NCHW have the same memory layout when C or H*W is 1. Such
+    // tensors are reshaped instead of transposed.
+    const bool in_same_layout = in_depths == 1 || in_rows * in_cols == 1;
+    const bool out_same_layout = out_depths == 1 || out_rows * out_cols == 1;
+
     Tensor in_transposed, out_transposed ;
     if ( data_format == FORMAT_NHWC ) {
       // if data_format is NHWC, then transpose in/out tensor
+      const TensorShape in_shape =
+          ShapeFromFormat(FORMAT_NCHW, batch, in_rows, in_cols, in_depths);
+      const TensorShape out_shape =
+          ShapeFromFormat(FORMAT_NCHW, batch, out_rows, out_cols, out_depths);
+
+      if (in_same_layout) {
+        OP_REQUIRES(ctx, in_transposed.CopyFrom(input, in_shape),
+                    errors::Internal("Error during reshape copy."));
+      } else {
+        OP_REQUIRES_OK(ctx,
+		       ctx->allocate_temp(
+			   reinterpret_cast<DataType>(input.dtype()),
+			   in_shape, &in_transposed));
+        OP_REQUIRES_OK( ctx, VEDoTranspose(ctx, input, {0,3,1,2}, &in_transposed));
+      }
 
-      OP_REQUIRES_OK(ctx,
-		     ctx->allocate_temp(
-			 reinterpret_cast<DataType>(input.dtype()),
-			 ShapeFromFormat(FORMAT_NCHW, batch, in_rows, in_cols, in_depths),
-                         &in_transposed)
-		     );
-
-      OP_REQUIRES_OK(ctx,
-		     ctx->allocate_temp(
-			 reinterpret_cast<DataType>(input.dtype()),
-			 ShapeFromFormat(FORMAT_NCHW, batch, out_rows, out_cols, out_depths),
-                         &out_transposed));
-
-      OP_REQUIRES_OK( ctx, VEDoTranspose(ctx, input, {0,3,1,2}, &in_transposed));
+      if (out_same_layout) {
+        OP_REQUIRES(ctx, out_transposed.CopyFrom(*output, out_shape),
+                    errors::Internal("Error during reshape copy."));
+      } else {
+        OP_REQUIRES_OK(ctx,
+		       ctx->allocate_temp(
+			   reinterpret_cast<DataType>(input.dtype()),
+			   out_shape, &out_transposed));
+      }
 
       args.addArg<Tensor>(in_transposed) ;	// 0
       args.addArg<Tensor>(out_transposed) ;	// 1
@@ -312,19 +410,7 @@ struct LaunchConv2DOp<VEDevice, T> {
 
     /* Filter */
     Tensor filter_transposed ;
-    if( f_ic * f_oc == 1 ) {
-      OP_REQUIRES(ctx, filter_transposed.CopyFrom(filter, ShapeFromFormat(FORMAT_NCHW, f_oc, f_rows, f_cols, f_ic)),
-                  errors::Internal("Error during reshape copy."));
-    }
-    else {
-      OP_REQUIRES_OK(ctx,
-		     ctx->allocate_temp(
-			 reinterpret_cast<DataType>(input.dtype()),
-			 ShapeFromFormat(FORMAT_NCHW, f_oc, f_rows, f_cols, f_ic),
-			 &filter_transposed));
-
-      OP_REQUIRES_OK( ctx, VEDoTranspose(ctx, filter, {3,2,0,1}, &filter_transposed));
-    }
+    OP_REQUIRES_OK(ctx, TransposeFilter(ctx, filter, &filter_transposed));
     args.addArg(filter_transposed) ;	// 2
 
     /* conv params */
@@ -344,10 +430,57 @@ struct LaunchConv2DOp<VEDevice, T> {
 
 
     // if data_format is NHWC, then transpose output tensor
-    if ( data_format == FORMAT_NHWC ) {
+    if ( data_format == FORMAT_NHWC && !out_same_layout ) {
       OP_REQUIRES_OK( ctx, VEDoTranspose(ctx, out_transposed, {0,2,3,1}, output));
     }
   }
+
+ private:
+  // Transposes a HWCN filter to NCHW. When TF_VE_CONV_CACHE_FILTER is set,
+  // the result is reused while the same filter buffer is given. This is only
+  // valid when filters are not updated in place, ex. in inference.
+  Status TransposeFilter(OpKernelContext* ctx, const Tensor& filter,
+                         Tensor* filter_transposed) {
+    const int64 f_rows = GetTensorDim(filter, FORMAT_HWCN, 'H');
+    const int64 f_cols = GetTensorDim(filter, FORMAT_HWCN, 'W');
+    const int64 f_ic  = GetTensorDim(filter, FORMAT_HWCN, 'C');
+    const int64 f_oc  = GetTensorDim(filter, FORMAT_HWCN, 'N');
+    const TensorShape shape =
+        ShapeFromFormat(FORMAT_NCHW, f_oc, f_rows, f_cols, f_ic);
+
+    if( f_ic * f_oc == 1 ) {
+      if (!filter_transposed->CopyFrom(filter, shape))
+        return errors::Internal("Error during reshape copy.");
+      return Status::OK();
+    }
+
+    static const bool cache_filter = getenv("TF_VE_CONV_CACHE_FILTER") != nullptr;
+    if (cache_filter) {
+      mutex_lock l(mu_);
+      if (cached_filter_.IsInitialized()
+          && cached_filter_.SharesBufferWith(filter)
+          && cached_filter_.shape() == filter.shape()) {
+        *filter_transposed = cached_filter_transposed_;
+        return Status::OK();
+      }
+    }
+
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(filter.dtype(), shape,
+                                          filter_transposed));
+    TF_RETURN_IF_ERROR(VEDoTranspose(ctx, filter, {3,2,0,1}, filter_transposed));
+
+    if (cache_filter) {
+      // The filter is kept not to reuse its buffer for another tensor.
+      mutex_lock l(mu_);
+      cached_filter_ = filter;
+      cached_filter_transposed_ = *filter_transposed;
+    }
+    return Status::OK();
+  }
+
+  mutex mu_;
+  Tensor cached_filter_ GUARDED_BY(mu_);
+  Tensor cached_filter_transposed_ GUARDED_BY(mu_);
 };
 #endif // TENSORFLOW_USE_VE
 
@@ -360,8 +493,8 @@ class LaunchDeepConvOp {
                   int filter_cols, int pad_rows, int pad_cols, int out_rows,
                   int /*out_cols*/, int /*out_depth*/, int /*dilation_rows*/,
                   int /*dilation_cols*/, int /*stride_rows*/,
-                  int /*stride_cols*/, Tensor* /*output*/,
-                  TensorFormat /*data_format*/) {
+                  int /*stride_cols*/, const Padding& /*padding*/,
+                  Tensor* /*output*/, TensorFormat /*data_format*/) {
     return false;
   }
 };
@@ -376,11 +509,10 @@ class LaunchDeepConvOp<CPUDevice, float> {
                   int filter_cols, int pad_rows, int pad_cols, int out_rows,
                   int out_cols, int out_depth, int dilation_rows,
                   int dilation_cols, int stride_rows, int stride_cols,
-                  Tensor* output, TensorFormat data_format) {
+                  const Padding& padding, Tensor* output,
+                  TensorFormat data_format) {
     if (data_format != FORMAT_NHWC || dilation_rows != 1 ||
-        dilation_cols != 1 ||
-        !CanUseDeepConv2D(stride_rows, stride_cols, filter_rows, filter_cols,
-                          in_depth, out_depth, out_rows, out_cols)) {
+        dilation_cols != 1) {
       return false;
     }
 
@@ -397,12 +529,115 @@ class LaunchDeepConvOp<CPUDevice, float> {
     args.out_cols = out_cols;
     args.out_depth = out_depth;
 
+    if (ShouldAutotuneDeepConv2D(stride_rows, stride_cols, filter_rows,
+                                 filter_cols)) {
+      return RunAutotuned(ctx, input, filter, padding, &args, output);
+    }
+
+    if (!CanUseDeepConv2D(stride_rows, stride_cols, filter_rows, filter_cols,
+                          in_depth, out_depth, out_rows, out_cols,
+                          &args.transform_type)) {
+      return false;
+    }
+
+    Launch(ctx, args, input, filter, output);
+    return true;
+  }
+
+ private:
+  // Algorithm picked by autotuning: direct (generic) convolution, or
+  // DeepConv2D with the given transform.
+  struct Algorithm {
+    bool use_deep_conv;
+    DeepConv2DTransformType transform_type;
+  };
+
+  // Fastest algorithm for each autotuned convolution shape, keyed by
+  // [batch, in_rows, in_cols, in_depth, out_depth, pad_rows, pad_cols,
+  //  out_rows, out_cols].
+  struct AutotuneMap {
+    mutex mu;
+    std::map<std::vector<int>, Algorithm> algorithms GUARDED_BY(mu);
+  };
+
+  static AutotuneMap* GetAutotuneMap() {
+    static AutotuneMap* autotune_map = new AutotuneMap;
+    return autotune_map;
+  }
+
+  static void Launch(OpKernelContext* ctx, const Conv2DArgs& args,
+                     const Tensor& input, const Tensor& filter,
+                     Tensor* output) {
     auto input_ptr = input.template flat<float>().data();
     auto filter_ptr = filter.template flat<float>().data();
     auto output_ptr = output->template flat<float>().data();
 
     functor::DeepConv2D<CPUDevice, float>()(ctx, args, input_ptr, filter_ptr,
                                             output_ptr);
+  }
+
+  // Runs the convolution with the fastest algorithm for its shape, timing all
+  // of the algorithms when the shape is seen for the first time. Returns
+  // false if the caller should run the generic convolution.
+  static bool RunAutotuned(OpKernelContext* ctx, const Tensor& input,
+                           const Tensor& filter, const Padding& padding,
+                           Conv2DArgs* args, Tensor* output) {
+    const std::vector<int> key = {args->batch,     args->in_rows,
+                                  args->in_cols,   args->in_depth,
+                                  args->out_depth, args->pad_rows,
+                                  args->pad_cols,  args->out_rows,
+                                  args->out_cols};
+    AutotuneMap* autotune_map = GetAutotuneMap();
+    {
+      mutex_lock l(autotune_map->mu);
+      auto it = autotune_map->algorithms.find(key);
+      if (it != autotune_map->algorithms.end()) {
+        if (!it->second.use_deep_conv) return false;
+        args->transform_type = it->second.transform_type;
+        Launch(ctx, *args, input, filter, output);
+        return true;
+      }
+    }
+
+    // Every candidate writes the same result to 'output', so the output of the
+    // last timed run is returned to the caller.
+    const std::vector<Algorithm> candidates = {
+        {false, DeepConv2DTransformType::kWinograd2x2},
+        {true, DeepConv2DTransformType::kWinograd2x2},
+        {true, DeepConv2DTransformType::kWinograd4x4}};
+    // Each candidate is run twice, so the faster run excludes warm-up costs.
+    constexpr int kNumRuns = 2;
+
+    Algorithm best = candidates[0];
+    uint64 best_time_us = std::numeric_limits<uint64>::max();
+    for (const Algorithm& candidate : candidates) {
+      for (int run = 0; run < kNumRuns; ++run) {
+        const uint64 start_us = Env::Default()->NowMicros();
+        if (candidate.use_deep_conv) {
+          args->transform_type = candidate.transform_type;
+          Launch(ctx, *args, input, filter, output);
+        } else {
+          LaunchGeneric<CPUDevice, float>()(
+              ctx, input, filter, /*row_stride=*/1, /*col_stride=*/1,
+              /*row_dilation=*/1, /*col_dilation=*/1, padding,
+              /*explicit_paddings=*/{}, output, FORMAT_NHWC);
+        }
+        if (!ctx->status().ok()) return true;
+        const uint64 time_us = Env::Default()->NowMicros() - start_us;
+
+        VLOG(2) << "DeepConv2D autotune: use_deep_conv="
+                << candidate.use_deep_conv << " transform_type="
+                << static_cast<int>(candidate.transform_type)
+                << " time_us=" << time_us;
+        if (time_us < best_time_us) {
+          best_time_us = time_us;
+          best = candidate;
+        }
+      }
+    }
+
+    mutex_lock l(autotune_map->mu);
+    autotune_map->algorithms.emplace(key, best);
     return true;
   }
 };
@@ -714,7 +949,8 @@ class Conv2DOp : public BinaryOp<T> {
             dimensions.pad_cols_before, dimensions.out_rows,
             dimensions.out_cols, dimensions.out_depth, dimensions.dilation_rows,
             dimensions.dilation_cols, dimensions.stride_rows,
-            dimensions.stride_cols, output, params_.data_format)) {
+            dimensions.stride_cols, params_.padding, output,
+            params_.data_format)) {
       return;
     }
 
@@ -752,6 +988,50 @@ TF_CALL_int32(REGISTER_CPU);
 REGISTER_KERNEL_BUILDER(
       Name("Conv2D").Device(DEVICE_VE).TypeConstraint<float>("T"),
       Conv2DOp<VEDevice, float>);
+
+// _FusedConv2D on VE runs Conv2D and then applies BiasAdd and the activation in
+// place on its output.
+template <typename T>
+class VEFusedConv2DOp : public Conv2DOp<VEDevice, T> {
+ public:
+  explicit VEFusedConv2DOp(OpKernelConstruction* context)
+      : Conv2DOp<VEDevice, T>(context) {
+    string data_format;
+    OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format));
+    OP_REQUIRES(context, FormatFromString(data_format, &data_format_),
+                errors::InvalidArgument("Invalid data format"));
+
+    using FCT = FusedComputationType;
+    const std::vector<FusedComputationPattern> patterns = {
+        {FCT::kBiasAdd, {"BiasAdd"}},
+        {FCT::kBiasAddWithRelu, {"BiasAdd", "Relu"}},
+        {FCT::kBiasAddWithRelu6, {"BiasAdd", "Relu6"}},
+        {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}},
+    };
+    OP_REQUIRES_OK(context, InitializeFusedComputation(
+                                context, "Conv2D", patterns,
+                                &fused_computation_, &fused_computation_args_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    Conv2DOp<VEDevice, T>::Compute(context);
+    if (!context->status().ok()) return;
+    OP_REQUIRES_OK(context, LaunchVEFusedOutputKernels(
+                                context, fused_computation_, data_format_,
+                                context->mutable_output(0)));
+  }
+
+ private:
+  TensorFormat data_format_;
+  FusedComputationType fused_computation_ = FusedComputationType::kUndefined;
+  FusedComputationArgs fused_computation_args_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(VEFusedConv2DOp);
+};
+
+REGISTER_KERNEL_BUILDER(
+      Name("_FusedConv2D").Device(DEVICE_VE).TypeConstraint<float>("T"),
+      VEFusedConv2DOp<float>);
 #endif
 
 // To be used inside depthwise_conv_op.cc.
@@ -53,6 +53,20 @@ struct LaunchConv2DOp<Eigen::GpuDevice, T> {
 };
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#ifdef TENSORFLOW_USE_VE
+// VE conv kernels take a single padding per spatial dimension. Convolutions
+// with asymmetric explicit paddings are run as VALID convolutions on an input
+// zero-padded by VEPadSpatialDims, and VESliceSpatialDims extracts the
+// unpadded part of the input gradient.
+Status VEPadSpatialDims(OpKernelContext* ctx, const Tensor& in,
+                        TensorFormat data_format, int64 pad_top,
+                        int64 pad_bottom, int64 pad_left, int64 pad_right,
+                        Tensor* out);
+Status VESliceSpatialDims(OpKernelContext* ctx, const Tensor& in,
+                          TensorFormat data_format, int64 pad_top,
+                          int64 pad_left, Tensor* out);
+#endif  // TENSORFLOW_USE_VE
+
 // Used to keep track of persistent memory buffers used within the op.
 // It uses malloc and free to avoid the time cost of initializing the memory.
 template <class T, size_t size>
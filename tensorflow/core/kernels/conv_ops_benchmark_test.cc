@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <stdlib.h>
+
 #include <string>
 #include <vector>
 
@@ -324,6 +326,18 @@ static Graph* FusedConv2DWithBatchNorm(
   }                                                                         \
   BENCHMARK(BM_NAME(BM_Conv2D, type, N, H, W, C, FW, FH, FC));
 
+// Runs Conv2D with DeepConv2D (TF_USE_DEEP_CONV2D) set to the given MODE.
+#define BM_Conv2DDeepConv(N, H, W, C, FW, FH, FC, MODE, type, LABEL)        \
+  static void BM_NAME(BM_Conv2DDeepConv_##MODE, type, N, H, W, C, FW, FH, \
+                      FC)(int iters) {                                    \
+    BM_SETUP(N, H, W, C, type, LABEL, Conv2D);                            \
+    setenv("TF_USE_DEEP_CONV2D", #MODE, 1);                               \
+    test::Benchmark(#type, Conv2D<float>(N, H, W, C, FW, FH, FC).graph)   \
+        .Run(iters);                                                      \
+    unsetenv("TF_USE_DEEP_CONV2D");                                       \
+  }                                                                       \
+  BENCHMARK(BM_NAME(BM_Conv2DDeepConv_##MODE, type, N, H, W, C, FW, FH, FC));
+
 #define BM_Conv2DWithBias(N, H, W, C, FW, FH, FC, type, LABEL)           \
   static void BM_NAME(BM_Conv2DWithBias, type, N, H, W, C, FW, FH,       \
                       FC)(int iters) {                                   \
@@ -467,6 +481,23 @@ BM_Conv2D(8, 32, 32, 128, 3, 3, 1024, cpu, "3x3 /b 8");
 BM_Conv2D(16, 32, 32, 128, 3, 3, 1024, cpu, "3x3 /b 16");
 BM_Conv2D(32, 32, 32, 128, 3, 3, 1024, cpu, "3x3 /b 32");
 
+// -------------------------------------------------------------------------- //
+// 3x3 Convolution: DeepConv2D (Winograd F(2x2, 3x3) and F(4x4, 3x3))
+// -------------------------------------------------------------------------- //
+
+BM_Conv2D(1, 32, 32, 128, 3, 3, 1024, cpu, "3x3 /b 1");
+BM_Conv2DDeepConv(1, 32, 32, 128, 3, 3, 1024, winograd2x2, cpu, "3x3 /b 1");
+BM_Conv2DDeepConv(1, 32, 32, 128, 3, 3, 1024, winograd4x4, cpu, "3x3 /b 1");
+BM_Conv2DDeepConv(1, 32, 32, 128, 3, 3, 1024, autotune, cpu, "3x3 /b 1");
+
+BM_Conv2DDeepConv(8, 32, 32, 128, 3, 3, 1024, winograd2x2, cpu, "3x3 /b 8");
+BM_Conv2DDeepConv(8, 32, 32, 128, 3, 3, 1024, winograd4x4, cpu, "3x3 /b 8");
+BM_Conv2DDeepConv(8, 32, 32, 128, 3, 3, 1024, autotune, cpu, "3x3 /b 8");
+
+BM_Conv2DDeepConv(32, 32, 32, 128, 3, 3, 1024, winograd2x2, cpu, "3x3 /b 32");
+BM_Conv2DDeepConv(32, 32, 32, 128, 3, 3, 1024, winograd4x4, cpu, "3x3 /b 32");
+BM_Conv2DDeepConv(32, 32, 32, 128, 3, 3, 1024, autotune, cpu, "3x3 /b 32");
+
 // 1) BiasAdd {+ Relu}
 
 BM_Conv2DWithBias(8, 32, 32, 128, 3, 3, 1024, cpu, "3x3 /b 8");
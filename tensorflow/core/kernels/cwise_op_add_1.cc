@@ -77,6 +77,10 @@ REGISTER_KERNEL_BUILDER(Name("AddV2")
                         .Device(DEVICE_VE)
                         .TypeConstraint<int64>("T"),
                         VEAddOp<int64, int64>);
+REGISTER_KERNEL_BUILDER(Name("Add")
+                        .Device(DEVICE_VE)
+                        .TypeConstraint<int64>("T"),
+                        VEAddOp<int64, int64>);
 REGISTER_KERNEL_BUILDER(Name("Add")
                             .Device(DEVICE_VE)
                             .HostMemory("x")
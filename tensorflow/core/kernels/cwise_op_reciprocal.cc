@@ -59,6 +59,94 @@ REGISTER(SimpleBinaryOp, SYCL, "ReciprocalGrad", functor::inverse_grad, float);
 
 #ifdef TENSORFLOW_USE_VE
 REGISTER_VE_UNARY_OP(Reciprocal, float);
+
+// The VE kernel library has no ReciprocalGrad kernel. dx = -dy * y * y is
+// computed with the Square, Mul and Neg kernels instead, all in place on the
+// output, so the three calls are queued back to back without a sync.
+class VEReciprocalGradOp : public OpKernel {
+ public:
+  explicit VEReciprocalGradOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    square_kernel_ = LookupVEKernel(ctx->device(), "Square");
+    OP_REQUIRES(ctx, square_kernel_ != 0,
+                errors::Internal("VE kernel not found for Square"));
+    mul_kernel_ = LookupVEKernel(ctx->device(), "Mul");
+    OP_REQUIRES(ctx, mul_kernel_ != 0,
+                errors::Internal("VE kernel not found for Mul"));
+    neg_kernel_ = LookupVEKernel(ctx->device(), "Neg");
+    OP_REQUIRES(ctx, neg_kernel_ != 0,
+                errors::Internal("VE kernel not found for Neg"));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& y = ctx->input(0);
+    const Tensor& dy = ctx->input(1);
+    OP_REQUIRES(ctx, y.shape() == dy.shape(),
+                errors::InvalidArgument(
+                    "y and dy must have the same shape, got ",
+                    y.shape().DebugString(), " and ", dy.shape().DebugString()));
+
+    // Only y may be forwarded: dy is still read after out is first written.
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(
+        ctx, ctx->forward_input_or_allocate_output({0}, 0, y.shape(), &out));
+    if (out->NumElements() == 0) return;
+
+    VEDeviceContext* vectx = ctx->op_device_context<VEDeviceContext>();
+
+    struct {
+      _Tensor in;
+      _Tensor out;
+    } __attribute__((__packed__)) unary_args;
+
+    struct {
+      _Tensor in0;
+      _Tensor in1;
+      _Tensor out;
+    } __attribute__((__packed__)) binary_args;
+
+    unary_args.in = _Tensor(y);
+    unary_args.out = _Tensor(*out);
+    OP_REQUIRES_OK(ctx, vectx->Compute(square_kernel_, (void*)&unary_args,
+                                       sizeof(unary_args)));
+
+    binary_args.in0 = _Tensor(*out);
+    binary_args.in1 = _Tensor(dy);
+    binary_args.out = _Tensor(*out);
+    OP_REQUIRES_OK(ctx, vectx->Compute(mul_kernel_, (void*)&binary_args,
+                                       sizeof(binary_args)));
+
+    unary_args.in = _Tensor(*out);
+    OP_REQUIRES_OK(ctx, vectx->Compute(neg_kernel_, (void*)&unary_args,
+                                       sizeof(unary_args)));
+  }
+
+ private:
+  // Tensors are passed flattened since all three kernels are elementwise.
+  struct _Tensor {
+    int32_t dtype;
+    uint64_t addr;
+    int32_t dims;
+    int64_t nelems;
+    int64_t dim_size[8];
+
+    _Tensor() {}
+    explicit _Tensor(const Tensor& t)
+        : dtype(t.dtype()),
+          addr((uint64_t)DMAHelper::base(&t)),
+          dims(1),
+          nelems(t.NumElements()) {
+      dim_size[0] = nelems;
+    }
+  } __attribute__((__packed__));
+
+  uint64_t square_kernel_;
+  uint64_t mul_kernel_;
+  uint64_t neg_kernel_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("ReciprocalGrad").Device(DEVICE_VE).TypeConstraint<float>("T"),
+    VEReciprocalGradOp);
 #endif  // TENSORFLOW_USE_VE
 
 }  // namespace tensorflow
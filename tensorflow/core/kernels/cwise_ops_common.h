@@ -692,7 +692,11 @@ struct ApproximateEqual<CPUDevice, T> {
 class VEUnaryOp : public OpKernel {
   public:
     explicit VEUnaryOp(OpKernelConstruction* ctx, std::string name) 
-      : OpKernel(ctx), name_(name) {}
+      : OpKernel(ctx), name_(name) {
+      kernel_ = LookupVEKernel(ctx->device(), name_);
+      OP_REQUIRES(ctx, kernel_ != 0,
+                  errors::Internal("VE kernel not found for ", name_));
+    }
 
     void Compute(OpKernelContext* ctx) override {
       const Tensor& inp = ctx->input(0);
@@ -723,13 +727,14 @@ class VEUnaryOp : public OpKernel {
       args.out.nelems = args.in.nelems;
 
       VEDeviceContext* vectx = ctx->op_device_context<VEDeviceContext>();
-      Status s = vectx->Compute(name_.c_str(), (void*)&args, sizeof(args));
+      Status s = vectx->Compute(kernel_, (void*)&args, sizeof(args));
       if (!s.ok())
         ctx->SetStatus(s);
     }
 
   private:
     std::string name_;
+    uint64_t kernel_;
 };
 
 template <typename Tin, typename Tout>
@@ -737,9 +742,31 @@ class VEBinaryOp : public BinaryOpShared {
   public:
     explicit VEBinaryOp(OpKernelConstruction* context, std::string name) 
       : BinaryOpShared(context, DataTypeToEnum<Tout>::v(), DataTypeToEnum<Tin>::v()),
-        name_(name) {}
+        name_(name) {
+      kernel_ = LookupVEKernel(context->device(), name_);
+      OP_REQUIRES(context, kernel_ != 0,
+                  errors::Internal("VE kernel not found for ", name_));
+    }
 
     void Compute(OpKernelContext* context) override {
+      const Tensor& in0 = context->input(0);
+      const Tensor& in1 = context->input(1);
+
+      // Descriptors depend only on shapes while addresses change every
+      // step. Reuse them and skip broadcasting when shapes are unchanged.
+      Args args;
+      TensorShape out_shape;
+      if (LookupCachedArgs(in0.shape(), in1.shape(), &args, &out_shape)) {
+        Tensor* out = nullptr;
+        OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                {0, 1}, 0, out_shape, &out));
+        args.in0.addr = (uint64_t)DMAHelper::base(&in0);
+        args.in1.addr = (uint64_t)DMAHelper::base(&in1);
+        args.out.addr = (uint64_t)DMAHelper::base(out);
+        Call(context, args);
+        return;
+      }
+
       BinaryOpState state(context);
       if (!context->status().ok()) return;
 
@@ -752,70 +779,95 @@ class VEBinaryOp : public BinaryOpShared {
         return;
       }
 
-      if (state.in0.dims() > 8 || state.in1.dims() > 8 || state.out->dims() > 8) {
+      // Shapes are collapsed by BCast, so that common cases such as
+      // scalar-tensor or row/column broadcast are passed as 1 or 2 dims.
+      if (state.ndims > 8) {
         context->SetStatus(errors::Unimplemented(
-                "in0.dims > 8 || in1.dims > 8 || out.dims > 8"
-                " is not supported by VEMulOp"));
+                "Broadcast of more than 8 dims after collapsing is not"
+                " supported by VEBinaryOp: in0.shape=",
+                state.in0.shape().DebugString(), " in1.shape=",
+                state.in1.shape().DebugString()));
         return;
       }
 
-      struct _Tensor {
-        int dtype;
-        uint64_t addr;
-        int32_t dims;
-        int64_t nelems;
-        int64_t dim_size[8];
-
-        _Tensor(const Tensor& t) :
-          dtype(t.dtype()),
-          addr((uint64_t)DMAHelper::base(&t)),
-          dims(t.dims()),
-          nelems(t.NumElements()) {
-            for (int i = 0; i < dims; ++i) {
-              dim_size[i] = t.dim_size(i);
-            }
-        }
-      } __attribute__((__packed__));
-
-      struct Args {
-        _Tensor in0;
-        _Tensor in1;
-        _Tensor out;
+      args = Args(state.in0, state.in1, *state.out, state.bcast);
+      {
+        mutex_lock l(mu_);
+        cached_in0_shape_ = state.in0.shape();
+        cached_in1_shape_ = state.in1.shape();
+        cached_out_shape_ = state.out->shape();
+        cached_args_ = args;
+        has_cached_args_ = true;
+      }
 
-        Args(const Tensor& in0_, const Tensor in1_, Tensor& out_) :
-          in0(in0_), in1(in1_), out(out_) {
-            if(in0.dims > in1.dims){
-                for(int i = 0; i < in1.dims; i++){
-                    in1.dim_size[in0.dims-i-1] = in1.dim_size[in1.dims-i-1] ;
-                }
-                for(int i = 0; i < in0.dims-in1.dims; i++){
-                    in1.dim_size[i] = 1;
-                }
-                in1.dims = in0.dims;
-            }
-            if(in1.dims > in0.dims){
-                for(int i = 0; i < in0.dims; i++){
-                    in0.dim_size[in1.dims-i-1] = in0.dim_size[in0.dims-i-1] ;
-                }
-                for(int i = 0; i < in1.dims-in0.dims; i++){
-                    in0.dim_size[i] = 1;
-                }
-                in0.dims = in1.dims;
-            }
-        }
-      } __attribute__((__packed__)) args(state.in0, state.in1, *state.out);
+      Call(context, args);
+    }
 
+  private:
+    struct _Tensor {
+      int dtype;
+      uint64_t addr;
+      int32_t dims;
+      int64_t nelems;
+      int64_t dim_size[8];
+
+      _Tensor() {}
+      // `t` viewed as `shape` that has the same number of elements.
+      _Tensor(const Tensor& t, const BCast::Vec& shape) :
+        dtype(t.dtype()),
+        addr((uint64_t)DMAHelper::base(&t)),
+        dims(shape.size()),
+        nelems(t.NumElements()) {
+          for (int i = 0; i < dims; ++i) {
+            dim_size[i] = shape[i];
+          }
+      }
+    } __attribute__((__packed__));
+
+    struct Args {
+      _Tensor in0;
+      _Tensor in1;
+      _Tensor out;
+
+      Args() {}
+      // Shapes reduced by `bcast`. All operands have the same number of
+      // dims, and a dim of an input is 1 or the one of the output.
+      Args(const Tensor& in0_, const Tensor& in1_, Tensor& out_,
+           const BCast& bcast) :
+        in0(in0_, bcast.x_reshape()), in1(in1_, bcast.y_reshape()),
+        out(out_, bcast.result_shape()) {}
+    } __attribute__((__packed__));
 
+    std::string name_;
+    uint64_t kernel_;
+
+    // Arguments of the last call. Only their addresses are updated when
+    // the op is called with the same shapes again.
+    mutex mu_;
+    bool has_cached_args_ GUARDED_BY(mu_) = false;
+    TensorShape cached_in0_shape_ GUARDED_BY(mu_);
+    TensorShape cached_in1_shape_ GUARDED_BY(mu_);
+    TensorShape cached_out_shape_ GUARDED_BY(mu_);
+    Args cached_args_ GUARDED_BY(mu_);
+
+    bool LookupCachedArgs(const TensorShape& in0_shape,
+                          const TensorShape& in1_shape, Args* args,
+                          TensorShape* out_shape) {
+      mutex_lock l(mu_);
+      if (!has_cached_args_ || in0_shape != cached_in0_shape_
+          || in1_shape != cached_in1_shape_)
+        return false;
+      *args = cached_args_;
+      *out_shape = cached_out_shape_;
+      return true;
+    }
 
+    void Call(OpKernelContext* context, const Args& args) {
       VEDeviceContext* vectx = context->op_device_context<VEDeviceContext>();
-      Status s = vectx->Compute(name_.c_str(), (void*)&args, sizeof(args), this);
+      Status s = vectx->Compute(kernel_, (void*)&args, sizeof(args), this);
       if (!s.ok())
         context->SetStatus(s);
-
     }
-
-  private:
-    std::string name_;
 };
 
 #define DEFINE_VE_UNARY_OP(Name) \
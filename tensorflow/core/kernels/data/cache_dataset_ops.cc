@@ -53,6 +53,7 @@ constexpr char kCacheSize[] = "cache_size";
 constexpr char kCache[] = "cache";
 constexpr char kSizeSuffix[] = ".size";
 constexpr char kCacheCompleted[] = "cache_completed";
+constexpr char kCacheCompressed[] = "cache_compressed";
 constexpr char kIndex[] = "index";
 constexpr char kImpl[] = "Impl";
 constexpr char kCacheDataset[] = "CacheDataset";
@@ -632,7 +633,11 @@ class CacheDatasetOp::FileDatasetV2 : public CacheDatasetOp::FileDataset {
 
 namespace {
 template <typename T, typename FullNameFn>
-Status SaveCache(IteratorStateWriter* writer, T* cache, FullNameFn full_name) {
+Status SaveCache(IteratorStateWriter* writer, T* cache, bool compressed,
+                 FullNameFn full_name) {
+  if (compressed) {
+    TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCacheCompressed), ""));
+  }
   size_t cache_size = cache->size();
   TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCacheSize), cache_size));
   for (size_t i = 0; i < cache_size; i++) {
@@ -651,7 +656,14 @@ Status SaveCache(IteratorStateWriter* writer, T* cache, FullNameFn full_name) {
 
 template <typename T, typename FullNameFn>
 Status RestoreCache(IteratorContext* ctx, IteratorStateReader* reader, T* cache,
-                    FullNameFn full_name) {
+                    bool compressed, FullNameFn full_name) {
+  // Cached elements are checkpointed in their stored representation.
+  if (reader->Contains(full_name(kCacheCompressed)) != compressed) {
+    return errors::FailedPrecondition(
+        "The checkpointed cache was ", compressed ? "not " : "",
+        "compressed. TF_DATA_MEMORY_CACHE_COMPRESSION must be set the same "
+        "way when saving and restoring the iterator.");
+  }
   size_t cache_size;
   {
     int64 temp;
@@ -787,8 +799,9 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
       mutex_lock l(mu_);
       if (cache_->IsCompleted()) {
         TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCacheCompleted), ""));
-        TF_RETURN_IF_ERROR(SaveCache(
-            writer, cache_, [this](const string& s) { return full_name(s); }));
+        TF_RETURN_IF_ERROR(
+            SaveCache(writer, cache_, cache_->compressed(),
+                      [this](const string& s) { return full_name(s); }));
       }
       return SaveInput(writer, iterator_);
     }
@@ -801,7 +814,7 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
       if (reader->Contains(full_name(kCacheCompleted))) {
         std::vector<std::vector<Tensor>> temp_cache;
         TF_RETURN_IF_ERROR(
-            RestoreCache(ctx, reader, &temp_cache,
+            RestoreCache(ctx, reader, &temp_cache, cache_->compressed(),
                          [this](const string& s) { return full_name(s); }));
         cache_->Complete(std::move(temp_cache));
       }
@@ -844,8 +857,10 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
           cache_->Complete(std::move(temp_cache_));
           return Status::OK();
         }
-        RecordBufferEnqueue(ctx, *out_tensors);
-        temp_cache_.emplace_back(*out_tensors);
+        std::vector<Tensor> element = *out_tensors;
+        TF_RETURN_IF_ERROR(cache_->Compress(&element));
+        RecordBufferEnqueue(ctx, element);
+        temp_cache_.emplace_back(std::move(element));
         return Status::OK();
       }
 
@@ -860,7 +875,7 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
         mutex_lock l(mu_);
         if (!cache_->IsCompleted()) {
           TF_RETURN_IF_ERROR(
-              SaveCache(writer, &temp_cache_,
+              SaveCache(writer, &temp_cache_, cache_->compressed(),
                         [this](const string& s) { return full_name(s); }));
         }
         return SaveInput(writer, input_impl_);
@@ -871,7 +886,7 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
         mutex_lock l(mu_);
         if (!reader->Contains(full_name(kCacheCompleted))) {
           TF_RETURN_IF_ERROR(
-              RestoreCache(ctx, reader, &temp_cache_,
+              RestoreCache(ctx, reader, &temp_cache_, cache_->compressed(),
                            [this](const string& s) { return full_name(s); }));
         }
         return RestoreInput(ctx, reader, input_impl_);
@@ -909,9 +924,7 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
         if (index_ < cache_->size()) {
-          const std::vector<Tensor>& cache_tensors = cache_->at(index_);
-          out_tensors->insert(out_tensors->begin(), cache_tensors.begin(),
-                              cache_tensors.end());
+          TF_RETURN_IF_ERROR(cache_->GetElement(index_, out_tensors));
           index_++;
           *end_of_sequence = false;
           return Status::OK();
@@ -12,6 +12,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/cache_dataset_ops.h"
 
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 
 namespace tensorflow {
 namespace data {
@@ -197,6 +198,34 @@ TEST_P(ParameterizedGetNextTest, GetNext) {
 INSTANTIATE_TEST_SUITE_P(CacheDatasetOpTest, ParameterizedGetNextTest,
                          ::testing::ValuesIn(GetNextTestCases()));
 
+TEST_F(CacheDatasetOpTest, CompressedMemoryCache) {
+  setenv("TF_DATA_MEMORY_CACHE_COMPRESSION", "1", /*overwrite=*/1);
+  auto cleanup = gtl::MakeCleanup(
+      []() { unsetenv("TF_DATA_MEMORY_CACHE_COMPRESSION"); });
+  auto dataset_params = CacheDatasetParams3();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> expected_outputs = CreateTensors<int64>(
+      TensorShape({3, 1}), {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}});
+
+  // The second pass reads the elements back from the cache.
+  for (int pass = 0; pass < 2; ++pass) {
+    if (pass > 0) {
+      TF_ASSERT_OK(dataset_->MakeIterator(
+          iterator_ctx_.get(), dataset_params.iterator_prefix(), &iterator_));
+    }
+    bool end_of_sequence = false;
+    std::vector<Tensor> out_tensors;
+    while (!end_of_sequence) {
+      std::vector<Tensor> next;
+      TF_EXPECT_OK(
+          iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+      out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+    }
+    TF_EXPECT_OK(ExpectEqual(out_tensors, expected_outputs,
+                             /*compare_order=*/true));
+  }
+}
+
 TEST_F(CacheDatasetOpTest, DatasetNodeName) {
   auto dataset_params = CacheDatasetParams1();
   TF_ASSERT_OK(Initialize(dataset_params));
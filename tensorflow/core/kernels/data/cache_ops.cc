@@ -18,9 +18,12 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/platform/snappy.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -28,8 +31,29 @@ namespace {
 
 const char kMemoryCache[] = "MemoryCache";
 
+bool MemoryCacheCompressionEnabled() {
+  bool compressed = false;
+  Status s = ReadBoolFromEnvVar("TF_DATA_MEMORY_CACHE_COMPRESSION",
+                                /*default_val=*/false, &compressed);
+  if (!s.ok()) {
+    LOG(WARNING) << s;
+    return false;
+  }
+  if (compressed) {
+    string probe;
+    if (!port::Snappy_Compress("", 0, &probe)) {
+      LOG(WARNING) << "TF_DATA_MEMORY_CACHE_COMPRESSION is set but snappy is "
+                      "not available; caching elements uncompressed.";
+      return false;
+    }
+  }
+  return compressed;
+}
+
 }  // namespace
 
+MemoryCache::MemoryCache() : compressed_(MemoryCacheCompressionEnabled()) {}
+
 string MemoryCache::DebugString() const { return kMemoryCache; }
 
 void MemoryCache::Complete(std::vector<std::vector<Tensor>>&& cache) {
@@ -62,6 +86,62 @@ size_t MemoryCache::size() {
   return cache_.size();
 }
 
+Status MemoryCache::Compress(std::vector<Tensor>* element) const {
+  if (!compressed_) return Status::OK();
+  VariantTensorDataProto proto;
+  for (const Tensor& t : *element) {
+    t.AsProtoTensorContent(proto.add_tensors());
+  }
+  string serialized;
+  if (!proto.SerializeToString(&serialized)) {
+    return errors::Internal("Failed to serialize cache element.");
+  }
+  string output;
+  if (!port::Snappy_Compress(serialized.data(), serialized.size(), &output)) {
+    return errors::Internal("Failed to compress cache element.");
+  }
+  Tensor compressed(DT_STRING, TensorShape({}));
+  compressed.scalar<tstring>()() = std::move(output);
+  element->assign(1, std::move(compressed));
+  return Status::OK();
+}
+
+Status MemoryCache::GetElement(int64 index, std::vector<Tensor>* out_tensors) {
+  const std::vector<Tensor>& element = at(index);
+  if (!compressed_) {
+    out_tensors->insert(out_tensors->begin(), element.begin(), element.end());
+    return Status::OK();
+  }
+  const tstring& input = element[0].scalar<tstring>()();
+  size_t length;
+  if (!port::Snappy_GetUncompressedLength(input.data(), input.size(),
+                                          &length)) {
+    return errors::DataLoss("Failed to read the size of cache element ",
+                            index);
+  }
+  string serialized;
+  serialized.resize(length);
+  if (!port::Snappy_Uncompress(input.data(), input.size(), &serialized[0])) {
+    return errors::DataLoss("Failed to uncompress cache element ", index);
+  }
+  VariantTensorDataProto proto;
+  if (!proto.ParseFromString(serialized)) {
+    return errors::DataLoss("Failed to parse cache element ", index);
+  }
+  std::vector<Tensor> tensors(proto.tensors_size());
+  for (int i = 0; i < proto.tensors_size(); ++i) {
+    if (!tensors[i].FromProto(cpu_allocator(),
+                              std::move(*proto.mutable_tensors(i)))) {
+      return errors::DataLoss("Failed to parse tensor ", i,
+                              " of cache element ", index);
+    }
+  }
+  out_tensors->insert(out_tensors->begin(),
+                      std::make_move_iterator(tensors.begin()),
+                      std::make_move_iterator(tensors.end()));
+  return Status::OK();
+}
+
 AnonymousMemoryCacheHandleOp::AnonymousMemoryCacheHandleOp(
     OpKernelConstruction* ctx)
     : AnonymousResourceOp<MemoryCache>(ctx) {}
@@ -27,9 +27,14 @@ namespace data {
 // The expected use is that a single `MemoryWriterIterator` populates the
 // cache with dataset elements. Once all elements are cached, the cache can
 // be used by one or more `MemoryReaderIterator`s.
+//
+// If the `TF_DATA_MEMORY_CACHE_COMPRESSION` environment variable is set, each
+// element is stored as a single scalar string tensor holding the
+// snappy-compressed serialization of the element. Writers use `Compress` to
+// produce that representation and readers use `GetElement` to undo it.
 class MemoryCache : public ResourceBase {
  public:
-  MemoryCache() = default;
+  MemoryCache();
 
   string DebugString() const override;
 
@@ -48,7 +53,19 @@ class MemoryCache : public ResourceBase {
   // Returns the size of the cache.
   size_t size();
 
+  // Returns whether elements are stored compressed.
+  bool compressed() const { return compressed_; }
+
+  // Replaces `element` with its compressed representation if the cache is
+  // compressed.
+  Status Compress(std::vector<Tensor>* element) const;
+
+  // Inserts the tensors of the element at the given index at the beginning of
+  // `out_tensors`, uncompressing them if needed.
+  Status GetElement(int64 index, std::vector<Tensor>* out_tensors);
+
  private:
+  const bool compressed_;
   mutex mu_;
   // Determines whether all elements of the dataset have been cached.
   bool completed_ GUARDED_BY(mu_) = false;
@@ -92,6 +92,8 @@ class SimpleStepStatsCollector : public StepStatsCollectorInterface {
 
     void SetReferencedTensors(const TensorReferenceVector& tensors) override {}
 
+    void SetReady(int64 nanos) override {}
+
     void SetScheduled(int64 nanos) override {}
 
    private:
@@ -752,7 +754,8 @@ Status InstantiatedCapturedFunction::RunInstantiated(
 
 void InstantiatedCapturedFunction::RunAsync(
     IteratorContext* ctx, std::vector<Tensor>&& args, std::vector<Tensor>* rets,
-    FunctionLibraryRuntime::DoneCallback done, const string& prefix) const {
+    FunctionLibraryRuntime::DoneCallback done, const string& prefix,
+    RetvalBufferProvider* retval_buffer_provider) const {
   auto& info = captured_func_->short_circuit_info();
   if (!info.indices.empty()) {
     // Run the `done` callback on a threadpool thread, because it will
@@ -780,6 +783,7 @@ void InstantiatedCapturedFunction::RunAsync(
   f_opts.step_container = step_container;
   f_opts.runner = ctx->runner();
   f_opts.create_rendezvous = ShouldCreateRendezvous();
+  f_opts.retval_buffer_provider = retval_buffer_provider;
   auto cancellation_manager =
       absl::make_unique<CancellationManager>(ctx->cancellation_manager());
   f_opts.cancellation_manager = cancellation_manager.get();
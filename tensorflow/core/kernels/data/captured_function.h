@@ -88,10 +88,14 @@ class InstantiatedCapturedFunction {
   // the results in `*rets`, and calls the given `done` callback when the
   // function returns. This method takes ownership of the tensors in `args`,
   // in order to be able to deallocate them as early as possible.
+  //
+  // If `retval_buffer_provider` is not null, the results are computed into
+  // the buffers it hands out where possible; it must outlive the call.
   void RunAsync(IteratorContext* ctx, std::vector<Tensor>&& args,
                 std::vector<Tensor>* rets,
                 FunctionLibraryRuntime::DoneCallback done,
-                const string& prefix) const;
+                const string& prefix,
+                RetvalBufferProvider* retval_buffer_provider = nullptr) const;
 
  private:
   InstantiatedCapturedFunction(
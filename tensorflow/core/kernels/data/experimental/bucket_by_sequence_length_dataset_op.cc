@@ -0,0 +1,663 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/bucket_by_sequence_length_dataset_op.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/stats_aggregator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/kernels/data/stats_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/batch_util.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kInputDataset;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kBucketBoundaries;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kBucketBatchSizes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kPaddedShapes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kPaddingValues;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kDropRemainder;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kLengthComponent;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kPadToBucketBoundary;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kToutputTypes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kOutputShapes;
+/* static */ constexpr const char* const BucketBySequenceLengthDatasetOp::kN;
+
+namespace {
+
+// See documentation in ../../ops/experimental_dataset_ops.cc for a high-level
+// description of the following op.
+
+constexpr char kEndOfInput[] = "end_of_input";
+constexpr char kNextFlushBucket[] = "next_flush_bucket";
+constexpr char kNumElements[] = "num_elements";
+constexpr char kNumValues[] = "num_values";
+constexpr char kBatch[] = "batch";
+constexpr char kElement[] = "element";
+
+}  // namespace
+
+class BucketBySequenceLengthDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input,
+          std::vector<int64> bucket_boundaries,
+          std::vector<int64> bucket_batch_sizes,
+          std::vector<PartialTensorShape> padded_shapes,
+          std::vector<Tensor> padding_values, bool drop_remainder,
+          int64 length_component, bool pad_to_bucket_boundary)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        bucket_boundaries_(std::move(bucket_boundaries)),
+        bucket_batch_sizes_(std::move(bucket_batch_sizes)),
+        padded_shapes_(std::move(padded_shapes)),
+        padding_values_(std::move(padding_values)),
+        drop_remainder_(drop_remainder),
+        length_component_(length_component),
+        pad_to_bucket_boundary_(pad_to_bucket_boundary) {
+    input_->Ref();
+
+    // The batch dimension is only static if every batch is full and all
+    // buckets have the same batch size.
+    int64 batch_dim = bucket_batch_sizes_[0];
+    for (int64 batch_size : bucket_batch_sizes_) {
+      if (!drop_remainder_ || batch_size != batch_dim) {
+        batch_dim = -1;
+      }
+    }
+    output_shapes_.reserve(padded_shapes_.size());
+    for (const auto& padded_shape : padded_shapes_) {
+      output_shapes_.push_back(
+          PartialTensorShape({batch_dim}).Concatenate(padded_shape));
+    }
+
+    // With `pad_to_bucket_boundary`, the padded shape of a bucket is known
+    // up front whenever the boundary fills in all its unknown dimensions,
+    // so its elements can be padded into the batch as they arrive.
+    bucket_padded_shapes_.resize(bucket_batch_sizes_.size());
+    fully_defined_.resize(bucket_batch_sizes_.size(), true);
+    for (size_t bucket = 0; bucket < bucket_batch_sizes_.size(); ++bucket) {
+      for (const auto& padded_shape : padded_shapes_) {
+        PartialTensorShape shape = padded_shape;
+        if (pad_to_bucket_boundary_ && bucket < bucket_boundaries_.size()) {
+          for (int dim = 0; dim < shape.dims(); ++dim) {
+            if (shape.dim_size(dim) == -1) {
+              shape.set_dim(dim, bucket_boundaries_[bucket] - 1);
+            }
+          }
+        }
+        if (!shape.IsFullyDefined()) {
+          fully_defined_[bucket] = false;
+        }
+        bucket_padded_shapes_[bucket].push_back(std::move(shape));
+      }
+    }
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* bucket_boundaries = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(bucket_boundaries_, &bucket_boundaries));
+    Node* bucket_batch_sizes = nullptr;
+    TF_RETURN_IF_ERROR(
+        b->AddVector(bucket_batch_sizes_, &bucket_batch_sizes));
+
+    std::vector<Node*> padded_shapes;
+    padded_shapes.reserve(padded_shapes_.size());
+    for (const auto& padded_shape : padded_shapes_) {
+      Node* node;
+      Tensor t(DT_INT64, TensorShape({padded_shape.dims()}));
+      for (int j = 0; j < padded_shape.dims(); ++j) {
+        t.vec<int64>()(j) = padded_shape.dim_size(j);
+      }
+      TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+      padded_shapes.emplace_back(node);
+    }
+
+    std::vector<Node*> padding_values;
+    padding_values.reserve(padding_values_.size());
+    for (const Tensor& t : padding_values_) {
+      Node* node;
+      TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+      padding_values.emplace_back(node);
+    }
+
+    Node* drop_remainder = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(drop_remainder_, &drop_remainder));
+
+    AttrValue length_component;
+    b->BuildAttrValue(length_component_, &length_component);
+    AttrValue pad_to_bucket_boundary;
+    b->BuildAttrValue(pad_to_bucket_boundary_, &pad_to_bucket_boundary);
+    AttrValue output_types;
+    b->BuildAttrValue(output_dtypes(), &output_types);
+    AttrValue N;
+    b->BuildAttrValue<int64>(padded_shapes_.size(), &N);
+
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this,
+        {{0, input_graph_node},
+         {1, bucket_boundaries},
+         {2, bucket_batch_sizes},
+         {5, drop_remainder}},
+        {{3, padded_shapes}, {4, padding_values}},
+        {{kLengthComponent, length_component},
+         {kPadToBucketBoundary, pad_to_bucket_boundary},
+         {kToutputTypes, output_types},
+         {kN, N}},
+        output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params) {}
+
+    Status Initialize(IteratorContext* ctx) override {
+      buckets_.resize(dataset()->bucket_batch_sizes_.size());
+      return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      while (input_impl_) {
+        std::vector<Tensor> element;
+        bool end_of_input;
+        TF_RETURN_IF_ERROR(
+            input_impl_->GetNext(ctx, &element, &end_of_input));
+        if (end_of_input) {
+          input_impl_.reset();
+          break;
+        }
+        int64 bucket_id;
+        TF_RETURN_IF_ERROR(BucketFor(element, &bucket_id));
+        TF_RETURN_IF_ERROR(AddToBucket(ctx, bucket_id, std::move(element)));
+        if (buckets_[bucket_id].num_elements ==
+            dataset()->bucket_batch_sizes_[bucket_id]) {
+          *end_of_sequence = false;
+          return ProduceBatch(ctx, bucket_id, out_tensors);
+        }
+      }
+      // At the end of the input, produce the partial batches in bucket
+      // order.
+      while (next_flush_bucket_ < static_cast<int64>(buckets_.size())) {
+        const int64 bucket_id = next_flush_bucket_++;
+        if (buckets_[bucket_id].num_elements > 0 &&
+            !dataset()->drop_remainder_) {
+          *end_of_sequence = false;
+          return ProduceBatch(ctx, bucket_id, out_tensors);
+        }
+        buckets_[bucket_id] = Bucket();
+      }
+      *end_of_sequence = true;
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeUnknownRatioNode(std::move(args));
+    }
+
+    Status SaveInternal(IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      if (input_impl_) {
+        TF_RETURN_IF_ERROR(SaveInput(writer, input_impl_));
+      } else {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kEndOfInput), ""));
+      }
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kNextFlushBucket),
+                                             next_flush_bucket_));
+      for (size_t i = 0; i < buckets_.size(); ++i) {
+        const Bucket& bucket = buckets_[i];
+        const string prefix = strings::StrCat("buckets[", i, "]");
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(strings::StrCat(prefix, kNumElements)),
+            bucket.num_elements));
+        if (bucket.num_elements == 0) {
+          continue;
+        }
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(strings::StrCat(prefix, kNumValues)),
+            bucket.num_values));
+        // A bucket either pads its elements into `batch` as they arrive or
+        // keeps them in `elements`, depending on its padded shape.
+        for (size_t j = 0; j < bucket.batch.size(); ++j) {
+          TF_RETURN_IF_ERROR(writer->WriteTensor(
+              full_name(strings::StrCat(prefix, kBatch, "[", j, "]")),
+              bucket.batch[j]));
+        }
+        for (size_t j = 0; j < bucket.elements.size(); ++j) {
+          for (size_t k = 0; k < bucket.elements[j].size(); ++k) {
+            TF_RETURN_IF_ERROR(writer->WriteTensor(
+                full_name(
+                    strings::StrCat(prefix, kElement, "[", j, "][", k, "]")),
+                bucket.elements[j][k]));
+          }
+        }
+      }
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      if (reader->Contains(full_name(kEndOfInput))) {
+        input_impl_.reset();
+      } else {
+        TF_RETURN_IF_ERROR(
+            dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_));
+        TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+      }
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kNextFlushBucket),
+                                            &next_flush_bucket_));
+      const size_t num_components = dataset()->output_dtypes().size();
+      buckets_.clear();
+      buckets_.resize(dataset()->bucket_batch_sizes_.size());
+      for (size_t i = 0; i < buckets_.size(); ++i) {
+        Bucket& bucket = buckets_[i];
+        const string prefix = strings::StrCat("buckets[", i, "]");
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            full_name(strings::StrCat(prefix, kNumElements)),
+            &bucket.num_elements));
+        if (bucket.num_elements == 0) {
+          continue;
+        }
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            full_name(strings::StrCat(prefix, kNumValues)),
+            &bucket.num_values));
+        if (dataset()->fully_defined_[i]) {
+          bucket.batch.resize(num_components);
+          for (size_t j = 0; j < num_components; ++j) {
+            TF_RETURN_IF_ERROR(reader->ReadTensor(
+                full_name(strings::StrCat(prefix, kBatch, "[", j, "]")),
+                &bucket.batch[j]));
+          }
+        } else {
+          bucket.elements.resize(bucket.num_elements);
+          for (size_t j = 0; j < bucket.elements.size(); ++j) {
+            bucket.elements[j].resize(num_components);
+            for (size_t k = 0; k < num_components; ++k) {
+              TF_RETURN_IF_ERROR(reader->ReadTensor(
+                  full_name(strings::StrCat(prefix, kElement, "[", j, "][",
+                                            k, "]")),
+                  &bucket.elements[j][k]));
+            }
+          }
+        }
+      }
+      return Status::OK();
+    }
+
+   private:
+    struct Bucket {
+      // The batch that elements are padded into as they arrive, if the
+      // padded shape of the bucket is fully defined.
+      std::vector<Tensor> batch;
+      // The elements of the batch otherwise, which are padded once the
+      // batch is complete.
+      std::vector<std::vector<Tensor>> elements;
+      int64 num_elements = 0;
+      // The number of values of the elements, excluding padding.
+      int64 num_values = 0;
+    };
+
+    Status BucketFor(const std::vector<Tensor>& element, int64* bucket_id) {
+      const Tensor& t = element[dataset()->length_component_];
+      int64 length;
+      if (t.dims() > 0) {
+        length = t.dim_size(0);
+      } else if (t.dtype() == DT_INT32) {
+        length = t.scalar<int32>()();
+      } else if (t.dtype() == DT_INT64) {
+        length = t.scalar<int64>()();
+      } else {
+        return errors::InvalidArgument(
+            "The length component must be an integer scalar or have at "
+            "least one dimension, but got a ",
+            DataTypeString(t.dtype()), " scalar.");
+      }
+      const auto& boundaries = dataset()->bucket_boundaries_;
+      *bucket_id =
+          std::upper_bound(boundaries.begin(), boundaries.end(), length) -
+          boundaries.begin();
+      if (dataset()->pad_to_bucket_boundary_ &&
+          *bucket_id == static_cast<int64>(boundaries.size())) {
+        return errors::InvalidArgument(
+            "When padding to the bucket boundary, elements must have "
+            "length < max(bucket_boundaries), but got length ",
+            length, ".");
+      }
+      return Status::OK();
+    }
+
+    Status AddToBucket(IteratorContext* ctx, int64 bucket_id,
+                       std::vector<Tensor> element)
+        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const auto& padded_shapes = dataset()->bucket_padded_shapes_[bucket_id];
+      Bucket& bucket = buckets_[bucket_id];
+      for (size_t i = 0; i < element.size(); ++i) {
+        if (element[i].dims() != padded_shapes[i].dims()) {
+          return errors::InvalidArgument(
+              "All elements in a batch must have the same rank as the "
+              "padded shape for component",
+              i, ": expected rank ", padded_shapes[i].dims(),
+              " but got element with rank ", element[i].dims());
+        }
+        bucket.num_values += element[i].NumElements();
+      }
+      if (!dataset()->fully_defined_[bucket_id]) {
+        bucket.elements.push_back(std::move(element));
+        ++bucket.num_elements;
+        return Status::OK();
+      }
+      if (bucket.batch.empty()) {
+        const int64 batch_size = dataset()->bucket_batch_sizes_[bucket_id];
+        for (size_t i = 0; i < element.size(); ++i) {
+          TensorShape shape({batch_size});
+          for (int dim = 0; dim < padded_shapes[i].dims(); ++dim) {
+            shape.AddDim(padded_shapes[i].dim_size(dim));
+          }
+          TF_RETURN_IF_ERROR(AllocateBatch(ctx, i, shape, &bucket.batch));
+        }
+      }
+      for (size_t i = 0; i < element.size(); ++i) {
+        TF_RETURN_IF_ERROR(
+            CopyElement(element[i], &bucket.batch[i], bucket.num_elements));
+      }
+      ++bucket.num_elements;
+      return Status::OK();
+    }
+
+    Status ProduceBatch(IteratorContext* ctx, int64 bucket_id,
+                        std::vector<Tensor>* out_tensors)
+        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      Bucket bucket = std::move(buckets_[bucket_id]);
+      buckets_[bucket_id] = Bucket();
+      if (bucket.elements.empty()) {
+        for (Tensor& batch : bucket.batch) {
+          if (bucket.num_elements < batch.dim_size(0)) {
+            out_tensors->push_back(batch.Slice(0, bucket.num_elements));
+          } else {
+            out_tensors->push_back(std::move(batch));
+          }
+        }
+      } else {
+        TF_RETURN_IF_ERROR(PadElements(ctx, bucket_id, bucket.elements,
+                                       out_tensors));
+      }
+      const auto& stats_aggregator = ctx->stats_aggregator();
+      if (stats_aggregator) {
+        int64 num_padded_values = 0;
+        for (const Tensor& t : *out_tensors) {
+          num_padded_values += t.NumElements();
+        }
+        if (num_padded_values > 0) {
+          stats_aggregator->AddToHistogram(
+              stats_utils::PaddingWasteHistogramName(dataset()->node_name()),
+              {1.0f - static_cast<float>(bucket.num_values) /
+                          static_cast<float>(num_padded_values)},
+              num_elements());
+        }
+      }
+      return Status::OK();
+    }
+
+    // Pads `elements` into a batch whose unknown dimensions are the
+    // maximum size of the elements in that dimension.
+    Status PadElements(IteratorContext* ctx, int64 bucket_id,
+                       const std::vector<std::vector<Tensor>>& elements,
+                       std::vector<Tensor>* out_tensors) {
+      const auto& padded_shapes = dataset()->bucket_padded_shapes_[bucket_id];
+      const int64 num_elements = elements.size();
+      for (size_t i = 0; i < padded_shapes.size(); ++i) {
+        TensorShape shape({num_elements});
+        for (int dim = 0; dim < padded_shapes[i].dims(); ++dim) {
+          int64 size = padded_shapes[i].dim_size(dim);
+          if (size == -1) {
+            size = 0;
+            for (const auto& element : elements) {
+              size = std::max(size, element[i].dim_size(dim));
+            }
+          }
+          shape.AddDim(size);
+        }
+        TF_RETURN_IF_ERROR(AllocateBatch(ctx, i, shape, out_tensors));
+        for (int64 j = 0; j < num_elements; ++j) {
+          TF_RETURN_IF_ERROR(
+              CopyElement(elements[j][i], &out_tensors->back(), j));
+        }
+      }
+      return Status::OK();
+    }
+
+    // Appends a batch of `shape` for component `index` that is filled with
+    // its padding value to `batch`.
+    Status AllocateBatch(IteratorContext* ctx, size_t index,
+                         const TensorShape& shape,
+                         std::vector<Tensor>* batch) {
+      batch->emplace_back(ctx->allocator({}),
+                          dataset()->output_dtypes()[index], shape);
+      if (!batch->back().IsInitialized()) {
+        return errors::ResourceExhausted(
+            "Failed to allocate memory for the batch of component ", index);
+      }
+      return batch_util::SetElementZero(&batch->back(),
+                                        dataset()->padding_values_[index]);
+    }
+
+    // Copies `element` into slice `index` of `batch`, padding it if it is
+    // smaller than the slice.
+    static Status CopyElement(const Tensor& element, Tensor* batch,
+                              int64 index) {
+      bool needs_padding = false;
+      for (int dim = 0; dim < element.dims(); ++dim) {
+        if (element.dim_size(dim) > batch->dim_size(dim + 1)) {
+          return errors::DataLoss(
+              "Attempted to pad to a smaller size than the input element.");
+        }
+        needs_padding |= element.dim_size(dim) < batch->dim_size(dim + 1);
+      }
+      if (needs_padding) {
+        return batch_util::CopyElementToLargerSlice(element, batch, index);
+      }
+      return batch_util::CopyElementToSlice(element, batch, index);
+    }
+
+    mutex mu_;
+    std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+    std::vector<Bucket> buckets_ GUARDED_BY(mu_);
+    // The next bucket to produce a partial batch from once the input is
+    // exhausted.
+    int64 next_flush_bucket_ GUARDED_BY(mu_) = 0;
+  };
+
+  const DatasetBase* const input_;
+  const std::vector<int64> bucket_boundaries_;
+  const std::vector<int64> bucket_batch_sizes_;
+  const std::vector<PartialTensorShape> padded_shapes_;
+  const std::vector<Tensor> padding_values_;
+  const bool drop_remainder_;
+  const int64 length_component_;
+  const bool pad_to_bucket_boundary_;
+  std::vector<PartialTensorShape> output_shapes_;
+  // The padded shape of each component in each bucket.
+  std::vector<std::vector<PartialTensorShape>> bucket_padded_shapes_;
+  // Whether all padded shapes of a bucket are fully defined.
+  std::vector<bool> fully_defined_;
+};
+
+BucketBySequenceLengthDatasetOp::BucketBySequenceLengthDatasetOp(
+    OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kLengthComponent, &length_component_));
+  OP_REQUIRES_OK(ctx,
+                 ctx->GetAttr(kPadToBucketBoundary, &pad_to_bucket_boundary_));
+}
+
+void BucketBySequenceLengthDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                                  DatasetBase* input,
+                                                  DatasetBase** output) {
+  std::vector<int64> bucket_boundaries;
+  OP_REQUIRES_OK(ctx, ParseVectorArgument<int64>(ctx, kBucketBoundaries,
+                                                 &bucket_boundaries));
+  for (size_t i = 1; i < bucket_boundaries.size(); ++i) {
+    OP_REQUIRES(ctx, bucket_boundaries[i - 1] < bucket_boundaries[i],
+                errors::InvalidArgument(
+                    "Bucket boundaries must be strictly increasing."));
+  }
+  std::vector<int64> bucket_batch_sizes;
+  OP_REQUIRES_OK(ctx, ParseVectorArgument<int64>(ctx, kBucketBatchSizes,
+                                                 &bucket_batch_sizes));
+  OP_REQUIRES(ctx, bucket_batch_sizes.size() == bucket_boundaries.size() + 1,
+              errors::InvalidArgument(
+                  "Number of bucket batch sizes (", bucket_batch_sizes.size(),
+                  ") must be one more than the number of bucket boundaries (",
+                  bucket_boundaries.size(), ")"));
+  for (int64 batch_size : bucket_batch_sizes) {
+    OP_REQUIRES(
+        ctx, batch_size > 0,
+        errors::InvalidArgument("Batch size must be greater than zero."));
+  }
+  OP_REQUIRES(
+      ctx, !pad_to_bucket_boundary_ || !bucket_boundaries.empty(),
+      errors::InvalidArgument("Padding to the bucket boundary requires at "
+                              "least one bucket boundary."));
+  const int64 num_components = input->output_dtypes().size();
+  OP_REQUIRES(ctx,
+              length_component_ >= 0 && length_component_ < num_components,
+              errors::InvalidArgument(
+                  "Length component ", length_component_,
+                  " is out of range for elements with ", num_components,
+                  " components"));
+
+  bool drop_remainder;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<bool>(ctx, kDropRemainder,
+                                                &drop_remainder));
+
+  OpInputList padded_shape_tensors;
+  OP_REQUIRES_OK(ctx,
+                 ctx->input_list(kPaddedShapes, &padded_shape_tensors));
+  OP_REQUIRES(ctx, padded_shape_tensors.size() == num_components,
+              errors::InvalidArgument("Number of padded shapes (",
+                                      padded_shape_tensors.size(),
+                                      ") must match the number of components "
+                                      "in the input dataset's elements (",
+                                      num_components, ")"));
+  std::vector<PartialTensorShape> padded_shapes;
+  padded_shapes.reserve(num_components);
+  for (const Tensor& padded_shape_t : padded_shape_tensors) {
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(padded_shape_t.shape()),
+                errors::InvalidArgument("All padded shapes must be vectors"));
+    PartialTensorShape padded_shape;
+    OP_REQUIRES_OK(ctx, PartialTensorShape::MakePartialShape(
+                            padded_shape_t.vec<int64>().data(),
+                            padded_shape_t.NumElements(), &padded_shape));
+    padded_shapes.push_back(std::move(padded_shape));
+  }
+
+  OpInputList padding_values_list;
+  OP_REQUIRES_OK(ctx,
+                 ctx->input_list(kPaddingValues, &padding_values_list));
+  OP_REQUIRES(ctx, padding_values_list.size() == num_components,
+              errors::InvalidArgument(
+                  "Number of padding values (", padding_values_list.size(),
+                  ") must match the number of components in the input "
+                  "dataset's elements (",
+                  num_components, ")"));
+  std::vector<Tensor> padding_values;
+  padding_values.reserve(num_components);
+  for (int i = 0; i < padding_values_list.size(); ++i) {
+    const Tensor& padding_value_t = padding_values_list[i];
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsScalar(padding_value_t.shape()),
+        errors::InvalidArgument("All padding values must be scalars"));
+    OP_REQUIRES(ctx, padding_value_t.dtype() == input->output_dtypes()[i],
+                errors::InvalidArgument(
+                    "Mismatched type between padding value ", i,
+                    " and input dataset's component ", i, ": ",
+                    DataTypeString(padding_value_t.dtype()), " vs. ",
+                    DataTypeString(input->output_dtypes()[i])));
+    padding_values.push_back(tensor::DeepCopy(padding_value_t));
+  }
+
+  *output = new Dataset(ctx, input, std::move(bucket_boundaries),
+                        std::move(bucket_batch_sizes),
+                        std::move(padded_shapes), std::move(padding_values),
+                        drop_remainder, length_component_,
+                        pad_to_bucket_boundary_);
+}
+
+namespace {
+
+REGISTER_KERNEL_BUILDER(
+    Name("BucketBySequenceLengthDataset").Device(DEVICE_CPU),
+    BucketBySequenceLengthDatasetOp);
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
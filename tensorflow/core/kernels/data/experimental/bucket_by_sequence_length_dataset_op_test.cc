@@ -0,0 +1,380 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/bucket_by_sequence_length_dataset_op.h"
+
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "bucket_by_sequence_length_dataset";
+
+class BucketBySequenceLengthDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  BucketBySequenceLengthDatasetParams(
+      T input_dataset_params, std::vector<int64> bucket_boundaries,
+      std::vector<int64> bucket_batch_sizes, std::vector<Tensor> padded_shapes,
+      std::vector<Tensor> padding_values, bool drop_remainder,
+      int64 length_component, bool pad_to_bucket_boundary,
+      DataTypeVector output_dtypes,
+      std::vector<PartialTensorShape> output_shapes)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      kNodeName),
+        bucket_boundaries_(std::move(bucket_boundaries)),
+        bucket_batch_sizes_(std::move(bucket_batch_sizes)),
+        padded_shapes_(std::move(padded_shapes)),
+        padding_values_(std::move(padding_values)),
+        drop_remainder_(drop_remainder),
+        length_component_(length_component),
+        pad_to_bucket_boundary_(pad_to_bucket_boundary) {
+    input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    std::vector<Tensor> input_tensors;
+    input_tensors.push_back(CreateTensor<int64>(
+        TensorShape({static_cast<int64>(bucket_boundaries_.size())}),
+        bucket_boundaries_));
+    input_tensors.push_back(CreateTensor<int64>(
+        TensorShape({static_cast<int64>(bucket_batch_sizes_.size())}),
+        bucket_batch_sizes_));
+    for (const Tensor& padded_shape : padded_shapes_) {
+      input_tensors.push_back(padded_shape);
+    }
+    for (const Tensor& padding_value : padding_values_) {
+      input_tensors.push_back(padding_value);
+    }
+    input_tensors.push_back(
+        CreateTensor<bool>(TensorShape({}), {drop_remainder_}));
+    return input_tensors;
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {BucketBySequenceLengthDatasetOp::kInputDataset,
+                    BucketBySequenceLengthDatasetOp::kBucketBoundaries,
+                    BucketBySequenceLengthDatasetOp::kBucketBatchSizes};
+    for (int i = 0; i < padded_shapes_.size(); ++i) {
+      input_names->emplace_back(strings::StrCat(
+          BucketBySequenceLengthDatasetOp::kPaddedShapes, "_", i));
+    }
+    for (int i = 0; i < padding_values_.size(); ++i) {
+      input_names->emplace_back(strings::StrCat(
+          BucketBySequenceLengthDatasetOp::kPaddingValues, "_", i));
+    }
+    input_names->push_back(BucketBySequenceLengthDatasetOp::kDropRemainder);
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {
+        {BucketBySequenceLengthDatasetOp::kLengthComponent, length_component_},
+        {BucketBySequenceLengthDatasetOp::kPadToBucketBoundary,
+         pad_to_bucket_boundary_},
+        {BucketBySequenceLengthDatasetOp::kToutputTypes, output_dtypes_},
+        {BucketBySequenceLengthDatasetOp::kOutputShapes, output_shapes_},
+        {BucketBySequenceLengthDatasetOp::kN,
+         static_cast<int64>(padded_shapes_.size())}};
+    return Status::OK();
+  }
+
+  string dataset_type() const override {
+    return BucketBySequenceLengthDatasetOp::kDatasetType;
+  }
+
+ private:
+  std::vector<int64> bucket_boundaries_;
+  std::vector<int64> bucket_batch_sizes_;
+  std::vector<Tensor> padded_shapes_;
+  std::vector<Tensor> padding_values_;
+  bool drop_remainder_;
+  int64 length_component_;
+  bool pad_to_bucket_boundary_;
+};
+
+class BucketBySequenceLengthDatasetOpTest : public DatasetOpsTestBase {};
+
+// Scalar elements that are their own length: 1, 2 and 3 go to the first
+// bucket and 5, 7 and 9 to the second one.
+TensorSliceDatasetParams ScalarLengthsDatasetParams() {
+  return TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<int64>(TensorShape{6}, {1, 5, 2, 7, 3, 9})},
+      /*node_name=*/"tensor_slice");
+}
+
+// Vectors of length 1, followed by vectors of length 4.
+ConcatenateDatasetParams VectorLengthsDatasetParams() {
+  auto tensor_slice_dataset_params_0 = TensorSliceDatasetParams(
+      /*components=*/CreateTensors<int64>(TensorShape{3, 1}, {{0, 1, 2}}),
+      /*node_name=*/"tensor_slice_0");
+  auto tensor_slice_dataset_params_1 = TensorSliceDatasetParams(
+      /*components=*/CreateTensors<int64>(
+          TensorShape{3, 4}, {{3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14}}),
+      /*node_name=*/"tensor_slice_1");
+  return ConcatenateDatasetParams(std::move(tensor_slice_dataset_params_0),
+                                  std::move(tensor_slice_dataset_params_1),
+                                  /*output_dtypes=*/{DT_INT64},
+                                  /*output_shapes=*/{PartialTensorShape({-1})},
+                                  /*node_name=*/"concatenate");
+}
+
+// Pads scalars into fully defined batches, with the partial batches at the
+// end.
+BucketBySequenceLengthDatasetParams ScalarLengthsParams() {
+  return BucketBySequenceLengthDatasetParams(
+      ScalarLengthsDatasetParams(),
+      /*bucket_boundaries=*/{4},
+      /*bucket_batch_sizes=*/{2, 2},
+      /*padded_shapes=*/{CreateTensor<int64>(TensorShape{0}, {})},
+      /*padding_values=*/{CreateTensor<int64>(TensorShape{}, {0})},
+      /*drop_remainder=*/false,
+      /*length_component=*/0,
+      /*pad_to_bucket_boundary=*/false,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})});
+}
+
+// Same as above, but drops the partial batches.
+BucketBySequenceLengthDatasetParams DropRemainderParams() {
+  return BucketBySequenceLengthDatasetParams(
+      ScalarLengthsDatasetParams(),
+      /*bucket_boundaries=*/{4},
+      /*bucket_batch_sizes=*/{2, 2},
+      /*padded_shapes=*/{CreateTensor<int64>(TensorShape{0}, {})},
+      /*padding_values=*/{CreateTensor<int64>(TensorShape{}, {0})},
+      /*drop_remainder=*/true,
+      /*length_component=*/0,
+      /*pad_to_bucket_boundary=*/false,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({2})});
+}
+
+// Pads vectors to the longest vector of each batch.
+BucketBySequenceLengthDatasetParams PadToLongestParams() {
+  return BucketBySequenceLengthDatasetParams(
+      VectorLengthsDatasetParams(),
+      /*bucket_boundaries=*/{3},
+      /*bucket_batch_sizes=*/{2, 2},
+      /*padded_shapes=*/{CreateTensor<int64>(TensorShape{1}, {-1})},
+      /*padding_values=*/{CreateTensor<int64>(TensorShape{}, {-1})},
+      /*drop_remainder=*/false,
+      /*length_component=*/0,
+      /*pad_to_bucket_boundary=*/false,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1, -1})});
+}
+
+// Pads vectors to the boundary of their bucket minus one.
+BucketBySequenceLengthDatasetParams PadToBucketBoundaryParams() {
+  return BucketBySequenceLengthDatasetParams(
+      VectorLengthsDatasetParams(),
+      /*bucket_boundaries=*/{3, 5},
+      /*bucket_batch_sizes=*/{2, 2, 2},
+      /*padded_shapes=*/{CreateTensor<int64>(TensorShape{1}, {-1})},
+      /*padding_values=*/{CreateTensor<int64>(TensorShape{}, {-1})},
+      /*drop_remainder=*/false,
+      /*length_component=*/0,
+      /*pad_to_bucket_boundary=*/true,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1, -1})});
+}
+
+// Elements of length 4 are too long for the bucket boundaries.
+BucketBySequenceLengthDatasetParams TooLongForBucketBoundaryParams() {
+  return BucketBySequenceLengthDatasetParams(
+      VectorLengthsDatasetParams(),
+      /*bucket_boundaries=*/{3},
+      /*bucket_batch_sizes=*/{2, 2},
+      /*padded_shapes=*/{CreateTensor<int64>(TensorShape{1}, {-1})},
+      /*padding_values=*/{CreateTensor<int64>(TensorShape{}, {-1})},
+      /*drop_remainder=*/false,
+      /*length_component=*/0,
+      /*pad_to_bucket_boundary=*/true,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1, -1})});
+}
+
+BucketBySequenceLengthDatasetParams InvalidLengthComponentParams() {
+  return BucketBySequenceLengthDatasetParams(
+      ScalarLengthsDatasetParams(),
+      /*bucket_boundaries=*/{4},
+      /*bucket_batch_sizes=*/{2, 2},
+      /*padded_shapes=*/{CreateTensor<int64>(TensorShape{0}, {})},
+      /*padding_values=*/{CreateTensor<int64>(TensorShape{}, {0})},
+      /*drop_remainder=*/false,
+      /*length_component=*/1,
+      /*pad_to_bucket_boundary=*/false,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})});
+}
+
+BucketBySequenceLengthDatasetParams InvalidBucketBatchSizesParams() {
+  return BucketBySequenceLengthDatasetParams(
+      ScalarLengthsDatasetParams(),
+      /*bucket_boundaries=*/{4},
+      /*bucket_batch_sizes=*/{2},
+      /*padded_shapes=*/{CreateTensor<int64>(TensorShape{0}, {})},
+      /*padding_values=*/{CreateTensor<int64>(TensorShape{}, {0})},
+      /*drop_remainder=*/false,
+      /*length_component=*/0,
+      /*pad_to_bucket_boundary=*/false,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})});
+}
+
+BucketBySequenceLengthDatasetParams DecreasingBucketBoundariesParams() {
+  return BucketBySequenceLengthDatasetParams(
+      ScalarLengthsDatasetParams(),
+      /*bucket_boundaries=*/{4, 2},
+      /*bucket_batch_sizes=*/{2, 2, 2},
+      /*padded_shapes=*/{CreateTensor<int64>(TensorShape{0}, {})},
+      /*padding_values=*/{CreateTensor<int64>(TensorShape{}, {0})},
+      /*drop_remainder=*/false,
+      /*length_component=*/0,
+      /*pad_to_bucket_boundary=*/false,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})});
+}
+
+std::vector<GetNextTestCase<BucketBySequenceLengthDatasetParams>>
+GetNextTestCases() {
+  return {{/*dataset_params=*/ScalarLengthsParams(),
+           /*expected_outputs=*/
+           {CreateTensor<int64>(TensorShape{2}, {1, 2}),
+            CreateTensor<int64>(TensorShape{2}, {5, 7}),
+            CreateTensor<int64>(TensorShape{1}, {3}),
+            CreateTensor<int64>(TensorShape{1}, {9})}},
+          {/*dataset_params=*/DropRemainderParams(),
+           /*expected_outputs=*/
+           {CreateTensor<int64>(TensorShape{2}, {1, 2}),
+            CreateTensor<int64>(TensorShape{2}, {5, 7})}},
+          {/*dataset_params=*/PadToLongestParams(),
+           /*expected_outputs=*/
+           {CreateTensor<int64>(TensorShape{2, 1}, {0, 1}),
+            CreateTensor<int64>(TensorShape{2, 4}, {3, 4, 5, 6, 7, 8, 9, 10}),
+            CreateTensor<int64>(TensorShape{1, 1}, {2}),
+            CreateTensor<int64>(TensorShape{1, 4}, {11, 12, 13, 14})}},
+          {/*dataset_params=*/PadToBucketBoundaryParams(),
+           /*expected_outputs=*/
+           {CreateTensor<int64>(TensorShape{2, 2}, {0, -1, 1, -1}),
+            CreateTensor<int64>(TensorShape{2, 4}, {3, 4, 5, 6, 7, 8, 9, 10}),
+            CreateTensor<int64>(TensorShape{1, 2}, {2, -1}),
+            CreateTensor<int64>(TensorShape{1, 4}, {11, 12, 13, 14})}}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(BucketBySequenceLengthDatasetOpTest,
+                         BucketBySequenceLengthDatasetParams,
+                         GetNextTestCases())
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, DatasetNodeName) {
+  auto dataset_params = ScalarLengthsParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetNodeName(dataset_params.node_name()));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, DatasetTypeString) {
+  auto dataset_params = ScalarLengthsParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetTypeString(
+      name_utils::OpName(BucketBySequenceLengthDatasetOp::kDatasetType)));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, DatasetOutputDtypes) {
+  auto dataset_params = ScalarLengthsParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputDtypes({DT_INT64}));
+}
+
+std::vector<DatasetOutputShapesTestCase<BucketBySequenceLengthDatasetParams>>
+DatasetOutputShapesTestCases() {
+  return {{/*dataset_params=*/ScalarLengthsParams(),
+           /*expected_output_shapes=*/{PartialTensorShape({-1})}},
+          {/*dataset_params=*/DropRemainderParams(),
+           /*expected_output_shapes=*/{PartialTensorShape({2})}},
+          {/*dataset_params=*/PadToBucketBoundaryParams(),
+           /*expected_output_shapes=*/{PartialTensorShape({-1, -1})}}};
+}
+
+DATASET_OUTPUT_SHAPES_TEST_P(BucketBySequenceLengthDatasetOpTest,
+                             BucketBySequenceLengthDatasetParams,
+                             DatasetOutputShapesTestCases())
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, IteratorPrefix) {
+  auto dataset_params = ScalarLengthsParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorPrefix(name_utils::IteratorPrefix(
+      BucketBySequenceLengthDatasetOp::kDatasetType,
+      dataset_params.iterator_prefix())));
+}
+
+std::vector<IteratorSaveAndRestoreTestCase<BucketBySequenceLengthDatasetParams>>
+IteratorSaveAndRestoreTestCases() {
+  return {{/*dataset_params=*/ScalarLengthsParams(),
+           /*breakpoints=*/{0, 1, 3, 5},
+           /*expected_outputs=*/
+           {CreateTensor<int64>(TensorShape{2}, {1, 2}),
+            CreateTensor<int64>(TensorShape{2}, {5, 7}),
+            CreateTensor<int64>(TensorShape{1}, {3}),
+            CreateTensor<int64>(TensorShape{1}, {9})}},
+          {/*dataset_params=*/PadToLongestParams(),
+           /*breakpoints=*/{0, 1, 3, 5},
+           /*expected_outputs=*/
+           {CreateTensor<int64>(TensorShape{2, 1}, {0, 1}),
+            CreateTensor<int64>(TensorShape{2, 4}, {3, 4, 5, 6, 7, 8, 9, 10}),
+            CreateTensor<int64>(TensorShape{1, 1}, {2}),
+            CreateTensor<int64>(TensorShape{1, 4}, {11, 12, 13, 14})}}};
+}
+
+ITERATOR_SAVE_AND_RESTORE_TEST_P(BucketBySequenceLengthDatasetOpTest,
+                                 BucketBySequenceLengthDatasetParams,
+                                 IteratorSaveAndRestoreTestCases())
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, ElementTooLongForBucketBoundary) {
+  auto dataset_params = TooLongForBucketBoundaryParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  // The first batch only holds elements of length 1.
+  TF_ASSERT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                  &end_of_sequence));
+  EXPECT_EQ(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                               &end_of_sequence)
+                .code(),
+            tensorflow::error::INVALID_ARGUMENT);
+}
+
+class ParameterizedInvalidArgumentTest
+    : public BucketBySequenceLengthDatasetOpTest,
+      public ::testing::WithParamInterface<
+          BucketBySequenceLengthDatasetParams> {};
+
+TEST_P(ParameterizedInvalidArgumentTest, InvalidArguments) {
+  auto dataset_params = GetParam();
+  EXPECT_EQ(Initialize(dataset_params).code(),
+            tensorflow::error::INVALID_ARGUMENT);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BucketBySequenceLengthDatasetOpTest, ParameterizedInvalidArgumentTest,
+    ::testing::ValuesIn(std::vector<BucketBySequenceLengthDatasetParams>(
+        {InvalidLengthComponentParams(), InvalidBucketBatchSizesParams(),
+         DecreasingBucketBoundariesParams()})));
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
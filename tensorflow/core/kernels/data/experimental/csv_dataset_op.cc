@@ -12,6 +12,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <cstring>
+
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op.h"
@@ -26,6 +28,47 @@ namespace data {
 namespace experimental {
 namespace {
 
+// Returns a word with every byte set to `ch`.
+inline uint64 Broadcast(char ch) {
+  return static_cast<uint64>(static_cast<uint8>(ch)) * 0x0101010101010101ULL;
+}
+
+// Returns a word whose high bits are set for (at least) the bytes of `word`
+// that are zero, and which is zero if and only if no byte of `word` is zero.
+inline uint64 ZeroBytes(uint64 word) {
+  return (word - 0x0101010101010101ULL) & ~word & 0x8080808080808080ULL;
+}
+
+// Returns the first character in [begin, end) that can terminate an unquoted
+// field -- `delim`, '\n', '\r' or, if `quote` is set, '"' -- or `end` if there
+// is none. Fields are typically much longer than a byte, so the range is
+// scanned a word at a time and only a word that contains a match is
+// inspected byte by byte.
+const char* FindFieldEnd(const char* begin, const char* end, char delim,
+                         bool quote) {
+  const uint64 delims = Broadcast(delim);
+  const uint64 newlines = Broadcast('\n');
+  const uint64 carriage_returns = Broadcast('\r');
+  const uint64 quotes = quote ? Broadcast('"') : delims;
+  const char* p = begin;
+  for (; end - p >= static_cast<ptrdiff_t>(sizeof(uint64));
+       p += sizeof(uint64)) {
+    uint64 word;
+    std::memcpy(&word, p, sizeof(word));
+    if (ZeroBytes(word ^ delims) | ZeroBytes(word ^ newlines) |
+        ZeroBytes(word ^ carriage_returns) | ZeroBytes(word ^ quotes)) {
+      break;
+    }
+  }
+  for (; p < end; ++p) {
+    const char ch = *p;
+    if (ch == delim || ch == '\n' || ch == '\r' || (quote && ch == '"')) {
+      return p;
+    }
+  }
+  return end;
+}
+
 class CSVDatasetOp : public DatasetOpKernel {
  public:
   explicit CSVDatasetOp(OpKernelConstruction* ctx) : DatasetOpKernel(ctx) {
@@ -498,7 +541,11 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
 
           } else {
-            pos_++;
+            // Skip to the next quote, which is the only character that can
+            // end the field.
+            const char* quote = static_cast<const char*>(
+                std::memchr(buffer_.data() + pos_, '"', buffer_.size() - pos_));
+            pos_ = quote != nullptr ? quote - buffer_.data() : buffer_.size();
           }
         }
       }
@@ -617,8 +664,12 @@ class CSVDatasetOp : public DatasetOpKernel {
             parse_result.Update(errors::InvalidArgument(
                 "Unquoted fields cannot have quotes inside"));
           }
-          // Otherwise, go to next character
+          // Otherwise, skip to the next character that can end the field.
           pos_++;
+          pos_ = FindFieldEnd(buffer_.data() + pos_,
+                              buffer_.data() + buffer_.size(),
+                              dataset()->delim_, dataset()->use_quote_delim_) -
+                 buffer_.data();
         }
       }
 
@@ -0,0 +1,388 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/kernels/data/serialization_utils.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kDatasetNodeName[] = "data_service/dataset";
+constexpr char kIteratorNodeName[] = "data_service/iterator";
+constexpr char kMakeIteratorNodeName[] = "data_service/make_iterator";
+constexpr char kGetNextNodeName[] = "data_service/get_next";
+
+Status AddConstNode(const string& name, int64 value, GraphDef* graph_def) {
+  Tensor tensor(DT_INT64, TensorShape({}));
+  tensor.scalar<int64>()() = value;
+  return NodeDefBuilder(name, "Const")
+      .Attr("dtype", DT_INT64)
+      .Attr("value", tensor)
+      .Finalize(graph_def->add_node());
+}
+
+// Turns the serialized input pipeline into a graph that a worker can run on
+// its own: the dataset, sharded to `index` of `num_workers` if there is more
+// than one worker, feeds an iterator whose next element is fetched from
+// `kGetNextNodeName`.
+Status MakeWorkerGraph(const GraphDef& dataset_graph,
+                       const DataTypeVector& output_types,
+                       const std::vector<PartialTensorShape>& output_shapes,
+                       int64 num_workers, int64 index, GraphDef* graph_def) {
+  *graph_def = dataset_graph;
+  string output;
+  auto* nodes = graph_def->mutable_node();
+  for (auto it = nodes->begin(); it != nodes->end(); ++it) {
+    if (it->op() == FunctionLibraryDefinition::kRetOp) {
+      output = it->input(0);
+      nodes->erase(it);
+      break;
+    }
+  }
+  if (output.empty()) {
+    return errors::Internal("Serialized dataset graph has no output node.");
+  }
+  if (num_workers > 1) {
+    const string num_workers_name = strings::StrCat(kDatasetNodeName, "/n");
+    const string index_name = strings::StrCat(kDatasetNodeName, "/index");
+    TF_RETURN_IF_ERROR(AddConstNode(num_workers_name, num_workers, graph_def));
+    TF_RETURN_IF_ERROR(AddConstNode(index_name, index, graph_def));
+    TF_RETURN_IF_ERROR(NodeDefBuilder(kDatasetNodeName, "AutoShardDataset")
+                           .Input(output, 0, DT_VARIANT)
+                           .Input(num_workers_name, 0, DT_INT64)
+                           .Input(index_name, 0, DT_INT64)
+                           .Attr("output_types", output_types)
+                           .Attr("output_shapes", output_shapes)
+                           .Finalize(graph_def->add_node()));
+    output = kDatasetNodeName;
+  }
+  TF_RETURN_IF_ERROR(NodeDefBuilder(kIteratorNodeName, "IteratorV2")
+                         .Attr("shared_name", "")
+                         .Attr("container", "")
+                         .Attr("output_types", output_types)
+                         .Attr("output_shapes", output_shapes)
+                         .Finalize(graph_def->add_node()));
+  TF_RETURN_IF_ERROR(NodeDefBuilder(kMakeIteratorNodeName, "MakeIterator")
+                         .Input(output, 0, DT_VARIANT)
+                         .Input(kIteratorNodeName, 0, DT_RESOURCE)
+                         .Finalize(graph_def->add_node()));
+  return NodeDefBuilder(kGetNextNodeName, "IteratorGetNext")
+      .Input(kIteratorNodeName, 0, DT_RESOURCE)
+      .Attr("output_types", output_types)
+      .Attr("output_shapes", output_shapes)
+      .Finalize(graph_def->add_node());
+}
+
+// Runs the input pipeline on remote workers and interleaves their elements.
+//
+// Every worker target (a `grpc://` address of a TensorFlow server) gets its
+// own session running a static shard of the input dataset, as chosen by
+// `AutoShardDataset`. Each worker is driven by a background thread that keeps
+// up to `buffer_size` elements in flight, so faster workers contribute more
+// elements and slow ones do not stall the consumer.
+class DataServiceDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit DataServiceDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    const Tensor* targets_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("targets", &targets_tensor));
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsVector(targets_tensor->shape()),
+        errors::InvalidArgument("`targets` must be a vector but got shape ",
+                                targets_tensor->shape().DebugString()));
+    std::vector<string> targets;
+    targets.reserve(targets_tensor->NumElements());
+    for (int64 i = 0; i < targets_tensor->NumElements(); ++i) {
+      targets.push_back(targets_tensor->flat<tstring>()(i));
+    }
+    OP_REQUIRES(ctx, !targets.empty(),
+                errors::InvalidArgument("`targets` must not be empty"));
+
+    int64 buffer_size;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64>(ctx, "buffer_size", &buffer_size));
+    OP_REQUIRES(ctx, buffer_size > 0,
+                errors::InvalidArgument("`buffer_size` must be > 0"));
+
+    SerializationContext::Params params;
+    params.external_state_policy =
+        SerializationContext::ExternalStatePolicy::kWarn;
+    GraphDef dataset_graph;
+    OP_REQUIRES_OK(ctx, AsGraphDef(ctx, input, SerializationContext(params),
+                                   &dataset_graph));
+
+    *output = new Dataset(ctx, input, std::move(targets), buffer_size,
+                          std::move(dataset_graph), output_types_,
+                          output_shapes_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const DatasetBase* input,
+            std::vector<string> targets, int64 buffer_size,
+            GraphDef dataset_graph, const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : DatasetBase(DatasetContext(ctx)),
+          input_(input),
+          targets_(std::move(targets)),
+          buffer_size_(buffer_size),
+          dataset_graph_(std::move(dataset_graph)),
+          output_types_(output_types),
+          output_shapes_(output_shapes) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return absl::make_unique<Iterator>(
+          Iterator::Params{this, strings::StrCat(prefix, "::DataService")});
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() const override {
+      return "DataServiceDatasetOp::Dataset";
+    }
+
+    int64 Cardinality() const override { return kUnknownCardinality; }
+
+    Status CheckExternalState() const override {
+      return input_->CheckExternalState();
+    }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* input_graph_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+
+      Tensor targets_tensor(DT_STRING,
+                            TensorShape({static_cast<int64>(targets_.size())}));
+      for (size_t i = 0; i < targets_.size(); ++i) {
+        targets_tensor.vec<tstring>()(i) = targets_[i];
+      }
+      Node* targets = nullptr;
+      TF_RETURN_IF_ERROR(b->AddTensor(targets_tensor, &targets));
+
+      Node* buffer_size = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(buffer_size_, &buffer_size));
+
+      return b->AddDataset(
+          this, {input_graph_node, targets, buffer_size}, output);
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      ~Iterator() override {
+        CancelThreads();
+        if (deregister_fn_) deregister_fn_();
+        for (auto& worker : workers_) {
+          if (worker->session) worker->session->Close().IgnoreError();
+        }
+        // The threads are joined when `workers_` is destroyed.
+        workers_.clear();
+      }
+
+      Status Initialize(IteratorContext* ctx) override {
+        TF_RETURN_IF_ERROR(RegisterCancellationCallback(
+            ctx->cancellation_manager(), [this]() { CancelThreads(); },
+            &deregister_fn_));
+        const int64 num_workers = dataset()->targets_.size();
+        for (int64 i = 0; i < num_workers; ++i) {
+          auto worker = absl::make_unique<Worker>();
+          GraphDef graph_def;
+          TF_RETURN_IF_ERROR(MakeWorkerGraph(
+              dataset()->dataset_graph_, dataset()->output_types_,
+              dataset()->output_shapes_, num_workers, i, &graph_def));
+          SessionOptions options;
+          options.target = dataset()->targets_[i];
+          // Every client iterator gets its own copy of the pipeline, even
+          // when several clients share a worker.
+          options.config.set_isolate_session_state(true);
+          Session* session = nullptr;
+          TF_RETURN_IF_ERROR(NewSession(options, &session));
+          worker->session.reset(session);
+          TF_RETURN_IF_ERROR(worker->session->Create(graph_def));
+          TF_RETURN_IF_ERROR(
+              worker->session->Run({}, {}, {kMakeIteratorNodeName}, nullptr));
+          workers_.push_back(std::move(worker));
+        }
+        return Status::OK();
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        EnsureThreadsStarted(ctx);
+        while (!cancelled_ && status_.ok() && buffer_.empty() &&
+               num_active_workers_ > 0) {
+          RecordStop(ctx);
+          cond_var_.wait(l);
+          RecordStart(ctx);
+        }
+        if (cancelled_) {
+          return errors::Cancelled("Operation was cancelled");
+        }
+        if (!status_.ok()) {
+          return status_;
+        }
+        if (buffer_.empty()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        *out_tensors = std::move(buffer_.front());
+        buffer_.pop_front();
+        *end_of_sequence = false;
+        cond_var_.notify_all();
+        return Status::OK();
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeKnownRatioNode(std::move(args),
+                                         /*ratio=*/1);
+      }
+
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        return errors::Unimplemented(
+            "DataServiceDataset does not support checkpointing.");
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        return errors::Unimplemented(
+            "DataServiceDataset does not support checkpointing.");
+      }
+
+     private:
+      struct Worker {
+        std::unique_ptr<Session> session;
+        std::unique_ptr<Thread> thread;
+      };
+
+      void CancelThreads() LOCKS_EXCLUDED(mu_) {
+        mutex_lock l(mu_);
+        cancelled_ = true;
+        cond_var_.notify_all();
+      }
+
+      void EnsureThreadsStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (threads_started_) return;
+        threads_started_ = true;
+        num_active_workers_ = workers_.size();
+        for (auto& worker : workers_) {
+          Session* session = worker->session.get();
+          worker->thread = ctx->StartThread(
+              "tf_data_service_worker",
+              [this, session]() { WorkerThread(session); });
+        }
+      }
+
+      // Fetches elements from one worker until it runs out of data, fails or
+      // the iterator is cancelled.
+      void WorkerThread(Session* session) {
+        const int num_components = dataset()->output_types_.size();
+        std::vector<string> fetches;
+        fetches.reserve(num_components);
+        for (int i = 0; i < num_components; ++i) {
+          fetches.push_back(strings::StrCat(kGetNextNodeName, ":", i));
+        }
+        while (true) {
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ && status_.ok() &&
+                   static_cast<int64>(buffer_.size()) >=
+                       dataset()->buffer_size_) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_ || !status_.ok()) break;
+          }
+          std::vector<Tensor> element;
+          Status s = session->Run({}, fetches, {}, &element);
+          mutex_lock l(mu_);
+          if (errors::IsOutOfRange(s)) break;
+          if (!s.ok()) {
+            if (status_.ok() && !cancelled_) status_ = s;
+            break;
+          }
+          buffer_.push_back(std::move(element));
+          cond_var_.notify_all();
+        }
+        mutex_lock l(mu_);
+        --num_active_workers_;
+        cond_var_.notify_all();
+      }
+
+      mutex mu_;
+      condition_variable cond_var_;
+      std::vector<std::unique_ptr<Worker>> workers_;
+      std::deque<std::vector<Tensor>> buffer_ GUARDED_BY(mu_);
+      Status status_ GUARDED_BY(mu_);
+      int64 num_active_workers_ GUARDED_BY(mu_) = 0;
+      bool threads_started_ GUARDED_BY(mu_) = false;
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      std::function<void()> deregister_fn_;
+    };
+
+    const DatasetBase* const input_;
+    const std::vector<string> targets_;
+    const int64 buffer_size_;
+    const GraphDef dataset_graph_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("DataServiceDataset").Device(DEVICE_CPU),
+                        DataServiceDatasetOp);
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,144 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/server_lib.h"
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/protobuf/cluster.pb.h"
+#include "tensorflow/core/protobuf/tensorflow_server.pb.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "data_service_dataset";
+constexpr char kDatasetType[] = "DataService";
+
+class DataServiceDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  DataServiceDatasetParams(T input_dataset_params, std::vector<tstring> targets,
+                           int64 buffer_size, DataTypeVector output_dtypes,
+                           std::vector<PartialTensorShape> output_shapes,
+                           string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        targets_(std::move(targets)),
+        buffer_size_(buffer_size) {
+    input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    return {CreateTensor<tstring>(
+                TensorShape({static_cast<int64>(targets_.size())}), targets_),
+            CreateTensor<int64>(TensorShape({}), {buffer_size_})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {"input_dataset", "targets", "buffer_size"};
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{"output_types", output_dtypes_},
+                    {"output_shapes", output_shapes_}};
+    return Status::OK();
+  }
+
+  string dataset_type() const override { return kDatasetType; }
+
+ private:
+  std::vector<tstring> targets_;
+  int64 buffer_size_;
+};
+
+class DataServiceDatasetOpTest : public DatasetOpsTestBase {
+ protected:
+  // Starts `num_workers` in-process servers and returns their targets.
+  std::vector<tstring> StartWorkers(int num_workers) {
+    std::vector<tstring> targets;
+    for (int i = 0; i < num_workers; ++i) {
+      ServerDef server_def;
+      server_def.set_protocol("grpc");
+      server_def.set_job_name("worker");
+      server_def.set_task_index(0);
+      JobDef* job_def = server_def.mutable_cluster()->add_job();
+      job_def->set_name("worker");
+      (*job_def->mutable_tasks())[0] =
+          strings::StrCat("localhost:", testing::PickUnusedPortOrDie());
+      std::unique_ptr<ServerInterface> server;
+      TF_CHECK_OK(NewServer(server_def, &server));
+      TF_CHECK_OK(server->Start());
+      targets.push_back(server->target());
+      servers_.push_back(std::move(server));
+    }
+    return targets;
+  }
+
+  std::vector<std::unique_ptr<ServerInterface>> servers_;
+};
+
+DataServiceDatasetParams RangeOnWorkers(const std::vector<tstring>& targets,
+                                        int64 buffer_size) {
+  return DataServiceDatasetParams(RangeDatasetParams(0, 10, 1), targets,
+                                  buffer_size,
+                                  /*output_dtypes=*/{DT_INT64},
+                                  /*output_shapes=*/{PartialTensorShape({})},
+                                  /*node_name=*/kNodeName);
+}
+
+TEST_F(DataServiceDatasetOpTest, OneWorker) {
+  auto dataset_params = RangeOnWorkers(StartWorkers(1), /*buffer_size=*/2);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<int64>(TensorShape({}),
+                           {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(DataServiceDatasetOpTest, ShardedAcrossWorkers) {
+  // Each worker produces its own shard; together they produce every element
+  // once, in the order in which the workers deliver them.
+  auto dataset_params = RangeOnWorkers(StartWorkers(3), /*buffer_size=*/4);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<int64>(TensorShape({}),
+                           {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}}),
+      /*compare_order=*/false));
+}
+
+TEST_F(DataServiceDatasetOpTest, DatasetNodeNameAndType) {
+  auto dataset_params = RangeOnWorkers(StartWorkers(1), /*buffer_size=*/1);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetNodeName(dataset_params.node_name()));
+  TF_ASSERT_OK(CheckDatasetTypeString(name_utils::OpName(kDatasetType)));
+  TF_ASSERT_OK(CheckDatasetCardinality(kUnknownCardinality));
+}
+
+TEST_F(DataServiceDatasetOpTest, InvalidArguments) {
+  const std::vector<tstring> targets = StartWorkers(1);
+  std::vector<DataServiceDatasetParams> invalid_dataset_params = {
+      RangeOnWorkers(/*targets=*/{}, /*buffer_size=*/1),
+      RangeOnWorkers(targets, /*buffer_size=*/0),
+      RangeOnWorkers(targets, /*buffer_size=*/-1)};
+  for (const auto& dataset_params : invalid_dataset_params) {
+    EXPECT_EQ(Initialize(dataset_params).code(),
+              tensorflow::error::INVALID_ARGUMENT);
+  }
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 #include <atomic>
 #include <utility>
 
+#include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/input_colocation_exemption_registry.h"
 #include "tensorflow/core/common_runtime/metrics.h"
@@ -319,6 +320,49 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
       int64 num_calls;  // access guarded by owner's mutex
     };
 
+    // Hands out the slices of a batch that the results of the map function
+    // would be copied to, so that the function computes them in place.
+    class BatchSliceProvider : public RetvalBufferProvider {
+     public:
+      BatchSliceProvider(std::shared_ptr<BatchResult> result, int64 offset)
+          : result_(std::move(result)), offset_(offset) {}
+
+      TensorBuffer* AllocateRetval(int index, DataType type,
+                                   const TensorShape& shape) override {
+        {
+          // Once allocated, the batch is not reallocated.
+          tf_shared_lock l(result_->mu);
+          if (!result_->output_allocated) {
+            return nullptr;
+          }
+        }
+        if (index >= static_cast<int>(result_->output.size())) {
+          return nullptr;
+        }
+        Tensor* batch = &result_->output[index];
+        if (batch->dtype() != type || !DataTypeCanUseMemcpy(type) ||
+            batch->dims() != shape.dims() + 1) {
+          return nullptr;
+        }
+        for (int i = 0; i < shape.dims(); ++i) {
+          if (batch->dim_size(i + 1) != shape.dim_size(i)) {
+            return nullptr;
+          }
+        }
+        Tensor slice = batch->SubSlice(offset_);
+        if (!slice.IsAligned()) {
+          return nullptr;
+        }
+        TensorBuffer* buf = DMAHelper::buffer(&slice);
+        buf->Ref();
+        return buf;
+      }
+
+     private:
+      const std::shared_ptr<BatchResult> result_;
+      const int64 offset_;
+    };
+
     void CallCompleted(const std::shared_ptr<IteratorContext>& ctx,
                        const std::shared_ptr<BatchResult>& result)
         LOCKS_EXCLUDED(*mu_) {
@@ -358,7 +402,10 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
 
       std::shared_ptr<std::vector<Tensor>> return_values =
           std::make_shared<std::vector<Tensor>>();
-      auto done = [this, ctx, result, return_values, offset](Status status) {
+      auto slice_provider =
+          std::make_shared<BatchSliceProvider>(result, offset);
+      auto done = [this, ctx, result, return_values, offset,
+                   slice_provider](Status status) {
         if (dataset()->preserve_cardinality_ && errors::IsOutOfRange(status)) {
           // To guarantee that the transformation preserves the cardinality of
           // the dataset, we convert `OutOfRange` to `InvalidArgument` as the
@@ -390,6 +437,10 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
                     offset);
                 break;
               }
+              if (IsBatchSlice(tensor, *batch, offset)) {
+                // The function computed `tensor` in place.
+                continue;
+              }
               // TODO(mrry): Add a version of DoParallelConcat that allows us
               // to move `tensor` where possible, to speed up string tensor
               // batching.
@@ -411,9 +462,9 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
 
       // Apply the map function on `input_element`, storing the result in
       // `return_values`, and invoking `done` when finished.
-      instantiated_captured_func_->RunAsync(ctx.get(), std::move(input_element),
-                                            return_values.get(),
-                                            std::move(done), prefix());
+      instantiated_captured_func_->RunAsync(
+          ctx.get(), std::move(input_element), return_values.get(),
+          std::move(done), prefix(), slice_provider.get());
     }
 
     void CancelThreads(bool wait) LOCKS_EXCLUDED(mu_) {
@@ -426,6 +477,17 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
       }
     }
 
+    // Returns true if `tensor` is backed by the slice of `batch` at `offset`.
+    static bool IsBatchSlice(const Tensor& tensor, const Tensor& batch,
+                             int64 offset) {
+      if (tensor.NumElements() == 0 || !DataTypeCanUseMemcpy(tensor.dtype())) {
+        return false;
+      }
+      const char* slice_data =
+          batch.tensor_data().data() + offset * tensor.TotalBytes();
+      return tensor.tensor_data().data() == slice_data;
+    }
+
     Status CopyPartialBatch(Tensor* output, const Tensor& value,
                             int64 num_elements) {
       switch (value.dtype()) {
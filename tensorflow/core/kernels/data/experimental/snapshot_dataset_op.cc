@@ -23,22 +23,14 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.pb.h"  // NOLINT
 #include "tensorflow/core/grappler/graph_view.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/kernels/data/experimental/snapshot_util.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
-#include "tensorflow/core/lib/core/raw_coding.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/path.h"
-#include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/platform/file_system.h"
-#if !defined(IS_SLIM_BUILD)
-#include "tensorflow/core/lib/io/snappy/snappy_inputbuffer.h"
-#include "tensorflow/core/lib/io/snappy/snappy_outputbuffer.h"
-#include "tensorflow/core/lib/io/zlib_compression_options.h"
-#include "tensorflow/core/lib/io/zlib_inputstream.h"
-#include "tensorflow/core/lib/io/zlib_outputbuffer.h"
-#endif  // IS_SLIM_BUILD
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/base64.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
@@ -49,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/data/experimental/snapshot.pb.h"
 #include "tensorflow/core/util/batch_util.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -60,17 +53,6 @@ enum SnapshotMode { READER = 0, WRITER = 1, PASSTHROUGH = 2 };
 // Defaults to 10 GiB per shard.
 const int64 kDefaultShardSizeBytes = 10LL * 1024 * 1024 * 1024;
 
-const int64 kSnappyWriterInputBufferSizeBytes = 16 << 20;   // 16 MiB
-const int64 kSnappyWriterOutputBufferSizeBytes = 16 << 20;  // 16 MiB
-
-// The reader input buffer size is deliberately large because the input reader
-// will throw an error if the compressed block length cannot fit in the input
-// buffer.
-const int64 kSnappyReaderInputBufferSizeBytes = 1 << 30;    // 1 GiB
-const int64 kSnappyReaderOutputBufferSizeBytes = 16 << 20;  // 16 MiB
-
-const size_t kHeaderSize = sizeof(uint64);
-
 constexpr char kModeAuto[] = "auto";
 constexpr char kModeWrite[] = "write";
 constexpr char kModeRead[] = "read";
@@ -105,156 +87,18 @@ constexpr char kBuffer[] = "buffer";
 constexpr char kNumElementsWritten[] = "num_elements_written";
 constexpr char kNextElem[] = "next_elem";
 
-class SnapshotWriter {
- public:
-  static constexpr const char* const kClassName = "SnapshotWriter";
-  static constexpr const char* const kWriteStringPiece = "WriteStringPiece";
-  static constexpr const char* const kWriteCord = "WriteCord";
-
-  explicit SnapshotWriter(WritableFile* dest, const string& compression_type =
-                                                  io::compression::kNone)
-      : dest_(dest), compression_type_(compression_type) {
-#if defined(IS_SLIM_BUILD)
-    if (compression_type != io::compression::kNone) {
-      LOG(ERROR) << "Compression is unsupported on mobile platforms. Turning "
-                 << "off compression.";
-    }
-#else   // IS_SLIM_BUILD
-    if (compression_type == io::compression::kGzip) {
-      io::ZlibCompressionOptions zlib_options;
-      zlib_options = io::ZlibCompressionOptions::GZIP();
-
-      io::ZlibOutputBuffer* zlib_output_buffer = new io::ZlibOutputBuffer(
-          dest, zlib_options.input_buffer_size, zlib_options.output_buffer_size,
-          zlib_options);
-      TF_CHECK_OK(zlib_output_buffer->Init());
-      dest_ = zlib_output_buffer;
-      dest_is_owned_ = true;
-    } else if (compression_type == io::compression::kSnappy) {
-      io::SnappyOutputBuffer* snappy_output_buffer = new io::SnappyOutputBuffer(
-          dest, /*input_buffer_bytes=*/kSnappyWriterInputBufferSizeBytes,
-          /*output_buffer_bytes=*/kSnappyWriterOutputBufferSizeBytes);
-      dest_ = snappy_output_buffer;
-      dest_is_owned_ = true;
-    }
-#endif  // IS_SLIM_BUILD
-  }
-
-  Status WriteRecord(const StringPiece& data) {
-    profiler::TraceMe activity(
-        absl::StrCat(kClassName, kSeparator, kWriteStringPiece),
-        profiler::TraceMeLevel::kInfo);
-    char header[kHeaderSize];
-    core::EncodeFixed64(header, data.size());
-    TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
-    return dest_->Append(data);
-  }
-
-#if defined(PLATFORM_GOOGLE)
-  Status WriteRecord(const absl::Cord& data) {
-    profiler::TraceMe activity(absl::StrCat(kClassName, kSeparator, kWriteCord),
-                               profiler::TraceMeLevel::kInfo);
-    char header[kHeaderSize];
-    core::EncodeFixed64(header, data.size());
-
-    TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
-
-    return dest_->Append(data);
-  }
-#endif  // PLATFORM_GOOGLE
-
-  Status Close() {
-    if (dest_is_owned_) {
-      Status s = dest_->Close();
-      delete dest_;
-      dest_ = nullptr;
-      return s;
-    }
-    return Status::OK();
-  }
-
-  ~SnapshotWriter() {
-    if (dest_ != nullptr) {
-      Status s = Close();
-      if (!s.ok()) {
-        LOG(ERROR) << "Could not finish writing file: " << s;
-      }
-    }
-  }
-
- private:
-  WritableFile* dest_;
-  bool dest_is_owned_ = false;
-  const string compression_type_;
-};
-
-class SnapshotReader {
- public:
-  static constexpr const char* const kClassName = "SnapshotReader";
-  static constexpr const char* const kReadString = "ReadString";
-  static constexpr const char* const kReadCord = "ReadCord";
-
-  explicit SnapshotReader(
-      RandomAccessFile* file,
-      const string& compression_type = io::compression::kNone)
-      : file_(file),
-        input_stream_(new io::RandomAccessInputStream(file)),
-        compression_type_(compression_type) {
-#if defined(IS_SLIM_BUILD)
-    if (compression_type_ != io::compression::kNone) {
-      LOG(ERROR) << "Compression is unsupported on mobile platforms. Turning "
-                 << "off compression.";
-    }
-#else   // IS_SLIM_BUILD
-    if (compression_type_ == io::compression::kGzip) {
-      io::ZlibCompressionOptions zlib_options;
-      zlib_options = io::ZlibCompressionOptions::GZIP();
-
-      input_stream_.reset(new io::ZlibInputStream(
-          input_stream_.release(), zlib_options.input_buffer_size,
-          zlib_options.output_buffer_size, zlib_options, true));
-    } else if (compression_type_ == io::compression::kSnappy) {
-      input_stream_ = absl::make_unique<io::SnappyInputBuffer>(
-          file_, /*input_buffer_bytes=*/kSnappyReaderInputBufferSizeBytes,
-          /*output_buffer_bytes=*/kSnappyReaderOutputBufferSizeBytes);
-    }
-#endif  // IS_SLIM_BUILD
-  }
-
-  Status ReadRecord(tstring* record) {
-    profiler::TraceMe activity(
-        absl::StrCat(kClassName, kSeparator, kReadString),
-        profiler::TraceMeLevel::kInfo);
-    tstring header;
-    TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(kHeaderSize, &header));
-    uint64 length = core::DecodeFixed64(header.data());
-    return input_stream_->ReadNBytes(length, record);
+// Returns whether new uncompressed snapshots should be written in the raw
+// tensor layout, which lets readers alias tensors onto mapped file pages.
+bool RawTensorLayoutEnabled() {
+  bool raw = false;
+  Status s = ReadBoolFromEnvVar("TF_SNAPSHOT_RAW_TENSOR_LAYOUT",
+                                /*default_val=*/false, &raw);
+  if (!s.ok()) {
+    LOG(WARNING) << s;
+    return false;
   }
-
-#if defined(PLATFORM_GOOGLE)
-  Status ReadRecord(absl::Cord* record) {
-    profiler::TraceMe activity(absl::StrCat(kClassName, kSeparator, kReadCord),
-                               profiler::TraceMeLevel::kInfo);
-    tstring header;
-    TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(kHeaderSize, &header));
-    uint64 length = core::DecodeFixed64(header.data());
-
-    if (compression_type_ == io::compression::kNone) {
-      return input_stream_->ReadNBytes(length, record);
-    } else {
-      tstring tmp_str;
-      Status s = input_stream_->ReadNBytes(length, &tmp_str);
-      record->Append(tmp_str);
-      return s;
-    }
-  }
-#endif
-
- private:
-  RandomAccessFile* file_;
-  std::unique_ptr<io::InputStreamInterface> input_stream_;
-  const string compression_type_;
-};
+  return raw;
+}
 
 Status WriteMetadataFile(const string& hash_dir,
                          const experimental::SnapshotMetadataRecord& metadata) {
@@ -709,7 +553,7 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             iterator_ = absl::make_unique<SnapshotReaderIterator>(
                 SnapshotReaderIterator::Params{
                     dataset(), absl::StrCat(prefix(), "ReaderImpl")},
-                hash_dir_, run_id);
+                hash_dir_, run_id, metadata);
             break;
           case PASSTHROUGH:
             iterator_ = absl::make_unique<SnapshotPassthroughIterator>(
@@ -725,11 +569,13 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
        public:
         static constexpr const char* const kParse = "Parse";
 
-        explicit SnapshotReaderIterator(const Params& params,
-                                        const string& hash_dir,
-                                        const string& run_id)
+        explicit SnapshotReaderIterator(
+            const Params& params, const string& hash_dir,
+            const string& run_id,
+            const experimental::SnapshotMetadataRecord& metadata)
             : DatasetIterator<Dataset>(params),
               hash_dir_(hash_dir),
+              metadata_(metadata),
               run_id_(run_id) {}
 
         ~SnapshotReaderIterator() override {
@@ -956,6 +802,19 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
           TF_CHECK_OK(Env::Default()->NewRandomAccessFile(filename, &file));
           std::unique_ptr<SnapshotReader> reader(
               new SnapshotReader(file.get(), dataset()->compression_));
+          std::unique_ptr<MappedSnapshotReader> mapped_reader;
+          if (metadata_.raw_tensor_layout()) {
+            std::unique_ptr<ReadOnlyMemoryRegion> region;
+            Status s = Env::Default()->NewReadOnlyMemoryRegionFromFile(
+                filename, &region);
+            if (s.ok()) {
+              mapped_reader = absl::make_unique<MappedSnapshotReader>(
+                  std::shared_ptr<ReadOnlyMemoryRegion>(std::move(region)));
+            } else {
+              VLOG(2) << "Reading " << filename
+                      << " without mapping it: " << s;
+            }
+          }
 
           while (true) {
             // Wait for a slot in the buffer.
@@ -972,31 +831,41 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
                     "ReadFile");
               }
             }
+            std::vector<Tensor> out_tensors;
+            Status s;
+            if (mapped_reader != nullptr) {
+              s = mapped_reader->ReadRawRecord(&out_tensors);
+            } else if (metadata_.raw_tensor_layout()) {
+              s = reader->ReadRawRecord(&out_tensors);
+            } else {
 #if !defined(PLATFORM_GOOGLE)
-            tstring record_bytes;
-            Status s = reader->ReadRecord(&record_bytes);
+              tstring record_bytes;
+              s = reader->ReadRecord(&record_bytes);
 #else
-            absl::Cord record_cord;
-            Status s = reader->ReadRecord(&record_cord);
+              absl::Cord record_cord;
+              s = reader->ReadRecord(&record_cord);
 #endif
-            if (s.ok()) {
-              profiler::TraceMe activity(
-                  absl::StrCat(prefix(), kSeparator, kParse),
-                  profiler::TraceMeLevel::kInfo);
-              experimental::SnapshotRecord record;
+              if (s.ok()) {
+                profiler::TraceMe activity(
+                    absl::StrCat(prefix(), kSeparator, kParse),
+                    profiler::TraceMeLevel::kInfo);
+                experimental::SnapshotRecord record;
 #if !defined(PLATFORM_GOOGLE)
-              record.ParseFromString(record_bytes);
+                record.ParseFromString(record_bytes);
 #else
-              record.ParseFromCord(record_cord);
+                record.ParseFromCord(record_cord);
 #endif
-              std::vector<Tensor> out_tensors;
-              for (int i = 0; i < record.tensor_size(); ++i) {
-                Tensor t;
-                if (!t.FromProto(record.tensor(i))) {
-                  return errors::DataLoss("Unable to parse tensor from proto.");
+                for (int i = 0; i < record.tensor_size(); ++i) {
+                  Tensor t;
+                  if (!t.FromProto(std::move(*record.mutable_tensor(i)))) {
+                    return errors::DataLoss(
+                        "Unable to parse tensor from proto.");
+                  }
+                  out_tensors.push_back(t);
                 }
-                out_tensors.push_back(t);
               }
+            }
+            if (s.ok()) {
               BufferElement elem;
               std::swap(elem.value, out_tensors);
               elem.status = Status::OK();
@@ -1146,7 +1015,16 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
                                         const string& run_id)
             : DatasetIterator<Dataset>(params),
               hash_dir_(hash_dir),
-              run_id_(run_id) {}
+              run_id_(run_id) {
+          if (RawTensorLayoutEnabled()) {
+            if (dataset()->compression_ == io::compression::kNone) {
+              raw_tensor_layout_ = true;
+            } else {
+              LOG(WARNING) << "TF_SNAPSHOT_RAW_TENSOR_LAYOUT is ignored for "
+                              "compressed snapshots.";
+            }
+          }
+        }
 
         ~SnapshotWriterIterator() override {
           mutex_lock l(mu_);
@@ -1191,6 +1069,7 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
                 metadata.set_creation_timestamp(EnvTime::NowMicros());
                 metadata.set_graph_hash(dataset()->graph_hash_);
                 metadata.set_run_id(run_id_.data(), run_id_.size());
+                metadata.set_raw_tensor_layout(raw_tensor_layout_);
                 metadata.set_finalized(false);
                 TF_RETURN_IF_ERROR(WriteMetadataFile(hash_dir_, metadata));
               }
@@ -1335,6 +1214,12 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             return Status::OK();
           }
           is_restored_ = true;
+          {
+            // Keep writing in the layout that the snapshot was started with.
+            experimental::SnapshotMetadataRecord metadata;
+            TF_RETURN_IF_ERROR(ReadMetadataFile(hash_dir_, &metadata));
+            raw_tensor_layout_ = metadata.raw_tensor_layout();
+          }
           if (reader->Contains(full_name(kEndOfSequence))) {
             end_of_sequence_ = true;
           } else {
@@ -1516,8 +1401,10 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             experimental::SnapshotRecord record;
             for (auto out_tensor : elem.value) {
               *bytes_written += out_tensor.TotalBytes();
-              TensorProto* t = record.add_tensor();
-              out_tensor.AsProtoTensorContent(t);
+              if (!raw_tensor_layout_) {
+                TensorProto* t = record.add_tensor();
+                out_tensor.AsProtoTensorContent(t);
+              }
             }
 
             if (*bytes_written > dataset()->shard_size_bytes_) {
@@ -1532,6 +1419,9 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
                   file->get(), dataset()->compression_);
               *bytes_written = 0;
             }
+            if (raw_tensor_layout_) {
+              return (*writer)->WriteRawRecord(elem.value);
+            }
 #if defined(PLATFORM_GOOGLE)
             TF_RETURN_IF_ERROR(
                 (*writer)->WriteRecord(record.SerializeAsCord()));
@@ -1635,6 +1525,9 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         bool first_call_ GUARDED_BY(mu_) = true;
         bool end_of_sequence_ GUARDED_BY(mu_) = false;
         bool written_final_metadata_file_ GUARDED_BY(mu_) = false;
+        // Whether records are written in the raw tensor layout. Only changed
+        // before the writer threads are started.
+        bool raw_tensor_layout_ = false;
         uint64 next_file_index_ GUARDED_BY(mu_) = 0;
         std::unique_ptr<thread::ThreadPool> thread_pool_;
         int64 num_active_threads_ GUARDED_BY(mu_) = 0;
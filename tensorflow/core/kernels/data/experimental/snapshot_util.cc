@@ -0,0 +1,360 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/snapshot_util.h"
+
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor.pb.h"  // NOLINT
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
+#include "tensorflow/core/lib/io/random_inputstream.h"
+#if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/snappy/snappy_inputbuffer.h"
+#include "tensorflow/core/lib/io/snappy/snappy_outputbuffer.h"
+#include "tensorflow/core/lib/io/zlib_compression_options.h"
+#include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/lib/io/zlib_outputbuffer.h"
+#endif  // IS_SLIM_BUILD
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/protobuf/data/experimental/snapshot.pb.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+const int64 kSnappyWriterInputBufferSizeBytes = 16 << 20;   // 16 MiB
+const int64 kSnappyWriterOutputBufferSizeBytes = 16 << 20;  // 16 MiB
+
+// The reader input buffer size is deliberately large because the input reader
+// will throw an error if the compressed block length cannot fit in the input
+// buffer.
+const int64 kSnappyReaderInputBufferSizeBytes = 1 << 30;    // 1 GiB
+const int64 kSnappyReaderOutputBufferSizeBytes = 16 << 20;  // 16 MiB
+
+const size_t kHeaderSize = sizeof(uint64);
+
+constexpr char kSeparator[] = "::";
+
+// In the raw tensor layout every tensor starts at an offset in the file that
+// is a multiple of this, so that the tensors of a mapped file are aligned.
+constexpr int64 kRawTensorAlignment = 64;
+
+// Returns the number of padding bytes between `offset` and the next offset
+// that is a multiple of kRawTensorAlignment.
+int64 RawTensorPadding(int64 offset) {
+  return (kRawTensorAlignment - offset % kRawTensorAlignment) %
+         kRawTensorAlignment;
+}
+
+// A buffer that aliases part of a read-only mapped snapshot file. The buffer
+// does not own its memory, so that kernels never forward it and write to it.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("mapped_snapshot_file");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
+// Converts the `data` of a tensor of a raw record to a tensor. If `region` is
+// set, `data` lies in it and the tensor aliases `data` when possible.
+Status RawTensorFromData(const experimental::TensorMetadata& metadata,
+                         StringPiece data,
+                         const std::shared_ptr<ReadOnlyMemoryRegion>& region,
+                         Tensor* tensor) {
+  if (!TensorShape::IsValid(metadata.tensor_shape())) {
+    return errors::DataLoss("Invalid tensor shape in snapshot record.");
+  }
+  const DataType dtype = metadata.dtype();
+  if (!DataTypeCanUseMemcpy(dtype)) {
+    TensorProto proto;
+    if (!proto.ParseFromArray(data.data(), data.size()) ||
+        !tensor->FromProto(std::move(proto))) {
+      return errors::DataLoss("Unable to parse tensor from proto.");
+    }
+    return Status::OK();
+  }
+  TensorShape shape(metadata.tensor_shape());
+  const size_t expected_size = shape.num_elements() * DataTypeSize(dtype);
+  if (data.size() != expected_size) {
+    return errors::DataLoss("Expected ", expected_size,
+                            " bytes for a tensor of shape ",
+                            shape.DebugString(), " and type ",
+                            DataTypeString(dtype), " but got ", data.size());
+  }
+  if (region != nullptr && !data.empty() &&
+      reinterpret_cast<uintptr_t>(data.data()) % EIGEN_MAX_ALIGN_BYTES == 0) {
+    TensorBuffer* buffer =
+        new MappedTensorBuffer(region, data.data(), data.size());
+    *tensor = Tensor(dtype, shape, buffer);
+    buffer->Unref();
+    return Status::OK();
+  }
+  *tensor = Tensor(dtype, shape);
+  std::copy(data.begin(), data.end(),
+            const_cast<char*>(tensor->tensor_data().data()));
+  return Status::OK();
+}
+
+}  // namespace
+
+SnapshotWriter::SnapshotWriter(WritableFile* dest,
+                               const string& compression_type)
+    : dest_(dest), compression_type_(compression_type) {
+#if defined(IS_SLIM_BUILD)
+  if (compression_type != io::compression::kNone) {
+    LOG(ERROR) << "Compression is unsupported on mobile platforms. Turning "
+               << "off compression.";
+  }
+#else   // IS_SLIM_BUILD
+  if (compression_type == io::compression::kGzip) {
+    io::ZlibCompressionOptions zlib_options;
+    zlib_options = io::ZlibCompressionOptions::GZIP();
+
+    io::ZlibOutputBuffer* zlib_output_buffer = new io::ZlibOutputBuffer(
+        dest, zlib_options.input_buffer_size, zlib_options.output_buffer_size,
+        zlib_options);
+    TF_CHECK_OK(zlib_output_buffer->Init());
+    dest_ = zlib_output_buffer;
+    dest_is_owned_ = true;
+  } else if (compression_type == io::compression::kSnappy) {
+    io::SnappyOutputBuffer* snappy_output_buffer = new io::SnappyOutputBuffer(
+        dest, /*input_buffer_bytes=*/kSnappyWriterInputBufferSizeBytes,
+        /*output_buffer_bytes=*/kSnappyWriterOutputBufferSizeBytes);
+    dest_ = snappy_output_buffer;
+    dest_is_owned_ = true;
+  }
+#endif  // IS_SLIM_BUILD
+}
+
+SnapshotWriter::~SnapshotWriter() {
+  if (dest_ != nullptr) {
+    Status s = Close();
+    if (!s.ok()) {
+      LOG(ERROR) << "Could not finish writing file: " << s;
+    }
+  }
+}
+
+Status SnapshotWriter::WriteRecord(const StringPiece& data) {
+  profiler::TraceMe activity(
+      absl::StrCat(kClassName, kSeparator, kWriteStringPiece),
+      profiler::TraceMeLevel::kInfo);
+  char header[kHeaderSize];
+  core::EncodeFixed64(header, data.size());
+  TF_RETURN_IF_ERROR(Append(StringPiece(header, sizeof(header))));
+  return Append(data);
+}
+
+#if defined(PLATFORM_GOOGLE)
+Status SnapshotWriter::WriteRecord(const absl::Cord& data) {
+  profiler::TraceMe activity(absl::StrCat(kClassName, kSeparator, kWriteCord),
+                             profiler::TraceMeLevel::kInfo);
+  char header[kHeaderSize];
+  core::EncodeFixed64(header, data.size());
+
+  TF_RETURN_IF_ERROR(Append(StringPiece(header, sizeof(header))));
+
+  offset_ += data.size();
+  return dest_->Append(data);
+}
+#endif  // PLATFORM_GOOGLE
+
+Status SnapshotWriter::WriteRawRecord(const std::vector<Tensor>& tensors) {
+  experimental::SnapshotTensorMetadata metadata;
+  std::vector<string> encoded(tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const Tensor& tensor = tensors[i];
+    experimental::TensorMetadata* tensor_metadata =
+        metadata.add_tensor_metadata();
+    tensor_metadata->set_dtype(tensor.dtype());
+    tensor.shape().AsProto(tensor_metadata->mutable_tensor_shape());
+    if (DataTypeCanUseMemcpy(tensor.dtype())) {
+      tensor_metadata->set_tensor_size_bytes(tensor.tensor_data().size());
+    } else {
+      TensorProto proto;
+      tensor.AsProtoTensorContent(&proto);
+      proto.SerializeToString(&encoded[i]);
+      tensor_metadata->set_tensor_size_bytes(encoded[i].size());
+    }
+  }
+  const string serialized_metadata = metadata.SerializeAsString();
+  TF_RETURN_IF_ERROR(WriteRecord(StringPiece(serialized_metadata)));
+  static const char kPadding[kRawTensorAlignment] = {};
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    TF_RETURN_IF_ERROR(
+        Append(StringPiece(kPadding, RawTensorPadding(offset_))));
+    TF_RETURN_IF_ERROR(Append(DataTypeCanUseMemcpy(tensors[i].dtype())
+                                  ? tensors[i].tensor_data()
+                                  : StringPiece(encoded[i])));
+  }
+  return Status::OK();
+}
+
+Status SnapshotWriter::Close() {
+  if (dest_is_owned_) {
+    Status s = dest_->Close();
+    delete dest_;
+    dest_ = nullptr;
+    return s;
+  }
+  return Status::OK();
+}
+
+Status SnapshotWriter::Append(StringPiece data) {
+  offset_ += data.size();
+  return dest_->Append(data);
+}
+
+SnapshotReader::SnapshotReader(RandomAccessFile* file,
+                               const string& compression_type)
+    : file_(file),
+      input_stream_(new io::RandomAccessInputStream(file)),
+      compression_type_(compression_type) {
+#if defined(IS_SLIM_BUILD)
+  if (compression_type_ != io::compression::kNone) {
+    LOG(ERROR) << "Compression is unsupported on mobile platforms. Turning "
+               << "off compression.";
+  }
+#else   // IS_SLIM_BUILD
+  if (compression_type_ == io::compression::kGzip) {
+    io::ZlibCompressionOptions zlib_options;
+    zlib_options = io::ZlibCompressionOptions::GZIP();
+
+    input_stream_.reset(new io::ZlibInputStream(
+        input_stream_.release(), zlib_options.input_buffer_size,
+        zlib_options.output_buffer_size, zlib_options, true));
+  } else if (compression_type_ == io::compression::kSnappy) {
+    input_stream_ = absl::make_unique<io::SnappyInputBuffer>(
+        file_, /*input_buffer_bytes=*/kSnappyReaderInputBufferSizeBytes,
+        /*output_buffer_bytes=*/kSnappyReaderOutputBufferSizeBytes);
+  }
+#endif  // IS_SLIM_BUILD
+}
+
+Status SnapshotReader::ReadRecord(tstring* record) {
+  profiler::TraceMe activity(absl::StrCat(kClassName, kSeparator, kReadString),
+                             profiler::TraceMeLevel::kInfo);
+  tstring header;
+  TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(kHeaderSize, &header));
+  uint64 length = core::DecodeFixed64(header.data());
+  return input_stream_->ReadNBytes(length, record);
+}
+
+#if defined(PLATFORM_GOOGLE)
+Status SnapshotReader::ReadRecord(absl::Cord* record) {
+  profiler::TraceMe activity(absl::StrCat(kClassName, kSeparator, kReadCord),
+                             profiler::TraceMeLevel::kInfo);
+  tstring header;
+  TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(kHeaderSize, &header));
+  uint64 length = core::DecodeFixed64(header.data());
+
+  if (compression_type_ == io::compression::kNone) {
+    return input_stream_->ReadNBytes(length, record);
+  } else {
+    tstring tmp_str;
+    Status s = input_stream_->ReadNBytes(length, &tmp_str);
+    record->Append(tmp_str);
+    return s;
+  }
+}
+#endif  // PLATFORM_GOOGLE
+
+Status SnapshotReader::ReadRawRecord(std::vector<Tensor>* tensors) {
+  tstring record;
+  TF_RETURN_IF_ERROR(ReadRecord(&record));
+  experimental::SnapshotTensorMetadata metadata;
+  if (!metadata.ParseFromArray(record.data(), record.size())) {
+    return errors::DataLoss("Unable to parse snapshot tensor metadata.");
+  }
+  tensors->clear();
+  tensors->reserve(metadata.tensor_metadata_size());
+  for (const auto& tensor_metadata : metadata.tensor_metadata()) {
+    TF_RETURN_IF_ERROR(
+        input_stream_->SkipNBytes(RawTensorPadding(input_stream_->Tell())));
+    tstring data;
+    TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(
+        tensor_metadata.tensor_size_bytes(), &data));
+    tensors->emplace_back();
+    TF_RETURN_IF_ERROR(RawTensorFromData(tensor_metadata, data,
+                                         /*region=*/nullptr, &tensors->back()));
+  }
+  return Status::OK();
+}
+
+MappedSnapshotReader::MappedSnapshotReader(
+    std::shared_ptr<ReadOnlyMemoryRegion> region)
+    : region_(std::move(region)) {}
+
+Status MappedSnapshotReader::ReadRawRecord(std::vector<Tensor>* tensors) {
+  const char* base = static_cast<const char*>(region_->data());
+  const uint64 length = region_->length();
+  if (offset_ == length) {
+    return errors::OutOfRange("End of snapshot file.");
+  }
+  if (length - offset_ < kHeaderSize) {
+    return errors::DataLoss("Truncated snapshot record header.");
+  }
+  const uint64 metadata_size = core::DecodeFixed64(base + offset_);
+  offset_ += kHeaderSize;
+  experimental::SnapshotTensorMetadata metadata;
+  if (length - offset_ < metadata_size ||
+      !metadata.ParseFromArray(base + offset_, metadata_size)) {
+    return errors::DataLoss("Unable to parse snapshot tensor metadata.");
+  }
+  offset_ += metadata_size;
+  tensors->clear();
+  tensors->reserve(metadata.tensor_metadata_size());
+  for (const auto& tensor_metadata : metadata.tensor_metadata()) {
+    offset_ += RawTensorPadding(offset_);
+    const int64 size = tensor_metadata.tensor_size_bytes();
+    if (size < 0 || offset_ > length ||
+        length - offset_ < static_cast<uint64>(size)) {
+      return errors::DataLoss("Truncated snapshot record.");
+    }
+    tensors->emplace_back();
+    TF_RETURN_IF_ERROR(RawTensorFromData(tensor_metadata,
+                                         StringPiece(base + offset_, size),
+                                         region_, &tensors->back()));
+    offset_ += size;
+  }
+  return Status::OK();
+}
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,115 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_SNAPSHOT_UTIL_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_SNAPSHOT_UTIL_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/io/compression.h"
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/cord.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Writes the records of a snapshot file. Each record is a length-prefixed
+// string, optionally compressed as a whole with the file.
+class SnapshotWriter {
+ public:
+  static constexpr const char* const kClassName = "SnapshotWriter";
+  static constexpr const char* const kWriteStringPiece = "WriteStringPiece";
+  static constexpr const char* const kWriteCord = "WriteCord";
+
+  explicit SnapshotWriter(WritableFile* dest, const string& compression_type =
+                                                  io::compression::kNone);
+  ~SnapshotWriter();
+
+  Status WriteRecord(const StringPiece& data);
+
+#if defined(PLATFORM_GOOGLE)
+  Status WriteRecord(const absl::Cord& data);
+#endif  // PLATFORM_GOOGLE
+
+  // Writes `tensors` as one record in the raw tensor layout. The tensor
+  // offsets are relative to the start of the writer, so the file must be
+  // uncompressed and empty when the writer is created.
+  Status WriteRawRecord(const std::vector<Tensor>& tensors);
+
+  Status Close();
+
+ private:
+  Status Append(StringPiece data);
+
+  WritableFile* dest_;
+  bool dest_is_owned_ = false;
+  const string compression_type_;
+  // Number of bytes written so far, before compression.
+  int64 offset_ = 0;
+};
+
+// Reads the records of a snapshot file written by SnapshotWriter.
+class SnapshotReader {
+ public:
+  static constexpr const char* const kClassName = "SnapshotReader";
+  static constexpr const char* const kReadString = "ReadString";
+  static constexpr const char* const kReadCord = "ReadCord";
+
+  explicit SnapshotReader(
+      RandomAccessFile* file,
+      const string& compression_type = io::compression::kNone);
+
+  Status ReadRecord(tstring* record);
+
+#if defined(PLATFORM_GOOGLE)
+  Status ReadRecord(absl::Cord* record);
+#endif  // PLATFORM_GOOGLE
+
+  // Reads a record written by SnapshotWriter::WriteRawRecord into newly
+  // allocated tensors. The file must be uncompressed.
+  Status ReadRawRecord(std::vector<Tensor>* tensors);
+
+ private:
+  RandomAccessFile* file_;
+  std::unique_ptr<io::InputStreamInterface> input_stream_;
+  const string compression_type_;
+};
+
+// Reads records written by SnapshotWriter::WriteRawRecord from a mapped file.
+// The tensors that it returns alias the mapped pages, which stay mapped until
+// the last of those tensors is destroyed.
+class MappedSnapshotReader {
+ public:
+  explicit MappedSnapshotReader(std::shared_ptr<ReadOnlyMemoryRegion> region);
+
+  // Returns OutOfRange at the end of the file.
+  Status ReadRawRecord(std::vector<Tensor>* tensors);
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  uint64 offset_ = 0;
+};
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_SNAPSHOT_UTIL_H_
@@ -0,0 +1,187 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/snapshot_util.h"
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+// Two records of tensors with sizes that are not multiples of the alignment,
+// with a type that cannot be memcpy-ed in between.
+std::vector<std::vector<Tensor>> TestRecords() {
+  return {
+      {test::AsTensor<float>({1, 2, 3, 4, 5, 6}, {2, 3}),
+       test::AsTensor<tstring>({"a", "bc", ""}, {3}),
+       test::AsScalar<int64>(7)},
+      {test::AsTensor<int32>({8, 9, 10}, {3}), test::AsScalar<tstring>("d"),
+       Tensor(DT_FLOAT, TensorShape({0}))},
+  };
+}
+
+void ExpectRecordsEqual(const std::vector<Tensor>& expected,
+                        const std::vector<Tensor>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i].DebugString(/*num_values=*/100),
+              actual[i].DebugString(/*num_values=*/100))
+        << "tensor " << i;
+  }
+}
+
+class SnapshotUtilTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    filename_ = io::JoinPath(testing::TmpDir(), "snapshot_util_test_file");
+  }
+
+  void TearDown() override {
+    Env::Default()->DeleteFile(filename_).IgnoreError();
+  }
+
+  void WriteRawRecords(const std::vector<std::vector<Tensor>>& records) {
+    std::unique_ptr<WritableFile> file;
+    TF_ASSERT_OK(Env::Default()->NewWritableFile(filename_, &file));
+    SnapshotWriter writer(file.get());
+    for (const std::vector<Tensor>& record : records) {
+      TF_ASSERT_OK(writer.WriteRawRecord(record));
+    }
+    TF_ASSERT_OK(writer.Close());
+    TF_ASSERT_OK(file->Close());
+  }
+
+  std::unique_ptr<MappedSnapshotReader> NewMappedReader(
+      std::shared_ptr<ReadOnlyMemoryRegion>* region) {
+    std::unique_ptr<ReadOnlyMemoryRegion> r;
+    TF_CHECK_OK(Env::Default()->NewReadOnlyMemoryRegionFromFile(filename_, &r));
+    *region = std::move(r);
+    return absl::make_unique<MappedSnapshotReader>(*region);
+  }
+
+  string filename_;
+};
+
+TEST_F(SnapshotUtilTest, RawRecordsThroughStream) {
+  const std::vector<std::vector<Tensor>> records = TestRecords();
+  WriteRawRecords(records);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(filename_, &file));
+  SnapshotReader reader(file.get());
+  std::vector<Tensor> tensors;
+  for (const std::vector<Tensor>& record : records) {
+    TF_ASSERT_OK(reader.ReadRawRecord(&tensors));
+    ExpectRecordsEqual(record, tensors);
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRawRecord(&tensors)));
+}
+
+TEST_F(SnapshotUtilTest, RawRecordsThroughMapping) {
+  const std::vector<std::vector<Tensor>> records = TestRecords();
+  WriteRawRecords(records);
+
+  std::shared_ptr<ReadOnlyMemoryRegion> region;
+  std::unique_ptr<MappedSnapshotReader> reader = NewMappedReader(&region);
+  std::vector<Tensor> tensors;
+  for (const std::vector<Tensor>& record : records) {
+    TF_ASSERT_OK(reader->ReadRawRecord(&tensors));
+    ExpectRecordsEqual(record, tensors);
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadRawRecord(&tensors)));
+}
+
+TEST_F(SnapshotUtilTest, MappedTensorsAliasTheFile) {
+  WriteRawRecords(TestRecords());
+
+  std::shared_ptr<ReadOnlyMemoryRegion> region;
+  std::unique_ptr<MappedSnapshotReader> reader = NewMappedReader(&region);
+  const char* begin = static_cast<const char*>(region->data());
+  const char* end = begin + region->length();
+  auto in_file = [begin, end](const Tensor& t) {
+    const char* data = t.tensor_data().data();
+    return data >= begin && data < end;
+  };
+
+  std::vector<Tensor> tensors;
+  TF_ASSERT_OK(reader->ReadRawRecord(&tensors));
+  ASSERT_EQ(tensors.size(), 3);
+  EXPECT_TRUE(in_file(tensors[0]));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(tensors[0].tensor_data().data()) %
+                EIGEN_MAX_ALIGN_BYTES,
+            0);
+  // Strings are parsed into tensors of their own.
+  EXPECT_FALSE(in_file(tensors[1]));
+  EXPECT_TRUE(in_file(tensors[2]));
+  TensorDescription description;
+  tensors[0].FillDescription(&description);
+  EXPECT_EQ(description.allocation_description().allocator_name(),
+            "mapped_snapshot_file");
+
+  // The mapping outlives the reader as long as the tensors are alive.
+  reader.reset();
+  region.reset();
+  test::ExpectTensorEqual<float>(
+      tensors[0], test::AsTensor<float>({1, 2, 3, 4, 5, 6}, {2, 3}));
+  test::ExpectTensorEqual<int64>(tensors[2], test::AsScalar<int64>(7));
+}
+
+TEST_F(SnapshotUtilTest, TruncatedMappedFile) {
+  WriteRawRecords({{test::AsTensor<float>({1, 2, 3, 4}, {4})}});
+  uint64 size;
+  TF_ASSERT_OK(Env::Default()->GetFileSize(filename_, &size));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename_, &contents));
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename_,
+                                 contents.substr(0, size - 1)));
+
+  std::shared_ptr<ReadOnlyMemoryRegion> region;
+  std::unique_ptr<MappedSnapshotReader> reader = NewMappedReader(&region);
+  std::vector<Tensor> tensors;
+  EXPECT_TRUE(errors::IsDataLoss(reader->ReadRawRecord(&tensors)));
+}
+
+TEST_F(SnapshotUtilTest, RecordsAreStillReadable) {
+  std::unique_ptr<WritableFile> file;
+  TF_ASSERT_OK(Env::Default()->NewWritableFile(filename_, &file));
+  {
+    SnapshotWriter writer(file.get());
+    TF_ASSERT_OK(writer.WriteRecord(StringPiece("first")));
+    TF_ASSERT_OK(writer.WriteRecord(StringPiece()));
+  }
+  TF_ASSERT_OK(file->Close());
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(filename_, &read_file));
+  SnapshotReader reader(read_file.get());
+  tstring record;
+  TF_ASSERT_OK(reader.ReadRecord(&record));
+  EXPECT_EQ(record, "first");
+  TF_ASSERT_OK(reader.ReadRecord(&record));
+  EXPECT_EQ(record, "");
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -20,6 +20,8 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -27,6 +29,33 @@ namespace data {
 namespace experimental {
 namespace {
 
+// Returns the options for the threads of the thread pools created by the ops
+// in this file. If TF_DATA_THREADPOOL_NUMA_NODE names a NUMA node, the threads
+// are pinned to it; buffers that they allocate and fill are then placed on
+// that node by the first-touch policy of the OS.
+ThreadOptions DataThreadOptions() {
+  ThreadOptions options;
+  int64 numa_node;
+  Status s = ReadInt64FromEnvVar("TF_DATA_THREADPOOL_NUMA_NODE",
+                                 port::kNUMANoAffinity, &numa_node);
+  if (!s.ok()) {
+    LOG(WARNING) << s.error_message();
+    return options;
+  }
+  if (numa_node == port::kNUMANoAffinity) {
+    return options;
+  }
+  if (!port::NUMAEnabled() || numa_node < 0 ||
+      numa_node >= port::NUMANumNodes()) {
+    LOG(WARNING) << "Ignoring TF_DATA_THREADPOOL_NUMA_NODE=" << numa_node
+                 << ": the host has " << port::NUMANumNodes()
+                 << " NUMA node(s)";
+    return options;
+  }
+  options.numa_node = static_cast<int>(numa_node);
+  return options;
+}
+
 class ThreadPoolResource : public ResourceBase {
  public:
   ThreadPoolResource(Env* env, const ThreadOptions& thread_options,
@@ -100,7 +129,8 @@ class ThreadPoolHandleOp : public OpKernel {
                               [this, ctx](ThreadPoolResource** ret)
                                   EXCLUSIVE_LOCKS_REQUIRED(mu_) {
                                     *ret = new ThreadPoolResource(
-                                        ctx->env(), {}, display_name_,
+                                        ctx->env(), DataThreadOptions(),
+                                        display_name_,
                                         num_threads_,
                                         /*low_latency_hint=*/false,
                                         max_intra_op_parallelism_);
@@ -361,7 +391,8 @@ class PrivateThreadPoolDatasetOp : public UnaryDatasetOpKernel {
           input_(input),
           num_threads_(num_threads) {
       thread_pool_ = absl::make_unique<thread::ThreadPool>(
-          ctx->env(), ThreadOptions{}, "data_private_threadpool", num_threads,
+          ctx->env(), DataThreadOptions(), "data_private_threadpool",
+          num_threads,
           /*low_latency_hint=*/false);
       input_->Ref();
     }
@@ -216,6 +216,11 @@ REGISTER_KERNEL_BUILDER(Name("GeneratorDataset")
                             .HostMemory("handle")
                             .Priority(1),
                         GeneratorDatasetOp);
+#ifdef TENSORFLOW_USE_VE
+REGISTER_KERNEL_BUILDER(
+    Name("GeneratorDataset").Device(DEVICE_VE).HostMemory("handle"),
+    GeneratorDatasetOp);
+#endif  // TENSORFLOW_USE_VE
 }  // namespace
 
 }  // namespace data
@@ -1129,6 +1129,38 @@ REGISTER_KERNEL_BUILDER(Name("IteratorFromStringHandleV2")
                             .HostMemory("string_handle")
                             .Priority(1),
                         IteratorFromStringHandleOp);
+
+#ifdef TENSORFLOW_USE_VE
+// Lets prefetch_to_device("/device:VE:N") keep its buffer of elements on VE.
+// No priority is set so that CPU and GPU kernels are still preferred.
+REGISTER_KERNEL_BUILDER(Name("IteratorV2").Device(DEVICE_VE),
+                        IteratorHandleOp);
+REGISTER_KERNEL_BUILDER(
+    Name("MakeIterator").Device(DEVICE_VE).HostMemory("dataset"),
+    MakeIteratorOp);
+REGISTER_KERNEL_BUILDER(
+    Name("DeleteIterator").Device(DEVICE_VE).HostMemory("deleter"),
+    DeleteIteratorOp);
+REGISTER_KERNEL_BUILDER(Name("AnonymousIterator").Device(DEVICE_VE),
+                        AnonymousIteratorHandleOp);
+REGISTER_KERNEL_BUILDER(
+    Name("AnonymousIteratorV2").Device(DEVICE_VE).HostMemory("deleter"),
+    AnonymousIteratorHandleOp);
+REGISTER_KERNEL_BUILDER(Name("IteratorGetNext").Device(DEVICE_VE),
+                        IteratorGetNextOp);
+REGISTER_KERNEL_BUILDER(Name("IteratorGetNextSync").Device(DEVICE_VE),
+                        IteratorGetNextOp);
+REGISTER_KERNEL_BUILDER(Name("IteratorGetNextAsOptional").Device(DEVICE_VE),
+                        IteratorGetNextAsOptionalOp);
+REGISTER_KERNEL_BUILDER(Name("IteratorToStringHandle")
+                            .Device(DEVICE_VE)
+                            .HostMemory("string_handle"),
+                        IteratorToStringHandleOp);
+REGISTER_KERNEL_BUILDER(Name("IteratorFromStringHandleV2")
+                            .Device(DEVICE_VE)
+                            .HostMemory("string_handle"),
+                        IteratorFromStringHandleOp);
+#endif  // TENSORFLOW_USE_VE
 REGISTER_KERNEL_BUILDER(Name("SerializeIterator").Device(DEVICE_CPU),
                         SerializeIteratorOp);
 REGISTER_KERNEL_BUILDER(Name("DeserializeIterator").Device(DEVICE_CPU),
@@ -196,6 +196,21 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
           }
           model_->Optimize(dataset()->algorithm_, dataset()->cpu_budget_,
                            dataset()->ram_budget_);
+          for (const auto& pair : model_->TunableParameterValues()) {
+            metrics::RecordTFDataAutotuneParameter(
+                pair.first.first, pair.first.second, pair.second);
+          }
+          const auto stats = model_->CollectNodeStats();
+          for (const auto& pair : stats) {
+            metrics::RecordTFDataNodeStats(
+                pair.first, static_cast<int64>(pair.second.processing_time),
+                pair.second.buffered_elements, pair.second.buffered_bytes);
+          }
+          const string slowest = model::SlowestNode(stats);
+          if (!slowest.empty()) {
+            VLOG(2) << "Slowest input pipeline node: " << slowest;
+            metrics::RecordTFDataBottleneck(slowest);
+          }
           // Exponentially increase the period of running the optimization
           // until a threshold is reached.
           if (optimization_period_ms != kOptimizationPeriodThresholdMs) {
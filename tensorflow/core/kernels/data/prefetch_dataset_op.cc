@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -517,6 +518,16 @@ PrefetchDatasetOp::PrefetchDatasetOp(OpKernelConstruction* ctx)
   if (ctx->HasAttr(kLegacyAutotune)) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr(kLegacyAutotune, &legacy_autotune_));
   }
+  // Lets the autotuning model choose the buffer size jointly with the
+  // parallelism of other transformations, within its RAM budget. This relies
+  // on autotuning being enabled for the input pipeline.
+  bool autotune_buffers = false;
+  OP_REQUIRES_OK(ctx, ReadBoolFromEnvVar("TF_DATA_AUTOTUNE_BUFFERS",
+                                         /*default_val=*/false,
+                                         &autotune_buffers));
+  if (autotune_buffers) {
+    legacy_autotune_ = false;
+  }
 }
 
 void PrefetchDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -547,6 +558,14 @@ REGISTER_KERNEL_BUILDER(Name("PrefetchDataset")
                             .HostMemory("handle")
                             .Priority(1),
                         PrefetchDatasetOp);
+#ifdef TENSORFLOW_USE_VE
+REGISTER_KERNEL_BUILDER(Name("PrefetchDataset")
+                            .Device(DEVICE_VE)
+                            .HostMemory("buffer_size")
+                            .HostMemory("input_dataset")
+                            .HostMemory("handle"),
+                        PrefetchDatasetOp);
+#endif  // TENSORFLOW_USE_VE
 }  // namespace
 
 }  // namespace data
@@ -0,0 +1,189 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/shuffle_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace data {
+
+ShuffleBuffer::ShuffleBuffer(int64 max_packed_element_bytes, int64 slab_bytes)
+    : max_packed_element_bytes_(max_packed_element_bytes),
+      slab_bytes_(std::max(slab_bytes, max_packed_element_bytes)) {}
+
+ShuffleBuffer::~ShuffleBuffer() = default;
+
+void ShuffleBuffer::Clear() {
+  entries_.clear();
+  slabs_.clear();
+  last_signature_.reset();
+  num_packed_ = 0;
+  live_bytes_ = 0;
+  used_bytes_ = 0;
+}
+
+void ShuffleBuffer::PushBack(std::vector<Tensor>&& element) {
+  entries_.emplace_back();
+  Entry& entry = entries_.back();
+  entry.signature = PackedSignature(element);
+  if (!entry.signature) {
+    entry.tensors = std::move(element);
+    return;
+  }
+  char* dst = AllocateInSlab(&entry);
+  for (const Tensor& t : element) {
+    StringPiece bytes = t.tensor_data();
+    std::memcpy(dst, bytes.data(), bytes.size());
+    dst += bytes.size();
+  }
+  num_packed_++;
+}
+
+void ShuffleBuffer::Take(int64 index, std::vector<Tensor>* element) {
+  DCHECK_GE(index, 0);
+  DCHECK_LT(index, size());
+  Entry& entry = entries_[index];
+  if (entry.slab != nullptr) {
+    *element = Unpack(entry);
+    Unref(entry);
+    num_packed_--;
+  } else {
+    *element = std::move(entry.tensors);
+  }
+  if (index != 0) {
+    entry = std::move(entries_.front());
+  }
+  entries_.pop_front();
+  MaybeCompact();
+}
+
+std::vector<Tensor> ShuffleBuffer::Get(int64 index) const {
+  const Entry& entry = entries_[index];
+  if (entry.slab != nullptr) {
+    return Unpack(entry);
+  }
+  return entry.tensors;
+}
+
+std::shared_ptr<const ShuffleBuffer::Signature> ShuffleBuffer::PackedSignature(
+    const std::vector<Tensor>& element) {
+  int64 num_bytes = 0;
+  for (const Tensor& t : element) {
+    if (!t.IsInitialized() || !DataTypeCanUseMemcpy(t.dtype())) {
+      return nullptr;
+    }
+    num_bytes += t.TotalBytes();
+    if (num_bytes > max_packed_element_bytes_) {
+      return nullptr;
+    }
+  }
+  // Elements without bytes gain nothing from packing.
+  if (num_bytes == 0) {
+    return nullptr;
+  }
+  if (last_signature_ && last_signature_->dtypes.size() == element.size()) {
+    bool same = true;
+    for (size_t i = 0; i < element.size() && same; ++i) {
+      same = last_signature_->dtypes[i] == element[i].dtype() &&
+             last_signature_->shapes[i] == element[i].shape();
+    }
+    if (same) {
+      return last_signature_;
+    }
+  }
+  auto signature = std::make_shared<Signature>();
+  for (const Tensor& t : element) {
+    signature->dtypes.push_back(t.dtype());
+    signature->shapes.push_back(t.shape());
+  }
+  signature->num_bytes = num_bytes;
+  last_signature_ = std::move(signature);
+  return last_signature_;
+}
+
+char* ShuffleBuffer::AllocateInSlab(Entry* entry) {
+  const int64 num_bytes = entry->signature->num_bytes;
+  if (slabs_.empty() ||
+      slabs_.back()->capacity - slabs_.back()->used < num_bytes) {
+    slabs_.push_back(absl::make_unique<Slab>(slab_bytes_));
+  }
+  Slab* slab = slabs_.back().get();
+  entry->slab = slab;
+  entry->offset = slab->used;
+  slab->used += num_bytes;
+  slab->live += num_bytes;
+  used_bytes_ += num_bytes;
+  live_bytes_ += num_bytes;
+  return slab->data.get() + entry->offset;
+}
+
+/* static */ std::vector<Tensor> ShuffleBuffer::Unpack(const Entry& entry) {
+  const Signature& signature = *entry.signature;
+  std::vector<Tensor> element;
+  element.reserve(signature.dtypes.size());
+  const char* src = entry.slab->data.get() + entry.offset;
+  for (size_t i = 0; i < signature.dtypes.size(); ++i) {
+    element.emplace_back(signature.dtypes[i], signature.shapes[i]);
+    StringPiece bytes = element.back().tensor_data();
+    std::memcpy(const_cast<char*>(bytes.data()), src, bytes.size());
+    src += bytes.size();
+  }
+  return element;
+}
+
+void ShuffleBuffer::Unref(const Entry& entry) {
+  Slab* slab = entry.slab;
+  slab->live -= entry.signature->num_bytes;
+  live_bytes_ -= entry.signature->num_bytes;
+  if (slab->live > 0) {
+    return;
+  }
+  used_bytes_ -= slab->used;
+  if (slab == slabs_.back().get()) {
+    // Keep packing into the last slab.
+    slab->used = 0;
+    return;
+  }
+  auto it = std::find_if(
+      slabs_.begin(), slabs_.end(),
+      [slab](const std::unique_ptr<Slab>& s) { return s.get() == slab; });
+  DCHECK(it != slabs_.end());
+  slabs_.erase(it);
+}
+
+void ShuffleBuffer::MaybeCompact() {
+  const int64 wasted_bytes = used_bytes_ - live_bytes_;
+  if (wasted_bytes <= live_bytes_ || wasted_bytes <= slab_bytes_) {
+    return;
+  }
+  // Repacking costs a copy of the packed elements, and happens only after as
+  // many bytes were taken, so it costs a constant per byte taken.
+  std::vector<std::unique_ptr<Slab>> old_slabs;
+  old_slabs.swap(slabs_);
+  used_bytes_ = 0;
+  live_bytes_ = 0;
+  for (Entry& entry : entries_) {
+    if (entry.slab == nullptr) continue;
+    const char* src = entry.slab->data.get() + entry.offset;
+    std::memcpy(AllocateInSlab(&entry), src, entry.signature->num_bytes);
+  }
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,144 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_SHUFFLE_BUFFER_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_SHUFFLE_BUFFER_H_
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data {
+
+// A double-ended queue of dataset elements, as buffered by the shuffle
+// iterators, that packs small elements into large slabs.
+//
+// Every buffered `Tensor` owns its own buffer, so an element of a few bytes
+// costs a few hundred bytes of bookkeeping and aligned allocations, and
+// filling a large shuffle buffer spends most of its time in malloc. Instead,
+// the bytes of the elements whose components all have memcpy-able types and
+// which take at most `max_packed_element_bytes` are copied back to back into
+// slabs of `slab_bytes`, and copied out into new tensors when the elements
+// are taken. Other elements, e.g. of strings, are kept as they are.
+//
+// A slab is freed when its last element is taken. Since elements are taken
+// in random order, slabs are repacked once they hold more bytes of taken
+// elements than of buffered ones, so the slabs take at most about twice the
+// bytes of the packed elements.
+class ShuffleBuffer {
+ public:
+  // Packing is disabled if `max_packed_element_bytes` is 0.
+  ShuffleBuffer(int64 max_packed_element_bytes, int64 slab_bytes);
+  ~ShuffleBuffer();
+
+  ShuffleBuffer(const ShuffleBuffer&) = delete;
+  ShuffleBuffer& operator=(const ShuffleBuffer&) = delete;
+
+  int64 size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+
+  // Removes all the elements.
+  void Clear();
+
+  // Appends `element` to the end of the buffer.
+  void PushBack(std::vector<Tensor>&& element);
+
+  // Removes the element at `index` into `*element`, and moves the first
+  // element in its place, so that the buffer ends up one element shorter at
+  // the front.
+  void Take(int64 index, std::vector<Tensor>* element);
+
+  // Returns the element at `index`, without removing it.
+  std::vector<Tensor> Get(int64 index) const;
+
+  // The number of packed elements.
+  int64 num_packed() const { return num_packed_; }
+  // The number of slabs allocated.
+  int64 num_slabs() const { return slabs_.size(); }
+  // The bytes of the packed elements.
+  int64 live_bytes() const { return live_bytes_; }
+  // The bytes of the slabs written so far, including those of the packed
+  // elements taken since.
+  int64 used_bytes() const { return used_bytes_; }
+
+ private:
+  // The types and shapes of the components of packed elements. Consecutive
+  // elements share it when they have the same.
+  struct Signature {
+    std::vector<DataType> dtypes;
+    std::vector<TensorShape> shapes;
+    int64 num_bytes = 0;
+  };
+
+  struct Slab {
+    explicit Slab(int64 capacity)
+        : data(new char[capacity]), capacity(capacity) {}
+
+    std::unique_ptr<char[]> data;
+    const int64 capacity;
+    // The bytes written, of which `live` belong to buffered elements.
+    int64 used = 0;
+    int64 live = 0;
+  };
+
+  // An element, either as its tensors or, if `slab` is not null, as the
+  // bytes of its components at `offset` in `slab`.
+  struct Entry {
+    std::vector<Tensor> tensors;
+    Slab* slab = nullptr;
+    int64 offset = 0;
+    std::shared_ptr<const Signature> signature;
+  };
+
+  // Returns the signature of `element`, or null if it cannot be packed.
+  std::shared_ptr<const Signature> PackedSignature(
+      const std::vector<Tensor>& element);
+
+  // Reserves the bytes of the packed `entry` at the end of the last slab,
+  // or of a new one if they do not fit, and returns them.
+  char* AllocateInSlab(Entry* entry);
+
+  // Returns the element of a packed `entry`.
+  static std::vector<Tensor> Unpack(const Entry& entry);
+
+  // Drops the bytes of the packed `entry` from its slab, and frees the slab
+  // if no other element is left in it.
+  void Unref(const Entry& entry);
+
+  // Repacks the packed elements into new slabs if the slabs hold more bytes
+  // of taken elements than of buffered ones.
+  void MaybeCompact();
+
+  const int64 max_packed_element_bytes_;
+  const int64 slab_bytes_;
+
+  std::deque<Entry> entries_;
+  // The last slab is the one that elements are packed into.
+  std::vector<std::unique_ptr<Slab>> slabs_;
+  std::shared_ptr<const Signature> last_signature_;
+  int64 num_packed_ = 0;
+  int64 live_bytes_ = 0;
+  int64 used_bytes_ = 0;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_SHUFFLE_BUFFER_H_
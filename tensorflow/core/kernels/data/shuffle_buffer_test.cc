@@ -0,0 +1,182 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/shuffle_buffer.h"
+
+#include <deque>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// An element of an int64 scalar and a float vector of `length`.
+std::vector<Tensor> MakeElement(int64 value, int64 length) {
+  std::vector<Tensor> element = {test::AsScalar<int64>(value),
+                                 Tensor(DT_FLOAT, TensorShape({length}))};
+  for (int64 i = 0; i < length; ++i) {
+    element[1].vec<float>()(i) = value + 0.5f * i;
+  }
+  return element;
+}
+
+void ExpectElement(const std::vector<Tensor>& element, int64 value,
+                   int64 length) {
+  ASSERT_EQ(element.size(), 2);
+  test::ExpectTensorEqual<int64>(element[0], test::AsScalar<int64>(value));
+  test::ExpectTensorEqual<float>(element[1], MakeElement(value, length)[1]);
+}
+
+TEST(ShuffleBufferTest, PacksSmallElements) {
+  ShuffleBuffer buffer(/*max_packed_element_bytes=*/64, /*slab_bytes=*/1024);
+  for (int64 i = 0; i < 10; ++i) {
+    buffer.PushBack(MakeElement(i, /*length=*/i % 3));
+  }
+  EXPECT_EQ(buffer.size(), 10);
+  EXPECT_EQ(buffer.num_packed(), 10);
+  EXPECT_EQ(buffer.num_slabs(), 1);
+  // 10 int64 scalars and 0 + 1 + 2 + 0 + ... = 9 floats.
+  EXPECT_EQ(buffer.live_bytes(), 10 * 8 + 9 * 4);
+  for (int64 i = 0; i < 10; ++i) {
+    ExpectElement(buffer.Get(i), i, i % 3);
+  }
+}
+
+TEST(ShuffleBufferTest, DoesNotPackLargeOrStringElements) {
+  ShuffleBuffer buffer(/*max_packed_element_bytes=*/64, /*slab_bytes=*/1024);
+  buffer.PushBack(MakeElement(0, /*length=*/1));
+  buffer.PushBack(MakeElement(1, /*length=*/100));
+  buffer.PushBack({test::AsScalar<tstring>("a string")});
+  buffer.PushBack({Tensor(DT_FLOAT, TensorShape({0}))});
+  EXPECT_EQ(buffer.size(), 4);
+  EXPECT_EQ(buffer.num_packed(), 1);
+
+  ExpectElement(buffer.Get(1), 1, 100);
+  std::vector<Tensor> element;
+  buffer.Take(2, &element);
+  ASSERT_EQ(element.size(), 1);
+  test::ExpectTensorEqual<tstring>(element[0],
+                                   test::AsScalar<tstring>("a string"));
+}
+
+TEST(ShuffleBufferTest, DisabledPacking) {
+  ShuffleBuffer buffer(/*max_packed_element_bytes=*/0, /*slab_bytes=*/1024);
+  buffer.PushBack(MakeElement(0, /*length=*/1));
+  EXPECT_EQ(buffer.num_packed(), 0);
+  EXPECT_EQ(buffer.num_slabs(), 0);
+  ExpectElement(buffer.Get(0), 0, 1);
+}
+
+TEST(ShuffleBufferTest, TakeMovesFirstElementInPlace) {
+  ShuffleBuffer buffer(/*max_packed_element_bytes=*/64, /*slab_bytes=*/1024);
+  for (int64 i = 0; i < 4; ++i) {
+    buffer.PushBack(MakeElement(i, /*length=*/1));
+  }
+  std::vector<Tensor> element;
+  buffer.Take(2, &element);
+  ExpectElement(element, 2, 1);
+  ASSERT_EQ(buffer.size(), 3);
+  ExpectElement(buffer.Get(0), 1, 1);
+  ExpectElement(buffer.Get(1), 0, 1);
+  ExpectElement(buffer.Get(2), 3, 1);
+
+  buffer.Take(0, &element);
+  ExpectElement(element, 1, 1);
+  ASSERT_EQ(buffer.size(), 2);
+  ExpectElement(buffer.Get(0), 0, 1);
+  ExpectElement(buffer.Get(1), 3, 1);
+}
+
+TEST(ShuffleBufferTest, MatchesUnpackedBuffer) {
+  // Interleaves pushes and random takes of packed and unpacked elements, and
+  // checks them against a deque of the elements.
+  ShuffleBuffer buffer(/*max_packed_element_bytes=*/16, /*slab_bytes=*/64);
+  std::deque<int64> expected;
+  random::PhiloxRandom philox(42, 7);
+  random::SimplePhilox rng(&philox);
+  std::vector<Tensor> element;
+  int64 next = 0;
+  for (int step = 0; step < 2000; ++step) {
+    if (expected.empty() || rng.Uniform(3) != 0) {
+      buffer.PushBack(MakeElement(next, /*length=*/next % 4));
+      expected.push_back(next++);
+    } else {
+      const int64 index = rng.Uniform(expected.size());
+      buffer.Take(index, &element);
+      ExpectElement(element, expected[index], expected[index] % 4);
+      expected[index] = expected.front();
+      expected.pop_front();
+    }
+    ASSERT_EQ(buffer.size(), expected.size());
+  }
+  for (int64 i = 0; i < buffer.size(); ++i) {
+    ExpectElement(buffer.Get(i), expected[i], expected[i] % 4);
+  }
+}
+
+TEST(ShuffleBufferTest, FreesAndRepacksSlabs) {
+  // 8 elements of 8 bytes per slab.
+  ShuffleBuffer buffer(/*max_packed_element_bytes=*/8, /*slab_bytes=*/64);
+  for (int64 i = 0; i < 800; ++i) {
+    buffer.PushBack({test::AsScalar<int64>(i)});
+  }
+  EXPECT_EQ(buffer.num_slabs(), 100);
+  EXPECT_EQ(buffer.used_bytes(), 6400);
+
+  // Taking elements at random leaves holes in most slabs, which are repacked
+  // before they take more than twice the bytes of the elements.
+  random::PhiloxRandom philox(42, 7);
+  random::SimplePhilox rng(&philox);
+  std::vector<Tensor> element;
+  while (buffer.size() > 100) {
+    buffer.Take(rng.Uniform(buffer.size()), &element);
+    EXPECT_LE(buffer.used_bytes(), 2 * buffer.live_bytes() + 64);
+  }
+  EXPECT_EQ(buffer.live_bytes(), 800);
+  EXPECT_LE(buffer.num_slabs(), buffer.used_bytes() / 64 + 1);
+
+  // Taking the rest frees all but the last slab.
+  while (!buffer.empty()) {
+    buffer.Take(0, &element);
+  }
+  EXPECT_EQ(buffer.live_bytes(), 0);
+  EXPECT_EQ(buffer.used_bytes(), 0);
+  EXPECT_LE(buffer.num_slabs(), 1);
+}
+
+TEST(ShuffleBufferTest, Clear) {
+  ShuffleBuffer buffer(/*max_packed_element_bytes=*/8, /*slab_bytes=*/64);
+  for (int64 i = 0; i < 20; ++i) {
+    buffer.PushBack({test::AsScalar<int64>(i)});
+  }
+  buffer.Clear();
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.num_packed(), 0);
+  EXPECT_EQ(buffer.num_slabs(), 0);
+  EXPECT_EQ(buffer.live_bytes(), 0);
+
+  buffer.PushBack({test::AsScalar<int64>(7)});
+  std::vector<Tensor> element;
+  buffer.Take(0, &element);
+  test::ExpectTensorEqual<int64>(element[0], test::AsScalar<int64>(7));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -24,10 +24,12 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
 #include "tensorflow/core/kernels/data/random_seed_ops.h"
+#include "tensorflow/core/kernels/data/shuffle_buffer.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -52,6 +54,8 @@ namespace data {
 
 const int64 kLogIntervalMicros = 10 * 1000000;  // 10 seconds.
 const int64 kMaxEpochsInBuffer = 3;
+// The size of the slabs that the shuffle buffer packs small elements into.
+const int64 kShuffleSlabBytes = 1 << 20;
 
 constexpr char kNumRandomSamples[] = "num_random_samples";
 constexpr char kDataProduced[] = "data_produced";
@@ -69,8 +73,40 @@ constexpr char kDSNumRandomSamples[] = "ds_num_random_samples";
 constexpr char kFixedSeedDatasetPrefix[] = "FixedSeed";
 constexpr char kReshufflingDatasetPrefix[] = "Reshuffling";
 constexpr char kShuffleDataset[] = "ShuffleDataset";
+constexpr char kNumProduced[] = "num_produced";
 
 namespace {
+
+// Returns the size up to which elements are packed in the shuffle buffer, see
+// `ShuffleBuffer`. Packing is disabled with 0.
+int64 MaxPackedElementBytes() {
+  int64 max_bytes = 0;
+  Status s = ReadInt64FromEnvVar("TF_DATA_SHUFFLE_MAX_PACKED_ELEMENT_BYTES",
+                                 /*default_val=*/1024, &max_bytes);
+  if (!s.ok()) {
+    LOG(WARNING) << s;
+    return 0;
+  }
+  return max_bytes;
+}
+
+// Whether iterators checkpoint how many elements they produced instead of the
+// contents of their buffer, and rebuild the buffer on restore by producing
+// those elements again from the start of the iteration. This keeps
+// checkpoints small and fast for large buffers, at the cost of re-reading the
+// input on restore, and requires the input to produce the same sequence of
+// elements every time it is iterated.
+bool CheckpointByReplay() {
+  bool replay = false;
+  Status s = ReadBoolFromEnvVar("TF_DATA_SHUFFLE_CHECKPOINT_BY_REPLAY",
+                                /*default_val=*/false, &replay);
+  if (!s.ok()) {
+    LOG(WARNING) << s;
+    return false;
+  }
+  return replay;
+}
+
 class Seeds {
  public:
   Seeds(int64 seed, int64 seed2) {
@@ -153,13 +189,13 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         : DatasetIterator<T>(params),
           seed_(seed),
           seed2_(seed2),
+          buffer_(MaxPackedElementBytes(), kShuffleSlabBytes),
           input_impl_(nullptr),
           epoch_(0),
           num_elements_(0),
           parent_generator_(seed, seed2),
-          generator_(&parent_generator_) {
-      buffer_ = absl::make_unique<std::vector<Tensor>[]>(
-          params.dataset->buffer_size_);
+          generator_(&parent_generator_),
+          checkpoint_by_replay_(CheckpointByReplay()) {
       slices_.push_back(absl::make_unique<Slice>(0, 0));
     }
 
@@ -172,6 +208,12 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
       mutex_lock l(mu_);
+      return GetNextLocked(ctx, out_tensors, end_of_sequence);
+    }
+
+    // Also used to rebuild the buffer on restore.
+    Status GetNextLocked(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                         bool* end_of_sequence) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       int64 start_micros = EnvTime::NowMicros();
       int64 num_log_entries = 0;
       if (!input_impl_ && epoch_ == 0) {
@@ -214,8 +256,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
                     << this->dataset()->buffer_size_;
           }
           this->RecordBufferEnqueue(ctx, input_element);
-          buffer_[slices_.back()->end % this->dataset()->buffer_size_] =
-              std::move(input_element);
+          buffer_.PushBack(std::move(input_element));
           num_elements_++;
           slices_.back()->end++;
         } else {
@@ -246,15 +287,11 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         // slice, and then remove the element from the slice.
         int64 offset =
             Random() % (slices_.front()->end - slices_.front()->start);
-        int64 index =
-            (slices_.front()->start + offset) % this->dataset()->buffer_size_;
-        *out_tensors = std::move(buffer_[index]);
+        buffer_.Take(offset, out_tensors);
         this->RecordBufferDequeue(ctx, *out_tensors);
-        std::swap(
-            buffer_[index],
-            buffer_[slices_.front()->start % this->dataset()->buffer_size_]);
         slices_.front()->start++;
         num_elements_--;
+        num_produced_++;
       } else {
         DCHECK(input_impl_ == nullptr);
         *end_of_sequence = true;
@@ -284,6 +321,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
                                              num_random_samples_));
       TF_RETURN_IF_ERROR(writer->WriteScalar(this->full_name(kSeed), seed_));
       TF_RETURN_IF_ERROR(writer->WriteScalar(this->full_name(kSeed2), seed2_));
+      if (checkpoint_by_replay_) {
+        return writer->WriteScalar(this->full_name(kNumProduced),
+                                   num_produced_);
+      }
 
       // Save input iterator if it hasn't been exhausted else write
       // "end_of_input_sequence".
@@ -310,15 +351,16 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             slices_[i]->end));
         for (size_t j = slices_[i]->start; j < slices_[i]->end; ++j) {
           size_t index = j % this->dataset()->buffer_size_;
+          const std::vector<Tensor> element = BufferAt(j);
           TF_RETURN_IF_ERROR(writer->WriteScalar(
               this->full_name(
                   absl::StrJoin(std::make_tuple(kBuffer, index, kSize), "_")),
-              buffer_[index].size()));
-          for (size_t k = 0; k < buffer_[index].size(); ++k) {
+              element.size()));
+          for (size_t k = 0; k < element.size(); ++k) {
             TF_RETURN_IF_ERROR(writer->WriteTensor(
                 this->full_name(
                     absl::StrJoin(std::make_tuple(kBuffer, index, k), "_")),
-                buffer_[index][k]));
+                element[k]));
           }
         }
       }
@@ -339,6 +381,12 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       TF_RETURN_IF_ERROR(reader->ReadScalar(this->full_name(kSeed), &seed_));
       TF_RETURN_IF_ERROR(reader->ReadScalar(this->full_name(kSeed2), &seed2_));
       ResetRngs();
+      if (reader->Contains(this->full_name(kNumProduced))) {
+        int64 num_produced;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(this->full_name(kNumProduced), &num_produced));
+        return Replay(ctx, num_produced);
+      }
 
       // Restore the input iterator if it wasn't already exhausted.
       if (!reader->Contains(this->full_name(kEndOfInputSequence))) {
@@ -360,8 +408,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             reader->ReadScalar(this->full_name(kSlicesSize), &temp));
         slices_size = static_cast<size_t>(temp);
       }
-      buffer_ = absl::make_unique<std::vector<Tensor>[]>(
-          this->dataset()->buffer_size_);
+      buffer_.Clear();
       slices_.clear();
       for (size_t i = 0; i < slices_size; ++i) {
         int64 start;
@@ -381,13 +428,16 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
               this->full_name(
                   absl::StrJoin(std::make_tuple(kBuffer, index, kSize), "_")),
               &list_size));
-          buffer_[index] = std::vector<Tensor>(list_size);
+          std::vector<Tensor> element(list_size);
           for (int k = 0; k < list_size; ++k) {
             TF_RETURN_IF_ERROR(reader->ReadTensor(
                 this->full_name(
                     absl::StrJoin(std::make_tuple(kBuffer, index, k), "_")),
-                &buffer_[index][k]));
+                &element[k]));
           }
+          // Slices are contiguous, so elements are restored in the order
+          // of their positions.
+          buffer_.PushBack(std::move(element));
         }
       }
       data_produced_ = reader->Contains(this->full_name(kDataProduced));
@@ -402,9 +452,8 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
    private:
     // Used to represent slices of `buffer_` that belong to different epochs.
     // The invariant maintained by the implementation is: `start` <= `end`.
-    // When using `start` and `end` to index into `buffer_`, their values
-    // should be taken modulo the size of `buffer_` as their absolute value
-    // can be greater than the range of `buffer_`.
+    // `start` and `end` are positions in the sequence of buffered elements;
+    // use `BufferAt` to look up the element at a position.
     struct Slice {
       Slice(int64 start, int64 end) : start(start), end(end) {}
 
@@ -412,6 +461,34 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       int64 end;
     };
 
+    // Rebuilds the state of the iterator after it produced `num_produced`
+    // elements, by producing them again from a new input iterator.
+    Status Replay(IteratorContext* ctx, int64 num_produced)
+        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      num_random_samples_ = 0;
+      ResetRngs();
+      input_impl_.reset();
+      epoch_ = 0;
+      num_elements_ = 0;
+      buffer_.Clear();
+      slices_.clear();
+      slices_.push_back(absl::make_unique<Slice>(0, 0));
+      data_produced_ = false;
+      num_produced_ = 0;
+      std::vector<Tensor> element;
+      bool end_of_sequence = false;
+      while (num_produced_ < num_produced && !end_of_sequence) {
+        TF_RETURN_IF_ERROR(GetNextLocked(ctx, &element, &end_of_sequence));
+      }
+      if (num_produced_ < num_produced) {
+        return errors::FailedPrecondition(
+            "Failed to rebuild the shuffle buffer: the input ran out after ",
+            num_produced_, " of the ", num_produced,
+            " elements that were produced before the checkpoint.");
+      }
+      return Status::OK();
+    }
+
     random::SingleSampleAdapter<random::PhiloxRandom>::ResultType Random()
         EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       num_random_samples_++;
@@ -419,7 +496,19 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       return out;
     }
 
-    std::unique_ptr<std::vector<Tensor>[]> buffer_ GUARDED_BY(mu_);
+    // Returns the buffered element at the given position of a slice.
+    std::vector<Tensor> BufferAt(int64 position) const
+        SHARED_LOCKS_REQUIRED(mu_) {
+      return buffer_.Get(position - (slices_.back()->end - num_elements_));
+    }
+
+    // The buffered elements, ordered by position. Slices are contiguous and
+    // elements are only removed from the start of the first slice, so the
+    // elements of all slices form the range
+    // [slices_.front()->start, slices_.back()->end) and the buffer only holds
+    // as many entries as there are buffered elements, however large
+    // `buffer_size` is. Small elements are packed into slabs.
+    ShuffleBuffer buffer_ GUARDED_BY(mu_);
     std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
     int64 epoch_ GUARDED_BY(mu_);
     int64 num_elements_ GUARDED_BY(mu_);
@@ -433,6 +522,9 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         GUARDED_BY(mu_);
     int64 num_random_samples_ GUARDED_BY(mu_) = 0;
     bool data_produced_ GUARDED_BY(mu_) = false;
+    // The number of elements produced since the iterator was created.
+    int64 num_produced_ GUARDED_BY(mu_) = 0;
+    const bool checkpoint_by_replay_;
   };
 
   const DatasetBase* const input_;
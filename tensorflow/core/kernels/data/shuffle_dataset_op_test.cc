@@ -12,6 +12,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/shuffle_dataset_op.h"
 
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 
 namespace tensorflow {
 namespace data {
@@ -510,9 +511,12 @@ IteratorSaveAndRestoreTestCases() {
 class ParameterizedIteratorSaveAndRestoreTest
     : public ShuffleDatasetOpTest,
       public ::testing::WithParamInterface<
-          IteratorSaveAndRestoreTestCase<ShuffleDatasetParams>> {};
+          IteratorSaveAndRestoreTestCase<ShuffleDatasetParams>> {
+ protected:
+  void SaveAndRestore();
+};
 
-TEST_P(ParameterizedIteratorSaveAndRestoreTest, IteratorSaveAndRestore) {
+void ParameterizedIteratorSaveAndRestoreTest::SaveAndRestore() {
   auto test_case = GetParam();
   TF_ASSERT_OK(Initialize(test_case.dataset_params));
 
@@ -546,6 +550,28 @@ TEST_P(ParameterizedIteratorSaveAndRestoreTest, IteratorSaveAndRestore) {
                            /*compare_order=*/true));
 }
 
+TEST_P(ParameterizedIteratorSaveAndRestoreTest, IteratorSaveAndRestore) {
+  SaveAndRestore();
+}
+
+TEST_P(ParameterizedIteratorSaveAndRestoreTest,
+       IteratorSaveAndRestoreByReplay) {
+  setenv("TF_DATA_SHUFFLE_CHECKPOINT_BY_REPLAY", "true", /*overwrite=*/1);
+  auto cleanup = gtl::MakeCleanup(
+      [] { unsetenv("TF_DATA_SHUFFLE_CHECKPOINT_BY_REPLAY"); });
+  SaveAndRestore();
+}
+
+// The int64 elements are packed in slabs by default; the sequence is the same
+// without packing.
+TEST_P(ParameterizedIteratorSaveAndRestoreTest,
+       IteratorSaveAndRestoreWithoutPacking) {
+  setenv("TF_DATA_SHUFFLE_MAX_PACKED_ELEMENT_BYTES", "0", /*overwrite=*/1);
+  auto cleanup = gtl::MakeCleanup(
+      [] { unsetenv("TF_DATA_SHUFFLE_MAX_PACKED_ELEMENT_BYTES"); });
+  SaveAndRestore();
+}
+
 INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpTest,
                         ParameterizedIteratorSaveAndRestoreTest,
                         ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
@@ -32,6 +32,7 @@ ABSL_CONST_INIT const char kDroppedElements[] = "dropped_elements";
 ABSL_CONST_INIT const char kFeaturesCount[] = "features_count";
 ABSL_CONST_INIT const char kFeatureValuesCount[] = "feature_values_count";
 ABSL_CONST_INIT const char kExamplesCount[] = "examples_count";
+ABSL_CONST_INIT const char kPaddingWaste[] = "padding_waste";
 
 string ExecutionTimeHistogramName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kExecutionTime);
@@ -69,6 +70,10 @@ string FeatureValueHistogramName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kFeatureValuesCount);
 }
 
+string PaddingWasteHistogramName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kPaddingWaste);
+}
+
 }  // namespace stats_utils
 }  // namespace data
 }  // namespace tensorflow
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -42,7 +43,8 @@ constexpr char kOffset[] = "offset";
 class TFRecordDatasetOp::Dataset : public DatasetBase {
  public:
   explicit Dataset(OpKernelContext* ctx, std::vector<string> filenames,
-                   const string& compression_type, int64 buffer_size)
+                   const string& compression_type, int64 buffer_size,
+                   int64 read_ahead_window)
       : DatasetBase(DatasetContext(ctx)),
         filenames_(std::move(filenames)),
         compression_type_(compression_type),
@@ -50,6 +52,7 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
             compression_type)) {
     if (buffer_size > 0) {
       options_.buffer_size = buffer_size;
+      options_.read_ahead_window = static_cast<int>(read_ahead_window);
     }
   }
 
@@ -242,8 +245,19 @@ void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
               errors::InvalidArgument(
                   "`buffer_size` must be >= 0 (0 == no buffering)"));
 
-  *output =
-      new Dataset(ctx, std::move(filenames), compression_type, buffer_size);
+  // Number of reads of `buffer_size` bytes to keep outstanding per file, for
+  // storage where latency rather than bandwidth limits the read rate.
+  int64 read_ahead_window = 0;
+  OP_REQUIRES_OK(ctx, ReadInt64FromEnvVar("TF_RECORD_READ_AHEAD_WINDOW",
+                                          /*default_val=*/0,
+                                          &read_ahead_window));
+  OP_REQUIRES(ctx, read_ahead_window >= 0,
+              errors::InvalidArgument(
+                  "TF_RECORD_READ_AHEAD_WINDOW must be >= 0 but is ",
+                  read_ahead_window));
+
+  *output = new Dataset(ctx, std::move(filenames), compression_type,
+                        buffer_size, read_ahead_window);
 }
 
 namespace {
@@ -235,4 +235,40 @@ TF_CALL_int64(REGISTER_GPU_KERNEL);
 #undef REGISTER_GPU_KERNEL
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#ifdef TENSORFLOW_USE_VE
+// The inputs of DataFormat ops inserted by the layout optimizer are small shape
+// and axis vectors, so VE runs the CPU implementation on host memory for both
+// the plain and the "host" labeled kernels.
+#define REGISTER_VE_KERNEL(T)                                            \
+  REGISTER_KERNEL_BUILDER(Name("DataFormatDimMap")                       \
+                              .Device(DEVICE_VE)                         \
+                              .HostMemory("x")                           \
+                              .HostMemory("y")                           \
+                              .TypeConstraint<T>("T"),                   \
+                          DataFormatDimMapOp<CPUDevice, T>);             \
+  REGISTER_KERNEL_BUILDER(Name("DataFormatDimMap")                       \
+                              .Device(DEVICE_VE)                         \
+                              .HostMemory("x")                           \
+                              .HostMemory("y")                           \
+                              .Label("host")                             \
+                              .TypeConstraint<T>("T"),                   \
+                          DataFormatDimMapOp<CPUDevice, T>);             \
+  REGISTER_KERNEL_BUILDER(Name("DataFormatVecPermute")                   \
+                              .Device(DEVICE_VE)                         \
+                              .HostMemory("x")                           \
+                              .HostMemory("y")                           \
+                              .TypeConstraint<T>("T"),                   \
+                          DataFormatVecPermuteOp<CPUDevice, T>);         \
+  REGISTER_KERNEL_BUILDER(Name("DataFormatVecPermute")                   \
+                              .Device(DEVICE_VE)                         \
+                              .HostMemory("x")                           \
+                              .HostMemory("y")                           \
+                              .Label("host")                             \
+                              .TypeConstraint<T>("T"),                   \
+                          DataFormatVecPermuteOp<CPUDevice, T>);
+TF_CALL_int32(REGISTER_VE_KERNEL);
+TF_CALL_int64(REGISTER_VE_KERNEL);
+#undef REGISTER_VE_KERNEL
+#endif  // TENSORFLOW_USE_VE
+
 }  // namespace tensorflow
@@ -76,55 +76,103 @@ static int64 GetDirectConvCost(int filter_rows, int filter_cols, int in_depth,
   return filter_rows * filter_cols * in_depth * out_depth * out_rows * out_cols;
 }
 
-// Reads environment variable 'env_var_name'.
-// Returns 'true' if environment variable is enabled, false otherwise.
-static bool ReadBoolFromEnvVar(const char* env_var_name, bool default_val) {
-  const char* tf_env_var_val = getenv(env_var_name);
-  if (tf_env_var_val != nullptr) {
-    StringPiece tf_env_var_val_str(tf_env_var_val);
-    if (tf_env_var_val_str == "0") {
-      return false;
-    }
-    return true;
-  }
-  return default_val;
+// DeepConv2D modes selected by the TF_USE_DEEP_CONV2D environment variable.
+enum class DeepConv2DMode {
+  kDisabled,
+  kCostModel,
+  kWinograd2x2,
+  kWinograd4x4,
+  kAutotune,
+};
+
+// Reads the DeepConv2D mode from the TF_USE_DEEP_CONV2D environment variable
+// (see CanUseDeepConv2D in deep_conv2d.h for the accepted values).
+// NOTE: IF this environment variable name changes, update conv_ops_test.py.
+static DeepConv2DMode ReadDeepConv2DMode() {
+  const char* tf_env_var_val = getenv("TF_USE_DEEP_CONV2D");
+  if (tf_env_var_val == nullptr) return DeepConv2DMode::kDisabled;
+
+  StringPiece tf_env_var_val_str(tf_env_var_val);
+  if (tf_env_var_val_str == "0") return DeepConv2DMode::kDisabled;
+  if (tf_env_var_val_str == "winograd2x2") return DeepConv2DMode::kWinograd2x2;
+  if (tf_env_var_val_str == "winograd4x4") return DeepConv2DMode::kWinograd4x4;
+  if (tf_env_var_val_str == "autotune") return DeepConv2DMode::kAutotune;
+  return DeepConv2DMode::kCostModel;
+}
+
+// Returns true if convolution parameters are supported by DeepConv2D.
+// TODO(andydavis) Add support for multiple filter sizes and strides.
+static bool IsDeepConv2DSupported(int stride_rows, int stride_cols,
+                                  int filter_rows, int filter_cols) {
+  return stride_rows == 1 && stride_cols == 1 && filter_rows == 3 &&
+         filter_cols == 3;
 }
 
 // Returns true if convolution can be computed efficiently by DeepConv2D,
 // returns false otherwise.
-// TODO(andydavis) Add support for other filter sizes and strides.
-// TODO(andydavis) Add support for autotuning.
 bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
                       int filter_cols, int in_depth, int out_depth,
-                      int out_rows, int out_cols) {
-  // Check if convolution parameters are supported.
-  // TODO(andydavis) Add support for multiple filter sizes and strides.
-  if (stride_rows > 1 || stride_cols > 1 || filter_rows != 3 ||
-      filter_cols != 3) {
+                      int out_rows, int out_cols,
+                      DeepConv2DTransformType* transform_type) {
+  if (!IsDeepConv2DSupported(stride_rows, stride_cols, filter_rows,
+                             filter_cols)) {
     return false;
   }
 
   // Check if deep convolution is enabled by environment variable.
-  // NOTE: IF this environment variable name changes, update conv_ops_test.py.
-  if (!ReadBoolFromEnvVar("TF_USE_DEEP_CONV2D", false)) {
-    return false;
+  switch (ReadDeepConv2DMode()) {
+    case DeepConv2DMode::kDisabled:
+    case DeepConv2DMode::kAutotune:
+      return false;
+    case DeepConv2DMode::kWinograd2x2:
+      *transform_type = DeepConv2DTransformType::kWinograd2x2;
+      return true;
+    case DeepConv2DMode::kWinograd4x4:
+      *transform_type = DeepConv2DTransformType::kWinograd4x4;
+      return true;
+    case DeepConv2DMode::kCostModel:
+      break;
   }
 
-  // Check if flop cost of deep convolution is less than direct convolution.
-  WinogradTransform<float> t;
-  const int64 deep_conv_cost = GetDeepConvCost(
-      t.input_shape().rows, t.input_shape().cols, t.output_shape().rows,
-      t.output_shape().cols, in_depth, out_depth, out_rows, out_cols);
+  // Pick the transform with the smallest flop cost, if it is less than the
+  // cost of direct convolution.
   const int64 direct_conv_cost = GetDirectConvCost(
       filter_rows, filter_cols, in_depth, out_depth, out_rows, out_cols);
+  int64 best_cost = direct_conv_cost;
+  bool use_deep_conv = false;
+
+  for (DeepConv2DTransformType type : {DeepConv2DTransformType::kWinograd2x2,
+                                       DeepConv2DTransformType::kWinograd4x4}) {
+    std::unique_ptr<DeepConv2DTransform<float>> t =
+        NewDeepConv2DTransform<float>(type);
+    const int64 deep_conv_cost = GetDeepConvCost(
+        t->input_shape().rows, t->input_shape().cols, t->output_shape().rows,
+        t->output_shape().cols, in_depth, out_depth, out_rows, out_cols);
+
+    VLOG(2) << "CanUseDeepConv2D"
+            << " output_tile: " << t->output_shape().rows << "x"
+            << t->output_shape().cols << " deep_conv_cost: " << deep_conv_cost
+            << " direct_conv_cost: " << direct_conv_cost
+            << " deep_direct_ratio: "
+            << (static_cast<float>(deep_conv_cost) /
+                static_cast<float>(direct_conv_cost));
+
+    if (deep_conv_cost < best_cost) {
+      best_cost = deep_conv_cost;
+      *transform_type = type;
+      use_deep_conv = true;
+    }
+  }
+
+  VLOG(2) << "CanUseDeepConv2D use_deep_conv: " << use_deep_conv;
+  return use_deep_conv;
+}
 
-  VLOG(2) << "CanUseDeepConv2D"
-          << " deep_conv_cost: " << deep_conv_cost
-          << " direct_conv_cost: " << direct_conv_cost << " deep_direct_ratio: "
-          << (static_cast<float>(deep_conv_cost) /
-              static_cast<float>(direct_conv_cost))
-          << " use_deep_conv: " << (deep_conv_cost < direct_conv_cost);
-  return deep_conv_cost < direct_conv_cost;
+bool ShouldAutotuneDeepConv2D(int stride_rows, int stride_cols,
+                              int filter_rows, int filter_cols) {
+  return IsDeepConv2DSupported(stride_rows, stride_cols, filter_rows,
+                               filter_cols) &&
+         ReadDeepConv2DMode() == DeepConv2DMode::kAutotune;
 }
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
@@ -923,8 +971,9 @@ namespace functor {
 // in_depth * out_depth).
 // Details:
 // *) Transforms and packs filters from 'filter' in parallel.
-// *) Computes Conv2D parallelized across 'batch' dimension.
-//   *) Each thread loops over images in its batch shard, copying 'num_tiles'
+// *) Computes Conv2D parallelized across 'batch' and tile rows (so that small
+//    batches, e.g. in inference, still use all threads).
+//   *) Each thread loops over tile rows in its shard, copying 'num_tiles'
 //      input tiles into a local buffer, and computing the Conv2D output of
 //      these tiles by all filters.
 
@@ -937,8 +986,8 @@ template <typename T>
 struct DeepConv2D<CPUDevice, T> {
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
                   const T* filter, T* output) {
-    // TODO(andydavis) Add function to select transform based on conv params.
-    std::unique_ptr<DeepConv2DTransform<T>> transform(new WinogradTransform<T>);
+    std::unique_ptr<DeepConv2DTransform<T>> transform =
+        NewDeepConv2DTransform<T>(args.transform_type);
 
     const int64 in_depth = args.in_depth;
     const int64 out_depth = args.out_depth;
@@ -1002,14 +1051,20 @@ struct DeepConv2D<CPUDevice, T> {
     transform->GetOutputTransformMatrix(
         out_tile_spatial_size, tile_spatial_size, output_transform_matrix);
 
+    const int64 row_tiles =
+        (args.out_rows + out_tile_rows - 1) / out_tile_rows +
+        filter_shards_row - 1;
+
+    // Tile rows write disjoint output rows only without filter shards (which
+    // accumulate into outputs of neighbouring tile rows), so only then the
+    // work can be sharded across tile rows of the same image.
+    const int64 row_shards = filter_shards_row == 1 ? row_tiles : 1;
+
     auto shard = [&ctx, &args, &transform, &packed_filters, &in_depth,
                   out_depth, out_tile_rows, out_tile_cols, filter_shards_row,
-                  filter_shards_col, tile_spatial_size, &input,
-                  &tile_transform_matrix, &output_transform_matrix,
-                  &output](int64 batch_start, int64 batch_limit) {
-      const int64 row_tiles =
-          (args.out_rows + out_tile_rows - 1) / out_tile_rows +
-          filter_shards_row - 1;
+                  filter_shards_col, tile_spatial_size, row_tiles, row_shards,
+                  &input, &tile_transform_matrix, &output_transform_matrix,
+                  &output](int64 work_start, int64 work_limit) {
       const int64 col_tiles =
           (args.out_cols + out_tile_cols - 1) / out_tile_cols +
           filter_shards_col - 1;
@@ -1117,11 +1172,17 @@ struct DeepConv2D<CPUDevice, T> {
       const int64 tile_stride_rows = transform->output_shape().rows;
       const int64 tile_stride_cols = transform->output_shape().cols;
 
-      for (int64 b = batch_start; b < batch_limit; ++b) {
+      const int64 rows_per_shard = row_tiles / row_shards;
+
+      for (int64 work = work_start; work < work_limit; ++work) {
+        const int64 b = work / row_shards;
         const int64 in_base = b * input_image_size;
         const int64 out_base = b * output_image_size;
 
-        for (int64 tile_r = 0; tile_r < row_tiles; ++tile_r) {
+        const int64 tile_r_start = (work % row_shards) * rows_per_shard;
+        const int64 tile_r_limit = tile_r_start + rows_per_shard;
+
+        for (int64 tile_r = tile_r_start; tile_r < tile_r_limit; ++tile_r) {
           const int64 in_r = tile_r * tile_stride_rows - row_pad;
 
           // Process unrolled tiles.
@@ -1145,9 +1206,9 @@ struct DeepConv2D<CPUDevice, T> {
     };
     auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
     const int64 shard_cost = args.out_rows * args.out_cols * args.out_depth *
-                             tile_spatial_size * args.in_depth;
-    Shard(worker_threads.num_threads, worker_threads.workers, args.batch,
-          shard_cost, shard);
+                             tile_spatial_size * args.in_depth / row_shards;
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          args.batch * row_shards, shard_cost, shard);
   }
 };
 
@@ -63,6 +63,12 @@ class DeepConv2DTransform {
   virtual const Shape& output_shape() const = 0;
 };
 
+// Transforms available to DeepConv2D, named by their output tile size.
+enum class DeepConv2DTransformType {
+  kWinograd2x2,  // F(2x2, 3x3): 4x4 input tiles (see WinogradTransform).
+  kWinograd4x4,  // F(4x4, 3x3): 6x6 input tiles (see Winograd4x4Transform).
+};
+
 // Conv2D arguments used by DeepConv2D implementation.
 struct Conv2DArgs {
   // Input layer dimensions
@@ -80,6 +86,9 @@ struct Conv2DArgs {
   int out_cols;
   int out_depth;
 
+  // Transform used to compute the convolution.
+  DeepConv2DTransformType transform_type;
+
   Conv2DArgs()
       : batch(0),
         in_rows(0),
@@ -91,15 +100,33 @@ struct Conv2DArgs {
         pad_cols(0),
         out_rows(0),
         out_cols(0),
-        out_depth(0) {}
+        out_depth(0),
+        transform_type(DeepConv2DTransformType::kWinograd2x2) {}
 };
 
 // Returns true if convolution operation specified by function arguments
-// can use DeepConv2D implementation, and false otherwise.
+// can use DeepConv2D implementation, and false otherwise. On success sets
+// 'transform_type' to the transform that should be used.
 // May return false based on parameters, cost, or whether feature is disabled.
+//
+// DeepConv2D is controlled by the TF_USE_DEEP_CONV2D environment variable:
+//   unset or "0":  disabled.
+//   "winograd2x2": always use F(2x2, 3x3) for supported convolutions.
+//   "winograd4x4": always use F(4x4, 3x3) for supported convolutions.
+//   "autotune":    time all algorithms (see ShouldAutotuneDeepConv2D).
+//   otherwise:     pick the cheapest transform or direct convolution by a
+//                  flop cost model.
 bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
                       int filter_cols, int in_depth, int out_depth,
-                      int out_rows, int out_cols);
+                      int out_rows, int out_cols,
+                      DeepConv2DTransformType* transform_type);
+
+// Returns true if DeepConv2D supports the convolution and TF_USE_DEEP_CONV2D
+// asks to autotune it. The caller is expected to time direct convolution and
+// every DeepConv2DTransformType for each convolution shape, and cache the
+// fastest one.
+bool ShouldAutotuneDeepConv2D(int stride_rows, int stride_cols,
+                              int filter_rows, int filter_cols);
 
 namespace functor {
 
@@ -155,5 +155,159 @@ TEST(DeepConv2DTransformTest, WingradOutputTransformMatrix) {
   }
 }
 
+TEST(DeepConv2DTransformTest, Winograd4x4FilterTransformMatrix) {
+  // Test that the filter transform matrix returned is the kronecker product of
+  // the following matrix with itself:
+  //
+  //   [ 1/4     0     0   ]
+  //   [-1/6  -1/6  -1/6   ]
+  //   [-1/6   1/6  -1/6   ]
+  //   [ 1/24  1/12  1/6   ]
+  //   [ 1/24 -1/12  1/6   ]
+  //   [ 0     0     1     ]
+  //
+  const int rows = 6;
+  const int cols = 3;
+
+  float transform_matrix[] = {1.0 / 4,  0,         0,        -1.0 / 6,
+                              -1.0 / 6, -1.0 / 6,  -1.0 / 6, 1.0 / 6,
+                              -1.0 / 6, 1.0 / 24,  1.0 / 12, 1.0 / 6,
+                              1.0 / 24, -1.0 / 12, 1.0 / 6,  0,
+                              0,        1};
+
+  const int kron_rows = rows * rows;
+  const int kron_cols = cols * cols;
+
+  float transform_matrix_kron[kron_rows * kron_cols];
+
+  ComputeKroneckerProduct(rows, cols, &transform_matrix[0],
+                          &transform_matrix_kron[0]);
+
+  float transform_matrix_test[kron_rows * kron_cols];
+  Winograd4x4Transform<float> t;
+  t.GetFilterTransformMatrix(kron_rows, kron_cols, &transform_matrix_test[0]);
+
+  for (int i = 0; i < kron_rows * kron_cols; ++i) {
+    EXPECT_FLOAT_EQ(transform_matrix_kron[i], transform_matrix_test[i]);
+  }
+}
+
+TEST(DeepConv2DTransformTest, Winograd4x4InputTransformMatrix) {
+  // Test that the input transform matrix returned is the kronecker product of
+  // the following matrix with itself:
+  //
+  //   [4   0  -5   0   1   0]
+  //   [0  -4  -4   1   1   0]
+  //   [0   4  -4  -1   1   0]
+  //   [0  -2  -1   2   1   0]
+  //   [0   2  -1  -2   1   0]
+  //   [0   4   0  -5   0   1]
+  //
+  const int rows = 6;
+  const int cols = 6;
+
+  float transform_matrix[] = {4, 0, -5, 0,  1,  0, 0, -4, -4, 1, 1, 0,
+                              0, 4, -4, -1, 1,  0, 0, -2, -1, 2, 1, 0,
+                              0, 2, -1, -2, 1,  0, 0, 4,  0,  -5, 0, 1};
+
+  const int kron_rows = rows * rows;
+  const int kron_cols = cols * cols;
+
+  float transform_matrix_kron[kron_rows * kron_cols];
+
+  ComputeKroneckerProduct(rows, cols, &transform_matrix[0],
+                          &transform_matrix_kron[0]);
+
+  float transform_matrix_test[kron_rows * kron_cols];
+  Winograd4x4Transform<float> t;
+  t.GetInputTransformMatrix(kron_rows, kron_cols, &transform_matrix_test[0]);
+
+  for (int i = 0; i < kron_rows * kron_cols; ++i) {
+    EXPECT_FLOAT_EQ(transform_matrix_kron[i], transform_matrix_test[i]);
+  }
+}
+
+TEST(DeepConv2DTransformTest, Winograd4x4OutputTransformMatrix) {
+  // Test that the output transform matrix returned is the kronecker product of
+  // the following matrix with itself:
+  //
+  //   [1  1  1  1  1  0]
+  //   [0  1 -1  2 -2  0]
+  //   [0  1  1  4  4  0]
+  //   [0  1 -1  8 -8  1]
+  //
+  const int rows = 4;
+  const int cols = 6;
+
+  float transform_matrix[] = {1, 1, 1,  1, 1,  0, 0, 1, -1, 2, -2, 0,
+                              0, 1, 1,  4, 4,  0, 0, 1, -1, 8, -8, 1};
+
+  const int kron_rows = rows * rows;
+  const int kron_cols = cols * cols;
+
+  float transform_matrix_kron[kron_rows * kron_cols];
+
+  ComputeKroneckerProduct(rows, cols, &transform_matrix[0],
+                          &transform_matrix_kron[0]);
+
+  float transform_matrix_test[kron_rows * kron_cols];
+  Winograd4x4Transform<float> t;
+  t.GetOutputTransformMatrix(kron_rows, kron_cols, &transform_matrix_test[0]);
+
+  for (int i = 0; i < kron_rows * kron_cols; ++i) {
+    EXPECT_FLOAT_EQ(transform_matrix_kron[i], transform_matrix_test[i]);
+  }
+}
+
+TEST(DeepConv2DTransformTest, Winograd4x4ComputesCorrelation) {
+  // Test that y = C[Ad * Bg] for a 6x6 data tile 'd' and a 3x3 filter 'g'
+  // is the 4x4 (valid) correlation of 'd' with 'g'.
+  Winograd4x4Transform<float> t;
+  const int tile_size = 36;
+  const int filter_size = 9;
+  const int out_size = 16;
+
+  float filter_transform[tile_size * filter_size];
+  float input_transform[tile_size * tile_size];
+  float output_transform[out_size * tile_size];
+  t.GetFilterTransformMatrix(tile_size, filter_size, filter_transform);
+  t.GetInputTransformMatrix(tile_size, tile_size, input_transform);
+  t.GetOutputTransformMatrix(out_size, tile_size, output_transform);
+
+  float d[tile_size];
+  float g[filter_size];
+  for (int i = 0; i < tile_size; ++i) d[i] = 0.1f * ((i * 7) % 11) - 0.5f;
+  for (int i = 0; i < filter_size; ++i) g[i] = 0.2f * ((i * 5) % 7) - 0.6f;
+
+  float product[tile_size];
+  for (int i = 0; i < tile_size; ++i) {
+    float ad = 0;
+    for (int j = 0; j < tile_size; ++j) {
+      ad += input_transform[i * tile_size + j] * d[j];
+    }
+    float bg = 0;
+    for (int j = 0; j < filter_size; ++j) {
+      bg += filter_transform[i * filter_size + j] * g[j];
+    }
+    product[i] = ad * bg;
+  }
+
+  for (int r = 0; r < 4; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      float y = 0;
+      for (int j = 0; j < tile_size; ++j) {
+        y += output_transform[(r * 4 + c) * tile_size + j] * product[j];
+      }
+      float expected = 0;
+      for (int fr = 0; fr < 3; ++fr) {
+        for (int fc = 0; fc < 3; ++fc) {
+          expected += d[(r + fr) * 6 + c + fc] * g[fr * 3 + fc];
+        }
+      }
+      EXPECT_NEAR(expected, y, 1e-4);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -14,8 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #define EIGEN_USE_THREADS
 
+#include <atomic>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
-#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM || defined(TENSORFLOW_USE_VE)
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/device_base.h"
 #endif
@@ -27,6 +29,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/casts.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#ifdef TENSORFLOW_USE_VE
+#include "tensorflow/core/util/env_var.h"
+#endif
 
 namespace tensorflow {
 typedef Eigen::GpuDevice GPUDevice;
@@ -334,6 +339,12 @@ class WhileOp : public AsyncOpKernel {
   explicit WhileOp(OpKernelConstruction* ctx) : AsyncOpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("cond", &cond_func_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("body", &body_func_));
+#ifdef TENSORFLOW_USE_VE
+    if (ctx->device_type() == DEVICE_VE && type_string() == "StatelessWhile") {
+      OP_REQUIRES_OK(ctx, ReadBoolFromEnvVar("TF_VE_SPECULATIVE_WHILE", false,
+                                             &speculate_));
+    }
+#endif
   }
 
   ~WhileOp() override {}
@@ -360,6 +371,11 @@ class WhileOp : public AsyncOpKernel {
  private:
   NameAttrList cond_func_;
   NameAttrList body_func_;
+#ifdef TENSORFLOW_USE_VE
+  // When true, the body runs while the predicate is copied from the VE, see
+  // State::SpeculateBody.
+  bool speculate_ = false;
+#endif
 
   class State {
    public:
@@ -391,6 +407,33 @@ class WhileOp : public AsyncOpKernel {
     FunctionLibraryRuntime::Options opts_;
     TensorVec args_;
     TensorVec rets_;
+#ifdef TENSORFLOW_USE_VE
+    // State of a speculative body run.
+    Tensor cond_ret_;
+    Tensor cond_t_;
+    Status cond_status_;
+    Status body_status_;
+    std::atomic<int> pending_{0};
+#endif
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM || defined(TENSORFLOW_USE_VE)
+    // Returns true if the predicate in rets_[0] is in device memory and has
+    // to be copied to the host.
+    bool CondOnDevice() const {
+      const bool ret_on_device = opts_.rets_alloc_attrs.empty() ||
+                                 !opts_.rets_alloc_attrs[0].on_host();
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+      const bool is_hostmem_dtype =
+          rets_[0].dtype() == DT_INT32 || rets_[0].dtype() == DT_INT64;
+      return !is_hostmem_dtype && ret_on_device &&
+             ctx_->device()->tensorflow_gpu_device_info() != nullptr;
+#else
+      // int32 tensors are kept in host memory on VE.
+      return rets_[0].dtype() != DT_INT32 && ret_on_device &&
+             down_cast<Device*>(ctx_->device())->device_type() == DEVICE_VE;
+#endif
+    }
+#endif
 
     void EvalCond() {
       profiler::TraceMe trace_me(
@@ -421,14 +464,11 @@ class WhileOp : public AsyncOpKernel {
         return Finish(s);
       }
       Tensor cond_t;
-#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
-      const DeviceBase::GpuDeviceInfo* gpu_device_info =
-          ctx_->device()->tensorflow_gpu_device_info();
-      const bool is_hostmem_dtype =
-          rets_[0].dtype() == DT_INT32 || rets_[0].dtype() == DT_INT64;
-      if (!is_hostmem_dtype && gpu_device_info &&
-          (opts_.rets_alloc_attrs.empty() ||
-           !opts_.rets_alloc_attrs[0].on_host())) {
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM || defined(TENSORFLOW_USE_VE)
+      if (CondOnDevice()) {
+#ifdef TENSORFLOW_USE_VE
+        if (kernel_->speculate_) return SpeculateBody();
+#endif
         // Copy the ret value to host if it's allocated on device.
         Device* device = down_cast<Device*>(ctx_->device());
         DeviceContext* device_ctx = ctx_->op_device_context();
@@ -475,17 +515,71 @@ class WhileOp : public AsyncOpKernel {
             if (!s.ok()) {
               return Finish(s);
             }
-            if (args_.size() != rets_.size()) {
-              return Finish(errors::InvalidArgument(
-                  "While loop body returned ", rets_.size(),
-                  " arguments. Expected: ", args_.size()));
-            }
-            args_.clear();
-            using std::swap;
-            swap(args_, rets_);
-            EvalCond();
+            NextIteration();
+          });
+    }
+
+    void NextIteration() {
+      if (args_.size() != rets_.size()) {
+        return Finish(errors::InvalidArgument(
+            "While loop body returned ", rets_.size(),
+            " arguments. Expected: ", args_.size()));
+      }
+      args_.clear();
+      using std::swap;
+      swap(args_, rets_);
+      EvalCond();
+    }
+
+#ifdef TENSORFLOW_USE_VE
+    // Runs the body before the predicate is known on the host. Otherwise
+    // each iteration waits for a round trip to the VE between the condition
+    // and the body, and the VE is idle meanwhile. The body kernels are
+    // queued behind the condition instead, and the next iteration's read of
+    // the predicate issues them together. The body of a StatelessWhile has
+    // no side effects, so its results and errors are dropped when the
+    // predicate is false.
+    void SpeculateBody() {
+      cond_ret_ = rets_[0];
+      cond_t_ = Tensor(cond_ret_.dtype(), cond_ret_.shape());
+      rets_.clear();
+      pending_.store(2);
+
+      Device* device = down_cast<Device*>(ctx_->device());
+      ctx_->op_device_context()->CopyDeviceTensorToCPU(
+          &cond_ret_, /*tensor_name=*/"", device, &cond_t_,
+          [this](const Status& s) {
+            cond_status_ = s;
+            SpeculationDone();
           });
+      profiler::TraceMe trace_me(
+          [&] {
+            return absl::StrCat(
+                "WhileOp-SpeculateBody #parent_step_id=", ctx_->step_id(),
+                ",function_step_id=", opts_.step_id, "#");
+          },
+          /*level=*/2);
+      lib_->Run(opts_, body_handle_, args_, &rets_, [this](const Status& s) {
+        body_status_ = s;
+        SpeculationDone();
+      });
+    }
+
+    void SpeculationDone() {
+      if (pending_.fetch_sub(1) != 1) return;
+      cond_ret_ = Tensor();
+      if (!cond_status_.ok()) return Finish(cond_status_);
+      bool cond;
+      Status s = ToBool({cond_t_}, &cond);
+      if (!s.ok()) return Finish(s);
+      if (!cond) {
+        rets_.clear();
+        return Finish(Status::OK());
+      }
+      if (!body_status_.ok()) return Finish(body_status_);
+      NextIteration();
     }
+#endif  // TENSORFLOW_USE_VE
 
     void Finish(Status s) {
       if (s.ok()) {
@@ -42,6 +42,8 @@ limitations under the License.
 #include "tensorflow/core/util/tensor_format.h"
 
 #ifdef TENSORFLOW_USE_VE
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/ve/ve_device.h"
 #include "tensorflow/core/framework/ve_ops_common.h"
 #endif
 
@@ -1620,6 +1622,26 @@ struct FusedBatchNorm<VEDevice, T, U> {
       /* From:NCHW(vetfkernel shape), To:NHWC */ 
       OP_REQUIRES_OK( context, VEDoTranspose(context, y_output_transposed, {0,2,3,1}, y_output));
     }
+
+    // The VE kernel has no fused activation, so _FusedBatchNormEx applies it
+    // in place on y.
+    if (activation_mode == FusedBatchNormActivationMode::kRelu) {
+      struct {
+        int dtype;
+        uint64_t in;
+        uint64_t out;
+        uint64_t num_elems;
+      } relu_args;
+
+      relu_args.dtype = DataTypeToEnum<T>::value;
+      relu_args.in = (uint64_t)DMAHelper::base(y_output);
+      relu_args.out = relu_args.in;
+      relu_args.num_elems = y_output->NumElements();
+
+      VEDeviceContext* vectx = context->op_device_context<VEDeviceContext>();
+      OP_REQUIRES_OK(context, vectx->Compute("Relu", (void*)&relu_args,
+                                             sizeof(relu_args)));
+    }
   }
 };
 
@@ -1871,6 +1893,61 @@ REGISTER_KERNEL_BUILDER(Name("FusedBatchNormGradV3")
                             .TypeConstraint<float>("U"),
                         FusedBatchNormGradOpV3<VEDevice, float, float>);
 
+// _FusedLayerNorm normalizes each innermost row of x in one VE kernel, in
+// place of the Mean, SquaredDifference, Rsqrt, Mul, Sub and Add nodes the
+// remapper fused.
+template <typename T>
+class FusedLayerNormOp : public VEOpKernel {
+ public:
+  explicit FusedLayerNormOp(OpKernelConstruction* context)
+      : VEOpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    const Tensor& gamma = context->input(1);
+    const Tensor& beta = context->input(2);
+    OP_REQUIRES(context, x.dims() >= 1,
+                errors::InvalidArgument("x must have >= 1 dimension, got ",
+                                        x.shape().DebugString()));
+    const int64 depth = x.dim_size(x.dims() - 1);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(gamma.shape()) &&
+                    gamma.NumElements() == depth,
+                errors::InvalidArgument("gamma must be a vector of size ",
+                                        depth, ", got ",
+                                        gamma.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(beta.shape()) &&
+                    beta.NumElements() == depth,
+                errors::InvalidArgument("beta must be a vector of size ",
+                                        depth, ", got ",
+                                        beta.shape().DebugString()));
+
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, x.shape(), &y));
+    if (y->NumElements() == 0) return;
+
+    ArgsImpl<> args;
+    args.addArg<Tensor>(x);                          // 0
+    args.addArg<Tensor>(gamma);                      // 1
+    args.addArg<Tensor>(beta);                       // 2
+    args.addArg<Tensor>(*y);                         // 3
+    args.addArg<T>(epsilon_);                        // 4
+    args.addArg<int64>(DataTypeToEnum<T>::value);    // 5
+
+    Call(context, "LayerNorm", args);
+  }
+
+ private:
+  T epsilon_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedLayerNorm").Device(DEVICE_VE).TypeConstraint<float>("T"),
+    FusedLayerNormOp<float>);
 
 #endif // TENSORFLOW_USE_VE
 
@@ -18,6 +18,12 @@ limitations under the License.
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
 
+#ifdef TENSORFLOW_USE_VE
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/ve/ve_device.h"
+#include "tensorflow/core/framework/ve_ops_common.h"
+#endif  // TENSORFLOW_USE_VE
+
 namespace tensorflow {
 
 Status InitializeFusedComputation(
@@ -85,4 +91,94 @@ Status InitializeFusedComputation(
   return Status::OK();
 }
 
+#ifdef TENSORFLOW_USE_VE
+Status LaunchVEFusedOutputKernels(OpKernelContext* context,
+                                  FusedComputationType fusion,
+                                  TensorFormat data_format, Tensor* output) {
+  if (fusion != FusedComputationType::kBiasAdd &&
+      fusion != FusedComputationType::kBiasAddWithRelu &&
+      fusion != FusedComputationType::kBiasAddWithRelu6 &&
+      fusion != FusedComputationType::kBiasAddWithElu) {
+    return errors::Unimplemented("Fusion is not implemented on VE");
+  }
+  if (output->NumElements() == 0) return Status::OK();
+
+  VEDeviceContext* vectx = context->op_device_context<VEDeviceContext>();
+
+  const Tensor& bias = context->input(2);
+  if (bias.dims() != 1)
+    return errors::InvalidArgument("bias must be 1-dimensional",
+                                   bias.shape().DebugString());
+
+  // Same argument layout as BiasOp<VEDevice, T>.
+  struct {
+    int dtype;
+    int data_format;
+    uint64_t in;
+    uint64_t bias;
+    uint64_t out;
+    int batch;
+    int width;
+    int height;
+    int channel;
+  } bias_args;
+
+  bias_args.dtype = output->dtype();
+  bias_args.data_format = data_format;
+  bias_args.in = (uint64_t)DMAHelper::base(output);
+  bias_args.bias = (uint64_t)DMAHelper::base(&bias);
+  bias_args.out = bias_args.in;
+  bias_args.batch = 1;
+  bias_args.width = 1;
+  bias_args.height = 1;
+  if (data_format == FORMAT_NHWC) {
+    const int channel_dim = output->dims() - 1;
+    bias_args.channel = static_cast<int>(output->dim_size(channel_dim));
+    for (int i = 0; i < channel_dim; ++i) {
+      bias_args.batch *= static_cast<int>(output->dim_size(i));
+    }
+  } else {
+    bias_args.batch = static_cast<int>(GetTensorDim(*output, data_format, 'N'));
+    bias_args.height = static_cast<int>(GetTensorDim(*output, data_format, 'H'));
+    bias_args.width = static_cast<int>(GetTensorDim(*output, data_format, 'W'));
+    bias_args.channel =
+        static_cast<int>(GetTensorDim(*output, data_format, 'C'));
+  }
+  if (bias.dim_size(0) != bias_args.channel)
+    return errors::InvalidArgument(
+        "Must provide as many biases as the channel dimension of the output "
+        "tensor: ",
+        bias.shape().DebugString(), " vs. ", output->shape().DebugString());
+
+  TF_RETURN_IF_ERROR(
+      vectx->Compute("BiasAdd", (void*)&bias_args, sizeof(bias_args)));
+
+  if (fusion == FusedComputationType::kBiasAddWithRelu) {
+    // Same argument layout as ReluOp<VEDevice, T>.
+    struct {
+      int dtype;
+      uint64_t in;
+      uint64_t out;
+      uint64_t num_elems;
+    } relu_args;
+
+    relu_args.dtype = output->dtype();
+    relu_args.in = (uint64_t)DMAHelper::base(output);
+    relu_args.out = relu_args.in;
+    relu_args.num_elems = output->NumElements();
+    return vectx->Compute("Relu", (void*)&relu_args, sizeof(relu_args));
+  }
+
+  if (fusion == FusedComputationType::kBiasAddWithRelu6 ||
+      fusion == FusedComputationType::kBiasAddWithElu) {
+    VEOpKernelHelper::ArgsImpl<> args(*output, *output);
+    return vectx->Compute(
+        fusion == FusedComputationType::kBiasAddWithRelu6 ? "Relu6" : "Elu",
+        args.buf(), args.size());
+  }
+
+  return Status::OK();
+}
+#endif  // TENSORFLOW_USE_VE
+
 }  // namespace tensorflow
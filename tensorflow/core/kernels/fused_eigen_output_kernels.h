@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/util/tensor_format.h"
 
 namespace tensorflow {
 
@@ -322,6 +323,16 @@ Status InitFusedBatchNormArgs(OpKernelContext* context, float epsilon,
   return Status::OK();
 }
 
+#ifdef TENSORFLOW_USE_VE
+// The VE kernel library has no fused contraction kernels. Instead the BiasAdd
+// and activation of `fusion` are applied in place to the contraction output,
+// which avoids allocating the intermediate tensors and the executor overhead of
+// separate nodes. The bias is read from input 2 as in `InitBiasAddArgs`.
+Status LaunchVEFusedOutputKernels(OpKernelContext* context,
+                                  FusedComputationType fusion,
+                                  TensorFormat data_format, Tensor* output);
+#endif  // TENSORFLOW_USE_VE
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
@@ -16,6 +16,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_GATHER_FUNCTOR_H_
 #define TENSORFLOW_CORE_KERNELS_GATHER_FUNCTOR_H_
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
 #include "tensorflow/core/framework/bounds_check.h"
@@ -38,6 +44,32 @@ typedef Eigen::GpuDevice GPUDevice;
 
 namespace functor {
 
+// Params rows are prefetched this many copies ahead of the copy, so that
+// random accesses into large tables overlap with the copies in flight.
+constexpr int kGatherPrefetchDistance = 8;
+
+// At most this many bytes of a params row are prefetched.
+constexpr size_t kGatherMaxPrefetchBytes = 1024;
+
+// Outputs of at least this many bytes are written with non-temporal stores,
+// because they do not fit into the last level cache anyway, and would only
+// evict the prefetched params rows.
+constexpr size_t kGatherNonTemporalMinBytes = 32 << 20;
+
+// Copies `bytes` bytes with non-temporal stores that bypass the caches.
+// REQUIRES: `dst` is aligned to 16 bytes and `bytes` is a multiple of 16.
+inline void NonTemporalCopy(void* dst, const void* src, size_t bytes) {
+#ifdef __SSE2__
+  __m128i* d = reinterpret_cast<__m128i*>(dst);
+  const __m128i* s = reinterpret_cast<const __m128i*>(src);
+  for (size_t i = 0; i < bytes / sizeof(__m128i); ++i) {
+    _mm_stream_si128(d + i, _mm_loadu_si128(s + i));
+  }
+#else
+  memcpy(dst, src, bytes);
+#endif
+}
+
 // Helper method to copy using memcpy.
 template <typename T, typename Index, typename SliceIndex,
           SliceIndex static_slice_elems>
@@ -57,6 +89,15 @@ SliceIndex HandleCopies(OpKernelContext* ctx,
   }
   // Compute slice_bytes here so that static knowledge is available
   const size_t slice_bytes = slice_elems * sizeof(T);
+  const size_t prefetch_bytes = std::min(slice_bytes, kGatherMaxPrefetchBytes);
+#ifdef __SSE2__
+  const bool non_temporal =
+      is_simple_type<T>::value && slice_bytes % 16 == 0 &&
+      reinterpret_cast<uintptr_t>(out_base) % 16 == 0 &&
+      batch_size * indices_size * slice_bytes >= kGatherNonTemporalMinBytes;
+#else
+  const bool non_temporal = false;
+#endif
   auto* worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
   mutex mu;
   // Store the value of invalidate index for printing error information, it's a
@@ -65,24 +106,33 @@ SliceIndex HandleCopies(OpKernelContext* ctx,
   auto work = [&](int64 start, int64 end) {
     SliceIndex batch_idx = static_cast<SliceIndex>(start / indices_size);
     SliceIndex indices_idx = static_cast<SliceIndex>(start % indices_size);
-    SliceIndex batch_idx_end = static_cast<SliceIndex>(end / indices_size);
-    SliceIndex indices_idx_end = static_cast<SliceIndex>(end % indices_size);
-
-    while ((batch_idx < batch_idx_end) ||
-           (batch_idx == batch_idx_end && indices_idx < indices_idx_end)) {
-      SliceIndex i_next = indices_idx + 1;
-      SliceIndex b_next = batch_idx + 1;
-      if ((batch_idx == batch_idx_end && i_next < indices_idx_end) ||
-          (i_next < indices_size)) {
-        port::prefetch<port::PREFETCH_HINT_T0>(
-            &params(batch_idx, indices(i_next), 0));
-        port::prefetch<port::PREFETCH_HINT_T0>(&out(batch_idx, i_next, 0));
-        b_next = batch_idx;
-      } else if (b_next <= batch_idx_end) {
-        port::prefetch<port::PREFETCH_HINT_T0>(&params(b_next, indices(0), 0));
-        port::prefetch<port::PREFETCH_HINT_T0>(&out(b_next, 0, 0));
-        i_next = 0;
+
+    // Prefetches the params row of the copy at `prefetch_pos`, and advances
+    // it. Indices are validated only before the copy, and prefetching an
+    // invalid address is harmless.
+    int64 prefetch_pos = start;
+    SliceIndex prefetch_batch_idx = batch_idx;
+    SliceIndex prefetch_indices_idx = indices_idx;
+    auto prefetch_next = [&]() {
+      if (prefetch_pos >= end) return;
+      const char* row = reinterpret_cast<const char*>(
+          params_base + (prefetch_batch_idx * static_cast<SliceIndex>(limit) +
+                         static_cast<SliceIndex>(
+                             indices(prefetch_indices_idx))) *
+                            slice_elems);
+      for (size_t offset = 0; offset < prefetch_bytes; offset += 64) {
+        port::prefetch<port::PREFETCH_HINT_T0>(row + offset);
       }
+      ++prefetch_pos;
+      if (++prefetch_indices_idx == indices_size) {
+        prefetch_indices_idx = 0;
+        ++prefetch_batch_idx;
+      }
+    };
+    for (int i = 0; i < kGatherPrefetchDistance; ++i) prefetch_next();
+
+    for (int64 pos = start; pos < end; ++pos) {
+      prefetch_next();
       const Index index = internal::SubtleMustCopy(indices(indices_idx));
       if (!FastBoundsCheck(index, limit)) {
         mutex_lock l(mu);
@@ -94,20 +144,31 @@ SliceIndex HandleCopies(OpKernelContext* ctx,
       // ahead-of-time compilation binary size).
       if (is_simple_type<T>::value) {
         // Avoid auto-promotion to Index from SliceIndex by casting.
-        memcpy(
-            out_base + (batch_idx * indices_size + indices_idx) * slice_elems,
+        T* dst =
+            out_base + (batch_idx * indices_size + indices_idx) * slice_elems;
+        const T* src =
             params_base + (batch_idx * static_cast<SliceIndex>(limit) +
                            static_cast<SliceIndex>(index)) *
-                              slice_elems,
-            slice_bytes);
+                              slice_elems;
+        if (non_temporal) {
+          NonTemporalCopy(dst, src, slice_bytes);
+        } else {
+          memcpy(dst, src, slice_bytes);
+        }
       } else {
         // For non-"simple" types (e.g. strings).
         out.template chip<0>(batch_idx).template chip<0>(indices_idx) =
             params.template chip<0>(batch_idx).template chip<0>(index);
       }
-      indices_idx = i_next;
-      batch_idx = b_next;
+      if (++indices_idx == indices_size) {
+        indices_idx = 0;
+        ++batch_idx;
+      }
     }
+#ifdef __SSE2__
+    // Make the non-temporal stores visible before the shard completes.
+    if (non_temporal) _mm_sfence();
+#endif
   };
 
   Shard(worker_threads->num_threads, worker_threads->workers,
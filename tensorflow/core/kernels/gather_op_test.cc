@@ -229,5 +229,48 @@ BM_GATHER(gpu, int32);
 BM_GATHER(cpu, int64);
 BM_GATHER(gpu, int64);
 
+// Gathers rows of `dim` floats from a table of `table_mb` megabytes, which is
+// well beyond the last level cache for the larger tables. The output of the
+// largest number of lookups is written with non-temporal stores.
+static Graph* GatherFromLargeTable(int table_mb, int dim, int lookups) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const int64 rows = ((static_cast<int64>(table_mb) << 20) / sizeof(float)) /
+                     dim;
+  Tensor params(DT_FLOAT, TensorShape({rows, dim}));
+  params.flat<float>().setRandom();
+
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  Tensor indices(DT_INT64, TensorShape({lookups}));
+  for (int i = 0; i < lookups; i++) {
+    indices.flat<int64>()(i) = rnd.Uniform64(rows);
+  }
+
+  Tensor axis(DT_INT64, TensorShape({}));
+  axis.scalar<int64>()() = 0;
+
+  test::graph::Gather(g, test::graph::Constant(g, params),
+                      test::graph::Constant(g, indices),
+                      test::graph::HostConstant(g, axis));
+  return g;
+}
+
+static void BM_cpu_gather_large_table(int iters, int table_mb, int dim) {
+  const int lookups = 256 * 1024;
+  const int64 tot = static_cast<int64>(iters) * lookups * dim;
+  testing::ItemsProcessed(tot);
+  testing::BytesProcessed(tot * sizeof(float));
+  testing::UseRealTime();
+  test::Benchmark("cpu", GatherFromLargeTable(table_mb, dim, lookups))
+      .Run(iters);
+}
+BENCHMARK(BM_cpu_gather_large_table)
+    ->ArgPair(16, 64)
+    ->ArgPair(256, 64)
+    ->ArgPair(2048, 64)
+    ->ArgPair(16, 256)
+    ->ArgPair(256, 256)
+    ->ArgPair(2048, 256);
+
 }  // namespace
 }  // namespace tensorflow
@@ -21,6 +21,11 @@ limitations under the License.
 
 #include "google/protobuf/any.pb.h"
 #include "absl/algorithm/container.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/types/optional.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logger.h"
 #include "tensorflow/core/protobuf/autotuning.pb.h"
 #include "tensorflow/core/protobuf/conv_autotuning.pb.h"
@@ -247,6 +252,182 @@ Status BestCudnnConvAlgorithm(absl::Span<const AutotuneResult> results,
   return Status::OK();
 }
 
+namespace {
+
+// Returns the value of TF_AUTOTUNE_CACHE_FILE, or "" if it is not set.
+const string& AutotuneCacheFile() {
+  static const string* file = [] {
+    const char* file_str = std::getenv("TF_AUTOTUNE_CACHE_FILE");
+    return new string(file_str != nullptr ? file_str : "");
+  }();
+  return *file;
+}
+
+// Names the GPUs of this process and the libraries autotuned configs depend
+// on, e.g. "Tesla V100-SXM2-16GB,10.1,dnn 7.6.5;Tesla V100-SXM2-16GB,...".
+const string& AutotuneDevicesKey() {
+  static const string* key = [] {
+    string* result = new string;
+#if GOOGLE_CUDA
+    auto platform_or =
+        se::MultiPlatformManager::PlatformWithId(se::cuda::kCudaPlatformId);
+#else
+    auto platform_or =
+        se::MultiPlatformManager::PlatformWithId(se::rocm::kROCmPlatformId);
+#endif
+    if (!platform_or.ok()) {
+      return result;
+    }
+    se::Platform* platform = platform_or.ValueOrDie();
+    for (int i = 0; i < platform->VisibleDeviceCount(); ++i) {
+      auto executor_or = platform->ExecutorForDevice(i);
+      if (!executor_or.ok()) {
+        continue;
+      }
+      se::StreamExecutor* executor = executor_or.ValueOrDie();
+      const se::DeviceDescription& desc = executor->GetDeviceDescription();
+      absl::StrAppend(result, result->empty() ? "" : ";", desc.name(), ",",
+                      desc.runtime_version());
+      if (auto* dnn = executor->AsDnn()) {
+        auto version_or = dnn->GetVersion();
+        if (version_or.ok()) {
+          const se::dnn::VersionInfo& version = version_or.ValueOrDie();
+          absl::StrAppend(result, ",dnn ", version.major_version(), ".",
+                          version.minor_version(), ".", version.patch());
+        }
+      }
+    }
+    return result;
+  }();
+  return *key;
+}
+
+bool AlgorithmDescFromString(absl::string_view s,
+                             absl::optional<se::dnn::AlgorithmDesc>* desc) {
+  if (s.empty()) {
+    *desc = absl::nullopt;
+    return true;
+  }
+  std::vector<absl::string_view> parts = absl::StrSplit(s, '/');
+  int64 algo_id;
+  int tensor_ops;
+  if (parts.size() != 2 || !absl::SimpleAtoi(parts[0], &algo_id) ||
+      !absl::SimpleAtoi(parts[1], &tensor_ops)) {
+    return false;
+  }
+  *desc = se::dnn::AlgorithmDesc(algo_id, tensor_ops != 0);
+  return true;
+}
+
+string AlgorithmDescToString(
+    const absl::optional<se::dnn::AlgorithmDesc>& desc) {
+  if (!desc.has_value()) {
+    return "";
+  }
+  return absl::StrCat(desc->algo_id(), "/", desc->tensor_ops_enabled());
+}
+
+}  // namespace
+
+std::vector<std::pair<string, string>> LoadAutotuneCache(
+    const string& map_name) {
+  std::vector<std::pair<string, string>> entries;
+  const string& file = AutotuneCacheFile();
+  if (file.empty() || !Env::Default()->FileExists(file).ok()) {
+    return entries;
+  }
+  string contents;
+  Status status = ReadFileToString(Env::Default(), file, &contents);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not read autotune cache " << file << ": "
+                 << status;
+    return entries;
+  }
+  const string& devices = AutotuneDevicesKey();
+  for (absl::string_view line : absl::StrSplit(contents, '\n')) {
+    std::vector<absl::string_view> fields = absl::StrSplit(line, '\t');
+    if (fields.size() == 4 && fields[0] == map_name && fields[1] == devices) {
+      entries.emplace_back(string(fields[2]), string(fields[3]));
+    }
+  }
+  return entries;
+}
+
+void AppendToAutotuneCache(const string& map_name, const string& params,
+                           const string& config) {
+  const string& file = AutotuneCacheFile();
+  if (file.empty()) {
+    return;
+  }
+  // Lines are short and written with a single append, so processes sharing
+  // the file do not interleave them in practice.
+  std::unique_ptr<WritableFile> writable;
+  Status status = Env::Default()->NewAppendableFile(file, &writable);
+  if (status.ok()) {
+    status = writable->Append(absl::StrCat(map_name, "\t",
+                                           AutotuneDevicesKey(), "\t", params,
+                                           "\t", config, "\n"));
+  }
+  if (status.ok()) {
+    status = writable->Close();
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not write autotune cache " << file << ": "
+                 << status;
+  }
+}
+
+bool AutotuneConfigToString(const se::dnn::AlgorithmConfig& config,
+                            string* result) {
+  *result = absl::StrCat(
+      AlgorithmDescToString(config.algorithm()), ",",
+      AlgorithmDescToString(config.algorithm_no_scratch()), ",",
+      config.scratch_size().has_value() ? absl::StrCat(*config.scratch_size())
+                                        : "");
+  return true;
+}
+
+bool AutotuneConfigFromString(absl::string_view s,
+                              se::dnn::AlgorithmConfig* config) {
+  std::vector<absl::string_view> fields = absl::StrSplit(s, ',');
+  absl::optional<se::dnn::AlgorithmDesc> algorithm, algorithm_no_scratch;
+  if (fields.size() != 3 || !AlgorithmDescFromString(fields[0], &algorithm) ||
+      !AlgorithmDescFromString(fields[1], &algorithm_no_scratch)) {
+    return false;
+  }
+  *config = se::dnn::AlgorithmConfig();
+  if (algorithm.has_value()) {
+    config->set_algorithm(*algorithm);
+  }
+  if (algorithm_no_scratch.has_value()) {
+    config->set_algorithm_no_scratch(*algorithm_no_scratch);
+  }
+  if (!fields[2].empty()) {
+    uint64 scratch_size;
+    if (!absl::SimpleAtoi(fields[2], &scratch_size)) {
+      return false;
+    }
+    config->set_scratch_size(scratch_size);
+  }
+  return true;
+}
+
+bool AutotuneConfigToString(const se::blas::AlgorithmConfig& config,
+                            string* result) {
+  *result = absl::StrCat(config.algorithm());
+  return true;
+}
+
+bool AutotuneConfigFromString(absl::string_view s,
+                              se::blas::AlgorithmConfig* config) {
+  se::blas::AlgorithmType algorithm;
+  if (!absl::SimpleAtoi(s, &algorithm)) {
+    return false;
+  }
+  config->set_algorithm(algorithm);
+  return true;
+}
+
 }  // namespace tensorflow
 
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -19,7 +19,11 @@ limitations under the License.
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -66,6 +70,48 @@ inline se::DeviceMemory<T> AsDeviceMemory(const T* cuda_memory, uint64 size) {
   return typed;
 }
 
+// The persistent autotune cache lets processes skip autotuning for parameters
+// an earlier process already tuned, and makes replicas sharing the cache pick
+// the same configs. It is a text file named by the TF_AUTOTUNE_CACHE_FILE
+// environment variable, with one accepted config per line:
+//
+//   <autotune map name> \t <devices> \t <parameters> \t <config>
+//
+// where <devices> names the GPU models and the CUDA and cuDNN versions of the
+// process, and <parameters> is Parameters::ToString().  Lines of other devices
+// are ignored; of duplicate lines, the last one wins.
+
+// Returns the entries of the persistent autotune cache for the autotune map
+// `map_name` and the GPUs of this process, as pairs of parameters and config
+// strings.  Returns nothing if TF_AUTOTUNE_CACHE_FILE is not set.
+std::vector<std::pair<string, string>> LoadAutotuneCache(
+    const string& map_name);
+
+// Appends an entry to the persistent autotune cache, if any.  Failures are
+// logged and ignored.
+void AppendToAutotuneCache(const string& map_name, const string& params,
+                           const string& config);
+
+// Converts autotune configs to and from the strings stored in the persistent
+// autotune cache.  Configs without an overload below are not persisted.
+bool AutotuneConfigToString(const se::dnn::AlgorithmConfig& config,
+                            string* result);
+bool AutotuneConfigFromString(absl::string_view s,
+                              se::dnn::AlgorithmConfig* config);
+bool AutotuneConfigToString(const se::blas::AlgorithmConfig& config,
+                            string* result);
+bool AutotuneConfigFromString(absl::string_view s,
+                              se::blas::AlgorithmConfig* config);
+
+template <typename Config>
+bool AutotuneConfigToString(const Config& config, string* result) {
+  return false;
+}
+template <typename Config>
+bool AutotuneConfigFromString(absl::string_view s, Config* config) {
+  return false;
+}
+
 // A helper class that looks up the best autotuned config from parameters.
 // Due to the noisy nature of autotune, especially with multiple devices, it
 // only accepts a config if its margin exceeds a threshold.
@@ -76,12 +122,26 @@ inline se::DeviceMemory<T> AsDeviceMemory(const T* cuda_memory, uint64 size) {
 // back and forth randomly, the expected number of experiments before autotune
 // settles is O(threshold ^ 2). So we recommend that number of warmup runs
 // for any benchmarks.
+//
+// Configs found in the persistent autotune cache are accepted right away, and
+// newly accepted configs are added to it.
 template <typename Parameters, typename Config>
 class AutoTuneMap {
  public:
   bool Find(const Parameters& params, Config* config) const {
     mutex_lock lock(mu_);
     auto iter = params_config_map_.find(params);
+    if (iter == params_config_map_.end() && !persisted_configs_.empty()) {
+      auto persisted = persisted_configs_.find(params.ToString());
+      if (persisted != persisted_configs_.end()) {
+        VLOG(1) << GetActionSummary("loads", params, persisted->second);
+        iter = params_config_map_
+                   .insert(std::make_pair(
+                       params, ValueType{persisted->second,
+                                         min_score_threshold_, 1}))
+                   .first;
+      }
+    }
     if (iter == params_config_map_.end() ||
         (iter->second.score < min_score_threshold_ &&
          iter->second.count <= max_autotune_count_)) {
@@ -91,58 +151,68 @@ class AutoTuneMap {
     return true;
   }
   void Insert(const Parameters& params, const Config& config) {
-    mutex_lock lock(mu_);
-    auto iter = params_config_map_.find(params);
-    int new_score = 0;
-    if (iter == params_config_map_.end()) {
-      // Create a new entry if params is new.
-      VLOG(1) << GetActionSummary("creates", params, config);
-      params_config_map_.insert(
-          std::make_pair(params, ValueType{config, 1, 1}));
-      new_score = 1;
-    } else if (iter->second.score < min_score_threshold_ &&
-               iter->second.count <= max_autotune_count_) {
-      DCHECK_GT(iter->second.score, 0);
-      if (iter->second.config != config) {
-        // If it is different from the current winner, demotes the winner.
-        VLOG(1) << GetActionSummary("demotes", params, config);
-        new_score = --iter->second.score;
-        ++iter->second.count;
-        if (new_score <= 0) {
-          VLOG(1) << GetActionSummary("erases", params, config);
-          params_config_map_.erase(iter);
-        }
-      } else {
-        // If it is the same as the current winner, promotes the winner.
-        VLOG(1) << GetActionSummary("promotes", params, config);
-        new_score = ++iter->second.score;
-        ++iter->second.count;
-      }
-    }
-    if (new_score >= min_score_threshold_) {
-      VLOG(1) << GetActionSummary("accepts", params, config);
-    } else if (autotune_global_count_ >= max_autotune_global_count_) {
-      // The autotuning exceeds the max iteration threshold and we accept the
-      // the winner if it exists in the map, otherwise we accept the current
-      // winner.
-      auto winner = params_config_map_.find(params);
-      if (winner == params_config_map_.end()) {
+    // Accepted configs are persisted after releasing mu_, so that lookups do
+    // not wait on the file system.
+    absl::optional<Config> accepted;
+    {
+      mutex_lock lock(mu_);
+      auto iter = params_config_map_.find(params);
+      int new_score = 0;
+      if (iter == params_config_map_.end()) {
+        // Create a new entry if params is new.
         VLOG(1) << GetActionSummary("creates", params, config);
-        for (int i = 0; i < min_score_threshold_; ++i) {
-          VLOG(1) << GetActionSummary("promotes", params, config);
-        }
         params_config_map_.insert(
-            std::make_pair(params, ValueType{config, min_score_threshold_, 1}));
-      } else {
-        int promotes_times = min_score_threshold_ - winner->second.score;
-        for (int i = 0; i < promotes_times; ++i) {
+            std::make_pair(params, ValueType{config, 1, 1}));
+        new_score = 1;
+      } else if (iter->second.score < min_score_threshold_ &&
+                 iter->second.count <= max_autotune_count_) {
+        DCHECK_GT(iter->second.score, 0);
+        if (iter->second.config != config) {
+          // If it is different from the current winner, demotes the winner.
+          VLOG(1) << GetActionSummary("demotes", params, config);
+          new_score = --iter->second.score;
+          ++iter->second.count;
+          if (new_score <= 0) {
+            VLOG(1) << GetActionSummary("erases", params, config);
+            params_config_map_.erase(iter);
+          }
+        } else {
+          // If it is the same as the current winner, promotes the winner.
           VLOG(1) << GetActionSummary("promotes", params, config);
+          new_score = ++iter->second.score;
+          ++iter->second.count;
+        }
+      }
+      if (new_score >= min_score_threshold_) {
+        VLOG(1) << GetActionSummary("accepts", params, config);
+        accepted = config;
+      } else if (autotune_global_count_ >= max_autotune_global_count_) {
+        // The autotuning exceeds the max iteration threshold and we accept the
+        // the winner if it exists in the map, otherwise we accept the current
+        // winner.
+        auto winner = params_config_map_.find(params);
+        if (winner == params_config_map_.end()) {
+          VLOG(1) << GetActionSummary("creates", params, config);
+          for (int i = 0; i < min_score_threshold_; ++i) {
+            VLOG(1) << GetActionSummary("promotes", params, config);
+          }
+          params_config_map_.insert(std::make_pair(
+              params, ValueType{config, min_score_threshold_, 1}));
+        } else {
+          int promotes_times = min_score_threshold_ - winner->second.score;
+          for (int i = 0; i < promotes_times; ++i) {
+            VLOG(1) << GetActionSummary("promotes", params, config);
+          }
+          winner->second.score = min_score_threshold_;
         }
-        winner->second.score = min_score_threshold_;
+        VLOG(1) << GetActionSummary("accepts", params, config);
+        accepted = params_config_map_.find(params)->second.config;
       }
-      VLOG(1) << GetActionSummary("accepts", params, config);
+      autotune_global_count_++;
+    }
+    if (accepted.has_value()) {
+      Persist(params, *accepted);
     }
-    autotune_global_count_++;
   }
 
  private:
@@ -163,6 +233,26 @@ class AutoTuneMap {
         5 * min_score_threshold_ * min_score_threshold_, min_warmup_iterations);
     max_autotune_global_count_ = 2 * max_autotune_count_;
     autotune_global_count_ = 0;
+
+    for (const auto& entry : LoadAutotuneCache(name_)) {
+      Config config;
+      if (AutotuneConfigFromString(entry.second, &config)) {
+        persisted_configs_[entry.first] = config;
+      } else {
+        LOG(WARNING) << "autotune_map " << name_
+                     << ": ignoring malformed cached config " << entry.second;
+      }
+    }
+    VLOG(1) << "autotune_map " << name_ << " loaded "
+            << persisted_configs_.size() << " cached configs";
+  }
+
+  // Adds an accepted config to the persistent autotune cache.
+  void Persist(const Parameters& params, const Config& config) {
+    string config_str;
+    if (AutotuneConfigToString(config, &config_str)) {
+      AppendToAutotuneCache(name_, params.ToString(), config_str);
+    }
   }
 
   template <class Group, class Params, class Cfg>
@@ -187,8 +277,11 @@ class AutoTuneMap {
     int32 score;
     int32 count;
   };
-  std::unordered_map<Parameters, ValueType, Hasher> params_config_map_
+  mutable std::unordered_map<Parameters, ValueType, Hasher> params_config_map_
       GUARDED_BY(mu_);
+  // Configs from the persistent autotune cache, keyed by
+  // Parameters::ToString().
+  std::unordered_map<string, Config> persisted_configs_;
   string name_;
   int32 min_score_threshold_;
   int32 max_autotune_count_;
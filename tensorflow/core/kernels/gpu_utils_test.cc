@@ -0,0 +1,187 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#include "tensorflow/core/kernels/gpu_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+const string& AutotuneCachePath() {
+  static const string* path = new string(
+      io::JoinPath(testing::TmpDir(), "gpu_utils_test_autotune_cache"));
+  return *path;
+}
+
+// The autotune cache file is read once per process, so it is set before any
+// test runs. Each test uses its own autotune map names.
+const bool kAutotuneCacheEnabled TF_ATTRIBUTE_UNUSED = [] {
+  remove(AutotuneCachePath().c_str());
+  setenv("TF_AUTOTUNE_CACHE_FILE", AutotuneCachePath().c_str(),
+         1 /* replace */);
+  return true;
+}();
+
+// Appends `lines` to the autotune cache file as they are.
+void AppendRawLines(const std::vector<string>& lines) {
+  string contents;
+  if (Env::Default()->FileExists(AutotuneCachePath()).ok()) {
+    TF_ASSERT_OK(
+        ReadFileToString(Env::Default(), AutotuneCachePath(), &contents));
+  }
+  for (const string& line : lines) {
+    absl::StrAppend(&contents, line, "\n");
+  }
+  TF_ASSERT_OK(
+      WriteStringToFile(Env::Default(), AutotuneCachePath(), contents));
+}
+
+// Returns the devices field that this process writes to the cache.
+string DevicesKey() {
+  AppendToAutotuneCache("devices_key_probe", "params", "config");
+  string contents;
+  TF_CHECK_OK(ReadFileToString(Env::Default(), AutotuneCachePath(), &contents));
+  for (absl::string_view line : absl::StrSplit(contents, '\n')) {
+    std::vector<string> fields = absl::StrSplit(line, '\t');
+    if (fields.size() == 4 && fields[0] == "devices_key_probe") {
+      return fields[1];
+    }
+  }
+  ADD_FAILURE() << "No devices_key_probe entry in " << contents;
+  return "";
+}
+
+void ExpectDnnRoundTrip(const se::dnn::AlgorithmConfig& config,
+                        const string& expected) {
+  string s;
+  ASSERT_TRUE(AutotuneConfigToString(config, &s));
+  EXPECT_EQ(s, expected);
+  se::dnn::AlgorithmConfig parsed(se::dnn::AlgorithmDesc(99, true), 99);
+  ASSERT_TRUE(AutotuneConfigFromString(s, &parsed));
+  EXPECT_TRUE(parsed == config) << parsed.ToString() << " vs "
+                                << config.ToString();
+}
+
+TEST(AutotuneConfigTest, DnnRoundTrip) {
+  ExpectDnnRoundTrip(se::dnn::AlgorithmConfig(), ",,");
+  ExpectDnnRoundTrip(
+      se::dnn::AlgorithmConfig(se::dnn::AlgorithmDesc(5, true), 1024),
+      "5/1,,1024");
+  ExpectDnnRoundTrip(
+      se::dnn::AlgorithmConfig(se::dnn::AlgorithmDesc(5, true),
+                               se::dnn::AlgorithmDesc(2, false)),
+      "5/1,2/0,");
+}
+
+TEST(AutotuneConfigTest, DnnMalformed) {
+  for (const char* s : {"", "5/1", "5/1,2/0", "5/1,2/0,1024,", "x/1,,",
+                        "5,,", "5/1/0,,", "5/1,,-1", "5/1,,1k"}) {
+    se::dnn::AlgorithmConfig config;
+    EXPECT_FALSE(AutotuneConfigFromString(s, &config)) << s;
+  }
+}
+
+TEST(AutotuneConfigTest, BlasRoundTrip) {
+  for (se::blas::AlgorithmType algorithm : {se::blas::AlgorithmType{0},
+                                            se::blas::AlgorithmType{7},
+                                            se::blas::kNoAlgorithm}) {
+    string s;
+    ASSERT_TRUE(
+        AutotuneConfigToString(se::blas::AlgorithmConfig(algorithm), &s));
+    EXPECT_EQ(s, absl::StrCat(algorithm));
+    se::blas::AlgorithmConfig parsed;
+    ASSERT_TRUE(AutotuneConfigFromString(s, &parsed));
+    EXPECT_EQ(parsed.algorithm(), algorithm);
+  }
+}
+
+TEST(AutotuneConfigTest, BlasMalformed) {
+  for (const char* s : {"", "x", "1.5", "7,"}) {
+    se::blas::AlgorithmConfig config;
+    EXPECT_FALSE(AutotuneConfigFromString(s, &config)) << s;
+  }
+}
+
+TEST(AutotuneCacheTest, LoadSkipsOtherAndMalformedLines) {
+  const string devices = DevicesKey();
+  AppendToAutotuneCache("load_map", "p1", "c1");
+  AppendRawLines({
+      "",
+      "garbage",
+      "load_map\tother devices\tp2\tc2",
+      absl::StrCat("other_map\t", devices, "\tp3\tc3"),
+      absl::StrCat("load_map\t", devices, "\tp4"),
+      absl::StrCat("load_map\t", devices, "\tp5\tc5\textra"),
+  });
+  AppendToAutotuneCache("load_map", "p1", "c1b");
+
+  std::vector<std::pair<string, string>> expected = {{"p1", "c1"},
+                                                     {"p1", "c1b"}};
+  EXPECT_EQ(LoadAutotuneCache("load_map"), expected);
+}
+
+struct TestParameters {
+  int64 id;
+
+  string ToString() const { return absl::StrCat("id ", id); }
+  uint64 hash() const { return id; }
+  bool operator==(const TestParameters& other) const {
+    return id == other.id;
+  }
+};
+
+struct TestAutotuneGroup {
+  static string name() { return "gpu_utils_test_map"; }
+};
+
+TEST(AutotuneCacheTest, AutoTuneMapLoadsAndPersists) {
+  AppendToAutotuneCache(TestAutotuneGroup::name(), "id 1", "7");
+  AppendToAutotuneCache(TestAutotuneGroup::name(), "id 2", "not a config");
+  auto* map = AutoTuneSingleton<TestAutotuneGroup, TestParameters,
+                                se::blas::AlgorithmConfig>::GetInstance();
+
+  se::blas::AlgorithmConfig config;
+  ASSERT_TRUE(map->Find({1}, &config));
+  EXPECT_EQ(config.algorithm(), 7);
+  EXPECT_FALSE(map->Find({2}, &config));
+  EXPECT_FALSE(map->Find({3}, &config));
+
+  // With the default threshold, the first config inserted is accepted.
+  map->Insert({3}, se::blas::AlgorithmConfig(9));
+  ASSERT_TRUE(map->Find({3}, &config));
+  EXPECT_EQ(config.algorithm(), 9);
+  std::vector<std::pair<string, string>> expected = {
+      {"id 1", "7"}, {"id 2", "not a config"}, {"id 3", "9"}};
+  EXPECT_EQ(LoadAutotuneCache(TestAutotuneGroup::name()), expected);
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -16,16 +16,20 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <array>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace lookup {
@@ -152,8 +156,33 @@ class MutableHashTableOfScalars final : public LookupInterface {
   std::unordered_map<K, V> table_ GUARDED_BY(mu_);
 };
 
+namespace {
+
+template <typename T>
+inline uint64 HashScalar(const T& key) {
+  return static_cast<uint64>(key);
+}
+
+inline uint64 HashScalar(const tstring& key) { return Hash64(key); }
+
+// If the given shape is a scalar return {1} instead. Otherwise leave it alone.
+TensorShape MaybeVectorizeShape(const TensorShape& shape) {
+  if (shape.dims() == 0) {
+    return TensorShape({1});
+  }
+  return shape;
+}
+
+}  // namespace
+
 // Lookup table that wraps an unordered_map. Behaves identical to
 // MutableHashTableOfScalars except that each value must be a vector.
+//
+// The table is striped over kNumShards maps, each guarded by its own mutex,
+// so that concurrent lookups and inserts of different keys rarely contend on
+// the same lock. Batches of keys are grouped by shard, so that every shard is
+// locked once per batch, and large batches of lookups are parallelized.
+// Inserts of a batch are atomic per shard, not across the whole batch.
 template <class K, class V>
 class MutableHashTableOfTensors final : public LookupInterface {
  public:
@@ -167,8 +196,12 @@ class MutableHashTableOfTensors final : public LookupInterface {
   }
 
   size_t size() const override {
-    tf_shared_lock l(mu_);
-    return table_.size();
+    size_t ret = 0;
+    for (const TableShard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      ret += shard.table.size();
+    }
+    return ret;
   }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
@@ -178,19 +211,35 @@ class MutableHashTableOfTensors final : public LookupInterface {
     auto value_values = value->flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
 
-    tf_shared_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      ValueArray* value_vec =
-          gtl::FindOrNull(table_, SubtleMustCopyIfIntegral(key_values(i)));
-      if (value_vec != nullptr) {
-        for (int64 j = 0; j < value_dim; j++) {
-          value_values(i, j) = value_vec->at(j);
-        }
-      } else {
-        for (int64 j = 0; j < value_dim; j++) {
-          value_values(i, j) = default_flat(j);
+    auto find_range = [&](int64 begin, int64 end) {
+      const auto keys_by_shard = GroupKeysByShard(key_values, begin, end);
+      for (int s = 0; s < kNumShards; ++s) {
+        if (keys_by_shard[s].empty()) continue;
+        const TableShard& shard = shards_[s];
+        tf_shared_lock l(shard.mu);
+        for (int64 i : keys_by_shard[s]) {
+          const ValueArray* value_vec = gtl::FindOrNull(
+              shard.table, SubtleMustCopyIfIntegral(key_values(i)));
+          if (value_vec != nullptr) {
+            for (int64 j = 0; j < value_dim; j++) {
+              value_values(i, j) = value_vec->at(j);
+            }
+          } else {
+            for (int64 j = 0; j < value_dim; j++) {
+              value_values(i, j) = default_flat(j);
+            }
+          }
         }
       }
+    };
+
+    if (ctx == nullptr) {
+      find_range(0, key_values.size());
+    } else {
+      auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+      const int64 cost_per_key = 100 + 2 * value_dim * sizeof(V);
+      Shard(worker_threads.num_threads, worker_threads.workers,
+            key_values.size(), cost_per_key, find_range);
     }
 
     return Status::OK();
@@ -199,20 +248,26 @@ class MutableHashTableOfTensors final : public LookupInterface {
   Status DoInsert(bool clear, const Tensor& keys, const Tensor& values) {
     const auto key_values = keys.flat<K>();
     const auto value_values = values.flat_inner_dims<V, 2>();
-    int64 value_dim = value_shape_.dim_size(0);
 
-    mutex_lock l(mu_);
+    const auto keys_by_shard =
+        GroupKeysByShard(key_values, 0, key_values.size());
     if (clear) {
-      table_.clear();
-    }
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      ValueArray value_vec;
-      for (int64 j = 0; j < value_dim; j++) {
-        V value = value_values(i, j);
-        value_vec.push_back(value);
+      // Replace the contents of all shards at once, locking them in order.
+      for (TableShard& shard : shards_) shard.mu.lock();
+      for (int s = 0; s < kNumShards; ++s) {
+        shards_[s].table.clear();
+        InsertIntoShard(keys_by_shard[s], key_values, value_values,
+                        &shards_[s]);
       }
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
-                          value_vec);
+      for (TableShard& shard : shards_) shard.mu.unlock();
+      return Status::OK();
+    }
+
+    for (int s = 0; s < kNumShards; ++s) {
+      if (keys_by_shard[s].empty()) continue;
+      mutex_lock l(shards_[s].mu);
+      InsertIntoShard(keys_by_shard[s], key_values, value_values,
+                      &shards_[s]);
     }
     return Status::OK();
   }
@@ -225,9 +280,14 @@ class MutableHashTableOfTensors final : public LookupInterface {
   Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
     const auto key_values = keys.flat<K>();
 
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      table_.erase(SubtleMustCopyIfIntegral(key_values(i)));
+    const auto keys_by_shard =
+        GroupKeysByShard(key_values, 0, key_values.size());
+    for (int s = 0; s < kNumShards; ++s) {
+      if (keys_by_shard[s].empty()) continue;
+      mutex_lock l(shards_[s].mu);
+      for (int64 i : keys_by_shard[s]) {
+        shards_[s].table.erase(SubtleMustCopyIfIntegral(key_values(i)));
+      }
     }
     return Status::OK();
   }
@@ -238,8 +298,14 @@ class MutableHashTableOfTensors final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    tf_shared_lock l(mu_);
-    int64 size = table_.size();
+    // Export a consistent snapshot of all shards, locking them in order.
+    for (TableShard& shard : shards_) shard.mu.lock_shared();
+    auto unlock = gtl::MakeCleanup([this] {
+      for (TableShard& shard : shards_) shard.mu.unlock_shared();
+    });
+
+    int64 size = 0;
+    for (const TableShard& shard : shards_) size += shard.table.size();
     int64 value_dim = value_shape_.dim_size(0);
 
     Tensor* keys;
@@ -252,12 +318,14 @@ class MutableHashTableOfTensors final : public LookupInterface {
     auto keys_data = keys->flat<K>();
     auto values_data = values->matrix<V>();
     int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      K key = it->first;
-      ValueArray value = it->second;
-      keys_data(i) = key;
-      for (int64 j = 0; j < value_dim; j++) {
-        values_data(i, j) = value[j];
+    for (const TableShard& shard : shards_) {
+      for (auto it = shard.table.begin(); it != shard.table.end(); ++it, ++i) {
+        K key = it->first;
+        const ValueArray& value = it->second;
+        keys_data(i) = key;
+        for (int64 j = 0; j < value_dim; j++) {
+          values_data(i, j) = value[j];
+        }
       }
     }
     return Status::OK();
@@ -273,43 +341,67 @@ class MutableHashTableOfTensors final : public LookupInterface {
 
   int64 MemoryUsed() const override {
     int64 ret = 0;
-    tf_shared_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
+    for (const TableShard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      for (unsigned i = 0; i < shard.table.bucket_count(); ++i) {
+        size_t bucket_size = shard.table.bucket_size(i);
+        if (bucket_size == 0) {
+          ret++;
+        } else {
+          ret += bucket_size;
+        }
       }
     }
     return sizeof(MutableHashTableOfTensors) + ret;
   }
 
  private:
-  TensorShape value_shape_;
-  mutable mutex mu_;
+  static constexpr int kNumShards = 32;
+
   typedef gtl::InlinedVector<V, 4> ValueArray;
-  std::unordered_map<K, ValueArray> table_ GUARDED_BY(mu_);
-};
 
-namespace {
+  struct TableShard {
+    mutable mutex mu;
+    std::unordered_map<K, ValueArray> table GUARDED_BY(mu);
+  };
 
-template <typename T>
-inline uint64 HashScalar(const T& key) {
-  return static_cast<uint64>(key);
-}
+  static int ShardOf(const K& key) {
+    // Fibonacci hashing takes the shard from the high bits of the hash, which
+    // are well mixed even for the identity hash of integers.
+    return (HashScalar(key) * 0x9E3779B97F4A7C15ULL) >> 59;
+  }
 
-inline uint64 HashScalar(const tstring& key) { return Hash64(key); }
+  void InsertIntoShard(const std::vector<int64>& positions,
+                       typename TTypes<K>::ConstFlat key_values,
+                       typename TTypes<V>::ConstMatrix value_values,
+                       TableShard* shard) EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    const int64 value_dim = value_shape_.dim_size(0);
+    for (int64 i : positions) {
+      ValueArray value_vec;
+      for (int64 j = 0; j < value_dim; j++) {
+        V value = value_values(i, j);
+        value_vec.push_back(value);
+      }
+      gtl::InsertOrUpdate(&shard->table,
+                          SubtleMustCopyIfIntegral(key_values(i)), value_vec);
+    }
+  }
 
-// If the given shape is a scalar return {1} instead. Otherwise leave it alone.
-TensorShape MaybeVectorizeShape(const TensorShape& shape) {
-  if (shape.dims() == 0) {
-    return TensorShape({1});
+  // Returns the positions in [begin, end) of the keys of every shard, in
+  // increasing order.
+  static std::array<std::vector<int64>, kNumShards> GroupKeysByShard(
+      typename TTypes<K>::ConstFlat key_values, int64 begin, int64 end) {
+    std::array<std::vector<int64>, kNumShards> keys_by_shard;
+    for (int64 i = begin; i < end; ++i) {
+      keys_by_shard[ShardOf(SubtleMustCopyIfIntegral(key_values(i)))]
+          .push_back(i);
+    }
+    return keys_by_shard;
   }
-  return shape;
-}
 
-}  // namespace
+  TensorShape value_shape_;
+  std::array<TableShard, kNumShards> shards_;
+};
 
 // Modeled after densehashtable in https://github.com/sparsehash/sparsehash
 template <class K, class V>
@@ -406,47 +498,64 @@ class MutableDenseHashTable final : public LookupInterface {
     const auto deleted_key_matrix =
         deleted_key_.AccessTensor(ctx)->template shaped<K, 2>({1, key_size});
     const int64 bit_mask = num_buckets_ - 1;
-    // TODO(andreasst): parallelize using work_sharder
-    for (int64 i = 0; i < num_elements; ++i) {
-      const uint64 key_hash = HashKey(key_matrix, i);
-      if (empty_key_hash_ == key_hash &&
-          IsEqualKey(empty_key_matrix, 0, key_matrix, i)) {
-        return errors::InvalidArgument(
-            "Using the empty_key as a table key is not allowed");
-      }
-      if (deleted_key_hash_ == key_hash &&
-          IsEqualKey(deleted_key_matrix, 0, key_matrix, i)) {
-        return errors::InvalidArgument(
-            "Using the deleted_key as a table key is not allowed");
-      }
-      int64 bucket_index = key_hash & bit_mask;
-      int64 num_probes = 0;
-      while (true) {
-        if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i)) {
-          for (int64 j = 0; j < value_size; ++j) {
-            // TODO(andreasst): check if we can get rid of SubtleMustCopy
-            // here and elsewhere in this file.
-            value_matrix(i, j) =
-                SubtleMustCopyIfIntegral(value_buckets_matrix(bucket_index, j));
-          }
-          break;
+    // Lookups only read the buckets, so they run in parallel over the keys
+    // while the shared lock is held.
+    Status status;
+    mutex status_mu;
+    auto set_status = [&](const Status& s) {
+      mutex_lock status_lock(status_mu);
+      status.Update(s);
+    };
+    auto find_range = [&](int64 begin, int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        const uint64 key_hash = HashKey(key_matrix, i);
+        if (empty_key_hash_ == key_hash &&
+            IsEqualKey(empty_key_matrix, 0, key_matrix, i)) {
+          set_status(errors::InvalidArgument(
+              "Using the empty_key as a table key is not allowed"));
+          return;
         }
-        if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_matrix, 0)) {
-          for (int64 j = 0; j < value_size; ++j) {
-            value_matrix(i, j) = SubtleMustCopyIfIntegral(default_flat(j));
-          }
-          break;
+        if (deleted_key_hash_ == key_hash &&
+            IsEqualKey(deleted_key_matrix, 0, key_matrix, i)) {
+          set_status(errors::InvalidArgument(
+              "Using the deleted_key as a table key is not allowed"));
+          return;
         }
-        ++num_probes;
-        bucket_index =
-            (bucket_index + num_probes) & bit_mask;  // quadratic probing
-        if (num_probes >= num_buckets_) {
-          return errors::Internal(
-              "Internal error in MutableDenseHashTable lookup");
+        int64 bucket_index = key_hash & bit_mask;
+        int64 num_probes = 0;
+        while (true) {
+          if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i)) {
+            for (int64 j = 0; j < value_size; ++j) {
+              // TODO(andreasst): check if we can get rid of SubtleMustCopy
+              // here and elsewhere in this file.
+              value_matrix(i, j) = SubtleMustCopyIfIntegral(
+                  value_buckets_matrix(bucket_index, j));
+            }
+            break;
+          }
+          if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_matrix,
+                         0)) {
+            for (int64 j = 0; j < value_size; ++j) {
+              value_matrix(i, j) = SubtleMustCopyIfIntegral(default_flat(j));
+            }
+            break;
+          }
+          ++num_probes;
+          bucket_index =
+              (bucket_index + num_probes) & bit_mask;  // quadratic probing
+          if (num_probes >= num_buckets_) {
+            set_status(errors::Internal(
+                "Internal error in MutableDenseHashTable lookup"));
+            return;
+          }
         }
       }
-    }
-    return Status::OK();
+    };
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    const int64 cost_per_key = 20 * (key_size + value_size) + 100;
+    Shard(worker_threads.num_threads, worker_threads.workers, num_elements,
+          cost_per_key, find_range);
+    return status;
   }
 
   Status Insert(OpKernelContext* ctx, const Tensor& key,
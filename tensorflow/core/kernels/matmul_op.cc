@@ -35,6 +35,7 @@ limitations under the License.
 #ifdef TENSORFLOW_USE_VE
 #include "tensorflow/core/common_runtime/ve/ve_device.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/kernels/fused_eigen_output_kernels.h"
 #endif
 
 namespace tensorflow {
@@ -667,12 +668,7 @@ class VEMatMulOp : public OpKernel {
         // If a has shape [x, 0] and b has shape [0, y], the
         // output shape is [x, y] where x and y are non-zero, so we fill
         // the output with zeros.
-#if 0
-        functor::SetZeroFunctor<Device, T> f;
-        f(ctx->eigen_device<Device>(), out->flat<T>());
-#endif
-        ctx->SetStatus(errors::Unimplemented(
-                "MatMul to fill zero is not supported on VE"));
+        functor::VESetZeroFunctor<T>(ctx, out);
         return;
       }
 
@@ -716,11 +712,47 @@ class VEMatMulOp : public OpKernel {
     bool transpose_b_;
 };
 
+// _FusedMatMul on VE runs MatMul and then applies BiasAdd and the activation in
+// place on its output.
+template <typename T>
+class VEFusedMatMulOp : public VEMatMulOp<T> {
+  public:
+    explicit VEFusedMatMulOp(OpKernelConstruction* ctx) : VEMatMulOp<T>(ctx) {
+      using FCT = FusedComputationType;
+      const std::vector<FusedComputationPattern> patterns = {
+          {FCT::kBiasAdd, {"BiasAdd"}},
+          {FCT::kBiasAddWithRelu, {"BiasAdd", "Relu"}},
+          {FCT::kBiasAddWithRelu6, {"BiasAdd", "Relu6"}},
+          {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}},
+      };
+      OP_REQUIRES_OK(ctx, InitializeFusedComputation(
+                              ctx, "MatMul", patterns, &fused_computation_,
+                              &fused_computation_args_));
+    }
+
+    void Compute(OpKernelContext* ctx) override {
+      VEMatMulOp<T>::Compute(ctx);
+      if (!ctx->status().ok() || ctx->mutable_output(0)->NumElements() == 0)
+        return;
+      OP_REQUIRES_OK(ctx, LaunchVEFusedOutputKernels(ctx, fused_computation_,
+                                                     FORMAT_NHWC,
+                                                     ctx->mutable_output(0)));
+    }
+
+  private:
+    FusedComputationType fused_computation_ = FusedComputationType::kUndefined;
+    FusedComputationArgs fused_computation_args_;
+};
+
 #define REGISTER_VE(T)                                         \
   REGISTER_KERNEL_BUILDER(Name("MatMul")                         \
                               .Device(DEVICE_VE)               \
                               .TypeConstraint<T>("T"),            \
-                          VEMatMulOp<T>)
+                          VEMatMulOp<T>);                        \
+  REGISTER_KERNEL_BUILDER(Name("_FusedMatMul")                   \
+                              .Device(DEVICE_VE)               \
+                              .TypeConstraint<T>("T"),            \
+                          VEFusedMatMulOp<T>)
 
 TF_CALL_float(REGISTER_VE);
 // TF_CALL_double(REGISTER_VE);
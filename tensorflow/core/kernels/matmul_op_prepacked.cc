@@ -0,0 +1,230 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements matmul with a constant right hand side (e.g. weights of a frozen
+// inference graph). Eigen tensor contraction packs the right hand side into
+// panels on every invocation, which dominates the matmul time for small left
+// hand sides. This kernel packs the weights once, on the first invocation, and
+// reuses the packed panels for all following invocations.
+//
+// Larger left hand sides are computed by the Eigen tensor contraction, where
+// packing cost is amortized over many rows.
+//
+// Currently supported only on CPU device.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Number of output columns in a single packed panel of the right hand side.
+constexpr int64 kPanelSize = 8;
+
+// Left hand sides with more rows than this are computed by Eigen.
+constexpr int64 kMaxPrepackedRows = 16;
+
+}  // namespace
+
+template <typename Device, typename T>
+class PrepackedMatMulOp : public OpKernel {
+ public:
+  explicit PrepackedMatMulOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_a", &transpose_a_));
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_b", &transpose_b_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& a = ctx->input(0);
+    const Tensor& b = ctx->input(1);
+
+    // Check that the dimensions of the two matrices are valid.
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsMatrix(a.shape()),
+        errors::InvalidArgument("In[0] is not a matrix. Instead it has shape ",
+                                a.shape().DebugString()));
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsMatrix(b.shape()),
+        errors::InvalidArgument("In[1] is not a matrix. Instead it has shape ",
+                                b.shape().DebugString()));
+    Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> dim_pair;
+    dim_pair[0].first = transpose_a_ ? 0 : 1;
+    dim_pair[0].second = transpose_b_ ? 1 : 0;
+
+    OP_REQUIRES(
+        ctx, a.dim_size(dim_pair[0].first) == b.dim_size(dim_pair[0].second),
+        errors::InvalidArgument(
+            "Matrix size-incompatible: In[0]: ", a.shape().DebugString(),
+            ", In[1]: ", b.shape().DebugString()));
+    int a_dim_remaining = 1 - dim_pair[0].first;
+    int b_dim_remaining = 1 - dim_pair[0].second;
+    TensorShape out_shape(
+        {a.dim_size(a_dim_remaining), b.dim_size(b_dim_remaining)});
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, out_shape, &out));
+
+    if (out->NumElements() == 0) {
+      // If a has shape [0, x] or b has shape [x, 0], the output shape
+      // is a 0-element matrix, so there is nothing to do.
+      return;
+    }
+
+    if (a.NumElements() == 0 && b.NumElements() == 0) {
+      // If a has shape [x, 0] and b has shape [0, y], the
+      // output shape is [x, y] where x and y are non-zero, so we fill
+      // the output with zeros.
+      functor::SetZeroFunctor<Device, T> f;
+      f(ctx->eigen_device<Device>(), out->flat<T>());
+      return;
+    }
+
+    const int64 m = out->dim_size(0);
+    if (m > kMaxPrepackedRows) {
+      auto& d = ctx->eigen_device<Device>();
+      out->matrix<T>().device(d) =
+          a.matrix<T>().contract(b.matrix<T>(), dim_pair);
+      return;
+    }
+
+    // Copy of the packed tensor shares the buffer, so it stays valid even if
+    // a concurrent invocation replaces the cached panels.
+    Tensor packed;
+    {
+      mutex_lock l(mu_);
+      if (packed_source_ != b.tensor_data().data()) {
+        OP_REQUIRES_OK(ctx, PackRhs(ctx, b));
+      }
+      packed = packed_;
+    }
+
+    ComputeWithPackedRhs(ctx, a, packed, out);
+  }
+
+ private:
+  // Packs the right hand side into [k, kPanelSize] panels, one per block of
+  // kPanelSize output columns, padding the last panel with zeros.
+  Status PackRhs(OpKernelContext* ctx, const Tensor& b)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const int64 k = b.dim_size(transpose_b_ ? 1 : 0);
+    const int64 n = b.dim_size(transpose_b_ ? 0 : 1);
+    const int64 num_panels = (n + kPanelSize - 1) / kPanelSize;
+
+    Tensor packed;
+    TensorShape packed_shape({num_panels * k * kPanelSize});
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(DataTypeToEnum<T>::value, packed_shape, &packed));
+
+    auto rhs = b.matrix<T>();
+    T* dst = packed.flat<T>().data();
+    for (int64 panel = 0; panel < num_panels; ++panel) {
+      for (int64 depth = 0; depth < k; ++depth) {
+        for (int64 j = 0; j < kPanelSize; ++j) {
+          const int64 col = panel * kPanelSize + j;
+          if (col >= n) {
+            *dst++ = T(0);
+          } else {
+            *dst++ = transpose_b_ ? rhs(col, depth) : rhs(depth, col);
+          }
+        }
+      }
+    }
+
+    VLOG(2) << "Packed right hand side of " << name() << ": "
+            << b.shape().DebugString();
+    packed_ = packed;
+    packed_source_ = b.tensor_data().data();
+    return Status::OK();
+  }
+
+  void ComputeWithPackedRhs(OpKernelContext* ctx, const Tensor& a,
+                            const Tensor& packed, Tensor* out) {
+    const int64 m = out->dim_size(0);
+    const int64 n = out->dim_size(1);
+    const int64 k = a.dim_size(transpose_a_ ? 0 : 1);
+    const int64 num_panels = (n + kPanelSize - 1) / kPanelSize;
+
+    const T* lhs = a.flat<T>().data();
+    const T* rhs = packed.flat<T>().data();
+    T* dst = out->flat<T>().data();
+
+    // Offsets between consecutive rows and depths of the left hand side.
+    const int64 row_stride = transpose_a_ ? 1 : k;
+    const int64 depth_stride = transpose_a_ ? m : 1;
+
+    auto compute_panels = [&](int64 begin, int64 end) {
+      for (int64 panel = begin; panel < end; ++panel) {
+        const T* panel_data = rhs + panel * k * kPanelSize;
+        const int64 col = panel * kPanelSize;
+        const int64 num_cols = std::min(kPanelSize, n - col);
+
+        for (int64 row = 0; row < m; ++row) {
+          T acc[kPanelSize];
+          std::fill(acc, acc + kPanelSize, T(0));
+
+          const T* lhs_row = lhs + row * row_stride;
+          for (int64 depth = 0; depth < k; ++depth) {
+            const T lhs_value = lhs_row[depth * depth_stride];
+            const T* rhs_values = panel_data + depth * kPanelSize;
+            for (int64 j = 0; j < kPanelSize; ++j) {
+              acc[j] += lhs_value * rhs_values[j];
+            }
+          }
+
+          std::copy(acc, acc + num_cols, dst + row * n + col);
+        }
+      }
+    };
+
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    const int64 cost_per_panel = 2 * m * k * kPanelSize;
+    Shard(worker_threads.num_threads, worker_threads.workers, num_panels,
+          cost_per_panel, compute_panels);
+  }
+
+  bool transpose_a_;
+  bool transpose_b_;
+
+  mutex mu_;
+  // Right hand side packed into panels, and the buffer it was packed from.
+  Tensor packed_ GUARDED_BY(mu_);
+  const char* packed_source_ GUARDED_BY(mu_) = nullptr;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PrepackedMatMulOp);
+};
+
+// Registration of the CPU implementations.
+#define REGISTER_PREPACKED_CPU_MATMUL(T)                                  \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("_PrepackedMatMul").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      PrepackedMatMulOp<CPUDevice, T>);
+
+TF_CALL_float(REGISTER_PREPACKED_CPU_MATMUL);
+
+#undef REGISTER_PREPACKED_CPU_MATMUL
+
+}  // namespace tensorflow
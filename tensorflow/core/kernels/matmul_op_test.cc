@@ -16,6 +16,7 @@ limitations under the License.
 #include "absl/algorithm/container.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
@@ -337,6 +338,63 @@ using FusedBiasAddDataTypes = ::testing::Types<float>;
 INSTANTIATE_TYPED_TEST_SUITE_P(Test, FusedMatMulWithBiasOpTest,
                                FusedBiasAddDataTypes);
 
+class PrepackedMatMulOpTest : public OpsTestBase {
+ protected:
+  // Runs _PrepackedMatMul twice with the same right hand side and different
+  // left hand sides, and compares both results with the Eigen contraction.
+  void VerifyPrepackedMatMul(int m, int k, int n, bool transpose_a,
+                             bool transpose_b) {
+    TF_EXPECT_OK(NodeDefBuilder("prepacked_matmul", "_PrepackedMatMul")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("transpose_a", transpose_a)
+                     .Attr("transpose_b", transpose_b)
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+
+    Tensor* lhs = AddInput(DT_FLOAT, transpose_a ? TensorShape({k, m})
+                                                 : TensorShape({m, k}));
+    Tensor* rhs = AddInput(DT_FLOAT, transpose_b ? TensorShape({n, k})
+                                                 : TensorShape({k, n}));
+    rhs->flat<float>().setRandom();
+
+    Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> dim_pair;
+    dim_pair[0].first = transpose_a ? 0 : 1;
+    dim_pair[0].second = transpose_b ? 1 : 0;
+
+    for (int run = 0; run < 2; ++run) {
+      lhs->flat<float>().setRandom();
+      TF_ASSERT_OK(RunOpKernel());
+
+      Tensor expected(DT_FLOAT, TensorShape({m, n}));
+      expected.matrix<float>() =
+          lhs->matrix<float>().contract(rhs->matrix<float>(), dim_pair);
+      test::ExpectClose(expected, *GetOutput(0), /*atol=*/1e-5);
+    }
+  }
+};
+
+TEST_F(PrepackedMatMulOpTest, MatMul1x256x256) {
+  VerifyPrepackedMatMul(1, 256, 256, false, false);
+}
+
+TEST_F(PrepackedMatMulOpTest, MatMul8x256x100) {
+  VerifyPrepackedMatMul(8, 256, 100, false, false);
+}
+
+TEST_F(PrepackedMatMulOpTest, MatMul8x256x100Transposed) {
+  VerifyPrepackedMatMul(8, 256, 100, true, true);
+}
+
+TEST_F(PrepackedMatMulOpTest, MatMul3x17x5TransposeB) {
+  VerifyPrepackedMatMul(3, 17, 5, false, true);
+}
+
+// Left hand side is too large for packed panels and is computed by Eigen.
+TEST_F(PrepackedMatMulOpTest, MatMul64x128x64) {
+  VerifyPrepackedMatMul(64, 128, 64, false, false);
+}
+
 //----------------------------------------------------------------------------//
 // Performance benchmarks are below.                                          //
 //----------------------------------------------------------------------------//
@@ -315,10 +315,19 @@ class VEReductionOp : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->MatchSignature({dt, pt}, {dt}));
 
     OP_REQUIRES_OK(ctx, ctx->GetAttr("keep_dims", &keep_dims_));
+
+    kernel_ = LookupVEKernel(ctx->device(), name_);
+    OP_REQUIRES(ctx, kernel_ != 0,
+                errors::Internal("VE kernel not found for ", name_));
   }
 
   void Compute(OpKernelContext* ctx) override {
-    const Tensor& data = ctx->input(0);
+    ComputeReduction(ctx, ctx->input(0));
+  }
+
+ protected:
+  // Reduces `data` along the axes given by input(1) and sets output(0).
+  void ComputeReduction(OpKernelContext* ctx, const Tensor& data) {
     const Tensor& axes = ctx->input(1);
     VLOG(1) << "data shape: " << data.shape().DebugString();
     VLOG(1) << "axes      : " << axes.SummarizeValue(10);
@@ -390,7 +399,7 @@ class VEReductionOp : public OpKernel {
       args.axis = 1;
 
       VEDeviceContext* vectx = ctx->op_device_context<VEDeviceContext>();
-      Status s = vectx->Compute(name_, (void*)&args, sizeof(args));
+      Status s = vectx->Compute(kernel_, (void*)&args, sizeof(args));
       if (!s.ok())
         ctx->SetStatus(s);
 #endif
@@ -417,7 +426,7 @@ class VEReductionOp : public OpKernel {
       args.axis = helper.reduce_first_axis() ? 0 : 1;
 
       VEDeviceContext* vectx = ctx->op_device_context<VEDeviceContext>();
-      Status s = vectx->Compute(name_, (void*)&args, sizeof(args));
+      Status s = vectx->Compute(kernel_, (void*)&args, sizeof(args));
       if (!s.ok())
         ctx->SetStatus(s);
 #endif
@@ -445,7 +454,7 @@ class VEReductionOp : public OpKernel {
       args.axis = helper.reduce_first_axis() ? 0 : 1;
 
       VEDeviceContext* vectx = ctx->op_device_context<VEDeviceContext>();
-      Status s = vectx->Compute(name_, (void*)&args, sizeof(args));
+      Status s = vectx->Compute(kernel_, (void*)&args, sizeof(args));
       if (!s.ok())
         ctx->SetStatus(s);
 #endif
@@ -493,7 +502,7 @@ class VEReductionOp : public OpKernel {
       args.axis = 1 ;
 
       VEDeviceContext* vectx = ctx->op_device_context<VEDeviceContext>();
-      Status s = vectx->Compute(name_, (void*)&args, sizeof(args));
+      Status s = vectx->Compute(kernel_, (void*)&args, sizeof(args));
       if (!s.ok())
         ctx->SetStatus(s);
 #endif
@@ -512,10 +521,81 @@ class VEReductionOp : public OpKernel {
 
  private:
   std::string name_;
+  uint64_t kernel_;
   // True if the number of dimensions should be maintained.
   bool keep_dims_;
 };
 
+// Runs an elementwise VE unary kernel (e.g. "Square", "Sqrt") from `in` to
+// `out`. `in` and `out` may be the same tensor.
+inline Status VEUnaryCompute(OpKernelContext* ctx, uint64_t kernel,
+                             const Tensor& in, Tensor* out) {
+  struct _Tensor {
+    int32_t dtype;
+    uint64_t addr;
+    int32_t dims;
+    int64_t nelems;
+    int64_t dim_size[8];
+  } __attribute__((__packed__));
+
+  struct {
+    _Tensor in;
+    _Tensor out;
+  } __attribute__((__packed__)) args;
+
+  args.in.dtype = in.dtype();
+  args.in.addr = (uint64_t)DMAHelper::base(&in);
+  args.in.dims = 0;  // doesn't use dims, so initialize it by 0
+  args.in.nelems = in.NumElements();
+  args.out.dtype = args.in.dtype;
+  args.out.addr = (uint64_t)DMAHelper::base(out);
+  args.out.dims = 0;
+  args.out.nelems = args.in.nelems;
+
+  VEDeviceContext* vectx = ctx->op_device_context<VEDeviceContext>();
+  return vectx->Compute(kernel, (void*)&args, sizeof(args));
+}
+
+// EuclideanNorm has no VE kernel of its own. It is computed as
+// sqrt(sum(x * x)) with the VE Square, Sum and Sqrt kernels.
+template <typename T, typename Tperm>
+class VEEuclideanNormOp : public VEReductionOp<T, Tperm> {
+ public:
+  explicit VEEuclideanNormOp(OpKernelConstruction* ctx)
+      : VEReductionOp<T, Tperm>(ctx, "Sum") {
+    square_kernel_ = LookupVEKernel(ctx->device(), "Square");
+    OP_REQUIRES(ctx, square_kernel_ != 0,
+                errors::Internal("VE kernel not found for Square"));
+    sqrt_kernel_ = LookupVEKernel(ctx->device(), "Sqrt");
+    OP_REQUIRES(ctx, sqrt_kernel_ != 0,
+                errors::Internal("VE kernel not found for Sqrt"));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& data = ctx->input(0);
+
+    Tensor squared;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(data.dtype(), data.shape(),
+                                           &squared,
+                                           ctx->output_alloc_attr(0)));
+    if (data.NumElements() > 0) {
+      OP_REQUIRES_OK(ctx, VEUnaryCompute(ctx, square_kernel_, data, &squared));
+    }
+
+    this->ComputeReduction(ctx, squared);
+    if (!ctx->status().ok()) return;
+
+    Tensor* out = ctx->mutable_output(0);
+    if (out->NumElements() > 0) {
+      OP_REQUIRES_OK(ctx, VEUnaryCompute(ctx, sqrt_kernel_, *out, out));
+    }
+  }
+
+ private:
+  uint64_t square_kernel_;
+  uint64_t sqrt_kernel_;
+};
+
 #define DEFINE_VE_REDUCTION_OP(Name) \
 template <typename T, typename Tperm> \
 class VE##Name##Op : public VEReductionOp<T,Tperm> { \
@@ -80,4 +80,22 @@ REGISTER_SYCL_KERNELS(double);
 #undef REGISTER_SYCL_KERNELS
 #endif  // TENSORFLOW_USE_SYCL
 
+#ifdef TENSORFLOW_USE_VE
+#define REGISTER_VE_KERNELS(type)                                  \
+  REGISTER_KERNEL_BUILDER(Name("EuclideanNorm")                    \
+                              .Device(DEVICE_VE)                   \
+                              .TypeConstraint<type>("T")           \
+                              .TypeConstraint<int32>("Tidx")       \
+                              .HostMemory("reduction_indices"),    \
+                          VEEuclideanNormOp<type, int32>);         \
+  REGISTER_KERNEL_BUILDER(Name("EuclideanNorm")                    \
+                              .Device(DEVICE_VE)                   \
+                              .TypeConstraint<type>("T")           \
+                              .TypeConstraint<int64>("Tidx")       \
+                              .HostMemory("reduction_indices"),    \
+                          VEEuclideanNormOp<type, int64>);
+REGISTER_VE_KERNELS(float);
+#undef REGISTER_VE_KERNELS
+#endif  // TENSORFLOW_USE_VE
+
 }  // namespace tensorflow
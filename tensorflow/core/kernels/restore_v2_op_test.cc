@@ -30,7 +30,9 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -353,5 +355,54 @@ TEST_F(RestoreV2OpTest, RestoreAfterSaveV2) { RunTest("SaveV2"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveSlicesV1) { RunTest("SaveSlices"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveV1) { RunTest("Save"); }
 
+// Restores tensors from several data files, which are read concurrently.
+TEST_F(RestoreV2OpTest, RestoreFromShards) {
+  const int kNumShards = 3;
+  const int kTensorsPerShard = 4;
+  const string merged_prefix =
+      io::JoinPath(testing::TmpDir(), "tensor_shards-merged");
+  std::vector<tstring> shard_prefixes;
+  std::vector<string> tensor_names;
+  for (int shard = 0; shard < kNumShards; ++shard) {
+    shard_prefixes.push_back(io::JoinPath(
+        testing::TmpDir(), strings::StrCat("tensor_shards-", shard)));
+    BundleWriter writer(Env::Default(), shard_prefixes.back());
+    for (int t = 0; t < kTensorsPerShard; ++t) {
+      const int id = shard * kTensorsPerShard + t;
+      tensor_names.push_back(strings::StrCat("tensor_", id));
+      TF_ASSERT_OK(writer.Add(
+          tensor_names.back(),
+          MakeInput<int32>(TensorShape({id + 1}),
+                           [id](int x) -> int32 { return id * 100 + x; })));
+    }
+    TF_ASSERT_OK(writer.Finish());
+  }
+  TF_ASSERT_OK(MergeBundles(Env::Default(), shard_prefixes, merged_prefix));
+
+  const int num_tensors = tensor_names.size();
+  TF_ASSERT_OK(NodeDefBuilder("myop", "RestoreV2")
+                   .Input(FakeInput())  // prefix
+                   .Input(FakeInput())  // tensor_names
+                   .Input(FakeInput())  // shape_and_slices
+                   .Attr("dtypes", DataTypeVector(num_tensors, DT_INT32))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInput<tstring>(TensorShape({}), [&merged_prefix](int x) -> tstring {
+    return merged_prefix;
+  });
+  AddInput<tstring>(TensorShape({num_tensors}),
+                    [&](int x) -> tstring { return tensor_names[x]; });
+  AddInput<tstring>(TensorShape({num_tensors}),
+                    [](int x) -> tstring { return ""; });
+  TF_ASSERT_OK(RunOpKernel());
+  for (int id = 0; id < num_tensors; ++id) {
+    Tensor* output = GetOutput(id);
+    ASSERT_EQ(id + 1, output->NumElements());
+    for (int i = 0; i <= id; ++i) {
+      EXPECT_EQ(id * 100 + i, output->flat<int32>()(i));
+    }
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -14,22 +14,31 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include <algorithm>
+#include <map>
 #include <numeric>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/cache.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -234,17 +243,112 @@ void RestoreTensor(OpKernelContext* context,
 
 namespace {
 
-// Tensors larger than this threshold will be restored from a thread-pool.
+// Tensors larger than this threshold are restored by a task of their own.
 const int64 kLargeShapeThreshold = 16 << 20;  // 16M
 
-// A restore operation for a single tensor.  Small tensors may be restored
-// directly from the op thread to improve read locality.  Large tensors can be
-// restored from a thread pool: this requires creating a separate BundleReader
-// for each restore.
+// Returns the options of the readers of RestoreV2.  With TF_RESTORE_USE_MMAP,
+// local data files are memory-mapped and suitably aligned full tensors are
+// restored as read-only tensors aliasing the mapping, so that large models are
+// neither copied nor resident twice while loading, and share the page cache
+// across processes.  TF_RESTORE_VERIFY_MMAP_CHECKSUMS=false additionally skips
+// checksumming them, so that their pages are only read in when used.
+// Returns the block cache shared by the metadata tables of all the readers of
+// RestoreV2, with a capacity of TF_RESTORE_METADATA_CACHE_SIZE bytes.  Null if
+// the capacity is 0.
+table::Cache* RestoreMetadataBlockCache() {
+  static table::Cache* cache = []() -> table::Cache* {
+    int64 capacity;
+    Status s = ReadInt64FromEnvVar("TF_RESTORE_METADATA_CACHE_SIZE",
+                                   /*default_val=*/32 << 20, &capacity);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to read TF_RESTORE_METADATA_CACHE_SIZE: " << s;
+      capacity = 32 << 20;
+    }
+    return capacity > 0 ? table::NewLRUCache(capacity) : nullptr;
+  }();
+  return cache;
+}
+
+BundleReader::Options RestoreReaderOptions() {
+  static const BundleReader::Options options = [] {
+    BundleReader::Options options;
+    Status s = ReadBoolFromEnvVar("TF_RESTORE_USE_MMAP",
+                                  /*default_val=*/false, &options.use_mmap);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to read TF_RESTORE_USE_MMAP: " << s;
+      options.use_mmap = false;
+    }
+    s = ReadBoolFromEnvVar("TF_RESTORE_VERIFY_MMAP_CHECKSUMS",
+                           /*default_val=*/true,
+                           &options.verify_mmap_checksums);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to read TF_RESTORE_VERIFY_MMAP_CHECKSUMS: " << s;
+      options.verify_mmap_checksums = true;
+    }
+    options.metadata_block_cache = RestoreMetadataBlockCache();
+    return options;
+  }();
+  return options;
+}
+
+// Returns the number of threads RestoreV2 reads tensors with, from
+// TF_RESTORE_V2_NUM_THREADS.  With 1, all tensors are read from the op thread.
+int64 RestoreNumThreads() {
+  static const int64 num_threads = [] {
+    int64 num_threads;
+    Status s = ReadInt64FromEnvVar("TF_RESTORE_V2_NUM_THREADS",
+                                   /*default_val=*/8, &num_threads);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to read TF_RESTORE_V2_NUM_THREADS: " << s;
+      num_threads = 8;
+    }
+    return std::max<int64>(num_threads, 1);
+  }();
+  return num_threads;
+}
+
+// Returns the size of the chunks RestoreV2 stages the bytes of a tensor in on
+// their way to device memory, from TF_RESTORE_V2_STAGING_CHUNK_SIZE.
+int64 RestoreStagingChunkSize() {
+  static const int64 chunk_size = [] {
+    int64 chunk_size;
+    Status s = ReadInt64FromEnvVar("TF_RESTORE_V2_STAGING_CHUNK_SIZE",
+                                   /*default_val=*/8 << 20, &chunk_size);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to read TF_RESTORE_V2_STAGING_CHUNK_SIZE: " << s;
+      chunk_size = 8 << 20;
+    }
+    return std::max<int64>(chunk_size, 1);
+  }();
+  return chunk_size;
+}
+
+// Host buffers in DMA-able memory that the bytes of tensors restored to a
+// device are staged in: a chunk is read from the data file into one buffer
+// while the previous chunk is copied to the device from the other.  Reused by
+// all the tensors restored by a thread.
+struct HostStaging {
+  // Makes both buffers hold at least "size" bytes.
+  Status Reserve(OpKernelContext* context, int64 size) {
+    AllocatorAttributes host_attr;
+    host_attr.set_on_host(true);
+    host_attr.set_gpu_compatible(true);
+    for (Tensor& buffer : buffers) {
+      if (buffer.IsInitialized() && buffer.NumElements() >= size) continue;
+      TF_RETURN_IF_ERROR(context->allocate_temp(DT_INT8, TensorShape({size}),
+                                                &buffer, host_attr));
+    }
+    return Status::OK();
+  }
+
+  Tensor buffers[2];
+};
+
+// A restore operation for a single tensor.
 struct RestoreOp {
   RestoreOp& operator=(const RestoreOp&) = delete;
 
-  bool should_run_in_pool(BundleReader* reader) const {
+  bool is_large(BundleReader* reader) const {
     TensorShape restored_full_shape;
 
     // Ignore status here; we'll catch the error later.
@@ -255,18 +359,15 @@ struct RestoreOp {
     return restored_full_shape.num_elements() > kLargeShapeThreshold;
   }
 
-  // Run this restore operation using a new BundleReader.
-  void run_with_new_reader() {
-    BundleReader reader(Env::Default(), reader_prefix);
-    if (!reader.status().ok()) {
-      status = reader.status();
-      return;
-    }
-
-    status = run(&reader);
+  // Whether the output is in the memory of a device other than the CPU, to
+  // which the restored bytes must be copied.
+  bool on_device() const {
+    return context->op_device_context() != nullptr &&
+           context->output_memory_type(idx) == DEVICE_MEMORY &&
+           context->device()->attributes().device_type() != DEVICE_CPU;
   }
 
-  Status run(BundleReader* reader) {
+  Status run(BundleReader* reader, HostStaging* staging) {
     TensorShape restored_full_shape;
     TF_RETURN_IF_ERROR(
         reader->LookupTensorShape(tensor_name, &restored_full_shape));
@@ -274,7 +375,16 @@ struct RestoreOp {
     VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name << " : "
             << restored_full_shape.num_elements();
     Tensor* restored_tensor;
-    if (shape_and_slice.empty()) {
+    if (shape_and_slice.empty() && on_device()) {
+      TF_RETURN_IF_ERROR(
+          context->allocate_output(idx, restored_full_shape, &restored_tensor));
+      TF_RETURN_IF_ERROR(RestoreToDevice(reader, staging, restored_tensor));
+    } else if (shape_and_slice.empty() && RestoreReaderOptions().use_mmap) {
+      // Let the reader return a tensor aliasing its mapped data file.
+      Tensor restored;
+      TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, &restored));
+      context->set_output(idx, restored);
+    } else if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, restored_full_shape, &restored_tensor));
@@ -298,21 +408,168 @@ struct RestoreOp {
       }
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, parsed_slice_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(
-          reader->LookupSlice(tensor_name, parsed_slice, restored_tensor));
+      if (on_device()) {
+        Tensor host_tensor;
+        TF_RETURN_IF_ERROR(AllocateHostTensor(
+            restored_tensor->dtype(), parsed_slice_shape, &host_tensor));
+        TF_RETURN_IF_ERROR(
+            reader->LookupSlice(tensor_name, parsed_slice, &host_tensor));
+        TF_RETURN_IF_ERROR(CopyToDevice(host_tensor, restored_tensor));
+      } else {
+        TF_RETURN_IF_ERROR(
+            reader->LookupSlice(tensor_name, parsed_slice, restored_tensor));
+      }
+    }
+    return Status::OK();
+  }
+
+  // Restores the full tensor into "device_tensor" in device memory.  Streams
+  // the bytes of the tensor from the data file in chunks through the staging
+  // buffers, so that reading a chunk overlaps with copying the previous one
+  // and no host copy of the whole tensor is made.  Falls back to restoring
+  // the tensor on the host and copying it as a whole for tensors that cannot
+  // be streamed, e.g. from bundles of a different endianness.
+  Status RestoreToDevice(BundleReader* reader, HostStaging* staging,
+                         Tensor* device_tensor) {
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(reader->GetBundleEntryProto(tensor_name, &entry));
+    if (DataTypeCanUseMemcpy(entry.dtype()) && entry.slices_size() == 0) {
+      Status s = StreamToDevice(reader, entry, staging, device_tensor);
+      if (!errors::IsUnimplemented(s)) return s;
+      VLOG(1) << "Not streaming tensor " << tensor_name << ": " << s;
+    }
+    Tensor host_tensor;
+    TF_RETURN_IF_ERROR(AllocateHostTensor(device_tensor->dtype(),
+                                          device_tensor->shape(),
+                                          &host_tensor));
+    TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, &host_tensor));
+    return CopyToDevice(host_tensor, device_tensor);
+  }
+
+  Status StreamToDevice(BundleReader* reader, const BundleEntryProto& entry,
+                        HostStaging* staging, Tensor* device_tensor) {
+    const int64 total_bytes = device_tensor->TotalBytes();
+    if (entry.size() != total_bytes) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", tensor_name,
+                              "; stored size ", entry.size(),
+                              "; expected size ", total_bytes);
+    }
+    if (total_bytes == 0) return Status::OK();
+
+    const int64 chunk_size =
+        std::min<int64>(RestoreStagingChunkSize(), total_bytes);
+    TF_RETURN_IF_ERROR(staging->Reserve(context, chunk_size));
+    Tensor device_bytes;
+    TF_RETURN_IF_ERROR(device_bytes.BitcastFrom(*device_tensor, DT_INT8,
+                                                TensorShape({total_bytes})));
+
+    // A copy to the device in flight, from one of the staging buffers.
+    struct ChunkCopy {
+      Tensor host;
+      Tensor device;
+      Status status;
+      Notification done;
+    };
+    std::unique_ptr<ChunkCopy> copies[2];
+    Device* device = static_cast<Device*>(context->device());
+    uint32 actual_crc32c = 0;
+    Status status;
+    for (int64 offset = 0, i = 0; offset < total_bytes;
+         offset += chunk_size, ++i) {
+      const int64 size = std::min(chunk_size, total_bytes - offset);
+      std::unique_ptr<ChunkCopy>& copy = copies[i % 2];
+      if (copy != nullptr) {
+        // Waits until the staging buffer is free again.
+        copy->done.WaitForNotification();
+        status = copy->status;
+        copy.reset();
+        if (!status.ok()) break;
+      }
+      Tensor host_chunk = staging->buffers[i % 2].Slice(0, size);
+      char* data = const_cast<char*>(host_chunk.tensor_data().data());
+      status = reader->ReadTensorBytes(entry, offset, size, data);
+      if (!status.ok()) break;
+      actual_crc32c = crc32c::Extend(actual_crc32c, data, size);
+
+      copy.reset(new ChunkCopy);
+      copy->host = host_chunk;
+      copy->device = device_bytes.Slice(offset, offset + size);
+      ChunkCopy* pending = copy.get();
+      context->op_device_context()->CopyCPUTensorToDevice(
+          &pending->host, device, &pending->device,
+          [pending](const Status& s) {
+            pending->status = s;
+            pending->done.Notify();
+          });
+    }
+    // The staging buffers must not be reused before the copies are done.
+    for (auto& copy : copies) {
+      if (copy == nullptr) continue;
+      copy->done.WaitForNotification();
+      status.Update(copy->status);
+    }
+    TF_RETURN_IF_ERROR(status);
+    if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+      return errors::DataLoss(
+          "Checksum does not match: stored ", crc32c::Unmask(entry.crc32c()),
+          " vs. calculated on the restored bytes ", actual_crc32c);
     }
     return Status::OK();
   }
 
+  Status AllocateHostTensor(DataType dtype, const TensorShape& shape,
+                            Tensor* host_tensor) {
+    AllocatorAttributes host_attr;
+    host_attr.set_on_host(true);
+    host_attr.set_gpu_compatible(true);
+    return context->allocate_temp(dtype, shape, host_tensor, host_attr);
+  }
+
+  Status CopyToDevice(const Tensor& host_tensor, Tensor* device_tensor) {
+    Notification done;
+    Status status;
+    context->op_device_context()->CopyCPUTensorToDevice(
+        &host_tensor, static_cast<Device*>(context->device()), device_tensor,
+        [&done, &status](const Status& s) {
+          status = s;
+          done.Notify();
+        });
+    done.WaitForNotification();
+    return status;
+  }
+
   OpKernelContext* context;
   size_t idx;
   string tensor_name;
   string shape_and_slice;
   string reader_prefix;
 
+  // Location of the tensor's bytes, for ordering the reads of a data file.
+  int32 shard_id = 0;
+  int64 offset = 0;
+  int64 size = 0;
+
   ::tensorflow::Status status;
 };
 
+// A group of restore operations run in order by one thread of the pool, with
+// a BundleReader of its own.
+struct RestoreTask {
+  void run() {
+    BundleReader reader(Env::Default(), ops[0]->reader_prefix,
+                        RestoreReaderOptions());
+    HostStaging staging;
+    for (RestoreOp* op : ops) {
+      op->status =
+          reader.status().ok() ? op->run(&reader, &staging) : reader.status();
+      if (!op->status.ok()) break;
+    }
+  }
+
+  std::vector<RestoreOp*> ops;
+  int64 size = 0;
+};
+
 }  // namespace
 
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
@@ -332,10 +589,8 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
               return tensor_names_flat(a) < tensor_names_flat(b);
             });
 
-  std::vector<std::unique_ptr<RestoreOp> > pool_restore_ops;
-  std::vector<std::unique_ptr<RestoreOp> > direct_restore_ops;
-
-  BundleReader default_reader(Env::Default(), prefix_string);
+  BundleReader default_reader(Env::Default(), prefix_string,
+                              RestoreReaderOptions());
   TF_RETURN_IF_ERROR(default_reader.status());
 
   std::vector<string> mismatched_errors;
@@ -358,39 +613,74 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     return errors::InvalidArgument(error_msg);
   }
 
+  // Groups the restore operations into tasks: each large tensor is read by a
+  // task of its own, and the other tensors of each data file by one task in
+  // file order, so that they share a reader and the read-ahead of the file.
+  std::vector<std::unique_ptr<RestoreOp> > restore_ops;
+  std::vector<RestoreTask> tasks;
+  std::map<int32, RestoreTask> small_tasks_by_shard;
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
     auto op =
         new RestoreOp{context, i, tensor_name, shape_and_slice, prefix_string};
-    if (op->should_run_in_pool(&default_reader)) {
-      pool_restore_ops.emplace_back(op);
+    restore_ops.emplace_back(op);
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(default_reader.GetBundleEntryProto(tensor_name, &entry));
+    op->shard_id = entry.shard_id();
+    op->offset = entry.offset();
+    op->size = entry.size();
+    RestoreTask* task;
+    if (op->is_large(&default_reader)) {
+      tasks.emplace_back();
+      task = &tasks.back();
     } else {
-      direct_restore_ops.emplace_back(op);
+      task = &small_tasks_by_shard[op->shard_id];
     }
+    task->ops.push_back(op);
+    task->size += op->size;
+  }
+  for (auto& shard_and_task : small_tasks_by_shard) {
+    RestoreTask& task = shard_and_task.second;
+    std::sort(task.ops.begin(), task.ops.end(),
+              [](const RestoreOp* a, const RestoreOp* b) {
+                return a->offset < b->offset;
+              });
+    tasks.push_back(std::move(task));
   }
 
-  {
-    // Schedule any threaded operations first, skipping thread pool creation if
-    // we don't have any expensive operations.
-    std::unique_ptr<thread::ThreadPool> reader_pool;
-    if (!pool_restore_ops.empty()) {
-      reader_pool.reset(
-          new thread::ThreadPool(Env::Default(), "restore_tensors", 8));
-      for (auto& op : pool_restore_ops) {
-        reader_pool->Schedule([&op]() { op->run_with_new_reader(); });
+  const int64 num_threads =
+      std::min<int64>(RestoreNumThreads(), static_cast<int64>(tasks.size()));
+  if (num_threads <= 1) {
+    HostStaging staging;
+    for (const RestoreTask& task : tasks) {
+      for (RestoreOp* op : task.ops) {
+        TF_RETURN_IF_ERROR(op->run(&default_reader, &staging));
       }
     }
-
-    // Read small tensors from the op thread
-    for (auto& op : direct_restore_ops) {
-      TF_RETURN_IF_ERROR(op->run(&default_reader));
+  } else {
+    // Schedules the largest tasks first, so that they do not end up last.
+    std::sort(tasks.begin(), tasks.end(),
+              [](const RestoreTask& a, const RestoreTask& b) {
+                return a.size > b.size;
+              });
+    {
+      thread::ThreadPool reader_pool(Env::Default(), "restore_tensors",
+                                     num_threads);
+      for (RestoreTask& task : tasks) {
+        reader_pool.Schedule([&task]() { task.run(); });
+      }
+    }
+    // Check status of the ops; this must come after the pool shuts down.
+    for (auto& op : restore_ops) {
+      TF_RETURN_IF_ERROR(op->status);
     }
   }
 
-  // Check status of pool ops; this must come after the pool shuts down.
-  for (auto& op : pool_restore_ops) {
-    TF_RETURN_IF_ERROR(op->status);
+  if (VLOG_IS_ON(1) && RestoreMetadataBlockCache() != nullptr) {
+    const table::Cache::Stats stats = RestoreMetadataBlockCache()->GetStats();
+    VLOG(1) << "Metadata block cache: " << stats.hits << " hits, "
+            << stats.misses << " misses, hit rate " << stats.HitRate();
   }
 
   for (auto i : sorted_name_idx) {
@@ -406,4 +696,71 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   return Status::OK();
 }
 
+namespace {
+
+// The background checkpoint writes of this process.
+struct CheckpointWrites {
+  mutex mu;
+  condition_variable cv;
+  // Prefixes being written, with the step that started each write.
+  std::unordered_map<string, int64> in_progress GUARDED_BY(mu);
+  // Errors of failed writes that were not waited for yet.
+  std::unordered_map<string, Status> failed GUARDED_BY(mu);
+};
+
+CheckpointWrites* GetCheckpointWrites() {
+  static CheckpointWrites* writes = new CheckpointWrites;
+  return writes;
+}
+
+}  // namespace
+
+void StartCheckpointWrite(const string& prefix, int64 step_id,
+                          std::function<Status()> write) {
+  CheckpointWrites* writes = GetCheckpointWrites();
+  {
+    mutex_lock l(writes->mu);
+    auto must_back_off = [writes, &prefix, step_id]() {
+      for (const auto& p : writes->in_progress) {
+        if (p.first == prefix || p.second != step_id) return true;
+      }
+      return false;
+    };
+    while (must_back_off()) {
+      writes->cv.wait(l);
+    }
+    writes->in_progress[prefix] = step_id;
+    writes->failed.erase(prefix);
+  }
+  Env::Default()->SchedClosure([writes, prefix, write]() {
+    Status s = write();
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to write checkpoint " << prefix << ": " << s;
+    }
+    mutex_lock l(writes->mu);
+    writes->in_progress.erase(prefix);
+    if (!s.ok()) writes->failed[prefix] = s;
+    writes->cv.notify_all();
+  });
+}
+
+bool CheckpointWritesInProgress() {
+  CheckpointWrites* writes = GetCheckpointWrites();
+  mutex_lock l(writes->mu);
+  return !writes->in_progress.empty();
+}
+
+Status WaitForCheckpointWrite(const string& prefix) {
+  CheckpointWrites* writes = GetCheckpointWrites();
+  mutex_lock l(writes->mu);
+  while (writes->in_progress.count(prefix) > 0) {
+    writes->cv.wait(l);
+  }
+  auto it = writes->failed.find(prefix);
+  if (it == writes->failed.end()) return Status::OK();
+  Status s = it->second;
+  writes->failed.erase(it);
+  return s;
+}
+
 }  // namespace tensorflow
@@ -16,6 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_SAVE_RESTORE_TENSOR_H_
 #define TENSORFLOW_CORE_KERNELS_SAVE_RESTORE_TENSOR_H_
 
+#include <functional>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_writer.h"
 
@@ -68,6 +72,23 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& shape_and_slices,
                         gtl::ArraySlice<DataType> dtypes);
 
+// Background writes of V2 checkpoints, e.g. by SaveV2 with TF_SAVE_V2_ASYNC.
+
+// Runs "write", which writes the bundle "prefix", on another thread.  Backs
+// off until the earlier writes of "prefix", and those started by other steps
+// than "step_id", have finished, so that at most one checkpoint is staged in
+// memory at a time while the shards saved by one step are written
+// concurrently.
+void StartCheckpointWrite(const string& prefix, int64 step_id,
+                          std::function<Status()> write);
+
+// Returns true iff any background checkpoint write is in progress.
+bool CheckpointWritesInProgress();
+
+// Waits for the background write of "prefix", if any, to finish.  Returns
+// the error of a failed write to the first caller after it failed.
+Status WaitForCheckpointWrite(const string& prefix);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_KERNELS_SAVE_RESTORE_TENSOR_H_
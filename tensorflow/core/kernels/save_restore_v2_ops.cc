@@ -15,12 +15,14 @@ limitations under the License.
 
 // See docs in ../ops/io_ops.cc.
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
@@ -29,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
@@ -85,6 +88,23 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// Returns true if SaveV2 should only snapshot its inputs and write the bundle
+// in the background, as set by TF_SAVE_V2_ASYNC.  Readers and mergers of the
+// bundle in this process wait for the write to finish.
+bool AsyncSaveEnabled() {
+  static const bool enabled = [] {
+    bool enabled;
+    Status s = ReadBoolFromEnvVar("TF_SAVE_V2_ASYNC",
+                                  /*default_val=*/false, &enabled);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to read TF_SAVE_V2_ASYNC: " << s;
+      enabled = false;
+    }
+    return enabled;
+  }();
+  return enabled;
+}
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
@@ -105,36 +125,70 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<tstring>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
+    const bool async = AsyncSaveEnabled();
+    auto entries = std::make_shared<std::vector<SaveEntry>>(num_tensors);
     for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
+      SaveEntry& entry = (*entries)[i];
+      entry.name = tensor_names_flat(i);
       const Tensor& tensor = context->input(i + kFixedInputs);
 
       if (!shape_and_slices_flat(i).empty()) {
         const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
+        entry.slice = TensorSlice(tensor.dims());
         TensorShape slice_shape;
 
         OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
+                                    shape_spec, &entry.shape, &entry.slice,
+                                    &slice_shape));
         OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
                     errors::InvalidArgument("Slice in shape_and_slice "
                                             "specification does not match the "
                                             "shape of the tensor to  save: ",
                                             shape_spec, ", tensor: ",
                                             tensor.shape().DebugString()));
+        entry.is_slice = true;
+      }
+      // In async mode, snapshots the value, since the input may be a variable
+      // that the next steps update in place.
+      entry.tensor = async ? tensor::DeepCopy(tensor) : tensor;
+    }
 
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
+    if (async) {
+      VLOG(1) << "Writing " << prefix_string << " in the background";
+      StartCheckpointWrite(prefix_string, context->step_id(),
+                           [prefix_string, entries]() {
+                             return WriteBundle(prefix_string, *entries);
+                           });
+    } else {
+      OP_REQUIRES_OK(context, WriteBundle(prefix_string, *entries));
+    }
+  }
+
+ private:
+  // A tensor to save, under "name", either in full or as "slice" of a full
+  // tensor of "shape".
+  struct SaveEntry {
+    string name;
+    bool is_slice = false;
+    TensorShape shape;
+    TensorSlice slice;
+    Tensor tensor;
+  };
+
+  static Status WriteBundle(const string& prefix,
+                            const std::vector<SaveEntry>& entries) {
+    BundleWriter writer(Env::Default(), prefix);
+    TF_RETURN_IF_ERROR(writer.status());
+    VLOG(1) << "BundleWriter, prefix_string: " << prefix;
+    for (const SaveEntry& entry : entries) {
+      if (entry.is_slice) {
+        TF_RETURN_IF_ERROR(writer.AddSlice(entry.name, entry.shape,
+                                           entry.slice, entry.tensor));
       } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
+        TF_RETURN_IF_ERROR(writer.Add(entry.name, entry.tensor));
       }
     }
-    OP_REQUIRES_OK(context, writer.Finish());
+    return writer.Finish();
   }
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
@@ -142,7 +196,8 @@ REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 // Restores a list of named tensors from a tensor bundle (V2 checkpoint format).
 class RestoreV2 : public OpKernel {
  public:
-  explicit RestoreV2(OpKernelConstruction* context) : OpKernel(context) {
+  explicit RestoreV2(OpKernelConstruction* context)
+      : OpKernel(context), on_cpu_(context->device_type() == DEVICE_CPU) {
     OP_REQUIRES_OK(context, context->GetAttr("dtypes", &dtypes_));
   }
 
@@ -158,6 +213,7 @@ class RestoreV2 : public OpKernel {
                    shape_and_slices);
 
     const string& prefix_string = prefix.scalar<tstring>()();
+    OP_REQUIRES_OK(context, WaitForCheckpointWrite(prefix_string));
 
     // Intention: we plan to use the RestoreV2 op as a backward-compatible
     // reader as we upgrade to the V2 format.  This allows transparent upgrade.
@@ -169,6 +225,11 @@ class RestoreV2 : public OpKernel {
         paths.empty()) {
       // Cannot find V2's metadata file, so "prefix_string" does not point to a
       // V2 checkpoint.  Invokes the V1 read path instead.
+      OP_REQUIRES(context, on_cpu_,
+                  errors::Unimplemented(
+                      "V1 checkpoints can only be restored on CPU; cannot "
+                      "find a V2 checkpoint at ",
+                      prefix_string));
       for (size_t i = 0; i < tensor_names.NumElements(); ++i) {
         RestoreTensor(context, &checkpoint::OpenTableTensorSliceReader,
                       /* preferred_shard */ -1, /* restore_slice */ true,
@@ -187,9 +248,28 @@ class RestoreV2 : public OpKernel {
  private:
   // Expected dtypes of the to-restore tensors.
   std::vector<DataType> dtypes_;
+  // Whether the outputs are in host memory.  Otherwise the tensors are
+  // streamed into device memory.
+  const bool on_cpu_;
 };
 REGISTER_KERNEL_BUILDER(Name("RestoreV2").Device(DEVICE_CPU), RestoreV2);
 
+#ifdef TENSORFLOW_USE_VE
+// Restores the tensors directly into VE memory.  Only for types that can be
+// copied to the device, so that e.g. string tensors stay on the CPU.
+REGISTER_KERNEL_BUILDER(Name("RestoreV2")
+                            .Device(DEVICE_VE)
+                            .HostMemory("prefix")
+                            .HostMemory("tensor_names")
+                            .HostMemory("shape_and_slices")
+                            .TypeConstraint("dtypes",
+                                            {DT_FLOAT, DT_DOUBLE, DT_HALF,
+                                             DT_BFLOAT16, DT_INT8, DT_UINT8,
+                                             DT_INT16, DT_UINT16, DT_INT32,
+                                             DT_INT64, DT_BOOL}),
+                        RestoreV2);
+#endif  // TENSORFLOW_USE_VE
+
 // The final step in saving sharded V2 checkpoints: merges metadata files.
 class MergeV2Checkpoints : public OpKernel {
  public:
@@ -214,6 +294,9 @@ class MergeV2Checkpoints : public OpKernel {
 
     const gtl::ArraySlice<tstring> input_prefixes =
         gtl::ArraySlice<tstring>(checkpoint_prefixes.flat<tstring>());
+    for (const string& input_prefix : input_prefixes) {
+      OP_REQUIRES_OK(context, WaitForCheckpointWrite(input_prefix));
+    }
     Env* env = Env::Default();
     const string& merged_prefix = destination_prefix.scalar<tstring>()();
     OP_REQUIRES_OK(
@@ -23,7 +23,10 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/save_restore_tensor.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
@@ -339,5 +342,53 @@ TEST_F(SaveV2OpTest, Simple) {
   }
 }
 
+TEST(CheckpointWriteTest, WaitsForBackgroundWrite) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "async_ckpt");
+  Notification start_writing;
+  bool written = false;
+  StartCheckpointWrite(prefix, /*step_id=*/1, [&]() {
+    start_writing.WaitForNotification();
+    written = true;
+    return Status::OK();
+  });
+  EXPECT_TRUE(CheckpointWritesInProgress());
+  start_writing.Notify();
+  TF_EXPECT_OK(WaitForCheckpointWrite(prefix));
+  EXPECT_TRUE(written);
+  EXPECT_FALSE(CheckpointWritesInProgress());
+}
+
+TEST(CheckpointWriteTest, ReportsFailedWriteOnce) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "failed_async_ckpt");
+  StartCheckpointWrite(prefix, /*step_id=*/1,
+                       []() { return errors::Unavailable("disk is gone"); });
+  EXPECT_TRUE(errors::IsUnavailable(WaitForCheckpointWrite(prefix)));
+  TF_EXPECT_OK(WaitForCheckpointWrite(prefix));
+}
+
+TEST(CheckpointWriteTest, NextStepBacksOff) {
+  const string prefix_0 = io::JoinPath(testing::TmpDir(), "ckpt-0");
+  const string prefix_1 = io::JoinPath(testing::TmpDir(), "ckpt-1");
+  Notification finish_first;
+  bool first_written = false;
+  StartCheckpointWrite(prefix_0, /*step_id=*/1, [&]() {
+    finish_first.WaitForNotification();
+    first_written = true;
+    return Status::OK();
+  });
+  // The write of the next step only starts once the first one finished.
+  Env::Default()->SchedClosure([&finish_first]() {
+    Env::Default()->SleepForMicroseconds(10000);
+    finish_first.Notify();
+  });
+  bool first_written_before_second = false;
+  StartCheckpointWrite(prefix_1, /*step_id=*/2, [&]() {
+    first_written_before_second = first_written;
+    return Status::OK();
+  });
+  TF_EXPECT_OK(WaitForCheckpointWrite(prefix_1));
+  EXPECT_TRUE(first_written_before_second);
+}
+
 }  // namespace
 }  // namespace tensorflow
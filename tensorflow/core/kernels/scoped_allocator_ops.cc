@@ -89,6 +89,11 @@ REGISTER_KERNEL_BUILDER(Name("_ScopedAllocator").Device(DEVICE_CPU),
 REGISTER_KERNEL_BUILDER(Name("_ScopedAllocator").Device(DEVICE_GPU),
                         ScopedAllocatorOp);
 
+#ifdef TENSORFLOW_USE_VE
+REGISTER_KERNEL_BUILDER(Name("_ScopedAllocator").Device(DEVICE_VE),
+                        ScopedAllocatorOp);
+#endif  // TENSORFLOW_USE_VE
+
 class ScopedAllocatorConcatOp : public OpKernel {
  public:
   explicit ScopedAllocatorConcatOp(OpKernelConstruction* context)
@@ -170,6 +175,11 @@ REGISTER_KERNEL_BUILDER(Name("_ScopedAllocatorConcat").Device(DEVICE_CPU),
 REGISTER_KERNEL_BUILDER(Name("_ScopedAllocatorConcat").Device(DEVICE_GPU),
                         ScopedAllocatorConcatOp);
 
+#ifdef TENSORFLOW_USE_VE
+REGISTER_KERNEL_BUILDER(Name("_ScopedAllocatorConcat").Device(DEVICE_VE),
+                        ScopedAllocatorConcatOp);
+#endif  // TENSORFLOW_USE_VE
+
 class ScopedAllocatorSplitOp : public OpKernel {
  public:
   explicit ScopedAllocatorSplitOp(OpKernelConstruction* context)
@@ -232,4 +242,9 @@ REGISTER_KERNEL_BUILDER(Name("_ScopedAllocatorSplit").Device(DEVICE_CPU),
 REGISTER_KERNEL_BUILDER(Name("_ScopedAllocatorSplit").Device(DEVICE_GPU),
                         ScopedAllocatorSplitOp);
 
+#ifdef TENSORFLOW_USE_VE
+REGISTER_KERNEL_BUILDER(Name("_ScopedAllocatorSplit").Device(DEVICE_VE),
+                        ScopedAllocatorSplitOp);
+#endif  // TENSORFLOW_USE_VE
+
 }  // namespace tensorflow
@@ -491,26 +491,31 @@ class VEUnsortedSegmentReductionOp : public OpKernel {
       return;
     }
     const auto segment_flat = segment_ids.flat<Index>();
-    const Index output_rows =
-        internal::SubtleMustCopy(num_segments.scalar<int32>()());
+    const int64 output_rows = internal::SubtleMustCopy(static_cast<int64>(
+        num_segments.dtype() == DT_INT32 ? num_segments.scalar<int32>()()
+                                         : num_segments.scalar<int64>()()));
     OP_REQUIRES(context, output_rows >= 0,
                 errors::InvalidArgument("Input num_segments == ", output_rows,
                                         " must not be negative."));
     TensorShape output_shape;
     output_shape.AddDim(output_rows);
+    int64_t segment_size = 1;
     for (int i = segment_ids.dims(); i < data.dims(); i++) {
       output_shape.AddDim(data.dim_size(i));
+      segment_size *= data.dim_size(i);
     }
     Tensor* output = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
 
+    // The kernel fills the output with the initial value before reducing, so
+    // it is also called when there is nothing to reduce.
     const int64_t N = segment_flat.dimension(0) ;
-    const int64_t data_size = data.NumElements() ;
 
     VEReductionFunctor reduction_functor;
     InitialValueF initialvalue_functor ;
     reduction_functor(context, &data, &segment_ids, output,
-	              N, output_rows, data_size / N,
+	              N, output_rows, segment_size,
 		      initialvalue_functor() ) ;
   }
 };
@@ -16,6 +16,7 @@ limitations under the License.
 #include <functional>
 #include <vector>
 
+#include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
@@ -166,4 +167,75 @@ static void BM_SparseSegmentMeanGrad_High(int iters, int size) {
 BENCHMARK(BM_SparseSegmentMeanGrad_Low)->Arg(1000)->Arg(100000);
 BENCHMARK(BM_SparseSegmentMeanGrad_High)->Arg(1000)->Arg(100000);
 
+class SparseSegmentWeightedSumOpTest : public OpsTestBase {
+ protected:
+  void MakeOp() {
+    TF_EXPECT_OK(NodeDefBuilder("op", "_SparseSegmentWeightedSum")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+};
+
+TEST_F(SparseSegmentWeightedSumOpTest, Simple) {
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({4, 2}), {1, 2, 3, 4, 5, 6, 7, 8});
+  AddInputFromArray<int32>(TensorShape({5}), {3, 0, 1, 1, 2});
+  AddInputFromArray<float>(TensorShape({5, 1}), {1, 2, -1, 0.5, 3});
+  AddInputFromArray<int32>(TensorShape({5}), {0, 0, 2, 2, 3});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Segment 1 has no indices and is zero.
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({4, 2}));
+  test::FillValues<float>(&expected, {9, 12, 0, 0, -1.5, -2, 15, 18});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-6);
+}
+
+TEST_F(SparseSegmentWeightedSumOpTest, Empty) {
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({4, 2}), {1, 2, 3, 4, 5, 6, 7, 8});
+  AddInputFromArray<int32>(TensorShape({0}), {});
+  AddInputFromArray<float>(TensorShape({0, 1}), {});
+  AddInputFromArray<int32>(TensorShape({0}), {});
+  TF_ASSERT_OK(RunOpKernel());
+
+  EXPECT_EQ(TensorShape({0, 2}), GetOutput(0)->shape());
+}
+
+TEST_F(SparseSegmentWeightedSumOpTest, IndexOutOfRange) {
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({4, 2}), {1, 2, 3, 4, 5, 6, 7, 8});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 4});
+  AddInputFromArray<float>(TensorShape({2, 1}), {1, 1});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 1});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(absl::StrContains(s.ToString(), "indices[1] == 4 out of range"))
+      << s;
+}
+
+TEST_F(SparseSegmentWeightedSumOpTest, UnsortedSegmentIds) {
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({4, 2}), {1, 2, 3, 4, 5, 6, 7, 8});
+  AddInputFromArray<int32>(TensorShape({3}), {0, 1, 2});
+  AddInputFromArray<float>(TensorShape({3, 1}), {1, 1, 1});
+  AddInputFromArray<int32>(TensorShape({3}), {1, 0, 1});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(absl::StrContains(s.ToString(), "segment ids are not increasing"))
+      << s;
+}
+
+TEST_F(SparseSegmentWeightedSumOpTest, WeightsNotBroadcast) {
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({4, 2}), {1, 2, 3, 4, 5, 6, 7, 8});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 1});
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, 1, 1, 1});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 1});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(absl::StrContains(s.ToString(), "weights must have shape [2"))
+      << s;
+}
+
 }  // namespace tensorflow
@@ -0,0 +1,170 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements the weighted embedding lookup of embedding_lookup_sparse,
+//   SegmentSum(Gather(data, indices) * weights, segment_ids),
+// in a single kernel. The unfused graph materializes the gathered and the
+// weighted [num_indices, ...] tensors, which dominate the memory traffic for
+// a large number of indices. This kernel reads the rows directly from `data`
+// and accumulates them into the output row of their segment, in parallel
+// over segments.
+//
+// Currently supported only on CPU device.
+
+#define EIGEN_USE_THREADS
+
+#include <vector>
+
+#include "tensorflow/core/framework/bounds_check.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+template <typename T, typename Index, typename SegmentId>
+class SparseSegmentWeightedSumOp : public OpKernel {
+ public:
+  explicit SparseSegmentWeightedSumOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& data = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& weights = context->input(2);
+    const Tensor& segment_ids = context->input(3);
+
+    OP_REQUIRES(context, data.dims() >= 1,
+                errors::InvalidArgument("data must be at least 1-D, got ",
+                                        data.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(indices.shape()),
+                errors::InvalidArgument("indices should be a vector."));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(segment_ids.shape()),
+                errors::InvalidArgument("segment_ids should be a vector."));
+
+    const int64 num_indices = indices.NumElements();
+    OP_REQUIRES(context, num_indices == segment_ids.NumElements(),
+                errors::InvalidArgument(
+                    "segment_ids and indices should have same size."));
+
+    // Weights are broadcast along the gathered rows, so they must have the
+    // rank of the gathered tensor and a single element per index.
+    OP_REQUIRES(
+        context,
+        weights.dims() == data.dims() && weights.dim_size(0) == num_indices &&
+            weights.NumElements() == num_indices,
+        errors::InvalidArgument(
+            "weights must have shape [", num_indices,
+            ", 1, ...] of the same rank as data, got weights.shape = ",
+            weights.shape().DebugString(),
+            ", data.shape = ", data.shape().DebugString()));
+
+    const auto indices_vec = indices.vec<Index>();
+    const auto segment_vec = segment_ids.vec<SegmentId>();
+
+    const SegmentId output_rows =
+        num_indices > 0
+            ? internal::SubtleMustCopy(segment_vec(num_indices - 1)) + 1
+            : 0;
+    OP_REQUIRES(context, output_rows >= 0,
+                errors::InvalidArgument("segment ids must be >= 0"));
+
+    TensorShape output_shape = data.shape();
+    output_shape.set_dim(0, output_rows);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    // Segments without indices are zero.
+    functor::SetZeroFunctor<CPUDevice, T> zero;
+    zero(context->eigen_device<CPUDevice>(), output->flat<T>());
+    if (num_indices == 0) return;
+
+    // Validate the inputs and find the first index of every segment, so that
+    // segments can be reduced independently.
+    const int64 num_data_rows = data.dim_size(0);
+    std::vector<int64> segment_starts;
+    SegmentId prev_segment_id = -1;
+    for (int64 i = 0; i < num_indices; ++i) {
+      const Index index = internal::SubtleMustCopy(indices_vec(i));
+      OP_REQUIRES(context, FastBoundsCheck(index, num_data_rows),
+                  errors::InvalidArgument("indices[", i, "] == ", index,
+                                          " out of range [0, ", num_data_rows,
+                                          ")"));
+      const SegmentId segment_id = internal::SubtleMustCopy(segment_vec(i));
+      OP_REQUIRES(context, segment_id >= prev_segment_id,
+                  errors::InvalidArgument("segment ids are not increasing"));
+      OP_REQUIRES(context, segment_id >= 0,
+                  errors::InvalidArgument("segment ids must be >= 0"));
+      if (segment_id != prev_segment_id) segment_starts.push_back(i);
+      prev_segment_id = segment_id;
+    }
+    segment_starts.push_back(num_indices);
+
+    const int64 num_cols = data.NumElements() / num_data_rows;
+    const T* data_ptr = data.flat<T>().data();
+    const T* weights_ptr = weights.flat<T>().data();
+    T* output_ptr = output->flat<T>().data();
+
+    auto reduce_segments = [&](int64 begin, int64 end) {
+      for (int64 s = begin; s < end; ++s) {
+        const int64 start = segment_starts[s];
+        const int64 limit = segment_starts[s + 1];
+        T* out = output_ptr + segment_vec(start) * num_cols;
+        for (int64 i = start; i < limit; ++i) {
+          const T* row = data_ptr + indices_vec(i) * num_cols;
+          const T weight = weights_ptr[i];
+          for (int64 j = 0; j < num_cols; ++j) {
+            out[j] += weight * row[j];
+          }
+        }
+      }
+    };
+
+    const int64 num_segments = segment_starts.size() - 1;
+    const int64 cost_per_segment = 2 * num_cols * num_indices / num_segments;
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, num_segments,
+          cost_per_segment, reduce_segments);
+  }
+};
+
+#define REGISTER_CPU_KERNEL(type, index_type, segment_ids_type) \
+  REGISTER_KERNEL_BUILDER(                                      \
+      Name("_SparseSegmentWeightedSum")                         \
+          .Device(DEVICE_CPU)                                   \
+          .TypeConstraint<type>("T")                            \
+          .TypeConstraint<index_type>("Tidx")                   \
+          .TypeConstraint<segment_ids_type>("Tsegmentids"),     \
+      SparseSegmentWeightedSumOp<type, index_type, segment_ids_type>);
+
+#define REGISTER_CPU_KERNELS(type)         \
+  REGISTER_CPU_KERNEL(type, int32, int32); \
+  REGISTER_CPU_KERNEL(type, int32, int64); \
+  REGISTER_CPU_KERNEL(type, int64, int32); \
+  REGISTER_CPU_KERNEL(type, int64, int64);
+
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace tensorflow
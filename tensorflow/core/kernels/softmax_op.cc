@@ -151,6 +151,55 @@ REGISTER_KERNEL_BUILDER(
     Name("LogSoftmax").Device(DEVICE_VE).TypeConstraint<float>("T"),
     SoftmaxOp<VEDevice, float>);
 
+// _FusedMaskedSoftmax computes Softmax(logits * scale + mask) of attention
+// scores in one VE kernel. The mask, e.g. [batch, 1, 1, to] for logits of
+// [batch, heads, from, to], is broadcast by the VE kernel.
+template <typename T>
+class FusedMaskedSoftmaxOp : public VEOpKernel {
+ public:
+  explicit FusedMaskedSoftmaxOp(OpKernelConstruction* context)
+      : VEOpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("scale", &scale_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& logits_in = context->input(0);
+    const Tensor& mask = context->input(1);
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(logits_in.shape()),
+                errors::InvalidArgument("logits must have >= 1 dimension, got ",
+                                        logits_in.shape().DebugString()));
+    bool broadcastable = mask.dims() == logits_in.dims();
+    for (int d = 0; broadcastable && d < mask.dims(); ++d) {
+      broadcastable = mask.dim_size(d) == 1 ||
+                      mask.dim_size(d) == logits_in.dim_size(d);
+    }
+    OP_REQUIRES(context, broadcastable,
+                errors::InvalidArgument(
+                    "mask of shape ", mask.shape().DebugString(),
+                    " can't be broadcast to logits of shape ",
+                    logits_in.shape().DebugString()));
+    Tensor* softmax_out = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, logits_in.shape(), &softmax_out));
+    if (softmax_out->NumElements() == 0) return;
+
+    ArgsImpl<> Args = ArgsImpl<>() ;
+    Args.addArg<Tensor>(logits_in) ;
+    Args.addArg<Tensor>(mask) ;
+    Args.addArg<Tensor>(*softmax_out) ;
+    Args.addArg<T>(scale_) ;
+
+    Call(context, "MaskedSoftmax", Args) ;
+  }
+
+ private:
+  T scale_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedMaskedSoftmax").Device(DEVICE_VE).TypeConstraint<float>("T"),
+    FusedMaskedSoftmaxOp<float>);
+
 #endif // TENSORFLOW_USE_VE
 
 
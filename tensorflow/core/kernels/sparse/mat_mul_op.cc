@@ -148,10 +148,10 @@ class CSRMatMulOp : public OpKernel {
 
 // CPU Kernel to compute sparse-dense matrix multiplication.
 //
-// Uses Eigen SparseMatrix to compute the sparse-dense multiplication between
-// a CSR SparseMatrix `a` and dense Tensor `b`. If intra-op parallelism is
-// available, the implementation parallelizes the computation across each row
-// of the sparse matrix.
+// Computes the sparse-dense multiplication between a CSR SparseMatrix `a` and
+// dense Tensor `b` directly on the CSR arrays, or with Eigen SparseMatrix if
+// `a` is transposed. If intra-op parallelism is available, the implementation
+// parallelizes the computation across the rows of the sparse matrix.
 template <typename T>
 class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
   using SparseMatrix = Eigen::SparseMatrix<T, Eigen::RowMajor>;
@@ -288,46 +288,104 @@ class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
       OpKernelContext* ctx, const int64 batch_size, const int64 num_lhs_rows,
       const CSRSparseMatrix& lhs, const Tensor& rhs, Tensor* output) {
     // Parallelize matrix multiplication across batch dimensions and across
-    // rows in each batch.
+    // rows in each batch. The rows are split into shards with about the same
+    // number of nonzeros rather than of rows, so that the few dense rows of
+    // e.g. a graph adjacency matrix do not leave one thread with most of the
+    // work.
     auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
     const int32 num_threads = worker_threads.num_threads;
-    const int64 block_size =
-        num_lhs_rows / std::max(kMaxShards, kNumShardsPerThread * num_threads);
     const int64 num_rhs_rows = rhs.dim_size(rhs.dims() - 2);
     const int64 num_rhs_cols = rhs.dim_size(rhs.dims() - 1);
+    if (batch_size == 0 || num_lhs_rows == 0 || num_rhs_cols == 0) return;
+    const int64 max_shards =
+        std::max<int64>(kMaxShards, kNumShardsPerThread * num_threads);
+    const int64 shards_per_batch = std::min(
+        num_lhs_rows, std::max<int64>(1, max_shards / batch_size));
+    // Each nonzero and each row costs a pass over a row of the rhs or output.
+    const int64 cost_per_shard =
+        (lhs.total_nnz() + batch_size * num_lhs_rows) * num_rhs_cols *
+        (Eigen::TensorOpCost::MulCost<T>() +
+         Eigen::TensorOpCost::AddCost<T>()) /
+        (batch_size * shards_per_batch);
     worker_threads.workers->ParallelFor(
-        batch_size * num_lhs_rows /* total */,
-        thread::ThreadPool::SchedulingParams(
-            thread::ThreadPool::SchedulingStrategy::
-                kFixedBlockSize /* strategy */,
-            absl::nullopt /* cost_per_unit */, block_size),
-        [&](int64 batch_and_row_begin, int64 batch_and_row_end) {
-          HandleBatchAndRowRange(
-              num_lhs_rows, batch_and_row_begin, batch_and_row_end,
-              [&](int64 batch_idx, int64 row_begin, int64 row_end) {
-                const int64 num_shard_rows = row_end - row_begin;
-
-                // Define an Eigen::SparseMatrix over the row range:
-                // [row_begin, row_end) of the CSR SparseMatrix A.
-                std::vector<int32> row_ptrs;
-                auto sparse_matrix = GetSparseMatrixRef(
-                    lhs, batch_idx, row_begin, num_shard_rows, &row_ptrs);
+        batch_size * shards_per_batch /* total */, cost_per_shard,
+        [&](int64 shard_begin, int64 shard_end) {
+          for (int64 shard = shard_begin; shard < shard_end; ++shard) {
+            const int64 batch_idx = shard / shards_per_batch;
+            const int32* row_ptrs = lhs.row_pointers_vec(batch_idx).data();
+            const int64 row_begin =
+                ShardRowBegin(row_ptrs, num_lhs_rows, shard % shards_per_batch,
+                              shards_per_batch);
+            const int64 row_end =
+                ShardRowBegin(row_ptrs, num_lhs_rows,
+                              shard % shards_per_batch + 1, shards_per_batch);
+            if (row_begin == row_end) continue;
+
+            // Map the rhs and the output of this batch.
+            ConstMatrixMap rhs_map(rhs.flat<T>().data() + batch_idx *
+                                                              num_rhs_rows *
+                                                              num_rhs_cols,
+                                   num_rhs_rows, num_rhs_cols);
+            MatrixMap output_map(output->flat<T>().data() +
+                                     batch_idx * num_lhs_rows * num_rhs_cols,
+                                 num_lhs_rows, num_rhs_cols);
+            SparseDenseMatMulRows(row_ptrs,
+                                  lhs.col_indices_vec(batch_idx).data(),
+                                  lhs.values_vec<T>(batch_idx).data(),
+                                  row_begin, row_end, rhs_map, &output_map);
+          }
+        });
+  }
 
-                // Map the corresponding rows of the rhs.
-                ConstMatrixMap rhs_map(rhs.flat<T>().data() + batch_idx *
-                                                                  num_rhs_rows *
-                                                                  num_rhs_cols,
-                                       num_rhs_rows, num_rhs_cols);
+  // Returns the first of the rows [0, num_rows) in shard `shard` of
+  // `num_shards`, where each shard has about the same number of nonzeros
+  // plus rows. `row_ptrs` are the num_rows + 1 row pointers of the matrix.
+  static int64 ShardRowBegin(const int32* row_ptrs, const int64 num_rows,
+                             const int64 shard, const int64 num_shards) {
+    if (shard >= num_shards) return num_rows;
+    const int64 total_cost = row_ptrs[num_rows] - row_ptrs[0] + num_rows;
+    const int64 target_cost = total_cost * shard / num_shards;
+    // The cost of rows [0, row) increases with row, so binary search it.
+    int64 lo = 0;
+    int64 hi = num_rows;
+    while (lo < hi) {
+      const int64 mid = lo + (hi - lo) / 2;
+      if (row_ptrs[mid] - row_ptrs[0] + mid < target_cost) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
 
-                // Write to the corresponding rows of the output matrix.
-                MatrixMap output_map(
-                    output->flat<T>().data() +
-                        batch_idx * num_lhs_rows * num_rhs_cols +
-                        row_begin * num_rhs_cols,
-                    num_shard_rows, num_rhs_cols);
-                output_map.noalias() = sparse_matrix * rhs_map;
-              });
-        });
+  // Computes the rows [row_begin, row_end) of `output` as the product of the
+  // CSR matrix given by `row_ptrs`, `col_ind` and `values` with `rhs`.
+  //
+  // Each output row is a sum of rhs rows scaled by the nonzeros of the lhs
+  // row. Eigen vectorizes these along the columns of rhs, and four nonzeros
+  // are added per pass so that the output row is loaded and stored a quarter
+  // as often.
+  static void SparseDenseMatMulRows(const int32* row_ptrs,
+                                    const int32* col_ind, const T* values,
+                                    const int64 row_begin, const int64 row_end,
+                                    const ConstMatrixMap& rhs,
+                                    MatrixMap* output) {
+    for (int64 row = row_begin; row < row_end; ++row) {
+      auto output_row = output->row(row);
+      output_row.setZero();
+      int32 k = row_ptrs[row];
+      const int32 k_end = row_ptrs[row + 1];
+      for (; k + 4 <= k_end; k += 4) {
+        output_row.noalias() += values[k] * rhs.row(col_ind[k]) +
+                                values[k + 1] * rhs.row(col_ind[k + 1]) +
+                                values[k + 2] * rhs.row(col_ind[k + 2]) +
+                                values[k + 3] * rhs.row(col_ind[k + 3]);
+      }
+      for (; k < k_end; ++k) {
+        output_row.noalias() += values[k] * rhs.row(col_ind[k]);
+      }
+    }
   }
 
   // Sparse-Dense Matrix Multiplication assuming the CSRSparseMatrix (LHS) is
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/training_ops.h"
 
 #include <algorithm>  // NOLINT
+#include <numeric>
 
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -50,6 +51,65 @@ using Index = Eigen::Index;
 typedef Eigen::VeDevice VEDevice;
 #endif  // TENSORFLOW_USE_VE
 
+#ifdef TENSORFLOW_USE_VE
+namespace {
+
+// Chains elementwise VE kernels (Add, Mul, Rsqrt, ...) for optimizers that
+// have no dedicated kernel in the VE kernel library. Tensors are passed
+// flattened and scalar operands are broadcast by the binary kernels. The
+// kernels are queued without a sync, and `out` may alias any input.
+class VEElementwiseChain {
+ public:
+  explicit VEElementwiseChain(OpKernelContext* ctx)
+      : vectx_(ctx->op_device_context<VEDeviceContext>()) {}
+
+  Status Unary(const std::string& name, const Tensor& in, Tensor* out) {
+    struct {
+      _Tensor in;
+      _Tensor out;
+    } __attribute__((__packed__)) args;
+    args.in = _Tensor(in);
+    args.out = _Tensor(*out);
+    return vectx_->Compute(name, (void*)&args, sizeof(args));
+  }
+
+  Status Binary(const std::string& name, const Tensor& in0, const Tensor& in1,
+                Tensor* out) {
+    struct {
+      _Tensor in0;
+      _Tensor in1;
+      _Tensor out;
+    } __attribute__((__packed__)) args;
+    args.in0 = _Tensor(in0);
+    args.in1 = _Tensor(in1);
+    args.out = _Tensor(*out);
+    return vectx_->Compute(name, (void*)&args, sizeof(args));
+  }
+
+ private:
+  struct _Tensor {
+    int32_t dtype;
+    uint64_t addr;
+    int32_t dims;
+    int64_t nelems;
+    int64_t dim_size[8];
+
+    _Tensor() {}
+    explicit _Tensor(const Tensor& t)
+        : dtype(t.dtype()),
+          addr((uint64_t)DMAHelper::base(&t)),
+          dims(1),
+          nelems(t.NumElements()) {
+      dim_size[0] = nelems;
+    }
+  } __attribute__((__packed__));
+
+  VEDeviceContext* vectx_;
+};
+
+}  // namespace
+#endif  // TENSORFLOW_USE_VE
+
 namespace {
 template <class T>
 inline T sgn(const T x) {
@@ -778,6 +838,70 @@ TF_CALL_float(REGISTER_VE_KERNELS);
 //#endif
 #undef REGISTER_VE_KERNELS
 
+// Applies N gradient descent updates that share alpha. The variables are
+// locked once, in order, and the N kernels are queued back to back so that
+// they are issued to the VE in one batch.
+template <typename T>
+class VEGroupedApplyGradientDescentOp : public VEOpKernel {
+ public:
+  explicit VEGroupedApplyGradientDescentOp(OpKernelConstruction* ctx)
+      : VEOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &num_vars_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const bool sparse = false;
+    std::vector<int> var_inputs(num_vars_);
+    std::iota(var_inputs.begin(), var_inputs.end(), 0);
+    auto locks = VEMaybeLockVariableInputMutexesInOrder<T>(
+        ctx, use_exclusive_lock_, sparse, var_inputs);
+
+    const Tensor& alpha = ctx->input(num_vars_);
+    OP_REQUIRES(ctx, IsLegacyScalar(alpha.shape()),
+                errors::InvalidArgument("alpha is not a scalar: ",
+                                        alpha.shape().DebugString()));
+
+    for (int i = 0; i < num_vars_; ++i) {
+      Tensor var;
+      OP_REQUIRES_OK(ctx, VEGetInputTensorFromVariable<T>(
+                              ctx, i, use_exclusive_lock_, sparse, &var));
+      OP_REQUIRES(ctx, var.IsInitialized(),
+                  errors::FailedPrecondition(
+                      "Attempting to use uninitialized variables: ",
+                      requested_input(i)));
+      const Tensor& delta = ctx->input(num_vars_ + 1 + i);
+      OP_REQUIRES(
+          ctx, var.shape().IsSameSize(delta.shape()),
+          errors::InvalidArgument("var and delta do not have the same shape",
+                                  var.shape().DebugString(), " ",
+                                  delta.shape().DebugString()));
+
+      ArgsImpl<> Args = ArgsImpl<>() ;
+      Args.addArg<Tensor>(var) ;
+      Args.addArg<Tensor>(alpha) ;
+      Args.addArg<Tensor>(delta) ;
+
+      Call(ctx, "ApplyGradientDescent", Args);
+      if (!ctx->status().ok()) return;
+    }
+  }
+
+ private:
+  bool use_exclusive_lock_;
+  int num_vars_;
+};
+
+#define REGISTER_VE_KERNELS(T)                                         \
+  REGISTER_KERNEL_BUILDER(Name("_ResourceGroupedApplyGradientDescent") \
+                              .Device(DEVICE_VE)                       \
+                              .HostMemory("var")                       \
+                              .TypeConstraint<T>("T"),                 \
+                          VEGroupedApplyGradientDescentOp<T>);
+
+TF_CALL_float(REGISTER_VE_KERNELS);
+#undef REGISTER_VE_KERNELS
+
 #endif // TENSORFLOW_USE_VE
 
 
@@ -1596,6 +1720,93 @@ REGISTER_KERNELS(GPU, complex128);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+#ifdef TENSORFLOW_USE_VE
+template <typename T>
+class VEApplyAdagradOp : public VEOpKernel {
+ public:
+  explicit VEApplyAdagradOp(OpKernelConstruction* ctx) : VEOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("update_slots", &update_slots_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const bool sparse = false;
+    auto locks = VEMaybeLockVariableInputMutexesInOrder<T>(
+        ctx, use_exclusive_lock_, sparse, {0, 1});
+    Tensor var;
+    OP_REQUIRES_OK(ctx, VEGetInputTensorFromVariable<T>(
+                            ctx, 0, use_exclusive_lock_, sparse, &var));
+    Tensor accum;
+    OP_REQUIRES_OK(ctx, VEGetInputTensorFromVariable<T>(
+                            ctx, 1, use_exclusive_lock_, sparse, &accum));
+    OP_REQUIRES(
+        ctx, var.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(0)));
+    OP_REQUIRES(
+        ctx, accum.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(1)));
+    const Tensor& lr = ctx->input(2);
+    OP_REQUIRES(ctx, IsLegacyScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar: ",
+                                        lr.shape().DebugString()));
+    const Tensor& grad = ctx->input(3);
+    OP_REQUIRES(
+        ctx, var.shape().IsSameSize(accum.shape()),
+        errors::InvalidArgument("var and accum do not have the same shape",
+                                var.shape().DebugString(), " ",
+                                accum.shape().DebugString()));
+    OP_REQUIRES(
+        ctx, var.shape().IsSameSize(grad.shape()),
+        errors::InvalidArgument("var and grad do not have the same shape",
+                                var.shape().DebugString(), " ",
+                                grad.shape().DebugString()));
+
+    if (var.NumElements() > 0) {
+      OP_REQUIRES_OK(ctx, Update(ctx, &var, &accum, lr, grad));
+    }
+
+    MaybeForwardRefInputToRefOutput(ctx, 0, 0);
+  }
+
+ private:
+  // accum += grad * grad; var -= lr * grad * rsqrt(accum)
+  Status Update(OpKernelContext* ctx, Tensor* var, Tensor* accum,
+                const Tensor& lr, const Tensor& grad) {
+    VEElementwiseChain chain(ctx);
+    Tensor tmp;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(DataTypeToEnum<T>::value, var->shape(), &tmp));
+    if (update_slots_) {
+      TF_RETURN_IF_ERROR(chain.Unary("Square", grad, &tmp));
+      TF_RETURN_IF_ERROR(chain.Binary("Add", *accum, tmp, accum));
+    }
+    TF_RETURN_IF_ERROR(chain.Unary("Rsqrt", *accum, &tmp));
+    TF_RETURN_IF_ERROR(chain.Binary("Mul", tmp, grad, &tmp));
+    TF_RETURN_IF_ERROR(chain.Binary("Mul", tmp, lr, &tmp));
+    return chain.Binary("Sub", *var, tmp, var);
+  }
+
+  bool use_exclusive_lock_;
+  bool update_slots_;
+};
+
+#define REGISTER_VE_KERNELS(T)                                         \
+  REGISTER_KERNEL_BUILDER(                                             \
+      Name("ApplyAdagrad").Device(DEVICE_VE).TypeConstraint<T>("T"),   \
+      VEApplyAdagradOp<T>);                                            \
+  REGISTER_KERNEL_BUILDER(Name("ResourceApplyAdagrad")                 \
+                              .Device(DEVICE_VE)                       \
+                              .HostMemory("var")                       \
+                              .HostMemory("accum")                     \
+                              .TypeConstraint<T>("T"),                 \
+                          VEApplyAdagradOp<T>);
+
+TF_CALL_float(REGISTER_VE_KERNELS);
+#undef REGISTER_VE_KERNELS
+#endif  // TENSORFLOW_USE_VE
+
 template <typename Device, typename T>
 class ApplyAdagradV2Op : public OpKernel {
  public:
@@ -1716,6 +1927,98 @@ REGISTER_KERNELS(GPU, complex128);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+#ifdef TENSORFLOW_USE_VE
+template <typename T>
+class VEApplyAdagradV2Op : public VEOpKernel {
+ public:
+  explicit VEApplyAdagradV2Op(OpKernelConstruction* ctx) : VEOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("update_slots", &update_slots_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const bool sparse = false;
+    auto locks = VEMaybeLockVariableInputMutexesInOrder<T>(
+        ctx, use_exclusive_lock_, sparse, {0, 1});
+    Tensor var;
+    OP_REQUIRES_OK(ctx, VEGetInputTensorFromVariable<T>(
+                            ctx, 0, use_exclusive_lock_, sparse, &var));
+    Tensor accum;
+    OP_REQUIRES_OK(ctx, VEGetInputTensorFromVariable<T>(
+                            ctx, 1, use_exclusive_lock_, sparse, &accum));
+    OP_REQUIRES(
+        ctx, var.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(0)));
+    OP_REQUIRES(
+        ctx, accum.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(1)));
+    const Tensor& lr = ctx->input(2);
+    OP_REQUIRES(ctx, IsLegacyScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar: ",
+                                        lr.shape().DebugString()));
+    const Tensor& epsilon = ctx->input(3);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(epsilon.shape()),
+                errors::InvalidArgument("epsilon is not a scalar: ",
+                                        epsilon.shape().DebugString()));
+    const Tensor& grad = ctx->input(4);
+    OP_REQUIRES(
+        ctx, var.shape().IsSameSize(accum.shape()),
+        errors::InvalidArgument("var and accum do not have the same shape",
+                                var.shape().DebugString(), " ",
+                                accum.shape().DebugString()));
+    OP_REQUIRES(
+        ctx, var.shape().IsSameSize(grad.shape()),
+        errors::InvalidArgument("var and grad do not have the same shape",
+                                var.shape().DebugString(), " ",
+                                grad.shape().DebugString()));
+
+    if (var.NumElements() > 0) {
+      OP_REQUIRES_OK(ctx, Update(ctx, &var, &accum, lr, epsilon, grad));
+    }
+
+    MaybeForwardRefInputToRefOutput(ctx, 0, 0);
+  }
+
+ private:
+  // accum += grad * grad; var -= lr * grad / (sqrt(accum) + epsilon)
+  Status Update(OpKernelContext* ctx, Tensor* var, Tensor* accum,
+                const Tensor& lr, const Tensor& epsilon, const Tensor& grad) {
+    VEElementwiseChain chain(ctx);
+    Tensor tmp;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(DataTypeToEnum<T>::value, var->shape(), &tmp));
+    if (update_slots_) {
+      TF_RETURN_IF_ERROR(chain.Unary("Square", grad, &tmp));
+      TF_RETURN_IF_ERROR(chain.Binary("Add", *accum, tmp, accum));
+    }
+    TF_RETURN_IF_ERROR(chain.Unary("Sqrt", *accum, &tmp));
+    TF_RETURN_IF_ERROR(chain.Binary("Add", tmp, epsilon, &tmp));
+    TF_RETURN_IF_ERROR(chain.Binary("Div", grad, tmp, &tmp));
+    TF_RETURN_IF_ERROR(chain.Binary("Mul", tmp, lr, &tmp));
+    return chain.Binary("Sub", *var, tmp, var);
+  }
+
+  bool use_exclusive_lock_;
+  bool update_slots_;
+};
+
+#define REGISTER_VE_KERNELS(T)                                         \
+  REGISTER_KERNEL_BUILDER(                                             \
+      Name("ApplyAdagradV2").Device(DEVICE_VE).TypeConstraint<T>("T"), \
+      VEApplyAdagradV2Op<T>);                                          \
+  REGISTER_KERNEL_BUILDER(Name("ResourceApplyAdagradV2")               \
+                              .Device(DEVICE_VE)                       \
+                              .HostMemory("var")                       \
+                              .HostMemory("accum")                     \
+                              .TypeConstraint<T>("T"),                 \
+                          VEApplyAdagradV2Op<T>);
+
+TF_CALL_float(REGISTER_VE_KERNELS);
+#undef REGISTER_VE_KERNELS
+#endif  // TENSORFLOW_USE_VE
+
 template <typename Device, typename T>
 class ApplyProximalAdagradOp : public OpKernel {
  public:
@@ -3308,6 +3611,92 @@ TF_CALL_float(REGISTER_VE_KERNELS);
 //TF_CALL_complex128(REGISTER_VE_KERNELS);
 //#endif
 #undef REGISTER_VE_KERNELS
+
+// Applies N momentum updates that share lr and momentum. See
+// VEGroupedApplyGradientDescentOp.
+template <typename T>
+class VEGroupedApplyMomentumOp : public VEOpKernel {
+ public:
+  explicit VEGroupedApplyMomentumOp(OpKernelConstruction* ctx)
+      : VEOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &num_vars_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const bool sparse = false;
+    std::vector<int> var_inputs(2 * num_vars_);
+    std::iota(var_inputs.begin(), var_inputs.end(), 0);
+    auto locks = VEMaybeLockVariableInputMutexesInOrder<T>(
+        ctx, use_exclusive_lock_, sparse, var_inputs);
+
+    const Tensor& lr = ctx->input(2 * num_vars_);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar: ",
+                                        lr.shape().DebugString()));
+    const Tensor& momentum = ctx->input(3 * num_vars_ + 1);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(momentum.shape()),
+                errors::InvalidArgument("momentum is not a scalar: ",
+                                        momentum.shape().DebugString()));
+
+    for (int i = 0; i < num_vars_; ++i) {
+      Tensor var;
+      OP_REQUIRES_OK(ctx, VEGetInputTensorFromVariable<T>(
+                              ctx, i, use_exclusive_lock_, sparse, &var));
+      Tensor accum;
+      OP_REQUIRES_OK(ctx, VEGetInputTensorFromVariable<T>(
+                              ctx, num_vars_ + i, use_exclusive_lock_, sparse,
+                              &accum));
+      OP_REQUIRES(ctx, var.IsInitialized(),
+                  errors::FailedPrecondition(
+                      "Attempting to use uninitialized variables: ",
+                      requested_input(i)));
+      OP_REQUIRES(ctx, accum.IsInitialized(),
+                  errors::FailedPrecondition(
+                      "Attempting to use uninitialized variables: ",
+                      requested_input(num_vars_ + i)));
+      const Tensor& grad = ctx->input(2 * num_vars_ + 1 + i);
+      OP_REQUIRES(
+          ctx, var.shape().IsSameSize(accum.shape()),
+          errors::InvalidArgument("var and accum do not have the same shape",
+                                  var.shape().DebugString(), " ",
+                                  accum.shape().DebugString()));
+      OP_REQUIRES(
+          ctx, var.shape().IsSameSize(grad.shape()),
+          errors::InvalidArgument("var and grad do not have the same shape",
+                                  var.shape().DebugString(), " ",
+                                  grad.shape().DebugString()));
+
+      ArgsImpl<> Args = ArgsImpl<>() ;
+      Args.addArg<Tensor>(var) ;
+      Args.addArg<Tensor>(accum) ;
+      Args.addArg<Tensor>(lr) ;
+      Args.addArg<Tensor>(grad) ;
+      Args.addArg<Tensor>(momentum) ;
+      Args.addArg<int64_t>(use_nesterov_ ? 1 : 0) ;
+
+      Call(ctx, "ApplyMomentum", Args);
+      if (!ctx->status().ok()) return;
+    }
+  }
+
+ private:
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+  int num_vars_;
+};
+
+#define REGISTER_VE_KERNELS(T)                                     \
+  REGISTER_KERNEL_BUILDER(Name("_ResourceGroupedApplyMomentum")    \
+                              .Device(DEVICE_VE)                   \
+                              .HostMemory("var")                   \
+                              .HostMemory("accum")                 \
+                              .TypeConstraint<T>("T"),             \
+                          VEGroupedApplyMomentumOp<T>);
+
+TF_CALL_float(REGISTER_VE_KERNELS);
+#undef REGISTER_VE_KERNELS
 #endif
 
 // Note, this op works on cpu only.
@@ -3552,6 +3941,100 @@ REGISTER_KERNELS(GPU, complex128);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+#ifdef TENSORFLOW_USE_VE
+template <typename T>
+class VEApplyKerasMomentumOp : public VEOpKernel {
+ public:
+  explicit VEApplyKerasMomentumOp(OpKernelConstruction* ctx)
+      : VEOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const bool sparse = false;
+    auto locks = VEMaybeLockVariableInputMutexesInOrder<T>(
+        ctx, use_exclusive_lock_, sparse, {0, 1});
+
+    Tensor var;
+    OP_REQUIRES_OK(ctx, VEGetInputTensorFromVariable<T>(
+                            ctx, 0, use_exclusive_lock_, sparse, &var));
+    Tensor accum;
+    OP_REQUIRES_OK(ctx, VEGetInputTensorFromVariable<T>(
+                            ctx, 1, use_exclusive_lock_, sparse, &accum));
+    OP_REQUIRES(
+        ctx, var.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(0)));
+    OP_REQUIRES(
+        ctx, accum.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(1)));
+    const Tensor& lr = ctx->input(2);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar: ",
+                                        lr.shape().DebugString()));
+    const Tensor& grad = ctx->input(3);
+    OP_REQUIRES(
+        ctx, var.shape().IsSameSize(accum.shape()),
+        errors::InvalidArgument("var and accum do not have the same shape",
+                                var.shape().DebugString(), " ",
+                                accum.shape().DebugString()));
+    OP_REQUIRES(
+        ctx, var.shape().IsSameSize(grad.shape()),
+        errors::InvalidArgument("var and grad do not have the same shape",
+                                var.shape().DebugString(), " ",
+                                grad.shape().DebugString()));
+
+    const Tensor& momentum = ctx->input(4);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(momentum.shape()),
+                errors::InvalidArgument("momentum is not a scalar: ",
+                                        momentum.shape().DebugString()));
+
+    if (var.NumElements() > 0) {
+      OP_REQUIRES_OK(ctx, Update(ctx, &var, &accum, lr, grad, momentum));
+    }
+  }
+
+ private:
+  // accum = accum * momentum - grad * lr
+  // var += nesterov ? accum * momentum - grad * lr : accum
+  Status Update(OpKernelContext* ctx, Tensor* var, Tensor* accum,
+                const Tensor& lr, const Tensor& grad, const Tensor& momentum) {
+    VEElementwiseChain chain(ctx);
+    Tensor scaled_grad;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                          var->shape(), &scaled_grad));
+    TF_RETURN_IF_ERROR(chain.Binary("Mul", grad, lr, &scaled_grad));
+    TF_RETURN_IF_ERROR(chain.Binary("Mul", *accum, momentum, accum));
+    TF_RETURN_IF_ERROR(chain.Binary("Sub", *accum, scaled_grad, accum));
+    if (!use_nesterov_) {
+      return chain.Binary("Add", *var, *accum, var);
+    }
+    Tensor tmp;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(DataTypeToEnum<T>::value, var->shape(), &tmp));
+    TF_RETURN_IF_ERROR(chain.Binary("Mul", *accum, momentum, &tmp));
+    TF_RETURN_IF_ERROR(chain.Binary("Sub", tmp, scaled_grad, &tmp));
+    return chain.Binary("Add", *var, tmp, var);
+  }
+
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+};
+
+#define REGISTER_VE_KERNELS(T)                                    \
+  REGISTER_KERNEL_BUILDER(Name("ResourceApplyKerasMomentum")      \
+                              .Device(DEVICE_VE)                  \
+                              .HostMemory("var")                  \
+                              .HostMemory("accum")                \
+                              .TypeConstraint<T>("T"),            \
+                          VEApplyKerasMomentumOp<T>);
+
+TF_CALL_float(REGISTER_VE_KERNELS);
+#undef REGISTER_VE_KERNELS
+#endif  // TENSORFLOW_USE_VE
+
 // Note, this op works on cpu only.
 template <typename T, typename Device, typename Tindex>
 class SparseApplyKerasMomentumOp : public OpKernel {
@@ -4645,6 +5128,133 @@ REGISTER_KERNELS(GPU, complex128);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+#ifdef TENSORFLOW_USE_VE
+template <typename T>
+class VEApplyRMSPropOp : public VEOpKernel {
+ public:
+  explicit VEApplyRMSPropOp(OpKernelConstruction* ctx) : VEOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const bool sparse = false;
+    auto locks = VEMaybeLockVariableInputMutexesInOrder<T>(
+        ctx, use_exclusive_lock_, sparse, {0, 1, 2});
+
+    Tensor var;
+    OP_REQUIRES_OK(ctx, VEGetInputTensorFromVariable<T>(
+                            ctx, 0, use_exclusive_lock_, sparse, &var));
+    Tensor ms;
+    OP_REQUIRES_OK(ctx, VEGetInputTensorFromVariable<T>(
+                            ctx, 1, use_exclusive_lock_, sparse, &ms));
+    Tensor mom;
+    OP_REQUIRES_OK(ctx, VEGetInputTensorFromVariable<T>(
+                            ctx, 2, use_exclusive_lock_, sparse, &mom));
+
+    OP_REQUIRES(
+        ctx, var.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(0)));
+    OP_REQUIRES(
+        ctx, ms.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(1)));
+    OP_REQUIRES(
+        ctx, mom.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(2)));
+
+    const Tensor& lr = ctx->input(3);
+    const Tensor& rho = ctx->input(4);
+    const Tensor& momentum = ctx->input(5);
+    const Tensor& epsilon = ctx->input(6);
+    const Tensor& grad = ctx->input(7);
+
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar : ",
+                                        lr.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(rho.shape()),
+                errors::InvalidArgument("rho is not a scalar: ",
+                                        rho.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(momentum.shape()),
+                errors::InvalidArgument("momentum is not a scalar: ",
+                                        momentum.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(epsilon.shape()),
+                errors::InvalidArgument("epsilon is not a scalar: ",
+                                        epsilon.shape().DebugString()));
+
+    OP_REQUIRES(ctx, var.shape().IsSameSize(ms.shape()),
+                errors::InvalidArgument("var and ms do not have the same shape",
+                                        var.shape().DebugString(), " ",
+                                        ms.shape().DebugString()));
+
+    OP_REQUIRES(ctx, var.shape().IsSameSize(mom.shape()),
+                errors::InvalidArgument(
+                    "var and mom do not have the same shape",
+                    var.shape().DebugString(), " ", mom.shape().DebugString()));
+
+    OP_REQUIRES(
+        ctx, var.shape().IsSameSize(grad.shape()),
+        errors::InvalidArgument("var and grad do not have the same shape",
+                                var.shape().DebugString(), " ",
+                                grad.shape().DebugString()));
+
+    if (var.NumElements() > 0) {
+      OP_REQUIRES_OK(ctx, Update(ctx, &var, &ms, &mom, lr, rho, momentum,
+                                 epsilon, grad));
+    }
+
+    MaybeForwardRefInputToRefOutput(ctx, 0, 0);
+  }
+
+ private:
+  // ms = grad^2 + rho * (ms - grad^2), i.e. rho * ms + (1 - rho) * grad^2
+  // mom = momentum * mom + lr * grad * rsqrt(ms + epsilon)
+  // var -= mom
+  Status Update(OpKernelContext* ctx, Tensor* var, Tensor* ms, Tensor* mom,
+                const Tensor& lr, const Tensor& rho, const Tensor& momentum,
+                const Tensor& epsilon, const Tensor& grad) {
+    VEElementwiseChain chain(ctx);
+    Tensor grad_sq;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                          var->shape(), &grad_sq));
+    Tensor tmp;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(DataTypeToEnum<T>::value, var->shape(), &tmp));
+
+    TF_RETURN_IF_ERROR(chain.Unary("Square", grad, &grad_sq));
+    TF_RETURN_IF_ERROR(chain.Binary("Sub", *ms, grad_sq, &tmp));
+    TF_RETURN_IF_ERROR(chain.Binary("Mul", tmp, rho, &tmp));
+    TF_RETURN_IF_ERROR(chain.Binary("Add", grad_sq, tmp, ms));
+
+    TF_RETURN_IF_ERROR(chain.Binary("Add", *ms, epsilon, &tmp));
+    TF_RETURN_IF_ERROR(chain.Unary("Rsqrt", tmp, &tmp));
+    TF_RETURN_IF_ERROR(chain.Binary("Mul", tmp, grad, &tmp));
+    TF_RETURN_IF_ERROR(chain.Binary("Mul", tmp, lr, &tmp));
+    TF_RETURN_IF_ERROR(chain.Binary("Mul", *mom, momentum, mom));
+    TF_RETURN_IF_ERROR(chain.Binary("Add", *mom, tmp, mom));
+    return chain.Binary("Sub", *var, *mom, var);
+  }
+
+  bool use_exclusive_lock_;
+};
+
+#define REGISTER_VE_KERNELS(T)                                         \
+  REGISTER_KERNEL_BUILDER(                                             \
+      Name("ApplyRMSProp").Device(DEVICE_VE).TypeConstraint<T>("T"),   \
+      VEApplyRMSPropOp<T>);                                            \
+  REGISTER_KERNEL_BUILDER(Name("ResourceApplyRMSProp")                 \
+                              .Device(DEVICE_VE)                       \
+                              .HostMemory("var")                       \
+                              .HostMemory("ms")                        \
+                              .HostMemory("mom")                       \
+                              .TypeConstraint<T>("T"),                 \
+                          VEApplyRMSPropOp<T>);
+
+TF_CALL_float(REGISTER_VE_KERNELS);
+#undef REGISTER_VE_KERNELS
+#endif  // TENSORFLOW_USE_VE
+
 // Note, this op works on cpu only.
 template <typename T, typename Tindex>
 class SparseApplyRMSPropOp : public OpKernel {
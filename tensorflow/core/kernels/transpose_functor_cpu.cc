@@ -15,6 +15,7 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <complex>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -71,12 +72,114 @@ void TransposeSimple(const CPUDevice& device, const Tensor& in,
   device.parallelFor(in.NumElements(), cost, std::move(transpose_fn));
 }
 
+// Number of rows and columns in a tile of the tiled transpose. Both the input
+// and the output of a tile stay in L1 cache.
+constexpr int64 kTransposeTileSize = 32;
+
+// Number of rows and columns in a block of a full tile. Loops over a block
+// have constant trip counts, so that they can be unrolled and vectorized.
+constexpr int64 kTransposeBlockSize = 8;
+
+// Transposes a [rows, cols] tile of the input into a [cols, rows] tile of the
+// output.
+template <typename T, bool conjugate>
+inline void TransposeTile(const T* in, int64 in_stride, int64 rows, int64 cols,
+                          T* out, int64 out_stride) {
+  if (rows == kTransposeTileSize && cols == kTransposeTileSize) {
+    for (int64 r = 0; r < kTransposeTileSize; r += kTransposeBlockSize) {
+      for (int64 c = 0; c < kTransposeTileSize; c += kTransposeBlockSize) {
+        const T* in_block = in + r * in_stride + c;
+        T* out_block = out + c * out_stride + r;
+        for (int64 j = 0; j < kTransposeBlockSize; ++j) {
+          for (int64 i = 0; i < kTransposeBlockSize; ++i) {
+            const T& value = in_block[i * in_stride + j];
+            out_block[j * out_stride + i] =
+                conjugate ? Eigen::numext::conj(value) : value;
+          }
+        }
+      }
+    }
+    return;
+  }
+
+  // Partial tile at the boundary of the matrix.
+  for (int64 j = 0; j < cols; ++j) {
+    for (int64 i = 0; i < rows; ++i) {
+      const T& value = in[i * in_stride + j];
+      out[j * out_stride + i] = conjugate ? Eigen::numext::conj(value) : value;
+    }
+  }
+}
+
+// Transposes the two inner dimensions of a [batch, rows, cols] tensor into a
+// [batch, cols, rows] tensor, one tile at a time. Covers matrix transposes,
+// swaps of the inner dimensions of batch matmul operands, and NHWC <-> NCHW
+// layout conversions, which all reduce to this permutation. Work is sharded
+// over batches and rows of tiles.
+template <typename T, bool conjugate>
+void TransposeInnerDimensionsUsingTiles(const CPUDevice& device, const T* in,
+                                        int64 batch, int64 rows, int64 cols,
+                                        T* out) {
+  const int64 row_tiles = (rows + kTransposeTileSize - 1) / kTransposeTileSize;
+  auto transpose_fn = [=](int64 begin, int64 end) {
+    for (int64 unit = begin; unit < end; ++unit) {
+      const int64 b = unit / row_tiles;
+      const int64 r = (unit % row_tiles) * kTransposeTileSize;
+      const int64 num_rows = std::min(kTransposeTileSize, rows - r);
+      const T* in_matrix = in + b * rows * cols;
+      T* out_matrix = out + b * rows * cols;
+      for (int64 c = 0; c < cols; c += kTransposeTileSize) {
+        const int64 num_cols = std::min(kTransposeTileSize, cols - c);
+        TransposeTile<T, conjugate>(in_matrix + r * cols + c, cols, num_rows,
+                                    num_cols, out_matrix + c * rows + r, rows);
+      }
+    }
+  };
+  const int64 elements_per_unit = kTransposeTileSize * cols;
+  Eigen::TensorOpCost cost(/*bytes_loaded=*/sizeof(T) * elements_per_unit,
+                           /*bytes_stored=*/sizeof(T) * elements_per_unit,
+                           /*compute_cycles=*/(conjugate ? 1 : 0) *
+                               elements_per_unit);
+  device.parallelFor(batch * row_tiles, cost, std::move(transpose_fn));
+}
+
+// Uses the tiled transpose if the permutation reduces to a transpose of the
+// two inner dimensions. Returns false otherwise.
+template <typename T, bool conjugate>
+bool TransposeUsingTile(const CPUDevice& device, const Tensor& in,
+                        const gtl::ArraySlice<int32> perm, Tensor* out) {
+  internal::TransposePermsVec new_perm;
+  internal::TransposeDimsVec new_dims;
+  internal::ReduceTransposeDimensions(in.shape(), perm, &new_perm, &new_dims);
+
+  int64 batch, rows, cols;
+  if (new_perm == internal::TransposePermsVec({1, 0})) {
+    batch = 1;
+    rows = new_dims[0];
+    cols = new_dims[1];
+  } else if (new_perm == internal::TransposePermsVec({0, 2, 1})) {
+    batch = new_dims[0];
+    rows = new_dims[1];
+    cols = new_dims[2];
+  } else {
+    return false;
+  }
+
+  const T* p = reinterpret_cast<const T*>(in.tensor_data().data());
+  T* q = reinterpret_cast<T*>(const_cast<char*>((out->tensor_data().data())));
+  TransposeInnerDimensionsUsingTiles<T, conjugate>(device, p, batch, rows,
+                                                   cols, q);
+  return true;
+}
+
 }  // namespace
 
 template <typename T, bool conjugate>
 struct Transpose<CPUDevice, T, conjugate> {
   static void run(const CPUDevice& d, const Tensor& in,
                   const gtl::ArraySlice<int32> perm, Tensor* out) {
+    if (TransposeUsingTile<T, conjugate>(d, in, perm, out)) return;
+
     switch (in.dims()) {
       case 2:
         internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in, perm, conjugate,
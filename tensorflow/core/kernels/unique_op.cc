@@ -13,9 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -24,11 +26,37 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+namespace {
+
+// Vectors with fewer elements than this are deduplicated on a single thread.
+constexpr int64 kMinParallelUniqueSize = 128 * 1024;
+
+// Minimum number of elements in a block of the parallel implementation.
+constexpr int64 kMinParallelUniqueBlockSize = 16 * 1024;
+
+// Maximum number of hash partitions, so that a partition fits into uint8.
+constexpr int kMaxParallelUniquePartitions = 256;
+
+// Finalizer of MurmurHash3, so that both the partition and the slot in the
+// open addressing table can be taken from the bits of a weak hash (e.g. the
+// identity hash of integers).
+inline uint64 MixHash(uint64 h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+}  // namespace
+
 template <typename T, typename TIndex>
 class UniqueOp : public OpKernel {
  public:
@@ -106,26 +134,33 @@ class UniqueOp : public OpKernel {
       auto Tin = input.flat<T>();
       const int64 N = static_cast<int64>(Tin.size());
 
-      std::unordered_map<T, TIndex> uniq;
-      uniq.reserve(2 * N);
-      for (Eigen::Index i = 0, j = 0; i < N; ++i) {
-        auto it = uniq.insert(std::make_pair(Tin(i), j));
-        idx_vec(i) = it.first->second;
-        if (it.second) {
-          ++j;
+      const auto& worker_threads =
+          *(context->device()->tensorflow_cpu_worker_threads());
+      if (N >= kMinParallelUniqueSize && worker_threads.num_threads > 1) {
+        OP_REQUIRES_OK(context, ComputeParallel(context, input, axis, idx_vec,
+                                                &uniq_size));
+      } else {
+        std::unordered_map<T, TIndex> uniq;
+        uniq.reserve(2 * N);
+        for (Eigen::Index i = 0, j = 0; i < N; ++i) {
+          auto it = uniq.insert(std::make_pair(Tin(i), j));
+          idx_vec(i) = it.first->second;
+          if (it.second) {
+            ++j;
+          }
         }
-      }
 
-      uniq_size = static_cast<int64>(uniq.size());
-      TensorShape output_shape(input.shape());
-      output_shape.set_dim(axis, uniq_size);
-      Tensor* output = nullptr;
-      OP_REQUIRES_OK(context,
-                     context->allocate_output(0, output_shape, &output));
-      auto Tout = output->flat<T>();
+        uniq_size = static_cast<int64>(uniq.size());
+        TensorShape output_shape(input.shape());
+        output_shape.set_dim(axis, uniq_size);
+        Tensor* output = nullptr;
+        OP_REQUIRES_OK(context,
+                       context->allocate_output(0, output_shape, &output));
+        auto Tout = output->flat<T>();
 
-      for (auto it : uniq) {
-        Tout(it.second) = it.first;
+        for (auto it : uniq) {
+          Tout(it.second) = it.first;
+        }
       }
     } else {
       // General implementation when unique is run over multiple elements.
@@ -192,6 +227,139 @@ class UniqueOp : public OpKernel {
       }
     }
   }
+
+ private:
+  // Deduplicates the elements of a vector on multiple threads, keeping the
+  // unique elements in the order of their first occurrence:
+  //   (1) Elements are partitioned by their hash, keeping the input order
+  //       within every partition.
+  //   (2) Every partition is deduplicated with an open addressing table, and
+  //       every element is mapped to the position of its first occurrence.
+  //   (3) First occurrences are numbered in the input order, and the positions
+  //       of first occurrences are replaced with their numbers.
+  Status ComputeParallel(OpKernelContext* context, const Tensor& input,
+                         int64 axis, typename TTypes<TIndex>::Vec idx_vec,
+                         int64* uniq_size) {
+    auto Tin = input.flat<T>();
+    const int64 N = static_cast<int64>(Tin.size());
+
+    const auto& worker_threads =
+        *(context->device()->tensorflow_cpu_worker_threads());
+    const int num_partitions =
+        std::min(worker_threads.num_threads, kMaxParallelUniquePartitions);
+    const int64 num_blocks = std::max<int64>(
+        1, std::min<int64>(N / kMinParallelUniqueBlockSize,
+                           4 * worker_threads.num_threads));
+    const int64 block_size = (N + num_blocks - 1) / num_blocks;
+    const int64 cost_per_block = 10 * block_size;
+
+    auto for_each_block = [&](const std::function<void(int64, int64)>& fn) {
+      Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+            cost_per_block, [&](int64 begin, int64 end) {
+              for (int64 b = begin; b < end; ++b) {
+                fn(b * block_size, std::min(N, (b + 1) * block_size));
+              }
+            });
+    };
+    auto block_index = [&](int64 start) { return start / block_size; };
+
+    // (1) Count the elements of every partition in every block, and scatter
+    // the positions of elements into contiguous ranges of their partitions.
+    std::vector<uint8> partition(N);
+    std::vector<int64> offsets(num_blocks * num_partitions, 0);
+    for_each_block([&](int64 start, int64 limit) {
+      int64* counts = &offsets[block_index(start) * num_partitions];
+      for (int64 i = start; i < limit; ++i) {
+        const uint64 h = MixHash(hash<T>{}(Tin(i)));
+        partition[i] = static_cast<uint8>((h >> 32) % num_partitions);
+        ++counts[partition[i]];
+      }
+    });
+
+    std::vector<int64> partition_starts(num_partitions + 1, 0);
+    int64 offset = 0;
+    for (int p = 0; p < num_partitions; ++p) {
+      partition_starts[p] = offset;
+      for (int64 b = 0; b < num_blocks; ++b) {
+        const int64 count = offsets[b * num_partitions + p];
+        offsets[b * num_partitions + p] = offset;
+        offset += count;
+      }
+    }
+    partition_starts[num_partitions] = offset;
+
+    std::vector<int32> order(N);
+    for_each_block([&](int64 start, int64 limit) {
+      int64* block_offsets = &offsets[block_index(start) * num_partitions];
+      for (int64 i = start; i < limit; ++i) {
+        order[block_offsets[partition[i]]++] = static_cast<int32>(i);
+      }
+    });
+
+    // (2) Map every element to the position of its first occurrence.
+    const int64 cost_per_partition = 20 * N / num_partitions;
+    Shard(worker_threads.num_threads, worker_threads.workers, num_partitions,
+          cost_per_partition, [&](int64 begin, int64 end) {
+            std::vector<int32> table;
+            for (int64 p = begin; p < end; ++p) {
+              const int64 size = partition_starts[p + 1] - partition_starts[p];
+              uint64 capacity = 16;
+              while (capacity < 2 * static_cast<uint64>(size)) capacity <<= 1;
+              const uint64 mask = capacity - 1;
+              table.assign(capacity, -1);
+
+              for (int64 k = partition_starts[p]; k < partition_starts[p + 1];
+                   ++k) {
+                const int32 i = order[k];
+                uint64 slot = MixHash(hash<T>{}(Tin(i))) & mask;
+                while (table[slot] >= 0 && !(Tin(table[slot]) == Tin(i))) {
+                  slot = (slot + 1) & mask;
+                }
+                if (table[slot] < 0) table[slot] = i;
+                idx_vec(i) = table[slot];
+              }
+            }
+          });
+
+    // (3) Number the first occurrences in the input order.
+    std::vector<int64> block_unique_starts(num_blocks + 1, 0);
+    for_each_block([&](int64 start, int64 limit) {
+      int64 count = 0;
+      for (int64 i = start; i < limit; ++i) {
+        if (idx_vec(i) == i) ++count;
+      }
+      block_unique_starts[block_index(start) + 1] = count;
+    });
+    for (int64 b = 0; b < num_blocks; ++b) {
+      block_unique_starts[b + 1] += block_unique_starts[b];
+    }
+    *uniq_size = block_unique_starts[num_blocks];
+
+    TensorShape output_shape(input.shape());
+    output_shape.set_dim(axis, *uniq_size);
+    Tensor* output = nullptr;
+    TF_RETURN_IF_ERROR(context->allocate_output(0, output_shape, &output));
+    auto Tout = output->flat<T>();
+
+    std::vector<TIndex> unique_ids(N);
+    for_each_block([&](int64 start, int64 limit) {
+      TIndex id = block_unique_starts[block_index(start)];
+      for (int64 i = start; i < limit; ++i) {
+        if (idx_vec(i) == i) {
+          unique_ids[i] = id;
+          Tout(id) = Tin(i);
+          ++id;
+        }
+      }
+    });
+    for_each_block([&](int64 start, int64 limit) {
+      for (int64 i = start; i < limit; ++i) {
+        idx_vec(i) = unique_ids[idx_vec(i)];
+      }
+    });
+
+    return Status::OK();
+  }
 };
 
 #define REGISTER_UNIQUE(type)                                    \
@@ -15,10 +15,15 @@ limitations under the License.
 
 #include <functional>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/node_builder.h"
@@ -26,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -62,6 +68,78 @@ TensorProto GetRandomInt32TensorProtoWithRepeat(int dim, int repeat,
   return tensor_proto;
 }
 
+class UniqueOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const string& op, DataType dtype) {
+    TF_EXPECT_OK(NodeDefBuilder("unique_op", op)
+                     .Input(FakeInput(dtype))
+                     .Attr("out_idx", DT_INT32)
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+};
+
+// Computes the expected outputs of UniqueWithCounts.
+template <typename T>
+void ExpectedUnique(const std::vector<T>& input, std::vector<T>* y,
+                    std::vector<int32>* idx, std::vector<int32>* count) {
+  std::unordered_map<T, int32> ids;
+  for (const T& value : input) {
+    auto it = ids.insert({value, static_cast<int32>(y->size())});
+    if (it.second) {
+      y->push_back(value);
+      count->push_back(0);
+    }
+    idx->push_back(it.first->second);
+    ++(*count)[it.first->second];
+  }
+}
+
+TEST_F(UniqueOpTest, ParallelKeepsFirstOccurrenceOrder) {
+  MakeOp("UniqueWithCounts", DT_INT64);
+
+  // Large enough to use the parallel implementation.
+  const int kSize = 300 * 1000;
+  std::vector<int64> input(kSize);
+  for (int i = 0; i < kSize; ++i) {
+    input[i] = (static_cast<int64>(i) * 7919) % 50021 - 25000;
+  }
+  AddInputFromArray<int64>(TensorShape({kSize}), input);
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<int64> y;
+  std::vector<int32> idx, count;
+  ExpectedUnique(input, &y, &idx, &count);
+  const int64 num_unique = y.size();
+  test::ExpectTensorEqual<int64>(
+      test::AsTensor<int64>(y, TensorShape({num_unique})), *GetOutput(0));
+  test::ExpectTensorEqual<int32>(
+      test::AsTensor<int32>(idx, TensorShape({kSize})), *GetOutput(1));
+  test::ExpectTensorEqual<int32>(
+      test::AsTensor<int32>(count, TensorShape({num_unique})), *GetOutput(2));
+}
+
+TEST_F(UniqueOpTest, ParallelStrings) {
+  MakeOp("Unique", DT_STRING);
+
+  const int kSize = 200 * 1000;
+  std::vector<tstring> input(kSize);
+  for (int i = 0; i < kSize; ++i) {
+    input[i] = strings::StrCat("id_", (i * 31) % 1000);
+  }
+  AddInputFromArray<tstring>(TensorShape({kSize}), input);
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<tstring> y;
+  std::vector<int32> idx, count;
+  ExpectedUnique(input, &y, &idx, &count);
+  const int64 num_unique = y.size();
+  test::ExpectTensorEqual<tstring>(
+      test::AsTensor<tstring>(y, TensorShape({num_unique})), *GetOutput(0));
+  test::ExpectTensorEqual<int32>(
+      test::AsTensor<int32>(idx, TensorShape({kSize})), *GetOutput(1));
+}
+
 static void BM_Unique_INT32(int iters, int dim, int max_int) {
   testing::StopTiming();
   Graph* g = new Graph(OpRegistry::Global());
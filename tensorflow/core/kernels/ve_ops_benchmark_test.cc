@@ -0,0 +1,436 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of kernels on VE. Compute bound kernels report items/s as
+// FLOP/s, and memory bound kernels report bytes/s.
+//
+// Batched and synchronous dispatch are compared by running the benchmarks
+// with and without TF_VE_SYNC=1, BM_VEDispatch in particular. BM_VECopy
+// measures copies between host and VE around TF_DMA_THRESHOLD.
+//
+//   bazel run -c opt --config=ve :ve_ops_benchmark_test -- --benchmarks=all
+
+#ifdef TENSORFLOW_USE_VE
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/bcast.h"
+
+namespace tensorflow {
+
+static Node* Random(Graph* g, const TensorShape& shape) {
+  Tensor data(DT_FLOAT, shape);
+  data.flat<float>().setRandom();
+  return test::graph::Constant(g, data);
+}
+
+static Node* Zeros(Graph* g, const TensorShape& shape) {
+  Tensor data(DT_FLOAT, shape);
+  data.flat<float>().setZero();
+  return test::graph::Constant(g, data);
+}
+
+static Node* Scalar(Graph* g, float val) {
+  Tensor data(DT_FLOAT, TensorShape({}));
+  data.flat<float>()(0) = val;
+  return test::graph::Constant(g, data);
+}
+
+static Node* Var(Graph* g, int n) {
+  return test::graph::Var(g, DT_FLOAT, TensorShape({n}));
+}
+
+// Conv2D and its backprops with SAME padding and stride 1 in NHWC.
+
+enum class ConvKind { kForward, kBackpropInput, kBackpropFilter };
+
+static Graph* Conv2D(ConvKind kind, int batch, int size, int in_depth,
+                     int filter, int out_depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  TensorShape input_shape({batch, size, size, in_depth});
+  TensorShape filter_shape({filter, filter, in_depth, out_depth});
+  TensorShape output_shape({batch, size, size, out_depth});
+  const std::vector<int32> strides = {1, 1, 1, 1};
+
+  Node* ret;
+  switch (kind) {
+    case ConvKind::kForward:
+      TF_CHECK_OK(NodeBuilder(g->NewName("conv"), "Conv2D")
+                      .Input(Random(g, input_shape))
+                      .Input(Random(g, filter_shape))
+                      .Attr("T", DT_FLOAT)
+                      .Attr("strides", strides)
+                      .Attr("padding", "SAME")
+                      .Finalize(g, &ret));
+      break;
+    case ConvKind::kBackpropInput:
+      TF_CHECK_OK(
+          NodeBuilder(g->NewName("conv"), "Conv2DBackpropInput")
+              .Input(test::graph::Constant(
+                  g, test::AsTensor<int32>({batch, size, size, in_depth})))
+              .Input(Random(g, filter_shape))
+              .Input(Random(g, output_shape))
+              .Attr("T", DT_FLOAT)
+              .Attr("strides", strides)
+              .Attr("padding", "SAME")
+              .Finalize(g, &ret));
+      break;
+    case ConvKind::kBackpropFilter:
+      TF_CHECK_OK(
+          NodeBuilder(g->NewName("conv"), "Conv2DBackpropFilter")
+              .Input(Random(g, input_shape))
+              .Input(test::graph::Constant(
+                  g, test::AsTensor<int32>(
+                         {filter, filter, in_depth, out_depth})))
+              .Input(Random(g, output_shape))
+              .Attr("T", DT_FLOAT)
+              .Attr("strides", strides)
+              .Attr("padding", "SAME")
+              .Finalize(g, &ret));
+      break;
+  }
+  return g;
+}
+
+#define BM_VEConv2DKind(KIND, N, S, C, F, K)                               \
+  static void BM_VEConv2D##KIND##_##N##_##S##_##C##_##F##_##K(int iters) { \
+    testing::UseRealTime();                                                \
+    testing::ItemsProcessed(static_cast<int64>(iters) * 2 * N * S * S *    \
+                            F * F * C * K);                                \
+    test::Benchmark("ve", Conv2D(ConvKind::k##KIND, N, S, C, F, K))       \
+        .Run(iters);                                                       \
+  }                                                                        \
+  BENCHMARK(BM_VEConv2D##KIND##_##N##_##S##_##C##_##F##_##K);
+
+#define BM_VEConv2D(N, S, C, F, K)              \
+  BM_VEConv2DKind(Forward, N, S, C, F, K)       \
+  BM_VEConv2DKind(BackpropInput, N, S, C, F, K) \
+  BM_VEConv2DKind(BackpropFilter, N, S, C, F, K)
+
+// Layers of ResNet-50.
+BM_VEConv2D(32, 56, 64, 3, 64);
+BM_VEConv2D(32, 28, 128, 3, 128);
+BM_VEConv2D(32, 14, 256, 3, 256);
+BM_VEConv2D(32, 7, 512, 3, 512);
+BM_VEConv2D(32, 56, 64, 1, 256);
+
+// MatMul and BatchMatMul.
+
+static Graph* Matmul(int m, int k, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Matmul(g, Random(g, TensorShape({m, k})),
+                      Random(g, TensorShape({k, n})), false, false);
+  return g;
+}
+
+#define BM_VEMatmul(M, K, N)                                                 \
+  static void BM_VEMatmul##_##M##_##K##_##N(int iters) {                     \
+    testing::UseRealTime();                                                  \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);      \
+    test::Benchmark("ve", Matmul(M, K, N)).Run(iters);                       \
+  }                                                                          \
+  BENCHMARK(BM_VEMatmul##_##M##_##K##_##N);
+
+BM_VEMatmul(128, 1024, 1024);
+BM_VEMatmul(1024, 1024, 1024);
+BM_VEMatmul(4096, 4096, 4096);
+BM_VEMatmul(32, 4096, 1000);
+
+static Graph* BatchMatmul(int b, int m, int k, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::BatchMatmul(g, Random(g, TensorShape({b, m, k})),
+                           Random(g, TensorShape({b, k, n})), false, false);
+  return g;
+}
+
+#define BM_VEBatchMatmul(B, M, K, N)                                       \
+  static void BM_VEBatchMatmul##_##B##_##M##_##K##_##N(int iters) {        \
+    testing::UseRealTime();                                                \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B * M * K * N * 2); \
+    test::Benchmark("ve", BatchMatmul(B, M, K, N)).Run(iters);             \
+  }                                                                        \
+  BENCHMARK(BM_VEBatchMatmul##_##B##_##M##_##K##_##N);
+
+BM_VEBatchMatmul(64, 128, 128, 128);
+BM_VEBatchMatmul(16, 512, 512, 512);
+BM_VEBatchMatmul(256, 64, 64, 64);
+
+// Binary ops with broadcasting. Bytes are read and written elements.
+
+static Graph* Binary(const string& func, const TensorShape& lhs,
+                     const TensorShape& rhs) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Binary(g, func, Random(g, lhs), Random(g, rhs));
+  return g;
+}
+
+static void BM_VEBinary(int iters, const string& func, const TensorShape& lhs,
+                        const TensorShape& rhs) {
+  testing::UseRealTime();
+  BCast bcast(BCast::FromShape(lhs), BCast::FromShape(rhs));
+  CHECK(bcast.IsValid());
+  int64 out = BCast::ToShape(bcast.output_shape()).num_elements();
+  int64 elems = lhs.num_elements() + rhs.num_elements() + out;
+  testing::ItemsProcessed(static_cast<int64>(iters) * out);
+  testing::BytesProcessed(static_cast<int64>(iters) * elems * sizeof(float));
+  test::Benchmark("ve", Binary(func, lhs, rhs)).Run(iters);
+}
+
+static void BM_VEAddSame(int iters, int n) {
+  BM_VEBinary(iters, "Add", TensorShape({n}), TensorShape({n}));
+}
+BENCHMARK(BM_VEAddSame)->Arg(1 << 10)->Arg(1 << 20)->Arg(16 << 20);
+
+static void BM_VEAddScalar(int iters, int n) {
+  BM_VEBinary(iters, "Add", TensorShape({n}), TensorShape({}));
+}
+BENCHMARK(BM_VEAddScalar)->Arg(1 << 10)->Arg(1 << 20)->Arg(16 << 20);
+
+static void BM_VEMulRow(int iters, int rows, int cols) {
+  BM_VEBinary(iters, "Mul", TensorShape({rows, cols}), TensorShape({cols}));
+}
+BENCHMARK(BM_VEMulRow)->ArgPair(4096, 64)->ArgPair(512, 2048);
+
+static void BM_VEMulColumn(int iters, int rows, int cols) {
+  BM_VEBinary(iters, "Mul", TensorShape({rows, cols}),
+              TensorShape({rows, 1}));
+}
+BENCHMARK(BM_VEMulColumn)->ArgPair(4096, 64)->ArgPair(512, 2048);
+
+static void BM_VESub3D(int iters, int n) {
+  BM_VEBinary(iters, "Sub", TensorShape({n, 1, 256}),
+              TensorShape({1, n, 256}));
+}
+BENCHMARK(BM_VESub3D)->Arg(16)->Arg(128);
+
+// Reductions over a [rows, cols] tensor.
+
+static Graph* Reduce(const string& reduce, int rows, int cols,
+                     const std::vector<int32>& axes) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor axes_t(DT_INT32, TensorShape({static_cast<int64>(axes.size())}));
+  for (size_t i = 0; i < axes.size(); ++i) axes_t.flat<int32>()(i) = axes[i];
+  test::graph::Reduce(g, reduce, Random(g, TensorShape({rows, cols})),
+                      test::graph::Constant(g, axes_t));
+  return g;
+}
+
+#define BM_VEReduce(NAME, REDUCE, AXES)                                     \
+  static void BM_VE##NAME(int iters, int rows, int cols) {                  \
+    testing::UseRealTime();                                                 \
+    testing::BytesProcessed(static_cast<int64>(iters) * rows * cols *       \
+                            sizeof(float));                                 \
+    test::Benchmark("ve", Reduce(REDUCE, rows, cols, AXES)).Run(iters);     \
+  }                                                                         \
+  BENCHMARK(BM_VE##NAME)                                                    \
+      ->ArgPair(1024, 1024)                                                 \
+      ->ArgPair(32, 1 << 16)                                                \
+      ->ArgPair(1 << 16, 32);
+
+BM_VEReduce(SumRows, "Sum", std::vector<int32>({1}));
+BM_VEReduce(SumColumns, "Sum", std::vector<int32>({0}));
+BM_VEReduce(SumAll, "Sum", std::vector<int32>({0, 1}));
+BM_VEReduce(MeanRows, "Mean", std::vector<int32>({1}));
+BM_VEReduce(MaxRows, "Max", std::vector<int32>({1}));
+
+// Transpose.
+
+static Graph* Transpose(const TensorShape& shape,
+                        const std::vector<int32>& perm) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("transpose"), "Transpose")
+                  .Input(Random(g, shape))
+                  .Input(test::graph::Constant(g, test::AsTensor<int32>(perm)))
+                  .Finalize(g, &ret));
+  return g;
+}
+
+static void BM_VETranspose2D(int iters, int rows, int cols) {
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * rows * cols * 2 *
+                          sizeof(float));
+  test::Benchmark("ve", Transpose(TensorShape({rows, cols}), {1, 0}))
+      .Run(iters);
+}
+BENCHMARK(BM_VETranspose2D)->ArgPair(1024, 1024)->ArgPair(64, 16384);
+
+// NHWC to NCHW.
+static void BM_VETransposeNHWCToNCHW(int iters, int size, int depth) {
+  testing::UseRealTime();
+  const int batch = 32;
+  testing::BytesProcessed(static_cast<int64>(iters) * batch * size * size *
+                          depth * 2 * sizeof(float));
+  test::Benchmark("ve", Transpose(TensorShape({batch, size, size, depth}),
+                                  {0, 3, 1, 2}))
+      .Run(iters);
+}
+BENCHMARK(BM_VETransposeNHWCToNCHW)->ArgPair(56, 64)->ArgPair(14, 256);
+
+// Optimizer apply ops. Bytes are read and written parameters.
+
+static void BM_VEApply(int iters, int n, int num_vars, int num_reads,
+                       const string& op,
+                       const std::function<std::vector<Node*>(
+                           Graph*, const std::vector<Node*>&)>& inputs) {
+  testing::UseRealTime();
+  testing::ItemsProcessed(static_cast<int64>(iters) * n);
+  testing::BytesProcessed(static_cast<int64>(iters) * n * num_reads *
+                          sizeof(float));
+
+  // Variables are shared by name, so they are created first in both graphs.
+  Graph* init = new Graph(OpRegistry::Global());
+  {
+    std::vector<Node*> vars;
+    for (int i = 0; i < num_vars; ++i) vars.push_back(Var(init, n));
+    Node* zero = Zeros(init, TensorShape({n}));
+    for (Node* var : vars) test::graph::Assign(init, var, zero);
+  }
+  Graph* train = new Graph(OpRegistry::Global());
+  {
+    std::vector<Node*> vars;
+    for (int i = 0; i < num_vars; ++i) vars.push_back(Var(train, n));
+    test::graph::Multi(train, op, inputs(train, vars));
+  }
+  test::Benchmark("ve", train, nullptr, init).Run(iters);
+}
+
+static void BM_VEApplyGradientDescent(int iters, int n) {
+  BM_VEApply(iters, n, 1, 3, "ApplyGradientDescent",
+             [n](Graph* g, const std::vector<Node*>& vars) {
+               return std::vector<Node*>(
+                   {vars[0], Scalar(g, 0.01), Random(g, TensorShape({n}))});
+             });
+}
+BENCHMARK(BM_VEApplyGradientDescent)->Arg(128 << 10)->Arg(16 << 20);
+
+static void BM_VEApplyMomentum(int iters, int n) {
+  BM_VEApply(iters, n, 2, 5, "ApplyMomentum",
+             [n](Graph* g, const std::vector<Node*>& vars) {
+               return std::vector<Node*>({vars[0], vars[1], Scalar(g, 0.01),
+                                          Random(g, TensorShape({n})),
+                                          Scalar(g, 0.9)});
+             });
+}
+BENCHMARK(BM_VEApplyMomentum)->Arg(128 << 10)->Arg(16 << 20);
+
+static void BM_VEApplyAdam(int iters, int n) {
+  BM_VEApply(iters, n, 3, 7, "ApplyAdam",
+             [n](Graph* g, const std::vector<Node*>& vars) {
+               return std::vector<Node*>(
+                   {vars[0], vars[1], vars[2], Scalar(g, 0.9),
+                    Scalar(g, 0.99), Scalar(g, 0.01), Scalar(g, 0.9),
+                    Scalar(g, 0.99), Scalar(g, 1e-8),
+                    Random(g, TensorShape({n}))});
+             });
+}
+BENCHMARK(BM_VEApplyAdam)->Arg(128 << 10)->Arg(16 << 20);
+
+// A chain of small kernels to measure the dispatch overhead per kernel.
+// Items are kernels.
+static Graph* AddChain(int num_kernels, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* x = Random(g, TensorShape({n}));
+  Node* y = Random(g, TensorShape({n}));
+  for (int i = 0; i < num_kernels; ++i) x = test::graph::Add(g, x, y);
+  return g;
+}
+
+static void BM_VEDispatch(int iters, int num_kernels) {
+  testing::UseRealTime();
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_kernels);
+  test::Benchmark("ve", AddChain(num_kernels, 256)).Run(iters);
+}
+BENCHMARK(BM_VEDispatch)->Arg(1)->Arg(16)->Arg(256);
+
+// Copies between host and VE. When `pinned` is true, the host buffer is
+// allocated by the VE host allocator which VE can DMA directly. Otherwise
+// copies larger than TF_DMA_THRESHOLD go through the staging buffer.
+
+static void BM_VECopy(int iters, int bytes, bool pinned, bool htod) {
+  testing::StopTiming();
+  std::unique_ptr<Device> device = DeviceFactory::NewDevice(
+      "VE", SessionOptions(), "/job:localhost/replica:0/task:0");
+  CHECK(device) << "Could not create a VE device";
+  DeviceContext* ctx = device->tensorflow_gpu_device_info()->default_context;
+
+  AllocatorAttributes host_attr;
+  host_attr.set_on_host(true);
+  host_attr.set_gpu_compatible(pinned);
+  Tensor host(device->GetAllocator(host_attr), DT_INT8, TensorShape({bytes}));
+  Tensor dev(device->GetAllocator(AllocatorAttributes()), DT_INT8,
+             TensorShape({bytes}));
+  host.flat<int8>().setZero();
+
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * bytes);
+  testing::StartTiming();
+  BlockingCounter counter(iters);
+  auto done = [&counter](const Status& s) {
+    TF_CHECK_OK(s);
+    counter.DecrementCount();
+  };
+  for (int i = 0; i < iters; ++i) {
+    if (htod)
+      ctx->CopyCPUTensorToDevice(&host, device.get(), &dev, done);
+    else
+      ctx->CopyDeviceTensorToCPU(&dev, "", device.get(), &host, done);
+  }
+  counter.Wait();
+  testing::StopTiming();
+}
+
+static void BM_VECopyHtoD(int iters, int bytes, int pinned) {
+  BM_VECopy(iters, bytes, pinned, true);
+}
+
+static void BM_VECopyDtoH(int iters, int bytes, int pinned) {
+  BM_VECopy(iters, bytes, pinned, false);
+}
+
+// Sizes around the default TF_DMA_THRESHOLD of 256KB.
+#define BM_VECopySizes(BM)                                               \
+  BENCHMARK(BM)                                                          \
+      ->ArgPair(4 << 10, 0)                                              \
+      ->ArgPair(64 << 10, 0)                                             \
+      ->ArgPair(128 << 10, 0)                                            \
+      ->ArgPair(256 << 10, 0)                                            \
+      ->ArgPair(512 << 10, 0)                                            \
+      ->ArgPair(1 << 20, 0)                                              \
+      ->ArgPair(16 << 20, 0)                                             \
+      ->ArgPair(64 << 20, 0)                                             \
+      ->ArgPair(256 << 10, 1)                                            \
+      ->ArgPair(1 << 20, 1)                                              \
+      ->ArgPair(16 << 20, 1)                                             \
+      ->ArgPair(64 << 20, 1);
+
+BM_VECopySizes(BM_VECopyHtoD);
+BM_VECopySizes(BM_VECopyDtoH);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_VE
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_WINOGRAD_TRANSFORM_H_
 #define TENSORFLOW_CORE_KERNELS_WINOGRAD_TRANSFORM_H_
 
+#include <memory>
+
 #include "tensorflow/core/kernels/deep_conv2d.h"
 
 namespace tensorflow {
@@ -372,6 +374,147 @@ void WinogradTransform<T>::GetOutputTransformMatrix(const int64 rows,
   transform_matrix[3 * cols + 15] = T(1.0);
 };
 
+// Winograd F(4x4, 3x3) DeepConv2DTransform implementation for 3x3 filters.
+// Computes 4x4 output tiles from 6x6 input tiles, which takes 36 products per
+// 16 outputs (vs. 16 products per 4 outputs for WinogradTransform above), at
+// the cost of larger input/output transforms and lower numerical precision.
+
+template <typename T>
+class Winograd4x4Transform : public DeepConv2DTransform<T> {
+ public:
+  typedef typename DeepConv2DTransform<T>::Shape Shape;
+
+  Winograd4x4Transform()
+      : filter_shape_(3, 3), input_shape_(6, 6), output_shape_(4, 4) {}
+
+  virtual void GetFilterTransformMatrix(const int64 rows, const int64 cols,
+                                        T* transform_matrix) const;
+
+  virtual void GetInputTransformMatrix(const int64 rows, const int64 cols,
+                                       T* transform_matrix) const;
+
+  virtual void GetOutputTransformMatrix(const int64 rows, const int64 cols,
+                                        T* transform_matrix) const;
+
+  virtual const Shape& filter_shape() const { return filter_shape_; }
+  virtual const Shape& input_shape() const { return input_shape_; }
+  virtual const Shape& output_shape() const { return output_shape_; }
+
+ private:
+  // Writes the kronecker product 'M * M' of the row-major matrix 'M'
+  // [m_rows, m_cols] into 'transform_matrix' [m_rows^2, m_cols^2].
+  static void ComputeKroneckerProduct(const double* m, const int64 m_rows,
+                                      const int64 m_cols, const int64 rows,
+                                      const int64 cols, T* transform_matrix) {
+    CHECK_EQ(rows, m_rows * m_rows);
+    CHECK_EQ(cols, m_cols * m_cols);
+    for (int64 i0 = 0; i0 < m_rows; ++i0) {
+      for (int64 i1 = 0; i1 < m_rows; ++i1) {
+        for (int64 j0 = 0; j0 < m_cols; ++j0) {
+          for (int64 j1 = 0; j1 < m_cols; ++j1) {
+            const int64 row = i0 * m_rows + i1;
+            const int64 col = j0 * m_cols + j1;
+            transform_matrix[row * cols + col] =
+                T(m[i0 * m_cols + j0] * m[i1 * m_cols + j1]);
+          }
+        }
+      }
+    }
+  }
+
+  const Shape filter_shape_;
+  const Shape input_shape_;
+  const Shape output_shape_;
+};
+
+// The filter transform matrix is the kronecker product 'M * M' of the
+// following matrix 'M':
+//
+//   [ 1/4     0     0   ]
+//   [-1/6  -1/6  -1/6   ]
+//   [-1/6   1/6  -1/6   ]
+//   [ 1/24  1/12  1/6   ]
+//   [ 1/24 -1/12  1/6   ]
+//   [ 0     0     1     ]
+//
+// The data layout of 'transform_matrix':
+//   [input_tile_spatial_size, filter_spatial_size]
+//
+template <typename T>
+void Winograd4x4Transform<T>::GetFilterTransformMatrix(
+    const int64 rows, const int64 cols, T* transform_matrix) const {
+  static constexpr double kMatrix[] = {
+      1.0 / 4,  0.0,       0.0,       //
+      -1.0 / 6, -1.0 / 6,  -1.0 / 6,  //
+      -1.0 / 6, 1.0 / 6,   -1.0 / 6,  //
+      1.0 / 24, 1.0 / 12,  1.0 / 6,   //
+      1.0 / 24, -1.0 / 12, 1.0 / 6,   //
+      0.0,      0.0,       1.0};
+  ComputeKroneckerProduct(kMatrix, 6, 3, rows, cols, transform_matrix);
+}
+
+// The input transform matrix is the kronecker product 'M * M' of the
+// following matrix 'M':
+//
+//   [4   0  -5   0   1   0]
+//   [0  -4  -4   1   1   0]
+//   [0   4  -4  -1   1   0]
+//   [0  -2  -1   2   1   0]
+//   [0   2  -1  -2   1   0]
+//   [0   4   0  -5   0   1]
+//
+// Data layout of 'transform_matrix':
+//   [tile_spatial_size, tile_spatial_size]
+//
+template <typename T>
+void Winograd4x4Transform<T>::GetInputTransformMatrix(
+    const int64 rows, const int64 cols, T* transform_matrix) const {
+  static constexpr double kMatrix[] = {
+      4, 0,  -5, 0,  1, 0,  //
+      0, -4, -4, 1,  1, 0,  //
+      0, 4,  -4, -1, 1, 0,  //
+      0, -2, -1, 2,  1, 0,  //
+      0, 2,  -1, -2, 1, 0,  //
+      0, 4,  0,  -5, 0, 1};
+  ComputeKroneckerProduct(kMatrix, 6, 6, rows, cols, transform_matrix);
+}
+
+// The output transform matrix is the kronecker product 'M * M' of the
+// following matrix 'M':
+//
+//   [1  1  1  1  1  0]
+//   [0  1 -1  2 -2  0]
+//   [0  1  1  4  4  0]
+//   [0  1 -1  8 -8  1]
+//
+// Data layout of 'transform_matrix':
+//   [out_tile_spatial_size, tile_spatial_size]
+//
+template <typename T>
+void Winograd4x4Transform<T>::GetOutputTransformMatrix(
+    const int64 rows, const int64 cols, T* transform_matrix) const {
+  static constexpr double kMatrix[] = {
+      1, 1, 1,  1, 1,  0,  //
+      0, 1, -1, 2, -2, 0,  //
+      0, 1, 1,  4, 4,  0,  //
+      0, 1, -1, 8, -8, 1};
+  ComputeKroneckerProduct(kMatrix, 4, 6, rows, cols, transform_matrix);
+}
+
+// Returns a new DeepConv2DTransform of the given type.
+template <typename T>
+std::unique_ptr<DeepConv2DTransform<T>> NewDeepConv2DTransform(
+    DeepConv2DTransformType type) {
+  switch (type) {
+    case DeepConv2DTransformType::kWinograd4x4:
+      return std::unique_ptr<DeepConv2DTransform<T>>(
+          new Winograd4x4Transform<T>);
+    case DeepConv2DTransformType::kWinograd2x2:
+    default:
+      return std::unique_ptr<DeepConv2DTransform<T>>(new WinogradTransform<T>);
+  }
+}
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_KERNELS_WINOGRAD_TRANSFORM_H_
@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/synchronization/blocking_counter.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
@@ -370,6 +371,23 @@ TEST(ThreadPool, Parallelism) {
   }
 }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+TEST(ThreadPool, PinsThreadsToCPUs) {
+  ThreadOptions thread_options;
+  thread_options.cpus = {0};
+  std::atomic<int> unpinned(0);
+  {
+    ThreadPool pool(Env::Default(), thread_options, "test", 4);
+    for (int i = 0; i < 100; ++i) {
+      pool.Schedule([&unpinned]() {
+        if (port::GetCurrentCPU() != 0) ++unpinned;
+      });
+    }
+  }
+  EXPECT_EQ(0, unpinned);
+}
+#endif
+
 static void BM_Sequential(int iters) {
   ThreadPool pool(Env::Default(), "test", kNumThreads);
   // Decrement count sequentially until 0.
@@ -0,0 +1,175 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+// The reads are I/O bound, so the pool is sized by the number of requests
+// worth keeping in flight rather than by the number of cores.
+constexpr int kNumReadAheadThreads = 32;
+
+thread::ThreadPool* ReadAheadThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "read_ahead_inputstream", kNumReadAheadThreads);
+  return pool;
+}
+
+}  // namespace
+
+ReadAheadInputStream::ReadAheadInputStream(RandomAccessFile* file,
+                                           size_t chunk_size, int window)
+    : file_(file),
+      chunk_size_(std::max<size_t>(chunk_size, 1)),
+      window_(std::max(window, 1)) {
+  mutex_lock l(mu_);
+  IssueReads();
+}
+
+ReadAheadInputStream::~ReadAheadInputStream() {
+  mutex_lock l(mu_);
+  DropChunks();
+  // The reads in flight write to `file_` and use `mu_`.
+  while (num_outstanding_ > 0) {
+    cond_var_.wait(l);
+  }
+}
+
+void ReadAheadInputStream::IssueReads() {
+  while (!eof_ && chunks_.size() < static_cast<size_t>(window_)) {
+    auto chunk = std::make_shared<Chunk>(next_offset_);
+    next_offset_ += chunk_size_;
+    chunks_.push_back(chunk);
+    ++num_outstanding_;
+    ReadAheadThreadPool()->Schedule([this, chunk]() {
+      string data;
+      data.resize(chunk_size_);
+      StringPiece result;
+      Status s = file_->Read(chunk->offset, chunk_size_, &result, &data[0]);
+      if (result.data() == data.data()) {
+        data.resize(result.size());
+      } else {
+        data.assign(result.data(), result.size());
+      }
+      mutex_lock l(mu_);
+      chunk->data = std::move(data);
+      chunk->status = s;
+      chunk->done = true;
+      --num_outstanding_;
+      cond_var_.notify_all();
+    });
+  }
+}
+
+void ReadAheadInputStream::DropChunks() { chunks_.clear(); }
+
+Status ReadAheadInputStream::Consume(int64 bytes, tstring* result,
+                                     mutex_lock* l) {
+  while (bytes > 0) {
+    if (chunks_.empty()) {
+      IssueReads();
+      if (chunks_.empty()) {
+        return errors::OutOfRange("reached end of file");
+      }
+    }
+    std::shared_ptr<Chunk> chunk = chunks_.front();
+    while (!chunk->done) {
+      cond_var_.wait(*l);
+    }
+    if (!chunk->status.ok() && !errors::IsOutOfRange(chunk->status)) {
+      return chunk->status;
+    }
+    const int64 start = pos_ - chunk->offset;
+    const int64 available = static_cast<int64>(chunk->data.size()) - start;
+    if (available > 0) {
+      const int64 n = std::min(available, bytes);
+      if (result != nullptr) {
+        result->append(chunk->data.data() + start, n);
+      }
+      pos_ += n;
+      bytes -= n;
+    }
+    if (pos_ == chunk->offset + static_cast<int64>(chunk->data.size())) {
+      if (chunk->data.size() < chunk_size_) {
+        // Every chunk after this one starts past the end of the file.
+        eof_ = true;
+        DropChunks();
+      } else {
+        chunks_.pop_front();
+        IssueReads();
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status ReadAheadInputStream::ReadNBytes(int64 bytes_to_read, tstring* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  result->clear();
+  mutex_lock l(mu_);
+  return Consume(bytes_to_read, result, &l);
+}
+
+Status ReadAheadInputStream::SkipNBytes(int64 bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes");
+  }
+  mutex_lock l(mu_);
+  const int64 target = pos_ + bytes_to_skip;
+  if (!eof_ && target > next_offset_) {
+    // Skipping past everything requested so far: abandon the window and, if
+    // the target lies within the file, restart reading from there.
+    DropChunks();
+    char scratch;
+    StringPiece data;
+    Status s = file_->Read(target - 1, 1, &data, &scratch);
+    if ((s.ok() || errors::IsOutOfRange(s)) && data.size() == 1) {
+      pos_ = target;
+      next_offset_ = target;
+      IssueReads();
+      return Status::OK();
+    }
+    next_offset_ = pos_;
+  }
+  return Consume(bytes_to_skip, nullptr, &l);
+}
+
+int64 ReadAheadInputStream::Tell() const {
+  tf_shared_lock l(mu_);
+  return pos_;
+}
+
+Status ReadAheadInputStream::Reset() {
+  mutex_lock l(mu_);
+  DropChunks();
+  pos_ = 0;
+  next_offset_ = 0;
+  eof_ = false;
+  IssueReads();
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
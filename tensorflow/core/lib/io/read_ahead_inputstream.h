@@ -0,0 +1,96 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads a RandomAccessFile sequentially while keeping up to `window` reads of
+// `chunk_size` bytes each outstanding ahead of the current position. The reads
+// run on a shared thread pool, so storage with high per-request latency is
+// kept busy without the caller having to read from several files at once.
+//
+// Chunks are released as soon as they have been consumed, and skipping past
+// the outstanding window abandons it instead of waiting for its data.
+//
+// A given instance of ReadAheadInputStream is NOT safe for concurrent use by
+// multiple threads.
+class ReadAheadInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of `file`, which must outlive *this.
+  ReadAheadInputStream(RandomAccessFile* file, size_t chunk_size, int window);
+
+  ~ReadAheadInputStream() override;
+
+  Status ReadNBytes(int64 bytes_to_read, tstring* result) override;
+
+  Status SkipNBytes(int64 bytes_to_skip) override;
+
+  int64 Tell() const override;
+
+  Status Reset() override;
+
+ private:
+  struct Chunk {
+    explicit Chunk(int64 offset) : offset(offset) {}
+
+    const int64 offset;
+    string data;
+    Status status;
+    bool done = false;
+  };
+
+  // Starts reads until `window_` chunks are outstanding or the end of the file
+  // has been seen.
+  void IssueReads() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Drops all chunks. Reads in flight complete in the background.
+  void DropChunks() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Consumes `bytes` bytes at the current position, appending them to
+  // `result` unless it is nullptr.
+  Status Consume(int64 bytes, tstring* result, mutex_lock* l)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  RandomAccessFile* const file_;  // Not owned.
+  const size_t chunk_size_;
+  const int window_;
+
+  mutable mutex mu_;
+  condition_variable cond_var_;
+  std::deque<std::shared_ptr<Chunk>> chunks_ GUARDED_BY(mu_);
+  // Offset in the file of the next chunk to read.
+  int64 next_offset_ GUARDED_BY(mu_) = 0;
+  int64 pos_ GUARDED_BY(mu_) = 0;
+  // Whether a chunk ending at the end of the file has been consumed.
+  bool eof_ GUARDED_BY(mu_) = false;
+  int num_outstanding_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReadAheadInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
@@ -42,6 +42,11 @@ class RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64 buffer_size = 0;
 
+  // If read_ahead_window and buffer_size are both non-zero, up to
+  // read_ahead_window reads of buffer_size bytes each are kept outstanding
+  // ahead of the reader. The same restrictions as for buffer_size apply.
+  int read_ahead_window = 0;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
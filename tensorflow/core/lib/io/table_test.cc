@@ -24,10 +24,12 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/block.h"
 #include "tensorflow/core/lib/io/block_builder.h"
+#include "tensorflow/core/lib/io/cache.h"
 #include "tensorflow/core/lib/io/format.h"
 #include "tensorflow/core/lib/io/iterator.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/test.h"
@@ -236,6 +238,7 @@ class TableConstructor : public Constructor {
     // Open the table
     source_ = new StringSource(sink.contents());
     Options table_options;
+    table_options.block_cache = options.block_cache;
     return Table::Open(table_options, source_, sink.contents().size(), &table_);
   }
 
@@ -633,5 +636,39 @@ TEST(TableTest, SeekToFirstKeyDoesNotReadTooMuch) {
   EXPECT_LT(c.BytesRead(), 200);
 }
 
+TEST(TableTest, BlockCacheAvoidsRereads) {
+  TableConstructor c;
+  for (int i = 0; i < 100; ++i) {
+    c.Add(strings::Printf("k%03d", i), string(100, 'x'));
+  }
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 1024;
+  options.compression = kNoCompression;
+  std::unique_ptr<Cache> cache(NewLRUCache(1 << 20));
+  options.block_cache = cache.get();
+  c.Finish(options, &keys, &kvmap);
+
+  // Alternates between blocks, each of which is read once.
+  uint64 bytes_read = 0;
+  for (int round = 0; round < 3; ++round) {
+    for (const char* key : {"k000", "k099", "k050"}) {
+      std::unique_ptr<Iterator> iter(c.NewIterator());
+      iter->Seek(key);
+      ASSERT_TRUE(iter->Valid());
+      EXPECT_EQ(key, iter->key());
+    }
+    if (round == 0) {
+      bytes_read = c.BytesRead();
+    } else {
+      EXPECT_EQ(bytes_read, c.BytesRead());
+    }
+  }
+  Cache::Stats stats = cache->GetStats();
+  EXPECT_EQ(3, stats.misses);
+  EXPECT_EQ(6, stats.hits);
+}
+
 }  // namespace table
 }  // namespace tensorflow
@@ -160,6 +160,55 @@ TEST(ZlibBuffers, MultipleWriteCallsWithFlush) {
   TestMultipleWrites(200, 200, 10, true);
 }
 
+// Deflates in parallel blocks, which must read back as a single stream.
+void TestParallelDeflate(CompressionOptions options) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/zlib_buffers_test";
+  options.compression_threads = 4;
+  for (auto block_size : {1000, 100 << 10}) {
+    for (auto num_copies : {0, 1, 500}) {
+      options.compression_block_size = block_size;
+      string data = GenTestString(num_copies);
+      std::unique_ptr<WritableFile> file_writer;
+      TF_ASSERT_OK(env->NewWritableFile(fname, &file_writer));
+      ZlibOutputBuffer out(file_writer.get(), 200, 200, options);
+      TF_ASSERT_OK(out.Init());
+      // Writes in uneven pieces, with a flush in the middle.
+      const size_t half = data.size() / 2;
+      TF_ASSERT_OK(out.Append(StringPiece(data).substr(0, half)));
+      TF_ASSERT_OK(out.Flush());
+      for (size_t pos = half; pos < data.size(); pos += 777) {
+        TF_ASSERT_OK(out.Append(StringPiece(data).substr(pos, 777)));
+      }
+      TF_ASSERT_OK(out.Close());
+      TF_ASSERT_OK(file_writer->Close());
+
+      std::unique_ptr<RandomAccessFile> file_reader;
+      TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file_reader));
+      std::unique_ptr<RandomAccessInputStream> input_stream(
+          new RandomAccessInputStream(file_reader.get()));
+      ZlibInputStream in(input_stream.get(), 1000, 1000, options);
+      tstring result;
+      TF_ASSERT_OK(in.ReadNBytes(data.size(), &result));
+      EXPECT_EQ(result, data);
+      // Reading past the end checks the trailer of the stream.
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &result)));
+    }
+  }
+}
+
+TEST(ZlibBuffers, ParallelDefaultOptions) {
+  TestParallelDeflate(CompressionOptions::DEFAULT());
+}
+
+TEST(ZlibBuffers, ParallelRawDeflate) {
+  TestParallelDeflate(CompressionOptions::RAW());
+}
+
+TEST(ZlibBuffers, ParallelGzip) {
+  TestParallelDeflate(CompressionOptions::GZIP());
+}
+
 TEST(ZlibInputStream, FailsToReadIfWindowBitsAreIncompatible) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/zlib_buffers_test";
@@ -111,6 +111,20 @@ class ZlibCompressionOptions {
   // for a simpler decoder for special applications.
   int8 compression_strategy;
 
+  // If greater than 1, `ZlibOutputBuffer` splits its input into blocks of
+  // `compression_block_size` bytes and deflates them on this many threads,
+  // priming each block with the end of the previous one as a dictionary.  The
+  // blocks are written in order, each ending in a sync flush, so the output
+  // is still a single zlib, gzip or raw deflate stream that any inflater,
+  // including `ZlibInputStream`, reads.  The compression ratio is slightly
+  // lower than with a single thread.  `flush_mode` is ignored in this mode.
+  //
+  // This option is ignored for `ZlibInputStream`.
+  int32 compression_threads = 1;
+
+  // Size of the blocks deflated in parallel if `compression_threads` > 1.
+  int64 compression_block_size = 128 << 10;
+
   // When this is set to true and we are unable to find the header to correctly
   // decompress a file, we return an error when `ReadNBytes` is called instead
   // of CHECK-failing. Defaults to false (i.e. CHECK-failing).
@@ -15,11 +15,98 @@ limitations under the License.
 
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/notification.h"
 
 namespace tensorflow {
 namespace io {
 
+namespace {
+
+// The base two logarithm of the window size for `window_bits`, which also
+// selects a zlib, gzip or raw deflate stream.  Like deflate(), uses a window
+// of at least 512 bytes.
+int WindowSizeBits(int window_bits) {
+  if (window_bits < 0) return std::max(-window_bits, 9);
+  if (window_bits > 15) return std::max(window_bits - 16, 9);
+  return std::max(window_bits, 9);
+}
+
+bool IsGzip(int window_bits) { return window_bits > 15; }
+
+bool IsZlib(int window_bits) { return window_bits > 0 && window_bits <= 15; }
+
+}  // namespace
+
+struct ZlibOutputBuffer::Block {
+  // Deflates `input` into a raw deflate stream that ends in a sync flush, or
+  // that ends the stream for the last block.
+  void Deflate(const ZlibCompressionOptions& options);
+
+  string input;
+  // The input preceding this block, up to the window size.
+  string dictionary;
+  bool last;
+
+  // Raw deflate stream of `input`, and the checksum of `input`.
+  string output;
+  uLong check;
+  Status status;
+  Notification done;
+};
+
+void ZlibOutputBuffer::Block::Deflate(const ZlibCompressionOptions& options) {
+  const Bytef* in = reinterpret_cast<const Bytef*>(input.data());
+  if (IsGzip(options.window_bits)) {
+    check = crc32(crc32(0L, Z_NULL, 0), in, input.size());
+  } else {
+    check = adler32(adler32(0L, Z_NULL, 0), in, input.size());
+  }
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(z_stream));
+  int error = deflateInit2(&stream, options.compression_level,
+                           options.compression_method,
+                           -WindowSizeBits(options.window_bits),
+                           options.mem_level, options.compression_strategy);
+  if (error != Z_OK) {
+    status = errors::InvalidArgument("deflateInit failed with status", error);
+    return;
+  }
+  if (!dictionary.empty()) {
+    deflateSetDictionary(&stream,
+                         reinterpret_cast<const Bytef*>(dictionary.data()),
+                         dictionary.size());
+  }
+  stream.next_in = const_cast<Bytef*>(in);
+  stream.avail_in = input.size();
+  const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+  // Leaves room for the sync flush marker on top of the bound.
+  output.resize(deflateBound(&stream, input.size()) + 16);
+  size_t produced = 0;
+  do {
+    if (produced == output.size()) {
+      output.resize(2 * output.size());
+    }
+    stream.next_out = reinterpret_cast<Bytef*>(&output[produced]);
+    stream.avail_out = output.size() - produced;
+    error = deflate(&stream, flush);
+    produced = output.size() - stream.avail_out;
+  } while (error == Z_OK && stream.avail_out == 0);
+  output.resize(produced);
+  if (error != (last ? Z_STREAM_END : Z_OK)) {
+    string error_string =
+        strings::StrCat("deflate() failed with error ", error);
+    if (stream.msg != nullptr) {
+      strings::StrAppend(&error_string, ": ", stream.msg);
+    }
+    status = errors::DataLoss(error_string);
+  }
+  deflateEnd(&stream);
+}
+
 ZlibOutputBuffer::ZlibOutputBuffer(
     WritableFile* file,
     int32 input_buffer_bytes,  // size of z_stream.next_in buffer
@@ -65,6 +152,18 @@ Status ZlibOutputBuffer::Init() {
   z_stream_->next_out = z_stream_output_.get();
   z_stream_->avail_in = 0;
   z_stream_->avail_out = output_buffer_capacity_;
+  if (IsParallel()) {
+    // The stream above only validates the options; the blocks are deflated
+    // with streams of their own.
+    if (zlib_options_.compression_block_size <= 0) {
+      return errors::InvalidArgument(
+          "compression_block_size should be positive");
+    }
+    thread_pool_.reset(new thread::ThreadPool(
+        Env::Default(), "zlib_deflate", zlib_options_.compression_threads));
+    check_ = IsGzip(zlib_options_.window_bits) ? crc32(0L, Z_NULL, 0)
+                                               : adler32(0L, Z_NULL, 0);
+  }
   return Status::OK();
 }
 
@@ -143,6 +242,8 @@ Status ZlibOutputBuffer::FlushOutputBufferToFile() {
 }
 
 Status ZlibOutputBuffer::Append(StringPiece data) {
+  if (IsParallel()) return AppendParallel(data);
+
   // If there is sufficient free space in z_stream_input_ to fit data we
   // add it there and return.
   // If there isn't enough space we deflate the existing contents of
@@ -201,7 +302,146 @@ Status ZlibOutputBuffer::Append(const absl::Cord& cord) {
 }
 #endif
 
+Status ZlibOutputBuffer::AppendParallel(StringPiece data) {
+  const size_t block_size = zlib_options_.compression_block_size;
+  while (!data.empty()) {
+    const size_t bytes_to_add =
+        std::min(data.size(), block_size - pending_input_.size());
+    pending_input_.append(data.data(), bytes_to_add);
+    data.remove_prefix(bytes_to_add);
+    if (pending_input_.size() == block_size) {
+      TF_RETURN_IF_ERROR(SubmitBlock(/*last=*/false));
+    }
+  }
+  return Status::OK();
+}
+
+Status ZlibOutputBuffer::SubmitBlock(bool last) {
+  // Bounds the memory held by blocks that are deflated ahead of writing.
+  while (blocks_.size() >=
+         2 * static_cast<size_t>(zlib_options_.compression_threads)) {
+    TF_RETURN_IF_ERROR(WriteOldestBlock());
+  }
+  std::unique_ptr<Block> block(new Block);
+  block->input.swap(pending_input_);
+  block->dictionary = dictionary_;
+  block->last = last;
+
+  const size_t window_size =
+      size_t{1} << WindowSizeBits(zlib_options_.window_bits);
+  if (block->input.size() >= window_size) {
+    dictionary_.assign(block->input, block->input.size() - window_size,
+                       window_size);
+  } else {
+    dictionary_.append(block->input);
+    if (dictionary_.size() > window_size) {
+      dictionary_.erase(0, dictionary_.size() - window_size);
+    }
+  }
+  pending_input_.reserve(zlib_options_.compression_block_size);
+
+  Block* pending = block.get();
+  blocks_.push_back(std::move(block));
+  const ZlibCompressionOptions& options = zlib_options_;
+  thread_pool_->Schedule([&options, pending]() {
+    pending->Deflate(options);
+    pending->done.Notify();
+  });
+  return Status::OK();
+}
+
+Status ZlibOutputBuffer::WriteOldestBlock() {
+  std::unique_ptr<Block> block = std::move(blocks_.front());
+  blocks_.pop_front();
+  block->done.WaitForNotification();
+  TF_RETURN_IF_ERROR(block->status);
+  TF_RETURN_IF_ERROR(WriteHeader());
+  TF_RETURN_IF_ERROR(file_->Append(block->output));
+  if (IsGzip(zlib_options_.window_bits)) {
+    check_ = crc32_combine(check_, block->check, block->input.size());
+  } else {
+    check_ = adler32_combine(check_, block->check, block->input.size());
+  }
+  total_in_ += static_cast<uint32>(block->input.size());
+  if (block->last) {
+    TF_RETURN_IF_ERROR(WriteTrailer());
+  }
+  return Status::OK();
+}
+
+Status ZlibOutputBuffer::WriteHeader() {
+  if (header_written_) return Status::OK();
+  header_written_ = true;
+  const int window_bits = zlib_options_.window_bits;
+  if (IsGzip(window_bits)) {
+    // Magic, method, no flags, no modification time, extra flags and an
+    // unknown operating system, as written by deflate().
+    char header[10] = {'\x1f', '\x8b', Z_DEFLATED, 0, 0, 0, 0, 0, 0, '\xff'};
+    if (zlib_options_.compression_level == 9) {
+      header[8] = 2;
+    } else if (zlib_options_.compression_level == 1) {
+      header[8] = 4;
+    }
+    return file_->Append(StringPiece(header, sizeof(header)));
+  }
+  if (IsZlib(window_bits)) {
+    // The compression level flags are computed as by deflate().
+    const int level = zlib_options_.compression_level == Z_DEFAULT_COMPRESSION
+                          ? 6
+                          : zlib_options_.compression_level;
+    int level_flags;
+    if (zlib_options_.compression_strategy >= Z_HUFFMAN_ONLY || level < 2) {
+      level_flags = 0;
+    } else if (level < 6) {
+      level_flags = 1;
+    } else if (level == 6) {
+      level_flags = 2;
+    } else {
+      level_flags = 3;
+    }
+    uint32 header = (Z_DEFLATED + ((WindowSizeBits(window_bits) - 8) << 4))
+                    << 8;
+    header |= level_flags << 6;
+    header += 31 - (header % 31);
+    const char bytes[2] = {static_cast<char>(header >> 8),
+                           static_cast<char>(header & 0xff)};
+    return file_->Append(StringPiece(bytes, sizeof(bytes)));
+  }
+  return Status::OK();
+}
+
+Status ZlibOutputBuffer::WriteTrailer() {
+  const int window_bits = zlib_options_.window_bits;
+  if (IsGzip(window_bits)) {
+    // The crc32 and the input length, least significant byte first.
+    char trailer[8];
+    for (int i = 0; i < 4; ++i) {
+      trailer[i] = static_cast<char>((check_ >> (8 * i)) & 0xff);
+      trailer[4 + i] = static_cast<char>((total_in_ >> (8 * i)) & 0xff);
+    }
+    return file_->Append(StringPiece(trailer, sizeof(trailer)));
+  }
+  if (IsZlib(window_bits)) {
+    // The adler32, most significant byte first.
+    char trailer[4];
+    for (int i = 0; i < 4; ++i) {
+      trailer[i] = static_cast<char>((check_ >> (8 * (3 - i))) & 0xff);
+    }
+    return file_->Append(StringPiece(trailer, sizeof(trailer)));
+  }
+  return Status::OK();
+}
+
 Status ZlibOutputBuffer::Flush() {
+  if (IsParallel()) {
+    if (!pending_input_.empty()) {
+      TF_RETURN_IF_ERROR(SubmitBlock(/*last=*/false));
+    }
+    while (!blocks_.empty()) {
+      TF_RETURN_IF_ERROR(WriteOldestBlock());
+    }
+    return file_->Flush();
+  }
   TF_RETURN_IF_ERROR(DeflateBuffered(Z_PARTIAL_FLUSH));
   TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
   return file_->Flush();
@@ -217,7 +457,14 @@ Status ZlibOutputBuffer::Sync() {
 }
 
 Status ZlibOutputBuffer::Close() {
-  if (z_stream_) {
+  if (z_stream_ && IsParallel()) {
+    TF_RETURN_IF_ERROR(SubmitBlock(/*last=*/true));
+    while (!blocks_.empty()) {
+      TF_RETURN_IF_ERROR(WriteOldestBlock());
+    }
+    deflateEnd(z_stream_.get());
+    z_stream_.reset(nullptr);
+  } else if (z_stream_) {
     TF_RETURN_IF_ERROR(DeflateBuffered(Z_FINISH));
     TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
     deflateEnd(z_stream_.get());
@@ -18,6 +18,8 @@ limitations under the License.
 
 #include <zlib.h>
 
+#include <deque>
+#include <memory>
 #include <string>
 
 #include "tensorflow/core/lib/core/status.h"
@@ -26,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -33,6 +36,8 @@ namespace io {
 
 // Provides support for writing compressed output to file using zlib
 // (http://www.zlib.net/).
+// With ZlibCompressionOptions::compression_threads > 1, the input is deflated
+// in blocks on a thread pool, like pigz does.
 // A given instance of an ZlibOutputBuffer is NOT safe for concurrent use
 // by multiple threads
 class ZlibOutputBuffer : public WritableFile {
@@ -149,6 +154,45 @@ class ZlibOutputBuffer : public WritableFile {
     return flush_mode == Z_SYNC_FLUSH || flush_mode == Z_FULL_FLUSH;
   }
 
+  // A block of input deflated in parallel.
+  struct Block;
+
+  bool IsParallel() const { return zlib_options_.compression_threads > 1; }
+
+  // Adds `data` to the input of the next block, and deflates the blocks that
+  // are full on `thread_pool_`.
+  Status AppendParallel(StringPiece data);
+
+  // Starts deflating `pending_input_` as a block.  The last block ends the
+  // stream.  Waits for the oldest block to write it out if too many blocks
+  // are queued already.
+  Status SubmitBlock(bool last);
+
+  // Waits until the oldest queued block is deflated and writes it to file.
+  Status WriteOldestBlock();
+
+  // Writes the zlib or gzip header, if any, in front of the first block.
+  Status WriteHeader();
+
+  // Writes the zlib or gzip trailer, if any, after the last block.
+  Status WriteTrailer();
+
+  // State for deflating in parallel, if compression_threads > 1.
+  // Input of the next block.
+  string pending_input_;
+  // The end of the input of the previous block, which primes the next one.
+  string dictionary_;
+  // Blocks being deflated or waiting to be written, oldest first.
+  std::deque<std::unique_ptr<Block>> blocks_;
+  // Declared after `blocks_`, so that it finishes deflating them first.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+  // Checksum of the input written so far: a crc32 for gzip streams, and an
+  // adler32 for zlib streams.
+  uLong check_ = 0;
+  // Length of the input written so far, modulo 2^32 as in the gzip trailer.
+  uint32 total_in_ = 0;
+  bool header_written_ = false;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ZlibOutputBuffer);
 };
 
@@ -246,6 +246,35 @@ REGISTER_OP("_FusedBatchNormEx")
 expected to create these operators.
 )doc");
 
+// Layer normalization over the innermost dimension of x:
+//   y = (x - mean) * rsqrt(variance + epsilon) * gamma + beta
+// where gamma and beta are vectors of the size of that dimension.
+REGISTER_OP("_FusedLayerNorm")
+    .Input("x: T")
+    .Input("gamma: T")
+    .Input("beta: T")
+    .Output("y: T")
+    .Attr("T: {float}")
+    .Attr("epsilon: float = 0.001")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &x));
+      DimensionHandle depth = c->Dim(x, -1);
+      for (int i = 1; i < 3; ++i) {
+        ShapeHandle v;
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &v));
+        TF_RETURN_IF_ERROR(c->Merge(depth, c->Dim(v, 0), &depth));
+      }
+      ShapeHandle y;
+      TF_RETURN_IF_ERROR(c->ReplaceDim(x, -1, depth, &y));
+      c->set_output(0, y);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("FusedBatchNormGrad")
     .Input("y_backprop: T")
     .Input("x: T")
@@ -1163,6 +1192,29 @@ REGISTER_OP("LogSoftmax")
       return shape_inference::UnchangedShapeWithRankAtLeast(c, 1);
     });
 
+// Softmax(logits * scale + mask) of attention scores, where mask has the rank
+// of logits and is broadcast along its dimensions of size 1.
+REGISTER_OP("_FusedMaskedSoftmax")
+    .Input("logits: T")
+    .Input("mask: T")
+    .Output("softmax: T")
+    .Attr("T: {float}")
+    .Attr("scale: float = 1.0")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle logits;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &logits));
+      ShapeHandle mask;
+      if (c->RankKnown(logits)) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(1), c->Rank(logits), &mask));
+      }
+      c->set_output(0, logits);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 // --------------------------------------------------------------------------
 
 REGISTER_OP("SoftmaxCrossEntropyWithLogits")
@@ -1191,4 +1191,63 @@ REGISTER_OP("ResourceApplyPowerSign")
       return ApplyPowerSignShapeFn(c, /*sparse=*/false);
     });
 
+// Grouped optimizer updates. The grouped_apply_optimizer replaces N updates
+// placed on a VE that share their hyper-parameters with one of these.
+static Status GroupedApplyGradientDescentShapeFn(InferenceContext* c) {
+  int n;
+  TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+  ShapeHandle unused;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(n), 0, &unused));  // alpha
+  for (int i = 0; i < n; ++i) {
+    ShapeHandle s = ShapeOrHandleShape(c, i);                   // var
+    TF_RETURN_IF_ERROR(c->Merge(s, c->input(n + 1 + i), &s));  // delta
+  }
+  return Status::OK();
+}
+
+REGISTER_OP("_ResourceGroupedApplyGradientDescent")
+    .Input("var: N * resource")
+    .Input("alpha: T")
+    .Input("delta: N * T")
+    .Attr("T: numbertype")
+    .Attr("N: int >= 1")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn(GroupedApplyGradientDescentShapeFn)
+    .Doc(R"doc(
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+static Status GroupedApplyMomentumShapeFn(InferenceContext* c) {
+  int n;
+  TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+  ShapeHandle unused;
+  // lr and momentum
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(2 * n), 0, &unused));
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(3 * n + 1), 0, &unused));
+  for (int i = 0; i < n; ++i) {
+    // var, accum and grad
+    ShapeHandle s = ShapeOrHandleShape(c, i);
+    TF_RETURN_IF_ERROR(c->Merge(s, ShapeOrHandleShape(c, n + i), &s));
+    TF_RETURN_IF_ERROR(c->Merge(s, c->input(2 * n + 1 + i), &s));
+  }
+  return Status::OK();
+}
+
+REGISTER_OP("_ResourceGroupedApplyMomentum")
+    .Input("var: N * resource")
+    .Input("accum: N * resource")
+    .Input("lr: T")
+    .Input("grad: N * T")
+    .Input("momentum: T")
+    .Attr("T: numbertype")
+    .Attr("N: int >= 1")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn(GroupedApplyMomentumShapeFn)
+    .Doc(R"doc(
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 }  // namespace tensorflow
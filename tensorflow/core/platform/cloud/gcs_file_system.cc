@@ -27,6 +27,7 @@ limitations under the License.
 #endif
 #include "absl/base/macros.h"
 #include "include/json/json.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/platform/cloud/curl_http_request.h"
 #include "tensorflow/core/platform/cloud/file_block_cache.h"
@@ -107,6 +108,16 @@ constexpr char kReadRequestTimeout[] = "GCS_READ_REQUEST_TIMEOUT_SECS";
 // The environment variable to configure the overall request timeout for
 // upload requests.
 constexpr char kWriteRequestTimeout[] = "GCS_WRITE_REQUEST_TIMEOUT_SECS";
+// The environment variables that configure the concurrent range requests of
+// large reads (format: <int32>, and chunk size in MB).
+constexpr char kReadParallelism[] = "GCS_READ_PARALLELISM";
+constexpr char kReadChunkSize[] = "GCS_READ_CHUNK_SIZE_MB";
+// The environment variables that configure the parallel composite uploads of
+// large writes (format: <int32>, and chunk size in MB).
+constexpr char kWriteParallelism[] = "GCS_WRITE_PARALLELISM";
+constexpr char kWriteChunkSize[] = "GCS_WRITE_CHUNK_SIZE_MB";
+// The maximum number of source objects of a compose request.
+constexpr uint64 kMaxComposeComponents = 32;
 // The environment variable to configure an additional header to send with
 // all requests to GCS (format HEADERNAME:HEADERCONTENT)
 constexpr char kAdditionalRequestHeader[] = "GCS_ADDITIONAL_REQUEST_HEADER";
@@ -509,6 +520,14 @@ class GcsWritableFile : public WritableFile {
       return errors::Internal(
           "Could not write to the internal temporary file.");
     }
+    uint64 file_size;
+    TF_RETURN_IF_ERROR(GetCurrentFileSize(&file_size));
+    const GcsFileSystem::ParallelTransferConfig& config =
+        filesystem_->parallel_transfers();
+    if (config.write_parallelism > 1 && config.write_chunk_size > 0 &&
+        file_size >= 2 * config.write_chunk_size) {
+      return CompositeUpload(file_size, config);
+    }
     string session_uri;
     TF_RETURN_IF_ERROR(CreateNewUploadSession(&session_uri));
     uint64 already_uploaded = 0;
@@ -678,6 +697,118 @@ class GcsWritableFile : public WritableFile {
     return Status::OK();
   }
 
+  /// \brief Uploads the file as a parallel composite upload.
+  ///
+  /// The file is split into at most kMaxComposeComponents parts of at least
+  /// `config.write_chunk_size` bytes, which are uploaded concurrently as
+  /// temporary objects, composed into the object and then deleted.
+  Status CompositeUpload(uint64 file_size,
+                         const GcsFileSystem::ParallelTransferConfig& config) {
+    const uint64 num_parts =
+        std::min(kMaxComposeComponents,
+                 (file_size + config.write_chunk_size - 1) /
+                     config.write_chunk_size);
+    const uint64 part_size = (file_size + num_parts - 1) / num_parts;
+    std::vector<string> uploaded_parts;
+    Status status =
+        UploadParts(file_size, num_parts, part_size,
+                    config.write_parallelism, &uploaded_parts);
+    if (status.ok()) {
+      status = ComposeParts(uploaded_parts);
+    }
+    for (const string& part : uploaded_parts) {
+      const Status delete_status = filesystem_->DeleteFile(
+          strings::StrCat("gs://", bucket_, "/", part));
+      if (!delete_status.ok()) {
+        LOG(WARNING) << "Could not delete the part gs://" << bucket_ << "/"
+                     << part << " of " << GetGcsPath() << ": "
+                     << delete_status;
+      }
+    }
+    if (status.ok()) {
+      // Erase the file from the file cache on every successful write.
+      file_cache_erase_();
+    }
+    return status;
+  }
+
+  /// Uploads the parts of a composite upload, `parallelism` at a time, and
+  /// appends the names of the parts that were uploaded to `uploaded_parts`.
+  Status UploadParts(uint64 file_size, uint64 num_parts, uint64 part_size,
+                     int32 parallelism, std::vector<string>* uploaded_parts) {
+    std::ifstream infile(tmp_content_filename_, std::ifstream::binary);
+    for (uint64 first = 0; first < num_parts; first += parallelism) {
+      const uint64 last = std::min(num_parts, first + parallelism);
+      std::vector<string> names;
+      std::vector<string> contents;
+      std::vector<std::unique_ptr<HttpRequest>> requests;
+      for (uint64 part = first; part < last; ++part) {
+        const uint64 offset = part * part_size;
+        string content(std::min(part_size, file_size - offset), '\0');
+        infile.seekg(offset);
+        infile.read(&content[0], content.size());
+        if (!infile.good()) {
+          return errors::Internal(
+              "Could not read the internal temporary file.");
+        }
+        std::unique_ptr<HttpRequest> request;
+        TF_RETURN_IF_ERROR(filesystem_->CreateHttpRequest(&request));
+        names.push_back(strings::StrCat(object_, ".part-", part));
+        request->SetUri(strings::StrCat(
+            kGcsUploadUriBase, "b/", bucket_, "/o?uploadType=media&name=",
+            request->EscapeString(names.back())));
+        request->SetTimeouts(timeouts_->connect, timeouts_->idle,
+                             timeouts_->write);
+        contents.push_back(std::move(content));
+        requests.push_back(std::move(request));
+      }
+      // The bodies are set once `contents` no longer reallocates.
+      for (size_t i = 0; i < requests.size(); ++i) {
+        requests[i]->SetPostFromBuffer(contents[i].data(), contents[i].size());
+      }
+      std::vector<Status> statuses;
+      filesystem_->SendConcurrently(requests, &statuses);
+      Status status;
+      for (size_t i = 0; i < requests.size(); ++i) {
+        if (statuses[i].ok()) {
+          uploaded_parts->push_back(names[i]);
+        } else if (status.ok()) {
+          status = statuses[i];
+        }
+      }
+      TF_RETURN_WITH_CONTEXT_IF_ERROR(status, " when uploading a part of ",
+                                      GetGcsPath());
+    }
+    return Status::OK();
+  }
+
+  /// Composes the uploaded parts, in order, into the object.
+  Status ComposeParts(const std::vector<string>& parts) {
+    Json::Value root;
+    Json::Value& source_objects = root["sourceObjects"];
+    for (const string& part : parts) {
+      Json::Value source_object;
+      source_object["name"] = part;
+      source_objects.append(source_object);
+    }
+    const string body = Json::FastWriter().write(root);
+
+    std::unique_ptr<HttpRequest> request;
+    TF_RETURN_IF_ERROR(filesystem_->CreateHttpRequest(&request));
+    request->SetUri(strings::StrCat(kGcsUriBase, "b/", bucket_, "/o/",
+                                    request->EscapeString(object_),
+                                    "/compose"));
+    request->AddHeader("Content-Type", "application/json");
+    request->SetPostFromBuffer(body.data(), body.size());
+    request->SetTimeouts(timeouts_->connect, timeouts_->idle,
+                         timeouts_->metadata);
+    std::vector<char> output_buffer;
+    request->SetResultBuffer(&output_buffer);
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when composing ",
+                                    GetGcsPath());
+    return Status::OK();
+  }
+
   string GetGcsPath() const {
     return strings::StrCat("gs://", bucket_, "/", object_);
   }
@@ -854,6 +985,23 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
     timeouts_.write = timeout_value;
   }
 
+  // Apply the overrides for the parallel transfers.
+  ParallelTransferConfig parallel_transfers;
+  int32 parallelism;
+  if (GetEnvVar(kReadParallelism, strings::safe_strto32, &parallelism)) {
+    parallel_transfers.read_parallelism = parallelism;
+  }
+  if (GetEnvVar(kReadChunkSize, strings::safe_strtou64, &value)) {
+    parallel_transfers.read_chunk_size = value * 1024 * 1024;
+  }
+  if (GetEnvVar(kWriteParallelism, strings::safe_strto32, &parallelism)) {
+    parallel_transfers.write_parallelism = parallelism;
+  }
+  if (GetEnvVar(kWriteChunkSize, strings::safe_strtou64, &value)) {
+    parallel_transfers.write_chunk_size = value * 1024 * 1024;
+  }
+  SetParallelTransfers(parallel_transfers);
+
   int64 token_value;
   if (GetEnvVar(kThrottleRate, strings::safe_strto64, &token_value)) {
     GcsThrottleConfig config;
@@ -998,24 +1146,13 @@ Status GcsFileSystem::LoadBufferFromGCS(const string& fname, size_t offset,
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
 
-  std::unique_ptr<HttpRequest> request;
-  TF_RETURN_WITH_CONTEXT_IF_ERROR(CreateHttpRequest(&request),
-                                  "when reading gs://", bucket, "/", object);
-
-  request->SetUri(strings::StrCat("https://", kStorageHost, "/", bucket, "/",
-                                  request->EscapeString(object)));
-  request->SetRange(offset, offset + n - 1);
-  request->SetResultBufferDirect(buffer, n);
-  request->SetTimeouts(timeouts_.connect, timeouts_.idle, timeouts_.read);
-
   if (stats_ != nullptr) {
     stats_->RecordBlockLoadRequest(fname, offset);
   }
 
-  TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when reading gs://",
-                                  bucket, "/", object);
-
-  size_t bytes_read = request->GetResultBufferDirectBytesTransferred();
+  size_t bytes_read;
+  TF_RETURN_IF_ERROR(
+      ReadObjectRanges(bucket, object, offset, n, buffer, &bytes_read));
   *bytes_transferred = bytes_read;
   VLOG(1) << "Successful read of gs://" << bucket << "/" << object << " @ "
           << offset << " of size: " << bytes_read;
@@ -1043,6 +1180,94 @@ Status GcsFileSystem::LoadBufferFromGCS(const string& fname, size_t offset,
   return Status::OK();
 }
 
+Status GcsFileSystem::ReadObjectRanges(const string& bucket,
+                                       const string& object, size_t offset,
+                                       size_t n, char* buffer,
+                                       size_t* bytes_read) {
+  *bytes_read = 0;
+  size_t chunk_size = n;
+  size_t num_chunks = 1;
+  size_t parallelism = 1;
+  if (transfer_pool_ != nullptr && parallel_transfers_.read_parallelism > 1 &&
+      parallel_transfers_.read_chunk_size > 0 &&
+      n >= 2 * parallel_transfers_.read_chunk_size) {
+    chunk_size = parallel_transfers_.read_chunk_size;
+    num_chunks = (n + chunk_size - 1) / chunk_size;
+    parallelism = parallel_transfers_.read_parallelism;
+  }
+  for (size_t first = 0; first < num_chunks; first += parallelism) {
+    const size_t last = std::min(num_chunks, first + parallelism);
+    std::vector<std::unique_ptr<HttpRequest>> requests;
+    for (size_t chunk = first; chunk < last; ++chunk) {
+      const size_t chunk_offset = chunk * chunk_size;
+      const size_t chunk_n = std::min(chunk_size, n - chunk_offset);
+      std::unique_ptr<HttpRequest> request;
+      TF_RETURN_WITH_CONTEXT_IF_ERROR(CreateHttpRequest(&request),
+                                      "when reading gs://", bucket, "/",
+                                      object);
+      request->SetUri(strings::StrCat("https://", kStorageHost, "/", bucket,
+                                      "/", request->EscapeString(object)));
+      request->SetRange(offset + chunk_offset,
+                        offset + chunk_offset + chunk_n - 1);
+      request->SetResultBufferDirect(buffer + chunk_offset, chunk_n);
+      request->SetTimeouts(timeouts_.connect, timeouts_.idle, timeouts_.read);
+      requests.push_back(std::move(request));
+    }
+    std::vector<Status> statuses;
+    SendConcurrently(requests, &statuses);
+    for (size_t i = 0; i < requests.size(); ++i) {
+      TF_RETURN_WITH_CONTEXT_IF_ERROR(statuses[i], " when reading gs://",
+                                      bucket, "/", object);
+    }
+    for (size_t i = 0; i < requests.size(); ++i) {
+      const size_t chunk_read =
+          requests[i]->GetResultBufferDirectBytesTransferred();
+      *bytes_read += chunk_read;
+      if (chunk_read < std::min(chunk_size, n - (first + i) * chunk_size)) {
+        // The object ends in this chunk.
+        return Status::OK();
+      }
+    }
+  }
+  return Status::OK();
+}
+
+void GcsFileSystem::SendConcurrently(
+    const std::vector<std::unique_ptr<HttpRequest>>& requests,
+    std::vector<Status>* statuses) {
+  statuses->assign(requests.size(), Status::OK());
+  if (requests.size() == 1 || transfer_pool_ == nullptr) {
+    for (size_t i = 0; i < requests.size(); ++i) {
+      (*statuses)[i] = requests[i]->Send();
+    }
+    return;
+  }
+  BlockingCounter counter(requests.size());
+  for (size_t i = 0; i < requests.size(); ++i) {
+    transfer_pool_->Schedule([&requests, statuses, &counter, i]() {
+      (*statuses)[i] = requests[i]->Send();
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+}
+
+void GcsFileSystem::SetParallelTransfers(
+    const ParallelTransferConfig& config) {
+  parallel_transfers_ = config;
+  const int32 num_threads =
+      std::max(config.read_parallelism, config.write_parallelism);
+  transfer_pool_.reset();
+  if (num_threads > 1) {
+    transfer_pool_.reset(
+        new thread::ThreadPool(Env::Default(), "gcs_transfer", num_threads));
+  }
+  VLOG(1) << "GCS read parallelism = " << config.read_parallelism << " ; "
+          << "read chunk size = " << config.read_chunk_size << " ; "
+          << "write parallelism = " << config.write_parallelism << " ; "
+          << "write chunk size = " << config.write_chunk_size;
+}
+
 void GcsFileSystem::ClearFileCaches(const string& fname) {
   tf_shared_lock l(block_cache_lock_);
   file_block_cache_->RemoveFile(fname);
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cloud/retrying_file_system.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -108,6 +109,7 @@ class GcsStatsInterface {
 class GcsFileSystem : public FileSystem {
  public:
   struct TimeoutConfig;
+  struct ParallelTransferConfig;
 
   // Main constructor used (via RetryingFileSystem) throughout Tensorflow
   explicit GcsFileSystem(bool make_default_cache = true);
@@ -184,6 +186,9 @@ class GcsFileSystem : public FileSystem {
     return file_block_cache_->max_staleness();
   }
   TimeoutConfig timeouts() const { return timeouts_; }
+  const ParallelTransferConfig& parallel_transfers() const {
+    return parallel_transfers_;
+  }
   std::unordered_set<string> allowed_locations() const {
     return allowed_locations_;
   }
@@ -239,8 +244,48 @@ class GcsFileSystem : public FileSystem {
           write(write) {}
   };
 
+  /// Structure configuring the concurrent transfers of large objects.
+  ///
+  /// Values of `*_parallelism` at most 1 disable the concurrent transfers.
+  struct ParallelTransferConfig {
+    // The maximum number of range requests in flight for one read. Reads of at
+    // least two chunks of `read_chunk_size` bytes are split into range
+    // requests of that size.
+    int32 read_parallelism = 1;
+    uint64 read_chunk_size = 16 * 1024 * 1024;  // 16 MB
+
+    // The maximum number of parts uploaded concurrently for one write. Files
+    // of at least two chunks of `write_chunk_size` bytes are uploaded as
+    // parts of at least that size, which are then composed into the object.
+    int32 write_parallelism = 1;
+    uint64 write_chunk_size = 64 * 1024 * 1024;  // 64 MB
+
+    ParallelTransferConfig() {}
+    ParallelTransferConfig(int32 read_parallelism, uint64 read_chunk_size,
+                           int32 write_parallelism, uint64 write_chunk_size)
+        : read_parallelism(read_parallelism),
+          read_chunk_size(read_chunk_size),
+          write_parallelism(write_parallelism),
+          write_chunk_size(write_chunk_size) {}
+  };
+
   Status CreateHttpRequest(std::unique_ptr<HttpRequest>* request);
 
+  /// \brief Sends `requests` concurrently, and stores the status of each of
+  /// them in `statuses`.
+  ///
+  /// The requests are sent from the threads of the parallel transfers, or
+  /// from the calling thread if there is only one of them.
+  void SendConcurrently(
+      const std::vector<std::unique_ptr<HttpRequest>>& requests,
+      std::vector<Status>* statuses);
+
+  /// \brief Reconfigures the concurrent transfers of large objects.
+  ///
+  /// Must not be called while files of this file system are being read or
+  /// written.
+  void SetParallelTransfers(const ParallelTransferConfig& config);
+
   /// \brief Sets a new AuthProvider on the GCS FileSystem.
   ///
   /// The new auth provider will be used for all subsequent requests.
@@ -332,6 +377,12 @@ class GcsFileSystem : public FileSystem {
 
   Status RenameObject(const string& src, const string& target);
 
+  /// Reads `n` bytes at `offset` of the object into `buffer`, splitting large
+  /// reads into concurrent range requests.
+  Status ReadObjectRanges(const string& bucket, const string& object,
+                          size_t offset, size_t n, char* buffer,
+                          size_t* bytes_read);
+
   // Clear all the caches related to the file with name `filename`.
   void ClearFileCaches(const string& fname);
 
@@ -363,6 +414,11 @@ class GcsFileSystem : public FileSystem {
 
   TimeoutConfig timeouts_;
 
+  ParallelTransferConfig parallel_transfers_;
+  // Runs the concurrent requests of the parallel transfers. Null if they are
+  // disabled.
+  std::unique_ptr<thread::ThreadPool> transfer_pool_;
+
   GcsStatsInterface* stats_ = nullptr;  // Not owned.
 
   /// The initial delay for exponential backoffs when retrying failed calls.
@@ -152,6 +152,70 @@ TEST(GcsFileSystemTest, NewRandomAccessFile_Buffered) {
   EXPECT_EQ("6789", result);
 }
 
+TEST(GcsFileSystemTest, NewRandomAccessFile_ParallelRanges) {
+  std::vector<HttpRequest*> requests({
+      new FakeHttpRequest(
+          "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+          "Auth Token: fake_token\n"
+          "Range: 0-3\n"
+          "Timeouts: 5 1 20\n",
+          "0123"),
+      new FakeHttpRequest(
+          "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+          "Auth Token: fake_token\n"
+          "Range: 4-7\n"
+          "Timeouts: 5 1 20\n",
+          "4567"),
+      new FakeHttpRequest(
+          "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+          "Auth Token: fake_token\n"
+          "Range: 8-9\n"
+          "Timeouts: 5 1 20\n",
+          "89"),
+      new FakeHttpRequest(
+          "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+          "Auth Token: fake_token\n"
+          "Range: 10-13\n"
+          "Timeouts: 5 1 20\n",
+          "ab"),
+      new FakeHttpRequest(
+          "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+          "Auth Token: fake_token\n"
+          "Range: 14-17\n"
+          "Timeouts: 5 1 20\n",
+          ""),
+  });
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 10 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */);
+  fs.SetParallelTransfers(GcsFileSystem::ParallelTransferConfig(
+      2 /* read parallelism */, 4 /* read chunk size */,
+      1 /* write parallelism */, 4 /* write chunk size */));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_EXPECT_OK(fs.NewRandomAccessFile("gs://bucket/random_access.txt", &file));
+
+  char scratch[8];
+  StringPiece result;
+
+  // The buffer of 10 bytes is read as two rounds of concurrent range requests.
+  TF_EXPECT_OK(file->Read(0, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("01234567", result);
+
+  // The object ends in the first range of the next buffer.
+  EXPECT_EQ(
+      errors::Code::OUT_OF_RANGE,
+      file->Read(sizeof(scratch), sizeof(scratch), &result, scratch).code());
+  EXPECT_EQ("89ab", result);
+}
+
 TEST(GcsFileSystemTest, NewRandomAccessFile_Buffered_Errors) {
   std::vector<HttpRequest*> requests({
       new FakeHttpRequest(
@@ -898,6 +962,82 @@ TEST(GcsFileSystemTest, NewWritableFile) {
   TF_EXPECT_OK(wfile->Close());
 }
 
+TEST(GcsFileSystemTest, NewWritableFile_CompositeUpload) {
+  string compose_body;
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=path%2Fwriteable.txt.part-0\n"
+           "Auth Token: fake_token\n"
+           "Timeouts: 5 1 30\n"
+           "Post body: conten\n",
+           ""),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=path%2Fwriteable.txt.part-1\n"
+           "Auth Token: fake_token\n"
+           "Timeouts: 5 1 30\n"
+           "Post body: t1,con\n",
+           ""),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=path%2Fwriteable.txt.part-2\n"
+           "Auth Token: fake_token\n"
+           "Timeouts: 5 1 30\n"
+           "Post body: tent2\n",
+           ""),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                           "bucket/o/path%2Fwriteable.txt/compose\n"
+                           "Auth Token: fake_token\n"
+                           "Header Content-Type: application/json\n"
+                           "Timeouts: 5 1 10\n",
+                           "", &compose_body),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                           "bucket/o/path%2Fwriteable.txt.part-0\n"
+                           "Auth Token: fake_token\n"
+                           "Timeouts: 5 1 10\n"
+                           "Delete: yes\n",
+                           ""),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                           "bucket/o/path%2Fwriteable.txt.part-1\n"
+                           "Auth Token: fake_token\n"
+                           "Timeouts: 5 1 10\n"
+                           "Delete: yes\n",
+                           ""),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                           "bucket/o/path%2Fwriteable.txt.part-2\n"
+                           "Auth Token: fake_token\n"
+                           "Timeouts: 5 1 10\n"
+                           "Delete: yes\n",
+                           "")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 0 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */);
+  fs.SetParallelTransfers(GcsFileSystem::ParallelTransferConfig(
+      1 /* read parallelism */, 8 /* read chunk size */,
+      2 /* write parallelism */, 8 /* write chunk size */));
+
+  // The 17 bytes are uploaded as three parts of at most 6 bytes.
+  std::unique_ptr<WritableFile> file;
+  TF_EXPECT_OK(fs.NewWritableFile("gs://bucket/path/writeable.txt", &file));
+
+  TF_EXPECT_OK(file->Append("content1,"));
+  TF_EXPECT_OK(file->Append("content2"));
+  TF_EXPECT_OK(file->Close());
+  EXPECT_EQ(
+      "{\"sourceObjects\":[{\"name\":\"path/writeable.txt.part-0\"},"
+      "{\"name\":\"path/writeable.txt.part-1\"},"
+      "{\"name\":\"path/writeable.txt.part-2\"}]}\n",
+      compose_body);
+}
+
 TEST(GcsFileSystemTest, NewWritableFile_ResumeUploadSucceeds) {
   std::vector<HttpRequest*> requests(
       {new FakeHttpRequest(
@@ -3450,6 +3590,17 @@ TEST(GcsFileSystemTest, OverrideCacheParameters) {
   EXPECT_EQ(20, fs5.timeouts().metadata);
   EXPECT_EQ(30, fs5.timeouts().read);
   EXPECT_EQ(40, fs5.timeouts().write);
+
+  // Verify parallel transfer overrides.
+  setenv("GCS_READ_PARALLELISM", "4", 1);
+  setenv("GCS_READ_CHUNK_SIZE_MB", "8", 1);
+  setenv("GCS_WRITE_PARALLELISM", "2", 1);
+  setenv("GCS_WRITE_CHUNK_SIZE_MB", "32", 1);
+  GcsFileSystem fs6;
+  EXPECT_EQ(4, fs6.parallel_transfers().read_parallelism);
+  EXPECT_EQ(8 * 1024 * 1024, fs6.parallel_transfers().read_chunk_size);
+  EXPECT_EQ(2, fs6.parallel_transfers().write_parallelism);
+  EXPECT_EQ(32 * 1024 * 1024, fs6.parallel_transfers().write_chunk_size);
 }
 
 TEST(GcsFileSystemTest, CreateHttpRequest) {
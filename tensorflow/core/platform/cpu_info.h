@@ -64,6 +64,10 @@ int NumTotalCPUs();
 // identified.  If successful, the return value will be in [0, NumTotalCPUs()).
 int GetCurrentCPU();
 
+// Restricts the current thread to run only on `cpu`. Returns false if the
+// platform does not support it or the call fails.
+bool SetCurrentThreadCPUAffinity(int cpu);
+
 // Returns an estimate of the number of hyperthreads per physical core
 // on the CPU
 int NumHyperthreadsPerCore();
@@ -122,6 +126,7 @@ enum CPUFeature {
   AVX512IFMA = 35,     // Integer multiply-add
   AVX512_4VNNIW = 36,  // Integer neural network
   AVX512_4FMAPS = 37,  // Floating point neural network
+  AVX512_BF16 = 38,    // Bfloat16 conversions and dot products
 };
 
 // Checks whether the current processor supports one of the features above.
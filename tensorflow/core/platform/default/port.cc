@@ -126,6 +126,19 @@ int GetCurrentCPU() {
   return kUnknownCPU;
 }
 
+bool SetCurrentThreadCPUAffinity(int cpu) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  // On Linux a pid of 0 is the calling thread, not the whole process.
+  return sched_setaffinity(0, sizeof(cpuset), &cpuset) == 0;
+#else
+  return false;
+#endif
+}
+
 int NumHyperthreadsPerCore() {
   static const int ht_per_core = tensorflow::port::CPUIDNumSMT();
   return (ht_per_core > 0) ? ht_per_core : 1;
@@ -450,6 +450,9 @@ struct ThreadOptions {
   /// Guard area size to use near thread stacks to use (in bytes)
   size_t guard_size = 0;  // 0: use system default value
   int numa_node = port::kNUMANoAffinity;
+  /// CPUs to pin the threads of a thread::ThreadPool to: thread i runs on
+  /// cpus[i % cpus.size()]. Empty means no pinning.
+  std::vector<int> cpus;
 };
 
 /// A utility routine: copy contents of `src` in file system `src_fs`
@@ -21,6 +21,7 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -46,11 +47,19 @@ struct EigenEnvironment {
   const ThreadOptions thread_options_;
   const string name_;
 
+  // Index of the next thread, to pick its CPU from thread_options_.cpus.
+  // The pool creates its threads one after another in its constructor.
+  int next_thread_ = 0;
+
   EigenEnvironment(Env* env, const ThreadOptions& thread_options,
                    const string& name)
       : env_(env), thread_options_(thread_options), name_(name) {}
 
   EnvThread* CreateThread(std::function<void()> f) {
+    const int cpu = thread_options_.cpus.empty()
+                        ? -1
+                        : thread_options_.cpus[next_thread_++ %
+                                               thread_options_.cpus.size()];
     return env_->StartThread(thread_options_, name_, [=]() {
       // Set the processor flag to flush denormals to zero.
       port::ScopedFlushDenormal flush;
@@ -59,6 +68,10 @@ struct EigenEnvironment {
       if (thread_options_.numa_node != port::kNUMANoAffinity) {
         port::NUMASetThreadNodeAffinity(thread_options_.numa_node);
       }
+      if (cpu >= 0 && !port::SetCurrentThreadCPUAffinity(cpu)) {
+        LOG(WARNING) << "Could not pin a thread of " << name_ << " to CPU "
+                     << cpu;
+      }
       f();
     });
   }
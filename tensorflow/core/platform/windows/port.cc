@@ -91,6 +91,11 @@ int GetCurrentCPU() {
   return GetCurrentProcessorNumber();
 }
 
+bool SetCurrentThreadCPUAffinity(int cpu) {
+  // Not yet implemented: pinning is ignored.
+  return false;
+}
+
 bool NUMAEnabled() {
   // Not yet implemented: coming soon.
   return false;
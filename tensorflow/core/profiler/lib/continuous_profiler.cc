@@ -0,0 +1,277 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/lib/continuous_profiler.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <map>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/internal/cpu/host_tracer_utils.h"
+#include "tensorflow/core/profiler/lib/profiler_utils.h"
+#include "tensorflow/core/profiler/utils/xplane_builder.h"
+#include "tensorflow/core/profiler/utils/xplane_schema.h"
+#include "tensorflow/core/profiler/utils/xplane_utils.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+const absl::string_view kContinuousProfilerPlane = "/host:continuous_profiler";
+
+// Rough size of the buffered `events`, to bound the memory of the ring.
+int64 EstimateBytes(const TraceMeRecorder::Events& events) {
+  int64 bytes = 0;
+  for (const auto& thread : events) {
+    bytes += sizeof(thread) + thread.thread.name.size();
+    for (const auto& event : thread.events) {
+      bytes += sizeof(event) + event.name.size();
+    }
+  }
+  return bytes;
+}
+
+// Reads `*value` from the environment variable `name`, keeping its current
+// value if the variable is not set or cannot be parsed.
+void ReadOption(absl::string_view name, int64* value) {
+  const int64 default_value = *value;
+  Status status = ReadInt64FromEnvVar(name, default_value, value);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    *value = default_value;
+  }
+}
+
+}  // namespace
+
+/*static*/ ContinuousProfiler::Options ContinuousProfiler::OptionsFromEnv() {
+  Options options;
+  ReadOption("TF_CONTINUOUS_PROFILER_PERIOD_MS", &options.period_ms);
+  ReadOption("TF_CONTINUOUS_PROFILER_WINDOW_MS", &options.window_ms);
+  ReadOption("TF_CONTINUOUS_PROFILER_RETENTION_MS", &options.retention_ms);
+  ReadOption("TF_CONTINUOUS_PROFILER_MAX_BYTES", &options.max_bytes);
+  int64 level = options.host_trace_level;
+  ReadOption("TF_CONTINUOUS_PROFILER_LEVEL", &level);
+  options.host_trace_level = static_cast<int>(level);
+  return options;
+}
+
+/*static*/ ContinuousProfiler* ContinuousProfiler::Global() {
+  static ContinuousProfiler* profiler = []() -> ContinuousProfiler* {
+    const Options options = OptionsFromEnv();
+    if (options.period_ms <= 0) return nullptr;
+    LOG(INFO) << "Sampling TraceMes up to level " << options.host_trace_level
+              << " for " << options.window_ms << "ms every "
+              << options.period_ms << "ms, keeping "
+              << options.retention_ms << "ms or " << options.max_bytes
+              << " bytes";
+    return new ContinuousProfiler(options);
+  }();
+  return profiler;
+}
+
+ContinuousProfiler::ContinuousProfiler(const Options& options, Env* env)
+    : options_(options), env_(env) {
+  if (options_.period_ms > 0 && options_.window_ms > 0) {
+    thread_.reset(env_->StartThread({}, "continuous_profiler",
+                                    [this]() { Run(); }));
+  }
+}
+
+ContinuousProfiler::~ContinuousProfiler() {
+  {
+    mutex_lock l(mu_);
+    stopping_ = true;
+    cv_.notify_all();
+  }
+  thread_.reset();
+}
+
+void ContinuousProfiler::Run() {
+  const uint64 period_ns = options_.period_ms * EnvTime::kMillisToNanos;
+  uint64 next_ns = env_->NowNanos();
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      while (!stopping_) {
+        const uint64 now_ns = env_->NowNanos();
+        if (now_ns >= next_ns) break;
+        cv_.wait_for(l, std::chrono::nanoseconds(next_ns - now_ns));
+      }
+      if (stopping_) return;
+    }
+    if (!RecordWindow()) {
+      mutex_lock l(mu_);
+      ++stats_.windows_skipped;
+    }
+    // Windows that overrun the period delay the next one rather than running
+    // back to back, so the duty cycle stays bounded.
+    next_ns = std::max(next_ns + period_ns, env_->NowNanos());
+  }
+}
+
+bool ContinuousProfiler::RecordWindow() {
+  const uint64 control_start_ns = env_->NowNanos();
+  {
+    mutex_lock l(mu_);
+    if (stopping_ || pause_count_ > 0) return false;
+    if (!AcquireProfilerLock()) return false;
+    recording_ = true;
+  }
+
+  const bool started = TraceMeRecorder::Start(options_.host_trace_level);
+  const uint64 start_ns = env_->NowNanos();
+  if (started) {
+    const uint64 deadline_ns =
+        start_ns + options_.window_ms * EnvTime::kMillisToNanos;
+    mutex_lock l(mu_);
+    while (!stopping_ && pause_count_ == 0) {
+      const uint64 now_ns = env_->NowNanos();
+      if (now_ns >= deadline_ns) break;
+      cv_.wait_for(l, std::chrono::nanoseconds(deadline_ns - now_ns));
+    }
+  }
+  const uint64 end_ns = env_->NowNanos();
+  TraceMeRecorder::Events events;
+  if (started) events = TraceMeRecorder::Stop();
+  ReleaseProfilerLock();
+
+  int64 num_events = 0;
+  for (const auto& thread : events) num_events += thread.events.size();
+  const int64 bytes = EstimateBytes(events);
+
+  mutex_lock l(mu_);
+  recording_ = false;
+  cv_.notify_all();
+  if (!started) return false;
+  ++stats_.windows_recorded;
+  stats_.recorded_ns += end_ns - start_ns;
+  if (num_events > 0) {
+    windows_.push_back({start_ns, end_ns, num_events, bytes,
+                        std::move(events)});
+    ++stats_.windows_buffered;
+    stats_.events_buffered += num_events;
+    stats_.bytes_buffered += bytes;
+  }
+  Evict(end_ns);
+  stats_.control_ns +=
+      (env_->NowNanos() - control_start_ns) - (end_ns - start_ns);
+  return true;
+}
+
+void ContinuousProfiler::Evict(uint64 now_ns) {
+  const uint64 retention_ns = options_.retention_ms * EnvTime::kMillisToNanos;
+  while (!windows_.empty() &&
+         (stats_.bytes_buffered > options_.max_bytes ||
+          windows_.front().end_ns + retention_ns < now_ns)) {
+    const Window& window = windows_.front();
+    --stats_.windows_buffered;
+    stats_.events_buffered -= window.num_events;
+    stats_.bytes_buffered -= window.bytes;
+    ++stats_.windows_dropped;
+    windows_.pop_front();
+  }
+}
+
+Status ContinuousProfiler::Collect(int64 lookback_ms, XSpace* space) {
+  const uint64 now_ns = env_->NowNanos();
+  const uint64 lookback_ns = lookback_ms * EnvTime::kMillisToNanos;
+  const uint64 since_ns =
+      lookback_ms > 0 && lookback_ns < now_ns ? now_ns - lookback_ns : 0;
+
+  uint64 start_timestamp_ns = 0;
+  // Concatenates the events of each thread over the windows, so that
+  // activities that span windows are paired by MakeCompleteEvents.
+  std::map<int32, TraceMeRecorder::ThreadEvents> threads;
+  Stats stats;
+  {
+    mutex_lock l(mu_);
+    Evict(now_ns);
+    for (const Window& window : windows_) {
+      if (window.end_ns < since_ns) continue;
+      if (start_timestamp_ns == 0) start_timestamp_ns = window.start_ns;
+      for (const auto& thread : window.events) {
+        TraceMeRecorder::ThreadEvents& merged = threads[thread.thread.tid];
+        merged.thread = thread.thread;
+        merged.events.insert(merged.events.end(), thread.events.begin(),
+                             thread.events.end());
+      }
+    }
+    stats = stats_;
+  }
+
+  TraceMeRecorder::Events events;
+  events.reserve(threads.size());
+  for (auto& tid_and_thread : threads) {
+    events.push_back(std::move(tid_and_thread.second));
+  }
+  MakeCompleteEvents(&events);
+  ConvertCompleteEventsToXPlane(start_timestamp_ns, events,
+                                GetOrCreatePlane(space, kHostThreads));
+
+  XPlaneBuilder plane(GetOrCreatePlane(space, kContinuousProfilerPlane));
+  int64 stat_id = 0;
+  auto add_stat = [&plane, &stat_id](absl::string_view name, int64 value) {
+    XStatMetadata* metadata = plane.GetOrCreateStatMetadata(stat_id++);
+    metadata->set_name(string(name));
+    plane.AddStatValue(*metadata, value);
+  };
+  add_stat("period_ms", options_.period_ms);
+  add_stat("window_ms", options_.window_ms);
+  add_stat("windows_recorded", stats.windows_recorded);
+  add_stat("windows_skipped", stats.windows_skipped);
+  add_stat("windows_dropped", stats.windows_dropped);
+  add_stat("windows_buffered", stats.windows_buffered);
+  add_stat("events_buffered", stats.events_buffered);
+  add_stat("bytes_buffered", stats.bytes_buffered);
+  add_stat("recorded_ns", stats.recorded_ns);
+  add_stat("control_ns", stats.control_ns);
+  return Status::OK();
+}
+
+ContinuousProfiler::Stats ContinuousProfiler::GetStats() {
+  mutex_lock l(mu_);
+  return stats_;
+}
+
+void ContinuousProfiler::Pause() {
+  mutex_lock l(mu_);
+  ++pause_count_;
+  cv_.notify_all();
+  while (recording_) cv_.wait(l);
+}
+
+void ContinuousProfiler::Resume() {
+  mutex_lock l(mu_);
+  DCHECK_GT(pause_count_, 0);
+  --pause_count_;
+}
+
+ContinuousProfiler::ScopedPause::ScopedPause(ContinuousProfiler* profiler)
+    : profiler_(profiler) {
+  if (profiler_ != nullptr) profiler_->Pause();
+}
+
+ContinuousProfiler::ScopedPause::~ScopedPause() {
+  if (profiler_ != nullptr) profiler_->Resume();
+}
+
+}  // namespace profiler
+}  // namespace tensorflow
@@ -0,0 +1,150 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PROFILER_LIB_CONTINUOUS_PROFILER_H_
+#define TENSORFLOW_CORE_PROFILER_LIB_CONTINUOUS_PROFILER_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/internal/traceme_recorder.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+
+// Samples host TraceMe events continuously into a bounded ring.
+//
+// Every `period_ms` the profiler records TraceMes for `window_ms`, so that
+// TraceMe overhead is only paid for window_ms / period_ms of the time. Windows
+// older than `retention_ms`, or beyond `max_bytes` of buffered events, are
+// dropped oldest first. Collect() returns the windows of the last few
+// minutes as an XSpace, without interrupting sampling.
+//
+// Only one profiler may record TraceMes at a time, so a window is skipped
+// while a ProfilerSession is active, and an on-demand session should hold a
+// ScopedPause so that it does not race with the next window.
+//
+// Thread-safety: This class is thread-safe.
+class ContinuousProfiler {
+ public:
+  struct Options {
+    // Time between the starts of consecutive windows. 0 disables sampling.
+    int64 period_ms = 0;
+    // Time recorded per window.
+    int64 window_ms = 100;
+    // Windows older than this are dropped.
+    int64 retention_ms = 10 * 60 * 1000;
+    // Upper bound on the estimated size of buffered events.
+    int64 max_bytes = 64 << 20;
+    // Only TraceMes up to this level are recorded.
+    int host_trace_level = 1;
+  };
+
+  // Counters describing the sampling and its cost.
+  struct Stats {
+    int64 windows_recorded = 0;
+    // Windows not recorded because another profiler was active or sampling
+    // was paused.
+    int64 windows_skipped = 0;
+    // Windows evicted because of retention_ms or max_bytes.
+    int64 windows_dropped = 0;
+    int64 windows_buffered = 0;
+    int64 events_buffered = 0;
+    int64 bytes_buffered = 0;
+    // Total time TraceMes were recorded.
+    int64 recorded_ns = 0;
+    // Total time spent starting and stopping the recorder and buffering its
+    // events, i.e. the cost of sampling beyond the TraceMes themselves.
+    int64 control_ns = 0;
+  };
+
+  // Returns the profiler configured by the TF_CONTINUOUS_PROFILER_PERIOD_MS,
+  // _WINDOW_MS, _RETENTION_MS, _MAX_BYTES and _LEVEL environment variables,
+  // started on first use, or nullptr if the period is not set.
+  static ContinuousProfiler* Global();
+
+  // Returns the Options set by those environment variables. Malformed values
+  // are logged and left at their default.
+  static Options OptionsFromEnv();
+
+  // Starts sampling if options.period_ms > 0.
+  explicit ContinuousProfiler(const Options& options,
+                              Env* env = Env::Default());
+  ~ContinuousProfiler();
+
+  // Adds the windows that ended within the last `lookback_ms` to `space`, as
+  // a kHostThreads plane, and the sampling Stats as a separate plane.
+  Status Collect(int64 lookback_ms, XSpace* space);
+
+  Stats GetStats();
+
+  const Options& options() const { return options_; }
+
+  // Ends the current window early and skips windows for the lifetime of the
+  // instance. Pauses nest. `profiler` may be nullptr.
+  class ScopedPause {
+   public:
+    explicit ScopedPause(ContinuousProfiler* profiler);
+    ~ScopedPause();
+
+   private:
+    ContinuousProfiler* const profiler_;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(ScopedPause);
+  };
+
+ private:
+  struct Window {
+    uint64 start_ns;
+    uint64 end_ns;
+    int64 num_events;
+    int64 bytes;
+    TraceMeRecorder::Events events;
+  };
+
+  void Run();
+  // Records one window, returns false if it was skipped.
+  bool RecordWindow() LOCKS_EXCLUDED(mu_);
+  void Evict(uint64 now_ns) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void Pause() LOCKS_EXCLUDED(mu_);
+  void Resume() LOCKS_EXCLUDED(mu_);
+
+  const Options options_;
+  Env* const env_;
+
+  mutex mu_;
+  condition_variable cv_;
+  bool stopping_ GUARDED_BY(mu_) = false;
+  int pause_count_ GUARDED_BY(mu_) = 0;
+  bool recording_ GUARDED_BY(mu_) = false;
+  std::deque<Window> windows_ GUARDED_BY(mu_);
+  Stats stats_ GUARDED_BY(mu_);
+
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ContinuousProfiler);
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_LIB_CONTINUOUS_PROFILER_H_
@@ -0,0 +1,207 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/lib/continuous_profiler.h"
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <functional>
+#include <set>
+#include <string>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/profiler/internal/traceme_recorder.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+#include "tensorflow/core/profiler/utils/xplane_schema.h"
+#include "tensorflow/core/profiler/utils/xplane_utils.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+// Windows start every kPeriodMs of fake time, and only end when the test
+// pauses the profiler, as the fake clock never reaches their deadline.
+constexpr int64 kPeriodMs = 20;
+
+// An Env whose clock only moves when the test advances it.
+class FakeClockEnv : public EnvWrapper {
+ public:
+  FakeClockEnv() : EnvWrapper(Env::Default()) {}
+
+  uint64 NowNanos() const override { return now_ns_; }
+  uint64 NowMicros() const override {
+    return now_ns_ / EnvTime::kMicrosToNanos;
+  }
+
+  void AdvanceMillis(int64 ms) { now_ns_ += ms * EnvTime::kMillisToNanos; }
+
+ private:
+  std::atomic<uint64> now_ns_{1000 * EnvTime::kSecondsToNanos};
+};
+
+// Polls `condition` for up to 10 seconds of real time.
+bool WaitFor(const std::function<bool()>& condition) {
+  for (int i = 0; i < 10000; ++i) {
+    if (condition()) return true;
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  return condition();
+}
+
+// Returns the names of the host events in `space`.
+std::set<string> EventNames(const XSpace& space) {
+  std::set<string> names;
+  const XPlane* plane = FindPlaneWithName(space, kHostThreads);
+  if (plane == nullptr) return names;
+  for (const auto& id_and_metadata : plane->event_metadata()) {
+    if (!id_and_metadata.second.name().empty()) {
+      names.insert(id_and_metadata.second.name());
+    }
+  }
+  return names;
+}
+
+class ContinuousProfilerTest : public ::testing::Test {
+ protected:
+  ContinuousProfiler::Options MakeOptions() {
+    ContinuousProfiler::Options options;
+    options.period_ms = kPeriodMs;
+    options.window_ms = 10 * 60 * 1000;
+    return options;
+  }
+
+  // Waits for the current window, records a TraceMe named `name` in it, and
+  // ends it with a pause at the current fake time.
+  void RecordWindow(ContinuousProfiler* profiler, const string& name) {
+    ASSERT_TRUE(WaitFor([] { return TraceMeRecorder::Active(); }));
+    { TraceMe trace(name); }
+    ContinuousProfiler::ScopedPause pause(profiler);
+  }
+
+  std::set<string> Collect(ContinuousProfiler* profiler, int64 lookback_ms) {
+    XSpace space;
+    TF_EXPECT_OK(profiler->Collect(lookback_ms, &space));
+    return EventNames(space);
+  }
+
+  FakeClockEnv env_;
+};
+
+TEST_F(ContinuousProfilerTest, RecordsWindows) {
+  ContinuousProfiler profiler(MakeOptions(), &env_);
+  RecordWindow(&profiler, "first");
+  env_.AdvanceMillis(kPeriodMs);
+  RecordWindow(&profiler, "second");
+
+  ContinuousProfiler::Stats stats = profiler.GetStats();
+  EXPECT_EQ(stats.windows_recorded, 2);
+  EXPECT_EQ(stats.windows_skipped, 0);
+  EXPECT_EQ(stats.windows_dropped, 0);
+  EXPECT_EQ(stats.windows_buffered, 2);
+  EXPECT_GE(stats.events_buffered, 2);
+  EXPECT_GT(stats.bytes_buffered, 0);
+
+  std::set<string> names = Collect(&profiler, /*lookback_ms=*/0);
+  EXPECT_EQ(names.count("first"), 1);
+  EXPECT_EQ(names.count("second"), 1);
+
+  // Only the second window ended within the lookback.
+  names = Collect(&profiler, /*lookback_ms=*/kPeriodMs / 2);
+  EXPECT_EQ(names.count("first"), 0);
+  EXPECT_EQ(names.count("second"), 1);
+}
+
+TEST_F(ContinuousProfilerTest, EvictsWindowsPastRetention) {
+  ContinuousProfiler::Options options = MakeOptions();
+  options.retention_ms = 5 * kPeriodMs;
+  ContinuousProfiler profiler(options, &env_);
+  RecordWindow(&profiler, "old");
+  env_.AdvanceMillis(kPeriodMs);
+  RecordWindow(&profiler, "new");
+  EXPECT_EQ(profiler.GetStats().windows_buffered, 2);
+
+  // "old" ended retention_ms + kPeriodMs / 2 ago, "new" kPeriodMs later.
+  env_.AdvanceMillis(options.retention_ms - kPeriodMs / 2);
+  std::set<string> names = Collect(&profiler, /*lookback_ms=*/0);
+  EXPECT_EQ(names.count("old"), 0);
+  EXPECT_EQ(names.count("new"), 1);
+
+  ContinuousProfiler::Stats stats = profiler.GetStats();
+  EXPECT_EQ(stats.windows_dropped, 1);
+  EXPECT_EQ(stats.windows_buffered, 1);
+}
+
+TEST_F(ContinuousProfilerTest, EvictsWindowsPastMaxBytes) {
+  ContinuousProfiler::Options options = MakeOptions();
+  options.max_bytes = 1;
+  ContinuousProfiler profiler(options, &env_);
+  RecordWindow(&profiler, "dropped");
+
+  ContinuousProfiler::Stats stats = profiler.GetStats();
+  EXPECT_EQ(stats.windows_recorded, 1);
+  EXPECT_EQ(stats.windows_dropped, 1);
+  EXPECT_EQ(stats.windows_buffered, 0);
+  EXPECT_EQ(stats.events_buffered, 0);
+  EXPECT_EQ(stats.bytes_buffered, 0);
+  EXPECT_EQ(Collect(&profiler, /*lookback_ms=*/0).count("dropped"), 0);
+}
+
+TEST_F(ContinuousProfilerTest, SkipsWindowsWhilePaused) {
+  ContinuousProfiler profiler(MakeOptions(), &env_);
+  RecordWindow(&profiler, "before");
+  {
+    ContinuousProfiler::ScopedPause pause(&profiler);
+    env_.AdvanceMillis(kPeriodMs);
+    ASSERT_TRUE(WaitFor(
+        [&profiler] { return profiler.GetStats().windows_skipped > 0; }));
+    EXPECT_FALSE(TraceMeRecorder::Active());
+    { TraceMe trace("paused"); }
+  }
+  env_.AdvanceMillis(kPeriodMs);
+  RecordWindow(&profiler, "after");
+
+  ContinuousProfiler::Stats stats = profiler.GetStats();
+  EXPECT_EQ(stats.windows_recorded, 2);
+  EXPECT_EQ(stats.windows_skipped, 1);
+  std::set<string> names = Collect(&profiler, /*lookback_ms=*/0);
+  EXPECT_EQ(names.count("before"), 1);
+  EXPECT_EQ(names.count("paused"), 0);
+  EXPECT_EQ(names.count("after"), 1);
+}
+
+TEST(ContinuousProfilerOptionsTest, MalformedEnvironmentKeepsDefaults) {
+  setenv("TF_CONTINUOUS_PROFILER_PERIOD_MS", "1000", 1 /* replace */);
+  setenv("TF_CONTINUOUS_PROFILER_WINDOW_MS", "ten", 1 /* replace */);
+  setenv("TF_CONTINUOUS_PROFILER_MAX_BYTES", "1M", 1 /* replace */);
+  ContinuousProfiler::Options options = ContinuousProfiler::OptionsFromEnv();
+  unsetenv("TF_CONTINUOUS_PROFILER_PERIOD_MS");
+  unsetenv("TF_CONTINUOUS_PROFILER_WINDOW_MS");
+  unsetenv("TF_CONTINUOUS_PROFILER_MAX_BYTES");
+
+  const ContinuousProfiler::Options defaults;
+  EXPECT_EQ(options.period_ms, 1000);
+  EXPECT_EQ(options.window_ms, defaults.window_ms);
+  EXPECT_EQ(options.retention_ms, defaults.retention_ms);
+  EXPECT_EQ(options.max_bytes, defaults.max_bytes);
+  EXPECT_EQ(options.host_trace_level, defaults.host_trace_level);
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
@@ -0,0 +1,70 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PROFILER_LIB_SCOPED_MEMORY_DEBUG_ANNOTATION_H_
+#define TENSORFLOW_CORE_PROFILER_LIB_SCOPED_MEMORY_DEBUG_ANNOTATION_H_
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace profiler {
+
+// The op and step an allocation is made for, as seen by allocators.
+struct MemoryDebugAnnotation {
+  const char* pending_op_name = nullptr;
+  int64 pending_step_id = 0;
+};
+
+// Sets the op and step that allocations on the current thread are attributed
+// to in the memory profile, for the lifetime of the instance. Unlike
+// MEMDEBUG_CACHE_OP this is available in every build; it costs two
+// thread-local stores. `op_name` must outlive the instance.
+//
+// Usage: {
+//          ScopedMemoryDebugAnnotation annotation(kernel->name().c_str(),
+//                                                 step_id);
+//          Tensor t(allocator, dtype, shape);  // Attributed to the kernel.
+//        }
+class ScopedMemoryDebugAnnotation {
+ public:
+  static const MemoryDebugAnnotation& CurrentAnnotation() {
+    return Annotation();
+  }
+
+  explicit ScopedMemoryDebugAnnotation(const char* op_name)
+      : last_annotation_(Annotation()) {
+    Annotation().pending_op_name = op_name;
+  }
+
+  ScopedMemoryDebugAnnotation(const char* op_name, int64 step_id)
+      : last_annotation_(Annotation()) {
+    Annotation().pending_op_name = op_name;
+    Annotation().pending_step_id = step_id;
+  }
+
+  ~ScopedMemoryDebugAnnotation() { Annotation() = last_annotation_; }
+
+ private:
+  static MemoryDebugAnnotation& Annotation();
+
+  const MemoryDebugAnnotation last_annotation_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedMemoryDebugAnnotation);
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_LIB_SCOPED_MEMORY_DEBUG_ANNOTATION_H_
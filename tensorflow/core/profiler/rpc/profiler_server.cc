@@ -21,6 +21,7 @@ limitations under the License.
 #include "grpcpp/grpcpp.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/profiler/lib/continuous_profiler.h"
 #include "tensorflow/core/profiler/profiler_service.grpc.pb.h"
 #include "tensorflow/core/profiler/rpc/profiler_service_impl.h"
 #include "tensorflow/core/util/ptr_util.h"
@@ -28,6 +29,9 @@ limitations under the License.
 namespace tensorflow {
 
 std::unique_ptr<Thread> StartProfilerServer(int32 port) {
+  // Starts sampling if TF_CONTINUOUS_PROFILER_PERIOD_MS is set, so that
+  // clients can pull recent profiles without starting a session.
+  profiler::ContinuousProfiler::Global();
   Env* env = Env::Default();
   return WrapUnique(env->StartThread({}, "profiler server", [port]() {
     string server_address = absl::StrCat("0.0.0.0:", port);
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/profiler/convert/op_stats_to_tf_stats.h"
 #include "tensorflow/core/profiler/convert/xplane_to_op_stats.h"
+#include "tensorflow/core/profiler/lib/continuous_profiler.h"
 #include "tensorflow/core/profiler/lib/profiler_session.h"
 #include "tensorflow/core/profiler/protobuf/op_stats.pb.h"
 #include "tensorflow/core/profiler/protobuf/tf_stats.pb.h"
@@ -35,6 +36,9 @@ namespace tensorflow {
 namespace {
 
 const absl::string_view kTensorflowStats = "tensorflow_stats";
+// Returns the XSpace sampled by the continuous profiler over the last
+// duration_ms, without starting a session.
+const absl::string_view kContinuousProfile = "continuous_profile";
 
 template <typename Proto>
 void AddToolData(absl::string_view tool_name, const Proto& tool_output,
@@ -74,6 +78,25 @@ class ProfilerServiceImpl : public grpc::ProfilerService::Service {
   ::grpc::Status Profile(::grpc::ServerContext* ctx, const ProfileRequest* req,
                          ProfileResponse* response) override {
     LOG(INFO) << "Received a profile request: " << req->DebugString();
+    profiler::ContinuousProfiler* continuous_profiler =
+        profiler::ContinuousProfiler::Global();
+    if (req->tools_size() == 1 && req->tools(0) == kContinuousProfile) {
+      if (continuous_profiler == nullptr) {
+        return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION,
+                              "TF_CONTINUOUS_PROFILER_PERIOD_MS is not set.");
+      }
+      profiler::XSpace space;
+      Status status = continuous_profiler->Collect(req->duration_ms(), &space);
+      if (!status.ok()) {
+        return ::grpc::Status(::grpc::StatusCode::INTERNAL,
+                              status.error_message());
+      }
+      AddToolData(kContinuousProfile, space, response);
+      return ::grpc::Status::OK;
+    }
+
+    // Stop sampling while the session records everything.
+    profiler::ContinuousProfiler::ScopedPause pause(continuous_profiler);
     std::unique_ptr<ProfilerSession> profiler = ProfilerSession::Create();
     Status status = profiler->Status();
     if (!status.ok()) {
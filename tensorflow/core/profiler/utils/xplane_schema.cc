@@ -24,6 +24,7 @@ namespace profiler {
 
 const absl::string_view kHostThreads = "Host Threads";
 const absl::string_view kGpuPlanePrefix = "GPU:";
+const absl::string_view kVePlanePrefix = "VE:";
 
 constexpr int kNumHostEventTypes =
     HostEventType::kLastHostEventType - HostEventType::kFirstHostEventType + 1;
@@ -89,6 +90,9 @@ static const absl::string_view kStatTypeStrMap[] = {
     "bytes_available",
     "fragmentation",
     "peak_bytes_in_use",
+    "requested_bytes",
+    "allocation_bytes",
+    "addr",
     "device_id",
     "context_id",
     "correlation_id",
@@ -146,6 +150,9 @@ const absl::flat_hash_map<absl::string_view, StatType>& GetStatTypeMap() {
           {"bytes_available", kBytesAvailable},
           {"fragmentation", kFragmentation},
           {"peak_bytes_in_use", kPeakBytesInUse},
+          {"requested_bytes", kRequestedBytes},
+          {"allocation_bytes", kAllocationBytes},
+          {"addr", kAddress},
           // Device trace arguments.
           {"device_id", kDeviceId},
           {"context_id", kContextId},
@@ -28,6 +28,8 @@ namespace profiler {
 ABSL_CONST_INIT extern const absl::string_view kHostThreads;
 // Name prefix of XPlane that contains GPU events.
 ABSL_CONST_INIT extern const absl::string_view kGpuPlanePrefix;
+// Name prefix of XPlane that contains VE events.
+ABSL_CONST_INIT extern const absl::string_view kVePlanePrefix;
 
 // Interesting event types (i.e., TraceMe names).
 enum HostEventType {
@@ -88,6 +90,9 @@ enum StatType {
   kBytesAvailable,
   kFragmentation,
   kPeakBytesInUse,
+  kRequestedBytes,
+  kAllocationBytes,
+  kAddress,
   // Device trace arguments.
   kDeviceId,
   kContextId,
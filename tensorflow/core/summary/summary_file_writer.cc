@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/summary/summary_file_writer.h"
 
+#include <deque>
+
 #include "tensorflow/core/summary/summary_converter.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -21,19 +23,37 @@ limitations under the License.
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/events_writer.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
 namespace {
 
+// What WriteEvent() does when the queue of events waiting for the writer
+// thread is full.
+enum class Backpressure {
+  // Wait for the writer thread to take the queued events.
+  kBlock,
+  // Drop the event.
+  kDrop,
+  // Replace the queued event with the same tag, or drop the event if there is
+  // none.
+  kCoalesce,
+};
+
 class SummaryFileWriter : public SummaryWriterInterface {
  public:
-  SummaryFileWriter(int max_queue, int flush_millis, Env* env)
+  SummaryFileWriter(int max_queue, int flush_millis, int64 queue_capacity,
+                    Backpressure backpressure, Env* env)
       : SummaryWriterInterface(),
         is_initialized_(false),
         max_queue_(max_queue),
         flush_millis_(flush_millis),
+        queue_capacity_(std::max<int64>(queue_capacity, max_queue + 1)),
+        backpressure_(backpressure),
         env_(env) {}
 
   Status Initialize(const string& logdir, const string& filename_suffix) {
@@ -44,14 +64,19 @@ class SummaryFileWriter : public SummaryWriterInterface {
       }
       TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(logdir));
     }
-    mutex_lock ml(mu_);
     events_writer_ =
         tensorflow::MakeUnique<EventsWriter>(io::JoinPath(logdir, "events"));
     TF_RETURN_WITH_CONTEXT_IF_ERROR(
         events_writer_->InitWithSuffix(filename_suffix),
         "Could not initialize events writer.");
     last_flush_ = env_->NowMicros();
-    is_initialized_ = true;
+    {
+      mutex_lock ml(mu_);
+      is_initialized_ = true;
+    }
+    writer_thread_.reset(env_->StartThread(ThreadOptions(),
+                                           "summary_file_writer",
+                                           [this]() { WriterLoop(); }));
     return Status::OK();
   }
 
@@ -60,11 +85,25 @@ class SummaryFileWriter : public SummaryWriterInterface {
     if (!is_initialized_) {
       return errors::FailedPrecondition("Class was not properly initialized.");
     }
-    return InternalFlush();
+    const uint64 generation = ++flush_requested_;
+    work_cv_.notify_one();
+    while (flush_completed_ < generation) {
+      done_cv_.wait(ml);
+    }
+    return ConsumeStatus();
   }
 
   ~SummaryFileWriter() override {
-    (void)Flush();  // Ignore errors.
+    if (writer_thread_ != nullptr) {
+      (void)Flush();  // Ignore errors.
+      {
+        mutex_lock ml(mu_);
+        shutdown_ = true;
+        work_cv_.notify_one();
+      }
+      // Joins the writer thread.
+      writer_thread_.reset();
+    }
   }
 
   Status WriteTensor(int64 global_step, Tensor t, const string& tag,
@@ -140,12 +179,27 @@ class SummaryFileWriter : public SummaryWriterInterface {
 
   Status WriteEvent(std::unique_ptr<Event> event) override {
     mutex_lock ml(mu_);
-    queue_.emplace_back(std::move(event));
-    if (queue_.size() > max_queue_ ||
-        env_->NowMicros() - last_flush_ > 1000 * flush_millis_) {
-      return InternalFlush();
+    if (queue_.size() >= queue_capacity_) {
+      switch (backpressure_) {
+        case Backpressure::kBlock:
+          while (queue_.size() >= queue_capacity_) {
+            done_cv_.wait(ml);
+          }
+          break;
+        case Backpressure::kDrop:
+          DropEvent();
+          return ConsumeStatus();
+        case Backpressure::kCoalesce:
+          if (!RemoveQueuedEventWithTag(CoalescingTag(*event))) {
+            DropEvent();
+            return ConsumeStatus();
+          }
+          break;
+      }
     }
-    return Status::OK();
+    queue_.push_back(std::move(event));
+    work_cv_.notify_one();
+    return ConsumeStatus();
   }
 
   string DebugString() const override { return "SummaryFileWriter"; }
@@ -155,28 +209,125 @@ class SummaryFileWriter : public SummaryWriterInterface {
     return static_cast<double>(env_->NowMicros()) / 1.0e6;
   }
 
-  Status InternalFlush() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    for (const std::unique_ptr<Event>& e : queue_) {
-      events_writer_->WriteEvent(*e);
+  // Serializes the queued events and writes them to the events file, flushing
+  // it when requested, when more than max_queue_ events were written since the
+  // last flush, and when the oldest of them is flush_millis_ old.
+  void WriterLoop() {
+    int unflushed_events = 0;
+    while (true) {
+      std::deque<std::unique_ptr<Event>> events;
+      uint64 flush_requested;
+      bool flush;
+      bool idle = false;
+      {
+        mutex_lock ml(mu_);
+        while (queue_.empty() && flush_requested_ == flush_completed_ &&
+               !idle) {
+          if (shutdown_) {
+            return;
+          }
+          if (unflushed_events == 0) {
+            work_cv_.wait(ml);
+          } else {
+            idle = WaitForMilliseconds(&ml, &work_cv_, flush_millis_) ==
+                   kCond_Timeout;
+          }
+        }
+        events.swap(queue_);
+        flush_requested = flush_requested_;
+        flush = flush_requested_ != flush_completed_;
+        done_cv_.notify_all();
+      }
+
+      for (const std::unique_ptr<Event>& e : events) {
+        events_writer_->WriteEvent(*e);
+      }
+      unflushed_events += events.size();
+      events.clear();
+      Status s;
+      if (flush || (unflushed_events > 0 &&
+                    (idle || unflushed_events > max_queue_ ||
+                     env_->NowMicros() - last_flush_ > 1000 * flush_millis_))) {
+        s = events_writer_->Flush();
+        if (!s.ok()) {
+          errors::AppendToMessage(&s, "Could not flush events file.");
+        }
+        unflushed_events = 0;
+        last_flush_ = env_->NowMicros();
+      }
+
+      mutex_lock ml(mu_);
+      if (!s.ok() && status_.ok()) {
+        status_ = s;
+      }
+      flush_completed_ = flush_requested;
+      done_cv_.notify_all();
     }
-    queue_.clear();
-    TF_RETURN_WITH_CONTEXT_IF_ERROR(events_writer_->Flush(),
-                                    "Could not flush events file.");
-    last_flush_ = env_->NowMicros();
-    return Status::OK();
   }
 
-  bool is_initialized_;
+  // Returns the tag of the only summary value of `event`, or an empty string
+  // if it does not have exactly one.
+  static string CoalescingTag(const Event& event) {
+    if (event.has_summary() && event.summary().value_size() == 1) {
+      return event.summary().value(0).tag();
+    }
+    return "";
+  }
+
+  // Removes the oldest queued event whose coalescing tag is `tag`. Returns
+  // false if there is none.
+  bool RemoveQueuedEventWithTag(const string& tag)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (tag.empty()) {
+      return false;
+    }
+    for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+      if (CoalescingTag(**it) == tag) {
+        queue_.erase(it);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void DropEvent() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    ++dropped_events_;
+    LOG_EVERY_N(WARNING, 1000)
+        << "The summary writer queue is full, dropped " << dropped_events_
+        << " events so far.";
+  }
+
+  // Returns the first error of the writer thread since the last call.
+  Status ConsumeStatus() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Status s = status_;
+    status_ = Status::OK();
+    return s;
+  }
+
+  bool is_initialized_ GUARDED_BY(mu_);
   const int max_queue_;
   const int flush_millis_;
-  uint64 last_flush_;
+  const size_t queue_capacity_;
+  const Backpressure backpressure_;
   Env* env_;
   mutex mu_;
-  std::vector<std::unique_ptr<Event>> queue_ GUARDED_BY(mu_);
-  // A pointer to allow deferred construction.
-  std::unique_ptr<EventsWriter> events_writer_ GUARDED_BY(mu_);
+  // Signaled when events or flush requests are queued.
+  condition_variable work_cv_;
+  // Signaled when the writer thread takes the queued events and when it
+  // completes a flush request.
+  condition_variable done_cv_;
+  std::deque<std::unique_ptr<Event>> queue_ GUARDED_BY(mu_);
+  uint64 flush_requested_ GUARDED_BY(mu_) = 0;
+  uint64 flush_completed_ GUARDED_BY(mu_) = 0;
+  bool shutdown_ GUARDED_BY(mu_) = false;
+  int64 dropped_events_ GUARDED_BY(mu_) = 0;
+  Status status_ GUARDED_BY(mu_);
+  // Only accessed by the writer thread once it has been started.
+  std::unique_ptr<EventsWriter> events_writer_;
+  uint64 last_flush_;
   std::vector<std::pair<string, SummaryMetadata>> registered_summaries_
       GUARDED_BY(mu_);
+  std::unique_ptr<Thread> writer_thread_;
 };
 
 }  // namespace
@@ -185,7 +336,36 @@ Status CreateSummaryFileWriter(int max_queue, int flush_millis,
                                const string& logdir,
                                const string& filename_suffix, Env* env,
                                SummaryWriterInterface** result) {
-  SummaryFileWriter* w = new SummaryFileWriter(max_queue, flush_millis, env);
+  // The number of events queued for the writer thread, and what to do with
+  // the events that are written while the queue is full: "block" until the
+  // writer takes them, "drop" the new events, or "coalesce" them with the
+  // queued events of the same tag.
+  static const int64 queue_capacity = []() {
+    int64 capacity;
+    Status s = ReadInt64FromEnvVar("TF_SUMMARY_WRITER_QUEUE_CAPACITY",
+                                   /*default_val=*/1024, &capacity);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to read TF_SUMMARY_WRITER_QUEUE_CAPACITY: " << s;
+      capacity = 1024;
+    }
+    return capacity;
+  }();
+  static const Backpressure backpressure = []() {
+    string policy;
+    Status s = ReadStringFromEnvVar("TF_SUMMARY_WRITER_BACKPRESSURE",
+                                    /*default_val=*/"block", &policy);
+    if (s.ok() && policy == "drop") {
+      return Backpressure::kDrop;
+    } else if (s.ok() && policy == "coalesce") {
+      return Backpressure::kCoalesce;
+    } else if (!s.ok() || policy != "block") {
+      LOG(ERROR) << "Invalid TF_SUMMARY_WRITER_BACKPRESSURE: " << policy
+                 << ", expected one of block, drop and coalesce.";
+    }
+    return Backpressure::kBlock;
+  }();
+  SummaryFileWriter* w = new SummaryFileWriter(
+      max_queue, flush_millis, queue_capacity, backpressure, env);
   const Status s = w->Initialize(logdir, filename_suffix);
   if (!s.ok()) {
     w->Unref();
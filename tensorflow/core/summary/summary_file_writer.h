@@ -27,8 +27,15 @@ namespace tensorflow {
 /// The file is an append-only records file of tf.Event protos. That
 /// makes this summary writer suitable for file systems like GCS.
 ///
-/// It will enqueue up to max_queue summaries, and flush at least every
-/// flush_millis milliseconds. The summaries will be written to the
+/// The summaries are serialized and written by a background thread, which
+/// flushes the file once more than max_queue summaries were written since the
+/// last flush, and at least every flush_millis milliseconds. The summaries
+/// waiting for that thread are bounded by TF_SUMMARY_WRITER_QUEUE_CAPACITY;
+/// when that queue is full, TF_SUMMARY_WRITER_BACKPRESSURE selects whether
+/// writing a summary blocks ("block", the default), drops it ("drop") or
+/// replaces the queued summary of the same tag ("coalesce"). Errors of the
+/// background thread are returned by the next write or Flush(). The
+/// summaries will be written to the
 /// directory specified by logdir and with the filename suffixed by
 /// filename_suffix. The caller owns a reference to result if the
 /// returned status is ok. The Env object must not be destroyed until
@@ -231,5 +231,45 @@ TEST_F(SummaryFileWriterTest, WallTime) {
       [](const Event& e) { EXPECT_EQ(e.wall_time(), 7.023); }));
 }
 
+TEST_F(SummaryFileWriterTest, WritesAllEventsOnDestruction) {
+  const string test_name = "destruction_test";
+  SummaryWriterInterface* writer;
+  TF_CHECK_OK(CreateSummaryFileWriter(10, 1000, testing::TmpDir(), test_name,
+                                      &env_, &writer));
+  for (int step = 0; step < 100; ++step) {
+    std::unique_ptr<Event> e{new Event};
+    e->set_step(step);
+    e->mutable_summary()->add_value()->set_tag("hi");
+    TF_CHECK_OK(writer->WriteEvent(std::move(e)));
+  }
+  writer->Unref();
+
+  std::vector<string> files;
+  TF_CHECK_OK(env_.GetChildren(testing::TmpDir(), &files));
+  int num_files = 0;
+  for (const string& f : files) {
+    if (!absl::StrContains(f, test_name)) {
+      continue;
+    }
+    ++num_files;
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env_.NewRandomAccessFile(io::JoinPath(testing::TmpDir(), f),
+                                         &read_file));
+    io::RecordReader reader(read_file.get(), io::RecordReaderOptions());
+    tstring record;
+    uint64 offset = 0;
+    TF_CHECK_OK(reader.ReadRecord(&offset, &record));  // The file version.
+    for (int step = 0; step < 100; ++step) {
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      Event e;
+      e.ParseFromString(record);
+      EXPECT_EQ(step, e.step());
+    }
+    EXPECT_EQ(errors::Code::OUT_OF_RANGE,
+              reader.ReadRecord(&offset, &record).code());
+  }
+  EXPECT_EQ(1, num_files);
+}
+
 }  // namespace
 }  // namespace tensorflow
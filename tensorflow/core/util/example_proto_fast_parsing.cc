@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "absl/base/casts.h"
@@ -238,15 +240,16 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64>(n));
+        if (stream.CurrentPosition() + packed_length > serialized_.size()) {
+          return false;
         }
-
-        stream.PopLimit(packed_limit);
+        const uint8* begin = reinterpret_cast<const uint8*>(
+                                 serialized_.data()) +
+                             stream.CurrentPosition();
+        if (!ParsePackedVarint64(begin, begin + packed_length, int64_list)) {
+          return false;
+        }
+        if (!stream.Skip(packed_length)) return false;
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kVarintTag(1))) return false;
@@ -263,6 +266,55 @@ class Feature {
   StringPiece GetSerialized() const { return serialized_; }
 
  private:
+  // Appends the varints in [begin, end) to `int64_list`. The output is sized
+  // once from the number of terminating bytes, and runs of eight single-byte
+  // varints, the common case for ids and small counts, are decoded together.
+  template <typename Result>
+  static bool ParsePackedVarint64(const uint8* begin, const uint8* end,
+                                  Result* int64_list) {
+    if (begin != end && end[-1] >= 0x80) return false;
+    size_t num_values = 0;
+    for (const uint8* p = begin; p < end; ++p) {
+      num_values += *p < 0x80;
+    }
+    const size_t initial_size = int64_list->size();
+    int64_list->resize(initial_size + num_values);
+    // Less than `num_values` in case of a LimitedArraySlice.
+    const size_t capacity = int64_list->size() - initial_size;
+    int64* out = int64_list->data() + initial_size;
+
+    size_t index = 0;
+    const uint8* p = begin;
+    while (p < end) {
+      if (end - p >= 8) {
+        uint64 word;
+        std::memcpy(&word, p, sizeof(word));
+        if ((word & 0x8080808080808080ULL) == 0) {
+          const size_t n =
+              index < capacity ? std::min<size_t>(8, capacity - index) : 0;
+          for (size_t i = 0; i < n; ++i) {
+            out[index + i] = p[i];
+          }
+          index += 8;
+          p += 8;
+          continue;
+        }
+      }
+      uint64 value = 0;
+      int shift = 0;
+      while (true) {
+        if (shift > 63) return false;
+        const uint8 byte = *p++;
+        value |= static_cast<uint64>(byte & 0x7f) << shift;
+        shift += 7;
+        if (byte < 0x80) break;
+      }
+      if (index < capacity) out[index] = static_cast<int64>(value);
+      ++index;
+    }
+    return true;
+  }
+
   // TODO(lew): Pair of uint8* would be more natural.
   StringPiece serialized_;
 };
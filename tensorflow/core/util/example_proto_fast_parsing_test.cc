@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <limits>
 #include <utility>
 
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
@@ -170,6 +171,24 @@ TEST(FastParse, Packed) {
       "\x0a\x0d\x0a\x0b\x0a\x03\x61\x67\x65\x12\x04\x1a\x02\x08\x0d");
 }
 
+TEST(FastParse, PackedInt64) {
+  Example example;
+  Int64List* int64_list =
+      (*example.mutable_features()->mutable_feature())["ids"]
+          .mutable_int64_list();
+  // Runs of single-byte values mixed with multi-byte and negative values.
+  for (int i = 0; i < 20; ++i) {
+    int64_list->add_value(i);
+  }
+  int64_list->add_value(300);
+  int64_list->add_value(-1);
+  int64_list->add_value(std::numeric_limits<int64>::max());
+  for (int i = 0; i < 9; ++i) {
+    int64_list->add_value(i * 13);
+  }
+  TestCorrectness(Serialize(example));
+}
+
 TEST(FastParse, EmptyFeatures) {
   Example example;
   example.mutable_features();
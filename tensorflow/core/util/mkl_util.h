@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_UTIL_MKL_UTIL_H_
 #ifdef INTEL_MKL
 
+#include <algorithm>
 #include <list>
 #include <memory>
 #include <string>
@@ -25,6 +26,7 @@ limitations under the License.
 #include <vector>
 
 #include "mkldnn.hpp"
+#include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
@@ -1980,7 +1982,9 @@ class MklPrimitiveFactory {
 
   MklPrimitive* GetOp(const string& key) {
     auto& lru_cache = MklPrimitiveFactory<T>::GetLRUCache();
-    return lru_cache.GetOp(key);
+    MklPrimitive* op = lru_cache.GetOp(key);
+    metrics::RecordMklPrimitiveCacheLookup(op != nullptr);
+    return op;
   }
 
   void SetOp(const string& key, MklPrimitive* op) {
@@ -2004,10 +2008,25 @@ class MklPrimitiveFactory {
     return is_primitive_mem_opt_enabled;
   }
 
+  /// Function to get the number of primitives every factory caches per
+  /// thread. Serving models with many distinct input shapes creates a
+  /// primitive per shape, so the capacity can be set with
+  /// TF_MKL_PRIMITIVE_CACHE_CAPACITY to trade memory for creation time.
+  static inline int64 GetCacheCapacity() {
+    static const int64 capacity = [] {
+      int64 capacity = kDefaultCacheCapacity;
+      TF_CHECK_OK(ReadInt64FromEnvVar("TF_MKL_PRIMITIVE_CACHE_CAPACITY",
+                                      kDefaultCacheCapacity, &capacity));
+      return std::max<int64>(capacity, 1);
+    }();
+    return capacity;
+  }
+
  private:
+  static constexpr int64 kDefaultCacheCapacity = 1024;
+
   static inline LRUCache<MklPrimitive>& GetLRUCache() {
-    static const int kCapacity = 1024;  // cache capacity
-    static thread_local LRUCache<MklPrimitive> lru_cache_(kCapacity);
+    static thread_local LRUCache<MklPrimitive> lru_cache_(GetCacheCapacity());
     return lru_cache_;
   }
 };
@@ -78,8 +78,22 @@ void StatSummarizer::Validate(const std::vector<TensorDescription>* outputs,
   }
 }
 
+std::string StatSummarizer::GetQueueingSummary() const {
+  std::stringstream stream;
+  stream << "Node wait time per run (us), summed over nodes:" << std::endl;
+  stream << "  in executor, ready to dispatched:   ";
+  run_ready_wait_us_.OutputToStream(&stream);
+  stream << std::endl << "  for inter-op thread, dispatched to started: ";
+  run_threadpool_wait_us_.OutputToStream(&stream);
+  stream << std::endl << "  in device queue, queued to submitted: ";
+  run_device_queue_us_.OutputToStream(&stream);
+  stream << std::endl;
+  return stream.str();
+}
+
 void StatSummarizer::PrintStepStats() const {
   string output = GetOutputString();
+  if (!run_ready_wait_us_.empty()) output += GetQueueingSummary();
   std::istringstream iss(output);
   for (std::string line; std::getline(iss, line);) {
     LOG(INFO) << line;
@@ -134,9 +148,27 @@ void StatSummarizer::ProcessStepStats(const StepStats& step_stats) {
   int64 first_node_start_us =
       step_stats.dev_stats(0).node_stats(0).all_start_micros();
 
+  int64 ready_wait_ns = 0;
+  int64 threadpool_wait_ns = 0;
+  int64 device_queue_ns = 0;
+
   int node_num = 0;
   for (const auto& ds : step_stats.dev_stats()) {
     for (const auto& ns : ds.node_stats()) {
+      // The executor fills in ready and scheduled times, device tracers the
+      // scheduled and submit times of the kernels they queue.
+      if (ns.ready_nanos() > 0 && ns.scheduled_nanos() >= ns.ready_nanos()) {
+        ready_wait_ns += ns.scheduled_nanos() - ns.ready_nanos();
+      }
+      if (ns.ready_nanos() > 0 &&
+          ns.all_start_nanos() >= ns.scheduled_nanos()) {
+        threadpool_wait_ns += ns.all_start_nanos() - ns.scheduled_nanos();
+      }
+      if (ns.device_submit_nanos() > 0 && ns.scheduled_nanos() > 0 &&
+          ns.device_submit_nanos() >= ns.scheduled_nanos()) {
+        device_queue_ns += ns.device_submit_nanos() - ns.scheduled_nanos();
+      }
+
       // NOTE(blackhc): To better support GPUs:
       // GPU kernels are duplicated both in /stream:all and their
       // /stream:$index. GPU memcpys are duplicated both in /memcpy and their
@@ -221,6 +253,9 @@ void StatSummarizer::ProcessStepStats(const StepStats& step_stats) {
 
   stats_calculator_->UpdateRunTotalUs(curr_total_us);
   stats_calculator_->UpdateMemoryUsed(mem_total);
+  run_ready_wait_us_.UpdateStat(ready_wait_ns / 1000);
+  run_threadpool_wait_us_.UpdateStat(threadpool_wait_ns / 1000);
+  run_device_queue_us_.UpdateStat(device_queue_ns / 1000);
 }
 
 
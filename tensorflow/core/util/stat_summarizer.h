@@ -102,6 +102,22 @@ class StatSummarizer {
     return stats_calculator_->run_total_us();
   }
 
+  // Returns stats of the microseconds nodes waited in each run, summed over
+  // the nodes: in the executor once ready, for an inter-op thread once
+  // dispatched, and in a device queue (e.g. a VE kernel stack) before being
+  // submitted to the device. Only nodes whose NodeExecStats carry the
+  // corresponding timestamps are counted.
+  const Stat<int64_t>& run_ready_wait_us() const { return run_ready_wait_us_; }
+  const Stat<int64_t>& run_threadpool_wait_us() const {
+    return run_threadpool_wait_us_;
+  }
+  const Stat<int64_t>& run_device_queue_us() const {
+    return run_device_queue_us_;
+  }
+
+  // Returns a human readable summary of the waits above.
+  std::string GetQueueingSummary() const;
+
  private:
   void Validate(const std::vector<TensorDescription>* outputs,
                 const NodeExecStats& ns) const;
@@ -109,6 +125,10 @@ class StatSummarizer {
   std::map<std::string, std::vector<TensorDescription> > outputs_;
 
   std::unique_ptr<StatsCalculator> stats_calculator_;
+
+  Stat<int64_t> run_ready_wait_us_;
+  Stat<int64_t> run_threadpool_wait_us_;
+  Stat<int64_t> run_device_queue_us_;
 };
 
 }  // namespace tensorflow
@@ -83,5 +83,49 @@ versions {
   ASSERT_TRUE(by_node_type.find("Const") != std::string::npos) << by_node_type;
 }
 
+TEST(StatSummarizerTest, SumsQueueingTimes) {
+  StepStats step_stats;
+  const std::string step_stats_str(R"EOF(
+dev_stats {
+  device: "/job:localhost/replica:0/task:0/device:CPU:0"
+  node_stats {
+    node_name: "a"
+    all_start_micros: 10
+    all_start_nanos: 10000
+    ready_nanos: 2000
+    scheduled_nanos: 5000
+  }
+  node_stats {
+    node_name: "b"
+    all_start_micros: 30
+    all_start_nanos: 30000
+    ready_nanos: 20000
+    scheduled_nanos: 21000
+  }
+}
+dev_stats {
+  device: "/device:VE:0/stream:0"
+  node_stats {
+    node_name: "k:k"
+    all_start_micros: 50
+    all_start_nanos: 50000
+    scheduled_nanos: 31000
+    device_submit_nanos: 45000
+  }
+}
+  )EOF");
+  ASSERT_TRUE(
+      protobuf::TextFormat::ParseFromString(step_stats_str, &step_stats));
+
+  StatSummarizer stats((StatSummarizerOptions()));
+  stats.ProcessStepStats(step_stats);
+
+  EXPECT_EQ(4, stats.run_ready_wait_us().newest());
+  EXPECT_EQ(14, stats.run_threadpool_wait_us().newest());
+  EXPECT_EQ(14, stats.run_device_queue_us().newest());
+  EXPECT_NE(std::string::npos,
+            stats.GetQueueingSummary().find("inter-op thread"));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -21,6 +21,8 @@ limitations under the License.
 #include <memory>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -40,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/byte_swap.h"
 #include "tensorflow/core/util/tensor_slice_util.h"
@@ -394,6 +397,47 @@ Status PadAlignment(FileOutputBuffer* out, int alignment, int64* size) {
   return status;
 }
 
+// A read-only tensor buffer that aliases a memory-mapped data file and keeps
+// the mapping alive.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("mmap");
+  }
+
+  // Prevents kernels from forwarding the buffer to an output and writing to
+  // the mapped memory.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
+// Returns true if "filename" is on a file system whose read-only memory
+// regions are real mappings rather than copies of the whole file.
+bool IsLocalFile(const string& filename) {
+  StringPiece scheme, host, path;
+  io::ParseURI(filename, &scheme, &host, &path);
+  return scheme.empty() || scheme == "file";
+}
+
+Status ChecksumMismatchError(uint32 stored_crc32c, uint32 actual_crc32c) {
+  return errors::DataLoss("Checksum does not match: stored ",
+                          strings::Printf("%08u", stored_crc32c),
+                          " vs. calculated on the restored bytes ",
+                          actual_crc32c);
+}
+
 }  // namespace
 
 BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
@@ -418,6 +462,40 @@ BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
       new FileOutputBuffer(wrapper.release(), 8 << 20 /* 8MB write buffer */));
 
   VLOG(1) << "Writing to file " << tmp_data_path_;
+
+  if (options_.chunk_size > 0 && !options_.base_prefix.empty()) {
+    status_ = LoadBaseChunks();
+  }
+}
+
+Status BundleWriter::LoadBaseChunks() {
+  BundleReader base(env_, options_.base_prefix);
+  TF_RETURN_IF_ERROR(base.status());
+  base.Seek(kHeaderEntryKey);
+  BundleHeaderProto header;
+  TF_RETURN_IF_ERROR(ParseEntryProto(base.key(), base.value(), &header));
+  if (header.endianness() != (port::kLittleEndian ? BundleHeaderProto::LITTLE
+                                                  : BundleHeaderProto::BIG)) {
+    return errors::InvalidArgument(
+        "Base bundle ", options_.base_prefix,
+        " is of a different endianness than this machine's hardware");
+  }
+  BundleEntryProto entry;
+  for (base.Next(); base.Valid(); base.Next()) {
+    TF_RETURN_IF_ERROR(ParseEntryProto(base.key(), base.value(), &entry));
+    for (BundleChunkProto chunk : entry.chunks()) {
+      if (chunk.prefix().empty()) {
+        chunk.set_prefix(options_.base_prefix);
+        chunk.set_num_shards(header.num_shards());
+      }
+      chunks_.emplace(
+          std::make_pair(chunk.fingerprint_low(), chunk.fingerprint_high()),
+          std::move(chunk));
+    }
+  }
+  VLOG(1) << "Loaded " << chunks_.size() << " chunks of base bundle "
+          << options_.base_prefix;
+  return Status::OK();
 }
 
 Status BundleWriter::Add(StringPiece key, const Tensor& val) {
@@ -435,6 +513,12 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
   entry->set_shard_id(0);
   entry->set_offset(size_);
 
+  if (options_.chunk_size > 0 && DataTypeCanUseMemcpy(val.dtype()) &&
+      val.TotalBytes() > 0) {
+    status_ = AddChunks(val, entry);
+    return status_;
+  }
+
   // Updates the data file.
   size_t data_bytes_written = 0;
   uint32 crc32c = 0;
@@ -457,6 +541,37 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
   return status_;
 }
 
+Status BundleWriter::AddChunks(const Tensor& val, BundleEntryProto* entry) {
+  const StringPiece data = val.tensor_data();
+  entry->set_size(data.size());
+  entry->set_crc32c(crc32c::Mask(crc32c::Value(data.data(), data.size())));
+  const size_t chunk_size = options_.chunk_size;
+  int64 reused_bytes = 0;
+  for (size_t start = 0; start < data.size(); start += chunk_size) {
+    const StringPiece bytes = data.substr(start, chunk_size);
+    const Fprint128 fingerprint = Fingerprint128(bytes);
+    const auto key = std::make_pair(fingerprint.low64, fingerprint.high64);
+    BundleChunkProto* chunk = entry->add_chunks();
+    const auto it = chunks_.find(key);
+    if (it != chunks_.end() && it->second.size() == bytes.size()) {
+      *chunk = it->second;
+      reused_bytes += bytes.size();
+      continue;
+    }
+    chunk->set_shard_id(0);
+    chunk->set_offset(size_);
+    chunk->set_size(bytes.size());
+    chunk->set_fingerprint_low(fingerprint.low64);
+    chunk->set_fingerprint_high(fingerprint.high64);
+    TF_RETURN_IF_ERROR(out_->Append(bytes));
+    size_ += bytes.size();
+    chunks_[key] = *chunk;
+  }
+  VLOG(2) << "Reused " << reused_bytes << " of " << data.size()
+          << " bytes in chunks";
+  return PadAlignment(out_.get(), options_.data_alignment, &size_);
+}
+
 Status BundleWriter::AddSlice(StringPiece full_tensor_key,
                               const TensorShape& full_tensor_shape,
                               const TensorSlice& slice_spec,
@@ -668,6 +783,14 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
         {DataFilename(prefix, to_merge_entry.shard_id(), num_shards),
          merge_state->shard_ids.size()});
     to_merge_entry.set_shard_id(result.first->second);
+    // So do the chunks stored by this bundle.
+    for (BundleChunkProto& chunk : *to_merge_entry.mutable_chunks()) {
+      if (!chunk.prefix().empty()) continue;
+      auto chunk_result = merge_state->shard_ids.insert(
+          {DataFilename(prefix, chunk.shard_id(), num_shards),
+           merge_state->shard_ids.size()});
+      chunk.set_shard_id(chunk_result.first->second);
+    }
     merge_state->entries[key] = to_merge_entry;
   }
   return Status::OK();
@@ -724,8 +847,10 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
 
 // Interface for reading a tensor bundle.
 
-BundleReader::BundleReader(Env* env, StringPiece prefix)
+BundleReader::BundleReader(Env* env, StringPiece prefix,
+                           const Options& options)
     : env_(env),
+      options_(options),
       prefix_(prefix),
       metadata_(nullptr),
       table_(nullptr),
@@ -741,7 +866,9 @@ BundleReader::BundleReader(Env* env, StringPiece prefix)
   status_ = env_->NewRandomAccessFile(filename, &wrapper);
   if (!status_.ok()) return;
   metadata_ = wrapper.release();
-  status_ = table::Table::Open(table::Options(), metadata_, file_size, &table_);
+  table::Options table_options;
+  table_options.block_cache = options_.metadata_block_cache;
+  status_ = table::Table::Open(table_options, metadata_, file_size, &table_);
   if (!status_.ok()) return;
   iter_ = table_->NewIterator();
 
@@ -810,9 +937,53 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
 }
 
 Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
+  if (entry.chunks_size() > 0) return GetChunkedValue(entry, val);
   Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
+
+  // Locates the bytes in the mapped data file, if any.
+  std::shared_ptr<ReadOnlyMemoryRegion> region;
+  const char* mapped_data = nullptr;
+  if (options_.use_mmap && DataTypeCanUseMemcpy(entry.dtype()) &&
+      entry.size() > 0) {
+    region = GetMappedShard(entry.shard_id());
+    if (region != nullptr) {
+      if (entry.offset() + entry.size() > region->length()) {
+        return errors::DataLoss("Bundle entry of key ", key(),
+                                " exceeds its data file: offset ",
+                                entry.offset(), "; size ", entry.size(),
+                                "; file size ", region->length());
+      }
+      mapped_data = static_cast<const char*>(region->data()) + entry.offset();
+    }
+  }
+
   if (val->NumElements() == 0) {
+    if (mapped_data != nullptr && !need_to_swap_bytes_ &&
+        reinterpret_cast<uintptr_t>(mapped_data) %
+                Allocator::kAllocatorAlignment ==
+            0) {
+      // Aliases the mapped bytes instead of allocating and copying.
+      const int64 expected_size =
+          stored_shape.num_elements() * DataTypeSize(entry.dtype());
+      if (entry.size() != expected_size) {
+        return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                                "; stored size ", entry.size(),
+                                "; expected size ", expected_size);
+      }
+      if (options_.verify_mmap_checksums) {
+        const uint32 actual_crc32c = crc32c::Value(mapped_data, entry.size());
+        if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+          return ChecksumMismatchError(crc32c::Unmask(entry.crc32c()),
+                                       actual_crc32c);
+        }
+      }
+      MappedTensorBuffer* buf =
+          new MappedTensorBuffer(std::move(region), mapped_data, entry.size());
+      *val = Tensor(entry.dtype(), stored_shape, buf);
+      buf->Unref();
+      return Status::OK();
+    }
     ret = new Tensor(entry.dtype(), stored_shape);
   }
 
@@ -839,24 +1010,30 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   }
 
   // Open the data file if it has not been opened.
-  io::InputBuffer* buffered_file = data_[entry.shard_id()];
-  if (buffered_file == nullptr) {
-    std::unique_ptr<RandomAccessFile> file = nullptr;
-    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
-        DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
-    buffered_file = new io::InputBuffer(file.release(), kBufferSize);
-    // The InputBuffer and RandomAccessFile objects are both released in dtor.
-    data_[entry.shard_id()] = buffered_file;
-  }
-  CHECK(buffered_file != nullptr);
+  io::InputBuffer* buffered_file = nullptr;
+  if (mapped_data == nullptr) {
+    buffered_file = data_[entry.shard_id()];
+    if (buffered_file == nullptr) {
+      std::unique_ptr<RandomAccessFile> file = nullptr;
+      TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
+          DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
+      buffered_file = new io::InputBuffer(file.release(), kBufferSize);
+      // The InputBuffer and RandomAccessFile objects are both released in
+      // dtor.
+      data_[entry.shard_id()] = buffered_file;
+    }
+    CHECK(buffered_file != nullptr);
 
-  TF_RETURN_IF_ERROR(buffered_file->Seek(entry.offset()));
+    TF_RETURN_IF_ERROR(buffered_file->Seek(entry.offset()));
+  }
   uint32 actual_crc32c = 0;
 
   if (DataTypeCanUseMemcpy(entry.dtype())) {
     char* backing_buffer = const_cast<char*>((ret->tensor_data().data()));
     size_t unused_bytes_read;
-    if (entry.size() > kBufferSize) {
+    if (mapped_data != nullptr) {
+      memcpy(backing_buffer, mapped_data, entry.size());
+    } else if (entry.size() > kBufferSize) {
       StringPiece sp;
       TF_RETURN_IF_ERROR(buffered_file->file()->Read(
           entry.offset(), entry.size(), &sp, backing_buffer));
@@ -893,10 +1070,8 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
         GetStringBackingBuffer(*ret), &actual_crc32c, need_to_swap_bytes_));
   }
   if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
-    return errors::DataLoss(
-        "Checksum does not match: stored ",
-        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
-        " vs. calculated on the restored bytes ", actual_crc32c);
+    return ChecksumMismatchError(crc32c::Unmask(entry.crc32c()),
+                                 actual_crc32c);
   }
 
   *val = *ret;
@@ -904,6 +1079,151 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   return Status::OK();
 }
 
+Status BundleReader::ReadTensorBytes(const BundleEntryProto& entry,
+                                     uint64 offset, size_t size, char* buf) {
+  if (!DataTypeCanUseMemcpy(entry.dtype()) || entry.slices_size() > 0) {
+    return errors::InvalidArgument(
+        "Can only read the bytes of full tensors of memcpy-able types; got "
+        "dtype ",
+        DataTypeString(entry.dtype()), " with ", entry.slices_size(),
+        " slices");
+  }
+  if (need_to_swap_bytes_) {
+    return errors::Unimplemented(
+        "TensorBundle at ", prefix_,
+        " is of a different endianness than this machine's hardware, and "
+        "its bytes cannot be read without byte-swapping.");
+  }
+  if (offset > entry.size() || size > entry.size() - offset) {
+    return errors::OutOfRange("Cannot read ", size, " bytes at offset ",
+                              offset, " of a tensor of ", entry.size(),
+                              " bytes");
+  }
+  if (size == 0) return Status::OK();
+  if (entry.chunks_size() > 0) {
+    return ReadChunkedBytes(entry, offset, size, buf);
+  }
+
+  if (options_.use_mmap) {
+    std::shared_ptr<ReadOnlyMemoryRegion> region =
+        GetMappedShard(entry.shard_id());
+    if (region != nullptr) {
+      if (entry.offset() + entry.size() > region->length()) {
+        return errors::DataLoss("Bundle entry exceeds its data file: offset ",
+                                entry.offset(), "; size ", entry.size(),
+                                "; file size ", region->length());
+      }
+      memcpy(buf,
+             static_cast<const char*>(region->data()) + entry.offset() + offset,
+             size);
+      return Status::OK();
+    }
+  }
+
+  io::InputBuffer* buffered_file = data_[entry.shard_id()];
+  if (buffered_file == nullptr) {
+    std::unique_ptr<RandomAccessFile> file = nullptr;
+    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
+        DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
+    buffered_file = new io::InputBuffer(file.release(), kBufferSize);
+    data_[entry.shard_id()] = buffered_file;
+  }
+  StringPiece sp;
+  TF_RETURN_IF_ERROR(
+      buffered_file->file()->Read(entry.offset() + offset, size, &sp, buf));
+  if (sp.data() != buf) {
+    memmove(buf, sp.data(), size);
+  }
+  return Status::OK();
+}
+
+Status BundleReader::GetChunkedValue(const BundleEntryProto& entry,
+                                     Tensor* val) {
+  if (!DataTypeCanUseMemcpy(entry.dtype())) {
+    return errors::DataLoss("Bundle entry of key ", key(), " and dtype ",
+                            DataTypeString(entry.dtype()),
+                            " cannot be stored in chunks");
+  }
+  Tensor ret = *val;
+  if (val->NumElements() == 0) {
+    ret = Tensor(entry.dtype(), TensorShape(entry.shape()));
+  }
+  if (entry.size() != ret.TotalBytes()) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(),
+                            "; expected size ", ret.TotalBytes());
+  }
+  char* backing_buffer = const_cast<char*>(ret.tensor_data().data());
+  TF_RETURN_IF_ERROR(
+      ReadChunkedBytes(entry, 0, entry.size(), backing_buffer));
+  // As in GetValue(), the checksum is on the bytes in file order.
+  const uint32 actual_crc32c = crc32c::Value(backing_buffer, entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return ChecksumMismatchError(crc32c::Unmask(entry.crc32c()),
+                                 actual_crc32c);
+  }
+  if (need_to_swap_bytes_) {
+    TF_RETURN_IF_ERROR(ByteSwapTensor(&ret));
+  }
+  *val = ret;
+  return Status::OK();
+}
+
+Status BundleReader::ReadChunkedBytes(const BundleEntryProto& entry,
+                                      uint64 offset, size_t size, char* buf) {
+  uint64 chunk_start = 0;
+  for (const BundleChunkProto& chunk : entry.chunks()) {
+    if (size == 0) break;
+    const uint64 chunk_end = chunk_start + chunk.size();
+    if (offset < chunk_end) {
+      const string filename =
+          chunk.prefix().empty()
+              ? DataFilename(prefix_, chunk.shard_id(), num_shards_)
+              : DataFilename(chunk.prefix(), chunk.shard_id(),
+                             chunk.num_shards());
+      std::unique_ptr<RandomAccessFile>& file = chunk_files_[filename];
+      if (file == nullptr) {
+        TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(filename, &file));
+      }
+      const size_t n = std::min<uint64>(size, chunk_end - offset);
+      StringPiece sp;
+      TF_RETURN_IF_ERROR(
+          file->Read(chunk.offset() + (offset - chunk_start), n, &sp, buf));
+      if (sp.data() != buf) {
+        memmove(buf, sp.data(), n);
+      }
+      offset += n;
+      size -= n;
+      buf += n;
+    }
+    chunk_start = chunk_end;
+  }
+  if (size > 0) {
+    return errors::DataLoss("Chunks of bundle entry hold ", chunk_start,
+                            " bytes; stored size ", entry.size());
+  }
+  return Status::OK();
+}
+
+std::shared_ptr<ReadOnlyMemoryRegion> BundleReader::GetMappedShard(
+    int32 shard_id) {
+  auto it = mapped_data_.find(shard_id);
+  if (it == mapped_data_.end()) {
+    const string filename = DataFilename(prefix_, shard_id, num_shards_);
+    std::unique_ptr<ReadOnlyMemoryRegion> mapped;
+    if (IsLocalFile(filename)) {
+      Status s = env_->NewReadOnlyMemoryRegionFromFile(filename, &mapped);
+      if (!s.ok()) {
+        // E.g. an empty file, which cannot be mapped.  Fall back to reads.
+        VLOG(1) << "Not mapping " << filename << ": " << s;
+        mapped.reset();
+      }
+    }
+    it = mapped_data_.emplace(shard_id, std::move(mapped)).first;
+  }
+  return it->second;
+}
+
 Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
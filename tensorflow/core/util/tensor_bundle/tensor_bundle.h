@@ -64,14 +64,17 @@ limitations under the License.
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/io/cache.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
 #include "tensorflow/core/lib/io/table.h"
 #include "tensorflow/core/platform/env.h"
@@ -112,6 +115,15 @@ class BundleWriter {
     // Alignment, in bytes, for tensor data.
     // Must be >= 1. The default size of 1 densely packs tensors.
     int data_alignment{1};
+    // If positive, the values of memcpy-able types are split into chunks of
+    // this many bytes, identified by their fingerprints, and each distinct
+    // chunk is written once (see BundleEntryProto.chunks).
+    int64 chunk_size{0};
+    // If non-empty, the prefix of an earlier bundle written with chunks, e.g.
+    // the previous checkpoint.  Chunks it already stores are referenced
+    // instead of written again, so that an incremental checkpoint only writes
+    // what changed.  That bundle must then be kept as long as this one.
+    string base_prefix;
   };
   BundleWriter(Env* env, StringPiece prefix,
                const Options& options = Options());
@@ -146,6 +158,11 @@ class BundleWriter {
   Status status() const { return status_; }
 
  private:
+  // Writes the bytes of "val" in chunks, referencing the known chunks.
+  Status AddChunks(const Tensor& val, BundleEntryProto* entry);
+  // Registers the chunks of the bundle at "base_prefix" as known.
+  Status LoadBaseChunks();
+
   Env* const env_;  // Not owned.
   const Options options_;
   const string prefix_;
@@ -154,6 +171,9 @@ class BundleWriter {
   std::unique_ptr<FileOutputBuffer> out_;
   int64 size_;  // Number of bytes written into out_.
   std::map<string, BundleEntryProto> entries_;
+  // Fingerprint -> the known chunk with these bytes.  Only used with
+  // Options::chunk_size.
+  std::map<std::pair<uint64, uint64>, BundleChunkProto> chunks_;
   Status status_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(BundleWriter);
@@ -181,7 +201,28 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
 // All threads accessing the same BundleReader must synchronize.
 class BundleReader {
  public:
-  BundleReader(Env* const env, StringPiece prefix);
+  struct Options {
+    Options() {}
+    // If true, the data files on local file systems are memory-mapped, and
+    // Lookup() into a tensor without elements returns a tensor that aliases
+    // the mapped file for entries of memcpy-able types whose data is aligned
+    // to Allocator::kAllocatorAlignment (see
+    // BundleWriter::Options::data_alignment).  Such tensors are read-only,
+    // keep the mapping alive, and share its pages with other processes
+    // mapping the same file.  Other entries are copied out of the mapping, or
+    // read as usual if the file cannot be mapped.
+    bool use_mmap{false};
+    // If false, the checksums of tensors aliasing a mapped file are not
+    // verified, so that their pages are only read in when first accessed.
+    bool verify_mmap_checksums{true};
+    // If non-null, caches the blocks of the metadata table, so that lookups
+    // jumping between keys, e.g. of the slices of partitioned tensors, do not
+    // read and parse the same blocks again.  May be shared by readers; not
+    // owned.
+    table::Cache* metadata_block_cache{nullptr};
+  };
+  BundleReader(Env* const env, StringPiece prefix,
+               const Options& options = Options());
   ~BundleReader();
 
   // Is ok() iff the reader construction is successful (completed the read of
@@ -211,6 +252,10 @@ class BundleReader {
   // corresponding contents, so that its buffer can be filled without needing
   // extra allocation.  These can be queried via "LookupDtypeAndShape()".
   //
+  // If "val" has no elements, e.g. is default-constructed, it is set to a new
+  // tensor of the stored dtype and shape instead, which may alias a mapped
+  // data file (see Options::use_mmap).  Partitioned tensors are always copied.
+  //
   // On error, "val" may contain nonsense data.  Returns a NotFound error if
   // tensor keyed by "key" does not exist in this bundle.
   //
@@ -260,15 +305,27 @@ class BundleReader {
   // REQUIRES: status().ok() && Valid()
   StringPiece value() const { return iter_->value(); }
 
-  string DebugString();
-
- private:
-  // Seeks for "key" and reads the metadata proto.
+  // Seeks for "key" and reads the metadata proto, e.g. to find the data file
+  // and offset of the tensor.  Calls Seek() internally, so this call
+  // invalidates the reader's current position.
   // On non-OK return, clears "entry" for the caller.
   // REQUIRES: status().ok()
   Status GetBundleEntryProto(StringPiece key,
                              BundleEntryProto* entry) TF_MUST_USE_RESULT;
 
+  // Reads the "size" bytes at "offset" of the stored value of "entry", a full
+  // tensor of a dtype that can be memcpy'ed, into "buf".  This lets callers
+  // stream a large tensor in chunks, e.g. into device memory.  The checksum
+  // is not verified: callers accumulate the crc32c of the chunks and compare
+  // it to entry.crc32c().  Returns Unimplemented if the bundle is of a
+  // different endianness than this machine.
+  // REQUIRES: status().ok()
+  Status ReadTensorBytes(const BundleEntryProto& entry, uint64 offset,
+                         size_t size, char* buf) TF_MUST_USE_RESULT;
+
+  string DebugString();
+
+ private:
   // Reads the tensor value described by the metadata proto "entry".
   // Usage for "val" follows the comment of "Lookup()".
   Status GetValue(const BundleEntryProto& entry,
@@ -282,7 +339,22 @@ class BundleReader {
                        const TensorSlice& slice_spec,
                        Tensor* val) TF_MUST_USE_RESULT;
 
+  // Reads the tensor value of "entry", stored in chunks.  Usage for "val"
+  // follows the comment of "Lookup()", except that it is never aliased.
+  // REQUIRES: entry.chunks_size() > 0
+  Status GetChunkedValue(const BundleEntryProto& entry,
+                         Tensor* val) TF_MUST_USE_RESULT;
+
+  // Like ReadTensorBytes(), for an entry stored in chunks.
+  Status ReadChunkedBytes(const BundleEntryProto& entry, uint64 offset,
+                          size_t size, char* buf) TF_MUST_USE_RESULT;
+
+  // Maps the data file of "shard_id" if it has not been mapped yet.  Returns
+  // null if the file is not on a local file system or cannot be mapped.
+  std::shared_ptr<ReadOnlyMemoryRegion> GetMappedShard(int32 shard_id);
+
   Env* env_;  // Not owned.
+  const Options options_;
   const string prefix_;
 
   Status status_;
@@ -291,6 +363,13 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // The mapped data files, shared with the tensors aliasing them.  Null for
+  // files that could not be mapped.  Only used with Options::use_mmap.
+  std::unordered_map<int32, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
+  // Data file name -> the opened file, for the chunks of chunked entries,
+  // which may lie in other bundles.
+  std::unordered_map<string, std::unique_ptr<RandomAccessFile>> chunk_files_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
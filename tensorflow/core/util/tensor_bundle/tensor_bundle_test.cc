@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/strings/str_util.h"
@@ -993,6 +994,164 @@ TEST(TensorBundleTest, TruncatedTensorContents) {
   EXPECT_TRUE(errors::IsOutOfRange(reader.Lookup("key", &val)));
 }
 
+TEST(TensorBundleTest, MemoryMapped) {
+  Env* env = Env::Default();
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = Allocator::kAllocatorAlignment;
+    BundleWriter writer(env, Prefix("mmap"), opts);
+    TF_EXPECT_OK(writer.Add("floats", Constant_2x3<float>(1.5)));
+    TF_EXPECT_OK(writer.Add("ints", Constant<int32>(7, TensorShape({5}))));
+    TF_EXPECT_OK(
+        writer.Add("strings", test::AsTensor<tstring>({"hello", "world"})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options opts;
+  opts.use_mmap = true;
+  Tensor aliased;
+  {
+    BundleReader reader(env, Prefix("mmap"), opts);
+    TF_ASSERT_OK(reader.status());
+    // Aligned entries alias the mapped file, which outlives the reader.
+    TF_ASSERT_OK(reader.Lookup("floats", &aliased));
+    EXPECT_FALSE(aliased.RefCountIsOne());
+    // Tensors with elements are still filled in.
+    Tensor copied(DT_INT32, TensorShape({5}));
+    TF_ASSERT_OK(reader.Lookup("ints", &copied));
+    EXPECT_TRUE(copied.RefCountIsOne());
+    test::ExpectTensorEqual<int32>(copied,
+                                   Constant<int32>(7, TensorShape({5})));
+    Expect<tstring>(&reader, "strings",
+                    test::AsTensor<tstring>({"hello", "world"}));
+  }
+  test::ExpectTensorEqual<float>(aliased, Constant_2x3<float>(1.5));
+
+  // Corrupts the floats, which are the first entry of the data file.
+  const string datafile = DataFilename(Prefix("mmap"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(env, datafile, &data));
+  data[0] = ~data[0];
+  TF_ASSERT_OK(WriteStringToFile(env, datafile, data));
+  {
+    BundleReader reader(env, Prefix("mmap"), opts);
+    TF_ASSERT_OK(reader.status());
+    Tensor val;
+    Status status = reader.Lookup("floats", &val);
+    EXPECT_TRUE(errors::IsDataLoss(status));
+    EXPECT_TRUE(
+        absl::StrContains(status.ToString(), "Checksum does not match"));
+  }
+  {
+    opts.verify_mmap_checksums = false;
+    BundleReader reader(env, Prefix("mmap"), opts);
+    TF_ASSERT_OK(reader.status());
+    Tensor val;
+    TF_EXPECT_OK(reader.Lookup("floats", &val));
+  }
+}
+
+TEST(TensorBundleTest, ReadTensorBytes) {
+  Env* env = Env::Default();
+  Tensor expected(DT_FLOAT, TensorShape({1000}));
+  for (int i = 0; i < 1000; ++i) {
+    expected.flat<float>()(i) = i;
+  }
+  {
+    BundleWriter writer(env, Prefix("bytes"));
+    TF_EXPECT_OK(writer.Add("floats", expected));
+    TF_EXPECT_OK(
+        writer.Add("strings", test::AsTensor<tstring>({"hello", "world"})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  for (bool use_mmap : {false, true}) {
+    BundleReader::Options opts;
+    opts.use_mmap = use_mmap;
+    BundleReader reader(env, Prefix("bytes"), opts);
+    TF_ASSERT_OK(reader.status());
+    BundleEntryProto entry;
+    TF_ASSERT_OK(reader.GetBundleEntryProto("floats", &entry));
+
+    // Reads the tensor in uneven chunks, accumulating the checksum.
+    Tensor val(DT_FLOAT, TensorShape({1000}));
+    char* buf = const_cast<char*>(val.tensor_data().data());
+    const size_t kChunkSize = 999;
+    uint32 crc = 0;
+    for (size_t offset = 0; offset < entry.size(); offset += kChunkSize) {
+      const size_t size = std::min<size_t>(kChunkSize, entry.size() - offset);
+      TF_ASSERT_OK(reader.ReadTensorBytes(entry, offset, size, buf + offset));
+      crc = crc32c::Extend(crc, buf + offset, size);
+    }
+    EXPECT_EQ(crc32c::Unmask(entry.crc32c()), crc);
+    test::ExpectTensorEqual<float>(val, expected);
+
+    EXPECT_TRUE(errors::IsOutOfRange(
+        reader.ReadTensorBytes(entry, entry.size() - 1, 2, buf)));
+    TF_ASSERT_OK(reader.GetBundleEntryProto("strings", &entry));
+    EXPECT_TRUE(
+        errors::IsInvalidArgument(reader.ReadTensorBytes(entry, 0, 1, buf)));
+  }
+}
+
+TEST(TensorBundleTest, IncrementalChunks) {
+  Env* env = Env::Default();
+  Tensor floats(DT_FLOAT, TensorShape({1000}));
+  for (int i = 0; i < 1000; ++i) {
+    floats.flat<float>()(i) = i;
+  }
+  const Tensor ints = test::AsTensor<int32>({1, 2, 3});
+  BundleWriter::Options opts;
+  opts.chunk_size = 400;  // 100 floats.
+  {
+    BundleWriter writer(env, Prefix("chunks_base"), opts);
+    TF_EXPECT_OK(writer.Add("floats", floats));
+    TF_EXPECT_OK(writer.Add("ints", ints));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  // Changes one chunk, and writes the next checkpoint as a merged bundle.
+  floats.flat<float>()(150) = -1;
+  opts.base_prefix = Prefix("chunks_base");
+  {
+    BundleWriter writer(env, Prefix("chunks_incr_tmp"), opts);
+    TF_EXPECT_OK(writer.Add("floats", floats));
+    TF_EXPECT_OK(writer.Add("ints", ints));
+    TF_EXPECT_OK(writer.Add("more_ints", ints));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  TF_ASSERT_OK(MergeBundles(env, {Prefix("chunks_incr_tmp")},
+                            Prefix("chunks_incr")));
+  uint64 data_size;
+  TF_ASSERT_OK(env->GetFileSize(DataFilename(Prefix("chunks_incr"), 0, 1),
+                                &data_size));
+  EXPECT_EQ(400, data_size);
+
+  BundleReader reader(env, Prefix("chunks_incr"));
+  TF_ASSERT_OK(reader.status());
+  BundleEntryProto entry;
+  TF_ASSERT_OK(reader.GetBundleEntryProto("floats", &entry));
+  ASSERT_EQ(10, entry.chunks_size());
+  EXPECT_EQ(Prefix("chunks_base"), entry.chunks(0).prefix());
+  EXPECT_EQ("", entry.chunks(1).prefix());
+  TF_ASSERT_OK(reader.GetBundleEntryProto("more_ints", &entry));
+  ASSERT_EQ(1, entry.chunks_size());
+  EXPECT_EQ(Prefix("chunks_base"), entry.chunks(0).prefix());
+
+  Expect<float>(&reader, "floats", floats);
+  Expect<int32>(&reader, "ints", ints);
+  Expect<int32>(&reader, "more_ints", ints);
+
+  // Reads bytes across chunk boundaries.
+  TF_ASSERT_OK(reader.GetBundleEntryProto("floats", &entry));
+  Tensor val(DT_FLOAT, TensorShape({1000}));
+  char* buf = const_cast<char*>(val.tensor_data().data());
+  const size_t kReadSize = 999;
+  for (size_t offset = 0; offset < entry.size(); offset += kReadSize) {
+    const size_t size = std::min<size_t>(kReadSize, entry.size() - offset);
+    TF_ASSERT_OK(reader.ReadTensorBytes(entry, offset, size, buf + offset));
+  }
+  test::ExpectTensorEqual<float>(val, floats);
+}
+
 TEST(TensorBundleTest, HeaderEntry) {
   {
     BundleWriter writer(Env::Default(), Prefix("b"));
@@ -14,10 +14,32 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/arena_planner.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <utility>
+#include <vector>
+
+#include "tensorflow/lite/minimal_logging.h"
 
 namespace tflite {
+namespace {
+
+size_t AlignTo(size_t alignment, size_t offset) {
+  return offset % alignment == 0 ? offset
+                                 : offset + (alignment - offset % alignment);
+}
+
+// The steps (see GraphInfo::node_step()) during which a tensor must stay
+// allocated, both inclusive.
+struct TensorLifetime {
+  int tensor;
+  int first_step;
+  int last_step;
+  size_t size;
+};
+
+}  // namespace
 
 struct AllocationInfo {
   // The node index requesting this allocation.
@@ -31,14 +53,15 @@ struct AllocationInfo {
 ArenaPlanner::ArenaPlanner(TfLiteContext* context,
                            std::unique_ptr<GraphInfo> graph_info,
                            bool preserve_inputs, bool preserve_intermediates,
-                           int tensor_alignment)
+                           int tensor_alignment, bool greedy_by_size)
     : context_(context),
       graph_info_(std::move(graph_info)),
       arena_(kDefaultArenaAlignment),
       persistent_arena_(kDefaultArenaAlignment),
       preserve_inputs_(preserve_inputs),
       preserve_intermediates_(preserve_intermediates),
-      tensor_alignment_(tensor_alignment) {}
+      tensor_alignment_(tensor_alignment),
+      greedy_by_size_(greedy_by_size) {}
 
 ArenaPlanner::~ArenaPlanner() {}
 
@@ -66,8 +89,9 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
   // Invalidate any existing data.
   TF_LITE_ENSURE_STATUS(ResetAllocations());
   // The alloc_queue_ is specific to the graph topology, and will be
-  // completely reconstructed from graph data here.
+  // completely reconstructed from graph data here. So are cached plans.
   alloc_queue_.clear();
+  plan_cache_.clear();
 
   // Keeps track of references to each tensor.
   std::vector<int> refcounts(graph_info_->num_tensors(), 0);
@@ -192,7 +216,30 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
   TF_LITE_ENSURE(context_, graph_info_->num_tensors() >= allocs_.size());
   allocs_.resize(graph_info_->num_tensors());
 
-  TF_LITE_ENSURE_STATUS(CalculateAllocations(first_node, last_node));
+  // The greedy-by-size plan needs the sizes of all tensors, which are only
+  // known up front if the whole graph is prepared at once, i.e. if it has no
+  // dynamic tensors. It is the only plan that knows about concurrent nodes.
+  const int num_nodes = static_cast<int>(graph_info_->num_nodes());
+  const bool whole_graph = first_node == 0 && last_node >= num_nodes - 1;
+  std::vector<size_t> signature;
+  if (whole_graph) {
+    signature = PlanSignature();
+  }
+  const CachedPlan* cached_plan =
+      whole_graph ? FindCachedPlan(signature) : nullptr;
+  if (cached_plan != nullptr) {
+    TF_LITE_ENSURE_STATUS(RestorePlan(*cached_plan));
+    ++num_cached_plan_hits_;
+  } else {
+    if ((greedy_by_size_ || HasConcurrentNodes()) && whole_graph) {
+      TF_LITE_ENSURE_STATUS(CalculateAllocationsGreedyBySize());
+    } else {
+      TF_LITE_ENSURE_STATUS(CalculateAllocations(first_node, last_node));
+    }
+    if (whole_graph) {
+      CachePlan(std::move(signature));
+    }
+  }
   TF_LITE_ENSURE_STATUS(Commit());
 
   for (int i = 0; i < static_cast<int>(graph_info_->num_tensors()); ++i) {
@@ -281,6 +328,226 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
   return kTfLiteOk;
 }
 
+TfLiteStatus ArenaPlanner::CalculateAllocationsGreedyBySize() {
+  const int num_nodes = static_cast<int>(graph_info_->num_nodes());
+  const int num_tensors = static_cast<int>(graph_info_->num_tensors());
+  std::vector<int> steps(std::max(num_nodes, 1), 0);
+  int last_step = 0;
+  for (int i = 0; i < num_nodes; ++i) {
+    steps[i] = static_cast<int>(graph_info_->node_step(i));
+    last_step = std::max(last_step, steps[i]);
+  }
+
+  // Tensors that are never deallocated stay alive until the last step.
+  std::vector<int> first_use(num_tensors, -1);
+  std::vector<int> last_use(num_tensors, -1);
+  auto use = [&](int tensor, int first, int last) {
+    first_use[tensor] =
+        first_use[tensor] == -1 ? first : std::min(first_use[tensor], first);
+    last_use[tensor] = std::max(last_use[tensor], last);
+  };
+  for (const auto& alloc_info : alloc_queue_) {
+    if (alloc_info.type == AllocationInfo::ALLOC) {
+      use(alloc_info.tensor, steps[alloc_info.node], last_step);
+    }
+  }
+  for (const auto& alloc_info : alloc_queue_) {
+    if (alloc_info.type == AllocationInfo::DEALLOC) {
+      last_use[alloc_info.tensor] = steps[alloc_info.node];
+    }
+  }
+  for (int i = 0; i < num_nodes; ++i) {
+    const TfLiteNode& node = graph_info_->node(i);
+    // Nodes running concurrently may consume a tensor after the node that
+    // deallocates it in execution order.
+    for (const TfLiteIntArray* tensors : {node.inputs, node.outputs}) {
+      for (int j = 0; j < tensors->size; ++j) {
+        const int tensor_index = tensors->data[j];
+        if (tensor_index != kTfLiteOptionalTensor &&
+            first_use[tensor_index] != -1) {
+          use(tensor_index, steps[i], steps[i]);
+        }
+      }
+    }
+    const TfLiteIntArray* node_temporaries = node.temporaries;
+    for (int j = 0; j < node_temporaries->size; ++j) {
+      use(node_temporaries->data[j], steps[i], steps[i]);
+    }
+  }
+
+  std::vector<TensorLifetime> lifetimes;
+  for (int tensor_index = 0; tensor_index < num_tensors; ++tensor_index) {
+    if (first_use[tensor_index] == -1) continue;
+    const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+    if (tensor.allocation_type == kTfLiteArenaRw) {
+      if (tensor.bytes > 0) {
+        lifetimes.push_back({tensor_index, first_use[tensor_index],
+                             last_use[tensor_index], tensor.bytes});
+      }
+    } else {
+      TF_LITE_ENSURE_STATUS(CalculateTensorAllocation(tensor_index));
+    }
+  }
+
+  // The largest total size of the tensors alive during any step.
+  std::vector<size_t> live_bytes(last_step + 2, 0);
+  for (const TensorLifetime& lifetime : lifetimes) {
+    live_bytes[lifetime.first_step] += lifetime.size;
+    live_bytes[lifetime.last_step + 1] -= lifetime.size;
+  }
+  size_t running_bytes = 0;
+  arena_size_lower_bound_ = 0;
+  for (int i = 0; i <= last_step; ++i) {
+    running_bytes += live_bytes[i];
+    arena_size_lower_bound_ = std::max(arena_size_lower_bound_, running_bytes);
+  }
+
+  // Place the largest tensors first, breaking ties by execution order so that
+  // the plan is deterministic.
+  std::sort(lifetimes.begin(), lifetimes.end(),
+            [](const TensorLifetime& a, const TensorLifetime& b) {
+              if (a.size != b.size) return a.size > b.size;
+              if (a.first_step != b.first_step) {
+                return a.first_step < b.first_step;
+              }
+              return a.tensor < b.tensor;
+            });
+
+  // Tensors placed so far, ordered by offset.
+  std::vector<const TensorLifetime*> placed;
+  placed.reserve(lifetimes.size());
+  planned_arena_size_ = 0;
+  for (const TensorLifetime& lifetime : lifetimes) {
+    size_t best_offset = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t current_offset = 0;
+    for (const TensorLifetime* other : placed) {
+      if (other->last_step < lifetime.first_step ||
+          lifetime.last_step < other->first_step) {
+        continue;
+      }
+      const ArenaAlloc& other_alloc = allocs_[other->tensor];
+      const size_t aligned_offset = AlignTo(tensor_alignment_, current_offset);
+      if (aligned_offset + lifetime.size <= other_alloc.offset &&
+          other_alloc.offset - current_offset < best_gap) {
+        best_offset = aligned_offset;
+        best_gap = other_alloc.offset - current_offset;
+      }
+      current_offset =
+          std::max(current_offset, other_alloc.offset + other_alloc.size);
+    }
+    if (best_offset == std::numeric_limits<size_t>::max()) {
+      best_offset = AlignTo(tensor_alignment_, current_offset);
+    }
+
+    ArenaAlloc& alloc = allocs_[lifetime.tensor];
+    alloc.offset = best_offset;
+    alloc.size = lifetime.size;
+    planned_arena_size_ =
+        std::max(planned_arena_size_, best_offset + alloc.size);
+    placed.insert(std::upper_bound(placed.begin(), placed.end(), &lifetime,
+                                   [this](const TensorLifetime* a,
+                                          const TensorLifetime* b) {
+                                     return allocs_[a->tensor].offset <
+                                            allocs_[b->tensor].offset;
+                                   }),
+                  &lifetime);
+  }
+  arena_.Reserve(planned_arena_size_);
+
+  TFLITE_LOG_PROD(TFLITE_LOG_INFO,
+                  "Planned an arena of %zu bytes for tensors needing at least "
+                  "%zu bytes.",
+                  planned_arena_size_, arena_size_lower_bound_);
+  return kTfLiteOk;
+}
+
+std::vector<size_t> ArenaPlanner::PlanSignature() {
+  const size_t num_tensors = graph_info_->num_tensors();
+  const size_t num_nodes = graph_info_->num_nodes();
+  std::vector<size_t> signature;
+  signature.reserve(num_tensors + num_nodes);
+  for (size_t i = 0; i < num_tensors; ++i) {
+    const TfLiteTensor& tensor = *graph_info_->tensor(i);
+    signature.push_back(tensor.allocation_type == kTfLiteArenaRw
+                            ? tensor.bytes
+                            : std::numeric_limits<size_t>::max());
+  }
+  for (size_t i = 0; i < num_nodes; ++i) {
+    const TfLiteIntArray* node_temporaries = graph_info_->node(i).temporaries;
+    signature.push_back(node_temporaries->size);
+    signature.insert(signature.end(), node_temporaries->data,
+                     node_temporaries->data + node_temporaries->size);
+    signature.push_back(graph_info_->node_step(i));
+  }
+  return signature;
+}
+
+bool ArenaPlanner::HasConcurrentNodes() const {
+  const size_t num_nodes = graph_info_->num_nodes();
+  for (size_t i = 0; i < num_nodes; ++i) {
+    if (graph_info_->node_step(i) != i) return true;
+  }
+  return false;
+}
+
+const ArenaPlanner::CachedPlan* ArenaPlanner::FindCachedPlan(
+    const std::vector<size_t>& signature) {
+  auto it = std::find_if(plan_cache_.begin(), plan_cache_.end(),
+                         [&signature](const CachedPlan& plan) {
+                           return plan.signature == signature;
+                         });
+  if (it == plan_cache_.end()) return nullptr;
+  plan_cache_.splice(plan_cache_.begin(), plan_cache_, it);
+  return &plan_cache_.front();
+}
+
+TfLiteStatus ArenaPlanner::RestorePlan(const CachedPlan& plan) {
+  for (size_t i = 0; i < allocs_.size(); ++i) {
+    if (graph_info_->tensor(i)->allocation_type == kTfLiteArenaRw) {
+      allocs_[i] = plan.allocs[i];
+    }
+  }
+  arena_.Reserve(plan.arena_size);
+  planned_arena_size_ = plan.planned_arena_size;
+  arena_size_lower_bound_ = plan.arena_size_lower_bound;
+
+  // Persistent tensors are never deallocated, so their order of allocation
+  // does not matter.
+  auto allocate_if_persistent = [this](int tensor_index) {
+    if (graph_info_->tensor(tensor_index)->allocation_type ==
+        kTfLiteArenaRwPersistent) {
+      return CalculateTensorAllocation(tensor_index);
+    }
+    return kTfLiteOk;
+  };
+  for (const auto& alloc_info : alloc_queue_) {
+    if (alloc_info.type == AllocationInfo::ALLOC) {
+      TF_LITE_ENSURE_STATUS(allocate_if_persistent(alloc_info.tensor));
+    }
+  }
+  for (size_t i = 0; i < graph_info_->num_nodes(); ++i) {
+    const TfLiteIntArray* node_temporaries = graph_info_->node(i).temporaries;
+    for (int j = 0; j < node_temporaries->size; ++j) {
+      TF_LITE_ENSURE_STATUS(allocate_if_persistent(node_temporaries->data[j]));
+    }
+  }
+  return kTfLiteOk;
+}
+
+void ArenaPlanner::CachePlan(std::vector<size_t> signature) {
+  CachedPlan plan;
+  plan.signature = std::move(signature);
+  plan.allocs = allocs_;
+  plan.arena_size = arena_.high_water_mark();
+  plan.planned_arena_size = planned_arena_size_;
+  plan.arena_size_lower_bound = arena_size_lower_bound_;
+  plan_cache_.push_front(std::move(plan));
+  if (plan_cache_.size() > static_cast<size_t>(kMaxCachedPlans)) {
+    plan_cache_.pop_back();
+  }
+}
+
 TfLiteStatus ArenaPlanner::ResolveTensorAllocation(int tensor_index) {
   TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
   if (tensor.allocation_type == kTfLiteArenaRw) {
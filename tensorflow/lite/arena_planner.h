@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_LITE_ARENA_PLANNER_H_
 
 #include <cstdint>
+#include <list>
 #include <memory>
 #include <vector>
 
@@ -46,6 +47,22 @@ struct AllocationInfo;
 // corresponding operation is executed, this class supports incremental
 // planning.
 //
+// By default tensors are placed in the arena in execution order, each in the
+// best fitting gap left by the tensors deallocated so far. If
+// 'greedy_by_size' is true and all tensors have static sizes, the whole graph
+// is instead planned at once: tensors are placed from the largest to the
+// smallest, each in the best fitting gap between the tensors already placed
+// whose lifetime overlaps with it. This usually gets much closer to the
+// minimum arena size for large models.
+//
+// If the graph info schedules some nodes to run concurrently (see
+// GraphInfo::node_step()), the greedy-by-size plan is always used, as it is
+// the one that keeps the tensors of concurrent nodes apart.
+//
+// Plans of the whole graph are kept for the last kMaxCachedPlans sets of tensor
+// sizes, so that a model whose inputs alternate between a few shapes only
+// computes each plan once.
+//
 // TODO(b/127354079): Remove the constrain below when the issue is fixed.
 // WARNING: MemoryPlanner's behavior must be deterministic. If the first N
 // nodes are unchanged, it must produce exactly the same allocation plan for
@@ -58,7 +75,8 @@ class ArenaPlanner : public MemoryPlanner {
   // them until the end of inference.
   ArenaPlanner(TfLiteContext* context, std::unique_ptr<GraphInfo> graph_info,
                bool preserve_inputs, bool preserve_intermediates,
-               int tensor_alignment = kDefaultTensorAlignment);
+               int tensor_alignment = kDefaultTensorAlignment,
+               bool greedy_by_size = false);
   ~ArenaPlanner() override;
   ArenaPlanner(const ArenaPlanner&) = delete;
   ArenaPlanner& operator=(const ArenaPlanner&) = delete;
@@ -73,6 +91,23 @@ class ArenaPlanner : public MemoryPlanner {
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
 
+  // Number of plans of the whole graph kept for reuse.
+  static constexpr int kMaxCachedPlans = 4;
+
+  // Returns how many times a plan of the whole graph was reused instead of
+  // being computed again.
+  int num_cached_plan_hits() const { return num_cached_plan_hits_; }
+
+  // Returns the number of bytes of the arena planned for the non-persistent
+  // tensors of the whole graph by the greedy-by-size planner, or 0 if the
+  // graph has not been planned that way.
+  size_t planned_arena_size() const { return planned_arena_size_; }
+
+  // Returns the largest total size of the non-persistent tensors that are
+  // alive at the same time, which is a lower bound of any arena size. Only
+  // computed by the greedy-by-size planner, 0 otherwise.
+  size_t arena_size_lower_bound() const { return arena_size_lower_bound_; }
+
  private:
   // Make sure all the arenas have reserved enough memory to store all their
   // tensors.
@@ -82,6 +117,32 @@ class ArenaPlanner : public MemoryPlanner {
   // for all tensors affected by ops in the interval [first_node, last_node].
   TfLiteStatus CalculateAllocations(int first_node, int last_node);
 
+  // Reserve space for all tensors of the graph at once, placing the
+  // non-persistent tensors by decreasing size against their lifetimes.
+  TfLiteStatus CalculateAllocationsGreedyBySize();
+
+  // Returns the key of the plan of the whole graph: the sizes of the tensors
+  // in the non-persistent arena, and the temporaries and step of every node.
+  std::vector<size_t> PlanSignature();
+
+  // Whether any node's step differs from its position in the execution plan,
+  // i.e. whether some nodes may run concurrently.
+  bool HasConcurrentNodes() const;
+
+  struct CachedPlan;
+
+  // Returns the cached plan with the given signature, marking it as the most
+  // recently used, or nullptr if there is none.
+  const CachedPlan* FindCachedPlan(const std::vector<size_t>& signature);
+
+  // Reuses a cached plan for the non-persistent tensors, reserving space for
+  // the persistent tensors again.
+  TfLiteStatus RestorePlan(const CachedPlan& plan);
+
+  // Caches the current plan of the whole graph, evicting the least recently
+  // used one if there are already kMaxCachedPlans.
+  void CachePlan(std::vector<size_t> signature);
+
   // Assign absolute memory location to a tensor, based on its relative
   // position inside the corresponding arena buffer.
   TfLiteStatus ResolveTensorAllocation(int tensor_index);
@@ -129,6 +190,28 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Number of bytes that tensor buffers should be aligned to.
   int tensor_alignment_;
+
+  // If true, the whole graph is planned at once when all tensor sizes are
+  // known, with CalculateAllocationsGreedyBySize().
+  bool greedy_by_size_;
+
+  // Statistics of the last greedy-by-size plan.
+  size_t planned_arena_size_ = 0;
+  size_t arena_size_lower_bound_ = 0;
+
+  // A plan of the whole graph for a given PlanSignature().
+  struct CachedPlan {
+    std::vector<size_t> signature;
+    // Allocations of the tensors in the non-persistent arena.
+    std::vector<ArenaAlloc> allocs;
+    size_t arena_size;
+    size_t planned_arena_size;
+    size_t arena_size_lower_bound;
+  };
+
+  // Most recently used plans first. Cleared when the graph topology changes.
+  std::list<CachedPlan> plan_cache_;
+  int num_cached_plan_hits_ = 0;
 };
 
 }  // namespace tflite
@@ -104,17 +104,22 @@ class TestGraph {
   const std::vector<int>& inputs() { return inputs_; }
   const std::vector<int>& outputs() { return outputs_; }
   const std::vector<int>& variables() { return variables_; }
+  const std::vector<int>& steps() { return steps_; }
 
   void SetVariables(const std::vector<int>& variables) {
     variables_ = variables;
   }
 
+  // Sets the step of every node, see GraphInfo::node_step().
+  void SetSteps(const std::vector<int>& steps) { steps_ = steps; }
+
   void Swap(TestGraph* other) {
     std::swap(nodes_, other->nodes_);
     std::swap(tensors_, other->tensors_);
     std::swap(inputs_, other->inputs_);
     std::swap(outputs_, other->outputs_);
     std::swap(variables_, other->variables_);
+    std::swap(steps_, other->steps_);
   }
 
  private:
@@ -123,6 +128,7 @@ class TestGraph {
   std::vector<int> inputs_;
   std::vector<int> outputs_;
   std::vector<int> variables_;
+  std::vector<int> steps_;
 };
 
 // The GraphInfo for a TestGraph.
@@ -139,6 +145,9 @@ class TestGraphInfo : public GraphInfo {
     return graph_->nodes()[index];
   }
   size_t node_index(size_t index) const override { return index; }
+  size_t node_step(size_t index) const override {
+    return graph_->steps().empty() ? index : graph_->steps()[index];
+  }
   const std::vector<int>& inputs() const override { return graph_->inputs(); }
   const std::vector<int>& outputs() const override { return graph_->outputs(); }
   const std::vector<int>& variables() const override {
@@ -163,12 +172,14 @@ void ReportError(TfLiteContext* context, const char* format, ...) {
 
 class ArenaPlannerTest : public ::testing::Test {
  protected:
-  void SetGraph(TestGraph* graph, bool preserve_inputs = false) {
+  void SetGraph(TestGraph* graph, bool preserve_inputs = false,
+                bool greedy_by_size = false) {
     graph_ = graph;
     context_.ReportError = ReportError;
     planner_.reset(new ArenaPlanner(
         &context_, std::unique_ptr<GraphInfo>(new TestGraphInfo(graph)),
-        preserve_inputs, /*preserve intermediates*/ false, kTensorAlignment));
+        preserve_inputs, /*preserve intermediates*/ false, kTensorAlignment,
+        greedy_by_size));
     CHECK(planner_->ResetAllocations() == kTfLiteOk);
     CHECK(planner_->PlanAllocations() == kTfLiteOk);
   }
@@ -610,6 +621,202 @@ TEST_F(ArenaPlannerTest, ModifiedGraph_DeallocateNonPersistentArena) {
   EXPECT_EQ(GetOffset(3), GetOffsetAfter(1));
 }
 
+TEST_F(ArenaPlannerTest, GreedyBySizeSimpleGraph) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4}, {3}, {}}         // Third op
+                  },
+                  {3, 5});
+  SetGraph(&graph, /*preserve_inputs=*/false, /*greedy_by_size=*/true);
+  Execute(0, 10);
+
+  // The largest tensors go first. Tensor 3 shares its space with tensor 2,
+  // which is dead by then, and tensor 1 with tensors 5 and 4, which are not
+  // alive yet.
+  EXPECT_EQ(GetOffset(5), 0);
+  EXPECT_EQ(GetOffset(4), GetOffsetAfter(5));
+  EXPECT_EQ(GetOffset(3), GetOffsetAfter(4));
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(4));
+  EXPECT_EQ(GetOffset(1), 0);
+  EXPECT_EQ(GetOffset(0), GetOffsetAfter(2));
+  EXPECT_EQ(planner_->planned_arena_size(), 51);
+  EXPECT_EQ(planner_->arena_size_lower_bound(), 45);
+}
+
+TEST_F(ArenaPlannerTest, GreedyBySizeDoesNotOverlapLiveTensors) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {7}},     // First op
+                      {{1}, {2}, {}},      // Second op
+                      {{0, 2}, {3}, {8}},  // Third op
+                      {{3}, {4}, {}},      // Fourth op
+                      {{4, 1}, {5}, {}},   // Fifth op
+                      {{5}, {6}, {9}}      // Sixth op
+                  },
+                  {6});
+  (*graph.tensors())[7].bytes = 100;
+  (*graph.tensors())[3].bytes = 80;
+  SetGraph(&graph, /*preserve_inputs=*/true, /*greedy_by_size=*/true);
+  Execute(0, 10);
+
+  // The lifetime of each tensor as [first node, last node].
+  const std::vector<std::pair<int, int>> lifetimes = {
+      {0, 5}, {0, 4}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 5},
+      {0, 0}, {2, 2}, {5, 5}};
+  const int num_tensors = lifetimes.size();
+  for (int a = 0; a < num_tensors; ++a) {
+    for (int b = a + 1; b < num_tensors; ++b) {
+      if (lifetimes[a].second < lifetimes[b].first ||
+          lifetimes[b].second < lifetimes[a].first) {
+        continue;
+      }
+      EXPECT_TRUE(GetOffsetAfter(a) <= GetOffset(b) ||
+                  GetOffsetAfter(b) <= GetOffset(a))
+          << "tensors " << a << " and " << b << " overlap";
+    }
+  }
+  EXPECT_GE(planner_->planned_arena_size(),
+            planner_->arena_size_lower_bound());
+}
+
+TEST_F(ArenaPlannerTest, ConcurrentNodesDoNotShareMemory) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},     // First op
+                      {{0}, {2}, {}},     // Second op
+                      {{1}, {3}, {6}},    // Third op
+                      {{2}, {4}, {7}},    // Fourth op
+                      {{3, 4}, {5}, {}},  // Fifth op
+                  },
+                  {5});
+  // The first two and the next two ops run concurrently. In execution order,
+  // the fourth op could reuse the memory freed by the third one.
+  graph.SetSteps({0, 0, 1, 1, 2});
+  (*graph.tensors())[4].bytes = 6;
+  (*graph.tensors())[7].bytes = 6;
+  SetGraph(&graph);
+  Execute(0, 10);
+
+  // Concurrent nodes are always planned by size.
+  EXPECT_GT(planner_->planned_arena_size(), 0);
+
+  // The lifetime of each tensor as [first step, last step].
+  const std::vector<std::pair<int, int>> lifetimes = {
+      {0, 0}, {0, 1}, {0, 1}, {1, 2}, {1, 2}, {2, 2}, {1, 1}, {1, 1}};
+  const int num_tensors = lifetimes.size();
+  for (int a = 0; a < num_tensors; ++a) {
+    for (int b = a + 1; b < num_tensors; ++b) {
+      if (lifetimes[a].second < lifetimes[b].first ||
+          lifetimes[b].second < lifetimes[a].first) {
+        continue;
+      }
+      EXPECT_TRUE(GetOffsetAfter(a) <= GetOffset(b) ||
+                  GetOffsetAfter(b) <= GetOffset(a))
+          << "tensors " << a << " and " << b << " overlap";
+    }
+  }
+}
+
+TEST_F(ArenaPlannerTest, GreedyBySizeNeedsLessMemoryThanExecutionOrder) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},     // First op
+                      {{1}, {2}, {}},     // Second op
+                      {{2, 0}, {3}, {}},  // Third op
+                      {{3}, {4}, {}}      // Fourth op
+                  },
+                  {4});
+  const size_t sizes[] = {20, 32, 40, 40, 12};
+  for (int i = 0; i < 5; ++i) {
+    (*graph.tensors())[i].bytes = sizes[i];
+  }
+
+  // In execution order, tensor 3 does not fit in the space left by tensor 1
+  // and goes after tensor 2.
+  SetGraph(&graph);
+  Execute(0, 10);
+  EXPECT_EQ(GetOffset(3), GetOffsetAfter(2));
+  EXPECT_EQ(GetOffsetAfter(3), 132);
+
+  // Placing tensors 2 and 3 first leaves tensor 1 room next to tensor 2, and
+  // the plan reaches the lower bound.
+  SetGraph(&graph, /*preserve_inputs=*/false, /*greedy_by_size=*/true);
+  Execute(0, 10);
+  EXPECT_EQ(GetOffset(2), 0);
+  EXPECT_EQ(GetOffset(3), GetOffsetAfter(2));
+  EXPECT_EQ(GetOffset(1), GetOffsetAfter(2));
+  EXPECT_EQ(GetOffset(0), GetOffsetAfter(3));
+  EXPECT_EQ(GetOffset(4), 0);
+  EXPECT_EQ(planner_->planned_arena_size(), 100);
+  EXPECT_EQ(planner_->arena_size_lower_bound(), 100);
+}
+
+TEST_F(ArenaPlannerTest, GreedyBySizeFallsBackForPartialPlans) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4}, {3}, {}}         // Third op
+                  },
+                  {3, 5});
+  SetGraph(&graph, /*preserve_inputs=*/false, /*greedy_by_size=*/true);
+  Execute(0, 0);
+  Execute(1, 2);
+
+  // Same plan as SimpleGraph.
+  EXPECT_EQ(GetOffset(0), 0);
+  EXPECT_EQ(GetOffset(1), GetOffsetAfter(0));
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(1));
+  EXPECT_EQ(GetOffset(4), GetOffsetAfter(2));
+  EXPECT_EQ(GetOffset(5), GetOffsetAfter(4));
+  EXPECT_EQ(GetOffset(3), 0);
+  EXPECT_EQ(planner_->planned_arena_size(), 0);
+}
+
+TEST_F(ArenaPlannerTest, ReusesPlanForPreviousTensorSizes) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4}, {3}, {}}         // Third op
+                  },
+                  {3, 5});
+  SetGraph(&graph);
+  Execute(0, 10);
+  std::vector<std::ptrdiff_t> offsets;
+  for (int i = 0; i < 6; ++i) offsets.push_back(GetOffset(i));
+
+  // A different size for one tensor needs a new plan.
+  (*graph.tensors())[2].bytes = 100;
+  CHECK(planner_->ResetAllocations() == kTfLiteOk);
+  Execute(0, 10);
+  EXPECT_EQ(GetOffset(4), GetOffsetAfter(2));
+  EXPECT_EQ(planner_->num_cached_plan_hits(), 0);
+
+  // Going back to the original sizes reuses the first plan.
+  (*graph.tensors())[2].bytes = 9;
+  CHECK(planner_->ResetAllocations() == kTfLiteOk);
+  Execute(0, 10);
+  EXPECT_EQ(planner_->num_cached_plan_hits(), 1);
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(GetOffset(i), offsets[i]);
+  }
+
+  // Partial plans are neither cached nor taken from the cache.
+  CHECK(planner_->ResetAllocations() == kTfLiteOk);
+  Execute(0, 0);
+  Execute(1, 10);
+  EXPECT_EQ(planner_->num_cached_plan_hits(), 1);
+}
+
 }  // namespace
 }  // namespace tflite
 
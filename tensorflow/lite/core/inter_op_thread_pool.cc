@@ -0,0 +1,80 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/inter_op_thread_pool.h"
+
+namespace tflite {
+
+InterOpThreadPool::InterOpThreadPool(int num_threads) {
+  for (int i = 1; i < num_threads; ++i) {
+    workers_.emplace_back(&InterOpThreadPool::WorkerLoop, this, i);
+  }
+}
+
+InterOpThreadPool::~InterOpThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exiting_ = true;
+  }
+  work_available_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void InterOpThreadPool::Run(int num_tasks,
+                            const std::function<void(int, int)>& task) {
+  if (workers_.empty() || num_tasks <= 1) {
+    for (int i = 0; i < num_tasks; ++i) task(0, i);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    num_tasks_ = num_tasks;
+    next_task_ = 0;
+    num_busy_workers_ = static_cast<int>(workers_.size());
+    ++generation_;
+  }
+  work_available_.notify_all();
+  RunTasks(0);
+  std::unique_lock<std::mutex> lock(mutex_);
+  work_done_.wait(lock, [this] { return num_busy_workers_ == 0; });
+  task_ = nullptr;
+}
+
+void InterOpThreadPool::RunTasks(int thread_index) {
+  for (int i = next_task_++; i < num_tasks_; i = next_task_++) {
+    (*task_)(thread_index, i);
+  }
+}
+
+void InterOpThreadPool::WorkerLoop(int thread_index) {
+  uint64_t seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_available_.wait(lock, [this, seen_generation] {
+        return exiting_ || generation_ != seen_generation;
+      });
+      if (exiting_) return;
+      seen_generation = generation_;
+    }
+    RunTasks(thread_index);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--num_busy_workers_ == 0) work_done_.notify_one();
+  }
+}
+
+}  // namespace tflite
@@ -162,6 +162,10 @@ class InterpreterInfo : public GraphInfo {
   size_t node_index(size_t index) const override {
     return subgraph_->execution_plan()[index];
   }
+  size_t node_step(size_t index) const override {
+    const std::vector<int>& steps = subgraph_->inter_op_schedule();
+    return index < steps.size() ? steps[index] : index;
+  }
   const std::vector<int>& inputs() const override {
     return subgraph_->inputs();
   }
@@ -404,8 +408,20 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
   return kTfLiteOk;
 }
 
+namespace {
+
+// The CPU backend context of the inter-op pool thread running the current op,
+// or nullptr if the op runs on the thread that called Invoke().
+thread_local TfLiteExternalContext* inter_op_cpu_backend_context = nullptr;
+
+}  // namespace
+
 TfLiteExternalContext* Subgraph::GetExternalContext(
     TfLiteExternalContextType type) {
+  if (type == kTfLiteCpuBackendContext &&
+      inter_op_cpu_backend_context != nullptr) {
+    return inter_op_cpu_backend_context;
+  }
   if (static_cast<int>(type) >= 0 && type < kTfLiteMaxExternalContexts) {
     return external_contexts_[type];
   }
@@ -630,7 +646,20 @@ TfLiteStatus Subgraph::AllocateTensors() {
     TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
   }
 
-  TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
+  // If only input tensors were resized since the last time every op was
+  // prepared, the ops that don't depend on them don't need to be prepared
+  // again.
+  const bool prepare_incrementally = can_prepare_incrementally_;
+  can_prepare_incrementally_ = false;
+  if (prepare_incrementally) {
+    TF_LITE_ENSURE_STATUS(PrepareResizedOpsAndTensors());
+  } else {
+    TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
+  }
+  resized_input_tensors_.clear();
+  // Dynamic inputs may be resized without going through ResizeInputTensor().
+  can_prepare_incrementally_ =
+      !has_dynamic_tensors_ && !HasDynamicTensorImpl(context_, inputs());
 
   state_ = kStateInvokable;
 
@@ -673,6 +702,7 @@ TfLiteStatus Subgraph::AddNodeWithParameters(
     return kTfLiteError;
   }
   state_ = kStateUninvokable;
+  can_prepare_incrementally_ = false;
 
   TF_LITE_ENSURE_OK(&context_, CheckTensorIndices("node inputs", inputs.data(),
                                                   inputs.size()));
@@ -756,7 +786,12 @@ TfLiteStatus Subgraph::ResizeInputTensor(int tensor_index,
     TF_LITE_ENSURE_STATUS(UndoAllDelegates());
   }
   state_ = kStateUninvokable;
-  return ResizeTensorImpl(tensor, ConvertVectorToTfLiteIntArray(dims));
+  TF_LITE_ENSURE_STATUS(
+      ResizeTensorImpl(tensor, ConvertVectorToTfLiteIntArray(dims)));
+  if (can_prepare_incrementally_) {
+    resized_input_tensors_.push_back(tensor_index);
+  }
+  return kTfLiteOk;
 }
 
 TfLiteStatus Subgraph::ReleaseNonPersistentMemory() {
@@ -821,7 +856,8 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   if (!memory_planner_) {
     memory_planner_.reset(new ArenaPlanner(
         &context_, std::unique_ptr<GraphInfo>(new InterpreterInfo(this)),
-        /*preserve_inputs=*/true, /*preserve_intermediates*/ false));
+        /*preserve_inputs=*/true, /*preserve_intermediates*/ false,
+        kDefaultTensorAlignment, use_greedy_arena_planner_));
     memory_planner_->PlanAllocations();
   }
 
@@ -831,6 +867,9 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
       next_execution_plan_index_to_prepare_, &last_exec_plan_index_prepared));
   next_execution_plan_index_to_prepare_ = last_exec_plan_index_prepared + 1;
 
+  if (next_execution_plan_index_to_plan_allocation_ == 0) {
+    BuildInterOpSchedule();
+  }
   TF_LITE_ENSURE_STATUS(memory_planner_->ExecuteAllocations(
       next_execution_plan_index_to_plan_allocation_,
       last_exec_plan_index_prepared));
@@ -840,6 +879,180 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   return kTfLiteOk;
 }
 
+TfLiteStatus Subgraph::PrepareResizedOpsAndTensors() {
+  // Tensors whose dimensions changed, either because they were resized by the
+  // user or because an op producing them was prepared again.
+  std::vector<bool> resized(tensors_.size(), false);
+  for (int tensor_index : resized_input_tensors_) {
+    resized[tensor_index] = true;
+  }
+  auto any_resized = [&resized](const TfLiteIntArray* tensor_indices) {
+    for (int i = 0; i < tensor_indices->size; ++i) {
+      const int tensor_index = tensor_indices->data[i];
+      if (tensor_index != kTfLiteOptionalTensor &&
+          tensor_index < static_cast<int>(resized.size()) &&
+          resized[tensor_index]) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  has_dynamic_tensors_ = false;
+  int last_exec_plan_index_prepared =
+      std::max(static_cast<int>(execution_plan_.size()) - 1, 0);
+  std::vector<std::unique_ptr<TfLiteIntArray, TfLiteIntArrayDeleter>>
+      output_dims;
+  for (int execution_plan_index = 0;
+       execution_plan_index < execution_plan_.size(); execution_plan_index++) {
+    int node_index = execution_plan_[execution_plan_index];
+    TfLiteNode& node = nodes_and_registration_[node_index].first;
+    const TfLiteRegistration& registration =
+        nodes_and_registration_[node_index].second;
+    if (!any_resized(node.inputs)) continue;
+
+    output_dims.clear();
+    for (int i = 0; i < node.outputs->size; ++i) {
+      output_dims.emplace_back(
+          TfLiteIntArrayCopy(tensors_[node.outputs->data[i]].dims));
+    }
+    EnsureTensorsVectorCapacity();
+    if (OpPrepare(registration, &node) == kTfLiteError) {
+      return ReportOpError(&context_, node, registration, node_index,
+                           "failed to prepare");
+    }
+    for (int i = 0; i < node.outputs->size; ++i) {
+      const int tensor_index = node.outputs->data[i];
+      if (!TfLiteIntArrayEqual(output_dims[i].get(),
+                               tensors_[tensor_index].dims)) {
+        if (tensor_index >= static_cast<int>(resized.size())) {
+          resized.resize(tensor_index + 1, false);
+        }
+        resized[tensor_index] = true;
+      }
+    }
+
+    // As in PrepareOpsStartingAt(), the ops after one with dynamic outputs
+    // are prepared during Invoke().
+    if (HasDynamicTensor(context_, node.outputs)) {
+      has_dynamic_tensors_ = true;
+      last_exec_plan_index_prepared = execution_plan_index;
+      break;
+    }
+  }
+  next_execution_plan_index_to_prepare_ = last_exec_plan_index_prepared + 1;
+
+  BuildInterOpSchedule();
+  TF_LITE_ENSURE_STATUS(
+      memory_planner_->ExecuteAllocations(0, last_exec_plan_index_prepared));
+  next_execution_plan_index_to_plan_allocation_ =
+      last_exec_plan_index_prepared + 1;
+
+  return kTfLiteOk;
+}
+
+void Subgraph::SetNumInterOpThreads(int num_threads) {
+  num_threads = std::max(num_threads, 1);
+  if (num_threads == num_inter_op_threads_) return;
+  num_inter_op_threads_ = num_threads;
+  state_ = kStateUninvokable;
+}
+
+bool Subgraph::CanRunConcurrently(
+    const TfLiteNode& node, const TfLiteRegistration& registration) const {
+  // Delegate kernels, custom ops and control flow ops may touch state outside
+  // of their tensors, or invoke other subgraphs.
+  if (node.delegate != nullptr) return false;
+  switch (registration.builtin_code) {
+    case BuiltinOperator_CUSTOM:
+    case BuiltinOperator_DELEGATE:
+    case BuiltinOperator_IF:
+    case BuiltinOperator_WHILE:
+      return false;
+    default:
+      break;
+  }
+  for (const TfLiteIntArray* tensor_indices : {node.inputs, node.outputs}) {
+    for (int i = 0; i < tensor_indices->size; ++i) {
+      const int tensor_index = tensor_indices->data[i];
+      if (tensor_index != kTfLiteOptionalTensor &&
+          tensors_[tensor_index].is_variable) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void Subgraph::BuildInterOpSchedule() {
+  inter_op_node_steps_.clear();
+  inter_op_steps_.clear();
+  inter_op_schedule_warmed_up_ = false;
+  if (num_inter_op_threads_ <= 1 || has_dynamic_tensors_) return;
+
+  // An op runs after the ops writing its inputs (`ready_step`), and after the
+  // ops reading or writing its outputs (`free_step`). Ops that can't run
+  // concurrently get a step of their own, after every op before them.
+  std::vector<int> ready_step(tensors_.size(), 0);
+  std::vector<int> free_step(tensors_.size(), 0);
+  int first_step = 0;
+  int num_steps = 0;
+  inter_op_node_steps_.resize(execution_plan_.size());
+  for (int execution_plan_index = 0;
+       execution_plan_index < execution_plan_.size(); execution_plan_index++) {
+    int node_index = execution_plan_[execution_plan_index];
+    const TfLiteNode& node = nodes_and_registration_[node_index].first;
+    const TfLiteRegistration& registration =
+        nodes_and_registration_[node_index].second;
+    const bool concurrent = CanRunConcurrently(node, registration);
+    int step = concurrent ? first_step : num_steps;
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      step = std::max(step, ready_step[tensor_index]);
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      step = std::max(step, free_step[tensor_index]);
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      free_step[tensor_index] = std::max(free_step[tensor_index], step + 1);
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      ready_step[tensor_index] = step + 1;
+      free_step[tensor_index] = std::max(free_step[tensor_index], step + 1);
+    }
+    if (!concurrent) first_step = step + 1;
+    inter_op_node_steps_[execution_plan_index] = step;
+    num_steps = std::max(num_steps, step + 1);
+  }
+  if (num_steps == static_cast<int>(execution_plan_.size())) {
+    // No two ops can run at the same time.
+    inter_op_node_steps_.clear();
+    return;
+  }
+  inter_op_steps_.resize(num_steps);
+  for (int execution_plan_index = 0;
+       execution_plan_index < execution_plan_.size(); execution_plan_index++) {
+    inter_op_steps_[inter_op_node_steps_[execution_plan_index]].push_back(
+        execution_plan_index);
+  }
+
+  if (!inter_op_thread_pool_ ||
+      inter_op_thread_pool_->num_threads() != num_inter_op_threads_) {
+    inter_op_thread_pool_.reset(new InterOpThreadPool(num_inter_op_threads_));
+    inter_op_cpu_backend_contexts_.clear();
+    for (int i = 1; i < num_inter_op_threads_; ++i) {
+      inter_op_cpu_backend_contexts_.emplace_back(
+          new ExternalCpuBackendContext());
+    }
+  }
+  TFLITE_LOG(tflite::TFLITE_LOG_INFO,
+             "Scheduled %zu ops in %d steps on %d inter-op threads.",
+             execution_plan_.size(), num_steps, num_inter_op_threads_);
+}
+
 TfLiteStatus Subgraph::Invoke() {
   if (!consistent_) {
     ReportError("Invoke called on model that is not consistent.");
@@ -862,6 +1075,10 @@ TfLiteStatus Subgraph::Invoke() {
     applied_nnapi_delegate_ = true;
   }
 
+  if (!inter_op_steps_.empty()) {
+    return InvokeInterOpSchedule();
+  }
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -938,6 +1155,90 @@ TfLiteStatus Subgraph::Invoke() {
   return status;
 }
 
+TfLiteStatus Subgraph::InvokeInterOpSchedule() {
+  // Until the schedule ran once with the current number of threads, ops run
+  // one at a time. They also do when profiling, as the profiler isn't
+  // thread-safe.
+  const bool warmed_up =
+      inter_op_schedule_warmed_up_ &&
+      inter_op_warm_up_num_threads_ == context_.recommended_num_threads;
+  if (!warmed_up) {
+    for (auto& cpu_backend_context : inter_op_cpu_backend_contexts_) {
+      TfLiteInternalBackendContext* internal_backend_context =
+          cpu_backend_context->internal_backend_context();
+      if (internal_backend_context != nullptr &&
+          context_.recommended_num_threads != -1) {
+        internal_backend_context->SetMaxNumThreads(
+            context_.recommended_num_threads);
+      }
+    }
+    inter_op_schedule_warmed_up_ = true;
+    inter_op_warm_up_num_threads_ = context_.recommended_num_threads;
+  }
+  const bool run_concurrently = warmed_up && profiler_ == nullptr;
+
+  std::vector<TfLiteStatus> statuses;
+  for (const std::vector<int>& step : inter_op_steps_) {
+    for (int execution_plan_index : step) {
+      const TfLiteNode& node =
+          nodes_and_registration_[execution_plan_[execution_plan_index]].first;
+      for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+        if (tensor_index == kTfLiteOptionalTensor) continue;
+        TfLiteTensor* tensor = &tensors_[tensor_index];
+        if (tensor->delegate && tensor->delegate != node.delegate &&
+            tensor->data_is_stale) {
+          TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
+        }
+      }
+    }
+
+    if (check_cancelled_func_ != nullptr &&
+        check_cancelled_func_(cancellation_data_)) {
+      ReportError("Client requested cancel during Invoke()");
+      return kTfLiteError;
+    }
+
+    EnsureTensorsVectorCapacity();
+    if (!run_concurrently || step.size() == 1) {
+      for (int execution_plan_index : step) {
+        TF_LITE_ENSURE_STATUS(InvokeScheduledOp(execution_plan_index));
+      }
+      continue;
+    }
+    statuses.assign(step.size(), kTfLiteOk);
+    inter_op_thread_pool_->Run(
+        static_cast<int>(step.size()), [&](int thread_index, int i) {
+          inter_op_cpu_backend_context =
+              thread_index == 0
+                  ? nullptr
+                  : inter_op_cpu_backend_contexts_[thread_index - 1].get();
+          statuses[i] = InvokeScheduledOp(step[i]);
+          inter_op_cpu_backend_context = nullptr;
+        });
+    for (TfLiteStatus status : statuses) {
+      TF_LITE_ENSURE_STATUS(status);
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::InvokeScheduledOp(int execution_plan_index) {
+  int node_index = execution_plan_[execution_plan_index];
+  TfLiteNode& node = nodes_and_registration_[node_index].first;
+  const TfLiteRegistration& registration =
+      nodes_and_registration_[node_index].second;
+
+  const char* op_name = nullptr;
+  if (profiler_) op_name = GetTFLiteOpName(registration);
+  TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(profiler_.get(), op_name, node_index);
+
+  if (OpInvoke(registration, &node) == kTfLiteError) {
+    return ReportOpError(&context_, node, registration, node_index,
+                         "failed to invoke");
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::ResizeTensor(TfLiteContext* context,
                                     TfLiteTensor* tensor,
                                     TfLiteIntArray* new_size) {
@@ -1059,6 +1360,7 @@ TfLiteStatus Subgraph::SetTensorParametersReadOnly(
     tensor.allocation = allocation;
   } else {
     state_ = kStateUninvokable;
+    can_prepare_incrementally_ = false;
     TfLiteTensorReset(type, name, ConvertArrayToTfLiteIntArray(rank, dims),
                       GetLegacyQuantization(quantization),
                       const_cast<char*>(buffer), bytes, kTfLiteMmapRo,
@@ -1109,6 +1411,7 @@ TfLiteStatus Subgraph::SetTensorParametersReadWrite(
     allocation_type = kTfLiteArenaRwPersistent;
   }
 
+  can_prepare_incrementally_ = false;
   TfLiteTensor& tensor = context_.tensors[tensor_index];
   TfLiteTensorReset(type, name, ConvertArrayToTfLiteIntArray(rank, dims),
                     GetLegacyQuantization(quantization),
@@ -1126,6 +1429,7 @@ TfLiteStatus Subgraph::SetExecutionPlan(const std::vector<int>& new_plan) {
                                   node_index < nodes_and_registration_.size());
   }
   execution_plan_ = new_plan;
+  can_prepare_incrementally_ = false;
   return kTfLiteOk;
 }
 
@@ -1239,6 +1543,7 @@ TfLiteStatus Subgraph::UndoAllDelegates() {
   nodes_and_registration_.resize(max_retained_node_index + 1);
   // After undoing delegates, the graph is uninvokable, but mutable.
   state_ = kStateUninvokable;
+  can_prepare_incrementally_ = false;
 
   delegates_undone_ = true;
   return kTfLiteOk;
@@ -1259,6 +1564,7 @@ TfLiteStatus Subgraph::RedoAllDelegates() {
 TfLiteStatus Subgraph::EnsureMemoryAllocations() {
   if (memory_planner_) {
     state_ = kStateUninvokable;
+    can_prepare_incrementally_ = false;
     TF_LITE_ENSURE_OK(&context_, memory_planner_->PlanAllocations());
   }
   TF_LITE_ENSURE_OK(&context_, AllocateTensors());
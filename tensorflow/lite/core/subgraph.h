@@ -23,9 +23,11 @@ limitations under the License.
 #include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/core/inter_op_thread_pool.h"
 #include "tensorflow/lite/core/macros.h"
 #include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/memory_planner.h"
 #include "tensorflow/lite/util.h"
 
@@ -258,6 +260,28 @@ class Subgraph {
   // WARNING: This is an experimental API and subject to change.
   void SetCancellationFunction(void* data, bool (*check_cancelled_func)(void*));
 
+  // Plans the arena of non-persistent tensors with the greedy-by-size planner
+  // of ArenaPlanner. Only takes effect if called before the tensors are
+  // allocated for the first time.
+  // WARNING: This is an experimental API and subject to change.
+  void SetUseGreedyArenaPlanner(bool use_greedy_arena_planner) {
+    use_greedy_arena_planner_ = use_greedy_arena_planner;
+  }
+
+  // Runs independent ops concurrently on up to `num_threads` threads, see
+  // Interpreter::SetNumInterOpThreads(). AllocateTensors() must be called
+  // again before Invoke().
+  // WARNING: This is an experimental API and subject to change.
+  void SetNumInterOpThreads(int num_threads);
+
+  // Returns the step in which each op of the execution plan runs, ops of the
+  // same step running concurrently, or an empty vector if the ops run one at a
+  // time in execution plan order.
+  // WARNING: This is an experimental API and subject to change.
+  const std::vector<int>& inter_op_schedule() const {
+    return inter_op_node_steps_;
+  }
+
   // Ensure the data in `tensor.data` is readable. In case delegate is used,
   // it might require to copy the data from delegate buffer to raw memory.
   // WARNING: This is an experimental API and subject to change.
@@ -394,6 +418,28 @@ class Subgraph {
   TfLiteStatus PrepareOpsStartingAt(int first_execution_plan_index,
                                     int* last_execution_plan_index_prepared);
 
+  // Like PrepareOpsAndTensors() from the first op, for a graph whose ops were
+  // all prepared before and whose only changes since are the input tensors
+  // resized in `resized_input_tensors_`. Only the ops reading a tensor whose
+  // dimensions changed are prepared again, and the whole graph is planned.
+  TfLiteStatus PrepareResizedOpsAndTensors();
+
+  // Groups the ops of a fully prepared graph without dynamic tensors into
+  // steps of ops that don't depend on each other, if more than one inter-op
+  // thread is requested. Must be called before planning the allocations, as
+  // concurrent ops can't share memory.
+  void BuildInterOpSchedule();
+
+  // Whether the op may run at the same time as other ops.
+  bool CanRunConcurrently(const TfLiteNode& node,
+                          const TfLiteRegistration& registration) const;
+
+  // Invoke() for a graph with an inter-op schedule.
+  TfLiteStatus InvokeInterOpSchedule();
+
+  // Invokes the op at `execution_plan_index`, reporting errors.
+  TfLiteStatus InvokeScheduledOp(int execution_plan_index);
+
   // Tensors needed by the interpreter. Use `AddTensors` to add more blank
   // tensor entries. Note, `tensors_.data()` needs to be synchronized to the
   // `context_` whenever this std::vector is reallocated. Currently this
@@ -636,6 +682,38 @@ class Subgraph {
 
   std::unique_ptr<MemoryPlanner> memory_planner_;
 
+  // Whether memory_planner_ places tensors by decreasing size.
+  bool use_greedy_arena_planner_ = false;
+
+  // True if every op was prepared by the last AllocateTensors() and the graph
+  // was only changed by ResizeInputTensor() since, in which case the next
+  // AllocateTensors() calls PrepareResizedOpsAndTensors().
+  bool can_prepare_incrementally_ = false;
+
+  // Tensors resized by ResizeInputTensor() since the last AllocateTensors().
+  std::vector<int> resized_input_tensors_;
+
+  // Number of threads running the ops of a step of the inter-op schedule.
+  int num_inter_op_threads_ = 1;
+
+  // The inter-op schedule: the step of every op of the execution plan, and the
+  // execution plan indices of the ops of every step. Empty if ops run one at
+  // a time.
+  std::vector<int> inter_op_node_steps_;
+  std::vector<std::vector<int>> inter_op_steps_;
+
+  // Threads running the steps, and the CPU backend context used by the ops
+  // running on each of them but the calling thread, which uses the shared one.
+  std::unique_ptr<InterOpThreadPool> inter_op_thread_pool_;
+  std::vector<std::unique_ptr<ExternalCpuBackendContext>>
+      inter_op_cpu_backend_contexts_;
+
+  // Whether the schedule was run since it was built, and with which
+  // `recommended_num_threads`. Until then ops run one at a time, so that the
+  // state kernels share and create on first use is not created concurrently.
+  bool inter_op_schedule_warmed_up_ = false;
+  int inter_op_warm_up_num_threads_ = -1;
+
   // Tracking bit for whether a tensor was resized in the course of an op
   // invocation. This is a useful hint to ensure that dynamic tensor outputs
   // trigger downstream reallocation after op invocation.
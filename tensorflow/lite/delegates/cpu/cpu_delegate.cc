@@ -0,0 +1,559 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/delegates/cpu/cpu_delegate.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/context_util.h"
+#include "tensorflow/lite/delegates/cpu/float_kernels.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/minimal_logging.h"
+#include "tensorflow/lite/model_resources.h"
+#include "tensorflow/lite/util.h"
+
+namespace tflite {
+namespace delegates {
+namespace cpu {
+namespace {
+
+// Minimum number of multiply-adds computed by a single task, below which the
+// overhead of waking up another thread is not amortized.
+constexpr int64_t kMinCostPerTask = 1 << 15;
+
+// Runs fn(begin, end) over [0, size) split in contiguous ranges, one per
+// thread, on the thread pool of the interpreter.
+class RangeTask : public cpu_backend_threadpool::Task {
+ public:
+  RangeTask(const std::function<void(int, int)>& fn, int begin, int end)
+      : fn_(fn), begin_(begin), end_(end) {}
+
+  void Run() override { fn_(begin_, end_); }
+
+ private:
+  const std::function<void(int, int)>& fn_;
+  int begin_;
+  int end_;
+};
+
+void ParallelFor(CpuBackendContext* cpu_backend_context, int max_threads,
+                 int size, int64_t cost_per_unit,
+                 const std::function<void(int, int)>& fn) {
+  const int64_t total_cost = static_cast<int64_t>(size) * cost_per_unit;
+  const int num_tasks = std::min<int64_t>(std::min(max_threads, size),
+                                          total_cost / kMinCostPerTask);
+  if (num_tasks <= 1) {
+    fn(0, size);
+    return;
+  }
+  std::vector<RangeTask> tasks;
+  tasks.reserve(num_tasks);
+  for (int i = 0; i < num_tasks; ++i) {
+    tasks.emplace_back(fn, static_cast<int64_t>(size) * i / num_tasks,
+                       static_cast<int64_t>(size) * (i + 1) / num_tasks);
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
+}
+
+bool IsFloatTensor(const TfLiteTensor& tensor) {
+  return tensor.type == kTfLiteFloat32;
+}
+
+bool IsConstantFloatTensor(const TfLiteTensor& tensor) {
+  return IsFloatTensor(tensor) && tensor.allocation_type == kTfLiteMmapRo;
+}
+
+bool IsSupportedActivation(TfLiteFusedActivation activation) {
+  return activation == kTfLiteActNone || activation == kTfLiteActRelu ||
+         activation == kTfLiteActRelu1 || activation == kTfLiteActRelu6;
+}
+
+// Returns whether the delegate kernels can compute the node. Weights must be
+// constant so that they can be packed when the delegate is applied.
+bool IsNodeSupported(TfLiteContext* context, const TfLiteNode* node,
+                     const TfLiteRegistration* registration) {
+  const int builtin_code = registration->builtin_code;
+  if (builtin_code != kTfLiteBuiltinConv2d &&
+      builtin_code != kTfLiteBuiltinDepthwiseConv2d &&
+      builtin_code != kTfLiteBuiltinFullyConnected) {
+    return false;
+  }
+  if (node->inputs->size < 2 || node->inputs->size > 3 ||
+      node->outputs->size != 1) {
+    return false;
+  }
+
+  const TfLiteTensor& input = context->tensors[node->inputs->data[0]];
+  const TfLiteTensor& filter = context->tensors[node->inputs->data[1]];
+  const TfLiteTensor& output = context->tensors[node->outputs->data[0]];
+  if (!IsFloatTensor(input) || !IsFloatTensor(output) ||
+      !IsConstantFloatTensor(filter)) {
+    return false;
+  }
+  if (node->inputs->size == 3 &&
+      node->inputs->data[2] != kTfLiteOptionalTensor &&
+      !IsConstantFloatTensor(context->tensors[node->inputs->data[2]])) {
+    return false;
+  }
+
+  switch (builtin_code) {
+    case kTfLiteBuiltinConv2d: {
+      const auto* params =
+          reinterpret_cast<const TfLiteConvParams*>(node->builtin_data);
+      return filter.dims->size == 4 &&
+             IsSupportedActivation(params->activation);
+    }
+    case kTfLiteBuiltinDepthwiseConv2d: {
+      const auto* params =
+          reinterpret_cast<const TfLiteDepthwiseConvParams*>(
+              node->builtin_data);
+      return filter.dims->size == 4 && filter.dims->data[0] == 1 &&
+             IsSupportedActivation(params->activation);
+    }
+    case kTfLiteBuiltinFullyConnected: {
+      const auto* params =
+          reinterpret_cast<const TfLiteFullyConnectedParams*>(
+              node->builtin_data);
+      return filter.dims->size == 2 &&
+             params->weights_format ==
+                 kTfLiteFullyConnectedWeightsFormatDefault &&
+             !params->keep_num_dims &&
+             IsSupportedActivation(params->activation);
+    }
+    default:
+      return false;
+  }
+}
+
+// A node of the delegated partition, with its weights packed for the
+// microkernels.
+struct Operation {
+  int builtin_code;
+  int input;
+  int output;
+  TfLitePadding padding;
+  ConvParams conv_params;
+  FullyConnectedParams fully_connected_params;
+  // Packed filter and bias, shared by the interpreters of the model or owned
+  // by the operation. Depthwise convolutions use the filter in place.
+  const float* packed_filter = nullptr;
+  const float* packed_bias = nullptr;
+  std::vector<float> owned_packed_filter;
+  std::vector<float> owned_packed_bias;
+  const float* filter;
+};
+
+// Kernel that runs a partition of supported nodes, in their execution order.
+// Tensors produced and consumed only inside the partition are requested as
+// temporaries of the delegate node, so that the arena allocates them.
+class CpuDelegateKernel {
+ public:
+  explicit CpuDelegateKernel(const TfLiteCpuDelegateOptions& options)
+      : options_(options) {}
+
+  TfLiteStatus Init(TfLiteContext* context,
+                    const TfLiteDelegateParams* params) {
+    std::unordered_set<int> partition_outputs(
+        params->output_tensors->data,
+        params->output_tensors->data + params->output_tensors->size);
+    for (int node_index : TfLiteIntArrayView(params->nodes_to_replace)) {
+      TfLiteNode* node;
+      TfLiteRegistration* registration;
+      TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
+          context, node_index, &node, &registration));
+      operations_.emplace_back();
+      TF_LITE_ENSURE_STATUS(
+          InitOperation(context, node, registration, &operations_.back()));
+      const int output = node->outputs->data[0];
+      if (partition_outputs.count(output) == 0) {
+        internal_tensors_.push_back(output);
+      }
+    }
+    for (Operation& op : operations_) {
+      if (op.packed_filter == nullptr) {
+        op.packed_filter = op.owned_packed_filter.data();
+        op.packed_bias = op.owned_packed_bias.data();
+      }
+    }
+    return kTfLiteOk;
+  }
+
+  TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+    for (Operation& op : operations_) {
+      TF_LITE_ENSURE_STATUS(PrepareOperation(context, &op));
+    }
+    TfLiteIntArrayFree(node->temporaries);
+    node->temporaries = TfLiteIntArrayCreate(internal_tensors_.size());
+    for (int i = 0; i < static_cast<int>(internal_tensors_.size()); ++i) {
+      node->temporaries->data[i] = internal_tensors_[i];
+    }
+    return kTfLiteOk;
+  }
+
+  TfLiteStatus Invoke(TfLiteContext* context, TfLiteNode* node) {
+    CpuBackendContext* cpu_backend_context =
+        CpuBackendContext::GetFromContext(context);
+    int max_threads = cpu_backend_context->max_num_threads();
+    if (options_.num_threads > 0) {
+      max_threads = std::min(max_threads, options_.num_threads);
+    }
+
+    for (const Operation& op : operations_) {
+      const float* input = context->tensors[op.input].data.f;
+      float* output = context->tensors[op.output].data.f;
+      switch (op.builtin_code) {
+        case kTfLiteBuiltinConv2d: {
+          const ConvParams& params = op.conv_params;
+          ParallelFor(cpu_backend_context, max_threads,
+                      params.batches * params.output_height,
+                      static_cast<int64_t>(params.output_width) *
+                          params.output_channels * params.filter_height *
+                          params.filter_width * params.input_channels,
+                      [&](int begin, int end) {
+                        ConvRows(params, input, op.packed_filter,
+                                 op.packed_bias, begin, end, output);
+                      });
+          break;
+        }
+        case kTfLiteBuiltinDepthwiseConv2d: {
+          const ConvParams& params = op.conv_params;
+          ParallelFor(cpu_backend_context, max_threads,
+                      params.batches * params.output_height,
+                      static_cast<int64_t>(params.output_width) *
+                          params.output_channels * params.filter_height *
+                          params.filter_width,
+                      [&](int begin, int end) {
+                        DepthwiseConvRows(params, input, op.filter,
+                                          op.packed_bias, begin, end,
+                                          output);
+                      });
+          break;
+        }
+        case kTfLiteBuiltinFullyConnected: {
+          const FullyConnectedParams& params = op.fully_connected_params;
+          ParallelFor(cpu_backend_context, max_threads,
+                      NumChannelBlocks(params.num_units),
+                      static_cast<int64_t>(params.batches) *
+                          params.input_size * kChannelBlock,
+                      [&](int begin, int end) {
+                        FullyConnectedBlocks(params, input,
+                                             op.packed_filter,
+                                             op.packed_bias, begin, end,
+                                             output);
+                      });
+          break;
+        }
+        default:
+          context->ReportError(context, "Unsupported operation %d",
+                               op.builtin_code);
+          return kTfLiteError;
+      }
+    }
+    return kTfLiteOk;
+  }
+
+ private:
+  TfLiteStatus InitOperation(TfLiteContext* context, const TfLiteNode* node,
+                             const TfLiteRegistration* registration,
+                             Operation* op) {
+    op->builtin_code = registration->builtin_code;
+    op->input = node->inputs->data[0];
+    op->output = node->outputs->data[0];
+    const TfLiteTensor& filter = context->tensors[node->inputs->data[1]];
+    const float* bias = nullptr;
+    if (node->inputs->size == 3 &&
+        node->inputs->data[2] != kTfLiteOptionalTensor) {
+      bias = context->tensors[node->inputs->data[2]].data.f;
+    }
+
+    TfLiteFusedActivation activation = kTfLiteActNone;
+    switch (op->builtin_code) {
+      case kTfLiteBuiltinConv2d: {
+        const auto* params =
+            reinterpret_cast<const TfLiteConvParams*>(node->builtin_data);
+        activation = params->activation;
+        op->padding = params->padding;
+        op->conv_params.stride_height = params->stride_height;
+        op->conv_params.stride_width = params->stride_width;
+        op->conv_params.dilation_height = params->dilation_height_factor;
+        op->conv_params.dilation_width = params->dilation_width_factor;
+        op->conv_params.output_channels = filter.dims->data[0];
+        op->conv_params.filter_height = filter.dims->data[1];
+        op->conv_params.filter_width = filter.dims->data[2];
+        op->conv_params.input_channels = filter.dims->data[3];
+        op->conv_params.depth_multiplier = 1;
+        TF_LITE_ENSURE_STATUS(PackWeights(
+            context, filter.data.f, bias, op->conv_params.output_channels,
+            op->conv_params.filter_height, op->conv_params.filter_width,
+            op->conv_params.input_channels, op));
+        break;
+      }
+      case kTfLiteBuiltinDepthwiseConv2d: {
+        const auto* params =
+            reinterpret_cast<const TfLiteDepthwiseConvParams*>(
+                node->builtin_data);
+        activation = params->activation;
+        op->padding = params->padding;
+        op->conv_params.stride_height = params->stride_height;
+        op->conv_params.stride_width = params->stride_width;
+        op->conv_params.dilation_height = params->dilation_height_factor;
+        op->conv_params.dilation_width = params->dilation_width_factor;
+        op->conv_params.filter_height = filter.dims->data[1];
+        op->conv_params.filter_width = filter.dims->data[2];
+        op->conv_params.output_channels = filter.dims->data[3];
+        op->filter = filter.data.f;
+        op->owned_packed_bias.assign(op->conv_params.output_channels, 0.0f);
+        if (bias != nullptr) {
+          std::copy(bias, bias + op->conv_params.output_channels,
+                    op->owned_packed_bias.begin());
+        }
+        break;
+      }
+      case kTfLiteBuiltinFullyConnected: {
+        const auto* params =
+            reinterpret_cast<const TfLiteFullyConnectedParams*>(
+                node->builtin_data);
+        activation = params->activation;
+        op->fully_connected_params.num_units = filter.dims->data[0];
+        op->fully_connected_params.input_size = filter.dims->data[1];
+        // Fully connected weights are packed like a 1x1 convolution filter.
+        TF_LITE_ENSURE_STATUS(PackWeights(
+            context, filter.data.f, bias, op->fully_connected_params.num_units,
+            1, 1, op->fully_connected_params.input_size, op));
+        break;
+      }
+      default:
+        context->ReportError(context, "Unsupported operation %d",
+                             op->builtin_code);
+        return kTfLiteError;
+    }
+
+    float activation_min, activation_max;
+    CalculateActivationRange(activation, &activation_min, &activation_max);
+    op->conv_params.activation_min = activation_min;
+    op->conv_params.activation_max = activation_max;
+    op->fully_connected_params.activation_min = activation_min;
+    op->fully_connected_params.activation_max = activation_max;
+    return kTfLiteOk;
+  }
+
+  // Packs the filter and bias of a convolution or fully connected operation
+  // with PackConvFilter(), once for all the interpreters of the model if they
+  // share resources.
+  TfLiteStatus PackWeights(TfLiteContext* context, const float* filter,
+                           const float* bias, int output_channels,
+                           int filter_height, int filter_width,
+                           int input_channels, Operation* op) {
+    ModelResources* resources = ModelResources::GetFromContext(context);
+    if (resources == nullptr) {
+      PackConvFilter(filter, bias, output_channels, filter_height,
+                     filter_width, input_channels, &op->owned_packed_filter,
+                     &op->owned_packed_bias);
+      return kTfLiteOk;
+    }
+
+    const size_t bias_size = NumChannelBlocks(output_channels) * kChannelBlock;
+    const size_t filter_size =
+        bias_size * filter_height * filter_width * input_channels;
+    char derivation[96];
+    snprintf(derivation, sizeof(derivation), "cpu_delegate:%d:%d:%d:%d:%p",
+             output_channels, filter_height, filter_width, input_channels,
+             static_cast<const void*>(bias));
+    const void* weights = resources->GetOrCreate(
+        filter, derivation, (filter_size + bias_size) * sizeof(float),
+        [&](void* buffer) {
+          std::vector<float> packed_filter;
+          std::vector<float> packed_bias;
+          PackConvFilter(filter, bias, output_channels, filter_height,
+                         filter_width, input_channels, &packed_filter,
+                         &packed_bias);
+          float* packed = static_cast<float*>(buffer);
+          std::copy(packed_filter.begin(), packed_filter.end(), packed);
+          std::copy(packed_bias.begin(), packed_bias.end(),
+                    packed + filter_size);
+          return kTfLiteOk;
+        });
+    TF_LITE_ENSURE(context, weights != nullptr);
+    op->packed_filter = static_cast<const float*>(weights);
+    op->packed_bias = op->packed_filter + filter_size;
+    return kTfLiteOk;
+  }
+
+  // Computes the shapes of the operation from its input, and resizes its
+  // output accordingly.
+  TfLiteStatus PrepareOperation(TfLiteContext* context, Operation* op) {
+    const TfLiteTensor& input = context->tensors[op->input];
+    TfLiteTensor* output = &context->tensors[op->output];
+    TfLiteIntArray* output_size;
+
+    if (op->builtin_code == kTfLiteBuiltinFullyConnected) {
+      FullyConnectedParams& params = op->fully_connected_params;
+      const int input_elements = NumElements(&input);
+      TF_LITE_ENSURE_EQ(context, input_elements % params.input_size, 0);
+      params.batches = input_elements / params.input_size;
+      output_size = TfLiteIntArrayCreate(2);
+      output_size->data[0] = params.batches;
+      output_size->data[1] = params.num_units;
+      return context->ResizeTensor(context, output, output_size);
+    }
+
+    ConvParams& params = op->conv_params;
+    TF_LITE_ENSURE_EQ(context, NumDimensions(&input), 4);
+    params.batches = input.dims->data[0];
+    params.input_height = input.dims->data[1];
+    params.input_width = input.dims->data[2];
+    if (op->builtin_code == kTfLiteBuiltinConv2d) {
+      TF_LITE_ENSURE_EQ(context, input.dims->data[3], params.input_channels);
+    } else {
+      params.input_channels = input.dims->data[3];
+      TF_LITE_ENSURE_EQ(context,
+                        params.output_channels % params.input_channels, 0);
+      params.depth_multiplier = params.output_channels / params.input_channels;
+    }
+
+    const TfLitePaddingValues padding = ComputePaddingHeightWidth(
+        params.stride_height, params.stride_width, params.dilation_height,
+        params.dilation_width, params.input_height, params.input_width,
+        params.filter_height, params.filter_width, op->padding,
+        &params.output_height, &params.output_width);
+    params.pad_height = padding.height;
+    params.pad_width = padding.width;
+
+    output_size = TfLiteIntArrayCreate(4);
+    output_size->data[0] = params.batches;
+    output_size->data[1] = params.output_height;
+    output_size->data[2] = params.output_width;
+    output_size->data[3] = params.output_channels;
+    return context->ResizeTensor(context, output, output_size);
+  }
+
+  const TfLiteCpuDelegateOptions options_;
+  std::vector<Operation> operations_;
+  // Outputs of the operations that are not outputs of the partition.
+  std::vector<int> internal_tensors_;
+};
+
+TfLiteRegistration GetCpuKernelRegistration() {
+  TfLiteRegistration kernel_registration = {};
+  kernel_registration.builtin_code = kTfLiteBuiltinDelegate;
+  kernel_registration.custom_name = "TfLiteCpuDelegate";
+  kernel_registration.free = [](TfLiteContext* context, void* buffer) -> void {
+    delete reinterpret_cast<CpuDelegateKernel*>(buffer);
+  };
+  kernel_registration.init = [](TfLiteContext* context, const char* buffer,
+                                size_t length) -> void* {
+    const TfLiteDelegateParams* params =
+        reinterpret_cast<const TfLiteDelegateParams*>(buffer);
+    const auto* options =
+        reinterpret_cast<const TfLiteCpuDelegateOptions*>(
+            params->delegate->data_);
+    auto cpu_kernel = std::make_unique<CpuDelegateKernel>(*options);
+    if (cpu_kernel->Init(context, params) != kTfLiteOk) {
+      return nullptr;
+    }
+    return cpu_kernel.release();
+  };
+  kernel_registration.prepare = [](TfLiteContext* context,
+                                   TfLiteNode* node) -> TfLiteStatus {
+    if (node->user_data == nullptr) {
+      context->ReportError(context, "CPU delegate kernel was not initialized");
+      return kTfLiteError;
+    }
+    return reinterpret_cast<CpuDelegateKernel*>(node->user_data)
+        ->Prepare(context, node);
+  };
+  kernel_registration.invoke = [](TfLiteContext* context,
+                                  TfLiteNode* node) -> TfLiteStatus {
+    return reinterpret_cast<CpuDelegateKernel*>(node->user_data)
+        ->Invoke(context, node);
+  };
+  return kernel_registration;
+}
+
+TfLiteStatus DelegatePrepare(TfLiteContext* context, TfLiteDelegate* delegate) {
+  TfLiteIntArray* plan;
+  TF_LITE_ENSURE_STATUS(context->GetExecutionPlan(context, &plan));
+
+  std::vector<int> supported_nodes;
+  for (int node_index : TfLiteIntArrayView(plan)) {
+    TfLiteNode* node;
+    TfLiteRegistration* registration;
+    TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
+        context, node_index, &node, &registration));
+    if (IsNodeSupported(context, node, registration)) {
+      supported_nodes.push_back(node_index);
+    }
+  }
+  TFLITE_LOG_PROD(tflite::TFLITE_LOG_INFO,
+                  "CPU delegate: %d nodes delegated out of %d nodes.\n",
+                  static_cast<int>(supported_nodes.size()), plan->size);
+  if (supported_nodes.empty()) return kTfLiteOk;
+
+  TfLiteIntArray* nodes_to_replace =
+      ConvertVectorToTfLiteIntArray(supported_nodes);
+  const TfLiteStatus status = context->ReplaceNodeSubsetsWithDelegateKernels(
+      context, GetCpuKernelRegistration(), nodes_to_replace, delegate);
+  TfLiteIntArrayFree(nodes_to_replace);
+  return status;
+}
+
+class CpuDelegate : public TfLiteDelegate {
+ public:
+  explicit CpuDelegate(const TfLiteCpuDelegateOptions* options)
+      : options_(options != nullptr ? *options
+                                    : TfLiteCpuDelegateOptionsDefault()) {
+    data_ = &options_;
+    flags = kTfLiteDelegateFlagsNone;
+    Prepare = &DelegatePrepare;
+    CopyFromBufferHandle = nullptr;
+    CopyToBufferHandle = nullptr;
+    FreeBufferHandle = nullptr;
+  }
+
+ private:
+  TfLiteCpuDelegateOptions options_;
+};
+
+}  // namespace
+}  // namespace cpu
+}  // namespace delegates
+}  // namespace tflite
+
+TfLiteCpuDelegateOptions TfLiteCpuDelegateOptionsDefault() {
+  TfLiteCpuDelegateOptions options;
+  options.num_threads = -1;
+  return options;
+}
+
+TfLiteDelegate* TfLiteCpuDelegateCreate(
+    const TfLiteCpuDelegateOptions* options) {
+  return new tflite::delegates::cpu::CpuDelegate(options);
+}
+
+void TfLiteCpuDelegateDelete(TfLiteDelegate* delegate) {
+  delete static_cast<tflite::delegates::cpu::CpuDelegate*>(delegate);
+}
@@ -0,0 +1,70 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_DELEGATES_CPU_CPU_DELEGATE_H_
+#define TENSORFLOW_LITE_DELEGATES_CPU_CPU_DELEGATE_H_
+
+#include "tensorflow/lite/c/common.h"
+
+#ifdef SWIG
+#define TFL_CAPI_EXPORT
+#else
+#if defined(_WIN32)
+#ifdef TFL_COMPILE_LIBRARY
+#define TFL_CAPI_EXPORT __declspec(dllexport)
+#else
+#define TFL_CAPI_EXPORT __declspec(dllimport)
+#endif  // TFL_COMPILE_LIBRARY
+#else
+#define TFL_CAPI_EXPORT __attribute__((visibility("default")))
+#endif  // _WIN32
+#endif  // SWIG
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+typedef struct {
+  // Maximum number of threads used by the delegate kernels. Values <= 0 use
+  // the number of threads of the interpreter.
+  int num_threads;
+} TfLiteCpuDelegateOptions;
+
+// Populates TfLiteCpuDelegateOptions as follows:
+//   num_threads = -1
+TFL_CAPI_EXPORT TfLiteCpuDelegateOptions TfLiteCpuDelegateOptionsDefault();
+
+// Creates a new delegate instance that needs to be destroyed with
+// TfLiteCpuDelegateDelete when the delegate is no longer used by TFLite.
+//
+// The delegate takes over float32 CONV_2D, DEPTHWISE_CONV_2D and
+// FULLY_CONNECTED nodes with constant weights, and runs every partition of
+// consecutive supported nodes with NHWC microkernels. Filters are packed once
+// when the delegate is applied, activations are fused into the kernels and
+// the kernels are split over the threads of the interpreter. Unsupported
+// nodes keep running on the builtin kernels.
+//
+// When `options` is set to `nullptr`, then default options are used.
+TFL_CAPI_EXPORT TfLiteDelegate* TfLiteCpuDelegateCreate(
+    const TfLiteCpuDelegateOptions* options);
+
+// Destroys a delegate created with `TfLiteCpuDelegateCreate` call.
+TFL_CAPI_EXPORT void TfLiteCpuDelegateDelete(TfLiteDelegate* delegate);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif  // TENSORFLOW_LITE_DELEGATES_CPU_CPU_DELEGATE_H_
@@ -0,0 +1,201 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/delegates/cpu/cpu_delegate.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::FloatNear;
+using ::testing::Pointwise;
+
+std::vector<float> RandomVector(int size, std::mt19937* rng) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> values(size);
+  for (float& value : values) value = dist(*rng);
+  return values;
+}
+
+template <typename T>
+T* NewBuiltinData() {
+  // The interpreter releases builtin data with free().
+  return reinterpret_cast<T*>(calloc(1, sizeof(T)));
+}
+
+// Builds the graph
+//   input [2, 9, 9, 3]
+//   -> CONV_2D (16 x 3 x 3, SAME, stride 1, RELU)
+//   -> DEPTHWISE_CONV_2D (3 x 3, multiplier 2, VALID, stride 2, RELU6)
+//   -> `middle_op`
+//   -> FULLY_CONNECTED (10 units)
+// where `middle_op` is either nothing or a LOGISTIC node that the delegate
+// does not support, splitting the graph into two delegated partitions.
+class CpuDelegateTest : public ::testing::Test {
+ protected:
+  CpuDelegateTest() : rng_(42) {
+    input_ = RandomVector(2 * 9 * 9 * 3, &rng_);
+    conv_filter_ = RandomVector(16 * 3 * 3 * 3, &rng_);
+    conv_bias_ = RandomVector(16, &rng_);
+    depthwise_filter_ = RandomVector(3 * 3 * 32, &rng_);
+    depthwise_bias_ = RandomVector(32, &rng_);
+    fc_weights_ = RandomVector(10 * 4 * 4 * 32, &rng_);
+    fc_bias_ = RandomVector(10, &rng_);
+  }
+
+  std::unique_ptr<Interpreter> BuildInterpreter(bool with_logistic) {
+    ops::builtin::BuiltinOpResolver resolver;
+    auto interpreter = std::make_unique<Interpreter>();
+    interpreter->AddTensors(11);
+    interpreter->SetInputs({0});
+    interpreter->SetOutputs({9});
+
+    const TfLiteQuantizationParams quant = {};
+    interpreter->SetTensorParametersReadWrite(0, kTfLiteFloat32, "input",
+                                              {2, 9, 9, 3}, quant);
+    SetConstant(interpreter.get(), 1, {16, 3, 3, 3}, conv_filter_);
+    SetConstant(interpreter.get(), 2, {16}, conv_bias_);
+    interpreter->SetTensorParametersReadWrite(3, kTfLiteFloat32, "conv", {},
+                                              quant);
+    SetConstant(interpreter.get(), 4, {1, 3, 3, 32}, depthwise_filter_);
+    SetConstant(interpreter.get(), 5, {32}, depthwise_bias_);
+    interpreter->SetTensorParametersReadWrite(6, kTfLiteFloat32, "depthwise",
+                                              {}, quant);
+    SetConstant(interpreter.get(), 7, {10, 4 * 4 * 32}, fc_weights_);
+    SetConstant(interpreter.get(), 8, {10}, fc_bias_);
+    interpreter->SetTensorParametersReadWrite(9, kTfLiteFloat32, "output", {},
+                                              quant);
+    interpreter->SetTensorParametersReadWrite(10, kTfLiteFloat32, "logistic",
+                                              {}, quant);
+
+    auto* conv_params = NewBuiltinData<TfLiteConvParams>();
+    conv_params->padding = kTfLitePaddingSame;
+    conv_params->stride_width = 1;
+    conv_params->stride_height = 1;
+    conv_params->dilation_width_factor = 1;
+    conv_params->dilation_height_factor = 1;
+    conv_params->activation = kTfLiteActRelu;
+    interpreter->AddNodeWithParameters(
+        {0, 1, 2}, {3}, nullptr, 0, conv_params,
+        resolver.FindOp(BuiltinOperator_CONV_2D, 1));
+
+    auto* depthwise_params = NewBuiltinData<TfLiteDepthwiseConvParams>();
+    depthwise_params->padding = kTfLitePaddingValid;
+    depthwise_params->stride_width = 2;
+    depthwise_params->stride_height = 2;
+    depthwise_params->depth_multiplier = 2;
+    depthwise_params->dilation_width_factor = 1;
+    depthwise_params->dilation_height_factor = 1;
+    depthwise_params->activation = kTfLiteActRelu6;
+    interpreter->AddNodeWithParameters(
+        {3, 4, 5}, {6}, nullptr, 0, depthwise_params,
+        resolver.FindOp(BuiltinOperator_DEPTHWISE_CONV_2D, 1));
+
+    int fc_input = 6;
+    if (with_logistic) {
+      interpreter->AddNodeWithParameters(
+          {6}, {10}, nullptr, 0, nullptr,
+          resolver.FindOp(BuiltinOperator_LOGISTIC, 1));
+      fc_input = 10;
+    }
+
+    auto* fc_params = NewBuiltinData<TfLiteFullyConnectedParams>();
+    fc_params->activation = kTfLiteActNone;
+    fc_params->weights_format = kTfLiteFullyConnectedWeightsFormatDefault;
+    interpreter->AddNodeWithParameters(
+        {fc_input, 7, 8}, {9}, nullptr, 0, fc_params,
+        resolver.FindOp(BuiltinOperator_FULLY_CONNECTED, 1));
+    return interpreter;
+  }
+
+  std::vector<float> Run(Interpreter* interpreter) {
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    std::copy(input_.begin(), input_.end(),
+              interpreter->typed_input_tensor<float>(0));
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+    const float* output = interpreter->typed_output_tensor<float>(0);
+    return std::vector<float>(output, output + 2 * 10);
+  }
+
+  void ExpectSameAsBuiltinKernels(bool with_logistic, int num_threads,
+                                  int expected_nodes) {
+    auto reference = BuildInterpreter(with_logistic);
+    const std::vector<float> expected = Run(reference.get());
+
+    auto delegated = BuildInterpreter(with_logistic);
+    delegated->SetNumThreads(num_threads);
+    std::unique_ptr<TfLiteDelegate, decltype(&TfLiteCpuDelegateDelete)>
+        delegate(TfLiteCpuDelegateCreate(nullptr), TfLiteCpuDelegateDelete);
+    ASSERT_EQ(delegated->ModifyGraphWithDelegate(delegate.get()), kTfLiteOk);
+    EXPECT_EQ(static_cast<int>(delegated->execution_plan().size()),
+              expected_nodes);
+    EXPECT_THAT(Run(delegated.get()), Pointwise(FloatNear(1e-4), expected));
+  }
+
+ private:
+  void SetConstant(Interpreter* interpreter, int index,
+                   const std::vector<int>& dims,
+                   const std::vector<float>& values) {
+    interpreter->SetTensorParametersReadOnly(
+        index, kTfLiteFloat32, "", dims, TfLiteQuantizationParams(),
+        reinterpret_cast<const char*>(values.data()),
+        values.size() * sizeof(float));
+  }
+
+  std::mt19937 rng_;
+  std::vector<float> input_;
+  std::vector<float> conv_filter_;
+  std::vector<float> conv_bias_;
+  std::vector<float> depthwise_filter_;
+  std::vector<float> depthwise_bias_;
+  std::vector<float> fc_weights_;
+  std::vector<float> fc_bias_;
+};
+
+TEST_F(CpuDelegateTest, SinglePartition) {
+  // All three nodes run in one delegate node.
+  ExpectSameAsBuiltinKernels(/*with_logistic=*/false, /*num_threads=*/1,
+                             /*expected_nodes=*/1);
+}
+
+TEST_F(CpuDelegateTest, SinglePartitionMultiThreaded) {
+  ExpectSameAsBuiltinKernels(/*with_logistic=*/false, /*num_threads=*/4,
+                             /*expected_nodes=*/1);
+}
+
+TEST_F(CpuDelegateTest, UnsupportedNodeFallsBackToBuiltinKernel) {
+  // The convolutions and the fully connected layer run in two delegate nodes
+  // around the builtin LOGISTIC.
+  ExpectSameAsBuiltinKernels(/*with_logistic=*/true, /*num_threads=*/2,
+                             /*expected_nodes=*/3);
+}
+
+TEST(CpuDelegateOptionsTest, Default) {
+  EXPECT_EQ(TfLiteCpuDelegateOptionsDefault().num_threads, -1);
+}
+
+}  // namespace
+}  // namespace tflite
@@ -0,0 +1,249 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/delegates/cpu/float_kernels.h"
+
+#include <algorithm>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+
+namespace tflite {
+namespace delegates {
+namespace cpu {
+namespace {
+
+// Number of batches computed together by the fully connected microkernel, so
+// that every packed weight loaded is used for several rows.
+constexpr int kBatchBlock = 4;
+
+void PackBias(const float* bias, int channels, std::vector<float>* packed) {
+  packed->assign(NumChannelBlocks(channels) * kChannelBlock, 0.0f);
+  if (bias != nullptr) {
+    std::copy(bias, bias + channels, packed->begin());
+  }
+}
+
+// Stores the first `num_channels` accumulators, clamped to the activation
+// range.
+inline void StoreBlock(const float* acc, int num_channels, float act_min,
+                       float act_max, float* output) {
+  for (int j = 0; j < num_channels; ++j) {
+    output[j] = ActivationFunctionWithMinMax(acc[j], act_min, act_max);
+  }
+}
+
+}  // namespace
+
+void PackConvFilter(const float* filter, const float* bias,
+                    int output_channels, int filter_height, int filter_width,
+                    int input_channels, std::vector<float>* packed_filter,
+                    std::vector<float>* packed_bias) {
+  const int num_blocks = NumChannelBlocks(output_channels);
+  const int taps = filter_height * filter_width * input_channels;
+  packed_filter->assign(num_blocks * taps * kChannelBlock, 0.0f);
+  for (int oc = 0; oc < output_channels; ++oc) {
+    float* block = packed_filter->data() +
+                   (oc / kChannelBlock) * taps * kChannelBlock +
+                   oc % kChannelBlock;
+    const float* src = filter + oc * taps;
+    for (int i = 0; i < taps; ++i) {
+      block[i * kChannelBlock] = src[i];
+    }
+  }
+  PackBias(bias, output_channels, packed_bias);
+}
+
+void PackFullyConnectedWeights(const float* weights, const float* bias,
+                               int num_units, int input_size,
+                               std::vector<float>* packed_weights,
+                               std::vector<float>* packed_bias) {
+  // A fully connected layer is a 1x1 convolution over a single pixel.
+  PackConvFilter(weights, bias, num_units, 1, 1, input_size, packed_weights,
+                 packed_bias);
+}
+
+void ConvRows(const ConvParams& params, const float* input,
+              const float* packed_filter, const float* packed_bias,
+              int row_begin, int row_end, float* output) {
+  const int num_blocks = NumChannelBlocks(params.output_channels);
+  const int block_size = params.filter_height * params.filter_width *
+                         params.input_channels * kChannelBlock;
+  const int input_batch_size =
+      params.input_height * params.input_width * params.input_channels;
+
+  for (int row = row_begin; row < row_end; ++row) {
+    const int batch = row / params.output_height;
+    const int out_y = row % params.output_height;
+    const float* input_batch = input + batch * input_batch_size;
+    float* output_row =
+        output + row * params.output_width * params.output_channels;
+    const int in_y_origin = out_y * params.stride_height - params.pad_height;
+
+    for (int out_x = 0; out_x < params.output_width; ++out_x) {
+      const int in_x_origin = out_x * params.stride_width - params.pad_width;
+      float* output_pixel = output_row + out_x * params.output_channels;
+
+      for (int block = 0; block < num_blocks; ++block) {
+        float acc[kChannelBlock];
+        std::copy(packed_bias + block * kChannelBlock,
+                  packed_bias + (block + 1) * kChannelBlock, acc);
+        const float* filter_block = packed_filter + block * block_size;
+
+        for (int ky = 0; ky < params.filter_height; ++ky) {
+          const int in_y = in_y_origin + ky * params.dilation_height;
+          if (in_y < 0 || in_y >= params.input_height) continue;
+          for (int kx = 0; kx < params.filter_width; ++kx) {
+            const int in_x = in_x_origin + kx * params.dilation_width;
+            if (in_x < 0 || in_x >= params.input_width) continue;
+            const float* in =
+                input_batch + (in_y * params.input_width + in_x) *
+                                  params.input_channels;
+            const float* weights =
+                filter_block + (ky * params.filter_width + kx) *
+                                   params.input_channels * kChannelBlock;
+            for (int ic = 0; ic < params.input_channels; ++ic) {
+              const float value = in[ic];
+              for (int j = 0; j < kChannelBlock; ++j) {
+                acc[j] += value * weights[j];
+              }
+              weights += kChannelBlock;
+            }
+          }
+        }
+
+        const int channel = block * kChannelBlock;
+        const int num_channels =
+            std::min(kChannelBlock, params.output_channels - channel);
+        StoreBlock(acc, num_channels, params.activation_min,
+                   params.activation_max, output_pixel + channel);
+      }
+    }
+  }
+}
+
+void DepthwiseConvRows(const ConvParams& params, const float* input,
+                       const float* filter, const float* bias, int row_begin,
+                       int row_end, float* output) {
+  const int output_channels = params.output_channels;
+  const int depth_multiplier = params.depth_multiplier;
+  const int input_batch_size =
+      params.input_height * params.input_width * params.input_channels;
+
+  for (int row = row_begin; row < row_end; ++row) {
+    const int batch = row / params.output_height;
+    const int out_y = row % params.output_height;
+    const float* input_batch = input + batch * input_batch_size;
+    float* output_row = output + row * params.output_width * output_channels;
+    const int in_y_origin = out_y * params.stride_height - params.pad_height;
+
+    for (int out_x = 0; out_x < params.output_width; ++out_x) {
+      const int in_x_origin = out_x * params.stride_width - params.pad_width;
+      // Channels are contiguous in both the input and the filter, so the
+      // output pixel is accumulated in place, one filter tap at a time.
+      float* out = output_row + out_x * output_channels;
+      std::copy(bias, bias + output_channels, out);
+
+      for (int ky = 0; ky < params.filter_height; ++ky) {
+        const int in_y = in_y_origin + ky * params.dilation_height;
+        if (in_y < 0 || in_y >= params.input_height) continue;
+        for (int kx = 0; kx < params.filter_width; ++kx) {
+          const int in_x = in_x_origin + kx * params.dilation_width;
+          if (in_x < 0 || in_x >= params.input_width) continue;
+          const float* in = input_batch + (in_y * params.input_width + in_x) *
+                                              params.input_channels;
+          const float* weights =
+              filter + (ky * params.filter_width + kx) * output_channels;
+          if (depth_multiplier == 1) {
+            for (int c = 0; c < output_channels; ++c) {
+              out[c] += in[c] * weights[c];
+            }
+          } else {
+            for (int ic = 0; ic < params.input_channels; ++ic) {
+              const float value = in[ic];
+              const int oc = ic * depth_multiplier;
+              for (int m = 0; m < depth_multiplier; ++m) {
+                out[oc + m] += value * weights[oc + m];
+              }
+            }
+          }
+        }
+      }
+
+      for (int c = 0; c < output_channels; ++c) {
+        out[c] = ActivationFunctionWithMinMax(out[c], params.activation_min,
+                                              params.activation_max);
+      }
+    }
+  }
+}
+
+void FullyConnectedBlocks(const FullyConnectedParams& params,
+                          const float* input, const float* packed_weights,
+                          const float* packed_bias, int block_begin,
+                          int block_end, float* output) {
+  const int input_size = params.input_size;
+  const int block_size = input_size * kChannelBlock;
+
+  for (int block = block_begin; block < block_end; ++block) {
+    const float* weights_block = packed_weights + block * block_size;
+    const float* bias_block = packed_bias + block * kChannelBlock;
+    const int channel = block * kChannelBlock;
+    const int num_channels =
+        std::min(kChannelBlock, params.num_units - channel);
+
+    for (int batch = 0; batch < params.batches; batch += kBatchBlock) {
+      const int num_batches = std::min(kBatchBlock, params.batches - batch);
+      float acc[kBatchBlock][kChannelBlock];
+      for (int b = 0; b < kBatchBlock; ++b) {
+        std::copy(bias_block, bias_block + kChannelBlock, acc[b]);
+      }
+
+      if (num_batches == kBatchBlock) {
+        const float* in = input + batch * input_size;
+        const float* weights = weights_block;
+        for (int i = 0; i < input_size; ++i) {
+          for (int b = 0; b < kBatchBlock; ++b) {
+            const float value = in[b * input_size + i];
+            for (int j = 0; j < kChannelBlock; ++j) {
+              acc[b][j] += value * weights[j];
+            }
+          }
+          weights += kChannelBlock;
+        }
+      } else {
+        for (int b = 0; b < num_batches; ++b) {
+          const float* in = input + (batch + b) * input_size;
+          const float* weights = weights_block;
+          for (int i = 0; i < input_size; ++i) {
+            const float value = in[i];
+            for (int j = 0; j < kChannelBlock; ++j) {
+              acc[b][j] += value * weights[j];
+            }
+            weights += kChannelBlock;
+          }
+        }
+      }
+
+      for (int b = 0; b < num_batches; ++b) {
+        StoreBlock(acc[b], num_channels, params.activation_min,
+                   params.activation_max,
+                   output + (batch + b) * params.num_units + channel);
+      }
+    }
+  }
+}
+
+}  // namespace cpu
+}  // namespace delegates
+}  // namespace tflite
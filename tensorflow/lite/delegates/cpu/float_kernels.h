@@ -0,0 +1,110 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_DELEGATES_CPU_FLOAT_KERNELS_H_
+#define TENSORFLOW_LITE_DELEGATES_CPU_FLOAT_KERNELS_H_
+
+#include <vector>
+
+namespace tflite {
+namespace delegates {
+namespace cpu {
+
+// Number of output channels computed together by the convolution and fully
+// connected microkernels. Their filters are packed in blocks of this many
+// output channels, so that the innermost loop is over contiguous weights that
+// the compiler keeps in vector registers.
+constexpr int kChannelBlock = 8;
+
+// Returns the number of channel blocks needed for `channels` channels.
+inline int NumChannelBlocks(int channels) {
+  return (channels + kChannelBlock - 1) / kChannelBlock;
+}
+
+// Geometry and fused activation of a 2D convolution over NHWC tensors.
+struct ConvParams {
+  int batches;
+  int input_height;
+  int input_width;
+  int input_channels;
+  int filter_height;
+  int filter_width;
+  int output_height;
+  int output_width;
+  int output_channels;
+  int stride_height;
+  int stride_width;
+  int dilation_height;
+  int dilation_width;
+  // Padding before the first row and column of the input.
+  int pad_height;
+  int pad_width;
+  // Only used by depthwise convolutions.
+  int depth_multiplier;
+  float activation_min;
+  float activation_max;
+};
+
+// Shape and fused activation of a fully connected layer.
+struct FullyConnectedParams {
+  int batches;
+  int input_size;
+  int num_units;
+  float activation_min;
+  float activation_max;
+};
+
+// Packs a [output_channels, filter_height, filter_width, input_channels]
+// convolution filter into blocks of kChannelBlock output channels, each laid
+// out as [filter_height, filter_width, input_channels, kChannelBlock]. Channels
+// past `output_channels` in the last block are zero. `bias` may be null.
+void PackConvFilter(const float* filter, const float* bias,
+                    int output_channels, int filter_height, int filter_width,
+                    int input_channels, std::vector<float>* packed_filter,
+                    std::vector<float>* packed_bias);
+
+// Packs a [num_units, input_size] weights matrix into blocks of kChannelBlock
+// units, each laid out as [input_size, kChannelBlock]. `bias` may be null.
+void PackFullyConnectedWeights(const float* weights, const float* bias,
+                               int num_units, int input_size,
+                               std::vector<float>* packed_weights,
+                               std::vector<float>* packed_bias);
+
+// Computes the rows [row_begin, row_end) of the `batches * output_height`
+// output rows of a convolution with a filter packed by PackConvFilter.
+void ConvRows(const ConvParams& params, const float* input,
+              const float* packed_filter, const float* packed_bias,
+              int row_begin, int row_end, float* output);
+
+// Computes the rows [row_begin, row_end) of the `batches * output_height`
+// output rows of a depthwise convolution. `filter` has the TFLite layout
+// [1, filter_height, filter_width, output_channels] and `bias` holds
+// `output_channels` values.
+void DepthwiseConvRows(const ConvParams& params, const float* input,
+                       const float* filter, const float* bias, int row_begin,
+                       int row_end, float* output);
+
+// Computes the unit blocks [block_begin, block_end) of a fully connected layer
+// with weights packed by PackFullyConnectedWeights, for all batches.
+void FullyConnectedBlocks(const FullyConnectedParams& params,
+                          const float* input, const float* packed_weights,
+                          const float* packed_bias, int block_begin,
+                          int block_end, float* output);
+
+}  // namespace cpu
+}  // namespace delegates
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_DELEGATES_CPU_FLOAT_KERNELS_H_
@@ -75,9 +75,10 @@ class InferenceEnvironment {
       std::unique_ptr<InferenceBuilder>* builder) = 0;
 
   // Returns opaque binary blob that contains a collection of already compiled
-  // OpenCL kernels present in a cache. Returned data could be re-used later
-  // to speed up compilation time when new environment is created for the same
-  // set of models.
+  // OpenCL kernels present in a cache, and the work group sizes picked by
+  // tuning them. Returned data could be re-used later to speed up compilation
+  // and tuning time when new environment is created for the same set of
+  // models.
   // Returned data is valid only if used on the same device, otherwise it will
   // not be compatible and will be discarded.
   virtual std::vector<uint8_t> GetSerializedBinaryCache() const = 0;
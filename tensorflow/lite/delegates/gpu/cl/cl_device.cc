@@ -378,6 +378,10 @@ std::string CLDevice::GetPlatformVersion() const {
   return GetPlatformInfo(platform_id_, CL_PLATFORM_VERSION);
 }
 
+std::string CLDevice::GetDeviceName() const {
+  return GetDeviceInfo<std::string>(id_, CL_DEVICE_NAME);
+}
+
 bool CLDevice::IsAdreno() const { return info_.vendor == Vendor::QUALCOMM; }
 
 bool CLDevice::IsAdreno3xx() const {
@@ -103,6 +103,7 @@ class CLDevice {
   cl_device_id id() const { return id_; }
   cl_platform_id platform() const { return platform_id_; }
   std::string GetPlatformVersion() const;
+  std::string GetDeviceName() const;
 
   const DeviceInfo& GetInfo() const { return info_; }
   const DeviceInfo* GetInfoPtr() const { return &info_; }
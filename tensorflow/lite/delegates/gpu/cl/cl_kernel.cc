@@ -61,6 +61,7 @@ CLKernel::CLKernel(CLKernel&& kernel)
     : private_memory_size_(kernel.private_memory_size_),
       max_work_group_size_(kernel.max_work_group_size_),
       binding_counter_(kernel.binding_counter_),
+      fingerprint_(kernel.fingerprint_),
       function_name_(std::move(kernel.function_name_)),
       program_(kernel.program_),
       kernel_(kernel.kernel_) {
@@ -73,6 +74,7 @@ CLKernel& CLKernel::operator=(CLKernel&& kernel) {
     std::swap(private_memory_size_, kernel.private_memory_size_);
     std::swap(max_work_group_size_, kernel.max_work_group_size_);
     std::swap(binding_counter_, kernel.binding_counter_);
+    std::swap(fingerprint_, kernel.fingerprint_);
     function_name_ = std::move(kernel.function_name_);
     std::swap(program_, kernel.program_);
     std::swap(kernel_, kernel.kernel_);
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_DELEGATES_GPU_CL_CL_KERNEL_H_
 #define TENSORFLOW_LITE_DELEGATES_GPU_CL_CL_KERNEL_H_
 
+#include <cstdint>
 #include <string>
 
 #include "tensorflow/lite/delegates/gpu/cl/cl_context.h"
@@ -65,6 +66,10 @@ class CLKernel {
   int GetPrivateMemorySize() const { return private_memory_size_; }
   int GetMaxWorkGroupSize() const { return max_work_group_size_; }
 
+  // Identifies the code of the kernel, set by ProgramCache. 0 if unknown.
+  uint64_t GetFingerprint() const { return fingerprint_; }
+  void SetFingerprint(uint64_t fingerprint) { fingerprint_ = fingerprint; }
+
   void ResetBindingCounter() { binding_counter_ = 0; }
 
   // Do not use this function
@@ -79,6 +84,7 @@ class CLKernel {
   int private_memory_size_;
   int max_work_group_size_;
   int binding_counter_ = -1;
+  uint64_t fingerprint_ = 0;
 
   std::string function_name_;
   // reference to program from which kernel was created
@@ -225,6 +225,7 @@ Status InferenceContext::InitFromGraph(const CreateInferenceInfo& create_info,
   TuningParameters tuning_parameters;
   tuning_parameters.queue = env->profiling_queue();
   tuning_parameters.info = env->device().GetInfoPtr();
+  tuning_parameters.cache = env->program_cache();
   if (create_info.hints.Check(ModelHints::kFastTuning)) {
     tuning_parameters.tuning_type = TuningType::FAST;
   }
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/lite/delegates/gpu/cl/cl_command_queue.h"
 #include "tensorflow/lite/delegates/gpu/cl/cl_device.h"
+#include "tensorflow/lite/delegates/gpu/cl/program_cache.h"
 
 namespace tflite {
 namespace gpu {
@@ -29,6 +30,8 @@ struct TuningParameters {
   ProfilingCommandQueue* queue;
   const DeviceInfo* info;
   TuningType tuning_type = TuningType::EXHAUSTIVE;
+  // If set, tuning results are looked up in and added to the cache.
+  ProgramCache* cache = nullptr;
 };
 
 }  // namespace cl
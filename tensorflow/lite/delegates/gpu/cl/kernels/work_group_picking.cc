@@ -20,6 +20,7 @@ limitations under the License.
 #include <set>
 #include <vector>
 
+#include "tensorflow/lite/delegates/gpu/cl/program_cache.h"
 #include "tensorflow/lite/delegates/gpu/common/util.h"
 
 namespace tflite {
@@ -75,6 +76,29 @@ std::vector<int3> GenerateWorkGroupSizesXY128Linear(
   return work_groups;
 }
 
+// Same as ProfilingCommandQueue::GetBestWorkGroupIndex, but reuses the result
+// of a previous tuning of the kernel from params.cache.
+Status GetBestWorkGroupIndex(const TuningParameters& params,
+                             const CLKernel& kernel, const int3& grid,
+                             const std::vector<int3>& work_groups, int* index) {
+  const uint64_t key =
+      params.cache ? ProgramCache::GetTuningKey(kernel, grid, work_groups) : 0;
+  int3 tuned;
+  if (key != 0 && params.cache->FindTunedWorkGroup(key, &tuned)) {
+    auto it = std::find(work_groups.begin(), work_groups.end(), tuned);
+    if (it != work_groups.end()) {
+      *index = it - work_groups.begin();
+      return OkStatus();
+    }
+  }
+  RETURN_IF_ERROR(params.queue->GetBestWorkGroupIndex(
+      kernel, *params.info, grid, work_groups, index));
+  if (key != 0) {
+    params.cache->AddTunedWorkGroup(key, work_groups[*index]);
+  }
+  return OkStatus();
+}
+
 Status GetBestWorkGroupAlignedToGrid(const TuningParameters& params,
                                      const CLKernel& kernel, const int3& grid,
                                      int3* best_work_group) {
@@ -83,8 +107,8 @@ Status GetBestWorkGroupAlignedToGrid(const TuningParameters& params,
       grid, params.info->max_work_group_sizes, kernel.GetMaxWorkGroupSize(),
       &work_groups));
   int best_work_group_index;
-  RETURN_IF_ERROR(params.queue->GetBestWorkGroupIndex(
-      kernel, *params.info, grid, work_groups, &best_work_group_index));
+  RETURN_IF_ERROR(GetBestWorkGroupIndex(params, kernel, grid, work_groups,
+                                        &best_work_group_index));
   *best_work_group = work_groups[best_work_group_index];
   return OkStatus();
 }
@@ -209,8 +233,8 @@ Status GetBestWorkGroupXY128(const TuningParameters& params,
   std::vector<int3> work_groups = GenerateWorkGroupSizesXY128(
       grid, kernel.GetMaxWorkGroupSize(), z_alignment);
   int best_work_group_index;
-  RETURN_IF_ERROR(params.queue->GetBestWorkGroupIndex(
-      kernel, *params.info, grid, work_groups, &best_work_group_index));
+  RETURN_IF_ERROR(GetBestWorkGroupIndex(params, kernel, grid, work_groups,
+                                        &best_work_group_index));
   *best_work_group = work_groups[best_work_group_index];
   return OkStatus();
 }
@@ -222,8 +246,8 @@ Status GetBestWorkGroupXY128Linear(const TuningParameters& params,
   std::vector<int3> work_groups = GenerateWorkGroupSizesXY128Linear(
       grid, kernel.GetMaxWorkGroupSize(), z_alignment);
   int best_work_group_index;
-  RETURN_IF_ERROR(params.queue->GetBestWorkGroupIndex(
-      kernel, *params.info, grid, work_groups, &best_work_group_index));
+  RETURN_IF_ERROR(GetBestWorkGroupIndex(params, kernel, grid, work_groups,
+                                        &best_work_group_index));
   *best_work_group = work_groups[best_work_group_index];
   return OkStatus();
 }
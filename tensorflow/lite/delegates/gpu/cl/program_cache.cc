@@ -46,12 +46,14 @@ ProgramCache::ProgramDescriptor::ProgramDescriptor(uint64_t fingerprints)
 
 ProgramCache::ProgramCache(ProgramCache&& program_cache)
     : use_fingerprints_(program_cache.use_fingerprints_),
-      programs_(std::move(program_cache.programs_)) {}
+      programs_(std::move(program_cache.programs_)),
+      tuned_work_groups_(std::move(program_cache.tuned_work_groups_)) {}
 
 ProgramCache& ProgramCache::operator=(ProgramCache&& program_cache) {
   if (this != &program_cache) {
     use_fingerprints_ = program_cache.use_fingerprints_;
     programs_ = std::move(program_cache.programs_);
+    tuned_work_groups_ = std::move(program_cache.tuned_work_groups_);
   }
   return *this;
 }
@@ -62,15 +64,19 @@ Status ProgramCache::GetOrCreateCLKernel(
     const CLContext& context, const CLDevice& device, CLKernel* result) {
   const std::string options = CompilerOptionsToString(device, compiler_options);
   ProgramDescriptor desc{code, options, use_fingerprints_};
+  const uint64_t kernel_fingerprint =
+      desc.fingerprint + ::util::Fingerprint64(function_name);
   auto it = programs_.find(desc);
   if (it != programs_.end()) {
     RETURN_IF_ERROR(result->CreateFromProgram(it->second, function_name));
+    result->SetFingerprint(kernel_fingerprint);
     return OkStatus();
   }
 
   CLProgram program;
   RETURN_IF_ERROR(CreateCLProgram(code, options, context, device, &program));
   RETURN_IF_ERROR(result->CreateFromProgram(program, function_name));
+  result->SetFingerprint(kernel_fingerprint);
   programs_.insert(std::make_pair(std::move(desc), std::move(program)));
   return OkStatus();
 }
@@ -83,6 +89,39 @@ Status ProgramCache::GetOrCreateCLKernel(const std::string& code,
   return GetOrCreateCLKernel(code, function_name, {}, context, device, result);
 }
 
+uint64_t ProgramCache::GetTuningKey(const CLKernel& kernel, const int3& grid,
+                                    const std::vector<int3>& work_groups) {
+  if (kernel.GetFingerprint() == 0) {
+    return 0;
+  }
+  std::vector<int> values = {grid.x, grid.y, grid.z};
+  values.reserve(values.size() + work_groups.size() * 3);
+  for (const auto& work_group : work_groups) {
+    values.push_back(work_group.x);
+    values.push_back(work_group.y);
+    values.push_back(work_group.z);
+  }
+  const uint64_t key =
+      kernel.GetFingerprint() +
+      ::util::Fingerprint64(reinterpret_cast<const char*>(values.data()),
+                            values.size() * sizeof(int));
+  // 0 means no key.
+  return key == 0 ? 1 : key;
+}
+
+bool ProgramCache::FindTunedWorkGroup(uint64_t key, int3* work_group) const {
+  auto it = tuned_work_groups_.find(key);
+  if (it == tuned_work_groups_.end()) {
+    return false;
+  }
+  *work_group = it->second;
+  return true;
+}
+
+void ProgramCache::AddTunedWorkGroup(uint64_t key, const int3& work_group) {
+  tuned_work_groups_[key] = work_group;
+}
+
 Status ProgramCache::AddSerializedCache(
     const CLContext& context, const CLDevice& device,
     absl::Span<const uint8_t> serialized_cache) {
@@ -100,6 +139,12 @@ Status ProgramCache::AddSerializedCache(
     return InvalidArgumentError(
         "OpenCL driver changed, cache invalid, should be regenerated");
   }
+  // Caches from older versions have no device name.
+  if (model->device_name() &&
+      device.GetDeviceName() != model->device_name()->str()) {
+    return InvalidArgumentError(
+        "OpenCL device changed, cache invalid, should be regenerated");
+  }
 
   use_fingerprints_ = true;
 
@@ -116,6 +161,15 @@ Status ProgramCache::AddSerializedCache(
       programs_.insert(std::make_pair(std::move(desc), std::move(program)));
     }
   }
+  if (model->tuned_work_groups()) {
+    for (auto tuned : *model->tuned_work_groups()) {
+      if (!tuned->work_group()) continue;
+      tuned_work_groups_.insert(
+          {tuned->key(), int3(tuned->work_group()->x(),
+                              tuned->work_group()->y(),
+                              tuned->work_group()->z())});
+    }
+  }
   return OkStatus();
 }
 
@@ -132,11 +186,22 @@ Status ProgramCache::GetSerializedCache(
     program_builder.add_binary(binary_offset);
     serialized_programs.push_back(program_builder.Finish());
   }
+  std::vector<flatbuffers::Offset<data::TunedWorkGroup>> serialized_tuning;
+  for (auto& tuned : tuned_work_groups_) {
+    const data::WorkGroup work_group(tuned.second.x, tuned.second.y,
+                                     tuned.second.z);
+    serialized_tuning.push_back(
+        data::CreateTunedWorkGroup(builder, tuned.first, &work_group));
+  }
   auto driver_version = builder.CreateString(device.GetPlatformVersion());
+  auto device_name = builder.CreateString(device.GetDeviceName());
   auto programs_s = builder.CreateVector(serialized_programs);
+  auto tuning_s = builder.CreateVector(serialized_tuning);
   data::CompiledCacheBuilder cache_builder(builder);
   cache_builder.add_driver_version(driver_version);
   cache_builder.add_programs(programs_s);
+  cache_builder.add_device_name(device_name);
+  cache_builder.add_tuned_work_groups(tuning_s);
   data::FinishCompiledCacheBuffer(builder, cache_builder.Finish());
   size_t next_element = serialized_cache->size();
   serialized_cache->resize(serialized_cache->size() + builder.GetSize());
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/lite/delegates/gpu/cl/cl_kernel.h"
 #include "tensorflow/lite/delegates/gpu/cl/cl_program.h"
 #include "tensorflow/lite/delegates/gpu/common/status.h"
+#include "tensorflow/lite/delegates/gpu/common/types.h"
 
 namespace tflite {
 namespace gpu {
@@ -51,6 +52,17 @@ class ProgramCache {
                              const CLContext& context, const CLDevice& device,
                              CLKernel* result);
 
+  // Work groups picked by tuning kernels, so that a kernel that was already
+  // tuned, in this process or in the one that serialized the cache, is not
+  // profiled again.
+  // Returns 0 if the kernel doesn't come from a ProgramCache.
+  static uint64_t GetTuningKey(const CLKernel& kernel, const int3& grid,
+                               const std::vector<int3>& work_groups);
+  bool FindTunedWorkGroup(uint64_t key, int3* work_group) const;
+  void AddTunedWorkGroup(uint64_t key, const int3& work_group);
+
+  // The serialized cache holds the compiled programs and the tuned work
+  // groups. It is valid for the device and driver that produced it only.
   Status AddSerializedCache(const CLContext& context, const CLDevice& device,
                             absl::Span<const uint8_t> serialized_cache);
   Status GetSerializedCache(const CLDevice& device,
@@ -95,6 +107,7 @@ class ProgramCache {
   std::unordered_map<ProgramDescriptor, CLProgram, ProgramDescriptorHasher,
                      ProgramDescriptorEqual>
       programs_;
+  std::unordered_map<uint64_t, int3> tuned_work_groups_;
 };
 
 }  // namespace cl
@@ -164,12 +164,29 @@ class Delegate {
 
   TfLiteDelegate* tflite_delegate() { return &delegate_; }
 
+  Status GetSerializedCache(const uint8_t** data, size_t* size) {
+    if (!cl_environment_) {
+      return UnavailableError("The delegate doesn't run on OpenCL.");
+    }
+    serialized_cache_ = cl_environment_->GetSerializedBinaryCache();
+    if (serialized_cache_.empty()) {
+      return InternalError("Failed to serialize the OpenCL cache.");
+    }
+    *data = serialized_cache_.data();
+    *size = serialized_cache_.size();
+    return OkStatus();
+  }
+
  private:
   Status InitializeOpenClApi(GraphFloat32* graph,
                              std::unique_ptr<InferenceBuilder>* builder,
                              bool* graph_is_destroyed) {
     *graph_is_destroyed = false;
     cl::InferenceEnvironmentOptions env_options;
+    if (options_.serialized_cache) {
+      env_options.serialized_binary_cache = absl::MakeConstSpan(
+          options_.serialized_cache, options_.serialized_cache_size);
+    }
     cl::InferenceEnvironmentProperties properties;
     RETURN_IF_ERROR(cl::NewInferenceEnvironment(env_options, &cl_environment_,
                                                 &properties));
@@ -230,6 +247,7 @@ class Delegate {
   std::unique_ptr<InferenceRunner> runner_;
   std::vector<int64_t> input_indices_;
   std::vector<int64_t> output_indices_;
+  std::vector<uint8_t> serialized_cache_;
 };
 
 inline Delegate* GetDelegate(TfLiteNode* node) {
@@ -307,6 +325,8 @@ TfLiteGpuDelegateOptionsV2 TfLiteGpuDelegateOptionsV2Default() {
   options.inference_priority1 = TFLITE_GPU_INFERENCE_PRIORITY_MAX_PRECISION;
   options.inference_priority2 = TFLITE_GPU_INFERENCE_PRIORITY_AUTO;
   options.inference_priority3 = TFLITE_GPU_INFERENCE_PRIORITY_AUTO;
+  options.serialized_cache = nullptr;
+  options.serialized_cache_size = 0;
   return options;
 }
 
@@ -321,3 +341,16 @@ TfLiteDelegate* TfLiteGpuDelegateV2Create(
 void TfLiteGpuDelegateV2Delete(TfLiteDelegate* delegate) {
   delete tflite::gpu::GetDelegate(delegate);
 }
+
+TfLiteStatus TfLiteGpuDelegateV2GetSerializedCache(TfLiteDelegate* delegate,
+                                                   const uint8_t** data,
+                                                   size_t* size) {
+  const auto status =
+      tflite::gpu::GetDelegate(delegate)->GetSerializedCache(data, size);
+  if (!status.ok()) {
+    TFLITE_LOG_PROD(tflite::TFLITE_LOG_WARNING, "%s",
+                    status.error_message().c_str());
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_DELEGATES_GPU_DELEGATE_H_
 #define TENSORFLOW_LITE_DELEGATES_GPU_DELEGATE_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "tensorflow/lite/c/common.h"
@@ -95,6 +96,14 @@ typedef struct {
   int32_t inference_priority1;
   int32_t inference_priority2;
   int32_t inference_priority3;
+
+  // Data returned by TfLiteGpuDelegateV2GetSerializedCache, from an earlier
+  // run on the same device. It holds the compiled OpenCL programs and the work
+  // group sizes picked by tuning, so that they are not computed again. Data
+  // from another device or driver version is ignored. Must stay valid until
+  // the delegate is applied to the interpreter.
+  const uint8_t* serialized_cache;
+  size_t serialized_cache_size;
 } TfLiteGpuDelegateOptionsV2;
 
 // Populates TfLiteGpuDelegateOptionsV2 as follows:
@@ -103,6 +112,8 @@ typedef struct {
 //   priority1 = TFLITE_GPU_INFERENCE_PRIORITY_MAX_PRECISION
 //   priority2 = TFLITE_GPU_INFERENCE_PRIORITY_AUTO
 //   priority3 = TFLITE_GPU_INFERENCE_PRIORITY_AUTO
+//   serialized_cache = nullptr
+//   serialized_cache_size = 0
 TFL_CAPI_EXPORT TfLiteGpuDelegateOptionsV2 TfLiteGpuDelegateOptionsV2Default();
 
 // Creates a new delegate instance that need to be destroyed with
@@ -118,6 +129,15 @@ TFL_CAPI_EXPORT TfLiteDelegate* TfLiteGpuDelegateV2Create(
 // Destroys a delegate created with `TfLiteGpuDelegateV2Create` call.
 TFL_CAPI_EXPORT void TfLiteGpuDelegateV2Delete(TfLiteDelegate* delegate);
 
+// Serializes the OpenCL programs compiled by the delegate and the results of
+// tuning them, to be passed as `serialized_cache` to delegates created later on
+// the same device, e.g. on the next start of the application. Call it after the
+// delegate is applied to an interpreter. `*data` stays valid until the next
+// call or until the delegate is destroyed.
+// Returns kTfLiteError if the delegate doesn't run on OpenCL.
+TFL_CAPI_EXPORT TfLiteStatus TfLiteGpuDelegateV2GetSerializedCache(
+    TfLiteDelegate* delegate, const uint8_t** data, size_t* size);
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
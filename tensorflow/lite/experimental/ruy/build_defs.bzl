@@ -22,13 +22,22 @@ def ruy_copts_base():
 
 # Used for targets that are compiled with extra features that are skipped at runtime if unavailable.
 def ruy_copts_skylake():
-    return []
+    return select({
+        "//tensorflow:linux_x86_64": [
+            "-mavx512f",
+            "-mavx512dq",
+            "-mavx512cd",
+            "-mavx512bw",
+            "-mavx512vl",
+        ],
+        "//conditions:default": [],
+    })
 
 # Used for targets that are compiled with extra features that are skipped at runtime if unavailable.
 def ruy_copts_avx2():
     return []
 
-# TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
+# TODO(b/147376783): SSE 4.2 support is incomplete / placeholder.
 # Optimization is not finished. In particular the dimensions of the kernel
 # blocks can be changed as desired.
 #
@@ -36,10 +45,10 @@ def ruy_copts_avx2():
 def ruy_copts_sse42():
     return []
 
-# TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
-# Optimization is not finished. In particular the dimensions of the kernel
-# blocks can be changed as desired.
-#
 # Used for targets that are compiled with extra features that are skipped at runtime if unavailable.
+# The AVX-VNNI path extends the AVX-512 path, so this includes the Skylake options.
 def ruy_copts_avxvnni():
-    return []
+    return ruy_copts_skylake() + select({
+        "//tensorflow:linux_x86_64": ["-mavx512vnni"],
+        "//conditions:default": [],
+    })
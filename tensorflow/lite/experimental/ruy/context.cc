@@ -59,8 +59,8 @@ Path Context::GetRuntimeEnabledPaths() {
 #endif  // RUY_PLATFORM(ARM)
 
 #if RUY_PLATFORM(X86)
-  // TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete /
-  // placeholder. Optimization is not finished. In particular the dimensions of
+  // TODO(b/147376783): SSE 4.2 support is incomplete / placeholder.
+  // Optimization is not finished. In particular the dimensions of
   // the kernel blocks can be changed as desired.
   //
   if ((runtime_enabled_paths_ & Path::kSse42) != Path::kNone) {
@@ -87,12 +87,11 @@ Path Context::GetRuntimeEnabledPaths() {
     }
   }
 
-  // TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete /
-  // placeholder. Optimization is not finished. In particular the dimensions of
-  // the kernel blocks can be changed as desired.
-  //
+  // kAvxVnni falls back to the kAvx512 kernels for float, so it also requires
+  // the kAvx512 path to have been built.
   if ((runtime_enabled_paths_ & Path::kAvxVnni) != Path::kNone) {
-    if (!(HaveBuiltPathForAvxVnni() && DetectCpuAvxVnni())) {
+    if (!(HaveBuiltPathForAvxVnni() && HaveBuiltPathForAvx512() &&
+          DetectCpuAvxVnni())) {
       runtime_enabled_paths_ = runtime_enabled_paths_ & ~Path::kAvxVnni;
       // Sanity check.
       RUY_DCHECK((runtime_enabled_paths_ & Path::kAvxVnni) == Path::kNone);
@@ -97,5 +97,15 @@ bool DetectCpuAvx512() {
   return (abcd[1] & kEbxAvx512Mask) == kEbxAvx512Mask;
 }
 
+bool DetectCpuAvxVnni() {
+  constexpr std::uint32_t kEcxAvx512Vnni = 1u << 11;
+
+  std::uint32_t abcd[4];
+  RunCpuid(7, 0, abcd);
+  const bool has_vnni = (abcd[2] & kEcxAvx512Vnni) == kEcxAvx512Vnni;
+
+  return has_vnni && DetectCpuAvx512();
+}
+
 #endif
 }  // namespace ruy
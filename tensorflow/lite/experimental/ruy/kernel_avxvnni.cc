@@ -35,29 +35,32 @@ void Kernel8bitAvxVnni(const KernelParams8bit<16, 16>& params) {
   RUY_DCHECK(false);
 }
 
-void KernelFloatAvxVnni(const KernelParamsFloat<16, 16>& params) {
+void Kernel8bitAvxVnniSingleCol(const KernelParams8bit<16, 16>& params) {
   // CPU-ID-based checks should disable the path that would reach this point.
   RUY_DCHECK(false);
 }
 
 #else  // RUY_PLATFORM(AVX_VNNI) && RUY_OPT_ENABLED(RUY_OPT_ASM)
 
-static constexpr int kAvxFloatBlockSize = 16;
-static constexpr int kAvx8bitBlockSize = 16;
-static constexpr int kAvx8bitInnerSize = 4;
-
-// TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
-// Optimization is not finished. In particular the dimensions of the kernel
-// blocks can be changed as desired.
-//
-// When removing this comment, update profiling label below.
+// Same as the kAvx512 8-bit kernels, on the same packed layout, except that
+// each pair of 16-bit multiply-adds and 32-bit accumulation is a single
+// VPDPWSSD instruction.
 void Kernel8bitAvxVnni(const KernelParams8bit<16, 16>& params) {
-  profiler::ScopeLabel label("Kernel kAvxVnni 8-bit (UNFINISHED)");
+  profiler::ScopeLabel label("Kernel kAvxVnni 8-bit");
 
-  std::int32_t accum_data[kAvx8bitBlockSize][kAvx8bitBlockSize];
+  std::int32_t dst_stride;
+  if ((params.dst_type_id == DstTypeId<std::int8_t>::kValue) ||
+      (params.dst_type_id == DstTypeId<std::uint8_t>::kValue)) {
+    dst_stride = params.dst_stride;
+  } else if (params.dst_type_id == DstTypeId<std::int16_t>::kValue) {
+    dst_stride = params.dst_stride / sizeof(std::int16_t);
+  } else if (params.dst_type_id == DstTypeId<std::int32_t>::kValue) {
+    dst_stride = params.dst_stride / sizeof(std::int32_t);
+  } else {
+    RUY_DCHECK(false);
+  }
 
-  int bias_ptr_block_increment =
-      params.flags & RUY_ASM_FLAG_HAS_BIAS ? kAvx8bitBlockSize : 0;
+  int bias_ptr_block_increment = params.flags & RUY_ASM_FLAG_HAS_BIAS ? 16 : 0;
 
   const std::int8_t* rhs_col_ptr = params.rhs_base_ptr;
   void* dst_col_ptr = params.dst_base_ptr;
@@ -66,369 +69,1204 @@ void Kernel8bitAvxVnni(const KernelParams8bit<16, 16>& params) {
     bias_col_ptr += params.start_row;
   }
 
-  for (int col = params.start_col; col <= params.last_col;
-       col += kAvx8bitBlockSize) {
+  for (int col = params.start_col; col <= params.last_col; col += 16) {
     const std::int8_t* lhs_col_ptr = params.lhs_base_ptr;
     void* dst_ptr = dst_col_ptr;
     const std::int32_t* bias_ptr = bias_col_ptr;
 
-    for (int row = params.start_row; row <= params.last_row;
-         row += kAvx8bitBlockSize) {
-      const int residual_rows =
-          std::min(params.dst_rows - row, kAvx8bitBlockSize);
-      const int residual_cols =
-          std::min(params.dst_cols - col, kAvx8bitBlockSize);
+    const std::int32_t lhs_zero_point = params.lhs_zero_point;
+    const bool has_rhs_sums_offsets =
+        (params.flags & RUY_ASM_FLAG_HAS_RHS_SUMS) && lhs_zero_point;
+    std::int32_t rhs_sums_offsets[16];
+    if (has_rhs_sums_offsets) {
+      const __m512i rhs_sums_offset_v =
+          _mm512_mullo_epi32(_mm512_set1_epi32(lhs_zero_point),
+                             _mm512_loadu_epi32(&params.rhs_sums[col]));
+      _mm512_storeu_si512(reinterpret_cast<__m512i*>(rhs_sums_offsets),
+                          rhs_sums_offset_v);
+    }
+
+    for (int row = params.start_row; row <= params.last_row; row += 16) {
+      const int residual_rows = std::min(params.dst_rows - row, 16);
+      const int residual_cols = std::min(params.dst_cols - col, 16);
+
+      __m512i accum_data_v0;
+      __m512i accum_data_v1;
+      __m512i accum_data_v2;
+      __m512i accum_data_v3;
+      __m512i accum_data_v4;
+      __m512i accum_data_v5;
+      __m512i accum_data_v6;
+      __m512i accum_data_v7;
+      __m512i accum_data_v8;
+      __m512i accum_data_v9;
+      __m512i accum_data_va;
+      __m512i accum_data_vb;
+      __m512i accum_data_vc;
+      __m512i accum_data_vd;
+      __m512i accum_data_ve;
+      __m512i accum_data_vf;
 
       // Initialize with bias.
-      std::int32_t initial_accum_data[kAvx8bitBlockSize];
-      for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-        initial_accum_data[i] = 0;
+      const __mmask16 row_mask =
+          (static_cast<std::uint32_t>(1) << residual_rows) - 1;
+      __m512i initial_accum_data = _mm512_maskz_loadu_epi32(row_mask, bias_ptr);
+      bias_ptr += bias_ptr_block_increment;
+
+      const std::int32_t rhs_zero_point = params.rhs_zero_point;
+      if ((params.flags & RUY_ASM_FLAG_HAS_LHS_SUMS) && rhs_zero_point) {
+        const __m512i lhs_sums_offset =
+            _mm512_mullo_epi32(_mm512_set1_epi32(rhs_zero_point),
+                               _mm512_loadu_epi32(&params.lhs_sums[row]));
+        initial_accum_data =
+            _mm512_sub_epi32(initial_accum_data, lhs_sums_offset);
       }
-      for (int i = 0; i < residual_rows; ++i) {
-        initial_accum_data[i] = bias_ptr[i];
+
+      const std::int32_t prod_zp_depth = params.prod_zp_depth;
+      if (prod_zp_depth != 0) {
+        initial_accum_data = _mm512_add_epi32(initial_accum_data,
+                                              _mm512_set1_epi32(prod_zp_depth));
       }
 
-      for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-        for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-          accum_data[j][i] = initial_accum_data[i];
-        }
+      // Adjustments differing across columns.
+      if (has_rhs_sums_offsets) {
+        accum_data_v0 = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[0]));
+        accum_data_v1 = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[1]));
+        accum_data_v2 = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[2]));
+        accum_data_v3 = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[3]));
+        accum_data_v4 = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[4]));
+        accum_data_v5 = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[5]));
+        accum_data_v6 = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[6]));
+        accum_data_v7 = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[7]));
+        accum_data_v8 = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[8]));
+        accum_data_v9 = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[9]));
+        accum_data_va = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[10]));
+        accum_data_vb = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[11]));
+        accum_data_vc = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[12]));
+        accum_data_vd = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[13]));
+        accum_data_ve = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[14]));
+        accum_data_vf = _mm512_sub_epi32(
+            initial_accum_data, _mm512_set1_epi32(rhs_sums_offsets[15]));
+      } else {
+        accum_data_v0 = initial_accum_data;
+        accum_data_v1 = initial_accum_data;
+        accum_data_v2 = initial_accum_data;
+        accum_data_v3 = initial_accum_data;
+        accum_data_v4 = initial_accum_data;
+        accum_data_v5 = initial_accum_data;
+        accum_data_v6 = initial_accum_data;
+        accum_data_v7 = initial_accum_data;
+        accum_data_v8 = initial_accum_data;
+        accum_data_v9 = initial_accum_data;
+        accum_data_va = initial_accum_data;
+        accum_data_vb = initial_accum_data;
+        accum_data_vc = initial_accum_data;
+        accum_data_vd = initial_accum_data;
+        accum_data_ve = initial_accum_data;
+        accum_data_vf = initial_accum_data;
       }
-      bias_ptr += bias_ptr_block_increment;
 
-      std::int8_t lhs_data[kAvx8bitBlockSize][kAvx8bitInnerSize];
-      std::int8_t rhs_data[kAvx8bitBlockSize][kAvx8bitInnerSize];
       const std::int8_t* lhs_ptr = lhs_col_ptr;
       const std::int8_t* rhs_ptr = rhs_col_ptr;
-      for (int d = 0; d < params.depth; d += kAvx8bitInnerSize) {
-        for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-          for (int x = 0; x < kAvx8bitInnerSize; ++x) {
-            lhs_data[i][x] = lhs_ptr[i * kAvx8bitInnerSize + x];
-            rhs_data[i][x] = rhs_ptr[i * kAvx8bitInnerSize + x];
-          }
+      for (int d = 0; d < params.depth; d += 4) {
+        const __m512i lhs_data = _mm512_loadu_epi8(lhs_ptr);
+        __m512i rhs_data_8bit = _mm512_loadu_epi8(rhs_ptr);
+
+        // Each "int32" is two 16-bit RHS values, sign extended from 8-bit.
+        std::int32_t rhs_data[32];
+        const __m256i rhs_data_bottom_lane =
+            _mm512_castsi512_si256(rhs_data_8bit);
+        const __m256i rhs_data_top_lane =
+            _mm512_extracti32x8_epi32(rhs_data_8bit, 1);
+        const __m512i rhs_16_bit_dup_low =
+            _mm512_cvtepi8_epi16(rhs_data_bottom_lane);
+        const __m512i rhs_16_bit_dup_high =
+            _mm512_cvtepi8_epi16(rhs_data_top_lane);
+        // Now that we have cast the RHS data, we store it so that each value
+        // can be separately loaded in the accumulation loop.
+        _mm512_storeu_si512(reinterpret_cast<__m256i*>(rhs_data),
+                            rhs_16_bit_dup_low);
+        _mm512_storeu_si512(reinterpret_cast<__m256i*>(rhs_data + 16),
+                            rhs_16_bit_dup_high);
+
+        // Take bytes 0, 1, 4, 5, 8, 9, ... and expand to 16-bit.
+        const __m512i lhs_16_bit_low =
+            _mm512_cvtepi8_epi16(_mm512_cvtepi32_epi16(lhs_data));
+        // Take bytes 2, 3, 6, 7, 10, 11, ... and expand to 16-bit.
+        const __m512i lhs_16_bit_high = _mm512_cvtepi8_epi16(
+            _mm512_cvtepi32_epi16(_mm512_srli_epi32(lhs_data, 16)));
+
+        // Process column 0.
+        {
+          __m512i accum_v = accum_data_v0;
+          constexpr int index = 0;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_v0 = accum_v;
         }
+        // Process column 1.
+        {
+          __m512i accum_v = accum_data_v1;
+          constexpr int index = 2;
 
-        for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-          for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-            for (int x = 0; x < kAvx8bitInnerSize; ++x) {
-              accum_data[j][i] += lhs_data[i][x] * rhs_data[j][x];
-            }
-          }
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_v1 = accum_v;
         }
+        // Process column 2.
+        {
+          __m512i accum_v = accum_data_v2;
+          constexpr int index = 4;
 
-        lhs_ptr += kAvx8bitBlockSize * kAvx8bitInnerSize;
-        rhs_ptr += kAvx8bitBlockSize * kAvx8bitInnerSize;
-      }
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
 
-      if ((params.flags & RUY_ASM_FLAG_HAS_LHS_SUMS) && params.rhs_zero_point) {
-        for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-          for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-            accum_data[j][i] -=
-                params.rhs_zero_point * params.lhs_sums[row + i];
-          }
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_v2 = accum_v;
         }
-      }
-      if ((params.flags & RUY_ASM_FLAG_HAS_RHS_SUMS) && params.lhs_zero_point) {
-        for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-          for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-            accum_data[j][i] -=
-                params.lhs_zero_point * params.rhs_sums[col + j];
-          }
+        // Process column 3.
+        {
+          __m512i accum_v = accum_data_v3;
+          constexpr int index = 6;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_v3 = accum_v;
         }
-      }
-      if (params.lhs_zero_point && params.rhs_zero_point) {
-        for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-          for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-            accum_data[j][i] += params.prod_zp_depth;
-          }
+        // Process column 4.
+        {
+          __m512i accum_v = accum_data_v4;
+          constexpr int index = 8;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_v4 = accum_v;
         }
+        // Process column 5.
+        {
+          __m512i accum_v = accum_data_v5;
+          constexpr int index = 10;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_v5 = accum_v;
+        }
+        // Process column 6.
+        {
+          __m512i accum_v = accum_data_v6;
+          constexpr int index = 12;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_v6 = accum_v;
+        }
+        // Process column 7.
+        {
+          __m512i accum_v = accum_data_v7;
+          constexpr int index = 14;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_v7 = accum_v;
+        }
+        // Process column 8.
+        {
+          __m512i accum_v = accum_data_v8;
+          constexpr int index = 16;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_v8 = accum_v;
+        }
+        // Process column 9.
+        {
+          __m512i accum_v = accum_data_v9;
+          constexpr int index = 18;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_v9 = accum_v;
+        }
+        // Process column 10.
+        {
+          __m512i accum_v = accum_data_va;
+          constexpr int index = 20;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_va = accum_v;
+        }
+        // Process column 11.
+        {
+          __m512i accum_v = accum_data_vb;
+          constexpr int index = 22;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_vb = accum_v;
+        }
+        // Process column 12.
+        {
+          __m512i accum_v = accum_data_vc;
+          constexpr int index = 24;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_vc = accum_v;
+        }
+        // Process column 13.
+        {
+          __m512i accum_v = accum_data_vd;
+          constexpr int index = 26;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_vd = accum_v;
+        }
+        // Process column 14.
+        {
+          __m512i accum_v = accum_data_ve;
+          constexpr int index = 28;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_ve = accum_v;
+        }
+        // Process column 15.
+        {
+          __m512i accum_v = accum_data_vf;
+          constexpr int index = 30;
+
+          const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+          const __m512i rhs_16_bit_dup_high =
+              _mm512_set1_epi32(rhs_data[index + 1]);
+
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low,
+                                        rhs_16_bit_dup_low);
+          accum_v = _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high,
+                                        rhs_16_bit_dup_high);
+          accum_data_vf = accum_v;
+        }
+
+        lhs_ptr += 16 * 4;
+        rhs_ptr += 16 * 4;
       }
 
       if (params.dst_type_id != DstTypeId<std::int32_t>::kValue) {
-        std::int32_t m_vector[kAvx8bitBlockSize];
-        std::int32_t e_vector[kAvx8bitBlockSize];
+        __m512i m_vector;
+        __m512i e_vector;
         // Does not make use of RUY_ASM_FLAG_NEEDS_LEFT_SHIFT.
         if (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) {
-          int i = 0;
-          for (; i < residual_rows; ++i) {
-            m_vector[i] = params.multiplier_fixedpoint[row + i];
-            e_vector[i] = params.multiplier_exponent[row + i];
-          }
-          for (; i < kAvx8bitBlockSize; ++i) {
-            m_vector[i] = m_vector[0];
-            e_vector[i] = e_vector[0];
-          }
+          m_vector = _mm512_maskz_loadu_epi32(
+              row_mask, &params.multiplier_fixedpoint[row]);
+          e_vector = _mm512_maskz_loadu_epi32(row_mask,
+                                              &params.multiplier_exponent[row]);
         } else {
           // These arrays have size LhsCols, and are pre-filled.
-          for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-            m_vector[i] = params.multiplier_fixedpoint[i];
-            e_vector[i] = params.multiplier_exponent[i];
-          }
+          m_vector = _mm512_set1_epi32(params.multiplier_fixedpoint[0]);
+          e_vector = _mm512_set1_epi32(params.multiplier_exponent[0]);
         }
 
-        for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-          for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-            accum_data[j][i] = MultiplyByQuantizedMultiplier(
-                accum_data[j][i], m_vector[i], e_vector[i]);
-          }
+        const __m512i m_64bit_low =
+            _mm512_cvtepi32_epi64(_mm512_extracti32x8_epi32(m_vector, 0));
+        const __m512i m_64bit_high =
+            _mm512_cvtepi32_epi64(_mm512_extracti32x8_epi32(m_vector, 1));
+
+        const __m512i zero_vector = _mm512_setzero_epi32();
+        const __m512i left_shift = _mm512_max_epi32(e_vector, zero_vector);
+        const __m512i neg_e_vector = _mm512_sub_epi32(zero_vector, e_vector);
+        const __m512i right_shift = _mm512_max_epi32(neg_e_vector, zero_vector);
+        const __m512i final_right_shift =
+            _mm512_add_epi32(right_shift, _mm512_set1_epi32(31));
+        const __m512i final_right_shift_low = _mm512_cvtepi32_epi64(
+            _mm512_extracti32x8_epi32(final_right_shift, 0));
+        const __m512i final_right_shift_high = _mm512_cvtepi32_epi64(
+            _mm512_extracti32x8_epi32(final_right_shift, 1));
+
+        const __m512i offset_vector =
+            _mm512_slli_epi64(_mm512_set1_epi64(1), 30);
+        // Really these should be shifted by neg_e_vector, but tests pass when
+        // using right_shift.
+        const __m512i offset_vector_low = _mm512_sllv_epi64(
+            offset_vector,
+            _mm512_cvtepi32_epi64(_mm512_extracti32x8_epi32(right_shift, 0)));
+        const __m512i offset_vector_high = _mm512_sllv_epi64(
+            offset_vector,
+            _mm512_cvtepi32_epi64(_mm512_extracti32x8_epi32(right_shift, 1)));
+
+        // Shift and round column 0.
+        {
+          accum_data_v0 = _mm512_sllv_epi32(accum_data_v0, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v0, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v0, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_v0 =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_v0 = _mm512_inserti32x8(
+              accum_data_v0, _mm512_cvtepi64_epi32(scaled_v_high), 1);
         }
+        // Shift and round column 1.
+        {
+          accum_data_v1 = _mm512_sllv_epi32(accum_data_v1, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v1, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v1, 1)),
+                               m_64bit_high);
 
-        if (params.dst_zero_point) {
-          for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-            for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-              accum_data[j][i] += params.dst_zero_point;
-            }
-          }
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_v1 =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_v1 = _mm512_inserti32x8(
+              accum_data_v1, _mm512_cvtepi64_epi32(scaled_v_high), 1);
         }
+        // Shift and round column 2.
+        {
+          accum_data_v2 = _mm512_sllv_epi32(accum_data_v2, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v2, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v2, 1)),
+                               m_64bit_high);
 
-        for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-          for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-            accum_data[j][i] =
-                std::min<std::int32_t>(accum_data[j][i], params.clamp_max);
-            accum_data[j][i] =
-                std::max<std::int32_t>(accum_data[j][i], params.clamp_min);
-          }
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_v2 =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_v2 = _mm512_inserti32x8(
+              accum_data_v2, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 3.
+        {
+          accum_data_v3 = _mm512_sllv_epi32(accum_data_v3, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v3, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v3, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_v3 =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_v3 = _mm512_inserti32x8(
+              accum_data_v3, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 4.
+        {
+          accum_data_v4 = _mm512_sllv_epi32(accum_data_v4, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v4, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v4, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_v4 =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_v4 = _mm512_inserti32x8(
+              accum_data_v4, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 5.
+        {
+          accum_data_v5 = _mm512_sllv_epi32(accum_data_v5, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v5, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v5, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_v5 =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_v5 = _mm512_inserti32x8(
+              accum_data_v5, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 6.
+        {
+          accum_data_v6 = _mm512_sllv_epi32(accum_data_v6, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v6, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v6, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_v6 =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_v6 = _mm512_inserti32x8(
+              accum_data_v6, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 7.
+        {
+          accum_data_v7 = _mm512_sllv_epi32(accum_data_v7, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v7, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v7, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_v7 =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_v7 = _mm512_inserti32x8(
+              accum_data_v7, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 8.
+        {
+          accum_data_v8 = _mm512_sllv_epi32(accum_data_v8, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v8, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v8, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_v8 =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_v8 = _mm512_inserti32x8(
+              accum_data_v8, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 9.
+        {
+          accum_data_v9 = _mm512_sllv_epi32(accum_data_v9, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v9, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_v9, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_v9 =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_v9 = _mm512_inserti32x8(
+              accum_data_v9, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 10.
+        {
+          accum_data_va = _mm512_sllv_epi32(accum_data_va, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_va, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_va, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_va =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_va = _mm512_inserti32x8(
+              accum_data_va, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 11.
+        {
+          accum_data_vb = _mm512_sllv_epi32(accum_data_vb, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_vb, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_vb, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_vb =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_vb = _mm512_inserti32x8(
+              accum_data_vb, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 12.
+        {
+          accum_data_vc = _mm512_sllv_epi32(accum_data_vc, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_vc, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_vc, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_vc =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_vc = _mm512_inserti32x8(
+              accum_data_vc, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 13.
+        {
+          accum_data_vd = _mm512_sllv_epi32(accum_data_vd, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_vd, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_vd, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_vd =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_vd = _mm512_inserti32x8(
+              accum_data_vd, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 14.
+        {
+          accum_data_ve = _mm512_sllv_epi32(accum_data_ve, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_ve, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_ve, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_ve =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_ve = _mm512_inserti32x8(
+              accum_data_ve, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+        // Shift and round column 15.
+        {
+          accum_data_vf = _mm512_sllv_epi32(accum_data_vf, left_shift);
+          // Apply the fixed-point part of the multiplier.
+          __m512i scaled_v_low =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_vf, 0)),
+                               m_64bit_low);
+          __m512i scaled_v_high =
+              _mm512_mul_epi32(_mm512_cvtepi32_epi64(
+                                   _mm512_extracti32x8_epi32(accum_data_vf, 1)),
+                               m_64bit_high);
+
+          scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+          scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+          scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+          scaled_v_high =
+              _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+          accum_data_vf =
+              _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+          accum_data_vf = _mm512_inserti32x8(
+              accum_data_vf, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+        }
+#if !RUY_OPT_ENABLED(RUY_OPT_NATIVE_ROUNDING)
+        RUY_DCHECK(false);
+#endif
+
+        if (params.dst_zero_point != 0) {
+          __m512i dst_zero_point = _mm512_set1_epi32(params.dst_zero_point);
+          accum_data_v0 = _mm512_add_epi32(accum_data_v0, dst_zero_point);
+          accum_data_v1 = _mm512_add_epi32(accum_data_v1, dst_zero_point);
+          accum_data_v2 = _mm512_add_epi32(accum_data_v2, dst_zero_point);
+          accum_data_v3 = _mm512_add_epi32(accum_data_v3, dst_zero_point);
+          accum_data_v4 = _mm512_add_epi32(accum_data_v4, dst_zero_point);
+          accum_data_v5 = _mm512_add_epi32(accum_data_v5, dst_zero_point);
+          accum_data_v6 = _mm512_add_epi32(accum_data_v6, dst_zero_point);
+          accum_data_v7 = _mm512_add_epi32(accum_data_v7, dst_zero_point);
+          accum_data_v8 = _mm512_add_epi32(accum_data_v8, dst_zero_point);
+          accum_data_v9 = _mm512_add_epi32(accum_data_v9, dst_zero_point);
+          accum_data_va = _mm512_add_epi32(accum_data_va, dst_zero_point);
+          accum_data_vb = _mm512_add_epi32(accum_data_vb, dst_zero_point);
+          accum_data_vc = _mm512_add_epi32(accum_data_vc, dst_zero_point);
+          accum_data_vd = _mm512_add_epi32(accum_data_vd, dst_zero_point);
+          accum_data_ve = _mm512_add_epi32(accum_data_ve, dst_zero_point);
+          accum_data_vf = _mm512_add_epi32(accum_data_vf, dst_zero_point);
         }
       }
 
-      const bool store_full_block = (residual_rows == kAvx8bitBlockSize) &&
-                                    (residual_cols == kAvx8bitBlockSize);
+      const __m512i clamp_max_v = _mm512_set1_epi32(params.clamp_max);
+      const __m512i clamp_min_v = _mm512_set1_epi32(params.clamp_min);
+
+      const bool store_full_block =
+          (residual_rows == 16) && (residual_cols == 16);
+
+      __m512i accum_data_v[16];
+
+      // In most cases we would make this conditional on (!store_full_block) and
+      // unwind the clamp-and-store loop, but the benefit appears small.
+      {
+        accum_data_v[0] = accum_data_v0;
+        accum_data_v[1] = accum_data_v1;
+        accum_data_v[2] = accum_data_v2;
+        accum_data_v[3] = accum_data_v3;
+        accum_data_v[4] = accum_data_v4;
+        accum_data_v[5] = accum_data_v5;
+        accum_data_v[6] = accum_data_v6;
+        accum_data_v[7] = accum_data_v7;
+        accum_data_v[8] = accum_data_v8;
+        accum_data_v[9] = accum_data_v9;
+        accum_data_v[10] = accum_data_va;
+        accum_data_v[11] = accum_data_vb;
+        accum_data_v[12] = accum_data_vc;
+        accum_data_v[13] = accum_data_vd;
+        accum_data_v[14] = accum_data_ve;
+        accum_data_v[15] = accum_data_vf;
+      }
 
       if (params.dst_type_id == DstTypeId<std::int8_t>::kValue) {
-        std::int8_t* tmp_ptr =
-            store_full_block
-                ? static_cast<std::int8_t*>(dst_ptr)
-                : const_cast<std::int8_t*>(
-                      reinterpret_cast<const std::int8_t*>(params.dst_tmp_buf));
-        const int block_col_offset =
-            store_full_block ? params.dst_stride / sizeof(std::int8_t)
-                             : kAvx8bitBlockSize;
-        for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-          for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-            tmp_ptr[i] = accum_data[j][i];
+        std::int8_t* tmp_ptr = static_cast<std::int8_t*>(dst_ptr);
+        const int block_col_offset = dst_stride;
+        if (store_full_block) {
+          for (int j = 0; j < 16; ++j) {
+            __m512i result = accum_data_v[j];
+            result = _mm512_min_epi32(result, clamp_max_v);
+            result = _mm512_max_epi32(result, clamp_min_v);
+            _mm_storeu_epi8(tmp_ptr + j * block_col_offset,
+                            _mm512_cvtepi32_epi8(result));
           }
-          tmp_ptr += block_col_offset;
-        }
-
-        if (!store_full_block) {
-          const std::int8_t* block_ptr =
-              reinterpret_cast<const std::int8_t*>(params.dst_tmp_buf);
+        } else {
           for (int j = 0; j < residual_cols; ++j) {
-            for (int i = 0; i < residual_rows; ++i) {
-              static_cast<std::int8_t*>(
-                  dst_ptr)[j * params.dst_stride / sizeof(std::int8_t) + i] =
-                  block_ptr[i];
-            }
-            block_ptr += kAvx8bitBlockSize;
+            __m512i result = accum_data_v[j];
+            result = _mm512_min_epi32(result, clamp_max_v);
+            result = _mm512_max_epi32(result, clamp_min_v);
+            _mm_mask_storeu_epi8(tmp_ptr + j * block_col_offset, row_mask,
+                                 _mm512_cvtepi32_epi8(result));
           }
         }
-        dst_ptr = static_cast<void*>(static_cast<std::int8_t*>(dst_ptr) +
-                                     kAvx8bitBlockSize);
+        dst_ptr = static_cast<void*>(static_cast<std::int8_t*>(dst_ptr) + 16);
       } else if (params.dst_type_id == DstTypeId<std::uint8_t>::kValue) {
-        std::uint8_t* tmp_ptr = store_full_block
-                                    ? static_cast<std::uint8_t*>(dst_ptr)
-                                    : const_cast<std::uint8_t*>(
-                                          reinterpret_cast<const std::uint8_t*>(
-                                              params.dst_tmp_buf));
-        const int block_col_offset =
-            store_full_block ? params.dst_stride : kAvx8bitBlockSize;
-        for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-          for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-            tmp_ptr[i] = accum_data[j][i];
+        std::uint8_t* tmp_ptr = static_cast<std::uint8_t*>(dst_ptr);
+        const int block_col_offset = dst_stride;
+        if (store_full_block) {
+          for (int j = 0; j < residual_cols; ++j) {
+            __m512i result = accum_data_v[j];
+            result = _mm512_min_epi32(result, clamp_max_v);
+            result = _mm512_max_epi32(result, clamp_min_v);
+            _mm_storeu_epi8(tmp_ptr + j * block_col_offset,
+                            _mm512_cvtepi32_epi8(result));
           }
-          tmp_ptr += block_col_offset;
-        }
-
-        if (!store_full_block) {
-          const std::uint8_t* block_ptr =
-              reinterpret_cast<const std::uint8_t*>(params.dst_tmp_buf);
+        } else {
           for (int j = 0; j < residual_cols; ++j) {
-            for (int i = 0; i < residual_rows; ++i) {
-              static_cast<std::uint8_t*>(
-                  dst_ptr)[j * params.dst_stride / sizeof(std::uint8_t) + i] =
-                  block_ptr[i];
-            }
-            block_ptr += kAvx8bitBlockSize;
+            __m512i result = accum_data_v[j];
+            result = _mm512_min_epi32(result, clamp_max_v);
+            result = _mm512_max_epi32(result, clamp_min_v);
+            _mm_mask_storeu_epi8(tmp_ptr + j * block_col_offset, row_mask,
+                                 _mm512_cvtepi32_epi8(result));
           }
         }
-        dst_ptr = static_cast<void*>(static_cast<std::uint8_t*>(dst_ptr) +
-                                     kAvx8bitBlockSize);
+        dst_ptr = static_cast<void*>(static_cast<std::uint8_t*>(dst_ptr) + 16);
       } else if (params.dst_type_id == DstTypeId<std::int16_t>::kValue) {
+        std::int16_t* tmp_ptr = static_cast<std::int16_t*>(dst_ptr);
+        const int block_col_offset = dst_stride;
         if (store_full_block) {
-          std::int16_t* tmp_ptr = static_cast<std::int16_t*>(dst_ptr);
-          const int block_col_offset = params.dst_stride / sizeof(std::int16_t);
-          for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-            for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-              tmp_ptr[i] = accum_data[j][i];
-            }
-            tmp_ptr += block_col_offset;
+          for (int j = 0; j < 16; ++j) {
+            __m512i result = accum_data_v[j];
+            result = _mm512_min_epi32(result, clamp_max_v);
+            result = _mm512_max_epi32(result, clamp_min_v);
+            _mm256_storeu_epi16(tmp_ptr + j * block_col_offset,
+                                _mm512_cvtepi32_epi16(result));
           }
         } else {
-          std::int16_t* tmp_ptr = const_cast<std::int16_t*>(
-              reinterpret_cast<const std::int16_t*>(params.dst_tmp_buf));
-          const int block_col_offset = kAvx8bitBlockSize;
-          for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-            for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-              tmp_ptr[i] = accum_data[j][i];
-            }
-            tmp_ptr += block_col_offset;
-          }
-          const std::int16_t* block_ptr =
-              reinterpret_cast<const std::int16_t*>(params.dst_tmp_buf);
-          std::int16_t* dst_block_ptr = static_cast<std::int16_t*>(dst_ptr);
           for (int j = 0; j < residual_cols; ++j) {
-            for (int i = 0; i < residual_rows; ++i) {
-              dst_block_ptr[i] = block_ptr[i];
-            }
-            dst_block_ptr += params.dst_stride / sizeof(std::int16_t);
-            block_ptr += kAvx8bitBlockSize;
+            __m512i result = accum_data_v[j];
+            result = _mm512_min_epi32(result, clamp_max_v);
+            result = _mm512_max_epi32(result, clamp_min_v);
+            _mm256_mask_storeu_epi16(tmp_ptr + j * block_col_offset, row_mask,
+                                     _mm512_cvtepi32_epi16(result));
           }
         }
-        dst_ptr = static_cast<void*>(static_cast<std::int16_t*>(dst_ptr) +
-                                     kAvx8bitBlockSize);
+        dst_ptr = static_cast<void*>(static_cast<std::int16_t*>(dst_ptr) + 16);
       } else if (params.dst_type_id == DstTypeId<std::int32_t>::kValue) {
         if (store_full_block) {
           std::int32_t* tmp_ptr = static_cast<std::int32_t*>(dst_ptr);
-          const int block_col_offset = params.dst_stride / sizeof(std::int32_t);
-          for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-            for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-              tmp_ptr[i] = accum_data[j][i];
-            }
-            tmp_ptr += block_col_offset;
+          for (int j = 0; j < 16; ++j) {
+            _mm512_storeu_epi32(tmp_ptr + j * dst_stride, accum_data_v[j]);
           }
         } else {
-          std::int32_t* dst_block_ptr = static_cast<std::int32_t*>(dst_ptr);
+          std::int32_t* tmp_ptr = static_cast<std::int32_t*>(dst_ptr);
           for (int j = 0; j < residual_cols; ++j) {
-            for (int i = 0; i < residual_rows; ++i) {
-              dst_block_ptr[i] = accum_data[j][i];
-            }
-            dst_block_ptr += params.dst_stride / sizeof(std::int32_t);
+            _mm512_mask_storeu_epi32(tmp_ptr + j * dst_stride, row_mask,
+                                     accum_data_v[j]);
           }
         }
-        dst_ptr = static_cast<void*>(static_cast<std::int32_t*>(dst_ptr) +
-                                     kAvx8bitBlockSize);
+        dst_ptr = static_cast<void*>(static_cast<std::int32_t*>(dst_ptr) + 16);
       } else {
         RUY_DCHECK(false);
       }
 
-      lhs_col_ptr += kAvx8bitBlockSize * params.lhs_stride;
+      lhs_col_ptr += 16 * params.lhs_stride;
     }  // End row-block loop.
 
     dst_col_ptr = static_cast<void*>(static_cast<char*>(dst_col_ptr) +
-                                     kAvx8bitBlockSize * params.dst_stride);
-    rhs_col_ptr += kAvx8bitBlockSize * params.rhs_stride;
+                                     16 * params.dst_stride);
+    rhs_col_ptr += 16 * params.rhs_stride;
   }  // End col-block loop.
 }  // NOLINT(readability/fn_size)
 
-// TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
-// Optimization is not finished. In particular the dimensions of the kernel
-// blocks can be changed as desired.
-//
-// When removing this comment, update profiling label below.
-void KernelFloatAvxVnni(const KernelParamsFloat<16, 16>& params) {
-  profiler::ScopeLabel label("Kernel kAvxVnni float (UNFINISHED)");
-
-  float lhs_data[kAvxFloatBlockSize];
-  float rhs_data[kAvxFloatBlockSize];
-  float accum_data[kAvxFloatBlockSize][kAvxFloatBlockSize];
-  int bias_ptr_block_increment =
-      params.flags & RUY_ASM_FLAG_HAS_BIAS ? kAvxFloatBlockSize : 0;
-
-  const float* rhs_col_ptr = params.rhs_base_ptr;
-  float* dst_col_ptr = params.dst_base_ptr;
-  const float* bias_col_ptr = params.bias;
+void Kernel8bitAvxVnniSingleCol(const KernelParams8bit<16, 16>& params) {
+  profiler::ScopeLabel label("Kernel kAvxVnni 8-bit GEMV");
+
+  RUY_DCHECK_EQ(params.dst_cols, 1);
+  RUY_DCHECK_EQ(params.last_col, 0);
+  RUY_DCHECK_EQ(params.start_col, 0);
+
+  std::int32_t dst_stride;
+  if ((params.dst_type_id == DstTypeId<std::int8_t>::kValue) ||
+      (params.dst_type_id == DstTypeId<std::uint8_t>::kValue)) {
+    dst_stride = params.dst_stride;
+  } else if (params.dst_type_id == DstTypeId<std::int16_t>::kValue) {
+    dst_stride = params.dst_stride / sizeof(std::int16_t);
+  } else if (params.dst_type_id == DstTypeId<std::int32_t>::kValue) {
+    dst_stride = params.dst_stride / sizeof(std::int32_t);
+  } else {
+    RUY_DCHECK(false);
+  }
+
+  int bias_ptr_block_increment = params.flags & RUY_ASM_FLAG_HAS_BIAS ? 16 : 0;
+
+  const std::int8_t* rhs_col_ptr = params.rhs_base_ptr;
+  void* dst_col_ptr = params.dst_base_ptr;
+  const std::int32_t* bias_col_ptr = params.bias;
   if (params.flags & RUY_ASM_FLAG_HAS_BIAS) {
     bias_col_ptr += params.start_row;
   }
 
-  for (int col = params.start_col; col <= params.last_col;
-       col += kAvxFloatBlockSize) {
-    const float* lhs_col_ptr = params.lhs_base_ptr;
-    float* dst_ptr = dst_col_ptr;
-    const float* bias_ptr = bias_col_ptr;
+  const std::int8_t* lhs_col_ptr = params.lhs_base_ptr;
+  void* dst_ptr = dst_col_ptr;
+  const std::int32_t* bias_ptr = bias_col_ptr;
 
-    for (int row = params.start_row; row <= params.last_row;
-         row += kAvxFloatBlockSize) {
-      const int residual_rows =
-          std::min(params.dst_rows - row, kAvxFloatBlockSize);
-      const int residual_cols =
-          std::min(params.dst_cols - col, kAvxFloatBlockSize);
+  const std::int32_t lhs_zero_point = params.lhs_zero_point;
+  const bool has_rhs_sums_offsets =
+      (params.flags & RUY_ASM_FLAG_HAS_RHS_SUMS) && lhs_zero_point;
+  std::int32_t rhs_sums_offsets[16];
+  if (has_rhs_sums_offsets) {
+    const __m512i rhs_sums_offset_v =
+        _mm512_mullo_epi32(_mm512_set1_epi32(lhs_zero_point),
+                           _mm512_loadu_epi32(&params.rhs_sums[0]));
+    _mm512_storeu_si512(reinterpret_cast<__m512i*>(rhs_sums_offsets),
+                        rhs_sums_offset_v);
+  }
 
-      // Initialize with bias.
-      float initial_accum_data[kAvxFloatBlockSize];
-      for (int i = 0; i < kAvxFloatBlockSize; ++i) {
-        initial_accum_data[i] = 0.0f;
-      }
-      for (int i = 0; i < residual_rows; ++i) {
-        initial_accum_data[i] = bias_ptr[i];
-      }
-      for (int j = 0; j < kAvxFloatBlockSize; ++j) {
-        for (int i = 0; i < kAvxFloatBlockSize; ++i) {
-          accum_data[j][i] = initial_accum_data[i];
-        }
-      }
-      bias_ptr += bias_ptr_block_increment;
+  for (int row = params.start_row; row <= params.last_row; row += 16) {
+    const int residual_rows = std::min(params.dst_rows - row, 16);
 
-      const float* lhs_ptr = lhs_col_ptr;
-      const float* rhs_ptr = rhs_col_ptr;
-      for (int d = 0; d < params.depth; ++d) {
-        for (int i = 0; i < kAvxFloatBlockSize; ++i) {
-          lhs_data[i] = lhs_ptr[i];
-          rhs_data[i] = rhs_ptr[i];
-        }
+    __m512i accum_data_v0;
 
-        for (int j = 0; j < kAvxFloatBlockSize; ++j) {
-          for (int i = 0; i < kAvxFloatBlockSize; ++i) {
-            accum_data[j][i] += lhs_data[i] * rhs_data[j];
-          }
-        }
+    // Initialize with bias.
+    const __mmask16 row_mask =
+        (static_cast<std::uint32_t>(1) << residual_rows) - 1;
+    __m512i initial_accum_data = _mm512_maskz_loadu_epi32(row_mask, bias_ptr);
+    bias_ptr += bias_ptr_block_increment;
 
-        lhs_ptr += kAvxFloatBlockSize;
-        rhs_ptr += kAvxFloatBlockSize;
-      }
+    const std::int32_t rhs_zero_point = params.rhs_zero_point;
+    if ((params.flags & RUY_ASM_FLAG_HAS_LHS_SUMS) && rhs_zero_point) {
+      const __m512i lhs_sums_offset =
+          _mm512_mullo_epi32(_mm512_set1_epi32(rhs_zero_point),
+                             _mm512_loadu_epi32(&params.lhs_sums[row]));
+      initial_accum_data =
+          _mm512_sub_epi32(initial_accum_data, lhs_sums_offset);
+    }
 
-      for (int j = 0; j < kAvxFloatBlockSize; ++j) {
-        for (int i = 0; i < kAvxFloatBlockSize; ++i) {
-          accum_data[j][i] =
-              std::min<float>(accum_data[j][i], params.clamp_max);
-          accum_data[j][i] =
-              std::max<float>(accum_data[j][i], params.clamp_min);
-        }
-      }
+    const std::int32_t prod_zp_depth = params.prod_zp_depth;
+    if (prod_zp_depth != 0) {
+      initial_accum_data = _mm512_add_epi32(initial_accum_data,
+                                            _mm512_set1_epi32(prod_zp_depth));
+    }
 
-      const bool store_full_block = (residual_rows == kAvxFloatBlockSize) &&
-                                    (residual_cols == kAvxFloatBlockSize);
+    // Adjustments differing across columns.
+    if (has_rhs_sums_offsets) {
+      accum_data_v0 = _mm512_sub_epi32(initial_accum_data,
+                                       _mm512_set1_epi32(rhs_sums_offsets[0]));
+    } else {
+      accum_data_v0 = initial_accum_data;
+    }
 
-      {
-        float* block_ptr =
-            store_full_block ? dst_ptr : const_cast<float*>(params.dst_tmp_buf);
-        const int block_col_offset = store_full_block
-                                         ? params.dst_stride / sizeof(float)
-                                         : kAvxFloatBlockSize;
-        for (int j = 0; j < kAvxFloatBlockSize; ++j) {
-          for (int i = 0; i < kAvxFloatBlockSize; ++i) {
-            block_ptr[i] = accum_data[j][i];
-          }
-          block_ptr += block_col_offset;
-        }
+    const std::int8_t* lhs_ptr = lhs_col_ptr;
+    const std::int8_t* rhs_ptr = rhs_col_ptr;
+    for (int d = 0; d < params.depth; d += 4) {
+      const __m512i lhs_data = _mm512_loadu_epi8(lhs_ptr);
+      const __m128i rhs_data_8bit = _mm_loadu_epi8(rhs_ptr);
+
+      // Each "int32" is two 16-bit RHS values, sign extended from 8-bit.
+      // For simplicity we load 4x the data that we need and process twice the
+      // data  that we need  and store only the data we need.
+      std::int32_t rhs_data[2];
+      const __m128i rhs_16_bit_dup = _mm_cvtepi8_epi16(rhs_data_8bit);
+      // Now that we have cast the RHS data, we store it so that each value
+      // can be separately loaded in the accumulation loop.
+      _mm_storeu_si64(reinterpret_cast<__m128i*>(rhs_data), rhs_16_bit_dup);
+
+      // Take bytes 0, 1, 4, 5, 8, 9, ... and expand to 16-bit.
+      const __m512i lhs_16_bit_low =
+          _mm512_cvtepi8_epi16(_mm512_cvtepi32_epi16(lhs_data));
+      // Take bytes 2, 3, 6, 7, 10, 11, ... and expand to 16-bit.
+      const __m512i lhs_16_bit_high = _mm512_cvtepi8_epi16(
+          _mm512_cvtepi32_epi16(_mm512_srli_epi32(lhs_data, 16)));
+
+      // Process column 0.
+      __m512i accum_v = accum_data_v0;
+      constexpr int index = 0;
+
+      const __m512i rhs_16_bit_dup_low = _mm512_set1_epi32(rhs_data[index]);
+      const __m512i rhs_16_bit_dup_high =
+          _mm512_set1_epi32(rhs_data[index + 1]);
+
+      accum_v =
+          _mm512_dpwssd_epi32(accum_v, lhs_16_bit_low, rhs_16_bit_dup_low);
+      accum_v =
+          _mm512_dpwssd_epi32(accum_v, lhs_16_bit_high, rhs_16_bit_dup_high);
+      accum_data_v0 = accum_v;
+
+      lhs_ptr += 16 * 4;
+      rhs_ptr += 16 * 4;
+    }
+
+    if (params.dst_type_id != DstTypeId<std::int32_t>::kValue) {
+      __m512i m_vector;
+      __m512i e_vector;
+      // Does not make use of RUY_ASM_FLAG_NEEDS_LEFT_SHIFT.
+      if (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) {
+        m_vector = _mm512_maskz_loadu_epi32(row_mask,
+                                            &params.multiplier_fixedpoint[row]);
+        e_vector = _mm512_maskz_loadu_epi32(row_mask,
+                                            &params.multiplier_exponent[row]);
+      } else {
+        // These arrays have size LhsCols, and are pre-filled.
+        m_vector = _mm512_set1_epi32(params.multiplier_fixedpoint[0]);
+        e_vector = _mm512_set1_epi32(params.multiplier_exponent[0]);
       }
-      if (!store_full_block) {
-        const float* block_ptr = params.dst_tmp_buf;
-        for (int j = 0; j < residual_cols; ++j) {
-          for (int i = 0; i < residual_rows; ++i) {
-            dst_ptr[j * params.dst_stride / sizeof(float) + i] = block_ptr[i];
-          }
-          block_ptr += kAvxFloatBlockSize;
-        }
+
+      const __m512i m_64bit_low =
+          _mm512_cvtepi32_epi64(_mm512_extracti32x8_epi32(m_vector, 0));
+      const __m512i m_64bit_high =
+          _mm512_cvtepi32_epi64(_mm512_extracti32x8_epi32(m_vector, 1));
+
+      const __m512i zero_vector = _mm512_setzero_epi32();
+      const __m512i left_shift = _mm512_max_epi32(e_vector, zero_vector);
+      const __m512i neg_e_vector = _mm512_sub_epi32(zero_vector, e_vector);
+      const __m512i right_shift = _mm512_max_epi32(neg_e_vector, zero_vector);
+      const __m512i final_right_shift =
+          _mm512_add_epi32(right_shift, _mm512_set1_epi32(31));
+      const __m512i final_right_shift_low = _mm512_cvtepi32_epi64(
+          _mm512_extracti32x8_epi32(final_right_shift, 0));
+      const __m512i final_right_shift_high = _mm512_cvtepi32_epi64(
+          _mm512_extracti32x8_epi32(final_right_shift, 1));
+
+      const __m512i offset_vector = _mm512_slli_epi64(_mm512_set1_epi64(1), 30);
+      // Really these should be shifted by neg_e_vector, but tests pass when
+      // using right_shift.
+      const __m512i offset_vector_low = _mm512_sllv_epi64(
+          offset_vector,
+          _mm512_cvtepi32_epi64(_mm512_extracti32x8_epi32(right_shift, 0)));
+      const __m512i offset_vector_high = _mm512_sllv_epi64(
+          offset_vector,
+          _mm512_cvtepi32_epi64(_mm512_extracti32x8_epi32(right_shift, 1)));
+
+      // Shift and round column 0.
+      accum_data_v0 = _mm512_sllv_epi32(accum_data_v0, left_shift);
+      // Apply the fixed-point part of the multiplier.
+      __m512i scaled_v_low = _mm512_mul_epi32(
+          _mm512_cvtepi32_epi64(_mm512_extracti32x8_epi32(accum_data_v0, 0)),
+          m_64bit_low);
+      __m512i scaled_v_high = _mm512_mul_epi32(
+          _mm512_cvtepi32_epi64(_mm512_extracti32x8_epi32(accum_data_v0, 1)),
+          m_64bit_high);
+
+      scaled_v_low = _mm512_add_epi64(scaled_v_low, offset_vector_low);
+      scaled_v_high = _mm512_add_epi64(scaled_v_high, offset_vector_high);
+
+      scaled_v_low = _mm512_srav_epi64(scaled_v_low, final_right_shift_low);
+      scaled_v_high = _mm512_srav_epi64(scaled_v_high, final_right_shift_high);
+
+      accum_data_v0 =
+          _mm512_castsi256_si512(_mm512_cvtepi64_epi32(scaled_v_low));
+      accum_data_v0 = _mm512_inserti32x8(
+          accum_data_v0, _mm512_cvtepi64_epi32(scaled_v_high), 1);
+#if !RUY_OPT_ENABLED(RUY_OPT_NATIVE_ROUNDING)
+      RUY_DCHECK(false);
+#endif
+
+      if (params.dst_zero_point != 0) {
+        __m512i dst_zero_point = _mm512_set1_epi32(params.dst_zero_point);
+        accum_data_v0 = _mm512_add_epi32(accum_data_v0, dst_zero_point);
       }
+    }
 
-      lhs_col_ptr += kAvxFloatBlockSize * params.lhs_stride / sizeof(float);
-      dst_ptr += kAvxFloatBlockSize;
-    }  // End row-block loop.
+    const __m512i clamp_max_v = _mm512_set1_epi32(params.clamp_max);
+    const __m512i clamp_min_v = _mm512_set1_epi32(params.clamp_min);
 
-    dst_col_ptr += kAvxFloatBlockSize * params.dst_stride / sizeof(float);
-    rhs_col_ptr += kAvxFloatBlockSize * params.rhs_stride / sizeof(float);
-  }  // End col-block loop.
-}
+    if (params.dst_type_id == DstTypeId<std::int8_t>::kValue) {
+      std::int8_t* tmp_ptr = static_cast<std::int8_t*>(dst_ptr);
+      __m512i result = accum_data_v0;
+      result = _mm512_min_epi32(result, clamp_max_v);
+      result = _mm512_max_epi32(result, clamp_min_v);
+      _mm_mask_storeu_epi8(tmp_ptr, row_mask, _mm512_cvtepi32_epi8(result));
+      dst_ptr = static_cast<void*>(static_cast<std::int8_t*>(dst_ptr) + 16);
+    } else if (params.dst_type_id == DstTypeId<std::uint8_t>::kValue) {
+      std::uint8_t* tmp_ptr = static_cast<std::uint8_t*>(dst_ptr);
+      __m512i result = accum_data_v0;
+      result = _mm512_min_epi32(result, clamp_max_v);
+      result = _mm512_max_epi32(result, clamp_min_v);
+      _mm_mask_storeu_epi8(tmp_ptr, row_mask, _mm512_cvtepi32_epi8(result));
+      dst_ptr = static_cast<void*>(static_cast<std::uint8_t*>(dst_ptr) + 16);
+    } else if (params.dst_type_id == DstTypeId<std::int16_t>::kValue) {
+      std::int16_t* tmp_ptr = static_cast<std::int16_t*>(dst_ptr);
+      __m512i result = accum_data_v0;
+      result = _mm512_min_epi32(result, clamp_max_v);
+      result = _mm512_max_epi32(result, clamp_min_v);
+      _mm256_mask_storeu_epi16(tmp_ptr, row_mask,
+                               _mm512_cvtepi32_epi16(result));
+      dst_ptr = static_cast<void*>(static_cast<std::int16_t*>(dst_ptr) + 16);
+    } else if (params.dst_type_id == DstTypeId<std::int32_t>::kValue) {
+      std::int32_t* tmp_ptr = static_cast<std::int32_t*>(dst_ptr);
+      _mm512_mask_storeu_epi32(tmp_ptr, row_mask, accum_data_v0);
+      dst_ptr = static_cast<void*>(static_cast<std::int32_t*>(dst_ptr) + 16);
+    } else {
+      RUY_DCHECK(false);
+    }
+
+    lhs_col_ptr += 16 * params.lhs_stride;
+  }  // End row-block loop.
+}  // NOLINT(readability/fn_size)
 
 #endif  //  RUY_PLATFORM(AVX_VNNI) && RUY_OPT_ENABLED(RUY_OPT_ASM)
 
@@ -31,7 +31,7 @@ limitations under the License.
 namespace ruy {
 
 #if RUY_PLATFORM(X86)
-// TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
+// TODO(b/147376783): SSE 4.2 support is incomplete / placeholder.
 // Optimization is not finished. In particular the dimensions of the kernel
 // blocks can be changed as desired.
 //
@@ -172,11 +172,10 @@ struct Kernel<Path::kAvx2, float, float, float, BasicSpec<float, float>> {
   }
 };
 
-// TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
-// Optimization is not finished. In particular the dimensions of the kernel
-// blocks can be changed as desired.
-//
+// Uses the same packed layout as kAvx512. Float matrices are handled by the
+// kAvx512 float kernel, inherited via RUY_INHERIT_KERNEL.
 void Kernel8bitAvxVnni(const KernelParams8bit<16, 16>& params);
+void Kernel8bitAvxVnniSingleCol(const KernelParams8bit<16, 16>& params);
 
 template <typename DstScalar>
 struct Kernel<Path::kAvxVnni, std::int8_t, std::int8_t, DstScalar,
@@ -193,25 +192,11 @@ struct Kernel<Path::kAvxVnni, std::int8_t, std::int8_t, DstScalar,
     KernelParams8bit<LhsLayout::kCols, RhsLayout::kCols> params;
     MakeKernelParams8bit(lhs, rhs, spec, start_row, start_col, end_row, end_col,
                          dst, &params);
-    Kernel8bitAvxVnni(params);
-  }
-};
-
-void KernelFloatAvxVnni(const KernelParamsFloat<16, 16>& params);
-
-template <>
-struct Kernel<Path::kAvxVnni, float, float, float, BasicSpec<float, float>> {
-  Tuning tuning = Tuning::kAuto;
-  using LhsLayout = FixedKernelLayout<Order::kRowMajor, 1, 16>;
-  using RhsLayout = FixedKernelLayout<Order::kRowMajor, 1, 16>;
-  explicit Kernel(Tuning tuning_) : tuning(tuning_) {}
-  void Run(const PackedMatrix<float>& lhs, const PackedMatrix<float>& rhs,
-           const BasicSpec<float, float>& spec, int start_row, int start_col,
-           int end_row, int end_col, Matrix<float>* dst) const {
-    KernelParamsFloat<LhsLayout::kCols, RhsLayout::kCols> params;
-    MakeKernelParamsFloat(lhs, rhs, spec, start_row, start_col, end_row,
-                          end_col, dst, &params);
-    KernelFloatAvxVnni(params);
+    if (dst->layout.cols == 1) {
+      Kernel8bitAvxVnniSingleCol(params);
+    } else {
+      Kernel8bitAvxVnni(params);
+    }
   }
 };
 
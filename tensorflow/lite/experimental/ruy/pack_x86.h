@@ -101,7 +101,7 @@ limitations under the License.
 namespace ruy {
 
 #if RUY_PLATFORM(X86)
-// TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
+// TODO(b/147376783): SSE 4.2 support is incomplete / placeholder.
 // Optimization is not finished. In particular the dimensions of the kernel
 // blocks can be changed as desired.
 //
@@ -154,7 +154,7 @@ struct PackImpl<Path::kSse42, FixedKernelLayout<Order::kColMajor, 4, 8>, Scalar,
   }
 };
 
-// TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
+// TODO(b/147376783): SSE 4.2 support is incomplete / placeholder.
 // Optimization is not finished. In particular the dimensions of the kernel
 // blocks can be changed as desired.
 //
@@ -360,100 +360,9 @@ struct PackImpl<Path::kAvx512, FixedKernelLayout<Order::kRowMajor, 1, 16>,
   }
 };
 
-// TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
-// Optimization is not finished. In particular the dimensions of the kernel
-// blocks can be changed as desired.
-//
-// Note that source and zero buffers can be uint8 type, but in the packing
-// function are reinterpreted as int8, and are XOR-ed with input_xor.
-void Pack8bitAvxVnni(const std::int8_t* src_ptr, std::int8_t input_xor,
-                     const std::int8_t* zerobuf, int src_stride,
-                     int remaining_src_cols, int src_rows,
-                     std::int8_t* packed_ptr, std::int32_t* sums_ptr);
-
-template <typename Scalar>
-struct PackImpl<Path::kAvxVnni, FixedKernelLayout<Order::kColMajor, 4, 16>,
-                Scalar, std::int8_t, std::int32_t> {
-  static_assert(std::is_same<Scalar, std::int8_t>::value ||
-                    std::is_same<Scalar, std::uint8_t>::value,
-                "");
-  using Layout = FixedKernelLayout<Order::kColMajor, 4, 16>;
-  static constexpr int kHalfLayoutCols =
-      8;  // Half the number of cols in a block.
-  static constexpr std::int8_t kInputXor =
-      std::is_same<Scalar, std::int8_t>::value ? 0 : 0x80;
-
-  static void Run(Tuning tuning, const Matrix<Scalar>& src_matrix,
-                  PackedMatrix<std::int8_t>* packed_matrix, int start_col,
-                  int end_col) {
-    profiler::ScopeLabel label("Pack (AVX-512 8-bit)");
-
-    RUY_DCHECK(IsColMajor(src_matrix.layout));
-    RUY_DCHECK(IsColMajor(packed_matrix->layout));
-    RUY_DCHECK_EQ((end_col - start_col) % Layout::kCols, 0);
-    RUY_DCHECK_EQ(start_col % Layout::kCols, 0);
-    RUY_DCHECK_EQ(kHalfLayoutCols * 2, Layout::kCols);
-    std::int32_t* sums = packed_matrix->sums;
-    Scalar zerobuf[kHalfLayoutCols * Layout::kRows];
-    memset(zerobuf, packed_matrix->zero_point ^ kInputXor,
-           kHalfLayoutCols * Layout::kRows * sizeof(Scalar));
-    for (int block_col = start_col; block_col < end_col;
-         block_col += Layout::kCols) {
-      std::int32_t* sums_ptr = sums ? sums + block_col : nullptr;
-      int src_stride = src_matrix.layout.stride;
-      const Scalar* src_ptr = src_matrix.data.get() + src_stride * block_col;
-      int remaining_src_cols = src_matrix.layout.cols - block_col;
-
-      static constexpr int block_col_mask = ~(Layout::kCols - 1);  // High bits.
-      std::int8_t* packed_ptr =
-          packed_matrix->data +
-          packed_matrix->layout.stride * (block_col & block_col_mask);
-      Pack8bitAvxVnni(reinterpret_cast<const std::int8_t*>(src_ptr), kInputXor,
-                      reinterpret_cast<const std::int8_t*>(zerobuf), src_stride,
-                      remaining_src_cols, src_matrix.layout.rows, packed_ptr,
-                      sums_ptr);
-    }
-  }
-};
-
-// TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
-// Optimization is not finished. In particular the dimensions of the kernel
-// blocks can be changed as desired.
-//
-void PackFloatAvxVnni(const float* src_ptr, const float* zerobuf,
-                      int src_stride, int remaining_src_cols, int src_rows,
-                      float* packed_ptr);
-
-template <>
-struct PackImpl<Path::kAvxVnni, FixedKernelLayout<Order::kRowMajor, 1, 16>,
-                float, float, float> {
-  static void Run(Tuning, const Matrix<float>& src_matrix,
-                  PackedMatrix<float>* packed_matrix, int start_col,
-                  int end_col) {
-    profiler::ScopeLabel label("Pack (AVX-512 float)");
-
-    using Layout = FixedKernelLayout<Order::kRowMajor, 1, 16>;
-    RUY_DCHECK(IsColMajor(src_matrix.layout));
-    RUY_DCHECK(IsColMajor(packed_matrix->layout));
-    RUY_DCHECK_EQ((end_col - start_col) % Layout::kCols, 0);
-    RUY_DCHECK_EQ(start_col % Layout::kCols, 0);
-    const float zerobuf[Layout::kCols] = {
-        0.0f};  // Remainder default inits to 0.0f.
-    for (int block_col = start_col; block_col < end_col;
-         block_col += Layout::kCols) {
-      int src_stride = src_matrix.layout.stride;
-      const float* src_ptr = src_matrix.data.get() + src_stride * block_col;
-      int remaining_src_cols = src_matrix.layout.cols - block_col;
+// kAvxVnni kernels use the kAvx512 packed layouts, so packing for kAvxVnni is
+// inherited from kAvx512 via RUY_INHERIT_PACK.
 
-      static constexpr int block_col_mask = ~(Layout::kCols - 1);  // High bits.
-      float* packed_ptr =
-          packed_matrix->data +
-          packed_matrix->layout.stride * (block_col & block_col_mask);
-      PackFloatAvxVnni(src_ptr, zerobuf, src_stride, remaining_src_cols,
-                       src_matrix.layout.rows, packed_ptr);
-    }
-  }
-};
 #endif  // RUY_PLATFORM(X86)
 
 }  // namespace ruy
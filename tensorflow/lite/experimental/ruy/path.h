@@ -85,8 +85,7 @@ enum class Path : std::uint8_t {
 #if RUY_PLATFORM(X86)
   // x86 architectures.
   //
-  // TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete /
-  // placeholder.
+  // TODO(b/147376783): SSE 4.2 support is incomplete / placeholder.
   // Optimization is not finished. In particular the dimensions of the kernel
   // blocks can be changed as desired.
   //
@@ -96,12 +95,7 @@ enum class Path : std::uint8_t {
   kAvx2 = 0x8,
   // Optimized for AVX-512.
   kAvx512 = 0x10,
-  // TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete /
-  // placeholder.
-  // Optimization is not finished. In particular the dimensions of the kernel
-  // blocks can be changed as desired.
-  //
-  // Optimized for AVX-VNNI.
+  // Optimized for AVX-512 VNNI (e.g. Cascade Lake and later).
   kAvxVnni = 0x20,
 #endif  // RUY_PLATFORM(X86)
 };
@@ -113,7 +113,7 @@ limitations under the License.
 #define RUY_DONOTUSEDIRECTLY_AVX2 0
 #endif
 
-// TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
+// TODO(b/147376783): SSE 4.2 support is incomplete / placeholder.
 // Optimization is not finished. In particular the dimensions of the kernel
 // blocks can be changed as desired.
 //
@@ -125,15 +125,9 @@ limitations under the License.
 #define RUY_DONOTUSEDIRECTLY_SSE42 0
 #endif
 
-// TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
-// Optimization is not finished. In particular the dimensions of the kernel
-// blocks can be changed as desired.
-//
 // Note that defined(__AVX512VBMI2__) can be false for compilation with
-// -march=cascadelake.
-// TODO(b/146646451) Check if we should also gate on defined(__AVX512VBMI2__).
-#if defined(RUY_ENABLE_VNNI_ENHANCEMENTS) && RUY_PLATFORM(AVX512) && \
-    defined(__AVX512VNNI__)
+// -march=cascadelake, and is not needed by the kernels.
+#if RUY_PLATFORM(AVX512) && defined(__AVX512VNNI__)
 #define RUY_DONOTUSEDIRECTLY_AVX_VNNI 1
 #else
 #define RUY_DONOTUSEDIRECTLY_AVX_VNNI 0
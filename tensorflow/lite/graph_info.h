@@ -45,6 +45,12 @@ class GraphInfo {
   // index.
   virtual size_t node_index(size_t index) const = 0;
 
+  // Returns the step at which the node at position `index` of the execution
+  // plan runs. Nodes sharing a step may run concurrently; a node's step is
+  // always greater than the steps of the nodes producing its inputs. By
+  // default every node has its own step.
+  virtual size_t node_step(size_t index) const { return index; }
+
   // Returns the indices of the input tensors.
   virtual const std::vector<int>& inputs() const = 0;
 
@@ -128,6 +128,12 @@ void Interpreter::SetExternalContext(TfLiteExternalContextType type,
   primary_subgraph().SetExternalContext(type, ctx);
 }
 
+void Interpreter::SetModelResources(std::shared_ptr<ModelResources> resources) {
+  model_resources_ = std::move(resources);
+  primary_subgraph().SetExternalContext(kTfLiteModelResourcesContext,
+                                        model_resources_.get());
+}
+
 TfLiteStatus Interpreter::SetInputs(std::vector<int> inputs) {
   return primary_subgraph().SetInputs(std::move(inputs));
 }
@@ -274,6 +280,18 @@ void Interpreter::SetCancellationFunction(void* data,
   }
 }
 
+void Interpreter::SetUseGreedyArenaPlanner(bool use_greedy_arena_planner) {
+  for (auto& subgraph : subgraphs_) {
+    subgraph->SetUseGreedyArenaPlanner(use_greedy_arena_planner);
+  }
+}
+
+void Interpreter::SetNumInterOpThreads(int num_threads) {
+  for (auto& subgraph : subgraphs_) {
+    subgraph->SetNumInterOpThreads(num_threads);
+  }
+}
+
 TfLiteStatus Interpreter::ModifyGraphWithDelegate(TfLiteDelegate* delegate) {
   for (auto& subgraph : subgraphs_) {
     TF_LITE_ENSURE_OK(context_, subgraph->ModifyGraphWithDelegate(delegate));
@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/resource/resource_base.h"
 #include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/memory_planner.h"
+#include "tensorflow/lite/model_resources.h"
 #include "tensorflow/lite/stderr_reporter.h"
 #include "tensorflow/lite/type_to_tflitetype.h"
 
@@ -357,6 +358,27 @@ class Interpreter {
   /// WARNING: This is an experimental API and subject to change.
   void SetCancellationFunction(void* data, bool (*check_cancelled_func)(void*));
 
+  /// Plans the memory of intermediate tensors by placing the largest tensors
+  /// first, against the lifetimes of all tensors of the graph, instead of
+  /// allocating them in execution order. This usually needs less memory for
+  /// large models. The planned and minimum arena sizes are logged. Must be
+  /// called before AllocateTensors(). Graphs with dynamic tensors keep using
+  /// the default planner.
+  /// default: disabled.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetUseGreedyArenaPlanner(bool use_greedy_arena_planner);
+
+  /// Runs ops that don't depend on each other concurrently, on up to
+  /// `num_threads` threads including the one calling Invoke(). The schedule
+  /// is computed by AllocateTensors(), which must be called again after this.
+  /// Only graphs without dynamic tensors are scheduled; custom ops, control
+  /// flow ops, delegated ops and ops using variable tensors always run alone.
+  /// Each thread runs ops with up to SetNumThreads() threads of its own, so
+  /// the two counts should be split between the available cores.
+  /// default: 1, i.e. ops run one at a time in execution plan order.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetNumInterOpThreads(int num_threads);
+
   /// Allow a delegate to look at the graph and modify the graph to handle
   /// parts of the graph themselves. After this is called, the graph may
   /// contain new nodes that replace 1 more nodes.
@@ -450,6 +472,15 @@ class Interpreter {
   void SetExternalContext(TfLiteExternalContextType type,
                           TfLiteExternalContext* ctx);
 
+  /// Shares the buffers that ops derive from constant tensors, like
+  /// dequantized weights, with the other interpreters using `resources`.
+  /// InterpreterBuilder sets the resources of the FlatBufferModel, so that
+  /// all the interpreters built from a model share them. The interpreter
+  /// keeps a reference to `resources`. Must be called before the ops are
+  /// prepared, i.e. before AllocateTensors() or ModifyGraphWithDelegate().
+  /// WARNING: This is an experimental API and subject to change.
+  void SetModelResources(std::shared_ptr<ModelResources> resources);
+
 #ifndef DOXYGEN_SKIP
   /// Adds `subgraphs_to_add` subgraphs, preserving pre-existing Subgraph
   /// entries. The value pointed to by `first_new_subgraph_index` will be set to
@@ -519,6 +550,10 @@ class Interpreter {
   // nullptr if necessary.
   std::unique_ptr<ExternalCpuBackendContext> own_external_cpu_backend_context_;
 
+  // The 'kTfLiteModelResourcesContext' external context, shared with the
+  // other interpreters of the model.
+  std::shared_ptr<ModelResources> model_resources_;
+
   // Subgraphs
   std::vector<std::unique_ptr<Subgraph>> subgraphs_;
 
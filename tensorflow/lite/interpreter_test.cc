@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <stdint.h>
 
+#include <algorithm>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "third_party/eigen3/Eigen/Core"
@@ -59,6 +61,7 @@ TfLiteRegistration* Register_NEG();
 }  // namespace ops
 namespace {
 
+using ::testing::ElementsAre;
 using ::testing::IsEmpty;
 
 // Make an interpreter that has no tensors and no nodes
@@ -606,6 +609,141 @@ TfLiteRegistration GetPassthroughOpRegistration() {
   return reg;
 }
 
+// Op that does output = input and counts how many times it is prepared in the
+// int passed as its init data.
+TfLiteRegistration GetCountingPassthroughOpRegistration() {
+  TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+  reg.init = [](TfLiteContext* context, const char* buffer, size_t) -> void* {
+    return const_cast<char*>(buffer);
+  };
+  reg.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    ++*static_cast<int*>(node->user_data);
+    const TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    return context->ResizeTensor(context, output,
+                                 TfLiteIntArrayCopy(input->dims));
+  };
+  reg.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    const TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    std::copy(input->data.f, input->data.f + NumElements(input),
+              output->data.f);
+    return kTfLiteOk;
+  };
+  return reg;
+}
+
+TEST(BasicInterpreter, ResizeInputTensorOnlyPreparesAffectedOps) {
+  // Two branches, 0 -> 1 -> 4 and 2 -> 3.
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(5), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0, 2}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3, 4}), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {2}, quant),
+              kTfLiteOk);
+  }
+
+  TfLiteRegistration reg = GetCountingPassthroughOpRegistration();
+  int prepare_count[3] = {0, 0, 0};
+  ASSERT_EQ(interpreter.AddNodeWithParameters(
+                {0}, {1}, reinterpret_cast<const char*>(&prepare_count[0]),
+                sizeof(int), nullptr, &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters(
+                {2}, {3}, reinterpret_cast<const char*>(&prepare_count[1]),
+                sizeof(int), nullptr, &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters(
+                {1}, {4}, reinterpret_cast<const char*>(&prepare_count[2]),
+                sizeof(int), nullptr, &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_THAT(prepare_count, ElementsAre(1, 1, 1));
+
+  // Only the branch of the resized input is prepared again.
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {5}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_THAT(prepare_count, ElementsAre(2, 1, 2));
+  ASSERT_EQ(NumElements(interpreter.tensor(4)), 5);
+  for (int i = 0; i < 5; ++i) interpreter.typed_tensor<float>(0)[i] = i;
+  for (int i = 0; i < 2; ++i) interpreter.typed_tensor<float>(2)[i] = -i;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(interpreter.typed_tensor<float>(4)[i], i);
+  }
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(interpreter.typed_tensor<float>(3)[i], -i);
+  }
+
+  // Going back to the previous shape works the same way.
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {2}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_THAT(prepare_count, ElementsAre(3, 1, 3));
+  ASSERT_EQ(NumElements(interpreter.tensor(4)), 2);
+
+  // Any other change to the graph prepares every op again.
+  ASSERT_EQ(interpreter.SetTensorParametersReadWrite(1, kTfLiteFloat32, "",
+                                                     {2}, quant),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.ResizeInputTensor(2, {3}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_THAT(prepare_count, ElementsAre(4, 2, 4));
+}
+
+TEST(BasicInterpreter, InterOpThreadsRunIndependentOpsConcurrently) {
+  // Two branches, 0 -> 1 -> 4 and 2 -> 3.
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(5), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0, 2}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3, 4}), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {3}, quant),
+              kTfLiteOk);
+  }
+
+  TfLiteRegistration reg = GetCountingPassthroughOpRegistration();
+  int prepare_count[3] = {0, 0, 0};
+  ASSERT_EQ(interpreter.AddNodeWithParameters(
+                {0}, {1}, reinterpret_cast<const char*>(&prepare_count[0]),
+                sizeof(int), nullptr, &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters(
+                {2}, {3}, reinterpret_cast<const char*>(&prepare_count[1]),
+                sizeof(int), nullptr, &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters(
+                {1}, {4}, reinterpret_cast<const char*>(&prepare_count[2]),
+                sizeof(int), nullptr, &reg),
+            kTfLiteOk);
+  interpreter.SetNumInterOpThreads(2);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_THAT(interpreter.subgraph(0)->inter_op_schedule(),
+              ElementsAre(0, 0, 1));
+
+  // The first run warms up one op at a time, the next ones run concurrently.
+  for (int run = 0; run < 3; ++run) {
+    for (int i = 0; i < 3; ++i) {
+      interpreter.typed_tensor<float>(0)[i] = run + i;
+      interpreter.typed_tensor<float>(2)[i] = -run - i;
+    }
+    ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(interpreter.typed_tensor<float>(4)[i], run + i);
+      EXPECT_EQ(interpreter.typed_tensor<float>(3)[i], -run - i);
+    }
+  }
+
+  interpreter.SetNumInterOpThreads(1);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_TRUE(interpreter.subgraph(0)->inter_op_schedule().empty());
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+}
+
 TEST(BasicInterpreter, OneOpInterpreter) {
   Interpreter interpreter;
   ASSERT_EQ(interpreter.AddTensors(2), kTfLiteOk);
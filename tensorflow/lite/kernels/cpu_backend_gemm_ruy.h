@@ -84,10 +84,17 @@ struct GemmImplUsingRuy {
 // If Ruy is not selected intentionally (TFLITE_WITH_RUY not defined)
 // and GEMMLOWP_NEON is absent, we fall back to Ruy for some quantized
 // kernels. Some Ruy paths are still experimental, so we restrict to reference
-// code in that case.
+// code and to the finished x86 paths, which are selected at runtime based on
+// the CPU features that are actually available.
 #if !defined(TFLITE_WITH_RUY) && !defined(GEMMLOWP_NEON)
+#if RUY_PLATFORM(X86)
+    constexpr ruy::Path kRuyPath =
+        ruy::Path::kReference | ruy::Path::kStandardCpp | ruy::Path::kAvx2 |
+        ruy::Path::kAvx512 | ruy::Path::kAvxVnni;
+#else
     constexpr ruy::Path kRuyPath =
         ruy::Path::kReference | ruy::Path::kStandardCpp;
+#endif
 #else
     constexpr ruy::Path kRuyPath = ruy::kAllPaths;
 #endif
@@ -17,6 +17,7 @@ limitations under the License.
 #include <string.h>
 
 #include <cstdint>
+#include <cstdio>
 #include <vector>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/op_macros.h"
+#include "tensorflow/lite/model_resources.h"
 
 namespace tflite {
 namespace ops {
@@ -53,6 +55,50 @@ void Free(TfLiteContext* context, void* buffer) {
   delete reinterpret_cast<OpData*>(buffer);
 }
 
+TfLiteStatus Densify(TfLiteContext* context, const TfLiteTensor* input,
+                     TfLiteTensor* output) {
+  switch (input->type) {
+    case kTfLiteFloat32:
+      reference_ops::Densify(input->sparsity, GetTensorShape(input),
+                             GetTensorData<float>(input),
+                             GetTensorShape(output),
+                             GetTensorData<float>(output));
+      break;
+    case kTfLiteInt8:
+      reference_ops::Densify(input->sparsity, GetTensorShape(input),
+                             GetTensorData<int8_t>(input),
+                             GetTensorShape(output),
+                             GetTensorData<int8_t>(output));
+      break;
+
+    default:
+      context->ReportError(context, "Type %d not supported.", input->type);
+      return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+// Points the output to the dense weights shared by the interpreters of the
+// model, densifying them if no interpreter did yet.
+TfLiteStatus ShareDenseWeights(TfLiteContext* context,
+                               ModelResources* resources,
+                               OpContext* op_context) {
+  const TfLiteTensor* input = op_context->input;
+  TfLiteTensor* output = op_context->output;
+  char derivation[32];
+  snprintf(derivation, sizeof(derivation), "densify:%d:%zu", input->type,
+           output->bytes);
+  const void* weights = resources->GetOrCreate(
+      input->data.raw, derivation, output->bytes, [&](void* buffer) {
+        output->data.raw = static_cast<char*>(buffer);
+        return Densify(context, input, output);
+      });
+  TF_LITE_ENSURE(context, weights != nullptr);
+  output->allocation_type = kTfLiteMmapRo;
+  output->data.raw = static_cast<char*>(const_cast<void*>(weights));
+  return kTfLiteOk;
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 1);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
@@ -63,41 +109,36 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE(context, IsConstantTensor(op_context.input));
   TF_LITE_ENSURE(context, op_context.input->sparsity != nullptr);
 
+  // An output already sharing the weights of the model is up to date.
+  if (op_context.output->allocation_type == kTfLiteMmapRo) {
+    return kTfLiteOk;
+  }
+
   op_context.output->type = op_context.input->type;
   op_context.output->allocation_type = kTfLiteArenaRwPersistent;
 
-  return context->ResizeTensor(context, op_context.output,
-                               TfLiteIntArrayCopy(op_context.input->dims));
+  TF_LITE_ENSURE_STATUS(
+      context->ResizeTensor(context, op_context.output,
+                            TfLiteIntArrayCopy(op_context.input->dims)));
+
+  // When the interpreter shares resources with the other interpreters of the
+  // model, the weights are densified once for all of them, right away.
+  ModelResources* resources = ModelResources::GetFromContext(context);
+  if (resources != nullptr) {
+    return ShareDenseWeights(context, resources, &op_context);
+  }
+  return kTfLiteOk;
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
   OpContext op_context(context, node);
-  if (op_data->dense_weights_initialized) {
+  if (op_data->dense_weights_initialized ||
+      op_context.output->allocation_type == kTfLiteMmapRo) {
     return kTfLiteOk;
   }
 
-  switch (op_context.input->type) {
-    case kTfLiteFloat32:
-      reference_ops::Densify(op_context.input->sparsity,
-                             GetTensorShape(op_context.input),
-                             GetTensorData<float>(op_context.input),
-                             GetTensorShape(op_context.output),
-                             GetTensorData<float>(op_context.output));
-      break;
-    case kTfLiteInt8:
-      reference_ops::Densify(op_context.input->sparsity,
-                             GetTensorShape(op_context.input),
-                             GetTensorData<int8_t>(op_context.input),
-                             GetTensorShape(op_context.output),
-                             GetTensorData<int8_t>(op_context.output));
-      break;
-
-    default:
-      context->ReportError(context, "Type %d not supported.",
-                           op_context.input->type);
-      return kTfLiteError;
-  }
+  TF_LITE_ENSURE_STATUS(Densify(context, op_context.input, op_context.output));
 
   op_data->dense_weights_initialized = true;
   return kTfLiteOk;
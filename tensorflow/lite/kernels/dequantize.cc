@@ -17,12 +17,14 @@ limitations under the License.
 #include <string.h>
 
 #include <cstdint>
+#include <cstdio>
 #include <vector>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/op_macros.h"
+#include "tensorflow/lite/model_resources.h"
 
 namespace tflite {
 namespace ops {
@@ -53,6 +55,30 @@ void Free(TfLiteContext* context, void* buffer) {
   delete reinterpret_cast<OpData*>(buffer);
 }
 
+// Points the output of a constant input to the dequantized weights shared by
+// the interpreters of the model, dequantizing them if no interpreter did yet.
+template <KernelType kernel_type>
+TfLiteStatus ShareDequantizedWeights(TfLiteContext* context, TfLiteNode* node,
+                                     ModelResources* resources,
+                                     OpContext* op_context) {
+  const TfLiteTensor* input = op_context->input;
+  TfLiteTensor* output = op_context->output;
+  char derivation[64];
+  snprintf(derivation, sizeof(derivation), "dequantize:%d:%d:%zu:%a:%d",
+           kernel_type, input->type, input->bytes, input->params.scale,
+           input->params.zero_point);
+  const void* weights = resources->GetOrCreate(
+      input->data.raw, derivation, output->bytes, [&](void* buffer) {
+        output->data.raw = static_cast<char*>(buffer);
+        return DequantizeImpl<kernel_type>(context, node, input, output);
+      });
+  TF_LITE_ENSURE(context, weights != nullptr);
+  output->allocation_type = kTfLiteMmapRo;
+  output->data.raw = static_cast<char*>(const_cast<void*>(weights));
+  return kTfLiteOk;
+}
+
+template <KernelType kernel_type>
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 1);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
@@ -64,20 +90,38 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                               op_context.input->type == kTfLiteInt16 ||
                               op_context.input->type == kTfLiteFloat16);
 
+  // An output already sharing the weights of the model is up to date.
+  if (op_context.output->allocation_type == kTfLiteMmapRo) {
+    return kTfLiteOk;
+  }
+
   op_context.output->type = kTfLiteFloat32;
   // If the input tensor is constant, we can persist the dequantized value in
   // the output tensor. Otherwise we run dequantize upon each eval.
   if (IsConstantTensor(op_context.input)) {
     op_context.output->allocation_type = kTfLiteArenaRwPersistent;
   }
-  return context->ResizeTensor(context, op_context.output,
-                               TfLiteIntArrayCopy(op_context.input->dims));
+  TF_LITE_ENSURE_STATUS(
+      context->ResizeTensor(context, op_context.output,
+                            TfLiteIntArrayCopy(op_context.input->dims)));
+
+  // When the interpreter shares resources with the other interpreters of the
+  // model, constant inputs are dequantized once for all of them, right away.
+  ModelResources* resources = ModelResources::GetFromContext(context);
+  if (IsConstantTensor(op_context.input) && resources != nullptr) {
+    return ShareDequantizedWeights<kernel_type>(context, node, resources,
+                                                &op_context);
+  }
+  return kTfLiteOk;
 }
 
 template <KernelType kernel_type>
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
   OpContext op_context(context, node);
+  if (op_context.output->allocation_type == kTfLiteMmapRo) {
+    return kTfLiteOk;
+  }
   if (IsConstantTensor(op_context.input) &&
       op_data->float_dequantized_weights_initialized) {
     return kTfLiteOk;
@@ -99,14 +143,15 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
 TfLiteRegistration* Register_DEQUANTIZE_OPT() {
   static TfLiteRegistration r = {
-      dequantize::Init, dequantize::Free, dequantize::Prepare,
+      dequantize::Init, dequantize::Free,
+      dequantize::Prepare<dequantize::kGenericOptimized>,
       dequantize::Eval<dequantize::kGenericOptimized>};
   return &r;
 }
 
 TfLiteRegistration* Register_DEQUANTIZE_REF() {
   static TfLiteRegistration r = {dequantize::Init, dequantize::Free,
-                                 dequantize::Prepare,
+                                 dequantize::Prepare<dequantize::kReference>,
                                  dequantize::Eval<dequantize::kReference>};
   return &r;
 }
@@ -23,10 +23,12 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
 #include "tensorflow/lite/kernels/internal/reference/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/reference/reference_ops.h"
+#include "tensorflow/lite/kernels/internal/reference/sparse_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
@@ -109,6 +111,76 @@ inline TfLiteStatus CheckTypes(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+// Sparse weights are run without densifying them when they use the block CSR
+// format of 2-D tensors: traversal order {0, 1, [2]}, a dense dimension of
+// output rows, a CSR dimension of blocks of input columns, and for blocks
+// wider than 1 a dense block dimension mapped to the input columns.
+TfLiteStatus CheckSparseWeights(TfLiteContext* context,
+                                const TfLiteTensor* input,
+                                const TfLiteTensor* filter,
+                                const TfLiteTensor* output,
+                                TfLiteFullyConnectedParams* params) {
+  TF_LITE_ENSURE(context, IsConstantTensor(filter));
+  TF_LITE_ENSURE_EQ(context, params->weights_format,
+                    kTfLiteFullyConnectedWeightsFormatDefault);
+  if (filter->type == kTfLiteInt8) {
+    // The blocks left out must be zeros, and hybrid execution isn't supported.
+    TF_LITE_ENSURE_EQ(context, filter->params.zero_point, 0);
+    TF_LITE_ENSURE_EQ(context, input->type, kTfLiteInt8);
+    TF_LITE_ENSURE_EQ(context, output->type, kTfLiteInt8);
+  } else {
+    TF_LITE_ENSURE_EQ(context, filter->type, kTfLiteFloat32);
+  }
+
+  const TfLiteSparsity& sparsity = *filter->sparsity;
+  const int dim_metadata_size = sparsity.dim_metadata_size;
+  TF_LITE_ENSURE(context, dim_metadata_size == 2 || dim_metadata_size == 3);
+  TF_LITE_ENSURE(context, sparsity.traversal_order != nullptr);
+  TF_LITE_ENSURE_EQ(context, sparsity.traversal_order->size,
+                    dim_metadata_size);
+  for (int i = 0; i < dim_metadata_size; ++i) {
+    TF_LITE_ENSURE_EQ(context, sparsity.traversal_order->data[i], i);
+  }
+  const int rows = SizeOfDimension(filter, 0);
+  const int cols = SizeOfDimension(filter, 1);
+  int block_cols = 1;
+  if (dim_metadata_size == 3) {
+    TF_LITE_ENSURE(context, sparsity.block_map != nullptr &&
+                                sparsity.block_map->size == 1 &&
+                                sparsity.block_map->data[0] == 1);
+    TF_LITE_ENSURE_EQ(context, sparsity.dim_metadata[2].format,
+                      kTfLiteDimDense);
+    block_cols = sparsity.dim_metadata[2].dense_size;
+    TF_LITE_ENSURE(context, block_cols > 0 && cols % block_cols == 0);
+  } else {
+    TF_LITE_ENSURE(context, sparsity.block_map == nullptr ||
+                                sparsity.block_map->size == 0);
+  }
+
+  TF_LITE_ENSURE_EQ(context, sparsity.dim_metadata[0].format,
+                    kTfLiteDimDense);
+  TF_LITE_ENSURE_EQ(context, sparsity.dim_metadata[0].dense_size, rows);
+  TF_LITE_ENSURE_EQ(context, sparsity.dim_metadata[1].format,
+                    kTfLiteDimSparseCSR);
+  const TfLiteIntArray* segments = sparsity.dim_metadata[1].array_segments;
+  const TfLiteIntArray* indices = sparsity.dim_metadata[1].array_indices;
+  TF_LITE_ENSURE_EQ(context, segments->size, rows + 1);
+  TF_LITE_ENSURE_EQ(context, segments->data[0], 0);
+  for (int row = 0; row < rows; ++row) {
+    TF_LITE_ENSURE(context, segments->data[row] <= segments->data[row + 1]);
+  }
+  TF_LITE_ENSURE_EQ(context, segments->data[rows], indices->size);
+  for (int i = 0; i < indices->size; ++i) {
+    TF_LITE_ENSURE(context, indices->data[i] >= 0 &&
+                                indices->data[i] < cols / block_cols);
+  }
+  const size_t element_size =
+      filter->type == kTfLiteInt8 ? sizeof(int8_t) : sizeof(float);
+  TF_LITE_ENSURE_EQ(context, filter->bytes,
+                    indices->size * block_cols * element_size);
+  return kTfLiteOk;
+}
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   // This is a builtin op, so we don't use the contents in 'buffer', if any.
   // Instead, we allocate a new object to carry information from Prepare() to
@@ -147,6 +219,10 @@ TfLiteStatus PrepareImpl(TfLiteContext* context, TfLiteNode* node) {
   // Check proper datatype match among all Input Tensors
   TF_LITE_ENSURE_STATUS(
       CheckTypes(context, input, filter, bias, output, params));
+  if (filter->sparsity != nullptr) {
+    TF_LITE_ENSURE_STATUS(
+        CheckSparseWeights(context, input, filter, output, params));
+  }
 
   // Check all the parameters of tensor match within themselves and match the
   // input configuration.
@@ -364,7 +440,23 @@ void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
   op_params.output_shift = data->output_shift;
   op_params.quantized_activation_min = data->output_activation_min;
   op_params.quantized_activation_max = data->output_activation_max;
-  if (kernel_type == kReference) {
+  if (filter->sparsity != nullptr) {
+    if (kernel_type == kReference) {
+      reference_ops::FullyConnectedSparseWeight(
+          *filter->sparsity, op_params, GetTensorShape(input),
+          GetTensorData<int8_t>(input), GetTensorShape(filter),
+          GetTensorData<int8_t>(filter), GetTensorShape(bias),
+          GetTensorData<int32_t>(bias), GetTensorShape(output),
+          GetTensorData<int8_t>(output));
+    } else {
+      optimized_ops::FullyConnectedSparseWeight(
+          *filter->sparsity, op_params, GetTensorShape(input),
+          GetTensorData<int8_t>(input), GetTensorShape(filter),
+          GetTensorData<int8_t>(filter), GetTensorShape(bias),
+          GetTensorData<int32_t>(bias), GetTensorShape(output),
+          GetTensorData<int8_t>(output), cpu_backend_context);
+    }
+  } else if (kernel_type == kReference) {
     reference_integer_ops::FullyConnected(
         op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
         GetTensorShape(filter), GetTensorData<int8_t>(filter),
@@ -513,7 +605,27 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
   float output_activation_min, output_activation_max;
   CalculateActivationRange(params->activation, &output_activation_min,
                            &output_activation_max);
-  if (kernel_type == kReference) {
+  if (filter->sparsity != nullptr) {
+    FullyConnectedParams op_params;
+    op_params.float_activation_min = output_activation_min;
+    op_params.float_activation_max = output_activation_max;
+    if (kernel_type == kReference) {
+      reference_ops::FullyConnectedSparseWeight(
+          *filter->sparsity, op_params, GetTensorShape(input),
+          GetTensorData<float>(input), GetTensorShape(filter),
+          GetTensorData<float>(filter), GetTensorShape(bias),
+          GetTensorData<float>(bias), GetTensorShape(output),
+          GetTensorData<float>(output));
+    } else {
+      optimized_ops::FullyConnectedSparseWeight(
+          *filter->sparsity, op_params, GetTensorShape(input),
+          GetTensorData<float>(input), GetTensorShape(filter),
+          GetTensorData<float>(filter), GetTensorShape(bias),
+          GetTensorData<float>(bias), GetTensorShape(output),
+          GetTensorData<float>(output),
+          CpuBackendContext::GetFromContext(context));
+    }
+  } else if (kernel_type == kReference) {
     FullyConnectedParams op_params;
     op_params.float_activation_min = output_activation_min;
     op_params.float_activation_max = output_activation_max;
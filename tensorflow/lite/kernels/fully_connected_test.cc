@@ -326,6 +326,58 @@ class HybridFullyConnectedOpModel : public SingleOpModel {
   int input_size_;
 };
 
+// Fully connected with constant block-sparse weights, which the kernel runs
+// without densifying them.
+class SparseFullyConnectedOpModel : public SingleOpModel {
+ public:
+  template <typename T>
+  SparseFullyConnectedOpModel(TfLiteRegistration* registration, int units,
+                              const TensorData& input,
+                              const TensorData& weights,
+                              const std::vector<T>& weights_data,
+                              int block_cols, const TensorData& output,
+                              int num_threads = -1) {
+    input_ = AddInput(input);
+    weights_ = AddConstSparseInput(weights, weights_data, block_cols);
+    if (input.type == TensorType_FLOAT32) {
+      bias_ = AddInput({TensorType_FLOAT32, {units}});
+    } else {
+      auto bias_scale = GetScale(input_) * GetScale(weights_);
+      bias_ = AddInput({TensorType_INT32, {units}, 0, 0, bias_scale});
+    }
+    output_ = AddOutput(output);
+
+    SetBuiltinOp(
+        BuiltinOperator_FULLY_CONNECTED, BuiltinOptions_FullyConnectedOptions,
+        CreateFullyConnectedOptions(builder_, ActivationFunctionType_NONE)
+            .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    BuildInterpreter({GetShape(input_), {}, GetShape(bias_)}, num_threads);
+  }
+
+  void SetBias(const std::vector<float>& f) { PopulateTensor(bias_, f); }
+  void SetInput(const std::vector<float>& f) { PopulateTensor(input_, f); }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+  void SetQuantizedBias(const std::vector<float>& data) {
+    QuantizeAndPopulate<int32_t>(bias_, data);
+  }
+  void SetQuantizedInput(const std::vector<float>& data) {
+    QuantizeAndPopulate<int8_t>(input_, data);
+  }
+  std::vector<float> GetDequantizedOutput() {
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_),
+                              GetScale(output_), GetZeroPoint(output_));
+  }
+
+ protected:
+  int input_;
+  int weights_;
+  int bias_;
+  int output_;
+};
+
 const auto kKernelMap = new std::map<string, TfLiteRegistration*>({
     {"Reference", ops::builtin::Register_FULLY_CONNECTED_REF()},
     {"GenericOptimized", ops::builtin::Register_FULLY_CONNECTED_GENERIC_OPT()},
@@ -957,6 +1009,112 @@ TEST_P(QuantizedFullyConnectedOpTest,
               ElementsAre(175, 177, 179, 243, 245, 247));
 }
 
+TEST_P(FloatFullyConnectedOpTest, SparseWeights1x4) {
+  SparseFullyConnectedOpModel m(GetRegistration(), /*units=*/3,
+                                /*input=*/{TensorType_FLOAT32, {2, 8}},
+                                /*weights=*/{TensorType_FLOAT32, {3, 8}},
+                                std::vector<float>{
+                                    1, 2, 3, 4, 0, 0, 0, 0,  // u = 0
+                                    0, 0, 0, 0, 0, 0, 0, 0,  // u = 1
+                                    0, 0, 0, 0, 5, 6, 7, 8,  // u = 2
+                                },
+                                /*block_cols=*/4,
+                                /*output=*/{TensorType_FLOAT32});
+  m.SetBias({1, 2, 3});
+
+  m.SetInput({
+      1, 1, 1, 1, 1,  1,  1,  1,   // b = 0
+      1, 2, 3, 4, -1, -2, -3, -4,  // b = 1
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(), ElementsAre(11, 2, 29, 31, 2, -67));
+}
+
+TEST_P(FloatFullyConnectedOpTest, SparseWeightsRandom) {
+  SparseFullyConnectedOpModel m(GetRegistration(), /*units=*/2,
+                                /*input=*/{TensorType_FLOAT32, {1, 3}},
+                                /*weights=*/{TensorType_FLOAT32, {2, 3}},
+                                std::vector<float>{
+                                    0, 2, 0,   // u = 0
+                                    3, 0, -1,  // u = 1
+                                },
+                                /*block_cols=*/1,
+                                /*output=*/{TensorType_FLOAT32});
+  m.SetBias({0.5, -0.5});
+
+  m.SetInput({1, 2, 3});
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(), ElementsAre(4.5, -0.5));
+}
+
+TEST_P(FloatFullyConnectedOpTest, SparseWeightsMultithreaded) {
+  constexpr int kUnits = 40;
+  constexpr int kInputSize = 16;
+  constexpr int kBatches = 2;
+  std::vector<float> weights(kUnits * kInputSize, 0.0f);
+  std::vector<float> input(kBatches * kInputSize);
+  std::vector<float> bias(kUnits);
+  for (int u = 0; u < kUnits; ++u) {
+    // Keeps one block of 8 columns out of two, alternating between rows.
+    const int block = u % 2;
+    for (int i = 0; i < 8; ++i) {
+      weights[u * kInputSize + block * 8 + i] = (u + i) % 5 - 2;
+    }
+    bias[u] = u;
+  }
+  for (int i = 0; i < kBatches * kInputSize; ++i) {
+    input[i] = i % 7 - 3;
+  }
+  std::vector<float> expected;
+  for (int b = 0; b < kBatches; ++b) {
+    for (int u = 0; u < kUnits; ++u) {
+      float total = bias[u];
+      for (int i = 0; i < kInputSize; ++i) {
+        total += weights[u * kInputSize + i] * input[b * kInputSize + i];
+      }
+      expected.push_back(total);
+    }
+  }
+
+  SparseFullyConnectedOpModel m(
+      GetRegistration(), kUnits,
+      /*input=*/{TensorType_FLOAT32, {kBatches, kInputSize}},
+      /*weights=*/{TensorType_FLOAT32, {kUnits, kInputSize}}, weights,
+      /*block_cols=*/8, /*output=*/{TensorType_FLOAT32}, /*num_threads=*/3);
+  m.SetBias(bias);
+  m.SetInput(input);
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear(expected)));
+}
+
+TEST_P(QuantizedFullyConnectedOpTest, SparseWeights1x4QuantizedInt8) {
+  SparseFullyConnectedOpModel m(
+      GetRegistration(), /*units=*/2,
+      /*input=*/{TensorType_INT8, {1, 8}, -63.5, 64},
+      /*weights=*/{TensorType_INT8, {2, 8}, 0, 0, /*scale=*/1.0},
+      std::vector<int8_t>{
+          1, 2, 3, 4, 0,  0, 0,  0,  // u = 0
+          0, 0, 0, 0, -1, 1, -1, 1,  // u = 1
+      },
+      /*block_cols=*/4,
+      /*output=*/{TensorType_INT8, {}, -127, 128});
+  m.SetQuantizedBias({1, -1});
+
+  m.SetQuantizedInput({1, 2, 3, 4, 5, 6, 7, 8});
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetDequantizedOutput(), ElementsAreArray(ArrayFloatNear({
+                                            31, 1,
+                                        })));
+}
+
 INSTANTIATE_TEST_SUITE_P(
     FloatFullyConnectedOpTest, FloatFullyConnectedOpTest,
     ::testing::ValuesIn(SingleOpTest::GetKernelTags(*kKernelMap)));
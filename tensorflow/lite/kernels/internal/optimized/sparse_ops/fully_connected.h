@@ -0,0 +1,313 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/experimental/ruy/profiler/instrumentation.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/optimized/neon_check.h"
+#include "tensorflow/lite/kernels/internal/reference/sparse_ops/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+namespace optimized_ops {
+
+// Block microkernels of FullyConnectedSparseWeight(): each returns the dot
+// product of the non-zero weight blocks [begin, end) of one output row with
+// the matching input columns. The *Block4 variants need blocks whose width
+// is a multiple of 4, as produced for 1x4 block sparsity, and accumulate in
+// independent lanes.
+inline float SparseRowDotBlock4(const float* weights, const int* indices,
+                                int begin, int end, int block_cols,
+                                const float* input) {
+#ifdef USE_NEON
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  for (int i = begin; i < end; ++i) {
+    const float* block_weights = weights + i * block_cols;
+    const float* block_input = input + indices[i] * block_cols;
+    for (int c = 0; c < block_cols; c += 4) {
+      acc = vmlaq_f32(acc, vld1q_f32(block_weights + c),
+                      vld1q_f32(block_input + c));
+    }
+  }
+  return vgetq_lane_f32(acc, 0) + vgetq_lane_f32(acc, 1) +
+         vgetq_lane_f32(acc, 2) + vgetq_lane_f32(acc, 3);
+#else
+  // Written so that compilers vectorize it on other targets.
+  float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  for (int i = begin; i < end; ++i) {
+    const float* block_weights = weights + i * block_cols;
+    const float* block_input = input + indices[i] * block_cols;
+    for (int c = 0; c < block_cols; c += 4) {
+      for (int j = 0; j < 4; ++j) {
+        acc[j] += block_weights[c + j] * block_input[c + j];
+      }
+    }
+  }
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+#endif
+}
+
+inline float SparseRowDot(const float* weights, const int* indices, int begin,
+                          int end, int block_cols, const float* input) {
+  if (block_cols % 4 == 0) {
+    return SparseRowDotBlock4(weights, indices, begin, end, block_cols, input);
+  }
+  float total = 0.0f;
+  for (int i = begin; i < end; ++i) {
+    const float* block_weights = weights + i * block_cols;
+    const float* block_input = input + indices[i] * block_cols;
+    for (int c = 0; c < block_cols; ++c) {
+      total += block_weights[c] * block_input[c];
+    }
+  }
+  return total;
+}
+
+// The int8 variants also return the sum of the weights, so that the input
+// offset is applied once per row rather than once per product.
+inline int32 SparseRowDotBlock4(const int8_t* weights, const int* indices,
+                                int begin, int end, int block_cols,
+                                const int8_t* input, int32* weights_sum) {
+  int32 acc[4] = {0, 0, 0, 0};
+  int32 sum[4] = {0, 0, 0, 0};
+  for (int i = begin; i < end; ++i) {
+    const int8_t* block_weights = weights + i * block_cols;
+    const int8_t* block_input = input + indices[i] * block_cols;
+    for (int c = 0; c < block_cols; c += 4) {
+      for (int j = 0; j < 4; ++j) {
+        acc[j] += block_weights[c + j] * block_input[c + j];
+        sum[j] += block_weights[c + j];
+      }
+    }
+  }
+  *weights_sum = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+#ifdef USE_NEON
+inline int32 SparseRowDotBlock8(const int8_t* weights, const int* indices,
+                                int begin, int end, int block_cols,
+                                const int8_t* input, int32* weights_sum) {
+  int32x4_t acc = vdupq_n_s32(0);
+  int32x4_t sum = vdupq_n_s32(0);
+  for (int i = begin; i < end; ++i) {
+    const int8_t* block_weights = weights + i * block_cols;
+    const int8_t* block_input = input + indices[i] * block_cols;
+    for (int c = 0; c < block_cols; c += 8) {
+      const int8x8_t w = vld1_s8(block_weights + c);
+      // The products of two int8 values fit in int16.
+      acc = vpadalq_s16(acc, vmull_s8(w, vld1_s8(block_input + c)));
+      sum = vpadalq_s16(sum, vmovl_s8(w));
+    }
+  }
+  *weights_sum = vgetq_lane_s32(sum, 0) + vgetq_lane_s32(sum, 1) +
+                 vgetq_lane_s32(sum, 2) + vgetq_lane_s32(sum, 3);
+  return vgetq_lane_s32(acc, 0) + vgetq_lane_s32(acc, 1) +
+         vgetq_lane_s32(acc, 2) + vgetq_lane_s32(acc, 3);
+}
+#endif  // USE_NEON
+
+inline int32 SparseRowDot(const int8_t* weights, const int* indices, int begin,
+                          int end, int block_cols, const int8_t* input,
+                          int32* weights_sum) {
+#ifdef USE_NEON
+  if (block_cols % 8 == 0) {
+    return SparseRowDotBlock8(weights, indices, begin, end, block_cols, input,
+                              weights_sum);
+  }
+#endif  // USE_NEON
+  if (block_cols % 4 == 0) {
+    return SparseRowDotBlock4(weights, indices, begin, end, block_cols, input,
+                              weights_sum);
+  }
+  int32 acc = 0;
+  int32 sum = 0;
+  for (int i = begin; i < end; ++i) {
+    const int8_t* block_weights = weights + i * block_cols;
+    const int8_t* block_input = input + indices[i] * block_cols;
+    for (int c = 0; c < block_cols; ++c) {
+      acc += block_weights[c] * block_input[c];
+      sum += block_weights[c];
+    }
+  }
+  *weights_sum = sum;
+  return acc;
+}
+
+// Computes the output rows [row_start, row_end) of all the batches.
+template <typename InputScalar, typename BiasScalar>
+struct FullyConnectedSparseWeightTask : cpu_backend_threadpool::Task {
+  FullyConnectedSparseWeightTask(
+      const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+      const InputScalar* input_data, const InputScalar* weights_data,
+      const BiasScalar* bias_data, InputScalar* output_data, int batches,
+      int output_depth, int accum_depth, int row_start, int row_end)
+      : params(params),
+        input_data(input_data),
+        weights_data(weights_data),
+        bias_data(bias_data),
+        output_data(output_data),
+        segments(sparsity.dim_metadata[1].array_segments->data),
+        indices(sparsity.dim_metadata[1].array_indices->data),
+        block_cols(reference_ops::SparseWeightBlockCols(sparsity)),
+        batches(batches),
+        output_depth(output_depth),
+        accum_depth(accum_depth),
+        row_start(row_start),
+        row_end(row_end) {}
+
+  void Run() override;
+
+  const FullyConnectedParams& params;
+  const InputScalar* input_data;
+  const InputScalar* weights_data;
+  const BiasScalar* bias_data;
+  InputScalar* output_data;
+  const int* segments;
+  const int* indices;
+  const int block_cols;
+  const int batches;
+  const int output_depth;
+  const int accum_depth;
+  const int row_start;
+  const int row_end;
+};
+
+template <>
+inline void FullyConnectedSparseWeightTask<float, float>::Run() {
+  for (int out_c = row_start; out_c < row_end; ++out_c) {
+    const float bias_value = bias_data ? bias_data[out_c] : 0.0f;
+    for (int b = 0; b < batches; ++b) {
+      const float total =
+          SparseRowDot(weights_data, indices, segments[out_c],
+                       segments[out_c + 1], block_cols,
+                       input_data + b * accum_depth);
+      output_data[out_c + output_depth * b] = ActivationFunctionWithMinMax(
+          total + bias_value, params.float_activation_min,
+          params.float_activation_max);
+    }
+  }
+}
+
+template <>
+inline void FullyConnectedSparseWeightTask<int8_t, int32>::Run() {
+  for (int out_c = row_start; out_c < row_end; ++out_c) {
+    const int32 bias_value = bias_data ? bias_data[out_c] : 0;
+    for (int b = 0; b < batches; ++b) {
+      int32 weights_sum;
+      int32 acc = SparseRowDot(weights_data, indices, segments[out_c],
+                               segments[out_c + 1], block_cols,
+                               input_data + b * accum_depth, &weights_sum);
+      acc += params.input_offset * weights_sum + bias_value;
+      acc = MultiplyByQuantizedMultiplier(acc, params.output_multiplier,
+                                          params.output_shift);
+      acc += params.output_offset;
+      acc = std::max(acc, params.quantized_activation_min);
+      acc = std::min(acc, params.quantized_activation_max);
+      output_data[out_c + output_depth * b] = static_cast<int8_t>(acc);
+    }
+  }
+}
+
+// Splits the output rows of the sparse weights among the threads of
+// `cpu_backend_context`. Rows are balanced by count rather than by number of
+// non-zero blocks, which pruning keeps roughly uniform.
+template <typename InputScalar, typename BiasScalar>
+inline void FullyConnectedSparseWeightImpl(
+    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const InputScalar* input_data,
+    const RuntimeShape& weights_shape, const InputScalar* weights_data,
+    const RuntimeShape& bias_shape, const BiasScalar* bias_data,
+    const RuntimeShape& output_shape, InputScalar* output_data,
+    CpuBackendContext* cpu_backend_context) {
+  const int output_dims_count = output_shape.DimensionsCount();
+  const int weights_dims_count = weights_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dims_count - 1);
+  const int output_depth = MatchingDim(weights_shape, weights_dims_count - 2,
+                                       output_shape, output_dims_count - 1);
+  const int accum_depth = weights_shape.Dims(weights_dims_count - 1);
+
+  constexpr int kMinRowsPerThread = 16;
+  int thread_count = output_depth / kMinRowsPerThread;
+  thread_count = thread_count > 0 ? thread_count : 1;
+  const int capped_thread_count =
+      cpu_backend_context == nullptr
+          ? 1
+          : std::min(thread_count, cpu_backend_context->max_num_threads());
+  if (capped_thread_count == 1) {
+    FullyConnectedSparseWeightTask<InputScalar, BiasScalar>(
+        sparsity, params, input_data, weights_data, bias_data, output_data,
+        batches, output_depth, accum_depth, 0, output_depth)
+        .Run();
+    return;
+  }
+
+  std::vector<FullyConnectedSparseWeightTask<InputScalar, BiasScalar>> tasks;
+  // TODO(b/131746020) don't create new heap allocations every time.
+  // At least we make it a single heap allocation by using reserve().
+  tasks.reserve(capped_thread_count);
+  int row_start = 0;
+  for (int i = 0; i < capped_thread_count; ++i) {
+    // Try to distribute the tasks as even as possible.
+    const int row_end =
+        row_start + (output_depth - row_start) / (capped_thread_count - i);
+    tasks.emplace_back(sparsity, params, input_data, weights_data, bias_data,
+                       output_data, batches, output_depth, accum_depth,
+                       row_start, row_end);
+    row_start = row_end;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
+}
+
+inline void FullyConnectedSparseWeight(
+    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const float* input_data,
+    const RuntimeShape& weights_shape, const float* weights_data,
+    const RuntimeShape& bias_shape, const float* bias_data,
+    const RuntimeShape& output_shape, float* output_data,
+    CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("FullyConnectedSparseWeight");
+  FullyConnectedSparseWeightImpl(sparsity, params, input_shape, input_data,
+                                 weights_shape, weights_data, bias_shape,
+                                 bias_data, output_shape, output_data,
+                                 cpu_backend_context);
+}
+
+inline void FullyConnectedSparseWeight(
+    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const int8_t* input_data,
+    const RuntimeShape& weights_shape, const int8_t* weights_data,
+    const RuntimeShape& bias_shape, const int32* bias_data,
+    const RuntimeShape& output_shape, int8_t* output_data,
+    CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("FullyConnectedSparseWeight/8bit");
+  FullyConnectedSparseWeightImpl(sparsity, params, input_shape, input_data,
+                                 weights_shape, weights_data, bias_shape,
+                                 bias_data, output_shape, output_data,
+                                 cpu_backend_context);
+}
+
+}  // namespace optimized_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
@@ -779,6 +779,14 @@ TfLiteStatus PopulatePrecomputedZPTimesWeightsWithBias(TfLiteContext* context,
                     PrecomputeZeroPointTimesWeightWithBias(
                         context, hidden_zp, projection_weights, projection_bias,
                         &(integer_lstm_params->projection_effective_bias)));
+
+  // Stack the gate weights and effective biases so that each step runs the
+  // gate matmuls as one GEMM per input.
+  lstm_eval::PopulateFusedGateWeights(
+      input_to_input_weights, input_to_forget_weights, input_to_cell_weights,
+      input_to_output_weights, recurrent_to_input_weights,
+      recurrent_to_forget_weights, recurrent_to_cell_weights,
+      recurrent_to_output_weights, integer_lstm_params);
   return kTfLiteOk;
 }
 
@@ -873,7 +881,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   if (is_hybrid_op) {
     node->temporaries = TfLiteIntArrayCreate(7);
   } else if (is_integer) {
-    node->temporaries = TfLiteIntArrayCreate(6);
+    node->temporaries = TfLiteIntArrayCreate(7);
   } else {
     node->temporaries = TfLiteIntArrayCreate(1);
   }
@@ -995,7 +1003,8 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
     // Allocate scratch buffer. Need 6 16bit buffer with size n_batch * n_cell
     // and 1 8bit buffer with size n_batch * n_cell. We also need 1 32 bit
-    // buffer with size n_batch * n_cell.
+    // buffer with size n_batch * n_cell, and 1 32 bit buffer with size
+    // n_batch * 2 * n_gates * n_cell for the fused gate matmuls.
     //
     // TODO(jianlijianli): Handle cifg case as well, which might save one
     // buffer.
@@ -1023,6 +1032,24 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       }
     }
 
+    const TfLiteTensor* input_to_input_weights =
+        GetOptionalInputTensor(context, node, kInputToInputWeightsTensor);
+    const int n_gates = (input_to_input_weights == nullptr) ? 3 : 4;
+    node->temporaries->data[6] = op_data->scratch_tensor_index + 6;
+    TfLiteTensor* gate_accumulators = GetTemporary(context, node, /*index=*/6);
+    gate_accumulators->type = kTfLiteInt32;
+    gate_accumulators->allocation_type = kTfLiteArenaRw;
+    const int gate_accumulators_dims[2] = {n_batch, 2 * n_gates * n_cell};
+    if (!TfLiteIntArrayEqualsArray(gate_accumulators->dims, 2,
+                                   gate_accumulators_dims)) {
+      TfLiteIntArray* gate_accumulators_size = TfLiteIntArrayCreate(2);
+      gate_accumulators_size->data[0] = gate_accumulators_dims[0];
+      gate_accumulators_size->data[1] = gate_accumulators_dims[1];
+      TF_LITE_ENSURE_OK(context,
+                        context->ResizeTensor(context, gate_accumulators,
+                                              gate_accumulators_size));
+    }
+
     // Populate precomputed zp * weight.
     TF_LITE_ENSURE_OK(context, PopulatePrecomputedZPTimesWeightsWithBias(
                                    context, op_data, node));
@@ -1163,6 +1190,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
         TfLiteTensor* scratch3 = GetTemporary(context, node, /*index=*/3);
         TfLiteTensor* scratch4 = GetTemporary(context, node, /*index=*/4);
         TfLiteTensor* scratch5 = GetTemporary(context, node, /*index=*/5);
+        TfLiteTensor* scratch6 = GetTemporary(context, node, /*index=*/6);
         return lstm_eval::EvalInteger(
             input, input_to_input_weights, input_to_forget_weights,
             input_to_cell_weights, input_to_output_weights,
@@ -1175,7 +1203,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
             cell_bias, output_gate_bias, projection_weights, projection_bias,
             params, &op_data->integer_lstm_param, activation_state, cell_state,
             output, scratch0, scratch1, scratch2, scratch3, scratch4, scratch5,
-            CpuBackendContext::GetFromContext(context));
+            scratch6, CpuBackendContext::GetFromContext(context));
         return kTfLiteOk;
       }
     }
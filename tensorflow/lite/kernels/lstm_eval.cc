@@ -16,11 +16,14 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstdint>
+#include <limits>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/experimental/ruy/profiler/instrumentation.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm.h"
+#include "tensorflow/lite/kernels/internal/common.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/kernel_utils.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
@@ -794,6 +797,86 @@ inline void LstmStepHybrid(
   }
 }
 
+// Computes the raw int32 accumulators, effective bias included, of the gate
+// weights stacked in `fused_weights` (n_gates * n_cell rows of n_input) against
+// all batches of `input`. The result is laid out batch-major: batch b starts at
+// scratch[b * n_gates * n_cell].
+void FusedGateMatmul(const int8_t* input, const int8_t* fused_weights,
+                     const int32_t* fused_effective_bias, int32 n_batch,
+                     int32 n_input, int32 n_rows, int32_t* scratch,
+                     CpuBackendContext* context) {
+  cpu_backend_gemm::MatrixParams<int8_t> lhs_params;
+  lhs_params.order = cpu_backend_gemm::Order::kRowMajor;
+  lhs_params.rows = n_rows;
+  lhs_params.cols = n_input;
+  lhs_params.cacheable = true;
+
+  cpu_backend_gemm::MatrixParams<int8_t> rhs_params;
+  rhs_params.order = cpu_backend_gemm::Order::kColMajor;
+  rhs_params.rows = n_input;
+  rhs_params.cols = n_batch;
+
+  cpu_backend_gemm::MatrixParams<int32_t> dst_params;
+  dst_params.order = cpu_backend_gemm::Order::kColMajor;
+  dst_params.rows = n_rows;
+  dst_params.cols = n_batch;
+
+  cpu_backend_gemm::GemmParams<int32, int32> gemm_params;
+  gemm_params.bias = fused_effective_bias;
+  cpu_backend_gemm::Gemm(lhs_params, fused_weights, rhs_params, input,
+                         dst_params, scratch, gemm_params, context);
+}
+
+// Computes the input and recurrent matmuls of all gates with one GEMM each and
+// rescales the accumulators into the int16 gate buffers, in input (non-cifg
+// only), forget, cell, output order. Produces the same values as the per-gate
+// MatrixBatchVectorMultiplyAccumulate calls it replaces: the input
+// contribution is rescaled and saturated first, then the recurrent one is
+// added to it.
+//
+// `scratch` must hold 2 * n_batch * n_gates * n_cell values.
+void FusedGateMatmulAccumulate(
+    const int8_t* input_ptr, const int8_t* activation_ptr,
+    const int8_t* fused_input_to_gate_weights,
+    const int32_t* fused_input_to_gate_effective_bias,
+    const int8_t* fused_recurrent_to_gate_weights,
+    const int32_t* fused_recurrent_to_gate_effective_bias, int n_gates,
+    const int32_t* input_scale_a, const int32_t* input_scale_b,
+    const int32_t* recurrent_scale_a, const int32_t* recurrent_scale_b,
+    int32 n_batch, int32 n_cell, int32 n_input, int32 n_output,
+    int32_t* scratch, int16_t* const* gate_outputs,
+    CpuBackendContext* context) {
+  const int n_rows = n_gates * n_cell;
+  int32_t* input_acc = scratch;
+  int32_t* recurrent_acc = scratch + n_batch * n_rows;
+  FusedGateMatmul(input_ptr, fused_input_to_gate_weights,
+                  fused_input_to_gate_effective_bias, n_batch, n_input, n_rows,
+                  input_acc, context);
+  FusedGateMatmul(activation_ptr, fused_recurrent_to_gate_weights,
+                  fused_recurrent_to_gate_effective_bias, n_batch, n_output,
+                  n_rows, recurrent_acc, context);
+
+  const int32_t output_min = std::numeric_limits<int16_t>::min();
+  const int32_t output_max = std::numeric_limits<int16_t>::max();
+  for (int g = 0; g < n_gates; ++g) {
+    int16_t* gate_output = gate_outputs[g];
+    for (int b = 0; b < n_batch; ++b) {
+      const int32_t* in = input_acc + b * n_rows + g * n_cell;
+      const int32_t* rec = recurrent_acc + b * n_rows + g * n_cell;
+      int16_t* out = gate_output + b * n_cell;
+      for (int i = 0; i < n_cell; ++i) {
+        int32_t acc = MultiplyByQuantizedMultiplier(in[i], input_scale_a[g],
+                                                    input_scale_b[g]);
+        acc = std::min(std::max(acc, output_min), output_max);
+        acc += MultiplyByQuantizedMultiplier(rec[i], recurrent_scale_a[g],
+                                             recurrent_scale_b[g]);
+        out[i] = static_cast<int16_t>(
+            std::min(std::max(acc, output_min), output_max));
+      }
+    }
+  }
+}
+
 // Fully quantized lstm kernel. Currently supports both cifg and non-cifg.
 //
 // Input activation of size n_batch * n_input:
@@ -881,6 +964,16 @@ inline void LstmStepHybrid(
 //   scratch_5: this scratch buffer is created purely for optimizing the
 //              MatrixBatchVectorMultiplyAccumulate.
 //
+// Optional gate weights and effective biases stacked in input (non-cifg only),
+// forget, cell, output order. When present, all gate matmuls run as one GEMM
+// over the input and one over the recurrent activation, using scratch_6 of
+// size 2 * n_batch * n_gates * n_cell.
+//   fused_input_to_gate_weights_ptr
+//   fused_input_to_gate_effective_bias
+//   fused_recurrent_to_gate_weights_ptr
+//   fused_recurrent_to_gate_effective_bias
+//   scratch_6_ptr
+//
 // Outputs:
 //   output_state_ptr - size 'n_batch * n_output'
 //   cell_state_ptr   - size 'n_batch * n_cell'
@@ -942,18 +1035,23 @@ inline void LstmStepInteger(
     const int32_t* recurrent_to_output_effective_bias,
     const int32_t* input_to_input_effective_bias,
     const int32_t* recurrent_to_input_effective_bias,
-    const int32_t* projection_effective_bias, int32 n_batch, int32 n_cell,
-    int32 n_input, int32 n_output, int8_t* activation_ptr,
+    const int32_t* projection_effective_bias,
+    const int8_t* fused_input_to_gate_weights_ptr,
+    const int32_t* fused_input_to_gate_effective_bias,
+    const int8_t* fused_recurrent_to_gate_weights_ptr,
+    const int32_t* fused_recurrent_to_gate_effective_bias, int32 n_batch,
+    int32 n_cell, int32 n_input, int32 n_output, int8_t* activation_ptr,
     int32_t activation_zp, int16_t* cell_ptr, int8_t* output_ptr,
     int16_t* scratch_0_ptr, int16_t* scratch_1_ptr, int16_t* scratch_2_ptr,
     int16_t* scratch_3_ptr, int8_t* scratch_4_ptr, int32_t* scratch_5_ptr,
-    CpuBackendContext* context) {
+    int32_t* scratch_6_ptr, CpuBackendContext* context) {
   ruy::profiler::ScopeLabel label("LstmStepInteger");
   // Get hyper parameters.
   const bool use_cifg = (input_to_input_weight_ptr == nullptr);
   const bool use_peephole = (cell_to_output_weight_ptr != nullptr);
   const bool use_layer_norm_lstm = (layer_norm_forget_weight_ptr != nullptr);
   const bool use_projection = (proj_weight_ptr != nullptr);
+  const bool use_fused_gates = (fused_input_to_gate_weights_ptr != nullptr);
 
   // Check for nullptrs.
   TFLITE_DCHECK(input_to_forget_effective_bias);
@@ -968,25 +1066,64 @@ inline void LstmStepInteger(
   }
   TFLITE_DCHECK(projection_effective_bias);
 
-  // Set scratch to 0.
-  if (!use_cifg) {
-    memset(scratch_0_ptr, 0, n_batch * n_cell * sizeof(int16_t));
+  if (use_fused_gates) {
+    TFLITE_DCHECK(fused_input_to_gate_effective_bias);
+    TFLITE_DCHECK(fused_recurrent_to_gate_weights_ptr);
+    TFLITE_DCHECK(fused_recurrent_to_gate_effective_bias);
+    TFLITE_DCHECK(scratch_6_ptr);
+    // Gate matmuls for all gates at once. The output gate only depends on the
+    // input and the previous activation, so it can be computed up front too.
+    int16_t* const gate_outputs[] = {scratch_0_ptr, scratch_1_ptr,
+                                     scratch_2_ptr, scratch_3_ptr};
+    const int32_t input_scale_a[] = {
+        effective_input_to_input_scale_a, effective_input_to_forget_scale_a,
+        effective_input_to_cell_scale_a, effective_input_to_output_scale_a};
+    const int32_t input_scale_b[] = {
+        effective_input_to_input_scale_b, effective_input_to_forget_scale_b,
+        effective_input_to_cell_scale_b, effective_input_to_output_scale_b};
+    const int32_t recurrent_scale_a[] = {
+        effective_recurrent_to_input_scale_a,
+        effective_recurrent_to_forget_scale_a,
+        effective_recurrent_to_cell_scale_a,
+        effective_recurrent_to_output_scale_a};
+    const int32_t recurrent_scale_b[] = {
+        effective_recurrent_to_input_scale_b,
+        effective_recurrent_to_forget_scale_b,
+        effective_recurrent_to_cell_scale_b,
+        effective_recurrent_to_output_scale_b};
+    // With cifg there is no input gate: skip the first entry of each table.
+    const int first_gate = use_cifg ? 1 : 0;
+    FusedGateMatmulAccumulate(
+        input_ptr, activation_ptr, fused_input_to_gate_weights_ptr,
+        fused_input_to_gate_effective_bias, fused_recurrent_to_gate_weights_ptr,
+        fused_recurrent_to_gate_effective_bias, 4 - first_gate,
+        input_scale_a + first_gate, input_scale_b + first_gate,
+        recurrent_scale_a + first_gate, recurrent_scale_b + first_gate,
+        n_batch, n_cell, n_input, n_output, scratch_6_ptr,
+        gate_outputs + first_gate, context);
+  } else {
+    // Set scratch to 0.
+    if (!use_cifg) {
+      memset(scratch_0_ptr, 0, n_batch * n_cell * sizeof(int16_t));
+    }
+    memset(scratch_1_ptr, 0, n_batch * n_cell * sizeof(int16_t));
+    memset(scratch_2_ptr, 0, n_batch * n_cell * sizeof(int16_t));
+    memset(scratch_3_ptr, 0, n_batch * n_cell * sizeof(int16_t));
   }
-  memset(scratch_1_ptr, 0, n_batch * n_cell * sizeof(int16_t));
-  memset(scratch_2_ptr, 0, n_batch * n_cell * sizeof(int16_t));
-  memset(scratch_3_ptr, 0, n_batch * n_cell * sizeof(int16_t));
 
   // Forget gate.
-  tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-      input_ptr, input_to_forget_effective_bias, input_to_forget_weight_ptr,
-      effective_input_to_forget_scale_a, effective_input_to_forget_scale_b,
-      n_batch, n_input, n_cell, 0, scratch_5_ptr, scratch_1_ptr, context);
+  if (!use_fused_gates) {
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        input_ptr, input_to_forget_effective_bias, input_to_forget_weight_ptr,
+        effective_input_to_forget_scale_a, effective_input_to_forget_scale_b,
+        n_batch, n_input, n_cell, 0, scratch_5_ptr, scratch_1_ptr, context);
 
-  tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-      activation_ptr, recurrent_to_forget_effective_bias,
-      recurrent_to_forget_weight_ptr, effective_recurrent_to_forget_scale_a,
-      effective_recurrent_to_forget_scale_b, n_batch, n_output, n_cell, 0,
-      scratch_5_ptr, scratch_1_ptr, context);
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        activation_ptr, recurrent_to_forget_effective_bias,
+        recurrent_to_forget_weight_ptr, effective_recurrent_to_forget_scale_a,
+        effective_recurrent_to_forget_scale_b, n_batch, n_output, n_cell, 0,
+        scratch_5_ptr, scratch_1_ptr, context);
+  }
   if (use_peephole) {
     tensor_utils::VectorBatchVectorCwiseProductAccumulate(
         cell_to_forget_weight_ptr, n_output, cell_ptr, n_batch,
@@ -1004,16 +1141,18 @@ inline void LstmStepInteger(
   tensor_utils::ApplySigmoid(scratch_1_ptr, n_batch, n_cell, scratch_1_ptr);
 
   // Modulation gate.
-  tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-      input_ptr, input_to_cell_effective_bias, input_to_cell_weight_ptr,
-      effective_input_to_cell_scale_a, effective_input_to_cell_scale_b, n_batch,
-      n_input, n_cell, 0, scratch_5_ptr, scratch_2_ptr, context);
+  if (!use_fused_gates) {
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        input_ptr, input_to_cell_effective_bias, input_to_cell_weight_ptr,
+        effective_input_to_cell_scale_a, effective_input_to_cell_scale_b,
+        n_batch, n_input, n_cell, 0, scratch_5_ptr, scratch_2_ptr, context);
 
-  tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-      activation_ptr, recurrent_to_cell_effective_bias,
-      recurrent_to_cell_weight_ptr, effective_recurrent_to_cell_scale_a,
-      effective_recurrent_to_cell_scale_b, n_batch, n_output, n_cell, 0,
-      scratch_5_ptr, scratch_2_ptr, context);
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        activation_ptr, recurrent_to_cell_effective_bias,
+        recurrent_to_cell_weight_ptr, effective_recurrent_to_cell_scale_a,
+        effective_recurrent_to_cell_scale_b, n_batch, n_output, n_cell, 0,
+        scratch_5_ptr, scratch_2_ptr, context);
+  }
 
   if (use_layer_norm_lstm) {
     tensor_utils::ApplyLayerNorm(scratch_2_ptr, layer_norm_cell_weight_ptr,
@@ -1028,16 +1167,18 @@ inline void LstmStepInteger(
   if (use_cifg) {
     tensor_utils::Sub1Vector(scratch_1_ptr, n_batch * n_cell, scratch_0_ptr);
   } else {
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-        input_ptr, input_to_input_effective_bias, input_to_input_weight_ptr,
-        effective_input_to_input_scale_a, effective_input_to_input_scale_b,
-        n_batch, n_input, n_cell, 0, scratch_5_ptr, scratch_0_ptr, context);
+    if (!use_fused_gates) {
+      tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+          input_ptr, input_to_input_effective_bias, input_to_input_weight_ptr,
+          effective_input_to_input_scale_a, effective_input_to_input_scale_b,
+          n_batch, n_input, n_cell, 0, scratch_5_ptr, scratch_0_ptr, context);
 
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-        activation_ptr, recurrent_to_input_effective_bias,
-        recurrent_to_input_weight_ptr, effective_recurrent_to_input_scale_a,
-        effective_recurrent_to_input_scale_b, n_batch, n_output, n_cell, 0,
-        scratch_5_ptr, scratch_0_ptr, context);
+      tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+          activation_ptr, recurrent_to_input_effective_bias,
+          recurrent_to_input_weight_ptr, effective_recurrent_to_input_scale_a,
+          effective_recurrent_to_input_scale_b, n_batch, n_output, n_cell, 0,
+          scratch_5_ptr, scratch_0_ptr, context);
+    }
     if (use_peephole) {
       tensor_utils::VectorBatchVectorCwiseProductAccumulate(
           cell_to_input_weight_ptr, n_output, cell_ptr, n_batch,
@@ -1069,16 +1210,18 @@ inline void LstmStepInteger(
   }
 
   // Ouptut gate.
-  tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-      input_ptr, input_to_output_effective_bias, input_to_output_weight_ptr,
-      effective_input_to_output_scale_a, effective_input_to_output_scale_b,
-      n_batch, n_input, n_cell, 0, scratch_5_ptr, scratch_3_ptr, context);
+  if (!use_fused_gates) {
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        input_ptr, input_to_output_effective_bias, input_to_output_weight_ptr,
+        effective_input_to_output_scale_a, effective_input_to_output_scale_b,
+        n_batch, n_input, n_cell, 0, scratch_5_ptr, scratch_3_ptr, context);
 
-  tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-      activation_ptr, recurrent_to_output_effective_bias,
-      recurrent_to_output_weight_ptr, effective_recurrent_to_output_scale_a,
-      effective_recurrent_to_output_scale_b, n_batch, n_output, n_cell, 0,
-      scratch_5_ptr, scratch_3_ptr, context);
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        activation_ptr, recurrent_to_output_effective_bias,
+        recurrent_to_output_weight_ptr, effective_recurrent_to_output_scale_a,
+        effective_recurrent_to_output_scale_b, n_batch, n_output, n_cell, 0,
+        scratch_5_ptr, scratch_3_ptr, context);
+  }
   if (use_peephole) {
     tensor_utils::VectorBatchVectorCwiseProductAccumulate(
         cell_to_output_weight_ptr, n_output, cell_ptr, n_batch,
@@ -1557,7 +1700,8 @@ TfLiteStatus EvalInteger(
     TfLiteTensor* activation_state, TfLiteTensor* cell_state,
     TfLiteTensor* output, TfLiteTensor* scratch0, TfLiteTensor* scratch1,
     TfLiteTensor* scratch2, TfLiteTensor* scratch3, TfLiteTensor* scratch4,
-    TfLiteTensor* scratch5, CpuBackendContext* context) {
+    TfLiteTensor* scratch5, TfLiteTensor* scratch6,
+    CpuBackendContext* context) {
   TF_LITE_ASSERT(input->dims->size >= 2 && input->dims->size <= 3);
   const int n_input = input->dims->data[input->dims->size - 1];
   int max_time, n_batch;
@@ -1653,18 +1797,81 @@ TfLiteStatus EvalInteger(
         integer_lstm_param->recurrent_to_output_effective_bias.get(),
         integer_lstm_param->input_to_input_effective_bias.get(),
         integer_lstm_param->recurrent_to_input_effective_bias.get(),
-        integer_lstm_param->projection_effective_bias.get(), n_batch, n_cell,
-        n_input, n_output, GetTensorData<int8_t>(activation_state),
-        activation_zp, GetTensorData<int16_t>(cell_state), output_ptr,
+        integer_lstm_param->projection_effective_bias.get(),
+        integer_lstm_param->fused_input_to_gate_weights.get(),
+        integer_lstm_param->fused_input_to_gate_effective_bias.get(),
+        integer_lstm_param->fused_recurrent_to_gate_weights.get(),
+        integer_lstm_param->fused_recurrent_to_gate_effective_bias.get(),
+        n_batch, n_cell, n_input, n_output,
+        GetTensorData<int8_t>(activation_state), activation_zp,
+        GetTensorData<int16_t>(cell_state), output_ptr,
         GetTensorData<int16_t>(scratch0), GetTensorData<int16_t>(scratch1),
         GetTensorData<int16_t>(scratch2), GetTensorData<int16_t>(scratch3),
         GetTensorData<int8_t>(scratch4), GetTensorData<int32_t>(scratch5),
-        context);
+        GetTensorData<int32_t>(scratch6), context);
   }
 
   return kTfLiteOk;
 }
 
+void PopulateFusedGateWeights(
+    const TfLiteTensor* input_to_input_weights,
+    const TfLiteTensor* input_to_forget_weights,
+    const TfLiteTensor* input_to_cell_weights,
+    const TfLiteTensor* input_to_output_weights,
+    const TfLiteTensor* recurrent_to_input_weights,
+    const TfLiteTensor* recurrent_to_forget_weights,
+    const TfLiteTensor* recurrent_to_cell_weights,
+    const TfLiteTensor* recurrent_to_output_weights,
+    IntegerLstmParameter* integer_lstm_param) {
+  const bool use_cifg = (input_to_input_weights == nullptr);
+  const int n_cell = input_to_output_weights->dims->data[0];
+  const int n_input = input_to_output_weights->dims->data[1];
+  const int n_output = recurrent_to_output_weights->dims->data[1];
+  const int n_gates = use_cifg ? 3 : 4;
+
+  const TfLiteTensor* input_weights[] = {
+      input_to_input_weights, input_to_forget_weights, input_to_cell_weights,
+      input_to_output_weights};
+  const TfLiteTensor* recurrent_weights[] = {
+      recurrent_to_input_weights, recurrent_to_forget_weights,
+      recurrent_to_cell_weights, recurrent_to_output_weights};
+  const int32_t* input_biases[] = {
+      integer_lstm_param->input_to_input_effective_bias.get(),
+      integer_lstm_param->input_to_forget_effective_bias.get(),
+      integer_lstm_param->input_to_cell_effective_bias.get(),
+      integer_lstm_param->input_to_output_effective_bias.get()};
+  const int32_t* recurrent_biases[] = {
+      integer_lstm_param->recurrent_to_input_effective_bias.get(),
+      integer_lstm_param->recurrent_to_forget_effective_bias.get(),
+      integer_lstm_param->recurrent_to_cell_effective_bias.get(),
+      integer_lstm_param->recurrent_to_output_effective_bias.get()};
+
+  integer_lstm_param->fused_input_to_gate_weights.reset(
+      new int8_t[n_gates * n_cell * n_input]);
+  integer_lstm_param->fused_input_to_gate_effective_bias.reset(
+      new int32_t[n_gates * n_cell]);
+  integer_lstm_param->fused_recurrent_to_gate_weights.reset(
+      new int8_t[n_gates * n_cell * n_output]);
+  integer_lstm_param->fused_recurrent_to_gate_effective_bias.reset(
+      new int32_t[n_gates * n_cell]);
+
+  for (int g = use_cifg ? 1 : 0, row = 0; g < 4; ++g, row += n_cell) {
+    std::copy_n(GetTensorData<int8_t>(input_weights[g]), n_cell * n_input,
+                integer_lstm_param->fused_input_to_gate_weights.get() +
+                    row * n_input);
+    std::copy_n(input_biases[g], n_cell,
+                integer_lstm_param->fused_input_to_gate_effective_bias.get() +
+                    row);
+    std::copy_n(GetTensorData<int8_t>(recurrent_weights[g]), n_cell * n_output,
+                integer_lstm_param->fused_recurrent_to_gate_weights.get() +
+                    row * n_output);
+    std::copy_n(
+        recurrent_biases[g], n_cell,
+        integer_lstm_param->fused_recurrent_to_gate_effective_bias.get() + row);
+  }
+}
+
 }  // namespace lstm_eval
 }  // namespace builtin
 }  // namespace ops
@@ -90,8 +90,32 @@ struct IntegerLstmParameter {
   std::unique_ptr<int32_t[]> recurrent_to_input_effective_bias;
   // Projection.
   std::unique_ptr<int32_t[]> projection_effective_bias;
+
+  // Optional gate weights and effective biases stacked along the output
+  // dimension, in input (non-cifg only), forget, cell, output gate order. When
+  // set, each time step computes all gate matmuls with one GEMM over the input
+  // and one over the recurrent activation. See PopulateFusedGateWeights().
+  std::unique_ptr<int8_t[]> fused_input_to_gate_weights;
+  std::unique_ptr<int32_t[]> fused_input_to_gate_effective_bias;
+  std::unique_ptr<int8_t[]> fused_recurrent_to_gate_weights;
+  std::unique_ptr<int32_t[]> fused_recurrent_to_gate_effective_bias;
 };
 
+// Stacks the per-gate weights and effective biases of a fully quantized LSTM
+// into the fused fields of `integer_lstm_param`. The per-gate effective biases
+// must already be populated. `input_to_input_weights` and
+// `recurrent_to_input_weights` are null for cifg.
+void PopulateFusedGateWeights(
+    const TfLiteTensor* input_to_input_weights,
+    const TfLiteTensor* input_to_forget_weights,
+    const TfLiteTensor* input_to_cell_weights,
+    const TfLiteTensor* input_to_output_weights,
+    const TfLiteTensor* recurrent_to_input_weights,
+    const TfLiteTensor* recurrent_to_forget_weights,
+    const TfLiteTensor* recurrent_to_cell_weights,
+    const TfLiteTensor* recurrent_to_output_weights,
+    IntegerLstmParameter* integer_lstm_param);
+
 TfLiteStatus EvalFloat(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
     const TfLiteTensor* input_to_forget_weights,
@@ -177,7 +201,8 @@ TfLiteStatus EvalInteger(
     TfLiteTensor* activation_state, TfLiteTensor* cell_state,
     TfLiteTensor* output, TfLiteTensor* scratch0, TfLiteTensor* scratch1,
     TfLiteTensor* scratch2, TfLiteTensor* scratch3, TfLiteTensor* scratch4,
-    TfLiteTensor* scratch5, CpuBackendContext* context);
+    TfLiteTensor* scratch5, TfLiteTensor* scratch6,
+    CpuBackendContext* context);
 
 }  // namespace lstm_eval
 }  // namespace builtin
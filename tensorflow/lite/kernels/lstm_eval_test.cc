@@ -258,6 +258,11 @@ class QuantizedLstmParam {
     scratch5_tensor_.data.i32 = scratch5_.data();
     return &scratch5_tensor_;
   }
+  TfLiteTensor* GetScratch6() {
+    PackWeightToTensor(&scratch6_tensor_, scratch6_, scratch6_size_);
+    scratch6_tensor_.data.i32 = scratch6_.data();
+    return &scratch6_tensor_;
+  }
   TfLiteTensor* GetActivation() {
     PackWeightToTensor(&activation_tensor_, activation_, activation_size_);
     activation_tensor_.data.int8 = activation_.data();
@@ -304,6 +309,7 @@ class QuantizedLstmParam {
     TfLiteIntArrayFree(scratch3_tensor_.dims);
     TfLiteIntArrayFree(scratch4_tensor_.dims);
     TfLiteIntArrayFree(scratch5_tensor_.dims);
+    TfLiteIntArrayFree(scratch6_tensor_.dims);
   }
 
  private:
@@ -546,7 +552,7 @@ class QuantizedLstmParam {
   // quantized_lstm_param
   ops::builtin::lstm_eval::IntegerLstmParameter integer_lstm_param_;
 
-  // 5 scratch buffers.
+  // 7 scratch buffers.
   std::vector<int16_t> scratch0_;
   std::vector<int32_t> scratch0_size_ = {n_batch_, n_cell_};
   TfLiteTensor scratch0_tensor_;
@@ -565,19 +571,32 @@ class QuantizedLstmParam {
   std::vector<int32_t> scratch5_;
   std::vector<int32_t> scratch5_size_ = {n_batch_, n_cell_};
   TfLiteTensor scratch5_tensor_;
+  std::vector<int32_t> scratch6_;
+  std::vector<int32_t> scratch6_size_ = {n_batch_, 2 * 4 * n_cell_};
+  TfLiteTensor scratch6_tensor_;
 };
 
-void TestOneFullyQuantizedLSTM() {
+void TestOneFullyQuantizedLSTM(bool fuse_gates) {
   CpuBackendContext context;
   QuantizedLstmParam one_parameter;
   auto activation = one_parameter.GetActivation();
   auto output = one_parameter.GetOutput();
   auto cell = one_parameter.GetCell();
   auto param = one_parameter.GetQuantParam();
+  auto i2i = one_parameter.Geti2i();
+  auto i2f = one_parameter.Geti2f();
+  auto i2c = one_parameter.Geti2c();
+  auto i2o = one_parameter.Geti2o();
+  auto r2i = one_parameter.Getr2i();
+  auto r2f = one_parameter.Getr2f();
+  auto r2c = one_parameter.Getr2c();
+  auto r2o = one_parameter.Getr2o();
+  if (fuse_gates) {
+    ops::builtin::lstm_eval::PopulateFusedGateWeights(
+        i2i, i2f, i2c, i2o, r2i, r2f, r2c, r2o, param);
+  }
   ops::builtin::lstm_eval::EvalInteger(
-      one_parameter.GetInput(), one_parameter.Geti2i(), one_parameter.Geti2f(),
-      one_parameter.Geti2c(), one_parameter.Geti2o(), one_parameter.Getr2i(),
-      one_parameter.Getr2f(), one_parameter.Getr2c(), one_parameter.Getr2o(),
+      one_parameter.GetInput(), i2i, i2f, i2c, i2o, r2i, r2f, r2c, r2o,
       nullptr, nullptr, nullptr, one_parameter.GetInputLayerNorm(),
       one_parameter.GetForgetLayerNorm(), one_parameter.GetCellLayerNorm(),
       one_parameter.GetOutputLayerNorm(), one_parameter.GetInputBias(),
@@ -586,7 +605,8 @@ void TestOneFullyQuantizedLSTM() {
       one_parameter.GetProjectionBias(), nullptr, param, activation, cell,
       output, one_parameter.GetScratch0(), one_parameter.GetScratch1(),
       one_parameter.GetScratch2(), one_parameter.GetScratch3(),
-      one_parameter.GetScratch4(), one_parameter.GetScratch5(), &context);
+      one_parameter.GetScratch4(), one_parameter.GetScratch5(),
+      one_parameter.GetScratch6(), &context);
 
   // Verify results.
   const std::vector<int16_t> expected_cell = {
@@ -601,7 +621,11 @@ void TestOneFullyQuantizedLSTM() {
 }
 
 TEST(TestOneFullyQuantizedLSTM, TestOneFullyQuantizedLSTM) {
-  TestOneFullyQuantizedLSTM();
+  TestOneFullyQuantizedLSTM(/*fuse_gates=*/false);
+}
+
+TEST(TestOneFullyQuantizedLSTM, TestOneFullyQuantizedLSTMFusedGates) {
+  TestOneFullyQuantizedLSTM(/*fuse_gates=*/true);
 }
 }  // namespace
 }  // namespace tflite
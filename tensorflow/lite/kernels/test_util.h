@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_KERNELS_TEST_UTIL_H_
 #define TENSORFLOW_LITE_KERNELS_TEST_UTIL_H_
 
+#include <algorithm>
 #include <cmath>
 #include <complex>
 #include <vector>
@@ -186,6 +187,81 @@ class SingleOpModel {
     return AddConstInput(TensorData{type, shape}, data);
   }
 
+  // Adds a constant 2-D input stored in the block-sparse format of
+  // FULLY_CONNECTED weights: `data` is dense and row major, and only the
+  // 1 x `block_cols` blocks holding a non-zero value are kept. Quantized
+  // inputs take an explicit scale and zero point, and already quantized data.
+  template <typename T>
+  int AddConstSparseInput(const TensorData& t, const std::vector<T>& data,
+                          int block_cols) {
+    CHECK_EQ(t.shape.size(), 2);
+    const int rows = t.shape[0];
+    const int cols = t.shape[1];
+    CHECK_EQ(cols % block_cols, 0);
+    CHECK_EQ(data.size(), rows * cols);
+
+    std::vector<T> values;
+    std::vector<int> segments = {0};
+    std::vector<int> indices;
+    for (int row = 0; row < rows; ++row) {
+      for (int block = 0; block < cols / block_cols; ++block) {
+        const auto begin = data.begin() + row * cols + block * block_cols;
+        if (std::all_of(begin, begin + block_cols,
+                        [](T value) { return value == T(0); })) {
+          continue;
+        }
+        indices.push_back(block);
+        values.insert(values.end(), begin, begin + block_cols);
+      }
+      segments.push_back(indices.size());
+    }
+
+    std::vector<int> traversal_order = {0, 1};
+    std::vector<flatbuffers::Offset<DimensionMetadata>> dim_metadata = {
+        CreateDimensionMetadata(builder_, DimensionType_DENSE, rows),
+        CreateDimensionMetadata(builder_, DimensionType_SPARSE_CSR,
+                                cols / block_cols,
+                                builder_.CreateVector(segments),
+                                builder_.CreateVector(indices))};
+    flatbuffers::Offset<flatbuffers::Vector<int32_t>> block_map = 0;
+    if (block_cols > 1) {
+      traversal_order.push_back(2);
+      block_map = builder_.CreateVector<int32_t>({1});
+      dim_metadata.push_back(
+          CreateDimensionMetadata(builder_, DimensionType_DENSE, block_cols));
+    }
+    auto sparsity = CreateSparsityParameters(
+        builder_, builder_.CreateVector(traversal_order), block_map,
+        builder_.CreateVector(dim_metadata));
+
+    flatbuffers::Offset<QuantizationParameters> q_params = 0;
+    if (t.scale != 0) {
+      q_params = CreateQuantizationParameters(
+          builder_, /*min=*/0, /*max=*/0,
+          builder_.CreateVector<float>({t.scale}),
+          builder_.CreateVector<int64_t>({t.zero_point}));
+    }
+
+    if (buffers_.empty()) {
+      buffers_.push_back(CreateBuffer(builder_, builder_.CreateVector({})));
+    }
+    const int buffer_id = buffers_.size();
+    buffers_.push_back(CreateBuffer(
+        builder_,
+        builder_.CreateVector(reinterpret_cast<const uint8_t*>(values.data()),
+                              sizeof(T) * values.size())));
+
+    const int id = tensors_.size();
+    tensors_.push_back(CreateTensor(builder_,
+                                    builder_.CreateVector<int>(t.shape), t.type,
+                                    /*buffer=*/buffer_id,
+                                    /*name=*/0, q_params, /*is_variable=*/false,
+                                    sparsity));
+    tensor_data_[id] = t;
+    inputs_.push_back(id);
+    return id;
+  }
+
   // Add a null input tensor (optional input) and return kTfLiteOptionalTensor.
   int AddNullInput();
 
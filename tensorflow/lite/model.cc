@@ -206,7 +206,8 @@ InterpreterBuilder::InterpreterBuilder(const FlatBufferModel& model,
     : model_(model.GetModel()),
       op_resolver_(op_resolver),
       error_reporter_(ValidateErrorReporter(model.error_reporter())),
-      allocation_(model.allocation()) {}
+      allocation_(model.allocation()),
+      resources_(model.resources()) {}
 
 InterpreterBuilder::InterpreterBuilder(const ::tflite::Model* model,
                                        const OpResolver& op_resolver,
@@ -667,6 +668,9 @@ TfLiteStatus InterpreterBuilder::operator()(
 
   interpreter->reset(new Interpreter(error_reporter_));
   (*interpreter)->SetNumThreads(num_threads);
+  if (resources_) {
+    (*interpreter)->SetModelResources(resources_);
+  }
   if (subgraphs->Length() > 1) {
     (*interpreter)->AddSubgraphs(subgraphs->Length() - 1);
   }
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/core/api/op_resolver.h"
 #include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model_resources.h"
 #include "tensorflow/lite/mutable_op_resolver.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
@@ -136,6 +137,13 @@ class FlatBufferModel {
   ErrorReporter* error_reporter() const { return error_reporter_; }
   const Allocation* allocation() const { return allocation_.get(); }
 
+  // Returns the buffers derived from the constant tensors of the model, shared
+  // by the interpreters built from it.
+  // WARNING: This is an experimental API and subject to change.
+  const std::shared_ptr<ModelResources>& resources() const {
+    return resources_;
+  }
+
   // Returns the minimum runtime version from the flatbuffer. This runtime
   // version encodes the minimum required interpreter version to run the
   // flatbuffer model. If the minimum version can't be determined, an empty
@@ -172,6 +180,9 @@ class FlatBufferModel {
   /// The allocator used for holding memory of the model. Note that this will
   /// be null if the client provides a tflite::Model directly.
   std::unique_ptr<Allocation> allocation_;
+  /// Shared with every interpreter built from this model, which keep it alive.
+  std::shared_ptr<ModelResources> resources_ =
+      std::make_shared<ModelResources>();
 };
 
 /// Build an interpreter capable of interpreting `model`.
@@ -234,6 +245,8 @@ class InterpreterBuilder {
   std::vector<TfLiteRegistration> unresolved_custom_ops_;
   std::vector<BuiltinOperator> flatbuffer_op_index_to_registration_types_;
   const Allocation* allocation_ = nullptr;
+  // Null when building from a raw flatbuffer Model, which disables sharing.
+  std::shared_ptr<ModelResources> resources_;
 
   bool has_flex_op_ = false;
 };
@@ -0,0 +1,71 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/model_resources.h"
+
+#include <cstdint>
+
+namespace tflite {
+namespace {
+
+// Same as kDefaultTensorAlignment, so that kernels find the same alignment as
+// for tensors in the arena.
+constexpr size_t kBufferAlignment = 64;
+
+}  // namespace
+
+ModelResources::ModelResources() {
+  this->type = kTfLiteModelResourcesContext;
+  this->Refresh = nullptr;
+}
+
+ModelResources* ModelResources::GetFromContext(TfLiteContext* context) {
+  return static_cast<ModelResources*>(
+      context->GetExternalContext(context, kTfLiteModelResourcesContext));
+}
+
+const void* ModelResources::GetOrCreate(
+    const void* source, const std::string& derivation, size_t size,
+    const std::function<TfLiteStatus(void*)>& fill) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto key = std::make_pair(source, derivation);
+  auto it = buffers_.find(key);
+  if (it != buffers_.end()) {
+    return it->second.size == size ? it->second.data : nullptr;
+  }
+
+  Buffer buffer;
+  buffer.storage.reset(new char[size + kBufferAlignment]);
+  const auto address = reinterpret_cast<std::uintptr_t>(buffer.storage.get());
+  buffer.data = buffer.storage.get() +
+                (kBufferAlignment - address % kBufferAlignment) %
+                    kBufferAlignment;
+  buffer.size = size;
+  if (fill(buffer.data) != kTfLiteOk) return nullptr;
+
+  total_bytes_ += size;
+  return buffers_.emplace(key, std::move(buffer)).first->second.data;
+}
+
+size_t ModelResources::num_buffers() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return buffers_.size();
+}
+
+size_t ModelResources::total_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return total_bytes_;
+}
+
+}  // namespace tflite
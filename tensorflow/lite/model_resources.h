@@ -0,0 +1,81 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MODEL_RESOURCES_H_
+#define TENSORFLOW_LITE_MODEL_RESOURCES_H_
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <utility>
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+
+// The 'kTfLiteModelResourcesContext'-typed external context: read-only
+// buffers derived from the constant tensors of a model, like dequantized or
+// densified weights, or weights packed for a delegate. A FlatBufferModel owns
+// one, and every Interpreter built from the model by an InterpreterBuilder
+// keeps a reference to it, so each buffer is computed and stored once however
+// many interpreters run the model. Activations stay in the arena of each
+// interpreter.
+//
+// Buffers are keyed by the address of the constant data they are computed
+// from, which all the interpreters of a model share, and by a description of
+// the computation, which must include any parameter other than that data.
+class ModelResources : public TfLiteExternalContext {
+ public:
+  ModelResources();
+  ~ModelResources() {}
+
+  ModelResources(const ModelResources&) = delete;
+  ModelResources& operator=(const ModelResources&) = delete;
+
+  // Returns the resources of the interpreter owning `context`, or nullptr if
+  // it has none.
+  static ModelResources* GetFromContext(TfLiteContext* context);
+
+  // Returns the buffer of `size` bytes computed from `source` as described by
+  // `derivation`, calling `fill` to compute it if it doesn't exist yet.
+  // Returns nullptr if `fill` fails, or if the existing buffer has another
+  // size. Buffers are aligned like tensors in the arena, and live as long as
+  // this object. Thread-safe: `fill` runs at most once per buffer, with a lock
+  // held.
+  const void* GetOrCreate(const void* source, const std::string& derivation,
+                          size_t size,
+                          const std::function<TfLiteStatus(void*)>& fill);
+
+  // Number of buffers, and their total size in bytes.
+  size_t num_buffers() const;
+  size_t total_bytes() const;
+
+ private:
+  struct Buffer {
+    std::unique_ptr<char[]> storage;
+    void* data;
+    size_t size;
+  };
+
+  mutable std::mutex mutex_;
+  std::map<std::pair<const void*, std::string>, Buffer> buffers_;
+  size_t total_bytes_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MODEL_RESOURCES_H_
@@ -0,0 +1,100 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/model_resources.h"
+
+#include <cstdint>
+#include <cstring>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+TfLiteStatus FillWithByte(void* buffer, size_t size, char value) {
+  memset(buffer, value, size);
+  return kTfLiteOk;
+}
+
+TEST(ModelResourcesTest, ComputesEachBufferOnce) {
+  ModelResources resources;
+  const float weights[4] = {1, 2, 3, 4};
+  int num_fills = 0;
+  auto fill = [&num_fills](void* buffer) {
+    ++num_fills;
+    return FillWithByte(buffer, 16, 7);
+  };
+
+  const void* buffer = resources.GetOrCreate(weights, "test", 16, fill);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buffer) % 64, 0);
+  EXPECT_EQ(static_cast<const char*>(buffer)[15], 7);
+  EXPECT_EQ(resources.GetOrCreate(weights, "test", 16, fill), buffer);
+  EXPECT_EQ(num_fills, 1);
+
+  // Another derivation or another source is another buffer.
+  EXPECT_NE(resources.GetOrCreate(weights, "other", 16, fill), buffer);
+  EXPECT_NE(resources.GetOrCreate(weights + 1, "test", 16, fill), buffer);
+  EXPECT_EQ(num_fills, 3);
+  EXPECT_EQ(resources.num_buffers(), 3);
+  EXPECT_EQ(resources.total_bytes(), 48);
+
+  // The size of an existing buffer can't change.
+  EXPECT_EQ(resources.GetOrCreate(weights, "test", 32, fill), nullptr);
+}
+
+TEST(ModelResourcesTest, FailedFillIsNotCached) {
+  ModelResources resources;
+  const float weights[1] = {1};
+  EXPECT_EQ(resources.GetOrCreate(weights, "test", 4,
+                                  [](void*) { return kTfLiteError; }),
+            nullptr);
+  EXPECT_EQ(resources.num_buffers(), 0);
+  EXPECT_NE(resources.GetOrCreate(
+                weights, "test", 4,
+                [](void* buffer) { return FillWithByte(buffer, 4, 1); }),
+            nullptr);
+}
+
+TEST(ModelResourcesTest, ConcurrentCallersShareTheBuffer) {
+  ModelResources resources;
+  const float weights[1] = {1};
+  constexpr int kNumThreads = 8;
+  std::vector<const void*> buffers(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&resources, &weights, &buffers, i] {
+      buffers[i] = resources.GetOrCreate(
+          weights, "test", 1024,
+          [](void* buffer) { return FillWithByte(buffer, 1024, 3); });
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  for (const void* buffer : buffers) {
+    EXPECT_EQ(buffer, buffers[0]);
+  }
+  EXPECT_EQ(resources.num_buffers(), 1);
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -57,6 +57,16 @@ class SimpleMemoryArena {
 
   TfLiteStatus Deallocate(TfLiteContext* context, const ArenaAlloc& alloc);
 
+  // Makes room for allocations whose offsets were chosen by the caller, up to
+  // `size` bytes. Such allocations are not tracked by the arena, so they must
+  // not be mixed with Allocate() and Deallocate() in the same plan.
+  void Reserve(size_t size) {
+    if (size > high_water_mark_) high_water_mark_ = size;
+  }
+
+  // Returns the end of the furthest allocation planned so far.
+  size_t high_water_mark() const { return high_water_mark_; }
+
   inline size_t RequiredBufferSize() {
     // Add in a small amount of padding to reduce the chance of resize events
     // for small allocations.
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/testing/util.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_performance_options.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_tflite_model.h"
+#include "tensorflow/lite/tools/benchmark/op_benchmark.h"
 #include "tensorflow/lite/tools/command_line_flags.h"
 
 namespace {
@@ -76,6 +77,12 @@ BenchmarkParams CreateParams(int32_t num_runs, float min_secs, float max_secs,
                   BenchmarkParam::Create<std::string>(""));
   params.AddParam("nnapi_execution_preference",
                   BenchmarkParam::Create<std::string>(""));
+  params.AddParam("enable_op_benchmark", BenchmarkParam::Create<bool>(false));
+  params.AddParam("op_benchmark_num_runs", BenchmarkParam::Create<int32_t>(2));
+  params.AddParam("op_benchmark_num_threads",
+                  BenchmarkParam::Create<std::string>(""));
+  params.AddParam("op_benchmark_cache_flush_mb",
+                  BenchmarkParam::Create<int32_t>(1));
   return params;
 }
 
@@ -92,6 +99,8 @@ class TestBenchmark : public BenchmarkTfLiteModel {
   explicit TestBenchmark(BenchmarkParams params)
       : BenchmarkTfLiteModel(std::move(params)) {}
   const tflite::Interpreter* GetInterpreter() { return interpreter_.get(); }
+  tflite::Interpreter* GetMutableInterpreter() { return interpreter_.get(); }
+  TfLiteStatus Invoke() { return RunImpl(); }
 
   void Prepare() {
     PrepareInputData();
@@ -160,6 +169,47 @@ TEST(BenchmarkTest, DoesntCrashWithExplicitInputInt8Model) {
   benchmark.Run();
 }
 
+TEST(BenchmarkTest, DoesntCrashWithOpBenchmark) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+
+  BenchmarkParams params = CreateFp32Params();
+  params.Set<bool>("enable_op_benchmark", true);
+  params.Set<std::string>("op_benchmark_num_threads", "1,2");
+  BenchmarkTfLiteModel benchmark(std::move(params));
+  EXPECT_EQ(kTfLiteOk, benchmark.Run());
+}
+
+TEST(BenchmarkTest, BenchmarksEachOp) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+
+  TestBenchmark benchmark(CreateFp32Params());
+  ASSERT_EQ(kTfLiteOk, benchmark.Init());
+  benchmark.Prepare();
+  ASSERT_EQ(kTfLiteOk, benchmark.Invoke());
+
+  OpBenchmarkOptions options;
+  options.num_runs = 2;
+  options.num_threads = {1, 2};
+  options.cache_flush_bytes = 1024;
+  std::vector<OpBenchmarkResult> results;
+  ASSERT_EQ(kTfLiteOk, BenchmarkOps(benchmark.GetMutableInterpreter(), options,
+                                    &results));
+
+  // Each op of the plan, for each number of threads.
+  const int num_ops = benchmark.GetInterpreter()->execution_plan().size();
+  ASSERT_EQ(results.size(), 2 * num_ops);
+  for (int i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(results[i].num_threads, i < num_ops ? 1 : 2);
+    EXPECT_EQ(results[i].op_name, "ADD");
+    EXPECT_EQ(results[i].cold_time_us.count(), 2);
+    EXPECT_EQ(results[i].hot_time_us.count(), 2);
+    // One addition per element of the [1, 8, 8, 3] output, and two inputs and
+    // one output of 192 floats.
+    EXPECT_EQ(results[i].cost.flops, 192);
+    EXPECT_EQ(results[i].cost.bytes, 3 * 192 * sizeof(float));
+  }
+}
+
 class MaxDurationWorksTestListener : public BenchmarkListener {
   void OnBenchmarkEnd(const BenchmarkResults& results) override {
     const int64_t num_actul_runs = results.inference_time_us().count();
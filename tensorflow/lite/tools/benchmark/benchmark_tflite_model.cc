@@ -51,6 +51,7 @@ limitations under the License.
 #include "tensorflow/lite/string_util.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_utils.h"
 #include "tensorflow/lite/tools/benchmark/logging.h"
+#include "tensorflow/lite/tools/benchmark/op_benchmark.h"
 #include "tensorflow/lite/tools/evaluation/utils.h"
 
 void RegisterSelectedOps(::tflite::MutableOpResolver* resolver);
@@ -113,6 +114,22 @@ class RuyProfileListener : public BenchmarkListener {
   std::unique_ptr<ruy::profiler::ScopeProfile> ruy_profile_;
 };
 
+// Benchmarks each op on its own after the regular runs, with the shapes and
+// data of the last run.
+class OpBenchmarkListener : public BenchmarkListener {
+ public:
+  OpBenchmarkListener(Interpreter* interpreter, OpBenchmarkOptions options)
+      : interpreter_(interpreter), options_(std::move(options)) {
+    TFLITE_BENCHMARK_CHECK(interpreter);
+  }
+
+  void OnBenchmarkEnd(const BenchmarkResults& results) override;
+
+ private:
+  Interpreter* interpreter_;
+  OpBenchmarkOptions options_;
+};
+
 void ProfilingListener::OnBenchmarkStart(const BenchmarkParams& params) {
   // At this point, we have completed the prepration for benchmark runs
   // including TFLite interpreter initialization etc. So we are going to process
@@ -156,6 +173,16 @@ void RuyProfileListener::OnBenchmarkEnd(const BenchmarkResults& results) {
   ruy_profile_ = nullptr;
 }
 
+void OpBenchmarkListener::OnBenchmarkEnd(const BenchmarkResults& results) {
+  std::vector<OpBenchmarkResult> op_results;
+  if (BenchmarkOps(interpreter_, options_, &op_results) != kTfLiteOk) {
+    TFLITE_LOG(ERROR) << "Failed to benchmark ops.";
+  }
+  TFLITE_LOG(INFO) << "Op-wise Benchmark, " << options_.num_runs
+                   << " cache-cold and cache-hot runs of each op:";
+  TFLITE_LOG(INFO) << OpBenchmarkResultsToString(op_results);
+}
+
 std::vector<std::string> Split(const std::string& str, const char delim) {
   std::vector<std::string> results;
   if (!util::SplitAndParse(str, delim, &results)) {
@@ -299,6 +326,14 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
       BenchmarkParam::Create<bool>(kOpProfilingEnabledDefault));
   default_params.AddParam("max_profiling_buffer_entries",
                           BenchmarkParam::Create<int32_t>(1024));
+  default_params.AddParam("enable_op_benchmark",
+                          BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("op_benchmark_num_runs",
+                          BenchmarkParam::Create<int32_t>(20));
+  default_params.AddParam("op_benchmark_num_threads",
+                          BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("op_benchmark_cache_flush_mb",
+                          BenchmarkParam::Create<int32_t>(64));
   return default_params;
 }
 
@@ -352,7 +387,20 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
                      "require delegate to run the entire graph"),
     CreateFlag<bool>("enable_op_profiling", &params_, "enable op profiling"),
     CreateFlag<int32_t>("max_profiling_buffer_entries", &params_,
-                        "max profiling buffer entries")
+                        "max profiling buffer entries"),
+    CreateFlag<bool>("enable_op_benchmark", &params_,
+                     "after the regular runs, benchmark each op on its own "
+                     "with the shapes of the model"),
+    CreateFlag<int32_t>("op_benchmark_num_runs", &params_,
+                        "number of cache-cold and of cache-hot runs of each "
+                        "op in the op benchmark"),
+    CreateFlag<std::string>(
+        "op_benchmark_num_threads", &params_,
+        "comma-separated numbers of threads to run each op with in the op "
+        "benchmark, e.g. 1,2,4. Defaults to --num_threads"),
+    CreateFlag<int32_t>("op_benchmark_cache_flush_mb", &params_,
+                        "megabytes written before each cache-cold run of an "
+                        "op, should exceed the size of the caches")
   };
 
   flags.insert(flags.end(), specific_flags.begin(), specific_flags.end());
@@ -410,6 +458,18 @@ void BenchmarkTfLiteModel::LogParams() {
   TFLITE_LOG(INFO) << "Max profiling buffer entries: ["
                    << params_.Get<int32_t>("max_profiling_buffer_entries")
                    << "]";
+  TFLITE_LOG(INFO) << "Enable op benchmark: ["
+                   << params_.Get<bool>("enable_op_benchmark") << "]";
+  if (params_.Get<bool>("enable_op_benchmark")) {
+    TFLITE_LOG(INFO) << "Op benchmark runs: ["
+                     << params_.Get<int32_t>("op_benchmark_num_runs") << "]";
+    TFLITE_LOG(INFO) << "Op benchmark threads: ["
+                     << params_.Get<std::string>("op_benchmark_num_threads")
+                     << "]";
+    TFLITE_LOG(INFO) << "Op benchmark cache flush (MB): ["
+                     << params_.Get<int32_t>("op_benchmark_cache_flush_mb")
+                     << "]";
+  }
 }
 
 TfLiteStatus BenchmarkTfLiteModel::ValidateParams() {
@@ -418,6 +478,13 @@ TfLiteStatus BenchmarkTfLiteModel::ValidateParams() {
         << "Please specify the name of your TF Lite input file with --graph";
     return kTfLiteError;
   }
+  std::vector<int> op_benchmark_num_threads;
+  if (!util::SplitAndParse(params_.Get<std::string>("op_benchmark_num_threads"),
+                           ',', &op_benchmark_num_threads)) {
+    TFLITE_LOG(ERROR) << "Incorrect --op_benchmark_num_threads: "
+                      << params_.Get<std::string>("op_benchmark_num_threads");
+    return kTfLiteError;
+  }
 
   return PopulateInputLayerInfo(
       params_.Get<std::string>("input_layer"),
@@ -645,6 +712,19 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
   ruy_profiling_listener_.reset(new RuyProfileListener());
   AddListener(ruy_profiling_listener_.get());
 
+  if (params_.Get<bool>("enable_op_benchmark")) {
+    OpBenchmarkOptions options;
+    options.num_runs = params_.Get<int32_t>("op_benchmark_num_runs");
+    util::SplitAndParse(params_.Get<std::string>("op_benchmark_num_threads"),
+                        ',', &options.num_threads);
+    options.cache_flush_bytes =
+        int64_t{params_.Get<int32_t>("op_benchmark_cache_flush_mb")} * 1024 *
+        1024;
+    op_benchmark_listener_.reset(
+        new OpBenchmarkListener(interpreter_.get(), std::move(options)));
+    AddListener(op_benchmark_listener_.get());
+  }
+
   return kTfLiteOk;
 }
 
@@ -48,11 +48,12 @@ typedef enum TfLiteStatus { kTfLiteOk = 0, kTfLiteError = 1 } TfLiteStatus;
 // need. Access to the external contexts is controled by one of the
 // corresponding support files.
 typedef enum TfLiteExternalContextType {
-  kTfLiteEigenContext = 0,       // include eigen_support.h to use.
-  kTfLiteGemmLowpContext = 1,    // include gemm_support.h to use.
-  kTfLiteEdgeTpuContext = 2,     // Placeholder for Edge TPU support.
-  kTfLiteCpuBackendContext = 3,  // include cpu_backend_support.h to use.
-  kTfLiteMaxExternalContexts = 4
+  kTfLiteEigenContext = 0,           // include eigen_support.h to use.
+  kTfLiteGemmLowpContext = 1,        // include gemm_support.h to use.
+  kTfLiteEdgeTpuContext = 2,         // Placeholder for Edge TPU support.
+  kTfLiteCpuBackendContext = 3,      // include cpu_backend_support.h to use.
+  kTfLiteModelResourcesContext = 4,  // include model_resources.h to use.
+  kTfLiteMaxExternalContexts = 5
 } TfLiteExternalContextType;
 
 // Forward declare so dependent structs and methods can reference these types
@@ -0,0 +1,215 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/op_benchmark.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/profiling/time.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/tools/benchmark/logging.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+int64_t NumElements(const TfLiteTensor& tensor) {
+  int64_t count = 1;
+  for (int i = 0; i < tensor.dims->size; ++i) {
+    count *= tensor.dims->data[i];
+  }
+  return count;
+}
+
+const TfLiteTensor* GetTensor(const TfLiteContext& context,
+                              const TfLiteIntArray* indices, int i) {
+  if (i >= indices->size || indices->data[i] < 0) return nullptr;
+  return &context.tensors[indices->data[i]];
+}
+
+std::string GetOpName(const TfLiteRegistration& registration) {
+  if (registration.builtin_code == kTfLiteBuiltinCustom) {
+    return registration.custom_name ? registration.custom_name
+                                    : "UnknownCustomOp";
+  }
+  return EnumNameBuiltinOperator(
+      static_cast<BuiltinOperator>(registration.builtin_code));
+}
+
+// Keeps the flush buffer from being optimized away.
+volatile uint8_t cache_flush_sink = 0;
+
+void FlushCache(std::vector<uint8_t>* buffer) {
+  for (size_t i = 0; i < buffer->size(); i += 64) {
+    (*buffer)[i] += 1;
+  }
+  cache_flush_sink = (*buffer)[0];
+}
+
+}  // namespace
+
+OpCost EstimateOpCost(const TfLiteContext& context, const TfLiteNode& node,
+                      const TfLiteRegistration& registration) {
+  OpCost cost;
+  for (const TfLiteIntArray* tensors : {node.inputs, node.outputs}) {
+    for (int i = 0; i < tensors->size; ++i) {
+      const TfLiteTensor* tensor = GetTensor(context, tensors, i);
+      if (tensor) cost.bytes += tensor->bytes;
+    }
+  }
+  // The cost of a delegated partition is unknown.
+  if (node.delegate || node.outputs->size == 0) return cost;
+  const TfLiteTensor* output = GetTensor(context, node.outputs, 0);
+  if (!output) return cost;
+  const int64_t output_elements = NumElements(*output);
+  cost.flops = output_elements;
+
+  const TfLiteTensor* filter = GetTensor(context, node.inputs, 1);
+  switch (registration.builtin_code) {
+    case kTfLiteBuiltinConv2d:
+      // Filter is [out_channels, height, width, in_channels].
+      if (filter && filter->dims->size == 4) {
+        cost.flops = 2 * output_elements * filter->dims->data[1] *
+                     filter->dims->data[2] * filter->dims->data[3];
+      }
+      break;
+    case kTfLiteBuiltinDepthwiseConv2d:
+      // Filter is [1, height, width, out_channels].
+      if (filter && filter->dims->size == 4) {
+        cost.flops =
+            2 * output_elements * filter->dims->data[1] * filter->dims->data[2];
+      }
+      break;
+    case kTfLiteBuiltinFullyConnected:
+      // Weights are [out_channels, accum_depth].
+      if (filter && filter->dims->size == 2) {
+        cost.flops = 2 * output_elements * filter->dims->data[1];
+      }
+      break;
+    case kTfLiteBuiltinTransposeConv: {
+      // Every input element is multiplied by the [out_channels, height, width]
+      // slice of the [out_channels, height, width, in_channels] filter for its
+      // channel.
+      const TfLiteTensor* input = GetTensor(context, node.inputs, 2);
+      if (input && filter && filter->dims->size == 4) {
+        cost.flops = 2 * NumElements(*input) * filter->dims->data[0] *
+                     filter->dims->data[1] * filter->dims->data[2];
+      }
+      break;
+    }
+    case kTfLiteBuiltinAveragePool2d:
+    case kTfLiteBuiltinMaxPool2d:
+    case kTfLiteBuiltinL2Pool2d:
+      if (node.builtin_data) {
+        const auto* params =
+            reinterpret_cast<const TfLitePoolParams*>(node.builtin_data);
+        cost.flops =
+            output_elements * params->filter_width * params->filter_height;
+      }
+      break;
+    default:
+      break;
+  }
+  return cost;
+}
+
+TfLiteStatus BenchmarkOps(Interpreter* interpreter,
+                          const OpBenchmarkOptions& options,
+                          std::vector<OpBenchmarkResult>* results) {
+  Subgraph& subgraph = interpreter->primary_subgraph();
+  TfLiteContext* context = subgraph.context();
+  const int initial_num_threads = context->recommended_num_threads;
+  std::vector<int> num_threads = options.num_threads;
+  if (num_threads.empty()) num_threads.push_back(initial_num_threads);
+  std::vector<uint8_t> flush_buffer(options.cache_flush_bytes);
+
+  TfLiteStatus status = kTfLiteOk;
+  for (int threads : num_threads) {
+    interpreter->SetNumThreads(threads);
+    for (int node_index : subgraph.execution_plan()) {
+      const auto* node_and_registration =
+          subgraph.node_and_registration(node_index);
+      TfLiteNode* node = const_cast<TfLiteNode*>(&node_and_registration->first);
+      const TfLiteRegistration& registration = node_and_registration->second;
+      if (!registration.invoke) continue;
+
+      OpBenchmarkResult result;
+      result.node_index = node_index;
+      result.op_name = GetOpName(registration);
+      result.num_threads = threads;
+      result.cost = EstimateOpCost(*context, *node, registration);
+      for (int run = 0; run < options.num_runs && status == kTfLiteOk; ++run) {
+        if (!flush_buffer.empty()) FlushCache(&flush_buffer);
+        int64_t start_us = profiling::time::NowMicros();
+        status = registration.invoke(context, node);
+        result.cold_time_us.UpdateStat(profiling::time::NowMicros() -
+                                       start_us);
+      }
+      // The runs above leave the data of the op in the caches.
+      for (int run = 0; run < options.num_runs && status == kTfLiteOk; ++run) {
+        int64_t start_us = profiling::time::NowMicros();
+        status = registration.invoke(context, node);
+        result.hot_time_us.UpdateStat(profiling::time::NowMicros() - start_us);
+      }
+      if (status != kTfLiteOk) {
+        TFLITE_LOG(ERROR) << "Failed to invoke node " << node_index << " ("
+                          << result.op_name << ").";
+        break;
+      }
+      results->push_back(std::move(result));
+    }
+    if (status != kTfLiteOk) break;
+  }
+  interpreter->SetNumThreads(initial_num_threads);
+  return status;
+}
+
+std::string OpBenchmarkResultsToString(
+    const std::vector<OpBenchmarkResult>& results) {
+  std::stringstream stream;
+  stream << std::setw(6) << "node" << std::setw(28) << "op" << std::setw(8)
+         << "threads" << std::setw(14) << "cold [us]" << std::setw(14)
+         << "hot [us]" << std::setw(12) << "MFLOP" << std::setw(10) << "KB"
+         << std::setw(10) << "GFLOP/s" << std::setw(10) << "GB/s"
+         << std::endl;
+  stream << std::fixed << std::setprecision(3);
+  for (const auto& result : results) {
+    const double hot_us = result.hot_time_us.avg();
+    stream << std::setw(6) << result.node_index << std::setw(28)
+           << result.op_name << std::setw(8) << result.num_threads
+           << std::setw(14) << result.cold_time_us.avg() << std::setw(14)
+           << hot_us << std::setw(12) << result.cost.flops / 1e6
+           << std::setw(10) << result.cost.bytes / 1024.0;
+    // FLOP per us is MFLOP/s, and bytes per us MB/s.
+    if (hot_us > 0) {
+      stream << std::setw(10) << result.cost.flops / hot_us / 1e3
+             << std::setw(10) << result.cost.bytes / hot_us / 1e3;
+    } else {
+      stream << std::setw(10) << "-" << std::setw(10) << "-";
+    }
+    stream << std::endl;
+  }
+  return stream.str();
+}
+
+}  // namespace benchmark
+}  // namespace tflite
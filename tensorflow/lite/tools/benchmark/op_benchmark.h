@@ -0,0 +1,80 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_TOOLS_BENCHMARK_OP_BENCHMARK_H_
+#define TENSORFLOW_LITE_TOOLS_BENCHMARK_OP_BENCHMARK_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/util/stats_calculator.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace tflite {
+namespace benchmark {
+
+// Work done by one run of an op: arithmetic operations, counting a multiply-add
+// as two, and bytes of the input and output tensors. The operation count is
+// exact for convolutions, fully connected and pooling ops, and one per output
+// element for any other op.
+struct OpCost {
+  int64_t flops = 0;
+  int64_t bytes = 0;
+};
+
+OpCost EstimateOpCost(const TfLiteContext& context, const TfLiteNode& node,
+                      const TfLiteRegistration& registration);
+
+struct OpBenchmarkOptions {
+  // Runs of each op for each number of threads, with a cold and a hot cache.
+  int num_runs = 20;
+  // Numbers of threads to run each op with. The current number of threads of
+  // the interpreter if empty.
+  std::vector<int> num_threads;
+  // Bytes written between two runs to evict the data of the op from the
+  // caches, for the cache-cold runs.
+  int64_t cache_flush_bytes = 64 * 1024 * 1024;
+};
+
+struct OpBenchmarkResult {
+  int node_index;
+  std::string op_name;
+  int num_threads;
+  OpCost cost;
+  tensorflow::Stat<int64_t> cold_time_us;
+  tensorflow::Stat<int64_t> hot_time_us;
+};
+
+// Benchmarks each op of the execution plan of the primary subgraph on its own,
+// by invoking its kernel directly, with the shapes and data that the tensors
+// have after a regular run. Call it after AllocateTensors() and at least one
+// Invoke(). The number of threads of the interpreter is restored at the end.
+// Threads only apply to kernels that read them on Eval, which includes the
+// kernels using the CPU backend.
+TfLiteStatus BenchmarkOps(Interpreter* interpreter,
+                          const OpBenchmarkOptions& options,
+                          std::vector<OpBenchmarkResult>* results);
+
+// Formats the results as a table, with the achieved GFLOP/s and GB/s of the
+// cache-hot runs.
+std::string OpBenchmarkResultsToString(
+    const std::vector<OpBenchmarkResult>& results);
+
+}  // namespace benchmark
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_BENCHMARK_OP_BENCHMARK_H_
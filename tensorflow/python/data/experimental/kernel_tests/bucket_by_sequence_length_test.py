@@ -460,6 +460,102 @@ class BucketBySequenceLengthTest(test_base.DatasetTestBase,
     expected_batches = _compute_expected_batches(param_drop_remainder)
     self.assertEqual(batches, expected_batches)
 
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(param_drop_remainder=[True, False])))
+  def testLengthComponent(self, param_drop_remainder):
+
+    def _generator():
+      text = [[1, 2, 3], [3, 4, 5, 6, 7], [1, 2], [8, 9, 0, 2, 3], [4]]
+      label = [1, 2, 1, 2, 1]
+      for x, y in zip(text, label):
+        yield (x, y)
+
+    def build_dataset(**kwargs):
+      return dataset_ops.Dataset.from_generator(
+          generator=_generator,
+          output_types=(dtypes.int64, dtypes.int32),
+          output_shapes=([None], [])).apply(
+              grouping.bucket_by_sequence_length(
+                  bucket_boundaries=[4],
+                  bucket_batch_sizes=[2, 2],
+                  padding_values=(-1, 0),
+                  drop_remainder=param_drop_remainder,
+                  **kwargs))
+
+    fused = build_dataset(element_length_func=None, length_component=0)
+    self.assertIsInstance(fused, grouping._BucketBySequenceLengthDataset)  # pylint: disable=protected-access
+    expected = [([[1, 2, 3], [1, 2, -1]], [1, 1]),
+                ([[3, 4, 5, 6, 7], [8, 9, 0, 2, 3]], [2, 2])]
+    if not param_drop_remainder:
+      expected.append(([[4]], [1]))
+    self.assertDatasetProduces(fused, expected)
+    self.assertDatasetProduces(
+        build_dataset(element_length_func=_element_length_fn), expected)
+
+    shapes = dataset_ops.get_legacy_output_shapes(fused)
+    batch_dim = 2 if param_drop_remainder else None
+    self.assertEqual([batch_dim, None], shapes[0].as_list())
+    self.assertEqual([batch_dim], shapes[1].as_list())
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testLengthComponentScalar(self):
+    dataset = dataset_ops.Dataset.from_tensor_slices(
+        ([1, 5, 2, 7, 3, 9], [10, 50, 20, 70, 30, 90])).apply(
+            grouping.bucket_by_sequence_length(
+                None, [4], [2, 2], length_component=0))
+    self.assertDatasetProduces(
+        dataset, [([1, 2], [10, 20]), ([5, 7], [50, 70]), ([3], [30]),
+                  ([9], [90])])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testLengthComponentPadToBoundary(self):
+
+    def element_gen():
+      for length in range(1, 11):
+        yield ([1] * length,)
+
+    dataset = dataset_ops.Dataset.from_generator(
+        element_gen, (dtypes.int64,), ([None],)).apply(
+            grouping.bucket_by_sequence_length(
+                None, [3, 7, 11], [2, 2, 2, 2],
+                pad_to_bucket_boundary=True,
+                length_component=0))
+    self.assertDatasetProduces(
+        dataset, [([[1, 0], [1, 1]],),
+                  ([[1, 1, 1, 0, 0, 0], [1, 1, 1, 1, 0, 0]],),
+                  ([[1, 1, 1, 1, 1, 0], [1, 1, 1, 1, 1, 1]],),
+                  ([[1, 1, 1, 1, 1, 1, 1, 0, 0, 0],
+                    [1, 1, 1, 1, 1, 1, 1, 1, 0, 0]],),
+                  ([[1, 1, 1, 1, 1, 1, 1, 1, 1, 0],
+                    [1, 1, 1, 1, 1, 1, 1, 1, 1, 1]],)])
+
+    dataset = dataset_ops.Dataset.from_tensors([1] * 3).apply(
+        grouping.bucket_by_sequence_length(
+            None, [3], [2, 2], pad_to_bucket_boundary=True,
+            length_component=0))
+    self.assertDatasetProduces(
+        dataset,
+        expected_error=(errors.InvalidArgumentError, "bucket_boundaries"))
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testLengthComponentNoPadding(self):
+    dataset = dataset_ops.Dataset.from_tensor_slices(
+        [[1, 2], [3, 4], [5, 6]]).apply(
+            grouping.bucket_by_sequence_length(
+                None, [4], [2, 2], no_padding=True, length_component=0))
+    self.assertNotIsInstance(dataset, grouping._BucketBySequenceLengthDataset)  # pylint: disable=protected-access
+    self.assertDatasetProduces(dataset, [[[1, 2], [3, 4]], [[5, 6]]])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testLengthFuncXorLengthComponent(self):
+    with self.assertRaises(ValueError):
+      grouping.bucket_by_sequence_length(None, [4], [2, 2])
+    with self.assertRaises(ValueError):
+      grouping.bucket_by_sequence_length(
+          _element_length_fn, [4], [2, 2], length_component=0)
+
 
 if __name__ == "__main__":
   test.main()
@@ -0,0 +1,60 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the experimental `run_on_workers` transformation."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from absl.testing import parameterized
+
+from tensorflow.python.data.experimental.ops import data_service_ops
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import combinations
+from tensorflow.python.framework import errors
+from tensorflow.python.platform import test
+from tensorflow.python.training import server_lib
+
+
+class DataServiceOpsTest(test_base.DatasetTestBase, parameterized.TestCase):
+
+  def setUp(self):
+    super(DataServiceOpsTest, self).setUp()
+    self._workers = [server_lib.Server.create_local_server() for _ in range(3)]
+    self._targets = [worker.target for worker in self._workers]
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testOneWorker(self):
+    dataset = dataset_ops.Dataset.range(10).map(lambda x: x * 2).apply(
+        data_service_ops.run_on_workers(self._targets[:1], buffer_size=2))
+    self.assertDatasetProduces(dataset, list(range(0, 20, 2)))
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testShardedAcrossWorkers(self):
+    dataset = dataset_ops.Dataset.range(100).apply(
+        data_service_ops.run_on_workers(self._targets))
+    self.assertDatasetProduces(
+        dataset, list(range(100)), assert_items_equal=True)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testInvalidBufferSize(self):
+    with self.assertRaises(errors.InvalidArgumentError):
+      dataset = dataset_ops.Dataset.range(10).apply(
+          data_service_ops.run_on_workers(self._targets, buffer_size=0))
+      self.evaluate(self.getNext(dataset)())
+
+
+if __name__ == "__main__":
+  test.main()
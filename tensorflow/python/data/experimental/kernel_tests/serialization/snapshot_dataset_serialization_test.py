@@ -165,5 +165,23 @@ class SnapshotDatasetSerializationTest(
         outputs, (list(range(1000)) + list(range(100)) + list(range(900))))
 
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testCheckpointRawTensorLayout(self):
+    os.environ["TF_SNAPSHOT_RAW_TENSOR_LAYOUT"] = "true"
+    self.addCleanup(os.environ.pop, "TF_SNAPSHOT_RAW_TENSOR_LAYOUT")
+    ds_fn = self._build_snapshot_dataset(repeat=True)
+
+    # Restores the writer halfway through the first epoch, then the reader
+    # halfway through the second one.
+    outputs = self.gen_outputs(ds_fn, [], 500, verify_exhausted=False)
+    outputs.extend(
+        self.gen_outputs(
+            ds_fn, [], 1000, ckpt_saved=True, verify_exhausted=False))
+    self.assertSequenceEqual(outputs, list(range(1000)) + list(range(500)))
+    outputs.extend(
+        self.gen_outputs(
+            ds_fn, [], 500, ckpt_saved=True, verify_exhausted=False))
+    self.assertSequenceEqual(outputs, list(range(1000)) * 2)
+
 if __name__ == "__main__":
   test.main()
@@ -284,6 +284,29 @@ class SnapshotDatasetTest(reader_dataset_ops_test_base.TFRecordDatasetTestBase,
         tmpdir, compression=compression))
     self.assertDatasetProduces(dataset2, expected)
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testReadRawTensorLayoutSnapshotAfterWrite(self):
+
+    def make_dataset(tmpdir):
+      dataset = dataset_ops.Dataset.range(100)
+      # Strings are written as protos, the other tensors as raw bytes.
+      dataset = dataset.map(lambda x: (x, string_ops.as_string(x),
+                                       gen_array_ops.fill([x % 3], x)))
+      return dataset.apply(snapshot.snapshot(tmpdir))
+
+    expected = [(x, b"%d" % x, [x] * (x % 3)) for x in range(100)]
+    tmpdir = self.makeSnapshotDirectory()
+    os.environ["TF_SNAPSHOT_RAW_TENSOR_LAYOUT"] = "true"
+    try:
+      self.assertDatasetProduces(make_dataset(tmpdir), expected)
+    finally:
+      del os.environ["TF_SNAPSHOT_RAW_TENSOR_LAYOUT"]
+    self.assertSnapshotDirectoryContains(tmpdir, 1, 1, 1)
+
+    # The layout is recorded in the snapshot, so reading it back does not
+    # depend on the environment.
+    self.assertDatasetProduces(make_dataset(tmpdir), expected)
+
   @combinations.generate(test_base.default_test_combinations())
   def testReadShuffledSnapshotAfterWrite(self):
     self.setUpTFRecord(num_files=10, num_records=50)
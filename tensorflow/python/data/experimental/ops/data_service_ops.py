@@ -0,0 +1,65 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Experimental API for running `tf.data` pipelines on remote workers."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import gen_experimental_dataset_ops
+
+
+class _DataServiceDataset(dataset_ops.UnaryUnchangedStructureDataset):
+  """A `Dataset` whose input pipeline runs on remote workers."""
+
+  def __init__(self, input_dataset, targets, buffer_size):
+    self._input_dataset = input_dataset
+    self._targets = ops.convert_to_tensor(
+        targets, dtype=dtypes.string, name="targets")
+    self._buffer_size = ops.convert_to_tensor(
+        buffer_size, dtype=dtypes.int64, name="buffer_size")
+    variant_tensor = gen_experimental_dataset_ops.data_service_dataset(
+        self._input_dataset._variant_tensor,  # pylint: disable=protected-access
+        targets=self._targets,
+        buffer_size=self._buffer_size,
+        **self._flat_structure)
+    super(_DataServiceDataset, self).__init__(input_dataset, variant_tensor)
+
+
+def run_on_workers(targets, buffer_size=16):
+  """Runs the input pipeline on the TensorFlow servers at `targets`.
+
+  Each server runs its own copy of the input pipeline, on a static shard of
+  the input as chosen by `tf.data.experimental.AutoShardPolicy.AUTO`, and the
+  elements of all the shards are interleaved in the order in which they
+  arrive. Every iterator of the resulting dataset starts its own copy of the
+  pipeline on each server. Iterators can't be checkpointed.
+
+  Args:
+    targets: A list of `grpc://` targets of running TensorFlow servers, e.g.
+      `tf.distribute.Server.target`.
+    buffer_size: The maximum number of elements buffered on the client.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    `tf.data.Dataset.apply`.
+  """
+
+  def _apply_fn(dataset):
+    return _DataServiceDataset(dataset, targets, buffer_size)
+
+  return _apply_fn
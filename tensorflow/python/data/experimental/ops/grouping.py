@@ -21,12 +21,15 @@ import numpy as np
 
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.util import nest
+from tensorflow.python.data.util import sparse
 from tensorflow.python.data.util import structure
 from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
+from tensorflow.python.framework import smart_cond
 from tensorflow.python.framework import tensor_shape
 from tensorflow.python.framework import tensor_spec
+from tensorflow.python.framework import tensor_util
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import check_ops
 from tensorflow.python.ops import gen_experimental_dataset_ops as ged_ops
@@ -132,7 +135,8 @@ def bucket_by_sequence_length(element_length_func,
                               padding_values=None,
                               pad_to_bucket_boundary=False,
                               no_padding=False,
-                              drop_remainder=False):
+                              drop_remainder=False,
+                              length_component=None):
   """A transformation that buckets elements in a `Dataset` by length.
 
   Elements of the `Dataset` are grouped together by length and then are padded
@@ -142,10 +146,15 @@ def bucket_by_sequence_length(element_length_func,
   Grouping together elements that have similar lengths reduces the total
   fraction of padding in a batch which increases training step efficiency.
 
+  If the length of an element can be read from one of its components,
+  `length_component` can be passed instead of `element_length_func`, in which
+  case the elements are bucketed, padded and batched by a single dataset
+  rather than by one `padded_batch` per window of `group_by_window`.
+
   Args:
     element_length_func: function from element in `Dataset` to `tf.int32`,
       determines the length of the element, which will determine the bucket it
-      goes into.
+      goes into. Must be `None` if `length_component` is set.
     bucket_boundaries: `list<int>`, upper length boundaries of the buckets.
     bucket_batch_sizes: `list<int>`, batch size per bucket. Length should be
       `len(bucket_boundaries) + 1`.
@@ -166,18 +175,39 @@ def bucket_by_sequence_length(element_length_func,
       whether the last batch should be dropped in the case it has fewer than
       `batch_size` elements; the default behavior is not to drop the smaller
       batch.
+    length_component: (Optional.) `int`, index of the component, in the
+      flattened structure of the elements, that determines their length. The
+      length is the value of that component if it is an integer scalar, and
+      the size of its first dimension otherwise.
 
   Returns:
     A `Dataset` transformation function, which can be passed to
     `tf.data.Dataset.apply`.
 
   Raises:
-    ValueError: if `len(bucket_batch_sizes) != len(bucket_boundaries) + 1`.
+    ValueError: if `len(bucket_batch_sizes) != len(bucket_boundaries) + 1`, or
+      if not exactly one of `element_length_func` and `length_component` is
+      set.
   """
   with ops.name_scope("bucket_by_seq_length"):
     if len(bucket_batch_sizes) != (len(bucket_boundaries) + 1):
       raise ValueError(
           "len(bucket_batch_sizes) must equal len(bucket_boundaries) + 1")
+    if (element_length_func is None) == (length_component is None):
+      raise ValueError(
+          "Exactly one of element_length_func and length_component must be "
+          "set.")
+
+    if length_component is not None:
+
+      def component_length(*args):
+        component = nest.flatten(args)[length_component]
+        if (component.shape.rank == 0 and
+            component.dtype in (dtypes.int32, dtypes.int64)):
+          return component
+        return array_ops.shape(component, out_type=dtypes.int64)[0]
+
+      element_length_func = component_length
 
     batch_sizes = constant_op.constant(bucket_batch_sizes, dtype=dtypes.int64)
 
@@ -237,6 +267,12 @@ def bucket_by_sequence_length(element_length_func,
           batch_size, shapes, padding_values, drop_remainder=drop_remainder)
 
     def _apply_fn(dataset):
+      if length_component is not None and not no_padding:
+        return _BucketBySequenceLengthDataset(
+            dataset, bucket_boundaries, bucket_batch_sizes,
+            padded_shapes or dataset_ops.get_legacy_output_shapes(dataset),
+            padding_values, drop_remainder, length_component,
+            pad_to_bucket_boundary)
       return dataset.apply(
           group_by_window(element_to_bucket_id, batching_fn,
                           window_size_func=window_size_fn))
@@ -244,6 +280,72 @@ def bucket_by_sequence_length(element_length_func,
     return _apply_fn
 
 
+class _BucketBySequenceLengthDataset(dataset_ops.UnaryDataset):
+  """A `Dataset` that buckets, pads and batches its input by length."""
+
+  def __init__(self, input_dataset, bucket_boundaries, bucket_batch_sizes,
+               padded_shapes, padding_values, drop_remainder, length_component,
+               pad_to_bucket_boundary):
+    """See `bucket_by_sequence_length()` for details."""
+    self._input_dataset = input_dataset
+    if sparse.any_sparse(
+        dataset_ops.get_legacy_output_classes(input_dataset)):
+      raise TypeError(
+          "Batching of padded sparse tensors is not currently supported")
+    padding_values = dataset_ops._padding_values_or_default(  # pylint: disable=protected-access
+        padding_values, input_dataset)
+
+    input_shapes = dataset_ops.get_legacy_output_shapes(input_dataset)
+    flat_padded_shapes = [
+        dataset_ops._padded_shape_to_tensor(padded_shape, input_shape)  # pylint: disable=protected-access
+        for input_shape, padded_shape in zip(
+            nest.flatten(input_shapes),
+            nest.flatten_up_to(input_shapes, padded_shapes))
+    ]
+    flat_padding_values = nest.flatten(
+        nest.map_structure_up_to(
+            input_shapes,
+            dataset_ops._padding_value_to_tensor,  # pylint: disable=protected-access
+            padding_values,
+            dataset_ops.get_legacy_output_types(input_dataset)))
+    drop_remainder = ops.convert_to_tensor(
+        drop_remainder, dtype=dtypes.bool, name="drop_remainder")
+
+    # The batch dimension is only known when every batch is full and of the
+    # same size.
+    batch_dim = None
+    if (smart_cond.smart_constant_value(drop_remainder) and
+        len(set(bucket_batch_sizes)) == 1):
+      batch_dim = bucket_batch_sizes[0]
+    output_shapes = nest.pack_sequence_as(input_shapes, [
+        tensor_shape.TensorShape([batch_dim]).concatenate(
+            tensor_util.constant_value_as_shape(s))
+        for s in flat_padded_shapes
+    ])
+    self._structure = structure.convert_legacy_structure(
+        dataset_ops.get_legacy_output_types(input_dataset), output_shapes,
+        dataset_ops.get_legacy_output_classes(input_dataset))
+
+    variant_tensor = ged_ops.bucket_by_sequence_length_dataset(
+        self._input_dataset._variant_tensor,  # pylint: disable=protected-access
+        bucket_boundaries=ops.convert_to_tensor(
+            bucket_boundaries, dtype=dtypes.int64, name="bucket_boundaries"),
+        bucket_batch_sizes=ops.convert_to_tensor(
+            bucket_batch_sizes, dtype=dtypes.int64, name="bucket_batch_sizes"),
+        padded_shapes=flat_padded_shapes,
+        padding_values=flat_padding_values,
+        drop_remainder=drop_remainder,
+        length_component=length_component,
+        pad_to_bucket_boundary=pad_to_bucket_boundary,
+        output_shapes=structure.get_flat_tensor_shapes(self._structure))
+    super(_BucketBySequenceLengthDataset, self).__init__(input_dataset,
+                                                         variant_tensor)
+
+  @property
+  def element_spec(self):
+    return self._structure
+
+
 class _GroupByReducerDataset(dataset_ops.UnaryDataset):
   """A `Dataset` that groups its input and performs a reduction."""
 
@@ -97,7 +97,7 @@ class _CopyToDeviceDataset(dataset_ops.UnaryUnchangedStructureDataset):
     self._input_dataset = input_dataset
     self._target_device = target_device
     spec = framework_device.DeviceSpec().from_string(self._target_device)
-    self._is_gpu_target = (spec.device_type == "GPU")
+    self._is_gpu_target = (spec.device_type in ("GPU", "VE"))
     self._source_device_string = source_device
     self._source_device = ops.convert_to_tensor(source_device)
 
@@ -219,8 +219,9 @@ class _CopyToDeviceDataset(dataset_ops.UnaryUnchangedStructureDataset):
   def make_one_shot_iterator(self):
     if self._is_gpu_target:
       raise ValueError("Cannot create a one shot iterator when using "
-                       "`tf.data.experimental.copy_to_device()` on GPU. Please "
-                       "use `Dataset.make_initializable_iterator()` instead.")
+                       "`tf.data.experimental.copy_to_device()` on GPU or VE. "
+                       "Please use `Dataset.make_initializable_iterator()` "
+                       "instead.")
     else:
       return super(_CopyToDeviceDataset, self).make_one_shot_iterator()
 
@@ -156,6 +156,8 @@ def set_optimizer_experimental_options(options):
         GPUs and above. Without the use of loss scaling, this can cause
         numerical underflow (see
         `keras.mixed_precision.experimental.LossScaleOptimizer`).
+      - grouped_apply_optimization: Group per-variable optimizer updates
+        placed on a VE into one update per device.
       - disable_meta_optimizer: Disable the entire meta optimizer.
       - min_graph_nodes: The minimum number of nodes in a graph to optimizer.
         For smaller graphs, optimization is skipped.
@@ -2767,10 +2767,11 @@ class DeepConv2DTest(test.TestCase):
       os.environ["TF_USE_DEEP_CONV2D"] = "0"
       values_expect = self.evaluate([conv])
 
-      os.environ["TF_USE_DEEP_CONV2D"] = "1"
-      values_test = self.evaluate([conv])
+      for mode in ["1", "winograd2x2", "winograd4x4", "autotune"]:
+        os.environ["TF_USE_DEEP_CONV2D"] = mode
+        values_test = self.evaluate([conv])
 
-      self.assertAllClose(values_expect, values_test, rtol=1e-5, atol=1e-5)
+        self.assertAllClose(values_expect, values_test, rtol=1e-5, atol=1e-5)
 
   def _RunTestCases(self, conv_strides, padding):
     input_sizes = [[5, 5, 5, 1248], [3, 17, 17, 192], [2, 35, 35, 288],
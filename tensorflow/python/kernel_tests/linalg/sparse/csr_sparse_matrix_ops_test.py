@@ -689,6 +689,107 @@ class CSRSparseMatrixOpsTest(test.TestCase):
 
     self.assertAllClose(c_t_value, c_dense_t_value, atol=1e-5, rtol=1e-5)
 
+  def _testSparseMatrixMatMulOnCPU(self, a_mats, b_mats, **kwargs):
+    """Checks the CPU kernel of sparse_matrix_mat_mul against numpy."""
+    transpose_output = kwargs.get("transpose_output", False)
+    conjugate_output = kwargs.get("conjugate_output", False)
+    a = a_mats
+    if kwargs.get("transpose_a", False) or kwargs.get("adjoint_a", False):
+      a = np.swapaxes(a, -2, -1)
+      if kwargs.get("adjoint_a", False):
+        a = np.conj(a)
+    b = b_mats
+    if kwargs.get("transpose_b", False) or kwargs.get("adjoint_b", False):
+      b = np.swapaxes(b, -2, -1)
+      if kwargs.get("adjoint_b", False):
+        b = np.conj(b)
+    expected = np.matmul(a, b)
+    if transpose_output:
+      expected = np.swapaxes(expected, -2, -1)
+    if conjugate_output:
+      expected = np.conj(expected)
+
+    with ops.device(CPU):
+      a_sm = dense_to_csr_sparse_matrix(a_mats)
+      c = sparse_csr_matrix_ops.sparse_matrix_mat_mul(a_sm, b_mats, **kwargs)
+      c_value = self.evaluate(c)
+    self.assertAllClose(expected, c_value, rtol=1e-5, atol=1e-4)
+
+  @test_util.run_in_graph_and_eager_modes
+  def testSparseMatrixMatMulPowerLawRows(self):
+    # Row i has about 300 / (i + 1) nonzeros, so the shards of the first rows
+    # hold few rows and those of the last rows many.
+    np.random.seed(0)
+    a_mats = np.zeros([2, 200, 300], dtype=np.float32)
+    for batch in range(2):
+      for row in range(200):
+        cols = np.random.choice(300, 300 // (row + 1), replace=False)
+        a_mats[batch, row, cols] = np.random.randn(len(cols))
+    b_mats = np.random.randn(2, 300, 17).astype(np.float32)
+    self._testSparseMatrixMatMulOnCPU(a_mats, b_mats)
+    # A single dense row and empty rows otherwise.
+    a_mats = np.zeros([1, 50, 300], dtype=np.float32)
+    a_mats[0, 7, :] = np.random.randn(300)
+    self._testSparseMatrixMatMulOnCPU(a_mats, b_mats[:1])
+
+  @test_util.run_in_graph_and_eager_modes
+  def testSparseMatrixMatMulEmptyLeadingAndTrailingRows(self):
+    np.random.seed(0)
+    sparsify = lambda m: m * (m > 0)
+    a_mats = sparsify(np.random.randn(3, 100, 40)).astype(np.float32)
+    a_mats[:, :10, :] = 0
+    a_mats[:, 90:, :] = 0
+    # One of the batches has no nonzeros at all.
+    a_mats[1, :, :] = 0
+    b_mats = np.random.randn(3, 40, 9).astype(np.float32)
+    self._testSparseMatrixMatMulOnCPU(a_mats, b_mats)
+    self._testSparseMatrixMatMulOnCPU(a_mats[0], b_mats[0])
+
+  @test_util.run_in_graph_and_eager_modes
+  def testSparseMatrixMatMulFewerRowsThanShards(self):
+    # The kernel splits the rows of a product into at least 20 shards, but
+    # never more than there are rows, so every row is a shard of its own.
+    np.random.seed(0)
+    for a_shape, b_shape in (([1, 5], [5, 3]), ([2, 3], [3, 1]),
+                             ([4, 1, 6], [4, 6, 2]), ([3, 2, 2], [3, 2, 5])):
+      a_mats = np.random.randn(*a_shape).astype(np.float32)
+      # Leave the first element of each matrix out.
+      a_mats[..., 0, 0] = 0
+      b_mats = np.random.randn(*b_shape).astype(np.float32)
+      self._testSparseMatrixMatMulOnCPU(a_mats, b_mats)
+
+  @test_util.run_in_graph_and_eager_modes
+  def testSparseMatrixMatMulComplexWithTransposes(self):
+    np.random.seed(0)
+    sparsify = lambda m: m * (m.real > 0)
+    a_shape = [3, 31, 23]
+    b_shape = [3, 23, 7]
+    for dtype in (np.complex64, np.complex128):
+      for a_flag in (None, "transpose_a", "adjoint_a"):
+        for b_flag in (None, "transpose_b", "adjoint_b"):
+          for transpose_output, conjugate_output in ((False, False),
+                                                     (False, True),
+                                                     (True, False),
+                                                     (True, True)):
+            a_dense_shape = list(a_shape)
+            b_dense_shape = list(b_shape)
+            kwargs = {
+                "transpose_output": transpose_output,
+                "conjugate_output": conjugate_output,
+            }
+            if a_flag:
+              kwargs[a_flag] = True
+              _swap(a_dense_shape, -2, -1)
+            if b_flag:
+              kwargs[b_flag] = True
+              _swap(b_dense_shape, -2, -1)
+            a_mats = sparsify(
+                np.random.randn(*a_dense_shape) +
+                1.j * np.random.randn(*a_dense_shape)).astype(dtype)
+            b_mats = (np.random.randn(*b_dense_shape) +
+                      1.j * np.random.randn(*b_dense_shape)).astype(dtype)
+            self._testSparseMatrixMatMulOnCPU(a_mats, b_mats, **kwargs)
+
   @test_util.run_in_graph_and_eager_modes
   def testSparseMatrixSparseMatMul(self):
     a_indices = np.array([[0, 0], [2, 3]])
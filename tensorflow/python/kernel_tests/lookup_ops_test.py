@@ -2979,6 +2979,39 @@ class MutableHashTableOpTest(test.TestCase):
       sorted_expected_values = np.sort([[4, 5], [2, 3], [0, 1]], axis=0)
       self.assertAllEqual(sorted_expected_values, sorted_values)
 
+  def testMutableHashTableOfTensorsLargeBatch(self):
+    with self.cached_session():
+      num_keys = 10000
+      default_val = constant_op.constant([-1, -1], dtypes.int64)
+      keys = np.arange(num_keys, dtype=np.int64)
+      values = np.stack([keys, 2 * keys], axis=1)
+      table = lookup_ops.MutableHashTable(dtypes.int64, dtypes.int64,
+                                          default_val)
+      self.evaluate(table.insert(keys, values))
+      self.assertAllEqual(num_keys, self.evaluate(table.size()))
+
+      self.evaluate(table.remove(keys[::2]))
+      self.assertAllEqual(num_keys // 2, self.evaluate(table.size()))
+
+      input_keys = np.arange(num_keys + 100, dtype=np.int64)
+      expected = np.full([num_keys + 100, 2], -1, dtype=np.int64)
+      expected[1:num_keys:2] = values[1::2]
+      self.assertAllEqual(expected, self.evaluate(table.lookup(input_keys)))
+
+      exported_keys, exported_values = self.evaluate(table.export())
+      order = np.argsort(exported_keys)
+      self.assertAllEqual(keys[1::2], exported_keys[order])
+      self.assertAllEqual(values[1::2], exported_values[order])
+
+      # Importing replaces the contents of the whole table.
+      self.evaluate(
+          lookup_ops.lookup_table_import_v2(table.resource_handle, keys[:10],
+                                            values[:10]))
+      self.assertAllEqual(10, self.evaluate(table.size()))
+      self.assertAllEqual(values[:10],
+                          self.evaluate(table.lookup(keys[:10])))
+      self.assertAllEqual([[-1, -1]], self.evaluate(table.lookup(keys[10:11])))
+
   def testMutableHashTableExportInsert(self):
     with self.cached_session():
       default_val = constant_op.constant([-1, -1], dtypes.int64)
@@ -419,6 +419,29 @@ class TransposeTest(test.TestCase):
     self._testBoth(
         np.arange(0, 1260).reshape([2, 3, 5, 7, 2, 3]).astype(np.int64))
 
+  def testInnerDimensionsTransposeCPU(self):
+    # Shapes that are not multiples of the tile size of the CPU kernel.
+    shapes_and_perms = [
+        ([67, 45], [1, 0]),
+        ([3, 70, 33], [0, 2, 1]),
+        ([2, 9, 11, 35], [0, 3, 1, 2]),  # NHWC -> NCHW
+        ([2, 35, 9, 11], [0, 2, 3, 1]),  # NCHW -> NHWC
+        ([2, 3, 64, 96], [0, 1, 3, 2]),
+    ]
+    for dtype in [np.int8, np.float16, np.float32, np.float64, np.complex64]:
+      for shape, perm in shapes_and_perms:
+        x = np.arange(np.prod(shape)).reshape(shape).astype(dtype)
+        if dtype == np.complex64:
+          x = x * np.complex(1, 2)
+        cs = [False, True] if dtype == np.complex64 else [False]
+        for c in cs:
+          np_ans = x.transpose(perm)
+          if c:
+            np_ans = np.conj(np_ans)
+          with self.cached_session(use_gpu=False):
+            tf_ans = self.evaluate(array_ops.transpose(x, perm, conjugate=c))
+          self.assertAllEqual(np_ans, tf_ans)
+
   @test_util.run_v1_only("b/120545219")
   def testTranspose2DAuto(self):
     x_np = [[1, 2, 3], [4, 5, 6]]
@@ -34,7 +34,8 @@ def batch_function(num_batch_threads,
                    batch_timeout_micros,
                    allowed_batch_sizes=None,
                    max_enqueued_batches=10,
-                   autograph=True):
+                   autograph=True,
+                   latency_budget_micros=0):
   """Batches the computation done by the decorated function.
 
   So, for example, in the following code
@@ -71,6 +72,10 @@ def batch_function(num_batch_threads,
     max_enqueued_batches: The maximum depth of the batch queue. Defaults to 10.
     autograph: Whether to use autograph to compile python and eager style code
      for efficient graph-mode execution.
+    latency_budget_micros: If positive, the number of microseconds within which
+     each call should be done. Batches are then processed early enough to meet
+     the tightest budget of their calls, given the time taken by earlier
+     batches of the same size, even before `batch_timeout_micros`.
 
   Returns:
     The decorated function will return the unbatched computation output Tensors.
@@ -100,6 +105,7 @@ def batch_function(num_batch_threads,
             batch_timeout_micros=batch_timeout_micros,
             allowed_batch_sizes=allowed_batch_sizes,
             max_enqueued_batches=max_enqueued_batches,
+            latency_budget_micros=latency_budget_micros,
             shared_name=name,
             f=computation,
             in_tensors=list(args),
@@ -287,6 +287,53 @@ class BatchOpsTest(test.TestCase):
       self.assertEqual(thread_results[0], [2])
       self.assertEqual(main_results[0], [3])
 
+  def testBatchFunctionOpWithLatencyBudget(self):
+    """Tests that a latency budget closes batches before the timeout."""
+    if context.executing_eagerly():
+      return
+    with self.cached_session() as sess:
+
+      @function.Defun(dtypes.int32)
+      def computation(in_t):
+        return in_t + 1
+
+      inp = array_ops.placeholder(dtype=dtypes.int32, shape=[1])
+      result = gen_batch_ops.batch_function(
+          [inp],
+          num_batch_threads=1,
+          max_batch_size=10,
+          batch_timeout_micros=600 * 1000 * 1000,
+          latency_budget_micros=1000,
+          Tout=[dtypes.int32],
+          f=computation,
+          captured_tensors=computation.captured_inputs)
+      # Would wait for the ten minute timeout without the budget.
+      self.assertEqual(sess.run([result], feed_dict={inp: [1]})[0], [2])
+
+  def testBatchFunctionOpSplitsLargeInputs(self):
+    """Tests that inputs larger than max_batch_size are split and rejoined."""
+    if context.executing_eagerly():
+      return
+    with self.cached_session() as sess:
+
+      @function.Defun(dtypes.int32)
+      def computation(in_t):
+        return in_t + 1
+
+      inp = array_ops.placeholder(dtype=dtypes.int32, shape=[None])
+      result = gen_batch_ops.batch_function(
+          [inp],
+          num_batch_threads=1,
+          max_batch_size=4,
+          batch_timeout_micros=1000,
+          allowed_batch_sizes=[2, 4],
+          Tout=[dtypes.int32],
+          f=computation,
+          captured_tensors=computation.captured_inputs)
+      self.assertAllEqual(
+          sess.run(result, feed_dict={inp: [1, 2, 3, 4, 5, 6, 7]})[0],
+          [2, 3, 4, 5, 6, 7, 8])
+
   def testBatchFunctionOpWithCapturedInput(self):
     """Tests that batch_function op works with captured input."""
     if context.executing_eagerly():
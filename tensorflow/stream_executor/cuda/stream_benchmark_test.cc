@@ -0,0 +1,193 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of the stream primitives of GPU 0: copy bandwidth between
+// pinned or pageable host memory and the device, kernel launch latency and
+// event round trips. Run with --benchmarks=all, e.g. to check a host after
+// a driver upgrade. Copies also report the bandwidth seen by a stream
+// Timer, which excludes the host side overhead included in the wall time.
+
+#if GOOGLE_CUDA
+#include <algorithm>
+#include <memory>
+
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/stream_executor/device_memory.h"
+#include "tensorflow/stream_executor/event.h"
+#include "tensorflow/stream_executor/kernel.h"
+#include "tensorflow/stream_executor/multi_platform_manager.h"
+#include "tensorflow/stream_executor/stream.h"
+#include "tensorflow/stream_executor/stream_executor.h"
+#include "tensorflow/stream_executor/timer.h"
+
+namespace stream_executor {
+namespace {
+
+// An empty kernel to measure launches.
+const char* const kNoopPtx = R"(
+.version 4.2
+.target sm_30
+.address_size 64
+
+.visible .entry noop()
+{
+  ret;
+}
+)";
+
+StreamExecutor* GetExecutor() {
+  Platform* platform =
+      MultiPlatformManager::PlatformWithName("CUDA").ValueOrDie();
+  return platform->ExecutorForDevice(0).ValueOrDie();
+}
+
+enum class CopyKind { kHostToDevice, kDeviceToHost, kDeviceToDevice };
+
+void BM_Memcpy(int iters, int size, CopyKind kind, bool pinned) {
+  tensorflow::testing::StopTiming();
+  tensorflow::testing::UseRealTime();
+  StreamExecutor* executor = GetExecutor();
+  Stream stream(executor);
+  stream.Init();
+  CHECK(stream.ok());
+
+  DeviceMemory<uint8> device = executor->AllocateArray<uint8>(size);
+  DeviceMemory<uint8> device2 = executor->AllocateArray<uint8>(size);
+  std::unique_ptr<uint8[]> pageable;
+  void* host;
+  if (pinned) {
+    host = executor->HostMemoryAllocate(size);
+  } else {
+    pageable.reset(new uint8[size]);
+    host = pageable.get();
+  }
+  CHECK(host != nullptr && !device.is_null() && !device2.is_null());
+
+  auto copy = [&]() {
+    switch (kind) {
+      case CopyKind::kHostToDevice:
+        stream.ThenMemcpy(&device, host, size);
+        break;
+      case CopyKind::kDeviceToHost:
+        stream.ThenMemcpy(host, device, size);
+        break;
+      case CopyKind::kDeviceToDevice:
+        stream.ThenMemcpyD2D(&device2, device, size);
+        break;
+    }
+  };
+  // Warms up the copy engines and the timer.
+  Timer timer(executor);
+  stream.ThenStartTimer(&timer);
+  copy();
+  stream.ThenStopTimer(&timer);
+  CHECK(stream.BlockHostUntilDone().ok());
+
+  tensorflow::testing::StartTiming();
+  stream.ThenStartTimer(&timer);
+  for (int i = 0; i < iters; ++i) copy();
+  stream.ThenStopTimer(&timer);
+  CHECK(stream.BlockHostUntilDone().ok());
+  tensorflow::testing::StopTiming();
+
+  const int64 bytes = static_cast<int64>(iters) * size;
+  tensorflow::testing::BytesProcessed(bytes);
+  tensorflow::testing::SetLabel(absl::StrFormat(
+      "device %.2f GB/s", static_cast<double>(bytes) /
+                              std::max<uint64>(timer.Nanoseconds(), 1)));
+
+  if (pinned) executor->HostMemoryDeallocate(host);
+  executor->Deallocate(&device);
+  executor->Deallocate(&device2);
+}
+
+#define BM_MEMCPY(name, kind, pinned)                      \
+  static void BM_##name(int iters, int size) {             \
+    BM_Memcpy(iters, size, CopyKind::kind, pinned);        \
+  }                                                        \
+  BENCHMARK(BM_##name)->Range(4 << 10, 256 << 20)
+
+BM_MEMCPY(MemcpyH2DPinned, kHostToDevice, true);
+BM_MEMCPY(MemcpyH2DPageable, kHostToDevice, false);
+BM_MEMCPY(MemcpyD2HPinned, kDeviceToHost, true);
+BM_MEMCPY(MemcpyD2HPageable, kDeviceToHost, false);
+BM_MEMCPY(MemcpyD2D, kDeviceToDevice, true);
+
+#undef BM_MEMCPY
+
+// Launches `iters` empty kernels, waiting for each one if `sync`. Without
+// sync this is the cost of a launch on the host, with sync the latency of a
+// launch until the host sees it completed.
+void BM_Launch(int iters, bool sync) {
+  tensorflow::testing::StopTiming();
+  tensorflow::testing::UseRealTime();
+  StreamExecutor* executor = GetExecutor();
+  Stream stream(executor);
+  stream.Init();
+  CHECK(stream.ok());
+  auto kernel_or = executor->CreateTypedKernel<>("noop", kNoopPtx, {});
+  CHECK(kernel_or.ok()) << kernel_or.status();
+  std::unique_ptr<TypedKernel<>> kernel = kernel_or.ConsumeValueOrDie();
+  stream.ThenLaunch(ThreadDim(1), BlockDim(1), *kernel);
+  CHECK(stream.BlockHostUntilDone().ok());
+
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    stream.ThenLaunch(ThreadDim(1), BlockDim(1), *kernel);
+    if (sync) CHECK(stream.BlockHostUntilDone().ok());
+  }
+  CHECK(stream.BlockHostUntilDone().ok());
+  tensorflow::testing::StopTiming();
+  tensorflow::testing::ItemsProcessed(iters);
+}
+
+static void BM_LaunchAsync(int iters) { BM_Launch(iters, false); }
+BENCHMARK(BM_LaunchAsync);
+
+static void BM_LaunchSync(int iters) { BM_Launch(iters, true); }
+BENCHMARK(BM_LaunchSync);
+
+// Records an event on an idle stream and polls it until it completes, as
+// the EventMgr does.
+static void BM_EventRoundTrip(int iters) {
+  tensorflow::testing::StopTiming();
+  tensorflow::testing::UseRealTime();
+  StreamExecutor* executor = GetExecutor();
+  Stream stream(executor);
+  stream.Init();
+  CHECK(stream.ok());
+  Event event(executor);
+  CHECK(event.Init());
+
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    stream.ThenRecordEvent(&event);
+    Event::Status status;
+    while ((status = event.PollForStatus()) == Event::Status::kPending) {
+    }
+    CHECK(status == Event::Status::kComplete);
+  }
+  tensorflow::testing::StopTiming();
+  tensorflow::testing::ItemsProcessed(iters);
+}
+BENCHMARK(BM_EventRoundTrip);
+
+}  // namespace
+}  // namespace stream_executor
+
+#endif  // GOOGLE_CUDA
@@ -19,6 +19,8 @@ limitations under the License.
 
 #include <string.h>
 
+#include <limits>
+
 #include "absl/synchronization/notification.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/profile_utils/cpu_utils.h"
@@ -255,9 +257,14 @@ HostExecutor::CreateDeviceDescription(int device_ordinal) {
 
   builder.set_device_address_bits(64);
 
-  // TODO(rspringer): How to report a value that's based in reality but that
-  // doesn't result in thrashing or other badness? 4GiB chosen arbitrarily.
-  builder.set_device_memory_size(static_cast<uint64>(4) * 1024 * 1024 * 1024);
+  // Report the RAM available when the device is created, so that memory
+  // budgets derived from it (e.g. XLA:CPU rematerialization) reflect the host.
+  // Fall back to 4GiB, chosen arbitrarily, if the platform doesn't know.
+  const int64 available_ram = tensorflow::port::AvailableRam();
+  builder.set_device_memory_size(
+      available_ram != std::numeric_limits<int64>::max()
+          ? static_cast<uint64>(available_ram)
+          : static_cast<uint64>(4) * 1024 * 1024 * 1024);
 
   float cycle_counter_frequency = static_cast<float>(
       tensorflow::profile_utils::CpuUtils::GetCycleCounterFrequency());
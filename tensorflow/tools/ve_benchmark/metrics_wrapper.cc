@@ -0,0 +1,59 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Reads monitoring metrics registered by the runtime, e.g. the
+// /tensorflow/core/ve/ counters of VEDevice. The Python monitoring API can
+// only create metrics, not read the existing ones.
+
+#include <string>
+
+#include "include/pybind11/pybind11.h"
+#include "tensorflow/core/lib/monitoring/collected_metrics.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+
+namespace py = pybind11;
+
+namespace {
+
+// Returns the points of the int64 metric `name` as a dict from the tuple of
+// their label values to their values. The dict is empty if the metric is not
+// registered, e.g. when the runtime was built without VE support.
+py::dict Int64MetricValues(const std::string& name) {
+  using tensorflow::monitoring::CollectionRegistry;
+  CollectionRegistry::CollectMetricsOptions options;
+  options.collect_metric_descriptors = false;
+  auto metrics = CollectionRegistry::Default()->CollectMetrics(options);
+
+  py::dict values;
+  auto it = metrics->point_set_map.find(name);
+  if (it == metrics->point_set_map.end()) return values;
+  for (const auto& point : it->second->points) {
+    if (point->value_type != tensorflow::monitoring::ValueType::kInt64) {
+      continue;
+    }
+    py::tuple labels(point->labels.size());
+    for (size_t i = 0; i < point->labels.size(); ++i) {
+      labels[i] = point->labels[i].value;
+    }
+    values[labels] = point->int64_value;
+  }
+  return values;
+}
+
+}  // namespace
+
+PYBIND11_MODULE(_pywrap_ve_metrics, m) {
+  m.def("Int64MetricValues", &Int64MetricValues);
+}
@@ -0,0 +1,312 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Standard models trained by the end-to-end VE benchmarks.
+
+Each model comes with synthetic inputs of a fixed seed and its training loss,
+so that a benchmark can build it in either graph or eager mode.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import math
+
+import numpy as np
+
+from tensorflow.python.keras import backend
+from tensorflow.python.keras import losses
+from tensorflow.python.keras.applications import resnet
+from tensorflow.python.keras.engine import base_layer
+from tensorflow.python.keras.engine import sequential
+from tensorflow.python.keras.engine import training
+from tensorflow.python.keras.layers import core
+from tensorflow.python.keras.layers import embeddings
+from tensorflow.python.keras.layers import normalization
+from tensorflow.python.keras.layers import recurrent_v2
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import nn_ops
+
+
+class BenchmarkModel(object):
+  """A model with its synthetic inputs and training loss.
+
+  Attributes:
+    name: Name of the model in benchmark names.
+    unit: What the throughput counts, e.g. "images" or "tokens".
+    units_per_example: Number of units in one example.
+    batch_size: Number of examples per training step.
+  """
+
+  def __init__(self, name, unit, units_per_example, batch_size):
+    self.name = name
+    self.unit = unit
+    self.units_per_example = units_per_example
+    self.batch_size = batch_size
+
+  def build(self):
+    """Returns a new Keras model, called on the features of make_inputs."""
+    raise NotImplementedError
+
+  def make_inputs(self):
+    """Returns numpy features and labels of one batch."""
+    raise NotImplementedError
+
+  def loss(self, labels, outputs):
+    """Returns the scalar training loss of `outputs`."""
+    raise NotImplementedError
+
+
+class ResNet50(BenchmarkModel):
+  """ResNet-50 v1 on 224x224 ImageNet-sized images."""
+
+  def __init__(self, data_format, batch_size=64):
+    layout = "nchw" if data_format == "channels_first" else "nhwc"
+    super(ResNet50, self).__init__("resnet50_" + layout, "images", 1,
+                                   batch_size)
+    self._data_format = data_format
+
+  def _image_shape(self):
+    if self._data_format == "channels_first":
+      return (3, 224, 224)
+    return (224, 224, 3)
+
+  def build(self):
+    # The Keras applications read the layout from the global data format.
+    saved_data_format = backend.image_data_format()
+    backend.set_image_data_format(self._data_format)
+    try:
+      return resnet.ResNet50(
+          weights=None, input_shape=self._image_shape(), classes=1000)
+    finally:
+      backend.set_image_data_format(saved_data_format)
+
+  def make_inputs(self):
+    rng = np.random.RandomState(0)
+    images = rng.uniform(
+        size=(self.batch_size,) + self._image_shape()).astype(np.float32)
+    labels = rng.randint(0, 1000, size=(self.batch_size,)).astype(np.int32)
+    return images, labels
+
+  def loss(self, labels, outputs):
+    return math_ops.reduce_mean(
+        losses.sparse_categorical_crossentropy(labels, outputs))
+
+
+def _gelu(x):
+  return 0.5 * x * (1.0 + math_ops.tanh(
+      math.sqrt(2.0 / math.pi) * (x + 0.044715 * math_ops.pow(x, 3))))
+
+
+class _TransformerEncoderLayer(base_layer.Layer):
+  """A post-layer-norm Transformer encoder layer as in BERT."""
+
+  def __init__(self, seq_length, hidden_size, num_heads, intermediate_size,
+               **kwargs):
+    super(_TransformerEncoderLayer, self).__init__(**kwargs)
+    self._seq_length = seq_length
+    self._num_heads = num_heads
+    self._head_size = hidden_size // num_heads
+    self._qkv = core.Dense(3 * hidden_size)
+    self._attention_output = core.Dense(hidden_size)
+    self._attention_norm = normalization.LayerNormalization(epsilon=1e-12)
+    self._intermediate = core.Dense(intermediate_size)
+    self._output = core.Dense(hidden_size)
+    self._output_norm = normalization.LayerNormalization(epsilon=1e-12)
+
+  def call(self, inputs, attention_bias):
+    # [batch, seq, 3, heads, head_size] -> [3, batch, heads, seq, head_size]
+    qkv = array_ops.reshape(
+        self._qkv(inputs),
+        [-1, self._seq_length, 3, self._num_heads, self._head_size])
+    qkv = array_ops.transpose(qkv, [2, 0, 3, 1, 4])
+    query, key, value = array_ops.unstack(qkv, axis=0)
+
+    scores = math_ops.matmul(query, key, transpose_b=True)
+    scores = scores * (1.0 / math.sqrt(self._head_size)) + attention_bias
+    context = math_ops.matmul(nn_ops.softmax(scores), value)
+    context = array_ops.reshape(
+        array_ops.transpose(context, [0, 2, 1, 3]),
+        [-1, self._seq_length, self._num_heads * self._head_size])
+
+    x = self._attention_norm(inputs + self._attention_output(context))
+    return self._output_norm(x + self._output(_gelu(self._intermediate(x))))
+
+
+class _BertClassifier(training.Model):
+  """A BERT encoder with a sentence classification head."""
+
+  def __init__(self, vocab_size, seq_length, hidden_size, num_layers,
+               num_heads, intermediate_size, num_classes):
+    super(_BertClassifier, self).__init__()
+    self._seq_length = seq_length
+    self._word_embeddings = embeddings.Embedding(vocab_size, hidden_size)
+    self._position_embeddings = embeddings.Embedding(seq_length, hidden_size)
+    self._embedding_norm = normalization.LayerNormalization(epsilon=1e-12)
+    self._encoder_layers = [
+        _TransformerEncoderLayer(seq_length, hidden_size, num_heads,
+                                 intermediate_size)
+        for _ in range(num_layers)
+    ]
+    self._pooler = core.Dense(hidden_size, activation="tanh")
+    self._classifier = core.Dense(num_classes)
+
+  def call(self, inputs):
+    input_ids, input_mask = inputs
+    x = self._word_embeddings(input_ids) + self._position_embeddings(
+        math_ops.range(self._seq_length))
+    x = self._embedding_norm(x)
+    # [batch, 1, 1, seq] bias that masks out the padding keys.
+    attention_bias = array_ops.expand_dims(
+        array_ops.expand_dims(
+            (1.0 - math_ops.cast(input_mask, x.dtype)) * -10000.0, 1), 1)
+    for layer in self._encoder_layers:
+      x = layer(x, attention_bias)
+    return self._classifier(self._pooler(x[:, 0]))
+
+
+class BertBase(BenchmarkModel):
+  """BERT-base fine-tuned on a two-class sentence classification task."""
+
+  def __init__(self, seq_length=128, batch_size=32):
+    super(BertBase, self).__init__("bert_base", "tokens", seq_length,
+                                   batch_size)
+    self._seq_length = seq_length
+    self._vocab_size = 30522
+
+  def build(self):
+    return _BertClassifier(
+        vocab_size=self._vocab_size,
+        seq_length=self._seq_length,
+        hidden_size=768,
+        num_layers=12,
+        num_heads=12,
+        intermediate_size=3072,
+        num_classes=2)
+
+  def make_inputs(self):
+    rng = np.random.RandomState(0)
+    input_ids = rng.randint(
+        0, self._vocab_size,
+        size=(self.batch_size, self._seq_length)).astype(np.int32)
+    # Sentences of random lengths padded to seq_length.
+    lengths = rng.randint(self._seq_length // 4, self._seq_length + 1,
+                          size=(self.batch_size, 1))
+    input_mask = (np.arange(self._seq_length) < lengths).astype(np.int32)
+    labels = rng.randint(0, 2, size=(self.batch_size,)).astype(np.int32)
+    return (input_ids, input_mask), labels
+
+  def loss(self, labels, outputs):
+    return math_ops.reduce_mean(
+        losses.sparse_categorical_crossentropy(
+            labels, outputs, from_logits=True))
+
+
+class LSTMLanguageModel(BenchmarkModel):
+  """A two-layer LSTM language model of the PTB "large" size."""
+
+  def __init__(self, num_steps=35, batch_size=64):
+    super(LSTMLanguageModel, self).__init__("lstm", "tokens", num_steps,
+                                            batch_size)
+    self._num_steps = num_steps
+    self._vocab_size = 10000
+
+  def build(self):
+    return sequential.Sequential([
+        embeddings.Embedding(self._vocab_size, 1500),
+        recurrent_v2.LSTM(1500, return_sequences=True),
+        recurrent_v2.LSTM(1500, return_sequences=True),
+        core.Dense(self._vocab_size),
+    ])
+
+  def make_inputs(self):
+    rng = np.random.RandomState(0)
+    tokens = rng.randint(
+        0, self._vocab_size,
+        size=(self.batch_size, self._num_steps + 1)).astype(np.int32)
+    return tokens[:, :-1], tokens[:, 1:]
+
+  def loss(self, labels, outputs):
+    return math_ops.reduce_mean(
+        losses.sparse_categorical_crossentropy(
+            labels, outputs, from_logits=True))
+
+
+class _WideDeepModel(training.Model):
+  """A linear model and an MLP over shared categorical ids, as in Criteo."""
+
+  def __init__(self, num_categorical, vocab_size, embedding_dim,
+               hidden_units):
+    super(_WideDeepModel, self).__init__()
+    self._num_categorical = num_categorical
+    self._vocab_size = vocab_size
+    self._embedding_dim = embedding_dim
+    # One table for all the features, indexed by id + feature * vocab_size,
+    # keeps the number of variables and of sparse updates per step small.
+    self._wide_embeddings = embeddings.Embedding(
+        num_categorical * vocab_size, 1)
+    self._deep_embeddings = embeddings.Embedding(
+        num_categorical * vocab_size, embedding_dim)
+    self._wide_dense = core.Dense(1)
+    self._hidden = [core.Dense(units, activation="relu")
+                    for units in hidden_units]
+    self._deep_output = core.Dense(1)
+
+  def call(self, inputs):
+    numeric, categorical = inputs
+    ids = categorical + math_ops.range(
+        0, self._num_categorical * self._vocab_size, self._vocab_size)
+    wide = self._wide_dense(numeric) + math_ops.reduce_sum(
+        self._wide_embeddings(ids), axis=1)
+    deep = array_ops.concat([
+        numeric,
+        array_ops.reshape(self._deep_embeddings(ids),
+                          [-1, self._num_categorical * self._embedding_dim])
+    ], axis=1)
+    for layer in self._hidden:
+      deep = layer(deep)
+    return wide + self._deep_output(deep)
+
+
+class WideDeep(BenchmarkModel):
+  """A wide&deep click-through model with 13 numeric and 26 id features."""
+
+  def __init__(self, batch_size=512):
+    super(WideDeep, self).__init__("wide_deep", "examples", 1, batch_size)
+    self._num_numeric = 13
+    self._num_categorical = 26
+    self._vocab_size = 100000
+
+  def build(self):
+    return _WideDeepModel(
+        num_categorical=self._num_categorical,
+        vocab_size=self._vocab_size,
+        embedding_dim=16,
+        hidden_units=(1024, 512, 256))
+
+  def make_inputs(self):
+    rng = np.random.RandomState(0)
+    numeric = rng.uniform(
+        size=(self.batch_size, self._num_numeric)).astype(np.float32)
+    categorical = rng.randint(
+        0, self._vocab_size,
+        size=(self.batch_size, self._num_categorical)).astype(np.int32)
+    labels = rng.randint(0, 2, size=(self.batch_size, 1)).astype(np.float32)
+    return (numeric, categorical), labels
+
+  def loss(self, labels, outputs):
+    return math_ops.reduce_mean(
+        losses.binary_crossentropy(labels, outputs, from_logits=True))
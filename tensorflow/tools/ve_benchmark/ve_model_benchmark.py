@@ -0,0 +1,316 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""End-to-end training benchmarks of standard models on /device:VE:0.
+
+Each model is trained with synthetic inputs fed from the host every step, in
+graph mode through a Session and in eager mode op by op, so that the kernel
+batching of VEOAsync, the copy paths, the CPU fallbacks of ops without a VE
+kernel and the tracer are all exercised together. Besides the throughput,
+every benchmark reports per step:
+
+  host_to_ve_bytes, ve_to_host_bytes  tensors copied by VEDevice.
+  issued_batches                      kernel batches flushed to the VE.
+  cpu_fallback_ops                    ops run on the host instead of the VE,
+                                      counted in one traced step.
+  tracer_overhead                     relative slowdown of a profiled step.
+
+The results are reported through tf.test.Benchmark, and also appended as JSON
+lines to $TF_VE_BENCHMARK_OUTPUT if it is set, together with the versions of
+TensorFlow and of the VE kernel library ($VEO_KERNEL) to track regressions
+across releases of both.
+
+Run with --benchmarks=all, or e.g. --benchmarks=resnet50 for a subset.
+TF_VE_BENCHMARK_STEPS sets the number of timed steps (default 20).
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import hashlib
+import json
+import os
+import time
+
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.client import session
+from tensorflow.python.eager import backprop
+from tensorflow.python.eager import context
+from tensorflow.python.eager import profiler
+from tensorflow.python.framework import config
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import versions
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import control_flow_ops
+from tensorflow.python.ops import variables
+from tensorflow.python.platform import test
+from tensorflow.python.platform import tf_logging as logging
+from tensorflow.python.training import gradient_descent
+from tensorflow.python.util import nest
+from tensorflow.tools.ve_benchmark import _pywrap_ve_metrics
+from tensorflow.tools.ve_benchmark import models
+
+_DEVICE = "/device:VE:0"
+_WARMUP_STEPS = 5
+_TRACED_STEPS = 5
+_LEARNING_RATE = 0.01
+
+# Ops that move tensors or feed the step rather than compute; running them on
+# the host is not a fallback.
+_NON_COMPUTE_OPS = frozenset([
+    "_Arg", "_HostRecv", "_HostSend", "_Recv", "_Retval", "_Send", "Const",
+    "Identity", "NoOp", "Placeholder"
+])
+
+
+def _num_steps():
+  return int(os.environ.get("TF_VE_BENCHMARK_STEPS", "20"))
+
+
+def _read_ve_counters():
+  """Returns the transfer bytes by direction and the issued batches so far."""
+  transfer_bytes = _pywrap_ve_metrics.Int64MetricValues(
+      "/tensorflow/core/ve/transfer_bytes")
+  issued_batches = _pywrap_ve_metrics.Int64MetricValues(
+      "/tensorflow/core/ve/issued_batches")
+  return (transfer_bytes.get(("host_to_device",), 0),
+          transfer_bytes.get(("device_to_host",), 0),
+          sum(issued_batches.values()))
+
+
+def _op_type(node_stats):
+  # Graph nodes are labeled "name = Op(inputs)", eager ops by their type.
+  label = node_stats.timeline_label
+  if " = " in label:
+    return label.split(" = ", 1)[1].split("(", 1)[0]
+  return node_stats.node_name.split(":", 1)[0]
+
+
+def _cpu_fallback_ops(run_metadata):
+  """Returns the types of the compute ops run on a CPU, with their counts."""
+  counts = {}
+  for device_stats in run_metadata.step_stats.dev_stats:
+    if "device:CPU:" not in device_stats.device:
+      continue
+    for node_stats in device_stats.node_stats:
+      op_type = _op_type(node_stats)
+      if op_type not in _NON_COMPUTE_OPS:
+        counts[op_type] = counts.get(op_type, 0) + 1
+  return counts
+
+
+_vetfkernel_id = None
+
+
+def _get_vetfkernel_id():
+  """Returns the path and a digest of the loaded VE kernel library."""
+  global _vetfkernel_id
+  if _vetfkernel_id is None:
+    path = os.environ.get("VEO_KERNEL", "")
+    try:
+      with open(path, "rb") as f:
+        digest = hashlib.sha256(f.read()).hexdigest()[:16]
+    except (IOError, OSError):
+      digest = "unknown"
+    _vetfkernel_id = "%s@%s" % (path, digest)
+  return _vetfkernel_id
+
+
+class VEModelBenchmark(test.Benchmark):
+  """End-to-end training benchmarks of the models in models.py."""
+
+  def _graph_runner(self, model):
+    """Builds a training step in a new graph and returns its runners.
+
+    Returns:
+      A tuple of three functions: one runs a number of steps, one runs a step
+      and returns its RunMetadata with the step stats, and one closes the
+      runner.
+    """
+    graph = ops.Graph()
+    with graph.as_default(), ops.device(_DEVICE):
+      features, labels = model.make_inputs()
+      feature_placeholders = nest.map_structure(
+          lambda a: array_ops.placeholder(a.dtype, a.shape), features)
+      label_placeholder = array_ops.placeholder(labels.dtype, labels.shape)
+      keras_model = model.build()
+      loss = model.loss(label_placeholder,
+                        keras_model(feature_placeholders, training=True))
+      train_op = gradient_descent.GradientDescentOptimizer(
+          _LEARNING_RATE).minimize(loss)
+      # Includes the moving statistics of batch normalization.
+      train_op = control_flow_ops.group(train_op, *keras_model.updates)
+      init_op = variables.global_variables_initializer()
+
+    feed_dict = dict(
+        zip(nest.flatten(feature_placeholders), nest.flatten(features)))
+    feed_dict[label_placeholder] = labels
+    sess = session.Session(
+        graph=graph,
+        config=config_pb2.ConfigProto(allow_soft_placement=True))
+    sess.run(init_op)
+
+    def run_steps(num_steps):
+      for _ in range(num_steps):
+        sess.run(train_op, feed_dict=feed_dict)
+
+    def run_traced_step():
+      run_metadata = config_pb2.RunMetadata()
+      sess.run(
+          train_op,
+          feed_dict=feed_dict,
+          options=config_pb2.RunOptions(
+              trace_level=config_pb2.RunOptions.SOFTWARE_TRACE),
+          run_metadata=run_metadata)
+      return run_metadata
+
+    return run_steps, run_traced_step, sess.close
+
+  def _eager_runner(self, model):
+    """Returns the runners of an op by op training step, see _graph_runner."""
+    with ops.device(_DEVICE):
+      keras_model = model.build()
+    optimizer = gradient_descent.GradientDescentOptimizer(_LEARNING_RATE)
+    features, labels = model.make_inputs()
+
+    def run_steps(num_steps):
+      with ops.device(_DEVICE):
+        loss = None
+        for _ in range(num_steps):
+          with backprop.GradientTape() as tape:
+            loss = model.loss(labels, keras_model(features, training=True))
+          trainable_variables = keras_model.trainable_variables
+          gradients = tape.gradient(loss, trainable_variables)
+          optimizer.apply_gradients(zip(gradients, trainable_variables))
+        # Kernels are batched asynchronously, so wait for the last step.
+        if loss is not None:
+          loss.numpy()
+
+    def run_traced_step():
+      context.enable_run_metadata()
+      try:
+        run_steps(1)
+        return context.export_run_metadata()
+      finally:
+        context.disable_run_metadata()
+
+    return run_steps, run_traced_step, lambda: None
+
+  def _run_benchmark(self, model, mode):
+    if not config.list_physical_devices("VE"):
+      logging.warning("Skipping %s_%s: no VE device", model.name, mode)
+      return
+
+    if mode == "graph":
+      with context.graph_mode():
+        run_steps, run_traced_step, close = self._graph_runner(model)
+        results = self._measure(run_steps, run_traced_step)
+        close()
+    else:
+      with context.eager_mode():
+        run_steps, run_traced_step, close = self._eager_runner(model)
+        results = self._measure(run_steps, run_traced_step)
+        close()
+    self._report(model, mode, *results)
+
+  def _measure(self, run_steps, run_traced_step):
+    """Returns the step time, the VE counters and the fallbacks per step."""
+    run_steps(_WARMUP_STEPS)
+
+    num_steps = _num_steps()
+    counters_before = _read_ve_counters()
+    start = time.time()
+    run_steps(num_steps)
+    step_time = (time.time() - start) / num_steps
+    counters_per_step = [
+        float(after - before) / num_steps
+        for before, after in zip(counters_before, _read_ve_counters())
+    ]
+
+    fallbacks = _cpu_fallback_ops(run_traced_step())
+
+    profiler.start()
+    start = time.time()
+    run_steps(_TRACED_STEPS)
+    traced_step_time = (time.time() - start) / _TRACED_STEPS
+    profiler.stop()
+
+    return step_time, counters_per_step, fallbacks, traced_step_time
+
+  def _report(self, model, mode, step_time, counters_per_step, fallbacks,
+              traced_step_time):
+    name = "%s_%s" % (model.name, mode)
+    units_per_sec = model.batch_size * model.units_per_example / step_time
+    host_to_ve_bytes, ve_to_host_bytes, issued_batches = counters_per_step
+    extras = {
+        "batch_size": model.batch_size,
+        "%s_per_sec" % model.unit: units_per_sec,
+        "host_to_ve_bytes_per_step": host_to_ve_bytes,
+        "ve_to_host_bytes_per_step": ve_to_host_bytes,
+        "issued_batches_per_step": issued_batches,
+        "cpu_fallback_ops_per_step": sum(fallbacks.values()),
+        "cpu_fallback_op_types": ",".join(sorted(fallbacks)),
+        "tracer_overhead": traced_step_time / step_time - 1.0,
+        "tf_version": versions.__version__,
+        "tf_git_version": versions.__git_version__,
+        "vetfkernel": _get_vetfkernel_id(),
+    }
+    self.report_benchmark(
+        iters=_num_steps(),
+        wall_time=step_time,
+        throughput=units_per_sec,
+        extras=extras,
+        name=name)
+
+    output = os.environ.get("TF_VE_BENCHMARK_OUTPUT")
+    if output:
+      record = dict(extras)
+      record.update({"name": name, "mode": mode, "wall_time": step_time})
+      with open(output, "a") as f:
+        f.write(json.dumps(record, sort_keys=True) + "\n")
+
+  def benchmark_resnet50_nchw_graph(self):
+    self._run_benchmark(models.ResNet50("channels_first"), "graph")
+
+  def benchmark_resnet50_nchw_eager(self):
+    self._run_benchmark(models.ResNet50("channels_first"), "eager")
+
+  def benchmark_resnet50_nhwc_graph(self):
+    self._run_benchmark(models.ResNet50("channels_last"), "graph")
+
+  def benchmark_resnet50_nhwc_eager(self):
+    self._run_benchmark(models.ResNet50("channels_last"), "eager")
+
+  def benchmark_bert_base_graph(self):
+    self._run_benchmark(models.BertBase(), "graph")
+
+  def benchmark_bert_base_eager(self):
+    self._run_benchmark(models.BertBase(), "eager")
+
+  def benchmark_lstm_graph(self):
+    self._run_benchmark(models.LSTMLanguageModel(), "graph")
+
+  def benchmark_lstm_eager(self):
+    self._run_benchmark(models.LSTMLanguageModel(), "eager")
+
+  def benchmark_wide_deep_graph(self):
+    self._run_benchmark(models.WideDeep(), "graph")
+
+  def benchmark_wide_deep_eager(self):
+    self._run_benchmark(models.WideDeep(), "eager")
+
+
+if __name__ == "__main__":
+  test.main()